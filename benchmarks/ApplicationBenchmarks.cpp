@@ -0,0 +1,260 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cmath>
+#include <cudaq.h>
+#include <cudaq/algorithm.h>
+#include <cudaq/builder.h>
+
+// End-to-end workloads after the examples in
+// docs/sphinx/examples/cpp/algorithms: VQE, MaxCut QAOA and phase
+// estimation. The kernels are built with the kernel_builder so that they run
+// on every platform, including REST QPUs, which are selected by setting
+// CUDAQ_BENCHMARK_TARGET to a target backend string, e.g.
+// "quantinuum;url;http://localhost:62454;credentials;<file>".
+//
+// Every benchmark reports, besides the time to solution of an iteration:
+//   circuits/s: the kernels launched per second (real time), over all QPUs,
+//   qpu_utilization: the fraction of the real time the QPUs spent in
+//                    launches, averaged over the QPUs.
+
+namespace {
+
+/// @brief The number of optimization steps of the variational workloads.
+constexpr std::size_t optimizationSteps = 10;
+
+/// @brief Report the launches of all QPUs during the `seconds` of real time
+/// the benchmark ran, since their statistics were reset.
+void reportQPUStatistics(benchmark::State &state, double seconds) {
+  auto &platform = cudaq::get_platform();
+  double launches = 0.0, busy = 0.0;
+  for (std::size_t qpu = 0; qpu < platform.num_qpus(); qpu++) {
+    auto statistics = platform.get_qpu_statistics(qpu);
+    launches += statistics.launches;
+    busy += statistics.busy_seconds;
+  }
+  state.counters["circuits/s"] = launches / seconds;
+  state.counters["qpu_utilization"] = busy / (seconds * platform.num_qpus());
+}
+
+/// @brief Minimize the expectation value of `H` for `kernel` by gradient
+/// descent from `parameters`. The central differences of each step are
+/// observed as one batch, which is split amongst the QPUs. Return the final
+/// expectation value.
+template <typename Kernel>
+double minimize(Kernel &kernel, const cudaq::spin_op &H,
+                std::vector<double> parameters) {
+  constexpr double step = 1e-3, rate = 0.2;
+  double energy = 0.0;
+  for (std::size_t iteration = 0; iteration < optimizationSteps; iteration++) {
+    std::vector<std::tuple<std::vector<double>>> argumentSets{{parameters}};
+    for (std::size_t i = 0; i < parameters.size(); i++)
+      for (double sign : {1.0, -1.0}) {
+        auto shifted = parameters;
+        shifted[i] += sign * step;
+        argumentSets.emplace_back(shifted);
+      }
+    auto results = cudaq::observe(kernel, H, argumentSets);
+    energy = results[0].exp_val_z();
+    for (std::size_t i = 0; i < parameters.size(); i++)
+      parameters[i] -= rate *
+                       (results[2 * i + 1].exp_val_z() -
+                        results[2 * i + 2].exp_val_z()) /
+                       (2 * step);
+  }
+  return energy;
+}
+
+/// @brief Run the workload once per benchmark iteration and report the
+/// QPU statistics of all iterations.
+template <typename Workload>
+void runWorkload(benchmark::State &state, Workload &&workload) {
+  auto &platform = cudaq::get_platform();
+  platform.reset_qpu_statistics();
+  const auto start = std::chrono::steady_clock::now();
+  for (auto _ : state)
+    state.counters["result"] = workload();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  reportQPUStatistics(state, elapsed.count());
+}
+
+/// @brief Append `layers` layers of ry rotations and a CNOT ladder on the
+/// qubits `q`, with the rotation angles of `thetas`.
+template <typename Kernel>
+void hardwareEfficientAnsatz(Kernel &kernel, cudaq::QuakeValue &q,
+                             cudaq::QuakeValue &thetas, std::size_t nQubits,
+                             std::size_t layers) {
+  std::size_t counter = 0;
+  for (std::size_t layer = 0; layer < layers; layer++) {
+    for (std::size_t i = 0; i < nQubits; i++)
+      kernel.ry(thetas[counter++], q[i]);
+    for (std::size_t i = 0; i + 1 < nQubits; i++)
+      kernel.template x<cudaq::ctrl>(q[i], q[i + 1]);
+  }
+}
+
+/// @brief The H2 Hamiltonian of vqe_h2.cpp, on 4 qubits.
+cudaq::spin_op h2Hamiltonian() {
+  std::vector<double> h2_data{0, 0, 0, 0, -0.10647701149499994, 0.0,
+                              1, 1, 1, 1, 0.0454063328691,      0.0,
+                              1, 1, 3, 3, 0.0454063328691,      0.0,
+                              3, 3, 1, 1, 0.0454063328691,      0.0,
+                              3, 3, 3, 3, 0.0454063328691,      0.0,
+                              2, 0, 0, 0, 0.170280101353,       0.0,
+                              2, 2, 0, 0, 0.120200490713,       0.0,
+                              2, 0, 2, 0, 0.168335986252,       0.0,
+                              2, 0, 0, 2, 0.165606823582,       0.0,
+                              0, 2, 0, 0, -0.22004130022499996, 0.0,
+                              0, 2, 2, 0, 0.165606823582,       0.0,
+                              0, 2, 0, 2, 0.174072892497,       0.0,
+                              0, 0, 2, 0, 0.17028010135300004,  0.0,
+                              0, 0, 2, 2, 0.120200490713,       0.0,
+                              0, 0, 0, 2, -0.22004130022499999, 0.0,
+                              15};
+  return cudaq::spin_op(h2_data, /*nQubits*/ 4);
+}
+
+/// @brief The Heisenberg chain on `nQubits` qubits, a molecule-sized stand-in
+/// for larger VQE problems.
+cudaq::spin_op heisenbergHamiltonian(std::size_t nQubits) {
+  using namespace cudaq::spin;
+  cudaq::spin_op H = x(0) * x(1) + y(0) * y(1) + z(0) * z(1);
+  for (std::size_t i = 1; i + 1 < nQubits; i++)
+    H += x(i) * x(i + 1) + y(i) * y(i + 1) + z(i) * z(i + 1);
+  return H;
+}
+
+/// @brief VQE of the hardware efficient ansatz of range(1) layers for the
+/// H2 Hamiltonian if range(0) is 4, else the Heisenberg chain of range(0)
+/// qubits.
+void BM_VQE(benchmark::State &state) {
+  const std::size_t nQubits = state.range(0), layers = state.range(1);
+  auto H = nQubits == 4 ? h2Hamiltonian() : heisenbergHamiltonian(nQubits);
+  auto [kernel, thetas] = cudaq::make_kernel<std::vector<double>>();
+  auto q = kernel.qalloc(nQubits);
+  kernel.x(q[0]);
+  kernel.x(q[2]);
+  hardwareEfficientAnsatz(kernel, q, thetas, nQubits, layers);
+
+  std::vector<double> initial(nQubits * layers, 0.1);
+  runWorkload(state, [&]() { return minimize(kernel, H, initial); });
+}
+BENCHMARK(BM_VQE)
+    ->Args({4, 2})
+    ->Args({4, 4})
+    ->Args({8, 2})
+    ->Args({12, 2})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// @brief QAOA of range(1) layers for MaxCut of the ring of range(0) nodes.
+void BM_QAOAMaxCut(benchmark::State &state) {
+  const std::size_t nNodes = state.range(0), layers = state.range(1);
+  using namespace cudaq::spin;
+  cudaq::spin_op H = 0.5 * z(0) * z(1) - 0.5;
+  for (std::size_t i = 1; i < nNodes; i++)
+    H += 0.5 * z(i) * z((i + 1) % nNodes) - 0.5;
+
+  auto [kernel, angles] = cudaq::make_kernel<std::vector<double>>();
+  auto q = kernel.qalloc(nNodes);
+  kernel.h(q);
+  for (std::size_t layer = 0; layer < layers; layer++) {
+    auto gamma = angles[2 * layer];
+    auto beta = angles[2 * layer + 1];
+    for (std::size_t i = 0; i < nNodes; i++) {
+      auto j = (i + 1) % nNodes;
+      kernel.x<cudaq::ctrl>(q[i], q[j]);
+      kernel.rz(2.0 * gamma, q[j]);
+      kernel.x<cudaq::ctrl>(q[i], q[j]);
+    }
+    for (std::size_t i = 0; i < nNodes; i++)
+      kernel.rx(2.0 * beta, q[i]);
+  }
+
+  std::vector<double> initial(2 * layers, 0.5);
+  runWorkload(state, [&]() { return minimize(kernel, H, initial); });
+}
+BENCHMARK(BM_QAOAMaxCut)
+    ->Args({6, 1})
+    ->Args({6, 3})
+    ->Args({12, 1})
+    ->Args({12, 3})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// @brief Apply the phase `angle` to |11> of `control` and `target`, with
+/// r1 rotations and CNOTs only.
+template <typename Kernel, typename Angle>
+void controlledPhase(Kernel &kernel, Angle angle, cudaq::QuakeValue control,
+                     cudaq::QuakeValue target) {
+  kernel.r1(0.5 * angle, control);
+  kernel.template x<cudaq::ctrl>(control, target);
+  kernel.r1(-0.5 * angle, target);
+  kernel.template x<cudaq::ctrl>(control, target);
+  kernel.r1(0.5 * angle, target);
+}
+
+/// @brief Phase estimation of the r1 gate on its eigenstate |1>, with
+/// range(0) counting qubits, sampled 1000 times.
+void BM_PhaseEstimation(benchmark::State &state) {
+  const std::size_t nCounting = state.range(0);
+  auto [kernel, phase] = cudaq::make_kernel<double>();
+  auto counting = kernel.qalloc(nCounting);
+  auto target = kernel.qalloc();
+  kernel.x(target);
+  kernel.h(counting);
+  for (std::size_t i = 0; i < nCounting; i++)
+    controlledPhase(kernel, (2.0 * M_PI * std::pow(2.0, i)) * phase,
+                    counting[i], target);
+
+  // The inverse quantum Fourier transform.
+  for (std::size_t i = 0; i < nCounting / 2; i++) {
+    auto a = counting[i], b = counting[nCounting - i - 1];
+    kernel.x<cudaq::ctrl>(a, b);
+    kernel.x<cudaq::ctrl>(b, a);
+    kernel.x<cudaq::ctrl>(a, b);
+  }
+  for (std::size_t i = 0; i < nCounting; i++) {
+    for (std::size_t j = 0; j < i; j++)
+      controlledPhase(kernel, -M_PI / std::pow(2.0, i - j), counting[j],
+                      counting[i]);
+    kernel.h(counting[i]);
+  }
+  kernel.mz(counting);
+
+  runWorkload(state, [&]() {
+    auto counts = cudaq::sample(kernel, 0.375);
+    return static_cast<double>(counts.size());
+  });
+}
+BENCHMARK(BM_PhaseEstimation)
+    ->DenseRange(4, 16, 4)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
+
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+
+  auto &platform = cudaq::get_platform();
+  if (auto *target = std::getenv("CUDAQ_BENCHMARK_TARGET"))
+    platform.setTargetBackend(target);
+  benchmark::AddCustomContext("cudaq_platform", platform.name());
+  benchmark::AddCustomContext("cudaq_num_qpus",
+                              std::to_string(platform.num_qpus()));
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "common/RuntimeMLIR.h"
+#include "cudaq/Frontend/nvqpp/AttributeNames.h"
+#include "cudaq/builder.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Parser/Parser.h"
+#include "llvm/Support/raw_ostream.h"
+#include <benchmark/benchmark.h>
+
+/// @brief Build a kernel of `nQubits` qubits and `depth` layers of gates,
+/// with `angle` as the angle of its first rotation. Kernels of distinct
+/// angles are distinct code, which the JIT cache does not share.
+static void buildKernel(cudaq::kernel_builder<> &kernel, std::size_t nQubits,
+                        std::size_t depth, double angle) {
+  auto q = kernel.qalloc(nQubits);
+  for (std::size_t d = 0; d < depth; d++) {
+    for (std::size_t i = 0; i < nQubits; i++) {
+      kernel.h(q[i]);
+      kernel.rz(angle + d + i, q[i]);
+    }
+    for (std::size_t i = 0; i + 1 < nQubits; i++)
+      kernel.x<cudaq::ctrl>(q[i], q[i + 1]);
+  }
+  kernel.mz(q);
+}
+
+/// @brief Building the Quake code of a kernel of range(0) layers of gates on
+/// 20 qubits.
+static void BM_BuildQuake(benchmark::State &state) {
+  for (auto _ : state) {
+    auto kernel = cudaq::make_kernel();
+    buildKernel(kernel, 20, state.range(0), 0.5);
+    benchmark::DoNotOptimize(kernel.to_quake());
+  }
+}
+BENCHMARK(BM_BuildQuake)
+    ->RangeMultiplier(4)
+    ->Range(1, 64)
+    ->Unit(benchmark::kMillisecond);
+
+/// @brief The latency of the JIT compilation of a kernel of range(0) layers
+/// of gates on 20 qubits, from Quake to executable code.
+static void BM_JitCompile(benchmark::State &state) {
+  std::size_t iteration = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto kernel = cudaq::make_kernel();
+    buildKernel(kernel, 20, state.range(0), 1e-6 * ++iteration);
+    state.ResumeTiming();
+    kernel.jitCode();
+  }
+}
+BENCHMARK(BM_JitCompile)
+    ->RangeMultiplier(4)
+    ->Range(1, 64)
+    ->Unit(benchmark::kMillisecond);
+
+/// @brief The lowering of a kernel of range(0) layers of gates on 20 qubits
+/// to OpenQASM 2, as the REST QPU lowers the kernels it submits: the config
+/// pass pipeline, the post-synthesis simplifications and the translation.
+static void BM_RestLowering(benchmark::State &state) {
+  auto kernel = cudaq::make_kernel();
+  buildKernel(kernel, 20, state.range(0), 0.5);
+  auto *context = cudaq::acquireMLIRContext();
+  {
+    auto module =
+        mlir::parseSourceString<mlir::ModuleOp>(kernel.to_quake(), context);
+    module->walk([](mlir::func::FuncOp func) {
+      func->setAttr(cudaq::entryPointAttrName,
+                    mlir::UnitAttr::get(func.getContext()));
+    });
+    auto &translation = cudaq::getTranslation("qasm2");
+    for (auto _ : state) {
+      mlir::OwningOpRef<mlir::ModuleOp> lowered(module->clone());
+      if (mlir::failed(cudaq::runPassPipeline(
+              "canonicalize,func.func(quake-op-cancellation),"
+              "func.func(quake-remove-dead-qubits),canonicalize",
+              *lowered))) {
+        state.SkipWithError("Quake lowering failed.");
+        break;
+      }
+      std::string code;
+      llvm::raw_string_ostream os(code);
+      if (mlir::failed(translation(*lowered, os))) {
+        state.SkipWithError("OpenQASM translation failed.");
+        break;
+      }
+      benchmark::DoNotOptimize(os.str());
+    }
+  }
+  cudaq::releaseMLIRContext(context);
+}
+BENCHMARK(BM_RestLowering)
+    ->RangeMultiplier(4)
+    ->Range(1, 64)
+    ->Unit(benchmark::kMillisecond);
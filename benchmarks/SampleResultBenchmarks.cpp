@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "common/MeasureCounts.h"
+#include <benchmark/benchmark.h>
+#include <random>
+
+static constexpr std::size_t nBits = 32;
+
+/// @brief Return the counts of `nStrings` random bit strings of nBits bits,
+/// packed, each observed up to 100 times.
+static cudaq::ExecutionResult randomCounts(std::size_t nStrings,
+                                           std::uint64_t seed) {
+  std::mt19937_64 gen(seed);
+  std::uniform_int_distribution<std::size_t> count(1, 100);
+  cudaq::ExecutionResult result;
+  for (std::size_t i = 0; i < nStrings; i++) {
+    std::uint64_t bits = gen() & ((std::uint64_t(1) << nBits) - 1);
+    result.appendResult(&bits, nBits, count(gen));
+  }
+  return result;
+}
+
+/// @brief Appending range(0) packed bit strings to an ExecutionResult.
+static void BM_SampleResultAppend(benchmark::State &state) {
+  for (auto _ : state)
+    benchmark::DoNotOptimize(randomCounts(state.range(0), 1));
+  state.SetItemsProcessed(state.range(0) * state.iterations());
+}
+BENCHMARK(BM_SampleResultAppend)->RangeMultiplier(10)->Range(100, 1000000);
+
+/// @brief Merging the sample_results of 8 QPUs of range(0) bit strings each.
+static void BM_SampleResultMerge(benchmark::State &state) {
+  std::vector<cudaq::sample_result> results;
+  for (std::size_t qpu = 0; qpu < 8; qpu++)
+    results.emplace_back(randomCounts(state.range(0), qpu));
+  for (auto _ : state) {
+    auto copies = results;
+    benchmark::DoNotOptimize(cudaq::sample_result::merge(copies));
+  }
+  state.SetItemsProcessed(8 * state.range(0) * state.iterations());
+}
+BENCHMARK(BM_SampleResultMerge)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond);
+
+/// @brief The <Z...Z> expectation of range(0) bit strings.
+static void BM_SampleResultExpValZ(benchmark::State &state) {
+  cudaq::sample_result result(randomCounts(state.range(0), 1));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(result.exp_val_z());
+  state.SetItemsProcessed(state.range(0) * state.iterations());
+}
+BENCHMARK(BM_SampleResultExpValZ)->RangeMultiplier(10)->Range(100, 1000000);
+
+/// @brief The most probable of range(0) bit strings.
+static void BM_SampleResultMostProbable(benchmark::State &state) {
+  cudaq::sample_result result(randomCounts(state.range(0), 1));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(result.most_probable());
+  state.SetItemsProcessed(state.range(0) * state.iterations());
+}
+BENCHMARK(BM_SampleResultMostProbable)
+    ->RangeMultiplier(10)
+    ->Range(100, 1000000);
+
+/// @brief Serializing and deserializing range(0) bit strings, as results are
+/// sent between processes.
+static void BM_SampleResultSerialize(benchmark::State &state) {
+  cudaq::sample_result result(randomCounts(state.range(0), 1));
+  for (auto _ : state) {
+    auto data = result.serialize();
+    cudaq::sample_result copy;
+    copy.deserialize(data);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.range(0) * state.iterations());
+}
+BENCHMARK(BM_SampleResultSerialize)
+    ->RangeMultiplier(10)
+    ->Range(100, 100000)
+    ->Unit(benchmark::kMillisecond);
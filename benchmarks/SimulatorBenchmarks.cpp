@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include <benchmark/benchmark.h>
+#include <cudaq.h>
+#include <cudaq/algorithm.h>
+
+// The benchmarks of the simulator backends. This file is compiled into one
+// executable per backend, see benchmarks/CMakeLists.txt.
+
+/// @brief Layers of single-qubit gates followed by a chain of CNOTs.
+struct gate_layers {
+  void operator()(int nQubits, int depth) __qpu__ {
+    cudaq::qreg q(nQubits);
+    for (int d = 0; d < depth; d++) {
+      for (int i = 0; i < nQubits; i++) {
+        h(q[i]);
+        rz(0.25 * (d + 1), q[i]);
+      }
+      for (int i = 0; i < nQubits - 1; i++)
+        x<cudaq::ctrl>(q[i], q[i + 1]);
+    }
+  }
+};
+
+/// @brief A GHZ state, measured.
+struct ghz {
+  void operator()(int nQubits) __qpu__ {
+    cudaq::qreg q(nQubits);
+    h(q[0]);
+    for (int i = 0; i < nQubits - 1; i++)
+      x<cudaq::ctrl>(q[i], q[i + 1]);
+    mz(q);
+  }
+};
+
+/// @brief A hardware efficient ansatz of one layer.
+struct ansatz {
+  void operator()(int nQubits, double theta) __qpu__ {
+    cudaq::qreg q(nQubits);
+    for (int i = 0; i < nQubits; i++)
+      ry(theta * (i + 1), q[i]);
+    for (int i = 0; i < nQubits - 1; i++)
+      x<cudaq::ctrl>(q[i], q[i + 1]);
+  }
+};
+
+static constexpr int depth = 10;
+
+/// @brief The gates applied per second, including the allocation of the
+/// state, for range(0) qubits.
+static void BM_GateLayers(benchmark::State &state) {
+  const int nQubits = state.range(0);
+  for (auto _ : state)
+    gate_layers{}(nQubits, depth);
+  const double gates = depth * (3.0 * nQubits - 1);
+  state.counters["gates"] = benchmark::Counter(
+      gates * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_GateLayers)
+    ->DenseRange(10, CUDAQ_BENCHMARK_MAX_QUBITS, 2)
+    ->Unit(benchmark::kMillisecond);
+
+/// @brief Sampling a 20-qubit GHZ state (fewer if the backend cannot hold
+/// that many) range(0) times.
+static void BM_Sample(benchmark::State &state) {
+  const int nQubits = std::min(20, CUDAQ_BENCHMARK_MAX_QUBITS);
+  const std::size_t shots = state.range(0);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(cudaq::sample(shots, ghz{}, nQubits));
+  state.counters["shots"] = benchmark::Counter(
+      shots * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Sample)
+    ->RangeMultiplier(10)
+    ->Range(1, 100000)
+    ->Unit(benchmark::kMillisecond);
+
+/// @brief Observing a random spin_op of range(1) terms on range(0) qubits.
+static void BM_Observe(benchmark::State &state) {
+  const int nQubits = state.range(0);
+  auto h = cudaq::spin_op::random(nQubits, state.range(1));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(cudaq::observe(ansatz{}, h, nQubits, 0.3));
+  state.counters["terms"] = benchmark::Counter(
+      h.n_terms() * state.iterations(), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Observe)
+    ->ArgsProduct({{std::min(12, CUDAQ_BENCHMARK_MAX_QUBITS),
+                    CUDAQ_BENCHMARK_MAX_QUBITS},
+                   {10, 100, 1000, 10000}})
+    ->Unit(benchmark::kMillisecond);
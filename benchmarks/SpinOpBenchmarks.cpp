@@ -0,0 +1,64 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "cudaq/spin_op.h"
+#include <benchmark/benchmark.h>
+
+static constexpr std::size_t nQubits = 40;
+
+/// @brief The sum of two random spin_ops of range(0) terms.
+static void BM_SpinOpAdd(benchmark::State &state) {
+  auto a = cudaq::spin_op::random(nQubits, state.range(0));
+  auto b = cudaq::spin_op::random(nQubits, state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(a + b);
+  state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_SpinOpAdd)->RangeMultiplier(10)->Range(10, 100000)->Complexity();
+
+/// @brief The product of two random spin_ops of range(0) terms.
+static void BM_SpinOpMultiply(benchmark::State &state) {
+  auto a = cudaq::spin_op::random(nQubits, state.range(0));
+  auto b = cudaq::spin_op::random(nQubits, state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(a * b);
+  state.SetComplexityN(state.range(0) * state.range(0));
+}
+BENCHMARK(BM_SpinOpMultiply)
+    ->RangeMultiplier(4)
+    ->Range(16, 1024)
+    ->Complexity();
+
+/// @brief The commutator of two random spin_ops of range(0) terms.
+static void BM_SpinOpCommutator(benchmark::State &state) {
+  auto a = cudaq::spin_op::random(nQubits, state.range(0));
+  auto b = cudaq::spin_op::random(nQubits, state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(cudaq::commutator(a, b));
+}
+BENCHMARK(BM_SpinOpCommutator)->RangeMultiplier(4)->Range(16, 1024);
+
+/// @brief The qubit-wise commuting groups of the terms of a random spin_op of
+/// range(0) terms, which observations measure together.
+static void BM_SpinOpGroups(benchmark::State &state) {
+  auto h = cudaq::spin_op::random(nQubits, state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(h.get_qubit_wise_commuting_groups());
+}
+BENCHMARK(BM_SpinOpGroups)->RangeMultiplier(10)->Range(10, 10000);
+
+/// @brief The sparse matrix of a random spin_op of 100 terms on range(0)
+/// qubits.
+static void BM_SpinOpSparseMatrix(benchmark::State &state) {
+  auto h = cudaq::spin_op::random(state.range(0), 100);
+  for (auto _ : state)
+    benchmark::DoNotOptimize(h.to_sparse_matrix());
+}
+BENCHMARK(BM_SpinOpSparseMatrix)
+    ->DenseRange(8, 16, 4)
+    ->Unit(benchmark::kMillisecond);
@@ -18,6 +18,7 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Rewrite/Core/Rewriter.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/ScopedHashTable.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
@@ -369,7 +370,7 @@ private:
     return toSourceLocation(getMLIRContext(), getContext(), srcRange);
   }
 
-  /// Convert an AST QualType to a Type.
+  /// Convert an AST QualType to a Type. The conversions are memoized.
   mlir::Type genType(const clang::QualType &ty);
 
   /// Add an entry block to FuncOp \p func corresponding to the AST FunctionDecl
@@ -479,6 +480,11 @@ private:
   /// Stack of Types built by the visitor. (right-to-left ordering)
   llvm::SmallVector<mlir::Type> typeStack;
   llvm::SmallVector<clang::RecordType *> records;
+  /// The converted types, keyed on the opaque pointer of the QualType. Types
+  /// referring to a lambda are not memoized, see genType().
+  llvm::DenseMap<void *, mlir::Type> typeCache;
+  /// Set when a lambda record type is traversed.
+  bool sawLambdaType = false;
   bool visitImplicitCode = false;
   bool visitTemplateInstantiations = false;
   bool typeMode = false;
@@ -16,4 +16,9 @@ static constexpr char entryPointAttrName[] = "cudaq-entrypoint";
 /// Name of the attribute attached to cudaq kernels.
 static constexpr char kernelAttrName[] = "cudaq-kernel";
 
+/// Name of the attribute attached to kernels whose qubits are mapped to the
+/// qubits of a device, with the device qubit of each kernel qubit at the end
+/// of the kernel.
+static constexpr char qubitLayoutAttrName[] = "cudaq-qubit-layout";
+
 } // namespace cudaq
@@ -24,4 +24,10 @@ static constexpr unsigned cudaqGenPrefixLength = sizeof(cudaqGenPrefixName) - 1;
 /// to the runtime library (and be handled at runtime).
 static constexpr const char launchKernelFuncName[] = "altLaunchKernel";
 
+/// Name of the runtime query made by a kernel entry procedure with vector
+/// arguments. It returns true when the data of the vectors can be passed to
+/// `launchKernelFuncName` by reference instead of being copied.
+static constexpr const char argsByReferenceFuncName[] =
+    "altArgumentsByReference";
+
 } // namespace cudaq::runtime
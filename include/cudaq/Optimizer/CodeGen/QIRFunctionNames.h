@@ -19,6 +19,7 @@ constexpr static const char QIRMeasureBody[] = "__quantum__qis__mz__body";
 constexpr static const char QIRMeasure[] = "__quantum__qis__mz";
 constexpr static const char QIRMeasureToRegister[] =
     "__quantum__qis__mz__to__register";
+constexpr static const char QIRMeasureArray[] = "__quantum__qis__mz__array";
 
 constexpr static const char QIRCnot[] = "__quantum__qis__cnot";
 constexpr static const char QIRCphase[] = "__quantum__qis__cphase";
@@ -27,6 +28,10 @@ constexpr static const char QIRReadResultBody[] =
 
 constexpr static const char NVQIRInvokeWithControlBits[] =
     "invokeWithControlQubits";
+constexpr static const char NVQIRCustomUnitary[] =
+    "__quantum__qis__custom_unitary";
+constexpr static const char NVQIRProductState[] =
+    "__quantum__qis__product_state";
 constexpr static const char NVQIRPackSingleQubitInArray[] =
     "packSingleQubitInArray";
 constexpr static const char NVQIRReleasePackedQubitArray[] =
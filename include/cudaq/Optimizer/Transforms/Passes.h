@@ -19,6 +19,11 @@
 
 namespace cudaq::opt {
 
+/// Attribute set by lambda lifting on the applications of the compute part of
+/// a compute_action. They are not controlled by the control variant of the
+/// kernel, since U V U^dag is the identity when the controls do not hold.
+static constexpr char computeActionComputeAttrName[] = "compute_action.compute";
+
 /// Pass to generate the device code loading stubs.
 std::unique_ptr<mlir::Pass> createGenerateKernelExecution();
 
@@ -47,11 +52,31 @@ std::unique_ptr<mlir::Pass> createLoopUnrollPass(std::size_t maxIterations);
 std::unique_ptr<mlir::Pass> createLowerToCFGPass();
 std::unique_ptr<mlir::Pass> createQuakeAddMetadata();
 std::unique_ptr<mlir::Pass> createQuakeAddDeallocs();
+std::unique_ptr<mlir::Pass> createQuakeDeferMeasurementsPass();
+std::unique_ptr<mlir::Pass>
+createQuakeDeferMeasurementsPass(std::size_t maxAncillas);
+std::unique_ptr<mlir::Pass> createQuakeFoldConstantGatesPass();
+std::unique_ptr<mlir::Pass> createQuakeFoldGatesPass();
+std::unique_ptr<mlir::Pass> createQuakeFoldGatesPass(std::size_t scale);
+std::unique_ptr<mlir::Pass> createQuakeGateFusionPass();
+std::unique_ptr<mlir::Pass> createQuakeGateFusionPass(std::size_t maxQubits);
+std::unique_ptr<mlir::Pass> createQuakeHoistAllocationsPass();
+std::unique_ptr<mlir::Pass> createQuakeOpCancellationPass();
 std::unique_ptr<mlir::Pass> createQuakeObserveAnsatzPass();
 std::unique_ptr<mlir::Pass> createQuakeObserveAnsatzPass(std::vector<bool> &);
+std::unique_ptr<mlir::Pass> createQuakeQubitMappingPass();
+std::unique_ptr<mlir::Pass>
+createQuakeQubitMappingPass(llvm::StringRef couplingMap);
+std::unique_ptr<mlir::Pass> createQuakeProductStatePass();
+std::unique_ptr<mlir::Pass> createQuakeQubitReusePass();
+std::unique_ptr<mlir::Pass> createQuakeRemoveDeadQubitsPass();
+std::unique_ptr<mlir::Pass> createQuakeResourceEstimatePass();
 std::unique_ptr<mlir::Pass> createQuakeSynthesizer();
 std::unique_ptr<mlir::Pass> createQuakeSynthesizer(std::string_view, void *);
 std::unique_ptr<mlir::Pass> createRaiseToAffinePass();
+std::unique_ptr<mlir::Pass> createSingleQubitResynthesisPass();
+std::unique_ptr<mlir::Pass>
+createSingleQubitResynthesisPass(llvm::StringRef basis);
 std::unique_ptr<mlir::Pass> createUnwindLoweringPass();
 std::unique_ptr<mlir::Pass> createOpCancellationPass();
 std::unique_ptr<mlir::Pass> createOpDecompositionPass();
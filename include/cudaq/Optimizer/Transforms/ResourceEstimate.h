@@ -0,0 +1,94 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class raw_ostream;
+} // namespace llvm
+
+namespace mlir::func {
+class FuncOp;
+} // namespace mlir::func
+
+namespace cudaq::opt {
+
+/// A count of resources, as a polynomial with non-negative integer
+/// coefficients in the numbers of iterations of the loops whose bounds are
+/// not known at compile time. The numbers of iterations of the loops bounded
+/// by an argument of the kernel are named `argN`, those of the other loops
+/// `nN`.
+class ResourceCount {
+public:
+  /// A product of symbols, sorted. The empty product is the constant term.
+  using Monomial = std::vector<std::string>;
+
+  ResourceCount() = default;
+  ResourceCount(std::int64_t value) {
+    if (value)
+      terms[{}] = value;
+  }
+  static ResourceCount getSymbol(const std::string &name) {
+    ResourceCount count;
+    count.terms[{name}] = 1;
+    return count;
+  }
+
+  bool isConstant() const {
+    return terms.empty() || (terms.size() == 1 && terms.count({}));
+  }
+  /// The constant term, the value of a constant count.
+  std::int64_t getConstant() const {
+    auto iter = terms.find({});
+    return iter == terms.end() ? 0 : iter->second;
+  }
+  const std::map<Monomial, std::int64_t> &getTerms() const { return terms; }
+
+  ResourceCount &operator+=(const ResourceCount &other);
+  ResourceCount operator*(const ResourceCount &other) const;
+  /// Return an upper bound of the larger of the counts: the larger one if
+  /// they are comparable, else the largest coefficient of every monomial.
+  static ResourceCount max(const ResourceCount &a, const ResourceCount &b);
+
+  void print(llvm::raw_ostream &os) const;
+
+private:
+  std::map<Monomial, std::int64_t> terms;
+};
+
+/// The resources of a kernel, for one execution.
+struct ResourceEstimate {
+  /// The qubits allocated.
+  ResourceCount qubits;
+  /// The gates, and those of them that act on exactly two qubits.
+  ResourceCount gates;
+  ResourceCount twoQubitGates;
+  /// The qubits measured.
+  ResourceCount measurements;
+  /// An upper bound of the depth, exact for straight-line kernels. Every gate,
+  /// measurement and reset is a layer on its qubits.
+  ResourceCount depth;
+  /// The gates by name, prefixed with a `c` per control (e.g. `h`, `cx`,
+  /// `ccx`), or `mc` if the number of controls is not known.
+  std::map<std::string, ResourceCount> gateCounts;
+
+  void print(llvm::raw_ostream &os) const;
+};
+
+/// Return the resources used by an execution of `kernel`. The counts of the
+/// operations in a loop are multiplied by its number of iterations, and those
+/// of the two branches of a conditional are bounded by the larger one. Calls
+/// are followed into the kernels of the same module.
+ResourceEstimate estimateResources(mlir::func::FuncOp kernel);
+
+} // namespace cudaq::opt
@@ -19,4 +19,10 @@ namespace cudaq {
 mlir::LogicalResult translateToOpenQASM(mlir::Operation *op,
                                         llvm::raw_ostream &os);
 
+/// Translates the given module to OpenQASM 3 code whose entry point
+/// parameters are `input` parameters, so that the program is compiled once
+/// and its parameters are bound at every execution.
+mlir::LogicalResult translateToParameterizedOpenQASM(mlir::Operation *op,
+                                                     llvm::raw_ostream &os);
+
 } // namespace cudaq
@@ -12,8 +12,10 @@
 #include "cudaq/Optimizer/Dialect/Quake/QuakeTypes.h"
 #include "clang/AST/ParentMapContext.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Timer.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/IR/IRMapping.h"
@@ -25,6 +27,11 @@
 
 using namespace mlir;
 
+static llvm::cl::opt<bool> timeKernels(
+    "time-kernels",
+    llvm::cl::desc("Report the time spent lowering each kernel to Quake."),
+    llvm::cl::init(false));
+
 // Generate a list (as a vector) of all the reachable functions recorded in the
 // call graph, \p cgn.
 static llvm::SmallVector<clang::Decl *>
@@ -364,8 +371,17 @@ void ASTBridgeAction::ASTBridgeConsumer::HandleTranslationUnit(
       &astContext, ctx, builder, module.get(), symbol_table, functionsToEmit,
       reachableFuncs, cxx_mangled_kernel_names, ci, mangler);
 
-  // Lower each kernel entry function.
+  // The timers of the kernels are printed when the group is destroyed.
+  llvm::TimerGroup kernelTimers("cudaq-kernels", "Kernel lowering time report");
+  std::deque<llvm::Timer> timers;
+
+  // Lower each kernel entry function. A kernel may be found more than once,
+  // e.g. a template instantiated from several declarations, it is only lowered
+  // the first time.
+  llvm::SmallPtrSet<const clang::FunctionDecl *, 16> loweredFuncs;
   for (auto fdPair : functionsToEmit) {
+    if (!loweredFuncs.insert(fdPair.second).second)
+      continue;
     SymbolTableScope var_scope(symbol_table);
     std::string entryName = visitor.generateQodaKernelName(fdPair);
     visitor.setEntryName(entryName);
@@ -373,7 +389,12 @@ void ASTBridgeAction::ASTBridgeConsumer::HandleTranslationUnit(
     auto mangledFuncName = visitor.cxxMangledDeclName(fdPair.second);
     cxx_mangled_kernel_names.insert({entryName, mangledFuncName});
     LLVM_DEBUG(llvm::dbgs() << "lowering function: " << entryName << '\n');
-    visitor.TraverseDecl(const_cast<clang::FunctionDecl *>(fdPair.second));
+    {
+      llvm::TimeRegion region(
+          timeKernels ? &timers.emplace_back(entryName, entryName, kernelTimers)
+                      : nullptr);
+      visitor.TraverseDecl(const_cast<clang::FunctionDecl *>(fdPair.second));
+    }
     if (auto func = module->lookupSymbol<func::FuncOp>(entryName)) {
       // Rationale: If a function marked as quantum code takes or returns
       // qubits, then it must be a pure quantum kernel that can only be called
@@ -177,6 +177,7 @@ bool QuakeBridgeVisitor::TraverseUsingType(clang::UsingType *t) {
 bool QuakeBridgeVisitor::TraverseRecordType(clang::RecordType *t) {
   auto *recDecl = t->getDecl();
   if (recDecl->isLambda()) {
+    sawLambdaType = true;
     // Traverse implicit code will traverse inline lambdas.
     visitImplicitCode = t->getDecl()->isLambda();
     return TraverseCXXRecordDecl(cast<clang::CXXRecordDecl>(recDecl));
@@ -440,13 +441,25 @@ SmallVector<Type> QuakeBridgeVisitor::lastTypes(unsigned n) {
 
 Type QuakeBridgeVisitor::genType(const clang::QualType &ty) {
   LLVM_DEBUG(llvm::dbgs() << "type to generate: " << ty << '\n');
+  // Kernels repeat the same few types over and over, so each type is only
+  // traversed once. Types referring to a lambda are traversed every time, as
+  // the traversal of a lambda's record visits its implicit code.
+  auto *key = ty.getAsOpaquePtr();
+  if (auto iter = typeCache.find(key); iter != typeCache.end())
+    return iter->second;
   bool saveTypeMode = typeMode;
+  bool saveSawLambdaType = sawLambdaType;
   typeMode = true;
+  sawLambdaType = false;
   bool res = TraverseType(ty);
   if (!res)
     TODO("type conversion to MLIR type");
   typeMode = saveTypeMode;
-  return popType();
+  auto result = popType();
+  if (!sawLambdaType)
+    typeCache.try_emplace(key, result);
+  sawLambdaType |= saveSawLambdaType;
+  return result;
 }
 
 std::optional<FunctionType>
@@ -91,6 +91,11 @@ static constexpr IntrinsicCode intrinsicTable[] = {
     return %3 : !llvm.struct<(ptr<i8>, i64)>
   })#"},
 
+    {cudaq::runtime::argsByReferenceFuncName, // altArgumentsByReference
+     {},
+     R"#(
+  func.func private @altArgumentsByReference() -> i1)#"},
+
     {cudaq::runtime::launchKernelFuncName, // altLaunchKernel
      {},
      R"#(
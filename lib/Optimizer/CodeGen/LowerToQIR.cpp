@@ -577,10 +577,10 @@ public:
   }
 };
 
-/// Lower single target Quantum ops with two parameters to QIR:
+/// Lower single target Quantum ops with several parameters to QIR:
 /// u2, u3
 template <typename OP>
-class OneTargetTwoParamLowering : public ConvertOpToLLVMPattern<OP> {
+class OneTargetMultiParamLowering : public ConvertOpToLLVMPattern<OP> {
 public:
   using Base = ConvertOpToLLVMPattern<OP>;
   using Base::Base;
@@ -595,37 +595,38 @@ public:
     auto *context = instOp.getContext();
     auto qirFunctionName = std::string(cudaq::opt::QIRQISPrefix) + instName;
 
-    SmallVector<Type> tmpArgTypes;
-    auto qubitIndexType = cudaq::opt::getQubitType(context);
-
-    auto paramType = FloatType::getF64(context);
-    tmpArgTypes.push_back(paramType);
-    tmpArgTypes.push_back(qubitIndexType);
-
-    FlatSymbolRefAttr symbolRef = cudaq::opt::factory::createLLVMFunctionSymbol(
-        qirFunctionName, /*return type=*/LLVM::LLVMVoidType::get(context),
-        std::move(tmpArgTypes), parentModule);
-
-    SmallVector<Value> funcArgs;
-    auto castToDouble = [&](Value v) {
-      if (v.getType().getIntOrFloatBitWidth() < 64)
-        v = rewriter.create<arith::ExtFOp>(loc, rewriter.getF64Type(), v);
-      return v;
-    };
-    Value v = adaptor.getOperands()[0];
-    v = instOp.getIsAdj() ? rewriter.create<arith::NegFOp>(loc, v) : v;
-    funcArgs.push_back(castToDouble(v));
-    v = adaptor.getOperands()[1];
-    v = instOp.getIsAdj() ? rewriter.create<arith::NegFOp>(loc, v) : v;
-    funcArgs.push_back(castToDouble(v));
-
     // TODO: What about the control qubits?
     if (numControls != 0)
       return instOp.emitError("unsupported controlled op " + instName +
                               " with " + std::to_string(numControls) +
                               " ctrl qubits");
 
-    funcArgs.push_back(adaptor.getOperands()[numControls + 2]);
+    SmallVector<Value> params(adaptor.getParameters().begin(),
+                              adaptor.getParameters().end());
+    if (instOp.getIsAdj()) {
+      // u3(θ,φ,λ)† = u3(-θ,-λ,-φ), u2 has no adjoint of the same form.
+      if (params.size() != 3)
+        return instOp.emitError("unsupported adjoint op " + instName);
+      std::swap(params[1], params[2]);
+      for (auto &param : params)
+        param = rewriter.create<arith::NegFOp>(loc, param);
+    }
+
+    SmallVector<Type> tmpArgTypes;
+    SmallVector<Value> funcArgs;
+    for (auto param : params) {
+      if (param.getType().getIntOrFloatBitWidth() < 64)
+        param = rewriter.create<arith::ExtFOp>(loc, rewriter.getF64Type(),
+                                               param);
+      tmpArgTypes.push_back(rewriter.getF64Type());
+      funcArgs.push_back(param);
+    }
+    tmpArgTypes.push_back(cudaq::opt::getQubitType(context));
+    funcArgs.push_back(adaptor.getTargets().front());
+
+    FlatSymbolRefAttr symbolRef = cudaq::opt::factory::createLLVMFunctionSymbol(
+        qirFunctionName, /*return type=*/LLVM::LLVMVoidType::get(context),
+        std::move(tmpArgTypes), parentModule);
 
     // Create the CallOp for this quantum instruction
     rewriter.replaceOpWithNewOp<LLVM::CallOp>(instOp, TypeRange{}, symbolRef,
@@ -677,6 +678,91 @@ public:
   }
 };
 
+/// Lower a unitary fused at compile time to a call to
+/// __quantum__qis__custom_unitary(double*, i64, Qubit*...), with the matrix
+/// in a constant global.
+class UnitaryOpLowering : public ConvertOpToLLVMPattern<quake::UnitaryOp> {
+public:
+  using ConvertOpToLLVMPattern::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(quake::UnitaryOp unitary, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto loc = unitary.getLoc();
+    auto parentModule = unitary->getParentOfType<ModuleOp>();
+    auto context = parentModule->getContext();
+    auto f64Ty = rewriter.getF64Type();
+    auto i64Ty = rewriter.getI64Type();
+
+    // Identical unitaries share the same global.
+    ArrayRef<double> matrix = unitary.getMatrix();
+    auto builder = cudaq::IRBuilder::atBlockEnd(parentModule.getBody());
+    auto globalName =
+        "__nvqpp__unitary." +
+        builder.hashStringByContent(
+            StringRef(reinterpret_cast<const char *>(matrix.data()),
+                      matrix.size() * sizeof(double)));
+    auto globalTy = LLVM::LLVMArrayType::get(f64Ty, matrix.size());
+    if (!parentModule.lookupSymbol<LLVM::GlobalOp>(globalName)) {
+      auto tensorTy = RankedTensorType::get(
+          {static_cast<std::int64_t>(matrix.size())}, f64Ty);
+      builder.create<LLVM::GlobalOp>(
+          loc, globalTy, /*isConstant=*/true, LLVM::Linkage::Private,
+          globalName, DenseElementsAttr::get(tensorTy, matrix),
+          /*alignment=*/0);
+    }
+    Value address = rewriter.create<LLVM::AddressOfOp>(
+        loc, cudaq::opt::factory::getPointerType(globalTy), globalName);
+    Value matrixPtr = rewriter.create<LLVM::BitcastOp>(
+        loc, cudaq::opt::factory::getPointerType(f64Ty), address);
+
+    FlatSymbolRefAttr symbolRef = cudaq::opt::factory::createLLVMFunctionSymbol(
+        cudaq::opt::NVQIRCustomUnitary, LLVM::LLVMVoidType::get(context),
+        {cudaq::opt::factory::getPointerType(f64Ty), i64Ty}, parentModule,
+        /*isVar=*/true);
+    Value numTargets = rewriter.create<LLVM::ConstantOp>(
+        loc, i64Ty, adaptor.getTargets().size());
+    SmallVector<Value> args = {matrixPtr, numTargets};
+    args.append(adaptor.getTargets().begin(), adaptor.getTargets().end());
+    rewriter.replaceOpWithNewOp<LLVM::CallOp>(unitary, TypeRange{}, symbolRef,
+                                              args);
+    return success();
+  }
+};
+
+/// Lower a product state preparation to a call to
+/// __quantum__qis__product_state(double, double, double, double, i64,
+/// Qubit*...), with the amplitudes of the single-qubit state as arguments.
+class ProductStateOpLowering
+    : public ConvertOpToLLVMPattern<quake::ProductStateOp> {
+public:
+  using ConvertOpToLLVMPattern::ConvertOpToLLVMPattern;
+
+  LogicalResult
+  matchAndRewrite(quake::ProductStateOp prep, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    auto loc = prep.getLoc();
+    auto parentModule = prep->getParentOfType<ModuleOp>();
+    auto context = parentModule->getContext();
+    auto f64Ty = rewriter.getF64Type();
+    auto i64Ty = rewriter.getI64Type();
+
+    FlatSymbolRefAttr symbolRef = cudaq::opt::factory::createLLVMFunctionSymbol(
+        cudaq::opt::NVQIRProductState, LLVM::LLVMVoidType::get(context),
+        {f64Ty, f64Ty, f64Ty, f64Ty, i64Ty}, parentModule, /*isVar=*/true);
+    SmallVector<Value> args;
+    for (auto value : prep.getState())
+      args.push_back(rewriter.create<LLVM::ConstantOp>(
+          loc, f64Ty, rewriter.getF64FloatAttr(value)));
+    args.push_back(rewriter.create<LLVM::ConstantOp>(
+        loc, i64Ty, adaptor.getTargets().size()));
+    args.append(adaptor.getTargets().begin(), adaptor.getTargets().end());
+    rewriter.replaceOpWithNewOp<LLVM::CallOp>(prep, TypeRange{}, symbolRef,
+                                              args);
+    return success();
+  }
+};
+
 /// Lowers Quake MeasureOp to respective QIR function.
 /// mx, my, mz
 template <typename OP>
@@ -688,6 +774,9 @@ public:
   LogicalResult
   matchAndRewrite(OP measure, typename Base::OpAdaptor adaptor,
                   ConversionPatternRewriter &rewriter) const override {
+    // Whole registers are lowered by MeasureRegisterLowering.
+    if (measure.getTargets().front().getType().template isa<quake::QVecType>())
+      return failure();
     auto loc = measure->getLoc();
     auto parentModule = measure->template getParentOfType<ModuleOp>();
     auto context = parentModule->getContext();
@@ -752,6 +841,51 @@ public:
   }
 };
 
+/// Lowers the measurement of a whole register, left in place by
+/// expand-measurements with joint-registers set, to a single
+/// __quantum__qis__mz__array(Array*, i1*) call. The call writes the bits of
+/// all the qubits to a buffer, which becomes the std::vector<bool> result.
+class MeasureRegisterLowering : public ConvertOpToLLVMPattern<quake::MzOp> {
+public:
+  using Base = ConvertOpToLLVMPattern<quake::MzOp>;
+  using Base::Base;
+
+  LogicalResult
+  matchAndRewrite(quake::MzOp measure, OpAdaptor adaptor,
+                  ConversionPatternRewriter &rewriter) const override {
+    if (measure.getTargets().size() != 1 ||
+        !measure.getTargets().front().getType().isa<quake::QVecType>())
+      return failure();
+    auto loc = measure->getLoc();
+    auto parentModule = measure->getParentOfType<ModuleOp>();
+    auto context = parentModule->getContext();
+    auto arrayTy = cudaq::opt::getArrayType(context);
+    auto i1PtrTy = cudaq::opt::factory::getPointerType(rewriter.getI1Type());
+    auto i64Ty = rewriter.getI64Type();
+    Value qubits = adaptor.getTargets().front();
+
+    auto sizeRef = cudaq::opt::factory::createLLVMFunctionSymbol(
+        cudaq::opt::QIRArrayGetSize, i64Ty, {arrayTy}, parentModule);
+    Value size =
+        rewriter.create<LLVM::CallOp>(loc, i64Ty, sizeRef, ValueRange{qubits})
+            ->getResult(0);
+    Value buff = rewriter.create<LLVM::AllocaOp>(loc, i1PtrTy, size);
+    auto measureRef = cudaq::opt::factory::createLLVMFunctionSymbol(
+        cudaq::opt::QIRMeasureArray, LLVM::LLVMVoidType::get(context),
+        {arrayTy, i1PtrTy}, parentModule);
+    rewriter.create<LLVM::CallOp>(loc, TypeRange{}, measureRef,
+                                  ValueRange{qubits, buff});
+
+    auto resTy = getTypeConverter()->convertType(measure.getType());
+    auto zero = DenseI64ArrayAttr::get(context, ArrayRef<std::int64_t>{0});
+    auto one = DenseI64ArrayAttr::get(context, ArrayRef<std::int64_t>{1});
+    Value val = rewriter.create<LLVM::UndefOp>(loc, resTy);
+    val = rewriter.create<LLVM::InsertValueOp>(loc, val, buff, zero);
+    rewriter.replaceOpWithNewOp<LLVM::InsertValueOp>(measure, val, size, one);
+    return success();
+  }
+};
+
 /// Converts returning a Result* to returning a bit. QIR expects
 /// __quantum__qis__mz(Qubit*) to return a Result*, and CUDA Quantum expects
 /// mz to return a bool. In the library we let Result = bool, so Result* is
@@ -1064,7 +1198,8 @@ public:
         AllocaOpLowering, CallableClosureOpLowering, CallableFuncOpLowering,
         ConcatOpLowering, DeallocOpLowering, ExtractQubitOpLowering,
         FuncToPtrOpLowering, InstantiateCallableOpLowering,
-        MeasureLowering<quake::MzOp>, OneTargetLowering<quake::HOp>,
+        MeasureLowering<quake::MzOp>, MeasureRegisterLowering,
+        OneTargetLowering<quake::HOp>,
         OneTargetLowering<quake::XOp>, OneTargetLowering<quake::YOp>,
         OneTargetLowering<quake::ZOp>, OneTargetLowering<quake::SOp>,
         OneTargetLowering<quake::TOp>, ResetLowering<quake::ResetOp>,
@@ -1072,11 +1207,11 @@ public:
         OneTargetOneParamLowering<quake::RxOp>,
         OneTargetOneParamLowering<quake::RyOp>,
         OneTargetOneParamLowering<quake::RzOp>,
-        OneTargetTwoParamLowering<quake::U2Op>,
-        OneTargetTwoParamLowering<quake::U3Op>,
-        TwoTargetLowering<quake::SwapOp>, StdvecDataOpLowering,
-        StdvecInitOpLowering, StdvecSizeOpLowering, SubvecOpLowering,
-        UndefOpLowering>(typeConverter);
+        OneTargetMultiParamLowering<quake::U2Op>,
+        OneTargetMultiParamLowering<quake::U3Op>,
+        TwoTargetLowering<quake::SwapOp>, ProductStateOpLowering,
+        StdvecDataOpLowering, StdvecInitOpLowering, StdvecSizeOpLowering,
+        SubvecOpLowering, UndefOpLowering, UnitaryOpLowering>(typeConverter);
 
     target.addLegalDialect<LLVM::LLVMDialect>();
     target.addLegalOp<ModuleOp>();
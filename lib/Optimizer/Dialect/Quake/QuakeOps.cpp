@@ -229,6 +229,33 @@ LogicalResult quake::MzOp::verify() {
                            getBits().getType());
 }
 
+//===----------------------------------------------------------------------===//
+// UnitaryOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult quake::UnitaryOp::verify() {
+  if (getTargets().empty())
+    return emitOpError("must have at least one target");
+  std::size_t dim = 1ULL << getTargets().size();
+  if (getMatrix().size() != 2 * dim * dim)
+    return emitOpError("matrix must have ")
+           << 2 * dim * dim << " elements for " << getTargets().size()
+           << " targets";
+  return success();
+}
+
+//===----------------------------------------------------------------------===//
+// ProductStateOp
+//===----------------------------------------------------------------------===//
+
+LogicalResult quake::ProductStateOp::verify() {
+  if (getTargets().empty())
+    return emitOpError("must have at least one target");
+  if (getState().size() != 4)
+    return emitOpError("state must have 4 elements");
+  return success();
+}
+
 /// Never inline a `quake.apply` of a variant form of a kernel. The apply
 /// operation must be rewritten to a call before it is inlined when the apply is
 /// a variant form.
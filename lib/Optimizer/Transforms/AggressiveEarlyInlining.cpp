@@ -78,6 +78,8 @@ public:
     llvm::StringMap<llvm::StringRef> result;
     auto mangledNameMap =
         module->getAttrOfType<DictionaryAttr>("qtx.mangled_name_map");
+    if (!mangledNameMap)
+      return result;
     for (auto namedAttr : mangledNameMap) {
       auto key = namedAttr.getName();
       auto val = namedAttr.getValue().cast<StringAttr>().getValue();
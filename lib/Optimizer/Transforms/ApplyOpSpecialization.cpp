@@ -16,6 +16,7 @@
 #include "mlir/Dialect/SCF/IR/SCF.h"
 #include "mlir/IR/Dominance.h"
 #include "mlir/IR/IRMapping.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "mlir/Transforms/Passes.h"
 
@@ -43,6 +44,10 @@ struct ApplyOpAnalysis {
   ApplyOpAnalysis(ModuleOp op) : module(op) {
     performAnalysis(op.getOperation());
   }
+  ApplyOpAnalysis(ModuleOp op, ArrayRef<Operation *> roots) : module(op) {
+    for (auto *root : roots)
+      performAnalysis(root);
+  }
 
   const ApplyOpAnalysisInfo &getAnalysisInfo() const { return infoMap; }
 
@@ -53,18 +58,13 @@ private:
         return;
       auto callee = appOp.getCallee();
       auto funcOp = module.lookupSymbol<func::FuncOp>(callee);
-      auto *fnOp = funcOp.getOperation();
-      ApplyVariants variant;
-      auto it = infoMap.find(fnOp);
-      if (it != infoMap.end())
-        variant = it->second;
+      auto &variant = infoMap[funcOp.getOperation()];
       if (appOp.getIsAdj() && !appOp.getControls().empty())
         variant.needsAdjointControlVariant = true;
       else if (appOp.getIsAdj())
         variant.needsAdjointVariant = true;
       else if (!appOp.getControls().empty())
         variant.needsControlVariant = true;
-      infoMap.insert(std::make_pair(fnOp, variant));
     });
   }
 
@@ -85,6 +85,28 @@ static std::string getCtrlVariantFunctionName(const std::string &n) {
   return n + ".ctrl";
 }
 
+/// Returns true if \p op calls a kernel for its effect on quantum operands,
+/// which the control and adjoint of the caller must apply to the callee.
+static bool isQuantumCall(Operation &op) {
+  if (isa<quake::ApplyOp>(op))
+    return true;
+  auto call = dyn_cast<func::CallOp>(op);
+  return call && call.getNumResults() == 0 &&
+         llvm::any_of(call.getOperandTypes(), [](Type ty) {
+           return ty.isa<quake::QRefType, quake::QVecType>();
+         });
+}
+
+/// Returns true if \p op is, or recursively contains, a quantum gate or a
+/// kernel call.
+static bool hasQuantumEffect(Operation &op) {
+  return cudaq::opt::internal::hasCharacteristic(
+      [](Operation &op) {
+        return op.hasTrait<cudaq::QuantumGate>() || isQuantumCall(op);
+      },
+      op);
+}
+
 static std::string getVariantFunctionName(quake::ApplyOp appOp,
                                           const std::string &calleeName) {
   if (appOp.getIsAdj() && !appOp.getControls().empty())
@@ -319,16 +341,47 @@ class ApplySpecializationPass
     : public cudaq::opt::ApplySpecializationBase<ApplySpecializationPass> {
 public:
   void runOnOperation() override {
-    ApplyOpAnalysis analysis(getOperation());
-    const auto &applyVariants = analysis.getAnalysisInfo();
-    step1(applyVariants);
+    ModuleOp module = getOperation();
+    ApplyOpAnalysis analysis(module);
+    auto newFuncs = step1(analysis.getAnalysisInfo());
+    // The variants apply the variants of the kernels they call, which are
+    // instantiated in turn, until all the variants needed exist.
+    while (!newFuncs.empty()) {
+      ApplyOpAnalysis nested(module, newFuncs);
+      newFuncs = step1(nested.getAnalysisInfo());
+    }
     step2();
   }
 
+  /// The variants of one function. The variants are declared in the module
+  /// serially, since adding symbols to the module is not thread-safe, and
+  /// their bodies are then populated in parallel, one function per task.
+  struct VariantsOf {
+    func::FuncOp funcOp;
+    func::FuncOp ctrlFunc;
+    func::FuncOp adjFunc;
+    func::FuncOp adjCtrlFunc;
+    // The control variant of which adjCtrlFunc is the adjoint.
+    func::FuncOp adjCtrlBase;
+  };
+
   /// Step 1. Instantiate all the implied variants of functions from all
-  /// quake.apply operations that were found.
-  void step1(const ApplyOpAnalysisInfo &applyVariants) {
+  /// quake.apply operations that were found. A variant is instantiated once,
+  /// whatever the number of its applications and the number of their
+  /// controls, which are passed as a single vector. Returns the variants
+  /// instantiated.
+  SmallVector<Operation *> step1(const ApplyOpAnalysisInfo &applyVariants) {
     ModuleOp module = getOperation();
+    SmallVector<VariantsOf> work;
+    SmallVector<Operation *> newFuncs;
+    auto declare = [&](const std::string &funcName, FunctionType funcTy) {
+      // A variant that exists already is reused.
+      if (module.lookupSymbol<func::FuncOp>(funcName))
+        return func::FuncOp{};
+      auto newFunc = declareVariantOf(funcName, funcTy);
+      newFuncs.push_back(newFunc.getOperation());
+      return newFunc;
+    };
 
     // Loop over all the globals in the module.
     for (auto &global : *module.getBody()) {
@@ -340,29 +393,73 @@ public:
       auto funcOp = dyn_cast<func::FuncOp>(global);
       assert(funcOp && "global must be a FuncOp");
       auto &variant = variantIter->second;
-
-      if (variant.needsControlVariant)
-        createControlVariantOf(funcOp);
+      auto funcName = funcOp.getName().str();
+      auto funcTy = funcOp.getFunctionType();
+
+      // The adjoint control variant is the adjoint of the control variant, so
+      // create a control variant for it, even if it wasn't needed. The dead
+      // variant can be eliminated as unreferenced.
+      VariantsOf variants{funcOp, {}, {}, {}, {}};
+      auto ctrlFuncName = getCtrlVariantFunctionName(funcName);
+      if (variant.needsControlVariant || variant.needsAdjointControlVariant)
+        variants.ctrlFunc =
+            declare(ctrlFuncName, getControlVariantType(funcTy));
       if (variant.needsAdjointVariant)
-        createAdjointVariantOf(
-            funcOp, getAdjVariantFunctionName(funcOp.getName().str()));
-      if (variant.needsAdjointControlVariant)
-        createAdjointControlVariantOf(funcOp);
+        variants.adjFunc = declare(getAdjVariantFunctionName(funcName), funcTy);
+      if (variant.needsAdjointControlVariant) {
+        variants.adjCtrlFunc = declare(getAdjCtrlVariantFunctionName(funcName),
+                                       getControlVariantType(funcTy));
+        variants.adjCtrlBase =
+            variants.ctrlFunc ? variants.ctrlFunc
+                              : module.lookupSymbol<func::FuncOp>(ctrlFuncName);
+      }
+      if (variants.ctrlFunc || variants.adjFunc || variants.adjCtrlFunc)
+        work.push_back(variants);
+    }
+
+    if (failed(failableParallelForEach(
+            module.getContext(), work, [&](VariantsOf &variants) {
+              auto funcOp = variants.funcOp;
+              if (variants.ctrlFunc)
+                populateControlVariantOf(funcOp, variants.ctrlFunc);
+              if (variants.adjFunc &&
+                  failed(populateAdjointVariantOf(funcOp, variants.adjFunc)))
+                return failure();
+              if (variants.adjCtrlFunc)
+                return populateAdjointVariantOf(variants.adjCtrlBase,
+                                                variants.adjCtrlFunc);
+              return success();
+            }))) {
+      signalPassFailure();
+      return {};
     }
+    return newFuncs;
   }
 
-  func::FuncOp createControlVariantOf(func::FuncOp funcOp) {
-    ModuleOp module = getOperation();
-    auto *ctx = module.getContext();
-    auto funcName = getCtrlVariantFunctionName(funcOp.getName().str());
-    auto funcTy = funcOp.getFunctionType();
-    auto qvecTy = quake::QVecType::getUnsized(ctx);
-    auto loc = funcOp.getLoc();
-    SmallVector<Type> inTys = {qvecTy};
-    inTys.append(funcTy.getInputs().begin(), funcTy.getInputs().end());
+  /// Add the declaration of the variant \p funcName of type \p funcTy to the
+  /// module.
+  func::FuncOp declareVariantOf(const std::string &funcName,
+                                FunctionType funcTy) {
     auto newFunc = cudaq::opt::factory::createFunction(
-        funcName, funcTy.getResults(), inTys, module);
+        funcName, funcTy.getResults(), funcTy.getInputs(), getOperation());
     newFunc.setPrivate();
+    return newFunc;
+  }
+
+  /// The control variant takes the control qubits as an additional first
+  /// argument.
+  static FunctionType getControlVariantType(FunctionType funcTy) {
+    auto *ctx = funcTy.getContext();
+    SmallVector<Type> inTys = {quake::QVecType::getUnsized(ctx)};
+    inTys.append(funcTy.getInputs().begin(), funcTy.getInputs().end());
+    return FunctionType::get(ctx, inTys, funcTy.getResults());
+  }
+
+  static void populateControlVariantOf(func::FuncOp funcOp,
+                                       func::FuncOp newFunc) {
+    auto *ctx = funcOp.getContext();
+    auto qvecTy = quake::QVecType::getUnsized(ctx);
+    auto loc = funcOp.getLoc();
     IRMapping mapping;
     funcOp.getBody().cloneInto(&newFunc.getBody(), mapping);
     auto newCond = newFunc.getBody().front().insertArgument(0u, qvecTy, loc);
@@ -381,20 +478,47 @@ public:
             ctx, {arrAttr[0], arrAttr[1] + 1, arrAttr[2]});
         NamedAttrList attrs(op->getAttrs());
         attrs.set(segmentSizes, newArrAttr);
+        if (auto negated =
+                op->getAttrOfType<DenseBoolArrayAttr>(negatedControls)) {
+          SmallVector<bool> newNegated = {false};
+          newNegated.append(negated.asArrayRef().begin(),
+                            negated.asArrayRef().end());
+          attrs.set(negatedControls, DenseBoolArrayAttr::get(ctx, newNegated));
+        }
         OperationState res(op->getLoc(), op->getName().getStringRef(), operands,
                            op->getResultTypes(), attrs);
         builder.create(res); // Quake quantum gates have no results
         op->erase();
+      } else if (isQuantumCall(*op) &&
+                 !op->hasAttr(cudaq::opt::computeActionComputeAttrName)) {
+        // A kernel call is controlled by applying the control variant of the
+        // callee, with `newCond` added to its controls. The compute and
+        // uncompute parts of a compute_action cancel out when the controls do
+        // not hold, so they are left uncontrolled.
+        OpBuilder builder(op);
+        SmallVector<Value> controls = {newCond};
+        if (auto apply = dyn_cast<quake::ApplyOp>(op)) {
+          controls.append(apply.getControls().begin(),
+                          apply.getControls().end());
+          builder.create<quake::ApplyOp>(op->getLoc(), TypeRange{},
+                                         apply.getCallee(), apply.getIsAdj(),
+                                         controls, apply.getArgs());
+        } else {
+          auto call = cast<func::CallOp>(op);
+          builder.create<quake::ApplyOp>(op->getLoc(), TypeRange{},
+                                         call.getCalleeAttr(),
+                                         /*isAdjoint=*/false, controls,
+                                         call.getOperands());
+        }
+        op->erase();
       }
     });
-    return newFunc;
   }
 
   /// The adjoint variant of the function is the "reverse" computation. We want
   /// to reverse the flow graph so the gates appear "upside down".
-  func::FuncOp createAdjointVariantOf(func::FuncOp funcOp,
-                                      std::string &&funcName) {
-    ModuleOp module = getOperation();
+  static LogicalResult populateAdjointVariantOf(func::FuncOp funcOp,
+                                                func::FuncOp newFunc) {
     auto loc = funcOp.getLoc();
     auto &funcBody = funcOp.getBody();
 
@@ -402,13 +526,15 @@ public:
     if (regionHasUnstructuredControlFlow(funcBody)) {
       emitError(loc,
                 "cannot make adjoint of kernel with unstructured control flow");
-      signalPassFailure();
-      return {};
+      return failure();
     }
-    if (cudaq::opt::hasCallOp(funcOp)) {
+    if (cudaq::opt::internal::hasCharacteristic(
+            [](Operation &op) {
+              return isa<CallOpInterface>(op) && !isQuantumCall(op);
+            },
+            *funcOp.getOperation())) {
       emitError(loc, "cannot make adjoint of kernel with calls");
-      signalPassFailure();
-      return {};
+      return failure();
     }
     if (cudaq::opt::internal::hasCharacteristic(
             [](Operation &op) {
@@ -417,30 +543,24 @@ public:
             },
             *funcOp.getOperation())) {
       emitError(loc, "cannot make adjoint of kernel with callable expressions");
-      signalPassFailure();
-      return {};
+      return failure();
     }
     if (cudaq::opt::hasMeasureOp(funcOp)) {
       emitError(loc, "cannot make adjoint of kernel with a measurement");
-      signalPassFailure();
-      return {};
+      return failure();
     }
 
-    auto funcTy = funcOp.getFunctionType();
-    auto newFunc = cudaq::opt::factory::createFunction(
-        funcName, funcTy.getResults(), funcTy.getInputs(), module);
-    newFunc.setPrivate();
     IRMapping mapping;
     funcBody.cloneInto(&newFunc.getBody(), mapping);
     reverseTheOpsInTheBlock(loc, newFunc.getBody().front().getTerminator(),
                             getOpsToInvert(newFunc.getBody().front()));
-    return newFunc;
+    return success();
   }
 
   static SmallVector<Operation *> getOpsToInvert(Block &block) {
     SmallVector<Operation *> ops;
     for (auto &op : block)
-      if (cudaq::opt::hasQuantum(op))
+      if (hasQuantumEffect(op))
         ops.push_back(&op);
     return ops;
   }
@@ -719,6 +839,21 @@ public:
         continue;
       }
 
+      if (isQuantumCall(*op)) {
+        // A kernel call is inverted by applying the adjoint of the callee.
+        LLVM_DEBUG(llvm::dbgs() << "moving kernel call: " << *op << ".\n");
+        if (auto apply = dyn_cast<quake::ApplyOp>(op))
+          builder.create<quake::ApplyOp>(op->getLoc(), TypeRange{},
+                                         apply.getCallee(), !apply.getIsAdj(),
+                                         apply.getControls(), apply.getArgs());
+        else
+          builder.create<quake::ApplyOp>(
+              op->getLoc(), TypeRange{}, cast<func::CallOp>(op).getCalleeAttr(),
+              /*isAdjoint=*/true, ValueRange{}, op->getOperands());
+        op->erase();
+        continue;
+      }
+
       bool opWasNegated = false;
       IRMapping mapper;
       LLVM_DEBUG(llvm::dbgs() << "moving quantum op: " << *op << ".\n");
@@ -749,21 +884,6 @@ public:
     }
   }
 
-  /// This is the combination of adjoint and control transformations. We will
-  /// create a control variant here, even if it wasn't needed to simplify
-  /// things. The dead variant can be eliminated as unreferenced.
-  func::FuncOp createAdjointControlVariantOf(func::FuncOp funcOp) {
-    ModuleOp module = getOperation();
-    auto funcName = funcOp.getName().str();
-    auto ctrlFuncName = getCtrlVariantFunctionName(funcName);
-    auto ctrlFunc = module.lookupSymbol<func::FuncOp>(ctrlFuncName);
-    if (!ctrlFunc)
-      ctrlFunc = createControlVariantOf(funcOp);
-
-    auto newFuncName = getAdjCtrlVariantFunctionName(funcName);
-    return createAdjointVariantOf(ctrlFunc, std::move(newFuncName));
-  }
-
   /// Step 2. Specialize all the quake.apply ops and convert them to calls.
   void step2() {
     ModuleOp module = getOperation();
@@ -782,6 +902,7 @@ public:
 
   // MLIR dependency: internal name used by tablegen.
   static constexpr char segmentSizes[] = "operand_segment_sizes";
+  static constexpr char negatedControls[] = "negated_qubit_controls";
 };
 } // namespace
 
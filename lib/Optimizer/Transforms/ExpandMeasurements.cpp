@@ -24,6 +24,14 @@ bool usesIndividualQubit(A x) {
   return x.getType() == IntegerType::get(x.getContext(), 1);
 }
 
+// An mz of a single whole register, without a register name, can be measured
+// jointly by the target.
+bool measuresWholeRegister(quake::MzOp x) {
+  return x.getTargets().size() == 1 &&
+         x.getTargets().front().getType().isa<quake::QVecType>() &&
+         !x->hasAttr("registerName");
+}
+
 // Generalized pattern for expanding a multiple qubit measurement (whether it is
 // mx, my, or mz) to a series of individual measurements.
 template <typename A>
@@ -124,8 +132,10 @@ public:
         [](quake::MxOp x) { return usesIndividualQubit(x); });
     target.addDynamicallyLegalOp<quake::MyOp>(
         [](quake::MyOp x) { return usesIndividualQubit(x); });
-    target.addDynamicallyLegalOp<quake::MzOp>(
-        [](quake::MzOp x) { return usesIndividualQubit(x); });
+    target.addDynamicallyLegalOp<quake::MzOp>([&](quake::MzOp x) {
+      return usesIndividualQubit(x) ||
+             (jointRegisters && measuresWholeRegister(x));
+    });
     if (failed(applyPartialConversion(op, target, std::move(patterns)))) {
       emitError(op->getLoc(), "error expanding measurements\n");
       signalPassFailure();
@@ -0,0 +1,105 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+///
+/// This file declares `getTargetMatrix`, the 2x2 matrix a single-target gate
+/// with constant parameters applies to its target, for the passes that
+/// evaluate gates known at compile time.
+
+#pragma once
+
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "mlir/IR/Matchers.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include <array>
+#include <cmath>
+#include <complex>
+
+namespace cudaq::opt {
+
+/// A 2x2 matrix, row-major.
+using TargetMatrix = std::array<std::complex<double>, 4>;
+
+inline TargetMatrix getU3Matrix(double theta, double phi, double lambda) {
+  using namespace std::complex_literals;
+  return {std::cos(theta / 2.), -std::exp(1i * lambda) * std::sin(theta / 2.),
+          std::exp(1i * phi) * std::sin(theta / 2.),
+          std::exp(1i * (phi + lambda)) * std::cos(theta / 2.)};
+}
+
+/// Return the value of a constant gate parameter, or nullopt.
+inline std::optional<double> getConstantParameter(mlir::Value value) {
+  llvm::APFloat param(0.0);
+  if (!mlir::matchPattern(value, mlir::m_ConstantFloat(&param)))
+    return std::nullopt;
+  bool losesInfo;
+  param.convert(llvm::APFloat::IEEEdouble(),
+                llvm::APFloat::rmNearestTiesToEven, &losesInfo);
+  return param.convertToDouble();
+}
+
+/// Return the matrix the gate applies to its target when its controls are
+/// active, or nullopt if it has more than one target or a parameter that is
+/// not a constant.
+inline std::optional<TargetMatrix>
+getTargetMatrix(quake::OperatorInterface optor) {
+  using namespace std::complex_literals;
+  if (optor.getTargets().size() != 1)
+    return std::nullopt;
+  llvm::SmallVector<double, 3> params;
+  for (auto param : optor.getParameters()) {
+    auto value = getConstantParameter(param);
+    if (!value)
+      return std::nullopt;
+    params.push_back(*value);
+  }
+  const double s = 1. / std::sqrt(2.);
+  auto matrix =
+      llvm::TypeSwitch<mlir::Operation *, std::optional<TargetMatrix>>(
+          optor.getOperation())
+          .Case([&](quake::HOp) { return TargetMatrix{s, s, s, -s}; })
+          .Case([](quake::XOp) { return TargetMatrix{0, 1, 1, 0}; })
+          .Case([](quake::YOp) { return TargetMatrix{0, -1i, 1i, 0}; })
+          .Case([](quake::ZOp) { return TargetMatrix{1, 0, 0, -1}; })
+          .Case([](quake::SOp) { return TargetMatrix{1, 0, 0, 1i}; })
+          .Case([](quake::TOp) {
+            return TargetMatrix{1, 0, 0, std::exp(1i * M_PI / 4.)};
+          })
+          .Case([&](quake::RxOp) {
+            double c = std::cos(params[0] / 2.), n = std::sin(params[0] / 2.);
+            return TargetMatrix{c, -1i * n, -1i * n, c};
+          })
+          .Case([&](quake::RyOp) {
+            double c = std::cos(params[0] / 2.), n = std::sin(params[0] / 2.);
+            return TargetMatrix{c, -n, n, c};
+          })
+          .Case([&](quake::RzOp) {
+            return TargetMatrix{std::exp(-0.5i * params[0]), 0, 0,
+                                std::exp(0.5i * params[0])};
+          })
+          .Case([&](quake::R1Op) {
+            return TargetMatrix{1, 0, 0, std::exp(1i * params[0])};
+          })
+          .Case([&](quake::PhasedRxOp) {
+            double c = std::cos(params[0] / 2.), n = std::sin(params[0] / 2.);
+            return TargetMatrix{c, -1i * std::exp(-1i * params[1]) * n,
+                                -1i * std::exp(1i * params[1]) * n, c};
+          })
+          .Case([&](quake::U2Op) {
+            return getU3Matrix(M_PI / 2., params[0], params[1]);
+          })
+          .Case([&](quake::U3Op) {
+            return getU3Matrix(params[0], params[1], params[2]);
+          })
+          .Default([](mlir::Operation *) { return std::nullopt; });
+  if (matrix && optor.isAdj())
+    matrix = TargetMatrix{std::conj((*matrix)[0]), std::conj((*matrix)[2]),
+                          std::conj((*matrix)[1]), std::conj((*matrix)[3])};
+  return matrix;
+}
+
+} // namespace cudaq::opt
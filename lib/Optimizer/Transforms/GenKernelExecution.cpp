@@ -38,6 +38,10 @@ static constexpr const char cudaqRegisterKernelName[] =
 
 static constexpr std::size_t NoResultOffset = ~0u >> 1;
 
+/// The size of the pointer slot in front of the data of every vector argument
+/// in the trailing bytes of the argument struct.
+static constexpr std::int32_t vectorSlotBytes = 8;
+
 class GenerateKernelExecution
     : public cudaq::opt::GenerateKernelExecutionBase<GenerateKernelExecution> {
 public:
@@ -56,8 +60,10 @@ public:
   /// ```llvm
   /// { i16, i64, double, i32 }
   /// ```
-  /// where the values of the vector argument are pass-by-value and appended to
-  /// the end of the struct as a sequence of \i n double values.
+  /// where the values of the vector argument are appended to the end of the
+  /// struct, after a pointer slot. When the slot is null, the slot is followed
+  /// by the \i n double values (pass-by-value). Otherwise the slot points to
+  /// the data of the caller's vector, which is not copied (pass-by-reference).
   LLVM::LLVMStructType buildStructType(const std::string &name,
                                        FunctionType funcTy) {
     auto *ctx = funcTy.getContext();
@@ -195,14 +201,9 @@ public:
     return builder.create<LLVM::SubOp>(loc, endInt, beginInt);
   }
 
-  Value copyVectorData(OpBuilder &builder, Location loc, Value stVal, Value arg,
-                       Value vecToBuffer, DenseI64ArrayAttr off) {
-    auto ctx = builder.getContext();
-    auto falseAttr = IntegerAttr::get(IntegerType::get(ctx, 1), 0);
-    auto notVolatile = builder.create<LLVM::ConstantOp>(
-        loc, IntegerType::get(ctx, 1), falseAttr);
-    // memcpy from arg->begin to vecToBuffer, size bytes.
-    auto bytes = builder.create<LLVM::ExtractValueOp>(loc, stVal, off);
+  /// Load the pointer to the beginning of the data of the `std::vector<T>`
+  /// at \p arg, as an `i8*`.
+  Value getVectorData(OpBuilder &builder, Location loc, Value arg) {
     auto inStructTy = arg.getType()
                           .cast<LLVM::LLVMPointerType>()
                           .getElementType()
@@ -211,8 +212,35 @@ public:
         loc, cudaq::opt::factory::getPointerType(inStructTy.getBody()[0]), arg,
         SmallVector<LLVM::GEPArg>{0, 0});
     auto fromBuff = builder.create<LLVM::LoadOp>(loc, beginPtr);
-    auto vecFromBuff = builder.create<LLVM::BitcastOp>(
-        loc, cudaq::opt::factory::getPointerType(ctx), fromBuff);
+    return builder.create<LLVM::BitcastOp>(
+        loc, cudaq::opt::factory::getPointerType(builder.getI8Type()),
+        fromBuff);
+  }
+
+  /// Store \p pointer into the pointer slot at \p vecToBuffer, which precedes
+  /// the data of every vector argument in the trailing bytes, and return the
+  /// position after the slot.
+  Value storeVectorSlot(OpBuilder &builder, Location loc, Value pointer,
+                        Value vecToBuffer) {
+    auto i8PtrTy = cudaq::opt::factory::getPointerType(builder.getI8Type());
+    auto slot = builder.create<LLVM::BitcastOp>(
+        loc, cudaq::opt::factory::getPointerType(i8PtrTy), vecToBuffer);
+    builder.create<LLVM::StoreOp>(loc, pointer, slot);
+    return builder.create<LLVM::GEPOp>(
+        loc, vecToBuffer.getType(), vecToBuffer,
+        SmallVector<LLVM::GEPArg>{vectorSlotBytes});
+  }
+
+  /// Copy \p bytes bytes of the data of the `std::vector<T>` at \p arg to
+  /// \p vecToBuffer, and return the position after the copied bytes.
+  Value copyVectorData(OpBuilder &builder, Location loc, Value bytes, Value arg,
+                       Value vecToBuffer) {
+    auto ctx = builder.getContext();
+    auto falseAttr = IntegerAttr::get(IntegerType::get(ctx, 1), 0);
+    auto notVolatile = builder.create<LLVM::ConstantOp>(
+        loc, IntegerType::get(ctx, 1), falseAttr);
+    // memcpy from arg->begin to vecToBuffer, size bytes.
+    auto vecFromBuff = getVectorData(builder, loc, arg);
     builder.create<func::CallOp>(
         loc, std::nullopt, llvmMemCopyIntrinsic,
         SmallVector<Value>{vecToBuffer, vecFromBuff, bytes, notVolatile});
@@ -262,6 +290,8 @@ public:
     // Initialize the counter for extra size.
     Value zero = builder.create<LLVM::ConstantOp>(loc, i64Ty, zeroAttr);
     Value extraBytes = zero;
+    Value slotBytes = builder.create<LLVM::ConstantOp>(
+        loc, i64Ty, builder.getI64IntegerAttr(vectorSlotBytes));
 
     // Loop over the struct elements
     for (auto structElementTypeIter : llvm::enumerate(structType.getBody())) {
@@ -311,10 +341,11 @@ public:
       if (isVecType) {
         // Store the index and the vec value
         vectorArgIndices.push_back(std::make_pair(idx, loadedVal));
-        // compute the extra size needed for the vector data
+        // compute the extra size needed for the slot and the vector data
         loadedVal = getVectorSize(
             builder, loc, type.cast<LLVM::LLVMPointerType>(), loadedVal);
         extraBytes = builder.create<LLVM::AddOp>(loc, extraBytes, loadedVal);
+        extraBytes = builder.create<LLVM::AddOp>(loc, extraBytes, slotBytes);
       }
 
       stVal = builder.create<LLVM::InsertValueOp>(loc, stVal, loadedVal, off);
@@ -355,10 +386,14 @@ public:
     Value vecToBuffer = builder.create<LLVM::GEPOp>(
         loc, i8PtrTy, buff, SmallVector<Value>{structSize});
 
+    // The buffers of the argsCreator may be sent to another process, the data
+    // is always copied behind a null slot.
+    Value nullPtr = builder.create<LLVM::NullOp>(loc, i8PtrTy);
     for (auto [idx, vecVal] : vectorArgIndices) {
       auto off = DenseI64ArrayAttr::get(ctx, ArrayRef<std::int64_t>{idx});
-      vecToBuffer =
-          copyVectorData(builder, loc, stVal, vecVal, vecToBuffer, off);
+      auto bytes = builder.create<LLVM::ExtractValueOp>(loc, stVal, off);
+      vecToBuffer = storeVectorSlot(builder, loc, nullPtr, vecToBuffer);
+      vecToBuffer = copyVectorData(builder, loc, bytes, vecVal, vecToBuffer);
     }
 
     builder.create<LLVM::StoreOp>(loc, buff, entry->getArgument(1));
@@ -428,13 +463,28 @@ public:
         auto eleSizeVal =
             builder.create<LLVM::ConstantOp>(loc, i64Ty, eleSizeAttr);
         auto vecLength = builder.create<LLVM::SDivOp>(loc, vecSize, eleSizeVal);
-        // The data is at trailingData and is valid for vecLength of eleTy.
+        // The slot at trailingData points to the data of the caller's vector,
+        // or it is null and followed by a copy of the data.
+        auto slot = builder.create<LLVM::BitcastOp>(
+            loc, cudaq::opt::factory::getPointerType(i8PtrTy), trailingData);
+        Value reference = builder.create<LLVM::LoadOp>(loc, slot);
+        Value copied = builder.create<LLVM::GEPOp>(
+            loc, i8PtrTy, trailingData,
+            SmallVector<LLVM::GEPArg>{vectorSlotBytes});
+        Value nullPtr = builder.create<LLVM::NullOp>(loc, i8PtrTy);
+        Value isCopy = builder.create<LLVM::ICmpOp>(
+            loc, LLVM::ICmpPredicate::eq, reference, nullPtr);
+        Value data =
+            builder.create<LLVM::SelectOp>(loc, isCopy, copied, reference);
+        // The data is valid for vecLength of eleTy.
         auto castData = builder.create<LLVM::BitcastOp>(
-            loc, cudaq::opt::factory::getPointerType(eleTy), trailingData);
+            loc, cudaq::opt::factory::getPointerType(eleTy), data);
         args.push_back(builder.create<cudaq::cc::StdvecInitOp>(
             loc, stdvecTy, castData, vecLength));
+        Value copiedBytes =
+            builder.create<LLVM::SelectOp>(loc, isCopy, vecSize, zero);
         trailingData =
-            builder.create<LLVM::GEPOp>(loc, i8PtrTy, trailingData, vecSize);
+            builder.create<LLVM::GEPOp>(loc, i8PtrTy, copied, copiedBytes);
       } else {
         args.push_back(
             builder.create<LLVM::ExtractValueOp>(loc, inTy, val, off));
@@ -545,9 +595,28 @@ public:
     auto zero = builder.create<LLVM::ConstantOp>(loc, i64Ty, zeroAttr);
     Value extraBytes = zero;
     bool hasTrailingData = false;
-    for (auto inp :
-         llvm::enumerate(rewriteEntryBlock->getArguments().drop_front(
-             hasHiddenSRet(funcTy) ? 2 : 1))) {
+    auto explicitArgs =
+        rewriteEntryBlock->getArguments().drop_front(hasHiddenSRet(funcTy) ? 2
+                                                                          : 1);
+
+    // The data of vector arguments is passed by reference, without a copy,
+    // when the runtime launches the kernel in this process and reads the
+    // arguments before the launch returns. The vectors outlive the launch.
+    Value byReference;
+    Value slotBytes;
+    if (llvm::any_of(explicitArgs, [](Value arg) {
+          return isa<LLVM::LLVMPointerType>(arg.getType());
+        })) {
+      byReference =
+          builder
+              .create<func::CallOp>(loc, builder.getI1Type(),
+                                    cudaq::runtime::argsByReferenceFuncName,
+                                    ValueRange{})
+              .getResult(0);
+      slotBytes = builder.create<LLVM::ConstantOp>(
+          loc, i64Ty, builder.getI64IntegerAttr(vectorSlotBytes));
+    }
+    for (auto inp : llvm::enumerate(explicitArgs)) {
       Value arg = inp.value();
       Type inTy = arg.getType();
       std::int64_t idx = inp.index();
@@ -561,7 +630,10 @@ public:
         // first two pointers. Use the unscaled size for now.
         auto sizeBytes = getVectorSize(builder, loc, ptrTy, arg);
         stVal = builder.create<LLVM::InsertValueOp>(loc, stVal, sizeBytes, off);
-        extraBytes = builder.create<LLVM::AddOp>(loc, extraBytes, sizeBytes);
+        Value copiedBytes =
+            builder.create<LLVM::SelectOp>(loc, byReference, zero, sizeBytes);
+        extraBytes = builder.create<LLVM::AddOp>(loc, extraBytes, copiedBytes);
+        extraBytes = builder.create<LLVM::AddOp>(loc, extraBytes, slotBytes);
         hasTrailingData = true;
       } else {
         stVal = builder.create<LLVM::InsertValueOp>(loc, stVal, arg, off);
@@ -588,20 +660,27 @@ public:
     // Store the arguments to the argument section.
     builder.create<LLVM::StoreOp>(loc, stVal, temp);
 
-    // Append the vector data to the end of the struct.
+    // Append the vector slots, and the vector data if it is copied, to the
+    // end of the struct.
     if (hasTrailingData) {
       Value vecToBuffer = builder.create<LLVM::GEPOp>(
           loc, i8PtrTy, buff, SmallVector<Value>{structSize});
-      for (auto inp :
-           llvm::enumerate(rewriteEntryBlock->getArguments().drop_front(1))) {
+      Value nullPtr = builder.create<LLVM::NullOp>(loc, i8PtrTy);
+      for (auto inp : llvm::enumerate(explicitArgs)) {
         Value arg = inp.value();
         Type inTy = arg.getType();
         std::int64_t idx = inp.index();
         auto off = DenseI64ArrayAttr::get(ctx, ArrayRef<std::int64_t>{idx});
-        if (auto ptrTy = dyn_cast<LLVM::LLVMPointerType>(inTy)) {
-          // memcpy from arg->begin to vecToBuffer, size bytes.
+        if (isa<LLVM::LLVMPointerType>(inTy)) {
+          Value bytes = builder.create<LLVM::ExtractValueOp>(loc, stVal, off);
+          Value reference = builder.create<LLVM::SelectOp>(
+              loc, byReference, getVectorData(builder, loc, arg), nullPtr);
+          vecToBuffer = storeVectorSlot(builder, loc, reference, vecToBuffer);
+          // A zero byte memcpy when the data is passed by reference.
+          Value copiedBytes =
+              builder.create<LLVM::SelectOp>(loc, byReference, zero, bytes);
           vecToBuffer =
-              copyVectorData(builder, loc, stVal, arg, vecToBuffer, off);
+              copyVectorData(builder, loc, copiedBytes, arg, vecToBuffer);
         }
       }
     }
@@ -717,6 +796,12 @@ public:
             {cudaq::opt::factory::getPointerType(ctx),
              cudaq::opt::factory::getPointerType(ctx)}));
 
+    if (failed(irBuilder.loadIntrinsic(
+            module, cudaq::runtime::argsByReferenceFuncName))) {
+      module.emitError(std::string("could not load ") +
+                       cudaq::runtime::argsByReferenceFuncName);
+      return;
+    }
     if (failed(irBuilder.loadIntrinsic(module, "malloc"))) {
       module.emitError("could not load malloc");
       return;
@@ -118,17 +118,21 @@ struct ComputeActionOpPattern
                                 PatternRewriter &rewriter) const override {
     auto *ctx = rewriter.getContext();
     auto loc = comAct.getLoc();
-    rewriter.create<quake::ApplyOp>(loc, TypeRange{},
-                                    getCallee(ctx, comAct.getCompute()),
-                                    /*isAdjoint=*/comAct.getIsDagger(),
-                                    ValueRange{}, getArgs(comAct.getCompute()));
+    auto compute = rewriter.create<quake::ApplyOp>(
+        loc, TypeRange{}, getCallee(ctx, comAct.getCompute()),
+        /*isAdjoint=*/comAct.getIsDagger(), ValueRange{},
+        getArgs(comAct.getCompute()));
     rewriter.create<quake::ApplyOp>(
         loc, TypeRange{}, getCallee(ctx, comAct.getAction()),
         /*isAdjoint=*/false, ValueRange{}, getArgs(comAct.getAction()));
-    rewriter.replaceOpWithNewOp<quake::ApplyOp>(
+    auto uncompute = rewriter.replaceOpWithNewOp<quake::ApplyOp>(
         comAct, TypeRange{}, getCallee(ctx, comAct.getCompute()),
         /*isAdjoint=*/!comAct.getIsDagger(), ValueRange{},
         getArgs(comAct.getCompute()));
+    // Only the action is controlled when the kernel is.
+    auto unit = rewriter.getUnitAttr();
+    compute->setAttr(cudaq::opt::computeActionComputeAttrName, unit);
+    uncompute->setAttr(cudaq::opt::computeActionComputeAttrName, unit);
     return success();
   }
 
@@ -19,15 +19,17 @@ using namespace mlir;
 
 namespace {
 
+static bool isCliffordT(Operation *op) {
+  if (auto tOp = dyn_cast<qtx::TOp>(op))
+    return tOp.getControls().size() == 0;
+  if (auto optor = dyn_cast<qtx::OperatorInterface>(op))
+    return optor.isClifford();
+  return true; // In decomposition, non-quantum operators are all legal.
+}
+
 struct CliffordT : public ConversionTarget {
   CliffordT(MLIRContext &context) : ConversionTarget(context) {
-    addDynamicallyLegalDialect<qtx::QTXDialect>([](Operation *op) {
-      if (auto tOp = dyn_cast<qtx::TOp>(op))
-        return tOp.getControls().size() == 0;
-      if (auto optor = dyn_cast<qtx::OperatorInterface>(op))
-        return optor.isClifford();
-      return true; // In decomposition, non-quantum operators are all legal.
-    });
+    addDynamicallyLegalDialect<qtx::QTXDialect>(isCliffordT);
   }
 };
 
@@ -138,6 +140,245 @@ struct XOpDecomposition : public OpRewritePattern<qtx::XOp> {
   }
 };
 
+//===----------------------------------------------------------------------===//
+// Multi-controlled decompositions
+//===----------------------------------------------------------------------===//
+
+/// The wires of a decomposition, by index, with their current values. Each
+/// gate added updates the value of its target.
+class Wires {
+public:
+  Wires(PatternRewriter &rewriter, Location loc)
+      : rewriter(rewriter), loc(loc) {}
+
+  unsigned add(Value wire) {
+    original.push_back(wire);
+    current.push_back(wire);
+    return current.size() - 1;
+  }
+  Value operator[](unsigned i) const { return current[i]; }
+  Value getOriginal(unsigned i) const { return original[i]; }
+  unsigned size() const { return current.size(); }
+
+  void h(unsigned w) {
+    current[w] = createOp<qtx::HOp>(rewriter, loc, current[w]);
+  }
+  void t(unsigned w, bool isAdj = false) {
+    current[w] = createOp<qtx::TOp>(rewriter, loc, isAdj, current[w]);
+  }
+  void x(ArrayRef<unsigned> controls, unsigned w) {
+    SmallVector<Value> values;
+    for (auto c : controls)
+      values.push_back(current[c]);
+    current[w] = createOp<qtx::XOp>(rewriter, loc, values, current[w]);
+  }
+
+  /// Toffoli gate up to a relative phase on the basis states, with 3 CNOTs
+  /// instead of 6. It is its own inverse, so it can compute a conjunction
+  /// that is uncomputed the same way.
+  void relativePhaseToffoli(unsigned c0, unsigned c1, unsigned w) {
+    h(w);
+    t(w);
+    x(c1, w);
+    t(w, /*isAdj=*/true);
+    x(c0, w);
+    t(w);
+    x(c1, w);
+    t(w, /*isAdj=*/true);
+    h(w);
+  }
+
+  /// X on `target` controlled by the n wires `c`, with n - 2 clean ancillas
+  /// `a` that compute the conjunction of the controls in a chain of
+  /// relative-phase Toffolis: 2n - 3 Toffolis, of which 2n - 4 have 3 CNOTs.
+  void cleanChain(ArrayRef<unsigned> c, ArrayRef<unsigned> a,
+                  unsigned target) {
+    auto n = c.size();
+    auto compute = [&](std::size_t i) {
+      if (i == 0)
+        relativePhaseToffoli(c[0], c[1], a[0]);
+      else
+        relativePhaseToffoli(c[i + 1], a[i - 1], a[i]);
+    };
+    for (std::size_t i = 0; i < n - 2; i++)
+      compute(i);
+    x({c[n - 1], a[n - 3]}, target);
+    for (std::size_t i = n - 2; i-- > 0;)
+      compute(i);
+  }
+
+  /// X on `target` controlled by the n wires `c`, with n - 2 dirty ancillas
+  /// `a`, in any state, which are restored: 4(n - 2) Toffolis (Barenco et
+  /// al., lemma 7.2).
+  void dirtyChain(ArrayRef<unsigned> c, ArrayRef<unsigned> a,
+                  unsigned target) {
+    auto n = c.size();
+    if (n <= 2) {
+      x(c, target);
+      return;
+    }
+    for (int repeat = 0; repeat < 2; repeat++) {
+      x({c[n - 1], a[n - 3]}, target);
+      for (std::size_t i = n - 2; i > 1; i--)
+        x({c[i], a[i - 2]}, a[i - 1]);
+      x({c[0], c[1]}, a[0]);
+      for (std::size_t i = 2; i < n - 1; i++)
+        x({c[i], a[i - 2]}, a[i - 1]);
+    }
+  }
+
+  /// X on `target` controlled by the wires `c`, with one dirty ancilla `a`:
+  /// the controls are split in two halves, each of which serves as dirty
+  /// ancillas for the gate on the other (Barenco et al., lemma 7.3).
+  void split(ArrayRef<unsigned> c, unsigned a, unsigned target) {
+    auto m = (c.size() + 1) / 2;
+    SmallVector<unsigned> first(c.begin(), c.begin() + m);
+    SmallVector<unsigned> second(c.begin() + m, c.end());
+    SmallVector<unsigned> firstSpare(second);
+    firstSpare.push_back(target);
+    second.push_back(a);
+    for (int repeat = 0; repeat < 2; repeat++) {
+      dirtyChain(first, firstSpare, a);
+      dirtyChain(second, first, target);
+    }
+  }
+
+private:
+  PatternRewriter &rewriter;
+  Location loc;
+  SmallVector<Value> original;
+  SmallVector<Value> current;
+};
+
+/// Returns the wires that hold a qubit across `op` without being acted on
+/// before it: the qubits `op` can borrow as dirty ancillas.
+static SmallVector<Value> getIdleWires(Operation *op) {
+  auto *block = op->getBlock();
+  auto isIdle = [&](Value wire) {
+    if (!wire.getType().isa<qtx::WireType>())
+      return false;
+    for (auto &use : wire.getUses()) {
+      auto *user = block->findAncestorOpInBlock(*use.getOwner());
+      if (!user || user == op)
+        return false;
+      if (!user->isBeforeInBlock(op))
+        continue;
+      // Before `op`, the wire may only be a control.
+      auto optor = dyn_cast<qtx::OperatorInterface>(user);
+      if (!optor || llvm::is_contained(optor.getTargets(), wire))
+        return false;
+    }
+    return true;
+  };
+  SmallVector<Value> wires;
+  for (auto arg : block->getArguments())
+    if (isIdle(arg))
+      wires.push_back(arg);
+  for (auto &prev : llvm::make_range(block->begin(), op->getIterator())) {
+    // The operations already decomposed are only erased at the end of the
+    // conversion.
+    if (!isCliffordT(&prev))
+      continue;
+    for (auto result : prev.getResults())
+      if (isIdle(result))
+        wires.push_back(result);
+  }
+  return wires;
+}
+
+/// Decomposes `op`, a multi-controlled X gate, or Z gate if `isZ`, into gates
+/// with at most two controls, on a number of gates linear in the number of
+/// controls. The construction depends on the qubits available: up to
+/// `maxAncillas` clean ancillas may be allocated, and the idle wires of the
+/// circuit may be borrowed as dirty ancillas.
+static LogicalResult decomposeMultiControlled(PatternRewriter &rewriter,
+                                              qtx::OperatorInterface op,
+                                              bool isZ,
+                                              std::size_t maxAncillas) {
+  auto n = op.getControls().size();
+  if (n < 3 || op->hasAttr("negated_qubit_controls"))
+    return failure();
+
+  Location loc = op->getLoc();
+  auto idle = getIdleWires(op.getOperation());
+  Wires wires(rewriter, loc);
+  SmallVector<unsigned> c;
+  for (auto control : op.getControls())
+    c.push_back(wires.add(control));
+  auto t = wires.add(op.getTarget());
+  SmallVector<unsigned> allocated;
+  auto allocate = [&]() {
+    allocated.push_back(wires.add(rewriter.create<qtx::AllocaOp>(loc)));
+    return allocated.back();
+  };
+
+  if (isZ)
+    wires.h(t);
+  if (maxAncillas >= n - 2) {
+    SmallVector<unsigned> a;
+    while (a.size() < n - 2)
+      a.push_back(allocate());
+    wires.cleanChain(c, a, t);
+  } else if (idle.size() >= n - 2) {
+    SmallVector<unsigned> a;
+    for (auto wire : ArrayRef<Value>(idle).take_front(n - 2))
+      a.push_back(wires.add(wire));
+    wires.dirtyChain(c, a, t);
+  } else if (!idle.empty()) {
+    wires.split(c, wires.add(idle.front()), t);
+  } else if (maxAncillas > 0) {
+    wires.split(c, allocate(), t);
+  } else {
+    return failure();
+  }
+  if (isZ)
+    wires.h(t);
+
+  if (!allocated.empty()) {
+    SmallVector<Value> ancillas;
+    for (auto a : allocated)
+      ancillas.push_back(wires[a]);
+    rewriter.create<qtx::DeallocOp>(loc, ancillas);
+  }
+  op->getResult(0).replaceAllUsesWith(wires[t]);
+  for (unsigned i = 0; i < wires.size(); i++) {
+    if (i == t || llvm::is_contained(allocated, i) ||
+        wires[i] == wires.getOriginal(i))
+      continue;
+    wires.getOriginal(i).replaceUsesWithIf(wires[i], [&](OpOperand &use) {
+      return !use.getOwner()->isBeforeInBlock(op.getOperation());
+    });
+  }
+  rewriter.eraseOp(op.getOperation());
+  return success();
+}
+
+struct MultiControlledXOpDecomposition : public OpRewritePattern<qtx::XOp> {
+  MultiControlledXOpDecomposition(MLIRContext *context,
+                                  std::size_t maxAncillas)
+      : OpRewritePattern(context), maxAncillas(maxAncillas) {}
+
+  LogicalResult matchAndRewrite(qtx::XOp op,
+                                PatternRewriter &rewriter) const override {
+    return decomposeMultiControlled(rewriter, op, /*isZ=*/false, maxAncillas);
+  }
+
+  std::size_t maxAncillas;
+};
+
+struct MultiControlledZOpDecomposition : public OpRewritePattern<qtx::ZOp> {
+  MultiControlledZOpDecomposition(MLIRContext *context,
+                                  std::size_t maxAncillas)
+      : OpRewritePattern(context), maxAncillas(maxAncillas) {}
+
+  LogicalResult matchAndRewrite(qtx::ZOp op,
+                                PatternRewriter &rewriter) const override {
+    return decomposeMultiControlled(rewriter, op, /*isZ=*/true, maxAncillas);
+  }
+
+  std::size_t maxAncillas;
+};
+
 } // namespace
 
 struct OpDecomposition
@@ -147,6 +388,8 @@ struct OpDecomposition
     MLIRContext *context = circuit.getContext();
     RewritePatternSet patterns(context);
     patterns.insert<XOpDecomposition, ZOpDecomposition>(context);
+    patterns.insert<MultiControlledXOpDecomposition,
+                    MultiControlledZOpDecomposition>(context, maxAncillas);
     CliffordT target(*context);
     if (failed(applyPartialConversion(circuit, target, std::move(patterns))))
       return signalPassFailure();
@@ -17,6 +17,8 @@
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/Dialect/MemRef/IR/MemRef.h"
 #include "mlir/IR/Dominance.h"
+#include "mlir/Interfaces/CallInterfaces.h"
+#include "mlir/Interfaces/LoopLikeInterface.h"
 #include "mlir/Transforms/DialectConversion.h"
 #include "mlir/Transforms/Passes.h"
 
@@ -27,6 +29,9 @@ namespace {
 /// @brief Define a type to contain the Quake Function Metadata
 struct QuakeMetadata {
   bool hasConditionalsOnMeasure = false;
+  /// @brief The number of qubits of a kernel whose allocations are all
+  /// static, none otherwise.
+  std::optional<std::size_t> requiredQubits;
 };
 
 /// @brief We'll define a type mapping a Quake Function to its metadata
@@ -136,9 +141,40 @@ private:
       });
     }
 
+    data.requiredQubits = getRequiredQubits(funcOp);
     infoMap.insert({operation, data});
   }
 
+  /// @brief Return the number of qubits allocated by \p funcOp if its
+  /// allocations are all static: of sizes known at compile time, executed
+  /// once (in a single block, outside loops), and not in callees.
+  static std::optional<std::size_t> getRequiredQubits(func::FuncOp funcOp) {
+    if (!funcOp.getBody().hasOneBlock())
+      return std::nullopt;
+    std::size_t nQubits = 0;
+    auto result = funcOp->walk([&](Operation *op) {
+      if (isa<CallOpInterface>(op) ||
+          (op != funcOp.getOperation() && !op->getRegions().empty() &&
+           isa<LoopLikeOpInterface>(op)))
+        return WalkResult::interrupt();
+      auto alloca = dyn_cast<quake::AllocaOp>(op);
+      if (!alloca)
+        return WalkResult::advance();
+      if (alloca.getType().isa<quake::QRefType>()) {
+        ++nQubits;
+        return WalkResult::advance();
+      }
+      auto vecTy = alloca.getType().cast<quake::QVecType>();
+      if (!vecTy.hasSpecifiedSize())
+        return WalkResult::interrupt();
+      nQubits += vecTy.getSize();
+      return WalkResult::advance();
+    });
+    if (result.wasInterrupted())
+      return std::nullopt;
+    return nQubits;
+  }
+
   /// @brief The Quake Function metadata map
   QuakeFunctionInfo infoMap;
 };
@@ -169,6 +205,12 @@ public:
       funcOp->setAttr("qubitMeasurementFeedback", builder.getBoolAttr(true));
     }
 
+    // Does this function allocate a static number of qubits? If so, it can be
+    // lowered to the QIR base profile and run on preallocated qubits.
+    if (info.requiredQubits)
+      funcOp->setAttr("requiredQubits",
+                      OpBuilder(funcOp).getI64IntegerAttr(*info.requiredQubits));
+
     // ... others in the future ...
   }
 };
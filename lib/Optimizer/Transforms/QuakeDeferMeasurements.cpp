@@ -0,0 +1,268 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "PassDetails.h"
+#include "QubitResolver.h"
+#include "cudaq/Optimizer/Dialect/CC/CCOps.h"
+#include "cudaq/Optimizer/Dialect/Characteristics.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include "mlir/Dialect/ControlFlow/IR/ControlFlowOps.h"
+#include "mlir/Dialect/MemRef/IR/MemRef.h"
+#include "mlir/IR/Dominance.h"
+#include "mlir/Interfaces/LoopLikeInterface.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+
+using namespace mlir;
+using cudaq::opt::QubitResolver;
+
+namespace {
+
+static constexpr char segmentSizes[] = "operand_segment_sizes";
+static constexpr char negatedControls[] = "negated_qubit_controls";
+
+/// A measurement whose bit only conditions gates, and the conditionals on
+/// it. `loads` are the loads of the bit through which conditionals use it,
+/// if the bit is stored to memory.
+struct Deferral {
+  quake::MzOp measure;
+  SmallVector<cudaq::cc::IfOp> conditionals;
+  SmallVector<memref::LoadOp> loads;
+};
+
+/// Return true if `op` is nested in a loop of the function.
+static bool isInLoop(Operation *op) {
+  for (auto *parent = op->getParentOp(); parent && !isa<func::FuncOp>(parent);
+       parent = parent->getParentOp())
+    if (isa<LoopLikeOpInterface>(parent))
+      return true;
+  return false;
+}
+
+/// Return true if `op` only refers to qubits, without acting on them.
+static bool isReference(Operation *op) {
+  return isa<quake::QExtractOp, quake::SubVecOp, quake::RelaxSizeOp,
+             quake::QVecSizeOp, quake::ConcatOp, quake::DeallocOp>(op);
+}
+
+class QuakeDeferMeasurementsPass
+    : public cudaq::opt::QuakeDeferMeasurementsBase<
+          QuakeDeferMeasurementsPass> {
+public:
+  QuakeDeferMeasurementsPass() = default;
+  QuakeDeferMeasurementsPass(std::size_t max) { maxAncillas = max; }
+
+  void runOnOperation() override {
+    auto func = getOperation();
+    if (func.empty())
+      return;
+    DominanceInfo dominance(func);
+    SmallVector<Deferral> deferrals;
+    func.walk([&](quake::MzOp measure) {
+      if (auto deferral = getDeferral(measure, dominance))
+        deferrals.push_back(std::move(*deferral));
+    });
+
+    QubitResolver resolver(func);
+    std::size_t ancillas = 0;
+    for (auto &deferral : deferrals) {
+      Value control = deferral.measure.getTargets().front();
+      if (isUsedAfter(func, deferral.measure, resolver)) {
+        // The qubit is used again, so its value is copied to a fresh qubit,
+        // which is measured instead and controls the gates.
+        if (ancillas == maxAncillas)
+          continue;
+        ancillas++;
+        OpBuilder builder(deferral.measure);
+        auto loc = deferral.measure.getLoc();
+        Value ancilla = builder.create<quake::AllocaOp>(loc);
+        builder.create<quake::XOp>(loc, ValueRange{control},
+                                   ValueRange{ancilla});
+        deferral.measure->setOperand(0, ancilla);
+        control = ancilla;
+      }
+      for (auto ifOp : deferral.conditionals)
+        inlineControlled(ifOp, control);
+      cleanUp(deferral);
+    }
+  }
+
+private:
+  /// Return the deferral of `measure` if it is a measurement of a single
+  /// qubit, executed once, whose conditionals can all be turned into
+  /// controlled gates. Other uses of its bit are kept as they are.
+  std::optional<Deferral> getDeferral(quake::MzOp measure,
+                                      DominanceInfo &dominance) {
+    if (measure.getTargets().size() != 1 ||
+        !measure.getTargets().front().getType().isa<quake::QRefType>() ||
+        measure.getRegisterName().has_value() || isInLoop(measure))
+      return std::nullopt;
+
+    Deferral deferral{measure};
+    // Add the conditionals on `bit` and return false if `bit` conditions
+    // anything that cannot be deferred.
+    auto addConditionals = [&](Value bit) {
+      for (auto *user : bit.getUsers()) {
+        if (isa<cf::CondBranchOp>(user))
+          return false;
+        auto ifOp = dyn_cast<cudaq::cc::IfOp>(user);
+        if (!ifOp || ifOp.getCondition() != bit)
+          continue;
+        if (!canInline(ifOp) ||
+            !dominance.properlyDominates(measure.getOperation(), ifOp))
+          return false;
+        deferral.conditionals.push_back(ifOp);
+      }
+      return true;
+    };
+
+    Value bit = measure.getResult(0);
+    if (!addConditionals(bit))
+      return std::nullopt;
+    for (auto *user : bit.getUsers()) {
+      // The bit of `auto b = mz(q);` goes through a local variable.
+      auto store = dyn_cast<memref::StoreOp>(user);
+      if (!store || store.getValueToStore() != bit)
+        continue;
+      auto alloca = store.getMemRef().getDefiningOp<memref::AllocaOp>();
+      if (!alloca)
+        return std::nullopt;
+      for (auto *memUser : alloca->getUsers()) {
+        if (auto load = dyn_cast<memref::LoadOp>(memUser)) {
+          if (!addConditionals(load.getResult()))
+            return std::nullopt;
+          deferral.loads.push_back(load);
+        } else if (memUser != store.getOperation()) {
+          // The variable is written again.
+          return std::nullopt;
+        }
+      }
+    }
+    if (deferral.conditionals.empty())
+      return std::nullopt;
+    return deferral;
+  }
+
+  /// Return true if `ifOp` is executed once and only applies gates when its
+  /// condition holds.
+  static bool canInline(cudaq::cc::IfOp ifOp) {
+    if (ifOp.hasResults() || isInLoop(ifOp) ||
+        !ifOp.getThenRegion().hasOneBlock())
+      return false;
+    auto &elseRegion = ifOp.getElseRegion();
+    if (!elseRegion.empty() && (!elseRegion.hasOneBlock() ||
+                                !hasOnlyTerminator(elseRegion.front())))
+      return false;
+    for (auto &op : ifOp.getThenRegion().front()) {
+      if (op.hasTrait<OpTrait::IsTerminator>()) {
+        if (op.getNumOperands() != 0)
+          return false;
+        continue;
+      }
+      if (op.hasTrait<cudaq::QuantumGate>())
+        continue;
+      if (op.getNumRegions() != 0 || !isPure(&op))
+        return false;
+    }
+    return true;
+  }
+
+  static bool hasOnlyTerminator(Block &block) {
+    return llvm::hasSingleElement(block) &&
+           block.front().getNumOperands() == 0;
+  }
+
+  /// Return true if the measured qubit of `measure` may be used after it,
+  /// other than by its deallocation.
+  static bool isUsedAfter(func::FuncOp func, quake::MzOp measure,
+                          QubitResolver &resolver) {
+    auto qubit = resolver.resolve(measure.getTargets().front());
+    if (!qubit || !qubit->fresh || !qubit->index)
+      return true;
+    auto key = qubit->getKey();
+    bool after = false;
+    auto result = func.walk<WalkOrder::PreOrder>([&](Operation *op) {
+      if (op == measure.getOperation()) {
+        after = true;
+        return WalkResult::advance();
+      }
+      if (!after || isReference(op))
+        return WalkResult::advance();
+      for (auto operand : op->getOperands())
+        if (resolver.mayReferTo(operand, key))
+          return WalkResult::interrupt();
+      return WalkResult::advance();
+    });
+    return result.wasInterrupted();
+  }
+
+  /// Move the body of `ifOp` before it, with `control` added to the controls
+  /// of its gates, and erase it.
+  static void inlineControlled(cudaq::cc::IfOp ifOp, Value control) {
+    auto *ctx = ifOp.getContext();
+    auto &body = ifOp.getThenRegion().front();
+    for (auto &op : llvm::make_early_inc_range(body.without_terminator())) {
+      if (!op.hasTrait<cudaq::QuantumGate>()) {
+        op.moveBefore(ifOp);
+        continue;
+      }
+      OpBuilder builder(ifOp);
+      auto arrAttr = op.getAttr(segmentSizes).cast<DenseI32ArrayAttr>();
+      SmallVector<Value> operands(op.getOperands().begin(),
+                                  op.getOperands().begin() + arrAttr[0]);
+      operands.push_back(control);
+      operands.append(op.getOperands().begin() + arrAttr[0],
+                      op.getOperands().end());
+      auto newArrAttr =
+          DenseI32ArrayAttr::get(ctx, {arrAttr[0], arrAttr[1] + 1, arrAttr[2]});
+      NamedAttrList attrs(op.getAttrs());
+      attrs.set(segmentSizes, newArrAttr);
+      if (auto negated =
+              op.getAttrOfType<DenseBoolArrayAttr>(negatedControls)) {
+        SmallVector<bool> newNegated = {false};
+        newNegated.append(negated.asArrayRef().begin(),
+                          negated.asArrayRef().end());
+        attrs.set(negatedControls, DenseBoolArrayAttr::get(ctx, newNegated));
+      }
+      OperationState res(op.getLoc(), op.getName().getStringRef(), operands,
+                         op.getResultTypes(), attrs);
+      builder.create(res);
+      op.erase();
+    }
+    ifOp.erase();
+  }
+
+  /// Erase the loads of the bit left without uses, and the local variable of
+  /// the bit if it is no longer read.
+  static void cleanUp(Deferral &deferral) {
+    Operation *alloca = nullptr;
+    for (auto load : deferral.loads) {
+      alloca = load.getMemRef().getDefiningOp();
+      if (load->use_empty())
+        load.erase();
+    }
+    if (!alloca || !llvm::all_of(alloca->getUsers(), [](Operation *user) {
+          return isa<memref::StoreOp>(user);
+        }))
+      return;
+    for (auto *user : llvm::make_early_inc_range(alloca->getUsers()))
+      user->erase();
+    alloca->erase();
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeDeferMeasurementsPass() {
+  return std::make_unique<QuakeDeferMeasurementsPass>();
+}
+
+std::unique_ptr<Pass>
+cudaq::opt::createQuakeDeferMeasurementsPass(std::size_t maxAncillas) {
+  return std::make_unique<QuakeDeferMeasurementsPass>(maxAncillas);
+}
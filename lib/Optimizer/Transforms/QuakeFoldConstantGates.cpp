@@ -0,0 +1,158 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "GateMatrix.h"
+#include "PassDetails.h"
+#include "QubitResolver.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include "llvm/ADT/DenseSet.h"
+
+using namespace mlir;
+using cudaq::opt::getConstantParameter;
+using cudaq::opt::QubitKey;
+using cudaq::opt::QubitResolver;
+
+namespace {
+
+static bool isMultipleOf(double angle, double period) {
+  constexpr double tolerance = 1e-12;
+  return std::abs(std::remainder(angle, period)) < tolerance;
+}
+
+/// Return true if `angle` is a constant multiple of `period`.
+static bool isMultipleOf(Value angle, double period) {
+  auto value = getConstantParameter(angle);
+  return value && isMultipleOf(*value, period);
+}
+
+/// Return true if the gate is the identity. Rotations by 2π are the identity
+/// up to a global phase, which is only dropped for uncontrolled gates.
+static bool isIdentity(quake::OperatorInterface optor) {
+  auto *op = optor.getOperation();
+  auto params = optor.getParameters();
+  const double period = optor.getControls().empty() ? 2. * M_PI : 4. * M_PI;
+  if (isa<quake::RxOp, quake::RyOp, quake::RzOp, quake::PhasedRxOp>(op))
+    return isMultipleOf(params[0], period);
+  if (isa<quake::R1Op>(op))
+    return isMultipleOf(params[0], 2. * M_PI);
+  if (isa<quake::U3Op>(op)) {
+    auto phi = getConstantParameter(params[1]);
+    auto lambda = getConstantParameter(params[2]);
+    return phi && lambda && isMultipleOf(params[0], period) &&
+           isMultipleOf(*phi + *lambda, 2. * M_PI);
+  }
+  return false;
+}
+
+/// Folds the gates of a kernel that do nothing: identity rotations, gates
+/// with a control that is still |0>, and uncontrolled phase gates on a qubit
+/// that is still |0>. A qubit allocated by the kernel is known to be |0>
+/// until it is used by anything but a control of a gate. Only the entry block
+/// is folded, any use in a nested region counts as a use at its parent.
+class ConstantGateFolder {
+public:
+  ConstantGateFolder(func::FuncOp func) : resolver(func) {}
+
+  void run(Block &block) {
+    for (auto &op : llvm::make_early_inc_range(block)) {
+      if (auto alloca = dyn_cast<quake::AllocaOp>(op)) {
+        zeroRoots.insert(alloca.getResult());
+        continue;
+      }
+      if (isa<quake::ConcatOp, quake::DeallocOp, quake::QExtractOp,
+              quake::QVecSizeOp, quake::RelaxSizeOp, quake::SubVecOp>(op))
+        continue;
+      if (auto optor = dyn_cast<quake::OperatorInterface>(op)) {
+        if (fold(optor))
+          continue;
+        // Controls are left as they are.
+        for (auto target : optor.getTargets())
+          use(target);
+        continue;
+      }
+      op.walk([&](Operation *nested) {
+        for (auto operand : nested->getOperands())
+          use(operand);
+      });
+    }
+  }
+
+private:
+  QubitResolver resolver;
+  /// The allocations whose qubits are |0>, unless used.
+  DenseSet<Value> zeroRoots;
+  /// The used qubits of the allocations in `zeroRoots`.
+  DenseSet<QubitKey> used;
+
+  bool isZero(Value ref) {
+    if (!ref.getType().isa<quake::QRefType>())
+      return false;
+    auto qubit = resolver.resolve(ref);
+    return qubit && qubit->fresh && qubit->index &&
+           zeroRoots.contains(qubit->root) && !used.contains(qubit->getKey());
+  }
+
+  /// Record that the qubits `value` may refer to are no longer |0>.
+  void use(Value value) {
+    bool isRef = value.getType().isa<quake::QRefType>();
+    if (!isRef && !value.getType().isa<quake::QVecType>())
+      return;
+    auto qubit =
+        isRef ? resolver.resolve(value) : resolver.resolveVector(value);
+    if (!qubit) {
+      zeroRoots.clear();
+      return;
+    }
+    // Arguments are never |0>, and allocations do not alias them.
+    if (!qubit->fresh)
+      return;
+    if (isRef && qubit->index)
+      used.insert(qubit->getKey());
+    else
+      zeroRoots.erase(qubit->root);
+  }
+
+  /// Erase the gate if it does nothing, return true if it was erased.
+  bool fold(quake::OperatorInterface optor) {
+    auto *op = optor.getOperation();
+    bool erase = isIdentity(optor);
+    auto negated =
+        op->getAttrOfType<DenseBoolArrayAttr>("negated_qubit_controls");
+    for (auto iter : llvm::enumerate(optor.getControls()))
+      if (!(negated && negated.asArrayRef()[iter.index()]) &&
+          isZero(iter.value()))
+        erase = true;
+    // A phase gate on |0> only applies a global phase.
+    if (optor.getControls().empty() &&
+        isa<quake::ZOp, quake::SOp, quake::TOp, quake::RzOp, quake::R1Op>(
+            op) &&
+        isZero(optor.getTargets()[0]))
+      erase = true;
+    if (erase)
+      op->erase();
+    return erase;
+  }
+};
+
+struct QuakeFoldConstantGates
+    : public cudaq::opt::QuakeFoldConstantGatesBase<QuakeFoldConstantGates> {
+  void runOnOperation() override {
+    auto func = getOperation();
+    if (func.empty())
+      return;
+    ConstantGateFolder folder(func);
+    folder.run(func.getBody().front());
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeFoldConstantGatesPass() {
+  return std::make_unique<QuakeFoldConstantGates>();
+}
@@ -0,0 +1,96 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "PassDetails.h"
+#include "cudaq/Optimizer/Dialect/Common/Traits.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include "mlir/Dialect/Arith/IR/Arith.h"
+
+using namespace mlir;
+
+namespace {
+
+/// Clone the adjoint of the gate `op` at the insertion point of `builder`.
+/// Hermitian gates are their own adjoint, the adjoint of a rotation negates
+/// its angle and the adjoint of `u3(θ, φ, λ)` is `u3(-θ, -λ, -φ)`, so that
+/// the adjoints of the gates of a target's basis stay in that basis. Only
+/// the remaining gates (`s`, `t` and `u2`) are marked as adjoint.
+static void cloneAdjoint(OpBuilder &builder, Operation *op) {
+  if (op->hasTrait<cudaq::Hermitian>()) {
+    builder.clone(*op);
+    return;
+  }
+  // The operands of an operator start with its parameters.
+  auto negate = [&](unsigned index) -> Value {
+    Value value = op->getOperand(index);
+    return builder.create<arith::NegFOp>(op->getLoc(), value.getType(),
+                                         value);
+  };
+  if (isa<quake::RxOp, quake::RyOp, quake::RzOp, quake::R1Op,
+          quake::PhasedRxOp>(op)) {
+    Value angle = negate(0);
+    builder.clone(*op)->setOperand(0, angle);
+    return;
+  }
+  if (isa<quake::U3Op>(op)) {
+    Value theta = negate(0);
+    Value phi = negate(1);
+    Value lambda = negate(2);
+    auto *adjoint = builder.clone(*op);
+    adjoint->setOperand(0, theta);
+    adjoint->setOperand(1, lambda);
+    adjoint->setOperand(2, phi);
+    return;
+  }
+  auto *adjoint = builder.clone(*op);
+  if (adjoint->hasAttr("is_adj"))
+    adjoint->removeAttr("is_adj");
+  else
+    adjoint->setAttr("is_adj", builder.getUnitAttr());
+}
+
+struct QuakeFoldGates : public cudaq::opt::QuakeFoldGatesBase<QuakeFoldGates> {
+  QuakeFoldGates() = default;
+  QuakeFoldGates(std::size_t factor) { scale = factor; }
+
+  void runOnOperation() override {
+    auto func = getOperation();
+    if (scale % 2 == 0) {
+      func.emitOpError("can only fold gates by an odd scale, not ") << scale;
+      signalPassFailure();
+      return;
+    }
+    if (func.empty() || scale == 1)
+      return;
+
+    SmallVector<Operation *> gates;
+    func.walk([&](Operation *op) {
+      if (op->hasTrait<cudaq::QuantumGate>())
+        gates.push_back(op);
+    });
+    for (auto *op : gates) {
+      OpBuilder builder(op->getContext());
+      builder.setInsertionPointAfter(op);
+      for (std::size_t i = 0; i < (scale - 1) / 2; i++) {
+        cloneAdjoint(builder, op);
+        builder.clone(*op);
+      }
+    }
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeFoldGatesPass() {
+  return std::make_unique<QuakeFoldGates>();
+}
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeFoldGatesPass(std::size_t scale) {
+  return std::make_unique<QuakeFoldGates>(scale);
+}
@@ -0,0 +1,290 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "GateMatrix.h"
+#include "PassDetails.h"
+#include "QubitResolver.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include <complex>
+#include <vector>
+
+using namespace mlir;
+using cudaq::opt::Qubit;
+using cudaq::opt::QubitResolver;
+
+namespace {
+
+/// A dense matrix, row-major. Bit `j` of a row (or column) index corresponds
+/// to the `j`-th qubit it acts on.
+using Matrix = std::vector<std::complex<double>>;
+
+/// A matrix and the qubits it acts on, with a reference to each of them.
+struct Unitary {
+  SmallVector<Qubit> qubits;
+  SmallVector<Value> refs;
+  Matrix matrix;
+};
+
+/// Return the matrix of `matrix`, acting on `qubits`, as a matrix acting on
+/// `into`, which must contain `qubits`.
+static Matrix embed(const Matrix &matrix, ArrayRef<Qubit> qubits,
+                    ArrayRef<Qubit> into) {
+  SmallVector<std::size_t> positions;
+  std::size_t mask = 0;
+  for (auto &qubit : qubits) {
+    positions.push_back(llvm::find(into, qubit) - into.begin());
+    mask |= 1ULL << positions.back();
+  }
+  auto compress = [&](std::size_t index) {
+    std::size_t local = 0;
+    for (auto iter : llvm::enumerate(positions))
+      local |= ((index >> iter.value()) & 1) << iter.index();
+    return local;
+  };
+  const std::size_t localDim = 1ULL << qubits.size();
+  const std::size_t dim = 1ULL << into.size();
+  Matrix result(dim * dim, 0.0);
+  for (std::size_t r = 0; r < dim; r++)
+    for (std::size_t c = 0; c < dim; c++)
+      if ((r & ~mask) == (c & ~mask))
+        result[r * dim + c] = matrix[compress(r) * localDim + compress(c)];
+  return result;
+}
+
+/// Return `a` times `b`, both of dimension `dim`.
+static Matrix multiply(const Matrix &a, const Matrix &b, std::size_t dim) {
+  Matrix result(dim * dim, 0.0);
+  for (std::size_t r = 0; r < dim; r++)
+    for (std::size_t k = 0; k < dim; k++) {
+      if (a[r * dim + k] == 0.0)
+        continue;
+      for (std::size_t c = 0; c < dim; c++)
+        result[r * dim + c] += a[r * dim + k] * b[k * dim + c];
+    }
+  return result;
+}
+
+static bool isIdentity(const Matrix &matrix, std::size_t dim) {
+  constexpr double tolerance = 1e-12;
+  for (std::size_t r = 0; r < dim; r++)
+    for (std::size_t c = 0; c < dim; c++)
+      if (std::abs(matrix[r * dim + c] - (r == c ? 1.0 : 0.0)) > tolerance)
+        return false;
+  return true;
+}
+
+/// Fuses the gates with constant parameters of a block. Each fused block is
+/// a set of gates on at most `maxQubits` qubits, with no other use of these
+/// qubits in between, so that its gates can all be moved to its last one.
+/// The fused blocks act on disjoint qubits.
+class GateFuser {
+public:
+  GateFuser(func::FuncOp func, std::size_t maxQubits)
+      : resolver(func), maxQubits(maxQubits) {}
+
+  void run(Block &block) {
+    for (auto &op : llvm::make_early_inc_range(block)) {
+      if (auto unitary = getUnitary(&op)) {
+        fuse(&op, std::move(*unitary));
+        continue;
+      }
+      if (op.getNumRegions()) {
+        flushAll();
+        continue;
+      }
+      if (isa<quake::AllocaOp, quake::ConcatOp, quake::QExtractOp,
+              quake::QVecSizeOp, quake::RelaxSizeOp, quake::SubVecOp>(op))
+        continue;
+      for (auto operand : op.getOperands())
+        for (std::size_t i = blocks.size(); i-- > 0;)
+          if (llvm::any_of(blocks[i].unitary.qubits, [&](const Qubit &qubit) {
+                return resolver.mayReferTo(operand, qubit.getKey());
+              }))
+            flush(i);
+    }
+    flushAll();
+  }
+
+private:
+  struct FusedBlock {
+    Unitary unitary;
+    SmallVector<Operation *> gates;
+  };
+
+  QubitResolver resolver;
+  std::size_t maxQubits;
+  SmallVector<FusedBlock> blocks;
+
+  /// Return the unitary of `op`, or nullopt if it is not a gate with constant
+  /// parameters on at most `maxQubits` distinct qubits, allocated by the
+  /// kernel (or the only quantum argument of the kernel) with known indices.
+  std::optional<Unitary> getUnitary(Operation *op) {
+    auto optor = dyn_cast<quake::OperatorInterface>(op);
+    if (!optor)
+      return std::nullopt;
+    if (optor.getTargets().size() + optor.getControls().size() > maxQubits)
+      return std::nullopt;
+
+    Matrix target;
+    if (isa<quake::SwapOp>(op)) {
+      target = {1, 0, 0, 0, 0, 0, 1, 0, 0, 1, 0, 0, 0, 0, 0, 1};
+    } else {
+      auto matrix = cudaq::opt::getTargetMatrix(optor);
+      if (!matrix)
+        return std::nullopt;
+      target.assign(matrix->begin(), matrix->end());
+    }
+
+    // The targets are the low bits and the controls the high bits of the
+    // index of the gate's matrix.
+    Unitary unitary;
+    SmallVector<Value> refs(optor.getTargets());
+    refs.append(optor.getControls().begin(), optor.getControls().end());
+    for (auto ref : refs) {
+      if (!ref.getType().isa<quake::QRefType>())
+        return std::nullopt;
+      auto qubit = resolver.resolve(ref);
+      if (!qubit || !qubit->index || !qubit->fresh ||
+          llvm::is_contained(unitary.qubits, *qubit))
+        return std::nullopt;
+      unitary.qubits.push_back(*qubit);
+    }
+    unitary.refs = std::move(refs);
+
+    auto negated =
+        op->getAttrOfType<DenseBoolArrayAttr>("negated_qubit_controls");
+    const std::size_t numTargets = optor.getTargets().size();
+    const std::size_t numControls = optor.getControls().size();
+    std::size_t activeControls = 0;
+    for (std::size_t i = 0; i < numControls; i++)
+      if (!negated || !negated.asArrayRef()[i])
+        activeControls |= 1ULL << i;
+    const std::size_t targetDim = 1ULL << numTargets;
+    const std::size_t dim = 1ULL << unitary.qubits.size();
+    unitary.matrix.assign(dim * dim, 0.0);
+    for (std::size_t r = 0; r < dim; r++) {
+      if ((r >> numTargets) != activeControls) {
+        unitary.matrix[r * dim + r] = 1.0;
+        continue;
+      }
+      const std::size_t base = r & ~(targetDim - 1);
+      for (std::size_t c = 0; c < targetDim; c++)
+        unitary.matrix[r * dim + base + c] =
+            target[(r - base) * targetDim + c];
+    }
+    return unitary;
+  }
+
+  /// Multiply the gate `op` into the fused blocks on its qubits if they fit
+  /// in `maxQubits` qubits together, otherwise flush them and start a new
+  /// fused block with it.
+  void fuse(Operation *op, Unitary gate) {
+    SmallVector<std::size_t> touched;
+    Unitary fused;
+    for (auto iter : llvm::enumerate(blocks)) {
+      auto &unitary = iter.value().unitary;
+      if (llvm::none_of(unitary.qubits, [&](const Qubit &qubit) {
+            return llvm::is_contained(gate.qubits, qubit);
+          }))
+        continue;
+      touched.push_back(iter.index());
+      fused.qubits.append(unitary.qubits);
+      fused.refs.append(unitary.refs);
+    }
+    for (auto iter : llvm::enumerate(gate.qubits))
+      if (!llvm::is_contained(fused.qubits, iter.value())) {
+        fused.qubits.push_back(iter.value());
+        fused.refs.push_back(gate.refs[iter.index()]);
+      }
+
+    if (fused.qubits.size() > maxQubits) {
+      for (auto i : llvm::reverse(touched))
+        flush(i);
+      blocks.push_back({std::move(gate), {op}});
+      return;
+    }
+
+    // The fused blocks act on disjoint qubits, so they commute and their
+    // product is their tensor product.
+    const std::size_t dim = 1ULL << fused.qubits.size();
+    fused.matrix = embed(gate.matrix, gate.qubits, fused.qubits);
+    SmallVector<Operation *> gates;
+    for (auto i : touched) {
+      auto &block = blocks[i];
+      fused.matrix = multiply(
+          fused.matrix,
+          embed(block.unitary.matrix, block.unitary.qubits, fused.qubits),
+          dim);
+      gates.append(block.gates);
+    }
+    gates.push_back(op);
+    for (auto i : llvm::reverse(touched))
+      blocks.erase(blocks.begin() + i);
+    blocks.push_back({std::move(fused), std::move(gates)});
+  }
+
+  /// Replace the gates of the fused block `i` by a single unitary, if it has
+  /// more than one gate.
+  void flush(std::size_t i) {
+    auto block = std::move(blocks[i]);
+    blocks.erase(blocks.begin() + i);
+    if (block.gates.size() < 2)
+      return;
+
+    // The gate that extended the block last is its last one.
+    auto *last = block.gates.back();
+    auto &unitary = block.unitary;
+    const std::size_t dim = 1ULL << unitary.qubits.size();
+    if (!isIdentity(unitary.matrix, dim)) {
+      SmallVector<double> values;
+      for (auto element : unitary.matrix) {
+        values.push_back(element.real());
+        values.push_back(element.imag());
+      }
+      OpBuilder builder(last);
+      builder.create<quake::UnitaryOp>(
+          last->getLoc(), builder.getDenseF64ArrayAttr(values), unitary.refs);
+    }
+    for (auto *op : block.gates)
+      op->erase();
+  }
+
+  void flushAll() {
+    while (!blocks.empty())
+      flush(blocks.size() - 1);
+  }
+};
+
+struct QuakeGateFusion
+    : public cudaq::opt::QuakeGateFusionBase<QuakeGateFusion> {
+  QuakeGateFusion() = default;
+  QuakeGateFusion(std::size_t max) { maxQubits = max; }
+
+  void runOnOperation() override {
+    auto func = getOperation();
+    if (func.empty() || maxQubits == 0)
+      return;
+    SmallVector<Block *> blocks;
+    func.walk([&](Block *block) { blocks.push_back(block); });
+    GateFuser fuser(func, maxQubits);
+    for (auto *block : blocks)
+      fuser.run(*block);
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeGateFusionPass() {
+  return std::make_unique<QuakeGateFusion>();
+}
+
+std::unique_ptr<Pass>
+cudaq::opt::createQuakeGateFusionPass(std::size_t maxQubits) {
+  return std::make_unique<QuakeGateFusion>(maxQubits);
+}
@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "PassDetails.h"
+#include "cudaq/Optimizer/Dialect/CC/CCOps.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+
+using namespace mlir;
+
+namespace {
+
+/// Return true if `type` is a qubit or a vector of qubits.
+static bool isQuantum(Type type) {
+  return type.isa<quake::QRefType, quake::QVecType>();
+}
+
+struct QuakeHoistAllocations
+    : public cudaq::opt::QuakeHoistAllocationsBase<QuakeHoistAllocations> {
+  void runOnOperation() override {
+    // Only the kernels executed shot by shot collapse the state at each
+    // measurement and reset, the others sample all their qubits from the
+    // final state, so each iteration must keep qubits of its own.
+    auto func = getOperation();
+    if (func.empty() || !func->hasAttr("qubitMeasurementFeedback"))
+      return;
+
+    SmallVector<std::pair<quake::AllocaOp, cudaq::cc::LoopOp>> hoists;
+    func.walk([&](quake::AllocaOp alloca) {
+      if (alloca.getSize() || !isReusable(alloca))
+        return;
+      if (auto loop = getOutermostLoop(alloca))
+        hoists.emplace_back(alloca, loop);
+    });
+
+    for (auto [alloca, loop] : hoists) {
+      // The qubits are fresh at the top of each iteration, as they were when
+      // allocated there.
+      OpBuilder builder(alloca);
+      auto loc = alloca.getLoc();
+      builder.create<quake::ResetOp>(loc, alloca.getResult());
+      alloca->moveBefore(loop);
+
+      bool deallocates = false;
+      for (auto *user : llvm::make_early_inc_range(alloca->getUsers()))
+        if (isa<quake::DeallocOp>(user)) {
+          deallocates = true;
+          user->erase();
+        }
+      if (deallocates) {
+        builder.setInsertionPointAfter(loop);
+        builder.create<quake::DeallocOp>(loc, alloca.getResult());
+      }
+    }
+  }
+
+  /// Return the outermost loop whose body `alloca` is in, without leaving
+  /// the kernel for the body of a lambda, or null if there is none.
+  static cudaq::cc::LoopOp getOutermostLoop(quake::AllocaOp alloca) {
+    cudaq::cc::LoopOp outermost;
+    for (auto *op = alloca->getParentOp(); op && !isa<func::FuncOp>(op);
+         op = op->getParentOp()) {
+      if (isa<cudaq::cc::CreateLambdaOp>(op))
+        return {};
+      if (auto loop = dyn_cast<cudaq::cc::LoopOp>(op))
+        outermost = loop;
+    }
+    return outermost;
+  }
+
+  /// Return true if the qubits of `alloca` may be reset and used again. A
+  /// qubit measured without a register name is not, its bit is sampled from
+  /// the final state, nor is a qubit passed to a call, which may measure it.
+  static bool isReusable(quake::AllocaOp alloca) {
+    SmallVector<Value> refs{alloca.getResult()};
+    while (!refs.empty()) {
+      auto ref = refs.pop_back_val();
+      for (auto *user : ref.getUsers()) {
+        if (isa<CallOpInterface>(user))
+          return false;
+        if (isa<quake::MxOp, quake::MyOp, quake::MzOp>(user) &&
+            !user->hasAttr("registerName"))
+          return false;
+        if (isa<quake::ConcatOp, quake::QExtractOp, quake::RelaxSizeOp,
+                quake::SubVecOp>(user))
+          for (auto result : user->getResults())
+            if (isQuantum(result.getType()))
+              refs.push_back(result);
+      }
+    }
+    return true;
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeHoistAllocationsPass() {
+  return std::make_unique<QuakeHoistAllocations>();
+}
@@ -7,6 +7,7 @@
  *******************************************************************************/
 
 #include "PassDetails.h"
+#include "cudaq/Frontend/nvqpp/AttributeNames.h"
 #include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
 #include "cudaq/Optimizer/Transforms/Passes.h"
 #include "cudaq/Todo.h"
@@ -95,6 +96,18 @@ private:
       }
     });
 
+    // A kernel mapped to the qubits of a device is measured on the device
+    // qubits its qubits end up on.
+    if (auto layout = funcOp->getAttrOfType<DenseI64ArrayAttr>(
+            cudaq::qubitLayoutAttrName)) {
+      DenseMap<std::size_t, Value> deviceQubits;
+      std::swap(deviceQubits, data.qubitValues);
+      data.nQubits = layout.size();
+      for (auto iter : llvm::enumerate(layout.asArrayRef()))
+        data.qubitValues.insert(
+            {iter.index(), deviceQubits.lookup(iter.value())});
+    }
+
     // Count all measures
     funcOp->walk([&](quake::MzOp op) { data.nMeasures++; });
 
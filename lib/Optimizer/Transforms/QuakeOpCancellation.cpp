@@ -0,0 +1,329 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "PassDetails.h"
+#include "QubitResolver.h"
+#include "cudaq/Optimizer/Dialect/Common/Traits.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include "mlir/IR/Matchers.h"
+
+using namespace mlir;
+using cudaq::opt::Qubit;
+using cudaq::opt::QubitKey;
+using cudaq::opt::QubitResolver;
+
+namespace {
+
+/// The operators a gate applies to one of its qubits. A control applies a
+/// projector, in the span of {I, Z}, and the target of a gate about an axis
+/// applies an operator in the span of {I, P} for the Pauli P of that axis.
+/// Two gates commute if they apply operators of the same axis to every qubit
+/// they share.
+enum class Axis { X, Y, Z, None };
+
+static Axis getTargetAxis(Operation *op) {
+  if (isa<quake::XOp, quake::RxOp>(op))
+    return Axis::X;
+  if (isa<quake::YOp, quake::RyOp>(op))
+    return Axis::Y;
+  if (isa<quake::ZOp, quake::SOp, quake::TOp, quake::RzOp, quake::R1Op>(op))
+    return Axis::Z;
+  return Axis::None;
+}
+
+struct GateOperand {
+  Qubit qubit;
+  Axis axis;
+  bool negated = false;
+};
+
+/// A gate on qubits with known indices.
+struct Gate {
+  SmallVector<GateOperand> controls;
+  SmallVector<GateOperand> targets;
+  /// The distinct keys of the qubits of the gate.
+  SmallVector<QubitKey> keys;
+};
+
+static std::optional<double> getConstantAngle(Value value) {
+  APFloat angle(0.0);
+  if (matchPattern(value, m_ConstantFloat(&angle))) {
+    bool losesInfo;
+    angle.convert(APFloat::IEEEdouble(), APFloat::rmNearestTiesToEven,
+                  &losesInfo);
+    return angle.convertToDouble();
+  }
+  return std::nullopt;
+}
+
+/// Cancels and merges the gates of one block. The commutation DAG of the
+/// block is kept as the list of gates on each qubit key since the last
+/// barrier on it: a new gate is combined with an earlier one on its first
+/// target if every gate in between on its qubits commutes with it.
+class GateCombiner {
+public:
+  GateCombiner(func::FuncOp func) : resolver(func) {}
+
+  void run(Block &block) {
+    frontier.clear();
+    gates.clear();
+    for (auto &op : llvm::make_early_inc_range(block)) {
+      if (auto gate = getGate(&op)) {
+        if (!combine(&op, *gate))
+          track(&op, std::move(*gate));
+        continue;
+      }
+      if (op.getNumRegions()) {
+        clear();
+        continue;
+      }
+      if (isa<quake::AllocaOp, quake::ConcatOp, quake::QExtractOp,
+              quake::QVecSizeOp, quake::RelaxSizeOp, quake::SubVecOp>(op))
+        continue;
+      // Any other use of a qubit, including a gate on unknown qubits, is a
+      // barrier on it.
+      for (auto operand : op.getOperands())
+        barrier(operand);
+    }
+  }
+
+private:
+  QubitResolver resolver;
+  DenseMap<QubitKey, SmallVector<Operation *>> frontier;
+  DenseMap<Operation *, Gate> gates;
+
+  /// Return the gate of `op`, or nullopt if it is not a gate on qubits with
+  /// known indices.
+  std::optional<Gate> getGate(Operation *op) {
+    auto optor = dyn_cast<quake::OperatorInterface>(op);
+    if (!optor)
+      return std::nullopt;
+    Gate gate;
+    bool known = true;
+    auto negated =
+        op->getAttrOfType<DenseBoolArrayAttr>("negated_qubit_controls");
+    for (auto iter : llvm::enumerate(optor.getControls())) {
+      auto qubit = iter.value().getType().isa<quake::QRefType>()
+                       ? resolver.resolve(iter.value())
+                       : std::nullopt;
+      if (!qubit || !qubit->index) {
+        known = false;
+        break;
+      }
+      bool isNegated = negated && negated.asArrayRef()[iter.index()];
+      gate.controls.push_back({*qubit, Axis::Z, isNegated});
+    }
+    auto axis = getTargetAxis(op);
+    for (auto target : optor.getTargets()) {
+      auto qubit = resolver.resolve(target);
+      if (!known || !qubit || !qubit->index) {
+        known = false;
+        break;
+      }
+      gate.targets.push_back({*qubit, axis});
+    }
+    if (!known || gate.targets.empty())
+      return std::nullopt;
+    for (auto *operands : {&gate.controls, &gate.targets})
+      for (auto &operand : *operands)
+        if (!llvm::is_contained(gate.keys, operand.qubit.getKey()))
+          gate.keys.push_back(operand.qubit.getKey());
+    return gate;
+  }
+
+  static bool commute(const Gate &a, const Gate &b) {
+    for (auto *aOperands : {&a.controls, &a.targets})
+      for (auto &x : *aOperands)
+        for (auto *bOperands : {&b.controls, &b.targets})
+          for (auto &y : *bOperands)
+            if (x.qubit.getKey() == y.qubit.getKey() &&
+                (x.axis != y.axis || x.axis == Axis::None))
+              return false;
+    return true;
+  }
+
+  static bool sameQubits(const Gate &a, const Gate &b) {
+    if (a.controls.size() != b.controls.size() ||
+        a.targets.size() != b.targets.size())
+      return false;
+    for (std::size_t i = 0; i < a.targets.size(); i++)
+      if (!(a.targets[i].qubit == b.targets[i].qubit))
+        return false;
+    // The order of the controls does not matter.
+    for (auto &x : a.controls)
+      if (llvm::none_of(b.controls, [&](const GateOperand &y) {
+            return x.qubit == y.qubit && x.negated == y.negated;
+          }))
+        return false;
+    return true;
+  }
+
+  enum class Combination { None, Cancel, Merge };
+
+  static Combination getCombination(Operation *prev, const Gate &prevGate,
+                                    Operation *op, const Gate &gate) {
+    if (prev->getName() != op->getName() || !sameQubits(prevGate, gate))
+      return Combination::None;
+    auto prevOptor = cast<quake::OperatorInterface>(prev);
+    auto optor = cast<quake::OperatorInterface>(op);
+    if (optor.getParameters().empty())
+      return (op->hasTrait<cudaq::Hermitian>() ||
+              prevOptor.isAdj() != optor.isAdj())
+                 ? Combination::Cancel
+                 : Combination::None;
+    if (isa<quake::RxOp, quake::RyOp, quake::RzOp, quake::R1Op>(op) &&
+        prevOptor.getParameters()[0].getType() ==
+            optor.getParameters()[0].getType())
+      return Combination::Merge;
+    return Combination::None;
+  }
+
+  /// Return true if the gates on the qubits of `gate` after `prev` commute
+  /// with it.
+  bool commutesAfter(Operation *prev, const Gate &gate) {
+    for (auto key : gate.keys) {
+      auto iter = frontier.find(key);
+      if (iter == frontier.end())
+        continue;
+      for (auto *other : llvm::reverse(iter->second)) {
+        if (other == prev || !prev->isBeforeInBlock(other))
+          break;
+        if (!commute(gates.find(other)->second, gate))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  /// Try to cancel `op` with, or merge it into, an earlier gate. Return true
+  /// if `op` was erased.
+  bool combine(Operation *op, Gate &gate) {
+    auto candidates = frontier.find(gate.targets.front().qubit.getKey());
+    if (candidates == frontier.end())
+      return false;
+    for (auto *prev : llvm::reverse(candidates->second)) {
+      auto &prevGate = gates.find(prev)->second;
+      auto combination = getCombination(prev, prevGate, op, gate);
+      if (combination != Combination::None && commutesAfter(prev, gate)) {
+        if (combination == Combination::Cancel) {
+          forget(prev);
+          prev->erase();
+          op->erase();
+          return true;
+        }
+        return merge(prev, op);
+      }
+      if (!commute(prevGate, gate))
+        return false;
+    }
+    return false;
+  }
+
+  /// Merge the rotation `prev` into the rotation `op`, which may move before
+  /// the gates in between since `prev` does. Return true if the merged
+  /// rotation is the identity and was erased.
+  bool merge(Operation *prev, Operation *op) {
+    auto prevOptor = cast<quake::OperatorInterface>(prev);
+    auto optor = cast<quake::OperatorInterface>(op);
+    Value prevAngle = prevOptor.getParameters()[0];
+    Value angle = optor.getParameters()[0];
+    OpBuilder builder(op);
+    auto loc = op->getLoc();
+    Value sum;
+    auto prevValue = getConstantAngle(prevAngle);
+    auto value = getConstantAngle(angle);
+    if (prevValue && value) {
+      double total = (prevOptor.isAdj() ? -*prevValue : *prevValue) +
+                     (optor.isAdj() ? -*value : *value);
+      if (total == 0.0) {
+        forget(prev);
+        prev->erase();
+        op->erase();
+        return true;
+      }
+      auto type = angle.getType();
+      sum = builder.create<arith::ConstantOp>(
+          loc, type, builder.getFloatAttr(type, total));
+    } else {
+      if (prevOptor.isAdj())
+        prevAngle = builder.create<arith::NegFOp>(loc, prevAngle);
+      if (optor.isAdj())
+        angle = builder.create<arith::NegFOp>(loc, angle);
+      sum = builder.create<arith::AddFOp>(loc, prevAngle, angle);
+    }
+    // The parameters are the first operands of an operator.
+    op->setOperand(0, sum);
+    op->removeAttr("is_adj");
+    forget(prev);
+    prev->erase();
+    return false;
+  }
+
+  void track(Operation *op, Gate gate) {
+    for (auto key : gate.keys)
+      frontier[key].push_back(op);
+    gates[op] = std::move(gate);
+  }
+
+  /// Stop tracking the gate `op` on all its qubits.
+  void forget(Operation *op) {
+    auto iter = gates.find(op);
+    if (iter == gates.end())
+      return;
+    for (auto key : iter->second.keys)
+      llvm::erase_value(frontier[key], op);
+    gates.erase(iter);
+  }
+
+  /// Forget the gates on the key, they cannot be combined with later gates.
+  void clear(QubitKey key) {
+    auto iter = frontier.find(key);
+    if (iter == frontier.end())
+      return;
+    auto ops = std::move(iter->second);
+    for (auto *op : ops)
+      forget(op);
+    frontier.erase(key);
+  }
+
+  void clear() {
+    frontier.clear();
+    gates.clear();
+  }
+
+  /// Forget the gates on the qubits `value` may refer to.
+  void barrier(Value value) {
+    SmallVector<QubitKey> keys;
+    for (auto &entry : frontier)
+      if (resolver.mayReferTo(value, entry.first))
+        keys.push_back(entry.first);
+    for (auto key : keys)
+      clear(key);
+  }
+};
+
+struct QuakeOpCancellation
+    : public cudaq::opt::QuakeOpCancellationBase<QuakeOpCancellation> {
+  void runOnOperation() override {
+    auto func = getOperation();
+    if (func.empty())
+      return;
+    SmallVector<Block *> blocks;
+    func.walk([&](Block *block) { blocks.push_back(block); });
+    GateCombiner combiner(func);
+    for (auto *block : blocks)
+      combiner.run(*block);
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeOpCancellationPass() {
+  return std::make_unique<QuakeOpCancellation>();
+}
@@ -0,0 +1,125 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "GateMatrix.h"
+#include "PassDetails.h"
+#include "QubitResolver.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include <array>
+#include <complex>
+
+using namespace mlir;
+using cudaq::opt::Qubit;
+using cudaq::opt::QubitResolver;
+
+namespace {
+
+/// A single-qubit state, the amplitudes of |0> and |1>.
+using QubitState = std::array<std::complex<double>, 2>;
+
+/// The gates of the leading layer that prepare the same state.
+struct Group {
+  QubitState state;
+  SmallVector<Operation *> gates;
+};
+
+static bool isQuantum(Type type) {
+  return type.isa<quake::QRefType, quake::QVecType>();
+}
+
+static bool isSameState(const QubitState &a, const QubitState &b) {
+  constexpr double tolerance = 1e-12;
+  return std::abs(a[0] - b[0]) < tolerance &&
+         std::abs(a[1] - b[1]) < tolerance;
+}
+
+struct QuakeProductState
+    : public cudaq::opt::QuakeProductStateBase<QuakeProductState> {
+  void runOnOperation() override {
+    auto func = getOperation();
+    if (func.empty())
+      return;
+
+    QubitResolver resolver(func);
+    SmallVector<Qubit> used;
+    SmallVector<Group> groups;
+    Operation *last = nullptr;
+    for (auto &op : func.getBody().front()) {
+      if (isa<quake::AllocaOp, quake::ConcatOp, quake::QExtractOp,
+              quake::QVecSizeOp, quake::RelaxSizeOp, quake::SubVecOp>(op))
+        continue;
+      if (!op.getNumRegions() &&
+          llvm::none_of(op.getOperandTypes(), isQuantum))
+        continue;
+      auto state = getPreparedState(&op, resolver, used);
+      if (!state)
+        break;
+      auto *group = llvm::find_if(
+          groups, [&](const Group &g) { return isSameState(g.state, *state); });
+      if (group == groups.end())
+        group = groups.insert(groups.end(), Group{*state, {}});
+      group->gates.push_back(&op);
+      last = &op;
+    }
+
+    // The gates of the layer act on distinct qubits, none used before the
+    // end of the layer, so they can all be moved to its last gate.
+    llvm::erase_if(groups, [](const Group &g) { return g.gates.size() < 2; });
+    if (groups.empty())
+      return;
+    OpBuilder builder(last);
+    for (auto &group : groups) {
+      SmallVector<double> values;
+      for (auto amplitude : group.state) {
+        values.push_back(amplitude.real());
+        values.push_back(amplitude.imag());
+      }
+      SmallVector<Value> targets;
+      for (auto *gate : group.gates)
+        targets.push_back(
+            cast<quake::OperatorInterface>(gate).getTargets().front());
+      builder.create<quake::ProductStateOp>(
+          last->getLoc(), builder.getDenseF64ArrayAttr(values), targets);
+    }
+    for (auto &group : groups)
+      for (auto *gate : group.gates)
+        gate->erase();
+  }
+
+  /// Return the state `op` prepares, or nullopt if it is not an uncontrolled
+  /// gate of the layer with constant parameters, the first use of a qubit
+  /// allocated by the kernel (so in |0>). The phase gates, which leave |0> as
+  /// it is, are not part of the layer.
+  static std::optional<QubitState>
+  getPreparedState(Operation *op, QubitResolver &resolver,
+                   SmallVectorImpl<Qubit> &used) {
+    if (!isa<quake::HOp, quake::XOp, quake::YOp, quake::RxOp, quake::RyOp>(
+            op))
+      return std::nullopt;
+    auto optor = cast<quake::OperatorInterface>(op);
+    if (!optor.getControls().empty() || optor.getTargets().size() != 1)
+      return std::nullopt;
+    auto qubit = resolver.resolve(optor.getTargets().front());
+    if (!qubit || !qubit->index ||
+        !qubit->root.getDefiningOp<quake::AllocaOp>() ||
+        llvm::is_contained(used, *qubit))
+      return std::nullopt;
+    auto matrix = cudaq::opt::getTargetMatrix(optor);
+    if (!matrix)
+      return std::nullopt;
+    used.push_back(*qubit);
+    return QubitState{(*matrix)[0], (*matrix)[2]};
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeProductStatePass() {
+  return std::make_unique<QuakeProductState>();
+}
@@ -0,0 +1,612 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "PassDetails.h"
+#include "QubitResolver.h"
+#include "cudaq/Frontend/nvqpp/AttributeNames.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include "llvm/ADT/DenseSet.h"
+#include "mlir/Interfaces/SideEffectInterfaces.h"
+#include <deque>
+#include <limits>
+
+using namespace mlir;
+
+namespace {
+
+/// The qubits of a device and the pairs of them that two-qubit gates can act
+/// on, with the distances between all the qubits.
+class CouplingMap {
+public:
+  static constexpr unsigned unreachable = std::numeric_limits<unsigned>::max();
+
+  /// Parse a coupling map given as a comma-separated list of undirected
+  /// edges, e.g. `0-1,1-2,2-3`. The device has the qubits up to the largest
+  /// one listed.
+  static std::optional<CouplingMap> parse(StringRef spec) {
+    CouplingMap map;
+    SmallVector<StringRef> edges;
+    spec.split(edges, ',', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+    SmallVector<std::pair<unsigned, unsigned>> pairs;
+    for (auto edge : edges) {
+      auto [lhs, rhs] = edge.trim().split('-');
+      unsigned a = 0, b = 0;
+      if (lhs.trim().getAsInteger(10, a) || rhs.trim().getAsInteger(10, b) ||
+          a == b)
+        return std::nullopt;
+      map.numQubits = std::max(map.numQubits, std::max(a, b) + 1);
+      pairs.emplace_back(a, b);
+    }
+    if (pairs.empty())
+      return std::nullopt;
+
+    map.neighbors.resize(map.numQubits);
+    for (auto [a, b] : pairs) {
+      if (llvm::is_contained(map.neighbors[a], b))
+        continue;
+      map.neighbors[a].push_back(b);
+      map.neighbors[b].push_back(a);
+    }
+    map.distances.assign(map.numQubits * map.numQubits, unreachable);
+    for (unsigned source = 0; source < map.numQubits; source++) {
+      std::deque<unsigned> queue{source};
+      map.distances[source * map.numQubits + source] = 0;
+      while (!queue.empty()) {
+        auto qubit = queue.front();
+        queue.pop_front();
+        for (auto next : map.neighbors[qubit])
+          if (map.distance(source, next) == unreachable) {
+            map.distances[source * map.numQubits + next] =
+                map.distance(source, qubit) + 1;
+            queue.push_back(next);
+          }
+      }
+    }
+    return map;
+  }
+
+  unsigned size() const { return numQubits; }
+
+  unsigned distance(unsigned a, unsigned b) const {
+    return distances[a * numQubits + b];
+  }
+
+  ArrayRef<unsigned> getNeighbors(unsigned qubit) const {
+    return neighbors[qubit];
+  }
+
+  bool isConnected() const {
+    return !llvm::is_contained(distances, unreachable);
+  }
+
+private:
+  unsigned numQubits = 0;
+  SmallVector<SmallVector<unsigned>> neighbors;
+  SmallVector<unsigned> distances;
+};
+
+/// The physical qubit of each logical qubit, and the other way around.
+struct Layout {
+  static constexpr unsigned none = std::numeric_limits<unsigned>::max();
+
+  /// The trivial layout, logical qubit `i` on physical qubit `i`.
+  Layout(unsigned numLogical, unsigned numPhysical)
+      : toPhysical(numLogical), toLogical(numPhysical, none) {
+    for (unsigned i = 0; i < numLogical; i++) {
+      toPhysical[i] = i;
+      toLogical[i] = i;
+    }
+  }
+
+  /// Swap the logical qubits on the physical qubits `a` and `b`.
+  void swap(unsigned a, unsigned b) {
+    std::swap(toLogical[a], toLogical[b]);
+    if (toLogical[a] != none)
+      toPhysical[toLogical[a]] = a;
+    if (toLogical[b] != none)
+      toPhysical[toLogical[b]] = b;
+  }
+
+  SmallVector<unsigned> toPhysical;
+  SmallVector<unsigned> toLogical;
+};
+
+/// An operation of the kernel, with the logical qubits it acts on and the
+/// operations it must come after (and before).
+struct Node {
+  Operation *op = nullptr;
+  SmallVector<unsigned> qubits;
+  /// Whether the operation is a gate on two qubits, which must be adjacent
+  /// on the device.
+  bool isTwoQubitGate = false;
+  SmallVector<unsigned> predecessors;
+  SmallVector<unsigned> successors;
+};
+
+/// A step of a routed circuit: the execution of a node, or a swap of two
+/// adjacent physical qubits.
+struct Step {
+  std::optional<unsigned> node;
+  unsigned a = 0;
+  unsigned b = 0;
+};
+
+/// Routes a circuit with the SABRE heuristic (Li, Ding and Xie, "Tackling the
+/// Qubit Mapping Problem for NISQ-Era Quantum Devices", 2019). The nodes that
+/// can be executed are, and when none of them can be, the swap that most
+/// reduces the distances between the qubits of the blocked two-qubit gates,
+/// and to a lesser extent of the gates that follow them, is inserted.
+class Router {
+public:
+  Router(const CouplingMap &device, ArrayRef<Node> nodes)
+      : device(device), nodes(nodes) {}
+
+  /// Route the circuit, or its reverse, starting from `layout`, which is
+  /// updated to the final layout. Return the nodes in execution order and
+  /// the swaps in between.
+  SmallVector<Step> route(Layout &layout, bool reverse) {
+    SmallVector<Step> steps;
+    SmallVector<unsigned> remaining(nodes.size());
+    SmallVector<unsigned> front;
+    for (unsigned i = 0; i < nodes.size(); i++) {
+      remaining[i] = reverse ? nodes[i].successors.size()
+                             : nodes[i].predecessors.size();
+      if (!remaining[i])
+        front.push_back(i);
+    }
+
+    SmallVector<double> decay(device.size(), 1.0);
+    unsigned swapsWithoutProgress = 0;
+    while (true) {
+      bool executed = false;
+      for (bool progress = true; progress;) {
+        progress = false;
+        SmallVector<unsigned> blocked;
+        for (auto node : front) {
+          if (!isExecutable(node, layout)) {
+            blocked.push_back(node);
+            continue;
+          }
+          steps.push_back({node});
+          progress = true;
+          for (auto next : getNext(node, reverse))
+            if (--remaining[next] == 0)
+              blocked.push_back(next);
+        }
+        front = std::move(blocked);
+        executed |= progress;
+      }
+      if (front.empty())
+        break;
+      if (executed) {
+        std::fill(decay.begin(), decay.end(), 1.0);
+        swapsWithoutProgress = 0;
+      }
+
+      // Only two-qubit gates are blocked. If the heuristic does not make
+      // progress, route the first one along a shortest path.
+      if (swapsWithoutProgress >= maxSwapsWithoutProgress * device.size()) {
+        auto &gate = nodes[front.front()];
+        unsigned from = layout.toPhysical[gate.qubits[0]];
+        unsigned to = layout.toPhysical[gate.qubits[1]];
+        while (device.distance(from, to) > 1) {
+          auto next =
+              *llvm::find_if(device.getNeighbors(from), [&](unsigned n) {
+                return device.distance(n, to) + 1 == device.distance(from, to);
+              });
+          steps.push_back({std::nullopt, from, next});
+          layout.swap(from, next);
+          from = next;
+        }
+        swapsWithoutProgress = 0;
+        continue;
+      }
+
+      auto [a, b] = chooseSwap(front, layout, decay, reverse);
+      steps.push_back({std::nullopt, a, b});
+      layout.swap(a, b);
+      decay[a] += decayIncrement;
+      decay[b] += decayIncrement;
+      if (++swapsWithoutProgress % decayResetInterval == 0)
+        std::fill(decay.begin(), decay.end(), 1.0);
+    }
+    return steps;
+  }
+
+private:
+  /// The number of two-qubit gates after the front the heuristic looks at.
+  static constexpr std::size_t extendedSetSize = 20;
+  /// The weight of the gates after the front in the heuristic.
+  static constexpr double extendedSetWeight = 0.5;
+  /// The decay of the qubits that were just swapped, which favors swaps on
+  /// other qubits so that they can run in parallel.
+  static constexpr double decayIncrement = 0.001;
+  static constexpr unsigned decayResetInterval = 5;
+  /// The swaps without executing a gate, per device qubit, after which the
+  /// heuristic gives up on the front.
+  static constexpr unsigned maxSwapsWithoutProgress = 3;
+
+  const CouplingMap &device;
+  ArrayRef<Node> nodes;
+
+  ArrayRef<unsigned> getNext(unsigned node, bool reverse) const {
+    return reverse ? nodes[node].predecessors : nodes[node].successors;
+  }
+
+  bool isExecutable(unsigned node, const Layout &layout) const {
+    auto &qubits = nodes[node].qubits;
+    return !nodes[node].isTwoQubitGate ||
+           device.distance(layout.toPhysical[qubits[0]],
+                           layout.toPhysical[qubits[1]]) == 1;
+  }
+
+  /// Return the sum of the distances between the qubits of the `gates`.
+  double getDistance(ArrayRef<unsigned> gates, const Layout &layout) const {
+    double sum = 0;
+    for (auto gate : gates)
+      sum += device.distance(layout.toPhysical[nodes[gate].qubits[0]],
+                             layout.toPhysical[nodes[gate].qubits[1]]);
+    return sum;
+  }
+
+  /// Return the first two-qubit gates that follow the front.
+  SmallVector<unsigned> getExtendedSet(ArrayRef<unsigned> front,
+                                       bool reverse) const {
+    SmallVector<unsigned> extended;
+    llvm::DenseSet<unsigned> visited(front.begin(), front.end());
+    std::deque<unsigned> queue(front.begin(), front.end());
+    while (!queue.empty() && extended.size() < extendedSetSize) {
+      auto node = queue.front();
+      queue.pop_front();
+      for (auto next : getNext(node, reverse)) {
+        if (!visited.insert(next).second)
+          continue;
+        if (nodes[next].isTwoQubitGate)
+          extended.push_back(next);
+        queue.push_back(next);
+      }
+    }
+    return extended;
+  }
+
+  std::pair<unsigned, unsigned> chooseSwap(ArrayRef<unsigned> front,
+                                           Layout &layout,
+                                           ArrayRef<double> decay,
+                                           bool reverse) const {
+    SmallVector<std::pair<unsigned, unsigned>> candidates;
+    for (auto gate : front)
+      for (auto qubit : nodes[gate].qubits) {
+        auto physical = layout.toPhysical[qubit];
+        for (auto neighbor : device.getNeighbors(physical)) {
+          std::pair<unsigned, unsigned> swap{std::min(physical, neighbor),
+                                             std::max(physical, neighbor)};
+          if (!llvm::is_contained(candidates, swap))
+            candidates.push_back(swap);
+        }
+      }
+
+    auto extended = getExtendedSet(front, reverse);
+    std::pair<unsigned, unsigned> best = candidates.front();
+    double bestScore = std::numeric_limits<double>::infinity();
+    for (auto [a, b] : candidates) {
+      layout.swap(a, b);
+      double score = getDistance(front, layout) / front.size();
+      if (!extended.empty())
+        score += extendedSetWeight * getDistance(extended, layout) /
+                 extended.size();
+      score *= std::max(decay[a], decay[b]);
+      layout.swap(a, b);
+      if (score < bestScore) {
+        bestScore = score;
+        best = {a, b};
+      }
+    }
+    return best;
+  }
+};
+
+/// Maps the qubits of a kernel to the qubits of a device. The kernel must be
+/// a single block, whose allocations all have a known size and whose qubits
+/// are all extracted at constant indices. Its qubits are replaced by the
+/// qubits of one vector the size of the device, and its operations are
+/// reordered, as their dependencies allow, with swaps in between so that the
+/// qubits of every two-qubit gate are adjacent.
+class QubitMapper {
+public:
+  QubitMapper(func::FuncOp func, const CouplingMap &device)
+      : func(func), device(device), resolver(func) {}
+
+  LogicalResult run() {
+    if (failed(collect()))
+      return failure();
+    if (numLogical == 0)
+      return success();
+    if (numLogical > device.size())
+      return func.emitOpError("uses ")
+             << numLogical << " qubits, more than the " << device.size()
+             << " qubits of the device";
+
+    // The initial layout is the layout a backward pass ends with, from the
+    // layout a forward pass from the trivial layout ends with.
+    Router router(device, nodes);
+    Layout layout(numLogical, device.size());
+    router.route(layout, /*reverse=*/false);
+    router.route(layout, /*reverse=*/true);
+    Layout initial = layout;
+    auto steps = router.route(layout, /*reverse=*/false);
+    rewrite(std::move(initial), steps);
+    return success();
+  }
+
+private:
+  func::FuncOp func;
+  const CouplingMap &device;
+  cudaq::opt::QubitResolver resolver;
+  /// The first logical qubit of each allocation.
+  DenseMap<Value, unsigned> firstQubits;
+  unsigned numLogical = 0;
+  SmallVector<Node> nodes;
+  /// The operations on qubit references and vectors, which are erased once
+  /// the operations on their qubits refer to the device qubits.
+  SmallVector<Operation *> references;
+  bool deallocates = false;
+
+  static bool isQuantum(Type type) {
+    return type.isa<quake::QRefType, quake::QVecType>();
+  }
+
+  std::optional<unsigned> getLogical(Value ref) {
+    auto qubit = resolver.resolve(ref);
+    if (!qubit || !qubit->index || !qubit->fresh)
+      return std::nullopt;
+    auto iter = firstQubits.find(qubit->root);
+    if (iter == firstQubits.end())
+      return std::nullopt;
+    return iter->second + *qubit->index;
+  }
+
+  static std::optional<std::size_t> getVectorSize(Value vec) {
+    if (auto relax = vec.getDefiningOp<quake::RelaxSizeOp>())
+      return getVectorSize(relax.getInputVec());
+    auto vecTy = vec.getType().cast<quake::QVecType>();
+    if (!vecTy.hasSpecifiedSize())
+      return std::nullopt;
+    return vecTy.getSize();
+  }
+
+  std::optional<SmallVector<unsigned>> getLogicals(Value vec) {
+    auto qubit = resolver.resolveVector(vec);
+    auto size = getVectorSize(vec);
+    if (!qubit || !qubit->fresh || !size)
+      return std::nullopt;
+    auto iter = firstQubits.find(qubit->root);
+    if (iter == firstQubits.end())
+      return std::nullopt;
+    SmallVector<unsigned> qubits;
+    for (std::size_t i = 0; i < *size; i++)
+      qubits.push_back(iter->second + *qubit->index + i);
+    return qubits;
+  }
+
+  LogicalResult collect() {
+    if (!func.getBody().hasOneBlock())
+      return func.emitOpError("must not have control flow to map its qubits, "
+                              "its loops must be unrolled first");
+    if (llvm::any_of(func.getArgumentTypes(), isQuantum))
+      return func.emitOpError("must not have quantum arguments to map its "
+                              "qubits");
+
+    auto &block = func.getBody().front();
+    DenseMap<Operation *, unsigned> nodeIndices;
+    DenseMap<unsigned, unsigned> lastOnQubit;
+    std::optional<unsigned> lastEffect;
+    for (auto &op : block.without_terminator()) {
+      if (auto alloca = dyn_cast<quake::AllocaOp>(op)) {
+        std::size_t size = 1;
+        if (auto vecTy = alloca.getType().dyn_cast<quake::QVecType>()) {
+          if (!vecTy.hasSpecifiedSize())
+            return alloca.emitOpError("must have a known size to map its "
+                                      "qubits");
+          size = vecTy.getSize();
+        }
+        firstQubits[alloca.getResult()] = numLogical;
+        numLogical += size;
+        references.push_back(&op);
+        continue;
+      }
+      if (auto size = dyn_cast<quake::QVecSizeOp>(op)) {
+        auto value = getVectorSize(size.getQvec());
+        if (!value)
+          return size.emitOpError("must have a known size to map its qubits");
+        OpBuilder builder(size);
+        Value constant;
+        if (size.getType().isa<IndexType>())
+          constant =
+              builder.create<arith::ConstantIndexOp>(size.getLoc(), *value);
+        else
+          constant = builder.create<arith::ConstantIntOp>(
+              size.getLoc(), *value, size.getType());
+        size.replaceAllUsesWith(constant);
+        references.push_back(&op);
+        continue;
+      }
+      if (isa<quake::ConcatOp, quake::DeallocOp, quake::QExtractOp,
+              quake::RelaxSizeOp, quake::SubVecOp>(op)) {
+        deallocates |= isa<quake::DeallocOp>(op);
+        references.push_back(&op);
+        continue;
+      }
+
+      const unsigned index = nodes.size();
+      Node node{&op};
+      for (auto operand : op.getOperands()) {
+        if (operand.getType().isa<quake::QRefType>()) {
+          auto qubit = getLogical(operand);
+          if (!qubit)
+            return op.emitOpError("must act on qubits extracted at constant "
+                                  "indices to map them");
+          if (!llvm::is_contained(node.qubits, *qubit))
+            node.qubits.push_back(*qubit);
+        } else if (operand.getType().isa<quake::QVecType>()) {
+          auto qubits = getLogicals(operand);
+          if (!qubits)
+            return op.emitOpError("must act on vectors of a known size to "
+                                  "map their qubits");
+          for (auto qubit : *qubits)
+            if (!llvm::is_contained(node.qubits, qubit))
+              node.qubits.push_back(qubit);
+        }
+      }
+      if (llvm::any_of(op.getResultTypes(), isQuantum))
+        return op.emitOpError("cannot be mapped to the device qubits");
+      SmallVector<unsigned> predecessors;
+      auto walk = op.walk([&](Operation *nested) {
+        if (nested != &op &&
+            (llvm::any_of(nested->getOperandTypes(), isQuantum) ||
+             llvm::any_of(nested->getResultTypes(), isQuantum)))
+          return WalkResult::interrupt();
+        for (auto operand : nested->getOperands())
+          if (auto *def = operand.getDefiningOp())
+            if (auto *ancestor = block.findAncestorOpInBlock(*def))
+              if (auto iter = nodeIndices.find(ancestor);
+                  iter != nodeIndices.end())
+                predecessors.push_back(iter->second);
+        return WalkResult::advance();
+      });
+      if (walk.wasInterrupted())
+        return op.emitOpError("must not use qubits in its regions to map "
+                              "them");
+      if (isa<quake::OperatorInterface>(op)) {
+        if (node.qubits.size() > 2)
+          return op.emitOpError("must be decomposed into gates on at most "
+                                "two qubits to map its qubits");
+        node.isTwoQubitGate = node.qubits.size() == 2;
+      }
+
+      // Operations on the same qubit, and classical operations with side
+      // effects, keep their order.
+      for (auto qubit : node.qubits) {
+        if (auto iter = lastOnQubit.find(qubit); iter != lastOnQubit.end())
+          predecessors.push_back(iter->second);
+        lastOnQubit[qubit] = index;
+      }
+      if (node.qubits.empty() && !isMemoryEffectFree(&op)) {
+        if (lastEffect)
+          predecessors.push_back(*lastEffect);
+        lastEffect = index;
+      }
+      llvm::sort(predecessors);
+      predecessors.erase(std::unique(predecessors.begin(), predecessors.end()),
+                         predecessors.end());
+      for (auto predecessor : predecessors)
+        nodes[predecessor].successors.push_back(index);
+      node.predecessors = std::move(predecessors);
+      nodes.push_back(std::move(node));
+      nodeIndices[&op] = index;
+    }
+    return success();
+  }
+
+  /// Move the operations of the kernel to the end of its block in the order
+  /// of `steps`, on the device qubits, starting from `layout`.
+  void rewrite(Layout layout, ArrayRef<Step> steps) {
+    auto &block = func.getBody().front();
+    auto *terminator = block.getTerminator();
+    auto loc = func.getLoc();
+    OpBuilder builder(&block, block.begin());
+    auto deviceQubits = builder.create<quake::AllocaOp>(loc, device.size());
+    SmallVector<Value> refs(device.size());
+    auto getRef = [&](unsigned physical) {
+      if (!refs[physical]) {
+        OpBuilder::InsertionGuard guard(builder);
+        builder.setInsertionPointAfter(deviceQubits);
+        auto index = builder.create<arith::ConstantIntOp>(loc, physical, 64);
+        refs[physical] =
+            builder.create<quake::QExtractOp>(loc, deviceQubits, index);
+      }
+      return refs[physical];
+    };
+
+    for (auto &step : steps) {
+      if (!step.node) {
+        builder.setInsertionPoint(terminator);
+        builder.create<quake::SwapOp>(
+            loc, ValueRange{}, ValueRange{getRef(step.a), getRef(step.b)});
+        layout.swap(step.a, step.b);
+        continue;
+      }
+      auto *op = nodes[*step.node].op;
+      op->moveBefore(terminator);
+      builder.setInsertionPoint(op);
+      for (auto &operand : op->getOpOperands()) {
+        auto value = operand.get();
+        if (value.getType().isa<quake::QRefType>()) {
+          operand.set(getRef(layout.toPhysical[*getLogical(value)]));
+        } else if (value.getType().isa<quake::QVecType>()) {
+          SmallVector<Value> qubits;
+          for (auto qubit : *getLogicals(value))
+            qubits.push_back(getRef(layout.toPhysical[qubit]));
+          operand.set(builder.create<quake::ConcatOp>(
+              op->getLoc(), value.getType(), qubits));
+        }
+      }
+    }
+
+    for (auto *op : llvm::reverse(references))
+      op->erase();
+    if (deallocates) {
+      builder.setInsertionPoint(terminator);
+      builder.create<quake::DeallocOp>(loc, deviceQubits);
+    }
+
+    // Record where the logical qubits end up, for the measurements that are
+    // appended to the kernel later on.
+    SmallVector<std::int64_t> finalLayout;
+    for (auto physical : layout.toPhysical) {
+      getRef(physical);
+      finalLayout.push_back(physical);
+    }
+    func->setAttr(cudaq::qubitLayoutAttrName,
+                  builder.getDenseI64ArrayAttr(finalLayout));
+  }
+};
+
+struct QuakeQubitMapping
+    : public cudaq::opt::QuakeQubitMappingBase<QuakeQubitMapping> {
+  QuakeQubitMapping() = default;
+  QuakeQubitMapping(StringRef map) { couplingMap = map.str(); }
+
+  void runOnOperation() override {
+    auto func = getOperation();
+    if (func.empty() || couplingMap.empty() ||
+        !func->hasAttr(cudaq::entryPointAttrName))
+      return;
+    auto device = CouplingMap::parse(couplingMap);
+    if (!device || !device->isConnected()) {
+      func.emitOpError("cannot be mapped on the coupling map '")
+          << couplingMap << "', which must be a connected list of edges";
+      signalPassFailure();
+      return;
+    }
+    QubitMapper mapper(func, *device);
+    if (failed(mapper.run()))
+      signalPassFailure();
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeQubitMappingPass() {
+  return std::make_unique<QuakeQubitMapping>();
+}
+
+std::unique_ptr<Pass>
+cudaq::opt::createQuakeQubitMappingPass(llvm::StringRef couplingMap) {
+  return std::make_unique<QuakeQubitMapping>(couplingMap);
+}
@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "PassDetails.h"
+#include "QubitResolver.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include <limits>
+#include <numeric>
+
+using namespace mlir;
+
+namespace {
+
+/// A qubit allocated in the entry block of the kernel: a single qubit, or a
+/// qubit of a vector whose qubits are all extracted at constant indices. Its
+/// lifetime spans the operations of the entry block from `first` to `last`.
+struct LogicalQubit {
+  /// The references to the qubit, the allocation or its extractions.
+  SmallVector<Value> refs;
+  unsigned first = std::numeric_limits<unsigned>::max();
+  unsigned last = 0;
+  /// Whether the qubit may be reused once its lifetime ends. A qubit
+  /// measured without a register name is not, its bit is sampled from the
+  /// final state.
+  bool releasable = true;
+};
+
+/// Return true if `type` is a qubit or a vector of qubits.
+static bool isQuantum(Type type) {
+  return type.isa<quake::QRefType, quake::QVecType>();
+}
+
+struct QuakeQubitReuse
+    : public cudaq::opt::QuakeQubitReuseBase<QuakeQubitReuse> {
+  void runOnOperation() override {
+    // Only the kernels executed shot by shot collapse the state at each
+    // measurement and reset, the others sample all their measurements from
+    // the final state.
+    auto func = getOperation();
+    if (func.empty() || !func.getBody().hasOneBlock() ||
+        !func->hasAttr("qubitMeasurementFeedback"))
+      return;
+
+    auto &block = func.getBody().front();
+    SmallVector<Operation *> ops;
+    DenseMap<Operation *, unsigned> positions;
+    for (auto &op : block) {
+      positions[&op] = ops.size();
+      ops.push_back(&op);
+    }
+    auto positionOf = [&](Operation *op) {
+      while (op->getBlock() != &block)
+        op = op->getParentOp();
+      return positions[op];
+    };
+
+    SmallVector<LogicalQubit> qubits;
+    SmallVector<quake::AllocaOp> allocas;
+    for (auto alloca : block.getOps<quake::AllocaOp>()) {
+      auto allocaQubits = getQubits(alloca);
+      if (!allocaQubits)
+        continue;
+      allocas.push_back(alloca);
+      for (auto &qubit : *allocaQubits) {
+        for (auto ref : qubit.refs)
+          for (auto *user : ref.getUsers()) {
+            if (isa<quake::DeallocOp>(user))
+              continue;
+            auto position = positionOf(user);
+            qubit.first = std::min(qubit.first, position);
+            qubit.last = std::max(qubit.last, position);
+            if (isa<quake::MxOp, quake::MyOp, quake::MzOp>(user))
+              qubit.releasable &= user->hasAttr("registerName");
+          }
+        if (qubit.first > qubit.last)
+          qubit.first = qubit.last = positions[alloca];
+        qubits.push_back(std::move(qubit));
+      }
+    }
+
+    // Assign the qubits, in the order their lifetimes start, to the first
+    // qubit of the kernel free by then.
+    SmallVector<unsigned> order(qubits.size());
+    std::iota(order.begin(), order.end(), 0);
+    llvm::stable_sort(order, [&](unsigned a, unsigned b) {
+      return qubits[a].first < qubits[b].first;
+    });
+    constexpr unsigned never = std::numeric_limits<unsigned>::max();
+    SmallVector<unsigned> freeAfter;
+    SmallVector<unsigned> slots(qubits.size());
+    SmallVector<bool> resets(qubits.size(), false);
+    for (auto i : order) {
+      auto &qubit = qubits[i];
+      auto *slot = llvm::find_if(
+          freeAfter, [&](unsigned end) { return end < qubit.first; });
+      resets[i] = slot != freeAfter.end();
+      if (!resets[i])
+        slot = freeAfter.insert(freeAfter.end(), 0);
+      *slot = qubit.releasable ? qubit.last : never;
+      slots[i] = slot - freeAfter.begin();
+    }
+    if (freeAfter.size() == qubits.size())
+      return;
+
+    OpBuilder builder(&block, block.begin());
+    auto loc = func.getLoc();
+    auto kernelQubits = builder.create<quake::AllocaOp>(loc, freeAfter.size());
+    SmallVector<Value> slotRefs;
+    for (std::size_t slot = 0; slot < freeAfter.size(); slot++) {
+      auto index = builder.create<arith::ConstantIntOp>(loc, slot, 64);
+      slotRefs.push_back(
+          builder.create<quake::QExtractOp>(loc, kernelQubits, index));
+    }
+    for (auto iter : llvm::enumerate(qubits)) {
+      auto slotRef = slotRefs[slots[iter.index()]];
+      if (resets[iter.index()]) {
+        builder.setInsertionPoint(ops[iter.value().first]);
+        builder.create<quake::ResetOp>(loc, slotRef);
+      }
+      for (auto ref : iter.value().refs)
+        ref.replaceUsesWithIf(slotRef, [](OpOperand &use) {
+          return !isa<quake::DeallocOp>(use.getOwner());
+        });
+    }
+
+    bool deallocates = false;
+    for (auto alloca : allocas) {
+      for (auto *user : llvm::make_early_inc_range(alloca->getUsers())) {
+        for (auto *extractUser :
+             llvm::make_early_inc_range(user->getUsers())) {
+          deallocates = true;
+          extractUser->erase();
+        }
+        deallocates |= isa<quake::DeallocOp>(user);
+        user->erase();
+      }
+      alloca.erase();
+    }
+    if (deallocates) {
+      builder.setInsertionPoint(block.getTerminator());
+      builder.create<quake::DeallocOp>(loc, kernelQubits);
+    }
+    if (auto required = func->getAttrOfType<IntegerAttr>("requiredQubits"))
+      func->setAttr("requiredQubits",
+                    builder.getI64IntegerAttr(required.getInt() -
+                                              qubits.size() +
+                                              freeAfter.size()));
+  }
+
+  /// Return the qubits of `alloca`, or nullopt if they cannot be renumbered:
+  /// the allocation is of a vector not only used through constant indices,
+  /// or a reference to one of its qubits is used to build another one.
+  static std::optional<SmallVector<LogicalQubit>>
+  getQubits(quake::AllocaOp alloca) {
+    SmallVector<LogicalQubit> qubits;
+    if (alloca.getType().isa<quake::QRefType>()) {
+      qubits.emplace_back();
+      qubits.back().refs.push_back(alloca);
+    } else {
+      auto vecTy = alloca.getType().cast<quake::QVecType>();
+      if (!vecTy.hasSpecifiedSize())
+        return std::nullopt;
+      qubits.resize(vecTy.getSize());
+      for (auto *user : alloca->getUsers()) {
+        if (isa<quake::DeallocOp>(user))
+          continue;
+        auto extract = dyn_cast<quake::QExtractOp>(user);
+        if (!extract)
+          return std::nullopt;
+        auto index = cudaq::opt::getConstantIndex(extract.getIndex());
+        if (!index || *index < 0 ||
+            static_cast<std::size_t>(*index) >= vecTy.getSize())
+          return std::nullopt;
+        qubits[*index].refs.push_back(extract);
+      }
+    }
+    for (auto &qubit : qubits)
+      for (auto ref : qubit.refs)
+        for (auto *user : ref.getUsers())
+          if (llvm::any_of(user->getResultTypes(), isQuantum))
+            return std::nullopt;
+    return qubits;
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeQubitReusePass() {
+  return std::make_unique<QuakeQubitReuse>();
+}
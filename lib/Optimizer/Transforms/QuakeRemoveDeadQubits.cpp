@@ -0,0 +1,113 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "PassDetails.h"
+#include "QubitResolver.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+
+using namespace mlir;
+
+namespace {
+
+/// Remove the qubits of `alloca` that are never used.
+static void removeDeadQubits(quake::AllocaOp alloca) {
+  for (auto *user : llvm::make_early_inc_range(alloca->getUsers()))
+    if (isa<quake::QExtractOp>(user) && user->use_empty())
+      user->erase();
+
+  // The qubits of a vector can only be renumbered if they are all used
+  // through a constant index.
+  SmallVector<quake::QExtractOp> extracts;
+  SmallVector<quake::DeallocOp> deallocs;
+  SmallVector<std::int64_t> indices;
+  for (auto *user : alloca->getUsers()) {
+    if (auto dealloc = dyn_cast<quake::DeallocOp>(user)) {
+      deallocs.push_back(dealloc);
+      continue;
+    }
+    auto extract = dyn_cast<quake::QExtractOp>(user);
+    if (!extract)
+      return;
+    auto index = cudaq::opt::getConstantIndex(extract.getIndex());
+    if (!index || *index < 0)
+      return;
+    extracts.push_back(extract);
+    indices.push_back(*index);
+  }
+
+  if (extracts.empty()) {
+    for (auto dealloc : deallocs)
+      dealloc.erase();
+    alloca.erase();
+    return;
+  }
+
+  auto vecTy = alloca.getType().dyn_cast<quake::QVecType>();
+  if (!vecTy || !vecTy.hasSpecifiedSize())
+    return;
+  llvm::sort(indices);
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+  if (indices.size() == vecTy.getSize() ||
+      static_cast<std::size_t>(indices.back()) >= vecTy.getSize())
+    return;
+
+  // Allocate only the used qubits, in the same order.
+  OpBuilder builder(alloca);
+  auto newAlloca =
+      builder.create<quake::AllocaOp>(alloca.getLoc(), indices.size());
+  for (auto extract : extracts) {
+    auto oldIndex = *cudaq::opt::getConstantIndex(extract.getIndex());
+    auto newIndex = llvm::lower_bound(indices, oldIndex) - indices.begin();
+    builder.setInsertionPoint(extract);
+    auto indexTy = extract.getIndex().getType();
+    Value index;
+    if (indexTy.isa<IndexType>())
+      index = builder.create<arith::ConstantIndexOp>(extract.getLoc(),
+                                                     newIndex);
+    else
+      index = builder.create<arith::ConstantIntOp>(extract.getLoc(), newIndex,
+                                                   indexTy);
+    extract.getQvecMutable().assign(newAlloca);
+    extract.getIndexMutable().assign(index);
+  }
+  for (auto dealloc : deallocs)
+    dealloc.getQregOrVecMutable().assign(newAlloca);
+  alloca.erase();
+}
+
+struct QuakeRemoveDeadQubits
+    : public cudaq::opt::QuakeRemoveDeadQubitsBase<QuakeRemoveDeadQubits> {
+  void runOnOperation() override {
+    // A kernel without measurements is sampled by measuring all its qubits,
+    // removing one would change the width of the bit strings.
+    auto func = getOperation();
+    bool measures = false;
+    func.walk([&](Operation *op) {
+      if (isa<quake::MxOp, quake::MyOp, quake::MzOp>(op)) {
+        measures = true;
+        return WalkResult::interrupt();
+      }
+      return WalkResult::advance();
+    });
+    if (!measures)
+      return;
+
+    SmallVector<quake::AllocaOp> allocas;
+    func.walk(
+        [&](quake::AllocaOp alloca) { allocas.push_back(alloca); });
+    for (auto alloca : allocas)
+      removeDeadQubits(alloca);
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeRemoveDeadQubitsPass() {
+  return std::make_unique<QuakeRemoveDeadQubits>();
+}
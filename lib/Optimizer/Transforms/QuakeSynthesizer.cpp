@@ -73,6 +73,41 @@ void synthesizeRuntimeArgument(
   argument.replaceAllUsesWith(runtimeArg);
 }
 
+/// Vectors with more elements are synthesized into a global constant array,
+/// instead of a constant per element.
+static constexpr std::size_t maxScalarizedVectorSize = 16;
+
+/// Replace the vector BlockArgument with a `cc.stdvec_init` of a private
+/// global constant array holding the elements of \p vec. All the uses of the
+/// argument remain valid, including loads at dynamic indices.
+void synthesizeVectorArgumentAsGlobal(OpBuilder &builder,
+                                      BlockArgument &argument,
+                                      const std::string &name,
+                                      const std::vector<double> &vec) {
+  auto loc = builder.getUnknownLoc();
+  auto f64Ty = builder.getF64Type();
+  auto arrayTy = LLVM::LLVMArrayType::get(f64Ty, vec.size());
+  auto module = argument.getOwner()->getParentOp()->getParentOfType<ModuleOp>();
+  {
+    OpBuilder::InsertionGuard guard(builder);
+    builder.setInsertionPointToStart(module.getBody());
+    auto values = DenseElementsAttr::get(
+        RankedTensorType::get({static_cast<std::int64_t>(vec.size())}, f64Ty),
+        ArrayRef<double>(vec));
+    builder.create<LLVM::GlobalOp>(loc, arrayTy, /*isConstant=*/true,
+                                   LLVM::Linkage::Private, name, values,
+                                   /*alignment=*/0);
+  }
+  Value address = builder.create<LLVM::AddressOfOp>(
+      loc, LLVM::LLVMPointerType::get(arrayTy), name);
+  Value data = builder.create<LLVM::BitcastOp>(
+      loc, LLVM::LLVMPointerType::get(f64Ty), address);
+  Value size = builder.create<arith::ConstantIntOp>(loc, vec.size(), 64);
+  Value stdvec = builder.create<cudaq::cc::StdvecInitOp>(
+      loc, argument.getType(), data, size);
+  argument.replaceAllUsesWith(stdvec);
+}
+
 LogicalResult synthesizeVectorArgument(OpBuilder &builder,
                                        BlockArgument &argument,
                                        std::vector<double> &vec) {
@@ -153,8 +188,8 @@ void QuakeSynthesizer::runOnOperation() {
     auto builder = OpBuilder::atBlockBegin(&funcOp.getBody().front());
     auto arguments = funcOp.getArguments();
 
-    // Keep track of the stdVec sizes.
-    std::vector<std::size_t> stdVecSizes;
+    // Keep track of the stdVec arguments and their sizes.
+    std::vector<std::pair<std::size_t, std::size_t>> stdVecSizes;
 
     // For each argument, get the type and synthesize
     // the runtime constant value.
@@ -206,7 +241,7 @@ void QuakeSynthesizer::runOnOperation() {
         std::size_t vectorSize = *(std::size_t *)(((char *)args) + offset);
         vectorSize /= sizeof(double);
         offset += sizeof(std::size_t);
-        stdVecSizes.push_back(vectorSize);
+        stdVecSizes.emplace_back(argument.getArgNumber(), vectorSize);
       } else {
         type.dump();
         TODO("We cannot synthesize this type of argument yet.");
@@ -214,11 +249,25 @@ void QuakeSynthesizer::runOnOperation() {
     }
 
     // For any std vec arguments, we now know the sizes
-    // let's replace the block arg with the actual vector element data.
-    for (std::size_t idx = 0; auto &stdVecSize : stdVecSizes) {
-      double *ptr = (double *)(((char *)args) + offset);
+    // let's replace the block arg with the actual vector element data. The
+    // data of each vector follows a pointer slot. A non-null slot points to
+    // the data of the caller's vector, which was not copied.
+    for (auto [idx, stdVecSize] : stdVecSizes) {
+      void *reference;
+      std::memcpy(&reference, ((char *)args) + offset, sizeof(void *));
+      offset += sizeof(void *);
+      double *ptr = reference ? (double *)reference
+                              : (double *)(((char *)args) + offset);
+      if (!reference)
+        offset += stdVecSize * sizeof(double);
       std::vector<double> v(ptr, ptr + stdVecSize);
-      if (failed(synthesizeVectorArgument(builder, arguments[idx++], v))) {
+      if (v.size() > maxScalarizedVectorSize) {
+        synthesizeVectorArgumentAsGlobal(
+            builder, arguments[idx],
+            funcOp.getName().str() + ".arg" + std::to_string(idx), v);
+        continue;
+      }
+      if (failed(synthesizeVectorArgument(builder, arguments[idx], v))) {
         emitError(module.getLoc(), "Quake Synthesis failed for stdvec type.\n");
         signalPassFailure();
       }
@@ -0,0 +1,136 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+///
+/// This file declares `QubitResolver`, which identifies the qubits that the
+/// Quake references of a kernel refer to, for the passes that track the gates
+/// on each qubit of a block.
+///
+/// A qubit is identified by its root, the vector (or single qubit) allocated
+/// by the kernel or passed to it as an argument, and its index in the root.
+/// Allocations never alias, but distinct arguments may be the same qubits, so
+/// if a kernel has more than one quantum argument all the qubits of its
+/// arguments share the same key.
+
+#pragma once
+
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/Matchers.h"
+
+namespace cudaq::opt {
+
+/// The key of a qubit, see Qubit::getKey().
+using QubitKey = std::pair<mlir::Value, std::int64_t>;
+
+inline std::optional<std::int64_t> getConstantIndex(mlir::Value value) {
+  llvm::APInt index;
+  if (mlir::matchPattern(value, mlir::m_ConstantInt(&index)))
+    return index.getSExtValue();
+  return std::nullopt;
+}
+
+/// A qubit, as its root and its index in it.
+struct Qubit {
+  mlir::Value root;
+  std::optional<std::int64_t> index;
+  /// Whether no other root can alias `root`: it is allocated by the kernel,
+  /// or it is the only quantum argument of the kernel.
+  bool fresh = false;
+
+  /// Return the key of the qubit, the same for all the qubits of the
+  /// arguments that may alias each other. The index must be known.
+  QubitKey getKey() const {
+    if (!fresh)
+      return {mlir::Value(), 0};
+    return {root, *index};
+  }
+
+  bool operator==(const Qubit &other) const {
+    return root == other.root && index == other.index;
+  }
+};
+
+class QubitResolver {
+public:
+  QubitResolver(mlir::func::FuncOp func) : kernel(func) {
+    std::size_t quantumArgs = 0;
+    for (auto arg : func.getArguments())
+      if (arg.getType().isa<quake::QRefType, quake::QVecType>())
+        quantumArgs++;
+    argsMayAlias = quantumArgs > 1;
+  }
+
+  /// Return the root and offset of a vector, or nullopt if it is not known.
+  std::optional<Qubit> resolveVector(mlir::Value vec) {
+    if (auto relax = vec.getDefiningOp<quake::RelaxSizeOp>())
+      return resolveVector(relax.getInputVec());
+    if (auto sub = vec.getDefiningOp<quake::SubVecOp>()) {
+      auto parent = resolveVector(sub.getQvec());
+      auto low = getConstantIndex(sub.getLow());
+      if (!parent || !low)
+        return std::nullopt;
+      parent->index = *parent->index + *low;
+      return parent;
+    }
+    if (vec.getDefiningOp<quake::AllocaOp>())
+      return Qubit{vec, 0, true};
+    if (isKernelArgument(vec))
+      return Qubit{vec, 0, !argsMayAlias};
+    return std::nullopt;
+  }
+
+  /// Return the qubit a reference refers to, without an index if it is not
+  /// known, or nullopt if the reference could be any qubit.
+  std::optional<Qubit> resolve(mlir::Value ref) {
+    if (auto extract = ref.getDefiningOp<quake::QExtractOp>()) {
+      auto qubit = resolveVector(extract.getQvec());
+      if (!qubit)
+        return std::nullopt;
+      auto index = getConstantIndex(extract.getIndex());
+      qubit->index =
+          index ? std::optional<std::int64_t>(*qubit->index + *index)
+                : std::nullopt;
+      return qubit;
+    }
+    if (ref.getDefiningOp<quake::AllocaOp>())
+      return Qubit{ref, 0, true};
+    if (isKernelArgument(ref)) {
+      if (argsMayAlias)
+        return Qubit{ref, std::nullopt, false};
+      return Qubit{ref, 0, true};
+    }
+    return std::nullopt;
+  }
+
+  /// Return true if `value`, a qubit or a vector of qubits, may refer to the
+  /// qubit of `key`.
+  bool mayReferTo(mlir::Value value, QubitKey key) {
+    bool isRef = value.getType().isa<quake::QRefType>();
+    if (!isRef && !value.getType().isa<quake::QVecType>())
+      return false;
+    auto qubit = isRef ? resolve(value) : resolveVector(value);
+    if (!qubit)
+      return true;
+    if (!qubit->fresh)
+      return !key.first;
+    if (isRef && qubit->index)
+      return key == qubit->getKey();
+    return key.first == qubit->root;
+  }
+
+private:
+  mlir::func::FuncOp kernel;
+  bool argsMayAlias = false;
+
+  bool isKernelArgument(mlir::Value value) {
+    auto arg = value.dyn_cast<mlir::BlockArgument>();
+    return arg && arg.getOwner() == &kernel.getBody().front();
+  }
+};
+
+} // namespace cudaq::opt
@@ -0,0 +1,446 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "cudaq/Optimizer/Transforms/ResourceEstimate.h"
+#include "PassDetails.h"
+#include "QubitResolver.h"
+#include "cudaq/Optimizer/Dialect/CC/CCOps.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include "llvm/Support/raw_ostream.h"
+
+using namespace mlir;
+using cudaq::opt::QubitKey;
+using cudaq::opt::QubitResolver;
+using cudaq::opt::ResourceCount;
+using cudaq::opt::ResourceEstimate;
+
+ResourceCount &ResourceCount::operator+=(const ResourceCount &other) {
+  for (auto &[monomial, coefficient] : other.terms)
+    terms[monomial] += coefficient;
+  return *this;
+}
+
+ResourceCount ResourceCount::operator*(const ResourceCount &other) const {
+  ResourceCount result;
+  for (auto &[a, x] : terms)
+    for (auto &[b, y] : other.terms) {
+      Monomial product;
+      std::merge(a.begin(), a.end(), b.begin(), b.end(),
+                 std::back_inserter(product));
+      result.terms[product] += x * y;
+    }
+  return result;
+}
+
+ResourceCount ResourceCount::max(const ResourceCount &a,
+                                 const ResourceCount &b) {
+  // The symbols are non-negative, a count is at least another one if none of
+  // its coefficients is smaller.
+  auto atLeast = [](const ResourceCount &x, const ResourceCount &y) {
+    return llvm::all_of(y.terms, [&](auto &term) {
+      auto iter = x.terms.find(term.first);
+      return iter != x.terms.end() && iter->second >= term.second;
+    });
+  };
+  if (atLeast(a, b))
+    return a;
+  if (atLeast(b, a))
+    return b;
+  ResourceCount result = a;
+  for (auto &[monomial, coefficient] : b.terms) {
+    auto &term = result.terms[monomial];
+    term = std::max(term, coefficient);
+  }
+  return result;
+}
+
+void ResourceCount::print(llvm::raw_ostream &os) const {
+  if (terms.empty()) {
+    os << 0;
+    return;
+  }
+  llvm::interleave(
+      terms, os,
+      [&](auto &term) {
+        auto &[monomial, coefficient] = term;
+        if (monomial.empty() || coefficient != 1) {
+          os << coefficient;
+          if (!monomial.empty())
+            os << '*';
+        }
+        llvm::interleave(monomial, os, "*");
+      },
+      " + ");
+}
+
+void ResourceEstimate::print(llvm::raw_ostream &os) const {
+  auto printCount = [&](StringRef name, const ResourceCount &count) {
+    os << "  " << name << ": ";
+    count.print(os);
+    os << '\n';
+  };
+  printCount("qubits", qubits);
+  printCount("gates", gates);
+  printCount("two-qubit gates", twoQubitGates);
+  printCount("measurements", measurements);
+  printCount("depth", depth);
+  for (auto &[name, count] : gateCounts)
+    printCount("gate " + name, count);
+}
+
+namespace {
+
+/// Return the number of qubits of the gates named `name` in the gate counts,
+/// or nullopt if it is not known.
+static std::optional<std::size_t> getNumQubits(StringRef name) {
+  if (name.startswith("mc"))
+    return std::nullopt;
+  std::size_t controls = name.size() - name.ltrim('c').size();
+  name = name.drop_front(controls);
+  if (name == "unitary")
+    return std::nullopt;
+  return controls + (name == "swap" ? 2 : 1);
+}
+
+/// Add `times` times the counts of `other` to those of `result`. The qubits
+/// are added once: the qubits allocated by a loop body or a callee are
+/// deallocated at its end.
+static void accumulate(ResourceEstimate &result, const ResourceEstimate &other,
+                       const ResourceCount &times) {
+  result.qubits += other.qubits;
+  result.gates += other.gates * times;
+  result.twoQubitGates += other.twoQubitGates * times;
+  result.measurements += other.measurements * times;
+  for (auto &[name, count] : other.gateCounts)
+    result.gateCounts[name] += count * times;
+}
+
+/// Return an upper bound of the resources of either `a` or `b`.
+static ResourceEstimate maxOf(const ResourceEstimate &a,
+                              const ResourceEstimate &b) {
+  ResourceEstimate result;
+  result.qubits = ResourceCount::max(a.qubits, b.qubits);
+  result.gates = ResourceCount::max(a.gates, b.gates);
+  result.twoQubitGates = ResourceCount::max(a.twoQubitGates, b.twoQubitGates);
+  result.measurements = ResourceCount::max(a.measurements, b.measurements);
+  result.depth = ResourceCount::max(a.depth, b.depth);
+  result.gateCounts = a.gateCounts;
+  for (auto &[name, count] : b.gateCounts)
+    result.gateCounts[name] = ResourceCount::max(result.gateCounts[name], count);
+  return result;
+}
+
+/// Return the quantum values used in the regions of `op` and defined outside
+/// of them.
+static SmallVector<Value> getQuantumUses(Operation *op) {
+  SmallVector<Value> values;
+  op->walk([&](Operation *nested) {
+    for (auto value : nested->getOperands())
+      if (value.getType().isa<quake::QRefType, quake::QVecType>() &&
+          !op->isAncestor(value.getParentRegion()->getParentOp()) &&
+          !llvm::is_contained(values, value))
+        values.push_back(value);
+  });
+  return values;
+}
+
+/// The depth of the operations of a region, as the number of layers of
+/// operations on each qubit. The layers of the operations on qubits that are
+/// not known, or on whole vectors, are barriers on all the qubits.
+class Layers {
+public:
+  Layers(QubitResolver &resolver) : resolver(resolver) {}
+
+  /// Add a layer of depth `depth` on `qubits`.
+  void add(ValueRange qubits, const ResourceCount &depth) {
+    SmallVector<QubitKey> keys;
+    for (auto value : qubits) {
+      std::optional<cudaq::opt::Qubit> qubit;
+      if (value.getType().isa<quake::QRefType>())
+        qubit = resolver.resolve(value);
+      if (!qubit || !qubit->index) {
+        total += depth;
+        barrier = total;
+        depths.clear();
+        return;
+      }
+      keys.push_back(qubit->getKey());
+    }
+
+    ResourceCount start = barrier;
+    for (auto key : keys) {
+      auto iter = depths.find(key);
+      if (iter != depths.end())
+        start = ResourceCount::max(start, iter->second);
+    }
+    start += depth;
+    for (auto key : keys)
+      depths[key] = start;
+    total = ResourceCount::max(total, start);
+  }
+
+  const ResourceCount &getDepth() const { return total; }
+
+private:
+  QubitResolver &resolver;
+  DenseMap<QubitKey, ResourceCount> depths;
+  ResourceCount barrier;
+  ResourceCount total;
+};
+
+/// Estimates the resources of the kernels of a module. The symbols of the
+/// counts are shared by all the kernels estimated.
+class Estimator {
+public:
+  ResourceEstimate estimate(func::FuncOp kernel, bool isEntry);
+
+  /// Return a new symbol.
+  ResourceCount getSymbol() {
+    return ResourceCount::getSymbol("n" + std::to_string(numSymbols++));
+  }
+
+  /// Return true if `kernel` is being estimated.
+  bool isActive(func::FuncOp kernel) {
+    return llvm::is_contained(active, kernel);
+  }
+
+private:
+  SmallVector<func::FuncOp> active;
+  unsigned numSymbols = 0;
+};
+
+/// Estimates the resources of a kernel.
+class KernelEstimator {
+public:
+  KernelEstimator(Estimator &estimator, func::FuncOp kernel, bool isEntry)
+      : estimator(estimator), kernel(kernel), resolver(kernel),
+        isEntry(isEntry) {}
+
+  ResourceEstimate run() { return estimate({&kernel.getBody()}); }
+
+private:
+  Estimator &estimator;
+  func::FuncOp kernel;
+  QubitResolver resolver;
+  /// Whether the arguments of the kernel are named in the symbols, which is
+  /// only meaningful for the kernel the estimate is for.
+  bool isEntry;
+
+  ResourceEstimate estimate(ArrayRef<Region *> regions) {
+    ResourceEstimate result;
+    Layers layers(resolver);
+    for (auto *region : regions)
+      for (auto &block : *region)
+        for (auto &op : block)
+          visit(&op, result, layers);
+    result.depth = layers.getDepth();
+    return result;
+  }
+
+  void visit(Operation *op, ResourceEstimate &result, Layers &layers) {
+    if (auto alloca = dyn_cast<quake::AllocaOp>(op)) {
+      result.qubits += getSize(alloca.getResult());
+      return;
+    }
+    if (auto optor = dyn_cast<quake::OperatorInterface>(op)) {
+      ResourceCount controls = getSizes(optor.getControls());
+      std::string name = op->getName().stripDialect().str();
+      addGate(result, controls, name, optor.getTargets().size());
+      SmallVector<Value> qubits(optor.getControls());
+      qubits.append(optor.getTargets().begin(), optor.getTargets().end());
+      layers.add(qubits, 1);
+      return;
+    }
+    if (auto unitary = dyn_cast<quake::UnitaryOp>(op)) {
+      addGate(result, 0, "unitary", unitary.getTargets().size());
+      layers.add(unitary.getTargets(), 1);
+      return;
+    }
+    if (auto prep = dyn_cast<quake::ProductStateOp>(op)) {
+      for (auto target : prep.getTargets()) {
+        addGate(result, 0, "product_state", 1);
+        layers.add(target, 1);
+      }
+      return;
+    }
+    if (isa<quake::MxOp, quake::MyOp, quake::MzOp>(op)) {
+      result.measurements += getSizes(op->getOperands());
+      layers.add(op->getOperands(), 1);
+      return;
+    }
+    if (auto reset = dyn_cast<quake::ResetOp>(op)) {
+      layers.add(reset.getTargets(), 1);
+      return;
+    }
+    if (auto call = dyn_cast<func::CallOp>(op)) {
+      visitCall(op, call.getCallee(), {}, result, layers);
+      return;
+    }
+    if (auto apply = dyn_cast<quake::ApplyOp>(op)) {
+      visitCall(op, apply.getCallee().getRootReference(), apply.getControls(),
+                result, layers);
+      return;
+    }
+    if (auto loop = dyn_cast<cudaq::cc::LoopOp>(op)) {
+      auto trips = getTripCount(loop);
+      auto body = estimate({&loop.getWhileRegion(), &loop.getBodyRegion(),
+                            &loop.getStepRegion()});
+      accumulate(result, body, trips);
+      layers.add(getQuantumUses(op), body.depth * trips);
+      return;
+    }
+    if (auto ifOp = dyn_cast<cudaq::cc::IfOp>(op)) {
+      auto branches = maxOf(estimate({&ifOp.getThenRegion()}),
+                            estimate({&ifOp.getElseRegion()}));
+      accumulate(result, branches, 1);
+      layers.add(getQuantumUses(op), branches.depth);
+      return;
+    }
+    for (auto &region : op->getRegions())
+      for (auto &block : region)
+        for (auto &nested : block)
+          visit(&nested, result, layers);
+  }
+
+  void addGate(ResourceEstimate &result, const ResourceCount &controls,
+               const std::string &name, std::size_t targets) {
+    std::string key =
+        controls.isConstant()
+            ? std::string(controls.getConstant(), 'c') + name
+            : "mc" + name;
+    result.gates += 1;
+    result.gateCounts[key] += 1;
+    if (controls.isConstant() && controls.getConstant() + targets == 2)
+      result.twoQubitGates += 1;
+  }
+
+  /// Add the resources of a call to `callee`, with `controls` added to all
+  /// its gates. Calls to kernels that are not defined in the module, or
+  /// recursive ones, are ignored.
+  void visitCall(Operation *op, StringRef calleeName, ValueRange controls,
+                 ResourceEstimate &result, Layers &layers) {
+    auto callee = SymbolTable::lookupNearestSymbolFrom<func::FuncOp>(
+        op, StringAttr::get(op->getContext(), calleeName));
+    if (!callee || callee.empty() || estimator.isActive(callee))
+      return;
+    auto estimate = estimator.estimate(callee, /*isEntry=*/false);
+    if (!controls.empty()) {
+      ResourceCount added = getSizes(controls);
+      std::map<std::string, ResourceCount> gateCounts;
+      estimate.twoQubitGates = 0;
+      for (auto &[name, count] : estimate.gateCounts) {
+        std::string key;
+        if (added.isConstant() && !StringRef(name).startswith("mc"))
+          key = std::string(added.getConstant(), 'c') + name;
+        else
+          key = "mc" + StringRef(name).ltrim("mc").str();
+        auto numQubits = getNumQubits(key);
+        if (numQubits && *numQubits == 2)
+          estimate.twoQubitGates += count;
+        gateCounts[key] += count;
+      }
+      estimate.gateCounts = std::move(gateCounts);
+    }
+    accumulate(result, estimate, 1);
+    SmallVector<Value> qubits;
+    for (auto operand : op->getOperands())
+      if (operand.getType().isa<quake::QRefType, quake::QVecType>())
+        qubits.push_back(operand);
+    layers.add(qubits, estimate.depth);
+  }
+
+  /// Return the number of iterations of `loop`. The loops built by the
+  /// factory (marked counted, or invariant once they could not be unrolled)
+  /// count from 0 to the bound of their condition.
+  ResourceCount getTripCount(cudaq::cc::LoopOp loop) {
+    if (loop->hasAttr("counted") || loop->hasAttr("invariant"))
+      for (auto &op : *loop.getWhileBlock())
+        if (auto compare = dyn_cast<arith::CmpIOp>(op))
+          return getValue(compare.getRhs());
+    return estimator.getSymbol();
+  }
+
+  /// Return the value of an integer, which is a symbol if it is not constant.
+  ResourceCount getValue(Value value) {
+    if (auto constant = cudaq::opt::getConstantIndex(value))
+      return std::max<std::int64_t>(*constant, 0);
+    while (auto *op = value.getDefiningOp()) {
+      if (!isa<arith::IndexCastOp, arith::ExtSIOp, arith::ExtUIOp,
+               arith::TruncIOp, cudaq::cc::StdvecSizeOp>(op)) {
+        if (auto size = dyn_cast<quake::QVecSizeOp>(op))
+          return getSize(size.getQvec());
+        break;
+      }
+      value = op->getOperand(0);
+    }
+    return getArgumentSymbol(value);
+  }
+
+  /// Return the number of qubits of `values`.
+  ResourceCount getSizes(ValueRange values) {
+    ResourceCount size;
+    for (auto value : values)
+      size += getSize(value);
+    return size;
+  }
+
+  ResourceCount getSize(Value value) {
+    auto vecTy = value.getType().dyn_cast<quake::QVecType>();
+    if (!vecTy)
+      return 1;
+    if (vecTy.hasSpecifiedSize())
+      return vecTy.getSize();
+    if (auto alloca = value.getDefiningOp<quake::AllocaOp>())
+      if (alloca.getSize())
+        return getValue(alloca.getSize());
+    if (auto relax = value.getDefiningOp<quake::RelaxSizeOp>())
+      return getSize(relax.getInputVec());
+    return getArgumentSymbol(value);
+  }
+
+  /// Return the symbol `argN` if `value` is the argument `N` of the entry
+  /// kernel (the value of an integer or the size of a vector), or a new
+  /// symbol.
+  ResourceCount getArgumentSymbol(Value value) {
+    auto arg = value.dyn_cast<BlockArgument>();
+    if (isEntry && arg && arg.getOwner() == &kernel.getBody().front())
+      return ResourceCount::getSymbol("arg" +
+                                      std::to_string(arg.getArgNumber()));
+    return estimator.getSymbol();
+  }
+};
+
+ResourceEstimate Estimator::estimate(func::FuncOp kernel, bool isEntry) {
+  active.push_back(kernel);
+  auto result = KernelEstimator(*this, kernel, isEntry).run();
+  active.pop_back();
+  return result;
+}
+
+struct QuakeResourceEstimate
+    : public cudaq::opt::QuakeResourceEstimateBase<QuakeResourceEstimate> {
+  void runOnOperation() override {
+    for (auto func : getOperation().getOps<func::FuncOp>()) {
+      if (func.empty())
+        continue;
+      llvm::outs() << "resources of @" << func.getName() << ":\n";
+      cudaq::opt::estimateResources(func).print(llvm::outs());
+    }
+  }
+};
+
+} // namespace
+
+ResourceEstimate cudaq::opt::estimateResources(func::FuncOp kernel) {
+  return Estimator().estimate(kernel, /*isEntry=*/true);
+}
+
+std::unique_ptr<Pass> cudaq::opt::createQuakeResourceEstimatePass() {
+  return std::make_unique<QuakeResourceEstimate>();
+}
@@ -0,0 +1,242 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "GateMatrix.h"
+#include "PassDetails.h"
+#include "QubitResolver.h"
+#include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include "llvm/Support/MathExtras.h"
+#include <array>
+#include <complex>
+
+using namespace mlir;
+using cudaq::opt::Qubit;
+using cudaq::opt::QubitKey;
+using cudaq::opt::QubitResolver;
+
+namespace {
+
+using Matrix = cudaq::opt::TargetMatrix;
+
+static Matrix multiply(const Matrix &a, const Matrix &b) {
+  return {a[0] * b[0] + a[1] * b[2], a[0] * b[1] + a[1] * b[3],
+          a[2] * b[0] + a[3] * b[2], a[2] * b[1] + a[3] * b[3]};
+}
+
+/// Return true if the rotation by `angle` is the identity, up to a global
+/// phase.
+static bool isIdentity(double angle) {
+  constexpr double tolerance = 1e-12;
+  double turns = std::remainder(angle, 2. * M_PI);
+  return std::abs(turns) < tolerance;
+}
+
+/// The gates a run is resynthesized into, in circuit order.
+struct NewGate {
+  enum Kind { U3, Rz, Ry, PhasedRx } kind;
+  SmallVector<double, 3> params;
+};
+
+/// Return the ZYZ Euler angles (θ, φ, λ) of `u`, such that `u` is Rz(φ)
+/// Ry(θ) Rz(λ), or u3(θ, φ, λ), up to a global phase.
+static std::array<double, 3> getEulerAngles(Matrix u) {
+  auto det = std::sqrt(u[0] * u[3] - u[1] * u[2]);
+  for (auto &element : u)
+    element /= det;
+  double theta = 2. * std::atan2(std::abs(u[2]), std::abs(u[0]));
+  double sum = std::abs(u[0]) < 1e-12 ? 0. : 2. * std::arg(u[3]);
+  double diff = std::abs(u[2]) < 1e-12 ? 0. : 2. * std::arg(u[2]);
+  return {theta, (sum + diff) / 2., (sum - diff) / 2.};
+}
+
+static SmallVector<NewGate> resynthesize(const Matrix &u, StringRef basis) {
+  auto [theta, phi, lambda] = getEulerAngles(u);
+  SmallVector<NewGate> gates;
+  bool noTheta = isIdentity(theta);
+  bool noPhase = isIdentity(phi + lambda);
+  if (basis == "u3") {
+    if (!noTheta || !noPhase)
+      gates.push_back({NewGate::U3, {theta, phi, lambda}});
+  } else if (basis == "zyz") {
+    if (noTheta) {
+      if (!noPhase)
+        gates.push_back({NewGate::Rz, {phi + lambda}});
+      return gates;
+    }
+    if (!isIdentity(lambda))
+      gates.push_back({NewGate::Rz, {lambda}});
+    gates.push_back({NewGate::Ry, {theta}});
+    if (!isIdentity(phi))
+      gates.push_back({NewGate::Rz, {phi}});
+  } else {
+    // Rz(φ) Ry(θ) Rz(λ) = PhasedRx(θ, π/2 + φ) Rz(φ + λ), and Rz(δ) is
+    // PhasedRx(π, δ/2) PhasedRx(π, 0) up to a global phase.
+    if (!noPhase) {
+      gates.push_back({NewGate::PhasedRx, {M_PI, 0.}});
+      gates.push_back({NewGate::PhasedRx, {M_PI, (phi + lambda) / 2.}});
+    }
+    if (!noTheta)
+      gates.push_back({NewGate::PhasedRx, {theta, M_PI / 2. + phi}});
+  }
+  return gates;
+}
+
+/// Collapses the runs of single-qubit gates with constant parameters of a
+/// block. A run ends at any other use of its qubit, so that its gates can all
+/// be moved to its last one.
+class RunCollapser {
+public:
+  RunCollapser(func::FuncOp func, StringRef basis)
+      : resolver(func), basis(basis) {}
+
+  void run(Block &block) {
+    for (auto &op : llvm::make_early_inc_range(block)) {
+      if (extend(&op))
+        continue;
+      if (op.getNumRegions()) {
+        flushAll();
+        continue;
+      }
+      if (isa<quake::AllocaOp, quake::ConcatOp, quake::QExtractOp,
+              quake::QVecSizeOp, quake::RelaxSizeOp, quake::SubVecOp>(op))
+        continue;
+      for (auto operand : op.getOperands()) {
+        SmallVector<QubitKey> keys;
+        for (auto &entry : runs)
+          if (resolver.mayReferTo(operand, entry.first))
+            keys.push_back(entry.first);
+        for (auto key : keys)
+          flush(key);
+      }
+    }
+    flushAll();
+  }
+
+private:
+  struct Run {
+    Qubit qubit;
+    SmallVector<Operation *> gates;
+    Matrix matrix;
+  };
+
+  QubitResolver resolver;
+  StringRef basis;
+  DenseMap<QubitKey, Run> runs;
+
+  /// Add `op` to the run of its qubit if it is a single-qubit gate with
+  /// constant parameters, return false otherwise.
+  bool extend(Operation *op) {
+    auto optor = dyn_cast<quake::OperatorInterface>(op);
+    if (!optor || !optor.getControls().empty() ||
+        optor.getTargets().size() != 1)
+      return false;
+    auto qubit = resolver.resolve(optor.getTargets()[0]);
+    if (!qubit || !qubit->index)
+      return false;
+    auto matrix = cudaq::opt::getTargetMatrix(optor);
+    if (!matrix)
+      return false;
+    auto key = qubit->getKey();
+    auto iter = runs.find(key);
+    if (iter != runs.end() && !(iter->second.qubit == *qubit)) {
+      flush(key);
+      iter = runs.end();
+    }
+    if (iter == runs.end()) {
+      runs[key] = Run{*qubit, {op}, *matrix};
+      return true;
+    }
+    iter->second.gates.push_back(op);
+    iter->second.matrix = multiply(*matrix, iter->second.matrix);
+    return true;
+  }
+
+  /// Replace the run on the qubit of `key` by its resynthesized gates, if
+  /// there are fewer of them.
+  void flush(QubitKey key) {
+    auto iter = runs.find(key);
+    if (iter == runs.end())
+      return;
+    auto run = std::move(iter->second);
+    runs.erase(iter);
+    if (run.gates.size() < 2)
+      return;
+    auto gates = resynthesize(run.matrix, basis);
+    if (gates.size() >= run.gates.size())
+      return;
+
+    auto *last = run.gates.back();
+    OpBuilder builder(last);
+    auto loc = last->getLoc();
+    Value target = cast<quake::OperatorInterface>(last).getTargets()[0];
+    for (auto &gate : gates) {
+      SmallVector<Value, 3> params;
+      for (double param : gate.params)
+        params.push_back(builder.create<arith::ConstantFloatOp>(
+            loc, APFloat(param), builder.getF64Type()));
+      switch (gate.kind) {
+      case NewGate::U3:
+        builder.create<quake::U3Op>(loc, params, ValueRange{}, target);
+        break;
+      case NewGate::Rz:
+        builder.create<quake::RzOp>(loc, params, ValueRange{}, target);
+        break;
+      case NewGate::Ry:
+        builder.create<quake::RyOp>(loc, params, ValueRange{}, target);
+        break;
+      case NewGate::PhasedRx:
+        builder.create<quake::PhasedRxOp>(loc, params, ValueRange{}, target);
+        break;
+      }
+    }
+    for (auto *op : run.gates)
+      op->erase();
+  }
+
+  void flushAll() {
+    SmallVector<QubitKey> keys;
+    for (auto &entry : runs)
+      keys.push_back(entry.first);
+    for (auto key : keys)
+      flush(key);
+  }
+};
+
+struct SingleQubitResynthesis
+    : public cudaq::opt::SingleQubitResynthesisBase<SingleQubitResynthesis> {
+  SingleQubitResynthesis() = default;
+  SingleQubitResynthesis(StringRef b) { basis = b.str(); }
+
+  void runOnOperation() override {
+    auto func = getOperation();
+    if (func.empty())
+      return;
+    if (basis != "u3" && basis != "zyz" && basis != "phased-rx") {
+      func.emitOpError("unknown single-qubit basis: " + basis);
+      signalPassFailure();
+      return;
+    }
+    SmallVector<Block *> blocks;
+    func.walk([&](Block *block) { blocks.push_back(block); });
+    RunCollapser collapser(func, basis);
+    for (auto *block : blocks)
+      collapser.run(*block);
+  }
+};
+
+} // namespace
+
+std::unique_ptr<Pass> cudaq::opt::createSingleQubitResynthesisPass() {
+  return std::make_unique<SingleQubitResynthesis>();
+}
+
+std::unique_ptr<Pass>
+cudaq::opt::createSingleQubitResynthesisPass(StringRef basis) {
+  return std::make_unique<SingleQubitResynthesis>(basis);
+}
@@ -21,23 +21,29 @@ namespace cudaq {
 
 static LogicalResult emitOperation(nlohmann::json &json, Emitter &emitter,
                                    Operation &op);
-static LogicalResult emitEntryPoint(nlohmann::json &json, Emitter &emitter,
+/// The instructions are written to the output as they are emitted, rather
+/// than collected into one JSON document, so that only one instruction of a
+/// large circuit is in memory at once.
+static LogicalResult emitEntryPoint(Emitter &emitter,
                                     qtx::CircuitOp circuitOp) {
   if (circuitOp.getBody().getBlocks().size() != 1)
     circuitOp.emitError("Cannot map qtx Circuit op with more than 1 block to "
                         "IQM Json. Must be a flat circuit representation.");
 
   Emitter::Scope scope(emitter, /*isEntryPoint=*/true);
-  json["name"] = circuitOp.getName().str();
-  std::vector<nlohmann::json> instructions;
+  emitter.os << "{\n    \"instructions\": [";
+  bool first = true;
   for (Operation &op : circuitOp.getOps()) {
     nlohmann::json instruction = nlohmann::json::object();
     if (failed(emitOperation(instruction, emitter, op)))
       return failure();
-    if (!instruction.empty())
-      instructions.push_back(instruction);
+    if (instruction.empty())
+      continue;
+    emitter.os << (first ? "\n" : ",\n") << instruction.dump(4);
+    first = false;
   }
-  json["instructions"] = instructions;
+  emitter.os << "\n    ],\n    \"name\": "
+             << nlohmann::json(circuitOp.getName().str()).dump() << "\n}";
   return success();
 }
 
@@ -54,8 +60,7 @@ static LogicalResult emitOperation(nlohmann::json &json, Emitter &emitter,
   }
   if (!entryPoint)
     return moduleOp.emitError("does not contain an entrypoint");
-  return emitEntryPoint(json, emitter, entryPoint);
-  return success();
+  return emitEntryPoint(emitter, entryPoint);
 }
 
 static LogicalResult emitOperation(nlohmann::json &json, Emitter &emitter,
@@ -154,9 +159,7 @@ mlir::LogicalResult translateToIQMJson(mlir::Operation *op,
                                        llvm::raw_ostream &os) {
   nlohmann::json j;
   Emitter emitter(os);
-  auto ret = emitOperation(j, emitter, *op);
-  os << j.dump(4);
-  return ret;
+  return emitOperation(j, emitter, *op);
 }
 
 } // namespace cudaq
@@ -45,18 +45,54 @@ static LogicalResult translateOperatorName(qtx::OperatorInterface optor,
   return success();
 }
 
+/// Print the expression of a parameter that is not a constant: an input
+/// parameter of the entry point, or arithmetic on such parameters.
+static LogicalResult printParameterExpression(Emitter &emitter, Value value) {
+  if (auto parameter = getParameterValueAsDouble(value)) {
+    emitter.os << *parameter;
+    return success();
+  }
+  if (emitter.valueToName.count(value)) {
+    emitter.os << emitter.getOrAssignName(value);
+    return success();
+  }
+  auto *op = value.getDefiningOp();
+  if (!op)
+    return failure();
+  if (auto neg = dyn_cast_if_present<arith::NegFOp>(op)) {
+    emitter.os << "-(";
+    if (failed(printParameterExpression(emitter, neg.getOperand())))
+      return failure();
+    emitter.os << ')';
+    return success();
+  }
+  StringRef symbol =
+      llvm::TypeSwitch<Operation *, StringRef>(op)
+          .Case<arith::AddFOp>([](auto) { return "+"; })
+          .Case<arith::SubFOp>([](auto) { return "-"; })
+          .Case<arith::MulFOp>([](auto) { return "*"; })
+          .Case<arith::DivFOp>([](auto) { return "/"; })
+          .Default([](Operation *) { return ""; });
+  if (symbol.empty())
+    return failure();
+  emitter.os << '(';
+  if (failed(printParameterExpression(emitter, op->getOperand(0))))
+    return failure();
+  emitter.os << ' ' << symbol << ' ';
+  if (failed(printParameterExpression(emitter, op->getOperand(1))))
+    return failure();
+  emitter.os << ')';
+  return success();
+}
+
 static LogicalResult printParameters(Emitter &emitter, ValueRange parameters) {
   if (parameters.empty())
     return success();
   emitter.os << '(';
   auto isFailure = false;
   llvm::interleaveComma(parameters, emitter.os, [&](Value value) {
-    auto parameter = getParameterValueAsDouble(value);
-    if (!parameter.has_value()) {
+    if (failed(printParameterExpression(emitter, value)))
       isFailure = true;
-      return;
-    }
-    emitter.os << *parameter;
   });
   emitter.os << ')';
   // TODO: emit error here?
@@ -83,9 +119,21 @@ static StringRef printClassicalAllocation(Emitter &emitter, Value bitOrVector) {
 
 static LogicalResult emitOperation(Emitter &emitter, Operation &op);
 
-static LogicalResult emitEntryPoint(Emitter &emitter,
-                                    qtx::CircuitOp circuitOp) {
+static LogicalResult emitEntryPoint(Emitter &emitter, qtx::CircuitOp circuitOp,
+                                    bool inputParameters) {
   Emitter::Scope scope(emitter, /*isEntryPoint=*/true);
+  if (inputParameters && circuitOp.getNumParameters()) {
+    for (auto param : circuitOp.getParameters()) {
+      auto name = emitter.createName("theta");
+      emitter.getOrAssignName(param, name);
+      if (param.getType().isa<FloatType>())
+        emitter.os << "input float[64] " << name << ";\n";
+      else
+        return circuitOp.emitError("cannot translate entry point parameter "
+                                   "of non-floating point type");
+    }
+    emitter.os << '\n';
+  }
   for (Operation &op : circuitOp.getOps()) {
     if (failed(emitOperation(emitter, op)))
       return failure();
@@ -93,12 +141,20 @@ static LogicalResult emitEntryPoint(Emitter &emitter,
   return success();
 }
 
-static LogicalResult emitOperation(Emitter &emitter, ModuleOp moduleOp) {
+/// Emit the module as OpenQASM 2.0, or as OpenQASM 3 whose entry point
+/// parameters are `input` parameters bound at execution.
+static LogicalResult emitOperation(Emitter &emitter, ModuleOp moduleOp,
+                                   bool inputParameters = false) {
   qtx::CircuitOp entryPoint = nullptr;
   // TODO: Improve header
   emitter.os << "// Code generated by NVIDIA's nvq++ compiler\n";
-  emitter.os << "OPENQASM 2.0;\n\n";
-  emitter.os << "include \"qelib1.inc\";\n\n";
+  if (inputParameters) {
+    emitter.os << "OPENQASM 3;\n\n";
+    emitter.os << "include \"stdgates.inc\";\n\n";
+  } else {
+    emitter.os << "OPENQASM 2.0;\n\n";
+    emitter.os << "include \"qelib1.inc\";\n\n";
+  }
   for (Operation &op : moduleOp) {
     if (op.hasAttr(cudaq::entryPointAttrName)) {
       if (entryPoint)
@@ -112,8 +168,7 @@ static LogicalResult emitOperation(Emitter &emitter, ModuleOp moduleOp) {
   }
   if (!entryPoint)
     return moduleOp.emitError("does not contain an entrypoint");
-  return emitEntryPoint(emitter, entryPoint);
-  return success();
+  return emitEntryPoint(emitter, entryPoint, inputParameters);
 }
 
 static LogicalResult emitOperation(Emitter &emitter, qtx::AllocaOp allocaOp) {
@@ -192,13 +247,17 @@ static LogicalResult emitOperation(Emitter &emitter, qtx::CircuitOp circuitOp) {
 
 static LogicalResult emitOperation(Emitter &emitter,
                                    qtx::OperatorInterface optor) {
-  // TODO: Handle adjoint for T and S
-  if (optor.isAdj())
-    return optor.emitError("cannot convert adjoint operations to OpenQASM 2.0");
-
   StringRef name;
-  if (failed(translateOperatorName(optor, name)))
+  if (optor.isAdj()) {
+    // The adjoints of S and T are gates of `qelib1.inc`.
+    Operation *op = optor;
+    if (!optor.getControls().empty() || !isa<qtx::SOp, qtx::TOp>(op))
+      return optor.emitError(
+          "cannot convert adjoint operations to OpenQASM 2.0");
+    name = isa<qtx::SOp>(op) ? "sdg" : "tdg";
+  } else if (failed(translateOperatorName(optor, name))) {
     return optor.emitError("cannot convert operation to OpenQASM 2.0");
+  }
   emitter.os << name << ' ';
 
   if (failed(printParameters(emitter, optor.getParameters())))
@@ -303,3 +362,12 @@ LogicalResult cudaq::translateToOpenQASM(Operation *op, raw_ostream &os) {
   Emitter emitter(os);
   return emitOperation(emitter, *op);
 }
+
+LogicalResult cudaq::translateToParameterizedOpenQASM(Operation *op,
+                                                      raw_ostream &os) {
+  auto moduleOp = dyn_cast<ModuleOp>(op);
+  if (!moduleOp)
+    return op->emitError("expected a module to translate to OpenQASM 3");
+  Emitter emitter(os);
+  return emitOperation(emitter, moduleOp, /*inputParameters=*/true);
+}
@@ -14,6 +14,7 @@
 #include "runtime/cudaq/algorithms/py_sample.h"
 #include "runtime/cudaq/algorithms/py_state.h"
 #include "runtime/cudaq/algorithms/py_vqe.h"
+#include "runtime/cudaq/builder/py_compiled_kernel.h"
 #include "runtime/cudaq/builder/py_kernel_builder.h"
 #include "runtime/cudaq/spin/py_spin_op.h"
 #include "utils/LinkedLibraryHolder.h"
@@ -88,6 +89,7 @@ PYBIND11_MODULE(_pycudaq, mod) {
       "Return true if there is a backend simulator with the given name.");
 
   cudaq::bindBuilder(mod);
+  cudaq::bindCompiledKernel(mod);
   cudaq::bindQuakeValue(mod);
   cudaq::bindObserve(mod);
   cudaq::bindObserveResult(mod);
@@ -11,6 +11,7 @@
 #include "py_NoiseModel.h"
 
 #include "common/NoiseModel.h"
+#include "common/ReadoutMitigation.h"
 #include "cudaq.h"
 
 #include <iostream>
@@ -106,7 +107,70 @@ void bindNoiseModel(py::module &mod) {
              std::vector<std::size_t> qbits) {
             return n.get_channels(op, qbits);
           },
-          "Return the KrausChannels that make up this noise model.");
+          "Return the KrausChannels that make up this noise model.")
+      .def(
+          "add_readout_error",
+          [](noise_model &n, std::size_t qubit, double p01, double p10) {
+            n.add_readout_error(qubit, p01, p10);
+          },
+          py::arg("qubit"), py::arg("p01"), py::arg("p10"),
+          "Add a readout error to the measurements of the qubit, which reads "
+          "1 instead of 0 with probability `p01`, and 0 instead of 1 with "
+          "probability `p10`.")
+      .def(
+          "add_readout_error",
+          [](noise_model &n, std::size_t qubit,
+             const std::array<double, 4> &matrix) {
+            n.add_readout_error(qubit, matrix);
+          },
+          py::arg("qubit"), py::arg("matrix"),
+          "Add a readout error to the measurements of the qubit, given as the "
+          "row major 2x2 matrix whose element (i, j) is the probability to "
+          "read j when the qubit is measured in state i.");
+
+  py::class_<readout_mitigator>(
+      mod, "ReadoutMitigator",
+      "Readout error mitigation of measurement counts, from the confusion "
+      "matrix of each qubit. The counts are corrected into "
+      "quasi-probabilities over the observed bit strings only, relating "
+      "those at most `max_distance` bit flips apart, so that the cost does "
+      "not grow as 2^n.")
+      .def(py::init<std::vector<std::array<double, 4>>, std::size_t>(),
+           py::arg("confusion_matrices"), py::kw_only(),
+           py::arg("max_distance") = 3,
+           "Create a mitigator from the confusion matrix of each qubit, as "
+           "a flat row major 2x2 matrix whose element (i, j) is the "
+           "probability to read j when the qubit is measured in state i.")
+      .def_static("from_noise_model", &readout_mitigator::from_noise_model,
+                  py::arg("noise_model"), py::arg("qubit_count"),
+                  py::kw_only(), py::arg("max_distance") = 3,
+                  "Create a mitigator from the readout errors of the first "
+                  "`qubit_count` qubits of the :class:`NoiseModel`.")
+      .def(
+          "quasi_probabilities",
+          [](const readout_mitigator &self, sample_result &result,
+             const std::vector<std::size_t> &qubits,
+             const std::string &registerName) {
+            return self.quasi_probabilities(result, qubits, registerName);
+          },
+          py::arg("result"), py::arg("qubits"),
+          py::arg("register_name") = GlobalRegisterName,
+          "Return the mitigated quasi-probabilities of the bit strings of "
+          "the register of the :class:`SampleResult`, bit j of which "
+          "measures `qubits[j]`, as a dictionary. They sum to one and may be "
+          "negative.")
+      .def(
+          "expectation_z",
+          [](const readout_mitigator &self, sample_result &result,
+             const std::vector<std::size_t> &qubits,
+             const std::string &registerName) {
+            return self.exp_val_z(result, qubits, registerName);
+          },
+          py::arg("result"), py::arg("qubits"),
+          py::arg("register_name") = GlobalRegisterName,
+          "Return the mitigated expectation value of Z...Z over the register "
+          "of the :class:`SampleResult`, bit j of which measures "
+          "`qubits[j]`.");
 
   py::class_<depolarization_channel, kraus_channel>(mod,
                                                     "DepolarizationChannel")
@@ -7,6 +7,7 @@
  *******************************************************************************/
 
 #include "py_ObserveResult.h"
+#include "utils/AsyncResult.h"
 
 #include "common/ObserveResult.h"
 #include "cudaq/algorithms/observe.h"
@@ -27,6 +28,9 @@ void bindObserveResult(py::module &mod) {
       .def("dump", &observe_result::dump,
            "Dump the raw data from the :class:`SampleResult` that are stored "
            "in :class:`ObserveResult` to the terminal.\n")
+      .def("get_counters", &observe_result::get_counters,
+           "Return the :class:`ExecutionCounters` of the kernel executions of "
+           "this observation.\n")
       .def(
           "counts", &observe_result::raw_data,
           "Returns a :class:`SampleResult` dictionary with the measurement "
@@ -64,7 +68,19 @@ void bindObserveResult(py::module &mod) {
           "\nReturns:\n"
           "  float : The expectation value of the `sub_term` with respect to "
           "the :class:`Kernel` "
-          "that was passed to :func:`observe`.\n");
+          "that was passed to :func:`observe`.\n")
+      .def(
+          "expectation_z",
+          [](observe_result &self, const readout_mitigator &mitigator) {
+            return self.exp_val_z(mitigator);
+          },
+          py::arg("mitigator"),
+          "Return the expectation value of the `spin_operator`, with the "
+          "counts of every term corrected for readout errors. The value is "
+          "not corrected if it was not computed from counts.\n"
+          "\nArgs:\n"
+          "  mitigator (:class:`ReadoutMitigator`): The readout error "
+          "mitigation.\n");
 
   py::class_<async_observe_result>(
       mod, "AsyncObserveResult",
@@ -85,6 +101,21 @@ void bindObserveResult(py::module &mod) {
       .def("get", &async_observe_result::get,
            "Return the :class:`ObserveResult` from the asynchronous observe "
            "execution.\n")
+      .def("get_within", &async_observe_result::get_within,
+           py::arg("tolerance"),
+           "Return the :class:`ObserveResult` as soon as the terms whose "
+           "remote jobs are still running can change the expectation value "
+           "by at most `tolerance`. These terms are counted as 0 and their "
+           "jobs are cancelled.\n")
+      .def("cancel", &async_observe_result::cancel,
+           "Stop waiting for the result and cancel the remote jobs that are "
+           "not done. `get` raises an error afterwards.\n")
+      .def("__await__",
+           [](py::object self) {
+             return awaitableResult<observe_result>(self).attr("__await__")();
+           },
+           "Await the :class:`ObserveResult` in a coroutine of the running "
+           "`asyncio` event loop, without blocking the loop or a thread.\n")
       .def("__str__", [](async_observe_result &self) {
         std::stringstream ss;
         ss << self;
@@ -6,19 +6,59 @@
  * the terms of the Apache License 2.0 which accompanies this distribution.    *
  *******************************************************************************/
 
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
 #include "py_SampleResult.h"
+#include "utils/SerializedBuffer.h"
 
+#include "common/ColumnarResult.h"
 #include "common/MeasureCounts.h"
 
+#include <cstring>
 #include <sstream>
 
 namespace cudaq {
 
+/// @brief Return the sample result in the columnar format as a numpy array
+/// of bytes, see columnar::serialize().
+static py::array_t<std::uint8_t> serializeSampleResult(const sample_result &r,
+                                                       bool compress) {
+  return toOwningArray(columnar::serialize(r, compress));
+}
+
+/// @brief Return the sample result in the columnar format in a buffer.
+static sample_result deserializeSampleResult(const py::buffer &buffer) {
+  auto info = buffer.request();
+  auto bytes = toBytes(info);
+  return sample_result_view(bytes.data(), bytes.size()).to_sample_result();
+}
+
 void bindMeasureCounts(py::module &mod) {
   using namespace cudaq;
 
+  py::class_<execution_counters>(
+      mod, "ExecutionCounters",
+      "The performance counters of the kernel executions behind a "
+      ":class:`SampleResult` or :class:`ObserveResult`, summed over the "
+      "executions.\n")
+      .def_readonly("gates", &execution_counters::gates,
+                    "The number of gates applied to the simulated state.\n")
+      .def_readonly("state_sweeps", &execution_counters::state_sweeps,
+                    "The number of passes over the simulated state applying "
+                    "gates, fewer than the gates if gates are fused.\n")
+      .def_readonly("peak_state_bytes", &execution_counters::peak_state_bytes,
+                    "The largest size of the simulated state, in bytes.\n")
+      .def_readonly("simulator_seconds",
+                    &execution_counters::simulator_seconds,
+                    "The time spent in the simulator, in seconds.\n")
+      .def_readonly("host_seconds", &execution_counters::host_seconds,
+                    "The time of the executions spent in host code, in "
+                    "seconds.\n")
+      .def_readonly("kernel_executions",
+                    &execution_counters::kernel_executions,
+                    "The number of kernel executions.\n");
+
   // TODO Bind the variants of this functions that take the register name
   // as input.
   py::class_<sample_result>(
@@ -35,6 +75,56 @@ void bindMeasureCounts(py::module &mod) {
       "  register_names (List[str]): A list of the names of each measurement "
       "register that are stored in `self`.\n")
       .def_property_readonly("register_names", &sample_result::register_names)
+      .def("get_counters", &sample_result::get_counters,
+           "Return the :class:`ExecutionCounters` of the kernel executions "
+           "that produced this result.\n")
+      .def(
+          "get_packed_counts",
+          [](sample_result &self, const std::string &registerName) {
+            // Copied with one memcpy per array, the packed counts are moved
+            // back into strings when the counts are next read as strings.
+            auto &packed = self.packed_counts(registerName);
+            const py::ssize_t n = packed.size();
+            const py::ssize_t nWords = packed.n_words();
+            py::array_t<std::uint64_t> outcomes({n, nWords});
+            py::array_t<std::uint64_t> counts(n);
+            std::memcpy(outcomes.mutable_data(), packed.keys_data(),
+                        n * nWords * sizeof(std::uint64_t));
+            static_assert(sizeof(std::size_t) == sizeof(std::uint64_t));
+            std::memcpy(counts.mutable_data(), packed.counts_data(),
+                        n * sizeof(std::uint64_t));
+            return py::make_tuple(outcomes, counts);
+          },
+          py::arg("register_name") = GlobalRegisterName,
+          "Return the measured bit strings of the given register and their "
+          "counts as numpy arrays, without building a string per bit "
+          "string.\n"
+          "\nArgs:\n"
+          "  register_name (Optional[str]): The register. Defaults to the "
+          "global register.\n"
+          "\nReturns:\n"
+          "  Tuple[numpy.ndarray, numpy.ndarray] : The bit strings, an array "
+          "of `numpy.uint64` of shape (N, W) holding each of the N bit strings "
+          "packed into W words, bit `j` of a bit string being bit `j % 64` of "
+          "its word `j / 64`, and the N counts as `numpy.uint64`.\n")
+      .def("serialize", &serializeSampleResult, py::kw_only(),
+           py::arg("compress") = false,
+           "Return the counts of all registers in the columnar binary format "
+           "as a `numpy.uint8` array, read back by :meth:`from_serialized`. "
+           "The bit strings are packed into bytes and the counts stored as "
+           "one column per register. The sequential data is not kept.\n"
+           "\nArgs:\n"
+           "  compress (Optional[bool]): Compress the columns, for slow "
+           "links. Defaults to False. Key-word only.\n")
+      .def_static("from_serialized", &deserializeSampleResult,
+                  py::arg("data"),
+                  "Return the `SampleResult` serialized by :meth:`serialize` "
+                  "into the given buffer, e.g. a numpy array or `bytes`.\n")
+      .def(py::pickle(
+          [](const sample_result &self) {
+            return serializeSampleResult(self, /*compress=*/false);
+          },
+          &deserializeSampleResult))
       .def(
           "dump", [](sample_result &self) { self.dump(); },
           "Print a string of the raw measurement counts data to the "
@@ -23,33 +23,37 @@ constexpr int defaultShotsValue = -1;
 /// @brief Default qpu id value set to 0
 constexpr int defaultQpuIdValue = 0;
 
-/// @brief Run `cudaq::observe` on the provided kernel and spin operator.
+/// @brief Run `cudaq::observe` on the provided kernel and spin operator. The
+/// arguments are validated and packed, and the kernel JIT compiled, with the
+/// GIL held. The observation runs with the GIL released, so that other Python
+/// threads run meanwhile.
 observe_result pyObserve(kernel_builder<> &kernel, spin_op &spin_operator,
                          py::args args = {}, int shots = defaultShotsValue) {
   // Ensure the user input is correct.
   auto validatedArgs = validateInputArguments(kernel, args);
+  OpaqueArguments argData;
+  packArgs(argData, validatedArgs);
   auto &platform = cudaq::get_platform();
 
   // TODO: would like to handle errors in the case that
   // `kernel.num_qubits() >= spin_operator.num_qubits()`
-  kernel.jitCode();
+  kernel.getJitKernel();
 
+  py::gil_scoped_release release;
   // Does this platform expose more than 1 QPU
   // If so, let's distribute the work amongst the QPUs
   if (auto nQpus = platform.num_qpus(); nQpus > 1)
     return details::distributeComputations(
         [&](std::size_t i, spin_op &op) {
-          return pyObserveAsync(kernel, op, args, i, shots);
+          return details::runObservationAsync(
+              [&]() mutable { kernel.jitAndInvoke(argData.data()); }, op,
+              platform, shots, i);
         },
         spin_operator, nQpus);
 
   // Launch the observation task
   return details::runObservation(
-             [&]() mutable {
-               OpaqueArguments argData;
-               packArgs(argData, validatedArgs);
-               kernel.jitAndInvoke(argData.data());
-             },
+             [&]() mutable { kernel.jitAndInvoke(argData.data()); },
              spin_operator, platform, shots)
       .value();
 }
@@ -61,26 +65,71 @@ async_observe_result pyObserveAsync(kernel_builder<> &kernel,
                                     std::size_t qpu_id = defaultQpuIdValue,
                                     int shots = defaultShotsValue) {
 
-  // Ensure the user input is correct.
+  // Ensure the user input is correct. The arguments are packed here, the
+  // asynchronous execution does not hold the GIL.
   auto validatedArgs = validateInputArguments(kernel, args);
+  auto argData = std::make_shared<OpaqueArguments>();
+  packArgs(*argData, validatedArgs);
 
   // TODO: would like to handle errors in the case that
   // `kernel.num_qubits() >= spin_operator.num_qubits()`
-  kernel.jitCode();
+  kernel.getJitKernel();
 
   // Get the platform, first check that the given qpu_id is valid
   auto &platform = cudaq::get_platform();
 
   // Launch the asynchronous execution.
   return details::runObservationAsync(
-      [&, a = std::move(validatedArgs)]() mutable {
-        OpaqueArguments argData;
-        packArgs(argData, a);
-        kernel.jitAndInvoke(argData.data());
-      },
+      [&kernel, argData]() mutable { kernel.jitAndInvoke(argData->data()); },
       spin_operator, platform, shots, qpu_id);
 }
 
+/// @brief Run `cudaq::observe` on the provided kernel and spin operator at
+/// each of the argument sets, in one broadcast (see packArgumentSets()). The
+/// argument sets are validated and packed up front, so the kernel executions
+/// run with the GIL released and neither touch the interpreter nor JIT the
+/// kernel again.
+std::vector<observe_result> pyObserveBatch(kernel_builder<> &kernel,
+                                           spin_op &spin_operator,
+                                           py::object argumentSets,
+                                           int shots = defaultShotsValue) {
+  auto packedArgs = packArgumentSets(kernel, argumentSets);
+  kernel.getJitKernel();
+  auto &platform = cudaq::get_platform();
+
+  py::gil_scoped_release release;
+  return details::runObservationBroadcast(
+      [&](std::size_t i) { kernel.jitAndInvoke(packedArgs[i].data()); },
+      packedArgs.size(), spin_operator, platform, shots);
+}
+
+/// @brief Run `cudaq::observe` on the provided kernel and spin operator at
+/// each of the noise `scales`, and extrapolate the expectation value to zero
+/// noise (see observe(zne_options, ...)).
+zne_result pyObserveZne(kernel_builder<> &kernel, spin_op &spin_operator,
+                        py::args args, std::vector<std::size_t> scales,
+                        const std::string &extrapolation, int shots) {
+  zne_options options;
+  options.scales = std::move(scales);
+  if (extrapolation == "exponential")
+    options.extrapolation = zne_extrapolation::exponential;
+  else if (extrapolation != "richardson")
+    throw std::runtime_error("Invalid zero-noise extrapolation (" +
+                             extrapolation +
+                             "), expected richardson or exponential.");
+
+  auto validatedArgs = validateInputArguments(kernel, args);
+  auto argData = std::make_shared<OpaqueArguments>();
+  packArgs(*argData, validatedArgs);
+  kernel.getJitKernel();
+  auto &platform = cudaq::get_platform();
+
+  py::gil_scoped_release release;
+  return details::runZneObservation(
+      [&kernel, argData]() mutable { kernel.jitAndInvoke(argData->data()); },
+      spin_operator, platform, shots, options);
+}
+
 void bindObserve(py::module &mod) {
 
   // FIXME provide ability to inject noise model here
@@ -117,6 +166,77 @@ void bindObserve(py::module &mod) {
       ":class:`SampleResult` "
       "dictionary.\n");
 
+  mod.def(
+      "observe_batch",
+      [&](kernel_builder<> &kernel, spin_op &spin_operator,
+          py::object argument_sets, int shots) {
+        return pyObserveBatch(kernel, spin_operator, argument_sets, shots);
+      },
+      py::arg("kernel"), py::arg("spin_operator"), py::arg("argument_sets"),
+      py::kw_only(), py::arg("shots_count") = defaultShotsValue,
+      "Compute the expected value of the `spin_operator` with respect to "
+      "the `kernel` at each of the `argument_sets`. The evaluations are split "
+      "amongst the QPUs of the platform, and simulated as one batch where "
+      "the backend supports it.\n"
+      "\nArgs:\n"
+      "  kernel (:class:`Kernel`): The :class:`Kernel` to evaluate the "
+      "expectation value with respect to.\n"
+      "  spin_operator (:class:`SpinOperator`): The Hermitian spin operator to "
+      "calculate the expectation of.\n"
+      "  argument_sets (List[Any]): The arguments of each evaluation: a tuple "
+      "of the kernel arguments, or the argument of a kernel of one argument. "
+      "A 2D numpy array holds the list arguments of a kernel of one list "
+      "argument row by row.\n"
+      "  shots_count (Optional[int]): The number of shots to use for QPU "
+      "execution. Defaults to 1 shot. Key-word only.\n"
+      "\nReturns:\n"
+      "  List[:class:`ObserveResult`] : The result of each evaluation, in the "
+      "order of the `argument_sets`.\n");
+
+  py::class_<zne_result>(
+      mod, "ZneResult",
+      "The result of :func:`observe_zne`: the expectation value "
+      "extrapolated to zero noise, and the observations at each noise "
+      "scale.\n"
+      "\nAttributes:\n"
+      "  expectation (float): The extrapolated expectation value.\n"
+      "  scales (List[int]): The noise scales.\n"
+      "  results (List[:class:`ObserveResult`]): The observation at each "
+      "noise scale.\n")
+      .def_readonly("expectation", &zne_result::expectation)
+      .def_readonly("scales", &zne_result::scales)
+      .def_readonly("results", &zne_result::results)
+      .def("__float__",
+           [](const zne_result &self) { return self.expectation; });
+
+  mod.def("observe_zne", &pyObserveZne, py::arg("kernel"),
+          py::arg("spin_operator"), py::kw_only(),
+          py::arg("scales") = std::vector<std::size_t>{1, 3, 5},
+          py::arg("extrapolation") = "richardson",
+          py::arg("shots_count") = defaultShotsValue,
+          "Compute the expected value of the `spin_operator` with respect to "
+          "the `kernel`, extrapolated to zero noise. The noise of the kernel "
+          "is amplified by each of the odd `scales` by folding its gates, "
+          "every gate G being applied as G (G^dagger G)^((scale - 1) / 2). "
+          "All the scaled observations are submitted at once, split amongst "
+          "the QPUs of the platform.\n"
+          "\nArgs:\n"
+          "  kernel (:class:`Kernel`): The :class:`Kernel` to evaluate the "
+          "expectation value with respect to.\n"
+          "  spin_operator (:class:`SpinOperator`): The Hermitian spin "
+          "operator to calculate the expectation of.\n"
+          "  *arguments (Optional[Any]): The concrete values to evaluate the "
+          "kernel function at.\n"
+          "  scales (Optional[List[int]]): The odd noise scales. Defaults to "
+          "[1, 3, 5]. Key-word only.\n"
+          "  extrapolation (Optional[str]): `richardson` (the default) or "
+          "`exponential`, which decays to the constant terms of the "
+          "`spin_operator`. Key-word only.\n"
+          "  shots_count (Optional[int]): The number of shots to use for QPU "
+          "execution. Defaults to 1 shot. Key-word only.\n"
+          "\nReturns:\n"
+          "  :class:`ZneResult` : The extrapolated expectation value.\n");
+
   /// Expose observe_async, can optionally take the qpu_id to target.
   mod.def(
       "observe_async",
@@ -25,6 +25,10 @@ observe_result pyObserve(kernel_builder<> &kernel, spin_op &spin_operator,
 async_observe_result pyObserveAsync(kernel_builder<> &kernel,
                                     spin_op &spin_operator, py::args args,
                                     std::size_t qpu_id, int shots);
+std::vector<observe_result> pyObserveBatch(kernel_builder<> &kernel,
+                                           spin_op &spin_operator,
+                                           py::object argumentSets,
+                                           int shots);
 /// @brief Expose binding of `cudaq::observe()` and `cudaq::observe_async` to
 /// python.
 void bindObserve(py::module &mod);
@@ -10,6 +10,7 @@
 
 #include "py_optimizer.h"
 
+#include "cudaq/algorithms/gradients/adjoint.h"
 #include "cudaq/algorithms/gradients/central_difference.h"
 #include "cudaq/algorithms/gradients/parameter_shift.h"
 #include "cudaq/algorithms/optimizers/ensmallen/ensmallen.h"
@@ -55,6 +56,17 @@ void bindGradientStrategies(py::module &mod) {
             return grad.compute(x, function);
           },
           py::arg("parameter_vector"), py::arg("function"), "");
+  py::class_<gradients::adjoint, gradient>(gradients_submodule, "Adjoint")
+      .def(py::init<>())
+      .def(
+          "compute",
+          [](cudaq::gradient &grad, const std::vector<double> &x,
+             py::function &func) {
+            auto function =
+                func.cast<std::function<double(std::vector<double>)>>();
+            return grad.compute(x, function);
+          },
+          py::arg("parameter_vector"), py::arg("function"), "");
 }
 
 /// @brief Add the requested optimization routine as a class
@@ -9,6 +9,7 @@
 #include <pybind11/stl.h>
 
 #include "py_sample.h"
+#include "utils/AsyncResult.h"
 #include "utils/OpaqueArguments.h"
 
 #include "cudaq.h"
@@ -21,20 +22,24 @@
 
 namespace cudaq {
 
-/// @brief Sample the state produced by the provided builder.
+/// @brief Sample the state produced by the provided builder. The arguments
+/// are validated and packed, and the kernel JIT compiled, with the GIL held.
+/// The sampling runs with the GIL released, so that other Python threads run
+/// meanwhile.
 sample_result pySample(kernel_builder<> &builder, py::args args = {},
                        std::size_t shots = 1000) {
   // Ensure the user input is correct.
   auto validatedArgs = validateInputArguments(builder, args);
 
   cudaq::info("Sampling the provided pythonic kernel.");
-  builder.jitCode();
+  builder.getJitKernel();
   auto kernelName = builder.name();
   auto &platform = cudaq::get_platform();
 
   // Map py::args to OpaqueArguments handle
   OpaqueArguments argData;
   packArgs(argData, validatedArgs);
+  py::gil_scoped_release release;
   return details::runSampling(
              [&]() mutable { builder.jitAndInvoke(argData.data()); }, platform,
              kernelName, shots)
@@ -47,22 +52,46 @@ async_sample_result pySampleAsync(kernel_builder<> &builder,
                                   std::size_t qpu_id = 0,
                                   std::size_t shots = 1000,
                                   py::args args = {}) {
-  // Ensure the user input is correct.
+  // Ensure the user input is correct. The arguments are packed here, the
+  // asynchronous execution does not hold the GIL.
   auto validatedArgs = validateInputArguments(builder, args);
+  auto argData = std::make_shared<OpaqueArguments>();
+  packArgs(*argData, validatedArgs);
   auto &platform = cudaq::get_platform();
   cudaq::info("Asynchronously sampling the provided pythonic kernel.");
-  builder.jitCode();
+  builder.getJitKernel();
   auto kernelName = builder.name();
 
   return details::runSamplingAsync(
-      [&, a = std::move(validatedArgs)]() mutable {
-        OpaqueArguments argData;
-        packArgs(argData, a);
-        builder.jitAndInvoke(argData.data());
-      },
+      [&builder, argData]() mutable { builder.jitAndInvoke(argData->data()); },
       platform, kernelName, shots, qpu_id);
 }
 
+/// @brief Sample the state produced by the provided builder at each of the
+/// argument sets, in one broadcast (see packArgumentSets()). The argument
+/// sets are validated and packed up front, so the kernel executions run with
+/// the GIL released.
+std::vector<sample_result> pySampleBatch(kernel_builder<> &builder,
+                                         py::object argumentSets,
+                                         std::size_t shots = 1000) {
+  auto packedArgs = packArgumentSets(builder, argumentSets);
+  cudaq::info("Sampling the provided pythonic kernel at {} argument sets.",
+              packedArgs.size());
+  builder.getJitKernel();
+  auto kernelName = builder.name();
+  auto &platform = cudaq::get_platform();
+
+  std::vector<sample_result> results(packedArgs.size());
+  py::gil_scoped_release release;
+  details::runSamplingBroadcast(
+      [&](std::size_t i) { builder.jitAndInvoke(packedArgs[i].data()); },
+      packedArgs.size(), platform, kernelName, shots,
+      [&](std::size_t i, sample_result &&result) {
+        results[i] = std::move(result);
+      });
+  return results;
+}
+
 void bindSample(py::module &mod) {
 
   py::class_<async_sample_result>(
@@ -84,6 +113,15 @@ void bindSample(py::module &mod) {
       .def("get", &async_sample_result::get,
            "Return the :class:`SampleResult` from the asynchronous sample "
            "execution.\n")
+      .def("cancel", &async_sample_result::cancel,
+           "Stop waiting for the result and cancel the remote jobs that are "
+           "not done. `get` raises an error afterwards.\n")
+      .def("__await__",
+           [](py::object self) {
+             return awaitableResult<sample_result>(self).attr("__await__")();
+           },
+           "Await the :class:`SampleResult` in a coroutine of the running "
+           "`asyncio` event loop, without blocking the loop or a thread.\n")
       .def("__str__", [](async_sample_result &res) {
         std::stringstream ss;
         ss << res;
@@ -125,6 +163,39 @@ void bindSample(py::module &mod) {
       "count results "
       "for the :class:`Kernel`.\n");
 
+  mod.def(
+      "sample_batch",
+      [&](kernel_builder<> &builder, py::object argument_sets,
+          std::size_t shots, std::optional<noise_model> noise) {
+        if (!noise)
+          return pySampleBatch(builder, argument_sets, shots);
+
+        set_noise(*noise);
+        auto res = pySampleBatch(builder, argument_sets, shots);
+        unset_noise();
+        return res;
+      },
+      py::arg("kernel"), py::arg("argument_sets"), py::kw_only(),
+      py::arg("shots_count") = 1000, py::arg("noise_model") = py::none(),
+      "Sample the state of the provided `kernel` at each of the "
+      "`argument_sets`, at the specified number of circuit executions "
+      "(`shots_count`) each. The evaluations are split amongst the QPUs of "
+      "the platform.\n"
+      "\nArgs:\n"
+      "  kernel (:class:`Kernel`): The :class:`Kernel` to execute.\n"
+      "  argument_sets (List[Any]): The arguments of each evaluation: a tuple "
+      "of the kernel arguments, or the argument of a kernel of one argument. "
+      "A 2D numpy array holds the list arguments of a kernel of one list "
+      "argument row by row.\n"
+      "  shots_count (Optional[int]): The number of kernel executions on the "
+      "QPU per evaluation. Defaults to 1000. Key-word only.\n"
+      "  noise_model (Optional[`NoiseModel`]): The optional "
+      ":class:`NoiseModel` to add noise to the kernel execution on the "
+      "simulator. Defaults to an empty noise model.\n"
+      "\nReturns:\n"
+      "  List[:class:`SampleResult`] : The measurement counts of each "
+      "evaluation, in the order of the `argument_sets`.\n");
+
   mod.def(
       "sample_async",
       [&](kernel_builder<> &builder, py::args args, std::size_t shots,
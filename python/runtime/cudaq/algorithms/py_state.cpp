@@ -45,9 +45,25 @@ state pyGetState(kernel_builder<> &kernel, py::args args) {
 /// @brief Bind the get_state cudaq function
 void bindPyState(py::module &mod) {
 
-  py::class_<state>(mod, "State",
+  py::class_<state>(mod, "State", py::buffer_protocol(),
                     "A representation of the internal simulation quantum state "
-                    "vector or density matrix.")
+                    "vector or density matrix. It exposes its data through the "
+                    "buffer protocol, `numpy.array(state, copy=False)` is a "
+                    "read-only view of it.")
+      .def_buffer([](state &self) {
+        // The view is on the state data, which the State keeps alive and
+        // never modifies. Device data is copied to the host once.
+        auto shape = self.get_shape();
+        std::vector<py::ssize_t> extents(shape.begin(), shape.end());
+        std::vector<py::ssize_t> strides(shape.size(), sizeof(complex));
+        if (shape.size() == 2)
+          strides[0] *= shape[1];
+        return py::buffer_info(const_cast<complex *>(self.get_host_data()),
+                               sizeof(complex),
+                               py::format_descriptor<complex>::format(),
+                               shape.size(), extents, strides,
+                               /*readonly=*/true);
+      })
       .def(py::init([](const py::buffer &b) {
              py::buffer_info info = b.request();
              std::vector<std::size_t> shape;
@@ -11,32 +11,64 @@
 
 #include "py_observe.h"
 #include "py_vqe.h"
+#include "runtime/cudaq/builder/py_compiled_kernel.h"
 
 #include "cudaq/algorithms/gradient.h"
+#include "cudaq/algorithms/observe.h"
 #include "cudaq/algorithms/optimizer.h"
+#include "cudaq/platform.h"
 
 namespace cudaq {
 
-/// @brief Run `cudaq.vqe()` without a gradient strategy.
-optimization_result pyVQE(kernel_builder<> &kernel, spin_op &hamiltonian,
-                          cudaq::optimizer &optimizer, const int n_params,
-                          const int shots = -1) {
-  if (kernel.getNumParams() != 1)
+/// @brief Run `cudaq.vqe()` natively, with or without a gradient strategy.
+/// The kernel is compiled once, and the optimizer, the gradient strategy and
+/// the observe loop run with the GIL released. Python is only called back to
+/// log each iteration, if a callback is given.
+optimization_result pyVQE(kernel_builder<> &kernel, cudaq::gradient *gradient,
+                          spin_op &hamiltonian, cudaq::optimizer &optimizer,
+                          const int n_params, const int shots,
+                          const std::optional<py::function> &callback) {
+  py_compiled_kernel compiled(kernel);
+  if (compiled.getNumParameters() != static_cast<std::size_t>(n_params))
     throw std::runtime_error(
-        "Kernels with signature other than "
-        "`void(List[float])` must provide an `argument_mapper`.");
+        "Kernels with signature other than `void(List[float])` of "
+        "`parameter_count` elements or `parameter_count` floats must provide "
+        "an `argument_mapper`.");
 
-  if (!kernel.isArgStdVec(0))
-    throw std::runtime_error(
-        "Kernels with signature other than "
-        "`void(List[float])` must provide an `argument_mapper`.");
+  auto requires_grad = optimizer.requiresGradients();
+  if (requires_grad && !gradient)
+    throw std::runtime_error("Provided optimizer requires a gradient strategy "
+                             "but none was given.");
+
+  // The gradient strategy executes the compiled kernel itself, e.g. at all
+  // shifted parameters at once. It must not keep it past this call.
+  struct ansatz_scope {
+    cudaq::gradient *gradient;
+    ~ansatz_scope() {
+      if (gradient)
+        gradient->set_ansatz({});
+    }
+  } scope{gradient};
+  if (gradient)
+    gradient->set_ansatz(
+        [&](std::vector<double> x) { compiled.invoke(x); });
 
+  auto &platform = cudaq::get_platform();
+  py::gil_scoped_release release;
   return optimizer.optimize(n_params, [&](const std::vector<double> &x,
                                           std::vector<double> &grad_vec) {
-    py::args params = py::make_tuple(x);
-    observe_result result = pyObserve(kernel, hamiltonian, params, shots);
-    double energy = result.exp_val_z();
-    printf("<H> = %lf\n", energy);
+    double energy =
+        details::runObservation([&]() { compiled.invoke(x); }, hamiltonian,
+                                platform, shots)
+            ->exp_val_z();
+    if (requires_grad)
+      gradient->compute(x, grad_vec, hamiltonian, energy);
+    if (callback) {
+      py::gil_scoped_acquire acquire;
+      (*callback)(x, energy);
+    } else {
+      printf("<H> = %lf\n", energy);
+    }
     return energy;
   });
 }
@@ -61,43 +93,6 @@ optimization_result pyVQE(kernel_builder<> &kernel, spin_op &hamiltonian,
   });
 }
 
-/// @brief Run `cudaq.vqe()` with the provided gradient strategy.
-optimization_result pyVQE(kernel_builder<> &kernel, cudaq::gradient &gradient,
-                          spin_op &hamiltonian, cudaq::optimizer &optimizer,
-                          const int n_params, const int shots = -1) {
-  if (kernel.getNumParams() != 1)
-    throw std::runtime_error(
-        "Kernels with signature other than "
-        "`void(List[float])` must provide an `argument_mapper`.");
-
-  if (!kernel.isArgStdVec(0))
-    throw std::runtime_error(
-        "Kernels with signature other than "
-        "`void(List[float])` must provide an `argument_mapper`.");
-
-  // Get the expected value of the system, <H> at the provided
-  // vector of parameters. This is passed to `cudaq::gradient::compute`
-  // to allow for the calculation of the gradient vector with the
-  // provided gradient strategy.
-  std::function<double(std::vector<double>)> get_expected_value =
-      [&](std::vector<double> x) {
-        py::args params = py::make_tuple(x);
-        observe_result result = pyObserve(kernel, hamiltonian, params, shots);
-        double energy = result.exp_val_z();
-        return energy;
-      };
-  auto requires_grad = optimizer.requiresGradients();
-  return optimizer.optimize(n_params, [&](const std::vector<double> &x,
-                                          std::vector<double> &grad_vec) {
-    double energy = get_expected_value(x);
-    printf("<H> = %lf\n", energy);
-    if (requires_grad) {
-      grad_vec = gradient.compute(x, get_expected_value);
-    }
-    return energy;
-  });
-}
-
 /// @brief Run `cudaq.vqe()` with the provided gradient strategy,
 /// using the provided `argument_mapper`.
 optimization_result pyVQE(kernel_builder<> &kernel, cudaq::gradient &gradient,
@@ -139,16 +134,13 @@ void bindVQE(py::module &mod) {
       "vqe",
       [](kernel_builder<> &kernel, cudaq::spin_op &spin_operator,
          cudaq::optimizer &optimizer, const int parameter_count,
-         const int shots) {
-        auto requires_grad = optimizer.requiresGradients();
-        if (requires_grad) {
-          std::runtime_error("Provided optimizer requires a gradient strategy "
-                             "but none was given.\n");
-        }
-        return pyVQE(kernel, spin_operator, optimizer, parameter_count, shots);
+         const int shots, std::optional<py::function> callback) {
+        return pyVQE(kernel, nullptr, spin_operator, optimizer,
+                     parameter_count, shots, callback);
       },
       py::arg("kernel"), py::arg("spin_operator"), py::arg("optimizer"),
-      py::arg("parameter_count"), py::arg("shots") = -1, "");
+      py::arg("parameter_count"), py::arg("shots") = -1, py::kw_only(),
+      py::arg("callback") = py::none(), "");
 
   // With a provided `argument_mapper`.
   mod.def(
@@ -173,13 +165,14 @@ void bindVQE(py::module &mod) {
       "vqe",
       [](kernel_builder<> &kernel, cudaq::gradient &gradient,
          cudaq::spin_op &spin_operator, cudaq::optimizer &optimizer,
-         const int parameter_count, const int shots) {
-        return pyVQE(kernel, gradient, spin_operator, optimizer,
-                     parameter_count, shots);
+         const int parameter_count, const int shots,
+         std::optional<py::function> callback) {
+        return pyVQE(kernel, &gradient, spin_operator, optimizer,
+                     parameter_count, shots, callback);
       },
       py::arg("kernel"), py::arg("gradient_strategy"), py::arg("spin_operator"),
       py::arg("optimizer"), py::arg("parameter_count"), py::arg("shots") = -1,
-      "");
+      py::kw_only(), py::arg("callback") = py::none(), "");
 
   // With a provided `argument_mapper`.
   mod.def(
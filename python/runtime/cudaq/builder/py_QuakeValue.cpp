@@ -21,7 +21,9 @@ void bindQuakeValue(py::module &mod) {
       ":class:`qubit`, or :class:`qreg`. The :class:`QuakeValue` can also hold "
       "kernel operations such as qubit allocations and measurements.\n")
       /// @brief Bind the indexing operator for cudaq::QuakeValue
-      .def("__getitem__", &QuakeValue::operator[], py::arg("index"),
+      .def("__getitem__",
+           py::overload_cast<const std::size_t>(&QuakeValue::operator[]),
+           py::arg("index"),
            "Return the element of `self` at the provided `index`.\n"
            "\nNote:\n"
            "  Only `list` or :class:`qreg` type :class:`QuakeValue`'s "
@@ -34,6 +36,12 @@ void bindQuakeValue(py::module &mod) {
            "\nRaises:\n"
            "  RuntimeError: if `self` is a non-subscriptable "
            ":class:`QuakeValue`.\n")
+      .def("__getitem__",
+           py::overload_cast<QuakeValue>(&QuakeValue::operator[]),
+           py::arg("index"),
+           "Return the qubit of `self`, a :class:`qreg`, at the index held by "
+           "the integer :class:`QuakeValue` `index`, e.g. the index of "
+           ":meth:`Kernel.for_loop`.\n")
       /// @brief Bind the binary operators on `QuakeValue` class. Note:
       /// these are incompatible with the pybind11 built-in
       /// binary operators (see: cudaq::spin_op bindings). Instead,
@@ -0,0 +1,134 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include "py_compiled_kernel.h"
+
+#include "cudaq/algorithms/observe.h"
+#include "cudaq/algorithms/sample.h"
+#include "cudaq/platform.h"
+
+namespace cudaq {
+
+/// @brief The parameters of a compiled kernel, a contiguous array of floats.
+/// Lists and arrays of another type or layout are converted into one.
+using parameter_array =
+    py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+static std::span<const double> toSpan(const parameter_array &parameters) {
+  return {parameters.data(), static_cast<std::size_t>(parameters.size())};
+}
+
+py_compiled_kernel::py_compiled_kernel(kernel_builder<> &kernel)
+    : kernel(kernel), jitKernel(kernel.getJitKernel()) {
+  auto &arguments = kernel.getArguments();
+  if (arguments.size() == 1 && kernel.isArgStdVec(0)) {
+    takesList = true;
+    numParameters = arguments[0].getRequiredElements();
+  } else if (kernel.allArgsAreDouble()) {
+    numParameters = arguments.size();
+  } else {
+    throw std::runtime_error("Only kernels taking floats or one list of "
+                             "floats can be compiled.");
+  }
+}
+
+void py_compiled_kernel::validate(std::span<const double> parameters) const {
+  if (parameters.size() != numParameters)
+    throw std::runtime_error("Compiled kernel requires " +
+                             std::to_string(numParameters) +
+                             " parameters but " +
+                             std::to_string(parameters.size()) + " provided.");
+}
+
+void py_compiled_kernel::invoke(std::span<const double> parameters) {
+  if (!takesList) {
+    details::invokeCode(jitKernel, parameters);
+    return;
+  }
+  thread_local std::vector<double> list;
+  list.assign(parameters.begin(), parameters.end());
+  void *args[] = {&list};
+  details::invokeCode(jitKernel, args);
+}
+
+void bindCompiledKernel(py::module &mod) {
+  py::class_<py_compiled_kernel>(
+      mod, "CompiledKernel",
+      "A :class:`Kernel` compiled once by :meth:`Kernel.compile`, for "
+      "kernels invoked many times at different parameters. It takes the "
+      "values of the float arguments of the kernel, or the elements of its "
+      "list argument, as one array of floats. A contiguous `numpy.float64` "
+      "array is read in place.\n"
+      "\nAttributes:\n"
+      "  parameter_count (int): The number of parameters. Read-only.\n")
+      .def_property_readonly("parameter_count",
+                             &py_compiled_kernel::getNumParameters)
+      .def(
+          "__call__",
+          [](py_compiled_kernel &self, const parameter_array &parameters) {
+            self.validate(toSpan(parameters));
+            self.invoke(toSpan(parameters));
+          },
+          py::arg("parameters"),
+          "Call the kernel at the given parameters.\n"
+          "\nArgs:\n"
+          "  parameters (numpy.ndarray): The parameters.\n")
+      .def(
+          "observe",
+          [](py_compiled_kernel &self, spin_op &spin_operator,
+             const parameter_array &parameters, int shots) {
+            auto values = toSpan(parameters);
+            self.validate(values);
+            auto &platform = cudaq::get_platform();
+            py::gil_scoped_release release;
+            return details::runObservation(
+                       [&]() { self.invoke(values); }, spin_operator,
+                       platform, shots)
+                .value();
+          },
+          py::arg("spin_operator"), py::arg("parameters"), py::kw_only(),
+          py::arg("shots_count") = -1,
+          "Compute the expected value of the `spin_operator` with respect to "
+          "the kernel at the given parameters. Equivalent to "
+          ":func:`observe`.\n"
+          "\nArgs:\n"
+          "  spin_operator (:class:`SpinOperator`): The Hermitian spin "
+          "operator to calculate the expectation of.\n"
+          "  parameters (numpy.ndarray): The parameters.\n"
+          "  shots_count (Optional[int]): The number of shots to use for QPU "
+          "execution. Defaults to 1 shot. Key-word only.\n"
+          "\nReturns:\n"
+          "  :class:`ObserveResult` : The expectation value.\n")
+      .def(
+          "sample",
+          [](py_compiled_kernel &self, const parameter_array &parameters,
+             std::size_t shots) {
+            auto values = toSpan(parameters);
+            self.validate(values);
+            auto &platform = cudaq::get_platform();
+            auto kernelName = self.getKernel().name();
+            py::gil_scoped_release release;
+            return details::runSampling([&]() { self.invoke(values); },
+                                        platform, kernelName, shots)
+                .value();
+          },
+          py::arg("parameters"), py::kw_only(), py::arg("shots_count") = 1000,
+          "Sample the state of the kernel at the given parameters. "
+          "Equivalent to :func:`sample`.\n"
+          "\nArgs:\n"
+          "  parameters (numpy.ndarray): The parameters.\n"
+          "  shots_count (Optional[int]): The number of kernel executions on "
+          "the QPU. Defaults to 1000. Key-word only.\n"
+          "\nReturns:\n"
+          "  :class:`SampleResult` : The measurement counts.\n");
+}
+
+} // namespace cudaq
@@ -0,0 +1,57 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+#include "cudaq/builder/kernel_builder.h"
+
+#include <span>
+
+namespace py = pybind11;
+
+namespace cudaq {
+
+/// @brief A `kernel_builder` JIT compiled once and bound to its signature,
+/// for kernels invoked many times at different parameters, e.g. in an
+/// optimization loop. The kernel takes either floats or one list of floats,
+/// and is invoked with the flat array of their values, without validating or
+/// packing Python arguments.
+class py_compiled_kernel {
+  kernel_builder<> &kernel;
+  details::JitKernel &jitKernel;
+
+  /// @brief Whether the kernel takes one list of floats rather than floats.
+  bool takesList = false;
+
+  /// @brief The number of floats, or of elements of the list.
+  std::size_t numParameters = 0;
+
+public:
+  /// @brief Compile the kernel. Throws if its arguments are neither floats
+  /// nor one list of floats.
+  py_compiled_kernel(kernel_builder<> &kernel);
+
+  /// @brief Return the kernel this was compiled from.
+  kernel_builder<> &getKernel() { return kernel; }
+
+  /// @brief Return the number of parameters the kernel is invoked with.
+  std::size_t getNumParameters() const { return numParameters; }
+
+  /// @brief Throw if the number of parameters is not the expected one.
+  void validate(std::span<const double> parameters) const;
+
+  /// @brief Invoke the kernel at the given parameters, which are copied into
+  /// a buffer of the calling thread allocated once.
+  void invoke(std::span<const double> parameters);
+};
+
+/// @brief Bind `py_compiled_kernel` as `cudaq.CompiledKernel`.
+void bindCompiledKernel(py::module &mod);
+} // namespace cudaq
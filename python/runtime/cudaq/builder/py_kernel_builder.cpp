@@ -6,8 +6,10 @@
  * the terms of the Apache License 2.0 which accompanies this distribution.    *
  *******************************************************************************/
 
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
+#include "py_compiled_kernel.h"
 #include "py_kernel_builder.h"
 #include "utils/OpaqueArguments.h"
 
@@ -110,6 +112,24 @@ void bindMakeKernel(py::module &mod) {
       "  # Parameterized kernel that accepts an `int` and `float` as "
       "arguments.\n"
       "  kernel, int_value, float_value = cudaq.make_kernel(int, float)\n");
+
+  mod.def(
+      "precompile",
+      [](py::args arguments) {
+        std::vector<details::kernel_builder_base *> kernels;
+        for (auto &arg : arguments)
+          kernels.push_back(&arg.cast<kernel_builder<> &>());
+        py::gil_scoped_release release;
+        cudaq::precompile(kernels);
+      },
+      "Just-In-Time (JIT) compile the given kernels concurrently, so that "
+      "their first calls do not compile them.\n"
+      "\nArgs:\n"
+      "  *kernels (:class:`Kernel`): The kernels to compile.\n"
+      "\n.. code-block:: python\n\n"
+      "  # Example:\n"
+      "  kernels = [build_ansatz(layers) for layers in range(1, 10)]\n"
+      "  cudaq.precompile(*kernels)\n");
 }
 
 /// Useful macros for defining builder.QIS(...) functions
@@ -220,7 +240,29 @@ void bindMakeKernel(py::module &mod) {
           " to the kernel at a concrete parameter value.\n"                   \
           "  kernel." #NAME "(parameter=3.14, target=qubit)\n")
 
+/// @brief A column of a gate list, read in place if it is a contiguous array
+/// of the right type.
+template <typename T>
+using gate_column = py::array_t<T, py::array::c_style | py::array::forcecast>;
+
 void bindKernel(py::module &mod) {
+  py::enum_<gate_instruction::kind>(
+      mod, "GateKind",
+      "The gates of a gate list appended by :meth:`Kernel.apply_gates`. "
+      "`sdg` and `tdg` are the adjoints of `s` and `t`.\n")
+      .value("h", gate_instruction::h)
+      .value("s", gate_instruction::s)
+      .value("t", gate_instruction::t)
+      .value("x", gate_instruction::x)
+      .value("y", gate_instruction::y)
+      .value("z", gate_instruction::z)
+      .value("sdg", gate_instruction::sdg)
+      .value("tdg", gate_instruction::tdg)
+      .value("rx", gate_instruction::rx)
+      .value("ry", gate_instruction::ry)
+      .value("rz", gate_instruction::rz)
+      .value("r1", gate_instruction::r1);
+
   py::class_<kernel_builder<>>(
       mod, "Kernel",
       "The :class:`Kernel` provides an API for dynamically constructing "
@@ -241,6 +283,23 @@ void bindKernel(py::module &mod) {
                              &cudaq::kernel_builder<>::getArguments)
       .def_property_readonly("argument_count",
                              &cudaq::kernel_builder<>::getNumParams)
+      .def(
+          "compile",
+          [](kernel_builder<> &self) { return py_compiled_kernel(self); },
+          py::keep_alive<0, 1>(),
+          "Just-In-Time (JIT) compile `self` (:class:`Kernel`) and return a "
+          ":class:`CompiledKernel`, which is invoked with an array of the "
+          "values of the arguments without validating or converting each "
+          "argument. The kernel must take floats, or one list of floats, and "
+          "must not be modified afterwards.\n"
+          "\nReturns:\n"
+          "  :class:`CompiledKernel` : The compiled kernel.\n"
+          "\n.. code-block:: python\n\n"
+          "  # Example:\n"
+          "  kernel, thetas = cudaq.make_kernel(list)\n"
+          "  ...\n"
+          "  compiled = kernel.compile()\n"
+          "  energy = compiled.observe(hamiltonian, np.array([0.1, 0.2]))\n")
       /// @brief Bind overloads for `qalloc()`.
       .def(
           "qalloc", [](kernel_builder<> &self) { return self.qalloc(); },
@@ -297,6 +356,17 @@ void bindKernel(py::module &mod) {
       .def(
           "__call__",
           [&](kernel_builder<> &self, py::args arguments) {
+            // Kernels taking only floats are invoked with their values,
+            // without packing them.
+            if (self.allArgsAreDouble()) {
+              std::vector<double> values;
+              values.reserve(arguments.size());
+              for (auto &arg : arguments)
+                values.push_back(arg.cast<double>());
+              self.invoke(values);
+              return;
+            }
+
             auto validatedArgs = validateInputArguments(self, arguments);
             OpaqueArguments argData;
             packArgs(argData, validatedArgs);
@@ -336,6 +406,50 @@ void bindKernel(py::module &mod) {
       // clang-format on
 
       /// @brief Allow for conditional statements on measurements.
+      .def(
+          "for_loop",
+          [](kernel_builder<> &self, std::size_t start, std::size_t stop,
+             py::function function) {
+            self.for_loop(start, stop,
+                          [&](QuakeValue &index) { function(index); });
+          },
+          py::arg("start"), py::arg("stop"), py::arg("function"),
+          "Apply the `function` to the :class:`Kernel` for each index in "
+          "[`start`, `stop`). The `function` is called once, and builds the "
+          "body of a loop, rather than being unrolled into one copy per "
+          "index. The JIT compilation only unrolls short loops.\n"
+          "\nArgs:\n"
+          "  start (int or :class:`QuakeValue`): The first index.\n"
+          "  stop (int or :class:`QuakeValue`): The index past the last "
+          "one.\n"
+          "  function (Callable): The function building the body, called "
+          "with the index as an integer :class:`QuakeValue`, which may index "
+          "a :class:`qreg`.\n"
+          "\n.. code-block:: python\n\n"
+          "  # Example: a chain of CNOTs.\n"
+          "  kernel = cudaq.make_kernel()\n"
+          "  qubits = kernel.qalloc(10)\n"
+          "  kernel.h(qubits[0])\n"
+          "  kernel.for_loop(0, 9, lambda i: kernel.cx(qubits[i], "
+          "qubits[i + 1]))\n")
+      .def(
+          "for_loop",
+          [](kernel_builder<> &self, std::size_t start, QuakeValue &stop,
+             py::function function) {
+            self.for_loop(start, stop,
+                          [&](QuakeValue &index) { function(index); });
+          },
+          py::arg("start"), py::arg("stop"), py::arg("function"),
+          "See :meth:`for_loop`.\n")
+      .def(
+          "for_loop",
+          [](kernel_builder<> &self, QuakeValue &start, QuakeValue &stop,
+             py::function function) {
+            self.for_loop(start, stop,
+                          [&](QuakeValue &index) { function(index); });
+          },
+          py::arg("start"), py::arg("stop"), py::arg("function"),
+          "See :meth:`for_loop`.\n")
       .def(
           "c_if",
           [&](kernel_builder<> &self, QuakeValue &measurement,
@@ -369,6 +483,78 @@ void bindKernel(py::module &mod) {
           "measured\n"
           "  # in the 1-state.\n"
           "  kernel.c_if(measurement, then_function)\n")
+      .def(
+          "apply_gates",
+          [](kernel_builder<> &self, QuakeValue &qubits,
+             const gate_column<std::uint8_t> &gates,
+             const gate_column<std::int64_t> &targets,
+             const std::optional<gate_column<std::int64_t>> &controls,
+             const std::optional<gate_column<double>> &angles,
+             const std::optional<gate_column<std::int64_t>> &parameterIndices,
+             std::optional<QuakeValue> parameters) {
+            const py::ssize_t n = gates.size();
+            auto checkSize = [&](py::ssize_t size, const char *name) {
+              if (size != n)
+                throw std::runtime_error(
+                    std::string("apply_gates: `") + name + "` has " +
+                    std::to_string(size) + " elements, not " +
+                    std::to_string(n) + ".");
+            };
+            checkSize(targets.size(), "targets");
+            if (controls)
+              checkSize(controls->size(), "controls");
+            if (angles)
+              checkSize(angles->size(), "angles");
+            if (parameterIndices)
+              checkSize(parameterIndices->size(), "parameter_indices");
+
+            std::vector<gate_instruction> instructions(n);
+            for (py::ssize_t i = 0; i < n; i++) {
+              auto &gate = instructions[i];
+              gate.gate = static_cast<gate_instruction::kind>(gates.data()[i]);
+              gate.target = targets.data()[i];
+              if (controls)
+                gate.control = controls->data()[i];
+              if (angles)
+                gate.angle = angles->data()[i];
+              if (parameterIndices)
+                gate.parameter = parameterIndices->data()[i];
+            }
+            self.apply_gates(qubits, instructions, parameters);
+          },
+          py::arg("qubits"), py::arg("gates"), py::arg("targets"),
+          py::kw_only(), py::arg("controls") = py::none(),
+          py::arg("angles") = py::none(),
+          py::arg("parameter_indices") = py::none(),
+          py::arg("parameters") = py::none(),
+          "Append a list of gates, e.g. of a generated circuit, to the "
+          ":class:`Kernel` in one call. Each gate is given by one element of "
+          "each array, whose qubits are indices into `qubits`. Each qubit and "
+          "angle is created once and shared by the gates that use it.\n"
+          "\nArgs:\n"
+          "  qubits (:class:`QuakeValue`): The register the gates act on.\n"
+          "  gates (numpy.ndarray): The :class:`GateKind` of each gate, as "
+          "integers.\n"
+          "  targets (numpy.ndarray): The target qubit of each gate.\n"
+          "  controls (Optional[numpy.ndarray]): The control qubit of each "
+          "gate, or -1 for none. Key-word only.\n"
+          "  angles (Optional[numpy.ndarray]): The angle of each rotation. "
+          "Key-word only.\n"
+          "  parameter_indices (Optional[numpy.ndarray]): The element of "
+          "`parameters` multiplying the angle of each rotation, or -1 for a "
+          "constant angle. Key-word only.\n"
+          "  parameters (Optional[:class:`QuakeValue`]): A list of floats, "
+          "e.g. an argument of the :class:`Kernel`. Key-word only.\n"
+          "\n.. code-block:: python\n\n"
+          "  # Example: a Trotter step of rotations scaled by `theta[0]`.\n"
+          "  kernel, theta = cudaq.make_kernel(list)\n"
+          "  qubits = kernel.qalloc(3)\n"
+          "  kernel.apply_gates(qubits,\n"
+          "                     np.array([int(cudaq.GateKind.rz)] * 3),\n"
+          "                     np.arange(3),\n"
+          "                     angles=np.full(3, 0.1),\n"
+          "                     parameter_indices=np.zeros(3, dtype=int),\n"
+          "                     parameters=theta)\n")
       /// @brief Bind overloads for measuring qubits and registers.
       .def(
           "mx",
@@ -11,11 +11,37 @@
 
 #include "cudaq/spin_op.h"
 #include "py_spin_op.h"
+#include "utils/SerializedBuffer.h"
 
 #include <complex>
+#include <cstring>
 
 namespace cudaq {
 
+/// @brief Return the packed representation of the spin_op as a numpy array
+/// of `uint64`, see spin_op::getPackedRepresentation().
+static py::array_t<std::uint64_t> serializeSpinOp(const spin_op &op) {
+  return toOwningArray(op.getPackedRepresentation());
+}
+
+/// @brief Construct a spin_op from its packed representation in a buffer,
+/// read in place unless the buffer is not aligned to 64 bit words.
+static spin_op deserializeSpinOp(const py::buffer &buffer) {
+  auto info = buffer.request();
+  auto bytes = toBytes(info);
+  if (bytes.size() % sizeof(std::uint64_t))
+    throw std::runtime_error("Invalid serialized SpinOperator of " +
+                             std::to_string(bytes.size()) + " bytes.");
+  const std::size_t nWords = bytes.size() / sizeof(std::uint64_t);
+  auto address = reinterpret_cast<std::uintptr_t>(bytes.data());
+  if (address % alignof(std::uint64_t) == 0)
+    return spin_op::fromPackedRepresentation(
+        {reinterpret_cast<const std::uint64_t *>(bytes.data()), nWords});
+  std::vector<std::uint64_t> words(nWords);
+  std::memcpy(words.data(), bytes.data(), bytes.size());
+  return spin_op::fromPackedRepresentation(words);
+}
+
 void bindSpinClass(py::module &mod) {
   // Binding the `cudaq::spin` class to `_pycudaq` as a submodule
   // so it's accessible directly in the cudaq namespace.
@@ -69,6 +95,17 @@ void bindSpinOperator(py::module &mod) {
       .def_static("random", &cudaq::spin_op::random,
                   "Return a random spin_op on the given number of qubits and "
                   "composed of the given number of terms.")
+      .def("serialize", &serializeSpinOp,
+           "Return the packed binary representation of this `SpinOperator` "
+           "as a `numpy.uint64` array: the number of qubits, of words per X "
+           "or Z row and of terms, the X and Z bits of each term packed into "
+           "words, then the real and imaginary parts of each coefficient. It "
+           "is not copied into the array, and is read back by "
+           ":meth:`from_serialized`.")
+      .def_static("from_serialized", &deserializeSpinOp, py::arg("data"),
+                  "Return the `SpinOperator` serialized by :meth:`serialize` "
+                  "into the given buffer, e.g. a numpy array or `bytes`.")
+      .def(py::pickle(&serializeSpinOp, &deserializeSpinOp))
 
       /// @brief Bind overloaded operators that are in-place on
       /// `cudaq.SpinOperator`.
@@ -78,6 +78,82 @@ def test_Kraus():
     cudaq.unset_noise()
 
 
+def test_readout_error():
+
+    cudaq.set_qpu('dm')
+
+    noise = cudaq.NoiseModel()
+    noise.add_readout_error(0, p01=0.05, p10=0.25)
+    with pytest.raises(RuntimeError):
+        noise.add_readout_error(1, [0.5, 0.6, 0.0, 1.0])
+    cudaq.set_noise(noise)
+    circuit = cudaq.make_kernel()
+    q = circuit.qalloc()
+    circuit.x(q)
+
+    counts = cudaq.sample(circuit, shots_count=2000)
+    assert counts.probability('0') == pytest.approx(0.25, abs=0.05)
+    assert counts.probability('1') == pytest.approx(0.75, abs=0.05)
+
+    cudaq.set_qpu('qpp')
+    cudaq.unset_noise()
+
+
+def test_readout_mitigation():
+
+    cudaq.set_qpu('dm')
+
+    noise = cudaq.NoiseModel()
+    noise.add_readout_error(0, p01=0.05, p10=0.1)
+    noise.add_readout_error(1, p01=0.05, p10=0.1)
+    cudaq.set_noise(noise)
+    circuit = cudaq.make_kernel()
+    qubits = circuit.qalloc(2)
+    circuit.x(qubits)
+
+    counts = cudaq.sample(circuit, shots_count=10000)
+    mitigator = cudaq.ReadoutMitigator.from_noise_model(noise, 2)
+    assert counts.expectation_z() == pytest.approx(0.64, abs=0.05)
+    assert mitigator.expectation_z(counts, [0, 1]) == pytest.approx(1.0,
+                                                                    abs=0.05)
+    quasi = mitigator.quasi_probabilities(counts, [0, 1])
+    assert sum(quasi.values()) == pytest.approx(1.0)
+
+    cudaq.set_qpu('qpp')
+    cudaq.unset_noise()
+
+
+def test_zero_noise_extrapolation():
+
+    cudaq.set_qpu('dm')
+
+    noise = cudaq.NoiseModel()
+    noise.add_channel('ry', [0], cudaq.DepolarizationChannel(.05))
+    cudaq.set_noise(noise)
+    kernel, theta = cudaq.make_kernel(float)
+    qubit = kernel.qalloc()
+    kernel.ry(theta, qubit)
+    hamiltonian = cudaq.spin.z(0)
+
+    # Every noisy ry shrinks <Z> by the same factor, which the exponential
+    # fit undoes exactly.
+    result = cudaq.observe_zne(kernel, hamiltonian, .5)
+    assert result.scales == [1, 3, 5]
+    assert len(result.results) == 3
+    assert result.expectation == pytest.approx(np.cos(.5), abs=1e-3)
+    assert abs(result.results[0].expectation_z() - np.cos(.5)) > 0.05
+    result = cudaq.observe_zne(kernel,
+                               hamiltonian,
+                               .5,
+                               extrapolation='exponential')
+    assert float(result) == pytest.approx(np.cos(.5), abs=1e-9)
+    with pytest.raises(RuntimeError):
+        cudaq.observe_zne(kernel, hamiltonian, .5, scales=[1, 2])
+
+    cudaq.set_qpu('qpp')
+    cudaq.unset_noise()
+
+
 # leave for gdb debugging
 if __name__ == "__main__":
     loc = os.path.abspath(__file__)
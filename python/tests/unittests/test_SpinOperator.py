@@ -153,6 +153,28 @@ def test_spin_op_vqe():
     assert want_string == str(hamiltonian)
 
 
+def test_spin_op_serialize():
+    """
+    Test that `cudaq.SpinOperator` round trips through its packed binary
+    representation and through pickle.
+    """
+    import pickle
+    hamiltonian = 5.907 - 2.1433 * spin.x(0) * spin.x(1) - 2.1433 * spin.y(
+        0) * spin.y(1) + .21829 * spin.z(0) - 6.125 * spin.z(1)
+    data = hamiltonian.serialize()
+    # Header, 2 words of X and Z bits and 2 words of coefficient per term.
+    assert len(data) == 3 + 4 * hamiltonian.get_term_count()
+    for restored in [
+            cudaq.SpinOperator.from_serialized(data),
+            cudaq.SpinOperator.from_serialized(data.tobytes()),
+            pickle.loads(pickle.dumps(hamiltonian, protocol=5))
+    ]:
+        assert restored.to_string() == hamiltonian.to_string()
+
+    with pytest.raises(RuntimeError):
+        cudaq.SpinOperator.from_serialized(data.tobytes()[:-1])
+
+
 # leave for gdb debugging
 if __name__ == "__main__":
     loc = os.path.abspath(__file__)
@@ -581,6 +581,89 @@ def test_observe_numpy_array(angles, want_state, want_expectation):
         cudaq.observe(kernel, hamiltonian, bad_params, qpu_id=0, shots_count=10)
 
 
+
+def test_observe_batch():
+    """
+    Tests that `cudaq.observe_batch` matches `cudaq.observe` at every
+    argument set, for kernels of one float, several floats and one list.
+    """
+    hamiltonian = spin.z(0) - 2.0 * spin.x(1)
+
+    kernel, theta = cudaq.make_kernel(float)
+    qreg = kernel.qalloc(2)
+    kernel.rx(theta, qreg[0])
+    kernel.ry(theta, qreg[1])
+    angles = [0.1 * i for i in range(7)]
+    results = cudaq.observe_batch(kernel, hamiltonian, angles)
+    assert len(results) == len(angles)
+    for angle, result in zip(angles, results):
+        want = cudaq.observe(kernel, hamiltonian, angle).expectation_z()
+        assert np.isclose(result.expectation_z(), want)
+
+    kernel, theta, phi = cudaq.make_kernel(float, float)
+    qreg = kernel.qalloc(2)
+    kernel.rx(theta, qreg[0])
+    kernel.ry(phi, qreg[1])
+    argument_sets = [(0.3, -0.2), (1.0, 0.5), (-0.7, 2.0)]
+    results = cudaq.observe_batch(kernel, hamiltonian, argument_sets)
+    for arguments, result in zip(argument_sets, results):
+        want = cudaq.observe(kernel, hamiltonian, *arguments).expectation_z()
+        assert np.isclose(result.expectation_z(), want)
+
+    # The rows of a 2D numpy array are the list argument of each evaluation.
+    kernel, thetas = cudaq.make_kernel(list)
+    qreg = kernel.qalloc(2)
+    kernel.rx(thetas[0], qreg[0])
+    kernel.ry(thetas[1], qreg[1])
+    grid = np.random.uniform(low=-np.pi, high=np.pi, size=(5, 2))
+    results = cudaq.observe_batch(kernel, hamiltonian, grid)
+    for row, result in zip(grid, results):
+        want = cudaq.observe(kernel, hamiltonian, row).expectation_z()
+        assert np.isclose(result.expectation_z(), want)
+
+    with pytest.raises(RuntimeError) as error:
+        cudaq.observe_batch(kernel, hamiltonian, [[0.1, 0.2, 0.3]])
+
+
+def test_compiled_kernel():
+    """
+    Tests that a compiled kernel matches the kernel it was compiled from,
+    for kernels of floats and of one list.
+    """
+    hamiltonian = spin.z(0) - 2.0 * spin.x(1)
+
+    kernel, theta, phi = cudaq.make_kernel(float, float)
+    qreg = kernel.qalloc(2)
+    kernel.rx(theta, qreg[0])
+    kernel.ry(phi, qreg[1])
+    compiled = kernel.compile()
+    assert compiled.parameter_count == 2
+    for parameters in [(0.3, -0.2), (1.0, 0.5)]:
+        want = cudaq.observe(kernel, hamiltonian, *parameters).expectation_z()
+        got = compiled.observe(hamiltonian, np.array(parameters))
+        assert np.isclose(got.expectation_z(), want)
+
+    kernel, thetas = cudaq.make_kernel(list)
+    qreg = kernel.qalloc(2)
+    kernel.rx(thetas[0], qreg[0])
+    kernel.ry(thetas[1], qreg[1])
+    kernel.mz(qreg)
+    compiled = kernel.compile()
+    assert compiled.parameter_count == 2
+    parameters = np.array([np.pi, 0.0])
+    compiled(parameters)
+    assert compiled.sample(parameters).most_probable() == "10"
+    # Lists are converted to arrays of floats.
+    assert compiled.sample([0.0, np.pi]).most_probable() == "01"
+
+    with pytest.raises(RuntimeError) as error:
+        compiled(np.array([0.1, 0.2, 0.3]))
+
+    kernel, qubit = cudaq.make_kernel(cudaq.qubit)
+    with pytest.raises(RuntimeError) as error:
+        kernel.compile()
+
+
 # leave for gdb debugging
 if __name__ == "__main__":
     loc = os.path.abspath(__file__)
@@ -439,6 +439,27 @@ def test_sample_async_params():
         result = cudaq.sample_async(kernel, 0.0, 0.0, qpu_id=12)
 
 
+def test_sample_async_await():
+    """Tests awaiting `cudaq.sample_async` results in `asyncio` coroutines."""
+    import asyncio
+
+    kernel, theta = cudaq.make_kernel(float)
+    qubits = kernel.qalloc(2)
+    kernel.rx(theta, qubits[0])
+    kernel.cx(qubits[0], qubits[1])
+    kernel.mz(qubits)
+
+    async def sample_all():
+        return await asyncio.gather(
+            cudaq.sample_async(kernel, 0.0), cudaq.sample_async(kernel, np.pi),
+            cudaq.sample_async(kernel, np.pi / 2.))
+
+    off, on, both = asyncio.run(sample_all())
+    assert off.most_probable() == '00'
+    assert on.most_probable() == '11'
+    assert len(both) == 2
+
+
 def test_sample_marginalize():
     """
     A more thorough test of the functionality of `SampleResult::get_marginal_counts`.
@@ -477,6 +498,167 @@ def test_sample_marginalize():
     assert marginal_result.most_probable() == "101"
 
 
+def test_sample_batch():
+    """
+    Tests that `cudaq.sample_batch` samples the kernel at every argument
+    set, given as a list or as the rows of a 2D numpy array.
+    """
+    kernel, theta = cudaq.make_kernel(float)
+    qubit = kernel.qalloc()
+    kernel.rx(theta, qubit)
+    kernel.mz(qubit)
+    results = cudaq.sample_batch(kernel, [0.0, np.pi, 0.0], shots_count=100)
+    assert [result.most_probable() for result in results] == ["0", "1", "0"]
+
+    kernel, thetas = cudaq.make_kernel(list)
+    qreg = kernel.qalloc(2)
+    kernel.rx(thetas[0], qreg[0])
+    kernel.rx(thetas[1], qreg[1])
+    kernel.mz(qreg)
+    grid = np.array([[0.0, np.pi], [np.pi, 0.0], [np.pi, np.pi]])
+    results = cudaq.sample_batch(kernel, grid, shots_count=100)
+    assert [result.most_probable() for result in results] == ["01", "10", "11"]
+
+    with pytest.raises(RuntimeError) as error:
+        cudaq.sample_batch(kernel, [[0.1, 0.2, 0.3]])
+
+
+def test_sample_threads():
+    """
+    Tests that `cudaq.sample` releases the GIL, so that Python threads
+    sample the same kernel concurrently.
+    """
+    from concurrent.futures import ThreadPoolExecutor
+
+    kernel, theta = cudaq.make_kernel(float)
+    qubit = kernel.qalloc()
+    kernel.rx(theta, qubit)
+    kernel.mz(qubit)
+    angles = [np.pi * (i % 2) for i in range(8)]
+    with ThreadPoolExecutor(max_workers=4) as executor:
+        results = list(
+            executor.map(lambda angle: cudaq.sample(kernel, angle), angles))
+    for angle, result in zip(angles, results):
+        assert result.most_probable() == ("1" if angle else "0")
+
+
+def test_sample_packed_counts():
+    """
+    Tests that `SampleResult.get_packed_counts` returns the bit strings
+    packed into integers and their counts as numpy arrays.
+    """
+    kernel = cudaq.make_kernel()
+    qreg = kernel.qalloc(3)
+    kernel.h(qreg[0])
+    kernel.x(qreg[2])
+    kernel.mz(qreg)
+    result = cudaq.sample(kernel, shots_count=1000)
+
+    outcomes, counts = result.get_packed_counts()
+    assert outcomes.dtype == np.uint64 and counts.dtype == np.uint64
+    assert outcomes.shape == (len(result), 1)
+    assert counts.sum() == 1000
+    # Bit j of the integer is character j of the bit string.
+    assert sorted(outcomes[:, 0].tolist()) == [0b100, 0b101]
+    for outcome, count in zip(outcomes[:, 0], counts):
+        bits = ''.join(str((int(outcome) >> j) & 1) for j in range(3))
+        assert result.count(bits) == count
+
+
+def test_sample_result_serialize():
+    """
+    Tests that `SampleResult` round trips through the columnar binary format
+    and through pickle.
+    """
+    import pickle
+    kernel = cudaq.make_kernel()
+    qreg = kernel.qalloc(3)
+    kernel.h(qreg[0])
+    kernel.x(qreg[2])
+    kernel.mz(qreg)
+    result = cudaq.sample(kernel, shots_count=1000)
+
+    data = result.serialize()
+    assert data.dtype == np.uint8
+    for restored in [
+            cudaq.SampleResult.from_serialized(data),
+            cudaq.SampleResult.from_serialized(
+                result.serialize(compress=True).tobytes()),
+            pickle.loads(pickle.dumps(result, protocol=5))
+    ]:
+        assert len(restored) == len(result)
+        for bits, count in result.items():
+            assert restored.count(bits) == count
+
+
+def test_sample_apply_gates():
+    """
+    Tests that a kernel built with `Kernel.apply_gates` samples like the
+    kernel built gate by gate.
+    """
+    kernel, thetas = cudaq.make_kernel(list)
+    qreg = kernel.qalloc(3)
+    gates = np.array([
+        int(cudaq.GateKind.rx),
+        int(cudaq.GateKind.x),
+        int(cudaq.GateKind.x)
+    ])
+    kernel.apply_gates(qreg,
+                       gates,
+                       targets=np.array([0, 1, 2]),
+                       controls=np.array([-1, 0, -1]),
+                       angles=np.array([0.5, 0., 0.]),
+                       parameter_indices=np.array([0, -1, -1]),
+                       parameters=thetas)
+    kernel.mz(qreg)
+
+    # rx(pi) flips qubit 0, which flips qubit 1.
+    counts = cudaq.sample(kernel, [2 * np.pi])
+    assert counts.most_probable() == '111'
+    assert len(counts) == 1
+
+    with pytest.raises(RuntimeError):
+        kernel.apply_gates(qreg, gates, targets=np.array([0, 1]))
+
+
+def test_sample_for_loop():
+    """
+    Tests that a GHZ kernel built with `Kernel.for_loop` keeps its loop and
+    samples the GHZ state.
+    """
+    qubit_count = 60
+    kernel = cudaq.make_kernel()
+    qreg = kernel.qalloc(qubit_count)
+    kernel.h(qreg[0])
+    kernel.for_loop(0, qubit_count - 1,
+                    lambda i: kernel.cx(qreg[i], qreg[i + 1]))
+    kernel.mz(qreg)
+    assert 'cc.loop' in str(kernel)
+
+    counts = cudaq.sample(kernel)
+    assert len(counts) == 2
+    assert counts.count('0' * qubit_count) + counts.count(
+        '1' * qubit_count) == 1000
+
+
+def test_sample_counters():
+    """
+    Tests the `ExecutionCounters` of a `SampleResult`.
+    """
+    kernel = cudaq.make_kernel()
+    qreg = kernel.qalloc(2)
+    kernel.h(qreg[0])
+    kernel.cx(qreg[0], qreg[1])
+    kernel.mz(qreg)
+
+    counters = cudaq.sample(kernel).get_counters()
+    assert counters.kernel_executions == 1
+    assert counters.gates == 2
+    assert 1 <= counters.state_sweeps <= counters.gates
+    assert counters.peak_state_bytes > 0
+    assert counters.simulator_seconds > 0
+
+
 # leave for gdb debugging
 if __name__ == "__main__":
     loc = os.path.abspath(__file__)
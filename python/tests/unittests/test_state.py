@@ -112,6 +112,25 @@ def test_simple_density_matrix():
     cudaq.set_qpu('qpp')
 
 
+def test_state_numpy_view():
+    """
+    Tests that a `State` is a read-only numpy view of the state data.
+    """
+    circuit = cudaq.make_kernel()
+    q = circuit.qalloc(2)
+    circuit.h(q[0])
+    circuit.cx(q[0], q[1])
+    state = cudaq.get_state(circuit)
+
+    view = np.array(state, copy=False)
+    assert view.dtype == np.complex128
+    assert view.shape == (4,)
+    assert not view.flags.writeable
+    assert np.allclose(view, [1. / np.sqrt(2.), 0., 0., 1. / np.sqrt(2.)])
+    # Repeated views share the data.
+    assert np.shares_memory(view, np.array(state, copy=False))
+
+
 # leave for gdb debugging
 if __name__ == "__main__":
     loc = os.path.abspath(__file__)
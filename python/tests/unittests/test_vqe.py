@@ -375,6 +375,25 @@ def test_vqe_three_qubit_list_gradients(optimizer, gradient,
                                                  got_parameters))
 
 
+def test_vqe_callback(kernel_two_qubit_vqe_float, hamiltonian_2q):
+    """
+    Test that `cudaq.vqe` without an `argument_mapper` reports each iteration
+    to the callback, for a kernel taking floats and a gradient strategy.
+    """
+    iterations = []
+    got_expectation, got_parameters = cudaq.vqe(
+        kernel=kernel_two_qubit_vqe_float,
+        gradient_strategy=cudaq.gradients.ParameterShift(),
+        spin_operator=hamiltonian_2q,
+        optimizer=cudaq.optimizers.LBFGS(),
+        parameter_count=1,
+        callback=lambda x, energy: iterations.append((list(x), energy)))
+
+    assert assert_close(-1.7487948611472093, got_expectation, tolerance=1e-2)
+    assert len(iterations) > 0
+    assert min(energy for _, energy in iterations) == got_expectation
+
+
 # leave for gdb debugging
 if __name__ == "__main__":
     loc = os.path.abspath(__file__)
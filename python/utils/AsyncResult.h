@@ -0,0 +1,74 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+#include "common/Future.h"
+
+#include <memory>
+
+namespace py = pybind11;
+
+namespace cudaq {
+
+/// @brief The Python objects an awaited asynchronous result is delivered to.
+/// They are only touched, and released, with the GIL held.
+struct py_awaiting {
+  py::object loop;
+  py::object future;
+  py::object result;
+};
+
+/// @brief Return an `asyncio.Future` of the running event loop that is
+/// resolved with `result.get()` once the result is ready. No thread waits
+/// for the result: the thread completing it schedules the resolution on the
+/// event loop.
+template <typename T>
+py::object awaitableResult(py::object result) {
+  auto state = std::make_shared<py_awaiting>();
+  state->loop = py::module::import("asyncio").attr("get_running_loop")();
+  state->future = state->loop.attr("create_future")();
+  state->result = result;
+  py::object future = state->future;
+
+  auto resolve = py::cpp_function([state]() {
+    if (state->future.attr("cancelled")().cast<bool>())
+      return;
+    try {
+      py::object value =
+          py::cast(state->result.cast<async_result<T> &>().get());
+      state->future.attr("set_result")(value);
+    } catch (py::error_already_set &e) {
+      state->future.attr("set_exception")(e.value());
+    } catch (std::exception &e) {
+      state->future.attr("set_exception")(
+          py::module::import("builtins").attr("RuntimeError")(e.what()));
+    }
+  });
+
+  // The callback only holds Python objects until it runs, since it is
+  // destroyed by a thread that may not hold the GIL.
+  py::object schedule = state->loop.attr("call_soon_threadsafe");
+  result.cast<async_result<T> &>().on_ready(
+      [schedule, resolve]() mutable {
+        py::gil_scoped_acquire acquire;
+        try {
+          // Fails if the event loop was closed meanwhile.
+          schedule(resolve);
+        } catch (py::error_already_set &e) {
+          e.discard_as_unraisable("resolving an awaited CUDA Quantum result");
+        }
+        schedule = py::object();
+        resolve = py::object();
+      });
+  return future;
+}
+
+} // namespace cudaq
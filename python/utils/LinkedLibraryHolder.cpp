@@ -88,12 +88,12 @@ LinkedLibraryHolder::LinkedLibraryHolder() {
       cudaqLibPath / fmt::format("libcudaq.{}", libSuffix)};
 
   // Load all the defaults
-  for (auto &p : libPaths) {
-    libHandles.emplace(p.string(),
-                       dlopen(p.string().c_str(), RTLD_GLOBAL | RTLD_NOW));
-  }
+  for (auto &p : libPaths)
+    loadLibrary(p);
 
-  // Load all simulators here when we start up.
+  // Find the simulators from the names of their libraries. Loading them, and
+  // their dependencies like the CUDA libraries, is deferred until they are
+  // selected, so that importing cudaq only loads the default simulator.
   for (const auto &library :
        std::filesystem::directory_iterator{cudaqLibPath}) {
     auto path = library.path();
@@ -106,22 +106,7 @@ LinkedLibraryHolder::LinkedLibraryHolder() {
       // Remove the suffix from the library
       auto idx = simName.find_last_of(".");
       simName = simName.substr(0, idx);
-
-      if (simName == "tensornet" || simName == "cuquantum_mgpu") {
-        simulators.emplace(simName, nullptr);
-        continue;
-      }
-
-      auto iter = libHandles.find(path.string());
-      if (iter == libHandles.end())
-        libHandles.emplace(path.string(), dlopen(path.string().c_str(),
-                                                 RTLD_GLOBAL | RTLD_NOW));
-
-      // Load the plugin and get the CircuitSimulator.
-      std::string symbolName = fmt::format("getCircuitSimulator_{}", simName);
-      auto *simulator =
-          getUniquePluginInstance<nvqir::CircuitSimulator>(symbolName);
-      simulators.emplace(simName, simulator);
+      simulators.emplace(simName, SimulatorPlugin{path});
     }
   }
 
@@ -129,6 +114,37 @@ LinkedLibraryHolder::LinkedLibraryHolder() {
   setQPU("qpp");
 }
 
+void *LinkedLibraryHolder::loadLibrary(const std::filesystem::path &path) {
+  auto iter = libHandles.find(path.string());
+  if (iter != libHandles.end())
+    return iter->second;
+
+  cudaq::info("Loading library {}.", path.string());
+  auto *handle = dlopen(path.string().c_str(), RTLD_GLOBAL | RTLD_LAZY);
+  if (!handle) {
+    cudaq::info("Could not load {}: {}", path.string(), dlerror());
+    return nullptr;
+  }
+  libHandles.emplace(path.string(), handle);
+  return handle;
+}
+
+nvqir::CircuitSimulator *
+LinkedLibraryHolder::getSimulator(const std::string &name) {
+  auto &plugin = simulators.at(name);
+  if (plugin.simulator)
+    return plugin.simulator;
+
+  // Load the plugin and get the CircuitSimulator.
+  if (!loadLibrary(plugin.path))
+    throw std::runtime_error(fmt::format("Could not load the {} simulator: {}",
+                                         name, plugin.path.string()));
+  std::string symbolName = fmt::format("getCircuitSimulator_{}", name);
+  plugin.simulator =
+      getUniquePluginInstance<nvqir::CircuitSimulator>(symbolName);
+  return plugin.simulator;
+}
+
 LinkedLibraryHolder::~LinkedLibraryHolder() {
   for (auto &[name, handle] : libHandles)
     dlclose(handle);
@@ -158,42 +174,12 @@ void LinkedLibraryHolder::setQPU(const std::string &name,
   if (name == "cuquantum")
     mutableName = "custatevec";
 
-  // Set the simulator if we find it
-  auto iter = simulators.find(mutableName);
-  if (iter != simulators.end()) {
-    if (iter->second) {
-      __nvqir__setCircuitSimulator(iter->second);
-      return;
-    }
-
-    // If this is one of mpi backends then we need to load it first.
-    // Note we can only load one of these in a single python execution context
-    if (mutableName == "cuquantum_mgpu") {
-      cudaq::info("Requested MPI QPU = {}", mutableName);
-      auto path =
-          cudaqLibPath / fmt::format("libnvqir-{}.{}", mutableName, libSuffix);
-      cudaq::info("Path is {}", path.string());
-
-      if (!std::filesystem::exists(path))
-        throw std::runtime_error(
-            fmt::format("Invalid path for simulation plugin: {}, {}",
-                        mutableName, path.string()));
-
-      auto iter = libHandles.find(path.string());
-      if (iter == libHandles.end())
-        libHandles.emplace(path.string(), dlopen(path.string().c_str(),
-                                                 RTLD_GLOBAL | RTLD_NOW));
-      // Load the plugin and get the CircuitSimulator.
-      std::string symbolName =
-          fmt::format("getCircuitSimulator_{}", mutableName);
-
-      // Load the simulator
-      auto *simulator =
-          getUniquePluginInstance<nvqir::CircuitSimulator>(symbolName);
-      simulators.erase(mutableName);
-      simulators.emplace(mutableName, simulator);
-      __nvqir__setCircuitSimulator(simulator);
-    }
+  // Set the simulator if we find it. Note the MPI simulator can only be
+  // loaded once in a single python execution context.
+  if (simulators.count(mutableName)) {
+    cudaq::info("Requested QPU = {}", mutableName);
+    __nvqir__setCircuitSimulator(getSimulator(mutableName));
+    return;
   }
 
   // Check if this name is one of our NAME.config files
@@ -203,9 +189,7 @@ void LinkedLibraryHolder::setQPU(const std::string &name,
     // May also need to load a plugin library
     auto potentialPath =
         cudaqLibPath / fmt::format("libcudaq-rest-qpu.{}", libSuffix);
-    libHandles.emplace(
-        potentialPath.string(),
-        dlopen(potentialPath.string().c_str(), RTLD_GLOBAL | RTLD_NOW));
+    loadLibrary(potentialPath);
 
     // Pack the config into the backend string name
     for (auto &[key, value] : config)
@@ -234,9 +218,7 @@ void LinkedLibraryHolder::setPlatform(
   auto potentialPath = cudaqLibPath / fmt::format("libcudaq-platform-{}.{}",
                                                   mutableName, libSuffix);
   if (std::filesystem::exists(potentialPath)) {
-    libHandles.emplace(
-        potentialPath.string(),
-        dlopen(potentialPath.string().c_str(), RTLD_GLOBAL | RTLD_NOW));
+    loadLibrary(potentialPath);
 
     // Extract the desired quantum_platform subtype and set it on the runtime.
     std::string symbolName = fmt::format("getQuantumPlatform_{}", mutableName);
@@ -36,8 +36,23 @@ protected:
   /// handles.
   std::unordered_map<std::string, void *> libHandles;
 
+  /// @brief A simulator plugin library, found by its file name. The library
+  /// is only loaded, and the simulator created, once it is selected.
+  struct SimulatorPlugin {
+    std::filesystem::path path;
+    nvqir::CircuitSimulator *simulator = nullptr;
+  };
+
   /// @brief Map of available simulators
-  std::unordered_map<std::string, nvqir::CircuitSimulator *> simulators;
+  std::unordered_map<std::string, SimulatorPlugin> simulators;
+
+  /// @brief dlopen the library at the given path, once, with lazy binding.
+  /// Return nullptr if it cannot be loaded.
+  void *loadLibrary(const std::filesystem::path &path);
+
+  /// @brief Return the simulator with the given name, loading its plugin
+  /// library on first use.
+  nvqir::CircuitSimulator *getSimulator(const std::string &name);
 
 public:
   LinkedLibraryHolder();
@@ -149,4 +149,28 @@ inline void packArgs(OpaqueArguments &argData, py::args args) {
   }
 }
 
+/// @brief Validate and pack each of the argument sets of a batched call of
+/// the kernel. Each argument set is a tuple of the kernel arguments, or the
+/// single argument of a kernel of one argument. A 2D numpy array holds the
+/// list argument of a kernel of one list argument row by row.
+inline std::vector<OpaqueArguments>
+packArgumentSets(kernel_builder<> &kernel, py::object argumentSets) {
+  if (py::hasattr(argumentSets, "tolist"))
+    argumentSets = argumentSets.attr("tolist")();
+  auto sets = argumentSets.cast<py::list>();
+
+  // Constructed in place, OpaqueArguments must not be copied.
+  std::vector<OpaqueArguments> packedArgs(sets.size());
+  const bool singleArgument = kernel.getNumParams() == 1;
+  for (std::size_t i = 0; i < sets.size(); i++) {
+    py::object set = sets[i];
+    const bool isTuple = py::isinstance<py::tuple>(set);
+    py::args args = singleArgument && !(isTuple && py::len(set) == 1)
+                        ? py::make_tuple(set)
+                        : py::tuple(set);
+    packArgs(packedArgs[i], validateInputArguments(kernel, args));
+  }
+  return packedArgs;
+}
+
 } // namespace cudaq
@@ -0,0 +1,48 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace cudaq {
+
+/// @brief Return a one-dimensional numpy array that takes ownership of the
+/// vector, without copying it. The array exports the data through the buffer
+/// protocol, and pickle protocol 5 ships it out of band.
+template <typename T>
+py::array_t<T> toOwningArray(std::vector<T> &&data) {
+  auto *owned = new std::vector<T>(std::move(data));
+  py::capsule free(owned, [](void *ptr) {
+    delete static_cast<std::vector<T> *>(ptr);
+  });
+  return py::array_t<T>(owned->size(), owned->data(), free);
+}
+
+/// @brief Return the bytes of a C contiguous buffer, e.g. `bytes`, a
+/// `memoryview` or a numpy array, read in place. The request keeps the
+/// buffer alive and must outlive the span.
+inline std::span<const std::uint8_t> toBytes(const py::buffer_info &info) {
+  py::ssize_t expected = info.itemsize;
+  for (py::ssize_t d = info.ndim - 1; d >= 0; d--) {
+    if (info.shape[d] != 1 && info.strides[d] != expected)
+      throw std::runtime_error("Serialized data must be C contiguous.");
+    expected *= info.shape[d];
+  }
+  return {static_cast<const std::uint8_t *>(info.ptr),
+          static_cast<std::size_t>(info.size * info.itemsize)};
+}
+
+} // namespace cudaq
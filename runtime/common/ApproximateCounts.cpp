@@ -0,0 +1,255 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "ApproximateCounts.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace cudaq {
+
+namespace {
+/// @brief The HyperLogLog registers are indexed by this many hash bits.
+constexpr std::size_t hllPrecision = 12;
+
+/// @brief Return the hash of the packed bit string of n words.
+std::uint64_t hashKey(const std::uint64_t *key, std::size_t n) {
+  std::uint64_t h = 0x9e3779b97f4a7c15ULL;
+  for (std::size_t i = 0; i < n; i++) {
+    // splitmix64 finalizer of each word, combined with the running hash.
+    std::uint64_t x = key[i] + h;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    h = x ^ (x >> 31);
+  }
+  return h;
+}
+
+/// @brief Return the column of the hash in the given row of the sketch,
+/// by double hashing.
+std::size_t sketchColumn(std::uint64_t hash, std::size_t row,
+                         std::size_t width) {
+  const std::uint64_t h1 = hash, h2 = (hash >> 32) | 1;
+  return (h1 + row * h2) % width;
+}
+} // namespace
+
+approximate_counts::approximate_counts(counting_policy p)
+    : policy(std::move(p)) {
+  if (policy.top_k == 0 || policy.sketch_width == 0 ||
+      policy.sketch_depth == 0)
+    throw std::runtime_error("A counting policy needs a positive top_k and "
+                             "sketch size.");
+  sketch.assign(policy.sketch_width * policy.sketch_depth, 0);
+  hllRegisters.assign(std::size_t(1) << hllPrecision, 0);
+  for (auto qubits : policy.marginals) {
+    std::sort(qubits.begin(), qubits.end());
+    marginalQubits.push_back(qubits);
+    marginalCounts.emplace_back(qubits.size());
+  }
+}
+
+std::size_t approximate_counts::findTracked(const std::uint64_t *key,
+                                            std::uint64_t hash) const {
+  auto [begin, end] = index.equal_range(hash);
+  for (auto it = begin; it != end; ++it)
+    if (std::equal(key, key + nWords, keys.begin() + it->second * nWords))
+      return it->second;
+  return std::size_t(-1);
+}
+
+void approximate_counts::siftDown(std::size_t position) {
+  const std::size_t n = heap.size();
+  while (true) {
+    std::size_t least = position;
+    for (auto child : {2 * position + 1, 2 * position + 2})
+      if (child < n && keyCounts[heap[child]] < keyCounts[heap[least]])
+        least = child;
+    if (least == position)
+      return;
+    std::swap(heap[position], heap[least]);
+    heapPosition[heap[position]] = position;
+    heapPosition[heap[least]] = least;
+    position = least;
+  }
+}
+
+void approximate_counts::siftUp(std::size_t position) {
+  while (position > 0) {
+    const std::size_t parent = (position - 1) / 2;
+    if (keyCounts[heap[parent]] <= keyCounts[heap[position]])
+      return;
+    std::swap(heap[position], heap[parent]);
+    heapPosition[heap[position]] = position;
+    heapPosition[heap[parent]] = parent;
+    position = parent;
+  }
+}
+
+std::size_t approximate_counts::sketchEstimate(std::uint64_t hash) const {
+  std::size_t estimate = std::numeric_limits<std::size_t>::max();
+  for (std::size_t row = 0; row < policy.sketch_depth; row++)
+    estimate = std::min(
+        estimate, sketch[row * policy.sketch_width +
+                         sketchColumn(hash, row, policy.sketch_width)]);
+  return estimate;
+}
+
+void approximate_counts::add(const std::uint64_t *key, std::size_t bits,
+                             std::size_t count) {
+  if (nWords == 0) {
+    nBits = bits;
+    nWords = std::max<std::size_t>((bits + 63) / 64, 1);
+    for (auto &qubits : marginalQubits)
+      for (auto q : qubits)
+        if (q >= nBits)
+          throw std::runtime_error("Invalid marginal index (" +
+                                   std::to_string(q) +
+                                   ", size=" + std::to_string(nBits) + ").");
+  } else if (bits != nBits)
+    throw std::runtime_error("Cannot count a bit string of " +
+                             std::to_string(bits) + " bits after ones of " +
+                             std::to_string(nBits) + " bits.");
+  if (count == 0)
+    return;
+  shots += count;
+
+  const auto hash = hashKey(key, nWords);
+  for (std::size_t row = 0; row < policy.sketch_depth; row++)
+    sketch[row * policy.sketch_width +
+           sketchColumn(hash, row, policy.sketch_width)] += count;
+  auto &hll = hllRegisters[hash >> (64 - hllPrecision)];
+  // The rank of the remaining hash bits, at most 64 - hllPrecision + 1.
+  const std::uint64_t rest =
+      (hash << hllPrecision) | (1ULL << (hllPrecision - 1));
+  hll = std::max<std::uint8_t>(hll, std::countl_zero(rest) + 1);
+
+  std::vector<std::uint64_t> marginalKey;
+  for (std::size_t m = 0; m < marginalQubits.size(); m++) {
+    auto &qubits = marginalQubits[m];
+    marginalKey.assign(marginalCounts[m].n_words(), 0);
+    for (std::size_t j = 0; j < qubits.size(); j++)
+      if ((key[qubits[j] / 64] >> (qubits[j] % 64)) & 1)
+        marginalKey[j / 64] |= 1ULL << (j % 64);
+    marginalCounts[m].add(marginalKey.data(), count);
+  }
+
+  // Space-Saving: count a tracked bit string, track a new one while there
+  // is room, or else replace the one of the least count.
+  if (auto slot = findTracked(key, hash); slot != std::size_t(-1)) {
+    keyCounts[slot] += count;
+    siftDown(heapPosition[slot]);
+    return;
+  }
+  if (keyCounts.size() < policy.top_k) {
+    const std::size_t slot = keyCounts.size();
+    keys.insert(keys.end(), key, key + nWords);
+    keyCounts.push_back(count);
+    keyErrors.push_back(0);
+    heap.push_back(slot);
+    heapPosition.push_back(heap.size() - 1);
+    index.insert({hash, slot});
+    siftUp(heap.size() - 1);
+    return;
+  }
+  evicted = true;
+  const std::size_t slot = heap.front();
+  const auto *old = keys.data() + slot * nWords;
+  auto [begin, end] = index.equal_range(hashKey(old, nWords));
+  for (auto it = begin; it != end; ++it)
+    if (it->second == slot) {
+      index.erase(it);
+      break;
+    }
+  std::copy_n(key, nWords, keys.begin() + slot * nWords);
+  keyErrors[slot] = keyCounts[slot];
+  keyCounts[slot] += count;
+  index.insert({hash, slot});
+  siftDown(0);
+}
+
+void approximate_counts::add(std::string_view bits, std::size_t count) {
+  std::vector<std::uint64_t> key(
+      std::max<std::size_t>((bits.size() + 63) / 64, 1), 0);
+  for (std::size_t j = 0; j < bits.size(); j++)
+    if (bits[j] == '1')
+      key[j / 64] |= 1ULL << (j % 64);
+    else if (bits[j] != '0')
+      throw std::runtime_error("Invalid bit string " + std::string(bits) +
+                               ".");
+  add(key.data(), bits.size(), count);
+}
+
+std::vector<heavy_hitter> approximate_counts::top_k() const {
+  std::vector<heavy_hitter> hitters(keyCounts.size());
+  for (std::size_t slot = 0; slot < keyCounts.size(); slot++) {
+    auto &hitter = hitters[slot];
+    hitter.bit_string.assign(nBits, '0');
+    for (std::size_t j = 0; j < nBits; j++)
+      if ((keys[slot * nWords + j / 64] >> (j % 64)) & 1)
+        hitter.bit_string[j] = '1';
+    hitter.count = keyCounts[slot];
+    hitter.max_error = keyErrors[slot];
+  }
+  std::stable_sort(hitters.begin(), hitters.end(),
+                   [](const heavy_hitter &a, const heavy_hitter &b) {
+                     return a.count > b.count;
+                   });
+  return hitters;
+}
+
+std::size_t approximate_counts::estimate(std::string_view bits) const {
+  if (bits.size() != nBits)
+    return 0;
+  std::vector<std::uint64_t> key(nWords, 0);
+  for (std::size_t j = 0; j < bits.size(); j++)
+    if (bits[j] == '1')
+      key[j / 64] |= 1ULL << (j % 64);
+  const auto hash = hashKey(key.data(), nWords);
+  if (auto slot = findTracked(key.data(), hash); slot != std::size_t(-1))
+    return keyCounts[slot];
+  if (!evicted)
+    return 0;
+  // An untracked bit string was counted at most the least tracked count.
+  return std::min(sketchEstimate(hash), keyCounts[heap.front()]);
+}
+
+double approximate_counts::distinct() const {
+  if (!evicted)
+    return keyCounts.size();
+  const double m = hllRegisters.size();
+  double sum = 0.0;
+  std::size_t zeros = 0;
+  for (auto r : hllRegisters) {
+    sum += std::ldexp(1.0, -int(r));
+    zeros += r == 0;
+  }
+  const double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+  // Linear counting for small cardinalities.
+  if (estimate <= 2.5 * m && zeros)
+    return m * std::log(m / zeros);
+  return estimate;
+}
+
+sample_result
+approximate_counts::marginal(const std::vector<std::size_t> &qubits) const {
+  auto sorted = qubits;
+  std::sort(sorted.begin(), sorted.end());
+  auto iter = std::find(marginalQubits.begin(), marginalQubits.end(), sorted);
+  if (iter == marginalQubits.end())
+    throw std::runtime_error("The marginal counts of these qubits are not "
+                             "kept by the counting policy.");
+  ExecutionResult result;
+  result.packedCounts = marginalCounts[iter - marginalQubits.begin()];
+  return sample_result(std::move(result));
+}
+
+} // namespace cudaq
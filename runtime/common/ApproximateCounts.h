@@ -0,0 +1,119 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "MeasureCounts.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cudaq {
+
+/// @brief How to count sampled bit strings in bounded memory, for sample
+/// spaces too large to keep a count per observed bit string.
+struct counting_policy {
+  /// @brief The number of most frequent bit strings counted individually.
+  std::size_t top_k = 1024;
+
+  /// @brief The counters per row and the rows of the Count-Min sketch that
+  /// estimates the counts of all other bit strings.
+  std::size_t sketch_width = 4096;
+  std::size_t sketch_depth = 4;
+
+  /// @brief The qubit subsets whose marginal counts are kept exactly. These
+  /// take 2^(subset size) counts at most.
+  std::vector<std::vector<std::size_t>> marginals;
+};
+
+/// @brief A bit string counted individually by approximate_counts. Its true
+/// count lies in [count - max_error, count].
+struct heavy_hitter {
+  std::string bit_string;
+  std::size_t count = 0;
+  std::size_t max_error = 0;
+};
+
+/// @brief Counts of sampled bit strings in memory bounded by a
+/// counting_policy rather than by the number of distinct bit strings.
+///
+/// The most frequent bit strings are tracked with the Space-Saving algorithm:
+/// top_k counters, where a new bit string replaces the one of the least
+/// count and inherits that count as its error, so any bit string seen more
+/// than shots / top_k times is tracked. A Count-Min sketch overestimates the
+/// count of every other bit string, and a HyperLogLog sketch estimates the
+/// number of distinct bit strings. Until more than top_k distinct bit strings
+/// are seen all counts are exact.
+class approximate_counts {
+  counting_policy policy;
+  std::size_t nBits = 0;
+  std::size_t nWords = 0;
+  std::size_t shots = 0;
+  bool evicted = false;
+
+  /// @brief The tracked bit strings, packed back to back, with their counts
+  /// and errors.
+  std::vector<std::uint64_t> keys;
+  std::vector<std::size_t> keyCounts;
+  std::vector<std::size_t> keyErrors;
+  /// @brief Min-heap of the tracked bit strings by count, and the position
+  /// of each one in it.
+  std::vector<std::size_t> heap;
+  std::vector<std::size_t> heapPosition;
+  /// @brief The tracked bit strings by hash.
+  std::unordered_multimap<std::uint64_t, std::size_t> index;
+
+  std::vector<std::size_t> sketch;
+  std::vector<std::uint8_t> hllRegisters;
+
+  /// @brief The exact marginal counts of the requested qubit subsets.
+  std::vector<std::vector<std::size_t>> marginalQubits;
+  std::vector<PackedCounts> marginalCounts;
+
+  std::size_t findTracked(const std::uint64_t *key, std::uint64_t hash) const;
+  void siftDown(std::size_t position);
+  void siftUp(std::size_t position);
+  std::size_t sketchEstimate(std::uint64_t hash) const;
+
+public:
+  /// @brief Construct empty counts with the given policy.
+  explicit approximate_counts(counting_policy policy = {});
+
+  /// @brief Add the count to the packed bit string (see PackedCounts) of the
+  /// given length. All bit strings must have the same length.
+  void add(const std::uint64_t *key, std::size_t bits, std::size_t count = 1);
+
+  /// @brief Add the count to the bit string of '0' and '1' characters.
+  void add(std::string_view bits, std::size_t count = 1);
+
+  /// @brief Return the total number of shots added.
+  std::size_t total_shots() const { return shots; }
+
+  /// @brief Return true if no bit string has been dropped, so that
+  /// top_k() holds the exact counts of all bit strings.
+  bool is_exact() const { return !evicted; }
+
+  /// @brief Return the tracked bit strings from most to least frequent.
+  std::vector<heavy_hitter> top_k() const;
+
+  /// @brief Return an upper bound of the count of the bit string, which is
+  /// exact if is_exact().
+  std::size_t estimate(std::string_view bits) const;
+
+  /// @brief Return the number of distinct bit strings, exact if is_exact()
+  /// and estimated to about 1.6% otherwise.
+  double distinct() const;
+
+  /// @brief Return the exact marginal counts of the given qubits, which must
+  /// be one of the subsets of the policy.
+  sample_result marginal(const std::vector<std::size_t> &qubits) const;
+};
+
+} // namespace cudaq
@@ -0,0 +1,325 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "ColumnarResult.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+namespace cudaq {
+
+namespace {
+constexpr bool hostIsLittleEndian = std::endian::native == std::endian::little;
+
+void store(std::uint8_t *p, std::uint64_t value, std::size_t bytes) {
+  for (std::size_t b = 0; b < bytes; b++)
+    p[b] = static_cast<std::uint8_t>(value >> (8 * b));
+}
+
+std::uint64_t load(const std::uint8_t *p, std::size_t bytes) {
+  std::uint64_t value = 0;
+  for (std::size_t b = 0; b < bytes; b++)
+    value |= std::uint64_t(p[b]) << (8 * b);
+  return value;
+}
+
+std::size_t padded(std::size_t n) { return (n + 7) / 8 * 8; }
+
+/// @brief Return the bytes per count needed for the largest count.
+std::size_t countWidth(std::uint64_t maxCount) {
+  if (maxCount <= std::numeric_limits<std::uint8_t>::max())
+    return 1;
+  if (maxCount <= std::numeric_limits<std::uint16_t>::max())
+    return 2;
+  if (maxCount <= std::numeric_limits<std::uint32_t>::max())
+    return 4;
+  return 8;
+}
+
+/// @brief A register as it is laid out in the buffer.
+struct RegisterLayout {
+  const std::string *name;
+  const ExecutionResult *result;
+  std::size_t nameOffset = 0;
+  std::size_t nBits = 0;
+  std::size_t nKeys = 0;
+  std::size_t keyBytes = 0;
+  std::size_t countBytes = 0;
+  std::size_t keysOffset = 0;
+  std::size_t countsOffset = 0;
+};
+} // namespace
+
+namespace columnar {
+
+void write(const sample_result &result, const writer &out, bool compress) {
+  result.materializeAll();
+  // The global register comes first, the others by name.
+  std::vector<RegisterLayout> layouts;
+  for (auto &[name, r] : result.sampleResults) {
+    r.packCounts();
+    if (!r.isPacked() && !r.counts.empty())
+      throw std::runtime_error("Cannot write register " + name +
+                               " in the columnar format, its bit strings "
+                               "differ in length.");
+    layouts.push_back({&name, &r});
+  }
+  std::sort(layouts.begin(), layouts.end(),
+            [](const RegisterLayout &a, const RegisterLayout &b) {
+              if ((*a.name == GlobalRegisterName) !=
+                  (*b.name == GlobalRegisterName))
+                return *a.name == GlobalRegisterName;
+              return *a.name < *b.name;
+            });
+
+  std::size_t offset = headerSize + layouts.size() * tableEntrySize;
+  for (auto &layout : layouts) {
+    layout.nameOffset = offset;
+    offset += layout.name->size();
+  }
+  offset = padded(offset);
+  for (auto &layout : layouts) {
+    auto &counts = layout.result->packedCounts;
+    layout.nBits = counts.n_bits();
+    layout.nKeys = counts.size();
+    if (compress) {
+      std::size_t maxCount = 0;
+      for (std::size_t i = 0; i < counts.size(); i++)
+        maxCount = std::max(maxCount, counts.count(i));
+      layout.keyBytes = std::max<std::size_t>((layout.nBits + 7) / 8, 1);
+      layout.countBytes = countWidth(maxCount);
+    } else {
+      layout.keyBytes = 8 * std::max<std::size_t>((layout.nBits + 63) / 64, 1);
+      layout.countBytes = 8;
+    }
+    if (layout.keyBytes > std::numeric_limits<std::uint16_t>::max())
+      throw std::runtime_error("Cannot write bit strings of " +
+                               std::to_string(layout.nBits) +
+                               " bits in the columnar format.");
+    layout.keysOffset = offset;
+    offset = padded(offset + layout.nKeys * layout.keyBytes);
+    layout.countsOffset = offset;
+    offset = padded(offset + layout.nKeys * layout.countBytes);
+  }
+  const std::size_t totalBytes = offset;
+
+  // Header, table and names.
+  std::vector<std::uint8_t> head(padded(
+      layouts.empty() ? headerSize
+                      : layouts.back().nameOffset + layouts.back().name->size()));
+  std::memcpy(head.data(), magic, sizeof(magic));
+  store(&head[4], version, 2);
+  store(&head[6], compress ? compressed : 0, 2);
+  store(&head[8], layouts.size(), 4);
+  store(&head[16], result.totalShots, 8);
+  store(&head[24], totalBytes, 8);
+  for (std::size_t r = 0; r < layouts.size(); r++) {
+    auto &layout = layouts[r];
+    auto *entry = &head[headerSize + r * tableEntrySize];
+    store(entry, layout.nameOffset, 8);
+    store(entry + 8, layout.name->size(), 4);
+    store(entry + 12, layout.nBits, 4);
+    store(entry + 16, layout.nKeys, 8);
+    store(entry + 24, layout.keysOffset, 8);
+    store(entry + 32, layout.countsOffset, 8);
+    store(entry + 40, layout.keyBytes, 2);
+    store(entry + 42, layout.countBytes, 2);
+    const auto &expectation = layout.result->expectationValue;
+    store(entry + 44, expectation ? has_expectation : 0, 4);
+    store(entry + 48, std::bit_cast<std::uint64_t>(expectation.value_or(0.0)),
+          8);
+    std::memcpy(&head[layout.nameOffset], layout.name->data(),
+                layout.name->size());
+  }
+  out(head.data(), head.size());
+
+  // The columns, staged in chunks unless they can be written in place.
+  std::vector<std::uint8_t> chunk;
+  auto writeColumn = [&](std::size_t n, std::size_t width, auto &&fill) {
+    constexpr std::size_t chunkBytes = 1 << 16;
+    const std::size_t perChunk = std::max<std::size_t>(chunkBytes / width, 1);
+    for (std::size_t first = 0; first < n; first += perChunk) {
+      const std::size_t last = std::min(n, first + perChunk);
+      chunk.assign((last - first) * width, 0);
+      for (std::size_t i = first; i < last; i++)
+        fill(i, &chunk[(i - first) * width]);
+      out(chunk.data(), chunk.size());
+    }
+    const std::uint64_t zeros = 0;
+    if (auto pad = padded(n * width) - n * width)
+      out(&zeros, pad);
+  };
+  for (auto &layout : layouts) {
+    auto &counts = layout.result->packedCounts;
+    if (hostIsLittleEndian && !compress && layout.nKeys > 0)
+      out(counts.key(0), layout.nKeys * layout.keyBytes);
+    else
+      writeColumn(layout.nKeys, layout.keyBytes,
+                  [&](std::size_t i, std::uint8_t *p) {
+                    for (std::size_t b = 0; b < layout.keyBytes; b++)
+                      p[b] = counts.key(i)[b / 8] >> (8 * (b % 8));
+                  });
+    writeColumn(layout.nKeys, layout.countBytes,
+                [&](std::size_t i, std::uint8_t *p) {
+                  store(p, counts.count(i), layout.countBytes);
+                });
+  }
+}
+
+void write(const sample_result &result, std::ostream &os, bool compress) {
+  write(
+      result,
+      [&](const void *data, std::size_t size) {
+        os.write(static_cast<const char *>(data), size);
+      },
+      compress);
+  if (!os)
+    throw std::runtime_error("Could not write the columnar sample result.");
+}
+
+std::vector<std::uint8_t> serialize(const sample_result &result,
+                                    bool compress) {
+  std::vector<std::uint8_t> buffer;
+  write(
+      result,
+      [&](const void *data, std::size_t size) {
+        auto *bytes = static_cast<const std::uint8_t *>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+      },
+      compress);
+  return buffer;
+}
+} // namespace columnar
+
+std::size_t columnar_register::count(std::size_t i) const {
+  return load(counts + i * countBytes, countBytes);
+}
+
+std::string columnar_register::bit_string(std::size_t i) const {
+  std::string bits(nBits, '0');
+  for (std::size_t j = 0; j < nBits; j++)
+    if (bit(i, j))
+      bits[j] = '1';
+  return bits;
+}
+
+const std::uint64_t *columnar_register::key(std::size_t i) const {
+  if (!hostIsLittleEndian || keyBytes % 8 ||
+      reinterpret_cast<std::uintptr_t>(keys) % alignof(std::uint64_t))
+    return nullptr;
+  return reinterpret_cast<const std::uint64_t *>(keys + i * keyBytes);
+}
+
+void columnar_register::copy_key(std::size_t i, std::uint64_t *words) const {
+  const std::size_t nWords = std::max<std::size_t>((nBits + 63) / 64, 1);
+  std::fill_n(words, nWords, 0);
+  const auto *p = keys + i * keyBytes;
+  for (std::size_t b = 0; b < std::min(keyBytes, 8 * nWords); b++)
+    words[b / 8] |= std::uint64_t(p[b]) << (8 * (b % 8));
+}
+
+std::optional<double> columnar_register::expectation_value() const {
+  if (flags & columnar::has_expectation)
+    return expectation;
+  return std::nullopt;
+}
+
+sample_result_view::sample_result_view(const void *buffer, std::size_t size)
+    : data(static_cast<const std::uint8_t *>(buffer)), nBytes(size) {
+  auto invalid = [](const std::string &why) {
+    return std::runtime_error("Invalid columnar sample result: " + why + ".");
+  };
+  if (nBytes < columnar::headerSize ||
+      std::memcmp(data, columnar::magic, sizeof(columnar::magic)))
+    throw invalid("bad header");
+  const auto fileVersion = load(data + 4, 2);
+  if (fileVersion != columnar::version)
+    throw invalid("unknown version " + std::to_string(fileVersion));
+  flags = load(data + 6, 2);
+  const std::size_t nRegisters = load(data + 8, 4);
+  shots = load(data + 16, 8);
+  const std::size_t totalBytes = load(data + 24, 8);
+  if (totalBytes > nBytes)
+    throw invalid("truncated buffer");
+  nBytes = totalBytes;
+
+  // Check that [offset, offset + n * width) lies in the buffer.
+  auto inBuffer = [&](std::size_t offset, std::size_t n, std::size_t width) {
+    return offset <= nBytes && (width == 0 || n <= (nBytes - offset) / width);
+  };
+  if (!inBuffer(columnar::headerSize, nRegisters, columnar::tableEntrySize))
+    throw invalid("truncated register table");
+  registers.resize(nRegisters);
+  for (std::size_t r = 0; r < nRegisters; r++) {
+    const auto *entry =
+        data + columnar::headerSize + r * columnar::tableEntrySize;
+    auto &reg = registers[r];
+    const std::size_t nameOffset = load(entry, 8);
+    const std::size_t nameLength = load(entry + 8, 4);
+    reg.nBits = load(entry + 12, 4);
+    reg.nKeys = load(entry + 16, 8);
+    const std::size_t keysOffset = load(entry + 24, 8);
+    const std::size_t countsOffset = load(entry + 32, 8);
+    reg.keyBytes = load(entry + 40, 2);
+    reg.countBytes = load(entry + 42, 2);
+    reg.flags = load(entry + 44, 4);
+    reg.expectation = std::bit_cast<double>(load(entry + 48, 8));
+
+    if (!inBuffer(nameOffset, nameLength, 1))
+      throw invalid("register name out of bounds");
+    reg.registerName = std::string_view(
+        reinterpret_cast<const char *>(data + nameOffset), nameLength);
+    if (reg.keyBytes < std::max<std::size_t>((reg.nBits + 7) / 8, 1) ||
+        !std::has_single_bit(reg.countBytes) || reg.countBytes > 8)
+      throw invalid("bad column widths of register " +
+                    std::string(reg.registerName));
+    if (!inBuffer(keysOffset, reg.nKeys, reg.keyBytes) ||
+        !inBuffer(countsOffset, reg.nKeys, reg.countBytes))
+      throw invalid("columns of register " + std::string(reg.registerName) +
+                    " out of bounds");
+    reg.keys = data + keysOffset;
+    reg.counts = data + countsOffset;
+  }
+}
+
+const columnar_register *
+sample_result_view::find_register(std::string_view name) const {
+  for (auto &reg : registers)
+    if (reg.name() == name)
+      return &reg;
+  return nullptr;
+}
+
+sample_result sample_result_view::to_sample_result() const {
+  sample_result result;
+  for (auto &reg : registers) {
+    ExecutionResult r{std::string(reg.name())};
+    r.expectationValue = reg.expectation_value();
+    if (reg.size() > 0) {
+      r.packedCounts = PackedCounts(reg.n_bits());
+      r.packedCounts.reserve(reg.size());
+      std::vector<std::uint64_t> words(r.packedCounts.n_words());
+      for (std::size_t i = 0; i < reg.size(); i++) {
+        const auto *key = reg.key(i);
+        if (!key) {
+          reg.copy_key(i, words.data());
+          key = words.data();
+        }
+        r.packedCounts.add(key, reg.count(i));
+      }
+    }
+    result.sampleResults.insert({r.registerName, std::move(r)});
+  }
+  result.totalShots = shots;
+  return result;
+}
+} // namespace cudaq
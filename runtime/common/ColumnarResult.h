@@ -0,0 +1,161 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "MeasureCounts.h"
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cudaq {
+
+/// @brief The columnar binary format of a sample_result. All integers are
+/// little-endian and every section starts at a multiple of 8 bytes.
+///
+///   header   (32 bytes): magic "CQSR", u16 version, u16 flags,
+///                        u32 number of registers, u32 reserved,
+///                        u64 total shots, u64 size of the whole buffer
+///   table    (56 bytes per register): u64 name offset, u32 name length,
+///                        u32 bits per bit string, u64 number of bit strings,
+///                        u64 keys offset, u64 counts offset,
+///                        u16 bytes per key, u16 bytes per count,
+///                        u32 register flags, f64 expectation value
+///   names    the register names back to back
+///   columns  per register, the keys of its bit strings back to back, then
+///            their counts
+///
+/// Offsets are from the start of the buffer. A key holds a packed bit string
+/// (see PackedCounts) as little-endian bytes, i.e. bit j is bit j % 8 of byte
+/// j / 8. Without compression a key takes whole 64-bit words and a count 8
+/// bytes, so on little-endian hosts the keys are read in place as the words
+/// of PackedCounts. With compression a key takes just enough bytes for its
+/// bits and a count just enough of 1, 2, 4 or 8 bytes for the largest count,
+/// which keeps the columns fixed width and so randomly accessible.
+namespace columnar {
+inline constexpr char magic[4] = {'C', 'Q', 'S', 'R'};
+inline constexpr std::uint16_t version = 1;
+inline constexpr std::size_t headerSize = 32;
+inline constexpr std::size_t tableEntrySize = 56;
+
+/// @brief Header flags.
+enum flags : std::uint16_t { compressed = 1 };
+
+/// @brief Register flags.
+enum register_flags : std::uint32_t { has_expectation = 1 };
+
+/// @brief Receives the bytes of a columnar buffer in order, e.g. to write
+/// them to a file or socket.
+using writer = std::function<void(const void *data, std::size_t size)>;
+
+/// @brief Write the sample result in the columnar format. The bit strings of
+/// each register must have one length. The buffer is written section by
+/// section, without being assembled in memory, and the total size is known
+/// up front, so the consumer can rely on the header. Sequential data is not
+/// written.
+void write(const sample_result &result, const writer &out,
+           bool compress = false);
+
+/// @brief Write the sample result in the columnar format to the stream.
+void write(const sample_result &result, std::ostream &os,
+           bool compress = false);
+
+/// @brief Return the sample result in the columnar format.
+std::vector<std::uint8_t> serialize(const sample_result &result,
+                                    bool compress = false);
+} // namespace columnar
+
+/// @brief A read-only view of one register of a columnar buffer.
+class columnar_register {
+  std::string_view registerName;
+  std::size_t nBits = 0;
+  std::size_t nKeys = 0;
+  std::size_t keyBytes = 0;
+  std::size_t countBytes = 0;
+  const std::uint8_t *keys = nullptr;
+  const std::uint8_t *counts = nullptr;
+  std::uint32_t flags = 0;
+  double expectation = 0.0;
+
+  friend class sample_result_view;
+
+public:
+  /// @brief Return the register name, pointing into the buffer.
+  std::string_view name() const { return registerName; }
+
+  /// @brief Return the length of the bit strings.
+  std::size_t n_bits() const { return nBits; }
+
+  /// @brief Return the number of distinct bit strings.
+  std::size_t size() const { return nKeys; }
+
+  /// @brief Return the count of the i-th bit string.
+  std::size_t count(std::size_t i) const;
+
+  /// @brief Return bit j of the i-th bit string.
+  bool bit(std::size_t i, std::size_t j) const {
+    return (keys[i * keyBytes + j / 8] >> (j % 8)) & 1;
+  }
+
+  /// @brief Return the i-th bit string as '0' and '1' characters.
+  std::string bit_string(std::size_t i) const;
+
+  /// @brief Return the i-th bit string as packed words in place, if the
+  /// buffer is uncompressed and the host little-endian, else nullptr.
+  const std::uint64_t *key(std::size_t i) const;
+
+  /// @brief Copy the i-th bit string into the given packed words.
+  void copy_key(std::size_t i, std::uint64_t *words) const;
+
+  /// @brief Return the expectation value, if one was stored.
+  std::optional<double> expectation_value() const;
+};
+
+/// @brief A read-only view of a sample result in the columnar format. The
+/// buffer is validated on construction and then read in place, so it must
+/// outlive the view.
+class sample_result_view {
+  const std::uint8_t *data = nullptr;
+  std::size_t nBytes = 0;
+  std::uint16_t flags = 0;
+  std::size_t shots = 0;
+  std::vector<columnar_register> registers;
+
+public:
+  /// @brief View the given buffer, which must hold a complete columnar
+  /// sample result of a known version. Throws if it does not.
+  sample_result_view(const void *buffer, std::size_t size);
+  explicit sample_result_view(const std::vector<std::uint8_t> &buffer)
+      : sample_result_view(buffer.data(), buffer.size()) {}
+
+  /// @brief Return true if the columns are compressed.
+  bool is_compressed() const { return flags & columnar::compressed; }
+
+  /// @brief Return the total number of shots.
+  std::size_t total_shots() const { return shots; }
+
+  /// @brief Return the number of registers.
+  std::size_t n_registers() const { return registers.size(); }
+
+  /// @brief Return the i-th register.
+  const columnar_register &get_register(std::size_t i) const {
+    return registers[i];
+  }
+
+  /// @brief Return the register of the given name, or nullptr.
+  const columnar_register *
+  find_register(std::string_view name = GlobalRegisterName) const;
+
+  /// @brief Copy the buffer into a sample_result, with packed counts.
+  sample_result to_sample_result() const;
+};
+
+} // namespace cudaq
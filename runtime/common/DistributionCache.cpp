@@ -0,0 +1,133 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "DistributionCache.h"
+#include <bit>
+#include <random>
+#include <stdexcept>
+
+namespace cudaq {
+
+AliasTable::AliasTable(const std::vector<double> &probabilities,
+                       std::size_t nBits)
+    : nBits(nBits) {
+  double total = 0.0;
+  for (auto p : probabilities)
+    if (p > 0.0)
+      total += p;
+  if (total <= 0.0)
+    throw std::runtime_error("Cannot sample a distribution of zero mass.");
+
+  std::vector<double> scaled;
+  for (std::size_t i = 0; i < probabilities.size(); i++)
+    if (probabilities[i] > 0.0) {
+      outcomes.push_back(i);
+      scaled.push_back(probabilities[i] / total);
+      expectationValue += (std::popcount(i) % 2 ? -1.0 : 1.0) *
+                          probabilities[i] / total;
+    }
+
+  // Vose: pair each column under the mean with one above it, which gives
+  // the column its missing mass.
+  const auto n = outcomes.size();
+  keep.assign(n, 1.0);
+  aliases.resize(n);
+  std::vector<std::uint32_t> small, large;
+  for (std::size_t i = 0; i < n; i++) {
+    scaled[i] *= n;
+    aliases[i] = i;
+    (scaled[i] < 1.0 ? small : large).push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    auto s = small.back();
+    auto l = large.back();
+    small.pop_back();
+    keep[s] = scaled[s];
+    aliases[s] = l;
+    scaled[l] -= 1.0 - scaled[s];
+    if (scaled[l] < 1.0) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+}
+
+ExecutionResult AliasTable::sample(std::size_t shots,
+                                   std::optional<std::uint64_t> seed) const {
+  std::mt19937_64 gen(seed ? *seed : std::random_device{}());
+  std::uniform_int_distribution<std::size_t> column(0, outcomes.size() - 1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::unordered_map<std::uint64_t, std::size_t> counts;
+  for (std::size_t shot = 0; shot < shots; shot++) {
+    auto c = column(gen);
+    counts[outcomes[uniform(gen) < keep[c] ? c : aliases[c]]]++;
+  }
+
+  ExecutionResult result(expectationValue);
+  for (auto [outcome, count] : counts)
+    result.appendResult(&outcome, nBits, count);
+  return result;
+}
+
+void DistributionCache::evict() {
+  while (entries.size() > capacity) {
+    index.erase(entries.back().first);
+    entries.pop_back();
+  }
+}
+
+bool DistributionCache::enabled() {
+  std::lock_guard lock(mutex);
+  return capacity > 0;
+}
+
+void DistributionCache::setCapacity(std::size_t newCapacity) {
+  std::lock_guard lock(mutex);
+  capacity = newCapacity;
+  evict();
+}
+
+void DistributionCache::clear() {
+  std::lock_guard lock(mutex);
+  index.clear();
+  entries.clear();
+  hitCount = 0;
+}
+
+std::size_t DistributionCache::hits() {
+  std::lock_guard lock(mutex);
+  return hitCount;
+}
+
+std::shared_ptr<const AliasTable>
+DistributionCache::find(const std::string &key) {
+  std::lock_guard lock(mutex);
+  auto iter = index.find(key);
+  if (iter == index.end())
+    return nullptr;
+  entries.splice(entries.begin(), entries, iter->second);
+  hitCount++;
+  return iter->second->second;
+}
+
+void DistributionCache::insert(std::string key,
+                               std::shared_ptr<const AliasTable> table) {
+  std::lock_guard lock(mutex);
+  if (capacity == 0 || index.count(key))
+    return;
+  entries.emplace_front(std::move(key), std::move(table));
+  index.emplace(entries.front().first, entries.begin());
+  evict();
+}
+
+DistributionCache &getDistributionCache() {
+  static DistributionCache cache;
+  return cache;
+}
+
+} // namespace cudaq
@@ -0,0 +1,83 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "MeasureCounts.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cudaq {
+
+/// @brief The outcome distribution of a sampled kernel, drawn from in
+/// constant time per shot with Vose's alias method. Only the outcomes of
+/// nonzero probability are kept.
+class AliasTable {
+  std::size_t nBits = 0;
+  std::vector<std::uint64_t> outcomes;
+  /// The probability of keeping a drawn column rather than taking its alias.
+  std::vector<double> keep;
+  std::vector<std::uint32_t> aliases;
+  double expectationValue = 0.0;
+
+public:
+  /// @brief Build the table of the (unnormalized) `probabilities` of the
+  /// outcomes of `nBits` bits, bit j of an outcome the value of bit j at
+  /// index j.
+  AliasTable(const std::vector<double> &probabilities, std::size_t nBits);
+
+  /// @brief Draw `shots` outcomes, from the random generator seeded with
+  /// `seed` if given. The result holds the parity expectation value of the
+  /// distribution, as a sampling simulator computes it.
+  ExecutionResult sample(std::size_t shots,
+                         std::optional<std::uint64_t> seed) const;
+};
+
+/// @brief A bounded, least recently used cache of the outcome distributions
+/// of sampled kernels, so that sampling the same kernel with the same
+/// arguments again only draws the shots, see set_sample_cache_capacity().
+class DistributionCache {
+  std::mutex mutex;
+  std::size_t capacity = 0;
+  std::size_t hitCount = 0;
+  /// The entries, most recently used first.
+  std::list<std::pair<std::string, std::shared_ptr<const AliasTable>>>
+      entries;
+  std::unordered_map<std::string_view, decltype(entries)::iterator> index;
+
+  void evict();
+
+public:
+  bool enabled();
+
+  /// @brief Set the maximum number of entries, evicting the least recently
+  /// used ones beyond it. Zero disables and empties the cache.
+  void setCapacity(std::size_t newCapacity);
+
+  void clear();
+
+  /// @brief The number of lookups answered from the cache since the last
+  /// clear().
+  std::size_t hits();
+
+  std::shared_ptr<const AliasTable> find(const std::string &key);
+
+  void insert(std::string key, std::shared_ptr<const AliasTable> table);
+};
+
+/// @brief Return the distribution cache of the process.
+DistributionCache &getDistributionCache();
+
+} // namespace cudaq
@@ -11,17 +11,15 @@
 #include "Future.h"
 #include "MeasureCounts.h"
 #include "NoiseModel.h"
+#include "ShotStream.h"
+#include "SimulationState.h"
+#include <memory>
 #include <optional>
 #include <string_view>
 
 namespace cudaq {
 class spin_op;
 
-// A State is the vector of data for the density matrix or state vector,
-// as well as the array shape (n,n) or (n)
-using State =
-    std::tuple<std::vector<std::size_t>, std::vector<std::complex<double>>>;
-
 /// @brief The ExecutionContext is an abstraction to indicate
 /// how a CUDA Quantum kernel should be executed.
 class ExecutionContext {
@@ -41,6 +39,10 @@ public:
   /// @brief A computed expectation value
   std::optional<double> expectationValue = std::nullopt;
 
+  /// @brief The covariances of the terms of an observe that were measured on
+  /// the same shots, for the shot noise of the expectation value.
+  std::vector<shot_covariance> shotCovariances;
+
   /// @brief The kernel being executed in this context
   /// has conditional statements on measure results.
   bool hasConditionalsOnMeasureResults = false;
@@ -49,10 +51,96 @@ public:
   /// current execution.
   noise_model *noiseModel = nullptr;
 
+  /// @brief The odd factor the noise of the kernel is scaled by for
+  /// zero-noise extrapolation: every gate G is applied as G (G† G)^k with
+  /// k = (foldScale - 1) / 2.
+  std::size_t foldScale = 1;
+
   /// @brief Flag to indicate if backend can
   /// handle spin_op observe task under this ExecutionContext.
   bool canHandleObserve = false;
 
+  /// @brief Under the "observe" context, have the expectation value of every
+  /// term of `spin` in the result, as a register named after the term (see
+  /// spin_op::term_view::to_string(false)), even if the backend handles the
+  /// observe task. This observes several spin_ops at once, on the union of
+  /// their terms.
+  bool termExpectations = false;
+
+  /// @brief Flag set by the backend if it simulates the noise model
+  /// with quantum trajectories. Every shot then samples its own noise
+  /// realization, so sampling executes the kernel once per shot.
+  bool hasNoiseTrajectories = false;
+
+  /// @brief Flag set by the backend if the kernel executions of a per-shot
+  /// sampling may run concurrently on several threads, each with a
+  /// simulator of its own.
+  bool concurrentShots = false;
+
+  /// @brief The number of kernel executions observed as one batch, and the
+  /// index of the current one (zero if this is not a batched observation).
+  std::size_t batchSize = 0;
+  std::size_t batchIndex = 0;
+
+  /// @brief Backends that observe a whole batch at once store the results
+  /// of all its executions here at the last one.
+  std::vector<ExecutionResult> batchResults;
+
+  /// @brief The parameters of the gates of the kernel, in order, set by
+  /// backends under the "adjoint-gradient" and "record-gates" contexts.
+  std::vector<double> gateParameters;
+
+  /// @brief The derivative of the expectation value of `spin` with respect
+  /// to each of the gateParameters, set under the "adjoint-gradient"
+  /// context. Empty if the backend could not differentiate the kernel.
+  std::vector<double> gateParameterGradient;
+
+  /// @brief Under the "overlap" context, which runs two kernels, set once
+  /// the backend keeps the state of the first one, and then the overlap
+  /// <a|b> of that state with the state of the second one.
+  bool overlapPrepared = false;
+  std::optional<std::complex<double>> overlap;
+
+  /// @brief Under the "amplitudes" context, the indices of the basis states
+  /// whose amplitudes are requested, in the order of the elements of
+  /// cudaq::state, and the amplitudes the backend sets.
+  std::vector<std::size_t> amplitudeIndices;
+  std::vector<std::complex<double>> amplitudes;
+
+  /// @brief Under the "probabilities" context, the qubits whose marginal
+  /// probabilities are requested, and the probabilities the backend sets,
+  /// of the outcome with bit j holding the value of probabilityQubits[j] at
+  /// index j.
+  std::vector<std::size_t> probabilityQubits;
+  std::vector<double> probabilities;
+
+  /// @brief If set, the seed of the random outcomes of this execution
+  /// (measurements, noise), so that the results are reproducible on
+  /// backends that support seeding.
+  std::optional<std::uint64_t> seed;
+
+  /// @brief Under the "sample" context, if true, a simulator that samples
+  /// the final state of a kernel without noise or conditionals on measure
+  /// results also sets the probabilities of the sampled outcomes, of the
+  /// outcome with bit j holding the value of the j-th sampled qubit at index
+  /// j. They are left empty if the simulator cannot compute them.
+  bool keepDistribution = false;
+  std::vector<double> distribution;
+
+  /// @brief If set, sampling appends the record of every shot to this stream
+  /// instead of collating the shots into `result`.
+  ShotStream *shotStream = nullptr;
+
+  /// @brief The name and a copy of the packed arguments of the first kernel
+  /// launched under the "resource-estimate" context, which records the
+  /// launch instead of executing the kernel.
+  std::string kernelName;
+  std::vector<char> kernelArgs;
+
+  /// @brief The performance counters of the executions under this context,
+  /// filled by the simulator and the QPU.
+  execution_counters counters;
+
   /// @brief Flag indicating that the current
   /// execution should occur asynchronously
   bool asyncExec = false;
@@ -61,9 +149,9 @@ public:
   /// the expected results as a cudaq::future here.
   details::future futureResult;
 
-  /// @brief simulationData provides a mechanism for
+  /// @brief simulationState provides a mechanism for
   /// simulation clients to extract the underlying simulation data.
-  State simulationData;
+  std::shared_ptr<SimulationState> simulationState;
 
   /// @brief The Constructor, takes the name of the context
   /// @param n The name of the context
@@ -8,40 +8,233 @@
 
 #include "Future.h"
 #include "Logger.h"
+#include "Profiler.h"
 #include "ObserveResult.h"
 #include "RestClient.h"
+#include "ResultDecoder.h"
 #include "ServerHelper.h"
+#include <atomic>
+#include <condition_variable>
+#include <optional>
+#include <thread>
 
 namespace cudaq::details {
 
-sample_result future::get() {
-  if (wrapsFutureSampling)
-    return inFuture.get();
+void completion_signal::notify() {
+  std::vector<std::function<void()>> ready;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    ready.swap(callbacks);
+  }
+  for (auto &callback : ready)
+    callback();
+}
+
+void completion_signal::subscribe(std::function<void()> callback) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!done) {
+      callbacks.push_back(std::move(callback));
+      return;
+    }
+  }
+  callback();
+}
+
+/// @brief The result of a future retrieved by the result poller.
+struct future::polled_result {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::optional<sample_result> result;
+  std::exception_ptr error;
+  completion_signal ready;
+
+  /// @brief Set by future::cancel(), the remote jobs still running are
+  /// cancelled when next polled.
+  std::atomic<bool> cancelled = false;
+
+  /// @brief Set the result or error, unless one is set already.
+  void set(std::optional<sample_result> r, std::exception_ptr e) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (result || error)
+        return;
+      result = std::move(r);
+      error = e;
+    }
+    changed.notify_all();
+    ready.notify();
+  }
+
+  bool wait_for(std::chrono::microseconds duration) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return changed.wait_for(lock, duration,
+                            [&]() { return result || error; });
+  }
+
+  sample_result get() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&]() { return result || error; });
+    if (error)
+      std::rethrow_exception(error);
+    return *result;
+  }
+};
 
 #ifdef CUDAQ_CURL_AVAILABLE
+namespace {
+/// @brief The remote jobs of a future and their results. All unfinished
+/// jobs whose interval has elapsed are polled together, with one concurrent
+/// round of requests. Each job backs off on its own, as advised by the
+/// server helper.
+class remote_jobs {
+  using clock = std::chrono::steady_clock;
+  struct PendingJob {
+    std::string path;
+    std::string registerName;
+    clock::time_point due;
+    std::chrono::milliseconds interval{0};
+    std::optional<ExecutionResult> result;
+  };
+
   RestClient client;
-  auto serverHelper = registry::get<ServerHelper>(qpuName);
-  serverHelper->initialize(serverConfig);
-  auto headers = serverHelper->getHeaders();
+  std::unique_ptr<ServerHelper> serverHelper;
+  RestHeaders headers;
+  std::vector<PendingJob> pending;
+  std::vector<std::string> jobIds;
+  std::size_t remaining;
 
-  std::vector<ExecutionResult> results;
-  for (auto &id : jobs) {
-    cudaq::info("Future retrieving results for {}.", id.first);
+public:
+  remote_jobs(std::vector<future::Job> jobs, const std::string &qpuName,
+              std::map<std::string, std::string> serverConfig)
+      : serverHelper(registry::get<ServerHelper>(qpuName)) {
+    serverHelper->initialize(serverConfig);
+    headers = serverHelper->getHeaders();
+    for (auto &id : jobs) {
+      cudaq::info("Future retrieving results for {}.", id.first);
+      auto jobGetPath = serverHelper->constructGetJobPath(id.first);
+      cudaq::info("Future got job retrieval path as {}.", jobGetPath);
+      pending.push_back({jobGetPath,
+                         jobs.size() == 1 ? GlobalRegisterName : id.second,
+                         clock::now()});
+      jobIds.push_back(id.first);
+    }
+    remaining = pending.size();
+  }
+
+  /// @brief Poll the jobs that are due. Return when the next ones are, or
+  /// nothing once all jobs are done.
+  std::optional<clock::time_point> poll() {
+    profiler::ScopedEvent event("poll", profiler::Category::rest_poll);
+    const auto now = clock::now();
+    std::vector<std::size_t> due;
+    std::vector<std::string> paths;
+    for (std::size_t i = 0; i < pending.size(); i++)
+      if (!pending[i].result && pending[i].due <= now) {
+        due.push_back(i);
+        paths.push_back(pending[i].path);
+      }
+
+    // The counts of large results are decoded as the responses are parsed,
+    // if the server helper names their objects.
+    const auto countsKey = serverHelper->streamedCountsKey();
+    auto texts = client.getAllText("", paths, headers);
+    for (std::size_t k = 0; k < due.size(); k++) {
+      auto &job = pending[due[k]];
+      std::vector<CountsDictionary> counts;
+      auto response = countsKey.empty()
+                          ? ServerMessage::parse(texts[k])
+                          : decodeJobResponse(texts[k], countsKey, counts);
+      texts[k].clear();
+      if (serverHelper->jobIsDone(response)) {
+        auto c = countsKey.empty()
+                     ? serverHelper->processResults(response)
+                     : serverHelper->processStreamedResults(response, counts);
+        job.result = c.extract_register();
+        job.result->registerName = job.registerName;
+        remaining--;
+        continue;
+      }
+      job.interval = serverHelper->nextPollingInterval(response, job.interval);
+      job.due = clock::now() + job.interval;
+    }
+
+    if (!remaining)
+      return std::nullopt;
+    auto next = clock::time_point::max();
+    for (auto &job : pending)
+      if (!job.result)
+        next = std::min(next, job.due);
+    return next;
+  }
 
-    auto jobGetPath = serverHelper->constructGetJobPath(id.first);
+  /// @brief Return the results of the jobs, once all are done.
+  sample_result takeResults() {
+    std::vector<ExecutionResult> results;
+    results.reserve(pending.size());
+    for (auto &job : pending)
+      results.push_back(std::move(*job.result));
+    return sample_result(std::move(results));
+  }
 
-    cudaq::info("Future got job retrieval path as {}.", jobGetPath);
-    auto resultResponse = client.get(jobGetPath, "", headers);
-    while (!serverHelper->jobIsDone(resultResponse)) {
-      std::this_thread::sleep_for(std::chrono::microseconds(100));
-      resultResponse = client.get(jobGetPath, "", headers);
+  /// @brief Return the results of the jobs done so far.
+  sample_result partialResults() const {
+    std::vector<ExecutionResult> results;
+    for (auto &job : pending)
+      if (job.result)
+        results.push_back(*job.result);
+    return sample_result(std::move(results));
+  }
+
+  /// @brief Cancel the jobs that are not done on the server, if it supports
+  /// it. Failures are only logged, a job may finish meanwhile.
+  void cancel() {
+    std::vector<std::string> paths;
+    for (std::size_t i = 0; i < pending.size(); i++)
+      if (!pending[i].result)
+        if (auto path = serverHelper->constructCancelJobPath(jobIds[i]))
+          paths.push_back(std::move(*path));
+    for (auto &path : paths) {
+      cudaq::info("Cancelling job with {}.", path);
+      try {
+        nlohmann::json message = nlohmann::json::object();
+        client.post(path, "", message, headers);
+      } catch (std::exception &e) {
+        cudaq::info("Could not cancel the job: {}", e.what());
+      }
     }
-    auto c = serverHelper->processResults(resultResponse);
-    results.emplace_back(c.to_map(),
-                         jobs.size() == 1 ? GlobalRegisterName : id.second);
   }
+};
+} // namespace
+#endif
 
-  return sample_result(results);
+sample_result future::get() {
+  return get(nullptr);
+}
+
+sample_result future::get(const std::function<bool(sample_result &)> &done) {
+  if (polled)
+    return polled->get();
+  if (cancelled)
+    throw std::runtime_error("cudaq::details::future::get() called on a "
+                             "cancelled future.");
+  if (wrapsFutureSampling)
+    return inFuture.get();
+
+#ifdef CUDAQ_CURL_AVAILABLE
+  remote_jobs remote(jobs, qpuName, serverConfig);
+  while (auto next = remote.poll()) {
+    if (done) {
+      auto partial = remote.partialResults();
+      if (done(partial)) {
+        remote.cancel();
+        return partial;
+      }
+    }
+    std::this_thread::sleep_until(*next);
+  }
+  return remote.takeResults();
 #else
   throw std::runtime_error("cudaq::details::future::get() requires REST Client "
                            "but CUDA Quantum not built with CURL support.");
@@ -49,6 +242,191 @@ sample_result future::get() {
 #endif
 }
 
+void future::cancel() {
+  if (polled) {
+    polled->cancelled = true;
+    polled->set(std::nullopt,
+                std::make_exception_ptr(std::runtime_error(
+                    "cudaq::details::future::get() called on a cancelled "
+                    "future.")));
+    return;
+  }
+  if (cancelled)
+    return;
+  cancelled = true;
+  if (wrapsFutureSampling)
+    return;
+
+#ifdef CUDAQ_CURL_AVAILABLE
+  remote_jobs(jobs, qpuName, serverConfig).cancel();
+#endif
+}
+
+bool future::wait_for(std::chrono::microseconds duration) const {
+  if (polled)
+    return polled->wait_for(duration);
+  if (cancelled || !wrapsFutureSampling)
+    return true;
+  return inFuture.wait_for(duration) == std::future_status::ready;
+}
+
+namespace {
+/// @brief When a result is next polled, nothing once it is retrieved.
+using next_poll = std::optional<std::chrono::steady_clock::time_point>;
+
+/// @brief The thread retrieving the results of the futures handed over by
+/// future::on_ready(). The remote jobs of all futures are polled in turn,
+/// each when it is due, so that any number of them are waited for by this
+/// one thread.
+class result_poller {
+  using clock = std::chrono::steady_clock;
+  struct Entry {
+    std::function<next_poll()> poll;
+    clock::time_point due;
+  };
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<Entry> entries;
+  bool stopping = false;
+  std::thread worker;
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+      auto next = clock::time_point::max();
+      for (auto &entry : entries)
+        next = std::min(next, entry.due);
+      if (entries.empty())
+        changed.wait(lock);
+      else if (next > clock::now())
+        changed.wait_until(lock, next);
+      if (stopping)
+        break;
+
+      // Poll the due entries without holding the lock, so that futures are
+      // handed over meanwhile.
+      std::vector<Entry> due;
+      const auto now = clock::now();
+      for (std::size_t i = 0; i < entries.size();)
+        if (entries[i].due <= now) {
+          due.push_back(std::move(entries[i]));
+          entries[i] = std::move(entries.back());
+          entries.pop_back();
+        } else {
+          i++;
+        }
+      lock.unlock();
+      for (auto &entry : due)
+        if (auto nextDue = entry.poll()) {
+          entry.due = *nextDue;
+          std::lock_guard<std::mutex> guard(mutex);
+          entries.push_back(std::move(entry));
+        }
+      lock.lock();
+    }
+  }
+
+public:
+  result_poller() : worker([this]() { run(); }) {}
+  ~result_poller() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    changed.notify_all();
+    worker.join();
+  }
+
+  /// @brief Call `poll` until it returns nothing, each time when it last
+  /// said the next poll is due.
+  void add(std::function<next_poll()> poll) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      entries.push_back({std::move(poll), clock::now()});
+    }
+    changed.notify_all();
+  }
+};
+
+result_poller &getResultPoller() {
+  static result_poller poller;
+  return poller;
+}
+} // namespace
+
+void future::on_ready(std::function<void()> callback) {
+  if (polled) {
+    polled->ready.subscribe(std::move(callback));
+    return;
+  }
+  if (cancelled) {
+    callback();
+    return;
+  }
+  if (wrapsFutureSampling) {
+    if (completion) {
+      completion->subscribe(std::move(callback));
+      return;
+    }
+    if (inFuture.wait_for(std::chrono::seconds(0)) ==
+        std::future_status::ready) {
+      callback();
+      return;
+    }
+  }
+
+  // Hand the retrieval of the result over to the result poller. A
+  // std::future that nobody notifies, e.g. one deferred until get(), is
+  // waited for there.
+  auto result = std::make_shared<polled_result>();
+  result->ready.subscribe(std::move(callback));
+  polled = result;
+  if (wrapsFutureSampling) {
+    auto shared = std::make_shared<std::future<sample_result>>(
+        std::move(inFuture));
+    getResultPoller().add([shared, result]() -> next_poll {
+      try {
+        result->set(shared->get(), nullptr);
+      } catch (...) {
+        result->set(std::nullopt, std::current_exception());
+      }
+      return std::nullopt;
+    });
+    return;
+  }
+
+#ifdef CUDAQ_CURL_AVAILABLE
+  std::shared_ptr<remote_jobs> remote;
+  try {
+    remote = std::make_shared<remote_jobs>(jobs, qpuName, serverConfig);
+  } catch (...) {
+    result->set(std::nullopt, std::current_exception());
+    return;
+  }
+  getResultPoller().add([remote, result]() -> next_poll {
+    try {
+      if (result->cancelled) {
+        remote->cancel();
+        return std::nullopt;
+      }
+      auto next = remote->poll();
+      if (!next)
+        result->set(remote->takeResults(), nullptr);
+      return next;
+    } catch (...) {
+      result->set(std::nullopt, std::current_exception());
+      return std::nullopt;
+    }
+  });
+#else
+  result->set(std::nullopt,
+              std::make_exception_ptr(std::runtime_error(
+                  "cudaq::details::future::get() requires REST Client but "
+                  "CUDA Quantum not built with CURL support.")));
+#endif
+}
+
 future &future::operator=(future &other) {
   jobs = other.jobs;
   qpuName = other.qpuName;
@@ -57,6 +435,9 @@ future &future::operator=(future &other) {
     wrapsFutureSampling = true;
     inFuture = std::move(other.inFuture);
   }
+  completion = other.completion;
+  polled = other.polled;
+  cancelled = other.cancelled;
   return *this;
 }
 
@@ -68,6 +449,9 @@ future &future::operator=(future &&other) {
     wrapsFutureSampling = true;
     inFuture = std::move(other.inFuture);
   }
+  completion = std::move(other.completion);
+  polled = std::move(other.polled);
+  cancelled = other.cancelled;
   return *this;
 }
 
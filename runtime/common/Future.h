@@ -10,12 +10,31 @@
 #include "MeasureCounts.h"
 #include "ObserveResult.h"
 
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <future>
 #include <map>
+#include <memory>
+#include <mutex>
 
 namespace cudaq {
 namespace details {
+/// @brief The callbacks waiting for an asynchronous result. They run once,
+/// on the thread that completes the result.
+class completion_signal {
+  std::mutex mutex;
+  bool done = false;
+  std::vector<std::function<void()>> callbacks;
+
+public:
+  /// @brief Mark the result as ready and run the callbacks.
+  void notify();
+
+  /// @brief Run the callback once the result is ready, right away if it is.
+  void subscribe(std::function<void()> callback);
+};
+
 /// @brief The future type models the expected result of a
 /// CUDA Quantum kernel execution under a specific execution context.
 /// This type is returned from asynchronous execution calls. It
@@ -49,6 +68,18 @@ protected:
   std::future<sample_result> inFuture;
   bool wrapsFutureSampling = false;
 
+  /// @brief Notified when `inFuture` is ready, if the task computing it
+  /// notifies it (see quantum_platform::enqueueAsyncTask()).
+  std::shared_ptr<completion_signal> completion;
+
+  /// @brief The result once handed over to the result poller, see
+  /// on_ready().
+  struct polled_result;
+  std::shared_ptr<polled_result> polled;
+
+  /// @brief Set by cancel(), when the result was not handed over.
+  bool cancelled = false;
+
 public:
   /// @brief The constructor
   future() = default;
@@ -63,6 +94,13 @@ public:
     wrapsFutureSampling = true;
   }
 
+  /// @brief The constructor, takes a std::future and the signal notified by
+  /// the task computing it.
+  future(std::future<sample_result> &&f,
+         std::shared_ptr<completion_signal> signal)
+      : inFuture(std::move(f)), wrapsFutureSampling(true),
+        completion(std::move(signal)) {}
+
   /// @brief The constructor, takes all info required to
   /// be able to retrieve results at a later date, even after file persistence.
   future(std::vector<Job> &_jobs, std::string &qpuNameIn,
@@ -74,6 +112,32 @@ public:
 
   sample_result get();
 
+  /// @brief Like get(), but a remote execution returns as soon as `done`
+  /// accepts the results of the jobs finished so far, and cancels the
+  /// others (see cancel()). `done` is called after each round of polls. A
+  /// result computed locally, or already handed over by on_ready(), is
+  /// waited for in full.
+  sample_result get(const std::function<bool(sample_result &)> &done);
+
+  /// @brief Stop waiting for the result: get() throws from now on, and the
+  /// callbacks of on_ready() run. The remote jobs that are not done are
+  /// cancelled on the server, if it supports it (see
+  /// ServerHelper::constructCancelJobPath()). A result computed locally is
+  /// left to complete, and then dropped.
+  void cancel();
+
+  /// @brief Wait at most the given duration for the data, return true if
+  /// get() will not block. Remote executions retrieve their results in
+  /// get(), so they are always considered ready.
+  bool wait_for(std::chrono::microseconds duration) const;
+
+  /// @brief Run the callback once get() will not block, on the thread that
+  /// completes the result: the QPU execution queue worker for tasks that
+  /// notify their completion, otherwise the single result poller thread of
+  /// the process, which polls the remote jobs of all futures together. The
+  /// callback must not block.
+  void on_ready(std::function<void()> callback);
+
   friend std::ostream &operator<<(std::ostream &, future &);
   friend std::istream &operator>>(std::istream &, future &);
 };
@@ -102,11 +166,70 @@ public:
   async_result(details::future &&f, spin_op *op = nullptr)
       : result(std::move(f)), spinOp(op) {}
 
+  /// @brief Wait at most the given duration for the data, return true if
+  /// get() will not block.
+  bool wait_for(std::chrono::microseconds duration) const {
+    return result.wait_for(duration);
+  }
+
+  /// @brief Run the callback once get() will not block, see
+  /// details::future::on_ready().
+  void on_ready(std::function<void()> callback) {
+    result.on_ready(std::move(callback));
+  }
+
+  /// @brief Stop waiting for the data and cancel the remote jobs computing
+  /// it, see details::future::cancel().
+  void cancel() { result.cancel(); }
+
   /// @brief Return the asynchronously computed data, will
   /// wait until the data is ready.
-  T get() {
-    auto data = result.get();
+  T get() { return makeResult(result.get()); }
+
+  /// @brief Return the observe_result as soon as the terms whose remote
+  /// jobs are still running can change the expectation value by at most
+  /// `tolerance`, that is, once the sum of the absolute values of their
+  /// coefficients is below it. These terms are counted as 0, and their jobs
+  /// are cancelled. The shot noise of the finished terms is not part of the
+  /// bound.
+  T get_within(double tolerance) {
+    static_assert(std::is_same_v<T, observe_result>,
+                  "get_within() requires an observe result.");
+    if (!spinOp)
+      throw std::runtime_error(
+          "Returning an observe_result requires a spin_op.");
+
+    auto groups = spinOp->get_qubit_wise_commuting_groups();
+    std::vector<double> weights(groups.size(), 0.0);
+    std::vector<std::string> names(groups.size());
+    for (std::size_t g = 0; g < groups.size(); g++) {
+      // The counts of a single group are in the global register.
+      names[g] = groups.size() == 1
+                     ? GlobalRegisterName
+                     : details::getMeasurementBasisName(*spinOp, groups[g]);
+      for (auto t : groups[g])
+        weights[g] += std::abs(spinOp->get_term_coefficient(t));
+    }
+    return makeResult(result.get([&](sample_result &partial) {
+      auto finished = partial.register_names();
+      double pending = 0.0;
+      for (std::size_t g = 0; g < groups.size(); g++)
+        if (std::find(finished.begin(), finished.end(), names[g]) ==
+            finished.end())
+          pending += weights[g];
+      return pending <= tolerance;
+    }));
+  }
+
+  template <typename U>
+  friend std::ostream &operator<<(std::ostream &, async_result<U> &);
+
+  template <typename U>
+  friend std::istream &operator>>(std::istream &, async_result<U> &);
 
+private:
+  /// @brief Return the result of the retrieved data.
+  T makeResult(sample_result data) {
     if constexpr (std::is_same_v<T, sample_result>)
       return data;
 
@@ -119,17 +242,18 @@ public:
         throw std::runtime_error(
             "Returning an observe_result requires a spin_op.");
 
-      // this assumes we ran in shots mode.
+      // this assumes we ran in shots mode, with one circuit per group of
+      // qubit-wise commuting terms.
+      details::marginalizeGroupCounts(data, *spinOp);
       double sum = 0.0;
-      for (std::size_t i = 0; i < spinOp->n_terms(); i++) {
-        auto term = (*spinOp)[i];
+      for (auto term : spinOp->terms()) {
         if (term.is_identity()) {
-          sum += term.get_coefficients()[0].real();
+          sum += term.get_coefficient().real();
           continue;
         }
 
         sum += data.exp_val_z(term.to_string(false)) *
-               term.get_coefficients()[0].real();
+               term.get_coefficient().real();
       }
 
       return observe_result(sum, *spinOp, data);
@@ -137,12 +261,6 @@ public:
 
     return T();
   }
-
-  template <typename U>
-  friend std::ostream &operator<<(std::ostream &, async_result<U> &);
-
-  template <typename U>
-  friend std::istream &operator>>(std::istream &, async_result<U> &);
 };
 
 template <typename T>
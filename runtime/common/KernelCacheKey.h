@@ -0,0 +1,73 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <concepts>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <vector>
+
+namespace cudaq::details {
+
+/// @brief Append the bytes of a trivially copyable value to a cache key.
+template <typename T>
+void appendCacheKeyBytes(std::string &key, const T &value) {
+  key.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+/// @brief Append the bytes of a kernel argument to a cache key. Only the
+/// trivially copyable values and vectors of them can be compared by their
+/// bytes, return false for any other argument.
+template <typename T>
+bool appendArgumentBytes(std::string &key, const T &arg) {
+  if constexpr (std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>) {
+    appendCacheKeyBytes(key, arg);
+    return true;
+  } else if constexpr (requires { typename T::value_type; } &&
+                       std::is_same_v<T, std::vector<typename T::value_type>>) {
+    using E = typename T::value_type;
+    if constexpr (std::is_trivially_copyable_v<E> && !std::is_pointer_v<E> &&
+                  !std::is_same_v<E, bool>) {
+      appendCacheKeyBytes(key, arg.size());
+      key.append(reinterpret_cast<const char *>(arg.data()),
+                 arg.size() * sizeof(E));
+      return true;
+    }
+  }
+  return false;
+}
+
+/// @brief Return the cache key of kernel(args...), or an empty string if the
+/// kernel or an argument cannot be compared by its bytes. A kernel without
+/// state is identified by its type. A kernel_builder, which can be extended
+/// between calls, is identified by its name and a hash of its Quake code.
+/// Other kernels with state, e.g. lambdas with captures, are not cached.
+template <typename QuantumKernel, typename... Args>
+std::string makeKernelCacheKey(const QuantumKernel &kernel,
+                               const Args &...args) {
+  std::string key;
+  appendCacheKeyBytes(key, typeid(QuantumKernel).hash_code());
+  if constexpr (requires {
+                  { kernel.name() } -> std::convertible_to<std::string>;
+                  { kernel.to_quake() } -> std::convertible_to<std::string>;
+                }) {
+    const std::string name = kernel.name();
+    appendCacheKeyBytes(key, name.size());
+    key += name;
+    appendCacheKeyBytes(key, std::hash<std::string>{}(kernel.to_quake()));
+  } else if constexpr (!std::is_empty_v<QuantumKernel>)
+    return {};
+  if (!(appendArgumentBytes(key, args) && ...))
+    return {};
+  return key;
+}
+
+} // namespace cudaq::details
@@ -39,6 +39,22 @@ __attribute__((constructor)) void initializeLogger() {
 }
 
 namespace details {
+bool should_log(const LogLevel level) {
+  switch (level) {
+  case LogLevel::trace:
+    return spdlog::should_log(spdlog::level::trace);
+  case LogLevel::info:
+    return spdlog::should_log(spdlog::level::info);
+  case LogLevel::debug:
+#ifdef CUDAQ_DEBUG
+    return spdlog::should_log(spdlog::level::debug);
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
 void trace(const std::string_view msg) { spdlog::trace(msg); }
 void info(const std::string_view msg) { spdlog::info(msg); }
 void debug(const std::string_view msg) {
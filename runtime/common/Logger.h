@@ -18,11 +18,26 @@ namespace cudaq {
 
 // Keep all spdlog headers hidden in the implementation file
 namespace details {
+/// @brief The levels of the runtime logger.
+enum class LogLevel { trace, info, debug };
+
+/// @brief Return true if messages of the given level are printed. Checked
+/// before a message is formatted, so disabled messages cost no formatting.
+bool should_log(const LogLevel level);
+
 void trace(const std::string_view msg);
 void info(const std::string_view msg);
 void debug(const std::string_view msg);
 } // namespace details
 
+/// Building with CUDAQ_NO_TRACE removes all logging and tracing from the
+/// runtime at compile time.
+#ifdef CUDAQ_NO_TRACE
+inline constexpr bool traceCompiledIn = false;
+#else
+inline constexpr bool traceCompiledIn = true;
+#endif
+
 /// This type seeks to enable automated injection of the
 /// source location of the cudaq::info() or debug() call.
 /// We do this via a struct of the same name (info), which
@@ -40,6 +55,8 @@ void debug(const std::string_view msg);
          const char *funcName = __builtin_FUNCTION(),                          \
          const char *fileName = __builtin_FILE(),                              \
          int lineNo = __builtin_LINE()) {                                      \
+      if (!traceCompiledIn || !details::should_log(details::LogLevel::NAME))   \
+        return;                                                                \
       auto msg = fmt::format(fmt::runtime(message), args...);                  \
       std::string name = funcName;                                             \
       auto start = name.find_first_of(" ");                                    \
@@ -56,6 +73,16 @@ void debug(const std::string_view msg);
 CUDAQ_LOGGER_DEDUCTION_STRUCT(info);
 CUDAQ_LOGGER_DEDUCTION_STRUCT(debug);
 
+/// Log with cudaq::info(), but only evaluate the arguments if info messages
+/// are printed. Use this where building the arguments is itself expensive,
+/// like the gate descriptions in the simulators.
+#define CUDAQ_INFO(...)                                                        \
+  do {                                                                         \
+    if (cudaq::traceCompiledIn &&                                              \
+        cudaq::details::should_log(cudaq::details::LogLevel::info))            \
+      cudaq::info(__VA_ARGS__);                                                \
+  } while (false)
+
 /// @brief This type is meant to provided quick tracing
 /// of function calls. Instantiate at the beginning
 /// of a function and when it goes out of scope at function
@@ -93,19 +120,31 @@ private:
   /// @brief Any args the user would also like to print
   std::string argsMsg;
 
+  /// @brief True if trace messages were printed when this was created. If
+  /// not, this does nothing at all.
+  bool enabled = false;
+
   static inline short int globalTraceStack = -1;
 
 public:
   /// @brief The constructor
-  ScopedTrace(const std::string &name)
-      : startTime(std::chrono::system_clock::now()), traceName(name) {
+  ScopedTrace(const std::string_view name) {
+    if (!traceCompiledIn || !details::should_log(details::LogLevel::trace))
+      return;
+    enabled = true;
+    startTime = std::chrono::system_clock::now();
+    traceName = name;
     globalTraceStack++;
   }
 
   /// @brief  Constructor, take and print user-specified critical args
   template <typename... Args>
-  ScopedTrace(const std::string &name, Args &&...args)
-      : startTime(std::chrono::system_clock::now()), traceName(name) {
+  ScopedTrace(const std::string_view name, Args &&...args) {
+    if (!traceCompiledIn || !details::should_log(details::LogLevel::trace))
+      return;
+    enabled = true;
+    startTime = std::chrono::system_clock::now();
+    traceName = name;
     argsMsg = " (args = {{";
     constexpr std::size_t nArgs = sizeof...(Args);
     for (std::size_t i = 0; i < nArgs; i++) {
@@ -117,6 +156,8 @@ public:
 
   /// The destructor, get the elapsed time and trace.
   ~ScopedTrace() {
+    if (!enabled)
+      return;
     auto duration = static_cast<double>(
         std::chrono::duration_cast<std::chrono::microseconds>(
             std::chrono::system_clock::now() - startTime)
@@ -9,13 +9,20 @@
 #include "MeasureCounts.h"
 
 #include <algorithm>
+#include <bit>
+#include <functional>
 #include <numeric>
 #include <string.h>
+#include <thread>
 
 #include <iostream>
 #include <map>
 #include <vector>
 
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
 namespace cudaq {
 std::string longToBitString(int size, long x) {
   std::string s(size, '0');
@@ -28,30 +35,234 @@ std::string longToBitString(int size, long x) {
   return s;
 }
 
-ExecutionResult::ExecutionResult(CountsDictionary c) : counts(c) {}
-ExecutionResult::ExecutionResult(std::string name) : registerName(name) {}
+namespace {
+/// @brief Return the hash of the packed bit string of n words.
+std::uint64_t hashKey(const std::uint64_t *key, std::size_t n) {
+  std::uint64_t h = 0x9e3779b97f4a7c15ULL;
+  for (std::size_t i = 0; i < n; i++) {
+    // splitmix64 finalizer of each word, combined with the running hash.
+    std::uint64_t x = key[i] + h;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    h = x ^ (x >> 31);
+  }
+  return h;
+}
+
+/// @brief Pack the bit string of '0' and '1' characters into the words.
+void packBits(std::string_view bits, std::uint64_t *key, std::size_t nWords) {
+  std::fill_n(key, nWords, 0);
+  for (std::size_t j = 0; j < bits.size(); j++) {
+    if (bits[j] == '1')
+      key[j / 64] |= 1ULL << (j % 64);
+    else if (bits[j] != '0')
+      throw std::runtime_error("Invalid bit string " + std::string(bits) +
+                               ".");
+  }
+}
+
+/// @brief Return the number of threads to split `n` items over, with at
+/// least `minPerThread` items per thread.
+std::size_t numThreads(std::size_t n, std::size_t minPerThread) {
+  return std::max<std::size_t>(
+      std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                            n / minPerThread),
+      1);
+}
+
+/// @brief Call `functor(i, begin, end)` for the i-th of `nThreads` equal
+/// consecutive ranges of [0, n), each on its own thread.
+void forEachRange(
+    std::size_t n, std::size_t nThreads,
+    const std::function<void(std::size_t, std::size_t, std::size_t)>
+        &functor) {
+  auto rangeBegin = [&](std::size_t i) { return n * i / nThreads; };
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < nThreads; i++)
+    threads.emplace_back(
+        [&, i]() { functor(i, rangeBegin(i), rangeBegin(i + 1)); });
+  functor(0, 0, rangeBegin(1));
+  for (auto &thread : threads)
+    thread.join();
+}
+
+/// @brief Return the bits of x selected by the mask, packed into the low
+/// bits in order (the BMI2 pext instruction).
+std::uint64_t extractBits(std::uint64_t x, std::uint64_t mask) {
+#ifdef __BMI2__
+  return _pext_u64(x, mask);
+#else
+  // One shift per run of consecutive selected bits.
+  std::uint64_t result = 0;
+  for (std::size_t k = 0; mask;) {
+    const auto first = std::countr_zero(mask);
+    const auto run = std::countr_one(mask >> first);
+    const std::uint64_t runMask = run == 64 ? ~0ULL : (1ULL << run) - 1;
+    result |= ((x >> first) & runMask) << k;
+    mask &= ~(runMask << first);
+    k += run;
+  }
+  return result;
+#endif
+}
+
+/// @brief Gathers the bits at the given increasing indices of packed bit
+/// strings into new packed bit strings, with one extractBits() per word of
+/// the bit strings that holds selected bits.
+class BitGather {
+  struct Group {
+    std::size_t word;
+    std::uint64_t mask;
+    std::size_t offset;
+  };
+  std::vector<Group> groups;
+
+public:
+  explicit BitGather(const std::vector<std::size_t> &indices) {
+    for (std::size_t j = 0; j < indices.size(); j++) {
+      const auto word = indices[j] / 64;
+      if (groups.empty() || groups.back().word != word)
+        groups.push_back({word, 0, j});
+      groups.back().mask |= 1ULL << (indices[j] % 64);
+    }
+  }
+
+  /// @brief Gather the bits of the key into `out`, whose words are zero.
+  void operator()(const std::uint64_t *key, std::uint64_t *out) const {
+    for (auto &group : groups) {
+      const auto bits = extractBits(key[group.word], group.mask);
+      const auto shift = group.offset % 64;
+      out[group.offset / 64] |= bits << shift;
+      if (shift && std::popcount(group.mask) > int(64 - shift))
+        out[group.offset / 64 + 1] |= bits >> (64 - shift);
+    }
+  }
+};
+
+/// @brief Merge the counts and sequential data of `theirs` into `ours`.
+void mergeResult(ExecutionResult &ours, ExecutionResult &theirs) {
+  // An expectation value of the counts no longer holds for the merged ones.
+  ours.expectationValue = std::nullopt;
+  if (ours.isPacked() && theirs.isPacked() &&
+      ours.packedCounts.n_bits() == theirs.packedCounts.n_bits()) {
+    auto &packed = theirs.packedCounts;
+    std::vector<std::size_t> indices(packed.size());
+    for (std::size_t i = 0; i < packed.size(); i++)
+      indices[i] = ours.packedCounts.add(packed.key(i), packed.count(i));
+    for (auto i : theirs.packedSequence)
+      ours.packedSequence.push_back(indices[i]);
+    return;
+  }
+  ours.materializeCounts();
+  theirs.materializeCounts();
+  for (auto &[bits, count] : theirs.counts)
+    ours.counts[bits] += count;
+
+  if (!theirs.sequentialData.empty())
+    ours.sequentialData.insert(ours.sequentialData.end(),
+                               theirs.sequentialData.begin(),
+                               theirs.sequentialData.end());
+}
+} // namespace
+
+PackedCounts::PackedCounts(std::size_t nBits)
+    : nBits(nBits), nWords(std::max<std::size_t>((nBits + 63) / 64, 1)) {}
+
+std::size_t PackedCounts::findSlot(const std::uint64_t *k) const {
+  const std::size_t mask = slots.size() - 1;
+  std::size_t slot = hashKey(k, nWords) & mask;
+  while (slots[slot] && !std::equal(k, k + nWords, key(slots[slot] - 1)))
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+void PackedCounts::rehash(std::size_t nSlots) {
+  slots.assign(nSlots, 0);
+  for (std::size_t i = 0; i < size(); i++)
+    slots[findSlot(key(i))] = i + 1;
+}
+
+void PackedCounts::reserve(std::size_t n) {
+  keys.reserve(n * nWords);
+  keyCounts.reserve(n);
+  if (slots.size() < 2 * n)
+    rehash(std::bit_ceil(2 * n));
+}
+
+std::size_t PackedCounts::add(const std::uint64_t *k, std::size_t count) {
+  // Keep the load factor at most 1 / 2.
+  if (slots.size() < 2 * (size() + 1))
+    rehash(std::max<std::size_t>(16, 2 * slots.size()));
+  const auto slot = findSlot(k);
+  if (slots[slot]) {
+    keyCounts[slots[slot] - 1] += count;
+    return slots[slot] - 1;
+  }
+  keys.insert(keys.end(), k, k + nWords);
+  keyCounts.push_back(count);
+  slots[slot] = size();
+  return size() - 1;
+}
+
+std::size_t PackedCounts::add(std::string_view bits, std::size_t count) {
+  if (nWords == 0)
+    *this = PackedCounts(bits.size());
+  if (bits.size() != nBits)
+    throw std::runtime_error("Cannot add the bit string " + std::string(bits) +
+                             " to counts of " + std::to_string(nBits) +
+                             " bit strings.");
+  std::vector<std::uint64_t> k(nWords);
+  packBits(bits, k.data(), nWords);
+  return add(k.data(), count);
+}
+
+std::size_t PackedCounts::find(std::string_view bits) const {
+  if (empty() || bits.size() != nBits ||
+      bits.find_first_not_of("01") != std::string_view::npos)
+    return -1;
+  std::vector<std::uint64_t> k(nWords);
+  packBits(bits, k.data(), nWords);
+  const auto slot = findSlot(k.data());
+  return slots[slot] ? slots[slot] - 1 : std::size_t(-1);
+}
+
+std::string PackedCounts::bit_string(std::size_t i) const {
+  std::string bits(nBits, '0');
+  for (std::size_t j = 0; j < nBits; j++)
+    if (bit(i, j))
+      bits[j] = '1';
+  return bits;
+}
+
+std::size_t PackedCounts::total() const {
+  return std::accumulate(keyCounts.begin(), keyCounts.end(), std::size_t(0));
+}
+
+void PackedCounts::clear() { *this = PackedCounts(); }
+
+ExecutionResult::ExecutionResult(CountsDictionary c) : counts(std::move(c)) {}
+ExecutionResult::ExecutionResult(std::string name)
+    : registerName(std::move(name)) {}
 ExecutionResult::ExecutionResult(double e) : expectationValue(e) {}
 
 ExecutionResult::ExecutionResult(CountsDictionary c, std::string name)
-    : counts(c), registerName(name) {}
+    : counts(std::move(c)), registerName(std::move(name)) {}
 ExecutionResult::ExecutionResult(CountsDictionary c, std::string name, double e)
-    : counts(c), expectationValue(e), registerName(name) {}
+    : counts(std::move(c)), expectationValue(e),
+      registerName(std::move(name)) {}
 
 ExecutionResult::ExecutionResult(CountsDictionary c, double e)
-    : counts(c), expectationValue(e) {}
-ExecutionResult::ExecutionResult(const ExecutionResult &other)
-    : counts(other.counts), expectationValue(other.expectationValue),
-      registerName(other.registerName), sequentialData(other.sequentialData) {}
-
-ExecutionResult &ExecutionResult::operator=(ExecutionResult &other) {
-  counts = other.counts;
-  expectationValue = other.expectationValue;
-  registerName = other.registerName;
-  sequentialData = other.sequentialData;
-  return *this;
-}
+    : counts(std::move(c)), expectationValue(e) {}
 
 void ExecutionResult::appendResult(std::string bitString, std::size_t count) {
+  if (isPacked()) {
+    if (bitString.size() == packedCounts.n_bits()) {
+      packedSequence.push_back(packedCounts.add(bitString, count));
+      return;
+    }
+    materializeCounts();
+  }
+
   auto iter = counts.find(bitString);
   if (iter == counts.end())
     counts.insert({bitString, count});
@@ -61,8 +272,91 @@ void ExecutionResult::appendResult(std::string bitString, std::size_t count) {
   sequentialData.push_back(bitString);
 }
 
+void ExecutionResult::appendResult(const std::uint64_t *bits,
+                                   std::size_t nBits, std::size_t count) {
+  if (!isPacked()) {
+    packCounts();
+    if (!isPacked() && counts.empty())
+      packedCounts = PackedCounts(nBits);
+  }
+  if (!isPacked() || packedCounts.n_bits() != nBits) {
+    // Bit strings of different lengths are only held as strings.
+    materializeCounts();
+    PackedCounts single(nBits);
+    single.add(bits, count);
+    appendResult(single.bit_string(0), count);
+    return;
+  }
+  packedSequence.push_back(packedCounts.add(bits, count));
+}
+
+void ExecutionResult::materializeCounts() {
+  if (!isPacked())
+    return;
+  counts.reserve(counts.size() + packedCounts.size());
+  for (std::size_t i = 0; i < packedCounts.size(); i++)
+    counts[packedCounts.bit_string(i)] += packedCounts.count(i);
+  sequentialData.reserve(sequentialData.size() + packedSequence.size());
+  for (auto i : packedSequence)
+    sequentialData.push_back(packedCounts.bit_string(i));
+  packedCounts.clear();
+  packedSequence.clear();
+}
+
+void ExecutionResult::packCounts() {
+  if (isPacked() || counts.empty())
+    return;
+  const auto nBits = counts.begin()->first.size();
+  auto hasLength = [&](const std::string &bits) {
+    return bits.size() == nBits &&
+           bits.find_first_not_of("01") == std::string::npos;
+  };
+  for (auto &[bits, count] : counts)
+    if (!hasLength(bits))
+      return;
+
+  PackedCounts packed(nBits);
+  packed.reserve(counts.size());
+  for (auto &[bits, count] : counts)
+    packed.add(bits, count);
+  std::vector<std::size_t> sequence;
+  sequence.reserve(sequentialData.size());
+  for (auto &bits : sequentialData) {
+    auto i = packed.find(bits);
+    if (i == std::size_t(-1))
+      return;
+    sequence.push_back(i);
+  }
+  packedCounts = std::move(packed);
+  packedSequence = std::move(sequence);
+  counts.clear();
+  sequentialData.clear();
+}
+
+std::size_t ExecutionResult::totalCount() const {
+  if (isPacked())
+    return packedCounts.total();
+  std::size_t total = 0;
+  for (auto &[bits, count] : counts)
+    total += count;
+  return total;
+}
+
+CountsDictionary ExecutionResult::toCountsDictionary() const {
+  if (!isPacked())
+    return counts;
+  CountsDictionary dictionary(packedCounts.size());
+  for (std::size_t i = 0; i < packedCounts.size(); i++)
+    dictionary.emplace(packedCounts.bit_string(i), packedCounts.count(i));
+  return dictionary;
+}
+
 bool ExecutionResult::operator==(const ExecutionResult &result) const {
-  return registerName == result.registerName && counts == result.counts;
+  if (registerName != result.registerName)
+    return false;
+  if (!isPacked() && !result.isPacked())
+    return counts == result.counts;
+  return toCountsDictionary() == result.toCountsDictionary();
 }
 
 /// @brief  Encoding - 1st element is size of the register name N, then next N
@@ -78,7 +372,22 @@ std::vector<std::size_t> ExecutionResult::serialize() {
     retData.push_back((std::size_t)registerName[j]);
   }
 
-  // Encode the counts data
+  // Encode the counts data, packed bit strings of up to 63 bits directly.
+  if (isPacked() && packedCounts.n_bits() < 64) {
+    const auto nBits = packedCounts.n_bits();
+    retData.push_back(packedCounts.size());
+    for (std::size_t i = 0; i < packedCounts.size(); i++) {
+      // The first bit is the most significant one.
+      std::size_t l = 0;
+      for (std::size_t j = 0; j < nBits; j++)
+        l = (l << 1) | packedCounts.bit(i, j);
+      retData.push_back(l);
+      retData.push_back(nBits);
+      retData.push_back(packedCounts.count(i));
+    }
+    return retData;
+  }
+  materializeCounts();
   retData.push_back(counts.size());
   for (auto &kv : counts) {
     auto bits = kv.first;
@@ -116,7 +425,119 @@ void ExecutionResult::deserialize(std::vector<std::size_t> &data) {
   }
 }
 
+void MeasurementLog::append(std::vector<Register> &&registers,
+                            const std::uint64_t *record, std::size_t nBits) {
+  if (segments.empty() || segments.back().registers != registers ||
+      segments.back().records.n_bits() != nBits) {
+    auto &segment = segments.emplace_back();
+    segment.registers = std::move(registers);
+    segment.records = PackedCounts(nBits);
+  }
+  auto &segment = segments.back();
+  segment.sequence.push_back(segment.records.add(record, 1));
+}
+
+void MeasurementLog::append(MeasurementLog &&other) {
+  for (auto &theirs : other.segments) {
+    if (segments.empty() || segments.back().registers != theirs.registers ||
+        segments.back().records.n_bits() != theirs.records.n_bits()) {
+      segments.push_back(std::move(theirs));
+      continue;
+    }
+    auto &ours = segments.back();
+    std::vector<std::size_t> indices(theirs.records.size());
+    for (std::size_t i = 0; i < theirs.records.size(); i++)
+      indices[i] =
+          ours.records.add(theirs.records.key(i), theirs.records.count(i));
+    for (auto i : theirs.sequence)
+      ours.sequence.push_back(indices[i]);
+  }
+  other.segments.clear();
+}
+
+bool MeasurementLog::contains(std::string_view name) const {
+  for (auto &segment : segments)
+    for (auto &reg : segment.registers)
+      if (reg.name == name)
+        return true;
+  return false;
+}
+
+std::vector<std::string> MeasurementLog::register_names() const {
+  std::vector<std::string> names;
+  for (auto &segment : segments)
+    for (auto &reg : segment.registers)
+      if (std::find(names.begin(), names.end(), reg.name) == names.end())
+        names.push_back(reg.name);
+  return names;
+}
+
+bool MeasurementLog::take(std::string_view name, ExecutionResult &result) {
+  bool found = false;
+  for (auto &segment : segments) {
+    auto reg = std::find_if(segment.registers.begin(), segment.registers.end(),
+                            [&](const Register &r) { return r.name == name; });
+    if (reg == segment.registers.end())
+      continue;
+    found = true;
+    auto &records = segment.records;
+    if (reg->isVector) {
+      // Gather the bit string of each distinct record once.
+      const std::size_t nBits = reg->bits.size();
+      const std::size_t nWords = std::max<std::size_t>((nBits + 63) / 64, 1);
+      std::vector<std::uint64_t> keys(records.size() * nWords, 0);
+      for (std::size_t i = 0; i < records.size(); i++)
+        for (std::size_t j = 0; j < nBits; j++)
+          if (records.bit(i, reg->bits[j]))
+            keys[i * nWords + j / 64] |= 1ULL << (j % 64);
+      for (auto i : segment.sequence)
+        result.appendResult(keys.data() + i * nWords, nBits, 1);
+    } else {
+      const std::uint64_t one = 1, zero = 0;
+      for (auto i : segment.sequence)
+        for (auto b : reg->bits)
+          result.appendResult(records.bit(i, b) ? &one : &zero, 1, 1);
+    }
+    segment.registers.erase(reg);
+  }
+  std::erase_if(segments, [](const Segment &segment) {
+    return segment.registers.empty();
+  });
+  return found;
+}
+
+execution_counters &
+execution_counters::operator+=(const execution_counters &other) {
+  gates += other.gates;
+  state_sweeps += other.state_sweeps;
+  peak_state_bytes = std::max(peak_state_bytes, other.peak_state_bytes);
+  simulator_seconds += other.simulator_seconds;
+  host_seconds += other.host_seconds;
+  kernel_executions += other.kernel_executions;
+  return *this;
+}
+
+void sample_result::materialize(std::string_view registerName) const {
+  if (midCircuitLog.empty())
+    return;
+  ExecutionResult result{std::string(registerName)};
+  if (!midCircuitLog.take(registerName, result))
+    return;
+  registerShots.erase(result.registerName);
+  auto iter = sampleResults.find(result.registerName);
+  if (iter == sampleResults.end())
+    sampleResults.emplace(result.registerName, std::move(result));
+  else
+    mergeResult(iter->second, result);
+}
+
+void sample_result::materializeAll() const {
+  for (auto &name : midCircuitLog.register_names())
+    materialize(name);
+}
+
 std::vector<std::size_t> sample_result::serialize() {
+  materializeAll();
   std::vector<std::size_t> retData;
   for (auto &result : sampleResults) {
     auto serialized = result.second.serialize();
@@ -126,6 +547,7 @@ std::vector<std::size_t> sample_result::serialize() {
 }
 
 void sample_result::deserialize(std::vector<std::size_t> &data) {
+  registerShots.clear();
   std::size_t stride = 0;
   while (stride < data.size()) {
     auto nChars = data[stride];
@@ -148,7 +570,7 @@ void sample_result::deserialize(std::vector<std::size_t> &data) {
       localCounts.insert({bs, count});
     }
 
-    sampleResults.insert({name, ExecutionResult{localCounts, name}});
+    sampleResults.insert({name, ExecutionResult{std::move(localCounts), name}});
 
     stride += nBs * 3;
     totalShots = localShots;
@@ -156,17 +578,29 @@ void sample_result::deserialize(std::vector<std::size_t> &data) {
 }
 
 sample_result::sample_result(ExecutionResult &result) {
-  sampleResults.insert({result.registerName, std::move(result)});
-  for (auto &[bits, count] : result.counts)
-    totalShots += count;
+  totalShots = result.totalCount();
+  sampleResults.insert({result.registerName, result});
+}
+
+sample_result::sample_result(ExecutionResult &&result) {
+  totalShots = result.totalCount();
+  auto name = result.registerName;
+  sampleResults.insert({std::move(name), std::move(result)});
 }
 
 sample_result::sample_result(std::vector<ExecutionResult> &results) {
   for (auto &result : results) {
     sampleResults.insert({result.registerName, result});
   }
-  for (auto &[bits, count] : results[0].counts)
-    totalShots += count;
+  totalShots = results.empty() ? 0 : results[0].totalCount();
+}
+
+sample_result::sample_result(std::vector<ExecutionResult> &&results) {
+  totalShots = results.empty() ? 0 : results[0].totalCount();
+  for (auto &result : results) {
+    auto name = result.registerName;
+    sampleResults.insert({std::move(name), std::move(result)});
+  }
 }
 
 sample_result::sample_result(double preComputedExp,
@@ -178,72 +612,184 @@ sample_result::sample_result(double preComputedExp,
   // Create a spot for the pre-computed exp val
   sampleResults.emplace(GlobalRegisterName, preComputedExp);
 
-  for (auto &[bits, count] : results[0].counts)
-    totalShots += count;
+  totalShots = results.empty() ? 0 : results[0].totalCount();
+}
+
+sample_result::sample_result(double preComputedExp,
+                             std::vector<ExecutionResult> &&results) {
+  totalShots = results.empty() ? 0 : results[0].totalCount();
+  for (auto &result : results) {
+    auto name = result.registerName;
+    sampleResults.insert({std::move(name), std::move(result)});
+  }
+
+  // Create a spot for the pre-computed exp val
+  sampleResults.emplace(GlobalRegisterName, preComputedExp);
 }
 
 void sample_result::append(ExecutionResult &result) {
+  registerShots.clear();
   sampleResults.insert({result.registerName, result});
   if (!totalShots)
-    for (auto &[bits, count] : result.counts)
-      totalShots += count;
+    totalShots = result.totalCount();
+}
+
+void sample_result::append(ExecutionResult &&result) {
+  registerShots.clear();
+  if (!totalShots)
+    totalShots = result.totalCount();
+  auto name = result.registerName;
+  sampleResults.insert({std::move(name), std::move(result)});
+}
+
+void sample_result::append(MeasurementLog &&log) {
+  registerShots.clear();
+  midCircuitLog.append(std::move(log));
+}
+
+ExecutionResult
+sample_result::extract_register(const std::string_view registerName) {
+  materialize(registerName);
+  registerShots.clear();
+  auto node = sampleResults.extract(std::string(registerName));
+  if (node.empty())
+    return ExecutionResult(std::string(registerName));
+  return std::move(node.mapped());
 }
 
 sample_result::sample_result(const sample_result &m)
-    : sampleResults(m.sampleResults), totalShots(m.totalShots) {}
+    : sampleResults(m.sampleResults), totalShots(m.totalShots),
+      counters(m.counters),
+      midCircuitLog(m.midCircuitLog) {}
 
 sample_result &sample_result::operator=(sample_result &counts) {
+  registerShots.clear();
   sampleResults.clear();
   for (auto &[name, sampleResult] : counts.sampleResults) {
     sampleResults.insert({name, sampleResult});
   }
   totalShots = counts.totalShots;
+  counters = counts.counters;
+  midCircuitLog = counts.midCircuitLog;
   return *this;
 }
+sample_result &sample_result::operator=(sample_result &&counts) {
+  registerShots.clear();
+  sampleResults = std::move(counts.sampleResults);
+  totalShots = counts.totalShots;
+  counters = counts.counters;
+  midCircuitLog = std::move(counts.midCircuitLog);
+  return *this;
+}
+
 sample_result &sample_result::operator=(const sample_result &counts) {
+  registerShots.clear();
   sampleResults.clear();
   for (auto &[name, sampleResult] : counts.sampleResults) {
     sampleResults.insert({name, sampleResult});
   }
   totalShots = counts.totalShots;
+  counters = counts.counters;
+  midCircuitLog = counts.midCircuitLog;
   return *this;
 }
 
 bool sample_result::operator==(const sample_result &counts) const {
+  materializeAll();
+  counts.materializeAll();
   return sampleResults == counts.sampleResults;
 }
 
 sample_result &sample_result::operator+=(sample_result &other) {
-
-  for (auto &otherResults : other.sampleResults) {
-    auto regName = otherResults.first;
+  registerShots.clear();
+  // A register logged on one side and built on the other is built on both
+  // before merging, the logs are then concatenated.
+  for (auto &[name, ours] : sampleResults)
+    other.materialize(name);
+  for (auto &[name, theirs] : other.sampleResults)
+    materialize(name);
+  for (auto &[regName, theirs] : other.sampleResults) {
     auto foundIter = sampleResults.find(regName);
     if (foundIter == sampleResults.end())
-      sampleResults.insert({regName, otherResults.second});
-    else {
-
+      sampleResults.insert({regName, theirs});
+    else
       // we already have a sample result with this name, so
       // now lets just merge them
-      auto &sr = sampleResults[regName];
-      for (auto &[bits, count] : otherResults.second.counts) {
-        auto &ourCounts = sr.counts;
-        if (ourCounts.count(bits))
-          ourCounts[bits] += count;
-        else
-          ourCounts.insert({bits, count});
-      }
+      mergeResult(foundIter->second, theirs);
+  }
+  if (!other.midCircuitLog.empty()) {
+    MeasurementLog theirs = other.midCircuitLog;
+    midCircuitLog.append(std::move(theirs));
+  }
+  totalShots += other.totalShots;
+  counters += other.counters;
+  return *this;
+}
 
-      if (!otherResults.second.sequentialData.empty())
-        sr.sequentialData.insert(sr.sequentialData.end(),
-                                 otherResults.second.sequentialData.begin(),
-                                 otherResults.second.sequentialData.end());
+sample_result &sample_result::operator+=(sample_result &&other) {
+  // Take over the log rather than copying it, the rest is merged as usual.
+  MeasurementLog theirs = std::move(other.midCircuitLog);
+  other.midCircuitLog.clear();
+  for (auto &[name, ours] : sampleResults)
+    if (theirs.contains(name)) {
+      other.midCircuitLog.append(std::move(theirs));
+      return *this += other;
     }
-  }
+  *this += other;
+  registerShots.clear();
+  midCircuitLog.append(std::move(theirs));
   return *this;
 }
 
+sample_result sample_result::merge(std::vector<sample_result> &results) {
+  // The results of each register, in order of appearance.
+  std::vector<std::string> names;
+  std::unordered_map<std::string, std::vector<ExecutionResult *>> groups;
+  std::size_t nKeys = 0;
+  sample_result merged;
+  for (auto &result : results) {
+    result.materializeAll();
+    merged.totalShots += result.totalShots;
+    merged.counters += result.counters;
+    for (auto &[name, r] : result.sampleResults) {
+      auto &group = groups[name];
+      if (group.empty())
+        names.push_back(name);
+      group.push_back(&r);
+      nKeys += r.isPacked() ? r.packedCounts.size() : r.counts.size();
+    }
+  }
+
+  // Each register is merged by one thread, into a table reserved for the
+  // keys of all its results.
+  std::vector<ExecutionResult> registers(names.size());
+  const auto nThreads =
+      std::min(numThreads(nKeys, 1 << 14),
+               std::max<std::size_t>(names.size(), 1));
+  forEachRange(names.size(), nThreads,
+               [&](std::size_t, std::size_t begin, std::size_t end) {
+                 for (std::size_t g = begin; g < end; g++) {
+                   auto &group = groups.at(names[g]);
+                   auto &ours = registers[g];
+                   ours = *group.front();
+                   if (ours.isPacked()) {
+                     std::size_t n = 0;
+                     for (auto *r : group)
+                       n += r->packedCounts.size();
+                     ours.packedCounts.reserve(n);
+                   }
+                   for (std::size_t i = 1; i < group.size(); i++)
+                     mergeResult(ours, *group[i]);
+                 }
+               });
+  for (std::size_t g = 0; g < names.size(); g++)
+    merged.sampleResults.insert({names[g], std::move(registers[g])});
+  return merged;
+}
+
 std::vector<std::string>
 sample_result::sequential_data(const std::string_view registerName) {
+  materialize(registerName);
   auto iter = sampleResults.find(registerName.data());
   if (iter == sampleResults.end())
     throw std::runtime_error(
@@ -255,22 +801,26 @@ sample_result::sequential_data(const std::string_view registerName) {
 }
 
 CountsDictionary::iterator sample_result::begin() {
+  registerShots.clear();
   auto iter = sampleResults.find(GlobalRegisterName);
   if (iter == sampleResults.end()) {
     throw std::runtime_error(
         "There is no global counts dictionary in this sample_result.");
   }
 
+  iter->second.materializeCounts();
   return iter->second.counts.begin();
 }
 
 CountsDictionary::iterator sample_result::end() {
+  registerShots.clear();
   auto iter = sampleResults.find(GlobalRegisterName);
   if (iter == sampleResults.end()) {
     throw std::runtime_error(
         "There is no global counts dictionary in this sample_result.");
   }
 
+  iter->second.materializeCounts();
   return iter->second.counts.end();
 }
 
@@ -281,6 +831,7 @@ CountsDictionary::const_iterator sample_result::cbegin() const {
         "There is no global counts dictionary in this sample_result.");
   }
 
+  iter->second.materializeCounts();
   return iter->second.counts.cbegin();
 }
 
@@ -291,42 +842,91 @@ CountsDictionary::const_iterator sample_result::cend() const {
         "There is no global counts dictionary in this sample_result.");
   }
 
+  iter->second.materializeCounts();
   return iter->second.counts.cend();
 }
 
+std::size_t
+sample_result::get_shots(const std::string_view registerName) const {
+  materialize(registerName);
+  auto iter = sampleResults.find(registerName.data());
+  if (iter == sampleResults.end())
+    return 0;
+  return shotsOf(iter->second);
+}
+
+const PackedCounts &
+sample_result::packed_counts(const std::string_view registerName) {
+  materialize(registerName);
+  auto iter = sampleResults.find(registerName.data());
+  if (iter == sampleResults.end())
+    throw std::runtime_error(
+        "[sample_result::packed_counts] invalid sample result register name (" +
+        std::string(registerName) + ")");
+  auto &result = iter->second;
+  result.packCounts();
+  if (!result.isPacked() && !result.counts.empty())
+    throw std::runtime_error("[sample_result::packed_counts] the bit strings "
+                             "of register " +
+                             std::string(registerName) +
+                             " do not have a common length");
+  return result.packedCounts;
+}
+
 std::size_t sample_result::size(const std::string_view registerName) noexcept {
+  materialize(registerName);
   auto iter = sampleResults.find(registerName.data());
   if (iter == sampleResults.end())
     return 0;
 
+  if (iter->second.isPacked())
+    return iter->second.packedCounts.size();
   return iter->second.counts.size();
 }
 
 double sample_result::probability(std::string_view bitStr,
                                   const std::string_view registerName) {
+  materialize(registerName);
   auto iter = sampleResults.find(registerName.data());
   if (iter == sampleResults.end())
     return 0.0;
 
-  return (double)iter->second.counts[bitStr.data()] / totalShots;
+  return (double)count(bitStr, registerName) / shotsOf(iter->second);
 }
 
 std::size_t sample_result::count(std::string_view bitStr,
                                  const std::string_view registerName) {
+  materialize(registerName);
   auto iter = sampleResults.find(registerName.data());
   if (iter == sampleResults.end())
     return 0;
 
-  return iter->second.counts[bitStr.data()];
+  if (iter->second.isPacked()) {
+    auto &packed = iter->second.packedCounts;
+    auto i = packed.find(bitStr);
+    return i == std::size_t(-1) ? 0 : packed.count(i);
+  }
+  // Look up without inserting the bit string.
+  auto found = iter->second.counts.find(std::string(bitStr));
+  return found == iter->second.counts.end() ? 0 : found->second;
 }
 
 std::string sample_result::most_probable(const std::string_view registerName) {
+  materialize(registerName);
   auto iter = sampleResults.find(registerName.data());
   if (iter == sampleResults.end())
     throw std::runtime_error(
         "[sample_result::most_probable] invalid sample result register name (" +
         std::string(registerName) + ")");
-  auto counts = iter->second.counts;
+  if (iter->second.isPacked()) {
+    auto &packed = iter->second.packedCounts;
+    std::size_t best = 0;
+    for (std::size_t i = 1; i < packed.size(); i++)
+      if (packed.count(i) > packed.count(best))
+        best = i;
+    return packed.bit_string(best);
+  }
+  auto &counts = iter->second.counts;
   return std::max_element(counts.begin(), counts.end(),
                           [](const auto &el1, const auto &el2) {
                             return el1.second < el2.second;
@@ -335,6 +935,7 @@ std::string sample_result::most_probable(const std::string_view registerName) {
 }
 
 bool sample_result::has_expectation(const std::string_view registerName) {
+  materialize(registerName);
   auto iter = sampleResults.find(registerName.data());
   if (iter == sampleResults.end())
     return false;
@@ -342,13 +943,15 @@ bool sample_result::has_expectation(const std::string_view registerName) {
   return iter->second.expectationValue.has_value();
 }
 
-double sample_result::exp_val_z(const std::string_view registerName) {
-  double aver = 0.0;
-  auto has_even_parity = [](const std::string &x) -> bool {
-    int c = std::count(x.begin(), x.end(), '1');
-    return c % 2 == 0;
-  };
+std::size_t sample_result::shotsOf(const ExecutionResult &result) const {
+  auto [iter, inserted] = registerShots.try_emplace(result.registerName, 0);
+  if (inserted)
+    iter->second = result.totalCount();
+  return iter->second ? iter->second : totalShots;
+}
 
+double sample_result::exp_val_z(const std::string_view registerName) {
+  materialize(registerName);
   auto iter = sampleResults.find(registerName.data());
   if (iter == sampleResults.end())
     return 0.0;
@@ -356,54 +959,106 @@ double sample_result::exp_val_z(const std::string_view registerName) {
   if (iter->second.expectationValue.has_value())
     return iter->second.expectationValue.value();
 
-  auto counts = iter->second.counts;
-  for (auto &kv : counts) {
-    auto par = has_even_parity(kv.first);
-    auto p = probability(kv.first, registerName);
-    if (!par) {
-      p = -p;
+  // Sum the counts signed by their parity in one pass, then normalize once.
+  double sum = 0.0;
+  if (iter->second.isPacked()) {
+    auto &packed = iter->second.packedCounts;
+    for (std::size_t i = 0; i < packed.size(); i++) {
+      std::size_t ones = 0;
+      for (std::size_t w = 0; w < packed.n_words(); w++)
+        ones += std::popcount(packed.key(i)[w]);
+      const double count = packed.count(i);
+      sum += ones % 2 ? -count : count;
+    }
+  } else {
+    for (auto &[bits, c] : iter->second.counts) {
+      const double count = c;
+      sum += std::count(bits.begin(), bits.end(), '1') % 2 ? -count : count;
     }
-    aver += p;
   }
 
-  return aver;
+  const auto shots = shotsOf(iter->second);
+  return shots ? sum / shots : 0.0;
 }
 
 std::vector<std::string> sample_result::register_names() {
   std::vector<std::string> ret;
   for (auto &kv : sampleResults)
     ret.push_back(kv.first);
+  for (auto &name : midCircuitLog.register_names())
+    if (!sampleResults.count(name))
+      ret.push_back(name);
 
   return ret;
 }
 
 CountsDictionary sample_result::to_map(const std::string_view registerName) {
+  materialize(registerName);
   auto iter = sampleResults.find(registerName.data());
   if (iter == sampleResults.end())
     return CountsDictionary();
 
-  return iter->second.counts;
+  return iter->second.toCountsDictionary();
 }
 
 sample_result
 sample_result::get_marginal(const std::vector<std::size_t> &marginalIndices,
                             const std::string_view registerName) {
+  materialize(registerName);
   auto iter = sampleResults.find(registerName.data());
   if (iter == sampleResults.end())
     return sample_result();
 
-  auto counts = iter->second.counts;
   auto mutableIndices = marginalIndices;
 
   std::sort(mutableIndices.begin(), mutableIndices.end());
 
   ExecutionResult sr;
+  if (iter->second.isPacked()) {
+    auto &packed = iter->second.packedCounts;
+    for (auto index : mutableIndices)
+      if (index >= packed.n_bits())
+        throw std::runtime_error("Invalid marginal index (" +
+                                 std::to_string(index) + ", size=" +
+                                 std::to_string(packed.n_bits()));
+    const std::size_t nBits = mutableIndices.size();
+    const bool distinct = std::adjacent_find(mutableIndices.begin(),
+                                             mutableIndices.end()) ==
+                          mutableIndices.end();
+    BitGather gather(mutableIndices);
+
+    // Each thread marginalizes a range of the bit strings into its own
+    // table, the tables are then summed.
+    const auto nThreads = numThreads(packed.size(), 1 << 15);
+    std::vector<PackedCounts> partial(nThreads, PackedCounts(nBits));
+    forEachRange(
+        packed.size(), nThreads,
+        [&](std::size_t t, std::size_t begin, std::size_t end) {
+          auto &counts = partial[t];
+          std::vector<std::uint64_t> key(counts.n_words());
+          for (std::size_t i = begin; i < end; i++) {
+            std::fill(key.begin(), key.end(), 0);
+            if (distinct)
+              gather(packed.key(i), key.data());
+            else
+              for (std::size_t j = 0; j < nBits; j++)
+                if (packed.bit(i, mutableIndices[j]))
+                  key[j / 64] |= 1ULL << (j % 64);
+            counts.add(key.data(), packed.count(i));
+          }
+        });
+    sr.packedCounts = std::move(partial.front());
+    for (std::size_t t = 1; t < nThreads; t++)
+      for (std::size_t i = 0; i < partial[t].size(); i++)
+        sr.packedCounts.add(partial[t].key(i), partial[t].count(i));
+    return sample_result(std::move(sr));
+  }
+
+  auto &counts = iter->second.counts;
   for (auto &[bits, count] : counts) {
-    std::string newBits;
-    for ([[maybe_unused]] auto &m : mutableIndices)
-      newBits += "0";
+    std::string newBits(mutableIndices.size(), '0');
     for (int counter = 0; auto &index : mutableIndices) {
-      if (index > bits.size())
+      if (index >= bits.size())
         throw std::runtime_error("Invalid marginal index (" +
                                  std::to_string(index) +
                                  ", size=" + std::to_string(bits.size()));
@@ -413,20 +1068,25 @@ sample_result::get_marginal(const std::vector<std::size_t> &marginalIndices,
     sr.appendResult(newBits, count);
   }
 
-  return sample_result(sr);
+  return sample_result(std::move(sr));
 }
 
 void sample_result::clear() {
+  registerShots.clear();
   sampleResults.clear();
+  midCircuitLog.clear();
   totalShots = 0;
+  counters = execution_counters();
 }
 
 void sample_result::dump(std::ostream &os) {
+  materializeAll();
   os << "{ ";
   if (sampleResults.size() > 1) {
     os << "\n  ";
     std::size_t counter = 0;
     for (auto &result : sampleResults) {
+      result.second.materializeCounts();
       os << result.first << " : { ";
       for (auto &kv : result.second.counts) {
         os << kv.first << ":" << kv.second << " ";
@@ -441,7 +1101,7 @@ void sample_result::dump(std::ostream &os) {
     CountsDictionary counts;
     auto iter = sampleResults.find(GlobalRegisterName);
     if (iter != sampleResults.end())
-      counts = iter->second.counts;
+      counts = iter->second.toCountsDictionary();
 
     for (auto &kv : counts) {
       os << kv.first << ":" << kv.second << " ";
@@ -8,9 +8,12 @@
 
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -21,6 +24,84 @@ using CountsDictionary = std::unordered_map<std::string, std::size_t>;
 
 inline static const std::string GlobalRegisterName = "__global__";
 
+/// @brief Observed bit strings and the number of times they were observed,
+/// with the bit strings packed into words rather than held as strings. Bit j
+/// of a bit string is bit j % 64 of its word j / 64. The packed bit strings
+/// are stored back to back in one buffer and found through an open
+/// addressing hash table, and keep the order they were first added in.
+class PackedCounts {
+  std::size_t nBits = 0;
+  std::size_t nWords = 0;
+  std::vector<std::uint64_t> keys;
+  std::vector<std::size_t> keyCounts;
+  /// @brief The hash table, each slot holds 1 + the index of a bit string,
+  /// or 0 if it is empty. Its size is a power of two.
+  std::vector<std::size_t> slots;
+
+  /// @brief Return the slot holding the given bit string, or the empty slot
+  /// it would go to.
+  std::size_t findSlot(const std::uint64_t *key) const;
+
+  /// @brief Resize the hash table to the given number of slots, a power of
+  /// two, and reinsert the bit strings.
+  void rehash(std::size_t nSlots);
+
+public:
+  PackedCounts() = default;
+
+  /// @brief Construct empty counts of bit strings of the given length.
+  explicit PackedCounts(std::size_t nBits);
+
+  /// @brief Return the length of the bit strings.
+  std::size_t n_bits() const { return nBits; }
+
+  /// @brief Return the number of words of each packed bit string.
+  std::size_t n_words() const { return nWords; }
+
+  /// @brief Return the number of distinct bit strings.
+  std::size_t size() const { return keyCounts.size(); }
+  bool empty() const { return keyCounts.empty(); }
+
+  /// @brief Reserve the memory for the given number of distinct bit strings.
+  void reserve(std::size_t n);
+
+  /// @brief Add the count to the packed bit string (n_words() words) and
+  /// return its index.
+  std::size_t add(const std::uint64_t *key, std::size_t count);
+
+  /// @brief Add the count to the bit string of '0' and '1' characters and
+  /// return its index. The first string added sets the length.
+  std::size_t add(std::string_view bits, std::size_t count);
+
+  /// @brief Return the index of the given bit string, or -1.
+  std::size_t find(std::string_view bits) const;
+
+  /// @brief Return the i-th packed bit string.
+  const std::uint64_t *key(std::size_t i) const {
+    return keys.data() + i * nWords;
+  }
+
+  /// @brief Return bit j of the i-th bit string.
+  bool bit(std::size_t i, std::size_t j) const {
+    return (key(i)[j / 64] >> (j % 64)) & 1;
+  }
+
+  /// @brief Return the count of the i-th bit string.
+  std::size_t count(std::size_t i) const { return keyCounts[i]; }
+
+  /// @brief Return the packed bit strings, back to back, and their counts.
+  const std::uint64_t *keys_data() const { return keys.data(); }
+  const std::size_t *counts_data() const { return keyCounts.data(); }
+
+  /// @brief Return the i-th bit string as '0' and '1' characters.
+  std::string bit_string(std::size_t i) const;
+
+  /// @brief Return the sum of all counts.
+  std::size_t total() const;
+
+  void clear();
+};
+
 /// The ExecutionResult models the result of a typical
 /// quantum state sampling task. It will contain the
 /// observed measurement bit strings and corresponding number
@@ -39,6 +120,15 @@ struct ExecutionResult {
   /// @brief Sequential bit strings observed (not collated into a map)
   std::vector<std::string> sequentialData;
 
+  /// @brief The counts appended with packed bit strings. While these are
+  /// not empty, `counts` and `sequentialData` are only filled from them by
+  /// materializeCounts().
+  PackedCounts packedCounts;
+
+  /// @brief The indices into packedCounts of the appended bit strings, in
+  /// order.
+  std::vector<std::size_t> packedSequence;
+
   /// @brief Serialize this sample result to a vector of integers.
   /// Encoding: 1st element is size of the register name N, then next N
   /// represent register name, next is the number of Bitstrings M,
@@ -76,14 +166,16 @@ struct ExecutionResult {
   /// @param e The pre-computed expected value
   ExecutionResult(CountsDictionary c, double e);
 
-  /// @brief Copy constructor
-  /// @param other
-  ExecutionResult(const ExecutionResult &other);
+  /// @brief Copy and move constructors, moving takes over the counts
+  /// without copying them.
+  ExecutionResult(const ExecutionResult &other) = default;
+  ExecutionResult(ExecutionResult &&other) = default;
 
   /// @brief Set this ExecutionResult equal to the provided one
   /// @param other
   /// @return
-  ExecutionResult &operator=(ExecutionResult &other);
+  ExecutionResult &operator=(const ExecutionResult &other) = default;
+  ExecutionResult &operator=(ExecutionResult &&other) = default;
 
   /// @brief Return true if the given ExecutionResult is the same as this one.
   /// @param result
@@ -95,9 +187,126 @@ struct ExecutionResult {
   /// @param count
   void appendResult(std::string bitString, std::size_t count);
 
-  std::vector<std::string> getSequentialData() { return sequentialData; }
+  /// @brief Append the packed bit string of the given length (see
+  /// PackedCounts) and count to this ExecutionResult, without creating a
+  /// string.
+  void appendResult(const std::uint64_t *bits, std::size_t nBits,
+                    std::size_t count);
+
+  /// @brief Return true if the counts are held as packed bit strings.
+  bool isPacked() const { return !packedCounts.empty(); }
+
+  /// @brief Move packed counts into the `counts` and `sequentialData`
+  /// strings. Does nothing if the counts are not packed.
+  void materializeCounts();
+
+  /// @brief Move string counts into `packedCounts`, if they have a common
+  /// length. Does nothing if the counts are packed already.
+  void packCounts();
+
+  /// @brief Return the sum of all counts.
+  std::size_t totalCount() const;
+
+  /// @brief Return the counts keyed by bit string, whether packed or not.
+  CountsDictionary toCountsDictionary() const;
+
+  std::vector<std::string> getSequentialData() {
+    materializeCounts();
+    return sequentialData;
+  }
 };
 
+/// @brief The mid-circuit measurement results of a kernel executed once per
+/// shot, logged as one packed record per shot rather than as an
+/// ExecutionResult per register. The results of a register are only built
+/// from the records when it is first read, see sample_result.
+class MeasurementLog {
+public:
+  /// @brief A named register and the positions of its measurements in the
+  /// record. A vector register (auto bits = mz(qreg)) gives one bit string
+  /// per shot, any other register one single bit result per measurement.
+  struct Register {
+    std::string name;
+    std::vector<std::size_t> bits;
+    bool isVector = false;
+    bool operator==(const Register &) const = default;
+  };
+
+private:
+  /// @brief Consecutive shots of the same registers, with their distinct
+  /// records and the index of the record of each shot.
+  struct Segment {
+    std::vector<Register> registers;
+    PackedCounts records;
+    std::vector<std::size_t> sequence;
+  };
+  std::vector<Segment> segments;
+
+public:
+  /// @brief Append the record of one shot, its measurement results in order
+  /// packed as by PackedCounts, and the registers they belong to.
+  void append(std::vector<Register> &&registers, const std::uint64_t *record,
+              std::size_t nBits);
+
+  /// @brief Append the shots of the other log after these.
+  void append(MeasurementLog &&other);
+
+  /// @brief Return true if no register is left to build.
+  bool empty() const { return segments.empty(); }
+
+  /// @brief Return true if the register is in the log.
+  bool contains(std::string_view name) const;
+
+  /// @brief Return the register names, in order of first appearance.
+  std::vector<std::string> register_names() const;
+
+  /// @brief Build the results of the register, in shot order, and remove it
+  /// from the log. Returns false if the register is not in the log.
+  bool take(std::string_view name, ExecutionResult &result);
+
+  void clear() { segments.clear(); }
+};
+
+/// @brief The covariance of the +1 / -1 parities of two registers sampled on
+/// the same shots, per shot. The terms of a qubit-wise commuting group of an
+/// observe are measured on the same shots, so their counts are correlated.
+struct shot_covariance {
+  std::string first;
+  std::string second;
+  double covariance = 0.0;
+};
+
+/// @brief Performance counters of the kernel executions behind a result,
+/// summed over the executions (e.g. one per shot of a kernel with
+/// conditionals on measurements, or one per circuit submitted to a remote
+/// QPU).
+struct execution_counters {
+  /// @brief The number of gates applied to the simulated state.
+  std::size_t gates = 0;
+  /// @brief The number of passes over the simulated state applying gates,
+  /// fewer than the gates if gates are fused.
+  std::size_t state_sweeps = 0;
+  /// @brief The largest size of the simulated state, in bytes.
+  std::size_t peak_state_bytes = 0;
+  /// @brief The time spent in the simulator, and the rest of the time of the
+  /// executions spent in host code, in seconds.
+  double simulator_seconds = 0.0;
+  double host_seconds = 0.0;
+  /// @brief The number of kernel executions.
+  std::size_t kernel_executions = 0;
+
+  /// @brief Add the counters of other executions. The peak state size is
+  /// the larger of both.
+  execution_counters &operator+=(const execution_counters &other);
+};
+
+class sample_result;
+class sample_result_view;
+namespace columnar {
+void write(const sample_result &,
+           const std::function<void(const void *, std::size_t)> &, bool);
+}
+
 /// @brief The sample_result abstraction wraps a set of ExecutionResults for
 /// a single quantum kernel execution under the sampling or observation
 /// ExecutionContext. Each ExecutionResult is mapped to a register name,
@@ -105,31 +314,68 @@ struct ExecutionResult {
 /// observed measurement results holistically for the quantum kernel.
 class sample_result {
 private:
-  /// @brief A mapping of register names to ExecutionResults
-  std::unordered_map<std::string, ExecutionResult> sampleResults;
+  /// @brief A mapping of register names to ExecutionResults. Packed counts
+  /// are only materialized as strings when iterated over, also by the const
+  /// iterators.
+  mutable std::unordered_map<std::string, ExecutionResult> sampleResults;
 
   /// @brief Keep track of the total number of shots. We keep this
   /// here so we don't have to keep recomputing it.
   std::size_t totalShots = 0;
 
+  /// @brief The performance counters of the executions.
+  execution_counters counters;
+
+  /// @brief The total count of each register, computed once on first use.
+  /// Cleared whenever the counts may change.
+  mutable std::unordered_map<std::string, std::size_t> registerShots;
+
+  /// @brief The mid-circuit measurement results of the registers not read
+  /// yet. A register is moved into sampleResults on first access.
+  mutable MeasurementLog midCircuitLog;
+
+  /// @brief Return the total count of the given ExecutionResult, or the
+  /// total number of shots if it holds no counts.
+  std::size_t shotsOf(const ExecutionResult &result) const;
+
+  /// @brief Build the results of the register from the mid-circuit log, if
+  /// it is still there.
+  void materialize(std::string_view registerName) const;
+
+  /// @brief Build the results of all registers of the mid-circuit log.
+  void materializeAll() const;
+
+  friend void columnar::write(const sample_result &,
+                              const std::function<void(const void *,
+                                                       std::size_t)> &,
+                              bool);
+  friend class sample_result_view;
+
 public:
   /// @brief Nullary constructor
   sample_result() = default;
 
-  /// @brief The constructor, sets the __global__ sample result.
+  /// @brief The constructor, sets the __global__ sample result. The rvalue
+  /// overloads here move the counts rather than copying them.
   /// @param result
   sample_result(ExecutionResult &result);
+  sample_result(ExecutionResult &&result);
 
   /// @brief The constructor, appends all provided ExecutionResults
   sample_result(std::vector<ExecutionResult> &results);
+  sample_result(std::vector<ExecutionResult> &&results);
 
   /// @brief The constructor, takes a pre-computed expectation value and
   /// stores it with the __global__ ExecutionResult.
   sample_result(double preComputedExp, std::vector<ExecutionResult> &results);
+  sample_result(double preComputedExp, std::vector<ExecutionResult> &&results);
 
   /// @brief Copy Constructor
   sample_result(const sample_result &);
 
+  /// @brief Move Constructor
+  sample_result(sample_result &&) = default;
+
   /// @brief The destructor
   ~sample_result() = default;
 
@@ -141,6 +387,16 @@ public:
   /// @brief Add another ExecutionResult to this pre-constructed sample_result
   /// @param result
   void append(ExecutionResult &result);
+  void append(ExecutionResult &&result);
+
+  /// @brief Add the registers of the mid-circuit measurement log, which are
+  /// only built when first read.
+  void append(MeasurementLog &&log);
+
+  /// @brief Remove the ExecutionResult of the given register and return it,
+  /// moving rather than copying its counts.
+  ExecutionResult
+  extract_register(const std::string_view registerName = GlobalRegisterName);
 
   /// @brief Return all register names. Can be used in tandem with
   /// sample_result::to_map(regName : string) to retrieve the counts
@@ -153,12 +409,19 @@ public:
   /// @return
   sample_result &operator=(sample_result &counts);
   sample_result &operator=(const sample_result &counts);
+  sample_result &operator=(sample_result &&counts);
 
   /// @brief Append all the data from other to this sample_result.
   /// Merge when necessary.
   /// @param other
   /// @return
   sample_result &operator+=(sample_result &other);
+  sample_result &operator+=(sample_result &&other);
+
+  /// @brief Merge the given sample_results, e.g. those of several QPUs, at
+  /// once. The results of each register are merged into a table reserved
+  /// for all of them, and the registers are merged in parallel.
+  static sample_result merge(std::vector<sample_result> &results);
 
   /// @brief Serialize this sample_result. Encoding is
   /// [(ExecutionResult0_Encoding)
@@ -206,6 +469,18 @@ public:
   std::size_t
   size(const std::string_view registerName = GlobalRegisterName) noexcept;
 
+  /// @brief Return the number of shots of the given register, i.e. its
+  /// total count, or 0 if there is no such register.
+  std::size_t
+  get_shots(const std::string_view registerName = GlobalRegisterName) const;
+
+  /// @brief Return the counts of the given register as packed bit strings,
+  /// packing them if they are held as strings. Throws if there is no such
+  /// register, or if its bit strings do not have a common length. The
+  /// reference is valid until the counts are next read as strings.
+  const PackedCounts &
+  packed_counts(const std::string_view registerName = GlobalRegisterName);
+
   /// @brief Dump this sample_result to standard out.
   void dump();
 
@@ -215,6 +490,13 @@ public:
   /// @brief Clear this sample_result.
   void clear();
 
+  /// @brief Return the performance counters of the kernel executions that
+  /// produced this sample_result. Merged results sum their counters.
+  const execution_counters &get_counters() const { return counters; }
+
+  /// @brief Set the performance counters of the executions.
+  void set_counters(const execution_counters &c) { counters = c; }
+
   /// @brief Extract the ExecutionResults as a std::unordered<string, size_t>
   /// map.
   /// @param registerName
@@ -230,11 +512,12 @@ public:
   sample_result
   get_marginal(const std::vector<std::size_t> &&marginalIndices,
                const std::string_view registerName = GlobalRegisterName) {
-    return get_marginal(marginalIndices);
+    return get_marginal(marginalIndices, registerName);
   }
 
   /// @brief Extract marginal counts, ie those counts for a subset of measured
-  /// qubits
+  /// qubits. Packed bit strings are marginalized by gathering the bits of
+  /// each word at once, on several threads for large results.
   /// @param marginalIndices The qubit indices as an reference
   /// @param registerName
   /// @return
@@ -84,7 +84,7 @@ kraus_channel &kraus_channel::operator=(const kraus_channel &other) {
   return *this;
 }
 
-std::vector<kraus_op> kraus_channel::get_ops() { return ops; }
+const std::vector<kraus_op> &kraus_channel::get_ops() const { return ops; }
 void kraus_channel::push_back(kraus_op op) { ops.push_back(op); }
 
 void noise_model::add_channel(const std::string &quantumOp,
@@ -122,6 +122,19 @@ void noise_model::add_channel(const std::string &quantumOp,
   iter->second.push_back(channel);
 }
 
+void noise_model::add_readout_error(std::size_t qubit,
+                                    const std::array<double, 4> &matrix) {
+  for (std::size_t i = 0; i < 2; i++) {
+    auto p0 = matrix[2 * i], p1 = matrix[2 * i + 1];
+    if (p0 < 0. || p1 < 0. || std::abs(p0 + p1 - 1.) > 1e-9)
+      throw std::runtime_error(
+          "Invalid readout error matrix for qubit " + std::to_string(qubit) +
+          ", its rows must be probabilities summing to one.");
+  }
+  cudaq::info("Adding readout error to noise_model (qubit {})", qubit);
+  readoutErrors.insert_or_assign(qubit, matrix);
+}
+
 std::vector<kraus_channel>
 noise_model::get_channels(const std::string &quantumOp,
                           const std::vector<std::size_t> &qubits) {
@@ -136,6 +149,45 @@ noise_model::get_channels(const std::string &quantumOp,
   return iter->second;
 }
 
+std::vector<complex>
+get_superoperator(const std::vector<kraus_channel> &channels,
+                  std::size_t nQubits) {
+  std::vector<complex> superOp;
+  const std::size_t dim = 1ULL << nQubits;
+  const std::size_t superDim = dim * dim;
+  for (auto &channel : channels) {
+    std::vector<complex> channelOp(superDim * superDim, 0.0);
+    for (auto &op : channel.get_ops()) {
+      if (op.nRows != dim)
+        throw std::runtime_error(
+            "Invalid kraus_op dimension " + std::to_string(op.nRows) +
+            " for a channel on " + std::to_string(nQubits) + " qubits.");
+      // Kraus op data are read column major, K[a][c] = data[a + c * dim].
+      const auto &K = op.data;
+      for (std::size_t a = 0; a < dim; a++)
+        for (std::size_t b = 0; b < dim; b++)
+          for (std::size_t c = 0; c < dim; c++)
+            for (std::size_t e = 0; e < dim; e++)
+              channelOp[(a * dim + b) * superDim + c * dim + e] +=
+                  K[a + c * dim] * std::conj(K[b + e * dim]);
+    }
+
+    // Channels act in sequence, compose as S = S_channel * S.
+    if (superOp.empty()) {
+      superOp = std::move(channelOp);
+      continue;
+    }
+    std::vector<complex> composed(superDim * superDim, 0.0);
+    for (std::size_t r = 0; r < superDim; r++)
+      for (std::size_t k = 0; k < superDim; k++)
+        for (std::size_t c = 0; c < superDim; c++)
+          composed[r * superDim + c] +=
+              channelOp[r * superDim + k] * superOp[k * superDim + c];
+    superOp = std::move(composed);
+  }
+  return superOp;
+}
+
 depolarization_channel::depolarization_channel(const double p)
     : kraus_channel() {
   std::vector<complex> k0v{std::sqrt(1 - p), 0, 0, std::sqrt(1 - p)},
@@ -10,6 +10,11 @@
 
 #include <array>
 #include <complex>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -126,7 +131,7 @@ public:
   kraus_channel &operator=(const kraus_channel &other);
 
   /// @brief Return all kraus_ops in this channel
-  std::vector<kraus_op> get_ops();
+  const std::vector<kraus_op> &get_ops() const;
 
   /// @brief Add a kraus_op to this channel.
   void push_back(kraus_op op);
@@ -159,20 +164,51 @@ protected:
   using NoiseModelOpMap =
       std::unordered_map<KeyT, std::vector<kraus_channel>, KeyTHash>;
 
-  static const constexpr std::array<const char *, 10> availableOps{
-      "x", "y", "z", "h", "s", "t", "rx", "ry", "rz", "r1"};
+  static const constexpr std::array<const char *, 13> availableOps{
+      "x",  "y",  "z",  "h",  "s",  "t",   "rx",
+      "ry", "rz", "r1", "u2", "u3", "swap"};
 
   // The noise model is a mapping of quantum operation
   // names to a kraus channel applied after the operation is applied.
   NoiseModelOpMap noiseModel;
 
+  /// @brief The readout error matrices of the measured qubits, keyed by the
+  /// qubit.
+  std::unordered_map<std::size_t, std::array<double, 4>> readoutErrors;
+
 public:
   /// @brief default constructor
   noise_model() = default;
 
-  /// @brief Return true if there are no kraus_channels in this noise model.
-  /// @return
-  bool empty() const { return noiseModel.empty(); }
+  /// @brief Return true if there are no kraus_channels and no readout errors
+  /// in this noise model.
+  bool empty() const { return noiseModel.empty() && readoutErrors.empty(); }
+
+  /// @brief Add a readout error to the measurements of the qubit. The
+  /// matrix is row major, its element (i, j) is the probability to read j
+  /// when the qubit is measured in state i. Its rows must sum to one.
+  void add_readout_error(std::size_t qubit,
+                         const std::array<double, 4> &matrix);
+
+  /// @brief Add a readout error to the measurements of the qubit, which reads
+  /// 1 instead of 0 with probability `p01`, and 0 instead of 1 with
+  /// probability `p10`.
+  void add_readout_error(std::size_t qubit, double p01, double p10) {
+    add_readout_error(qubit, {1. - p01, p01, p10, 1. - p10});
+  }
+
+  /// @brief Return the readout error matrix of the qubit, or nullptr if its
+  /// measurements are exact.
+  const std::array<double, 4> *get_readout_error(std::size_t qubit) const {
+    auto iter = readoutErrors.find(qubit);
+    return iter == readoutErrors.end() ? nullptr : &iter->second;
+  }
+
+  /// @brief Return true if some quantum operation has kraus_channels.
+  bool has_channels() const { return !noiseModel.empty(); }
+
+  /// @brief Return true if measurements of some qubit have readout errors.
+  bool has_readout_errors() const { return !readoutErrors.empty(); }
 
   /// @brief Add the Kraus channel to the specified one-qubit quantum
   /// operation. It applies to the quantumOp operation for the specified
@@ -213,8 +249,93 @@ public:
     QuantumOp op;
     return get_channels(op.name, qubits);
   }
+
+  /// @brief The number of quantum operations kraus_channels can be added to.
+  static constexpr std::size_t num_ops = availableOps.size();
+
+  /// @brief Return the index of the quantum operation among those
+  /// kraus_channels can be added to, or nothing for the other operations,
+  /// which are noiseless.
+  static std::optional<std::size_t> op_index(std::string_view quantumOp) {
+    for (std::size_t i = 0; i < num_ops; i++)
+      if (quantumOp == availableOps[i])
+        return i;
+    return std::nullopt;
+  }
+
+  /// @brief Call `f` with the quantum operation, the qubits and the
+  /// kraus_channels of every entry of this noise model.
+  void for_each_channels(
+      const std::function<void(const std::string &,
+                               const std::vector<std::size_t> &,
+                               const std::vector<kraus_channel> &)> &f) const {
+    for (auto &[key, channels] : noiseModel)
+      f(key.first, key.second, channels);
+  }
 };
 
+/// @brief A noise_model frozen into a table of values built once from the
+/// kraus_channels of each of its entries, e.g. their superoperators, for
+/// simulators that look up the noise of every gate. The table is indexed by
+/// the operation index, then by the qubit for one-qubit channels, which are
+/// stored densely. Channels on several qubits are keyed by their qubits.
+/// Lookups return references and allocate nothing.
+template <typename T>
+class noise_table {
+  std::array<std::vector<std::optional<T>>, noise_model::num_ops> single;
+  std::array<std::map<std::vector<std::size_t>, T>, noise_model::num_ops>
+      multi;
+
+public:
+  noise_table() = default;
+
+  /// @brief Freeze the noise model, the value of an entry is
+  /// `build(quantumOp, qubits, channels)`.
+  template <typename Build>
+  noise_table(const noise_model &model, Build &&build) {
+    model.for_each_channels([&](const std::string &quantumOp,
+                                const std::vector<std::size_t> &qubits,
+                                const std::vector<kraus_channel> &channels) {
+      auto op = *noise_model::op_index(quantumOp);
+      T value = build(quantumOp, qubits, channels);
+      if (qubits.size() != 1) {
+        multi[op].insert_or_assign(qubits, std::move(value));
+        return;
+      }
+      auto &row = single[op];
+      if (row.size() <= qubits[0])
+        row.resize(qubits[0] + 1);
+      row[qubits[0]] = std::move(value);
+    });
+  }
+
+  /// @brief Return the value for the quantum operation on the qubits, or
+  /// nullptr if the noise model has no kraus_channels for them.
+  const T *find(std::string_view quantumOp,
+                const std::vector<std::size_t> &qubits) const {
+    auto op = noise_model::op_index(quantumOp);
+    if (!op)
+      return nullptr;
+    if (qubits.size() == 1) {
+      auto &row = single[*op];
+      if (qubits[0] >= row.size() || !row[qubits[0]])
+        return nullptr;
+      return &*row[qubits[0]];
+    }
+    auto iter = multi[*op].find(qubits);
+    return iter == multi[*op].end() ? nullptr : &iter->second;
+  }
+};
+
+/// @brief Return the superoperator of the kraus_channels, acting in
+/// sequence on `nQubits` qubits. It is the row major (d^2 x d^2) matrix S
+/// with S[(a,b),(c,e)] = sum_K K[a][c] conj(K[b][e]), so that vec(rho') =
+/// S vec(rho) for rho' = sum K rho K^dag, the first qubit being the most
+/// significant bit of a, b, c and e.
+std::vector<complex>
+get_superoperator(const std::vector<kraus_channel> &channels,
+                  std::size_t nQubits);
+
 /// @brief depolarization_channel is a kraus_channel that
 /// automates the creation of the kraus_ops that make up
 /// a single-qubit depolarization error channel.
@@ -9,12 +9,47 @@
 #pragma once
 
 #include "MeasureCounts.h"
+#include "ReadoutMitigation.h"
 #include "cudaq/spin_op.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <unordered_map>
 
 namespace cudaq {
 
+namespace details {
+/// @brief Split `budget` shots in proportion to the non-negative weights,
+/// rounding down and then handing out the remaining shots by largest
+/// remainder. Returns no shots at all if every weight is 0.
+inline std::vector<std::size_t>
+apportionShots(std::size_t budget, const std::vector<double> &weights) {
+  double total = 0.0;
+  for (auto w : weights)
+    total += w;
+  std::vector<std::size_t> shots(weights.size(), 0);
+  if (total <= 0.0)
+    return shots;
+
+  std::vector<std::pair<double, std::size_t>> remainders;
+  std::size_t assigned = 0;
+  for (std::size_t t = 0; t < weights.size(); t++) {
+    const double exact = budget * weights[t] / total;
+    shots[t] = std::min(static_cast<std::size_t>(exact), budget - assigned);
+    assigned += shots[t];
+    remainders.emplace_back(exact - shots[t], t);
+  }
+  std::sort(remainders.begin(), remainders.end(),
+            [](auto &a, auto &b) { return a.first > b.first; });
+  for (std::size_t i = 0; assigned < budget && i < remainders.size(); i++) {
+    shots[remainders[i].second]++;
+    assigned++;
+  }
+  return shots;
+}
+} // namespace details
+
 /// @brief The observe_result encapsulates all data generated from a
 /// cudaq"::"observe call. This includes all measurement counts from the
 /// execution of each ansatz + measure circuit, and the global expected
@@ -30,6 +65,19 @@ protected:
   // Contains ExecutionResults for all terms measured
   sample_result data;
 
+  // The covariances of the terms measured on the same shots
+  std::vector<shot_covariance> covariances;
+
+  /// @brief Return the shot noise variance of the expectation value of the
+  /// term of the given name, or 0 if it has no counts.
+  double termVariance(const std::string &name) {
+    const auto shots = data.get_shots(name);
+    if (!shots || data.size(name) == 0)
+      return 0.0;
+    const double e = data.exp_val_z(name);
+    return (1.0 - e * e) / shots;
+  }
+
 public:
   observe_result() = default;
 
@@ -42,15 +90,28 @@ public:
   /// was shots based, also provide the sample_result data containing counts
   /// for each term in H.
   observe_result(double &e, spin_op &H, sample_result counts)
-      : expValZ(e), spinOp(H), data(counts) {}
+      : expValZ(e), spinOp(H), data(std::move(counts)) {}
 
   observe_result(double &&e, spin_op &H, sample_result counts)
-      : expValZ(e), spinOp(H), data(counts) {}
+      : expValZ(e), spinOp(H), data(std::move(counts)) {}
+
+  /// @brief Constructor, also takes the covariances of the terms measured on
+  /// the same shots.
+  observe_result(double e, spin_op &H, sample_result counts,
+                 std::vector<shot_covariance> covariances)
+      : expValZ(e), spinOp(H), data(std::move(counts)),
+        covariances(std::move(covariances)) {}
 
   /// @brief Return the raw counts data for all terms
   /// @return
   sample_result raw_data() { return data; };
 
+  /// @brief Return the performance counters of the kernel executions of
+  /// this observation.
+  const execution_counters &get_counters() const {
+    return data.get_counters();
+  }
+
   /// @brief Conversion operator for this observe_result to double. Simply
   /// returns the pre-computed expectation value for the given spin_op. This
   // enables one to ignore the fine-grain sample_result data, and explicitly
@@ -73,6 +134,108 @@ public:
     return data.exp_val_z(term.to_string(false));
   }
 
+  /// @brief Return the shot noise variance of exp_val_z(term), i.e.
+  /// (1 - <P>^2) / shots for a term P, or 0 if it was computed exactly.
+  template <typename SpinOpType>
+  double variance(SpinOpType term) {
+    static_assert(std::is_same_v<spin_op, std::remove_reference_t<SpinOpType>>,
+                  "Must provide a one term spin_op");
+    return termVariance(term.to_string(false));
+  }
+
+  /// @brief Return the expectation value of the spin_op with the counts of
+  /// every term corrected for readout errors by the mitigator. The counts of
+  /// a term measure its qubits in increasing order. Returns exp_val_z() if
+  /// the expectation value was not computed from counts.
+  double exp_val_z(const readout_mitigator &mitigator) {
+    double sum = 0.0;
+    for (auto term : spinOp.terms()) {
+      const double c = term.get_coefficient().real();
+      if (term.is_identity()) {
+        sum += c;
+        continue;
+      }
+      const auto name = term.to_string(false);
+      if (data.size(name) == 0)
+        return expValZ;
+      std::vector<std::size_t> qubits;
+      for (std::size_t q = 0; q < term.n_qubits(); ++q)
+        if (term.get_pauli(q) != pauli::I)
+          qubits.push_back(q);
+      sum += c * mitigator.exp_val_z(data, qubits, name);
+    }
+    return sum;
+  }
+
+  /// @brief Return the shot noise covariance of exp_val_z(a) and
+  /// exp_val_z(b). This is 0 unless the terms were measured on the same
+  /// shots, as the qubit-wise commuting terms of a group are.
+  template <typename SpinOpType>
+  double covariance(SpinOpType a, SpinOpType b) {
+    static_assert(std::is_same_v<spin_op, std::remove_reference_t<SpinOpType>>,
+                  "Must provide one term spin_ops");
+    const auto first = a.to_string(false), second = b.to_string(false);
+    if (first == second)
+      return termVariance(first);
+    for (auto &c : covariances)
+      if ((c.first == first && c.second == second) ||
+          (c.first == second && c.second == first)) {
+        const auto shots = data.get_shots(first);
+        return shots ? c.covariance / shots : 0.0;
+      }
+    return 0.0;
+  }
+
+  /// @brief Return the shot noise variance of exp_val_z(), the variances
+  /// and covariances of the terms weighted by their coefficients. This needs
+  /// no further sampling, and is 0 if the expectation value is exact.
+  double variance() {
+    std::unordered_map<std::string, double> coefficients;
+    double sum = 0.0;
+    for (auto term : spinOp.terms()) {
+      if (term.is_identity())
+        continue;
+      const auto name = term.to_string(false);
+      const double c = term.get_coefficient().real();
+      coefficients[name] = c;
+      sum += c * c * termVariance(name);
+    }
+    for (auto &c : covariances) {
+      auto a = coefficients.find(c.first), b = coefficients.find(c.second);
+      const auto shots = data.get_shots(c.first);
+      if (a != coefficients.end() && b != coefficients.end() && shots)
+        sum += 2 * a->second * b->second * c.covariance / shots;
+    }
+    return sum;
+  }
+
+  /// @brief Return the covariances of the terms measured on the same shots,
+  /// per shot.
+  const std::vector<shot_covariance> &shot_covariances() const {
+    return covariances;
+  }
+
+  /// @brief Return the number of shots to spend on each term of the spin_op,
+  /// in term order, to minimize the variance of the expectation value for
+  /// the given budget. A term P of coefficient c gets shots in proportion to
+  /// |c| sqrt(1 - <P>^2), estimated from this result, and identity terms
+  /// get none. The covariances of terms measured together are not taken
+  /// into account.
+  std::vector<std::size_t> optimal_shots(std::size_t budget) {
+    std::vector<double> weights;
+    for (auto term : spinOp.terms()) {
+      if (term.is_identity()) {
+        weights.push_back(0.0);
+        continue;
+      }
+      const auto name = term.to_string(false);
+      const double e = data.size(name) ? data.exp_val_z(name) : 0.0;
+      weights.push_back(std::abs(term.get_coefficient().real()) *
+                        std::sqrt(std::max(1.0 - e * e, 0.0)));
+    }
+    return details::apportionShots(budget, weights);
+  }
+
   /// @brief Return the counts data for the given spin_op
   /// @param term
   /// @return
@@ -89,9 +252,9 @@ public:
   /// @brief Return the coefficient of the identity term.
   /// @return
   double id_coefficient() {
-    for (std::size_t i = 0; i < spinOp.n_terms(); i++)
-      if (spinOp[i].is_identity())
-        return spinOp[i].get_term_coefficient(0).real();
+    for (auto term : spinOp.terms())
+      if (term.is_identity())
+        return term.get_coefficient().real();
     return 0.0;
   }
 
@@ -99,4 +262,77 @@ public:
   void dump() { data.dump(); }
 };
 
+namespace details {
+
+/// @brief Return the measurement setting of a group of qubit-wise commuting
+/// terms of `H` (see spin_op::get_qubit_wise_commuting_groups()), as the
+/// union of their binary symplectic rows.
+inline std::vector<bool>
+getMeasurementBasis(const spin_op &H, const std::vector<std::size_t> &group) {
+  const auto nQubits = H.n_qubits();
+  std::vector<bool> basis(2 * nQubits);
+  for (auto t : group) {
+    const auto term = H.get_term(t);
+    for (std::size_t q = 0; q < nQubits; ++q) {
+      const auto p = term.get_pauli(q);
+      basis[q] = basis[q] || p == pauli::X || p == pauli::Y;
+      basis[q + nQubits] = basis[q + nQubits] || p == pauli::Z || p == pauli::Y;
+    }
+  }
+  return basis;
+}
+
+/// @brief Return the name of the register holding the counts of a group of
+/// qubit-wise commuting terms of `H`. This is the name of the Pauli word
+/// measured by the group, like spin_op::to_string(false) of a term.
+inline std::string
+getMeasurementBasisName(const spin_op &H,
+                        const std::vector<std::size_t> &group) {
+  auto basis = getMeasurementBasis(H, group);
+  const auto nQubits = H.n_qubits();
+  std::string name;
+  for (std::size_t q = 0; q < nQubits; ++q) {
+    bool x = basis[q], z = basis[q + nQubits];
+    name += (x && z ? "Y" : x ? "X" : z ? "Z" : "I") + std::to_string(q);
+  }
+  return name;
+}
+
+/// @brief Add the counts of each non-identity term of `H` to `data`,
+/// marginalized from the counts of its qubit-wise commuting group. These are
+/// expected in the register named by getMeasurementBasisName(), or in the
+/// global register if `H` has a single group.
+inline void marginalizeGroupCounts(sample_result &data, const spin_op &H) {
+  const auto nQubits = H.n_qubits();
+  auto groups = H.get_qubit_wise_commuting_groups();
+  for (auto &group : groups) {
+    auto basis = getMeasurementBasis(H, group);
+    auto groupCounts = groups.size() == 1
+                           ? data.to_map()
+                           : data.to_map(getMeasurementBasisName(H, group));
+    for (auto t : group) {
+      // The group bit strings hold the measured qubits in increasing order.
+      const auto term = H.get_term(t);
+      std::vector<std::size_t> bitPositions;
+      for (std::size_t q = 0, i = 0; q < nQubits; ++q) {
+        if (!basis[q] && !basis[q + nQubits])
+          continue;
+        if (term.get_pauli(q) != pauli::I)
+          bitPositions.push_back(i);
+        ++i;
+      }
+
+      ExecutionResult termResult(term.to_string(false));
+      for (auto &[bits, count] : groupCounts) {
+        std::string termBits;
+        for (auto i : bitPositions)
+          termBits += bits[i];
+        termResult.counts[termBits] += count;
+      }
+      data.append(termResult);
+    }
+  }
+}
+} // namespace details
+
 } // namespace cudaq
@@ -0,0 +1,356 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <set>
+#include <string>
+
+namespace cudaq::profiler {
+
+namespace details {
+std::atomic<bool> enabled = false;
+} // namespace details
+
+namespace {
+
+/// The events of one thread. The buffer is only contended while the events
+/// are exported.
+struct ThreadBuffer {
+  std::mutex mutex;
+  std::vector<Event> events;
+  /// The index the next event is stored at, once the buffer is full.
+  std::size_t next = 0;
+  std::size_t capacity = 0;
+  std::uint32_t thread = 0;
+};
+
+/// The buffers of all threads that recorded events, kept after the threads
+/// exit so that their events are exported.
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  std::size_t capacity = 1 << 16;
+};
+
+Registry &registry() {
+  static Registry instance;
+  return instance;
+}
+
+thread_local std::shared_ptr<ThreadBuffer> threadBuffer;
+thread_local int threadQPU = -1;
+
+ThreadBuffer &getThreadBuffer() {
+  if (!threadBuffer) {
+    auto &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    threadBuffer = std::make_shared<ThreadBuffer>();
+    threadBuffer->capacity = r.capacity;
+    threadBuffer->thread = r.buffers.size();
+    r.buffers.push_back(threadBuffer);
+  }
+  return *threadBuffer;
+}
+
+/// Write `s` as a JSON string.
+void writeString(std::ostream &os, const char *s) {
+  os << '"';
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\')
+      os << '\\';
+    os << *s;
+  }
+  os << '"';
+}
+
+/// Write the time in nanoseconds as microseconds.
+void writeMicroseconds(std::ostream &os, std::int64_t ns) {
+  os << ns / 1000 << '.' << std::to_string(1000 + ns % 1000).substr(1);
+}
+
+/// Write `value` as `digits` hexadecimal digits.
+void writeHex(std::ostream &os, std::uint64_t value, int digits) {
+  static constexpr char hex[] = "0123456789abcdef";
+  for (int i = digits - 1; i >= 0; i--)
+    os << hex[(value >> (4 * i)) & 0xf];
+}
+
+/// Write the events to the files of the environment variables at exit.
+struct EnvironmentExport {
+  std::string chromeFile;
+  std::string otlpFile;
+
+  EnvironmentExport() {
+    if (auto *env = std::getenv("CUDAQ_PROFILE_FILE"))
+      chromeFile = env;
+    if (auto *env = std::getenv("CUDAQ_PROFILE_OTLP_FILE"))
+      otlpFile = env;
+    if (chromeFile.empty() && otlpFile.empty())
+      return;
+    std::size_t capacity = 1 << 16;
+    if (auto *env = std::getenv("CUDAQ_PROFILE_BUFFER_SIZE"))
+      capacity = std::max<std::size_t>(1, std::strtoull(env, nullptr, 10));
+    enable(capacity);
+  }
+
+  ~EnvironmentExport() {
+    if (!chromeFile.empty()) {
+      std::ofstream out(chromeFile);
+      writeChromeTrace(out);
+    }
+    if (!otlpFile.empty()) {
+      std::ofstream out(otlpFile);
+      writeOpenTelemetry(out);
+    }
+  }
+};
+
+EnvironmentExport environmentExport;
+
+} // namespace
+
+const char *toString(Category category) {
+  switch (category) {
+  case Category::jit:
+    return "jit";
+  case Category::pass_pipeline:
+    return "pass_pipeline";
+  case Category::launch:
+    return "launch";
+  case Category::gate:
+    return "gate";
+  case Category::sampling:
+    return "sampling";
+  case Category::rest_submit:
+    return "rest_submit";
+  case Category::rest_poll:
+    return "rest_poll";
+  case Category::queue_wait:
+    return "queue_wait";
+  }
+  return "unknown";
+}
+
+void enable(std::size_t eventsPerThread) {
+  {
+    auto &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.capacity = std::max<std::size_t>(1, eventsPerThread);
+    for (auto &buffer : r.buffers) {
+      std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+      buffer->events.clear();
+      buffer->next = 0;
+      buffer->capacity = r.capacity;
+    }
+  }
+  details::enabled = true;
+}
+
+void disable() { details::enabled = false; }
+
+void clear() {
+  auto &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (auto &buffer : r.buffers) {
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    buffer->events.clear();
+    buffer->next = 0;
+  }
+}
+
+std::int64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void record(const char *name, Category category, std::int64_t start,
+            std::int64_t end) {
+  record(name, category, start, end, threadQPU);
+}
+
+void record(const char *name, Category category, std::int64_t start,
+            std::int64_t end, int qpu) {
+  if (!isEnabled())
+    return;
+  auto &buffer = getThreadBuffer();
+  Event event{name, category, qpu, buffer.thread, start, end};
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (buffer.events.size() < buffer.capacity) {
+    buffer.events.push_back(event);
+    return;
+  }
+  buffer.events[buffer.next] = event;
+  buffer.next = (buffer.next + 1) % buffer.capacity;
+}
+
+std::vector<Event> getEvents() {
+  std::vector<Event> events;
+  {
+    auto &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (auto &buffer : r.buffers) {
+      std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+      events.insert(events.end(), buffer->events.begin(),
+                    buffer->events.end());
+    }
+  }
+  // Enclosing events first, so that a parent precedes its children.
+  std::sort(events.begin(), events.end(), [](const Event &a, const Event &b) {
+    return a.start != b.start ? a.start < b.start : a.end > b.end;
+  });
+  return events;
+}
+
+void writeChromeTrace(std::ostream &os) {
+  auto events = getEvents();
+  const std::int64_t origin = events.empty() ? 0 : events.front().start;
+
+  os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto separate = [&]() {
+    if (!first)
+      os << ",\n";
+    first = false;
+  };
+
+  // Name the process of every QPU and the threads of each process.
+  std::set<std::pair<int, std::uint32_t>> tracks;
+  for (auto &event : events)
+    tracks.emplace(event.qpu + 1, event.thread);
+  int lastProcess = -1;
+  for (auto &[process, thread] : tracks) {
+    if (process != lastProcess) {
+      separate();
+      os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << process
+         << ",\"args\":{\"name\":\"";
+      if (process == 0)
+        os << "host";
+      else
+        os << "QPU " << process - 1;
+      os << "\"}}";
+      separate();
+      os << "{\"name\":\"process_sort_index\",\"ph\":\"M\",\"pid\":"
+         << process << ",\"args\":{\"sort_index\":" << process << "}}";
+      lastProcess = process;
+    }
+    separate();
+    os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << process
+       << ",\"tid\":" << thread << ",\"args\":{\"name\":\"thread " << thread
+       << "\"}}";
+  }
+
+  // Queue waits overlap the tasks run before on the same thread, they are
+  // asynchronous events on tracks of their own.
+  std::size_t asyncId = 0;
+  for (auto &event : events) {
+    const int process = event.qpu + 1;
+    if (event.category == Category::queue_wait) {
+      for (const char *phase : {"b", "e"}) {
+        separate();
+        os << "{\"name\":";
+        writeString(os, event.name);
+        os << ",\"cat\":\"" << toString(event.category) << "\",\"ph\":\""
+           << phase << "\",\"id\":" << asyncId << ",\"pid\":" << process
+           << ",\"tid\":" << event.thread << ",\"ts\":";
+        writeMicroseconds(os, (*phase == 'b' ? event.start : event.end) -
+                                  origin);
+        os << "}";
+      }
+      asyncId++;
+      continue;
+    }
+    separate();
+    os << "{\"name\":";
+    writeString(os, event.name);
+    os << ",\"cat\":\"" << toString(event.category)
+       << "\",\"ph\":\"X\",\"pid\":" << process << ",\"tid\":" << event.thread
+       << ",\"ts\":";
+    writeMicroseconds(os, event.start - origin);
+    os << ",\"dur\":";
+    writeMicroseconds(os, event.end - event.start);
+    os << "}";
+  }
+  os << "]}\n";
+}
+
+void writeOpenTelemetry(std::ostream &os) {
+  auto events = getEvents();
+
+  // The steady clock times of the events are converted to the epoch.
+  const std::int64_t toEpoch =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count() -
+      now();
+  std::random_device device;
+  std::mt19937_64 gen(device());
+  const std::uint64_t traceHigh = gen(), traceLow = gen();
+
+  // The span id of event i is i + 1. The parent of an event is the
+  // innermost enclosing event of its thread.
+  std::vector<std::vector<std::size_t>> stacks;
+  os << "{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":"
+        "\"service.name\",\"value\":{\"stringValue\":\"cudaq\"}}]},"
+        "\"scopeSpans\":[{\"scope\":{\"name\":\"cudaq.profiler\"},"
+        "\"spans\":[";
+  for (std::size_t i = 0; i < events.size(); i++) {
+    auto &event = events[i];
+    if (stacks.size() <= event.thread)
+      stacks.resize(event.thread + 1);
+    auto &stack = stacks[event.thread];
+    while (!stack.empty() && events[stack.back()].end <= event.start)
+      stack.pop_back();
+    const bool nested = event.category != Category::queue_wait;
+
+    if (i)
+      os << ",\n";
+    os << "{\"traceId\":\"";
+    writeHex(os, traceHigh, 16);
+    writeHex(os, traceLow, 16);
+    os << "\",\"spanId\":\"";
+    writeHex(os, i + 1, 16);
+    os << "\"";
+    if (nested && !stack.empty()) {
+      os << ",\"parentSpanId\":\"";
+      writeHex(os, stack.back() + 1, 16);
+      os << "\"";
+    }
+    os << ",\"name\":";
+    writeString(os, event.name);
+    os << ",\"kind\":1,\"startTimeUnixNano\":\"" << event.start + toEpoch
+       << "\",\"endTimeUnixNano\":\"" << event.end + toEpoch
+       << "\",\"attributes\":[{\"key\":\"cudaq.category\",\"value\":{"
+          "\"stringValue\":\""
+       << toString(event.category)
+       << "\"}},{\"key\":\"thread.id\",\"value\":{\"intValue\":\""
+       << event.thread << "\"}}";
+    if (event.qpu >= 0)
+      os << ",{\"key\":\"cudaq.qpu\",\"value\":{\"intValue\":\"" << event.qpu
+         << "\"}}";
+    os << "]}";
+    if (nested)
+      stack.push_back(i);
+  }
+  os << "]}]}]}\n";
+}
+
+ScopedQPU::ScopedQPU(int qpu) : previous(threadQPU) { threadQPU = qpu; }
+
+ScopedQPU::~ScopedQPU() { threadQPU = previous; }
+
+} // namespace cudaq::profiler
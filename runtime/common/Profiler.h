@@ -0,0 +1,142 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/// The profiler records timed events of the runtime (JIT compilation, pass
+/// pipelines, kernel launches, gate applications, sampling, REST submissions
+/// and polls, queue waits) into a ring buffer per thread, for them to be
+/// exported as a Chrome trace (chrome://tracing, Perfetto) or as OpenTelemetry
+/// spans (OTLP JSON). Recording an event only reads the clock twice and
+/// stores the event, nothing is formatted until the export. When profiling is
+/// disabled, the default, an event costs one relaxed atomic load.
+///
+/// Profiling is enabled with enable(), or by setting the environment
+/// variable CUDAQ_PROFILE_FILE (Chrome trace) or CUDAQ_PROFILE_OTLP_FILE
+/// (OpenTelemetry) to the file the events are written to at exit.
+/// CUDAQ_PROFILE_BUFFER_SIZE sets the number of events kept per thread, the
+/// oldest ones are overwritten first.
+namespace cudaq::profiler {
+
+/// @brief The kind of work an event times.
+enum class Category : std::uint8_t {
+  jit,
+  pass_pipeline,
+  launch,
+  gate,
+  sampling,
+  rest_submit,
+  rest_poll,
+  queue_wait
+};
+
+/// @brief Return the name of the category, e.g. "pass_pipeline".
+const char *toString(Category category);
+
+/// @brief A recorded event. Times are in nanoseconds of the steady clock.
+struct Event {
+  /// @brief The name of the event, a string with static storage duration.
+  const char *name;
+  Category category;
+  /// @brief The QPU the event ran for, -1 for the host.
+  std::int32_t qpu;
+  /// @brief The index of the recording thread, in the order threads first
+  /// recorded an event.
+  std::uint32_t thread;
+  std::int64_t start;
+  std::int64_t end;
+};
+
+namespace details {
+#ifdef CUDAQ_NO_TRACE
+inline constexpr bool compiledIn = false;
+#else
+inline constexpr bool compiledIn = true;
+#endif
+extern std::atomic<bool> enabled;
+} // namespace details
+
+/// @brief Return true if events are recorded.
+inline bool isEnabled() {
+  return details::compiledIn &&
+         details::enabled.load(std::memory_order_relaxed);
+}
+
+/// @brief Start recording, keeping the last `eventsPerThread` events of each
+/// thread. Drops the events recorded so far.
+void enable(std::size_t eventsPerThread = 1 << 16);
+
+/// @brief Stop recording. The recorded events are kept for export.
+void disable();
+
+/// @brief Drop the recorded events.
+void clear();
+
+/// @brief Return the current time of the steady clock in nanoseconds.
+std::int64_t now();
+
+/// @brief Record an event of the calling thread. `qpu` defaults to the QPU
+/// the thread runs for, see ScopedQPU.
+void record(const char *name, Category category, std::int64_t start,
+            std::int64_t end);
+void record(const char *name, Category category, std::int64_t start,
+            std::int64_t end, int qpu);
+
+/// @brief Return the recorded events of all threads, ordered by start time.
+std::vector<Event> getEvents();
+
+/// @brief Write the recorded events as a Chrome trace (JSON trace event
+/// format). Every QPU is a process whose threads are the threads that ran
+/// for it, the host is process 0. Queue waits are asynchronous events.
+void writeChromeTrace(std::ostream &os);
+
+/// @brief Write the recorded events as one OpenTelemetry trace in the OTLP
+/// JSON encoding. Events nested in time on a thread are child spans.
+void writeOpenTelemetry(std::ostream &os);
+
+/// @brief Mark the calling thread as running for `qpu` while in scope, so
+/// that the events it records go to the track of the QPU.
+class ScopedQPU {
+  int previous;
+
+public:
+  explicit ScopedQPU(int qpu);
+  ~ScopedQPU();
+  ScopedQPU(const ScopedQPU &) = delete;
+  ScopedQPU &operator=(const ScopedQPU &) = delete;
+};
+
+/// @brief Record an event from the construction of this object to its
+/// destruction, if profiling is enabled at construction. `name` must have
+/// static storage duration, e.g. a string literal.
+class ScopedEvent {
+  const char *name;
+  Category category;
+  std::int64_t start = -1;
+
+public:
+  ScopedEvent(const char *name, Category category)
+      : name(name), category(category) {
+    if (isEnabled())
+      start = now();
+  }
+  ~ScopedEvent() {
+    if (start >= 0)
+      record(name, category, start, now());
+  }
+  ScopedEvent(const ScopedEvent &) = delete;
+  ScopedEvent &operator=(const ScopedEvent &) = delete;
+};
+
+} // namespace cudaq::profiler
@@ -0,0 +1,74 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace cudaq {
+
+/// @brief The QuditIdTracker hands out qudit indices, always the smallest
+/// one not in use, and takes them back at deallocation. The free indices are
+/// kept in a min-heap and flagged in a bitset, so that allocation and
+/// deallocation cost O(log n) and checking an index costs O(1). The pool
+/// starts with 30 indices and grows on demand, the ExecutionManager and the
+/// simulators bound the number of qudits themselves.
+class QuditIdTracker {
+  /// Min-heap of the free indices.
+  std::vector<std::size_t> freeIndices;
+
+  /// Bit i is set if index i is free.
+  std::vector<bool> isFree;
+
+public:
+  QuditIdTracker() : isFree(30, true) {
+    // Ascending indices are a valid min-heap.
+    freeIndices.resize(isFree.size());
+    for (std::size_t i = 0; i < freeIndices.size(); i++)
+      freeIndices[i] = i;
+  }
+
+  /// @brief Return the smallest free index and mark it as in use.
+  std::size_t getNextIndex() {
+    if (freeIndices.empty()) {
+      isFree.push_back(false);
+      return isFree.size() - 1;
+    }
+    std::pop_heap(freeIndices.begin(), freeIndices.end(), std::greater<>());
+    auto next = freeIndices.back();
+    freeIndices.pop_back();
+    isFree[next] = false;
+    return next;
+  }
+
+  /// @brief Mark the index as free again. Returning an index that is not in
+  /// use has no effect.
+  void returnIndex(std::size_t idx) {
+    if (idx >= isFree.size() || isFree[idx])
+      return;
+    isFree[idx] = true;
+    freeIndices.push_back(idx);
+    std::push_heap(freeIndices.begin(), freeIndices.end(), std::greater<>());
+  }
+
+  /// @brief Return true if the index is not in use.
+  bool isAvailable(std::size_t idx) const {
+    return idx < isFree.size() && isFree[idx];
+  }
+
+  /// @brief Return the number of free indices.
+  std::size_t numAvailable() const { return freeIndices.size(); }
+
+  /// @brief Return the total number of indices, free or in use.
+  std::size_t totalNumQudits() const { return isFree.size(); }
+};
+
+} // namespace cudaq
@@ -0,0 +1,137 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "ReadoutMitigation.h"
+
+#include <Eigen/IterativeLinearSolvers>
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+namespace cudaq {
+
+static constexpr std::array<double, 4> exactReadout{1., 0., 0., 1.};
+
+readout_mitigator::readout_mitigator(
+    std::vector<std::array<double, 4>> confusionMatrices,
+    std::size_t maxDistance)
+    : matrices(std::move(confusionMatrices)), maxDistance(maxDistance) {
+  for (std::size_t q = 0; q < matrices.size(); q++)
+    for (std::size_t i = 0; i < 2; i++) {
+      auto p0 = matrices[q][2 * i], p1 = matrices[q][2 * i + 1];
+      if (p0 < 0. || p1 < 0. || std::abs(p0 + p1 - 1.) > 1e-9)
+        throw std::runtime_error(
+            "Invalid confusion matrix for qubit " + std::to_string(q) +
+            ", its rows must be probabilities summing to one.");
+    }
+}
+
+readout_mitigator readout_mitigator::from_noise_model(const noise_model &model,
+                                                      std::size_t nQubits,
+                                                      std::size_t maxDistance) {
+  std::vector<std::array<double, 4>> matrices;
+  for (std::size_t q = 0; q < nQubits; q++) {
+    const auto *matrix = model.get_readout_error(q);
+    matrices.push_back(matrix ? *matrix : exactReadout);
+  }
+  return readout_mitigator(std::move(matrices), maxDistance);
+}
+
+std::unordered_map<std::string, double>
+readout_mitigator::quasi_probabilities(sample_result &result,
+                                       const std::vector<std::size_t> &qubits,
+                                       std::string_view registerName) const {
+  auto counts = result.to_map(registerName);
+  const std::size_t nBits = qubits.size();
+  const std::size_t nWords = (nBits + 63) / 64;
+  const std::size_t nOutcomes = counts.size();
+
+  // Pack the outcomes, so that their distances are counted word by word.
+  std::vector<std::string> outcomes;
+  std::vector<std::uint64_t> keys(nOutcomes * nWords, 0);
+  Eigen::VectorXd p(nOutcomes);
+  double total = 0.;
+  for (auto &[bits, count] : counts) {
+    if (bits.size() != nBits)
+      throw std::runtime_error("Cannot mitigate bit strings of " +
+                               std::to_string(bits.size()) + " bits with " +
+                               std::to_string(nBits) + " qubits.");
+    const auto i = outcomes.size();
+    for (std::size_t j = 0; j < nBits; j++)
+      if (bits[j] == '1')
+        keys[i * nWords + j / 64] |= 1ULL << (j % 64);
+    p[i] = count;
+    total += count;
+    outcomes.push_back(bits);
+  }
+  if (total > 0.)
+    p /= total;
+
+  std::vector<const std::array<double, 4> *> readout;
+  for (auto q : qubits)
+    readout.push_back(q < matrices.size() ? &matrices[q] : &exactReadout);
+
+  // A(s, t) for the outcomes s read from each measured outcome t, normalized
+  // over the observed outcomes.
+  std::vector<Eigen::Triplet<double>> entries;
+  for (std::size_t t = 0; t < nOutcomes; t++) {
+    const auto *measured = &keys[t * nWords];
+    const std::size_t first = entries.size();
+    double columnSum = 0.;
+    for (std::size_t s = 0; s < nOutcomes; s++) {
+      const auto *read = &keys[s * nWords];
+      std::size_t distance = 0;
+      for (std::size_t w = 0; w < nWords && distance <= maxDistance; w++)
+        distance += std::popcount(measured[w] ^ read[w]);
+      if (distance > maxDistance)
+        continue;
+      double probability = 1.;
+      for (std::size_t j = 0; j < nBits; j++) {
+        const bool m = (measured[j / 64] >> (j % 64)) & 1;
+        const bool r = (read[j / 64] >> (j % 64)) & 1;
+        probability *= (*readout[j])[2 * m + r];
+      }
+      if (probability == 0.)
+        continue;
+      entries.emplace_back(s, t, probability);
+      columnSum += probability;
+    }
+    for (std::size_t e = first; e < entries.size(); e++)
+      entries[e] = Eigen::Triplet<double>(entries[e].row(), entries[e].col(),
+                                          entries[e].value() / columnSum);
+  }
+  Eigen::SparseMatrix<double> A(nOutcomes, nOutcomes);
+  A.setFromTriplets(entries.begin(), entries.end());
+
+  Eigen::BiCGSTAB<Eigen::SparseMatrix<double>> solver;
+  solver.setTolerance(1e-10);
+  solver.compute(A);
+  Eigen::VectorXd x = solver.solve(p);
+  if (solver.info() != Eigen::Success)
+    throw std::runtime_error("Readout error mitigation did not converge.");
+
+  std::unordered_map<std::string, double> quasiProbabilities;
+  for (std::size_t i = 0; i < nOutcomes; i++)
+    quasiProbabilities.emplace(std::move(outcomes[i]), x[i]);
+  return quasiProbabilities;
+}
+
+double readout_mitigator::exp_val_z(sample_result &result,
+                                    const std::vector<std::size_t> &qubits,
+                                    std::string_view registerName) const {
+  double expectation = 0.;
+  for (auto &[bits, x] : quasi_probabilities(result, qubits, registerName)) {
+    const auto ones = std::count(bits.begin(), bits.end(), '1');
+    expectation += ones % 2 ? -x : x;
+  }
+  return expectation;
+}
+
+} // namespace cudaq
@@ -0,0 +1,67 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "MeasureCounts.h"
+#include "NoiseModel.h"
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cudaq {
+
+/// @brief Readout error mitigation of measured counts, from the confusion
+/// matrix of each qubit. The measured distribution p is corrected into the
+/// quasi-probabilities x solving A x = p, where A(s, t) is the probability to
+/// read the bit string s when t was measured. As in the matrix-free
+/// measurement mitigation (M3) method, A is restricted to the observed bit
+/// strings, and to the pairs of them at most `maxDistance` bit flips apart,
+/// with its columns renormalized. The cost then depends on the number of
+/// distinct outcomes rather than on 2^n, and the sparse system is solved
+/// iteratively.
+class readout_mitigator {
+  /// @brief The confusion matrices, indexed by the qubit, in the format of
+  /// noise_model::add_readout_error(). Qubits past the end read exactly.
+  std::vector<std::array<double, 4>> matrices;
+
+  /// @brief The most bit flips between two outcomes that A relates.
+  std::size_t maxDistance;
+
+public:
+  /// @brief Mitigate with the confusion matrix of each qubit, whose element
+  /// (i, j) is the probability to read j when the qubit is measured in state
+  /// i. Throws if a row is not a probability distribution.
+  readout_mitigator(std::vector<std::array<double, 4>> confusionMatrices,
+                    std::size_t maxDistance = 3);
+
+  /// @brief Mitigate the readout errors of the first `nQubits` qubits of
+  /// the noise model, e.g. to check a mitigation against simulation.
+  static readout_mitigator from_noise_model(const noise_model &model,
+                                            std::size_t nQubits,
+                                            std::size_t maxDistance = 3);
+
+  /// @brief Return the quasi-probabilities of the observed bit strings of the
+  /// register, bit j of which measures qubits[j]. They sum to one and may be
+  /// negative.
+  std::unordered_map<std::string, double>
+  quasi_probabilities(sample_result &result,
+                      const std::vector<std::size_t> &qubits,
+                      std::string_view registerName = GlobalRegisterName) const;
+
+  /// @brief Return the expectation value of Z...Z over the register, from
+  /// the mitigated quasi-probabilities.
+  double exp_val_z(sample_result &result,
+                   const std::vector<std::size_t> &qubits,
+                   std::string_view registerName = GlobalRegisterName) const;
+};
+
+} // namespace cudaq
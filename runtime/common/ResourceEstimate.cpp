@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "ResourceEstimate.h"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace cudaq {
+
+bool resource_count::is_constant() const {
+  return countTerms.empty() ||
+         (countTerms.size() == 1 && countTerms.count(monomial{}));
+}
+
+std::int64_t resource_count::value() const {
+  if (!is_constant())
+    throw std::runtime_error("resource count " + to_string() +
+                             " is not constant.");
+  return evaluate({});
+}
+
+std::int64_t resource_count::evaluate(
+    const std::map<std::string, std::int64_t> &values) const {
+  std::int64_t result = 0;
+  for (auto &[product, coefficient] : countTerms) {
+    std::int64_t term = coefficient;
+    for (auto &symbol : product) {
+      auto iter = values.find(symbol);
+      if (iter == values.end())
+        throw std::runtime_error("no value for the symbol " + symbol +
+                                 " of the resource count " + to_string() +
+                                 ".");
+      term *= iter->second;
+    }
+    result += term;
+  }
+  return result;
+}
+
+std::string resource_count::to_string() const {
+  if (countTerms.empty())
+    return "0";
+  std::string result;
+  for (auto &[product, coefficient] : countTerms) {
+    if (!result.empty())
+      result += " + ";
+    if (product.empty() || coefficient != 1) {
+      result += std::to_string(coefficient);
+      if (!product.empty())
+        result += "*";
+    }
+    for (std::size_t i = 0; i < product.size(); i++)
+      result += (i ? "*" : "") + product[i];
+  }
+  return result;
+}
+
+std::string resource_estimate::to_string() const {
+  std::string result;
+  auto add = [&](const std::string &name, const resource_count &count) {
+    result += name + ": " + count.to_string() + "\n";
+  };
+  add("qubits", qubits);
+  add("gates", gates);
+  add("two-qubit gates", two_qubit_gates);
+  add("measurements", measurements);
+  add("depth", depth);
+  for (auto &[name, count] : gate_counts)
+    add("gate " + name, count);
+  return result;
+}
+
+void resource_estimate::dump() const { std::cout << to_string(); }
+
+} // namespace cudaq
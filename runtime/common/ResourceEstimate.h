@@ -0,0 +1,85 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace cudaq {
+
+/// @brief A count of resources used by a kernel. It is a polynomial in the
+/// numbers of iterations of the loops that are not known once the arguments
+/// of the kernel are: `argN` for a loop bounded by the argument N of the
+/// kernel, `nN` for any other loop.
+class resource_count {
+public:
+  /// @brief A product of symbols, sorted. The empty product is the constant
+  /// term.
+  using monomial = std::vector<std::string>;
+
+  resource_count() = default;
+  resource_count(std::map<monomial, std::int64_t> terms)
+      : countTerms(std::move(terms)) {}
+
+  /// @brief Return the terms of the polynomial, by monomial.
+  const std::map<monomial, std::int64_t> &terms() const { return countTerms; }
+
+  /// @brief Return true if the count does not depend on any symbol.
+  bool is_constant() const;
+
+  /// @brief Return the value of a constant count. Throws if it is not
+  /// constant.
+  std::int64_t value() const;
+
+  /// @brief Return the count for the given values of its symbols. Throws if
+  /// a symbol has no value.
+  std::int64_t
+  evaluate(const std::map<std::string, std::int64_t> &values) const;
+
+  /// @brief Return the polynomial as a string, e.g. `3 + 2*arg0`.
+  std::string to_string() const;
+
+private:
+  std::map<monomial, std::int64_t> countTerms;
+};
+
+/// @brief The resources used by one execution of a kernel, estimated from its
+/// Quake code by cudaq::estimate_resources().
+struct resource_estimate {
+  /// @brief The qubits allocated at once.
+  resource_count qubits;
+  /// @brief The gates, and those of them that act on exactly two qubits.
+  resource_count gates;
+  resource_count two_qubit_gates;
+  /// @brief The qubits measured.
+  resource_count measurements;
+  /// @brief An upper bound of the circuit depth, exact for kernels without
+  /// loops or conditionals.
+  resource_count depth;
+  /// @brief The gates by name, prefixed with a `c` per control (e.g. `h`,
+  /// `cx`, `ccx`), or `mc` if the number of controls is not known.
+  std::map<std::string, resource_count> gate_counts;
+
+  /// @brief Return the estimate as a string, one count per line.
+  std::string to_string() const;
+
+  /// @brief Print the estimate to standard out.
+  void dump() const;
+};
+
+namespace details {
+/// @brief Return the resources used by the kernel `kernelName`, given its
+/// Quake code, for the packed arguments `args` of its launch (nullptr if it
+/// takes no arguments). Implemented in the cudaq-mlir-runtime library.
+resource_estimate estimateResources(const std::string &kernelName,
+                                    const std::string &quakeCode, void *args);
+} // namespace details
+} // namespace cudaq
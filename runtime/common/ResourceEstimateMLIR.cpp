@@ -0,0 +1,69 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "ResourceEstimate.h"
+#include "RuntimeMLIR.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include "cudaq/Optimizer/Transforms/ResourceEstimate.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Parser/Parser.h"
+#include "mlir/Pass/PassManager.h"
+
+using namespace mlir;
+
+namespace cudaq {
+
+static resource_count toResourceCount(const opt::ResourceCount &count) {
+  return resource_count(count.getTerms());
+}
+
+resource_estimate details::estimateResources(const std::string &kernelName,
+                                             const std::string &quakeCode,
+                                             void *args) {
+  std::unique_ptr<MLIRContext, decltype(&releaseMLIRContext)> context{
+      acquireMLIRContext(), releaseMLIRContext};
+  auto module = parseSourceString<ModuleOp>(quakeCode, context.get());
+  if (!module)
+    throw std::runtime_error("Could not parse the Quake code of kernel " +
+                             kernelName + ".");
+
+  // The arguments are synthesized so that the loops they bound are unrolled
+  // and counted exactly.
+  if (args) {
+    PassManager pm(context.get());
+    pm.addPass(opt::createQuakeSynthesizer(kernelName, args));
+    if (failed(pm.run(*module)))
+      throw std::runtime_error("Could not successfully apply quake-synth.");
+  }
+  std::string errorMessage;
+  if (failed(runPassPipeline("canonicalize,cc-loop-unroll,canonicalize",
+                             *module, &errorMessage)))
+    throw std::runtime_error("Could not simplify kernel " + kernelName +
+                             " for resource estimation (" + errorMessage +
+                             ").");
+
+  auto func = module->lookupSymbol<func::FuncOp>(
+      std::string("__nvqpp__mlirgen__") + kernelName);
+  if (!func)
+    throw std::runtime_error("Could not find the Quake code of kernel " +
+                             kernelName + ".");
+  auto estimate = opt::estimateResources(func);
+
+  resource_estimate result;
+  result.qubits = toResourceCount(estimate.qubits);
+  result.gates = toResourceCount(estimate.gates);
+  result.two_qubit_gates = toResourceCount(estimate.twoQubitGates);
+  result.measurements = toResourceCount(estimate.measurements);
+  result.depth = toResourceCount(estimate.depth);
+  for (auto &[name, count] : estimate.gateCounts)
+    result.gate_counts[name] = toResourceCount(count);
+  return result;
+}
+
+} // namespace cudaq
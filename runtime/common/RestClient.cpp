@@ -8,11 +8,30 @@
 
 #include "RestClient.h"
 #include "Logger.h"
+#include "ResultDecoder.h"
 #include <cpr/cpr.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 namespace cudaq {
 constexpr long validHttpCode = 205;
 
+std::string RestClient::makeBody(const nlohmann::json &message) const {
+  auto body = message.dump();
+  if (!compressPosts || !isGzipAvailable())
+    return body;
+  return gzipCompress(body);
+}
+
+void RestClient::addContentEncoding(
+    std::map<std::string, std::string> &headers) const {
+  if (compressPosts && isGzipAvailable())
+    headers["Content-Encoding"] = "gzip";
+}
+
 nlohmann::json RestClient::post(const std::string_view remoteUrl,
                                 const std::string_view path,
                                 nlohmann::json &post,
@@ -20,15 +39,17 @@ nlohmann::json RestClient::post(const std::string_view remoteUrl,
   if (headers.empty())
     headers.insert(std::make_pair("Content-type", "application/json"));
 
+  cudaq::info("Posting to {}/{} with data = {}", remoteUrl, path, post.dump());
+  addContentEncoding(headers);
+  auto body = makeBody(post);
+
   cpr::Header cprHeaders;
   for (auto &kv : headers)
     cprHeaders.insert({kv.first, kv.second});
 
-  cudaq::info("Posting to {}/{} with data = {}", remoteUrl, path, post.dump());
-
   auto actualPath = std::string(remoteUrl) + std::string(path);
-  auto r = cpr::Post(cpr::Url{actualPath}, cpr::Body(post.dump()), cprHeaders,
-                     cpr::VerifySsl(false));
+  auto r = cpr::Post(cpr::Url{actualPath}, cpr::Body(std::move(body)),
+                     cprHeaders, cpr::VerifySsl(false));
 
   if (r.status_code > validHttpCode)
     throw std::runtime_error("HTTP POST Error - status code " +
@@ -38,6 +59,71 @@ nlohmann::json RestClient::post(const std::string_view remoteUrl,
   return nlohmann::json::parse(r.text);
 }
 
+std::vector<nlohmann::json>
+RestClient::postAll(const std::string_view remoteUrl,
+                    const std::string_view path,
+                    std::vector<nlohmann::json> &posts,
+                    std::map<std::string, std::string> &headers,
+                    std::size_t maxConcurrent) {
+  if (headers.empty())
+    headers.insert(std::make_pair("Content-type", "application/json"));
+  addContentEncoding(headers);
+
+  cpr::Header cprHeaders;
+  for (auto &kv : headers)
+    cprHeaders.insert({kv.first, kv.second});
+
+  const auto actualPath = std::string(remoteUrl) + std::string(path);
+  std::vector<nlohmann::json> responses(posts.size());
+  std::atomic<std::size_t> next = 0;
+  std::exception_ptr error;
+  std::mutex errorMutex;
+
+  // Every worker posts the next pending message on its own session, whose
+  // connection is reused for all its posts.
+  auto worker = [&]() {
+    cpr::Session session;
+    session.SetUrl(cpr::Url{actualPath});
+    session.SetHeader(cprHeaders);
+    session.SetVerifySsl(cpr::VerifySsl(false));
+    session.SetHttpVersion(
+        cpr::HttpVersion{cpr::HttpVersionCode::VERSION_2_0_TLS});
+    for (std::size_t i = next++; i < posts.size(); i = next++) {
+      try {
+        cudaq::info("Posting to {} with data = {}", actualPath,
+                    posts[i].dump());
+        session.SetBody(cpr::Body(makeBody(posts[i])));
+        auto r = session.Post();
+        if (r.status_code > validHttpCode)
+          throw std::runtime_error("HTTP POST Error - status code " +
+                                   std::to_string(r.status_code) + ": " +
+                                   r.error.message + ": " + r.text);
+        responses[i] = nlohmann::json::parse(r.text);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!error)
+          error = std::current_exception();
+        next = posts.size();
+        return;
+      }
+    }
+  };
+
+  const std::size_t nWorkers =
+      std::clamp<std::size_t>(maxConcurrent, 1, std::max<std::size_t>(
+                                                    posts.size(), 1));
+  std::vector<std::thread> workers;
+  for (std::size_t w = 1; w < nWorkers; w++)
+    workers.emplace_back(worker);
+  worker();
+  for (auto &t : workers)
+    t.join();
+
+  if (error)
+    std::rethrow_exception(error);
+  return responses;
+}
+
 nlohmann::json RestClient::get(const std::string_view remoteUrl,
                                const std::string_view path,
                                std::map<std::string, std::string> &headers) {
@@ -56,4 +142,40 @@ nlohmann::json RestClient::get(const std::string_view remoteUrl,
   return nlohmann::json::parse(r.text);
 }
 
+std::vector<nlohmann::json>
+RestClient::getAll(const std::string_view remoteUrl,
+                   const std::vector<std::string> &paths,
+                   std::map<std::string, std::string> &headers) {
+  std::vector<nlohmann::json> results;
+  results.reserve(paths.size());
+  for (auto &text : getAllText(remoteUrl, paths, headers))
+    results.push_back(nlohmann::json::parse(text));
+  return results;
+}
+
+std::vector<std::string>
+RestClient::getAllText(const std::string_view remoteUrl,
+                       const std::vector<std::string> &paths,
+                       std::map<std::string, std::string> &headers) {
+  if (headers.empty())
+    headers.insert(std::make_pair("Content-type", "application/json"));
+
+  cpr::Header cprHeaders;
+  for (auto &kv : headers)
+    cprHeaders.insert({kv.first, kv.second});
+
+  std::vector<cpr::AsyncResponse> responses;
+  responses.reserve(paths.size());
+  for (auto &path : paths)
+    responses.push_back(
+        cpr::GetAsync(cpr::Url{std::string(remoteUrl) + path}, cprHeaders,
+                      cpr::Parameters{}, cpr::VerifySsl(false)));
+
+  std::vector<std::string> results;
+  results.reserve(paths.size());
+  for (auto &response : responses)
+    results.push_back(std::move(response.get().text));
+  return results;
+}
+
 } // namespace cudaq
@@ -10,6 +10,7 @@
 #include "nlohmann/json.hpp"
 #include <map>
 #include <string>
+#include <vector>
 
 namespace cudaq {
 
@@ -20,19 +21,55 @@ protected:
   // Use verbose printout
   bool verbose = false;
 
+  /// @brief Compress the bodies of posts with gzip, see setCompressPosts().
+  bool compressPosts = false;
+
+  /// @brief Return the body of a post of `message`, compressed if requested.
+  /// The content encoding of the body is added to `headers`.
+  std::string makeBody(const nlohmann::json &message) const;
+  void addContentEncoding(std::map<std::string, std::string> &headers) const;
+
 public:
   /// @brief set verbose printout
   /// @param v
   void setVerbose(bool v) { verbose = v; }
 
+  /// @brief Compress the bodies of posts with gzip, for servers accepting
+  /// the `Content-Encoding: gzip` header. The JSON of a job of thousands of
+  /// circuits or terms typically shrinks tenfold. Ignored if the runtime was
+  /// built without zlib.
+  void setCompressPosts(bool compress) { compressPosts = compress; }
+
   /// Post the message to the remote path at the provided URL.
   nlohmann::json post(const std::string_view remoteUrl,
                       const std::string_view path, nlohmann::json &postStr,
                       std::map<std::string, std::string> &headers);
+  /// Post all the messages to the remote path at the provided URL, with up
+  /// to maxConcurrent posts in flight. Each concurrent stream of posts keeps
+  /// its connection alive across its posts, and negotiates HTTP/2 when the
+  /// server offers it. The responses are in the order of the messages.
+  std::vector<nlohmann::json>
+  postAll(const std::string_view remoteUrl, const std::string_view path,
+          std::vector<nlohmann::json> &posts,
+          std::map<std::string, std::string> &headers,
+          std::size_t maxConcurrent);
   /// Get the contents of the remote server at the given url and path.
   nlohmann::json get(const std::string_view remoteUrl,
                      const std::string_view path,
                      std::map<std::string, std::string> &headers);
+  /// Get the contents of all the given paths on the remote server, with the
+  /// requests in flight concurrently. The results are in the order of the
+  /// paths.
+  std::vector<nlohmann::json>
+  getAll(const std::string_view remoteUrl,
+         const std::vector<std::string> &paths,
+         std::map<std::string, std::string> &headers);
+  /// Like getAll(), but return the unparsed bodies, e.g. to decode large
+  /// results with decodeJobResponse().
+  std::vector<std::string>
+  getAllText(const std::string_view remoteUrl,
+             const std::vector<std::string> &paths,
+             std::map<std::string, std::string> &headers);
 
   ~RestClient() = default;
 };
@@ -0,0 +1,115 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+
+#include "ResultCache.h"
+#include "Logger.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+namespace cudaq {
+
+namespace {
+/// @brief The first word of every entry, the format version.
+constexpr std::size_t entryMagic = 0x6375647131ULL;
+} // namespace
+
+ResultCache::ResultCache(std::filesystem::path dir, std::chrono::seconds t)
+    : directory(std::move(dir)), ttl(t) {
+  std::filesystem::create_directories(directory);
+}
+
+std::optional<ResultCache> ResultCache::fromEnvironment() {
+  auto *dir = std::getenv("CUDAQ_RESULT_CACHE_DIR");
+  if (!dir || !*dir)
+    return std::nullopt;
+  if (auto *bypass = std::getenv("CUDAQ_RESULT_CACHE_BYPASS");
+      bypass && std::string(bypass) == "1")
+    return std::nullopt;
+  std::chrono::seconds ttl = std::chrono::hours(24 * 7);
+  if (auto *seconds = std::getenv("CUDAQ_RESULT_CACHE_TTL"))
+    ttl = std::chrono::seconds(std::stoll(seconds));
+  return ResultCache(dir, ttl);
+}
+
+std::string ResultCache::hashKey(const std::vector<std::string> &parts) {
+  // Two independent 64 bit hashes: FNV-1a and a multiply-xorshift, over the
+  // length prefixed parts so that their boundaries count.
+  std::uint64_t fnv = 0xcbf29ce484222325ULL, mix = 0x9e3779b97f4a7c15ULL;
+  auto add = [&](unsigned char c) {
+    fnv = (fnv ^ c) * 0x100000001b3ULL;
+    mix = (mix ^ c) * 0xbf58476d1ce4e5b9ULL;
+    mix ^= mix >> 29;
+  };
+  for (auto &part : parts) {
+    for (std::size_t n = part.size(), i = 0; i < 8; i++, n >>= 8)
+      add(static_cast<unsigned char>(n));
+    for (unsigned char c : part)
+      add(c);
+  }
+  return fmt::format("{:016x}{:016x}", fnv, mix);
+}
+
+std::filesystem::path ResultCache::entryPath(const std::string &key) const {
+  return directory / (key + ".result");
+}
+
+std::optional<sample_result> ResultCache::load(const std::string &key) const {
+  auto path = entryPath(key);
+  std::error_code ec;
+  auto written = std::filesystem::last_write_time(path, ec);
+  if (ec)
+    return std::nullopt;
+  if (std::filesystem::file_time_type::clock::now() - written > ttl) {
+    cudaq::info("Result cache entry {} expired.", key);
+    std::filesystem::remove(path, ec);
+    return std::nullopt;
+  }
+
+  std::ifstream in(path, std::ios::binary);
+  std::size_t header[2] = {0, 0};
+  if (!in.read(reinterpret_cast<char *>(header), sizeof(header)) ||
+      header[0] != entryMagic)
+    return std::nullopt;
+  std::vector<std::size_t> data(header[1]);
+  if (!in.read(reinterpret_cast<char *>(data.data()),
+               data.size() * sizeof(std::size_t)))
+    return std::nullopt;
+
+  cudaq::info("Result cache hit for {}.", key);
+  sample_result result;
+  result.deserialize(data);
+  return result;
+}
+
+void ResultCache::store(const std::string &key, sample_result &result) const {
+  auto data = result.serialize();
+  const std::size_t header[2] = {entryMagic, data.size()};
+  auto path = entryPath(key);
+  auto temporary = path;
+  temporary += "." + std::to_string(std::random_device{}()) + ".tmp";
+  {
+    std::ofstream out(temporary, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(data.data()),
+              data.size() * sizeof(std::size_t));
+    if (!out) {
+      cudaq::info("Could not write the result cache entry {}.", key);
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(temporary, path, ec);
+  if (ec)
+    std::filesystem::remove(temporary, ec);
+}
+
+} // namespace cudaq
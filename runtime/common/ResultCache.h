@@ -0,0 +1,55 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+
+#pragma once
+
+#include "MeasureCounts.h"
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace cudaq {
+
+/// @brief A persistent, content addressed cache of execution results on
+/// disk, so that re-running identical remote executions (notebooks,
+/// regression suites) does not re-submit them. Every entry is a file named
+/// by the hash of its key, entries older than the time to live are ignored
+/// and removed.
+class ResultCache {
+  std::filesystem::path directory;
+  std::chrono::seconds ttl;
+
+  std::filesystem::path entryPath(const std::string &key) const;
+
+public:
+  /// @brief Use the given directory, created if needed, with the given time
+  /// to live of the entries.
+  ResultCache(std::filesystem::path directory, std::chrono::seconds ttl);
+
+  /// @brief Return the cache configured by the environment, or std::nullopt
+  /// if caching is off. CUDAQ_RESULT_CACHE_DIR enables it in the given
+  /// directory, CUDAQ_RESULT_CACHE_TTL sets the time to live in seconds
+  /// (default 7 days), and CUDAQ_RESULT_CACHE_BYPASS=1 turns it off.
+  static std::optional<ResultCache> fromEnvironment();
+
+  /// @brief Return the key of the given parts, a 128 bit hash in hex.
+  static std::string hashKey(const std::vector<std::string> &parts);
+
+  /// @brief Return the result stored under the key, if it is there and has
+  /// not expired.
+  std::optional<sample_result> load(const std::string &key) const;
+
+  /// @brief Store the result under the key. The entry is written to a
+  /// temporary file and renamed, so readers never see a partial entry.
+  void store(const std::string &key, sample_result &result) const;
+};
+
+} // namespace cudaq
@@ -0,0 +1,174 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "ResultDecoder.h"
+#include <charconv>
+#include <stdexcept>
+
+#ifdef CUDAQ_ZLIB_AVAILABLE
+#include <zlib.h>
+#endif
+
+namespace cudaq {
+namespace {
+using json = nlohmann::json;
+
+/// @brief Builds the DOM of a job response from the parser events, except
+/// for the counts objects, whose entries are added to their dictionary as
+/// they are parsed.
+class ResponseBuilder : public nlohmann::json_sax<json> {
+  const std::string &countsKey;
+  std::vector<CountsDictionary> &counts;
+  json root;
+  /// The open objects and arrays, innermost last.
+  std::vector<json *> stack;
+  /// The key of the next value of the innermost object.
+  std::string lastKey;
+  /// True while the entries of counts.back() are parsed.
+  bool inCounts = false;
+
+  json *add(json value) {
+    if (stack.empty()) {
+      root = std::move(value);
+      return &root;
+    }
+    auto &top = *stack.back();
+    if (top.is_array()) {
+      top.push_back(std::move(value));
+      return &top.back();
+    }
+    return &(top[lastKey] = std::move(value));
+  }
+
+  bool addCount(std::size_t count) {
+    counts.back()[lastKey] += count;
+    return true;
+  }
+
+  bool invalidCount() {
+    throw std::runtime_error("Invalid count of bit string " + lastKey +
+                             " in the job response.");
+  }
+
+public:
+  ResponseBuilder(const std::string &countsKey,
+                  std::vector<CountsDictionary> &counts)
+      : countsKey(countsKey), counts(counts) {}
+
+  json takeResult() { return std::move(root); }
+
+  bool null() override { return inCounts ? invalidCount() : (add({}), true); }
+  bool boolean(bool value) override {
+    return inCounts ? invalidCount() : (add(value), true);
+  }
+  bool number_integer(number_integer_t value) override {
+    return inCounts ? invalidCount() : (add(value), true);
+  }
+  bool number_unsigned(number_unsigned_t value) override {
+    return inCounts ? addCount(value) : (add(value), true);
+  }
+  bool number_float(number_float_t value, const string_t &) override {
+    return inCounts ? invalidCount() : (add(value), true);
+  }
+  bool string(string_t &value) override {
+    if (!inCounts) {
+      add(std::move(value));
+      return true;
+    }
+    std::size_t count = 0;
+    auto [end, error] =
+        std::from_chars(value.data(), value.data() + value.size(), count);
+    if (error != std::errc() || end != value.data() + value.size())
+      return invalidCount();
+    return addCount(count);
+  }
+  bool binary(binary_t &value) override {
+    return inCounts ? invalidCount() : (add(json::binary(value)), true);
+  }
+  bool start_object(std::size_t) override {
+    if (inCounts)
+      return invalidCount();
+    auto *object = add(json::object());
+    if (!stack.empty() && stack.back()->is_object() && lastKey == countsKey) {
+      counts.emplace_back();
+      inCounts = true;
+      return true;
+    }
+    stack.push_back(object);
+    return true;
+  }
+  bool key(string_t &value) override {
+    lastKey = std::move(value);
+    return true;
+  }
+  bool end_object() override {
+    if (inCounts)
+      inCounts = false;
+    else
+      stack.pop_back();
+    return true;
+  }
+  bool start_array(std::size_t) override {
+    if (inCounts)
+      return invalidCount();
+    stack.push_back(add(json::array()));
+    return true;
+  }
+  bool end_array() override {
+    stack.pop_back();
+    return true;
+  }
+  bool parse_error(std::size_t, const std::string &,
+                   const nlohmann::detail::exception &ex) override {
+    throw std::runtime_error(std::string("Invalid JSON job response: ") +
+                             ex.what());
+  }
+};
+} // namespace
+
+nlohmann::json decodeJobResponse(std::string_view text,
+                                 const std::string &countsKey,
+                                 std::vector<CountsDictionary> &counts) {
+  ResponseBuilder builder(countsKey, counts);
+  json::sax_parse(text.begin(), text.end(), &builder);
+  return builder.takeResult();
+}
+
+#ifdef CUDAQ_ZLIB_AVAILABLE
+std::string gzipCompress(std::string_view text) {
+  z_stream stream{};
+  // 16 + 15: the gzip wrapper around a deflate stream of the largest window.
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + 15, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK)
+    throw std::runtime_error("Cannot initialize the gzip compression.");
+
+  std::string compressed(deflateBound(&stream, text.size()), '\0');
+  stream.next_in =
+      reinterpret_cast<Bytef *>(const_cast<char *>(text.data()));
+  stream.avail_in = text.size();
+  stream.next_out = reinterpret_cast<Bytef *>(compressed.data());
+  stream.avail_out = compressed.size();
+  const auto status = deflate(&stream, Z_FINISH);
+  compressed.resize(stream.total_out);
+  deflateEnd(&stream);
+  if (status != Z_STREAM_END)
+    throw std::runtime_error("The gzip compression failed.");
+  return compressed;
+}
+
+bool isGzipAvailable() { return true; }
+#else
+std::string gzipCompress(std::string_view) {
+  throw std::runtime_error(
+      "gzip compression requires CUDA Quantum built with zlib.");
+}
+
+bool isGzipAvailable() { return false; }
+#endif
+
+} // namespace cudaq
@@ -0,0 +1,37 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "MeasureCounts.h"
+#include "nlohmann/json.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cudaq {
+
+/// @brief Parse the JSON job response `text`, decoding the counts objects
+/// (the objects of bit strings to counts under a `countsKey` key, at any
+/// depth) straight into `counts`, in document order. The rest of the
+/// response is returned as a DOM, where every counts object is left empty.
+/// The counts of a large result are thus never held as JSON values. A count
+/// may be an integer or a string of digits, anything else throws.
+nlohmann::json decodeJobResponse(std::string_view text,
+                                 const std::string &countsKey,
+                                 std::vector<CountsDictionary> &counts);
+
+/// @brief Return `text` compressed in the gzip format, for a request body
+/// sent with the `Content-Encoding: gzip` header. Throws if the runtime was
+/// built without zlib.
+std::string gzipCompress(std::string_view text);
+
+/// @brief Return true if gzipCompress() is available.
+bool isGzipAvailable();
+
+} // namespace cudaq
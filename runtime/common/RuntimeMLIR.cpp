@@ -7,6 +7,7 @@
  *******************************************************************************/
 
 #include "RuntimeMLIR.h"
+#include "Profiler.h"
 #include "cudaq/Optimizer/Builder/Runtime.h"
 #include "cudaq/Optimizer/CodeGen/Passes.h"
 #include "cudaq/Optimizer/Dialect/CC/CCDialect.h"
@@ -50,10 +51,38 @@
 #include "mlir/Tools/ParseUtilities.h"
 #include "mlir/Transforms/Passes.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
 using namespace mlir;
 
 namespace cudaq {
-static bool mlirLLVMInitialized = false;
+static std::once_flag mlirLLVMInitialized;
+
+namespace {
+/// @brief The idle contexts of the platform, and the idle pass managers
+/// parsed for each context created by the pool, by pipeline. A pass manager
+/// runs one module at a time, concurrent runs of a pipeline take distinct
+/// ones.
+struct MLIRContextPool {
+  static constexpr std::size_t capacity = 8;
+  std::mutex mutex;
+  std::vector<std::unique_ptr<MLIRContext>> idle;
+  std::unordered_set<MLIRContext *> live;
+  std::unordered_map<
+      MLIRContext *,
+      llvm::StringMap<std::vector<std::unique_ptr<PassManager>>>>
+      pipelines;
+};
+
+MLIRContextPool &getContextPool() {
+  static MLIRContextPool pool;
+  return pool;
+}
+} // namespace
 
 static llvm::StringMap<cudaq::Translation> &getTranslationRegistry() {
   static llvm::StringMap<cudaq::Translation> translationBundle;
@@ -88,7 +117,7 @@ void registerToOpenQASMTranslation();
 void registerToIQMJsonTranslation();
 
 std::unique_ptr<MLIRContext> initializeMLIR() {
-  if (!mlirLLVMInitialized) {
+  std::call_once(mlirLLVMInitialized, []() {
     llvm::InitializeNativeTarget();
     llvm::InitializeNativeTargetAsmPrinter();
     registerAllPasses();
@@ -98,8 +127,7 @@ std::unique_ptr<MLIRContext> initializeMLIR() {
     registerToQIRTranslation();
     registerToOpenQASMTranslation();
     registerToIQMJsonTranslation();
-    mlirLLVMInitialized = true;
-  }
+  });
 
   // if (!llvmContext)
   //   llvmContext = std::make_unique<llvm::LLVMContext>();
@@ -113,14 +141,95 @@ std::unique_ptr<MLIRContext> initializeMLIR() {
   return context;
 }
 
-bool setupTargetTriple(llvm::Module *llvmModule) {
+MLIRContext *acquireMLIRContext() {
+  auto &pool = getContextPool();
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    if (!pool.idle.empty()) {
+      auto *context = pool.idle.back().release();
+      pool.idle.pop_back();
+      return context;
+    }
+  }
+  auto *context = initializeMLIR().release();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  pool.live.insert(context);
+  return context;
+}
+
+void releaseMLIRContext(MLIRContext *context) {
+  if (!context)
+    return;
+  auto &pool = getContextPool();
+  std::unique_ptr<MLIRContext> owned(context);
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  if (!pool.live.count(context))
+    return;
+  if (pool.idle.size() < MLIRContextPool::capacity) {
+    pool.idle.push_back(std::move(owned));
+    return;
+  }
+  // The cached pass managers refer to the context, drop them first.
+  pool.pipelines.erase(context);
+  pool.live.erase(context);
+  owned.reset();
+}
+
+LogicalResult runPassPipeline(const std::string &pipeline, ModuleOp module,
+                              std::string *errorMessage) {
+  profiler::ScopedEvent event("runPassPipeline",
+                              profiler::Category::pass_pipeline);
+  auto *context = module.getContext();
+  auto parse = [&](PassManager &pm) {
+    std::string errMsg;
+    llvm::raw_string_ostream os(errMsg);
+    if (succeeded(parsePassPipeline(pipeline, pm, os)))
+      return success();
+    if (errorMessage)
+      *errorMessage = os.str();
+    return failure();
+  };
+
+  auto &pool = getContextPool();
+  std::unique_lock<std::mutex> lock(pool.mutex);
+  if (!pool.live.count(context)) {
+    // Contexts not created by the pool may die at any time, their pipelines
+    // are parsed at every run.
+    lock.unlock();
+    PassManager pm(context);
+    if (failed(parse(pm)))
+      return failure();
+    return pm.run(module);
+  }
+
+  std::unique_ptr<PassManager> pm;
+  auto &idle = pool.pipelines[context][pipeline];
+  if (!idle.empty()) {
+    pm = std::move(idle.back());
+    idle.pop_back();
+  }
+  lock.unlock();
+
+  if (!pm) {
+    pm = std::make_unique<PassManager>(context);
+    if (failed(parse(*pm)))
+      return failure();
+  }
+  auto result = pm->run(module);
+  lock.lock();
+  // The context is alive while its modules are being lowered.
+  pool.pipelines[context][pipeline].push_back(std::move(pm));
+  return result;
+}
+
+std::unique_ptr<llvm::TargetMachine> createHostTargetMachine(int optLevel) {
   // Setup the machine properties from the current architecture.
   auto targetTriple = llvm::sys::getDefaultTargetTriple();
   std::string errorMessage;
   const auto *target =
       llvm::TargetRegistry::lookupTarget(targetTriple, errorMessage);
   if (!target)
-    return false;
+    return nullptr;
 
   std::string cpu(llvm::sys::getHostCPUName());
   llvm::SubtargetFeatures features;
@@ -130,40 +239,69 @@ bool setupTargetTriple(llvm::Module *llvmModule) {
     for (auto &f : hostFeatures)
       features.AddFeature(f.first(), f.second);
 
-  std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(
-      targetTriple, cpu, features.getString(), {}, {}));
+  return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+      targetTriple, cpu, features.getString(), {}, {}, std::nullopt,
+      static_cast<llvm::CodeGenOpt::Level>(std::clamp(optLevel, 0, 3))));
+}
+
+bool setupTargetTriple(llvm::Module *llvmModule) {
+  auto machine = createHostTargetMachine(/*optLevel=*/2);
   if (!machine)
     return false;
 
   llvmModule->setDataLayout(machine->createDataLayout());
-  llvmModule->setTargetTriple(targetTriple);
+  llvmModule->setTargetTriple(machine->getTargetTriple().str());
 
   return true;
 }
 
-void optimizeLLVM(llvm::Module *module) {
-  bool enableOpt = true;
+int getJITOptLevel() {
+  static const int optLevel = []() {
+    const char *env = std::getenv("CUDAQ_JIT_OPT_LEVEL");
+    if (!env)
+      return 2;
+    std::string level(env);
+    if (level.size() == 2 && (level[0] == 'O' || level[0] == 'o'))
+      level = level.substr(1);
+    if (level.size() != 1 || level[0] < '0' || level[0] > '3')
+      throw std::runtime_error("Invalid CUDAQ_JIT_OPT_LEVEL (" +
+                               std::string(env) + "), use 0 to 3.");
+    return level[0] - '0';
+  }();
+  return optLevel;
+}
+
+static void optimizeLLVM(llvm::Module *module, int optLevel,
+                         llvm::TargetMachine *machine) {
   auto optPipeline = makeOptimizingTransformer(
-      /*optLevel=*/enableOpt ? 3 : 0, /*sizeLevel=*/0,
-      /*targetMachine=*/nullptr);
-  if (auto err = optPipeline(module))
+      /*optLevel=*/std::clamp(optLevel, 0, 3), /*sizeLevel=*/0,
+      /*targetMachine=*/machine);
+  if (auto err = optPipeline(module)) {
+    llvm::consumeError(std::move(err));
     throw std::runtime_error("Failed to optimize LLVM IR ");
+  }
+}
+
+void optimizeLLVM(llvm::Module *module, int optLevel) {
+  // Tune the pipeline, e.g. the vectorization costs, for the host CPU.
+  auto machine = createHostTargetMachine(optLevel);
+  optimizeLLVM(module, optLevel, machine.get());
+}
+
+void optimizeLLVM(llvm::Module *module) {
+  optimizeLLVM(module, 3, /*machine=*/nullptr);
 }
 
 void registerToQIRTranslation() {
   cudaq::TranslateFromMLIRRegistration reg(
       "qir", "translate from quake to qir adaptive",
       [](Operation *op, raw_ostream &output) {
-        auto context = op->getContext();
-        PassManager pm(context);
-        std::string errMsg;
-        llvm::raw_string_ostream errOs(errMsg);
         std::string qirBasePipelineConfig = "quake-to-qir,qir-to-base-qir-prep,"
                                             "llvm.func(quake-to-base-qir-func),"
                                             "qir-to-base-qir";
-        if (failed(parsePassPipeline(qirBasePipelineConfig, pm, errOs)))
-          return failure();
-        if (failed(pm.run(op)))
+        auto moduleOp = dyn_cast<ModuleOp>(op);
+        if (!moduleOp ||
+            failed(cudaq::runPassPipeline(qirBasePipelineConfig, moduleOp)))
           return failure();
 
         std::unique_ptr<llvm::LLVMContext> llvmContext =
@@ -184,21 +322,35 @@ void registerToQIRTranslation() {
       });
 }
 
+/// @brief Lower the Quake module to QTX, for the OpenQASM translations.
+static void lowerToQTX(Operation *op) {
+  auto moduleOp = dyn_cast<ModuleOp>(op);
+  if (!moduleOp)
+    throw std::runtime_error("Lowering to qtx requires a module.");
+  std::string errMsg;
+  if (failed(cudaq::runPassPipeline(
+          "func.func(convert-quake-to-qtx),convert-func-to-qtx", moduleOp,
+          &errMsg))) {
+    if (!errMsg.empty())
+      throw std::runtime_error("Lowering to qtx failed (" + errMsg + ").");
+    throw std::runtime_error("Lowering to qtx failed.");
+  }
+}
+
 void registerToOpenQASMTranslation() {
   cudaq::TranslateFromMLIRRegistration reg(
       "qasm2", "translate from qtx to openqasm",
       [](Operation *op, raw_ostream &output) {
         // Manually run quake to qtx here
-        PassManager pm(op->getContext());
-        std::string errMsg;
-        llvm::raw_string_ostream os(errMsg);
-        if (failed(parsePassPipeline(
-                "func.func(convert-quake-to-qtx),convert-func-to-qtx", pm, os)))
-          throw std::runtime_error("Lowering to qtx failed (" + errMsg + ").");
-        if (failed(pm.run(op)))
-          throw std::runtime_error("Lowering to qtx failed.");
+        lowerToQTX(op);
         return cudaq::translateToOpenQASM(op, output);
       });
+  cudaq::TranslateFromMLIRRegistration regParameterized(
+      "qasm3", "translate from qtx to openqasm 3 with input parameters",
+      [](Operation *op, raw_ostream &output) {
+        lowerToQTX(op);
+        return cudaq::translateToParameterizedOpenQASM(op, output);
+      });
 }
 
 void registerToIQMJsonTranslation() {
@@ -10,24 +10,60 @@
 
 #include "mlir/Tools/mlir-translate/Translation.h"
 #include <memory>
+#include <string>
 
 namespace mlir {
 class MLIRContext;
+class ModuleOp;
 } // namespace mlir
 
 namespace llvm {
 class Module;
-}
+class TargetMachine;
+} // namespace llvm
 
 namespace cudaq {
 /// @brief Initialize MLIR with CUDA Quantum dialects and return the
 /// MLIRContext.
 std::unique_ptr<mlir::MLIRContext> initializeMLIR();
+
+/// @brief Return an initialized MLIRContext from the platform's pool of idle
+/// contexts, or a new one if the pool is empty. Hand it back with
+/// releaseMLIRContext() rather than deleting it, so that the next client
+/// does not pay for loading the dialects again. A context is used by one
+/// thread at a time.
+mlir::MLIRContext *acquireMLIRContext();
+
+/// @brief Return the context to the pool. Contexts beyond the capacity of
+/// the pool are deleted.
+void releaseMLIRContext(mlir::MLIRContext *context);
+
+/// @brief Run the textual pass pipeline on the module. The parsed pass
+/// managers are cached per context and pipeline, so the steady-state cost is
+/// only that of the passes themselves. Modules of the same context may be
+/// lowered concurrently.
+mlir::LogicalResult runPassPipeline(const std::string &pipeline,
+                                    mlir::ModuleOp module,
+                                    std::string *errorMessage = nullptr);
 /// @brief Given an LLVM Module, set its target triple corresponding to the
 /// current host machine.
 bool setupTargetTriple(llvm::Module *);
 
-/// @brief Run the LLVM PassManager.
+/// @brief Return the target machine of the host CPU and its features,
+/// generating code at the given optimization level (0 to 3), or nullptr if
+/// the host is not a registered target.
+std::unique_ptr<llvm::TargetMachine> createHostTargetMachine(int optLevel);
+
+/// @brief Return the optimization level (0 to 3) of JIT compiled kernels,
+/// set by CUDAQ_JIT_OPT_LEVEL ("0" to "3" or "O0" to "O3"), 2 by default.
+int getJITOptLevel();
+
+/// @brief Run the LLVM PassManager at the given optimization level (0 to 3),
+/// tuned for the host CPU.
+void optimizeLLVM(llvm::Module *, int optLevel);
+
+/// @brief Run the LLVM PassManager at level 3, not tuned for any CPU, for
+/// code that does not run on this host.
 void optimizeLLVM(llvm::Module *);
 
 class Translation {
@@ -14,6 +14,9 @@
 #include "Future.h"
 #include "MeasureCounts.h"
 #include "Registry.h"
+#include <algorithm>
+#include <chrono>
+#include <optional>
 
 namespace cudaq {
 
@@ -77,9 +80,26 @@ public:
   virtual ServerJobPayload
   createJob(std::vector<KernelExecution> &circuitCodes) = 0;
 
+  /// @brief Given a vector of compiled quantum codes, create the payload
+  /// that submits them together in as few jobs as the server allows. Return
+  /// std::nullopt (the default) if the server only accepts one circuit per
+  /// job, createJob() is then used.
+  virtual std::optional<ServerJobPayload>
+  createBatchJob(std::vector<KernelExecution> &circuitCodes) {
+    return std::nullopt;
+  }
+
   /// @brief Extract the job id from the server response from posting the job.
   virtual std::string extractJobId(ServerMessage &postResponse) = 0;
 
+  /// @brief Extract the ids of the jobs of all circuits of a batch job from
+  /// the server response from posting it, one per circuit in order. By
+  /// default the post created one job.
+  virtual std::vector<std::string>
+  extractBatchJobIds(ServerMessage &postResponse) {
+    return {extractJobId(postResponse)};
+  }
+
   /// @brief Get the specific path required to retrieve job results.
   /// Construct specifically from the job id.
   virtual std::string constructGetJobPath(std::string &jobId) = 0;
@@ -88,14 +108,87 @@ public:
   /// from the full server response message.
   virtual std::string constructGetJobPath(ServerMessage &postResponse) = 0;
 
+  /// @brief Return the path to post to, with an empty message, to cancel
+  /// the job, or std::nullopt (the default) if the server does not support
+  /// cancelling jobs.
+  virtual std::optional<std::string>
+  constructCancelJobPath(std::string &jobId) {
+    return std::nullopt;
+  }
+
+  /// @brief Return true if the server compiles parameterized programs once
+  /// and then runs them for parameter values bound at submission, see
+  /// createProgramUpload() and createBindingJob().
+  virtual bool supportsParameterBinding() { return false; }
+
+  /// @brief Create the payload that uploads the given parameterized
+  /// programs (OpenQASM 3 with `input` parameters) for later binding.
+  virtual ServerJobPayload
+  createProgramUpload(std::vector<KernelExecution> &parameterizedCodes) {
+    throw std::runtime_error(name() +
+                             " does not support parameterized programs.");
+  }
+
+  /// @brief Extract the ids of the uploaded programs, one per program in
+  /// order, from the server response from posting the upload.
+  virtual std::vector<std::string>
+  extractProgramIds(ServerMessage &uploadResponse) {
+    throw std::runtime_error(name() +
+                             " does not support parameterized programs.");
+  }
+
+  /// @brief Create the payload that runs every uploaded program with the
+  /// given parameter values. The job ids of the response are extracted with
+  /// extractBatchJobIds(), one per program.
+  virtual ServerJobPayload
+  createBindingJob(const std::vector<std::string> &programIds,
+                   const std::vector<double> &parameters) {
+    throw std::runtime_error(name() +
+                             " does not support parameterized programs.");
+  }
+
   /// @brief Return true if the job is done.
   virtual bool jobIsDone(ServerMessage &getJobResponse) = 0;
 
+  /// @brief Return how long to wait before polling an unfinished job again,
+  /// given its last response and the previous interval (zero before the
+  /// first poll). Servers that advise a polling interval in their responses
+  /// override this. By default the interval doubles from 100 ms up to 10 s.
+  virtual std::chrono::milliseconds
+  nextPollingInterval(ServerMessage &getJobResponse,
+                      std::chrono::milliseconds previous) {
+    using namespace std::chrono_literals;
+    return std::clamp<std::chrono::milliseconds>(2 * previous, 100ms,
+                                                 10000ms);
+  }
+
   /// @brief Given a successful job and the success response,
   /// retrieve the results and map them to a sample_result.
   /// @param postJobResponse
   /// @return
   virtual cudaq::sample_result
   processResults(ServerMessage &postJobResponse) = 0;
+
+  /// @brief Return the key of the objects of bit strings to counts in the
+  /// job results, e.g. "counts", to have them decoded straight into
+  /// CountsDictionary while the response is parsed, see
+  /// decodeJobResponse() and processStreamedResults(). This avoids holding
+  /// the counts of a large result as JSON values. An empty key (the default)
+  /// parses the whole response, for processResults().
+  virtual std::string streamedCountsKey() { return {}; }
+
+  /// @brief Given a successful job, its response with the counts objects
+  /// left empty and the counts they held in document order, map them to a
+  /// sample_result. By default the response must hold one counts object,
+  /// the global register.
+  virtual cudaq::sample_result
+  processStreamedResults(ServerMessage &getJobResponse,
+                         std::vector<CountsDictionary> &counts) {
+    if (counts.size() != 1)
+      throw std::runtime_error(
+          name() + " job response holds " + std::to_string(counts.size()) +
+          " counts objects, processStreamedResults() must be overridden.");
+    return sample_result(ExecutionResult(std::move(counts.front())));
+  }
 };
 } // namespace cudaq
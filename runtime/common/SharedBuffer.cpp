@@ -0,0 +1,106 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+#include "SharedBuffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <random>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cudaq {
+
+namespace {
+std::runtime_error sharedBufferError(const std::string &what,
+                                     const std::string &name) {
+  return std::runtime_error("Could not " + what + " the shared buffer " +
+                            name + " (" + std::strerror(errno) + ").");
+}
+} // namespace
+
+SharedBuffer::SharedBuffer(std::string n, int f, bool o)
+    : name(std::move(n)), fd(f), owner(o) {}
+
+SharedBuffer::~SharedBuffer() {
+  if (mapping)
+    munmap(mapping, mappedSize);
+  if (fd >= 0)
+    close(fd);
+  if (owner)
+    shm_unlink(name.c_str());
+}
+
+std::unique_ptr<SharedBuffer> SharedBuffer::create(std::size_t size) {
+  std::random_device rd;
+  for (int attempt = 0; attempt < 16; attempt++) {
+    auto name = "/cudaq-" + std::to_string(getpid()) + "-" +
+                std::to_string(
+                    std::uniform_int_distribution<std::uint64_t>()(rd));
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST)
+      continue;
+    if (fd < 0)
+      throw sharedBufferError("create", name);
+    std::unique_ptr<SharedBuffer> buffer(new SharedBuffer(name, fd, true));
+    buffer->reserve(size);
+    return buffer;
+  }
+  throw std::runtime_error("Could not find a free shared buffer name.");
+}
+
+std::unique_ptr<SharedBuffer> SharedBuffer::open(const std::string &name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0600);
+  if (fd < 0)
+    throw sharedBufferError("open", name);
+  std::unique_ptr<SharedBuffer> buffer(new SharedBuffer(name, fd, false));
+  buffer->remap();
+  return buffer;
+}
+
+void SharedBuffer::remap() {
+  struct stat info;
+  if (fstat(fd, &info) != 0)
+    throw sharedBufferError("stat", name);
+  const std::size_t size = info.st_size;
+  if (mapping && size == mappedSize)
+    return;
+  if (mapping)
+    munmap(mapping, mappedSize);
+  mapping = nullptr;
+  mappedSize = 0;
+  if (size == 0)
+    return;
+  void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (ptr == MAP_FAILED)
+    throw sharedBufferError("map", name);
+  mapping = static_cast<char *>(ptr);
+  mappedSize = size;
+}
+
+char *SharedBuffer::data() {
+  remap();
+  return mapping;
+}
+
+void SharedBuffer::reserve(std::size_t size) {
+  remap();
+  if (size <= mappedSize)
+    return;
+  // Grow geometrically, so that growing results do not remap every time.
+  const std::size_t newSize = std::max(size, 2 * mappedSize);
+  if (ftruncate(fd, newSize) != 0)
+    throw sharedBufferError("grow", name);
+  remap();
+}
+
+} // namespace cudaq
@@ -0,0 +1,58 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace cudaq {
+
+/// @brief A buffer in POSIX shared memory, which processes on the same host
+/// map by name to exchange large data without serializing or copying it
+/// through a socket. Either process may grow the buffer, the other one maps
+/// the new size on its next call to data().
+class SharedBuffer {
+  std::string name;
+  int fd = -1;
+  char *mapping = nullptr;
+  std::size_t mappedSize = 0;
+  /// @brief The creator unlinks the name on destruction.
+  bool owner = false;
+
+  SharedBuffer(std::string name, int fd, bool owner);
+
+  /// @brief Map the current size of the shared memory object.
+  void remap();
+
+public:
+  /// @brief Create a buffer of the given size under a unique name.
+  static std::unique_ptr<SharedBuffer> create(std::size_t size);
+
+  /// @brief Open the buffer created under the given name.
+  static std::unique_ptr<SharedBuffer> open(const std::string &name);
+
+  SharedBuffer(const SharedBuffer &) = delete;
+  SharedBuffer &operator=(const SharedBuffer &) = delete;
+  ~SharedBuffer();
+
+  /// @brief Return the name other processes open the buffer by.
+  const std::string &getName() const { return name; }
+
+  /// @brief Return the data of the buffer, mapping it again if another
+  /// process grew it.
+  char *data();
+
+  /// @brief Return the size of the buffer, as of the last call to data().
+  std::size_t size() const { return mappedSize; }
+
+  /// @brief Grow the buffer to at least the given size.
+  void reserve(std::size_t size);
+};
+
+} // namespace cudaq
@@ -0,0 +1,107 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "ShotStream.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace cudaq {
+
+std::string shot_batch::bit_string(std::size_t shot) const {
+  std::string bits(nBits, '0');
+  for (std::size_t j = 0; j < nBits; j++)
+    if (bit(shot, j))
+      bits[j] = '1';
+  return bits;
+}
+
+ShotStream::ShotStream(shot_sink s)
+    : sink(std::move(s)), generator(std::random_device{}()) {
+  if (!sink.callback)
+    throw std::runtime_error("A shot stream needs a callback.");
+  if (sink.batch_size == 0)
+    throw std::runtime_error("The batch size of a shot stream must be "
+                             "positive.");
+}
+
+void ShotStream::setBits(std::size_t bits) {
+  if (nWords == 0) {
+    nBits = bits;
+    nWords = std::max<std::size_t>((bits + 63) / 64, 1);
+    records.resize(sink.batch_size * nWords);
+    return;
+  }
+  if (bits != nBits)
+    throw std::runtime_error("Cannot stream a record of " +
+                             std::to_string(bits) + " bits after records of " +
+                             std::to_string(nBits) + " bits.");
+}
+
+void ShotStream::append(const std::uint64_t *record, std::size_t bits) {
+  setBits(bits);
+  std::copy_n(record, nWords, records.begin() + nBuffered * nWords);
+  if (++nBuffered == sink.batch_size)
+    flush();
+}
+
+void ShotStream::append(std::string_view bits) {
+  setBits(bits.size());
+  auto record = records.begin() + nBuffered * nWords;
+  std::fill_n(record, nWords, 0);
+  for (std::size_t j = 0; j < bits.size(); j++)
+    if (bits[j] == '1')
+      record[j / 64] |= 1ULL << (j % 64);
+  if (++nBuffered == sink.batch_size)
+    flush();
+}
+
+void ShotStream::appendCounts(const PackedCounts &counts) {
+  const std::size_t n = counts.size();
+  if (n == 0)
+    return;
+
+  // Draw without replacement through a Fenwick tree of the remaining
+  // counts, whose prefix sums locate the drawn shot.
+  std::vector<std::size_t> tree(n + 1, 0);
+  for (std::size_t i = 0; i < n; i++) {
+    tree[i + 1] += counts.count(i);
+    const auto parent = (i + 1) + ((i + 1) & -(i + 1));
+    if (parent <= n)
+      tree[parent] += tree[i + 1];
+  }
+  std::size_t highBit = 1;
+  while (highBit * 2 <= n)
+    highBit *= 2;
+
+  for (std::size_t remaining = counts.total(); remaining > 0; remaining--) {
+    // Find the bit string holding the r-th remaining shot.
+    std::size_t r =
+        std::uniform_int_distribution<std::size_t>(0, remaining - 1)(generator);
+    std::size_t pos = 0;
+    for (std::size_t step = highBit; step > 0; step /= 2)
+      if (pos + step <= n && tree[pos + step] <= r) {
+        pos += step;
+        r -= tree[pos];
+      }
+    for (std::size_t i = pos + 1; i <= n; i += i & -i)
+      tree[i]--;
+    append(counts.key(pos), counts.n_bits());
+  }
+}
+
+void ShotStream::flush() {
+  if (nBuffered == 0)
+    return;
+  sink.callback(
+      shot_batch(records.data(), nBuffered, nBits, nWords, nStreamed));
+  nStreamed += nBuffered;
+  nBuffered = 0;
+}
+} // namespace cudaq
@@ -0,0 +1,110 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "MeasureCounts.h"
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace cudaq {
+
+/// @brief A batch of per-shot measurement records, each packed like the bit
+/// strings of PackedCounts (bit j of a record is bit j % 64 of its word
+/// j / 64). The records are only valid during the call of the shot_sink.
+class shot_batch {
+  const std::uint64_t *records = nullptr;
+  std::size_t nShots = 0;
+  std::size_t nBits = 0;
+  std::size_t nWords = 0;
+  std::size_t firstShot = 0;
+
+public:
+  shot_batch(const std::uint64_t *records, std::size_t nShots,
+             std::size_t nBits, std::size_t nWords, std::size_t firstShot)
+      : records(records), nShots(nShots), nBits(nBits), nWords(nWords),
+        firstShot(firstShot) {}
+
+  /// @brief Return the number of shots in this batch.
+  std::size_t size() const { return nShots; }
+
+  /// @brief Return the number of bits of each record.
+  std::size_t n_bits() const { return nBits; }
+
+  /// @brief Return the number of words of each record.
+  std::size_t n_words() const { return nWords; }
+
+  /// @brief Return the index of the first shot of this batch in the run.
+  std::size_t first_shot() const { return firstShot; }
+
+  /// @brief Return the packed record of the given shot of this batch.
+  const std::uint64_t *record(std::size_t shot) const {
+    return records + shot * nWords;
+  }
+
+  /// @brief Return bit j of the record of the given shot.
+  bool bit(std::size_t shot, std::size_t j) const {
+    return (record(shot)[j / 64] >> (j % 64)) & 1;
+  }
+
+  /// @brief Return the record of the given shot as '0' and '1' characters.
+  std::string bit_string(std::size_t shot) const;
+};
+
+/// @brief Receives the per-shot records of a sampling run in batches of at
+/// most `batch_size` shots. The sampling waits for the callback to return,
+/// so a slow consumer holds back the producer and at most one batch is
+/// buffered.
+struct shot_sink {
+  std::function<void(const shot_batch &)> callback;
+  std::size_t batch_size = 4096;
+};
+
+/// @brief Buffers per-shot records and hands them to a shot_sink once a
+/// batch is full. All records of a stream have the same number of bits.
+class ShotStream {
+  shot_sink sink;
+  std::size_t nBits = 0;
+  std::size_t nWords = 0;
+  std::vector<std::uint64_t> records;
+  std::size_t nBuffered = 0;
+  std::size_t nStreamed = 0;
+  std::mt19937_64 generator;
+
+  /// @brief Set the number of bits of the records, checking that it does
+  /// not change within the stream.
+  void setBits(std::size_t bits);
+
+public:
+  /// @brief Construct a stream into the given sink.
+  explicit ShotStream(shot_sink sink);
+
+  /// @brief Append the record of one shot, packed with the given number of
+  /// bits.
+  void append(const std::uint64_t *record, std::size_t bits);
+
+  /// @brief Append the record of one shot, given as '0' and '1' characters.
+  void append(std::string_view bits);
+
+  /// @brief Append one record per count of the given counts, in a uniformly
+  /// random order, i.e. as if the shots had been drawn one at a time. This
+  /// takes O(log n) time per shot for n distinct bit strings and no memory
+  /// beyond the counts and one batch.
+  void appendCounts(const PackedCounts &counts);
+
+  /// @brief Hand the buffered records to the sink, even if the batch is not
+  /// full.
+  void flush();
+
+  /// @brief Return the number of shots appended so far.
+  std::size_t size() const { return nStreamed + nBuffered; }
+};
+} // namespace cudaq
@@ -0,0 +1,130 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <complex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cudaq {
+
+// A State is the vector of data for the density matrix or state vector,
+// as well as the array shape (n,n) or (n)
+using State =
+    std::tuple<std::vector<std::size_t>, std::vector<std::complex<double>>>;
+
+/// @brief A SimulationState is a handle to the state vector (shape (n)) or
+/// density matrix (shape (n, n)) of a simulator. Backends return subtypes
+/// that reference or own the simulator memory directly, on the host or on
+/// the device, so that extracting the state does not copy it. Elements are
+/// only read from the underlying memory when they are accessed.
+class SimulationState {
+public:
+  virtual ~SimulationState() = default;
+
+  /// @brief Return the shape of the state, (n) or (n, n).
+  virtual std::vector<std::size_t> getShape() const = 0;
+
+  /// @brief Return the element at the given flat index into the data.
+  virtual std::complex<double> getElement(std::size_t idx) const = 0;
+
+  /// @brief Return the contiguous double precision host data of the state,
+  /// or nullptr if the data is held on a device or in another precision.
+  virtual const std::complex<double> *getHostData() const { return nullptr; }
+
+  /// @brief Return the number of elements of the state.
+  std::size_t size() const {
+    std::size_t size = 1;
+    for (auto extent : getShape())
+      size *= extent;
+    return size;
+  }
+
+  /// @brief Copy the `count` elements from the flat index `first` on into
+  /// host memory at `out`.
+  virtual void copyElements(std::size_t first, std::size_t count,
+                            std::complex<double> *out) const {
+    if (auto *hostData = getHostData())
+      std::copy(hostData + first, hostData + first + count, out);
+    else
+      for (std::size_t i = 0; i < count; i++)
+        out[i] = getElement(first + i);
+  }
+
+  /// @brief Copy the state into host memory.
+  virtual State toState() const {
+    std::vector<std::complex<double>> data(size());
+    if (auto *hostData = getHostData())
+      std::copy(hostData, hostData + data.size(), data.begin());
+    else
+      for (std::size_t i = 0; i < data.size(); i++)
+        data[i] = getElement(i);
+    return State{getShape(), std::move(data)};
+  }
+};
+
+/// @brief A SimulationState that owns contiguous host data, any container
+/// with data() and size() holding complex amplitudes. Simulators move their
+/// own container in here to hand its ownership over without a copy.
+template <typename ContainerT>
+class HostSimulationState : public SimulationState {
+protected:
+  std::vector<std::size_t> shape;
+  ContainerT container;
+
+public:
+  HostSimulationState(std::vector<std::size_t> shape, ContainerT &&container)
+      : shape(std::move(shape)), container(std::move(container)) {}
+
+  std::vector<std::size_t> getShape() const override { return shape; }
+
+  std::complex<double> getElement(std::size_t idx) const override {
+    return std::complex<double>(container.data()[idx]);
+  }
+
+  const std::complex<double> *getHostData() const override {
+    using Element = std::remove_cv_t<
+        std::remove_reference_t<decltype(*std::declval<ContainerT>().data())>>;
+    if constexpr (std::is_same_v<Element, std::complex<double>>)
+      return container.data();
+    else
+      return nullptr;
+  }
+};
+
+/// @brief A SimulationState referencing host data owned by a simulator. It
+/// is valid until the next operation on the simulator.
+template <typename ElementT>
+class HostSimulationStateView : public SimulationState {
+protected:
+  std::vector<std::size_t> shape;
+  const ElementT *data;
+
+public:
+  HostSimulationStateView(std::vector<std::size_t> shape, const ElementT *data)
+      : shape(std::move(shape)), data(data) {}
+
+  std::vector<std::size_t> getShape() const override { return shape; }
+
+  std::complex<double> getElement(std::size_t idx) const override {
+    return std::complex<double>(data[idx]);
+  }
+
+  const std::complex<double> *getHostData() const override {
+    if constexpr (std::is_same_v<ElementT, std::complex<double>>)
+      return data;
+    else
+      return nullptr;
+  }
+};
+
+} // namespace cudaq
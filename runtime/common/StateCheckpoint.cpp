@@ -0,0 +1,219 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+#include "StateCheckpoint.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cudaq {
+
+namespace {
+
+/// The file starts with this header, followed by the extents of the shape,
+/// the qubit indices, the indices of the stored amplitudes if compressed, and
+/// the stored amplitudes, 16 byte aligned.
+struct Header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t flags;
+  std::uint64_t rank;
+  std::uint64_t numQubits;
+  std::uint64_t numStored;
+};
+
+constexpr char checkpointMagic[8] = {'C', 'U', 'D', 'A', 'Q', 'C', 'K', 'P'};
+constexpr std::uint32_t checkpointVersion = 1;
+constexpr std::uint32_t compressedFlag = 1;
+
+/// The number of amplitudes copied from the state at once.
+constexpr std::size_t chunkSize = 1 << 16;
+
+/// Return the offset of the stored amplitudes.
+std::size_t amplitudesOffset(const Header &header) {
+  std::size_t offset = sizeof(Header) + 8 * (header.rank + header.numQubits);
+  if (header.flags & compressedFlag)
+    offset += 8 * header.numStored;
+  return (offset + 15) / 16 * 16;
+}
+
+std::runtime_error checkpointError(const std::string &what,
+                                   const std::string &path) {
+  return std::runtime_error("Could not " + what + " the state checkpoint " +
+                            path + " (" + std::strerror(errno) + ").");
+}
+} // namespace
+
+void writeStateCheckpoint(const std::string &path,
+                          const SimulationState &state,
+                          const std::vector<std::size_t> &qubits,
+                          bool compress) {
+  const auto shape = state.getShape();
+  const std::size_t size = state.size();
+  std::vector<std::complex<double>> chunk;
+
+  // Compress only if the indices and the non-zero amplitudes take less space
+  // than the dense amplitudes.
+  std::size_t numStored = size;
+  if (compress) {
+    std::size_t nonZero = 0;
+    chunk.resize(std::min(size, chunkSize));
+    for (std::size_t first = 0; first < size; first += chunkSize) {
+      const std::size_t count = std::min(chunkSize, size - first);
+      state.copyElements(first, count, chunk.data());
+      nonZero += std::count_if(chunk.begin(), chunk.begin() + count,
+                               [](auto a) { return a != 0.0; });
+    }
+    compress = 3 * nonZero < 2 * size;
+    if (compress)
+      numStored = nonZero;
+  }
+
+  Header header;
+  std::memcpy(header.magic, checkpointMagic, sizeof(header.magic));
+  header.version = checkpointVersion;
+  header.flags = compress ? compressedFlag : 0;
+  header.rank = shape.size();
+  header.numQubits = qubits.size();
+  header.numStored = numStored;
+  const std::size_t offset = amplitudesOffset(header);
+  const std::size_t fileSize =
+      offset + numStored * sizeof(std::complex<double>);
+
+  const std::string partialPath = path + ".partial";
+  int fd = ::open(partialPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    throw checkpointError("create", partialPath);
+  auto fail = [&](const std::string &what) {
+    auto error = checkpointError(what, partialPath);
+    close(fd);
+    unlink(partialPath.c_str());
+    return error;
+  };
+  if (ftruncate(fd, fileSize) != 0)
+    throw fail("resize");
+  auto *mapping = static_cast<char *>(
+      mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+  if (mapping == MAP_FAILED)
+    throw fail("map");
+
+  std::memcpy(mapping, &header, sizeof(header));
+  auto *words = reinterpret_cast<std::uint64_t *>(mapping + sizeof(header));
+  words = std::copy(shape.begin(), shape.end(), words);
+  words = std::copy(qubits.begin(), qubits.end(), words);
+  auto *amplitudes =
+      reinterpret_cast<std::complex<double> *>(mapping + offset);
+  if (!compress) {
+    for (std::size_t first = 0; first < size; first += chunkSize)
+      state.copyElements(first, std::min(chunkSize, size - first),
+                         amplitudes + first);
+  } else {
+    for (std::size_t first = 0; first < size; first += chunkSize) {
+      const std::size_t count = std::min(chunkSize, size - first);
+      state.copyElements(first, count, chunk.data());
+      for (std::size_t i = 0; i < count; i++)
+        if (chunk[i] != 0.0) {
+          *words++ = first + i;
+          *amplitudes++ = chunk[i];
+        }
+    }
+  }
+
+  const bool synced = msync(mapping, fileSize, MS_SYNC) == 0;
+  munmap(mapping, fileSize);
+  if (!synced)
+    throw fail("write");
+  close(fd);
+  if (std::rename(partialPath.c_str(), path.c_str()) != 0)
+    throw checkpointError("rename", partialPath);
+}
+
+StateCheckpoint::StateCheckpoint(const std::string &path) {
+  fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw checkpointError("open", path);
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    auto error = checkpointError("stat", path);
+    close(fd);
+    throw error;
+  }
+  mappedSize = info.st_size;
+  Header header;
+  if (mappedSize >= sizeof(header)) {
+    mapping = static_cast<char *>(
+        mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0));
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+      auto error = checkpointError("map", path);
+      close(fd);
+      throw error;
+    }
+    std::memcpy(&header, mapping, sizeof(header));
+  }
+
+  auto invalid = [&]() {
+    if (mapping)
+      munmap(mapping, mappedSize);
+    close(fd);
+    return std::runtime_error(path + " is not a state checkpoint.");
+  };
+  if (!mapping ||
+      std::memcmp(header.magic, checkpointMagic, sizeof(header.magic)) != 0 ||
+      header.version != checkpointVersion || header.rank < 1 ||
+      header.rank > 2 || header.numQubits > 64)
+    throw invalid();
+
+  const auto *words =
+      reinterpret_cast<const std::uint64_t *>(mapping + sizeof(header));
+  shape.assign(words, words + header.rank);
+  words += header.rank;
+  qubits.assign(words, words + header.numQubits);
+  words += header.numQubits;
+  std::size_t size = 1;
+  for (auto extent : shape)
+    size *= extent;
+  const bool compressed = header.flags & compressedFlag;
+  if (!std::has_single_bit(shape[0]) ||
+      (header.rank == 2 && shape[1] != shape[0]) ||
+      (compressed ? header.numStored > size : header.numStored != size) ||
+      amplitudesOffset(header) + header.numStored * 16 > mappedSize)
+    throw invalid();
+
+  amplitudes = reinterpret_cast<const std::complex<double> *>(
+      mapping + amplitudesOffset(header));
+  if (compressed) {
+    expanded.assign(size, 0.0);
+    for (std::size_t i = 0; i < header.numStored; i++) {
+      if (words[i] >= size)
+        throw invalid();
+      expanded[words[i]] = amplitudes[i];
+    }
+    amplitudes = expanded.data();
+  }
+}
+
+StateCheckpoint::~StateCheckpoint() {
+  if (mapping)
+    munmap(mapping, mappedSize);
+  if (fd >= 0)
+    close(fd);
+}
+
+std::size_t StateCheckpoint::getNumQubits() const {
+  return std::countr_zero(shape[0]);
+}
+
+} // namespace cudaq
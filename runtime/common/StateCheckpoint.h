@@ -0,0 +1,63 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+#pragma once
+
+#include "SimulationState.h"
+#include <complex>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cudaq {
+
+/// @brief Write a checkpoint file of `state` and of the qubit indices in use
+/// on it, `qubits`. The amplitudes are streamed into the memory mapped file
+/// in chunks, so that no host copy of a device state is made. If `compress`
+/// is set and the state is sparse enough, only its non-zero amplitudes are
+/// stored, with their indices. The file is written under a temporary name
+/// and renamed to `path` once complete, so that a preempted write leaves any
+/// previous checkpoint intact.
+void writeStateCheckpoint(const std::string &path,
+                          const SimulationState &state,
+                          const std::vector<std::size_t> &qubits,
+                          bool compress = false);
+
+/// @brief A checkpoint file mapped into memory. The amplitudes of a dense
+/// checkpoint are read from the mapping as they are accessed, those of a
+/// compressed one are expanded on opening.
+class StateCheckpoint {
+  int fd = -1;
+  char *mapping = nullptr;
+  std::size_t mappedSize = 0;
+  std::vector<std::size_t> shape;
+  std::vector<std::size_t> qubits;
+  const std::complex<double> *amplitudes = nullptr;
+  std::vector<std::complex<double>> expanded;
+
+public:
+  /// @brief Open the checkpoint file at `path`.
+  explicit StateCheckpoint(const std::string &path);
+  StateCheckpoint(const StateCheckpoint &) = delete;
+  StateCheckpoint &operator=(const StateCheckpoint &) = delete;
+  ~StateCheckpoint();
+
+  /// @brief Return the shape of the state, (n) or (n, n).
+  const std::vector<std::size_t> &getShape() const { return shape; }
+
+  /// @brief Return the qubit indices in use when the checkpoint was written.
+  const std::vector<std::size_t> &getQubits() const { return qubits; }
+
+  /// @brief Return the number of qubits of the state.
+  std::size_t getNumQubits() const;
+
+  /// @brief Return the amplitudes of the state, in the flat order of
+  /// SimulationState.
+  const std::complex<double> *data() const { return amplitudes; }
+};
+
+} // namespace cudaq
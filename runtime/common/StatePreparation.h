@@ -0,0 +1,116 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// This header is included by the CUDA backends, which are compiled as C++17.
+
+namespace cudaq {
+
+/// @brief Throw if the `nAmplitudes` amplitudes are not a normalized state of
+/// `nQubits` qubits.
+inline void checkStateAmplitudes(std::size_t nQubits,
+                                 const std::complex<double> *amplitudes,
+                                 std::size_t nAmplitudes) {
+  if (nQubits >= 64 || nAmplitudes != 1ULL << nQubits)
+    throw std::runtime_error(
+        "Cannot initialize " + std::to_string(nQubits) + " qubits with " +
+        std::to_string(nAmplitudes) + " amplitudes, 2^n are required.");
+  double norm = 0.0;
+  for (std::size_t k = 0; k < nAmplitudes; k++)
+    norm += std::norm(amplitudes[k]);
+  if (std::abs(norm - 1.0) > 1e-6)
+    throw std::runtime_error("The amplitudes to initialize the qubits with "
+                             "are not normalized (norm " +
+                             std::to_string(std::sqrt(norm)) + ").");
+}
+
+/// @brief Synthesize the circuit taking `nQubits` fresh qubits, in |0>, to
+/// the state with the 2^n `amplitudes`, where bit j of the amplitude index is
+/// the value of the j-th qubit. `gate(name, angle, controls, target)` is
+/// called for each gate, an "x", "ry" or "r1" with the qubits given by their
+/// position j. From the last qubit to the first, an ry controlled on each
+/// value of the qubits after it splits the weight of the amplitudes with
+/// that value (x gates select the value), then r1 gates controlled on each
+/// value of the other qubits set the phases, up to a global phase. This
+/// takes O(2^n) multi-controlled gates, zero rotations are skipped.
+template <typename ApplyGate>
+void synthesizeStatePreparation(std::size_t nQubits,
+                                const std::complex<double> *amplitudes,
+                                ApplyGate &&gate) {
+  if (nQubits == 0)
+    return;
+  const std::size_t dim = 1ULL << nQubits;
+  // weights[j][m] is the summed squared norm of the amplitudes whose bits j
+  // and above have the value m.
+  std::vector<std::vector<double>> weights(nQubits + 1);
+  weights[0].resize(dim);
+  for (std::size_t k = 0; k < dim; k++)
+    weights[0][k] = std::norm(amplitudes[k]);
+  for (std::size_t j = 1; j <= nQubits; j++) {
+    weights[j].resize(dim >> j);
+    for (std::size_t m = 0; m < weights[j].size(); m++)
+      weights[j][m] = weights[j - 1][2 * m] + weights[j - 1][2 * m + 1];
+  }
+
+  // Flip the qubits from `first` on whose bit in `value` is 0, so that the
+  // gates controlled on all of them act on that value.
+  auto flip = [&](std::size_t first, std::size_t value) {
+    for (std::size_t p = first; p < nQubits; p++)
+      if (!(value >> (p - first) & 1))
+        gate("x", 0.0, std::vector<std::size_t>{}, p);
+  };
+
+  std::vector<std::size_t> controls;
+  for (std::size_t j = nQubits; j-- > 0;) {
+    controls.clear();
+    for (std::size_t p = j + 1; p < nQubits; p++)
+      controls.push_back(p);
+    for (std::size_t h = 0; h < 1ULL << (nQubits - 1 - j); h++) {
+      const double w0 = weights[j][2 * h], w1 = weights[j][2 * h + 1];
+      if (w1 == 0.0)
+        continue;
+      flip(j + 1, h);
+      gate("ry", 2.0 * std::atan2(std::sqrt(w1), std::sqrt(w0)), controls,
+           j);
+      flip(j + 1, h);
+    }
+  }
+
+  // The phases of the pairs of amplitudes that differ in the first qubit.
+  controls.clear();
+  for (std::size_t p = 1; p < nQubits; p++)
+    controls.push_back(p);
+  const std::vector<std::size_t> phaseControls(controls.begin() +
+                                                   (nQubits > 1),
+                                               controls.end());
+  for (std::size_t h = 0; h < dim / 2; h++) {
+    const auto a0 = amplitudes[2 * h], a1 = amplitudes[2 * h + 1];
+    if (a0 == 0.0 && a1 == 0.0)
+      continue;
+    const double phi0 = a0 != 0.0 ? std::arg(a0) : std::arg(a1);
+    const double phi1 = a1 != 0.0 ? std::arg(a1) : phi0;
+    // With a single qubit phi0 is a global phase.
+    const bool setPhase = nQubits > 1 && phi0 != 0.0;
+    if (phi1 == phi0 && !setPhase)
+      continue;
+    flip(1, h);
+    if (phi1 != phi0)
+      gate("r1", phi1 - phi0, controls, 0);
+    if (setPhase)
+      gate("r1", phi0, phaseControls, 1);
+    flip(1, h);
+  }
+}
+} // namespace cudaq
@@ -0,0 +1,220 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "ThreadAffinity.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace cudaq {
+
+namespace {
+thread_local std::size_t threadBudget = 0;
+
+/// Parse a Linux CPU list, e.g. "0-3,8,10-11".
+std::vector<int> parseCpuList(const std::string &list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || !std::isdigit(range[0]))
+      continue;
+    auto dash = range.find('-');
+    const int first = std::stoi(range.substr(0, dash));
+    const int last =
+        dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; cpu++)
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+std::vector<int> readCoresByNumaNode() {
+  std::vector<int> allowed;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      if (CPU_ISSET(cpu, &set))
+        allowed.push_back(cpu);
+#endif
+  if (allowed.empty()) {
+    const unsigned numCpus = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned cpu = 0; cpu < numCpus; cpu++)
+      allowed.push_back(cpu);
+  }
+
+  // Order the allowed cores node by node, those of no node last.
+  std::vector<std::pair<int, std::filesystem::path>> nodes;
+  std::error_code ec;
+  for (auto &entry : std::filesystem::directory_iterator(
+           "/sys/devices/system/node", ec)) {
+    auto name = entry.path().filename().string();
+    if (name.rfind("node", 0) == 0 && name.size() > 4 &&
+        std::all_of(name.begin() + 4, name.end(), ::isdigit))
+      nodes.emplace_back(std::stoi(name.substr(4)), entry.path() / "cpulist");
+  }
+  std::sort(nodes.begin(), nodes.end());
+
+  std::vector<int> cores;
+  std::set<int> remaining(allowed.begin(), allowed.end());
+  for (auto &[node, path] : nodes) {
+    std::ifstream file(path);
+    std::string list;
+    std::getline(file, list);
+    for (auto cpu : parseCpuList(list))
+      if (remaining.erase(cpu))
+        cores.push_back(cpu);
+  }
+  cores.insert(cores.end(), remaining.begin(), remaining.end());
+  return cores;
+}
+/// The NUMA placement of the pages of large buffers.
+struct NumaPolicy {
+  enum Kind { firstTouch, interleave, bind } kind = firstTouch;
+  int node = 0;
+};
+
+NumaPolicy readNumaPolicy() {
+  NumaPolicy policy;
+  auto *env = std::getenv("CUDAQ_NUMA_POLICY");
+  if (!env)
+    return policy;
+  std::string value = env;
+  if (value == "interleave")
+    policy.kind = NumaPolicy::interleave;
+  else if (value.rfind("bind:", 0) == 0) {
+    policy.kind = NumaPolicy::bind;
+    policy.node = std::atoi(value.c_str() + 5);
+  }
+  return policy;
+}
+} // namespace
+
+const std::vector<int> &getCoresByNumaNode() {
+  static const std::vector<int> cores = readCoresByNumaNode();
+  return cores;
+}
+
+std::vector<int> getCorePartition(std::size_t part, std::size_t numParts) {
+  auto &cores = getCoresByNumaNode();
+  if (numParts == 0)
+    return cores;
+  if (numParts >= cores.size())
+    return {cores[part % cores.size()]};
+  const std::size_t begin = part * cores.size() / numParts;
+  const std::size_t end = (part + 1) * cores.size() / numParts;
+  return std::vector<int>(cores.begin() + begin, cores.begin() + end);
+}
+
+bool pinCallingThread(const std::vector<int> &cores) {
+#ifdef __linux__
+  if (cores.empty())
+    return false;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto core : cores)
+    if (core >= 0 && core < CPU_SETSIZE)
+      CPU_SET(core, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+void setSimulatorThreadBudget(std::size_t numThreads) {
+  threadBudget = numThreads;
+}
+
+std::size_t getSimulatorThreadBudget() {
+  if (threadBudget)
+    return threadBudget;
+  static const std::size_t environmentBudget = []() -> std::size_t {
+    if (auto *threads = std::getenv("CUDAQ_SIMULATOR_THREADS"))
+      return std::strtoul(threads, nullptr, 10);
+    return 0;
+  }();
+  return environmentBudget;
+}
+
+bool useHugePages() {
+  static const bool hugePages = []() {
+    auto *env = std::getenv("CUDAQ_HUGE_PAGES");
+    return env && std::strtoul(env, nullptr, 10) != 0;
+  }();
+  return hugePages;
+}
+
+void adviseLargeBuffer(void *data, std::size_t bytes) {
+#ifdef __linux__
+  static const NumaPolicy policy = readNumaPolicy();
+  if (bytes < hugePageSize ||
+      (!useHugePages() && policy.kind == NumaPolicy::firstTouch))
+    return;
+
+  // Advise the whole pages of the buffer only.
+  const std::uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+  const auto begin = (reinterpret_cast<std::uintptr_t>(data) + pageSize - 1) &
+                     ~(pageSize - 1);
+  const auto end =
+      (reinterpret_cast<std::uintptr_t>(data) + bytes) & ~(pageSize - 1);
+  if (end <= begin)
+    return;
+  auto *start = reinterpret_cast<void *>(begin);
+  const std::size_t length = end - begin;
+
+#ifdef MADV_HUGEPAGE
+  if (useHugePages())
+    madvise(start, length, MADV_HUGEPAGE);
+#endif
+
+#ifdef SYS_mbind
+  if (policy.kind == NumaPolicy::firstTouch)
+    return;
+  // The memory policies of set_mempolicy(2), without requiring libnuma.
+  constexpr int mpolBind = 2, mpolInterleave = 3;
+  constexpr std::size_t maxNodes = 1024;
+  constexpr std::size_t bitsPerWord = 8 * sizeof(unsigned long);
+  unsigned long nodeMask[maxNodes / bitsPerWord] = {};
+  std::vector<int> nodes;
+  if (policy.kind == NumaPolicy::bind) {
+    nodes.push_back(policy.node);
+  } else {
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string list;
+    std::getline(online, list);
+    nodes = parseCpuList(list);
+  }
+  for (auto node : nodes)
+    if (node >= 0 && static_cast<std::size_t>(node) < maxNodes)
+      nodeMask[node / bitsPerWord] |= 1UL << (node % bitsPerWord);
+  syscall(SYS_mbind, start, length,
+          policy.kind == NumaPolicy::bind ? mpolBind : mpolInterleave,
+          nodeMask, maxNodes, 0);
+#endif
+#endif
+}
+
+} // namespace cudaq
@@ -0,0 +1,65 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/// Control of the CPU resources of the simulators. Simulators running
+/// concurrently on several threads (e.g. the shot threads of the platform)
+/// would each start as many OpenMP threads as there are cores and
+/// oversubscribe them. Instead, every thread is given a thread budget for its
+/// simulator, and can be pinned to its own cores, filled NUMA node by NUMA
+/// node. The threads a pinned thread starts inherit its cores, so the
+/// amplitudes the simulator's threads first touch are allocated on their node.
+/// The pages of large state buffers can also be backed by huge pages, and
+/// interleaved over or bound to NUMA nodes.
+namespace cudaq {
+
+/// @brief Return the cores the process may run on, the cores of each NUMA
+/// node in turn. Read once, at the first call.
+const std::vector<int> &getCoresByNumaNode();
+
+/// @brief Return the `part`-th of `numParts` contiguous partitions of nearly
+/// equal size of getCoresByNumaNode(), so that each partition spans as few
+/// NUMA nodes as possible. Every partition has at least one core, partitions
+/// share cores if there are more partitions than cores.
+std::vector<int> getCorePartition(std::size_t part, std::size_t numParts);
+
+/// @brief Pin the calling thread to `cores`. Threads it starts afterwards,
+/// e.g. OpenMP workers, inherit them. Return false if the thread could not be
+/// pinned.
+bool pinCallingThread(const std::vector<int> &cores);
+
+/// @brief Set the number of threads the simulator of the calling thread may
+/// use, 0 for no budget of its own.
+void setSimulatorThreadBudget(std::size_t numThreads);
+
+/// @brief Return the number of threads the simulator of the calling thread
+/// may use: its budget if set, else the CUDAQ_SIMULATOR_THREADS environment
+/// variable, else 0 for all the cores.
+std::size_t getSimulatorThreadBudget();
+
+/// @brief The size of a transparent huge page, the alignment of the buffers
+/// to back by huge pages.
+inline constexpr std::size_t hugePageSize = 2 << 20;
+
+/// @brief Return true if large buffers are backed by transparent huge pages,
+/// set by the CUDAQ_HUGE_PAGES environment variable (0 or 1).
+bool useHugePages();
+
+/// @brief Advise the kernel on the pages of [data, data + bytes), a simulator
+/// buffer not written yet: back them with huge pages if useHugePages(), and
+/// place them as the CUDAQ_NUMA_POLICY environment variable says,
+/// "interleave" over all the NUMA nodes or "bind:<node>" to one node. By
+/// default, a page goes to the node of the thread that first writes it.
+/// Buffers smaller than a huge page are left as they are.
+void adviseLargeBuffer(void *data, std::size_t bytes);
+
+} // namespace cudaq
@@ -0,0 +1,74 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "ZeroNoiseExtrapolation.h"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace cudaq {
+
+/// @brief Return the Lagrange polynomial through the points at zero.
+static double richardson(const std::vector<double> &scales,
+                         const std::vector<double> &values) {
+  double result = 0.0;
+  for (std::size_t i = 0; i < scales.size(); i++) {
+    double weight = 1.0;
+    for (std::size_t j = 0; j < scales.size(); j++)
+      if (j != i)
+        weight *= scales[j] / (scales[j] - scales[i]);
+    result += weight * values[i];
+  }
+  return result;
+}
+
+/// @brief Fit log|E - a| = log|b| - c s by least squares and return a + b.
+static double exponential(const std::vector<double> &scales,
+                          const std::vector<double> &values, double asymptote) {
+  const double sign = values.front() < asymptote ? -1.0 : 1.0;
+  const double n = scales.size();
+  double sumS = 0.0, sumY = 0.0, sumSS = 0.0, sumSY = 0.0;
+  for (std::size_t i = 0; i < scales.size(); i++) {
+    const double distance = sign * (values[i] - asymptote);
+    if (distance <= 0.0)
+      throw std::runtime_error(
+          "Exponential zero-noise extrapolation requires the expectation "
+          "values at all noise scales on the same side of the asymptote.");
+    const double y = std::log(distance);
+    sumS += scales[i];
+    sumY += y;
+    sumSS += scales[i] * scales[i];
+    sumSY += scales[i] * y;
+  }
+  const double slope = (n * sumSY - sumS * sumY) / (n * sumSS - sumS * sumS);
+  const double intercept = (sumY - slope * sumS) / n;
+  return asymptote + sign * std::exp(intercept);
+}
+
+double extrapolate_to_zero_noise(const std::vector<double> &scales,
+                                 const std::vector<double> &values,
+                                 zne_extrapolation extrapolation,
+                                 double asymptote) {
+  if (scales.size() != values.size())
+    throw std::runtime_error("Zero-noise extrapolation requires one value per "
+                             "noise scale.");
+  for (std::size_t i = 0; i < scales.size(); i++)
+    for (std::size_t j = 0; j < i; j++)
+      if (scales[i] == scales[j])
+        throw std::runtime_error("Zero-noise extrapolation requires distinct "
+                                 "noise scales.");
+  if (scales.size() < 2)
+    throw std::runtime_error("Zero-noise extrapolation requires at least two "
+                             "noise scales.");
+
+  if (extrapolation == zne_extrapolation::exponential)
+    return exponential(scales, values, asymptote);
+  return richardson(scales, values);
+}
+
+} // namespace cudaq
@@ -0,0 +1,63 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "ObserveResult.h"
+
+#include <vector>
+
+namespace cudaq {
+
+/// @brief The fit that extrapolates the expectation values measured at
+/// amplified noise to zero noise.
+enum class zne_extrapolation {
+  /// @brief The polynomial through all the points, evaluated at zero
+  /// (Richardson extrapolation).
+  richardson,
+  /// @brief The curve a + b exp(-c s) fitted to the points by least squares
+  /// on log(E - a), for a fixed asymptote a: the expectation value noise
+  /// decays to, e.g. the constant terms of the observed spin_op.
+  exponential
+};
+
+/// @brief The options of a zero-noise extrapolated observe, see
+/// observe(zne_options, ...).
+struct zne_options {
+  /// @brief The odd factors the noise of the kernel is scaled by, by
+  /// folding its gates. At least two distinct ones.
+  std::vector<std::size_t> scales = {1, 3, 5};
+
+  /// @brief The extrapolation to zero noise.
+  zne_extrapolation extrapolation = zne_extrapolation::richardson;
+};
+
+/// @brief The result of a zero-noise extrapolated observe.
+struct zne_result {
+  /// @brief The expectation value extrapolated to zero noise.
+  double expectation = 0.0;
+
+  /// @brief The noise scales and the observation at each of them.
+  std::vector<std::size_t> scales;
+  std::vector<observe_result> results;
+
+  /// @brief Conversion to the extrapolated expectation value.
+  operator double() const { return expectation; }
+};
+
+/// @brief Return the value at zero noise extrapolated from the `values`
+/// measured at the noise `scales`. Exponential extrapolation approaches the
+/// `asymptote` at infinite noise. Throws if there are fewer than two
+/// distinct scales, or if an exponential cannot be fitted because the
+/// values are not all on the same side of the asymptote.
+double extrapolate_to_zero_noise(const std::vector<double> &scales,
+                                 const std::vector<double> &values,
+                                 zne_extrapolation extrapolation,
+                                 double asymptote = 0.0);
+
+} // namespace cudaq
@@ -188,6 +188,10 @@ void set_noise(cudaq::noise_model &model);
 /// @brief Remove an existing noise model from simulation.
 void unset_noise();
 
+/// @brief Seed the random outcomes of the executions from now on, so that
+/// sampling is reproducible, including when it is split across QPUs.
+void set_random_seed(std::size_t seed);
+
 /// @brief Utility function for clearing the shots
 void clear_shots(const std::size_t nShots);
 
@@ -10,5 +10,6 @@
 
 #include "algorithms/observe.h"
 #include "algorithms/optimizer.h"
+#include "algorithms/resource_estimate.h"
 #include "algorithms/state.h"
 #include "algorithms/vqe.h"
@@ -0,0 +1,456 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "cudaq/qis/qubit_qis.h"
+#include "observe.h"
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cudaq {
+
+/// \brief A gate of a cut_circuit, by the name the execution manager knows
+/// it (e.g. "h", "x", "rx", "swap"), with its parameters, controls and
+/// targets.
+struct circuit_gate {
+  std::string name;
+  std::vector<double> parameters;
+  std::vector<std::size_t> controls;
+  std::vector<std::size_t> targets;
+};
+
+/// \brief A circuit of gates on `num_qubits` qubits starting in |0>,
+/// observed with observe_cut().
+struct cut_circuit {
+  std::size_t num_qubits = 0;
+  std::vector<circuit_gate> gates;
+};
+
+/// \brief The limits of the wire cuts of observe_cut().
+struct cut_options {
+  /// \brief The most qubits of a fragment, that is of one simulation.
+  std::size_t max_fragment_qubits = 20;
+
+  /// \brief The most wire cuts. The reconstruction sums over 4^cuts terms,
+  /// and a fragment with n incoming cuts is simulated 6^n times.
+  std::size_t max_cuts = 8;
+};
+
+namespace details {
+
+/// @brief A subcircuit of a cut circuit, on qubits of its own. A wire cut
+/// ends the wire of a qubit in one fragment, where the qubit is measured in
+/// a Pauli basis, and continues it on a new qubit of another fragment,
+/// prepared in an eigenstate of that Pauli.
+struct cut_fragment {
+  std::size_t num_qubits = 0;
+  /// The gates, on the qubits of the fragment.
+  std::vector<circuit_gate> gates;
+  /// The cut index and fragment qubit of the incoming and the outgoing cuts.
+  std::vector<std::pair<std::size_t, std::size_t>> inputs, outputs;
+  /// The circuit qubit and fragment qubit of the wires that end here.
+  std::vector<std::pair<std::size_t, std::size_t>> finals;
+};
+
+/// @brief The fragments of a cut circuit.
+struct cut_plan {
+  std::vector<cut_fragment> fragments;
+  std::size_t num_cuts = 0;
+};
+
+/// @brief Cut the wires of `circuit` into fragments of at most `maxQubits`
+/// qubits, in one pass over the gates. A gate joins the fragment holding
+/// its qubits, the fragments of its qubits are merged if they fit together,
+/// and otherwise the wires of its qubits elsewhere are cut into the fragment
+/// holding most of them, or into a new one.
+inline cut_plan planWireCuts(const cut_circuit &circuit,
+                             std::size_t maxQubits) {
+  constexpr std::size_t none = -1;
+  struct segment {
+    std::size_t fragment, qubit;
+  };
+  std::vector<segment> segments;
+  std::vector<std::size_t> wires(circuit.num_qubits, none);
+  std::vector<cut_fragment> fragments;
+  std::vector<bool> alive;
+  std::size_t nCuts = 0;
+
+  auto newFragment = [&] {
+    fragments.emplace_back();
+    alive.push_back(true);
+    return fragments.size() - 1;
+  };
+  auto addQubit = [&](std::size_t q, std::size_t f) {
+    wires[q] = segments.size();
+    segments.push_back({f, fragments[f].num_qubits++});
+  };
+  // Move the gates and qubits of fragment `from` after those of `to`.
+  auto merge = [&](std::size_t to, std::size_t from) {
+    auto &src = fragments[from];
+    auto &dst = fragments[to];
+    const auto offset = dst.num_qubits;
+    for (auto &gate : src.gates) {
+      for (auto &q : gate.controls)
+        q += offset;
+      for (auto &q : gate.targets)
+        q += offset;
+      dst.gates.push_back(std::move(gate));
+    }
+    for (auto [cut, q] : src.inputs)
+      dst.inputs.emplace_back(cut, q + offset);
+    for (auto [cut, q] : src.outputs)
+      dst.outputs.emplace_back(cut, q + offset);
+    for (auto &s : segments)
+      if (s.fragment == from)
+        s = {to, s.qubit + offset};
+    dst.num_qubits += src.num_qubits;
+    src = cut_fragment();
+    alive[from] = false;
+  };
+
+  for (auto &gate : circuit.gates) {
+    std::vector<std::size_t> qubits(gate.controls);
+    qubits.insert(qubits.end(), gate.targets.begin(), gate.targets.end());
+    if (qubits.size() > maxQubits)
+      throw std::runtime_error("Cannot cut a gate on " +
+                               std::to_string(qubits.size()) +
+                               " qubits into fragments of " +
+                               std::to_string(maxQubits) + " qubits.");
+    std::vector<std::size_t> held;
+    std::size_t fresh = 0;
+    for (auto q : qubits) {
+      if (q >= circuit.num_qubits)
+        throw std::runtime_error("Invalid qubit " + std::to_string(q) +
+                                 " of a gate of the cut circuit.");
+      if (wires[q] == none)
+        fresh++;
+      else if (auto f = segments[wires[q]].fragment;
+               std::find(held.begin(), held.end(), f) == held.end())
+        held.push_back(f);
+    }
+
+    std::size_t width = fresh;
+    for (auto f : held)
+      width += fragments[f].num_qubits;
+    std::size_t target;
+    if (width <= maxQubits) {
+      target = held.empty() ? newFragment() : held.front();
+      for (std::size_t i = 1; i < held.size(); i++)
+        merge(target, held[i]);
+    } else {
+      // The fragment holding most of the qubits that still fits them all.
+      target = none;
+      std::size_t most = 0;
+      for (auto f : held) {
+        std::size_t inside = 0;
+        for (auto q : qubits)
+          inside += wires[q] != none && segments[wires[q]].fragment == f;
+        if (fragments[f].num_qubits + qubits.size() - inside <= maxQubits &&
+            inside > most) {
+          target = f;
+          most = inside;
+        }
+      }
+      if (target == none)
+        target = newFragment();
+      for (auto q : qubits)
+        if (wires[q] != none && segments[wires[q]].fragment != target) {
+          auto [from, local] = segments[wires[q]];
+          fragments[from].outputs.emplace_back(nCuts, local);
+          addQubit(q, target);
+          fragments[target].inputs.emplace_back(
+              nCuts++, segments[wires[q]].qubit);
+        }
+    }
+    for (auto q : qubits)
+      if (wires[q] == none)
+        addQubit(q, target);
+
+    auto local = [&](std::size_t q) { return segments[wires[q]].qubit; };
+    circuit_gate mapped{gate.name, gate.parameters, {}, {}};
+    for (auto q : gate.controls)
+      mapped.controls.push_back(local(q));
+    for (auto q : gate.targets)
+      mapped.targets.push_back(local(q));
+    fragments[target].gates.push_back(std::move(mapped));
+  }
+
+  for (std::size_t q = 0; q < circuit.num_qubits; q++)
+    if (wires[q] != none)
+      fragments[segments[wires[q]].fragment].finals.emplace_back(
+          q, segments[wires[q]].qubit);
+  cut_plan plan;
+  for (std::size_t f = 0; f < fragments.size(); f++)
+    if (alive[f])
+      plan.fragments.push_back(std::move(fragments[f]));
+  plan.num_cuts = nCuts;
+  return plan;
+}
+
+/// @brief Execute the gates of `fragment`, its incoming cut qubits first
+/// prepared in the eigenstates of the given codes (digits in base 6 of
+/// `preparation`, the first input least significant): |0>, |1>, |+>, |->,
+/// |+i> and |-i>.
+inline void executeFragment(const cut_fragment &fragment,
+                            std::size_t preparation) {
+  cudaq::qreg<> q(fragment.num_qubits);
+  auto *manager = getExecutionManager();
+  auto apply = [&](const char *name, std::size_t qubit) {
+    std::size_t target = q[qubit].id();
+    manager->apply(name, {}, {}, std::span<std::size_t>(&target, 1));
+  };
+  for (auto [cut, qubit] : fragment.inputs) {
+    const auto code = preparation % 6;
+    preparation /= 6;
+    if (code % 2)
+      apply("x", qubit);
+    if (code >= 2)
+      apply("h", qubit);
+    if (code >= 4)
+      apply("s", qubit);
+  }
+
+  std::vector<std::size_t> controls, targets;
+  for (auto &gate : fragment.gates) {
+    controls.clear();
+    targets.clear();
+    for (auto c : gate.controls)
+      controls.push_back(q[c].id());
+    for (auto t : gate.targets)
+      targets.push_back(q[t].id());
+    manager->apply(gate.name, std::vector<double>(gate.parameters), controls,
+                   targets);
+  }
+}
+
+inline std::size_t power(std::size_t base, std::size_t exponent) {
+  std::size_t result = 1;
+  while (exponent--)
+    result *= base;
+  return result;
+}
+
+/// @brief Return the expected value of `H` on a circuit of `nQubits` qubits
+/// cut as `plan`. The fragments are observed by `evaluate(jobs, words)`,
+/// which returns for every job, a fragment index and the preparation of its
+/// incoming cut qubits (see executeFragment()), the expectation values of
+/// the Pauli words of the fragment.
+template <typename Evaluate>
+double reconstructCutExpectation(const cut_plan &plan, std::size_t nQubits,
+                                 const spin_op &H, Evaluate &&evaluate) {
+  const auto nCuts = plan.num_cuts;
+  auto terms = H.terms();
+  std::vector<spin_op::term_view> termList(terms.begin(), terms.end());
+  const auto nTerms = termList.size();
+
+  // The Pauli words of each fragment: the terms of H on its final qubits
+  // times every Pauli of its outgoing cuts. wordOf[f][t * 4^outputs + out].
+  constexpr pauli paulis[] = {pauli::I, pauli::X, pauli::Y, pauli::Z};
+  const auto nFragments = plan.fragments.size();
+  std::vector<std::vector<spin_op>> words(nFragments);
+  std::vector<std::vector<std::size_t>> wordOf(nFragments);
+  for (std::size_t f = 0; f < nFragments; f++) {
+    auto &fragment = plan.fragments[f];
+    const auto nOut = power(4, fragment.outputs.size());
+    std::unordered_map<std::string, std::size_t> known;
+    for (auto &term : termList)
+      for (std::size_t out = 0; out < nOut; out++) {
+        std::vector<spin_op_builder::factor> factors;
+        std::string key(fragment.num_qubits, 'I');
+        for (auto [q, local] : fragment.finals)
+          if (auto p = q < term.n_qubits() ? term.get_pauli(q) : pauli::I;
+              p != pauli::I) {
+            factors.emplace_back(p, local);
+            key[local] = "IXYZ"[static_cast<int>(p)];
+          }
+        for (std::size_t j = 0; j < fragment.outputs.size(); j++)
+          if (auto digit = out >> 2 * j & 3) {
+            factors.emplace_back(paulis[digit], fragment.outputs[j].second);
+            key[fragment.outputs[j].second] = "IXYZ"[digit];
+          }
+        auto [iter, added] = known.emplace(key, words[f].size());
+        if (added) {
+          spin_op_builder builder;
+          builder.add(1.0, factors);
+          words[f].push_back(builder.build());
+        }
+        wordOf[f].push_back(iter->second);
+      }
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> jobs;
+  for (std::size_t f = 0; f < nFragments; f++)
+    for (std::size_t prep = 0;
+         prep < power(6, plan.fragments[f].inputs.size()); prep++)
+      jobs.emplace_back(f, prep);
+  std::vector<std::vector<double>> values = evaluate(jobs, words);
+
+  // The value of each fragment for each term and Paulis of its cuts,
+  // table[f][t][in * 4^outputs + out]: a Pauli of an incoming cut is the
+  // signed sum over the preparations of its two eigenstates.
+  std::vector<std::vector<std::vector<double>>> table(nFragments);
+  for (std::size_t f = 0, firstJob = 0; f < nFragments; f++) {
+    auto &fragment = plan.fragments[f];
+    const auto nIn = fragment.inputs.size();
+    const auto nOut = power(4, fragment.outputs.size());
+    table[f].assign(nTerms,
+                    std::vector<double>(power(4, nIn) * nOut, 0.0));
+    for (std::size_t in = 0; in < power(4, nIn); in++)
+      for (std::size_t signs = 0; signs < (1ULL << nIn); signs++) {
+        std::size_t prep = 0;
+        double weight = 1.0;
+        for (std::size_t j = nIn; j-- > 0;) {
+          const auto digit = in >> 2 * j & 3;
+          const auto sign = signs >> j & 1;
+          // I and Z: |0>, |1>; X: |+>, |->; Y: |+i>, |-i>.
+          prep = 6 * prep + (digit == 1 ? 2 : digit == 2 ? 4 : 0) + sign;
+          if (digit != 0 && sign)
+            weight = -weight;
+        }
+        auto &observed = values[firstJob + prep];
+        for (std::size_t t = 0; t < nTerms; t++)
+          for (std::size_t out = 0; out < nOut; out++)
+            table[f][t][in * nOut + out] +=
+                weight * observed[wordOf[f][t * nOut + out]];
+      }
+    firstJob += power(6, nIn);
+  }
+
+  // Sum over the Paulis of all cuts, a half per cut. The qubits without
+  // gates stay in |0>, the terms with X or Y on them vanish.
+  std::vector<bool> touched(nQubits, false);
+  for (auto &fragment : plan.fragments)
+    for (auto [q, local] : fragment.finals)
+      touched[q] = true;
+  double expectation = 0.0;
+  for (std::size_t t = 0; t < nTerms; t++) {
+    auto &term = termList[t];
+    bool vanishes = false;
+    for (std::size_t q = 0; q < term.n_qubits(); q++) {
+      auto p = term.get_pauli(q);
+      vanishes |= !touched[q] && (p == pauli::X || p == pauli::Y);
+    }
+    if (vanishes)
+      continue;
+    double sum = 0.0;
+    for (std::size_t cuts = 0; cuts < power(4, nCuts); cuts++) {
+      double product = 1.0;
+      for (std::size_t f = 0; f < nFragments && product != 0.0; f++) {
+        auto &fragment = plan.fragments[f];
+        std::size_t in = 0, out = 0;
+        for (std::size_t j = fragment.inputs.size(); j-- > 0;)
+          in = 4 * in + (cuts >> 2 * fragment.inputs[j].first & 3);
+        for (std::size_t j = fragment.outputs.size(); j-- > 0;)
+          out = 4 * out + (cuts >> 2 * fragment.outputs[j].first & 3);
+        const auto nOut = power(4, fragment.outputs.size());
+        product *= table[f][t][in * nOut + out];
+      }
+      sum += product;
+    }
+    expectation += term.get_coefficient().real() * sum /
+                   static_cast<double>(1ULL << nCuts);
+  }
+  return expectation;
+}
+
+} // namespace details
+
+///
+/// \brief Compute the expected value of \p H with respect to \p circuit by
+/// cutting its wires into fragments that fit the simulator, each simulated
+/// in several variants, and recombining their expectation values.
+///
+/// \param circuit The circuit, too wide to simulate at once.
+/// \param H The hermitian cudaq::spin_op to compute the expected value for.
+/// \param options The most qubits of a fragment and the most cuts.
+/// \returns The expected value <circuit|H|circuit>.
+///
+/// \details A cut wire carries the identity channel, the sum over the Paulis
+///          P of Tr(rho P) P / 2. The fragment before the cut observes P on
+///          the cut qubit, the fragment after it is prepared in the
+///          eigenstates of P. Every fragment is simulated once for each
+///          preparation of its incoming cut qubits, observing at once all
+///          the Pauli words it contributes to the terms of H. These
+///          simulations are independent, they are spread over the QPUs of
+///          the platform, and the expectation values are recombined by
+///          summing over the Paulis of all cuts. Circuits whose entangling
+///          gates are mostly local to blocks of qubits need few cuts.
+///
+/// Usage:
+/// \code{.cpp}
+/// cudaq::cut_circuit circuit{40, {}};
+/// for (std::size_t q = 0; q < 40; q++)
+///   circuit.gates.push_back({"h", {}, {}, {q}});
+/// for (std::size_t q = 0; q + 1 < 40; q++)
+///   circuit.gates.push_back({"z", {}, {q}, {q + 1}});
+/// cudaq::cut_options options{.max_fragment_qubits = 20};
+/// double energy = cudaq::observe_cut(circuit, H, options);
+/// \endcode
+///
+inline double observe_cut(const cut_circuit &circuit, const spin_op &H,
+                          const cut_options &options = {}) {
+  if (H.n_qubits() > circuit.num_qubits)
+    throw std::runtime_error("Cannot observe a spin_op on " +
+                             std::to_string(H.n_qubits()) +
+                             " qubits of a circuit of " +
+                             std::to_string(circuit.num_qubits) + " qubits.");
+  auto plan = details::planWireCuts(circuit, options.max_fragment_qubits);
+  if (plan.num_cuts > options.max_cuts)
+    throw std::runtime_error(
+        "The circuit needs " + std::to_string(plan.num_cuts) +
+        " wire cuts, more than the " + std::to_string(options.max_cuts) +
+        " allowed.");
+
+  // Observe the words of every fragment for every preparation of its
+  // incoming cut qubits, spread over the local QPUs.
+  auto &platform = cudaq::get_platform();
+  auto evaluate = [&](const std::vector<std::pair<std::size_t, std::size_t>>
+                          &jobs,
+                      const std::vector<std::vector<spin_op>> &words) {
+    std::vector<std::vector<double>> values(jobs.size());
+    auto runJob = [&](std::size_t j, std::size_t qpu) {
+      auto [f, prep] = jobs[j];
+      auto observables = words[f];
+      auto results = details::runMultiObservation(
+          [&, f = f, prep = prep]() {
+            details::executeFragment(plan.fragments[f], prep);
+          },
+          observables, platform, -1, qpu);
+      for (auto &result : results)
+        values[j].push_back(result.exp_val_z());
+    };
+    std::vector<std::size_t> qpus;
+    for (std::size_t qpu = 0; qpu < platform.num_qpus(); qpu++)
+      if (!platform.is_remote(qpu))
+        qpus.push_back(qpu);
+    if (qpus.size() < 2 || jobs.size() < 2) {
+      for (std::size_t j = 0; j < jobs.size(); j++)
+        runJob(j, 0);
+      return values;
+    }
+    std::vector<UnplacedTask> tasks;
+    for (std::size_t j = 0; j < jobs.size(); j++)
+      tasks.emplace_back([&, j](std::size_t qpu) {
+        runJob(j, qpu);
+        return sample_result();
+      });
+    auto stream = platform.enqueueUnplacedTasks(std::move(tasks), qpus);
+    while (stream.next())
+      ;
+    return values;
+  };
+  return details::reconstructCutExpectation(plan, circuit.num_qubits, H,
+                                            evaluate);
+}
+
+} // namespace cudaq
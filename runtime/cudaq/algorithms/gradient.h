@@ -43,6 +43,21 @@ protected:
     return cudaq::observe(ansatz_functor, h, x);
   }
 
+  // Given the parameter sets xs and the spin_op h, compute the expected
+  // value at each of them with respect to the ansatz. They are observed as
+  // one broadcast, split amongst the QPUs of the platform and simulated at
+  // once by batching backends.
+  std::vector<double>
+  getExpectedValues(const std::vector<std::vector<double>> &xs, spin_op h) {
+    std::vector<std::tuple<std::vector<double>>> argumentSets(xs.begin(),
+                                                              xs.end());
+    std::vector<double> values;
+    values.reserve(xs.size());
+    for (auto &result : cudaq::observe(ansatz_functor, h, argumentSets))
+      values.push_back(result.exp_val_z());
+    return values;
+  }
+
 public:
   /// Constructor, takes the quantum kernel with prescribed signature
   gradient(std::function<void(std::vector<double>)> &&kernel)
@@ -84,6 +99,12 @@ public:
     };
   }
 
+  /// Set the parameterized ansatz, e.g. of a gradient strategy constructed
+  /// without one. An empty function unsets it.
+  void set_ansatz(std::function<void(std::vector<double>)> kernel) {
+    ansatz_functor = std::move(kernel);
+  }
+
   /// Compute the current iterations gradient vector and update the
   /// provided vector<double reference (dx).
   virtual void compute(const std::vector<double> &x, std::vector<double> &dx,
@@ -0,0 +1,88 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "cudaq/algorithms/gradient.h"
+
+namespace cudaq::gradients {
+/// @brief Adjoint differentiation on state vector simulators. One execution
+/// of the ansatz and one backward sweep over its gates yield the derivative
+/// with respect to every gate angle, whatever the number of parameters. The
+/// ansatz parameters are mapped to the gate angles by central differences of
+/// the angles, recorded without simulating the gates, which is exact for
+/// angles linear in the parameters.
+class adjoint : public gradient {
+  /// @brief Execute the ansatz at `x` under the given context.
+  void execute(ExecutionContext &context, const std::vector<double> &x) {
+    auto &platform = cudaq::get_platform();
+    platform.set_exec_ctx(&context);
+    ansatz_functor(x);
+    platform.reset_exec_ctx();
+  }
+
+  /// @brief Return the gate angles of the ansatz at `x`.
+  std::vector<double> getGateParameters(const std::vector<double> &x) {
+    ExecutionContext context("record-gates");
+    execute(context, x);
+    return std::move(context.gateParameters);
+  }
+
+public:
+  using gradient::gradient;
+  double step = 1e-4;
+
+  void compute(const std::vector<double> &x, std::vector<double> &dx,
+               spin_op &h, double exp_h) override {
+    ExecutionContext context("adjoint-gradient");
+    context.spin = &h;
+    execute(context, x);
+    if (!context.expectationValue)
+      throw std::runtime_error(
+          "The adjoint gradient requires a state vector simulator and a "
+          "noiseless ansatz without measurements, resets or u2 / u3 gates.");
+
+    // dE/dx_i is the sum over the gate angles of dE/dangle dangle/dx_i.
+    const auto &angleGradient = context.gateParameterGradient;
+    auto shifted = x;
+    for (std::size_t i = 0; i < x.size(); i++) {
+      shifted[i] = x[i] + step;
+      auto plus = getGateParameters(shifted);
+      shifted[i] = x[i] - step;
+      auto minus = getGateParameters(shifted);
+      shifted[i] = x[i];
+      if (plus.size() != angleGradient.size() ||
+          minus.size() != angleGradient.size())
+        throw std::runtime_error("The adjoint gradient requires an ansatz "
+                                 "whose gates do not depend on its "
+                                 "parameters, only their angles.");
+      dx[i] = 0.0;
+      for (std::size_t j = 0; j < angleGradient.size(); j++)
+        dx[i] += angleGradient[j] * (plus[j] - minus[j]) / (2. * step);
+    }
+  }
+
+  /// @brief An arbitrary function, `func`, has no gates to differentiate,
+  /// its gradient is computed with central differences.
+  std::vector<double>
+  compute(const std::vector<double> &x,
+          std::function<double(std::vector<double>)> &func) override {
+    std::vector<double> dx(x.size());
+    auto tmpX = x;
+    for (std::size_t i = 0; i < x.size(); i++) {
+      tmpX[i] = x[i] + step;
+      double px = func(tmpX);
+      tmpX[i] = x[i] - step;
+      double mx = func(tmpX);
+      tmpX[i] = x[i];
+      dx[i] = (px - mx) / (2. * step);
+    }
+    return dx;
+  }
+};
+} // namespace cudaq::gradients
@@ -10,12 +10,30 @@
 
 #include <cudaq/spin_op.h>
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 #include "common/ExecutionContext.h"
+#include "common/KernelCacheKey.h"
 #include "common/ObserveResult.h"
+#include "common/ZeroNoiseExtrapolation.h"
 #include "cudaq/concepts.h"
 #include "cudaq/platform.h"
 #include "cudaq/platform/quantum_platform.h"
@@ -25,6 +43,16 @@ namespace cudaq {
 /// @brief Return type for asynchronous observation.
 using async_observe_result = async_result<observe_result>;
 
+/// @brief The shots of an adaptive observe, see observe(shot_budget, ...).
+struct shot_budget {
+  /// @brief The total number of shots, over all terms and rounds.
+  std::size_t shots = 0;
+
+  /// @brief The number of rounds the shots are spent in. The rounds after
+  /// the first allocate their shots by the variances estimated so far.
+  std::size_t rounds = 4;
+};
+
 /// @brief Define a combined sample function validation concept.
 /// These concepts provide much better error messages than old-school SFINAE
 template <typename QuantumKernel, typename... Args>
@@ -34,15 +62,49 @@ concept ObserveCallValid =
 
 namespace details {
 
+/// @brief Return the observe_result for `h` from the data left in the
+/// observe ExecutionContext after the kernel execution.
+inline observe_result extractObserveResult(ExecutionContext &ctx,
+                                           spin_op &h) {
+  // Extract the results
+  sample_result data = std::move(ctx.result);
+  data.set_counters(ctx.counters);
+  double expectationValue;
+
+  // It is possible for the expectation value to be
+  // pre computed, if so grab it and set it so the client gets it
+  if (ctx.expectationValue.has_value())
+    expectationValue = ctx.expectationValue.value_or(0.0);
+  else {
+    // If not, we have everything we need to compute it.
+    double sum = 0.0;
+    for (auto term : h.terms()) {
+      if (term.is_identity())
+        sum += term.get_coefficient().real();
+      else
+        sum += data.exp_val_z(term.to_string(false)) *
+               term.get_coefficient().real();
+    }
+    expectationValue = sum;
+  }
+
+  return observe_result(expectationValue, h, std::move(data),
+                        std::move(ctx.shotCovariances));
+}
+
 /// @brief Take the input KernelFunctor (a lambda that captures runtime args and
-/// invokes the quantum kernel) and invoke the spin_op observation process.
+/// invokes the quantum kernel) and invoke the spin_op observation process,
+/// with the noise of the kernel scaled by `foldScale` (see
+/// ExecutionContext::foldScale).
 template <typename KernelFunctor>
 std::optional<observe_result>
 runObservation(KernelFunctor &&k, cudaq::spin_op &h, quantum_platform &platform,
                int shots, std::size_t qpu_id = 0,
-               details::future *futureResult = nullptr) {
+               details::future *futureResult = nullptr,
+               std::size_t foldScale = 1) {
   auto ctx = std::make_unique<ExecutionContext>("observe", shots);
   ctx->spin = &h;
+  ctx->foldScale = foldScale;
   if (shots > 0)
     ctx->shots = shots;
 
@@ -62,31 +124,253 @@ runObservation(KernelFunctor &&k, cudaq::spin_op &h, quantum_platform &platform,
   }
 
   platform.reset_exec_ctx(qpu_id);
+  return extractObserveResult(*ctx, h);
+}
 
-  // Extract the results
-  sample_result data;
-  double expectationValue;
-  data = ctx->result;
+/// @brief Take the input KernelFunctor (a lambda that invokes the quantum
+/// kernel with the arguments of the given batch index) and observe `h` for
+/// each of the batchSize kernel executions on the QPU `qpu_id`. Backends
+/// that support it simulate all executions of the batch at once, for exact
+/// expectation values only: with shots, the context has no batchSize and
+/// every execution is sampled on its own.
+template <typename KernelFunctor>
+std::vector<observe_result>
+runObservationBatch(KernelFunctor &&k, std::size_t batchSize, spin_op &h,
+                    quantum_platform &platform, int shots,
+                    std::size_t qpu_id) {
+  auto ctx = std::make_unique<ExecutionContext>("observe", shots);
+  ctx->spin = &h;
+  if (shots > 0)
+    ctx->shots = shots;
+  else
+    ctx->batchSize = batchSize;
 
-  // It is possible for the expectation value to be
-  // pre computed, if so grab it and set it so the client gets it
-  if (ctx->expectationValue.has_value())
-    expectationValue = ctx->expectationValue.value_or(0.0);
-  else {
-    // If not, we have everything we need to compute it.
-    double sum = 0.0;
-    for (std::size_t i = 0; i < h.n_terms(); i++) {
-      auto term = h[i];
-      if (term.is_identity())
-        sum += term.get_coefficients()[0].real();
-      else
-        sum += data.exp_val_z(term.to_string(false)) *
-               term.get_coefficients()[0].real();
+  platform.set_current_qpu(qpu_id);
+  std::vector<observe_result> results;
+  for (std::size_t i = 0; i < batchSize; i++) {
+    ctx->batchIndex = i;
+    ctx->result = sample_result();
+    ctx->counters = execution_counters();
+    ctx->expectationValue = std::nullopt;
+    platform.set_exec_ctx(ctx.get(), qpu_id);
+    k(i);
+    platform.reset_exec_ctx(qpu_id);
+    results.push_back(extractObserveResult(*ctx, h));
+  }
+
+  // The per execution results above are placeholders if the backend
+  // observed the whole batch at the last execution.
+  if (ctx->batchResults.size() == batchSize)
+    for (std::size_t i = 0; i < batchSize; i++)
+      results[i] = observe_result(
+          ctx->batchResults[i].expectationValue.value_or(0.0), h,
+          sample_result(ctx->batchResults[i]));
+  return results;
+}
+
+/// @brief Take the input KernelFunctor (a lambda that captures runtime args and
+/// invokes the quantum kernel) and observe each of the `observables` on the
+/// state of a single kernel execution on the QPU `qpu_id`. The union of their
+/// terms is observed, with the expectation value of every term in the
+/// result, and each observable then sums its own terms.
+template <typename KernelFunctor>
+std::vector<observe_result>
+runMultiObservation(KernelFunctor &&k, std::vector<spin_op> &observables,
+                    quantum_platform &platform, int shots,
+                    std::size_t qpu_id = 0) {
+  if (observables.empty())
+    return {};
+
+  // The terms of the union have unit coefficients, so none cancel out. A
+  // term is identified by its Paulis up to its last non-identity one, its
+  // name depends on the width of its spin_op.
+  auto termKey = [](const spin_op::term_view &term) {
+    std::string key;
+    for (std::size_t q = 0; q < term.n_qubits(); q++) {
+      auto p = term.get_pauli(q);
+      key += p == pauli::X   ? 'X'
+             : p == pauli::Y ? 'Y'
+             : p == pauli::Z ? 'Z'
+                             : 'I';
     }
-    expectationValue = sum;
+    return key.substr(0, key.find_last_not_of('I') + 1);
+  };
+  spin_op_builder builder;
+  for (auto &op : observables)
+    for (auto term : op.terms()) {
+      std::vector<spin_op_builder::factor> factors;
+      for (std::size_t q = 0; q < term.n_qubits(); q++)
+        if (auto p = term.get_pauli(q); p != pauli::I)
+          factors.emplace_back(p, q);
+      builder.add(1.0, factors);
+    }
+  auto H = builder.build();
+
+  auto ctx = std::make_unique<ExecutionContext>("observe", shots);
+  ctx->spin = &H;
+  ctx->termExpectations = true;
+  if (shots > 0)
+    ctx->shots = shots;
+  platform.set_current_qpu(qpu_id);
+  platform.set_exec_ctx(ctx.get(), qpu_id);
+  k();
+  platform.reset_exec_ctx(qpu_id);
+
+  std::unordered_map<std::string, ExecutionResult> termResults;
+  for (auto term : H.terms())
+    if (!term.is_identity())
+      termResults.emplace(
+          termKey(term), ctx->result.extract_register(term.to_string(false)));
+
+  std::vector<observe_result> results;
+  for (auto &op : observables) {
+    double expectation = 0.0;
+    std::vector<ExecutionResult> measured;
+    std::unordered_map<std::string, std::string> names;
+    for (auto term : op.terms()) {
+      const double coefficient = term.get_coefficient().real();
+      if (term.is_identity()) {
+        expectation += coefficient;
+        continue;
+      }
+      auto iter = termResults.find(termKey(term));
+      if (iter == termResults.end())
+        continue;
+      auto &result = measured.emplace_back(iter->second);
+      names.emplace(result.registerName, term.to_string(false));
+      result.registerName = term.to_string(false);
+      expectation += coefficient * result.expectationValue.value_or(0.0);
+    }
+    std::vector<shot_covariance> covariances;
+    for (auto &covariance : ctx->shotCovariances) {
+      auto a = names.find(covariance.first);
+      auto b = names.find(covariance.second);
+      if (a != names.end() && b != names.end())
+        covariances.push_back({a->second, b->second, covariance.covariance});
+    }
+    if (measured.empty())
+      measured.emplace_back(expectation);
+    sample_result data(expectation, std::move(measured));
+    data.set_counters(ctx->counters);
+    results.emplace_back(expectation, op, std::move(data),
+                         std::move(covariances));
+  }
+  return results;
+}
+
+/// @brief Take the input KernelFunctor (a lambda that captures runtime args and
+/// invokes the quantum kernel) and observe `H` within the shot budget. Each
+/// qubit-wise commuting group of `H` is observed on its own, with the shots
+/// of each round split amongst the groups so that the total shots of group g
+/// approach the budget spent so far times sigma_g / sum(sigma), where
+/// sigma_g^2 is the per shot variance of the weighted sum of its terms. This
+/// allocation minimizes the variance of the expectation value. The first
+/// round assumes the worst case sigma_g^2 = sum(c_i^2) of the group.
+template <typename KernelFunctor>
+observe_result runAdaptiveObservation(KernelFunctor &&k, spin_op &H,
+                                      quantum_platform &platform,
+                                      const shot_budget &budget) {
+  double identity = 0.0;
+  for (auto term : H.terms())
+    if (term.is_identity())
+      identity += term.get_coefficient().real();
+
+  // The sub spin_op of each group and its worst case standard deviation.
+  std::vector<spin_op> groups;
+  std::vector<double> worstCase;
+  for (auto &terms : H.get_qubit_wise_commuting_groups()) {
+    spin_op group = H[terms.front()];
+    double norm = 0.0;
+    for (std::size_t i = 0; i < terms.size(); i++) {
+      if (i > 0)
+        group += H[terms[i]];
+      const double c = H.get_term_coefficient(terms[i]).real();
+      norm += c * c;
+    }
+    groups.push_back(std::move(group));
+    worstCase.push_back(std::sqrt(norm));
   }
+  const std::size_t nGroups = groups.size();
+  if (nGroups == 0)
+    return observe_result(identity, H);
+  if (budget.rounds == 0 || budget.shots / budget.rounds < nGroups)
+    throw std::runtime_error(
+        "A shot budget of " + std::to_string(budget.shots) + " shots in " +
+        std::to_string(budget.rounds) + " rounds cannot measure the " +
+        std::to_string(nGroups) + " commuting groups of the spin_op.");
+
+  std::vector<sample_result> data(nGroups);
+  std::vector<std::size_t> groupShots(nGroups, 0);
+  std::vector<double> shotVariances(nGroups, 0.0);
+  // The per shot covariances of each group, summed weighted by the shots of
+  // the round that estimated them.
+  std::vector<std::map<std::pair<std::string, std::string>, double>>
+      covarianceSums(nGroups);
+  auto groupCovariances = [&](std::size_t g) {
+    std::vector<shot_covariance> covariances;
+    for (auto &[names, sum] : covarianceSums[g])
+      covariances.push_back({names.first, names.second, sum / groupShots[g]});
+    return covariances;
+  };
 
-  return observe_result(expectationValue, h, data);
+  std::size_t spent = 0;
+  for (std::size_t round = 0; round < budget.rounds; round++) {
+    const std::size_t roundShots =
+        (budget.shots - spent) / (budget.rounds - round);
+    std::vector<std::size_t> shots;
+    if (round == 0) {
+      // At least one shot per group, so that each has an estimate.
+      shots = details::apportionShots(roundShots - nGroups, worstCase);
+      for (auto &s : shots)
+        s++;
+    } else {
+      // The shots each group lacks from its share of the budget spent after
+      // this round. A group that came out deterministic keeps the variance
+      // of one more worst case shot, so that few early shots do not starve
+      // it.
+      std::vector<double> sigma(nGroups), lacking(nGroups);
+      double total = 0.0;
+      for (std::size_t g = 0; g < nGroups; g++) {
+        sigma[g] = std::sqrt(shotVariances[g] + worstCase[g] * worstCase[g] /
+                                                    (groupShots[g] + 1));
+        total += sigma[g];
+      }
+      for (std::size_t g = 0; g < nGroups; g++)
+        lacking[g] = std::max((spent + roundShots) * sigma[g] / total -
+                                  double(groupShots[g]),
+                              0.0);
+      shots = details::apportionShots(roundShots, lacking);
+    }
+
+    for (std::size_t g = 0; g < nGroups; g++) {
+      if (shots[g] == 0)
+        continue;
+      auto result =
+          runObservation(k, groups[g], platform, shots[g]).value();
+      for (auto &c : result.shot_covariances())
+        covarianceSums[g][{c.first, c.second}] += c.covariance * shots[g];
+      auto counts = result.raw_data();
+      data[g] += counts;
+      groupShots[g] += shots[g];
+      spent += shots[g];
+      shotVariances[g] = observe_result(0.0, groups[g], data[g],
+                                        groupCovariances(g))
+                             .variance() *
+                         groupShots[g];
+    }
+  }
+
+  double expectation = identity;
+  std::vector<shot_covariance> covariances;
+  for (std::size_t g = 0; g < nGroups; g++) {
+    for (auto term : groups[g].terms())
+      expectation += data[g].exp_val_z(term.to_string(false)) *
+                     term.get_coefficient().real();
+    auto groupCov = groupCovariances(g);
+    covariances.insert(covariances.end(), groupCov.begin(), groupCov.end());
+  }
+  return observe_result(expectation, H, sample_result::merge(data),
+                        std::move(covariances));
 }
 
 /// @brief Take the input KernelFunctor (a lambda that captures runtime args and
@@ -95,7 +379,7 @@ runObservation(KernelFunctor &&k, cudaq::spin_op &h, quantum_platform &platform,
 template <typename KernelFunctor>
 auto runObservationAsync(KernelFunctor &&wrappedKernel, spin_op &H,
                          quantum_platform &platform, int shots,
-                         std::size_t qpu_id = 0) {
+                         std::size_t qpu_id = 0, std::size_t foldScale = 1) {
 
   if (qpu_id >= platform.num_qpus()) {
     throw std::invalid_argument(
@@ -110,64 +394,482 @@ auto runObservationAsync(KernelFunctor &&wrappedKernel, spin_op &H,
     // type. Just return that wrapped in an async_result
     details::future futureResult;
     details::runObservation(std::forward<KernelFunctor>(wrappedKernel), H,
-                            platform, shots, qpu_id, &futureResult);
+                            platform, shots, qpu_id, &futureResult,
+                            foldScale);
     return async_observe_result(std::move(futureResult), &H);
   }
 
   // If the platform is not remote, then we can handle async execution via
   // a new worker thread.
   KernelExecutionTask task(
-      [&, qpu_id, shots,
+      [&, qpu_id, shots, foldScale,
        kernel = std::forward<KernelFunctor>(wrappedKernel)]() mutable {
-        return details::runObservation(kernel, H, platform, shots, qpu_id)
+        return details::runObservation(kernel, H, platform, shots, qpu_id,
+                                       nullptr, foldScale)
             .value()
             .raw_data();
       });
 
+  auto completion = std::make_shared<details::completion_signal>();
   return async_observe_result(
-      details::future(platform.enqueueAsyncTask(qpu_id, task)), &H);
+      details::future(platform.enqueueAsyncTask(qpu_id, task, {}, completion),
+                      completion),
+      &H);
+}
+
+/// @brief Take the input KernelFunctor (a lambda that captures runtime args and
+/// invokes the quantum kernel) and observe `H` at each noise scale of
+/// `options`, then extrapolate its expectation value to zero noise. The
+/// scaled observations are all launched before any is waited for, round
+/// robin over the QPUs of the platform, so that a remote QPU receives them
+/// as one batch of jobs rather than one after the other. Exponential
+/// extrapolation decays to the constant terms of `H`.
+template <typename KernelFunctor>
+zne_result runZneObservation(KernelFunctor &&k, spin_op &H,
+                             quantum_platform &platform, int shots,
+                             const zne_options &options) {
+  if (options.scales.size() < 2)
+    throw std::runtime_error(
+        "Zero-noise extrapolation requires at least two noise scales.");
+  for (auto scale : options.scales)
+    if (scale % 2 == 0)
+      throw std::runtime_error("Zero-noise extrapolation requires odd noise "
+                               "scales, not " +
+                               std::to_string(scale) + ".");
+
+  std::vector<async_observe_result> pending;
+  for (std::size_t i = 0; i < options.scales.size(); i++)
+    pending.emplace_back(runObservationAsync(
+        k, H, platform, shots, i % platform.num_qpus(), options.scales[i]));
+
+  zne_result result;
+  result.scales = options.scales;
+  std::vector<double> scales, values;
+  for (std::size_t i = 0; i < pending.size(); i++) {
+    auto observed = pending[i].get();
+    scales.push_back(options.scales[i]);
+    values.push_back(observed.exp_val_z());
+    result.results.push_back(std::move(observed));
+  }
+
+  double identity = 0.0;
+  for (auto term : H.terms())
+    if (term.is_identity())
+      identity += term.get_coefficient().real();
+  result.expectation = extrapolate_to_zero_noise(
+      scales, values, options.extrapolation, identity);
+  return result;
+}
+
+/// @brief Take the input KernelFunctor (a lambda that invokes the quantum
+/// kernel with the arguments of the given index) and observe `h` for each of
+/// the n kernel executions on the QPUs of this process, returning the
+/// results in order. On a platform with more than one QPU the executions are
+/// split into contiguous chunks, one per QPU, each observed as a batch on a
+/// worker thread of its QPU. Remote QPUs cannot run batches on worker
+/// threads, their executions are dispatched one by one instead.
+template <typename KernelFunctor>
+std::vector<observe_result>
+runLocalObservationBroadcast(KernelFunctor &&k, std::size_t n, spin_op &h,
+                             quantum_platform &platform, int shots) {
+  const auto nQpus = std::min(platform.num_qpus(), n);
+  if (nQpus < 2)
+    return runObservationBatch(k, n, h, platform, shots,
+                               platform.get_current_qpu());
+
+  const auto chunkSize = n / nQpus + (n % nQpus != 0);
+  std::vector<std::vector<observe_result>> chunkResults(nQpus);
+  std::vector<std::future<sample_result>> chunksDone;
+  std::vector<async_observe_result> remoteResults;
+  std::vector<std::size_t> remoteIndices;
+  for (std::size_t qpu = 0; qpu < nQpus; qpu++) {
+    const auto begin = std::min(qpu * chunkSize, n);
+    const auto end = std::min(begin + chunkSize, n);
+    if (platform.is_remote(qpu)) {
+      for (auto i = begin; i < end; i++) {
+        remoteResults.emplace_back(runObservationAsync(
+            [&k, i]() mutable { k(i); }, h, platform, shots, qpu));
+        remoteIndices.push_back(i);
+      }
+      continue;
+    }
+    KernelExecutionTask task([&, qpu, begin, end]() {
+      chunkResults[qpu] = runObservationBatch(
+          [&k, begin](std::size_t i) { k(begin + i); }, end - begin, h,
+          platform, shots, qpu);
+      return sample_result();
+    });
+    chunksDone.emplace_back(platform.enqueueAsyncTask(qpu, task));
+  }
+  for (auto &done : chunksDone)
+    done.wait();
+
+  std::vector<std::optional<observe_result>> results(n);
+  for (std::size_t qpu = 0; qpu < nQpus; qpu++)
+    for (std::size_t i = 0; i < chunkResults[qpu].size(); i++)
+      results[qpu * chunkSize + i] = std::move(chunkResults[qpu][i]);
+  for (std::size_t r = 0; r < remoteResults.size(); r++)
+    results[remoteIndices[r]] = remoteResults[r].get();
+
+  std::vector<observe_result> ordered;
+  ordered.reserve(n);
+  for (auto &result : results)
+    ordered.emplace_back(std::move(result).value());
+  return ordered;
+}
+
+/// @brief Observe `h` for each of the n kernel executions, see
+/// runLocalObservationBroadcast(). On a platform spanning several processes
+/// each process observes a contiguous share of the executions and the
+/// expectation values are exchanged. The results of the other processes
+/// only hold their expectation values, not their raw data.
+template <typename KernelFunctor>
+std::vector<observe_result>
+runObservationBroadcast(KernelFunctor &&k, std::size_t n, spin_op &h,
+                        quantum_platform &platform, int shots) {
+  const auto nRanks = platform.num_ranks();
+  if (nRanks < 2)
+    return runLocalObservationBroadcast(k, n, h, platform, shots);
+
+  const auto chunkSize = n / nRanks + (n % nRanks != 0);
+  const auto begin = std::min(platform.rank() * chunkSize, n);
+  const auto end = std::min(begin + chunkSize, n);
+  std::vector<observe_result> local;
+  if (begin < end)
+    local = runLocalObservationBroadcast(
+        [&k, begin](std::size_t i) mutable { k(begin + i); }, end - begin, h,
+        platform, shots);
+  std::vector<double> values(n, 0.0);
+  for (std::size_t i = 0; i < local.size(); i++)
+    values[begin + i] = local[i].exp_val_z();
+  platform.all_reduce_sum(values);
+
+  std::vector<observe_result> results;
+  results.reserve(n);
+  for (std::size_t i = 0; i < n; i++)
+    if (i >= begin && i < end)
+      results.emplace_back(std::move(local[i - begin]));
+    else
+      results.emplace_back(values[i], h);
+  return results;
+}
+
+/// @brief The throughput, in estimated term cost per second, that each QPU
+/// achieved on past distributed observations. Unmeasured QPUs are assumed
+/// as fast as the average measured one.
+class qpu_throughput_history {
+  std::mutex mutex;
+  std::vector<double> throughputs;
+
+public:
+  /// @brief Return the relative speed of each of the nQpus QPUs.
+  std::vector<double> get(std::size_t nQpus) {
+    std::lock_guard lock(mutex);
+    std::vector<double> speeds(nQpus, 0.0);
+    double sum = 0.0;
+    std::size_t measured = 0;
+    for (std::size_t i = 0; i < std::min(nQpus, throughputs.size()); i++)
+      if (throughputs[i] > 0.0) {
+        speeds[i] = throughputs[i];
+        sum += throughputs[i];
+        measured++;
+      }
+    for (auto &speed : speeds)
+      if (speed == 0.0)
+        speed = measured ? sum / measured : 1.0;
+    return speeds;
+  }
+
+  /// @brief Record the throughput of a QPU, averaged with the past ones.
+  void update(std::size_t qpu, double throughput) {
+    std::lock_guard lock(mutex);
+    if (qpu >= throughputs.size())
+      throughputs.resize(qpu + 1, 0.0);
+    auto &average = throughputs[qpu];
+    average = average > 0.0 ? 0.75 * average + 0.25 * throughput : throughput;
+  }
+};
+
+inline qpu_throughput_history &getQpuThroughputHistory() {
+  static qpu_throughput_history history;
+  return history;
+}
+
+/// @brief A bounded, least recently used cache of exact observe results,
+/// see set_observe_cache_capacity(). The keys are the bytes of the kernel
+/// identity, its arguments and the spin_op, compared in full.
+class observe_cache {
+  std::mutex mutex;
+  std::size_t capacity = 0;
+  std::size_t hitCount = 0;
+  /// The entries, most recently used first.
+  std::list<std::pair<std::string, observe_result>> entries;
+  std::unordered_map<std::string_view, decltype(entries)::iterator> index;
+
+public:
+  bool enabled() {
+    std::lock_guard lock(mutex);
+    return capacity > 0;
+  }
+
+  /// @brief Set the maximum number of entries, evicting the least recently
+  /// used ones beyond it. Zero disables and empties the cache.
+  void set_capacity(std::size_t newCapacity) {
+    std::lock_guard lock(mutex);
+    capacity = newCapacity;
+    while (entries.size() > capacity) {
+      index.erase(entries.back().first);
+      entries.pop_back();
+    }
+  }
+
+  void clear() {
+    std::lock_guard lock(mutex);
+    index.clear();
+    entries.clear();
+    hitCount = 0;
+  }
+
+  /// @brief The number of lookups answered from the cache since the last
+  /// clear().
+  std::size_t hits() {
+    std::lock_guard lock(mutex);
+    return hitCount;
+  }
+
+  std::optional<observe_result> find(const std::string &key) {
+    std::lock_guard lock(mutex);
+    auto iter = index.find(key);
+    if (iter == index.end())
+      return std::nullopt;
+    entries.splice(entries.begin(), entries, iter->second);
+    hitCount++;
+    return iter->second->second;
+  }
+
+  void insert(std::string key, const observe_result &result) {
+    std::lock_guard lock(mutex);
+    if (capacity == 0 || index.count(key))
+      return;
+    entries.emplace_front(std::move(key), result);
+    index.emplace(entries.front().first, entries.begin());
+    if (entries.size() > capacity) {
+      index.erase(entries.back().first);
+      entries.pop_back();
+    }
+  }
+};
+
+inline observe_cache &getObserveCache() {
+  static observe_cache cache;
+  return cache;
+}
+
+/// @brief Append the packed terms and coefficients of H to an observe cache
+/// key.
+inline void appendSpinOpBytes(std::string &key, const spin_op &H) {
+  const auto nTerms = H.n_terms();
+  const auto nWords = H.n_words();
+  appendCacheKeyBytes(key, nTerms);
+  appendCacheKeyBytes(key, nWords);
+  for (std::size_t t = 0; t < nTerms; t++) {
+    key.append(reinterpret_cast<const char *>(H.get_term_data(t)),
+               2 * nWords * sizeof(std::uint64_t));
+    appendCacheKeyBytes(key, H.get_term(t).get_coefficient());
+  }
+}
+
+/// @brief Return the observe cache key of kernel(args...) and H, or an
+/// empty string if the kernel cannot be cached: an argument cannot be
+/// compared by its bytes (see makeKernelCacheKey()), or QPU 0 is remote or
+/// noisy, so that its results depend on more than the key.
+template <typename QuantumKernel, typename... Args>
+std::string makeObserveCacheKey(quantum_platform &platform,
+                                const QuantumKernel &kernel, const spin_op &H,
+                                const Args &...args) {
+  if (platform.is_remote(0) || platform.get_noise(0))
+    return {};
+  auto key = makeKernelCacheKey(kernel, args...);
+  if (!key.empty())
+    appendSpinOpBytes(key, H);
+  return key;
+}
+
+/// @brief Partition the terms of H amongst QPUs of the given relative
+/// speeds, balancing their estimated completion times. Each group of
+/// qubit-wise commuting terms stays on one QPU, since its terms share the
+/// executions of a shot-based observation, and costs one execution plus,
+/// per term, one expectation value over the term's qubits. Groups are placed
+/// from the costliest on the QPU that would complete them first. Identity
+/// terms cost nothing. Returns the term indices of each QPU, and its cost.
+inline std::pair<std::vector<std::vector<std::size_t>>, std::vector<double>>
+partitionTermsByCost(const spin_op &H, const std::vector<double> &speeds) {
+  const auto nQpus = speeds.size();
+  const auto nWords = H.n_words();
+  const double nQubits = std::max<std::size_t>(H.n_qubits(), 1);
+  auto groups = H.get_qubit_wise_commuting_groups();
+  std::vector<double> groupCosts(groups.size(), 1.0);
+  for (std::size_t g = 0; g < groups.size(); g++)
+    for (auto t : groups[g]) {
+      const auto *term = H.get_term_data(t);
+      std::size_t support = 0;
+      for (std::size_t w = 0; w < nWords; w++)
+        support += std::popcount(term[w] | term[w + nWords]);
+      groupCosts[g] += 1.0 + support / nQubits;
+    }
+
+  std::vector<std::size_t> order(groups.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](auto a, auto b) {
+    return groupCosts[a] > groupCosts[b];
+  });
+  std::vector<std::vector<std::size_t>> partition(nQpus);
+  std::vector<double> loads(nQpus, 0.0);
+  auto earliest = [&](double cost) {
+    std::size_t best = 0;
+    for (std::size_t q = 1; q < nQpus; q++)
+      if ((loads[q] + cost) / speeds[q] <
+          (loads[best] + cost) / speeds[best])
+        best = q;
+    return best;
+  };
+  for (auto g : order) {
+    auto q = earliest(groupCosts[g]);
+    loads[q] += groupCosts[g];
+    partition[q].insert(partition[q].end(), groups[g].begin(),
+                        groups[g].end());
+  }
+
+  // The identity terms go with the least loaded QPU.
+  std::vector<std::size_t> identities;
+  for (std::size_t t = 0; t < H.n_terms(); t++)
+    if (H.get_term(t).is_identity())
+      identities.push_back(t);
+  if (!identities.empty()) {
+    auto &least = partition[earliest(0.0)];
+    least.insert(least.end(), identities.begin(), identities.end());
+  }
+  for (auto &terms : partition)
+    std::sort(terms.begin(), terms.end());
+  return {std::move(partition), std::move(loads)};
 }
 
 /// @brief Distribute the expectation value computations amongst the
 /// available platform QPUs. The asyncLauncher functor takes as input the
 /// qpu index and the spin_op chunk and returns an async_observe_result.
+/// The terms are partitioned by estimated cost and the measured speed of
+/// the QPUs (see partitionTermsByCost()), and the results are reduced as
+/// the QPUs complete, which also updates their measured speed in `history`,
+/// by default that of the platform QPUs.
 inline auto distributeComputations(
     std::function<async_observe_result(std::size_t, spin_op &)> &&asyncLauncher,
-    spin_op &H, std::size_t nQpus) {
+    spin_op &H, std::size_t nQpus,
+    qpu_throughput_history &history = getQpuThroughputHistory()) {
+  auto [partition, costs] = partitionTermsByCost(H, history.get(nQpus));
 
-  // Calculate how many terms we can equally divide amongst the qpus
-  auto nTermsPerQPU = H.n_terms() / nQpus + (H.n_terms() % nQpus != 0);
-
-  // Slice the given spin_op into subsets for each QPU
+  // Observe each sub-spin_op asynchronously, skipping the idle QPUs.
   std::vector<spin_op> spins;
-  for (auto uniqueQpuId : cudaq::range(nQpus)) {
-    auto lowerBound = uniqueQpuId * nTermsPerQPU;
-    spins.emplace_back(H.slice(lowerBound, nTermsPerQPU));
-  }
-
-  // Observe each sub-spin_op asynchronously
+  std::vector<std::size_t> qpus;
+  for (std::size_t i = 0; i < nQpus; i++)
+    if (!partition[i].empty()) {
+      spins.emplace_back(H.select(partition[i]));
+      qpus.push_back(i);
+    }
+  const auto start = std::chrono::steady_clock::now();
   std::vector<async_observe_result> asyncResults;
-  for (std::size_t i = 0; auto &op : spins) {
-    asyncResults.emplace_back(asyncLauncher(i, op));
-    i++;
-  }
+  for (std::size_t i = 0; i < spins.size(); i++)
+    asyncResults.emplace_back(asyncLauncher(qpus[i], spins[i]));
 
-  // Wait for the results, should be executing
-  // in parallel on the available QPUs.
+  // Reduce the results in the order the QPUs complete them.
   double result = 0.0;
-  sample_result data;
-  for (auto &asyncResult : asyncResults) {
-    auto res = asyncResult.get();
-    result += res.exp_val_z();
-    auto incomingData = res.raw_data();
-    data += incomingData;
+  std::vector<sample_result> qpuData;
+  std::vector<shot_covariance> covariances;
+  std::vector<bool> done(asyncResults.size(), false);
+  for (std::size_t remaining = asyncResults.size(); remaining > 0;) {
+    for (std::size_t i = 0; i < asyncResults.size(); i++) {
+      if (done[i] || !asyncResults[i].wait_for(std::chrono::microseconds(
+                         remaining == 1 ? 1000000 : 100)))
+        continue;
+      auto res = asyncResults[i].get();
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      if (elapsed.count() > 0.0)
+        history.update(qpus[i], costs[qpus[i]] / elapsed.count());
+      done[i] = true;
+      remaining--;
+      result += res.exp_val_z();
+      qpuData.emplace_back(res.raw_data());
+      auto &qpuCovariances = res.shot_covariances();
+      covariances.insert(covariances.end(), qpuCovariances.begin(),
+                         qpuCovariances.end());
+    }
   }
 
-  return observe_result(result, H, data);
+  // Merge the data of all QPUs at once.
+  return observe_result(result, H, sample_result::merge(qpuData),
+                        std::move(covariances));
+}
+
+/// @brief Observe all of H with `observeTerms`, unless the platform spans
+/// several processes (see quantum_platform::num_ranks()). Then each process
+/// only observes its share of the terms, partitioned by cost amongst equally
+/// fast processes (see partitionTermsByCost()), and the expectation values
+/// of all processes are summed. The raw data of the result only holds the
+/// terms of this process.
+inline observe_result
+observeAcrossRanks(
+    quantum_platform &platform, spin_op &H,
+    const std::function<observe_result(spin_op &)> &observeTerms) {
+  const auto nRanks = platform.num_ranks();
+  if (nRanks < 2)
+    return observeTerms(H);
+
+  auto [partition, costs] =
+      partitionTermsByCost(H, std::vector<double>(nRanks, 1.0));
+  auto &terms = partition[platform.rank()];
+  std::vector<double> expectation{0.0};
+  sample_result data;
+  if (!terms.empty()) {
+    auto share = H.select(terms);
+    auto result = observeTerms(share);
+    expectation[0] = result.exp_val_z();
+    data = result.raw_data();
+  }
+  platform.all_reduce_sum(expectation);
+  return observe_result(expectation[0], H, std::move(data));
 }
 
 } // namespace details
 
+///
+/// \brief Memoize up to \p capacity exact observe results, those computed
+/// without shots, so that an optimizer or a gradient that evaluates the
+/// same parameters again gets the earlier result. Zero, the default,
+/// disables the memoization.
+///
+/// \details A result is looked up by the kernel type, the name and Quake
+///          code of a kernel_builder, the bytes of the arguments and the
+///          terms of the spin_op. Only the kernels without state, or
+///          kernel_builders, whose arguments are trivially copyable values
+///          or vectors of them are memoized. The target and the noise model
+///          must not be changed while results are memoized, call
+///          clear_observe_cache() after such changes.
+///
+/// Usage:
+/// \code{.cpp}
+/// cudaq::set_observe_cache_capacity(1024);
+/// auto [energy, params] = cudaq::vqe(ansatz{}, gradient, H, optimizer, 1);
+/// cudaq::set_observe_cache_capacity(0);
+/// \endcode
+///
+inline void set_observe_cache_capacity(std::size_t capacity) {
+  details::getObserveCache().set_capacity(capacity);
+}
+
+/// \brief Forget the memoized observe results, see
+/// set_observe_cache_capacity().
+inline void clear_observe_cache() { details::getObserveCache().clear(); }
+
 ///
 /// \brief Compute the expected value of \p H with respect to kernel(Args...).
 ///
@@ -209,23 +911,38 @@ observe_result observe(QuantumKernel &&kernel, spin_op H, Args &&...args) {
   auto &platform = cudaq::get_platform();
   auto shots = platform.get_shots().value_or(-1);
 
+  // Exact results may have been memoized, see set_observe_cache_capacity().
+  auto &cache = details::getObserveCache();
+  std::string key;
+  if (shots == -1 && cache.enabled()) {
+    key = details::makeObserveCacheKey(platform, kernel, H, args...);
+    if (!key.empty())
+      if (auto cached = cache.find(key))
+        return std::move(*cached);
+  }
+
   // Does this platform expose more than 1 QPU
   // If so, let's distribute the work amongst the QPUs
-  if (auto nQpus = platform.num_qpus(); nQpus > 1)
-    return details::distributeComputations(
-        [&kernel, ... args = std::forward<Args>(args)](std::size_t i,
-                                                       spin_op &op) mutable {
-          return observe_async(i, std::forward<QuantumKernel>(kernel), op,
-                               std::forward<Args>(args)...);
-        },
-        H, nQpus);
-
-  return details::runObservation(
-             [&kernel, ... args = std::forward<Args>(args)]() mutable {
-               kernel(args...);
-             },
-             H, platform, shots)
-      .value();
+  // and, on a platform spanning several processes, amongst those.
+  std::optional<observe_result> result = details::observeAcrossRanks(
+      platform, H,
+      [&, ... args = std::forward<Args>(args)](spin_op &terms) mutable {
+        if (auto nQpus = platform.num_qpus(); nQpus > 1)
+          return details::distributeComputations(
+              [&kernel, &args...](std::size_t i, spin_op &op) mutable {
+                return observe_async(i, std::forward<QuantumKernel>(kernel),
+                                     op, std::forward<Args>(args)...);
+              },
+              terms, nQpus);
+        return details::runObservation(
+                   [&kernel, &args...]() mutable { kernel(args...); }, terms,
+                   platform, shots)
+            .value();
+      });
+
+  if (!key.empty())
+    cache.insert(std::move(key), *result);
+  return std::move(result).value();
 }
 
 ///
@@ -272,21 +989,310 @@ observe_result observe(std::size_t shots, QuantumKernel &&kernel, spin_op H,
 
   // Does this platform expose more than 1 QPU
   // If so, let's distribute the work amongst the QPUs
-  if (auto nQpus = platform.num_qpus(); nQpus > 1)
-    return details::distributeComputations(
-        [&kernel, ... args = std::forward<Args>(args)](std::size_t i,
-                                                       spin_op &op) mutable {
-          return observe_async(i, std::forward<QuantumKernel>(kernel), op,
-                               std::forward<Args>(args)...);
-        },
-        H, nQpus);
-
-  return details::runObservation(
-             [&kernel, ... args = std::forward<Args>(args)]() mutable {
-               kernel(args...);
-             },
-             H, platform, shots)
-      .value();
+  // and, on a platform spanning several processes, amongst those.
+  return details::observeAcrossRanks(
+      platform, H,
+      [&, ... args = std::forward<Args>(args)](spin_op &terms) mutable {
+        if (auto nQpus = platform.num_qpus(); nQpus > 1)
+          return details::distributeComputations(
+              [&kernel, &args...](std::size_t i, spin_op &op) mutable {
+                return observe_async(i, std::forward<QuantumKernel>(kernel),
+                                     op, std::forward<Args>(args)...);
+              },
+              terms, nQpus);
+        return details::runObservation(
+                   [&kernel, &args...]() mutable { kernel(args...); }, terms,
+                   platform, shots)
+            .value();
+      });
+}
+
+///
+/// \brief Compute the expected value of each of the \p observables with
+/// respect to the state of a single kernel(Args...) execution.
+///
+/// \param kernel The instantiated ansatz callable, a CUDA Quantum kernel,
+///         cannot contain measure statements.
+/// \param observables The hermitian cudaq::spin_ops to compute the expected
+///         values for.
+/// \param args The variadic concrete arguments for evaluation of the kernel.
+/// \returns The observe_result of each observable, in order.
+///
+/// \details The kernel is executed once, and the expectation value of every
+///          distinct term of the observables is computed on that state.
+///          Terms shared by several observables are only measured once. The
+///          observables are observed on the current QPU.
+///
+/// Usage:
+/// \code{.cpp}
+/// std::vector<cudaq::spin_op> ops{H, cudaq::spin::z(0), cudaq::spin::z(1)};
+/// auto results = cudaq::observe(ansatz{}, ops, theta);
+/// double energy = results[0].exp_val_z();
+/// \endcode
+///
+template <typename QuantumKernel, typename... Args>
+  requires ObserveCallValid<QuantumKernel, Args...>
+std::vector<observe_result> observe(QuantumKernel &&kernel,
+                                    std::vector<spin_op> observables,
+                                    Args &&...args) {
+  auto &platform = cudaq::get_platform();
+  auto shots = platform.get_shots().value_or(-1);
+  return details::runMultiObservation(
+      [&kernel, ... args = std::forward<Args>(args)]() mutable {
+        kernel(args...);
+      },
+      observables, platform, shots);
+}
+
+///
+/// \brief Compute the expected value of \p H with respect to kernel(Args...)
+/// within a total shot budget, spent where it reduces the shot noise most.
+///
+/// \param budget The total shots over all terms of \p H, and the number of
+///         rounds they are spent in.
+/// \param kernel The instantiated ansatz callable, a CUDA Quantum kernel,
+///         cannot contain measure statements.
+/// \param H The hermitian cudaq::spin_op to compute the expected value for.
+/// \param args The variadic concrete arguments for evaluation of the kernel.
+/// \returns exp The expected value <ansatz(args...)|H|ansatz<args...)>.
+///
+/// \details Rather than measuring every qubit-wise commuting group of \p H
+///          with the same number of shots, the groups get shots in
+///          proportion to the standard deviation of their weighted terms,
+///          sqrt(sum c_i c_j Cov(P_i, P_j)). These are unknown up front, so
+///          the budget is spent in rounds, each one allocated by the
+///          variances estimated from the shots of the earlier rounds. Groups
+///          of small coefficients or nearly deterministic terms get few
+///          shots, which for a remote QPU means fewer shots submitted for
+///          the same accuracy. The groups are observed on the current QPU.
+///
+/// Usage:
+/// \code{.cpp}
+/// auto result = cudaq::observe(cudaq::shot_budget{10000}, ansatz{}, H, theta);
+/// double exp_val = result.exp_val_z(), variance = result.variance();
+/// \endcode
+///
+template <typename QuantumKernel, typename... Args>
+  requires ObserveCallValid<QuantumKernel, Args...>
+observe_result observe(const shot_budget &budget, QuantumKernel &&kernel,
+                       spin_op H, Args &&...args) {
+  auto &platform = cudaq::get_platform();
+  return details::runAdaptiveObservation(
+      [&kernel, ... args = std::forward<Args>(args)]() mutable {
+        kernel(args...);
+      },
+      H, platform, budget);
+}
+
+///
+/// \brief Compute the expected value of \p H with respect to kernel(Args...)
+/// extrapolated to zero noise.
+///
+/// \param options The odd noise scales to measure at, and the extrapolation
+///         to zero noise.
+/// \param kernel The instantiated ansatz callable, a CUDA Quantum kernel,
+///         cannot contain measure statements.
+/// \param H The hermitian cudaq::spin_op to compute the expected value for.
+/// \param args The variadic concrete arguments for evaluation of the kernel.
+/// \returns The extrapolated expected value, and the observation at each
+///         noise scale.
+///
+/// \details The noise of the kernel is amplified by an odd scale s by
+///          folding its gates: every gate G is applied as G (G† G)^((s-1)/2),
+///          by the simulator, or by the `quake-fold-gates` pass for remote
+///          QPUs. All the scaled observations are submitted at once, round
+///          robin over the QPUs of the platform, and their expectation
+///          values extrapolated to zero noise with a Richardson or an
+///          exponential fit.
+///
+/// Usage:
+/// \code{.cpp}
+/// cudaq::zne_options options{{1, 3, 5}, cudaq::zne_extrapolation::richardson};
+/// double exp_val = cudaq::observe(options, ansatz{}, H, theta);
+/// \endcode
+///
+template <typename QuantumKernel, typename... Args>
+  requires ObserveCallValid<QuantumKernel, Args...>
+zne_result observe(const zne_options &options, QuantumKernel &&kernel,
+                   spin_op H, Args &&...args) {
+  auto &platform = cudaq::get_platform();
+  auto shots = platform.get_shots().value_or(-1);
+  return details::runZneObservation(
+      [&kernel, ... args = std::forward<Args>(args)]() mutable {
+        kernel(args...);
+      },
+      H, platform, shots, options);
+}
+
+///
+/// \brief Compute the expected value of the compile time \p H with respect to
+/// kernel(Args...).
+///
+/// \details The terms of \p H are packed at compile time, they are copied
+///          into the spin_op observed as they are, without building or
+///          converting the binary symplectic form at runtime.
+///
+/// Usage:
+/// \code{.cpp}
+/// constexpr cudaq::static_spin_op<2, 3> H({"XX", "YY", "ZZ"}, {1., 1., 1.});
+/// auto exp_val = cudaq::observe(ansatz{}, H, theta);
+/// \endcode
+///
+template <typename QuantumKernel, std::size_t NQubits, std::size_t NTerms,
+          typename... Args>
+  requires ObserveCallValid<QuantumKernel, Args...>
+observe_result observe(QuantumKernel &&kernel,
+                       const static_spin_op<NQubits, NTerms> &H,
+                       Args &&...args) {
+  return observe(std::forward<QuantumKernel>(kernel), H.to_spin_op(),
+                 std::forward<Args>(args)...);
+}
+
+///
+/// \brief Compute the expected value of the file backed \p H with respect to
+/// kernel(Args...).
+///
+/// \tparam Args The variadic list of argument types for this kernel. Usually
+///         can be deduced by the compiler.
+/// \param kernel The instantiated ansatz callable, a CUDA Quantum kernel,
+///         cannot contain measure statements.
+/// \param H The hermitian cudaq::mapped_spin_op to compute the expected value
+///         for.
+/// \param args The variadic concrete arguments for evaluation of the kernel.
+/// \returns exp The expected value <ansatz(args...)|H|ansatz<args...)>.
+///
+/// \details The terms of \p H are observed in chunks of
+///          mapped_spin_op::default_chunk_size terms, so that only one chunk
+///          is copied out of the mapped file at a time. The kernel is
+///          evaluated once per chunk, and the chunks are distributed amongst
+///          the platform QPUs like the terms of a spin_op.
+///
+/// Usage:
+/// \code{.cpp}
+/// cudaq::mapped_spin_op H("hamiltonian.bin");
+/// double exp_val = cudaq::observe(ansatz{}, H, theta);
+/// \endcode
+///
+template <typename QuantumKernel, typename... Args>
+  requires ObserveCallValid<QuantumKernel, Args...>
+double observe(QuantumKernel &&kernel, const mapped_spin_op &H,
+               Args &&...args) {
+  double expectation = 0.0;
+  H.for_each_chunk(mapped_spin_op::default_chunk_size, [&](spin_op &chunk) {
+    expectation += observe(kernel, chunk, args...).exp_val_z();
+  });
+  return expectation;
+}
+
+///
+/// \brief Compute the expected value of \p H with respect to kernel(Args...)
+/// for each set of arguments in \p argumentSets.
+///
+/// \tparam Args The variadic list of argument types for this kernel. Usually
+///         can be deduced by the compiler.
+/// \param kernel The instantiated ansatz callable, a CUDA Quantum kernel,
+///         cannot contain measure statements.
+/// \param H The hermitian cudaq::spin_op to compute the expected value for.
+/// \param argumentSets The concrete arguments of each kernel evaluation.
+/// \returns The observe_result of each set of arguments, in order.
+///
+/// \details This is typically used for parameter sweeps and the shifted
+///          evaluations of a gradient. Backends that support it (e.g.
+///          cuquantum) simulate all the evaluations as one batch of state
+///          vectors when computing exact expectation values. Sampled
+///          evaluations, with shots, are never batched. On a platform
+///          with more than one QPU the evaluations are split amongst the
+///          QPUs, each observing its share as one batch.
+///
+/// Usage:
+/// \code{.cpp}
+/// std::vector<std::tuple<double>> thetas{{.59}, {.6}, {.61}};
+/// auto results = cudaq::observe_batch(ansatz{}, H, thetas);
+/// \endcode
+///
+template <typename QuantumKernel, typename... Args>
+  requires ObserveCallValid<QuantumKernel, Args...>
+std::vector<observe_result>
+observe_batch(QuantumKernel &&kernel, spin_op H,
+              const std::vector<std::tuple<Args...>> &argumentSets) {
+  auto &platform = cudaq::get_platform();
+  auto shots = platform.get_shots().value_or(-1);
+  auto &cache = details::getObserveCache();
+  if (shots == -1 && cache.enabled()) {
+    // Only observe the argument sets that are not memoized.
+    std::vector<std::optional<observe_result>> results(argumentSets.size());
+    std::vector<std::string> keys(argumentSets.size());
+    std::vector<std::size_t> missing;
+    for (std::size_t i = 0; i < argumentSets.size(); i++) {
+      keys[i] = std::apply(
+          [&](const auto &...args) {
+            return details::makeObserveCacheKey(platform, kernel, H,
+                                                  args...);
+          },
+          argumentSets[i]);
+      if (!keys[i].empty())
+        results[i] = cache.find(keys[i]);
+      if (!results[i])
+        missing.push_back(i);
+    }
+    auto observed = details::runObservationBroadcast(
+        [&](std::size_t i) { std::apply(kernel, argumentSets[missing[i]]); },
+        missing.size(), H, platform, shots);
+    for (std::size_t m = 0; m < missing.size(); m++) {
+      if (!keys[missing[m]].empty())
+        cache.insert(std::move(keys[missing[m]]), observed[m]);
+      results[missing[m]] = std::move(observed[m]);
+    }
+    std::vector<observe_result> ordered;
+    ordered.reserve(results.size());
+    for (auto &result : results)
+      ordered.emplace_back(std::move(result).value());
+    return ordered;
+  }
+  return details::runObservationBroadcast(
+      [&](std::size_t i) { std::apply(kernel, argumentSets[i]); },
+      argumentSets.size(), H, platform, shots);
+}
+
+///
+/// \brief Compute the expected value of \p H with respect to kernel(Args...)
+/// for each set of arguments in \p argumentSets, see observe_batch().
+///
+/// Usage:
+/// \code{.cpp}
+/// std::vector<std::tuple<double>> thetas{{.59}, {.6}, {.61}};
+/// auto results = cudaq::observe(ansatz{}, H, thetas);
+/// \endcode
+///
+template <typename QuantumKernel, typename... Args>
+  requires ObserveCallValid<QuantumKernel, Args...>
+std::vector<observe_result>
+observe(QuantumKernel &&kernel, spin_op H,
+        const std::vector<std::tuple<Args...>> &argumentSets) {
+  return observe_batch(std::forward<QuantumKernel>(kernel), std::move(H),
+                       argumentSets);
+}
+
+///
+/// \brief Compute the expected value of \p H with respect to kernel(Args...)
+/// for each set of arguments in \p argumentSets, from \p shots samples each,
+/// see observe_batch().
+///
+/// Usage:
+/// \code{.cpp}
+/// std::vector<std::tuple<double>> thetas{{.59}, {.6}, {.61}};
+/// auto results = cudaq::observe(/*shots*/ 1000, ansatz{}, H, thetas);
+/// \endcode
+///
+template <typename QuantumKernel, typename... Args>
+  requires ObserveCallValid<QuantumKernel, Args...>
+std::vector<observe_result>
+observe(std::size_t shots, QuantumKernel &&kernel, spin_op H,
+        const std::vector<std::tuple<Args...>> &argumentSets) {
+  auto &platform = cudaq::get_platform();
+  return details::runObservationBroadcast(
+      [&](std::size_t i) { std::apply(kernel, argumentSets[i]); },
+      argumentSets.size(), H, platform, shots);
 }
 
 ///
@@ -62,6 +62,12 @@ public:
   }
 };
 
+/// A batch_objective_function evaluates the objective function at a batch of
+/// input parameters at once, returning the values in the same order. The
+/// points of a batch are independent, so they may be evaluated concurrently.
+using batch_objective_function =
+    std::function<std::vector<double>(const std::vector<std::vector<double>> &)>;
+
 ///
 /// The cudaq::optimizer provides a high-level interface for general
 /// optimization of user-specified objective functions. This is meant
@@ -108,5 +114,26 @@ public:
   /// current input parameters.
   virtual optimization_result optimize(const int dim,
                                        optimizable_function &&opt_function) = 0;
+
+  /// Returns true if this optimization strategy evaluates its objective
+  /// function at several input parameters per iteration, handing them to
+  /// optimize_batch() objective functions together. Batch evaluation is
+  /// gradient-free, even for strategies that require gradients otherwise.
+  virtual bool supportsBatchEvaluation() { return false; }
+
+  /// Returns the number of shots this optimization strategy requests per
+  /// objective function evaluation of optimize_batch(), or 0 for the
+  /// platform default.
+  virtual std::size_t evaluation_shots() { return 0; }
+
+  /// Run the gradient-free optimization strategy with an objective function
+  /// evaluated at batches of input parameters. Strategies that do not
+  /// support batch evaluation hand it one input parameter vector at a time.
+  virtual optimization_result optimize_batch(const int dim,
+                                             batch_objective_function &&f) {
+    return optimize(dim, [&](const std::vector<double> &x) {
+      return f({x}).front();
+    });
+  }
 };
 } // namespace cudaq
@@ -6,7 +6,9 @@
  * the terms of the Apache License 2.0 which accompanies this distribution.    *
  *******************************************************************************/
 
+#include <cmath>
 #include <optional>
+#include <random>
 
 #include "armadillo"
 
@@ -55,6 +57,80 @@ public:
 } // namespace
 namespace cudaq::optimizers {
 
+namespace {
+/// Minimize f by descending simultaneous perturbation gradient estimates,
+/// `step` updating the parameters from the estimate of each iteration.
+optimization_result perturbationDescent(
+    const BaseEnsmallen &base, const StochasticBatchParameters &params,
+    const int dim, batch_objective_function &f,
+    const std::function<void(std::size_t, std::vector<double> &,
+                             const std::vector<double> &)> &step) {
+  std::vector<double> x =
+      base.initial_parameters.value_or(std::vector<double>(dim));
+  auto localFtol = base.f_tol.value_or(1e-4);
+  auto localGamma = params.gamma.value_or(.101);
+  auto localEvalStepSize = params.eval_step_size.value_or(.3);
+  auto maxEval =
+      base.max_eval.value_or(std::numeric_limits<std::size_t>::max());
+  auto nPerturbations =
+      std::max<std::size_t>(params.perturbations.value_or(1), 1);
+  if (params.shot_budget && !params.shots)
+    throw std::invalid_argument("A shot budget requires the shots of each "
+                                "objective evaluation.");
+  const std::size_t batchShots =
+      params.shots.value_or(0) * (2 * nPerturbations + 1);
+
+  std::mt19937 gen(std::random_device{}());
+  std::bernoulli_distribution coin;
+  std::vector<std::vector<double>> deltas(nPerturbations,
+                                          std::vector<double>(dim));
+  std::vector<std::vector<double>> points(2 * nPerturbations + 1);
+  std::vector<double> gradient(dim);
+  optimization_result best{std::numeric_limits<double>::infinity(), x};
+  double last = std::numeric_limits<double>::infinity();
+  std::size_t spentShots = 0;
+  for (std::size_t k = 0; k < maxEval; k++) {
+    if (params.shot_budget && spentShots + batchShots > *params.shot_budget)
+      break;
+    spentShots += batchShots;
+    const double ck = localEvalStepSize / std::pow(k + 1, localGamma);
+
+    // One batch: the current parameters, then each perturbation forward and
+    // backward.
+    points[0] = x;
+    for (std::size_t p = 0; p < nPerturbations; p++) {
+      auto &plus = points[2 * p + 1], &minus = points[2 * p + 2];
+      plus = x;
+      minus = x;
+      for (int i = 0; i < dim; i++) {
+        deltas[p][i] = coin(gen) ? 1.0 : -1.0;
+        plus[i] += ck * deltas[p][i];
+        minus[i] -= ck * deltas[p][i];
+      }
+    }
+    auto values = f(points);
+    if (values.size() != points.size())
+      throw std::runtime_error("The batch objective function must return one "
+                               "value per input parameter vector.");
+
+    if (values[0] < std::get<0>(best))
+      best = std::make_tuple(values[0], x);
+    if (std::abs(values[0] - last) < localFtol)
+      break;
+    last = values[0];
+
+    std::fill(gradient.begin(), gradient.end(), 0.0);
+    for (std::size_t p = 0; p < nPerturbations; p++) {
+      const double diff = values[2 * p + 1] - values[2 * p + 2];
+      for (int i = 0; i < dim; i++)
+        gradient[i] += diff / (2. * ck * deltas[p][i] * nPerturbations);
+    }
+    step(k, x, gradient);
+  }
+  return best;
+}
+} // namespace
+
 void BaseEnsmallen::validate(optimizable_function &optFunction) {
   if (!optFunction.providesGradients() && requiresGradients())
     throw std::invalid_argument(
@@ -107,6 +183,29 @@ optimization_result adam::optimize(const int dim,
                          arma::conv_to<std::vector<double>>::from(initCoords));
 }
 
+optimization_result adam::optimize_batch(const int dim,
+                                         batch_objective_function &&f) {
+  auto localStepSize = step_size.value_or(0.01);
+  auto localBeta1 = beta1.value_or(0.9);
+  auto localBeta2 = beta2.value_or(.999);
+  auto localEps = eps.value_or(1e-8);
+  std::vector<double> m(dim), v(dim);
+  return perturbationDescent(
+      *this, *this, dim, f,
+      [&](std::size_t k, std::vector<double> &x,
+          const std::vector<double> &gradient) {
+        const double rate = learning_rate ? learning_rate(k) : localStepSize;
+        const double correction1 = 1. - std::pow(localBeta1, k + 1);
+        const double correction2 = 1. - std::pow(localBeta2, k + 1);
+        for (std::size_t i = 0; i < x.size(); i++) {
+          m[i] = localBeta1 * m[i] + (1. - localBeta1) * gradient[i];
+          v[i] = localBeta2 * v[i] + (1. - localBeta2) * gradient[i] * gradient[i];
+          x[i] -= rate * (m[i] / correction1) /
+                  (std::sqrt(v[i] / correction2) + localEps);
+        }
+      });
+}
+
 optimization_result
 gradient_descent::optimize(const int dim, optimizable_function &&opt_function) {
   validate(opt_function);
@@ -171,4 +270,20 @@ optimization_result spsa::optimize(const int dim,
                          arma::conv_to<std::vector<double>>::from(initCoords));
 }
 
+optimization_result spsa::optimize_batch(const int dim,
+                                         batch_objective_function &&f) {
+  auto localStepSize = step_size.value_or(0.16);
+  auto localAlpha = alpha.value_or(0.602);
+  return perturbationDescent(
+      *this, *this, dim, f,
+      [&](std::size_t k, std::vector<double> &x,
+          const std::vector<double> &gradient) {
+        const double ak = learning_rate
+                              ? learning_rate(k)
+                              : localStepSize / std::pow(k + 1, localAlpha);
+        for (std::size_t i = 0; i < x.size(); i++)
+          x[i] -= ak * gradient[i];
+      });
+}
+
 } // namespace cudaq::optimizers
@@ -38,15 +38,60 @@ public:
   };
 
 CUDAQ_ENSMALLEN_ALGORITHM_TYPE(lbfgs, true, )
-CUDAQ_ENSMALLEN_ALGORITHM_TYPE(spsa, false, std::optional<double> alpha;
-                               std::optional<double> gamma;
-                               std::optional<double> eval_step_size;)
-
-CUDAQ_ENSMALLEN_ALGORITHM_TYPE(adam, true,
-                               std::optional<std::size_t> batch_size;
-                               std::optional<double> beta1;
-                               std::optional<double> beta2;
-                               std::optional<double> eps;)
+
+/// The parameters of the batch evaluation of the stochastic optimizers,
+/// which descend gradients estimated from random simultaneous perturbations
+/// of the parameters. The 2 * perturbations + 1 objective evaluations of an
+/// iteration (including the current parameters) form one batch.
+struct StochasticBatchParameters {
+  /// The number of perturbations averaged per iteration, 1 by default.
+  std::optional<std::size_t> perturbations;
+  /// The perturbation size is eval_step_size / (k + 1)^gamma at iteration k.
+  std::optional<double> gamma;
+  std::optional<double> eval_step_size;
+  /// If set, the learning rate of iteration k, replacing the default
+  /// schedule of the optimizer.
+  std::function<double(std::size_t)> learning_rate;
+  /// The shots of each objective evaluation, the platform default if unset.
+  std::optional<std::size_t> shots;
+  /// The total shots of all objective evaluations. The optimization stops
+  /// before a batch would exceed it. Requires shots.
+  std::optional<std::size_t> shot_budget;
+};
+
+/// Simultaneous perturbation stochastic approximation. Its batch evaluation
+/// steps by the learning rate step_size / (k + 1)^alpha by default.
+class spsa : public BaseEnsmallen, public StochasticBatchParameters {
+public:
+  spsa() = default;
+  bool requiresGradients() override { return false; }
+  optimization_result optimize(const int dim,
+                               optimizable_function &&opt_function) override;
+  bool supportsBatchEvaluation() override { return true; }
+  optimization_result optimize_batch(const int dim,
+                                     batch_objective_function &&f) override;
+  std::size_t evaluation_shots() override { return shots.value_or(0); }
+  std::optional<double> alpha;
+};
+
+/// Adam. Its batch evaluation is gradient-free: it applies the Adam update,
+/// with the learning rate step_size by default, to simultaneous perturbation
+/// gradient estimates, which suits noisy expectation values.
+class adam : public BaseEnsmallen, public StochasticBatchParameters {
+public:
+  adam() = default;
+  bool requiresGradients() override { return true; }
+  optimization_result optimize(const int dim,
+                               optimizable_function &&opt_function) override;
+  bool supportsBatchEvaluation() override { return true; }
+  optimization_result optimize_batch(const int dim,
+                                     batch_objective_function &&f) override;
+  std::size_t evaluation_shots() override { return shots.value_or(0); }
+  std::optional<std::size_t> batch_size;
+  std::optional<double> beta1;
+  std::optional<double> beta2;
+  std::optional<double> eps;
+};
 
 CUDAQ_ENSMALLEN_ALGORITHM_TYPE(gradient_descent, true, )
 CUDAQ_ENSMALLEN_ALGORITHM_TYPE(sgd, true,
@@ -10,26 +10,23 @@
 #include "observe.h"
 #include <cudaq.h>
 #include <cudaq/spin_op.h>
+#include <unordered_map>
 
 namespace cudaq {
 namespace __internal__ {
 
+/// @brief Prepare exp(-i step_size A_k) ... exp(-i step_size A_1)|0>, the
+/// state evolved by the QITE steps so far.
 struct base_qite_ansatz {
   void operator()(const int N, const double step_size,
                   std::vector<cudaq::spin_op> &aOps) __qpu__ {
     cudaq::qreg q(N);
-    for (auto &a : aOps) {
-      for (std::size_t i = 0; i < a.n_terms(); i++) {
-        auto term = a[i];
-        if (!term.is_identity()) {
-          exp(q, 0.5 * step_size, term);
-        }
-      }
-    }
+    for (auto &a : aOps)
+      exp(q, 2.0 * step_size, a);
   }
 };
 
-std::vector<cudaq::spin_op> generatePauliPermutation(int in_nbQubits) {
+inline std::vector<cudaq::spin_op> generatePauliPermutation(int in_nbQubits) {
   const int nbPermutations = std::pow(4, in_nbQubits);
   std::vector<cudaq::spin_op> opsList;
   opsList.reserve(nbPermutations);
@@ -58,26 +55,122 @@ std::vector<cudaq::spin_op> generatePauliPermutation(int in_nbQubits) {
   return opsList;
 }
 
+/// @brief Return the Pauli word of `term` over `nQubits` qubits, the Pauli
+/// on qubit i as its i-th character.
+inline std::string getPauliWord(const spin_op::term_view &term,
+                                std::size_t nQubits) {
+  std::string word(nQubits, 'I');
+  for (std::size_t q = 0; q < std::min(nQubits, term.n_qubits()); q++) {
+    auto p = term.get_pauli(q);
+    word[q] = p == pauli::X   ? 'X'
+              : p == pauli::Y ? 'Y'
+              : p == pauli::Z ? 'Z'
+                              : 'I';
+  }
+  return word;
+}
+
+/// @brief Solve the symmetric positive semi-definite system M x = v by
+/// Gaussian elimination, regularizing its diagonal so that directions the
+/// state does not depend on get no weight.
+inline std::vector<double> solveQiteSystem(std::vector<double> M,
+                                           std::vector<double> v) {
+  constexpr double regularization = 1e-8;
+  const std::size_t n = v.size();
+  for (std::size_t i = 0; i < n; i++)
+    M[i * n + i] += regularization;
+  for (std::size_t k = 0; k < n; k++) {
+    std::size_t pivot = k;
+    for (std::size_t i = k + 1; i < n; i++)
+      if (std::abs(M[i * n + k]) > std::abs(M[pivot * n + k]))
+        pivot = i;
+    if (pivot != k) {
+      for (std::size_t j = 0; j < n; j++)
+        std::swap(M[k * n + j], M[pivot * n + j]);
+      std::swap(v[k], v[pivot]);
+    }
+    for (std::size_t i = k + 1; i < n; i++) {
+      const double factor = M[i * n + k] / M[k * n + k];
+      for (std::size_t j = k; j < n; j++)
+        M[i * n + j] -= factor * M[k * n + j];
+      v[i] -= factor * v[k];
+    }
+  }
+  std::vector<double> x(n);
+  for (std::size_t k = n; k-- > 0;) {
+    double sum = v[k];
+    for (std::size_t j = k + 1; j < n; j++)
+      sum -= M[k * n + j] * x[j];
+    x[k] = sum / M[k * n + k];
+  }
+  return x;
+}
+
+/// @brief Run one QITE step: observe `h` and every Pauli word on the evolved
+/// state, all from a single preparation of it, then append the hermitian A
+/// whose exp(-i step_size A) best approximates the normalized imaginary time
+/// step exp(-step_size h). A = sum a_I P_I solves Re<P_I P_J> a = -Im<h P_I>.
+/// Return the energy of the state before the step.
 template <typename Kernel>
 double qiteEvolve(cudaq::spin_op h, const double m_step_size,
                   std::vector<cudaq::spin_op> &aOps) {
-  [[maybe_unused]] auto energy =
-      cudaq::observe(Kernel{}, h, (int)h.n_qubits(), m_step_size, aOps);
-  auto pauliOps = generatePauliPermutation(h.n_qubits());
-  std::vector<double> sig_exps{1.0}; // 4**N of these
-  for (std::size_t i = 1; i < pauliOps.size(); i++) {
-    auto val = cudaq::observe(Kernel{}, pauliOps[i], (int)h.n_qubits(),
-                              m_step_size, aOps);
-    sig_exps.push_back(val);
+  const std::size_t nQubits = h.n_qubits();
+  auto pauliOps = generatePauliPermutation(nQubits);
+  std::vector<cudaq::spin_op> observables{h};
+  observables.insert(observables.end(), pauliOps.begin(), pauliOps.end());
+  auto results = cudaq::observe(Kernel{}, observables, (int)nQubits,
+                                m_step_size, aOps);
+
+  std::vector<std::string> words;
+  std::unordered_map<std::string, double> sig_exps;
+  for (std::size_t i = 0; i < pauliOps.size(); i++) {
+    words.push_back(getPauliWord(*pauliOps[i].terms().begin(), nQubits));
+    sig_exps.emplace(words.back(), results[i + 1].exp_val_z());
   }
+  // The expectation value of the product of two one term spin_ops.
+  auto expectation = [&](const cudaq::spin_op &a, const cudaq::spin_op &b) {
+    auto product = *(a * b).terms().begin();
+    return product.get_coefficient() *
+           sig_exps.at(getPauliWord(product, nQubits));
+  };
+
+  // The identity is a global phase, it is left out of A.
+  cudaq::spin_op_builder builder;
+  std::vector<cudaq::spin_op> hTerms;
+  for (auto term : h.terms())
+    hTerms.push_back(builder
+                         .add(term.get_coefficient(),
+                              getPauliWord(term, nQubits))
+                         .build());
+  const std::size_t n = pauliOps.size() - 1;
+  std::vector<double> M(n * n), v(n, 0.0);
+  for (std::size_t i = 0; i < n; i++) {
+    for (std::size_t j = 0; j < n; j++)
+      M[i * n + j] = expectation(pauliOps[i + 1], pauliOps[j + 1]).real();
+    for (auto &term : hTerms)
+      v[i] -= expectation(term, pauliOps[i + 1]).imag();
+  }
+  auto a = solveQiteSystem(std::move(M), std::move(v));
 
-  return 0.0;
+  bool evolves = false;
+  for (std::size_t i = 0; i < n; i++)
+    if (std::abs(a[i]) > 1e-12) {
+      builder.add(a[i], words[i + 1]);
+      evolves = true;
+    }
+  if (evolves)
+    aOps.push_back(builder.build());
+  return results[0].exp_val_z();
 }
 
 } // namespace __internal__
 
-std::vector<double> qite(cudaq::spin_op h, const int steps,
-                         const double step_size) {
+/// @brief Run `steps` steps of quantum imaginary time evolution of `h` with
+/// the given `step_size`, and return the energy of the evolved state before
+/// each step. Each step observes the Hamiltonian and all the Pauli words it
+/// needs on one preparation of the evolved state.
+inline std::vector<double> qite(cudaq::spin_op h, const int steps,
+                                const double step_size) {
   std::vector<cudaq::spin_op> aOps;
   std::vector<double> energies;
   for (int i = 0; i < steps; i++) {
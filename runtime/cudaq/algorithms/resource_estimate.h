@@ -0,0 +1,63 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "common/ExecutionContext.h"
+#include "common/ResourceEstimate.h"
+#include "cudaq/platform.h"
+#include <stdexcept>
+
+namespace nvqir {
+void checkStateFits(std::size_t numQubits);
+}
+
+namespace cudaq {
+std::string get_quake_by_name(const std::string &kernelName);
+
+/// @brief Return the resources (qubits, gates, depth, measurements) used by
+/// one execution of the kernel at the given runtime arguments, without
+/// executing it. The kernel is launched under the "resource-estimate"
+/// context, which records its name and arguments, and its Quake code is
+/// specialized to these arguments and its loops unrolled before counting.
+/// The counts of the loops whose bounds are still unknown are symbolic. The
+/// kernel must be compiled by nvq++.
+template <typename QuantumKernel, typename... Args>
+resource_estimate estimate_resources(QuantumKernel &&kernel, Args &&...args) {
+  auto &platform = cudaq::get_platform();
+  ExecutionContext context("resource-estimate");
+  platform.set_exec_ctx(&context);
+  kernel(std::forward<Args>(args)...);
+  platform.reset_exec_ctx();
+
+  if (context.kernelName.empty())
+    throw std::runtime_error(
+        "estimate_resources requires a kernel compiled by nvq++.");
+  return details::estimateResources(
+      context.kernelName, get_quake_by_name(context.kernelName),
+      context.kernelArgs.empty() ? nullptr : context.kernelArgs.data());
+}
+
+/// @brief Check, before executing it, that the kernel at the given runtime
+/// arguments fits the simulation backend: the qubits of its resource
+/// estimate are compared with the memory model of the backend (e.g. 16 * 2^n
+/// bytes for a double precision state vector, 16 * 4^n for a density
+/// matrix) and the memory available to it. Throws, naming the backends with
+/// a smaller footprint, if the state would not fit. Remote QPUs and kernels
+/// whose qubit count is not known from their arguments are not checked.
+/// Return the resource estimate.
+template <typename QuantumKernel, typename... Args>
+resource_estimate preflight(QuantumKernel &&kernel, Args &&...args) {
+  auto estimate = estimate_resources(std::forward<QuantumKernel>(kernel),
+                                     std::forward<Args>(args)...);
+  if (!cudaq::get_platform().is_remote() && estimate.qubits.is_constant())
+    nvqir::checkStateFits(estimate.qubits.value());
+  return estimate;
+}
+
+} // namespace cudaq
@@ -8,10 +8,19 @@
 
 #pragma once
 
+#include "common/ApproximateCounts.h"
+#include "common/DistributionCache.h"
 #include "common/ExecutionContext.h"
+#include "common/KernelCacheKey.h"
 #include "common/MeasureCounts.h"
 #include "cudaq/concepts.h"
 #include "cudaq/platform.h"
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <vector>
 
 namespace cudaq {
 bool kernelHasConditionalFeedback(const std::string &);
@@ -28,15 +37,74 @@ concept SampleCallValid =
 
 namespace details {
 
+/// @brief The fewest shots worth a shot thread of their own in a per-shot
+/// sampling.
+constexpr std::size_t minShotsPerThread = 16;
+
+/// @brief Run `shots` executions of the kernel of a per-shot sampling under
+/// the context `ctx`, one shot each, split over `nThreads` shot threads of
+/// the platform. Each thread runs its range of the shots with a simulator
+/// and an execution context of its own, its random generators seeded from
+/// `seed` by thread index if given. The results are merged in thread order
+/// and the performance counters of the threads are added to those of `ctx`.
+/// The functor is invoked concurrently.
+template <typename KernelFunctor>
+sample_result runShotsConcurrently(KernelFunctor &wrappedKernel,
+                                   quantum_platform &platform,
+                                   ExecutionContext &ctx, std::size_t qpu_id,
+                                   std::size_t shots, std::size_t nThreads,
+                                   std::optional<std::uint64_t> seed) {
+  std::vector<sample_result> results(nThreads);
+  std::vector<execution_counters> counters(nThreads);
+  platform.run_on_shot_threads(nThreads, [&](std::size_t thread) {
+    ExecutionContext threadCtx(ctx.name, ctx.shots);
+    threadCtx.hasConditionalsOnMeasureResults =
+        ctx.hasConditionalsOnMeasureResults;
+    threadCtx.noiseModel = ctx.noiseModel;
+    if (seed)
+      threadCtx.seed = mixSeed(*seed, thread);
+    const std::size_t begin = shots * thread / nThreads;
+    const std::size_t end = shots * (thread + 1) / nThreads;
+    for (std::size_t shot = begin; shot < end; shot++) {
+      platform.set_exec_ctx(&threadCtx, qpu_id);
+      wrappedKernel();
+      platform.reset_exec_ctx(qpu_id);
+      results[thread] += std::move(threadCtx.result);
+      threadCtx.result.clear();
+      threadCtx.seed.reset();
+    }
+    counters[thread] = threadCtx.counters;
+  });
+
+  sample_result counts;
+  for (std::size_t thread = 0; thread < nThreads; thread++) {
+    counts += std::move(results[thread]);
+    ctx.counters += counters[thread];
+  }
+  return counts;
+}
+
 /// @brief Take the input KernelFunctor (a lambda that captures runtime args and
-/// invokes the quantum kernel) and invoke the sampling process.
+/// invokes the quantum kernel) and invoke the sampling process. If a shot
+/// stream is given, simulators append the record of every shot to it instead
+/// of collating the shots into the returned result. The random outcomes are
+/// seeded with `seed`, or else the next seed of the platform, if any. If
+/// `distribution` is given, it receives the probabilities of the sampled
+/// outcomes, if the simulator could keep them (see
+/// ExecutionContext::keepDistribution).
 template <typename KernelFunctor>
 std::optional<sample_result>
 runSampling(KernelFunctor &&wrappedKernel, quantum_platform &platform,
             const std::string &kernelName, int shots, std::size_t qpu_id = 0,
-            details::future *futureResult = nullptr) {
+            details::future *futureResult = nullptr,
+            ShotStream *shotStream = nullptr,
+            std::optional<std::uint64_t> seed = std::nullopt,
+            std::vector<double> *distribution = nullptr) {
   // Create the execution context.
   auto ctx = std::make_unique<ExecutionContext>("sample", shots);
+  ctx->shotStream = shotStream;
+  ctx->seed = seed ? seed : platform.next_random_seed();
+  ctx->keepDistribution = distribution != nullptr;
 
   // Tell the context if this quantum kernel has
   // conditionals on measure results
@@ -51,8 +119,9 @@ runSampling(KernelFunctor &&wrappedKernel, quantum_platform &platform,
   platform.set_current_qpu(qpu_id);
   auto hasCondFeedback = platform.supports_conditional_feedback();
 
-  // If no conditionals, nothing special to do for library mode
-  if (!ctx->hasConditionalsOnMeasureResults) {
+  // If no conditionals or noise trajectories, nothing special to do for
+  // library mode
+  if (!ctx->hasConditionalsOnMeasureResults && !ctx->hasNoiseTrajectories) {
     // Execute
     wrappedKernel();
 
@@ -64,13 +133,18 @@ runSampling(KernelFunctor &&wrappedKernel, quantum_platform &platform,
 
     // otherwise lets reset the context and set the data
     platform.reset_exec_ctx(qpu_id);
-    return ctx->result;
+    if (distribution)
+      *distribution = std::move(ctx->distribution);
+    ctx->result.set_counters(ctx->counters);
+    return std::move(ctx->result);
   }
 
   // If the execution backend does not support
-  // sampling with cond feedback, we'll emulate it here
-  if (!hasCondFeedback) {
+  // sampling with cond feedback, we'll emulate it here. Noise trajectories
+  // need one kernel execution per shot as well.
+  if (!hasCondFeedback || ctx->hasNoiseTrajectories) {
     sample_result counts;
+    const auto seed = ctx->seed;
 
     // If it has conditionals, loop over individual circuit executions
     for (auto &i : cudaq::range(shots)) {
@@ -79,14 +153,31 @@ runSampling(KernelFunctor &&wrappedKernel, quantum_platform &platform,
       // Reset the context and get the single measure result,
       // add it to the sample_result and clear the context result
       platform.reset_exec_ctx(qpu_id);
-      counts += ctx->result;
+      counts += std::move(ctx->result);
       ctx->result.clear();
+      // The random generators are seeded once, the next shots continue
+      // their streams.
+      ctx->seed.reset();
+
+      // Once the backend is known to allow it, the other shots are split
+      // over the shot threads of the platform.
+      const std::size_t remaining = shots - i - 1;
+      const auto nThreads = std::min<std::size_t>(
+          platform.get_num_shot_threads(), remaining / minShotsPerThread);
+      if (i == 0 && ctx->concurrentShots && !ctx->shotStream &&
+          nThreads > 1) {
+        counts += runShotsConcurrently(wrappedKernel, platform, *ctx, qpu_id,
+                                       remaining, nThreads, seed);
+        break;
+      }
+
       // Reset the context for the next round,
       // don't need to reset on the last exec
       if (i < static_cast<unsigned>(shots) - 1)
         platform.set_exec_ctx(ctx.get(), qpu_id);
     }
 
+    counts.set_counters(ctx->counters);
     return counts;
   }
 
@@ -101,7 +192,8 @@ runSampling(KernelFunctor &&wrappedKernel, quantum_platform &platform,
   }
 
   platform.reset_exec_ctx(qpu_id);
-  return ctx->result;
+  ctx->result.set_counters(ctx->counters);
+  return std::move(ctx->result);
 }
 
 /// @brief Take the input KernelFunctor (a lambda that captures runtime args and
@@ -134,11 +226,215 @@ auto runSamplingAsync(KernelFunctor &&wrappedKernel, quantum_platform &platform,
             .value();
       });
 
-  return async_sample_result(
-      details::future(platform.enqueueAsyncTask(qpu_id, task)));
+  auto completion = std::make_shared<details::completion_signal>();
+  return async_sample_result(details::future(
+      platform.enqueueAsyncTask(qpu_id, task, {}, completion), completion));
+}
+
+/// @brief Take the input KernelFunctor (a lambda that captures runtime args and
+/// invokes the quantum kernel) and sample it, splitting the shots amongst
+/// the local QPUs of the platform that share the noise model of QPU 0. The
+/// shots are split into a fixed number of chunks, taken by the QPUs as they
+/// become free, each seeded from the stream of the platform (see
+/// quantum_platform::set_random_seed()) and merged in order, so the result
+/// does not depend on which QPU ran which chunk. The functor is invoked
+/// concurrently. With a single such QPU, or fewer shots than QPUs, the
+/// kernel is sampled on QPU 0.
+template <typename KernelFunctor>
+sample_result runSplitSampling(KernelFunctor &&wrappedKernel,
+                               quantum_platform &platform,
+                               const std::string &kernelName,
+                               std::size_t shots) {
+  std::vector<std::size_t> qpus;
+  for (std::size_t qpu = 0; qpu < platform.num_qpus(); qpu++)
+    if (!platform.is_remote(qpu) &&
+        platform.get_noise(qpu) == platform.get_noise(0))
+      qpus.push_back(qpu);
+  const auto seed = platform.next_random_seed();
+  if (qpus.size() < 2 || shots < qpus.size() || platform.is_remote(0))
+    return runSampling(wrappedKernel, platform, kernelName, shots, 0, nullptr,
+                       nullptr, seed)
+        .value();
+
+  // More chunks than QPUs, for QPUs of uneven speed to balance.
+  const auto nChunks = std::min<std::size_t>(shots, 4 * qpus.size());
+  std::vector<UnplacedTask> tasks;
+  for (std::size_t chunk = 0; chunk < nChunks; chunk++) {
+    const std::size_t chunkShots =
+        shots / nChunks + (chunk < shots % nChunks);
+    std::optional<std::uint64_t> chunkSeed;
+    if (seed)
+      chunkSeed = mixSeed(*seed, chunk);
+    tasks.emplace_back([&, chunkShots, chunkSeed](std::size_t qpu) {
+      return runSampling(wrappedKernel, platform, kernelName, chunkShots, qpu,
+                         nullptr, nullptr, chunkSeed)
+          .value();
+    });
+  }
+  std::vector<sample_result> chunks(nChunks);
+  auto stream = platform.enqueueUnplacedTasks(std::move(tasks), qpus);
+  while (auto completed = stream.next())
+    chunks[completed->first] = std::move(completed->second);
+  return sample_result::merge(chunks);
+}
+
+/// @brief Return the distribution cache key of kernel(args...), or an empty
+/// string if the cache is disabled (see set_sample_cache_capacity()) or
+/// the kernel cannot be cached: its arguments cannot be compared by their
+/// bytes (see makeKernelCacheKey()), it has conditionals on measure results,
+/// or QPU 0 is remote or noisy.
+template <typename QuantumKernel, typename... Args>
+std::string makeSampleCacheKey(quantum_platform &platform,
+                               const std::string &kernelName,
+                               const QuantumKernel &kernel,
+                               const Args &...args) {
+  if (!getDistributionCache().enabled() || platform.is_remote(0) ||
+      platform.get_noise(0) || cudaq::kernelHasConditionalFeedback(kernelName))
+    return {};
+  return makeKernelCacheKey(kernel, args...);
+}
+
+/// @brief Sample the kernel like runSplitSampling(), unless `key` is a
+/// distribution cache key (see makeSampleCacheKey()). The shots are then
+/// drawn from the cached distribution of the key, or else the kernel is
+/// sampled on QPU 0 and its distribution cached for the next calls.
+template <typename KernelFunctor>
+sample_result runCachedSampling(std::string key, KernelFunctor &&wrappedKernel,
+                                quantum_platform &platform,
+                                const std::string &kernelName,
+                                std::size_t shots) {
+  if (key.empty())
+    return runSplitSampling(wrappedKernel, platform, kernelName, shots);
+
+  auto &cache = getDistributionCache();
+  const auto seed = platform.next_random_seed();
+  if (auto table = cache.find(key))
+    return sample_result(table->sample(shots, seed));
+  std::vector<double> distribution;
+  auto result = runSampling(wrappedKernel, platform, kernelName, shots, 0,
+                            nullptr, nullptr, seed, &distribution)
+                    .value();
+  if (!distribution.empty())
+    cache.insert(std::move(key),
+                 std::make_shared<const AliasTable>(
+                     distribution, std::countr_zero(distribution.size())));
+  return result;
+}
+
+/// @brief Take the input KernelFunctor (a lambda that invokes the quantum
+/// kernel with the arguments of the given index) and sample each of the n
+/// kernel executions on the QPUs of this process, handing every result with
+/// its index to `onResult` on the calling thread. On a platform with more
+/// than one QPU the executions are taken by the local QPUs as they become
+/// free (see quantum_platform::enqueueUnplacedTasks()), or placed round
+/// robin on the remote ones, and handed over as they complete. Otherwise
+/// they run one after the other, in order.
+template <typename KernelFunctor>
+void runLocalSamplingBroadcast(
+    KernelFunctor &&k, std::size_t n, quantum_platform &platform,
+    const std::string &kernelName, int shots,
+    const std::function<void(std::size_t, sample_result &&)> &onResult) {
+  const auto nQpus = std::min(platform.num_qpus(), n);
+  if (nQpus < 2) {
+    for (std::size_t i = 0; i < n; i++)
+      onResult(i, runSampling([&k, i]() mutable { k(i); }, platform,
+                              kernelName, shots)
+                      .value());
+    return;
+  }
+
+  // The tasks placed round robin on remote QPUs run there asynchronously,
+  // the others are taken by the local QPUs as they become free.
+  std::vector<std::size_t> localQpus;
+  for (std::size_t qpu = 0; qpu < nQpus; qpu++)
+    if (!platform.is_remote(qpu))
+      localQpus.push_back(qpu);
+  std::vector<std::pair<std::size_t, async_sample_result>> remoteResults;
+  std::vector<std::size_t> localTasks;
+  for (std::size_t i = 0; i < n; i++) {
+    const auto qpu = i % nQpus;
+    if (localQpus.empty() || platform.is_remote(qpu))
+      remoteResults.emplace_back(
+          i, runSamplingAsync([&k, i]() mutable { k(i); }, platform,
+                              kernelName, shots, qpu));
+    else
+      localTasks.push_back(i);
+  }
+
+  std::vector<UnplacedTask> tasks;
+  for (auto i : localTasks)
+    tasks.emplace_back([&, i](std::size_t qpu) {
+      return runSampling([&k, i]() mutable { k(i); }, platform, kernelName,
+                         shots, qpu)
+          .value();
+    });
+  auto stream = platform.enqueueUnplacedTasks(std::move(tasks), localQpus);
+  while (auto completed = stream.next())
+    onResult(localTasks[completed->first], std::move(completed->second));
+  for (auto &[i, result] : remoteResults)
+    onResult(i, result.get());
+}
+
+/// @brief Sample each of the n kernel executions, see
+/// runLocalSamplingBroadcast(). On a platform spanning several processes
+/// each process samples a contiguous share of the executions, the counts
+/// are exchanged and every process hands all the results to `onResult`, in
+/// order.
+template <typename KernelFunctor>
+void runSamplingBroadcast(
+    KernelFunctor &&k, std::size_t n, quantum_platform &platform,
+    const std::string &kernelName, int shots,
+    const std::function<void(std::size_t, sample_result &&)> &onResult) {
+  const auto nRanks = platform.num_ranks();
+  if (nRanks < 2)
+    return runLocalSamplingBroadcast(k, n, platform, kernelName, shots,
+                                     onResult);
+
+  const auto chunkSize = n / nRanks + (n % nRanks != 0);
+  const auto begin = std::min(platform.rank() * chunkSize, n);
+  const auto end = std::min(begin + chunkSize, n);
+  std::vector<sample_result> local(end - begin);
+  if (begin < end)
+    runLocalSamplingBroadcast(
+        [&k, begin](std::size_t i) mutable { k(begin + i); }, end - begin,
+        platform, kernelName, shots,
+        [&](std::size_t i, sample_result &&result) {
+          local[i] = std::move(result);
+        });
+  auto results = platform.all_gather_results(local);
+  for (std::size_t i = 0; i < results.size(); i++)
+    onResult(i, std::move(results[i]));
 }
 } // namespace details
 
+/// \brief Keep the outcome distributions of up to \p capacity sampled
+/// kernels, so that sampling a kernel again with the same arguments only
+/// draws the shots from its distribution instead of simulating it. Zero,
+/// the default, disables the cache.
+///
+/// \details The distribution is kept by the simulators that compute the
+///          marginal probabilities of up to 20 sampled qubits, for kernels
+///          without noise or conditionals on measure results, sampled on a
+///          local QPU. A kernel is looked up by its type, the name and
+///          Quake code of a kernel_builder and the bytes of its arguments,
+///          which must be trivially copyable values or vectors of them.
+///          Other kernels with state are not cached. The target must not be
+///          changed while a distribution is cached, call
+///          clear_sample_cache() after such a change.
+///
+/// Usage:
+/// \code{.cpp}
+/// cudaq::set_sample_cache_capacity(16);
+/// for (int i = 0; i < 100; i++)
+///   bootstrap.push_back(cudaq::sample(1000, kernel, theta));
+/// \endcode
+inline void set_sample_cache_capacity(std::size_t capacity) {
+  getDistributionCache().setCapacity(capacity);
+}
+
+/// \brief Forget the cached distributions, see set_sample_cache_capacity().
+inline void clear_sample_cache() { getDistributionCache().clear(); }
+
 /// \brief Sample the given quantum kernel expression and return the
 /// mapping of observed bit strings to corresponding number of
 /// times observed.
@@ -165,12 +461,11 @@ sample_result sample(QuantumKernel &&kernel, Args &&...args) {
   auto &platform = cudaq::get_platform();
   auto shots = platform.get_shots().value_or(1000);
   auto kernelName = cudaq::getKernelName(kernel);
-  return details::runSampling(
-             [&kernel, ... args = std::forward<Args>(args)]() mutable {
-               kernel(std::forward<Args>(args)...);
-             },
-             platform, kernelName, shots)
-      .value();
+  auto key = details::makeSampleCacheKey(platform, kernelName, kernel, args...);
+  return details::runCachedSampling(
+      std::move(key),
+      [&kernel, ... args = std::forward<Args>(args)]() { kernel(args...); },
+      platform, kernelName, shots);
 }
 
 /// \brief Sample the given quantum kernel expression and return the
@@ -199,12 +494,151 @@ auto sample(std::size_t shots, QuantumKernel &&kernel, Args &&...args) {
   // Run this SHOTS times
   auto &platform = cudaq::get_platform();
   auto kernelName = cudaq::getKernelName(kernel);
-  return details::runSampling(
-             [&kernel, ... args = std::forward<Args>(args)]() mutable {
-               kernel(std::forward<Args>(args)...);
-             },
-             platform, kernelName, shots)
-      .value();
+  auto key = details::makeSampleCacheKey(platform, kernelName, kernel, args...);
+  return details::runCachedSampling(
+      std::move(key),
+      [&kernel, ... args = std::forward<Args>(args)]() { kernel(args...); },
+      platform, kernelName, shots);
+}
+
+/// \brief Sample the given quantum kernel expression and hand the record of
+/// every shot to the sink, in batches, instead of collating the shots into a
+/// counts dictionary.
+///
+/// \param shots the number of samples to collect.
+/// \param sink the callback receiving the batches and the batch size.
+/// \param kernel the kernel expression, must contain final measurements
+/// \param args the variadic concrete arguments for evaluation of the kernel.
+/// \returns the number of shots handed to the sink.
+///
+/// \details The sampling waits for the callback to return, so at most one
+///          batch of records is held in memory however many shots are taken.
+///          A record holds the mid-circuit measurement results of its shot
+///          in measurement order, followed by the sampled bits. Backends that
+///          only return collated counts have them expanded into shots in
+///          random order.
+template <typename QuantumKernel, typename... Args>
+  requires SampleCallValid<QuantumKernel, Args...>
+std::size_t sample_stream(std::size_t shots, shot_sink sink,
+                          QuantumKernel &&kernel, Args &&...args) {
+  // Need the code to be lowered to llvm and the kernel to be registered
+  // so that we can check for conditional feedback / mid circ measurement
+  if constexpr (has_name<QuantumKernel>::value) {
+    static_cast<cudaq::details::kernel_builder_base &>(kernel).jitCode();
+  }
+
+  ShotStream stream(std::move(sink));
+  auto &platform = cudaq::get_platform();
+  auto kernelName = cudaq::getKernelName(kernel);
+  auto result = details::runSampling(
+                    [&kernel, ... args = std::forward<Args>(args)]() mutable {
+                      kernel(std::forward<Args>(args)...);
+                    },
+                    platform, kernelName, shots, 0, nullptr, &stream)
+                    .value();
+
+  // Remote backends collate the shots themselves.
+  if (stream.size() == 0 && result.size() > 0) {
+    PackedCounts counts(result.begin()->first.size());
+    for (auto &[bits, count] : result)
+      counts.add(bits, count);
+    stream.appendCounts(counts);
+  }
+  stream.flush();
+  return stream.size();
+}
+
+/// \brief Sample the given quantum kernel expression into counts of bounded
+/// memory, for sample spaces too large to count every observed bit string.
+///
+/// \param policy how many bit strings to count individually, the size of
+/// the sketch estimating the others and the qubits to keep marginals of.
+/// \param shots the number of samples to collect.
+/// \param kernel the kernel expression, must contain final measurements
+/// \param args the variadic concrete arguments for evaluation of the kernel.
+/// \returns the approximate counts.
+///
+/// \details The shots are streamed (see sample_stream()) into the counts, so
+///          simulators sample them in chunks and neither the shots nor their
+///          collated counts are held in memory at once.
+template <typename QuantumKernel, typename... Args>
+  requires SampleCallValid<QuantumKernel, Args...>
+approximate_counts sample_bounded(counting_policy policy, std::size_t shots,
+                                  QuantumKernel &&kernel, Args &&...args) {
+  approximate_counts counts(std::move(policy));
+  sample_stream(
+      shots,
+      {[&](const shot_batch &batch) {
+        for (std::size_t s = 0; s < batch.size(); s++)
+          counts.add(batch.record(s), batch.n_bits());
+      }},
+      std::forward<QuantumKernel>(kernel), std::forward<Args>(args)...);
+  return counts;
+}
+
+/// \brief Sample the given quantum kernel expression at each set of
+/// arguments, handing every counts dictionary to `onResult` as soon as it is
+/// sampled.
+///
+/// \param shots the number of samples to collect per set of arguments.
+/// \param kernel the kernel expression, must contain final measurements
+/// \param argumentSets the concrete arguments of each kernel evaluation.
+/// \param onResult called with the index of the set of arguments and its
+/// counts dictionary, on the calling thread.
+///
+/// \details On a platform with more than one QPU the evaluations are
+///          distributed amongst the QPUs and handed over in the order they
+///          complete, otherwise in input order. The kernel is compiled once
+///          for all of them.
+template <typename QuantumKernel, typename... Args>
+  requires SampleCallValid<QuantumKernel, Args...>
+void sample(std::size_t shots, QuantumKernel &&kernel,
+            const std::vector<std::tuple<Args...>> &argumentSets,
+            const std::function<void(std::size_t, sample_result &&)>
+                &onResult) {
+  if constexpr (has_name<QuantumKernel>::value) {
+    static_cast<cudaq::details::kernel_builder_base &>(kernel).jitCode();
+  }
+
+  auto &platform = cudaq::get_platform();
+  auto kernelName = cudaq::getKernelName(kernel);
+  details::runSamplingBroadcast(
+      [&](std::size_t i) { std::apply(kernel, argumentSets[i]); },
+      argumentSets.size(), platform, kernelName, shots, onResult);
+}
+
+/// \brief Sample the given quantum kernel expression at each set of
+/// arguments. Specify the number of shots per set of arguments.
+///
+/// \returns the counts dictionary of each set of arguments, in order.
+///
+/// Usage:
+/// \code{.cpp}
+/// std::vector<std::tuple<double, double>> angles{{.1, .2}, {.3, .4}};
+/// auto results = cudaq::sample(1000, qaoa{}, angles);
+/// \endcode
+template <typename QuantumKernel, typename... Args>
+  requires SampleCallValid<QuantumKernel, Args...>
+std::vector<sample_result>
+sample(std::size_t shots, QuantumKernel &&kernel,
+       const std::vector<std::tuple<Args...>> &argumentSets) {
+  std::vector<sample_result> results(argumentSets.size());
+  sample(shots, std::forward<QuantumKernel>(kernel), argumentSets,
+         [&](std::size_t i, sample_result &&result) {
+           results[i] = std::move(result);
+         });
+  return results;
+}
+
+/// \brief Sample the given quantum kernel expression at each set of
+/// arguments, with the shots of the platform.
+template <typename QuantumKernel, typename... Args>
+  requires SampleCallValid<QuantumKernel, Args...>
+std::vector<sample_result>
+sample(QuantumKernel &&kernel,
+       const std::vector<std::tuple<Args...>> &argumentSets) {
+  auto shots = cudaq::get_platform().get_shots().value_or(1000);
+  return sample(shots, std::forward<QuantumKernel>(kernel), argumentSets);
 }
 
 /// \brief Sample the given kernel expression asynchronously and return
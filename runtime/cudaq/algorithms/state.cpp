@@ -14,56 +14,79 @@ namespace cudaq {
 
 void state::dump() { dump(std::cout); }
 void state::dump(std::ostream &os) {
-  auto &[shape, stateData] = data;
+  auto shape = data->getShape();
   if (shape.size() == 1) {
-    for (auto &d : stateData)
-      os << d.real() << " ";
+    for (std::size_t i = 0; i < shape[0]; i++)
+      os << data->getElement(i).real() << " ";
     os << "\n";
   } else {
     for (std::size_t i = 0; i < shape[0]; i++) {
       for (std::size_t j = 0; j < shape[1]; j++) {
-        os << stateData[i * shape[0] + j].real() << " ";
+        os << data->getElement(i * shape[0] + j).real() << " ";
       }
       os << "\n";
     }
   }
 }
 std::complex<double> state::operator[](std::size_t idx) {
-  auto &[shape, stateData] = data;
-  if (shape.size() != 1)
+  if (data->getShape().size() != 1)
     throw std::runtime_error("Cannot request 1-d index into density matrix. "
                              "Must be a state vector.");
-  return stateData[idx];
+  return data->getElement(idx);
 }
 
 std::complex<double> state::operator()(std::size_t idx, std::size_t jdx) {
-  auto &[shape, stateData] = data;
+  auto shape = data->getShape();
 
   if (shape.size() != 2)
     throw std::runtime_error("Cannot request 2-d index into state vector. "
                              "Must be a density matrix.");
 
-  return stateData[idx * std::get<0>(data)[0] + jdx];
+  return data->getElement(idx * shape[0] + jdx);
+}
+
+const std::complex<double> *state::get_host_data() {
+  if (auto *hostData = data->getHostData())
+    return hostData;
+  auto [shape, hostData] = data->toState();
+  data = std::make_shared<
+      HostSimulationState<std::vector<std::complex<double>>>>(
+      std::move(shape), std::move(hostData));
+  return data->getHostData();
+}
+
+/// @brief Return the host data of the given state, copying it into `storage`
+/// if it is held on a device or in another precision.
+static const std::complex<double> *
+getHostData(const SimulationState &s,
+            std::vector<std::complex<double>> &storage) {
+  if (auto *hostData = s.getHostData())
+    return hostData;
+  storage = std::get<1>(s.toState());
+  return storage.data();
 }
 
 double state::overlap(state &other) {
   double sum = 0.0;
-  auto &[shape, stateData] = data;
-  if (shape.size() != std::get<0>(other.data).size())
+  auto shape = data->getShape();
+  if (shape.size() != other.data->getShape().size())
     throw std::runtime_error(
         "Cannot compare state vectors and density matrices.");
 
+  std::vector<std::complex<double>> storage, otherStorage;
+  const auto *stateData = getHostData(*data, storage);
+  const auto *otherData = getHostData(*other.data, otherStorage);
   if (shape.size() == 1) {
-    for (std::size_t i = 0; i < std::get<1>(data).size(); i++) {
-      sum += std::abs(std::get<1>(data)[i] * other[i]);
+    for (std::size_t i = 0; i < shape[0]; i++) {
+      sum += std::abs(stateData[i] * otherData[i]);
     }
   } else {
 
     // Create rho and sigma matrices
     Eigen::MatrixXcd rho =
-        Eigen::Map<Eigen::MatrixXcd>(stateData.data(), shape[0], shape[1]);
-    Eigen::MatrixXcd sigma = Eigen::Map<Eigen::MatrixXcd>(
-        std::get<1>(other.data).data(), shape[0], shape[1]);
+        Eigen::Map<const Eigen::MatrixXcd>(stateData, shape[0], shape[1]);
+    Eigen::MatrixXcd sigma =
+        Eigen::Map<const Eigen::MatrixXcd>(otherData, shape[0], shape[1]);
 
     // For qubit systems, F(rho,sigma) = tr(rho*sigma) + 2 *
     // sqrt(det(rho)*det(sigma))
@@ -11,6 +11,8 @@
 #include "common/ExecutionContext.h"
 #include "cudaq/platform.h"
 #include <complex>
+#include <memory>
+#include <tuple>
 #include <vector>
 
 namespace cudaq {
@@ -21,16 +23,31 @@ class state {
 
 private:
   /// @brief Reference to the simulation data
-  State data;
+  std::shared_ptr<SimulationState> data;
 
 public:
   /// @brief The constructor, takes the simulation data
-  state(State d) : data(d) {}
+  state(State d)
+      : data(std::make_shared<
+             HostSimulationState<std::vector<std::complex<double>>>>(
+            std::move(std::get<0>(d)), std::move(std::get<1>(d)))) {}
+
+  /// @brief The constructor, takes a handle to the simulation data. The
+  /// data is not copied, elements are read from it when accessed.
+  state(std::shared_ptr<SimulationState> d) : data(std::move(d)) {}
 
   /// @brief Return the data element at the given indices
   std::complex<double> operator[](std::size_t idx);
   std::complex<double> operator()(std::size_t idx, std::size_t jdx);
 
+  /// @brief Return the shape of the state, (n) or (n, n).
+  std::vector<std::size_t> get_shape() const { return data->getShape(); }
+
+  /// @brief Return the contiguous host data of the state, row major. State
+  /// data held on a device or in another precision is copied to the host on
+  /// the first call, and the copy is kept for the next ones.
+  const std::complex<double> *get_host_data();
+
   /// @brief Dump the state to standard out
   void dump();
   void dump(std::ostream &os);
@@ -64,10 +81,108 @@ state extractState(KernelFunctor &&kernel) {
   platform.reset_exec_ctx();
 
   // Return the state data.
-  return state(context.simulationData);
+  if (!context.simulationState)
+    return state(State{});
+  return state(std::move(context.simulationState));
+}
+
+/// @brief Execute the two kernel functors one after the other under an
+/// "overlap" context and return the overlap of their states.
+template <typename KernelFunctorA, typename KernelFunctorB>
+std::complex<double> computeOverlap(KernelFunctorA &&kernelA,
+                                    KernelFunctorB &&kernelB) {
+  auto &platform = cudaq::get_platform();
+  if (!platform.is_simulator())
+    throw std::runtime_error("Cannot use overlap on a physical QPU.");
+
+  ExecutionContext context("overlap");
+  platform.set_exec_ctx(&context);
+  kernelA();
+  platform.reset_exec_ctx();
+  platform.set_exec_ctx(&context);
+  kernelB();
+  platform.reset_exec_ctx();
+
+  if (!context.overlap)
+    throw std::runtime_error(
+        "Cannot compute the overlap of states on different numbers of qubits "
+        "or on this backend.");
+  return *context.overlap;
+}
+
+/// @brief Execute the given kernel functor under the state query context
+/// `context`, "amplitudes" or "probabilities".
+template <typename KernelFunctor>
+void queryState(ExecutionContext &context, KernelFunctor &&kernel) {
+  auto &platform = cudaq::get_platform();
+  if (!platform.is_simulator())
+    throw std::runtime_error("Cannot query the state on a physical QPU.");
+  platform.set_exec_ctx(&context);
+  kernel();
+  platform.reset_exec_ctx();
 }
 } // namespace details
 
+/// @brief Return the amplitudes of the basis states of the given indices in
+/// the state vector prepared by the kernel at the given runtime arguments,
+/// i.e. get_state(kernel, args...)[index] for each index. The backend reads
+/// only these amplitudes, the state is not copied.
+template <typename QuantumKernel, typename... Args>
+std::vector<std::complex<double>>
+get_amplitudes(QuantumKernel &&kernel, const std::vector<std::size_t> &indices,
+               Args &&...args) {
+  ExecutionContext context("amplitudes");
+  context.amplitudeIndices = indices;
+  details::queryState(context, [&]() { kernel(std::forward<Args>(args)...); });
+  if (context.amplitudes.size() != indices.size())
+    throw std::runtime_error("Cannot get the amplitudes: an index is out of "
+                             "range or the state is not a state vector.");
+  return context.amplitudes;
+}
+
+/// @brief Return the marginal probabilities of the 2^n outcomes of the n
+/// given qubits, for the state prepared by the kernel at the given runtime
+/// arguments. Bit j of an outcome is the value of qubits[j]. The backend
+/// reduces the probabilities in place, e.g. on the GPU, only they are copied.
+template <typename QuantumKernel, typename... Args>
+std::vector<double> get_probabilities(QuantumKernel &&kernel,
+                                      const std::vector<std::size_t> &qubits,
+                                      Args &&...args) {
+  ExecutionContext context("probabilities");
+  context.probabilityQubits = qubits;
+  details::queryState(context, [&]() { kernel(std::forward<Args>(args)...); });
+  if (context.probabilities.empty())
+    throw std::runtime_error(
+        "Cannot get the probabilities: the qubits are not distinct allocated "
+        "qubits or the backend does not support probability queries.");
+  return context.probabilities;
+}
+
+/// @brief Return the overlap <a|b> of the state a prepared by `kernelA` at
+/// the arguments `argsA` and the state b prepared by `kernelB` at `argsB`.
+/// The simulator keeps the first state where it holds it, e.g. on the GPU,
+/// while it prepares the second one, and reduces the overlap there, so that
+/// neither state is copied to the host. For density matrices, this is
+/// Tr(a^dag b).
+template <typename QuantumKernelA, typename... ArgsA,
+          typename QuantumKernelB, typename... ArgsB>
+std::complex<double> overlap(QuantumKernelA &&kernelA,
+                             std::tuple<ArgsA...> argsA,
+                             QuantumKernelB &&kernelB,
+                             std::tuple<ArgsB...> argsB) {
+  return details::computeOverlap(
+      [&]() { std::apply(kernelA, argsA); },
+      [&]() { std::apply(kernelB, argsB); });
+}
+
+/// @brief Return the overlap <a|b> of the states prepared by the kernels
+/// without arguments `kernelA` and `kernelB`.
+template <typename QuantumKernelA, typename QuantumKernelB>
+std::complex<double> overlap(QuantumKernelA &&kernelA,
+                             QuantumKernelB &&kernelB) {
+  return details::computeOverlap([&]() { kernelA(); }, [&]() { kernelB(); });
+}
+
 /// @brief Return the state representation generated by
 /// the kernel at the given runtime arguments.
 template <typename QuantumKernel, typename... Args>
@@ -10,6 +10,16 @@
 #include "gradient.h"
 #include "observe.h"
 #include "optimizer.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
 
 namespace cudaq {
 
@@ -397,4 +407,383 @@ optimization_result vqe(QuantumKernel &&kernel, cudaq::gradient &gradient,
   });
 }
 
+/// \brief The wall-clock accounting of a batched VQE.
+struct vqe_batch_report {
+  /// \brief The number of energy evaluations and of batches of them.
+  std::size_t evaluations = 0;
+  std::size_t batches = 0;
+
+  /// \brief The lowest energy evaluated and its parameters.
+  double best_energy = std::numeric_limits<double>::infinity();
+  std::vector<double> best_parameters;
+
+  /// \brief The seconds of the whole optimization, and of waiting for the
+  /// batches of energies, the rest being spent by the optimizer.
+  double wall_time = 0.0;
+  double evaluation_time = 0.0;
+
+  /// \brief The QPU-seconds of the batches: each one keeps
+  /// min(batch size, number of QPUs) QPUs busy for its duration.
+  double qpu_time = 0.0;
+  std::size_t num_qpus = 1;
+
+  /// \brief Return the fraction of the wall-clock time of all QPUs spent
+  /// evaluating energies.
+  double utilization() const {
+    return wall_time > 0.0 ? qpu_time / (wall_time * num_qpus) : 0.0;
+  }
+};
+
+/// \brief The options of a batched VQE.
+struct vqe_batch_options {
+  /// \brief If set, called after every batch with the lowest energy
+  /// evaluated so far and its parameters, e.g. to write a checkpoint. An
+  /// interrupted VQE is resumed by setting the optimizer's initial
+  /// parameters to the checkpointed ones.
+  std::function<void(double, const std::vector<double> &)> checkpoint;
+
+  /// \brief If set, receives the accounting of the optimization.
+  vqe_batch_report *report = nullptr;
+};
+
+///
+/// \brief Compute the minimal eigenvalue of \p H with VQE, evaluating the
+///        energies requested together by the optimizer concurrently.
+///
+/// \param kernel The ansatz, a quantum kernel callable, must have
+///        callable-type void(std::vector<double>) and no measures.
+/// \param H The hermitian cudaq::spin_op to compute the minimal eigenvalue for.
+/// \param optimizer The cudaq::optimizer to use. Strategies whose
+///        supportsBatchEvaluation() is true request several energies per
+///        iteration, from evaluation_shots() shots each, others must be
+///        gradient-free and request one energy at a time.
+/// \param n_params The number of variational parameters in the ansatz quantum
+///        kernel callable.
+/// \param options The checkpoint callback and the report to fill in.
+/// \returns The optimal value and corresponding parameters as a
+///        cudaq::optimization_result (std::tuple<double,std::vector<double>>)
+///
+/// \details Every batch of parameters is observed with the broadcast
+/// cudaq::observe, which spreads it over the QPUs of the platform, so a batch
+/// at least as large as the number of QPUs keeps them all busy.
+///
+/// Usage:
+/// \code{.cpp}
+/// cudaq::optimizers::spsa optimizer;
+/// optimizer.perturbations = cudaq::get_platform().num_qpus();
+/// optimizer.initial_parameters = loadCheckpoint();
+/// cudaq::vqe_batch_report report;
+/// auto [val, params] = cudaq::vqe_batch(
+///     ansatz{}, H, optimizer, 1,
+///     {.checkpoint = [](double e, auto &x) { saveCheckpoint(x); },
+///      .report = &report});
+/// printf("QPU utilization %lf\n", report.utilization());
+/// \endcode
+///
+template <typename QuantumKernel>
+optimization_result vqe_batch(QuantumKernel &&kernel, cudaq::spin_op H,
+                              cudaq::optimizer &optimizer, const int n_params,
+                              const vqe_batch_options &options = {}) {
+  static_assert(std::is_invocable_v<QuantumKernel, std::vector<double>>,
+                "Invalid parameterized quantum kernel expression. Must have "
+                "void(std::vector<double>) signature.");
+  if (optimizer.requiresGradients() && !optimizer.supportsBatchEvaluation()) {
+    throw std::invalid_argument("Provided cudaq::optimizer requires gradients. "
+                                "Batched VQE takes gradient-free optimizers.");
+  }
+
+  using clock = std::chrono::steady_clock;
+  auto seconds = [](clock::time_point begin) {
+    return std::chrono::duration<double>(clock::now() - begin).count();
+  };
+  vqe_batch_report report;
+  report.num_qpus = std::max<std::size_t>(get_platform().num_qpus(), 1);
+  const auto shots = optimizer.evaluation_shots();
+  const auto start = clock::now();
+  auto result = optimizer.optimize_batch(
+      n_params, [&](const std::vector<std::vector<double>> &xs) {
+        std::vector<std::tuple<std::vector<double>>> argumentSets(xs.begin(),
+                                                                  xs.end());
+        const auto batchStart = clock::now();
+        auto results =
+            shots ? cudaq::observe(shots, kernel, H, argumentSets)
+                  : cudaq::observe(kernel, H, argumentSets);
+        const double batchTime = seconds(batchStart);
+
+        report.batches++;
+        report.evaluations += xs.size();
+        report.evaluation_time += batchTime;
+        report.qpu_time += batchTime * std::min(xs.size(), report.num_qpus);
+        std::vector<double> energies(xs.size());
+        for (std::size_t i = 0; i < xs.size(); i++) {
+          energies[i] = results[i].exp_val_z();
+          if (energies[i] < report.best_energy) {
+            report.best_energy = energies[i];
+            report.best_parameters = xs[i];
+          }
+        }
+        if (options.checkpoint)
+          options.checkpoint(report.best_energy, report.best_parameters);
+        return energies;
+      });
+  report.wall_time = seconds(start);
+  if (options.report)
+    *options.report = std::move(report);
+  return result;
+}
+
+/// \brief One optimization of a multi-start VQE.
+struct vqe_trajectory {
+  /// \brief The parameters the optimizer started from, and the QPU that
+  /// evaluated its energies.
+  std::vector<double> initial_parameters;
+  std::size_t qpu_id = 0;
+
+  /// \brief The energy of every evaluation, in order.
+  std::vector<double> energies;
+
+  /// \brief The optimal value and parameters returned by the optimizer, or
+  /// the lowest energy evaluated and its parameters if it was stopped.
+  double optimal_value = std::numeric_limits<double>::infinity();
+  std::vector<double> optimal_parameters;
+
+  /// \brief True if the trajectory was stopped before its optimizer
+  /// finished, because it stalled or the stop predicate asked for it.
+  bool stopped = false;
+};
+
+/// \brief The result of a multi-start VQE: the best of the optimizations,
+/// and all of them in the order of their starts.
+struct vqe_multistart_result {
+  double optimal_value = std::numeric_limits<double>::infinity();
+  std::vector<double> optimal_parameters;
+  std::size_t best_start = 0;
+  std::vector<vqe_trajectory> trajectories;
+};
+
+/// \brief The options of a multi-start VQE.
+struct vqe_multistart_options {
+  /// \brief The initial parameters are drawn uniformly from
+  /// [lower_bound, upper_bound], with a random seed if none is given.
+  double lower_bound = -M_PI;
+  double upper_bound = M_PI;
+  std::optional<std::uint64_t> seed;
+
+  /// \brief The number of optimizations that run at once, by default one
+  /// per QPU of the platform.
+  std::size_t max_concurrent = 0;
+
+  /// \brief The shots of each energy evaluation, 0 for the platform default.
+  std::size_t shots = 0;
+
+  /// \brief If nonzero, a trajectory is stopped once its lowest energy has
+  /// not decreased by more than stall_tolerance for stall_evaluations
+  /// evaluations.
+  std::size_t stall_evaluations = 0;
+  double stall_tolerance = 1e-6;
+
+  /// \brief If set, called after every evaluation with the trajectory and
+  /// the lowest energy of all trajectories so far. Returning true stops the
+  /// trajectory, e.g. if it is far above the best one.
+  std::function<bool(const vqe_trajectory &, double)> stop;
+
+  /// \brief If set, called whenever the lowest energy of all trajectories
+  /// decreases, with that energy and its parameters, e.g. to write a
+  /// checkpoint. The calls do not overlap.
+  std::function<void(double, const std::vector<double> &)> checkpoint;
+};
+
+///
+/// \brief Compute the minimal eigenvalue of \p H with several VQE
+///        optimizations from random initial parameters, run concurrently.
+///
+/// \param kernel The ansatz, a quantum kernel callable, must have
+///        callable-type void(std::vector<double>) and no measures.
+/// \param H The hermitian cudaq::spin_op to compute the minimal eigenvalue for.
+/// \param optimizer_factory A callable that takes the initial parameters of
+///        an optimization and returns the gradient-free cudaq::optimizer, as
+///        a std::unique_ptr, that starts from them.
+/// \param n_params The number of variational parameters in the ansatz quantum
+///        kernel callable.
+/// \param n_starts The number of optimizations.
+/// \param options The initial parameter range, concurrency, stopping rules
+///        and checkpoint callback.
+/// \returns The best optimal value and parameters, and every trajectory.
+///
+/// \details Rugged energy landscapes need many initial parameters. The
+/// optimizations run on max_concurrent threads, each evaluating its energies
+/// with cudaq::observe_async on its own QPU (round robin over the QPUs of
+/// the platform), so that the optimizations keep all QPUs busy. The lowest
+/// energy evaluated by any of them is shared, for the stop predicate and
+/// the checkpoint. A stopped trajectory keeps its lowest energy. The
+/// optimizers are created up front on the calling thread, so the factory
+/// need not be thread-safe, but the optimizers themselves run concurrently.
+/// If an optimization throws, the others are stopped and the exception is
+/// rethrown.
+///
+/// Usage:
+/// \code{.cpp}
+/// auto result = cudaq::vqe_multistart(
+///     ansatz{}, H,
+///     [](const std::vector<double> &x0) {
+///       auto optimizer = std::make_unique<cudaq::optimizers::cobyla>();
+///       optimizer->initial_parameters = x0;
+///       return optimizer;
+///     },
+///     /*n_params*/ 4, /*n_starts*/ 64, {.seed = 7, .stall_evaluations = 50});
+/// printf("%lf from start %zu\n", result.optimal_value, result.best_start);
+/// \endcode
+///
+template <typename QuantumKernel, typename OptimizerFactory>
+vqe_multistart_result
+vqe_multistart(QuantumKernel &&kernel, cudaq::spin_op H,
+               OptimizerFactory &&optimizer_factory, const int n_params,
+               const std::size_t n_starts,
+               const vqe_multistart_options &options = {}) {
+  static_assert(std::is_invocable_v<QuantumKernel, std::vector<double>>,
+                "Invalid parameterized quantum kernel expression. Must have "
+                "void(std::vector<double>) signature.");
+  static_assert(std::is_invocable_r_v<std::unique_ptr<cudaq::optimizer>,
+                                      OptimizerFactory,
+                                      const std::vector<double> &>,
+                "Invalid optimizer factory. Must have "
+                "std::unique_ptr<cudaq::optimizer>(const std::vector<double> "
+                "&) signature.");
+  if (n_starts == 0)
+    throw std::invalid_argument("Multi-start VQE requires at least one start.");
+
+  vqe_multistart_result result;
+  result.trajectories.resize(n_starts);
+  std::mt19937_64 generator(options.seed ? *options.seed
+                                         : std::random_device{}());
+  std::uniform_real_distribution<double> distribution(options.lower_bound,
+                                                      options.upper_bound);
+  std::vector<std::unique_ptr<cudaq::optimizer>> optimizers;
+  for (auto &trajectory : result.trajectories) {
+    trajectory.initial_parameters.resize(n_params);
+    for (auto &parameter : trajectory.initial_parameters)
+      parameter = distribution(generator);
+    auto optimizer = optimizer_factory(trajectory.initial_parameters);
+    if (!optimizer)
+      throw std::invalid_argument("The optimizer factory returned no "
+                                  "cudaq::optimizer.");
+    if (optimizer->requiresGradients())
+      throw std::invalid_argument(
+          "Provided cudaq::optimizer requires gradients. "
+          "Multi-start VQE takes gradient-free optimizers.");
+    optimizers.push_back(std::move(optimizer));
+  }
+
+  const auto numQpus = std::max<std::size_t>(get_platform().num_qpus(), 1);
+  const auto numWorkers = std::min(
+      n_starts, options.max_concurrent ? options.max_concurrent : numQpus);
+
+  // The lowest energy of all trajectories, and the first error, guarded by
+  // the mutex.
+  std::mutex mutex;
+  double bestEnergy = std::numeric_limits<double>::infinity();
+  std::exception_ptr error;
+  std::atomic<bool> aborted = false;
+  std::atomic<std::size_t> nextStart = 0;
+
+  auto runTrajectory = [&](std::size_t start, std::size_t qpu,
+                           cudaq::spin_op &localH) {
+    auto &trajectory = result.trajectories[start];
+    trajectory.qpu_id = qpu;
+    double stallReference = std::numeric_limits<double>::infinity();
+    std::size_t lastImprovement = 0;
+    bool stopRequested = false;
+    try {
+      auto [value, parameters] = optimizers[start]->optimize(
+          n_params,
+          [&](const std::vector<double> &x, std::vector<double> &grad_vec) {
+            // The optimizers only see an exception, some of them rethrow a
+            // copy of it, so the reason to stop is kept here.
+            if (aborted) {
+              stopRequested = true;
+              throw std::runtime_error("Multi-start VQE was aborted.");
+            }
+            auto pending =
+                options.shots
+                    ? cudaq::observe_async(options.shots, qpu, kernel, localH,
+                                           x)
+                    : cudaq::observe_async(qpu, kernel, localH, x);
+            const double energy = pending.get().exp_val_z();
+            trajectory.energies.push_back(energy);
+            if (energy < trajectory.optimal_value) {
+              trajectory.optimal_value = energy;
+              trajectory.optimal_parameters = x;
+            }
+            if (energy < stallReference - options.stall_tolerance) {
+              stallReference = energy;
+              lastImprovement = trajectory.energies.size();
+            }
+
+            double best;
+            {
+              std::lock_guard<std::mutex> lock(mutex);
+              if (energy < bestEnergy) {
+                bestEnergy = energy;
+                if (options.checkpoint)
+                  options.checkpoint(energy, x);
+              }
+              best = bestEnergy;
+            }
+
+            const bool stalled =
+                options.stall_evaluations &&
+                trajectory.energies.size() - lastImprovement >=
+                    options.stall_evaluations;
+            if (stalled || (options.stop && options.stop(trajectory, best))) {
+              stopRequested = true;
+              throw std::runtime_error("Stopped the VQE trajectory.");
+            }
+            return energy;
+          });
+      // An optimizer may also return after the objective threw.
+      if (!stopRequested) {
+        trajectory.optimal_value = value;
+        trajectory.optimal_parameters = std::move(parameters);
+      }
+      trajectory.stopped = stopRequested;
+    } catch (...) {
+      if (stopRequested) {
+        trajectory.stopped = true;
+        return;
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error)
+        error = std::current_exception();
+      aborted = true;
+    }
+  };
+
+  auto worker = [&](std::size_t index) {
+    // The spin_op is not shared between threads.
+    cudaq::spin_op localH = H;
+    const auto qpu = index % numQpus;
+    for (std::size_t start = nextStart++; start < n_starts && !aborted;
+         start = nextStart++)
+      runTrajectory(start, qpu, localH);
+  };
+  std::vector<std::thread> threads;
+  for (std::size_t index = 1; index < numWorkers; index++)
+    threads.emplace_back(worker, index);
+  worker(0);
+  for (auto &thread : threads)
+    thread.join();
+  if (error)
+    std::rethrow_exception(error);
+
+  for (std::size_t start = 0; start < n_starts; start++) {
+    const auto &trajectory = result.trajectories[start];
+    if (trajectory.optimal_value < result.optimal_value) {
+      result.optimal_value = trajectory.optimal_value;
+      result.optimal_parameters = trajectory.optimal_parameters;
+      result.best_start = start;
+    }
+  }
+  return result;
+}
+
 } // namespace cudaq
@@ -132,6 +132,20 @@ QuakeValue QuakeValue::operator[](const std::size_t idx) {
   return QuakeValue(opBuilder, loaded);
 }
 
+QuakeValue QuakeValue::operator[](QuakeValue idx) {
+  Value vectorValue = value->asMLIR();
+  if (!vectorValue.getType().isa<quake::QVecType>())
+    throw std::runtime_error(
+        "Only a qreg QuakeValue can be indexed by a QuakeValue.");
+  Value indexValue = idx.getValue();
+  if (!indexValue.getType().isIntOrIndex())
+    throw std::runtime_error("A QuakeValue index must be an integer.");
+
+  Value extractedQubit =
+      opBuilder.create<quake::QExtractOp>(vectorValue, indexValue);
+  return QuakeValue(opBuilder, extractedQubit);
+}
+
 QuakeValue QuakeValue::slice(const std::size_t startIdx,
                              const std::size_t count) {
   Value vectorValue = value->asMLIR();
@@ -224,6 +238,13 @@ QuakeValue QuakeValue::operator+(const double constValue) {
   if (!v.getType().isIntOrFloat())
     throw std::runtime_error("Can only add double/float QuakeValues.");
 
+  if (v.getType().isa<IntegerType>()) {
+    Value constant = opBuilder.create<arith::ConstantIntOp>(
+        static_cast<std::int64_t>(constValue), v.getType());
+    Value added = opBuilder.create<arith::AddIOp>(v, constant);
+    return QuakeValue(opBuilder, added);
+  }
+
   llvm::APFloat d(constValue);
   Value constant =
       opBuilder.create<arith::ConstantFloatOp>(d, opBuilder.getF64Type());
@@ -249,6 +270,13 @@ QuakeValue QuakeValue::operator-(const double constValue) {
   if (!v.getType().isIntOrFloat())
     throw std::runtime_error("Can only subtract double/float QuakeValues.");
 
+  if (v.getType().isa<IntegerType>()) {
+    Value constant = opBuilder.create<arith::ConstantIntOp>(
+        static_cast<std::int64_t>(constValue), v.getType());
+    Value subtracted = opBuilder.create<arith::SubIOp>(v, constant);
+    return QuakeValue(opBuilder, subtracted);
+  }
+
   llvm::APFloat d(constValue);
   Value constant =
       opBuilder.create<arith::ConstantFloatOp>(d, opBuilder.getF64Type());
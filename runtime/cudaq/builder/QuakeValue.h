@@ -74,6 +74,10 @@ public:
   /// and QVecType.
   QuakeValue operator[](const std::size_t idx);
 
+  /// @brief Return the qubit of this QVecType QuakeValue at the index held by
+  /// the given integer QuakeValue, e.g. the index of a kernel_builder loop.
+  QuakeValue operator[](QuakeValue idx);
+
   /// @brief Negate this QuakeValue
   QuakeValue operator-();
 
@@ -83,13 +87,15 @@ public:
   /// @brief Multiply this QuakeValue by the given QuakeValue
   QuakeValue operator*(QuakeValue other);
 
-  /// @brief Add this QuakeValue with the given double.
+  /// @brief Add this QuakeValue with the given double. The double is
+  /// truncated to an integer if this QuakeValue is an integer.
   QuakeValue operator+(const double);
 
   /// @brief Add this QuakeValue with the given QuakeValue
   QuakeValue operator+(QuakeValue other);
 
-  /// @brief Subtract the given double from this QuakeValue
+  /// @brief Subtract the given double from this QuakeValue. The double is
+  /// truncated to an integer if this QuakeValue is an integer.
   QuakeValue operator-(const double);
 
   /// @brief Subtract the given QuakeValue from this QuakeValue
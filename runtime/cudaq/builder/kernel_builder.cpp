@@ -8,6 +8,7 @@
 
 #include "kernel_builder.h"
 #include "common/Logger.h"
+#include "common/Profiler.h"
 #include "common/RuntimeMLIR.h"
 #include "cudaq/Optimizer/Builder/Runtime.h"
 #include "cudaq/Optimizer/CodeGen/Passes.h"
@@ -16,6 +17,16 @@
 #include "cudaq/Optimizer/Dialect/Quake/QuakeDialect.h"
 #include "cudaq/Optimizer/Dialect/Quake/QuakeOps.h"
 #include "cudaq/Optimizer/Transforms/Passes.h"
+#include "cudaq/utils/registry.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/SHA256.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Affine/Passes.h"
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
@@ -31,7 +42,18 @@
 #include "mlir/Target/LLVMIR/ModuleTranslation.h"
 #include "mlir/Transforms/Passes.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
 #include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace mlir;
 
@@ -100,10 +122,195 @@ KernelBuilderType mapArgToType(cudaq::qreg<> &e) {
 
 MLIRContext *initializeContext() {
   cudaq::info("Initializing the MLIR infrastructure.");
-  return cudaq::initializeMLIR().release();
+  return cudaq::acquireMLIRContext();
+}
+void deleteContext(MLIRContext *context) {
+  cudaq::releaseMLIRContext(context);
+}
+
+namespace {
+/// @brief An ExecutionEngine shared by the builders of the same code.
+struct CachedEngine {
+  std::unique_ptr<ExecutionEngine> engine;
+  /// The name of the kernel the engine was compiled for, and its device code
+  std::string kernelName;
+  std::string deviceCode;
+  /// The number of builders using the engine
+  std::size_t users = 0;
+};
+
+/// @brief The process-wide cache of the ExecutionEngines of builder kernels,
+/// keyed by the hash of their Quake code with the kernel name canonicalized,
+/// so that builders of identical code are JIT compiled once. The engines in
+/// use are kept, and up to maxUnused of the unused ones, least recently used
+/// evicted first (CUDAQ_JIT_CACHE_SIZE, 32 by default).
+///
+/// If CUDAQ_JIT_CACHE_DIR is set, the optimized LLVM bitcode of the kernels
+/// is also written there, so that later processes skip the MLIR lowering and
+/// the LLVM optimization of the same code.
+struct JitCache {
+  std::unordered_map<std::string, CachedEngine> engines;
+  std::unordered_map<ExecutionEngine *, std::string> keys;
+  std::list<std::string> unused;
+  std::size_t maxUnused = 32;
+  std::string directory;
+
+  /// The names of the kernels registered for an engine compiled for another
+  /// name, the kernel registry keeps views of them.
+  std::deque<std::string> aliases;
+
+  /// The keys of the code being compiled, builders of the same code wait for
+  /// it to be compiled rather than compiling it again.
+  std::unordered_set<std::string> compiling;
+  std::condition_variable compiled;
+
+  /// Guards the cache, and the kernel registry that the engines update
+  std::mutex lock;
+
+  JitCache() {
+    if (auto *env = std::getenv("CUDAQ_JIT_CACHE_SIZE"))
+      maxUnused = std::strtoull(env, nullptr, 10);
+    if (auto *env = std::getenv("CUDAQ_JIT_CACHE_DIR")) {
+      std::error_code ec;
+      std::filesystem::create_directories(env, ec);
+      if (ec)
+        cudaq::info("Could not create the JIT cache directory {}: {}", env,
+                    ec.message());
+      else
+        directory = env;
+    }
+  }
+
+  /// @brief Drop the least recently used engines over the budget.
+  void evict() {
+    while (unused.size() > maxUnused) {
+      auto iter = engines.find(unused.back());
+      keys.erase(iter->second.engine.get());
+      engines.erase(iter);
+      unused.pop_back();
+    }
+  }
+};
+
+/// @brief Return the cache of this process, never destroyed since builders
+/// may outlive static destruction.
+JitCache &getJitCache() {
+  static auto *cache = new JitCache;
+  return *cache;
+}
+
+/// @brief Return the cache key of the kernel module: the hash of its code,
+/// with the name of the kernel replaced, and of what its compilation depends
+/// on.
+std::string getJitCacheKey(ModuleOp module, const std::string &properName,
+                           int optLevel,
+                           const std::vector<std::string> &extraLibPaths) {
+  std::string code;
+  llvm::raw_string_ostream os(code);
+  module.print(os);
+  os.flush();
+  const std::string placeholder = "__nvqppBuilderKernel";
+  for (auto pos = code.find(properName); pos != std::string::npos;
+       pos = code.find(properName, pos + placeholder.size()))
+    code.replace(pos, properName.size(), placeholder);
+
+  llvm::SHA256 hash;
+  hash.update(code);
+  hash.update(std::string(";") + LLVM_VERSION_STRING + ";" +
+              llvm::sys::getDefaultTargetTriple() + ";" +
+              llvm::sys::getHostCPUName().str() + ";O" +
+              std::to_string(optLevel));
+  for (auto &lib : extraLibPaths)
+    hash.update(";" + lib);
+  return llvm::toHex(hash.final(), /*LowerCase=*/true);
+}
+
+/// @brief Return the device code of the kernel the module was compiled for,
+/// which its init_func registers.
+std::string getDeviceCode(llvm::Module &module,
+                          const std::string &compiledName) {
+  auto *global = module.getGlobalVariable(
+      compiledName + "CodeHolder.extract_device_code", /*AllowInternal=*/true);
+  if (!global || !global->hasInitializer())
+    return {};
+  auto *data = dyn_cast<llvm::ConstantDataSequential>(global->getInitializer());
+  if (!data || !data->isCString())
+    return {};
+  return data->getAsCString().str();
+}
+
+/// @brief Register the kernel `properName` as the kernel `compiledName` of
+/// the engine, which has the same code under another name. The device code
+/// is that of the engine, since the registry may hold another kernel under
+/// `compiledName` when the engine was compiled by another process.
+void registerAlias(JitCache &cache, ExecutionEngine &engine,
+                   const std::string &compiledName,
+                   const std::string &properName, std::string code) {
+  for (auto pos = code.find(compiledName); pos != std::string::npos;
+       pos = code.find(compiledName, pos + properName.size()))
+    code.replace(pos, compiledName.size(), properName);
+
+  auto &name = cache.aliases.emplace_back(properName);
+  registry::deviceCodeHolderAdd(name.c_str(), code.c_str());
+  registry::cudaqRegisterKernelName(name.c_str());
+  auto argsCreator = engine.lookup(compiledName + ".argsCreator");
+  if (!argsCreator)
+    throw std::runtime_error(
+        "cudaq::builder failed to get argsCreator function.");
+  registry::cudaqRegisterArgsCreator(name.c_str(),
+                                     reinterpret_cast<char *>(*argsCreator));
+}
+
+/// @brief Write the bitcode of the module, compiled for the kernel, to the
+/// file. It is written to a temporary file first, so that concurrent
+/// processes never read a partial one.
+void writeBitcode(llvm::Module &module, const std::string &file,
+                  const std::string &kernelName) {
+  module.setSourceFileName(kernelName);
+  auto tmp = file + "." + std::to_string(llvm::sys::Process::getProcessId());
+  std::error_code ec;
+  {
+    llvm::raw_fd_ostream os(tmp, ec);
+    if (!ec) {
+      llvm::WriteBitcodeToFile(module, os);
+      os.close();
+      ec = os.error();
+    }
+  }
+  if (!ec)
+    std::filesystem::rename(tmp, file, ec);
+  if (ec) {
+    cudaq::info("Could not write the JIT cache file {}: {}", file,
+                ec.message());
+    std::filesystem::remove(tmp, ec);
+  }
+}
+
+/// @brief Return the name of the kernel the engine was compiled for.
+std::string getCompiledName(ExecutionEngine *jit,
+                            const std::string &properName) {
+  auto &cache = getJitCache();
+  std::lock_guard<std::mutex> l(cache.lock);
+  auto key = cache.keys.find(jit);
+  if (key == cache.keys.end())
+    return properName;
+  return cache.engines.at(key->second).kernelName;
+}
+} // namespace
+
+void deleteJitEngine(ExecutionEngine *jit) {
+  auto &cache = getJitCache();
+  std::lock_guard<std::mutex> l(cache.lock);
+  auto key = cache.keys.find(jit);
+  if (key == cache.keys.end()) {
+    delete jit;
+    return;
+  }
+  if (--cache.engines.at(key->second).users > 0)
+    return;
+  cache.unused.push_front(key->second);
+  cache.evict();
 }
-void deleteContext(MLIRContext *context) { delete context; }
-void deleteJitEngine(ExecutionEngine *jit) { delete jit; }
 
 ImplicitLocOpBuilder *
 initializeBuilder(MLIRContext *context,
@@ -152,6 +359,12 @@ bool isArgStdVec(std::vector<QuakeValue> &args, std::size_t idx) {
   return args[idx].isStdVec();
 }
 
+bool allArgsAreDouble(std::vector<QuakeValue> &args) {
+  return std::all_of(args.begin(), args.end(), [](QuakeValue &arg) {
+    return arg.getValue().getType().isF64();
+  });
+}
+
 void call(ImplicitLocOpBuilder &builder, std::string &name,
           std::string &quakeCode, std::vector<QuakeValue> &values) {
   // Create a ModuleOp from the other kernel's quake code
@@ -387,6 +600,140 @@ CUDAQ_ONE_QUBIT_PARAM_IMPL(ry, RyOp)
 CUDAQ_ONE_QUBIT_PARAM_IMPL(rz, RzOp)
 CUDAQ_ONE_QUBIT_PARAM_IMPL(r1, R1Op)
 
+static void forLoop(ImplicitLocOpBuilder &builder, Value start, Value end,
+                    std::function<void(QuakeValue &)> &body) {
+  auto indexTy = builder.getIndexType();
+  auto toIndex = [&](Value bound) -> Value {
+    if (bound.getType().isIndex())
+      return bound;
+    if (!bound.getType().isa<IntegerType>())
+      throw std::runtime_error("Invalid loop bound (must be integer type).");
+    return builder.create<arith::IndexCastOp>(indexTy, bound);
+  };
+  Value first = toIndex(start);
+  Value iterations = builder.create<arith::SubIOp>(toIndex(end), first);
+  // The body builds into the loop, since the kernel_builder methods use this
+  // builder, whose insertion point is in the loop body meanwhile.
+  cudaq::opt::factory::createCountedLoop(
+      builder, builder.getLoc(), iterations,
+      [&](OpBuilder &, Location, Region &, Block &block) {
+        Value index =
+            builder.create<arith::AddIOp>(first, block.getArgument(0));
+        QuakeValue iv(builder, builder.create<arith::IndexCastOp>(
+                                   builder.getI64Type(), index));
+        body(iv);
+      });
+}
+
+void forLoop(ImplicitLocOpBuilder &builder, std::size_t start, std::size_t end,
+             std::function<void(QuakeValue &)> &body) {
+  cudaq::info("kernel_builder loop from {} to {}", start, end);
+  forLoop(builder, builder.create<arith::ConstantIndexOp>(start),
+          builder.create<arith::ConstantIndexOp>(end), body);
+}
+
+void forLoop(ImplicitLocOpBuilder &builder, std::size_t start, QuakeValue &end,
+             std::function<void(QuakeValue &)> &body) {
+  cudaq::info("kernel_builder loop from {} to quake value", start);
+  forLoop(builder, builder.create<arith::ConstantIndexOp>(start),
+          end.getValue(), body);
+}
+
+void forLoop(ImplicitLocOpBuilder &builder, QuakeValue &start, QuakeValue &end,
+             std::function<void(QuakeValue &)> &body) {
+  cudaq::info("kernel_builder loop between quake values");
+  forLoop(builder, start.getValue(), end.getValue(), body);
+}
+
+void applyGates(ImplicitLocOpBuilder &builder, QuakeValue &qubits,
+                std::span<const gate_instruction> gates,
+                QuakeValue *parameters) {
+  cudaq::info("kernel_builder apply {} gates", gates.size());
+  Value qvec = qubits.getValue();
+  auto qvecTy = qvec.getType().dyn_cast<quake::QVecType>();
+  if (!qvecTy)
+    throw std::runtime_error("Gates can only be applied in bulk to a qreg.");
+  const std::size_t nQubits = qvecTy.hasSpecifiedSize() ? qvecTy.getSize() : 0;
+
+  // Each qubit, angle and parameter is created once, before its first use,
+  // and shared by the following gates.
+  std::unordered_map<std::int64_t, Value> qubitRefs;
+  auto getQubit = [&](std::int64_t index) {
+    if (index < 0 || (nQubits && std::size_t(index) >= nQubits))
+      throw std::runtime_error("Invalid qubit index " + std::to_string(index) +
+                               " in the gates applied to a qreg of " +
+                               std::to_string(nQubits) + " qubits.");
+    auto [iter, inserted] = qubitRefs.try_emplace(index);
+    if (inserted)
+      iter->second = builder.create<quake::QExtractOp>(
+          qvec, builder.create<arith::ConstantIntOp>(index, 64));
+    return iter->second;
+  };
+  std::unordered_map<double, Value> angles;
+  std::unordered_map<std::int64_t, Value> parameterValues;
+  auto getAngle = [&](const gate_instruction &gate) {
+    auto [iter, inserted] = angles.try_emplace(gate.angle);
+    if (inserted)
+      iter->second = builder.create<arith::ConstantFloatOp>(
+          llvm::APFloat(gate.angle), builder.getF64Type());
+    if (gate.parameter < 0)
+      return iter->second;
+    if (!parameters)
+      throw std::runtime_error(
+          "Gates with parameters require a list of parameters.");
+    auto [param, newParam] = parameterValues.try_emplace(gate.parameter);
+    if (newParam)
+      param->second = (*parameters)[gate.parameter].getValue();
+    return Value(builder.create<arith::MulFOp>(iter->second, param->second));
+  };
+
+  for (auto &gate : gates) {
+    Value target = getQubit(gate.target);
+    SmallVector<Value, 1> ctrls;
+    if (gate.control >= 0)
+      ctrls.push_back(getQubit(gate.control));
+    switch (gate.gate) {
+    case gate_instruction::h:
+      applyOneQubitOp<quake::HOp>(builder, ValueRange(), ctrls, target);
+      break;
+    case gate_instruction::s:
+    case gate_instruction::sdg:
+      applyOneQubitOp<quake::SOp>(builder, ValueRange(), ctrls, target,
+                                  gate.gate == gate_instruction::sdg);
+      break;
+    case gate_instruction::t:
+    case gate_instruction::tdg:
+      applyOneQubitOp<quake::TOp>(builder, ValueRange(), ctrls, target,
+                                  gate.gate == gate_instruction::tdg);
+      break;
+    case gate_instruction::x:
+      applyOneQubitOp<quake::XOp>(builder, ValueRange(), ctrls, target);
+      break;
+    case gate_instruction::y:
+      applyOneQubitOp<quake::YOp>(builder, ValueRange(), ctrls, target);
+      break;
+    case gate_instruction::z:
+      applyOneQubitOp<quake::ZOp>(builder, ValueRange(), ctrls, target);
+      break;
+    case gate_instruction::rx:
+      applyOneQubitOp<quake::RxOp>(builder, getAngle(gate), ctrls, target);
+      break;
+    case gate_instruction::ry:
+      applyOneQubitOp<quake::RyOp>(builder, getAngle(gate), ctrls, target);
+      break;
+    case gate_instruction::rz:
+      applyOneQubitOp<quake::RzOp>(builder, getAngle(gate), ctrls, target);
+      break;
+    case gate_instruction::r1:
+      applyOneQubitOp<quake::R1Op>(builder, getAngle(gate), ctrls, target);
+      break;
+    default:
+      throw std::runtime_error("Invalid gate " + std::to_string(gate.gate) +
+                               " in the gates applied to a qreg.");
+    }
+  }
+}
+
 template <typename QuakeMeasureOp>
 QuakeValue applyMeasure(ImplicitLocOpBuilder &builder, Value value,
                         std::string regName) {
@@ -501,6 +848,7 @@ ExecutionEngine *jitCode(ImplicitLocOpBuilder &builder, ExecutionEngine *jit,
     return jit;
 
   cudaq::info("kernel_builder running jitCode.");
+  cudaq::profiler::ScopedEvent event("jitCode", cudaq::profiler::Category::jit);
 
   auto block = builder.getBlock();
   if ((block->getOperations().empty() ||
@@ -530,44 +878,98 @@ ExecutionEngine *jitCode(ImplicitLocOpBuilder &builder, ExecutionEngine *jit,
     return WalkResult::advance();
   });
 
-  PassManager pm(context);
-  pm.addPass(createCanonicalizerPass());
-  OpPassManager &optPM = pm.nest<func::FuncOp>();
-  pm.addPass(cudaq::opt::createExpandMeasurementsPass());
-  pm.addPass(createCanonicalizerPass());
-  pm.addPass(cudaq::opt::createApplyOpSpecializationPass());
-  pm.addPass(cudaq::opt::createLoopUnrollPass());
-  pm.addPass(createCanonicalizerPass());
-  pm.addPass(createInlinerPass());
-  pm.addPass(createCanonicalizerPass());
-  pm.addPass(createCSEPass());
+  // Kernel names are __nvqpp__mlirgen__BuilderKernelPTRSTR
+  // for the following we want the proper name, BuilderKernelPTRST
+  std::string properName = name(kernelName);
 
-  // For some reason I get CFG ops from the LowerToCFGPass
-  // instead of the unrolled cc loop if I don't run
-  // the above manually.
-  if (failed(pm.run(module)))
-    throw std::runtime_error(
-        "cudaq::builder failed to JIT compile the Quake representation.");
+  // Reuse the engine of a builder of the same code, if any.
+  const int optLevel = cudaq::getJITOptLevel();
+  const auto key = getJitCacheKey(module, properName, optLevel, extraLibPaths);
+  auto &cache = getJitCache();
+  std::unique_lock<std::mutex> l(cache.lock);
+  cache.compiled.wait(l, [&]() { return !cache.compiling.count(key); });
+  if (auto iter = cache.engines.find(key); iter != cache.engines.end()) {
+    auto &cached = iter->second;
+    cudaq::info("- Reusing the JIT compiled kernel {}.", cached.kernelName);
+    if (cached.users++ == 0)
+      cache.unused.remove(key);
+    if (cached.kernelName != properName)
+      registerAlias(cache, *cached.engine, cached.kernelName, properName,
+                    cached.deviceCode);
+    return cached.engine.get();
+  }
 
-  // Continue on...
-  pm.addPass(createInlinerPass());
-  optPM.addPass(cudaq::opt::createQuakeAddDeallocs());
-  optPM.addPass(cudaq::opt::createQuakeAddMetadata());
-  pm.addPass(cudaq::opt::createGenerateDeviceCodeLoader(/*genAsQuake=*/true));
-  pm.addPass(cudaq::opt::createGenerateKernelExecution());
-  optPM.addPass(cudaq::opt::createLowerToCFGPass());
-  pm.addPass(createCanonicalizerPass());
-  pm.addPass(createCSEPass());
-  pm.addPass(cudaq::opt::createConvertToQIRPass());
+  // Compile the code without holding the lock, so that builders of other
+  // code compile concurrently. If the compilation fails, the builders
+  // waiting for it compile the code themselves.
+  cache.compiling.insert(key);
+  l.unlock();
+  auto doneCompiling = llvm::make_scope_exit([&]() {
+    if (!l.owns_lock())
+      l.lock();
+    cache.compiling.erase(key);
+    cache.compiled.notify_all();
+  });
 
-  if (failed(pm.run(module)))
-    throw std::runtime_error(
-        "cudaq::builder failed to JIT compile the Quake representation.");
+  // Read the bitcode of the same code compiled by a previous process, if any.
+  std::string bitcode;
+  std::string bitcodeFile;
+  if (!cache.directory.empty()) {
+    bitcodeFile =
+        (std::filesystem::path(cache.directory) / (key + ".bc")).string();
+    std::ifstream is(bitcodeFile, std::ios::binary);
+    if (is)
+      bitcode.assign(std::istreambuf_iterator<char>(is),
+                     std::istreambuf_iterator<char>());
+  }
 
-  cudaq::info("- Pass manager was applied.");
+  auto lower = [&]() {
+    PassManager pm(context);
+    pm.addPass(createCanonicalizerPass());
+    OpPassManager &optPM = pm.nest<func::FuncOp>();
+    pm.addPass(cudaq::opt::createExpandMeasurementsPass());
+    pm.addPass(createCanonicalizerPass());
+    pm.addPass(cudaq::opt::createApplyOpSpecializationPass());
+    pm.addPass(cudaq::opt::createLoopUnrollPass());
+    pm.addPass(createCanonicalizerPass());
+    pm.addPass(createInlinerPass());
+    pm.addPass(createCanonicalizerPass());
+    pm.addNestedPass<func::FuncOp>(cudaq::opt::createQuakeOpCancellationPass());
+    pm.addPass(createCSEPass());
+
+    // For some reason I get CFG ops from the LowerToCFGPass
+    // instead of the unrolled cc loop if I don't run
+    // the above manually.
+    if (failed(pm.run(module)))
+      throw std::runtime_error(
+          "cudaq::builder failed to JIT compile the Quake representation.");
+
+    // Continue on...
+    pm.addPass(createInlinerPass());
+    optPM.addPass(cudaq::opt::createQuakeAddDeallocs());
+    optPM.addPass(cudaq::opt::createQuakeAddMetadata());
+    pm.addPass(
+        cudaq::opt::createGenerateDeviceCodeLoader(/*genAsQuake=*/true));
+    pm.addPass(cudaq::opt::createGenerateKernelExecution());
+    optPM.addPass(cudaq::opt::createLowerToCFGPass());
+    pm.addPass(createCanonicalizerPass());
+    pm.addPass(createCSEPass());
+    pm.addPass(cudaq::opt::createConvertToQIRPass());
+
+    if (failed(pm.run(module)))
+      throw std::runtime_error(
+          "cudaq::builder failed to JIT compile the Quake representation.");
+
+    cudaq::info("- Pass manager was applied.");
+  };
+  if (bitcode.empty())
+    lower();
+
+  // The name of the kernel the code was compiled for, that of a previous
+  // process if read from its bitcode, and its device code.
+  std::string compiledName = properName;
+  std::string deviceCode;
   ExecutionEngineOptions opts;
-  opts.transformer = [](llvm::Module *m) { return llvm::ErrorSuccess(); };
-  opts.jitCodeGenOptLevel = llvm::CodeGenOpt::None;
   SmallVector<StringRef, 4> sharedLibs;
   for (auto &lib : extraLibPaths) {
     cudaq::info("Extra library loaded: {}", lib);
@@ -575,33 +977,73 @@ ExecutionEngine *jitCode(ImplicitLocOpBuilder &builder, ExecutionEngine *jit,
   }
   opts.sharedLibPaths = sharedLibs;
   opts.llvmModuleBuilder =
-      [](Operation *module,
-         llvm::LLVMContext &llvmContext) -> std::unique_ptr<llvm::Module> {
+      [&](Operation *module,
+          llvm::LLVMContext &llvmContext) -> std::unique_ptr<llvm::Module> {
     llvmContext.setOpaquePointers(false);
+    if (!bitcode.empty()) {
+      auto llvmModule = llvm::parseBitcodeFile(
+          llvm::MemoryBufferRef(bitcode, bitcodeFile), llvmContext);
+      if (!llvmModule) {
+        cudaq::info("Could not read the JIT cache file {}: {}", bitcodeFile,
+                    llvm::toString(llvmModule.takeError()));
+        return nullptr;
+      }
+      compiledName = (*llvmModule)->getSourceFileName();
+      deviceCode = getDeviceCode(**llvmModule, compiledName);
+      return std::move(*llvmModule);
+    }
+
     auto llvmModule = translateModuleToLLVMIR(module, llvmContext);
     if (!llvmModule) {
       llvm::errs() << "Failed to emit LLVM IR\n";
       return nullptr;
     }
     ExecutionEngine::setupTargetTriple(llvmModule.get());
+
+    // Optimize the classical code of the kernel (loops, parameter arithmetic,
+    // QIR bookkeeping) for the host CPU at the level of CUDAQ_JIT_OPT_LEVEL.
+    if (optLevel > 0) {
+      try {
+        cudaq::optimizeLLVM(llvmModule.get(), optLevel);
+      } catch (std::exception &e) {
+        llvm::errs() << e.what() << "\n";
+        return nullptr;
+      }
+    }
+    deviceCode = getDeviceCode(*llvmModule, properName);
+    if (!bitcodeFile.empty())
+      writeBitcode(*llvmModule, bitcodeFile, properName);
     return llvmModule;
   };
+  opts.jitCodeGenOptLevel = static_cast<llvm::CodeGenOpt::Level>(optLevel);
 
   cudaq::info(" - Creating the MLIR ExecutionEngine");
   auto jitOrError = ExecutionEngine::create(module, opts);
-  assert(!!jitOrError);
+  if (!jitOrError && !bitcode.empty()) {
+    // The cached bitcode is unusable, compile the code again.
+    llvm::consumeError(jitOrError.takeError());
+    std::error_code ec;
+    std::filesystem::remove(bitcodeFile, ec);
+    bitcode.clear();
+    compiledName = properName;
+    lower();
+    jitOrError = ExecutionEngine::create(module, opts);
+  }
+  if (!jitOrError)
+    throw std::runtime_error(
+        "cudaq::builder failed to create the JIT ExecutionEngine: " +
+        llvm::toString(jitOrError.takeError()));
 
   auto uniqueJit = std::move(jitOrError.get());
-  jit = uniqueJit.release();
+  jit = uniqueJit.get();
 
   cudaq::info("- JIT Engine created successfully.");
 
-  // Kernel names are __nvqpp__mlirgen__BuilderKernelPTRSTR
-  // for the following we want the proper name, BuilderKernelPTRST
-  std::string properName = name(kernelName);
+  // The kernel registration is not thread safe.
+  l.lock();
 
   // Need to first invoke the init_func()
-  auto kernelInitFunc = properName + ".init_func";
+  auto kernelInitFunc = compiledName + ".init_func";
   auto initFuncPtr = jit->lookup(kernelInitFunc);
   if (!initFuncPtr) {
     throw std::runtime_error(
@@ -611,7 +1053,7 @@ ExecutionEngine *jitCode(ImplicitLocOpBuilder &builder, ExecutionEngine *jit,
   kernelInit();
 
   // Need to first invoke the kernelRegFunc()
-  auto kernelRegFunc = properName + ".kernelRegFunc";
+  auto kernelRegFunc = compiledName + ".kernelRegFunc";
   auto regFuncPtr = jit->lookup(kernelRegFunc);
   if (!regFuncPtr) {
     throw std::runtime_error(
@@ -620,47 +1062,122 @@ ExecutionEngine *jitCode(ImplicitLocOpBuilder &builder, ExecutionEngine *jit,
   auto kernelReg = reinterpret_cast<void (*)()>(*regFuncPtr);
   kernelReg();
 
+  // Share the engine with the builders of the same code.
+  auto &cached = cache.engines[key];
+  cached.engine = std::move(uniqueJit);
+  cached.kernelName = compiledName;
+  cached.deviceCode = deviceCode;
+  cached.users = 1;
+  cache.keys[jit] = key;
+  if (compiledName != properName)
+    registerAlias(cache, *jit, compiledName, properName, deviceCode);
+
   return jit;
 }
 
-void invokeCode(ImplicitLocOpBuilder &builder, ExecutionEngine *jit,
-                std::string kernelName, void **argsArray,
-                std::vector<std::string> extraLibPaths) {
+void precompile(const std::vector<kernel_builder_base *> &builders) {
+  // A builder is compiled by one thread only.
+  auto kernels = builders;
+  std::sort(kernels.begin(), kernels.end());
+  kernels.erase(std::unique(kernels.begin(), kernels.end()), kernels.end());
+
+  const std::size_t nThreads = std::min<std::size_t>(
+      std::max(std::thread::hardware_concurrency(), 1u), kernels.size());
+  std::atomic<std::size_t> next = 0;
+  std::mutex errorLock;
+  std::exception_ptr error;
+  auto worker = [&]() {
+    for (auto i = next++; i < kernels.size(); i = next++) {
+      try {
+        kernels[i]->jitCode();
+      } catch (...) {
+        std::lock_guard<std::mutex> l(errorLock);
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  };
 
+  cudaq::info("Precompiling {} kernels on {} threads.", kernels.size(),
+              nThreads);
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < nThreads; i++)
+    threads.emplace_back(worker);
+  worker();
+  for (auto &thread : threads)
+    thread.join();
+  if (error)
+    std::rethrow_exception(error);
+}
+
+JitKernel resolveKernel(ExecutionEngine *jit, std::string kernelName,
+                        std::vector<QuakeValue> &arguments) {
   assert(jit != nullptr && "JIT ExecutionEngine was null.");
-  cudaq::info("kernel_builder invoke kernel with args.");
 
   // Kernel names are __nvqpp__mlirgen__BuilderKernelPTRSTR
   // for the following we want the proper name, BuilderKernelPTRST
-  std::string properName = name(kernelName);
+  JitKernel kernel;
+  kernel.name = name(kernelName);
+  kernel.numArgs = arguments.size();
+  kernel.allArgsAreDouble = allArgsAreDouble(arguments);
 
-  // Incoming Args... have been converted to void **,
-  // now we convert to void * altLaunchKernel args.
-  auto argCreatorName = properName + ".argsCreator";
+  // The engine may have been compiled for another builder of the same code,
+  // its functions are named after that kernel.
+  auto compiledName = getCompiledName(jit, kernel.name);
+
+  auto argCreatorName = compiledName + ".argsCreator";
   auto expectedPtr = jit->lookup(argCreatorName);
   if (!expectedPtr) {
     throw std::runtime_error(
         "cudaq::builder failed to get argsCreator function.");
   }
-  auto argsCreator =
+  kernel.argsCreator =
       reinterpret_cast<std::size_t (*)(void **, void **)>(*expectedPtr);
-  void *rawArgs = nullptr;
-  [[maybe_unused]] auto size = argsCreator(argsArray, &rawArgs);
 
   //  Extract the entry point, which we named.
-  auto thunkName = properName + ".thunk";
+  auto thunkName = compiledName + ".thunk";
   auto thunkPtr = jit->lookup(thunkName);
   if (!thunkPtr) {
     throw std::runtime_error("cudaq::builder failed to get thunk function");
   }
+  kernel.thunk = reinterpret_cast<void (*)(void *)>(*thunkPtr);
+  return kernel;
+}
 
-  // Invoke and free the args memory.
-  auto thunk = reinterpret_cast<void (*)(void *)>(*thunkPtr);
+void invokeCode(JitKernel &kernel, void **argsArray) {
+  cudaq::info("kernel_builder invoke kernel with args.");
 
-  altLaunchKernel(properName.data(), thunk, rawArgs, size);
+  // Incoming Args... have been converted to void **,
+  // now we convert to void * altLaunchKernel args.
+  void *rawArgs = nullptr;
+  [[maybe_unused]] auto size = kernel.argsCreator(argsArray, &rawArgs);
+
+  // Invoke and free the args memory.
+  altLaunchKernel(kernel.name.data(), kernel.thunk, rawArgs, size);
   std::free(rawArgs);
 }
 
+void invokeCode(JitKernel &kernel, std::span<const double> args) {
+  if (!kernel.allArgsAreDouble)
+    throw std::runtime_error(
+        "cudaq::builder invoke requires a kernel whose arguments are all "
+        "doubles.");
+  if (args.size() != kernel.numArgs)
+    throw std::runtime_error("Kernel requires " +
+                             std::to_string(kernel.numArgs) +
+                             " arguments but " + std::to_string(args.size()) +
+                             " provided.");
+
+  // The argument buffer of such kernels is the array of the values. They are
+  // copied, since the thunk may write to its buffer, to a buffer of the
+  // thread that is allocated once.
+  thread_local std::vector<double> buffer;
+  buffer.assign(args.begin(), args.end());
+  buffer.resize(std::max<std::size_t>(args.size(), 1));
+  altLaunchKernel(kernel.name.data(), kernel.thunk, buffer.data(),
+                  args.size() * sizeof(double));
+}
+
 std::string to_quake(ImplicitLocOpBuilder &builder) {
   // Add return if not there.
   auto *block = builder.getBlock();
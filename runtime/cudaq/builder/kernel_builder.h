@@ -11,11 +11,14 @@
 #include "cudaq/qis/modifiers.h"
 #include "cudaq/qis/qreg.h"
 #include "cudaq/utils/cudaq_utils.h"
+#include <concepts>
+#include <cstdint>
 #include <cstring>
 #include <functional>
 #include <map>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <variant>
 #include <vector>
@@ -39,6 +42,23 @@ using namespace mlir;
 namespace cudaq {
 std::string get_quake_by_name(const std::string &);
 
+/// @brief One gate of a list of gates appended to a kernel in one call, see
+/// kernel_builder::apply_gates(). The qubits are indices into a qreg.
+struct gate_instruction {
+  /// @brief The gate, `sdg` and `tdg` being the adjoints of `s` and `t`.
+  enum kind : std::uint8_t { h, s, t, x, y, z, sdg, tdg, rx, ry, rz, r1 };
+  kind gate = h;
+  /// @brief The target qubit.
+  std::int64_t target = 0;
+  /// @brief The control qubit, or -1 for none.
+  std::int64_t control = -1;
+  /// @brief The rotation angle, times the parameter if there is one.
+  double angle = 0.0;
+  /// @brief The index of the parameter in the list of parameters, or -1 for
+  /// a constant angle.
+  std::int64_t parameter = -1;
+};
+
 /// @brief Define a floating point concept
 template <typename T>
 concept NumericType = requires(T param) { std::is_floating_point_v<T>; };
@@ -173,6 +193,22 @@ CUDAQ_DETAILS_MEASURE_DECLARATION(mz)
 void c_if(ImplicitLocOpBuilder &builder, QuakeValue &conditional,
           std::function<void()> &thenFunctor);
 
+/// @brief Apply the body to each integer index in [start, end), in a counted
+/// loop kept in the Quake code. The loop unrolling pass unrolls it if its
+/// number of iterations is constant and below its threshold.
+void forLoop(ImplicitLocOpBuilder &builder, std::size_t start, std::size_t end,
+             std::function<void(QuakeValue &)> &body);
+void forLoop(ImplicitLocOpBuilder &builder, std::size_t start, QuakeValue &end,
+             std::function<void(QuakeValue &)> &body);
+void forLoop(ImplicitLocOpBuilder &builder, QuakeValue &start, QuakeValue &end,
+             std::function<void(QuakeValue &)> &body);
+
+/// @brief Append the gates to the kernel, on the qubits of `qubits`. The
+/// parameters, if any, are a list of floats.
+void applyGates(ImplicitLocOpBuilder &builder, QuakeValue &qubits,
+                std::span<const gate_instruction> gates,
+                QuakeValue *parameters);
+
 /// @brief Return the name of this kernel_builder,
 /// it is also the name of the function
 std::string name(std::string_view kernelName);
@@ -186,10 +222,32 @@ ExecutionEngine *jitCode(ImplicitLocOpBuilder &builder, ExecutionEngine *jit,
                          std::string kernelName,
                          std::vector<std::string> extraLibPaths);
 
-/// @brief Invoke the function with the given kernel name.
-void invokeCode(ImplicitLocOpBuilder &builder, ExecutionEngine *jit,
-                std::string kernelName, void **argsArray,
-                std::vector<std::string> extraLibPaths);
+/// @brief The entry points of a JIT compiled kernel, looked up once.
+struct JitKernel {
+  /// The name the kernel is launched with
+  std::string name;
+
+  /// Packs the `void **` arguments into the argument buffer of the thunk
+  std::size_t (*argsCreator)(void **, void **) = nullptr;
+  void (*thunk)(void *) = nullptr;
+
+  /// The number of arguments, and whether they are all doubles, whose
+  /// argument buffer is then the array of their values
+  std::size_t numArgs = 0;
+  bool allArgsAreDouble = false;
+};
+
+/// @brief Look up the entry points of the kernel with the given name in the
+/// engine.
+JitKernel resolveKernel(ExecutionEngine *jit, std::string kernelName,
+                        std::vector<QuakeValue> &arguments);
+
+/// @brief Invoke the kernel with the given arguments.
+void invokeCode(JitKernel &kernel, void **argsArray);
+
+/// @brief Invoke the kernel whose arguments are all doubles with their
+/// values, without packing them.
+void invokeCode(JitKernel &kernel, std::span<const double> args);
 
 /// @brief Invoke the provided kernel function.
 void call(ImplicitLocOpBuilder &builder, std::string &name,
@@ -211,6 +269,9 @@ std::string to_quake(ImplicitLocOpBuilder &builder);
 /// is a `cc::StdvecType`. Returns `false` otherwise.
 bool isArgStdVec(std::vector<QuakeValue> &args, std::size_t idx);
 
+/// @brief Return true if all the arguments are doubles.
+bool allArgsAreDouble(std::vector<QuakeValue> &args);
+
 /// @brief The ArgumentValidator provides a way validate the input
 /// Args... when the kernel is invoked (via a fold expression).
 template <typename T>
@@ -257,6 +318,10 @@ public:
   virtual ~kernel_builder_base() = default;
 };
 
+/// @brief JIT compile the kernels concurrently, on a thread per core. The
+/// first error is thrown once all are done.
+void precompile(const std::vector<kernel_builder_base *> &kernels);
+
 } // namespace details
 
 template <class... Ts>
@@ -288,6 +353,10 @@ private:
   /// out of CUDA Quantum code
   std::unique_ptr<ExecutionEngine, void (*)(ExecutionEngine *)> jitEngine;
 
+  /// @brief The entry points of the JIT compiled kernel, looked up on its
+  /// first invocation.
+  std::optional<details::JitKernel> jitKernel;
+
   /// @brief Name of the CUDA Quantum kernel quake function
   std::string kernelName = "__nvqpp__mlirgen____nvqppBuilderKernel";
 
@@ -320,8 +389,12 @@ public:
     return details::isArgStdVec(arguments, idx);
   }
 
+  /// @brief Return `true` if all the arguments to the kernel are doubles,
+  /// which invoke() then takes without packing them.
+  bool allArgsAreDouble() { return details::allArgsAreDouble(arguments); }
+
   /// @brief Return the name of this kernel
-  std::string name() { return details::name(kernelName); }
+  std::string name() const { return details::name(kernelName); }
 
   /// @brief Return the number of function arguments.
   /// @return
@@ -451,6 +524,34 @@ public:
   CUDAQ_BUILDER_ADD_MEASURE(my)
   CUDAQ_BUILDER_ADD_MEASURE(mz)
 
+  /// @brief Apply the body to each index in [start, end), e.g. to repeat a
+  /// layer of gates. The body is built once, into a loop which is only
+  /// unrolled by the JIT compilation if it is short enough. The index is an
+  /// integer QuakeValue, which can index a qreg.
+  void for_loop(std::size_t start, std::size_t end,
+                std::function<void(QuakeValue &)> &&body) {
+    details::forLoop(*opBuilder, start, end, body);
+  }
+  void for_loop(std::size_t start, QuakeValue end,
+                std::function<void(QuakeValue &)> &&body) {
+    details::forLoop(*opBuilder, start, end, body);
+  }
+  void for_loop(QuakeValue start, QuakeValue end,
+                std::function<void(QuakeValue &)> &&body) {
+    details::forLoop(*opBuilder, start, end, body);
+  }
+
+  /// @brief Append the gates, e.g. of a generated circuit, on the qubits of
+  /// the qreg in one call. Each qubit, constant and parameter is materialized
+  /// once and shared by all the gates that use it. The rotation angles are
+  /// scaled by elements of `parameters`, a list of floats, if given.
+  void apply_gates(QuakeValue &qubits,
+                   std::span<const gate_instruction> gates,
+                   std::optional<QuakeValue> parameters = std::nullopt) {
+    details::applyGates(*opBuilder, qubits, gates,
+                        parameters ? &*parameters : nullptr);
+  }
+
   /// @brief Apply a conditional statement on a
   /// measure result, if true apply the thenFunctor.
   void c_if(QuakeValue result, std::function<void()> &&thenFunctor) {
@@ -558,9 +659,24 @@ public:
   /// @brief Invoke jitCode and extract a function pointer and execute.
   void jitAndInvoke(void **argsArray,
                     std::vector<std::string> extraLibPaths = {}) {
-    jitCode(extraLibPaths);
-    details::invokeCode(*opBuilder, jitEngine.get(), kernelName, argsArray,
-                        extraLibPaths);
+    details::invokeCode(getJitKernel(extraLibPaths), argsArray);
+  }
+
+  /// @brief Execute the kernel whose arguments are all doubles with their
+  /// values, which are not packed, for kernels invoked repeatedly.
+  void invoke(std::span<const double> args) {
+    details::invokeCode(getJitKernel(), args);
+  }
+
+  /// @brief Return the entry points of the JIT compiled kernel.
+  details::JitKernel &
+  getJitKernel(std::vector<std::string> extraLibPaths = {}) {
+    if (!jitKernel) {
+      jitCode(extraLibPaths);
+      jitKernel =
+          details::resolveKernel(jitEngine.get(), kernelName, arguments);
+    }
+    return *jitKernel;
   }
 
   /// @brief The call operator for the kernel_builder,
@@ -609,6 +725,21 @@ struct tuple_element<N, cudaq::kernel_builder<Args...>> {
 
 namespace cudaq {
 
+/// @brief JIT compile the given kernel_builders concurrently, e.g. at
+/// startup, so that their first invocations do not compile them. Builders of
+/// the same code are compiled once.
+template <typename... Kernels>
+  requires(std::derived_from<Kernels, details::kernel_builder_base> && ...)
+void precompile(Kernels &...kernels) {
+  details::precompile({&kernels...});
+}
+
+/// @brief JIT compile the given kernel_builders concurrently.
+inline void
+precompile(const std::vector<details::kernel_builder_base *> &kernels) {
+  details::precompile(kernels);
+}
+
 /// @brief Return a new kernel_builder that takes no arguments
 inline auto make_kernel() {
   std::vector<details::KernelBuilderType> empty;
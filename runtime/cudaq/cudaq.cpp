@@ -148,6 +148,11 @@ void unset_noise() {
   auto &platform = cudaq::get_platform();
   platform.set_noise(nullptr);
 }
+
+void set_random_seed(std::size_t seed) {
+  auto &platform = cudaq::get_platform();
+  platform.set_random_seed(seed);
+}
 } // namespace cudaq
 
 namespace cudaq::support {
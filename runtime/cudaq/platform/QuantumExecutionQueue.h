@@ -10,11 +10,14 @@
 
 #include "common/MeasureCounts.h"
 #include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <future>
-#include <queue>
+#include <map>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace cudaq {
 
@@ -24,29 +27,88 @@ namespace cudaq {
 /// instance being provided and set.
 using QuantumTask = std::function<void()>;
 
-/// The QuantumExecutionQueue provides a queue running on a
-/// separate thread from the main CUDA Quantum host thread that clients
+/// @brief How a task is scheduled on the execution queue.
+struct QuantumTaskOptions {
+  /// @brief Tasks of higher priority run first, tasks of equal priority in
+  /// the order they were enqueued.
+  int priority = 0;
+
+  /// @brief Queued tasks of the same priority and non-empty batch key are
+  /// compatible: the worker that takes the first one takes the others too,
+  /// and runs them together.
+  std::string batchKey;
+};
+
+/// @brief Run a batch of compatible tasks, e.g. as one batch job.
+using QuantumTaskBatchHandler = std::function<void(std::vector<QuantumTask> &)>;
+
+/// The QuantumExecutionQueue provides a queue running on
+/// separate threads from the main CUDA Quantum host thread that clients
 /// can submit execution tasks to, and these tasks will be executed
-/// (asynchronously from the calling thread) in the order they are submitted.
+/// (asynchronously from the calling thread) by priority, then in the order
+/// they are submitted. With a single worker, the default, tasks run one at a
+/// time; QPUs whose tasks mostly wait on I/O can have many in flight.
 class QuantumExecutionQueue {
 public:
-  /// The Constructor
-  QuantumExecutionQueue();
+  /// The Constructor, starts the given number of workers
+  QuantumExecutionQueue(std::size_t numWorkers = 1);
   /// The Destructor
   ~QuantumExecutionQueue();
 
   /// Enqueue a Sampling task.
   void enqueue(QuantumTask &task);
 
+  /// @brief Enqueue a task with the given priority and batch key.
+  void enqueue(QuantumTask &task, const QuantumTaskOptions &options);
+
+  /// @brief Start or stop workers to have `n` of them. Stopped workers
+  /// finish their current task first, so this must not be called from a
+  /// task of this queue.
+  void setNumWorkers(std::size_t n);
+
+  /// @brief Return the number of workers.
+  std::size_t getNumWorkers();
+
+  /// @brief Coalesce the queued tasks of the batch key by at most
+  /// `maxBatchSize` and run every batch with the handler. Batches of keys
+  /// without a handler run one task after the other on the same worker.
+  void setBatchHandler(const std::string &batchKey,
+                       QuantumTaskBatchHandler handler,
+                       std::size_t maxBatchSize = 64);
+
 protected:
+  /// @brief A queued task, ordered by decreasing priority then by the order
+  /// of submission.
+  struct QueuedTask {
+    QuantumTask task;
+    std::string batchKey;
+  };
+  using QueueKey = std::pair<int, std::uint64_t>;
+
+  /// @brief The handler and the batch size of a batch key.
+  struct BatchHandler {
+    QuantumTaskBatchHandler handler;
+    std::size_t maxBatchSize = 64;
+  };
+
   /// The mutex, used for locking when adding to the queue
   std::mutex lock;
 
-  /// The thread this queue executes on
-  std::thread thread;
+  /// @brief Serializes the changes of the number of workers.
+  std::mutex workersLock;
+
+  /// The threads this queue executes on
+  std::vector<std::thread> threads;
+
+  /// @brief The number of workers requested, workers of a higher index
+  /// exit.
+  std::size_t numWorkers = 0;
+
+  /// The execution queue, keyed by negated priority and submission order
+  std::map<QueueKey, QueuedTask> queue;
+  std::uint64_t submitted = 0;
 
-  /// The execution queue
-  std::queue<QuantumTask> queue;
+  std::unordered_map<std::string, BatchHandler> batchHandlers;
 
   /// The condition variable used for notifying listeners
   std::condition_variable cv;
@@ -54,8 +116,8 @@ protected:
   /// Should we quit this thread?
   bool quit = false;
 
-  /// Main execution thread, loops until destruction,
-  /// continuously pops tasks off the queue and executes them
-  void handler(void);
+  /// Main execution thread of the worker of the given index, loops until
+  /// destruction, continuously pops tasks off the queue and executes them
+  void handler(std::size_t worker);
 };
 } // namespace cudaq
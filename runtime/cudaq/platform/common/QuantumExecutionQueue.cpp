@@ -8,10 +8,14 @@
 
 #include "cudaq/platform/QuantumExecutionQueue.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace cudaq {
 
-QuantumExecutionQueue::QuantumExecutionQueue() : lock() {
-  thread = std::thread(&QuantumExecutionQueue::handler, this);
+QuantumExecutionQueue::QuantumExecutionQueue(std::size_t numWorkers)
+    : lock() {
+  setNumWorkers(numWorkers);
 }
 
 QuantumExecutionQueue::~QuantumExecutionQueue() {
@@ -19,37 +23,97 @@ QuantumExecutionQueue::~QuantumExecutionQueue() {
   quit = true;
   cv.notify_all();
   l.unlock();
-  if (thread.joinable()) {
-    thread.join();
-  }
+  for (auto &thread : threads)
+    if (thread.joinable())
+      thread.join();
 }
 
-void QuantumExecutionQueue::enqueue(QuantumTask &t) {
+void QuantumExecutionQueue::enqueue(QuantumTask &t) { enqueue(t, {}); }
+
+void QuantumExecutionQueue::enqueue(QuantumTask &t,
+                                    const QuantumTaskOptions &options) {
   std::unique_lock<std::mutex> l(lock);
-  queue.push(t);
+  queue.emplace(QueueKey{-options.priority, submitted++},
+                QueuedTask{t, options.batchKey});
   cv.notify_one();
-  return;
 }
 
-void QuantumExecutionQueue::handler(void) {
+void QuantumExecutionQueue::setNumWorkers(std::size_t n) {
+  if (n == 0)
+    throw std::runtime_error("An execution queue needs at least one worker.");
+  std::lock_guard<std::mutex> workers(workersLock);
+  std::unique_lock<std::mutex> l(lock);
+  numWorkers = n;
+  for (std::size_t i = threads.size(); i < n; i++)
+    threads.emplace_back(&QuantumExecutionQueue::handler, this, i);
+  if (threads.size() == n)
+    return;
+  cv.notify_all();
+  l.unlock();
+  for (std::size_t i = n; i < threads.size(); i++)
+    threads[i].join();
+  threads.resize(n);
+}
+
+std::size_t QuantumExecutionQueue::getNumWorkers() {
+  std::lock_guard<std::mutex> l(lock);
+  return numWorkers;
+}
+
+void QuantumExecutionQueue::setBatchHandler(const std::string &batchKey,
+                                            QuantumTaskBatchHandler handler,
+                                            std::size_t maxBatchSize) {
+  std::lock_guard<std::mutex> l(lock);
+  batchHandlers[batchKey] = BatchHandler{std::move(handler),
+                                         std::max<std::size_t>(maxBatchSize, 1)};
+}
+
+void QuantumExecutionQueue::handler(std::size_t worker) {
   std::unique_lock<std::mutex> l(lock);
 
   do {
     // Wait until we have data or a quit signal
-    cv.wait(l, [this] { return (queue.size() || quit); });
+    cv.wait(l, [&] { return queue.size() || quit || worker >= numWorkers; });
 
     // after wait, we own the lock
-    if (!quit && queue.size()) {
+    if (quit || worker >= numWorkers)
+      return;
 
-      auto op = std::move(queue.front());
-      queue.pop();
+    auto first = queue.begin();
+    const auto priority = first->first.first;
+    std::vector<QuantumTask> batch;
+    batch.push_back(std::move(first->second.task));
+    const auto batchKey = std::move(first->second.batchKey);
+    queue.erase(first);
 
-      // unlock now that we're done messing with the queue
-      l.unlock();
-
-      op();
-      l.lock();
+    // Take the queued tasks compatible with the first one, in order.
+    QuantumTaskBatchHandler batchHandler;
+    if (!batchKey.empty()) {
+      std::size_t maxBatchSize = 64;
+      if (auto iter = batchHandlers.find(batchKey);
+          iter != batchHandlers.end()) {
+        batchHandler = iter->second.handler;
+        maxBatchSize = iter->second.maxBatchSize;
+      }
+      for (auto iter = queue.begin(); iter != queue.end() &&
+                                      iter->first.first == priority &&
+                                      batch.size() < maxBatchSize;)
+        if (iter->second.batchKey == batchKey) {
+          batch.push_back(std::move(iter->second.task));
+          iter = queue.erase(iter);
+        } else
+          ++iter;
     }
+
+    // unlock now that we're done messing with the queue
+    l.unlock();
+
+    if (batchHandler)
+      batchHandler(batch);
+    else
+      for (auto &op : batch)
+        op();
+    l.lock();
   } while (!quit);
 }
 
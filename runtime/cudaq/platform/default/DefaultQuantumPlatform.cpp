@@ -22,6 +22,12 @@
 LLVM_INSTANTIATE_REGISTRY(cudaq::QPU::RegistryType)
 
 namespace {
+/// @brief The execution context of the calling thread. The shots of a
+/// per-shot sampling run concurrently on the shot threads of the platform,
+/// each with its own execution manager and simulator, see
+/// quantum_platform::run_on_shot_threads().
+thread_local cudaq::ExecutionContext *threadContext = nullptr;
+
 /// The DefaultQPU models a simulated QPU by specifically
 /// targeting the QIS ExecutionManager. This QPU is meant
 /// to be used in Library Mode (no qpud daemon or remote
@@ -44,57 +50,46 @@ public:
   void setExecutionContext(cudaq::ExecutionContext *context) override {
     cudaq::ScopedTrace trace("DefaultPlatform::setExecutionContext",
                              context->name);
-    executionContext = context;
+    threadContext = context;
     if (noiseModel)
-      executionContext->noiseModel = noiseModel;
+      threadContext->noiseModel = noiseModel;
 
-    cudaq::getExecutionManager()->setExecutionContext(executionContext);
+    cudaq::getExecutionManager()->setExecutionContext(threadContext);
+    beginExecution(*threadContext);
   }
 
   /// Overrides resetExecutionContext to forward to
   /// the ExecutionManager. Also handles observe post-processing
   void resetExecutionContext() override {
+    auto *ctx = threadContext;
     cudaq::ScopedTrace trace("DefaultPlatform::resetExecutionContext",
-                             executionContext->name);
+                             ctx ? ctx->name : "");
 
-    auto ctx = executionContext;
     if (ctx && ctx->name == "observe") {
-      double sum = 0.0;
       if (!ctx->spin.has_value())
         throw std::runtime_error(
             "Observe ExecutionContext specified without a cudaq::spin_op.");
 
-      std::vector<cudaq::ExecutionResult> results;
       cudaq::spin_op &H = *ctx->spin.value();
 
-      // If the backend supports the observe task,
-      // let it compute the expectation value instead of
-      // manually looping over terms, applying basis change ops,
-      // and computing <ZZ..ZZZ>
-      if (executionContext->canHandleObserve) {
-        auto [exp, data] = cudaq::measure(H);
-        results.emplace_back(data.to_map(), H.to_string());
-        ctx->expectationValue = exp;
-        ctx->result = cudaq::sample_result(results);
-      } else {
-
-        // Loop over each term and compute coeff * <term>
-        H.for_each_term([&](cudaq::spin_op &term) {
-          if (term.is_identity())
-            sum += term.get_term_coefficient(0).real();
-          else {
-            auto [exp, data] = cudaq::measure(term);
-            results.emplace_back(data.to_map(), term.to_string(false));
-            sum += term.get_term_coefficient(0).real() * exp;
-          }
-        });
-
-        ctx->expectationValue = sum;
-        ctx->result = cudaq::sample_result(sum, results);
-      }
+      // The simulator evaluates all terms against the state prepared by
+      // the kernel. If the backend supports the observe task it computes
+      // <psi | H | psi> itself, otherwise NVQIR applies the basis change ops
+      // and computes <ZZ..ZZZ> for each term.
+      auto [exp, data] = cudaq::measure(H);
+      ctx->expectationValue = exp;
+      if (ctx->canHandleObserve && !ctx->termExpectations) {
+        std::vector<cudaq::ExecutionResult> results;
+        auto &result = results.emplace_back(data.extract_register());
+        result.registerName = H.to_string();
+        ctx->result = cudaq::sample_result(exp, std::move(results));
+      } else
+        ctx->result = std::move(data);
     }
     cudaq::getExecutionManager()->resetExecutionContext();
-    executionContext = nullptr;
+    if (ctx)
+      endExecution(*ctx);
+    threadContext = nullptr;
   }
 };
 
@@ -8,36 +8,178 @@
 
 #include "Executor.h"
 #include "common/Logger.h"
+#include "common/Profiler.h"
+#include <future>
 
 namespace cudaq {
+details::future
+Executor::withResultCache(std::vector<std::string> keyParts,
+                          const std::function<details::future()> &submit) {
+  auto cache = ResultCache::fromEnvironment();
+  if (!cache)
+    return submit();
+
+  keyParts.push_back(serverHelper->name());
+  keyParts.push_back(std::to_string(shots));
+  for (auto &[key, value] : serverHelper->getConfig()) {
+    keyParts.push_back(key);
+    keyParts.push_back(value);
+  }
+  auto key = ResultCache::hashKey(keyParts);
+  if (auto result = cache->load(key)) {
+    std::promise<sample_result> ready;
+    ready.set_value(std::move(*result));
+    return details::future(ready.get_future());
+  }
+
+  return details::future(std::async(
+      std::launch::deferred,
+      [remote = submit(), cache = std::move(*cache), key]() mutable {
+        auto result = remote.get();
+        cache.store(key, result);
+        return result;
+      }));
+}
+
 details::future
 Executor::execute(std::vector<KernelExecution> &codesToExecute) {
+  std::vector<std::string> keyParts;
+  for (auto &code : codesToExecute) {
+    keyParts.push_back(code.name);
+    keyParts.push_back(code.code);
+  }
+  return withResultCache(std::move(keyParts), [&]() {
+    return submit(codesToExecute);
+  });
+}
+
+details::future
+Executor::submit(std::vector<KernelExecution> &codesToExecute) {
+  return makeFuture(postJobs(codesToExecute));
+}
+
+details::future
+Executor::makeFuture(const std::vector<details::future::Job> &jobs) {
+  auto ids = jobs;
+  auto config = serverHelper->getConfig();
+  std::string name = serverHelper->name();
+  return details::future(ids, name, config);
+}
+
+std::vector<details::future::Job>
+Executor::postJobs(std::vector<KernelExecution> &codesToExecute) {
+  profiler::ScopedEvent event("postJobs", profiler::Category::rest_submit);
 
   serverHelper->setShots(shots);
 
   cudaq::info("Executor creating {} jobs to execute with the {} helper.",
               codesToExecute.size(), serverHelper->name());
 
-  // Create the Job Payload, composed of job post path, headers,
-  // and the job json messages themselves
-  auto [jobPostPath, headers, jobs] = serverHelper->createJob(codesToExecute);
-
+  // Servers that accept several circuits per job get them in one batch,
+  // the others one job per circuit.
   std::vector<details::future::Job> ids;
-  for (std::size_t i = 0; auto &job : jobs) {
-    cudaq::info("Job (name={}) created, posting to {}", codesToExecute[i].name,
-                jobPostPath);
-
-    // Post it, get the response
-    auto response = client.post(jobPostPath, "", job, headers);
-    cudaq::info("Job (name={}) posted, response was {}", codesToExecute[i].name,
-                response.dump());
-
-    // Add the job id and the job name.
-    ids.emplace_back(serverHelper->extractJobId(response),
-                     codesToExecute[i].name);
-    i++;
+  if (auto batch = serverHelper->createBatchJob(codesToExecute)) {
+    auto &[jobPostPath, headers, jobs] = *batch;
+    cudaq::info("Batch job of {} circuits created, posting {} messages to {}",
+                codesToExecute.size(), jobs.size(), jobPostPath);
+    auto responses = client.postAll(jobPostPath, "", jobs, headers,
+                                    submissionConcurrency);
+    std::vector<std::string> jobIds;
+    for (auto &response : responses)
+      for (auto &id : serverHelper->extractBatchJobIds(response))
+        jobIds.push_back(id);
+    if (jobIds.size() != codesToExecute.size())
+      throw std::runtime_error(
+          "The batch job returned " + std::to_string(jobIds.size()) +
+          " job ids for " + std::to_string(codesToExecute.size()) +
+          " circuits.");
+    for (std::size_t i = 0; i < jobIds.size(); i++)
+      ids.emplace_back(jobIds[i], codesToExecute[i].name);
+  } else {
+    // Create the Job Payload, composed of job post path, headers,
+    // and the job json messages themselves
+    auto [jobPostPath, headers, jobs] = serverHelper->createJob(codesToExecute);
+
+    cudaq::info("{} jobs created, posting to {}", jobs.size(), jobPostPath);
+
+    // Post them concurrently, get the responses
+    auto responses = client.postAll(jobPostPath, "", jobs, headers,
+                                    submissionConcurrency);
+    for (std::size_t i = 0; auto &response : responses) {
+      cudaq::info("Job (name={}) posted, response was {}",
+                  codesToExecute[i].name, response.dump());
+
+      // Add the job id and the job name.
+      ids.emplace_back(serverHelper->extractJobId(response),
+                       codesToExecute[i].name);
+      i++;
+    }
+  }
+
+  return ids;
+}
+
+std::vector<std::string>
+Executor::uploadPrograms(std::vector<KernelExecution> &parameterizedCodes) {
+  auto [uploadPath, headers, messages] =
+      serverHelper->createProgramUpload(parameterizedCodes);
+  cudaq::info("Uploading {} parameterized programs to {}",
+              parameterizedCodes.size(), uploadPath);
+  auto responses = client.postAll(uploadPath, "", messages, headers,
+                                  submissionConcurrency);
+  std::vector<std::string> programIds;
+  for (auto &response : responses)
+    for (auto &id : serverHelper->extractProgramIds(response))
+      programIds.push_back(id);
+  if (programIds.size() != parameterizedCodes.size())
+    throw std::runtime_error(
+        "The program upload returned " + std::to_string(programIds.size()) +
+        " program ids for " + std::to_string(parameterizedCodes.size()) +
+        " programs.");
+  return programIds;
+}
+
+details::future
+Executor::executeBound(const std::vector<std::string> &programIds,
+                       const std::vector<std::string> &names,
+                       const std::vector<double> &parameters) {
+  std::vector<std::string> keyParts;
+  for (std::size_t i = 0; i < programIds.size(); i++) {
+    keyParts.push_back(names[i]);
+    keyParts.push_back(programIds[i]);
   }
+  for (auto parameter : parameters)
+    keyParts.push_back(fmt::format("{}", parameter));
+  return withResultCache(std::move(keyParts), [&]() {
+    return submitBound(programIds, names, parameters);
+  });
+}
 
+details::future
+Executor::submitBound(const std::vector<std::string> &programIds,
+                      const std::vector<std::string> &names,
+                      const std::vector<double> &parameters) {
+  serverHelper->setShots(shots);
+
+  auto [jobPostPath, headers, jobs] =
+      serverHelper->createBindingJob(programIds, parameters);
+  cudaq::info("Binding {} parameters to {} programs, posting to {}",
+              parameters.size(), programIds.size(), jobPostPath);
+  auto responses =
+      client.postAll(jobPostPath, "", jobs, headers, submissionConcurrency);
+
+  std::vector<std::string> jobIds;
+  for (auto &response : responses)
+    for (auto &id : serverHelper->extractBatchJobIds(response))
+      jobIds.push_back(id);
+  if (jobIds.size() != names.size())
+    throw std::runtime_error("The binding job returned " +
+                             std::to_string(jobIds.size()) + " job ids for " +
+                             std::to_string(names.size()) + " programs.");
+
+  std::vector<details::future::Job> ids;
+  for (std::size_t i = 0; i < jobIds.size(); i++)
+    ids.emplace_back(jobIds[i], names[i]);
   auto config = serverHelper->getConfig();
   std::string name = serverHelper->name();
   return details::future(ids, name, config);
@@ -9,6 +9,7 @@
 #pragma once
 #include "common/ExecutionContext.h"
 #include "common/RestClient.h"
+#include "common/ResultCache.h"
 #include "common/ServerHelper.h"
 
 namespace cudaq {
@@ -29,6 +30,24 @@ protected:
   /// @brief The number of shots to execute
   std::size_t shots = 100;
 
+  /// @brief The maximum number of job posts in flight at once
+  std::size_t submissionConcurrency = 8;
+
+  /// @brief Return the cached result of the execution with the given key
+  /// parts as a ready future, if the result cache is enabled and has it.
+  /// Otherwise return the future of `submit`, whose result is stored in the
+  /// cache when it is retrieved.
+  details::future
+  withResultCache(std::vector<std::string> keyParts,
+                  const std::function<details::future()> &submit);
+
+  /// @brief Submit the codes, or bind the parameters to the programs,
+  /// bypassing the result cache.
+  details::future submit(std::vector<KernelExecution> &codesToExecute);
+  details::future submitBound(const std::vector<std::string> &programIds,
+                              const std::vector<std::string> &names,
+                              const std::vector<double> &parameters);
+
 public:
   Executor() = default;
   virtual ~Executor() = default;
@@ -39,9 +58,37 @@ public:
   /// @brief Set the number of shots to execute
   void setShots(std::size_t s) { shots = s; }
 
+  /// @brief Set the maximum number of job posts in flight at once
+  void setSubmissionConcurrency(std::size_t n) { submissionConcurrency = n; }
+
+  /// @brief Compress the bodies of the job posts with gzip
+  void setCompressPosts(bool compress) { client.setCompressPosts(compress); }
+
   /// @brief Execute the provided quantum codes and return a future object
   /// The caller can make this synchronous by just immediately calling .get().
+  /// With the result cache enabled (see ResultCache::fromEnvironment()), an
+  /// execution identical to a cached one returns its result instead.
   details::future execute(std::vector<KernelExecution> &codesToExecute);
+
+  /// @brief Post the jobs of the quantum codes, bypassing the result cache,
+  /// and return their ids. A large execution can post its codes in chunks,
+  /// then make one future of all their jobs with makeFuture().
+  std::vector<details::future::Job>
+  postJobs(std::vector<KernelExecution> &codesToExecute);
+
+  /// @brief Return the future of the results of the given posted jobs.
+  details::future makeFuture(const std::vector<details::future::Job> &jobs);
+
+  /// @brief Upload the parameterized codes to the server, return their
+  /// program ids.
+  std::vector<std::string>
+  uploadPrograms(std::vector<KernelExecution> &parameterizedCodes);
+
+  /// @brief Execute the uploaded programs, named as given, with the
+  /// parameter values and return a future object.
+  details::future executeBound(const std::vector<std::string> &programIds,
+                               const std::vector<std::string> &names,
+                               const std::vector<double> &parameters);
 };
 
 } // namespace cudaq
@@ -0,0 +1,234 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "ObserveCodegen.h"
+#include "cudaq/Optimizer/Transforms/Passes.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Pass/PassManager.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cctype>
+#include <regex>
+#include <string_view>
+
+using namespace mlir;
+
+namespace {
+/// @brief Return true if the character may be part of an OpenQASM name.
+bool isNameChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+/// @brief Return the position of the first occurrence of `name` in `text`,
+/// from `pos` on, that is a whole name rather than part of a longer one.
+std::size_t findName(std::string_view text, std::string_view name,
+                     std::size_t pos = 0) {
+  for (pos = text.find(name, pos); pos != std::string_view::npos;
+       pos = text.find(name, pos + 1)) {
+    const std::size_t end = pos + name.size();
+    if ((pos == 0 || !isNameChar(text[pos - 1])) &&
+        (end == text.size() || !isNameChar(text[end])))
+      return pos;
+  }
+  return std::string_view::npos;
+}
+
+/// @brief Return the text with every whole occurrence of the name `from`
+/// renamed to `to`.
+std::string rename(std::string text, const std::string &from,
+                   const std::string &to) {
+  if (from == to)
+    return text;
+  for (auto pos = findName(text, from); pos != std::string::npos;
+       pos = findName(text, from, pos + to.size()))
+    text.replace(pos, from.size(), to);
+  return text;
+}
+
+/// @brief Return the lines of the text, each with its newline.
+std::vector<std::string_view> splitLines(std::string_view text) {
+  std::vector<std::string_view> lines;
+  while (!text.empty()) {
+    auto end = std::min(text.find('\n'), text.size() - 1) + 1;
+    lines.push_back(text.substr(0, end));
+    text.remove_prefix(end);
+  }
+  return lines;
+}
+
+/// @brief Return the basis changes of every qubit, given the code the
+/// translator emits between the ansatz and the measurements when all qubits
+/// are changed to the same basis. The changes are the same number of lines
+/// per qubit, in qubit order, each naming its qubit.
+std::optional<std::vector<std::string>>
+splitBasisChanges(std::string_view changes,
+                  const std::vector<std::string> &qubitNames) {
+  auto lines = splitLines(changes);
+  const std::size_t numQubits = qubitNames.size();
+  if (lines.empty() || lines.size() % numQubits != 0)
+    return std::nullopt;
+  const std::size_t linesPerQubit = lines.size() / numQubits;
+  std::vector<std::string> result(numQubits);
+  for (std::size_t i = 0; i < numQubits; i++)
+    for (std::size_t j = 0; j < linesPerQubit; j++) {
+      auto line = lines[i * linesPerQubit + j];
+      if (findName(line, qubitNames[i]) == std::string_view::npos)
+        return std::nullopt;
+      result[i] += line;
+    }
+  return result;
+}
+} // namespace
+
+namespace cudaq {
+
+std::string translateModule(Translation &translation,
+                            const std::string &translationName,
+                            ModuleOp moduleOp) {
+  std::string codeStr;
+  llvm::raw_string_ostream outStr(codeStr);
+  if (failed(translation(moduleOp, outStr)))
+    throw std::runtime_error("Could not successfully translate to " +
+                             translationName + ".");
+  outStr.flush();
+  return codeStr;
+}
+
+std::string translateObserveModule(Translation &translation,
+                                   const std::string &translationName,
+                                   ModuleOp moduleOp,
+                                   const std::vector<bool> &basis) {
+  // Create the pass manager, add the quake observe ansatz pass and run it
+  // followed by the canonicalizer
+  PassManager pm(moduleOp.getContext());
+  OpPassManager &optPM = pm.nest<func::FuncOp>();
+  optPM.addPass(cudaq::opt::createQuakeObserveAnsatzPass(basis));
+  if (failed(pm.run(moduleOp)))
+    throw std::runtime_error("Could not apply measurements to ansatz.");
+  std::string errMsg;
+  if (failed(runPassPipeline("canonicalize", moduleOp, &errMsg)))
+    throw std::runtime_error("Could not canonicalize the observed ansatz (" +
+                             errMsg + ").");
+  return translateModule(translation, translationName, moduleOp);
+}
+
+std::optional<OpenQASMAnsatz>
+translateOpenQASMAnsatz(Translation &translation,
+                        const std::string &translationName,
+                        func::FuncOp ansatz, std::size_t numQubits) {
+  if (numQubits == 0)
+    return std::nullopt;
+  // The bases measuring every qubit in Z, X and Y.
+  std::vector<bool> zBasis(2 * numQubits, false);
+  std::fill(zBasis.begin() + numQubits, zBasis.end(), true);
+  std::vector<bool> xBasis(2 * numQubits, false);
+  std::fill(xBasis.begin(), xBasis.begin() + numQubits, true);
+  std::vector<bool> yBasis(2 * numQubits, true);
+  auto translateBasis = [&](const std::vector<bool> &basis) {
+    OwningOpRef<ModuleOp> module(ModuleOp::create(ansatz.getLoc()));
+    module->push_back(ansatz.clone());
+    return translateObserveModule(translation, translationName, *module,
+                                  basis);
+  };
+  const auto zCode = translateBasis(zBasis);
+  const auto xCode = translateBasis(xBasis);
+  const auto yCode = translateBasis(yBasis);
+
+  // Find the measurements from the end of the Z code, skipping blank lines.
+  std::vector<std::string_view> lines;
+  std::string_view text(zCode);
+  std::size_t end = text.size();
+  while (lines.size() < 2 * numQubits && end > 0) {
+    auto newline = text.rfind('\n', end - 1);
+    auto begin = newline == std::string_view::npos ? 0 : newline + 1;
+    auto line = text.substr(begin, end - begin);
+    if (line.find_first_not_of(" \t") != std::string_view::npos)
+      lines.push_back(line);
+    end = newline == std::string_view::npos ? 0 : newline;
+  }
+  if (lines.size() < 2 * numQubits)
+    return std::nullopt;
+
+  static const std::regex cregLine(R"(\s*creg ([A-Za-z_]+)(\d+)\[1\];)");
+  static const std::regex measureLine(
+      R"(\s*measure (\S+) -> ([A-Za-z_]+\d+)\[0\];)");
+  OpenQASMAnsatz result;
+  result.code = zCode.substr(0, end ? end + 1 : 0);
+  std::vector<std::string> qubitNames;
+  for (std::size_t i = 0; i < numQubits; i++) {
+    std::cmatch creg, measure;
+    auto &cregText = lines[lines.size() - 1 - 2 * i];
+    auto &measureText = lines[lines.size() - 2 - 2 * i];
+    if (!std::regex_match(cregText.begin(), cregText.end(), creg, cregLine) ||
+        !std::regex_match(measureText.begin(), measureText.end(), measure,
+                          measureLine) ||
+        measure[2].str() != creg[1].str() + creg[2].str())
+      return std::nullopt;
+    if (i == 0) {
+      result.registerPrefix = creg[1].str();
+      result.firstRegister = std::stoul(creg[2].str());
+    } else if (creg[1].str() != result.registerPrefix ||
+               std::stoul(creg[2].str()) != result.firstRegister + i) {
+      return std::nullopt;
+    }
+    qubitNames.push_back(measure[1].str());
+    result.measurements.push_back(std::string(cregText) + "\n" +
+                                  std::string(measureText) + "\n");
+  }
+
+  // The X and Y codes are the ansatz, the basis changes and the same
+  // measurements as the Z code.
+  const std::string_view measurements =
+      std::string_view(zCode).substr(result.code.size());
+  for (auto [code, changes] : {std::pair{&xCode, &result.xChanges},
+                               std::pair{&yCode, &result.yChanges}}) {
+    std::string_view other(*code);
+    if (!other.starts_with(result.code) || !other.ends_with(measurements) ||
+        other.size() < zCode.size())
+      return std::nullopt;
+    auto split = splitBasisChanges(
+        other.substr(result.code.size(), other.size() - zCode.size()),
+        qubitNames);
+    if (!split)
+      return std::nullopt;
+    *changes = std::move(*split);
+  }
+
+  // The pieces only stand for the translator if they give its codes back.
+  if (measureOpenQASMAnsatz(result, zBasis) != zCode ||
+      measureOpenQASMAnsatz(result, xBasis) != xCode ||
+      measureOpenQASMAnsatz(result, yBasis) != yCode)
+    return std::nullopt;
+  return result;
+}
+
+std::string measureOpenQASMAnsatz(const OpenQASMAnsatz &ansatz,
+                                  const std::vector<bool> &basis) {
+  const std::size_t numQubits = basis.size() / 2;
+  std::string code = ansatz.code;
+  std::vector<std::size_t> measured;
+  for (std::size_t i = 0; i < numQubits; i++) {
+    const bool x = basis[i], z = basis[i + numQubits];
+    if (x && z)
+      code += ansatz.yChanges[i];
+    else if (x)
+      code += ansatz.xChanges[i];
+    if (x || z)
+      measured.push_back(i);
+  }
+  // The registers of the measured qubits are numbered in order.
+  std::size_t bits = ansatz.firstRegister;
+  for (auto i : measured)
+    code += rename(
+        ansatz.measurements[i],
+        ansatz.registerPrefix + std::to_string(ansatz.firstRegister + i),
+        ansatz.registerPrefix + std::to_string(bits++));
+  return code;
+}
+
+} // namespace cudaq
@@ -0,0 +1,69 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "common/RuntimeMLIR.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace mlir::func {
+class FuncOp;
+} // namespace mlir::func
+
+namespace cudaq {
+
+/// @brief Translate the module with the given translation.
+std::string translateModule(Translation &translation,
+                            const std::string &translationName,
+                            mlir::ModuleOp moduleOp);
+
+/// @brief Add the measurements of the given basis, in its binary symplectic
+/// form, to the ansatz of the module, canonicalize it and translate it. This
+/// is the code of one circuit of an observation.
+std::string translateObserveModule(Translation &translation,
+                                   const std::string &translationName,
+                                   mlir::ModuleOp moduleOp,
+                                   const std::vector<bool> &basis);
+
+/// @brief The OpenQASM code of an observed ansatz, split into the ansatz
+/// without measurements and the code, per qubit, of its basis changes and its
+/// measurement. All of it is emitted by the translator, the code measuring a
+/// group of terms is assembled from the pieces, so the ansatz is translated
+/// a fixed number of times per observation rather than once per group.
+struct OpenQASMAnsatz {
+  std::string code;
+  /// @brief The basis changes of each qubit to the X and Y bases.
+  std::vector<std::string> xChanges;
+  std::vector<std::string> yChanges;
+  /// @brief The classical register and measurement of each qubit, in the
+  /// order the translator emits them when all qubits are measured.
+  std::vector<std::string> measurements;
+  /// @brief The prefix and number of the name of the first classical
+  /// register, the measurements are renumbered from it on.
+  std::string registerPrefix;
+  std::size_t firstRegister = 0;
+};
+
+/// @brief Translate the ansatz measured in the Z, X and Y bases on all
+/// `numQubits` qubits and split the codes into an `OpenQASMAnsatz`. Return
+/// nothing if the codes do not split into the ansatz followed by per qubit
+/// basis changes and measurements, or if assembling the three bases from the
+/// pieces does not give back the translated codes.
+std::optional<OpenQASMAnsatz>
+translateOpenQASMAnsatz(Translation &translation,
+                        const std::string &translationName,
+                        mlir::func::FuncOp ansatz, std::size_t numQubits);
+
+/// @brief Return the OpenQASM code measuring the ansatz in the given basis,
+/// as `translateObserveModule` emits it for the ansatz.
+std::string measureOpenQASMAnsatz(const OpenQASMAnsatz &ansatz,
+                                  const std::vector<bool> &basis);
+
+} // namespace cudaq
@@ -7,22 +7,29 @@
  *******************************************************************************/
 
 #include "Executor.h"
+#include "ObserveCodegen.h"
 #include "common/ExecutionContext.h"
 #include "common/Logger.h"
+#include "common/ObserveResult.h"
 #include "common/RestClient.h"
 #include "cudaq/platform/qpu.h"
 #include "nvqpp_config.h"
 
 #include "common/RuntimeMLIR.h"
 #include "cudaq/platform/quantum_platform.h"
+#include <chrono>
+#include <cstring>
 #include <cudaq/spin_op.h>
 #include <fmt/core.h>
 #include <fstream>
+#include <future>
 #include <iostream>
+#include <mutex>
 #include <netinet/in.h>
 #include <regex>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unordered_map>
 
 #include "cudaq/Frontend/nvqpp/AttributeNames.h"
 #include "cudaq/Optimizer/CodeGen/Passes.h"
@@ -44,6 +51,7 @@
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/IR/Diagnostics.h"
 #include "mlir/IR/ImplicitLocOpBuilder.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/Parser/Parser.h"
 #include "mlir/Pass/PassManager.h"
 #include "mlir/Pass/PassRegistry.h"
@@ -61,6 +69,12 @@ namespace {
 
 constexpr char platformLoweringConfig[] = "PLATFORM_LOWERING_CONFIG";
 constexpr char codeEmissionType[] = "CODEGEN_EMISSION";
+constexpr char couplingMapConfig[] = "COUPLING_MAP";
+
+/// @brief The execution context and the shots of the task running on this
+/// thread, the queue workers of a remote QPU run several at once.
+thread_local cudaq::ExecutionContext *threadContext = nullptr;
+thread_local std::optional<int> threadShots;
 
 /// @brief The RemoteRESTQPU is a subtype of QPU that enables the
 /// execution of CUDA Quantum kernels on remotely hosted quantum computing
@@ -74,15 +88,34 @@ constexpr char codeEmissionType[] = "CODEGEN_EMISSION";
 /// backends as well as those that take OpenQASM2 as input.
 class RemoteRESTQPU : public cudaq::QPU {
 protected:
-  /// The number of shots
-  std::optional<int> nShots;
+  /// @brief The number of tasks of the execution queue in flight at once,
+  /// unless set by the `queue_workers` backend config key.
+  static constexpr std::size_t defaultQueueWorkers = 8;
 
   /// @brief the platform file path, CUDAQ_INSTALL/platforms
   std::filesystem::path platformPath;
 
-  /// @brief The Pass pipeline string, configured by the
-  /// QPU config file in the platform path.
-  std::string passPipelineConfig = "canonicalize";
+  /// @brief The pass pipeline run on every kernel before the platform
+  /// lowering.
+  static constexpr char basePipelineConfig[] =
+      "canonicalize,func.func(quake-op-cancellation)";
+
+  /// @brief The pass pipeline run on kernels once their arguments are
+  /// synthesized, before the platform lowering. The loops bounded by
+  /// arguments are unrolled, then the gates made trivial by the argument
+  /// values are folded away.
+  static constexpr char postSynthesisPipelineConfig[] =
+      "canonicalize,cc-loop-unroll,canonicalize,func.func(quake-op-"
+      "cancellation,quake-fold-constant-gates)";
+
+  /// @brief The platform lowering pipeline, configured by the QPU config
+  /// file in the platform path. It starts with the mapping of the qubits to
+  /// the device qubits if the file gives the device coupling map.
+  std::string platformPipelineConfig;
+
+  /// @brief The Pass pipeline string, the base pipeline followed by the
+  /// platform lowering.
+  std::string passPipelineConfig = basePipelineConfig;
 
   /// @brief The name of the QPU being targeted
   std::string qpuName;
@@ -100,6 +133,146 @@ protected:
   /// configuration.
   std::map<std::string, std::string> backendConfig;
 
+  /// @brief The MLIR context of the cached lowered kernels, which outlive a
+  /// single launch, taken from the platform's pool.
+  std::unique_ptr<MLIRContext, void (*)(MLIRContext *)> cacheContext{
+      nullptr, cudaq::releaseMLIRContext};
+
+  /// @brief The kernels lowered by the config pass pipeline, before their
+  /// arguments are synthesized, keyed on the kernel name and the pipeline.
+  /// Launches only synthesize the arguments into a clone.
+  std::unordered_map<std::string, OwningOpRef<ModuleOp>> loweredModules;
+
+  /// @brief The translated codes of kernels without synthesized arguments,
+  /// which are the same at every launch, keyed by getCodesKey().
+  std::unordered_map<std::string, std::vector<cudaq::KernelExecution>>
+      loweredCodes;
+
+  /// @brief Guards the caches and their context.
+  std::mutex loweringMutex;
+
+  /// @brief The ids of the parameterized programs uploaded to the server,
+  /// keyed as the translated codes, and their guard.
+  std::unordered_map<std::string, std::vector<std::string>> uploadedPrograms;
+  std::mutex uploadMutex;
+
+  /// @brief Serializes the submissions of the concurrent tasks, which share
+  /// the executor and its number of shots. Waiting for the results is not
+  /// serialized.
+  std::mutex submissionMutex;
+
+  /// @brief Return the key of the translated codes of the kernel for the
+  /// current execution context.
+  std::string getCodesKey(const std::string &kernelName,
+                          const std::string &translationName) {
+    std::string key = kernelName + ";" + passPipelineConfig + ";" + qpuName +
+                      ";" + translationName + ";";
+    if (threadContext && threadContext->foldScale > 1)
+      key += "fold=" + std::to_string(threadContext->foldScale) + ";";
+    if (threadContext && threadContext->name == "observe")
+      key += threadContext->spin.value()->to_string();
+    return key;
+  }
+
+  /// @brief Return the kernel lowered by `pipeline`, the config pass
+  /// pipeline by default, before its arguments are synthesized, from the
+  /// cache. The caller holds loweringMutex.
+  ModuleOp getLoweredKernel(const std::string &kernelName,
+                            const std::string &pipeline) {
+    if (!cacheContext)
+      cacheContext.reset(cudaq::acquireMLIRContext());
+    MLIRContext &context = *cacheContext;
+
+    const std::string moduleKey = kernelName + ";" + pipeline;
+    auto &lowered = loweredModules[moduleKey];
+    if (lowered)
+      return *lowered;
+
+    auto location = FileLineColLoc::get(&context, "<builder>", 1, 1);
+    ImplicitLocOpBuilder builder(location, &context);
+
+    // Get the quake representation of the kernel
+    auto quakeCode = cudaq::get_quake_by_name(kernelName);
+    auto m_module = parseSourceString<ModuleOp>(quakeCode, &context);
+
+    // Extract the kernel name
+    auto func = m_module->lookupSymbol<mlir::func::FuncOp>(
+        std::string("__nvqpp__mlirgen__") + kernelName);
+
+    // FIXME this should be added to the builder.
+    if (!func->hasAttr(cudaq::entryPointAttrName))
+      func->setAttr(cudaq::entryPointAttrName, builder.getUnitAttr());
+
+    // Create a new Module to clone the function into
+    OwningOpRef<ModuleOp> loweredOp(builder.create<ModuleOp>());
+    loweredOp->push_back(func.clone());
+
+    // Run the config-specified pass pipeline
+    runPassPipeline(kernelName, pipeline, *loweredOp);
+    lowered = std::move(loweredOp);
+    return *lowered;
+  }
+
+  ModuleOp getLoweredKernel(const std::string &kernelName) {
+    return getLoweredKernel(kernelName, passPipelineConfig);
+  }
+
+  /// @brief Return the pipeline run on a kernel once its arguments are
+  /// synthesized. The unused qubits are only removed when sampling, since
+  /// the spin operator of an observation refers to the qubits by index.
+  std::string getPostSynthesisPipeline(bool isObserve) const {
+    std::string pipeline = postSynthesisPipelineConfig;
+    if (!isObserve)
+      pipeline += ",func.func(quake-remove-dead-qubits)";
+    pipeline += ",canonicalize";
+    if (!platformPipelineConfig.empty())
+      pipeline += "," + platformPipelineConfig;
+    return pipeline;
+  }
+
+  /// @brief Apply a specific pipeline to the given ModuleOp
+  void runPassPipeline(const std::string &kernelName,
+                       const std::string &pipeline, ModuleOp moduleOpIn) {
+    cudaq::info("Pass pipeline for {} = {}", kernelName, pipeline);
+    std::string errMsg;
+    if (failed(cudaq::runPassPipeline(pipeline, moduleOpIn, &errMsg))) {
+      if (!errMsg.empty())
+        throw std::runtime_error(
+            "Remote rest platform failed to add passes to pipeline (" +
+            errMsg + ").");
+      throw std::runtime_error("Remote rest platform Quake lowering failed.");
+    }
+  }
+
+  /// @brief Return true if kernels of `double` arguments are uploaded once
+  /// as parameterized OpenQASM 3 programs and then executed by binding their
+  /// arguments. Enabled by the backend configuration key parameter_binding
+  /// for OpenQASM backends whose server helper supports it.
+  bool useParameterBinding() {
+    auto iter = backendConfig.find("parameter_binding");
+    return iter != backendConfig.end() && iter->second == "true" &&
+           codegenTranslation == "qasm2" &&
+           serverHelper->supportsParameterBinding();
+  }
+
+  /// @brief Return the arguments of the kernel if they are all `double`, as
+  /// the values of the parameters of its parameterized program.
+  std::optional<std::vector<double>>
+  getScalarArguments(const std::string &kernelName, void *args,
+                     std::uint64_t voidStarSize) {
+    std::lock_guard<std::mutex> lock(loweringMutex);
+    auto func = getLoweredKernel(kernelName).lookupSymbol<func::FuncOp>(
+        std::string("__nvqpp__mlirgen__") + kernelName);
+    auto inputs = func.getFunctionType().getInputs();
+    if (!args || inputs.empty() ||
+        voidStarSize < inputs.size() * sizeof(double) ||
+        !llvm::all_of(inputs, [](Type t) { return t.isF64(); }))
+      return std::nullopt;
+    std::vector<double> parameters(inputs.size());
+    std::memcpy(parameters.data(), args, inputs.size() * sizeof(double));
+    return parameters;
+  }
+
 public:
   /// @brief The constructor
   RemoteRESTQPU() : QPU() {
@@ -107,6 +280,7 @@ public:
     platformPath = cudaqLibPath.parent_path().parent_path() / "platforms";
     // Default is to run sampling via the remote rest call
     executor = std::make_unique<cudaq::Executor>();
+    setNumQueueWorkers(defaultQueueWorkers);
   }
 
   RemoteRESTQPU(RemoteRESTQPU &&) = delete;
@@ -124,13 +298,10 @@ public:
   bool supportsConditionalFeedback() override { return false; }
 
   /// Provide the number of shots
-  void setShots(int _nShots) override {
-    nShots = _nShots;
-    executor->setShots(static_cast<std::size_t>(_nShots));
-  }
+  void setShots(int _nShots) override { threadShots = _nShots; }
 
   /// Clear the number of shots
-  void clearShots() override { nShots = std::nullopt; }
+  void clearShots() override { threadShots = std::nullopt; }
   virtual bool isRemote() override { return true; }
 
   /// Store the execution context for launchKernel
@@ -142,13 +313,13 @@ public:
                 context->name);
 
     // Execution context is valid
-    executionContext = context;
+    threadContext = context;
   }
 
   /// Reset the execution context
   void resetExecutionContext() override {
     // do nothing here
-    executionContext = nullptr;
+    threadContext = nullptr;
   }
 
   /// @brief This setTargetBackend override is in charge of reading the
@@ -186,18 +357,38 @@ public:
 
     // Loop through the file, extract the pass pipeline and CODEGEN Type
     auto lines = cudaq::split(configContents, '\n');
+    std::string couplingMap;
     for (auto &line : lines) {
       if (line.find(platformLoweringConfig) != std::string::npos) {
         auto keyVal = cudaq::split(line, '=');
         auto value = std::regex_replace(keyVal[1], std::regex("\""), "");
         cudaq::info("Appending lowering pipeline: {}", value);
-        passPipelineConfig += "," + value;
+        if (!platformPipelineConfig.empty())
+          platformPipelineConfig += ",";
+        platformPipelineConfig += value;
       } else if (line.find(codeEmissionType) != std::string::npos) {
         auto keyVal = cudaq::split(line, '=');
         codegenTranslation = keyVal[1];
+      } else if (line.find(couplingMapConfig) != std::string::npos) {
+        auto keyVal = cudaq::split(line, '=');
+        couplingMap = std::regex_replace(keyVal[1], std::regex("\""), "");
       }
     }
 
+    // The qubits of the kernels are mapped to the device qubits before the
+    // platform lowering decomposes the gates, including the swaps.
+    if (!couplingMap.empty()) {
+      cudaq::info("Mapping qubits to the coupling map: {}", couplingMap);
+      std::string mapping = "canonicalize,cc-loop-unroll,canonicalize,"
+                            "func.func(quake-qubit-mapping{coupling-map=" +
+                            couplingMap + "})";
+      platformPipelineConfig = platformPipelineConfig.empty()
+                                   ? mapping
+                                   : mapping + "," + platformPipelineConfig;
+    }
+    if (!platformPipelineConfig.empty())
+      passPipelineConfig += "," + platformPipelineConfig;
+
     // Set the qpu name
     qpuName = mutableBackend;
 
@@ -207,112 +398,164 @@ public:
 
     // Give the server helper to the executor
     executor->setServerHelper(serverHelper.get());
+    if (auto iter = backendConfig.find("submission_concurrency");
+        iter != backendConfig.end())
+      executor->setSubmissionConcurrency(std::stoul(iter->second));
+    if (auto iter = backendConfig.find("compress_posts");
+        iter != backendConfig.end())
+      executor->setCompressPosts(iter->second == "true");
+    if (auto iter = backendConfig.find("queue_workers");
+        iter != backendConfig.end())
+      setNumQueueWorkers(std::stoul(iter->second));
   }
 
+  /// @brief The number of observe circuits lowered in parallel before they
+  /// are handed over for submission.
+  static constexpr std::size_t observeChunkSize = 64;
+
   /// @brief Extract the Quake representation for the given kernel name and
   /// lower it to the code format required for the specific backend. The
   /// lowering process is controllable via the platforms/BACKEND.config file for
-  /// this targeted backend.
-  std::vector<cudaq::KernelExecution>
-  lowerQuakeCode(const std::string &kernelName, void *kernelArgs) {
-
-    auto contextPtr = cudaq::initializeMLIR();
-    MLIRContext &context = *contextPtr.get();
-
-    // Get the quake representation of the kernel
-    auto quakeCode = cudaq::get_quake_by_name(kernelName);
-    auto m_module = parseSourceString<ModuleOp>(quakeCode, &context);
-
-    // Extract the kernel name
-    auto func = m_module->lookupSymbol<mlir::func::FuncOp>(
-        std::string("__nvqpp__mlirgen__") + kernelName);
+  /// this targeted backend. The circuits of an observation are lowered in
+  /// parallel, in chunks that are handed to `onCodes` as soon as they are
+  /// translated, so their submission overlaps the lowering of the next ones.
+  /// The codes handed to `onCodes` are only returned, and kept, if they are
+  /// cached, so the memory of a large observation is bounded by its chunks.
+  std::vector<cudaq::KernelExecution> lowerQuakeCode(
+      const std::string &kernelName, void *kernelArgs,
+      const std::string &translationName,
+      const std::function<void(std::vector<cudaq::KernelExecution>)>
+          &onCodes = {}) {
+
+    std::lock_guard<std::mutex> lock(loweringMutex);
+    const bool isObserve =
+        threadContext && threadContext->name == "observe";
+    const std::string codesKey = getCodesKey(kernelName, translationName);
+    if (!kernelArgs)
+      if (auto iter = loweredCodes.find(codesKey); iter != loweredCodes.end()) {
+        if (onCodes)
+          onCodes(iter->second);
+        return iter->second;
+      }
 
-    // Create a new Module to clone the function into
+    // Kernels with arguments are only lowered by the platform pipeline once
+    // the arguments are synthesized and the circuit simplified with them.
+    auto lowered = kernelArgs
+                       ? getLoweredKernel(kernelName, basePipelineConfig)
+                       : getLoweredKernel(kernelName);
+    MLIRContext &context = *cacheContext;
     auto location = FileLineColLoc::get(&context, "<builder>", 1, 1);
     ImplicitLocOpBuilder builder(location, &context);
 
-    // FIXME this should be added to the builder.
-    if (!func->hasAttr(cudaq::entryPointAttrName))
-      func->setAttr(cudaq::entryPointAttrName, builder.getUnitAttr());
-    auto moduleOp = builder.create<ModuleOp>();
-    moduleOp.push_back(func.clone());
-
-    // Lambda to apply a specific pipeline to the given ModuleOp
-    auto runPassPipeline = [&](const std::string &pipeline,
-                               ModuleOp moduleOpIn) {
-      PassManager pm(&context);
-      std::string errMsg;
-      llvm::raw_string_ostream os(errMsg);
-      cudaq::info("Pass pipeline for {} = {}", kernelName, pipeline);
-      if (failed(parsePassPipeline(pipeline, pm, os)))
-        throw std::runtime_error(
-            "Remote rest platform failed to add passes to pipeline (" + errMsg +
-            ").");
-      if (failed(pm.run(moduleOpIn)))
-        throw std::runtime_error("Remote rest platform Quake lowering failed.");
-    };
-
-    // Run the config-specified pass pipeline
-    runPassPipeline(passPipelineConfig, moduleOp);
+    // The arguments are synthesized into a clone of the lowered kernel, the
+    // modules of this launch are erased on return.
+    OwningOpRef<ModuleOp> ownedModule(lowered.clone());
+    auto moduleOp = *ownedModule;
 
     if (kernelArgs) {
       PassManager pm(&context);
       pm.addPass(cudaq::opt::createQuakeSynthesizer(kernelName, kernelArgs));
       if (failed(pm.run(moduleOp)))
         throw std::runtime_error("Could not successfully apply quake-synth.");
+      runPassPipeline(kernelName, getPostSynthesisPipeline(isObserve),
+                      moduleOp);
     }
 
-    std::vector<std::pair<std::string, ModuleOp>> modules;
-    // Apply observations if necessary
-    if (executionContext && executionContext->name == "observe") {
-
-      cudaq::spin_op &spin = *executionContext->spin.value();
-      for (std::size_t i = 0; i < spin.n_terms(); i++) {
-        auto term = spin[i];
-        if (term.is_identity())
-          continue;
-
-        // Get the ansatz
-        auto ansatz = moduleOp.lookupSymbol<func::FuncOp>(
-            std::string("__nvqpp__mlirgen__") + kernelName);
-
-        // Create a new Module to clone the ansatz into it
-        auto tmpModuleOp = builder.create<ModuleOp>();
-        tmpModuleOp.push_back(ansatz.clone());
-
-        // Extract the binary symplectic encoding
-        auto binarySymplecticForm = term.get_bsf()[0];
-
-        // Create the pass manager, add the quake observe ansatz pass
-        // and run it followed by the canonicalizer
-        PassManager pm(&context);
-        OpPassManager &optPM = pm.nest<func::FuncOp>();
-        optPM.addPass(
-            cudaq::opt::createQuakeObserveAnsatzPass(binarySymplecticForm));
-        if (failed(pm.run(tmpModuleOp)))
-          throw std::runtime_error("Could not apply measurements to ansatz.");
-        runPassPipeline("canonicalize", tmpModuleOp);
-        modules.emplace_back(term.to_string(false), tmpModuleOp);
-      }
-
-    } else
-      modules.emplace_back(kernelName, moduleOp);
+    // Zero-noise extrapolation scales the noise of the simplified kernel by
+    // folding its gates.
+    if (threadContext && threadContext->foldScale > 1)
+      runPassPipeline(kernelName,
+                      "func.func(quake-fold-gates{scale=" +
+                          std::to_string(threadContext->foldScale) + "})",
+                      moduleOp);
 
     // Get the code gen translation
-    auto translation = cudaq::getTranslation(codegenTranslation);
+    auto &translation = cudaq::getTranslation(translationName);
 
-    // Apply user-specified codegen
     std::vector<cudaq::KernelExecution> codes;
-    for (auto &[name, moduleOpI] : modules) {
-      std::string codeStr;
-      {
-        llvm::raw_string_ostream outStr(codeStr);
-        if (failed(translation(moduleOpI, outStr)))
-          throw std::runtime_error("Could not successfully translate to " +
-                                   codegenTranslation + ".");
+    const bool keepCodes = !onCodes || !kernelArgs;
+    if (!isObserve) {
+      auto code =
+          cudaq::translateModule(translation, translationName, moduleOp);
+      auto name = kernelName;
+      codes.emplace_back(name, code);
+      if (onCodes)
+        onCodes(codes);
+    } else {
+      // One circuit measures all qubit-wise commuting terms of a group, their
+      // counts are marginalized from the group counts afterwards.
+      cudaq::spin_op &spin = *threadContext->spin.value();
+      auto groups = spin.get_qubit_wise_commuting_groups();
+      auto ansatz = moduleOp.lookupSymbol<func::FuncOp>(
+          std::string("__nvqpp__mlirgen__") + kernelName);
+      // OpenQASM translates the ansatz in three bases, the code of each
+      // group is assembled from the pieces of their codes. Other
+      // translations, e.g. QIR, translate the ansatz of each group.
+      std::optional<cudaq::OpenQASMAnsatz> qasmAnsatz;
+      if (translationName.starts_with("qasm"))
+        qasmAnsatz = cudaq::translateOpenQASMAnsatz(
+            translation, translationName, ansatz, spin.num_qubits());
+
+      for (std::size_t first = 0; first < groups.size();
+           first += observeChunkSize) {
+        const std::size_t n =
+            std::min(observeChunkSize, groups.size() - first);
+        if (qasmAnsatz) {
+          std::vector<cudaq::KernelExecution> chunk;
+          for (std::size_t k = 0; k < n; k++) {
+            auto &group = groups[first + k];
+            chunk.emplace_back(
+                cudaq::details::getMeasurementBasisName(spin, group),
+                cudaq::measureOpenQASMAnsatz(
+                    *qasmAnsatz,
+                    cudaq::details::getMeasurementBasis(spin, group)));
+          }
+          if (keepCodes)
+            codes.insert(codes.end(), chunk.begin(), chunk.end());
+          if (onCodes)
+            onCodes(std::move(chunk));
+          continue;
+        }
+
+        // Clone the ansatz into a module per group, then add the
+        // measurements of the group and translate the modules in parallel.
+        std::vector<OwningOpRef<ModuleOp>> groupModules;
+        std::vector<std::string> names(n), groupCodes(n), errors(n);
+        std::vector<std::vector<bool>> bases(n);
+        for (std::size_t k = 0; k < n; k++) {
+          auto &group = groups[first + k];
+          auto &tmpModuleOp =
+              groupModules.emplace_back(builder.create<ModuleOp>());
+          tmpModuleOp->push_back(ansatz.clone());
+          names[k] = cudaq::details::getMeasurementBasisName(spin, group);
+          // Extract the binary symplectic encoding of the group basis
+          bases[k] = cudaq::details::getMeasurementBasis(spin, group);
+        }
+
+        mlir::parallelFor(&context, 0, n, [&](std::size_t k) {
+          try {
+            groupCodes[k] = cudaq::translateObserveModule(
+                translation, translationName, *groupModules[k], bases[k]);
+          } catch (std::exception &e) {
+            errors[k] = e.what();
+          }
+        });
+        for (auto &error : errors)
+          if (!error.empty())
+            throw std::runtime_error(error);
+
+        std::vector<cudaq::KernelExecution> chunk;
+        for (std::size_t k = 0; k < n; k++)
+          chunk.emplace_back(names[k], std::move(groupCodes[k]));
+        if (keepCodes)
+          codes.insert(codes.end(), chunk.begin(), chunk.end());
+        if (onCodes)
+          onCodes(std::move(chunk));
       }
-      codes.emplace_back(name, codeStr);
     }
+
+    if (!kernelArgs)
+      loweredCodes.emplace(codesKey, codes);
     return codes;
   }
 
@@ -326,24 +569,82 @@ public:
     cudaq::info("launching remote rest kernel ({})", kernelName);
 
     // TODO future iterations of this should support non-void return types.
-    if (!executionContext)
+    if (!threadContext)
       throw std::runtime_error("Remote rest execution can only be performed "
                                "via cudaq::sample() or cudaq::observe().");
 
-    // Get the Quake code, lowered according to config file.
-    auto codes = lowerQuakeCode(kernelName, args);
-
-    // Execute the codes produced in quake lowering
-    auto future = executor->execute(codes);
+    // The lowering and submission are the host time of the launch.
+    const auto start = std::chrono::steady_clock::now();
+    std::size_t nCircuits = 0;
+    cudaq::details::future future;
+    std::unique_lock<std::mutex> submission(submissionMutex);
+    if (threadShots)
+      executor->setShots(static_cast<std::size_t>(*threadShots));
+    std::optional<std::vector<double>> parameters;
+    if (useParameterBinding())
+      parameters = getScalarArguments(kernelName, args, voidStarSize);
+    if (parameters) {
+      // Upload the parameterized programs once, then only bind the
+      // arguments at every launch.
+      auto codes = lowerQuakeCode(kernelName, nullptr, "qasm3");
+      std::vector<std::string> programIds, names;
+      {
+        std::lock_guard<std::mutex> lock(uploadMutex);
+        auto &uploaded = uploadedPrograms[getCodesKey(kernelName, "qasm3")];
+        if (uploaded.empty())
+          uploaded = executor->uploadPrograms(codes);
+        programIds = uploaded;
+      }
+      for (auto &code : codes)
+        names.push_back(code.name);
+      nCircuits = codes.size();
+      future = executor->executeBound(programIds, names, *parameters);
+    } else if (cudaq::ResultCache::fromEnvironment()) {
+      // Get the Quake code, lowered according to config file.
+      auto codes = lowerQuakeCode(kernelName, args, codegenTranslation);
+
+      // Execute the codes produced in quake lowering, the result cache is
+      // keyed on all of them.
+      nCircuits = codes.size();
+      future = executor->execute(codes);
+    } else {
+      // Post the jobs of every chunk of lowered codes while the next chunk
+      // is lowered, one chunk after the other.
+      std::vector<cudaq::details::future::Job> jobs;
+      std::future<void> posting;
+      lowerQuakeCode(kernelName, args, codegenTranslation,
+                     [&](std::vector<cudaq::KernelExecution> chunk) {
+                       if (posting.valid())
+                         posting.get();
+                       posting = std::async(
+                           std::launch::async,
+                           [&, chunk = std::move(chunk)]() mutable {
+                             auto ids = executor->postJobs(chunk);
+                             jobs.insert(jobs.end(), ids.begin(), ids.end());
+                           });
+                     });
+      if (posting.valid())
+        posting.get();
+      nCircuits = jobs.size();
+      future = executor->makeFuture(jobs);
+    }
+    submission.unlock();
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    threadContext->counters.kernel_executions += nCircuits;
+    threadContext->counters.host_seconds += elapsed.count();
 
     // Keep this asynchronous if requested
-    if (executionContext->asyncExec) {
-      executionContext->futureResult = future;
+    if (threadContext->asyncExec) {
+      threadContext->futureResult = future;
       return;
     }
 
     // Otherwise make this synchronous
-    executionContext->result = future.get();
+    threadContext->result = future.get();
+    if (threadContext->name == "observe")
+      cudaq::details::marginalizeGroupCounts(threadContext->result,
+                                             *threadContext->spin.value());
   }
 };
 } // namespace
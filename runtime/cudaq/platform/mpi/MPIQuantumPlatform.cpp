@@ -0,0 +1,130 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+// The QPUs of each rank are those of the multi-QPU platform.
+#define CUDAQ_MQPU_TOGGLE_REGISTER
+#include "../mqpu/MultiQPUPlatform.cpp"
+
+#include <mpi.h>
+
+#define HANDLE_MPI_ERROR(x)                                                    \
+  {                                                                            \
+    const auto err = x;                                                        \
+    if (err != MPI_SUCCESS) {                                                  \
+      throw std::runtime_error(fmt::format("[mpi] error {} in {} (line {})",   \
+                                           err, __FUNCTION__, __LINE__));      \
+    }                                                                          \
+  };
+
+namespace {
+/// @brief Initialize MPI on first use and finalize it at exit, unless the
+/// application manages MPI itself.
+class MPISession {
+  bool ownsMPI = false;
+
+public:
+  MPISession() {
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (!initialized) {
+      HANDLE_MPI_ERROR(MPI_Init(nullptr, nullptr));
+      ownsMPI = true;
+    }
+  }
+  ~MPISession() {
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (ownsMPI && !finalized)
+      MPI_Finalize();
+  }
+  static MPISession &get() {
+    static MPISession session;
+    return session;
+  }
+};
+
+/// @brief The mpi platform spans the ranks of an MPI job, which all run the
+/// same program. Each rank owns the QPUs of the multi-QPU platform on its
+/// share of the GPUs of its node. observe() splits the terms of the spin_op
+/// amongst the ranks, and the observe and sample broadcasts (and so the
+/// gradients) split their argument sets. Each rank then distributes its
+/// share amongst its own QPUs, and the results are combined with
+/// MPI_Allreduce and MPI_Allgatherv, so that all ranks return the same.
+class MPIQuantumPlatform : public MultiQPUQuantumPlatform {
+  int worldRank = 0;
+  int worldSize = 1;
+
+public:
+  MPIQuantumPlatform() : MultiQPUQuantumPlatform(getRankDevices()) {
+    HANDLE_MPI_ERROR(MPI_Comm_rank(MPI_COMM_WORLD, &worldRank));
+    HANDLE_MPI_ERROR(MPI_Comm_size(MPI_COMM_WORLD, &worldSize));
+    cudaq::info("mpi platform rank {} of {} with {} QPUs.", worldRank,
+                worldSize, platformNumQPUs);
+  }
+
+  /// @brief Return the devices of the QPUs of this rank. The ranks on a node
+  /// take its devices (see MultiQPUQuantumPlatform::getDevices()) round
+  /// robin, a rank without a device of its own shares one. With
+  /// CUDAQ_MQPU_DEVICES each rank takes the devices it lists.
+  static std::vector<int> getRankDevices() {
+    MPISession::get();
+    auto devices = getDevices();
+    if (!spdlog::details::os::getenv("CUDAQ_MQPU_DEVICES").empty() ||
+        devices.empty())
+      return devices;
+
+    MPI_Comm node;
+    HANDLE_MPI_ERROR(MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED,
+                                         0, MPI_INFO_NULL, &node));
+    int localRank = 0, localSize = 1;
+    MPI_Comm_rank(node, &localRank);
+    MPI_Comm_size(node, &localSize);
+    MPI_Comm_free(&node);
+
+    std::vector<int> rankDevices;
+    for (std::size_t i = localRank; i < devices.size(); i += localSize)
+      rankDevices.push_back(devices[i]);
+    if (rankDevices.empty())
+      rankDevices.push_back(devices[localRank % devices.size()]);
+    return rankDevices;
+  }
+
+  std::size_t num_ranks() const override { return worldSize; }
+
+  std::size_t rank() const override { return worldRank; }
+
+  void all_reduce_sum(std::vector<double> &values) override {
+    HANDLE_MPI_ERROR(MPI_Allreduce(MPI_IN_PLACE, values.data(),
+                                   static_cast<int>(values.size()), MPI_DOUBLE,
+                                   MPI_SUM, MPI_COMM_WORLD));
+  }
+
+  std::vector<std::vector<std::size_t>>
+  all_gather(const std::vector<std::size_t> &data) override {
+    static_assert(sizeof(std::size_t) == sizeof(std::uint64_t));
+    const int count = data.size();
+    std::vector<int> counts(worldSize), offsets(worldSize, 0);
+    HANDLE_MPI_ERROR(MPI_Allgather(&count, 1, MPI_INT, counts.data(), 1,
+                                   MPI_INT, MPI_COMM_WORLD));
+    for (int r = 1; r < worldSize; r++)
+      offsets[r] = offsets[r - 1] + counts[r - 1];
+    std::vector<std::size_t> all(offsets.back() + counts.back());
+    HANDLE_MPI_ERROR(MPI_Allgatherv(data.data(), count, MPI_UINT64_T,
+                                    all.data(), counts.data(), offsets.data(),
+                                    MPI_UINT64_T, MPI_COMM_WORLD));
+
+    std::vector<std::vector<std::size_t>> gathered(worldSize);
+    for (int r = 0; r < worldSize; r++)
+      gathered[r].assign(all.begin() + offsets[r],
+                         all.begin() + offsets[r] + counts[r]);
+    return gathered;
+  }
+};
+} // namespace
+
+CUDAQ_REGISTER_PLATFORM(MPIQuantumPlatform, mpi)
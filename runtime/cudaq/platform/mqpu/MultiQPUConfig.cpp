@@ -0,0 +1,105 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "MultiQPUConfig.h"
+#include "cudaq/utils/cudaq_utils.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace {
+/// @brief Return true if the url has no port, or a port in [1, 65535]. The
+/// colons of a bracketed IPv6 host are not ports.
+bool hasValidPort(const std::string &url) {
+  auto hostBegin = url.find("://");
+  hostBegin = hostBegin == std::string::npos ? 0 : hostBegin + 3;
+  const auto hostEnd = std::min(url.find('/', hostBegin), url.size());
+  const auto host = url.substr(hostBegin, hostEnd - hostBegin);
+  const auto colon = host.rfind(':');
+  if (colon == std::string::npos ||
+      (host.starts_with('[') && host.rfind(']') > colon))
+    return true;
+  const auto port = host.substr(colon + 1);
+  if (port.empty() || port.size() > 5 ||
+      !std::all_of(port.begin(), port.end(),
+                   [](unsigned char c) { return std::isdigit(c); }))
+    return false;
+  const auto number = std::stoul(port);
+  return number > 0 && number < 65536;
+}
+
+/// @brief Return the device id, a non-negative integer, or throw.
+int parseDeviceId(const std::string &id) {
+  if (id.empty() || id.size() > 9 ||
+      !std::all_of(id.begin(), id.end(),
+                   [](unsigned char c) { return std::isdigit(c); }))
+    throw std::runtime_error("Invalid CUDAQ_MQPU_DEVICES environment "
+                             "variable, must be a comma separated list of "
+                             "device ids or ranges of them (" +
+                             id + ").");
+  return std::stoi(id);
+}
+} // namespace
+
+namespace cudaq::mqpu {
+
+std::vector<std::string> parseRemoteQPUs(const std::string &value) {
+  std::vector<std::string> backends;
+  for (auto &backend : cudaq::split(value, ' ')) {
+    if (backend.empty())
+      continue;
+    auto config = cudaq::split(backend, ';');
+    if (config[0].empty() || config.size() % 2 == 0)
+      throw std::runtime_error(
+          "Invalid CUDAQ_MQPU_REMOTE_QPUS environment variable, each backend "
+          "must be its name followed by key-value pairs (" +
+          backend + ").");
+    for (std::size_t i = 1; i < config.size(); i += 2)
+      if (config[i] == "url" && !hasValidPort(config[i + 1]))
+        throw std::runtime_error(
+            "Invalid CUDAQ_MQPU_REMOTE_QPUS environment variable, the url "
+            "has an invalid port (" +
+            config[i + 1] + ").");
+    backends.push_back(backend);
+  }
+  return backends;
+}
+
+std::vector<int> parseDevices(const std::string &value, int deviceCount) {
+  // A trailing comma leaves an empty entry, which split() drops.
+  auto entries = cudaq::split(value, ',');
+  if (value.ends_with(','))
+    entries.emplace_back();
+  std::vector<int> devices;
+  for (auto &entry : entries) {
+    const auto dash = entry.find('-');
+    const int first = parseDeviceId(entry.substr(0, dash));
+    const int last = dash == std::string::npos
+                         ? first
+                         : parseDeviceId(entry.substr(dash + 1));
+    if (last < first)
+      throw std::runtime_error("Invalid CUDAQ_MQPU_DEVICES environment "
+                               "variable, the range " +
+                               entry + " is empty.");
+    for (int device = first; device <= last; device++) {
+      if (device >= deviceCount)
+        throw std::runtime_error(
+            "Invalid CUDAQ_MQPU_DEVICES environment variable, device " +
+            std::to_string(device) + " is not one of the " +
+            std::to_string(deviceCount) + " devices.");
+      if (std::find(devices.begin(), devices.end(), device) != devices.end())
+        throw std::runtime_error(
+            "Invalid CUDAQ_MQPU_DEVICES environment variable, device " +
+            std::to_string(device) + " is listed twice.");
+      devices.push_back(device);
+    }
+  }
+  return devices;
+}
+
+} // namespace cudaq::mqpu
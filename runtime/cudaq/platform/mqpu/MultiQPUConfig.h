@@ -0,0 +1,30 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace cudaq::mqpu {
+
+/// @brief Parse the value of CUDAQ_MQPU_REMOTE_QPUS, the backends of the
+/// remote QPUs separated by spaces, e.g.
+/// "quantinuum;machine;H1-1E quantinuum;url;https://localhost:62440". Each
+/// backend is its name followed by the key-value pairs of its config,
+/// separated by semicolons. Throw if a config is not made of pairs or if its
+/// url has an invalid port.
+std::vector<std::string> parseRemoteQPUs(const std::string &value);
+
+/// @brief Parse the value of CUDAQ_MQPU_DEVICES, a comma separated list of
+/// device ids and inclusive ranges of them, e.g. "0,2,4-7". Throw if an
+/// entry is malformed, if a device is listed twice, or if it is not one of
+/// the `deviceCount` devices.
+std::vector<int> parseDevices(const std::string &value, int deviceCount);
+
+} // namespace cudaq::mqpu
@@ -6,6 +6,7 @@
  * the terms of the Apache License 2.0 which accompanies this distribution.    *
  *******************************************************************************/
 
+#include "MultiQPUConfig.h"
 #include "common/ExecutionContext.h"
 #include "common/Logger.h"
 #include "common/NoiseModel.h"
@@ -14,105 +15,123 @@
 #include "cudaq/platform/quantum_platform.h"
 #include "cudaq/qis/qubit_qis.h"
 #include "cudaq/spin_op.h"
+#include <array>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <spdlog/cfg/env.h>
 
 namespace {
-// We want to kick off CUDA lazy initialization,
-// flip this to true once we do
-static bool devicesWarmedUp = false;
+/// @brief The execution context of the calling thread. The tasks of all
+/// QPUs run concurrently on their own worker threads, each thread owns its
+/// execution manager and simulator, see cudaq::getExecutionManager(), so it
+/// only needs to know its own context.
+thread_local cudaq::ExecutionContext *threadContext = nullptr;
 
 /// @brief This QPU implementation enqueues kernel
 /// execution tasks and sets the CUDA GPU device that it
 /// represents. There is a GPUEmulatedQPU per available GPU.
 class GPUEmulatedQPU : public cudaq::QPU {
-protected:
-  std::map<std::size_t, cudaq::ExecutionContext *> contexts;
+  /// @brief The CUDA device of this QPU.
+  int deviceId = 0;
+
+  /// @brief Set once the warm-up of the device is enqueued.
+  std::once_flag warmUpFlag;
 
 public:
   GPUEmulatedQPU() = default;
-  GPUEmulatedQPU(std::size_t id) : QPU(id) {}
+  GPUEmulatedQPU(std::size_t id, int device) : QPU(id), deviceId(device) {}
 
   void enqueue(cudaq::QuantumTask &task) override {
     cudaq::info("Enqueue Task on QPU {}", qpu_id);
-    cudaSetDevice(qpu_id);
+    // Warm up the device on the queue worker ahead of the first task, so
+    // that CUDA lazy initialization does not delay the platform creation
+    // and overlaps with the work of the caller.
+    std::call_once(warmUpFlag, [this]() {
+      cudaq::QuantumTask warmUp = [id = qpu_id, device = deviceId]() {
+        cudaSetDevice(device);
+        cudaFree(0);
+
+        // Warm up the GPU via an allocation / deallocation.
+        cudaq::info("Warm up Emulated QPU {} (GPU {}).", id, device);
+        auto warmUpSim = cudaq::getExecutionManager();
+        std::array<std::size_t, 1> qbits{warmUpSim->getAvailableIndex()};
+        warmUpSim->returnQubit(qbits[0]);
+      };
+      execution_queue->enqueue(warmUp);
+    });
     execution_queue->enqueue(task);
   }
 
   void launchKernel(const std::string &name, void (*kernelFunc)(void *),
                     void *args, std::uint64_t, std::uint64_t) override {
-    cudaq::info("QPU::launchKernel GPU {}", qpu_id);
+    cudaq::info("QPU::launchKernel GPU {}", deviceId);
     kernelFunc(args);
   }
 
   /// Overrides setExecutionContext to forward it to the ExecutionManager
   void setExecutionContext(cudaq::ExecutionContext *context) override {
-    cudaSetDevice(qpu_id);
+    cudaSetDevice(deviceId);
 
     cudaq::info("MultiQPUPlatform::setExecutionContext QPU {}", qpu_id);
-    auto tid = std::hash<std::thread::id>{}(std::this_thread::get_id());
-    contexts.emplace(tid, context);
+    threadContext = context;
     if (noiseModel)
-      contexts[tid]->noiseModel = noiseModel;
+      threadContext->noiseModel = noiseModel;
 
-    cudaq::getExecutionManager()->setExecutionContext(contexts[tid]);
+    cudaq::getExecutionManager()->setExecutionContext(threadContext);
+    beginExecution(*threadContext);
   }
 
   /// Overrides resetExecutionContext to forward to
   /// the ExecutionManager. Also handles observe post-processing
   void resetExecutionContext() override {
     cudaq::info("MultiQPUPlatform::resetExecutionContext QPU {}", qpu_id);
-    auto tid = std::hash<std::thread::id>{}(std::this_thread::get_id());
-
-    auto ctx = contexts[tid];
+    auto *ctx = threadContext;
     if (ctx && ctx->name == "observe") {
-      double sum = 0.0;
       if (!ctx->spin.has_value())
         throw std::runtime_error(
             "Observe ExecutionContext specified without a cudaq::spin_op.");
 
-      std::vector<cudaq::ExecutionResult> results;
       cudaq::spin_op &H = *ctx->spin.value();
 
-      // If the backend supports the observe task,
-      // let it compute the expectation value instead of
-      // manually looping over terms, applying basis change ops,
-      // and computing <ZZ..ZZZ>
-      if (ctx->canHandleObserve) {
-        auto [exp, data] = cudaq::measure(H);
-        results.emplace_back(data.to_map(), H.to_string());
-        ctx->expectationValue = exp;
-        ctx->result = cudaq::sample_result(results);
-      } else {
-        H.for_each_term([&](cudaq::spin_op &term) {
-          if (term.is_identity())
-            sum += term.get_term_coefficient(0).real();
-          else {
-
-            auto [exp, data] = cudaq::measure(term);
-            results.emplace_back(data.to_map(), term.to_string());
-            sum += term.get_term_coefficient(0).real() * exp;
-          }
-        });
-
-        ctx->expectationValue = sum;
-        ctx->result = cudaq::sample_result(sum, results);
-      }
+      // The simulator evaluates all terms against the state prepared by
+      // the kernel. If the backend supports the observe task it computes
+      // <psi | H | psi> itself, otherwise NVQIR applies the basis change ops
+      // and computes <ZZ..ZZZ> for each term.
+      auto [exp, data] = cudaq::measure(H);
+      ctx->expectationValue = exp;
+      if (ctx->canHandleObserve && !ctx->termExpectations) {
+        std::vector<cudaq::ExecutionResult> results;
+        auto &result = results.emplace_back(data.extract_register());
+        result.registerName = H.to_string();
+        ctx->result = cudaq::sample_result(exp, std::move(results));
+      } else
+        ctx->result = std::move(data);
     }
 
     cudaq::getExecutionManager()->resetExecutionContext();
-    contexts[tid] = nullptr;
-    contexts.erase(tid);
+    if (ctx)
+      endExecution(*ctx);
+    threadContext = nullptr;
   }
 };
 
 class MultiQPUQuantumPlatform : public cudaq::quantum_platform {
 public:
   ~MultiQPUQuantumPlatform() = default;
-  MultiQPUQuantumPlatform() {
-    int nDevices;
-    cudaGetDeviceCount(&nDevices);
+  MultiQPUQuantumPlatform() : MultiQPUQuantumPlatform(getDevices()) {}
+
+  /// @brief Return the devices of the QPUs. CUDAQ_MQPU_DEVICES pins a list of
+  /// device ids, e.g. "0,2,4-7" (see cudaq::mqpu::parseDevices()), otherwise
+  /// CUDAQ_MQPU_NGPUS takes the first devices.
+  static std::vector<int> getDevices() {
+    int nDevices = 0;
+    if (cudaGetDeviceCount(&nDevices) != cudaSuccess)
+      nDevices = 0;
+
+    auto deviceList = spdlog::details::os::getenv("CUDAQ_MQPU_DEVICES");
+    if (!deviceList.empty())
+      return cudaq::mqpu::parseDevices(deviceList, nDevices);
 
     auto envVal = spdlog::details::os::getenv("CUDAQ_MQPU_NGPUS");
     if (!envVal.empty()) {
@@ -120,42 +139,52 @@ public:
       try {
         specifiedNDevices = std::stoi(envVal);
       } catch (...) {
-        throw std::runtime_error(
-            "Invalid CUDAQ_MQPU_NGPUS environment variable, must be integer.");
+        throw std::runtime_error("Invalid CUDAQ_MQPU_NGPUS environment "
+                                 "variable, must be integer.");
       }
 
       if (specifiedNDevices < nDevices)
         nDevices = specifiedNDevices;
     }
+    std::vector<int> devices;
+    for (int i = 0; i < nDevices; i++)
+      devices.push_back(i);
+    return devices;
+  }
 
-    if (!devicesWarmedUp) {
-      // Warm up the GPUs so we don't have any lazy init issues.
-      std::vector<std::future<void>> futures;
-      for (int i = 0; i < nDevices; i++) {
-        futures.emplace_back(std::async(std::launch::async, [i]() {
-          auto warmUpSim = cudaq::getExecutionManager();
-
-          cudaSetDevice(i);
-          cudaFree(0);
-
-          // Warm up the GPUs via an allocation / deallocation.
-          cudaq::info("Warm up Emulated QPU (GPU) {}.", i);
-          std::array<std::size_t, 1> qbits{warmUpSim->getAvailableIndex()};
-          warmUpSim->returnQubit(qbits[0]);
-        }));
-      }
-
-      // Sync up the threads
-      for (auto &f : futures)
-        f.get();
-
-      cudaSetDevice(0);
-      devicesWarmedUp = true;
+  explicit MultiQPUQuantumPlatform(const std::vector<int> &devices) {
+    // Add a QPU for each GPU. The GPUs are warmed up lazily, on the first
+    // task of their QPU.
+    for (auto device : devices)
+      platformQPUs.emplace_back(
+          std::make_unique<GPUEmulatedQPU>(platformQPUs.size(), device));
+
+    // Add a remote QPU for each backend of CUDAQ_MQPU_REMOTE_QPUS, each with
+    // its own config (e.g. the credentials of an account), see
+    // cudaq::mqpu::parseRemoteQPUs(). Work is distributed to the QPUs by
+    // their measured throughput, so the remote QPUs take the work the GPUs
+    // cannot keep up with.
+    for (auto &backend : cudaq::mqpu::parseRemoteQPUs(
+             spdlog::details::os::getenv("CUDAQ_MQPU_REMOTE_QPUS"))) {
+#ifdef CUDAQ_MQPU_REMOTE
+      auto qpu = cudaq::registry::get<cudaq::QPU>("remote_rest");
+#else
+      std::unique_ptr<cudaq::QPU> qpu;
+#endif
+      if (!qpu)
+        throw std::runtime_error("Remote QPUs are not available on the mqpu "
+                                 "platform, it was built without the REST "
+                                 "QPU (" +
+                                 backend + ").");
+      cudaq::info("Add remote QPU {} targeting {}.", platformQPUs.size(),
+                  backend);
+      qpu->setTargetBackend(backend);
+      platformQPUs.emplace_back(std::move(qpu));
     }
-
-    // Add a QPU for each GPU.
-    for (int i = 0; i < nDevices; i++)
-      platformQPUs.emplace_back(std::make_unique<GPUEmulatedQPU>(i));
+    if (platformQPUs.empty())
+      throw std::runtime_error("The mqpu platform has no QPUs, no GPU is "
+                               "available and CUDAQ_MQPU_REMOTE_QPUS is not "
+                               "set.");
 
     platformNumQPUs = platformQPUs.size();
     platformCurrentQPU = 0;
@@ -163,4 +192,7 @@ public:
 };
 } // namespace
 
+// The mpi platform includes this file to build on the multi-QPU platform.
+#ifndef CUDAQ_MQPU_TOGGLE_REGISTER
 CUDAQ_REGISTER_PLATFORM(MultiQPUQuantumPlatform, mqpu)
+#endif
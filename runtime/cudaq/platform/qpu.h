@@ -9,10 +9,13 @@
 #pragma once
 
 #include "QuantumExecutionQueue.h"
+#include "common/ExecutionContext.h"
 #include "common/Registry.h"
 #include "cudaq/qis/execution_manager.h"
 #include "cudaq/utils/cudaq_utils.h"
 
+#include <algorithm>
+#include <chrono>
 #include <optional>
 
 namespace cudaq {
@@ -42,6 +45,31 @@ protected:
   ExecutionContext *executionContext = nullptr;
   noise_model *noiseModel = nullptr;
 
+  /// @brief The start of the kernel execution of this thread, and the
+  /// simulator time of its context at that point.
+  static inline thread_local std::chrono::steady_clock::time_point
+      executionStart;
+  static inline thread_local double executionSimulatorSeconds = 0.0;
+
+  /// @brief Start a kernel execution under `context`, see endExecution().
+  static void beginExecution(ExecutionContext &context) {
+    executionStart = std::chrono::steady_clock::now();
+    executionSimulatorSeconds = context.counters.simulator_seconds;
+  }
+
+  /// @brief Count the kernel execution under `context` begun last on this
+  /// thread in its performance counters. Its time not spent in the
+  /// simulator is host time.
+  static void endExecution(ExecutionContext &context) {
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - executionStart;
+    auto &counters = context.counters;
+    const double simulatorSeconds =
+        counters.simulator_seconds - executionSimulatorSeconds;
+    counters.kernel_executions++;
+    counters.host_seconds += std::max(0.0, elapsed.count() - simulatorSeconds);
+  }
+
 public:
   /// The constructor, initializes the execution queue
   QPU() : execution_queue(std::make_unique<QuantumExecutionQueue>()) {}
@@ -56,6 +84,8 @@ public:
   virtual ~QPU() = default;
 
   virtual void setNoiseModel(noise_model *model) { noiseModel = model; }
+  /// Return the noise model of this QPU, nullptr if noiseless.
+  noise_model *getNoiseModel() { return noiseModel; }
 
   /// Return the number of qubits
   std::size_t getNumQubits() { return numQubits; }
@@ -74,10 +104,25 @@ public:
 
   virtual bool isRemote() { return false; }
 
+  /// @brief Return true if launchKernel() only reads the argument buffer in
+  /// this process, before it returns, so that the buffer may point to the data
+  /// of vector arguments instead of holding a copy.
+  virtual bool canReferenceArguments() { return !isRemote(); }
+
   /// Enqueue a quantum task on the asynchronous execution queue.
   virtual void
   enqueue(QuantumTask &task) = 0; //{ execution_queue->enqueue(task); }
 
+  /// Enqueue a quantum task with the given priority and batch key.
+  void enqueue(QuantumTask &task, const QuantumTaskOptions &options) {
+    execution_queue->enqueue(task, options);
+  }
+
+  /// Set the number of tasks of the execution queue run concurrently.
+  void setNumQueueWorkers(std::size_t n) { execution_queue->setNumWorkers(n); }
+  /// Return the number of tasks of the execution queue run concurrently.
+  std::size_t getNumQueueWorkers() { return execution_queue->getNumWorkers(); }
+
   /// Set the execution context, meant for subtype specification
   virtual void setExecutionContext(ExecutionContext *context) = 0;
   /// Reset the execution context, meant for subtype specification
@@ -81,6 +81,9 @@ public:
     qpudClient.set_backend(backend);
   }
 
+  /// The argument buffers are sent to the qpud process.
+  bool canReferenceArguments() override { return false; }
+
   /// Launch the kernel with given name and runtime arguments.
   void launchKernel(const std::string &kernelName, void (*kernelFunc)(void *),
                     void *args, std::uint64_t voidStarSize,
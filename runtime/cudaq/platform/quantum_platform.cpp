@@ -16,10 +16,15 @@
 #include "cudaq/platform/quantum_platform.h"
 #include "common/Logger.h"
 #include "common/PluginUtils.h"
+#include "common/Profiler.h"
+#include "common/ThreadAffinity.h"
 #include "cudaq/platform/qpu.h"
 #include "cudaq/qis/qubit_qis.h"
 #include "cudaq/qis/qudit.h"
 #include "nvqpp_config.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <fmt/core.h>
 #include <fstream>
 #include <iostream>
@@ -52,28 +57,168 @@ quantum_platform *getQuantumPlatformInternal() {
   return platform;
 }
 
+thread_local std::size_t quantum_platform::platformCurrentQPU = 0;
+thread_local ExecutionContext *quantum_platform::executionContext = nullptr;
+
 void quantum_platform::set_noise(noise_model *model) {
   auto &platformQPU = platformQPUs[platformCurrentQPU];
   platformQPU->setNoiseModel(model);
 }
 
+noise_model *quantum_platform::get_noise(const std::size_t qpu_id) {
+  return platformQPUs[qpu_id]->getNoiseModel();
+}
+
+void quantum_platform::set_random_seed(std::uint64_t seed) {
+  platformRandomSeed = seed;
+  platformSeedsDrawn = 0;
+}
+
+std::optional<std::uint64_t> quantum_platform::next_random_seed() {
+  if (!platformRandomSeed)
+    return std::nullopt;
+  return details::mixSeed(*platformRandomSeed, platformSeedsDrawn++);
+}
+
 std::future<sample_result>
-quantum_platform::enqueueAsyncTask(const std::size_t qpu_id,
-                                   KernelExecutionTask &task) {
+quantum_platform::enqueueAsyncTask(
+    const std::size_t qpu_id, KernelExecutionTask &task,
+    const QuantumTaskOptions &options,
+    std::shared_ptr<details::completion_signal> completion) {
   set_current_qpu(qpu_id);
 
   std::promise<sample_result> promise;
   auto f = promise.get_future();
   QuantumTask wrapped = detail::make_copyable_function(
-      [p = std::move(promise), t = std::move(task)]() mutable {
-        auto counts = t();
-        p.set_value(counts);
+      [p = std::move(promise), t = std::move(task),
+       completion = std::move(completion), qpu_id,
+       enqueued = profiler::now()]() mutable {
+        profiler::record("queue wait", profiler::Category::queue_wait,
+                         enqueued, profiler::now(), qpu_id);
+        profiler::ScopedQPU scopedQPU(qpu_id);
+        try {
+          p.set_value(t());
+        } catch (...) {
+          p.set_exception(std::current_exception());
+        }
+        if (completion)
+          completion->notify();
       });
 
-  platformQPUs[platformCurrentQPU]->enqueue(wrapped);
+  platformQPUs[platformCurrentQPU]->enqueue(wrapped, options);
   return f;
 }
 
+struct task_completion_stream::state {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<UnplacedTask> tasks;
+  std::vector<std::promise<sample_result>> promises;
+  std::vector<std::future<sample_result>> futures;
+  /// The next task to start, the running tasks, and the completed ones not
+  /// yet returned.
+  std::size_t nextTask = 0;
+  std::size_t running = 0;
+  std::deque<std::size_t> completed;
+  std::size_t returned = 0;
+};
+
+task_completion_stream::~task_completion_stream() {
+  if (!taskState)
+    return;
+  std::unique_lock lock(taskState->mutex);
+  taskState->nextTask = taskState->tasks.size();
+  taskState->changed.wait(lock, [&] { return taskState->running == 0; });
+}
+
+std::optional<std::pair<std::size_t, sample_result>>
+task_completion_stream::next() {
+  auto &s = *taskState;
+  std::unique_lock lock(s.mutex);
+  if (s.returned == s.tasks.size())
+    return std::nullopt;
+  s.changed.wait(lock, [&] { return !s.completed.empty(); });
+  const auto i = s.completed.front();
+  s.completed.pop_front();
+  s.returned++;
+  lock.unlock();
+  return std::make_pair(i, s.futures[i].get());
+}
+
+std::size_t task_completion_stream::remaining() const {
+  std::lock_guard lock(taskState->mutex);
+  return taskState->tasks.size() - taskState->returned;
+}
+
+task_completion_stream
+quantum_platform::enqueueUnplacedTasks(std::vector<UnplacedTask> tasks,
+                                       const std::vector<std::size_t> &qpuIds) {
+  auto s = std::make_shared<task_completion_stream::state>();
+  const auto nTasks = tasks.size();
+  s->tasks = std::move(tasks);
+  s->promises.resize(nTasks);
+  for (auto &promise : s->promises)
+    s->futures.emplace_back(promise.get_future());
+
+  std::vector<std::size_t> qpus = qpuIds;
+  if (qpus.empty())
+    for (std::size_t i = 0; i < platformNumQPUs; i++)
+      qpus.push_back(i);
+  for (auto qpu : qpus)
+    if (qpu >= platformNumQPUs)
+      throw std::invalid_argument(
+          "QPU device id is not valid (greater than number of available "
+          "QPUs).");
+  // One pump per queue worker, round robin over the QPUs.
+  std::vector<std::size_t> pumps;
+  for (std::size_t round = 0; pumps.size() < nTasks; round++) {
+    const auto before = pumps.size();
+    for (auto qpu : qpus)
+      if (round < platformQPUs[qpu]->getNumQueueWorkers() &&
+          pumps.size() < nTasks)
+        pumps.push_back(qpu);
+    if (pumps.size() == before)
+      break;
+  }
+  for (auto qpu : pumps)
+    enqueueUnplacedTaskPump(s, qpu);
+  return task_completion_stream(std::move(s));
+}
+
+void quantum_platform::enqueueUnplacedTaskPump(
+    std::shared_ptr<task_completion_stream::state> s, std::size_t qpuId) {
+  // Each pump runs one task and enqueues the next pump behind the tasks
+  // enqueued on the QPU meanwhile.
+  QuantumTask pump = [this, s, qpuId, enqueued = profiler::now()]() {
+    profiler::record("queue wait", profiler::Category::queue_wait, enqueued,
+                     profiler::now(), qpuId);
+    profiler::ScopedQPU scopedQPU(qpuId);
+    std::unique_lock lock(s->mutex);
+    if (s->nextTask == s->tasks.size())
+      return;
+    const auto i = s->nextTask++;
+    s->running++;
+    lock.unlock();
+
+    platformCurrentQPU = qpuId;
+    try {
+      s->promises[i].set_value(s->tasks[i](qpuId));
+    } catch (...) {
+      s->promises[i].set_exception(std::current_exception());
+    }
+
+    lock.lock();
+    s->running--;
+    s->completed.push_back(i);
+    const bool more = s->nextTask < s->tasks.size();
+    lock.unlock();
+    s->changed.notify_all();
+    if (more)
+      enqueueUnplacedTaskPump(s, qpuId);
+  };
+  platformQPUs[qpuId]->enqueue(pump);
+}
+
 void quantum_platform::set_current_qpu(const std::size_t device_id) {
   if (device_id >= platformNumQPUs) {
     throw std::invalid_argument(
@@ -90,6 +235,8 @@ std::size_t quantum_platform::get_current_qpu() { return platformCurrentQPU; }
 void quantum_platform::set_exec_ctx(cudaq::ExecutionContext *ctx,
                                     std::size_t qid) {
   executionContext = ctx;
+  // Kernels launched on this thread run on the QPU of the context.
+  platformCurrentQPU = qid;
   auto &platformQPU = platformQPUs[qid];
   platformQPU->setExecutionContext(ctx);
 }
@@ -118,16 +265,152 @@ bool quantum_platform::supports_conditional_feedback(
   return platformQPUs[qpu_id]->supportsConditionalFeedback();
 }
 
+bool quantum_platform::can_reference_arguments() {
+  // The arguments of resource estimates are synthesized after the launch.
+  if (executionContext && executionContext->name == "resource-estimate")
+    return false;
+  return platformQPUs[platformCurrentQPU]->canReferenceArguments();
+}
+
 void quantum_platform::launchKernel(std::string kernelName,
                                     void (*kernelFunc)(void *), void *args,
                                     std::uint64_t voidStarSize,
                                     std::uint64_t resultOffset) {
-  auto &qpu = platformQPUs[platformCurrentQPU];
-  qpu->launchKernel(kernelName, kernelFunc, args, voidStarSize, resultOffset);
+  // Kernels are only recorded for the compiler to estimate their resources.
+  if (executionContext && executionContext->name == "resource-estimate") {
+    if (executionContext->kernelName.empty()) {
+      executionContext->kernelName = kernelName;
+      auto *begin = static_cast<char *>(args);
+      executionContext->kernelArgs.assign(begin, begin + voidStarSize);
+    }
+    return;
+  }
+  const auto qpuId = platformCurrentQPU;
+  auto &qpu = platformQPUs[qpuId];
+  const auto start = std::chrono::steady_clock::now();
+  {
+    profiler::ScopedQPU scopedQPU(qpuId);
+    profiler::ScopedEvent event("launchKernel", profiler::Category::launch);
+    qpu->launchKernel(kernelName, kernelFunc, args, voidStarSize,
+                      resultOffset);
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::lock_guard<std::mutex> lock(platformStatisticsMutex);
+  if (platformQPUStatistics.size() <= qpuId)
+    platformQPUStatistics.resize(qpuId + 1);
+  platformQPUStatistics[qpuId].launches++;
+  platformQPUStatistics[qpuId].busy_seconds += elapsed.count();
+}
+
+qpu_statistics quantum_platform::get_qpu_statistics(const std::size_t qpu_id) {
+  std::lock_guard<std::mutex> lock(platformStatisticsMutex);
+  if (qpu_id >= platformQPUStatistics.size())
+    return {};
+  return platformQPUStatistics[qpu_id];
+}
+
+void quantum_platform::reset_qpu_statistics() {
+  std::lock_guard<std::mutex> lock(platformStatisticsMutex);
+  platformQPUStatistics.clear();
+}
+
+std::vector<sample_result>
+quantum_platform::all_gather_results(std::vector<sample_result> &results) {
+  if (num_ranks() < 2)
+    return results;
+  // Each result is its serialized length followed by its serialized counts.
+  std::vector<std::size_t> data;
+  for (auto &result : results) {
+    auto serialized = result.serialize();
+    data.push_back(serialized.size());
+    data.insert(data.end(), serialized.begin(), serialized.end());
+  }
+  std::vector<sample_result> gathered;
+  for (auto &rankData : all_gather(data))
+    for (std::size_t i = 0; i < rankData.size(); i += rankData[i] + 1) {
+      std::vector<std::size_t> serialized(rankData.begin() + i + 1,
+                                          rankData.begin() + i + 1 +
+                                              rankData[i]);
+      gathered.emplace_back().deserialize(serialized);
+    }
+  return gathered;
+}
+
+void quantum_platform::set_num_shot_threads(std::size_t n) {
+  platformNumShotThreads = std::max<std::size_t>(n, 1);
+  if (platformShotThreads)
+    platformShotThreads->setNumWorkers(platformNumShotThreads);
+}
+
+std::size_t quantum_platform::get_num_shot_threads() {
+  if (platformNumShotThreads == 0) {
+    platformNumShotThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (auto *threads = std::getenv("CUDAQ_SHOT_THREADS"))
+      platformNumShotThreads =
+          std::max<std::size_t>(std::strtoul(threads, nullptr, 10), 1);
+  }
+  return platformNumShotThreads;
+}
+
+void quantum_platform::set_thread_pinning(bool pin) {
+  platformPinThreads = pin;
+}
+
+void quantum_platform::run_on_shot_threads(
+    std::size_t n, const std::function<void(std::size_t)> &task) {
+  if (n > get_num_shot_threads())
+    throw std::invalid_argument("More shot tasks than shot threads.");
+  if (!platformPinThreads) {
+    auto *pin = std::getenv("CUDAQ_PIN_THREADS");
+    platformPinThreads = pin && std::strtoul(pin, nullptr, 10) != 0;
+  }
+  if (!platformShotThreads)
+    platformShotThreads =
+        std::make_unique<QuantumExecutionQueue>(platformNumShotThreads);
+
+  std::vector<std::future<void>> done;
+  for (std::size_t i = 0; i < n; i++) {
+    std::promise<void> promise;
+    done.emplace_back(promise.get_future());
+    QuantumTask wrapped = detail::make_copyable_function(
+        [p = std::move(promise), &task, i, n, pin = *platformPinThreads,
+         this]() mutable {
+          // Kernels launched by the task run on this platform.
+          platform = this;
+          // The tasks run concurrently, each simulator only uses its share of
+          // the cores.
+          auto cores = getCorePartition(i, n);
+          setSimulatorThreadBudget(cores.size());
+          // A thread pinned by an earlier sampling is released to all the
+          // cores once pinning is disabled.
+          static thread_local bool pinned = false;
+          if (pin || pinned)
+            pinned = pinCallingThread(pin ? cores : getCoresByNumaNode()) &&
+                     pin;
+          try {
+            task(i);
+            p.set_value();
+          } catch (...) {
+            p.set_exception(std::current_exception());
+          }
+        });
+    platformShotThreads->enqueue(wrapped);
+  }
+  // Wait for all tasks before rethrowing, they reference `task`.
+  for (auto &f : done)
+    f.wait();
+  for (auto &f : done)
+    f.get();
 }
 
 } // namespace cudaq
 
+bool cudaq::altArgumentsByReference() {
+  return cudaq::getQuantumPlatformInternal()->can_reference_arguments();
+}
+
 void cudaq::altLaunchKernel(const char *kernelName, void (*kernelFunc)(void *),
                             void *kernelArgs, std::uint64_t argsSize,
                             std::uint64_t resultOffset) {
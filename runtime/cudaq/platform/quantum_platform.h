@@ -11,12 +11,17 @@
 #include "common/ExecutionContext.h"
 #include "common/NoiseModel.h"
 #include "common/ObserveResult.h"
+#include "cudaq/platform/QuantumExecutionQueue.h"
 #include "cudaq/utils/cudaq_utils.h"
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
 #include <cxxabi.h>
+#include <deque>
 #include <functional>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
@@ -37,6 +42,55 @@ using KernelExecutionTask = std::function<sample_result()>;
 /// a double expectation value.
 using ObserveTask = std::function<observe_result()>;
 
+namespace details {
+/// Return the seed of the given index in the stream of seeds started by
+/// `seed`, a splitmix64 hash of both.
+inline std::uint64_t mixSeed(std::uint64_t seed, std::uint64_t index) {
+  std::uint64_t x = seed + (index + 1) * 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+} // namespace details
+
+/// An unplaced task runs on whichever QPU takes it, whose id it is given,
+/// and returns a sample_result instance.
+using UnplacedTask = std::function<sample_result(std::size_t)>;
+
+/// The results of a set of unplaced tasks in the order they complete, see
+/// quantum_platform::enqueueUnplacedTasks(). Destroying the stream cancels
+/// the tasks not yet started and waits for the running ones.
+class task_completion_stream {
+public:
+  /// The task queue shared with the QPU workers.
+  struct state;
+
+  explicit task_completion_stream(std::shared_ptr<state> s)
+      : taskState(std::move(s)) {}
+  task_completion_stream(task_completion_stream &&) = default;
+  ~task_completion_stream();
+
+  /// Wait for the next task to complete and return its index and result,
+  /// rethrowing its exception, or std::nullopt once all were returned.
+  std::optional<std::pair<std::size_t, sample_result>> next();
+
+  /// Return the number of tasks not yet returned by next().
+  std::size_t remaining() const;
+
+private:
+  std::shared_ptr<state> taskState;
+};
+
+/// The kernel launches of a QPU and the time spent in them, see
+/// quantum_platform::get_qpu_statistics().
+struct qpu_statistics {
+  /// The number of kernels launched on the QPU.
+  std::size_t launches = 0;
+  /// The time spent in these launches, in seconds. Launches on remote QPUs
+  /// that return before the job completes only count its submission.
+  double busy_seconds = 0.0;
+};
+
 /// The quantum_platform corresponds to a specific quantum architecture.
 /// The quantum_platform exposes a public API for programmers to
 /// query specific information about the targeted QPU(s) (e.g. number
@@ -93,11 +147,41 @@ public:
 
   bool is_remote(const std::size_t qpuId = 0);
 
+  /// @brief Return true if the current QPU of the calling thread may read the
+  /// data of vector kernel arguments through pointers into the caller's
+  /// vectors, so that kernel launches do not copy that data.
+  bool can_reference_arguments();
+
   void set_noise(noise_model *model);
 
-  /// Enqueue an asynchronous sampling task.
-  std::future<sample_result> enqueueAsyncTask(const std::size_t qpu_id,
-                                              KernelExecutionTask &t);
+  /// Return the noise model of the given QPU, nullptr if noiseless.
+  noise_model *get_noise(const std::size_t qpu_id = 0);
+
+  /// Seed the random outcomes of the executions from now on. Each sampling
+  /// draws its seed from a deterministic stream started by this seed.
+  void set_random_seed(std::uint64_t seed);
+
+  /// Return the next seed of the stream started by set_random_seed(), or
+  /// std::nullopt if no seed was set.
+  std::optional<std::uint64_t> next_random_seed();
+
+  /// Enqueue an asynchronous sampling task, with the given priority and
+  /// batch key on the execution queue of the QPU. The `completion` signal,
+  /// if any, is notified by the queue worker once the result (or the
+  /// exception of the task) is set.
+  std::future<sample_result>
+  enqueueAsyncTask(const std::size_t qpu_id, KernelExecutionTask &t,
+                   const QuantumTaskOptions &options = {},
+                   std::shared_ptr<details::completion_signal> completion = {});
+
+  /// Enqueue tasks without placing them on a QPU. Every QPU in `qpu_ids`
+  /// (all QPUs if empty) takes the next pending task whenever it is free,
+  /// in turn with the tasks enqueued on it directly, so work of uneven cost
+  /// does not leave QPUs idle while others still have a backlog. A QPU with
+  /// several queue workers takes as many tasks at once.
+  task_completion_stream
+  enqueueUnplacedTasks(std::vector<UnplacedTask> tasks,
+                       const std::vector<std::size_t> &qpu_ids = {});
 
   /// Enqueue an asynchronous observation task
   // std::future<observe_result>
@@ -109,6 +193,60 @@ public:
                     void *args, std::uint64_t voidStarSize,
                     std::uint64_t resultOffset);
 
+  /// Return the kernel launches of the QPU since the platform was created
+  /// or reset_qpu_statistics() was last called.
+  qpu_statistics get_qpu_statistics(const std::size_t qpu_id = 0);
+
+  /// Reset the launch statistics of all QPUs.
+  void reset_qpu_statistics();
+
+  /// Set the number of threads the shots of a per-shot sampling (kernels
+  /// with conditionals on measurement results, or noise trajectories) are
+  /// split over, 1 to run them on the calling thread. Defaults to the
+  /// CUDAQ_SHOT_THREADS environment variable, else the hardware concurrency.
+  void set_num_shot_threads(std::size_t n);
+
+  /// Return the number of threads of a per-shot sampling.
+  std::size_t get_num_shot_threads();
+
+  /// Pin the shot threads, and the threads their simulators start, to
+  /// disjoint sets of cores, filled NUMA node by NUMA node, so that the
+  /// amplitudes of each simulator are allocated on the node it runs on.
+  /// Defaults to the CUDAQ_PIN_THREADS environment variable (0 or 1).
+  void set_thread_pinning(bool pin);
+
+  /// Run `task(i)` for every `i < n` concurrently on the shot threads and
+  /// wait for all of them, rethrowing the first exception. The threads are
+  /// kept for the next sampling, so that the simulators of the threads are
+  /// created once. `n` must not exceed get_num_shot_threads(). The cores are
+  /// split amongst the `n` tasks, the simulator of each may only use the
+  /// threads of its share.
+  void run_on_shot_threads(std::size_t n,
+                           const std::function<void(std::size_t)> &task);
+
+  /// Return the number of processes the work of this platform is split
+  /// amongst, each with its own QPUs. 1 unless the platform spans the ranks
+  /// of an MPI job (the mpi platform), whose processes all run the same
+  /// program and observe and sample in lockstep.
+  virtual std::size_t num_ranks() const { return 1; }
+
+  /// Return the index of this process amongst num_ranks().
+  virtual std::size_t rank() const { return 0; }
+
+  /// Sum `values` element by element over all processes, in place.
+  virtual void all_reduce_sum(std::vector<double> &values) {}
+
+  /// Return the `data` of every process, in rank order.
+  virtual std::vector<std::vector<std::size_t>>
+  all_gather(const std::vector<std::size_t> &data) {
+    return {data};
+  }
+
+  /// Return the `results` of every process concatenated in rank order. Only
+  /// the counts of the results are exchanged.
+  std::vector<sample_result> all_gather_results(
+      std::vector<sample_result> &results);
+
   /// List all available platforms, which correspond to .qplt files in the
   /// platform directory.
   static std::vector<std::string> list_platforms();
@@ -125,6 +263,10 @@ public:
   virtual void setTargetBackend(const std::string &name) {}
 
 protected:
+  /// Enqueue on the given QPU the taking of the next unplaced task.
+  void enqueueUnplacedTaskPump(std::shared_ptr<task_completion_stream::state>,
+                               std::size_t qpu_id);
+
   /// The Platform QPUs, populated by concrete subtypes
   std::vector<std::unique_ptr<QPU>> platformQPUs;
 
@@ -134,13 +276,33 @@ protected:
   /// Number of QPUs in the platform.
   std::size_t platformNumQPUs;
 
-  /// The current QPU.
-  std::size_t platformCurrentQPU = 0;
+  /// The current QPU of the calling thread. The worker threads of the QPUs
+  /// select theirs concurrently while running asynchronous tasks.
+  static thread_local std::size_t platformCurrentQPU;
 
   /// Optional number of shots.
   std::optional<int> platformNumShots;
 
-  ExecutionContext *executionContext = nullptr;
+  /// The seed set by set_random_seed() and the number of seeds drawn since.
+  std::optional<std::uint64_t> platformRandomSeed;
+  std::atomic<std::uint64_t> platformSeedsDrawn = 0;
+
+  /// The launch statistics of each QPU, and their guard since the QPUs
+  /// launch kernels concurrently.
+  std::vector<qpu_statistics> platformQPUStatistics;
+  std::mutex platformStatisticsMutex;
+
+  /// The number of shot threads, zero until set or first read, and the
+  /// queue whose workers they are, started by the first per-shot sampling.
+  std::size_t platformNumShotThreads = 0;
+  std::unique_ptr<QuantumExecutionQueue> platformShotThreads;
+
+  /// Whether the shot threads are pinned to their cores, unset until set or
+  /// first read.
+  std::optional<bool> platformPinThreads;
+
+  /// The execution context of the calling thread.
+  static thread_local ExecutionContext *executionContext;
 };
 
 /// Entry point for the auto-generated kernel execution path. TODO: Needs to be
@@ -149,6 +311,11 @@ protected:
 extern "C" {
 void altLaunchKernel(const char *kernelName, void (*kernel)(void *), void *args,
                      std::uint64_t argsSize, std::uint64_t resultOffset);
+
+/// Return true if the next altLaunchKernel() of the calling thread may receive
+/// the data of vector arguments by reference, see
+/// quantum_platform::can_reference_arguments().
+bool altArgumentsByReference();
 }
 
 } // namespace cudaq
@@ -8,12 +8,15 @@
 
 #pragma once
 
+#include "common/QuditIdTracker.h"
+#include "common/StatePreparation.h"
 #include "cudaq/spin_op.h"
+#include <array>
 #include <cassert>
 #include <complex>
 #include <cstddef>
-#include <deque>
 #include <span>
+#include <stdexcept>
 #include <string_view>
 #include <vector>
 
@@ -21,6 +24,13 @@ namespace cudaq {
 class ExecutionContext;
 using SpinMeasureResult = std::pair<double, sample_result>;
 
+/// @brief The Suzuki product formula exp() applies, of order 1 or of even
+/// order, with the evolution split into `steps` equal steps.
+struct trotter_options {
+  std::size_t order = 1;
+  std::size_t steps = 1;
+};
+
 /// The ExecutionManager provides a base class describing a
 /// concrete sub-system for allocating qudits and executing quantum
 /// instructions on those qudits. This type is templated on the concrete
@@ -29,39 +39,23 @@ using SpinMeasureResult = std::pair<double, sample_result>;
 /// current execution context, and applying specific quantum instructions.
 class ExecutionManager {
 protected:
-  /// Available qudit indices
-  std::deque<std::size_t> availableIndices;
-
-  /// Total qudits available
-  std::size_t totalQudits;
+  /// Tracker of the qudit indices in use
+  QuditIdTracker tracker;
 
   /// Internal - return the next qudit index
-  std::size_t getNextIndex() {
-    assert(!availableIndices.empty() && "No more qubits available.");
-    auto next = availableIndices.front();
-    availableIndices.pop_front();
-    return next;
-  }
+  std::size_t getNextIndex() { return tracker.getNextIndex(); }
 
   /// Internal - At qudit deallocation, return the qudit index
-  void returnIndex(std::size_t idx) {
-    availableIndices.push_front(idx);
-    std::sort(availableIndices.begin(), availableIndices.end());
-  }
+  void returnIndex(std::size_t idx) { tracker.returnIndex(idx); }
 
   /// Internal - Get the number of remaining available qudit ids
-  std::size_t numAvailable() { return availableIndices.size(); }
+  std::size_t numAvailable() { return tracker.numAvailable(); }
 
   /// Internal - Get the total number of qudit ids available
-  std::size_t totalNumQudits() { return totalQudits; }
+  std::size_t totalNumQudits() { return tracker.totalNumQudits(); }
 
 public:
-  ExecutionManager() {
-    totalQudits = 30; // platform.get_num_qubits();
-    for (std::size_t i = 0; i < totalQudits; i++) {
-      availableIndices.push_back(i);
-    }
-  }
+  ExecutionManager() = default;
   /// Return the next available qudit index
   virtual std::size_t getAvailableIndex() { return getNextIndex(); }
 
@@ -85,15 +79,68 @@ public:
                      std::span<std::size_t> targets,
                      bool isAdjoint = false) = 0;
 
-  /// Apply exp( -i theta op), first order trotterization
+  /// Apply exp( -i theta op), trotterized with the given product formula
   // For the spin_op representation, this takes the BinarySymplectic Data
   // and the term coefficients. Subtypes can reconstruct the spin op
   // with that data.
   virtual void exp(std::vector<std::size_t> &&q, double theta,
-                   cudaq::spin_op &op) = 0;
+                   cudaq::spin_op &op, const trotter_options &options) = 0;
   //  std::vector<std::vector<bool>> &data,
   //  std::vector<std::complex<double>> &coefficients) = 0;
 
+  /// Move the state of `targets[i]` to `targets[permutation[i]]`, for every
+  /// i. Managers whose backend permutes qubits at once override this, the
+  /// default applies the permutation as swaps.
+  virtual void permuteQubits(const std::vector<std::size_t> &targets,
+                             const std::vector<std::size_t> &permutation) {
+    const std::size_t n = targets.size();
+    // The qudit due at each position, the position of each qudit and the
+    // qudit at each position.
+    std::vector<std::size_t> due(n, n), where(n), at(n);
+    for (std::size_t i = 0; i < n; i++) {
+      if (permutation.size() != n || permutation[i] >= n ||
+          due[permutation[i]] != n)
+        throw std::runtime_error("Invalid qubit permutation.");
+      due[permutation[i]] = i;
+      where[i] = at[i] = i;
+    }
+    // Swap the due qudit into each position in turn.
+    for (std::size_t p = 0; p < n; p++) {
+      const auto q = due[p];
+      if (at[p] == q)
+        continue;
+      const auto from = where[q];
+      std::array<std::size_t, 2> pair{targets[p], targets[from]};
+      apply("swap", {}, {}, pair);
+      at[from] = at[p];
+      where[at[from]] = from;
+      at[p] = q;
+      where[q] = p;
+    }
+  }
+
+  /// Put the `targets`, fresh qudits in |0>, in the state with the 2^n
+  /// normalized `amplitudes`, bit j of the amplitude index being the value of
+  /// `targets[j]`. Managers whose backend writes states directly override
+  /// this, the default applies a synthesized state preparation circuit.
+  virtual void
+  initializeState(const std::vector<std::size_t> &targets,
+                  std::span<const std::complex<double>> amplitudes) {
+    synthesizeStatePreparation(
+        targets.size(), amplitudes.data(),
+        [&](std::string_view name, double angle,
+            const std::vector<std::size_t> &positions, std::size_t target) {
+          std::vector<std::size_t> controls;
+          for (auto p : positions)
+            controls.push_back(targets[p]);
+          std::array<std::size_t, 1> t{targets[target]};
+          if (name == "x")
+            apply(name, {}, controls, t);
+          else
+            apply(name, {angle}, controls, t);
+        });
+  }
+
   virtual void resetQubit(const std::size_t &id) = 0;
 
   /// Begin an region of code where all operations will be adjoint-ed
@@ -107,10 +154,28 @@ public:
   /// End the control region
   virtual void endCtrlRegion(const std::size_t n_controls) = 0;
 
+  /// Start a region of code whose operations are not controlled by the
+  /// enclosing control regions, e.g. the compute part of a compute-action.
+  virtual void startUncontrolledRegion() = 0;
+  /// End the uncontrolled region, restoring the enclosing control regions.
+  virtual void endUncontrolledRegion() = 0;
+
   /// Measure the qudit and return the observed state (0,1,2,3,...)
   /// e.g. for qubits, this can return 0 or 1;
   virtual int measure(const std::size_t &target) = 0;
 
+  /// Measure the qudits of a register and return their observed states, in
+  /// order. Managers whose backend measures several qudits at once override
+  /// this, the default measures them one after the other.
+  virtual std::vector<int>
+  measureRegister(const std::vector<std::size_t> &targets) {
+    std::vector<int> results;
+    results.reserve(targets.size());
+    for (auto &target : targets)
+      results.push_back(measure(target));
+    return results;
+  }
+
   /// Measure the current state in the given pauli basis, return
   /// the expectation value <term>.
   virtual SpinMeasureResult measure(cudaq::spin_op &op) = 0;
@@ -13,13 +13,16 @@
 #include "cudaq/qis/qudit.h"
 #include "cudaq/spin_op.h"
 #include "cudaq/utils/cudaq_utils.h"
+#include <algorithm>
+#include <array>
 #include <complex>
+#include <cstdint>
 #include <cstring>
-#include <functional>
 #include <map>
-#include <queue>
+#include <memory>
+#include <optional>
 #include <sstream>
-#include <stack>
+#include <string_view>
 
 // Define some stubs for the QIR opaque types
 class Array;
@@ -34,7 +37,9 @@ void __quantum__rt__array_release(Array *);
 int8_t *__quantum__rt__array_get_element_ptr_1d(Array *q, uint64_t);
 int64_t __quantum__rt__array_get_size_1d(Array *);
 Array *__quantum__rt__array_create_1d(int, int64_t);
-void __quantum__qis__exp__body(Array *paulis, double angle, Array *qubits);
+void __quantum__qis__exp__suzuki__body(Array *paulis, double angle,
+                                       Array *qubits, int64_t order,
+                                       int64_t steps);
 void __quantum__qis__measure__body(Array *, Array *);
 Qubit *__quantum__rt__qubit_allocate();
 void __quantum__rt__qubit_release(Qubit *);
@@ -81,19 +86,168 @@ void __quantum__qis__swap(Qubit *, Qubit *);
 void __quantum__qis__cphase(double x, Qubit *src, Qubit *tgt);
 
 Result *__quantum__qis__mz(Qubit *);
+void __nvqir__mzQubits(Qubit **qubits, std::size_t count, bool *results);
+void __nvqir__permuteQubits(Qubit **qubits, const std::size_t *permutation,
+                            std::size_t count);
+void __nvqir__initializeState(Qubit **qubits, std::size_t count,
+                              const std::complex<double> *amplitudes);
 }
 
 namespace {
 Array *spinToArray(cudaq::spin_op &);
 
+/// A vector that stores up to N elements inline and only allocates beyond
+/// that.
+template <typename T, std::size_t N>
+class SmallVector {
+  std::array<T, N> inlineData;
+  std::vector<T> heapData;
+  std::size_t count = 0;
+
+public:
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  const T *data() const {
+    return count > N ? heapData.data() : inlineData.data();
+  }
+  T *data() { return count > N ? heapData.data() : inlineData.data(); }
+  const T *begin() const { return data(); }
+  const T *end() const { return data() + count; }
+  T *begin() { return data(); }
+  T *end() { return data() + count; }
+  const T &operator[](std::size_t i) const { return data()[i]; }
+  T &operator[](std::size_t i) { return data()[i]; }
+
+  void clear() {
+    heapData.clear();
+    count = 0;
+  }
+
+  void push_back(const T &element) {
+    if (count < N) {
+      inlineData[count++] = element;
+      return;
+    }
+    if (count == N)
+      heapData.assign(inlineData.begin(), inlineData.end());
+    heapData.push_back(element);
+    count++;
+  }
+};
+
+/// The quantum instructions known to the QIRQubitQISManager.
+enum class GateKind : std::uint8_t {
+  h,
+  x,
+  y,
+  z,
+  t,
+  s,
+  tdg,
+  sdg,
+  rx,
+  ry,
+  rz,
+  r1,
+  swap,
+  cphase
+};
+
+/// Return the GateKind with the given name, if there is one.
+std::optional<GateKind> getGateKind(std::string_view name) {
+  static constexpr std::string_view names[] = {
+      "h",   "x",  "y",  "z",  "t",  "s",    "tdg",
+      "sdg", "rx", "ry", "rz", "r1", "swap", "cphase"};
+  for (std::size_t i = 0; i < std::size(names); i++)
+    if (names[i] == name)
+      return static_cast<GateKind>(i);
+  return std::nullopt;
+}
+
+/// The adjoint of each GateKind, by GateKind value. The adjoint of a
+/// rotation additionally negates its angle.
+constexpr GateKind adjointGates[] = {
+    GateKind::h,   GateKind::x,   GateKind::y, GateKind::z,
+    GateKind::tdg, GateKind::sdg, GateKind::t, GateKind::s,
+    GateKind::rx,  GateKind::ry,  GateKind::rz, GateKind::r1,
+    GateKind::swap, GateKind::cphase};
+static_assert(std::size(adjointGates) ==
+              static_cast<std::size_t>(GateKind::cphase) + 1);
+static_assert(adjointGates[static_cast<std::size_t>(GateKind::t)] ==
+              GateKind::tdg);
+static_assert(adjointGates[static_cast<std::size_t>(GateKind::sdg)] ==
+              GateKind::s);
+
+/// Return the adjoint of the gate.
+constexpr GateKind getAdjointGate(GateKind gate) {
+  return adjointGates[static_cast<std::size_t>(gate)];
+}
+
+/// A quantum instruction queued by QIRQubitQISManager::apply(). Parameters
+/// and qubits are stored inline for all but the widest gates.
+struct Instruction {
+  GateKind gate;
+  SmallVector<double, 3> params;
+  SmallVector<std::size_t, 4> controls;
+  SmallVector<std::size_t, 2> targets;
+};
+
+/// A FIFO queue of instructions in a ring buffer. Records are reused, so
+/// once the buffer has grown to the depth of the queue, queueing an
+/// instruction does not allocate.
+class InstructionQueue {
+  std::vector<Instruction> records;
+  std::size_t head = 0;
+  std::size_t count = 0;
+
+public:
+  bool empty() const { return count == 0; }
+  std::size_t size() const { return count; }
+
+  /// Return the i-th instruction from the front of the queue.
+  Instruction &operator[](std::size_t i) {
+    return records[(head + i) % records.size()];
+  }
+  Instruction &front() { return records[head]; }
+
+  /// Append a cleared instruction to the queue and return it.
+  Instruction &emplace_back() {
+    if (count == records.size()) {
+      // Unwrap the queue before growing the buffer.
+      std::rotate(records.begin(), records.begin() + head, records.end());
+      head = 0;
+      records.resize(std::max<std::size_t>(16, 2 * records.size()));
+    }
+    auto &instruction = records[(head + count++) % records.size()];
+    instruction.params.clear();
+    instruction.controls.clear();
+    instruction.targets.clear();
+    return instruction;
+  }
+
+  /// Reverse the order of the instructions from the i-th one to the back of
+  /// the queue.
+  void reverseFrom(std::size_t i) {
+    for (std::size_t j = count; i + 1 < j; i++, j--)
+      std::swap((*this)[i], (*this)[j - 1]);
+  }
+
+  void pop_front() {
+    head = (head + 1) % records.size();
+    count--;
+  }
+
+  void clear() {
+    head = 0;
+    count = 0;
+  }
+};
+
 /// The QIRQubitQISManager will implement allocation, deallocation, and
 /// quantum instruction application via calls to the extern declared QIR
 /// runtime library functions.
 class QIRQubitQISManager : public cudaq::ExecutionManager {
 private:
-  using Instruction = std::tuple<std::string, std::vector<double>, Array *,
-                                 std::vector<std::size_t>>;
-  using InstructionQueue = std::queue<Instruction>;
   cudaq::ExecutionContext *ctx;
   std::vector<std::size_t> contextQubitIdsForDeletion;
 
@@ -101,83 +255,78 @@ private:
   std::map<std::size_t, Qubit *> qubits;
 
   InstructionQueue instructionQueue;
-  std::stack<InstructionQueue> adjointQueueStack;
-
-  /// The QIR function application map. Each element of
-  /// this map exposes a functor that takes a parameter vector, control
-  /// qubits as an Array*, and the target QIR Qubits.
-  std::map<std::string_view, std::function<void(std::vector<double>, Array *,
-                                                std::vector<Qubit *> &)>>
-      qir_qis_q_funcs{
-          {"h",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__h__ctl(a, q[0])
-                          : __quantum__qis__h(q[0]);
-           }},
-          {"x",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__x__ctl(a, q[0])
-                          : __quantum__qis__x(q[0]);
-           }},
-          {"y",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__y__ctl(a, q[0])
-                          : __quantum__qis__y(q[0]);
-           }},
-          {"z",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__z__ctl(a, q[0])
-                          : __quantum__qis__z(q[0]);
-           }},
-
-          {"t",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__t__ctl(a, q[0])
-                          : __quantum__qis__t(q[0]);
-           }},
-          {"s",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__s__ctl(a, q[0])
-                          : __quantum__qis__s(q[0]);
-           }},
-          {"tdg",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__tdg__ctl(a, q[0])
-                          : __quantum__qis__tdg(q[0]);
-           }},
-          {"sdg",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__sdg__ctl(a, q[0])
-                          : __quantum__qis__sdg(q[0]);
-           }},
-          {"rx",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__rx__ctl(d[0], a, q[0])
-                          : __quantum__qis__rx(d[0], q[0]);
-           }},
-          {"ry",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__ry__ctl(d[0], a, q[0])
-                          : __quantum__qis__ry(d[0], q[0]);
-           }},
-          {"rz",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__rz__ctl(d[0], a, q[0])
-                          : __quantum__qis__rz(d[0], q[0]);
-           }},
-          {"r1",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             a != nullptr ? __quantum__qis__r1__ctl(d[0], a, q[0])
-                          : __quantum__qis__r1(d[0], q[0]);
-           }},
-          {"swap",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             __quantum__qis__swap(q[0], q[1]);
-           }},
-          {"cphase",
-           [](std::vector<double> d, Array *a, std::vector<Qubit *> &q) {
-             __quantum__qis__cphase(d[0], q[0], q[1]);
-           }}};
+
+  /// The position in the instruction queue of the first instruction of each
+  /// open adjoint region, outermost first. The instructions of a region are
+  /// queued in place and reversed when the region ends, they are not applied
+  /// before the outermost region ends.
+  std::vector<std::size_t> adjointRegionStarts;
+
+  /// The QIR Arrays handed to the controlled QIR functions, one per number
+  /// of controls. They are reused for every gate with that many controls.
+  std::vector<Array *> controlArrays;
+
+  /// Return a QIR Array of the Qubit pointers of the controls, or nullptr
+  /// if there are none. The Array is only valid until the next call.
+  Array *controlsToArray(const SmallVector<std::size_t, 4> &ctrls) {
+    if (ctrls.empty())
+      return nullptr;
+
+    if (controlArrays.size() < ctrls.size())
+      controlArrays.resize(ctrls.size(), nullptr);
+    auto *&a = controlArrays[ctrls.size() - 1];
+    if (!a)
+      a = __quantum__rt__array_create_1d(sizeof(Qubit *), ctrls.size());
+
+    // For each qubit in the tuple, add it to the Array
+    for (std::size_t i = 0; i < ctrls.size(); i++) {
+      Qubit **qq = reinterpret_cast<Qubit **>(
+          __quantum__rt__array_get_element_ptr_1d(a, i));
+      *qq = qubits[ctrls[i]];
+    }
+    return a;
+  }
+
+  /// Run the QIR QIS function of the instruction.
+  void applyInstruction(const Instruction &instruction) {
+    const auto &d = instruction.params;
+    Array *a = controlsToArray(instruction.controls);
+    Qubit *q0 = qubits[instruction.targets[0]];
+    switch (instruction.gate) {
+    case GateKind::h:
+      return a ? __quantum__qis__h__ctl(a, q0) : __quantum__qis__h(q0);
+    case GateKind::x:
+      return a ? __quantum__qis__x__ctl(a, q0) : __quantum__qis__x(q0);
+    case GateKind::y:
+      return a ? __quantum__qis__y__ctl(a, q0) : __quantum__qis__y(q0);
+    case GateKind::z:
+      return a ? __quantum__qis__z__ctl(a, q0) : __quantum__qis__z(q0);
+    case GateKind::t:
+      return a ? __quantum__qis__t__ctl(a, q0) : __quantum__qis__t(q0);
+    case GateKind::s:
+      return a ? __quantum__qis__s__ctl(a, q0) : __quantum__qis__s(q0);
+    case GateKind::tdg:
+      return a ? __quantum__qis__tdg__ctl(a, q0) : __quantum__qis__tdg(q0);
+    case GateKind::sdg:
+      return a ? __quantum__qis__sdg__ctl(a, q0) : __quantum__qis__sdg(q0);
+    case GateKind::rx:
+      return a ? __quantum__qis__rx__ctl(d[0], a, q0)
+               : __quantum__qis__rx(d[0], q0);
+    case GateKind::ry:
+      return a ? __quantum__qis__ry__ctl(d[0], a, q0)
+               : __quantum__qis__ry(d[0], q0);
+    case GateKind::rz:
+      return a ? __quantum__qis__rz__ctl(d[0], a, q0)
+               : __quantum__qis__rz(d[0], q0);
+    case GateKind::r1:
+      return a ? __quantum__qis__r1__ctl(d[0], a, q0)
+               : __quantum__qis__r1(d[0], q0);
+    case GateKind::swap:
+      return __quantum__qis__swap(q0, qubits[instruction.targets[1]]);
+    case GateKind::cphase:
+      return __quantum__qis__cphase(d[0], q0, qubits[instruction.targets[1]]);
+    }
+  }
 
   /// Utility to convert a vector of qubits into an opaque Array pointer
   Array *vectorToArray(const std::vector<std::size_t> &ctrls) {
@@ -218,9 +367,7 @@ public:
     ctx = _ctx;
     __quantum__rt__setExecutionContext(_ctx);
     // If we set a new exec context, make sure we clear any old instructions.
-    while (!instructionQueue.empty()) {
-      instructionQueue.pop();
-    }
+    instructionQueue.clear();
   }
 
   void resetExecutionContext() override {
@@ -255,6 +402,8 @@ public:
   /// Overriding returnQubit in order to release the Qubit *
   void returnQubit(const std::size_t &qid) override {
     if (!ctx) {
+      // Apply the queued instructions while the qubit still exists.
+      synchronize();
       __quantum__rt__qubit_release(qubits[qid]);
       qubits.erase(qid);
       returnIndex(qid);
@@ -277,44 +426,20 @@ public:
     qubits.erase(qid);
     returnIndex(qid);
     if (numAvailable() == totalNumQudits()) {
-      if (ctx && ctx_name == "observe") {
-        while (!instructionQueue.empty())
-          instructionQueue.pop();
-      }
+      if (ctx && ctx_name == "observe")
+        instructionQueue.clear();
     }
   }
 
   std::vector<std::size_t> extra_control_qubit_ids;
   bool inAdjointRegion = false;
-  void startAdjointRegion() override { adjointQueueStack.emplace(); }
+  void startAdjointRegion() override {
+    adjointRegionStarts.push_back(instructionQueue.size());
+  }
 
   void endAdjointRegion() override {
-    // Get the top queue and remove it
-    auto adjointQueue = adjointQueueStack.top();
-    adjointQueueStack.pop();
-
-    // Reverse it
-    [](InstructionQueue &q) {
-      std::stack<Instruction> s;
-      while (!q.empty()) {
-        s.push(q.front());
-        q.pop();
-      }
-      while (!s.empty()) {
-        q.push(s.top());
-        s.pop();
-      }
-    }(adjointQueue);
-
-    while (!adjointQueue.empty()) {
-      auto front = adjointQueue.front();
-      adjointQueue.pop();
-      if (adjointQueueStack.empty()) {
-        instructionQueue.push(front);
-      } else {
-        adjointQueueStack.top().push(front);
-      }
-    }
+    instructionQueue.reverseFrom(adjointRegionStarts.back());
+    adjointRegionStarts.pop_back();
   }
 
   void startCtrlRegion(std::vector<std::size_t> &control_qubits) override {
@@ -328,8 +453,22 @@ public:
     extra_control_qubit_ids.resize(extra_control_qubit_ids.size() - n_controls);
   }
 
-  /// The goal for apply is to create a new element of the
-  /// instruction queue (a tuple).
+  /// The controls of the enclosing control regions, for each open
+  /// uncontrolled region.
+  std::vector<std::vector<std::size_t>> suspended_control_qubit_ids;
+
+  void startUncontrolledRegion() override {
+    suspended_control_qubit_ids.push_back(std::move(extra_control_qubit_ids));
+    extra_control_qubit_ids.clear();
+  }
+
+  void endUncontrolledRegion() override {
+    extra_control_qubit_ids = std::move(suspended_control_qubit_ids.back());
+    suspended_control_qubit_ids.pop_back();
+  }
+
+  /// The goal for apply is to append a new instruction to the
+  /// instruction queue.
   void apply(const std::string_view gateName,
              const std::vector<double> &&params,
              std::span<std::size_t> controls, std::span<std::size_t> targets,
@@ -337,77 +476,41 @@ public:
     cudaq::ScopedTrace trace("QIRExecManager::apply", gateName, params,
                              controls, targets, isAdjoint);
 
-    // Make a copy of the name that we can mutate if necessary
-    std::string mutable_name(gateName);
-
-    // Make a copy of the params that we can mutate
-    std::vector<double> mutable_params = params;
-
-    // Create an array of controls, we will
-    // prepend any extra controls if in a control region
-    std::vector<std::size_t> mutable_controls;
-    for (auto &e : extra_control_qubit_ids) {
-      mutable_controls.push_back(e);
-    }
-    for (auto &e : controls) {
-      mutable_controls.push_back(e);
-    }
-
-    std::vector<std::size_t> mutable_targets;
-    for (auto &t : targets) {
-      mutable_targets.push_back(t);
-    }
-
-    // Get the ctrls Array* , could be nullptr
-    auto ctrls_a = vectorToArray(mutable_controls);
-
-    if (!qir_qis_q_funcs.count(mutable_name)) {
+    auto gate = getGateKind(gateName);
+    if (!gate) {
       std::stringstream ss;
-      ss << mutable_name << " is an invalid quantum instruction.";
+      ss << gateName << " is an invalid quantum instruction.";
       throw std::invalid_argument(ss.str());
     }
 
-    if (isAdjoint || !adjointQueueStack.empty()) {
-      for (std::size_t i = 0; i < params.size(); i++) {
-        mutable_params[i] = -1.0 * params[i];
-      }
-      if (mutable_name == "t") {
-        mutable_name = "tdg";
-      } else if (mutable_name == "s") {
-        mutable_name = "sdg";
-      }
-    }
-    if (!adjointQueueStack.empty()) {
-      // Add to the adjoint instruction queue
-      adjointQueueStack.top().emplace(std::make_tuple(
-          mutable_name, mutable_params, ctrls_a, mutable_targets));
-    } else {
-      // Add to the instruction queue
-      instructionQueue.emplace(std::make_tuple(
-          std::move(mutable_name), mutable_params, ctrls_a, mutable_targets));
-    }
+    // The gate is inverted an odd number of times by its adjoint modifier
+    // and the enclosing adjoint regions.
+    const bool adjoint = isAdjoint != (adjointRegionStarts.size() % 2 == 1);
+
+    auto &instruction = instructionQueue.emplace_back();
+    instruction.gate = adjoint ? getAdjointGate(*gate) : *gate;
+    for (auto p : params)
+      instruction.params.push_back(adjoint ? -p : p);
+    // Prepend any extra controls if in a control region
+    for (auto c : extra_control_qubit_ids)
+      instruction.controls.push_back(c);
+    for (auto c : controls)
+      instruction.controls.push_back(c);
+    for (auto t : targets)
+      instruction.targets.push_back(t);
   }
 
   void synchronize() override {
-    while (!instructionQueue.empty()) {
-      auto instruction = instructionQueue.front();
-
-      // Get the data, create the Qubit* targets
-      auto [gateName, p, c, q] = instruction;
-
-      std::vector<Qubit *> qqs;
-      std::transform(
-          q.begin(), q.end(), std::back_inserter(qqs),
-          [&, qqs](const std::size_t &q) mutable { return qubits[q]; });
-
-      // Run the QIR QIS function
-      qir_qis_q_funcs[gateName](p, c, qqs);
-      if (c != nullptr) {
-        auto s = __quantum__rt__array_get_size_1d(c);
-        clearArray(c, s);
-      }
-      instructionQueue.pop();
+    // Instructions of open adjoint regions are still to be reversed.
+    std::size_t n = instructionQueue.size();
+    if (!adjointRegionStarts.empty())
+      n = std::min(n, adjointRegionStarts.front());
+    for (std::size_t i = 0; i < n; i++) {
+      applyInstruction(instructionQueue.front());
+      instructionQueue.pop_front();
     }
+    for (auto &start : adjointRegionStarts)
+      start -= n;
   }
 
   int measure(const std::size_t &target) override {
@@ -420,6 +523,51 @@ public:
     return res ? 1 : 0;
   }
 
+  std::vector<int>
+  measureRegister(const std::vector<std::size_t> &targets) override {
+    synchronize();
+    std::vector<Qubit *> measured;
+    measured.reserve(targets.size());
+    for (auto target : targets)
+      measured.push_back(qubits[target]);
+    auto bits = std::make_unique<bool[]>(targets.size());
+    __nvqir__mzQubits(measured.data(), measured.size(), bits.get());
+    return std::vector<int>(bits.get(), bits.get() + targets.size());
+  }
+
+  void permuteQubits(const std::vector<std::size_t> &targets,
+                     const std::vector<std::size_t> &permutation) override {
+    // Inside adjoint or control regions, the swaps are queued like any other
+    // gate and inverted or controlled with them.
+    if (!adjointRegionStarts.empty() || !extra_control_qubit_ids.empty())
+      return ExecutionManager::permuteQubits(targets, permutation);
+    if (permutation.size() != targets.size())
+      throw std::runtime_error("Qubit permutation of the wrong size.");
+    synchronize();
+    std::vector<Qubit *> permuted;
+    permuted.reserve(targets.size());
+    for (auto target : targets)
+      permuted.push_back(qubits[target]);
+    __nvqir__permuteQubits(permuted.data(), permutation.data(),
+                           permuted.size());
+  }
+
+  void initializeState(
+      const std::vector<std::size_t> &targets,
+      std::span<const std::complex<double>> amplitudes) override {
+    // Inside adjoint or control regions, the preparation circuit is queued
+    // like any other gates and inverted or controlled with them.
+    if (!adjointRegionStarts.empty() || !extra_control_qubit_ids.empty())
+      return ExecutionManager::initializeState(targets, amplitudes);
+    synchronize();
+    std::vector<Qubit *> initialized;
+    initialized.reserve(targets.size());
+    for (auto target : targets)
+      initialized.push_back(qubits[target]);
+    __nvqir__initializeState(initialized.data(), initialized.size(),
+                             amplitudes.data());
+  }
+
   cudaq::SpinMeasureResult measure(cudaq::spin_op &op) override {
     synchronize();
     // FIXME need to remove QIR things from spin_op
@@ -427,20 +575,20 @@ public:
     __quantum__qis__measure__body(term_arr, nullptr);
     // auto counts_raw = ctx->extract_results();
     auto exp = ctx->expectationValue;
-    auto data = ctx->result;
-    return std::make_pair(exp.value(), data);
+    return std::make_pair(exp.value(), std::move(ctx->result));
   }
 
   void resetQubit(const std::size_t &id) override {
     __quantum__qis__reset(qubits[id]);
   }
 
-  void exp(std::vector<std::size_t> &&q, double theta,
-           cudaq::spin_op &op) override {
+  void exp(std::vector<std::size_t> &&q, double theta, cudaq::spin_op &op,
+           const cudaq::trotter_options &options) override {
     synchronize();
     Array *term = spinToArray(op);
     auto qubits = vectorToArray(q);
-    __quantum__qis__exp__body(term, theta, qubits);
+    __quantum__qis__exp__suzuki__body(term, theta, qubits, options.order,
+                                      options.steps);
     clearArray(qubits, q.size());
   }
 };
@@ -453,42 +601,29 @@ Array *spinToArray(cudaq::spin_op &op) {
   // End the data array with the number of terms in the list
   // x0 y1 - y0 x1 would be
   // 1 3 coeff.real coeff.imag 3 1 coeff.real coeff.imag NTERMS
-  auto n_qubits = op.n_qubits(); // data[0].size() / 2.;
-  auto n_terms = op.n_terms();   // data.size();
-  auto data = op.get_bsf();
+  auto n_qubits = op.n_qubits();
+  auto n_terms = op.n_terms();
 
   auto arr = __quantum__rt__array_create_1d(
       sizeof(double), n_qubits * n_terms + 2 * n_terms + 1);
 
-  for (std::size_t i = 0; i < n_terms; i++) {
-    auto term_data = data[i];
-    std::size_t row_size = n_qubits + 2;
-    for (std::size_t j = 0; j < row_size; j++) {
-      int8_t *ptr =
-          __quantum__rt__array_get_element_ptr_1d(arr, i * row_size + j);
-      auto ptr_el = reinterpret_cast<double *>(ptr);
-      if (j == n_qubits) {
-        *ptr_el = op.get_term_coefficient(i).real();
-        continue;
-      }
-      if (j == n_qubits + 1) {
-        *ptr_el = op.get_term_coefficient(i).imag();
-        break;
-      }
-
-      if (term_data[j] && term_data[j + n_qubits]) {
-        // Y term
-        *ptr_el = 3.0;
-      } else if (term_data[j]) {
-        // X term
-        *ptr_el = 1.0;
-      } else if (term_data[j + n_qubits]) {
-        // Z term
-        *ptr_el = 2.0;
-      } else {
-        *ptr_el = 0.0;
-      }
+  // Read the packed terms in place rather than expanding the BSF.
+  const std::size_t row_size = n_qubits + 2;
+  for (std::size_t i = 0; auto term : op.terms()) {
+    auto element = [&](std::size_t j) {
+      return reinterpret_cast<double *>(
+          __quantum__rt__array_get_element_ptr_1d(arr, i * row_size + j));
+    };
+    for (std::size_t j = 0; j < n_qubits; j++) {
+      auto p = term.get_pauli(j);
+      *element(j) = p == cudaq::pauli::Y   ? 3.0
+                    : p == cudaq::pauli::X ? 1.0
+                    : p == cudaq::pauli::Z ? 2.0
+                                           : 0.0;
     }
+    *element(n_qubits) = term.get_coefficient().real();
+    *element(n_qubits + 1) = term.get_coefficient().imag();
+    i++;
   }
 
   int8_t *ptr = __quantum__rt__array_get_element_ptr_1d(
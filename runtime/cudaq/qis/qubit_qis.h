@@ -282,6 +282,36 @@ void swap(QuantumRegister &ctrls, qubit &src, qubit &target) {
   getExecutionManager()->apply("swap", {}, c_span, t_span);
 }
 
+/// @brief Permute the qubits of the register, moving the state of `q[i]` to
+/// `q[permutation[i]]`. The permutation is applied at once where the backend
+/// supports it, e.g. to reorder qubits after routing, and as swaps otherwise.
+template <typename QuantumRegister>
+  requires(std::ranges::range<QuantumRegister>)
+void permute_qubits(QuantumRegister &q,
+                    const std::vector<std::size_t> &permutation) {
+  std::vector<std::size_t> targets;
+  for (auto &qq : q)
+    targets.push_back(qq.id());
+  getExecutionManager()->permuteQubits(targets, permutation);
+}
+
+/// @brief Put the qubits of the register, fresh qubits in |0>, in the state
+/// with the given 2^n normalized amplitudes, bit j of the amplitude index
+/// being the value of `q[j]`. Simulators write the amplitudes directly where
+/// they can, e.g. to load a known state for amplitude encoding, instead of
+/// applying a state preparation circuit of O(2^n) gates. Other backends
+/// apply that circuit.
+template <typename QuantumRegister>
+  requires(std::ranges::range<QuantumRegister>)
+void initialize_state(QuantumRegister &q,
+                      std::span<const std::complex<double>> amplitudes) {
+  std::vector<std::size_t> targets;
+  for (auto &qq : q)
+    targets.push_back(qq.id());
+  checkStateAmplitudes(targets.size(), amplitudes.data(), amplitudes.size());
+  getExecutionManager()->initializeState(targets, amplitudes);
+}
+
 // Define common 2 qubit operations.
 inline void cnot(qubit &q, qubit &r) { x<cudaq::ctrl>(q, r); }
 inline void cx(qubit &q, qubit &r) { x<cudaq::ctrl>(q, r); }
@@ -299,15 +329,17 @@ inline void cphase(ScalarAngle angle, qubit &q, qubit &r) {
   getExecutionManager()->apply("cphase", {angle}, {}, t);
 }
 
-// Define the first order trotterization exp (i theta op)
+// Define the trotterization exp (i theta op), first order with a single step
+// unless other options are given
 template <typename ScalarAngle, typename QuantumRegister>
   requires(std::ranges::range<QuantumRegister>)
-void exp(QuantumRegister &qubits, ScalarAngle angle, cudaq::spin_op &&op) {
+void exp(QuantumRegister &qubits, ScalarAngle angle, cudaq::spin_op op,
+         const trotter_options &options = {}) {
   std::vector<std::size_t> qubitIds;
   for (auto &q : qubits)
     qubitIds.push_back(q.id());
 
-  getExecutionManager()->exp(std::move(qubitIds), angle, op);
+  getExecutionManager()->exp(std::move(qubitIds), angle, op, options);
 }
 
 // Measure an individual qubit, return 0,1 as bool
@@ -332,11 +364,11 @@ inline void reset(qubit &q) { getExecutionManager()->resetQubit(q.id()); }
 template <typename QubitRange>
   requires(std::ranges::range<QubitRange>)
 std::vector<bool> mz(QubitRange &q) {
-  std::vector<bool> b; //(q.size());
-  for (auto &qq : q) {
-    b.push_back(mz(qq));
-  }
-  return b;
+  std::vector<std::size_t> ids;
+  for (auto &qq : q)
+    ids.push_back(qq.id());
+  auto results = getExecutionManager()->measureRegister(ids);
+  return std::vector<bool>(results.begin(), results.end());
 }
 
 template <typename... Qs>
@@ -450,9 +482,15 @@ template <typename ComputeFunction, typename ActionFunction>
   requires isCallableVoidKernel<ComputeFunction> &&
            isCallableVoidKernel<ActionFunction>
 void compute_action(ComputeFunction &&c, ActionFunction &&a) {
+  // Under a control, only the action is controlled: C and C^dag cancel out
+  // when the controls do not hold.
+  getExecutionManager()->startUncontrolledRegion();
   c();
+  getExecutionManager()->endUncontrolledRegion();
   a();
+  getExecutionManager()->startUncontrolledRegion();
   adjoint(c);
+  getExecutionManager()->endUncontrolledRegion();
 }
 
 /// Instantiate this type to affect C^dag A C, where the user
@@ -462,9 +500,13 @@ template <typename ComputeFunction, typename ActionFunction>
   requires isCallableVoidKernel<ComputeFunction> &&
            isCallableVoidKernel<ActionFunction>
 void compute_dag_action(ComputeFunction &&c, ActionFunction &&a) {
+  getExecutionManager()->startUncontrolledRegion();
   adjoint(c);
+  getExecutionManager()->endUncontrolledRegion();
   a();
+  getExecutionManager()->startUncontrolledRegion();
   c();
+  getExecutionManager()->endUncontrolledRegion();
 }
 
 /// Helper function to extract a subvector of a std::vector<T> to be used within
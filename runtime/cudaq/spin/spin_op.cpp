@@ -10,16 +10,218 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cmath>
 #include <complex>
 #include <fstream>
 #include <map>
+#include <optional>
 #include <random>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace cudaq {
 
+namespace {
+/// @brief Return the number of words holding one bit per qubit.
+std::size_t numWords(const std::size_t nQubits) {
+  return std::max<std::size_t>((nQubits + 63) / 64, 1);
+}
+
+/// @brief Hash a packed term of `n` words.
+std::uint64_t hashTerm(const std::uint64_t *term, const std::size_t n) {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for (std::size_t i = 0; i < n; i++)
+    hash = (hash ^ term[i]) * 0x100000001b3ULL;
+  return hash;
+}
+
+/// @brief Index of the terms of a packed binary symplectic form, to find
+/// duplicate terms in O(1) rather than by scanning all terms. Used for the
+/// per thread products in spin_op::multiplyTerms().
+class TermIndex {
+  const std::vector<std::uint64_t> &data;
+  std::size_t termWords;
+  std::unordered_multimap<std::uint64_t, std::size_t> index;
+
+public:
+  TermIndex(const std::vector<std::uint64_t> &data, std::size_t termWords)
+      : data(data), termWords(termWords) {
+    const std::size_t nTerms = data.size() / termWords;
+    index.reserve(nTerms);
+    for (std::size_t t = 0; t < nTerms; t++)
+      insert(t);
+  }
+
+  /// @brief Return the index of the term equal to `term`, or -1.
+  std::size_t find(const std::uint64_t *term) const {
+    auto [begin, end] = index.equal_range(hashTerm(term, termWords));
+    for (auto it = begin; it != end; ++it)
+      if (std::equal(term, term + termWords,
+                     data.begin() + it->second * termWords))
+        return it->second;
+    return -1;
+  }
+
+  /// @brief Add the term at the given index of the data.
+  void insert(std::size_t termIdx) {
+    index.emplace(hashTerm(data.data() + termIdx * termWords, termWords),
+                  termIdx);
+  }
+};
+
+/// @brief Return the number of threads to split `n` items over, with at
+/// least `minPerThread` items per thread.
+std::size_t numThreads(std::size_t n, std::size_t minPerThread) {
+  return std::max<std::size_t>(
+      std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1u),
+                            n / minPerThread),
+      1);
+}
+
+/// @brief Call `functor(i, begin, end)` for the i-th of `nThreads` equal
+/// consecutive ranges of [0, n), each on its own thread.
+void forEachRange(
+    std::size_t n, std::size_t nThreads,
+    const std::function<void(std::size_t, std::size_t, std::size_t)>
+        &functor) {
+  auto rangeBegin = [&](std::size_t i) { return n * i / nThreads; };
+  std::vector<std::thread> threads;
+  for (std::size_t i = 1; i < nThreads; i++)
+    threads.emplace_back(
+        [&, i]() { functor(i, rangeBegin(i), rangeBegin(i + 1)); });
+  functor(0, 0, rangeBegin(1));
+  for (auto &thread : threads)
+    thread.join();
+}
+} // namespace
+
+std::vector<std::size_t>
+spin_op::multiplyTerms(const spin_op &lhs, const spin_op &rhs, bool commutator,
+                       std::vector<std::uint64_t> &product,
+                       std::vector<std::complex<double>> &productCoeffs) {
+  const std::size_t nw = lhs.m_n_words, termWords = 2 * nw;
+  const std::size_t nLhs = lhs.n_terms(), nRhs = rhs.n_terms();
+
+  // Products of the lhs terms [begin, end) with all rhs terms, summed into
+  // the given buffers. Returns the indices of the products that were summed
+  // with an equal one, i.e. that may have cancelled out.
+  auto multiplyRange = [&](std::size_t begin, std::size_t end,
+                           std::vector<std::uint64_t> &terms,
+                           std::vector<std::complex<double>> &coeffs) {
+    const std::complex<double> imaginary(0, 1);
+    const std::complex<double> phaseCoeffs[] = {1.0, -1. * imaginary, -1.0,
+                                                imaginary};
+    std::vector<std::size_t> merged;
+    TermIndex index(terms, termWords);
+    std::vector<std::uint64_t> tmp(termWords);
+    for (std::size_t t = begin; t < end; t++) {
+      const auto *row = lhs.termData(t);
+      for (std::size_t u = 0; u < nRhs; u++) {
+        const auto *other_row = rhs.termData(u);
+        // Two Pauli words anticommute if they anticommute on an odd number
+        // of qubits. Commuting words do not contribute to the commutator.
+        if (commutator) {
+          std::size_t overlap = 0;
+          for (std::size_t w = 0; w < nw; w++)
+            overlap += std::popcount(row[w] & other_row[w + nw]) +
+                       std::popcount(row[w + nw] & other_row[w]);
+          if (overlap % 2 == 0)
+            continue;
+        }
+
+        // This is term * otherTerm, the phase is i^-(nY(row) + nY(other_row)
+        // + 2 |X(row) & Z(other_row)| - nY(product)).
+        std::int64_t phase = 0;
+        for (std::size_t w = 0; w < nw; w++) {
+          const auto x = row[w], z = row[w + nw];
+          const auto otherX = other_row[w], otherZ = other_row[w + nw];
+          tmp[w] = x ^ otherX;
+          tmp[w + nw] = z ^ otherZ;
+          phase += std::popcount(x & z) + std::popcount(otherX & otherZ) +
+                   2 * std::popcount(x & otherZ) -
+                   std::popcount(tmp[w] & tmp[w + nw]);
+        }
+        // For anticommuting words, PQ - QP = 2 PQ.
+        auto coeff = phaseCoeffs[phase & 3] * lhs.coefficients[t] *
+                     rhs.coefficients[u] * (commutator ? 2.0 : 1.0);
+        auto idx = index.find(tmp.data());
+        if (idx != std::size_t(-1)) {
+          coeffs[idx] += coeff;
+          merged.push_back(idx);
+          continue;
+        }
+        terms.insert(terms.end(), tmp.begin(), tmp.end());
+        coeffs.push_back(coeff);
+        index.insert(coeffs.size() - 1);
+      }
+    }
+    return merged;
+  };
+
+  // Split large products by lhs terms over threads, each summing into its
+  // own buffers, and merge these in order, so that the terms are in the
+  // same order as for a serial product.
+  constexpr std::size_t minPairsPerThread = 1 << 14;
+  const std::size_t nThreads =
+      std::min<std::size_t>({std::max(std::thread::hardware_concurrency(), 1u),
+                             nLhs, nLhs * nRhs / minPairsPerThread});
+  if (nThreads <= 1) {
+    auto merged = multiplyRange(0, nLhs, product, productCoeffs);
+    std::sort(merged.begin(), merged.end());
+    return merged;
+  }
+
+  std::vector<std::vector<std::uint64_t>> threadTerms(nThreads);
+  std::vector<std::vector<std::complex<double>>> threadCoeffs(nThreads);
+  std::vector<std::vector<std::size_t>> threadMerged(nThreads);
+  std::vector<std::thread> threads;
+  auto rangeBegin = [&](std::size_t i) { return nLhs * i / nThreads; };
+  for (std::size_t i = 1; i < nThreads; i++)
+    threads.emplace_back([&, i]() {
+      threadMerged[i] = multiplyRange(rangeBegin(i), rangeBegin(i + 1),
+                                      threadTerms[i], threadCoeffs[i]);
+    });
+  auto merged =
+      multiplyRange(0, rangeBegin(1), threadTerms[0], threadCoeffs[0]);
+  for (auto &thread : threads)
+    thread.join();
+
+  product = std::move(threadTerms[0]);
+  productCoeffs = std::move(threadCoeffs[0]);
+  TermIndex index(product, termWords);
+  for (std::size_t i = 1; i < nThreads; i++) {
+    // A term summed within its thread may have cancelled out as well.
+    std::vector<bool> wasMerged(threadCoeffs[i].size());
+    for (auto t : threadMerged[i])
+      wasMerged[t] = true;
+    for (std::size_t t = 0; t < threadCoeffs[i].size(); t++) {
+      const auto *term = threadTerms[i].data() + t * termWords;
+      auto idx = index.find(term);
+      if (idx != std::size_t(-1)) {
+        productCoeffs[idx] += threadCoeffs[i][t];
+        merged.push_back(idx);
+        continue;
+      }
+      product.insert(product.end(), term, term + termWords);
+      productCoeffs.push_back(threadCoeffs[i][t]);
+      index.insert(productCoeffs.size() - 1);
+      if (wasMerged[t])
+        merged.push_back(productCoeffs.size() - 1);
+    }
+  }
+  std::sort(merged.begin(), merged.end());
+  return merged;
+}
+
 void spin_op::for_each_term(std::function<void(spin_op &)> &&functor) {
   for (std::size_t i = 0; i < n_terms(); i++) {
     auto term = operator[](i);
@@ -33,18 +235,13 @@ void spin_op::for_each_pauli(
         "spin_op::for_each_pauli on valid for spin_op with n_terms == 1.");
 
   auto nQ = n_qubits();
-  auto bsf = get_bsf()[0];
-  for (std::size_t i = 0; i < nQ; i++) {
-    if (bsf[i] && bsf[i + nQ]) {
-      functor(pauli::Y, i);
-    } else if (bsf[i]) {
-      functor(pauli::X, i);
-    } else if (bsf[i + nQ]) {
-      functor(pauli::Z, i);
-    } else {
-      functor(pauli::I, i);
-    }
-  }
+  for (std::size_t i = 0; i < nQ; i++)
+    functor(getPauli(0, i), i);
+}
+
+pauli spin_op::getPauli(const std::size_t termIdx,
+                        const std::size_t qubit) const {
+  return get_term(termIdx).get_pauli(qubit);
 }
 
 spin_op spin_op::random(std::size_t nQubits, std::size_t nTerms) {
@@ -63,90 +260,151 @@ spin_op spin_op::random(std::size_t nQubits, std::size_t nTerms) {
 }
 
 void spin_op::expandToNQubits(const std::size_t n_q) {
-  for (auto &row : data) {
-    std::vector<bool> tmp(n_q * 2);
-    for (std::size_t k = 0; k < m_n_qubits; k++)
-      if (row[k] && row[k + m_n_qubits]) {
-        tmp[k] = 1;
-        tmp[k + n_q] = 1;
-      } else if (row[k])
-        tmp[k] = row[k];
-      else if (row[k + m_n_qubits])
-        tmp[k + n_q] = true;
-    row = tmp;
-  }
   m_n_qubits = n_q;
+  const auto newWords = numWords(n_q);
+  if (newWords == m_n_words)
+    return;
+
+  // The bits stay in place within the X and the Z words of every term, the
+  // new words are zero.
+  std::vector<std::uint64_t> expanded(n_terms() * 2 * newWords);
+  for (std::size_t t = 0; t < n_terms(); t++) {
+    const auto *term = termData(t);
+    std::copy_n(term, m_n_words, expanded.begin() + 2 * newWords * t);
+    std::copy_n(term + m_n_words, m_n_words,
+                expanded.begin() + 2 * newWords * t + newWords);
+  }
+  data = std::move(expanded);
+  m_n_words = newWords;
+  // The hashes depend on the number of words.
+  termIndex.clear();
 }
 
 spin_op::spin_op() {
   coefficients.push_back(1.0);
-  // Should initialize with 2 elements for a 1 qubit Identity.
-  data.push_back(std::vector<bool>(2));
+  // Should initialize with 2 words for a 1 qubit Identity.
+  data.resize(2);
 }
 
 spin_op::spin_op(BinarySymplecticForm d,
                  std::vector<std::complex<double>> coeffs)
-    : data(d), coefficients(coeffs) {
-  m_n_qubits = data[0].size() / 2.;
+    : coefficients(coeffs) {
+  m_n_qubits = d[0].size() / 2.;
+  m_n_words = numWords(m_n_qubits);
+  data.resize(d.size() * 2 * m_n_words);
+  for (std::size_t t = 0; t < d.size(); t++) {
+    auto *term = termData(t);
+    for (std::size_t q = 0; q < m_n_qubits; q++) {
+      const std::uint64_t bit = 1ULL << (q % 64);
+      if (d[t][q])
+        term[q / 64] |= bit;
+      if (d[t][q + m_n_qubits])
+        term[m_n_words + q / 64] |= bit;
+    }
+  }
 }
 
 spin_op::spin_op(pauli type, const std::size_t idx,
                  std::complex<double> coeff) {
   m_n_qubits = idx + 1;
-  [[maybe_unused]] int p = 0;
-  data.push_back(std::vector<bool>(2 * m_n_qubits));
-  if (type == pauli::X) {
-    data.back()[idx] = true;
-  } else if (type == pauli::Y) {
-    p++;
-    data.back()[idx] = true;
-    data.back()[idx + m_n_qubits] = true;
-  } else if (type == pauli::Z) {
-    data.back()[idx + m_n_qubits] = true;
-  }
+  m_n_words = numWords(m_n_qubits);
+  data.resize(2 * m_n_words);
+  const std::uint64_t bit = 1ULL << (idx % 64);
+  if (type == pauli::X || type == pauli::Y)
+    data[idx / 64] |= bit;
+  if (type == pauli::Z || type == pauli::Y)
+    data[m_n_words + idx / 64] |= bit;
 
   coefficients.push_back(coeff);
 }
 
 spin_op::spin_op(const spin_op &o)
-    : data(o.data), coefficients(o.coefficients), m_n_qubits(o.m_n_qubits) {}
+    : data(o.data), m_n_words(o.m_n_words), termIndex(o.termIndex),
+      mayHoldZeroTerms(o.mayHoldZeroTerms), coefficients(o.coefficients),
+      m_n_qubits(o.m_n_qubits) {}
+
+void spin_op::removeZeroTerms(const std::vector<std::size_t> *candidates,
+                              double tolerance) {
+  const std::size_t termWords = 2 * m_n_words;
+  std::size_t next = 0, kept = 0;
+  for (std::size_t t = 0; t < n_terms(); t++) {
+    bool isCandidate = true;
+    if (candidates) {
+      while (next < candidates->size() && (*candidates)[next] < t)
+        next++;
+      isCandidate = next < candidates->size() && (*candidates)[next] == t;
+    }
+    if (isCandidate && std::abs(coefficients[t]) < tolerance)
+      continue;
+    if (kept != t) {
+      std::copy_n(termData(t), termWords, termData(kept));
+      coefficients[kept] = coefficients[t];
+    }
+    kept++;
+  }
+  if (!candidates)
+    mayHoldZeroTerms = false;
+  if (kept == coefficients.size())
+    return;
+  data.resize(kept * termWords);
+  coefficients.resize(kept);
+  // The indices of the kept terms have moved.
+  termIndex.clear();
+}
+
+std::size_t spin_op::findTerm(const std::uint64_t *term) {
+  const std::size_t termWords = 2 * m_n_words;
+  if (termIndex.size() != n_terms()) {
+    termIndex.clear();
+    termIndex.reserve(n_terms());
+    for (std::size_t t = 0; t < n_terms(); t++)
+      termIndex.emplace(hashTerm(termData(t), termWords), t);
+  }
+
+  auto [begin, end] = termIndex.equal_range(hashTerm(term, termWords));
+  for (auto it = begin; it != end; ++it)
+    if (std::equal(term, term + termWords, termData(it->second)))
+      return it->second;
+  return -1;
+}
 
 spin_op &spin_op::operator+=(const spin_op &v) noexcept {
-  spin_op tmpv = v;
+  // Only copy v if it has to be expanded, or if it is this spin_op.
+  const spin_op *other = &v;
+  std::optional<spin_op> tmpv;
   if (v.m_n_qubits > m_n_qubits) {
     // If we are adding a op that has more qubits than we do
     // then we need to resize, making sure to ensure the
     // correct 1/0 positions.
     expandToNQubits(v.m_n_qubits);
   } else if (v.m_n_qubits < m_n_qubits) {
-    tmpv.expandToNQubits(m_n_qubits);
+    other = &tmpv.emplace(v);
+    tmpv->expandToNQubits(m_n_qubits);
   }
+  if (other == this)
+    other = &tmpv.emplace(v);
 
   // Add the rows from v to this, if
   // the row already exists, we should just add the coeffs
-  for (auto [i, row] : enumerate(tmpv.data)) {
-    auto it = std::find(data.begin(), data.end(), row);
-    if (it != data.end()) {
-      auto idx = std::distance(data.begin(), it);
-      coefficients[idx] += tmpv.coefficients[i];
+  const std::size_t termWords = 2 * m_n_words;
+  bool hasZeros = false;
+  for (std::size_t i = 0; i < other->n_terms(); i++) {
+    const auto *row = other->termData(i);
+    auto idx = findTerm(row);
+    if (idx != std::size_t(-1)) {
+      coefficients[idx] += other->coefficients[i];
+      hasZeros |= std::abs(coefficients[idx]) < 1e-12;
     } else {
-      data.push_back(row);
-      coefficients.push_back(tmpv.coefficients[i]);
+      data.insert(data.end(), row, row + termWords);
+      coefficients.push_back(other->coefficients[i]);
+      hasZeros |= std::abs(coefficients.back()) < 1e-12;
+      termIndex.emplace(hashTerm(row, termWords), coefficients.size() - 1);
     }
   }
 
-  // mark any rows for deletion if coeff = (0,0)
-  std::vector<int> marked;
-  for (std::size_t i = 0; i < data.size(); i++)
-    if (std::abs(coefficients[i]) < 1e-12)
-      marked.push_back(i);
-
-  std::sort(marked.begin(), marked.end(), std::greater<int>());
-  for (auto m : marked) {
-    data.erase(data.begin() + m);
-    coefficients.erase(coefficients.begin() + m);
-  }
-
+  // remove any rows with coeff = (0,0), in one pass
+  if (hasZeros || mayHoldZeroTerms)
+    removeZeroTerms();
   return *this;
 }
 
@@ -155,11 +413,38 @@ std::vector<std::complex<double>> spin_op::get_coefficients() const {
 }
 
 spin_op spin_op::operator[](const std::size_t term_idx) const {
-  std::vector<bool> term_data = data[term_idx];
-  auto term_coeff = coefficients[term_idx];
-  BinarySymplecticForm f{term_data};
-  std::vector<std::complex<double>> c{term_coeff};
-  return spin_op(f, c);
+  spin_op term;
+  term.m_n_qubits = m_n_qubits;
+  term.m_n_words = m_n_words;
+  term.data.assign(termData(term_idx), termData(term_idx) + 2 * m_n_words);
+  term.coefficients[0] = coefficients[term_idx];
+  return term;
+}
+
+spin_op &spin_op::simplify(double tolerance) {
+  // Sum the equal terms into the first of them, then drop the small ones.
+  const std::size_t termWords = 2 * m_n_words;
+  std::vector<std::uint64_t> merged;
+  std::vector<std::complex<double>> mergedCoeffs;
+  merged.reserve(data.size());
+  mergedCoeffs.reserve(coefficients.size());
+  TermIndex index(merged, termWords);
+  for (std::size_t t = 0; t < n_terms(); t++) {
+    const auto *term = termData(t);
+    auto idx = index.find(term);
+    if (idx != std::size_t(-1)) {
+      mergedCoeffs[idx] += coefficients[t];
+      continue;
+    }
+    merged.insert(merged.end(), term, term + termWords);
+    mergedCoeffs.push_back(coefficients[t]);
+    index.insert(mergedCoeffs.size() - 1);
+  }
+  data = std::move(merged);
+  coefficients = std::move(mergedCoeffs);
+  termIndex.clear();
+  removeZeroTerms(nullptr, std::max(tolerance, 1e-12));
+  return *this;
 }
 
 spin_op &spin_op::operator-=(const spin_op &v) noexcept {
@@ -177,105 +462,251 @@ spin_op &spin_op::operator*=(const spin_op &v) noexcept {
     copy.expandToNQubits(m_n_qubits);
   }
 
-  int counter = 0;
-  for (auto &row : data) {
-    int inner_counter = 0;
-    for (auto &other_row : copy.data) {
-      // This is term * otherTerm
-      std::vector<bool> tmp(2 * m_n_qubits), tmp2(2 * m_n_qubits);
-      for (std::size_t i = 0; i < 2 * m_n_qubits; i++)
-        tmp[i] = row[i] ^ other_row[i];
+  std::vector<std::uint64_t> product;
+  std::vector<std::complex<double>> productCoeffs;
+  auto merged = multiplyTerms(*this, copy, /*commutator=*/false, product,
+                              productCoeffs);
+  data = std::move(product);
+  coefficients = std::move(productCoeffs);
+  termIndex.clear();
+  // Only drop the terms that (may have) cancelled out in the sum.
+  removeZeroTerms(&merged);
+  mayHoldZeroTerms = true;
+  return *this;
+}
 
-      for (std::size_t i = 0; i < m_n_qubits; i++)
-        tmp2[i] = row[i] && other_row[m_n_qubits + i];
+spin_op commutator(const spin_op &a, const spin_op &b) {
+  const auto nQubits = std::max(a.m_n_qubits, b.m_n_qubits);
+  spin_op lhs(a), rhs(b);
+  lhs.expandToNQubits(nQubits);
+  rhs.expandToNQubits(nQubits);
 
-      int orig_phase = 0, other_phase = 0;
-      for (std::size_t i = 0; i < m_n_qubits; i++) {
-        if (row[i] && row[i + m_n_qubits])
-          orig_phase++;
+  spin_op result;
+  result.m_n_qubits = nQubits;
+  result.m_n_words = lhs.m_n_words;
+  result.data.clear();
+  result.coefficients.clear();
+  auto merged = spin_op::multiplyTerms(lhs, rhs, /*commutator=*/true,
+                                       result.data, result.coefficients);
+  result.removeZeroTerms(&merged);
+  result.mayHoldZeroTerms = true;
+  return result;
+}
 
-        if (other_row[i] && other_row[i + m_n_qubits])
-          other_phase++;
-      }
+spin_op_builder::spin_op_builder() {
+  op.data.clear();
+  op.coefficients.clear();
+  op.mayHoldZeroTerms = false;
+  term.resize(2 * op.m_n_words);
+}
 
-      auto _phase = orig_phase + other_phase;
-      int sum = 0;
-      for (auto a : tmp2)
-        if (a)
-          sum++;
-
-      _phase += 2 * sum;
-      // Based on the phase, figure out an extra coeff to apply
-      for (std::size_t i = 0; i < m_n_qubits; i++)
-        if (tmp[i] && tmp[i + m_n_qubits])
-          _phase -= 1;
-
-      _phase %= 4;
-      std::complex<double> imaginary(0, 1);
-      std::map<int, std::complex<double>> phase_coeff_map{
-          {0, 1.0}, {1, -1. * imaginary}, {2, -1.0}, {3, imaginary}};
-      auto phase_coeff = phase_coeff_map[_phase];
-      coefficients[counter] *= phase_coeff * copy.coefficients[inner_counter];
-      inner_counter++;
-      row = tmp;
+void spin_op_builder::reserve(std::size_t nTerms, std::size_t nQubits) {
+  if (nQubits > op.m_n_qubits) {
+    op.expandToNQubits(nQubits);
+    term.assign(2 * op.m_n_words, 0);
+  }
+  op.data.reserve(nTerms * 2 * op.m_n_words);
+  op.coefficients.reserve(nTerms);
+  op.termIndex.reserve(nTerms);
+}
+
+template <typename Factors>
+spin_op_builder &spin_op_builder::addProduct(std::complex<double> coeff,
+                                             const Factors &factors) {
+  std::size_t nQubits = op.m_n_qubits;
+  for (auto &[p, q] : factors)
+    nQubits = std::max(nQubits, q + 1);
+  if (nQubits > op.m_n_qubits)
+    op.expandToNQubits(nQubits);
+  const std::size_t nw = op.m_n_words;
+  term.assign(2 * nw, 0);
+
+  // Multiply the factors into the term, tracking the power of i of the
+  // phase. With P = i^(x z) X^x Z^z, moving Z^z1 past X^x2 gives (-1)^(z1 x2).
+  int phase = 0;
+  for (auto &[p, q] : factors) {
+    const std::uint64_t bit = 1ULL << (q % 64);
+    auto &xWord = term[q / 64];
+    auto &zWord = term[nw + q / 64];
+    const int x1 = (xWord & bit) != 0, z1 = (zWord & bit) != 0;
+    const int x2 = p == pauli::X || p == pauli::Y;
+    const int z2 = p == pauli::Z || p == pauli::Y;
+    const int x = x1 ^ x2, z = z1 ^ z2;
+    phase += x1 * z1 + x2 * z2 - x * z + 2 * z1 * x2;
+    if (x2)
+      xWord ^= bit;
+    if (z2)
+      zWord ^= bit;
+  }
+  const std::complex<double> powers[] = {1.0, {0, 1}, -1.0, {0, -1}};
+  addTerm(coeff * powers[((phase % 4) + 4) % 4]);
+  return *this;
+}
+
+spin_op_builder &
+spin_op_builder::add(std::complex<double> coeff,
+                     std::initializer_list<factor> factors) {
+  return addProduct(coeff, factors);
+}
+
+spin_op_builder &spin_op_builder::add(std::complex<double> coeff,
+                                      const std::vector<factor> &factors) {
+  return addProduct(coeff, factors);
+}
+
+spin_op_builder &spin_op_builder::add(std::complex<double> coeff,
+                                      std::string_view word) {
+  if (word.size() > op.m_n_qubits)
+    op.expandToNQubits(word.size());
+  const std::size_t nw = op.m_n_words;
+  term.assign(2 * nw, 0);
+  for (std::size_t q = 0; q < word.size(); q++) {
+    const std::uint64_t bit = 1ULL << (q % 64);
+    switch (word[q]) {
+    case 'I':
+      break;
+    case 'X':
+      term[q / 64] |= bit;
+      break;
+    case 'Y':
+      term[q / 64] |= bit;
+      term[nw + q / 64] |= bit;
+      break;
+    case 'Z':
+      term[nw + q / 64] |= bit;
+      break;
+    default:
+      throw std::runtime_error("Invalid Pauli '" + std::string(1, word[q]) +
+                               "' in the Pauli word " + std::string(word) +
+                               ".");
     }
-    counter++;
   }
+  addTerm(coeff);
   return *this;
 }
 
-bool spin_op::is_identity() {
-  for (auto &row : data)
-    for (auto e : row)
-      if (e)
-        return false;
+spin_op_builder &spin_op_builder::add(const spin_op &other) {
+  if (other.m_n_qubits > op.m_n_qubits)
+    op.expandToNQubits(other.m_n_qubits);
+  const std::size_t nw = op.m_n_words;
+  term.resize(2 * nw);
+  for (std::size_t t = 0; t < other.n_terms(); t++) {
+    // Copy the X and the Z words into the (possibly wider) term.
+    const auto *row = other.termData(t);
+    std::fill(term.begin(), term.end(), 0);
+    std::copy_n(row, other.m_n_words, term.begin());
+    std::copy_n(row + other.m_n_words, other.m_n_words, term.begin() + nw);
+    addTerm(other.coefficients[t]);
+  }
+  return *this;
+}
 
-  return true;
+void spin_op_builder::addTerm(std::complex<double> coeff) {
+  const std::size_t termWords = term.size();
+  auto idx = op.findTerm(term.data());
+  if (idx != std::size_t(-1)) {
+    op.coefficients[idx] += coeff;
+    return;
+  }
+  op.data.insert(op.data.end(), term.begin(), term.end());
+  op.coefficients.push_back(coeff);
+  op.termIndex.emplace(hashTerm(term.data(), termWords),
+                       op.coefficients.size() - 1);
 }
 
-bool spin_op::operator==(const spin_op &v) const noexcept {
-  // Could be that the term is identity with all zeros
-  bool isId1 = true, isId2 = true;
-  for (auto &row : data)
-    for (auto e : row)
-      if (e) {
-        isId1 = false;
-        break;
-      }
+spin_op spin_op_builder::build() {
+  spin_op result = std::move(op);
+  *this = spin_op_builder();
+  result.removeZeroTerms();
+  if (result.n_terms() == 0) {
+    result.data.assign(2 * result.m_n_words, 0);
+    result.coefficients.assign(1, 0.0);
+    result.termIndex.clear();
+  }
+  return result;
+}
 
-  for (auto &row : v.data)
-    for (auto e : row)
-      if (e) {
-        isId2 = false;
-        break;
-      }
+bool spin_op::is_identity() {
+  return std::all_of(data.begin(), data.end(),
+                     [](std::uint64_t word) { return word == 0; });
+}
 
-  if (isId1 && isId2)
+bool spin_op::operator==(const spin_op &v) const noexcept {
+  // Could be that the term is identity with all zeros
+  auto isZero = [](std::uint64_t word) { return word == 0; };
+  if (std::all_of(data.begin(), data.end(), isZero) &&
+      std::all_of(v.data.begin(), v.data.end(), isZero))
     return true;
 
-  return data == v.data;
+  return m_n_qubits == v.m_n_qubits && data == v.data;
 }
 
 spin_op &spin_op::operator*=(const double v) noexcept {
   for (auto &c : coefficients)
     c *= v;
+  mayHoldZeroTerms = true;
 
   return *this;
 }
 spin_op &spin_op::operator*=(const std::complex<double> v) noexcept {
   for (auto &c : coefficients)
     c *= v;
+  mayHoldZeroTerms = true;
 
   return *this;
 }
 
 std::size_t spin_op::n_qubits() const { return m_n_qubits; }
-std::size_t spin_op::n_terms() const { return data.size(); }
+std::size_t spin_op::n_terms() const { return data.size() / (2 * m_n_words); }
 std::complex<double>
 spin_op::get_term_coefficient(const std::size_t idx) const {
   return coefficients[idx];
 }
 
+std::vector<std::vector<std::size_t>>
+spin_op::get_qubit_wise_commuting_groups() const {
+  const std::size_t nw = m_n_words;
+  std::vector<std::vector<std::size_t>> groups;
+  // The union of the binary symplectic rows of the terms in each group,
+  // packed like the terms.
+  std::vector<std::uint64_t> groupBases;
+  for (std::size_t t = 0; t < n_terms(); ++t) {
+    const auto *term = termData(t);
+    if (std::all_of(term, term + 2 * nw,
+                    [](std::uint64_t word) { return word == 0; }))
+      continue;
+
+    // The term commutes qubit-wise with a group if both apply the same Pauli
+    // to every qubit they both act on.
+    auto commutes = [&](const std::uint64_t *basis) {
+      for (std::size_t w = 0; w < nw; ++w) {
+        const auto shared =
+            (term[w] | term[w + nw]) & (basis[w] | basis[w + nw]);
+        const auto differ =
+            (term[w] ^ basis[w]) | (term[w + nw] ^ basis[w + nw]);
+        if (shared & differ)
+          return false;
+      }
+      return true;
+    };
+
+    std::size_t g = 0;
+    while (g < groups.size() && !commutes(groupBases.data() + 2 * nw * g))
+      ++g;
+    if (g == groups.size()) {
+      groupBases.insert(groupBases.end(), term, term + 2 * nw);
+      groups.push_back({t});
+      continue;
+    }
+
+    for (std::size_t w = 0; w < 2 * nw; ++w)
+      groupBases[2 * nw * g + w] |= term[w];
+    groups[g].push_back(t);
+  }
+
+  return groups;
+}
+
 spin_op spin_op::slice(const std::size_t startIdx, const std::size_t count) {
   auto nTerms = n_terms();
   if (nTerms <= count)
@@ -283,53 +714,56 @@ spin_op spin_op::slice(const std::size_t startIdx, const std::size_t count) {
                              std::to_string(count) + " terms on spin_op with " +
                              std::to_string(nTerms) + " terms.");
 
-  std::vector<std::complex<double>> newCoeffs;
-  BinarySymplecticForm newData;
-  for (std::size_t i = startIdx; i < startIdx + count; ++i) {
-    if (i == data.size())
-      break;
-    newData.push_back(data[i]);
-    newCoeffs.push_back(coefficients[i]);
+  spin_op sliced;
+  sliced.m_n_qubits = m_n_qubits;
+  sliced.m_n_words = m_n_words;
+  const auto beginIdx = std::min(startIdx, nTerms);
+  const auto endIdx = std::min(startIdx + count, nTerms);
+  sliced.data.assign(termData(beginIdx), termData(endIdx));
+  sliced.coefficients.assign(coefficients.begin() + beginIdx,
+                             coefficients.begin() + endIdx);
+  return sliced;
+}
+
+spin_op spin_op::select(const std::vector<std::size_t> &termIndices) const {
+  const std::size_t termWords = 2 * m_n_words;
+  spin_op selected;
+  selected.m_n_qubits = m_n_qubits;
+  selected.m_n_words = m_n_words;
+  selected.data.resize(termIndices.size() * termWords);
+  selected.coefficients.resize(termIndices.size());
+  for (std::size_t i = 0; i < termIndices.size(); i++) {
+    if (termIndices[i] >= n_terms())
+      throw std::runtime_error("Invalid term index (" +
+                               std::to_string(termIndices[i]) + ", size=" +
+                               std::to_string(n_terms()) + ").");
+    std::copy_n(termData(termIndices[i]), termWords,
+                selected.data.begin() + i * termWords);
+    selected.coefficients[i] = coefficients[termIndices[i]];
   }
-  return spin_op(newData, newCoeffs);
+  return selected;
 }
 
 std::string spin_op::to_string(bool printCoeffs) const {
   if (data.empty())
     return "";
 
-  auto first = data[0];
-  std::stringstream ss;
-  if (printCoeffs)
-    ss << coefficients[0] << " ";
-  for (std::size_t i = 0; i < m_n_qubits; i++) {
-    if (first[i] && first[i + m_n_qubits])
-      ss << "Y" << i;
-    else if (first[i])
-      ss << "X" << i;
-    else if (first[i + m_n_qubits])
-      ss << "Z" << i;
-    else
-      ss << "I" << i;
-  }
-
-  for (std::size_t j = 1; j < data.size(); j++) {
-    ss << " + ";
-    first = data[j];
-    if (printCoeffs)
-      ss << coefficients[j] << " ";
-    for (std::size_t i = 0; i < m_n_qubits; i++) {
-      if (first[i] && first[i + m_n_qubits])
-        ss << "Y" << i;
-      else if (first[i])
-        ss << "X" << i;
-      else if (first[i + m_n_qubits])
-        ss << "Z" << i;
-      else
-        ss << "I" << i;
-    }
+  std::string str;
+  for (std::size_t j = 0; j < n_terms(); j++) {
+    if (j > 0)
+      str += " + ";
+    str += get_term(j).to_string(printCoeffs);
   }
 
+  return str;
+}
+
+std::string spin_op::term_view::to_string(bool printCoefficient) const {
+  std::stringstream ss;
+  if (printCoefficient)
+    ss << coefficient << " ";
+  for (std::size_t i = 0; i < nQubits; i++)
+    ss << pauli_to_str.at(get_pauli(i)) << i;
   return ss.str();
 }
 
@@ -345,8 +779,10 @@ spin_op::spin_op(std::vector<double> &input_vec, std::size_t nQubits) {
                              "spin_op. Number of data elements is incorrect.");
 
   m_n_qubits = nQubits;
+  m_n_words = numWords(m_n_qubits);
   for (std::size_t i = 0; i < input_vec.size() - 1; i += m_n_qubits + 2) {
-    std::vector<bool> tmpv(2 * m_n_qubits);
+    data.resize(data.size() + 2 * m_n_words);
+    auto *tmpv = &data[data.size() - 2 * m_n_words];
     for (std::size_t j = 0; j < m_n_qubits; j++) {
       double intPart;
       if (std::modf(input_vec[j + i], &intPart) != 0.0)
@@ -354,28 +790,401 @@ spin_op::spin_op(std::vector<double> &input_vec, std::size_t nQubits) {
             "Invalid pauli data element, must be integer value.");
 
       int val = (int)input_vec[j + i];
-      if (val == 1) { // X
-        tmpv[j] = 1;
-      } else if (val == 2) { // Z
-        tmpv[j + m_n_qubits] = 1;
-      } else if (val == 3) { // Y
-        tmpv[j + m_n_qubits] = 1;
-        tmpv[j] = 1;
-      }
+      const std::uint64_t bit = 1ULL << (j % 64);
+      if (val == 1 || val == 3) // X or Y
+        tmpv[j / 64] |= bit;
+      if (val == 2 || val == 3) // Z or Y
+        tmpv[m_n_words + j / 64] |= bit;
     }
-    data.push_back(tmpv);
     auto el_real = input_vec[i + m_n_qubits];
     auto el_imag = input_vec[i + m_n_qubits + 1];
     coefficients.emplace_back(el_real, el_imag);
   }
 }
 
-spin_op::BinarySymplecticForm spin_op::get_bsf() const { return data; }
+std::vector<std::complex<double>>
+csr_matrix::operator*(const std::vector<std::complex<double>> &v) const {
+  std::vector<std::complex<double>> result(n_rows);
+  forEachRange(n_rows, numThreads(nnz(), 1 << 16),
+               [&](std::size_t, std::size_t begin, std::size_t end) {
+                 for (std::size_t r = begin; r < end; r++) {
+                   std::complex<double> sum = 0.0;
+                   for (auto k = row_offsets[r]; k < row_offsets[r + 1]; k++)
+                     sum += values[k] * v[column_indices[k]];
+                   result[r] = sum;
+                 }
+               });
+  return result;
+}
+
+csr_matrix spin_op::to_sparse_matrix() const {
+  if (m_n_qubits > 62)
+    throw std::runtime_error("Cannot build the matrix of a spin_op on " +
+                             std::to_string(m_n_qubits) + " qubits.");
+
+  // Term P = i^nY X^x Z^z maps the basis state |c> to
+  // i^nY (-1)^popcount(c & z) |c ^ x>, so all terms with the same X mask
+  // contribute to the same column of a row. The masks are in matrix index
+  // bits, where qubit q is bit n - 1 - q.
+  struct Term {
+    std::uint64_t zMask;
+    std::complex<double> coefficient;
+  };
+  const std::complex<double> phases[] = {1.0, {0, 1}, -1.0, {0, -1}};
+  std::unordered_map<std::uint64_t, std::vector<Term>> termsByX;
+  for (auto term : terms()) {
+    std::uint64_t xMask = 0, zMask = 0;
+    std::size_t nY = 0;
+    for (std::size_t q = 0; q < m_n_qubits; q++) {
+      const auto p = term.get_pauli(q);
+      const std::uint64_t bit = 1ULL << (m_n_qubits - 1 - q);
+      if (p == pauli::X || p == pauli::Y)
+        xMask |= bit;
+      if (p == pauli::Z || p == pauli::Y)
+        zMask |= bit;
+      nY += p == pauli::Y;
+    }
+    termsByX[xMask].push_back({zMask, term.get_coefficient() * phases[nY % 4]});
+  }
+  std::vector<std::pair<std::uint64_t, std::vector<Term>>> groups(
+      termsByX.begin(), termsByX.end());
+
+  // Each thread builds the rows of its range, which are concatenated after.
+  csr_matrix matrix;
+  matrix.n_rows = 1ULL << m_n_qubits;
+  const auto nThreads =
+      numThreads(matrix.n_rows * n_terms(), std::size_t(1) << 16);
+  std::vector<std::vector<std::size_t>> threadColumns(nThreads),
+      threadRowSizes(nThreads);
+  std::vector<std::vector<std::complex<double>>> threadValues(nThreads);
+  forEachRange(
+      matrix.n_rows, nThreads,
+      [&](std::size_t i, std::size_t begin, std::size_t end) {
+        auto &columns = threadColumns[i];
+        auto &values = threadValues[i];
+        auto &rowSizes = threadRowSizes[i];
+        std::vector<std::pair<std::size_t, std::complex<double>>> row;
+        for (std::size_t r = begin; r < end; r++) {
+          row.clear();
+          for (auto &[xMask, groupTerms] : groups) {
+            const std::size_t c = r ^ xMask;
+            std::complex<double> value = 0.0;
+            for (auto &term : groupTerms)
+              value += std::popcount(c & term.zMask) % 2 ? -term.coefficient
+                                                         : term.coefficient;
+            if (std::abs(value) >= 1e-12)
+              row.emplace_back(c, value);
+          }
+          std::sort(row.begin(), row.end(), [](auto &a, auto &b) {
+            return a.first < b.first;
+          });
+          for (auto &[c, value] : row) {
+            columns.push_back(c);
+            values.push_back(value);
+          }
+          rowSizes.push_back(row.size());
+        }
+      });
+
+  matrix.row_offsets.reserve(matrix.n_rows + 1);
+  matrix.row_offsets.push_back(0);
+  for (std::size_t i = 0; i < nThreads; i++) {
+    for (auto size : threadRowSizes[i])
+      matrix.row_offsets.push_back(matrix.row_offsets.back() + size);
+    matrix.column_indices.insert(matrix.column_indices.end(),
+                                 threadColumns[i].begin(),
+                                 threadColumns[i].end());
+    matrix.values.insert(matrix.values.end(), threadValues[i].begin(),
+                         threadValues[i].end());
+    // Release the thread buffers as they are copied.
+    threadColumns[i] = {};
+    threadValues[i] = {};
+  }
+  return matrix;
+}
+
+namespace {
+/// @brief A vector over GF(2), one bit per entry.
+using BitVector = std::vector<std::uint64_t>;
+
+bool getBit(const BitVector &v, std::size_t i) {
+  return v[i / 64] >> (i % 64) & 1;
+}
+void setBit(BitVector &v, std::size_t i) { v[i / 64] |= 1ULL << (i % 64); }
+void xorInto(BitVector &v, const BitVector &other) {
+  for (std::size_t w = 0; w < v.size(); w++)
+    v[w] ^= other[w];
+}
+
+/// @brief Return the generators of the Z2 symmetries of H as BSF bit
+/// vectors (X bits followed by Z bits), and the qubit each one is tapered
+/// on, see find_z2_symmetries().
+std::pair<std::vector<BitVector>, std::vector<std::size_t>>
+findTaperableSymmetries(const spin_op &H) {
+  const std::size_t n = H.n_qubits(), nBits = 2 * n;
+  const std::size_t nWords = (nBits + 63) / 64;
+
+  // The Pauli word (a_x | a_z) commutes with the term (x | z) if
+  // z . a_x + x . a_z = 0, so the symmetries are the kernel of the matrix
+  // of rows (z | x), brought to reduced row echelon form.
+  std::vector<BitVector> rows;
+  for (auto term : H.terms()) {
+    BitVector row(nWords);
+    for (std::size_t q = 0; q < n; q++) {
+      const auto p = term.get_pauli(q);
+      if (p == pauli::Z || p == pauli::Y)
+        setBit(row, q);
+      if (p == pauli::X || p == pauli::Y)
+        setBit(row, n + q);
+    }
+    rows.push_back(std::move(row));
+  }
+  std::vector<std::size_t> pivotColumns;
+  std::vector<bool> isPivot(nBits);
+  for (std::size_t c = 0, rank = 0; c < nBits && rank < rows.size(); c++) {
+    std::size_t r = rank;
+    while (r < rows.size() && !getBit(rows[r], c))
+      r++;
+    if (r == rows.size())
+      continue;
+    std::swap(rows[r], rows[rank]);
+    for (std::size_t other = 0; other < rows.size(); other++)
+      if (other != rank && getBit(rows[other], c))
+        xorInto(rows[other], rows[rank]);
+    pivotColumns.push_back(c);
+    isPivot[c] = true;
+    rank++;
+  }
+
+  // One kernel vector per free column, then reduce their Z parts so that
+  // each one has a Z part bit (its tapered qubit) no other one has.
+  std::vector<BitVector> generators;
+  std::vector<std::size_t> qubits;
+  for (std::size_t f = 0; f < nBits; f++) {
+    if (isPivot[f])
+      continue;
+    BitVector generator(nWords);
+    setBit(generator, f);
+    for (std::size_t i = 0; i < pivotColumns.size(); i++)
+      if (getBit(rows[i], f))
+        setBit(generator, pivotColumns[i]);
+
+    for (std::size_t i = 0; i < generators.size(); i++)
+      if (getBit(generator, n + qubits[i]))
+        xorInto(generator, generators[i]);
+    std::size_t q = 0;
+    while (q < n && !getBit(generator, n + q))
+      q++;
+    if (q == n)
+      continue;
+    for (auto &other : generators)
+      if (getBit(other, n + q))
+        xorInto(other, generator);
+    generators.push_back(std::move(generator));
+    qubits.push_back(q);
+  }
+  return {generators, qubits};
+}
+
+/// @brief Return the one term spin_op of the given BSF bit vector.
+spin_op bitVectorToSpinOp(const BitVector &v, std::size_t nQubits) {
+  std::vector<std::vector<bool>> bsf(1, std::vector<bool>(2 * nQubits));
+  for (std::size_t i = 0; i < 2 * nQubits; i++)
+    bsf[0][i] = getBit(v, i);
+  std::vector<std::complex<double>> coeffs{1.0};
+  return spin_op::from_binary_symplectic(bsf, coeffs);
+}
+} // namespace
+
+std::vector<spin_op> find_z2_symmetries(const spin_op &H) {
+  auto [generators, qubits] = findTaperableSymmetries(H);
+  std::vector<spin_op> symmetries;
+  for (auto &generator : generators)
+    symmetries.push_back(bitVectorToSpinOp(generator, H.n_qubits()));
+  return symmetries;
+}
+
+tapered_spin_op taper_qubits(const spin_op &H, const std::vector<int> &sector) {
+  const std::size_t n = H.n_qubits();
+  auto [generators, qubits] = findTaperableSymmetries(H);
+  if (generators.size() == n) {
+    generators.pop_back();
+    qubits.pop_back();
+  }
+  if (!sector.empty() && sector.size() != generators.size())
+    throw std::runtime_error("taper_qubits expects a sector of " +
+                             std::to_string(generators.size()) +
+                             " eigenvalues.");
+
+  tapered_spin_op result;
+  result.tapered_qubits = qubits;
+  spin_op rotated = H;
+  for (auto &generator : generators) {
+    result.symmetries.push_back(bitVectorToSpinOp(generator, n));
+    // U = (X_q + tau) / sqrt(2) is its own inverse and maps tau to X_q.
+    auto U = spin::x(qubits[result.symmetries.size() - 1]) +
+             result.symmetries.back();
+    rotated = 0.5 * (U * rotated * U);
+  }
+  rotated.simplify();
+
+  // The rotated terms act with I or X on the tapered qubits, where X is
+  // replaced by the eigenvalue of the symmetry.
+  std::vector<int> eigenvalues = sector;
+  eigenvalues.resize(generators.size(), 1);
+  std::vector<bool> isTapered(n);
+  for (auto q : qubits)
+    isTapered[q] = true;
+  const std::size_t nKept = n - qubits.size();
+  std::vector<std::vector<bool>> bsf;
+  std::vector<std::complex<double>> coeffs;
+  for (auto term : rotated.terms()) {
+    auto coefficient = term.get_coefficient();
+    for (std::size_t i = 0; i < qubits.size(); i++) {
+      const auto p = term.get_pauli(qubits[i]);
+      if (p == pauli::Z || p == pauli::Y)
+        throw std::runtime_error("taper_qubits: the operator does not commute "
+                                 "with its symmetries.");
+      if (p == pauli::X)
+        coefficient *= eigenvalues[i];
+    }
+    std::vector<bool> row(2 * nKept);
+    for (std::size_t q = 0, k = 0; q < n; q++) {
+      if (isTapered[q])
+        continue;
+      const auto p = term.get_pauli(q);
+      row[k] = p == pauli::X || p == pauli::Y;
+      row[k + nKept] = p == pauli::Z || p == pauli::Y;
+      k++;
+    }
+    bsf.push_back(std::move(row));
+    coeffs.push_back(coefficient);
+  }
+  if (bsf.empty()) {
+    bsf.emplace_back(2 * nKept);
+    coeffs.push_back(0.0);
+  }
+  result.op = spin_op::from_binary_symplectic(bsf, coeffs);
+  result.op.simplify();
+  return result;
+}
+
+namespace {
+/// @brief Return the smallest eigenvalue of the symmetric tridiagonal matrix
+/// with the given diagonal and off diagonal, by Sturm sequence bisection.
+double smallestTridiagonalEigenvalue(const std::vector<double> &diagonal,
+                                     const std::vector<double> &offDiagonal) {
+  const std::size_t n = diagonal.size();
+  // Gershgorin bounds of the spectrum.
+  double lower = diagonal[0], upper = diagonal[0];
+  for (std::size_t i = 0; i < n; i++) {
+    const double radius = (i > 0 ? std::abs(offDiagonal[i - 1]) : 0.0) +
+                          (i + 1 < n ? std::abs(offDiagonal[i]) : 0.0);
+    lower = std::min(lower, diagonal[i] - radius);
+    upper = std::max(upper, diagonal[i] + radius);
+  }
+
+  // The number of eigenvalues below x is the number of negative pivots of
+  // the LDL^T factorization of T - x.
+  auto countBelow = [&](double x) {
+    std::size_t count = 0;
+    double pivot = 1.0;
+    for (std::size_t i = 0; i < n; i++) {
+      const double b2 = i > 0 ? offDiagonal[i - 1] * offDiagonal[i - 1] : 0.0;
+      pivot = diagonal[i] - x - (i > 0 ? b2 / pivot : 0.0);
+      if (pivot == 0.0)
+        pivot = -1e-300;
+      count += pivot < 0.0;
+    }
+    return count;
+  };
+
+  const double scale = std::max(std::abs(lower), std::abs(upper));
+  while (upper - lower > 1e-15 * std::max(scale, 1.0)) {
+    const double mid = 0.5 * (lower + upper);
+    if (mid <= lower || mid >= upper)
+      break;
+    if (countBelow(mid) > 0)
+      upper = mid;
+    else
+      lower = mid;
+  }
+  return 0.5 * (lower + upper);
+}
+} // namespace
+
+double exact_ground_state(const spin_op &H, std::size_t maxIterations,
+                          double tolerance) {
+  const auto matrix = H.to_sparse_matrix();
+  const std::size_t dim = matrix.n_rows;
+
+  // Lanczos without reorthogonalization, which only keeps the last two
+  // Krylov vectors. Lost orthogonality only adds spurious copies of
+  // converged eigenvalues, the smallest one is still found.
+  std::mt19937 gen(1234);
+  std::normal_distribution<double> dist;
+  std::vector<std::complex<double>> v(dim), previous(dim, 0.0);
+  for (auto &amplitude : v)
+    amplitude = {dist(gen), dist(gen)};
+  auto norm = [](const std::vector<std::complex<double>> &u) {
+    double sum = 0.0;
+    for (auto &a : u)
+      sum += std::norm(a);
+    return std::sqrt(sum);
+  };
+  const double vNorm = norm(v);
+  for (auto &amplitude : v)
+    amplitude /= vNorm;
+
+  std::vector<double> alphas, betas;
+  double beta = 0.0, estimate = 0.0;
+  for (std::size_t k = 0; k < std::min(maxIterations, dim); k++) {
+    auto w = matrix * v;
+    std::complex<double> alpha = 0.0;
+    for (std::size_t i = 0; i < dim; i++)
+      alpha += std::conj(v[i]) * w[i];
+    for (std::size_t i = 0; i < dim; i++)
+      w[i] -= alpha.real() * v[i] + beta * previous[i];
+    alphas.push_back(alpha.real());
+
+    const double lastEstimate = estimate;
+    estimate = smallestTridiagonalEigenvalue(alphas, betas);
+    beta = norm(w);
+    // The Krylov space is invariant, or the estimate has converged.
+    if (beta < 1e-12 * std::max(std::abs(estimate), 1.0) ||
+        (k > 0 && std::abs(estimate - lastEstimate) <
+                      tolerance * std::max(std::abs(estimate), 1.0)))
+      break;
+
+    betas.push_back(beta);
+    previous = std::move(v);
+    v = std::move(w);
+    for (auto &amplitude : v)
+      amplitude /= beta;
+  }
+  return estimate;
+}
+
+spin_op::BinarySymplecticForm spin_op::get_bsf() const {
+  BinarySymplecticForm bsf(n_terms(), std::vector<bool>(2 * m_n_qubits));
+  for (std::size_t t = 0; t < bsf.size(); t++) {
+    const auto *term = termData(t);
+    for (std::size_t q = 0; q < m_n_qubits; q++) {
+      const std::uint64_t bit = 1ULL << (q % 64);
+      bsf[t][q] = term[q / 64] & bit;
+      bsf[t][q + m_n_qubits] = term[m_n_words + q / 64] & bit;
+    }
+  }
+  return bsf;
+}
 
 spin_op &spin_op::operator=(const spin_op &other) {
   data = other.data;
   coefficients = other.coefficients;
   m_n_qubits = other.m_n_qubits;
+  m_n_words = other.m_n_words;
+  termIndex = other.termIndex;
+  mayHoldZeroTerms = other.mayHoldZeroTerms;
   return *this;
 }
 
@@ -393,29 +1202,181 @@ spin_op z(const std::size_t idx) { return spin_op(pauli::Z, idx); }
 
 std::vector<double> spin_op::getDataRepresentation() {
   std::vector<double> dataVec;
-  int counter = 0;
-  for (auto &term : data) {
+  for (std::size_t t = 0; t < n_terms(); t++) {
     auto nq = n_qubits();
     for (std::size_t i = 0; i < nq; i++) {
-      if (term[i] && term[i + nq]) {
-        dataVec.push_back(3.);
-      } else if (term[i]) {
-        dataVec.push_back(1.);
-      } else if (term[i + nq]) {
-        dataVec.push_back(2.);
-      } else {
-        dataVec.push_back(0.);
-      }
+      auto p = getPauli(t, i);
+      dataVec.push_back(p == pauli::Y   ? 3.
+                        : p == pauli::X ? 1.
+                        : p == pauli::Z ? 2.
+                                        : 0.);
     }
-    dataVec.push_back(coefficients[counter].real());
-    dataVec.push_back(coefficients[counter].imag());
-    counter++;
+    dataVec.push_back(coefficients[t].real());
+    dataVec.push_back(coefficients[t].imag());
   }
   dataVec.push_back(n_terms());
   return dataVec;
 }
 
+std::vector<std::uint64_t> spin_op::getPackedRepresentation() const {
+  std::vector<std::uint64_t> packed;
+  packed.reserve(3 + data.size() + 2 * coefficients.size());
+  packed.push_back(m_n_qubits);
+  packed.push_back(m_n_words);
+  packed.push_back(n_terms());
+  packed.insert(packed.end(), data.begin(), data.end());
+  for (auto &coeff : coefficients) {
+    packed.push_back(std::bit_cast<std::uint64_t>(coeff.real()));
+    packed.push_back(std::bit_cast<std::uint64_t>(coeff.imag()));
+  }
+  return packed;
+}
+
+spin_op
+spin_op::fromPackedRepresentation(std::span<const std::uint64_t> packed) {
+  if (packed.size() < 3)
+    throw std::runtime_error("Invalid packed spin_op, no header.");
+  const std::size_t nQubits = packed[0], nWords = packed[1],
+                    nTerms = packed[2];
+  if (nQubits == 0 || nWords != (nQubits + 63) / 64 ||
+      packed.size() != 3 + nTerms * (2 * nWords + 2))
+    throw std::runtime_error("Invalid packed spin_op of " +
+                             std::to_string(packed.size()) + " words.");
+
+  spin_op op;
+  op.m_n_qubits = nQubits;
+  op.m_n_words = nWords;
+  auto rows = packed.begin() + 3;
+  op.data.assign(rows, rows + 2 * nWords * nTerms);
+  op.coefficients.resize(nTerms);
+  auto coeffs = rows + 2 * nWords * nTerms;
+  for (std::size_t t = 0; t < nTerms; t++)
+    op.coefficients[t] = {std::bit_cast<double>(coeffs[2 * t]),
+                          std::bit_cast<double>(coeffs[2 * t + 1])};
+  return op;
+}
+
+namespace {
+/// @brief The header of the mapped_spin_op file format.
+struct MappedSpinOpHeader {
+  char magic[8];
+  std::uint64_t version;
+  std::uint64_t nQubits;
+  std::uint64_t nWords;
+  std::uint64_t nTerms;
+  std::uint64_t reserved[3];
+};
+static_assert(sizeof(MappedSpinOpHeader) == 64);
+constexpr char mappedSpinOpMagic[8] = {'C', 'U', 'D', 'A', 'Q', 'S', 'P', 'O'};
+constexpr std::uint64_t mappedSpinOpVersion = 1;
+} // namespace
+
+mapped_spin_op::mapped_spin_op(const std::string &fileName) {
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error(fileName + " does not exist.");
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      std::size_t(st.st_size) < sizeof(MappedSpinOpHeader)) {
+    ::close(fd);
+    throw std::runtime_error(fileName + " is not a mapped spin_op file.");
+  }
+  mappingSize = st.st_size;
+  void *ptr = ::mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the file is closed.
+  ::close(fd);
+  if (ptr == MAP_FAILED)
+    throw std::runtime_error("Could not map " + fileName + " into memory.");
+  mapping = ptr;
+
+  const auto *header = static_cast<const MappedSpinOpHeader *>(mapping);
+  const auto termWords = 2 * header->nWords;
+  if (!std::equal(header->magic, header->magic + 8, mappedSpinOpMagic) ||
+      header->version != mappedSpinOpVersion ||
+      header->nWords != numWords(header->nQubits) ||
+      mappingSize != sizeof(MappedSpinOpHeader) +
+                         header->nTerms * (termWords * sizeof(std::uint64_t) +
+                                           sizeof(std::complex<double>))) {
+    ::munmap(ptr, mappingSize);
+    throw std::runtime_error(fileName + " is not a mapped spin_op file.");
+  }
+  nQubits = header->nQubits;
+  nWords = header->nWords;
+  nTerms = header->nTerms;
+  words = reinterpret_cast<const std::uint64_t *>(header + 1);
+  coefficients = reinterpret_cast<const std::complex<double> *>(
+      words + nTerms * termWords);
+  // The terms are mostly read in order.
+  ::madvise(ptr, mappingSize, MADV_SEQUENTIAL);
+}
+
+mapped_spin_op::mapped_spin_op(mapped_spin_op &&other) noexcept
+    : mapping(other.mapping), mappingSize(other.mappingSize),
+      words(other.words), coefficients(other.coefficients),
+      nQubits(other.nQubits), nWords(other.nWords), nTerms(other.nTerms) {
+  other.mapping = nullptr;
+  other.mappingSize = 0;
+  other.nTerms = 0;
+}
+
+mapped_spin_op::~mapped_spin_op() {
+  if (mapping)
+    ::munmap(const_cast<void *>(mapping), mappingSize);
+}
+
+void mapped_spin_op::write(const std::string &fileName, const spin_op &op) {
+  std::ofstream output(fileName, std::ios::binary);
+  if (output.fail())
+    throw std::runtime_error("Could not open " + fileName + " for writing.");
+
+  MappedSpinOpHeader header{};
+  std::copy_n(mappedSpinOpMagic, 8, header.magic);
+  header.version = mappedSpinOpVersion;
+  header.nQubits = op.n_qubits();
+  header.nWords = op.n_words();
+  header.nTerms = op.n_terms();
+  output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  output.write(reinterpret_cast<const char *>(op.data.data()),
+               op.data.size() * sizeof(std::uint64_t));
+  output.write(reinterpret_cast<const char *>(op.coefficients.data()),
+               op.coefficients.size() * sizeof(std::complex<double>));
+  if (output.fail())
+    throw std::runtime_error("Could not write " + fileName + ".");
+}
+
+bool mapped_spin_op::is_mapped_format(const std::string &fileName) {
+  std::ifstream input(fileName, std::ios::binary);
+  char magic[8] = {};
+  input.read(magic, 8);
+  return input.good() && std::equal(magic, magic + 8, mappedSpinOpMagic);
+}
+
+spin_op mapped_spin_op::chunk(const std::size_t startIdx,
+                              const std::size_t count) const {
+  const auto beginIdx = std::min(startIdx, nTerms);
+  const auto endIdx = std::min(beginIdx + count, nTerms);
+  spin_op op;
+  op.m_n_qubits = nQubits;
+  op.m_n_words = nWords;
+  op.data.assign(words + 2 * nWords * beginIdx, words + 2 * nWords * endIdx);
+  op.coefficients.assign(coefficients + beginIdx, coefficients + endIdx);
+  return op;
+}
+
+void mapped_spin_op::for_each_chunk(
+    std::size_t chunkSize, std::function<void(spin_op &)> &&functor) const {
+  if (chunkSize == 0)
+    throw std::runtime_error("The chunk size must be positive.");
+  for (std::size_t startIdx = 0; startIdx < nTerms; startIdx += chunkSize) {
+    auto op = chunk(startIdx, chunkSize);
+    functor(op);
+  }
+}
+
 spin_op binary_spin_op_reader::read(const std::string &data_filename) {
+  if (mapped_spin_op::is_mapped_format(data_filename))
+    return mapped_spin_op(data_filename).to_spin_op();
+
   std::ifstream input(data_filename, std::ios::binary);
   if (input.fail())
     throw std::runtime_error(data_filename + " does not exist.");
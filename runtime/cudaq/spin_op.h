@@ -10,8 +10,19 @@
 #include <complex>
 
 #include "utils/cudaq_utils.h"
+#include <array>
+#include <cstdint>
 #include <functional>
+#include <initializer_list>
+#include <iterator>
 #include <map>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 // Define friend functions for operations between spin_op and scalars.
 #define CUDAQ_SPIN_SCALAR_OPERATIONS(op, U)                                    \
@@ -61,9 +72,11 @@
     return nrv;                                                                \
   }                                                                            \
                                                                                \
-  friend spin_op &&operator op(const spin_op &lhs, spin_op &&rhs) noexcept {   \
-    rhs op## = lhs;                                                            \
-    return std::move(rhs);                                                     \
+  friend spin_op operator op(const spin_op &lhs, spin_op &&rhs) noexcept {     \
+    /* The product is not commutative, lhs has to stay on the left. */         \
+    spin_op nrv(lhs);                                                          \
+    nrv op## = rhs;                                                            \
+    return nrv;                                                                \
   }                                                                            \
                                                                                \
   friend spin_op &&operator op(spin_op &&lhs, const spin_op &rhs) noexcept {   \
@@ -97,6 +110,28 @@ spin_op y(const std::size_t idx);
 spin_op z(const std::size_t idx);
 } // namespace spin
 
+class mapped_spin_op;
+class spin_op_builder;
+template <std::size_t NQubits, std::size_t NTerms>
+class static_spin_op;
+
+/// @brief A complex matrix in compressed sparse row format. The entries of
+/// row r are values[row_offsets[r]] to values[row_offsets[r + 1] - 1], in the
+/// columns given by column_indices, in increasing order.
+struct csr_matrix {
+  std::size_t n_rows = 0;
+  std::vector<std::size_t> row_offsets;
+  std::vector<std::size_t> column_indices;
+  std::vector<std::complex<double>> values;
+
+  /// @brief Return the number of stored entries.
+  std::size_t nnz() const { return values.size(); }
+
+  /// @brief Return the product of this matrix with the given vector.
+  std::vector<std::complex<double>>
+  operator*(const std::vector<std::complex<double>> &v) const;
+};
+
 /// @brief The spin_op represents a general sum of pauli tensor products.
 /// It exposes the typical algebraic operations that allow programmers to
 /// define primitive pauli operators and use them to compose larger, more
@@ -109,6 +144,11 @@ private:
   friend spin_op spin::x(const std::size_t);
   friend spin_op spin::y(const std::size_t);
   friend spin_op spin::z(const std::size_t);
+  friend spin_op commutator(const spin_op &, const spin_op &);
+  friend class mapped_spin_op;
+  friend class spin_op_builder;
+  template <std::size_t NQubits, std::size_t NTerms>
+  friend class static_spin_op;
 
   /// @brief We represent the spin_op in binary symplectic form,
   /// i.e. each term is a vector of 1s and 0s of size 2 * nQubits,
@@ -117,8 +157,24 @@ private:
   /// and X=0, Z=1 -> Z on site i.
   using BinarySymplecticForm = std::vector<std::vector<bool>>;
 
-  /// @brief The spin_op representation
-  BinarySymplecticForm data;
+  /// @brief The spin_op representation, the binary symplectic rows of all
+  /// terms packed into one buffer. Each term takes 2 * m_n_words words, the
+  /// X bits of the qubits followed by their Z bits, with qubit q at bit q % 64
+  /// of word q / 64. Bits beyond the last qubit are zero.
+  std::vector<std::uint64_t> data;
+
+  /// @brief The number of words holding the X (or Z) bits of a term
+  std::size_t m_n_words = 1;
+
+  /// @brief Index from the hash of a packed term to the term index, to find
+  /// the duplicates of added terms in O(1). It is valid if it holds one entry
+  /// per term, and is rebuilt on the next lookup otherwise.
+  std::unordered_multimap<std::uint64_t, std::size_t> termIndex;
+
+  /// @brief False if no term has a zero coefficient. The zero terms are only
+  /// searched for in operator+= if the coefficients may have become zero in
+  /// another way since, i.e. at construction or by multiplication.
+  bool mayHoldZeroTerms = true;
 
   /// @brief The coefficients for each term in the spin_op
   std::vector<std::complex<double>> coefficients;
@@ -127,13 +183,44 @@ private:
   std::size_t m_n_qubits = 1;
 
   /// @brief Utility map that takes the pauli enum to a string representation
-  std::map<pauli, std::string> pauli_to_str{
+  static inline const std::map<pauli, std::string> pauli_to_str{
       {pauli::I, "I"}, {pauli::X, "X"}, {pauli::Y, "Y"}, {pauli::Z, "Z"}};
 
   /// @brief Expand this spin_op binary symplectic representation to
   /// a larger number of qubits.
   void expandToNQubits(const std::size_t nQubits);
 
+  /// @brief Return the packed words of the given term.
+  std::uint64_t *termData(const std::size_t termIdx) {
+    return data.data() + 2 * m_n_words * termIdx;
+  }
+  const std::uint64_t *termData(const std::size_t termIdx) const {
+    return data.data() + 2 * m_n_words * termIdx;
+  }
+
+  /// @brief Return the index of the term equal to the packed `term`, or -1.
+  std::size_t findTerm(const std::uint64_t *term);
+
+  /// @brief Return the Pauli of the given term on the given qubit.
+  pauli getPauli(const std::size_t termIdx, const std::size_t qubit) const;
+
+  /// @brief Sum the products of all pairs of terms of lhs and rhs, which
+  /// are on the same number of qubits, into the given (empty) buffers of
+  /// packed terms and coefficients. Large products are computed on multiple
+  /// threads. If `commutator` is true, only anticommuting pairs contribute
+  /// (twice), which gives the commutator [lhs, rhs]. Returns the sorted
+  /// indices of the products that were summed with another one.
+  static std::vector<std::size_t>
+  multiplyTerms(const spin_op &lhs, const spin_op &rhs, bool commutator,
+                std::vector<std::uint64_t> &product,
+                std::vector<std::complex<double>> &productCoeffs);
+
+  /// @brief Remove the terms with a zero coefficient, i.e. below
+  /// `tolerance` in magnitude. If `candidates` is given, only these terms (in
+  /// increasing order) are considered.
+  void removeZeroTerms(const std::vector<std::size_t> *candidates = nullptr,
+                       double tolerance = 1e-12);
+
   /// @brief Internal constructor, takes the Pauli type, the qubit site, and the
   /// term coefficient. Constructs a spin_op of one pauli on one qubit.
   spin_op(pauli, const std::size_t id, std::complex<double> coeff = 1.0);
@@ -143,6 +230,135 @@ private:
   spin_op(BinarySymplecticForm bsf, std::vector<std::complex<double>> coeffs);
 
 public:
+  class term_range;
+
+  /// @brief A view of one term of a spin_op, its packed binary symplectic row
+  /// and its coefficient. Creating one does not allocate. It is valid until
+  /// the spin_op is modified.
+  class term_view {
+    friend class spin_op;
+    friend class term_range;
+    const std::uint64_t *words = nullptr;
+    std::size_t nWords = 0;
+    std::size_t nQubits = 0;
+    std::complex<double> coefficient;
+
+    term_view(const std::uint64_t *words, std::size_t nWords,
+              std::size_t nQubits, std::complex<double> coefficient)
+        : words(words), nWords(nWords), nQubits(nQubits),
+          coefficient(coefficient) {}
+
+  public:
+    /// @brief Return the number of qubits of the spin_op.
+    std::size_t n_qubits() const { return nQubits; }
+
+    /// @brief Return the coefficient of the term.
+    std::complex<double> get_coefficient() const { return coefficient; }
+
+    /// @brief Return the Pauli on the given qubit.
+    pauli get_pauli(const std::size_t qubit) const {
+      const std::uint64_t bit = 1ULL << (qubit % 64);
+      const bool x = words[qubit / 64] & bit;
+      const bool z = words[nWords + qubit / 64] & bit;
+      return x && z ? pauli::Y : x ? pauli::X : z ? pauli::Z : pauli::I;
+    }
+
+    /// @brief Return the packed row, see spin_op::get_term_data().
+    const std::uint64_t *data() const { return words; }
+
+    /// @brief Return true if the term is the identity.
+    bool is_identity() const {
+      for (std::size_t w = 0; w < 2 * nWords; w++)
+        if (words[w])
+          return false;
+      return true;
+    }
+
+    /// @brief Return the string representation of the term, the same as
+    /// spin_op::to_string() of a one term spin_op.
+    std::string to_string(bool printCoefficient = true) const;
+  };
+
+  /// @brief A random access range over the terms of a spin_op, see terms().
+  /// It views the packed rows and coefficients of the terms, which may also
+  /// be held by a mapped_spin_op. Its iterators are valid while it is.
+  class term_range {
+    const std::uint64_t *words = nullptr;
+    const std::complex<double> *coefficients = nullptr;
+    std::size_t nWords = 0;
+    std::size_t nQubits = 0;
+    std::size_t nTerms = 0;
+
+  public:
+    class iterator {
+      const term_range *range;
+      std::size_t termIdx;
+
+    public:
+      using iterator_category = std::random_access_iterator_tag;
+      using value_type = term_view;
+      using difference_type = std::ptrdiff_t;
+      using pointer = void;
+      using reference = term_view;
+
+      iterator(const term_range *range, std::size_t termIdx)
+          : range(range), termIdx(termIdx) {}
+      term_view operator*() const { return (*range)[termIdx]; }
+      term_view operator[](difference_type n) const {
+        return (*range)[termIdx + n];
+      }
+      iterator &operator++() {
+        ++termIdx;
+        return *this;
+      }
+      iterator operator++(int) { return iterator(range, termIdx++); }
+      iterator &operator--() {
+        --termIdx;
+        return *this;
+      }
+      iterator operator--(int) { return iterator(range, termIdx--); }
+      iterator &operator+=(difference_type n) {
+        termIdx += n;
+        return *this;
+      }
+      iterator &operator-=(difference_type n) {
+        termIdx -= n;
+        return *this;
+      }
+      iterator operator+(difference_type n) const {
+        return iterator(range, termIdx + n);
+      }
+      iterator operator-(difference_type n) const {
+        return iterator(range, termIdx - n);
+      }
+      difference_type operator-(const iterator &other) const {
+        return difference_type(termIdx) - difference_type(other.termIdx);
+      }
+      bool operator==(const iterator &other) const {
+        return termIdx == other.termIdx;
+      }
+      bool operator!=(const iterator &other) const {
+        return termIdx != other.termIdx;
+      }
+      bool operator<(const iterator &other) const {
+        return termIdx < other.termIdx;
+      }
+    };
+
+    term_range(const std::uint64_t *words,
+               const std::complex<double> *coefficients, std::size_t nWords,
+               std::size_t nQubits, std::size_t nTerms)
+        : words(words), coefficients(coefficients), nWords(nWords),
+          nQubits(nQubits), nTerms(nTerms) {}
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, nTerms); }
+    std::size_t size() const { return nTerms; }
+    term_view operator[](std::size_t termIdx) const {
+      return term_view(words + 2 * nWords * termIdx, nWords, nQubits,
+                       coefficients[termIdx]);
+    }
+  };
+
   /// @brief Return a new spin_op from the user-provided binary symplectic data.
   static spin_op
   from_binary_symplectic(BinarySymplecticForm &data,
@@ -159,6 +375,9 @@ public:
   /// @brief Copy constructor
   spin_op(const spin_op &o);
 
+  /// @brief Move constructor, takes over the terms of o.
+  spin_op(spin_op &&o) noexcept = default;
+
   /// @brief Construct this spin_op from a serialized representation.
   /// Specifically, this encoding is via a vector of doubles. The encoding is
   /// as follows: for each term, a list of doubles where the ith element is
@@ -174,6 +393,9 @@ public:
   /// @brief Set the provided spin_op equal to this one and return *this.
   spin_op &operator=(const spin_op &);
 
+  /// @brief Take over the terms of the provided spin_op and return *this.
+  spin_op &operator=(spin_op &&) noexcept = default;
+
   /// @brief Add the given spin_op to this one and return *this
   spin_op &operator+=(const spin_op &v) noexcept;
 
@@ -224,6 +446,20 @@ public:
   /// @brief Return the ith term of this spin_op (by value).
   spin_op operator[](const std::size_t termIdx) const;
 
+  /// @brief Return a view of the ith term of this spin_op, without copying
+  /// it.
+  term_view get_term(const std::size_t termIdx) const {
+    return term_view(termData(termIdx), m_n_words, m_n_qubits,
+                     coefficients[termIdx]);
+  }
+
+  /// @brief Return a range of views over all terms of this spin_op, i.e.
+  /// `for (auto term : op.terms())`.
+  term_range terms() const {
+    return term_range(data.data(), coefficients.data(), m_n_words, m_n_qubits,
+                      n_terms());
+  }
+
   /// @brief Return the number of qubits this spin_op is on
   std::size_t n_qubits() const;
 
@@ -236,6 +472,30 @@ public:
   /// @brief Return the binary symplectic form data
   BinarySymplecticForm get_bsf() const;
 
+  /// @brief Return the 2^n_qubits() x 2^n_qubits() matrix of this spin_op
+  /// in compressed sparse row format. Qubit 0 is the most significant bit of
+  /// the row and column indices, as for the simulator state vectors. Each
+  /// row holds at most one entry per distinct X part of the terms, the rows
+  /// are computed on multiple threads.
+  csr_matrix to_sparse_matrix() const;
+
+  /// @brief Return the number of 64 bit words holding the X (or Z) bits of
+  /// a term, see get_term_data().
+  std::size_t n_words() const { return m_n_words; }
+
+  /// @brief Return the packed binary symplectic row of the given term,
+  /// n_words() words of X bits followed by n_words() words of Z bits. Qubit
+  /// q is bit q % 64 of word q / 64. The pointer is valid until this spin_op
+  /// is modified.
+  const std::uint64_t *get_term_data(const std::size_t termIdx) const {
+    return termData(termIdx);
+  }
+
+  /// @brief Sum the equal terms of this spin_op and remove the terms whose
+  /// coefficient is below `tolerance` in magnitude (at least 1e-12, the
+  /// threshold of the arithmetic operators). Return *this.
+  spin_op &simplify(double tolerance = 1e-12);
+
   /// @brief Is this spin_op == to the identity
   bool is_identity();
 
@@ -249,16 +509,39 @@ public:
   /// spin_op. (see the constructor for the encoding)
   std::vector<double> getDataRepresentation();
 
+  /// @brief Return the packed representation of this spin_op: the number of
+  /// qubits, of words per X or Z row and of terms, the packed rows of all
+  /// terms (see get_term_data()), then the bits of the real and imaginary
+  /// parts of each coefficient. A term takes 2 * n_words() + 2 words rather
+  /// than n_qubits() + 2 doubles, and is copied without conversion.
+  std::vector<std::uint64_t> getPackedRepresentation() const;
+
+  /// @brief Construct a spin_op from its packed representation (see
+  /// getPackedRepresentation()), e.g. read in place from a received buffer.
+  static spin_op
+  fromPackedRepresentation(std::span<const std::uint64_t> packed);
+
   /// @brief Return all term coefficients in this spin_op
   std::vector<std::complex<double>> get_coefficients() const;
 
+  /// @brief Partition the non-identity terms of this spin_op into groups of
+  /// qubit-wise commuting terms, i.e. terms that apply the same Pauli to
+  /// every qubit they share. All terms of a group can be measured with one
+  /// measurement setting. Returns the term indices of each group.
+  std::vector<std::vector<std::size_t>> get_qubit_wise_commuting_groups() const;
+
   /// @brief Return a new spin_op made up of a sum of spin_op terms
   /// where the first term is the one at startIdx, and the remaining terms
   /// are the next count terms.
   spin_op slice(const std::size_t startIdx, const std::size_t count);
 
+  /// @brief Return a new spin_op made up of the terms at the given indices,
+  /// in that order.
+  spin_op select(const std::vector<std::size_t> &termIndices) const;
+
   /// @brief Apply the give functor on each term of this spin_op. This method
-  /// can enable general reductions via lambda capture variables.
+  /// can enable general reductions via lambda capture variables. Each term
+  /// is copied into a new spin_op, prefer terms() to only read them.
   void for_each_term(std::function<void(spin_op &)> &&);
 
   /// @brief Apply the functor on each pauli in this 1-term spin_op. An
@@ -267,6 +550,102 @@ public:
   void for_each_pauli(std::function<void(pauli, std::size_t)> &&);
 };
 
+/// @brief Accumulates a sum of Pauli products into packed terms, merging
+/// equal terms as they are added, and materializes the spin_op once. Unlike
+/// `h += c * x(i) * z(j)`, adding a product does not create any temporary
+/// spin_op, so large operators can be built from loops, e.g.
+///   spin_op_builder builder;
+///   for (std::size_t i = 0; i + 1 < n; i++)
+///     builder.add(J, {{pauli::Z, i}, {pauli::Z, i + 1}});
+///   spin_op h = builder.build();
+class spin_op_builder {
+  /// @brief The terms added so far, there is no term initially.
+  spin_op op;
+  /// @brief The packed row of the term being added.
+  std::vector<std::uint64_t> term;
+
+public:
+  /// @brief A Pauli on a qubit, a factor of a product.
+  using factor = std::pair<pauli, std::size_t>;
+
+  spin_op_builder();
+
+  /// @brief Reserve the memory for the given number of terms on the given
+  /// number of qubits.
+  void reserve(std::size_t nTerms, std::size_t nQubits);
+
+  /// @brief Add the product of the coefficient and the Pauli factors, in
+  /// order. Factors on the same qubit are multiplied, e.g. {X0, Y0} adds
+  /// i Z0. An empty product adds the identity.
+  spin_op_builder &add(std::complex<double> coeff,
+                       std::initializer_list<factor> factors);
+  spin_op_builder &add(std::complex<double> coeff,
+                       const std::vector<factor> &factors);
+
+  /// @brief Add the coefficient times the Pauli word, whose i-th character
+  /// (I, X, Y or Z) is the Pauli on qubit i.
+  spin_op_builder &add(std::complex<double> coeff, std::string_view word);
+
+  /// @brief Add all terms of the given spin_op.
+  spin_op_builder &add(const spin_op &other);
+  spin_op_builder &operator+=(const spin_op &other) { return add(other); }
+
+  /// @brief Return the number of distinct terms added so far, including the
+  /// ones that cancelled out.
+  std::size_t n_terms() const { return op.n_terms(); }
+
+  /// @brief Return the sum of the added terms, without the terms that
+  /// cancelled out, and start over with no term. If no term is left, this
+  /// is the identity with a zero coefficient.
+  spin_op build();
+
+private:
+  template <typename Factors>
+  spin_op_builder &addProduct(std::complex<double> coeff,
+                              const Factors &factors);
+  /// @brief Add `term` with the given coefficient.
+  void addTerm(std::complex<double> coeff);
+};
+
+/// @brief Return the commutator [a, b] = a * b - b * a. Only the pairs of
+/// anticommuting terms are multiplied, commuting ones are skipped.
+spin_op commutator(const spin_op &a, const spin_op &b);
+
+/// @brief Return independent Pauli words (as one term spin_ops with unit
+/// coefficient) that commute with every term of H, i.e. generators of its Z2
+/// symmetries, found by GF(2) elimination on its binary symplectic form.
+/// Generator i acts with Z or Y on qubit tapered_qubits[i] of
+/// taper_qubits() and with I or X there for all other generators. Generators
+/// without such a qubit cannot be tapered and are not returned.
+std::vector<spin_op> find_z2_symmetries(const spin_op &H);
+
+/// @brief The result of taper_qubits().
+struct tapered_spin_op {
+  /// @brief The operator on the remaining qubits, renumbered in order.
+  spin_op op;
+  /// @brief The symmetries of the original operator, see
+  /// find_z2_symmetries().
+  std::vector<spin_op> symmetries;
+  /// @brief The qubit removed for each symmetry.
+  std::vector<std::size_t> tapered_qubits;
+};
+
+/// @brief Remove one qubit of H per Z2 symmetry (see find_z2_symmetries()).
+/// Each symmetry tau_i is rotated to X on qubit tapered_qubits[i] by the
+/// Clifford (X + tau_i) / sqrt(2), which is then replaced by the eigenvalue
+/// sector[i] of tau_i (+1 or -1, all +1 if sector is empty). The spectrum
+/// of H is the union of the spectra of all sectors. At least one qubit is
+/// kept.
+tapered_spin_op taper_qubits(const spin_op &H,
+                             const std::vector<int> &sector = {});
+
+/// @brief Return the smallest eigenvalue of the Hermitian spin_op H, computed
+/// by the Lanczos method on its sparse matrix. This is meant as a classical
+/// reference for variational results, its memory is O(nnz + 2^n_qubits). It
+/// stops once the estimate changes by less than the relative tolerance.
+double exact_ground_state(const spin_op &H, std::size_t maxIterations = 1000,
+                          double tolerance = 1e-10);
+
 /// @brief Add a double and a spin_op
 spin_op operator+(double coeff, spin_op op);
 
@@ -279,12 +658,148 @@ spin_op operator-(double coeff, spin_op op);
 /// @brief Subtract a spin_op and a double
 spin_op operator-(spin_op op, double coeff);
 
+/// @brief A read-only spin_op held in a file of packed terms and mapped into
+/// memory, for operators too large to load at once. The file holds a 64 byte
+/// header (the magic "CUDAQSPO", the format version, the number of qubits,
+/// of words per X or Z row and of terms, as 64 bit integers), then the packed
+/// rows of all terms as in spin_op::get_term_data(), then the coefficients as
+/// pairs of doubles, all in native byte order. Pages are only read from the
+/// file when the terms are accessed.
+class mapped_spin_op {
+  const void *mapping = nullptr;
+  std::size_t mappingSize = 0;
+  const std::uint64_t *words = nullptr;
+  const std::complex<double> *coefficients = nullptr;
+  std::size_t nQubits = 0;
+  std::size_t nWords = 0;
+  std::size_t nTerms = 0;
+
+public:
+  /// @brief The number of terms per chunk observe() evaluates at once.
+  static constexpr std::size_t default_chunk_size = 1 << 16;
+
+  /// @brief Map the given file, written by write().
+  explicit mapped_spin_op(const std::string &fileName);
+  mapped_spin_op(mapped_spin_op &&other) noexcept;
+  mapped_spin_op(const mapped_spin_op &) = delete;
+  mapped_spin_op &operator=(const mapped_spin_op &) = delete;
+  ~mapped_spin_op();
+
+  /// @brief Write the given spin_op to a file in the mapped format.
+  static void write(const std::string &fileName, const spin_op &op);
+
+  /// @brief Return true if the given file starts with the mapped format
+  /// header.
+  static bool is_mapped_format(const std::string &fileName);
+
+  std::size_t n_qubits() const { return nQubits; }
+  std::size_t n_terms() const { return nTerms; }
+  std::size_t n_words() const { return nWords; }
+
+  /// @brief Return a range of views over all terms, reading them from the
+  /// mapping.
+  spin_op::term_range terms() const {
+    return spin_op::term_range(words, coefficients, nWords, nQubits, nTerms);
+  }
+
+  /// @brief Return a view of the ith term.
+  spin_op::term_view get_term(const std::size_t termIdx) const {
+    return terms()[termIdx];
+  }
+
+  /// @brief Copy the terms [startIdx, startIdx + count) into a spin_op. The
+  /// chunk is clamped to the number of terms.
+  spin_op chunk(const std::size_t startIdx, const std::size_t count) const;
+
+  /// @brief Apply the functor on consecutive chunks of at most chunkSize
+  /// terms, each copied into a spin_op. Only one chunk is held in memory
+  /// at a time.
+  void for_each_chunk(std::size_t chunkSize,
+                      std::function<void(spin_op &)> &&functor) const;
+
+  /// @brief Copy all terms into a spin_op.
+  spin_op to_spin_op() const { return chunk(0, nTerms); }
+};
+
+/// @brief A sum of NTerms Pauli words on NQubits qubits, packed at compile
+/// time. The terms are given as strings of 'I', 'X', 'Y' and 'Z' with the
+/// Pauli of qubit q at position q, i.e.
+/// \code{.cpp}
+/// constexpr cudaq::static_spin_op<2, 3> H({"XX", "YY", "ZZ"}, {1., 1., 1.});
+/// \endcode
+/// An invalid term fails the constant evaluation. The terms are packed as
+/// in spin_op::get_term_data(), so to_spin_op() copies them into a spin_op
+/// without parsing or converting them.
+template <std::size_t NQubits, std::size_t NTerms>
+class static_spin_op {
+  static_assert(NQubits > 0 && NTerms > 0,
+                "A static_spin_op needs at least one qubit and one term.");
+  static constexpr std::size_t nWords = (NQubits + 63) / 64;
+
+  std::array<std::uint64_t, 2 * nWords * NTerms> words{};
+  std::array<std::complex<double>, NTerms> coefficients{};
+
+public:
+  constexpr static_spin_op(
+      const std::array<std::string_view, NTerms> &paulis,
+      const std::array<std::complex<double>, NTerms> &coeffs)
+      : coefficients(coeffs) {
+    for (std::size_t t = 0; t < NTerms; t++) {
+      if (paulis[t].size() != NQubits)
+        throw std::invalid_argument("static_spin_op term of wrong length.");
+      for (std::size_t q = 0; q < NQubits; q++) {
+        const std::uint64_t bit = 1ULL << (q % 64);
+        const char p = paulis[t][q];
+        if (p == 'X' || p == 'Y')
+          words[2 * nWords * t + q / 64] |= bit;
+        if (p == 'Z' || p == 'Y')
+          words[2 * nWords * t + nWords + q / 64] |= bit;
+        if (p != 'I' && p != 'X' && p != 'Y' && p != 'Z')
+          throw std::invalid_argument("Invalid Pauli in static_spin_op term.");
+      }
+    }
+  }
+
+  static constexpr std::size_t n_qubits() { return NQubits; }
+  static constexpr std::size_t n_terms() { return NTerms; }
+  static constexpr std::size_t n_words() { return nWords; }
+
+  /// @brief Return the packed row of the given term.
+  constexpr const std::uint64_t *get_term_data(std::size_t termIdx) const {
+    return words.data() + 2 * nWords * termIdx;
+  }
+
+  constexpr std::complex<double>
+  get_term_coefficient(std::size_t termIdx) const {
+    return coefficients[termIdx];
+  }
+
+  /// @brief Return a range of views over all terms.
+  spin_op::term_range terms() const {
+    return spin_op::term_range(words.data(), coefficients.data(), nWords,
+                               NQubits, NTerms);
+  }
+
+  /// @brief Copy the terms into a spin_op.
+  spin_op to_spin_op() const {
+    spin_op op;
+    op.m_n_qubits = NQubits;
+    op.m_n_words = nWords;
+    op.data.assign(words.begin(), words.end());
+    op.coefficients.assign(coefficients.begin(), coefficients.end());
+    return op;
+  }
+};
+
 class spin_op_reader {
 public:
   virtual ~spin_op_reader() = default;
   virtual spin_op read(const std::string &data_filename) = 0;
 };
 
+/// @brief Read a spin_op from a file holding either the vector<double>
+/// representation (see spin_op::getDataRepresentation()) or the
+/// mapped_spin_op format.
 class binary_spin_op_reader : public spin_op_reader {
 public:
   spin_op read(const std::string &data_filename) override;
@@ -11,11 +11,35 @@
 #include "Logger.h"
 #include "MeasureCounts.h"
 #include "NoiseModel.h"
+#include "Profiler.h"
 #include "QIRTypes.h"
+#include "StateCheckpoint.h"
+#include "StatePreparation.h"
+#include "ThreadAffinity.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <complex>
 #include <cstdarg>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <random>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 ///
 /// This file defines the CircuitSimulator, which is meant to be
@@ -25,6 +49,104 @@
 
 namespace nvqir {
 
+/// @brief The gates of a CapturedCircuit.
+enum class CapturedGate : std::uint8_t {
+  x,
+  y,
+  z,
+  h,
+  s,
+  t,
+  sdg,
+  tdg,
+  rx,
+  ry,
+  rz,
+  r1,
+  u1,
+  u2,
+  u3,
+  swap
+};
+
+/// @brief Return the CapturedGate with the given name, if there is one.
+inline std::optional<CapturedGate> getCapturedGate(std::string_view name) {
+  static constexpr std::string_view names[] = {
+      "x",  "y",  "z",  "h",  "s",  "t",  "sdg", "tdg",
+      "rx", "ry", "rz", "r1", "u1", "u2", "u3", "swap"};
+  for (std::size_t i = 0; i < std::size(names); i++)
+    if (names[i] == name)
+      return static_cast<CapturedGate>(i);
+  return std::nullopt;
+}
+
+/// @brief The gate sequence of one kernel execution, recorded by
+/// CircuitSimulator::beginCapture() and applied again, possibly with new
+/// gate parameters, by CircuitSimulator::replay().
+struct CapturedCircuit {
+  /// @brief One gate. Its controls and targets are a slice of `qubits`
+  /// starting at `qubitOffset`, its parameters a slice of `parameters`
+  /// starting at `parameterOffset`.
+  struct Instruction {
+    CapturedGate gate;
+    std::uint8_t nParameters;
+    std::uint16_t nControls;
+    std::uint32_t qubitOffset;
+    std::uint32_t parameterOffset;
+  };
+
+  std::vector<Instruction> instructions;
+
+  /// @brief The controls followed by the targets of every instruction.
+  std::vector<std::size_t> qubits;
+
+  /// @brief The parameter slots, that is the parameters of all instructions
+  /// in order. replay() takes a vector of the same layout.
+  std::vector<double> parameters;
+
+  /// @brief The qubits measured for sampling at the end of the kernel.
+  std::vector<std::size_t> measuredQubits;
+
+  /// @brief The number of qubits the kernel allocated.
+  std::size_t nQubits = 0;
+
+  /// @brief False if the kernel read or collapsed the state (mid-circuit
+  /// measurements, resets, noise) or applied a gate that cannot be
+  /// captured, the gates do not describe the execution then.
+  bool replayable = true;
+};
+
+/// @brief The diagonal factor exp(-i angle / 2 Z...Z) with a Z on each of
+/// the qubits. A layer of these, like a QAOA cost layer, is applied in one
+/// sweep by simulators that can, see CircuitSimulator::applyDiagonalPhases().
+struct ZRotation {
+  std::vector<std::size_t> qubits;
+  double angle = 0.0;
+};
+
+/// @brief Add the time from construction to destruction to the simulator
+/// time of the performance counters of `context`, if not null.
+class SimulatorTimer {
+  cudaq::ExecutionContext *context;
+  std::chrono::steady_clock::time_point start;
+
+public:
+  explicit SimulatorTimer(cudaq::ExecutionContext *context)
+      : context(context) {
+    if (context)
+      start = std::chrono::steady_clock::now();
+  }
+  ~SimulatorTimer() {
+    if (!context)
+      return;
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    context->counters.simulator_seconds += elapsed.count();
+  }
+  SimulatorTimer(const SimulatorTimer &) = delete;
+  SimulatorTimer &operator=(const SimulatorTimer &) = delete;
+};
+
 /// The CircuitSimulator defines a base class for all simulators
 /// that are available to CUDA Quantum via the NVQIR library.
 /// This base class handles Qubit allocation and deallocation,
@@ -50,17 +172,22 @@ protected:
   /// Vector containing qubit ids that are to be sampled
   std::vector<std::size_t> sampleQubits;
 
-  /// @brief Map of register name to observed bit results for mid-circuit
-  /// sampling
-  std::unordered_map<std::string, std::vector<std::string>>
-      midCircuitSampleResults;
+  /// @brief The named registers of the mid-circuit measurements of the
+  /// current shot, with the positions of their results in midCircuitBits,
+  /// and the index of each register by name.
+  std::vector<cudaq::MeasurementLog::Register> midCircuitRegisters;
+  std::unordered_map<std::string, std::size_t> midCircuitRegisterIndex;
 
   /// @brief Store the last observed register name, this will help us
   /// know if we are writing to a classical bit vector
   std::string lastMidCircuitRegisterName = "";
 
-  /// @brief Vector storing register names that are bit vectors
-  std::vector<std::string> vectorRegisters;
+  /// @brief The mid-circuit measurement results of the current shot, in
+  /// measurement order.
+  std::vector<bool> midCircuitBits;
+
+  /// @brief The number of shots sampled at once when streaming.
+  static constexpr int streamChunkShots = 1 << 20;
 
   /// Under certain execution contexts, we'll deallocate
   /// before we are actually done with the execution task,
@@ -68,13 +195,831 @@ protected:
   /// deallocated at a later time.
   std::vector<std::size_t> deferredDeallocation;
 
+  /// @brief The largest number of qubits a fused gate may act on. Zero
+  /// disables gate fusion, see enableGateFusion().
+  std::size_t maxFusedQubits = 0;
+
+  /// @brief The qubits the pending fused gate acts on. Bit `j` of the fused
+  /// matrix row / column index corresponds to `fusedQubits[j]`.
+  std::vector<std::size_t> fusedQubits;
+
+  /// @brief The pending fused gate as a dense, row major matrix.
+  std::vector<std::complex<double>> fusedMatrix;
+
+  /// @brief The number of gates multiplied into the pending fused gate.
+  std::size_t nFusedGates = 0;
+
+  /// @brief Random number generator for sampling noise trajectories.
+  std::mt19937 trajectoryRandomEngine{std::random_device{}()};
+
+  /// @brief A gate as seen by skipPrefixGate().
+  struct PrefixGate {
+    std::string name;
+    std::vector<double> parameters;
+    std::vector<std::size_t> controls;
+    std::vector<std::size_t> targets;
+
+    bool operator==(const PrefixGate &other) const {
+      return name == other.name && parameters == other.parameters &&
+             controls == other.controls && targets == other.targets;
+    }
+  };
+
+  /// @brief What skipPrefixGate() does with the gates of the current shot.
+  enum class PrefixCacheMode {
+    /// Gates are applied as usual.
+    Off,
+    /// Gates are applied and recorded as the prefix of the kernel.
+    Recording,
+    /// Gates matching the recorded prefix are skipped, the state at the end
+    /// of the prefix is restored from the snapshot instead.
+    Matching
+  };
+  PrefixCacheMode prefixCacheMode = PrefixCacheMode::Off;
+
+  /// @brief The gates applied before the state was first read (typically the
+  /// first mid-circuit measurement) in a shot of a kernel with conditionals
+  /// on measure results.
+  std::vector<PrefixGate> prefixGates;
+
+  /// @brief The number of prefix gates matched so far in the current shot.
+  std::size_t prefixPosition = 0;
+
+  /// @brief True if the subtype holds a snapshot of the state at the end of
+  /// the prefix.
+  bool hasPrefixSnapshot = false;
+
+  /// @brief The execution context the prefix was recorded for.
+  const cudaq::ExecutionContext *prefixContext = nullptr;
+
+  /// @brief The gates and the number of qubits of one kernel execution of a
+  /// batched observation.
+  struct BatchElement {
+    std::vector<PrefixGate> gates;
+    std::size_t nQubits = 0;
+  };
+
+  /// @brief The kernel executions of the current batched observation.
+  std::vector<BatchElement> batchElements;
+
+  /// @brief True while the gates of the current kernel execution are
+  /// recorded into batchElements rather than applied.
+  bool recordingBatch = false;
+
+  /// @brief True while the gates seen by skipPrefixGate() are appended to
+  /// capturedCircuit, see beginCapture().
+  bool capturing = false;
+
+  /// @brief True while captured gates are only recorded, not applied, see
+  /// beginGateRecording().
+  bool captureOnly = false;
+
+  /// @brief The circuit being captured.
+  CapturedCircuit capturedCircuit;
+
+  /// @brief The controls of the instruction being replayed.
+  std::vector<std::size_t> replayControls;
+
   /// Return the current multi-qubit state dimension
   std::size_t calculateStateDim(const int n_qubits) { return 1ULL << n_qubits; }
 
+  /// @brief Return the memory of the simulated state in bytes. The default
+  /// is that of a state vector of stateDimension double precision
+  /// amplitudes.
+  virtual std::size_t getStateBytes() {
+    return stateDimension * sizeof(std::complex<double>);
+  }
+
+  /// @brief Return the bytes of a state vector of `numQubits` qubits with
+  /// amplitudes of `amplitudeBytes` bytes, saturating at the largest
+  /// std::size_t.
+  static std::size_t stateVectorBytes(std::size_t numQubits,
+                                      std::size_t amplitudeBytes) {
+    constexpr auto max = std::numeric_limits<std::size_t>::max();
+    if (numQubits >= std::numeric_limits<std::size_t>::digits)
+      return max;
+    const std::size_t dimension = std::size_t{1} << numQubits;
+    return dimension > max / amplitudeBytes ? max : dimension * amplitudeBytes;
+  }
+
+  /// @brief States needing fewer bytes are not checked by checkStateFits().
+  static constexpr std::size_t minCheckedStateBytes = 1ULL << 26;
+
+  /// @brief Return the free memory in bytes the state can grow into. The
+  /// default is the available host memory, as reported by /proc/meminfo, or
+  /// else the physical memory.
+  virtual std::size_t getFreeMemory() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    std::size_t kiloBytes;
+    while (meminfo >> key >> kiloBytes) {
+      if (key == "MemAvailable:")
+        return kiloBytes * 1024;
+      meminfo.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    const long pages = sysconf(_SC_PHYS_PAGES);
+    const long pageSize = sysconf(_SC_PAGE_SIZE);
+    if (pages <= 0 || pageSize <= 0)
+      return std::numeric_limits<std::size_t>::max();
+    return static_cast<std::size_t>(pages) * pageSize;
+  }
+
+  /// @brief Count a gate applied to the state, in a pass over the state of
+  /// its own, in the performance counters of the execution context.
+  void countAppliedGate() {
+    if (!executionContext)
+      return;
+    executionContext->counters.gates++;
+    executionContext->counters.state_sweeps++;
+  }
+
+  /// @brief Record the current size of the state in the peak state size of
+  /// the execution context.
+  void countStateBytes() {
+    if (!executionContext)
+      return;
+    auto &peak = executionContext->counters.peak_state_bytes;
+    peak = std::max(peak, getStateBytes());
+  }
+
+  /// @brief Turn on gate fusion for this simulator. The maximum fused gate
+  /// width is read from the CUDAQ_FUSION_MAX_QUBITS environment variable,
+  /// gate fusion stays disabled if it is unset or zero. Subtypes calling this
+  /// must implement applyDenseMatrix() and route their gates through
+  /// fuseGate().
+  void enableGateFusion() {
+    if (auto *maxQubits = std::getenv("CUDAQ_FUSION_MAX_QUBITS"))
+      maxFusedQubits = std::strtoul(maxQubits, nullptr, 10);
+    if (maxFusedQubits > maxSupportedFusedQubits) {
+      cudaq::info("Gate fusion width {} too large, using {}.", maxFusedQubits,
+                  maxSupportedFusedQubits);
+      maxFusedQubits = maxSupportedFusedQubits;
+    }
+    if (maxFusedQubits)
+      cudaq::info("Gate fusion enabled for up to {} qubits.", maxFusedQubits);
+  }
+
+  /// @brief Return true if gates should be handed to fuseGate(). Gates are
+  /// never fused under a noise model, since noise acts between them.
+  bool isGateFusionEnabled() const {
+    return maxFusedQubits > 0 &&
+           !(executionContext && executionContext->noiseModel);
+  }
+
+  /// @brief Apply the dense, row major `matrix` to the `targets`. Bit `j` of
+  /// the matrix row / column index corresponds to `targets[j]`. Subtypes that
+  /// enable gate fusion or trajectory noise must implement this.
+  virtual void applyDenseMatrix(const std::vector<std::complex<double>> &matrix,
+                                const std::vector<std::size_t> &targets) {
+    throw std::runtime_error(
+        "The current backend does not support dense matrix application.");
+  }
+
+  /// @brief Return true if this CircuitSimulator applies a qubit permutation
+  /// at once, see applyQubitPermutation().
+  virtual bool canPermuteQubits() { return false; }
+
+  /// @brief Move the state of `qubits[i]` to `qubits[permutation[i]]`, for
+  /// every i, in a single step (e.g. one pass over the state, or relabeling
+  /// the qubits). Subtypes for which canPermuteQubits() is true implement
+  /// this.
+  virtual void
+  applyQubitPermutation(const std::vector<std::size_t> &qubits,
+                        const std::vector<std::size_t> &permutation) {
+    throw std::runtime_error(
+        "The current backend does not support qubit permutations.");
+  }
+
+  /// @brief Return true if this CircuitSimulator writes a product state at
+  /// once, see applyProductState().
+  virtual bool canPrepareProductState() { return false; }
+
+  /// @brief Put each of the `qubits`, which are all in |0>, in the state
+  /// `state[0] |0> + state[1] |1>`, in a single step. Subtypes for which
+  /// canPrepareProductState() is true implement this.
+  virtual void
+  applyProductState(const std::array<std::complex<double>, 2> &state,
+                    const std::vector<std::size_t> &qubits) {
+    throw std::runtime_error(
+        "The current backend does not support product state preparation.");
+  }
+
+  /// @brief Return true if this CircuitSimulator writes the amplitudes of a
+  /// state initialization on the `qubits` at once, see
+  /// applyStateInitialization().
+  virtual bool canInitializeState(const std::vector<std::size_t> &qubits) {
+    return false;
+  }
+
+  /// @brief Put the `qubits`, which are all in |0>, in the state with the
+  /// 2^n `amplitudes` in a single step, bit j of the amplitude index being
+  /// the value of `qubits[j]`. Subtypes for which canInitializeState() is
+  /// true implement this.
+  virtual void
+  applyStateInitialization(const std::vector<std::size_t> &qubits,
+                           const std::complex<double> *amplitudes) {
+    throw std::runtime_error(
+        "The current backend does not support state initialization.");
+  }
+
+  /// @brief Return <psi| M |psi> for the dense, row major, Hermitian `matrix`
+  /// M acting on the `targets`, with the same ordering as applyDenseMatrix().
+  /// Subtypes that support trajectory noise must implement this.
+  virtual double
+  expectationOfDenseMatrix(const std::vector<std::complex<double>> &matrix,
+                           const std::vector<std::size_t> &targets) {
+    throw std::runtime_error(
+        "The current backend does not support dense matrix expectations.");
+  }
+
+  /// @brief Return true if this CircuitSimulator simulates noise models with
+  /// quantum trajectories. Such subtypes call applyNoiseTrajectory() after
+  /// every gate.
+  virtual bool canHandleTrajectoryNoise() { return false; }
+
+  /// @brief Return the bit read out for the qubit measured in state `bit`,
+  /// flipped with the probability given by the readout error of the qubit in
+  /// the noise model, if any.
+  bool readOut(const std::size_t qubitIdx, const bool bit) {
+    if (!executionContext || !executionContext->noiseModel)
+      return bit;
+    const auto *matrix =
+        executionContext->noiseModel->get_readout_error(qubitIdx);
+    if (!matrix)
+      return bit;
+    std::uniform_real_distribution<double> distr(0.0, 1.0);
+    return distr(trajectoryRandomEngine) < (*matrix)[2 * bit + 1];
+  }
+
+  /// @brief Apply the readout errors of the noise model to every shot of
+  /// the sampled result, bit j of which measures qubitIdxs[j]. The shots
+  /// keep their order.
+  void applyReadoutErrors(cudaq::ExecutionResult &result,
+                          const std::vector<std::size_t> &qubitIdxs) {
+    if (!executionContext || !executionContext->noiseModel ||
+        !executionContext->noiseModel->has_readout_errors())
+      return;
+    result.materializeCounts();
+    auto shots = std::move(result.sequentialData);
+    if (shots.size() != result.totalCount()) {
+      shots.clear();
+      for (auto &[bits, count] : result.counts)
+        shots.insert(shots.end(), count, bits);
+    }
+    cudaq::CountsDictionary counts;
+    for (auto &bits : shots) {
+      for (std::size_t j = 0; j < bits.size() && j < qubitIdxs.size(); j++)
+        bits[j] = readOut(qubitIdxs[j], bits[j] == '1') ? '1' : '0';
+      counts[bits]++;
+    }
+    cudaq::ExecutionResult noisy(std::move(counts), result.registerName);
+    noisy.sequentialData = std::move(shots);
+    result = std::move(noisy);
+  }
+
+  /// @brief Apply the noise channels registered for the gate on the given
+  /// qubits as one step of a quantum trajectory. For each channel a single
+  /// Kraus operator K_i is chosen with probability p_i = <psi|K_i^dag K_i|psi>
+  /// and the state becomes K_i |psi> / sqrt(p_i).
+  void applyNoiseTrajectory(const std::string_view gateName,
+                            const std::vector<std::size_t> &qubits) {
+    if (!executionContext || !executionContext->noiseModel)
+      return;
+
+    auto krausChannels = executionContext->noiseModel->get_channels(
+        std::string(gateName), qubits);
+    if (krausChannels.empty())
+      return;
+    if (capturing)
+      capturedCircuit.replayable = false;
+
+    // Kraus op data follow the density matrix simulator convention: column
+    // major, with qubits[0] the most significant bit of the matrix index.
+    const std::vector<std::size_t> targets(qubits.rbegin(), qubits.rend());
+    const std::size_t dim = 1ULL << qubits.size();
+    std::uniform_real_distribution<double> distr(0.0, 1.0);
+    for (auto &channel : krausChannels) {
+      const auto &ops = channel.get_ops();
+      const double r = distr(trajectoryRandomEngine);
+      double cumulative = 0.0, chosenProbability = 0.0,
+             fallbackProbability = 0.0;
+      std::vector<std::complex<double>> chosen, fallback;
+      for (std::size_t i = 0; i < ops.size(); i++) {
+        std::vector<std::complex<double>> K(dim * dim), KdagK(dim * dim, 0.0);
+        for (std::size_t a = 0; a < dim; a++)
+          for (std::size_t c = 0; c < dim; c++)
+            K[a * dim + c] = ops[i].data[a + c * dim];
+        for (std::size_t a = 0; a < dim; a++)
+          for (std::size_t c = 0; c < dim; c++)
+            for (std::size_t b = 0; b < dim; b++)
+              KdagK[a * dim + c] += std::conj(K[b * dim + a]) * K[b * dim + c];
+
+        const double probability =
+            ops.size() == 1 ? 1.0 : expectationOfDenseMatrix(KdagK, targets);
+        cumulative += probability;
+        if (r < cumulative) {
+          cudaq::info("Trajectory picked kraus_op {} of {} for {} on {}", i,
+                      ops.size(), gateName, qubits);
+          chosen = std::move(K);
+          chosenProbability = probability;
+          break;
+        }
+        // Rounding may leave r above the total, then keep the likeliest op.
+        if (probability > fallbackProbability) {
+          fallback = std::move(K);
+          fallbackProbability = probability;
+        }
+      }
+
+      if (chosen.empty()) {
+        chosen = std::move(fallback);
+        chosenProbability = fallbackProbability;
+      }
+      if (chosen.empty())
+        continue;
+      const double scale = 1.0 / std::sqrt(chosenProbability);
+      for (auto &element : chosen)
+        element *= scale;
+      applyDenseMatrix(chosen, targets);
+    }
+  }
+
+  /// @brief Multiply the (optionally controlled) gate into the pending fused
+  /// gate. The row major `matrix` acts on the `targets`, with bit `j` of its
+  /// index corresponding to `targets[j]`. If the gate does not fit in the
+  /// fusion window the pending fused gate is applied first and a new one is
+  /// started. Returns false, after flushing, if the gate on its own is wider
+  /// than the fusion window, in which case the caller applies it directly.
+  bool fuseGate(const std::vector<std::complex<double>> &matrix,
+                const std::vector<std::size_t> &controls,
+                const std::vector<std::size_t> &targets) {
+    std::vector<std::size_t> gateQubits(targets);
+    gateQubits.insert(gateQubits.end(), controls.begin(), controls.end());
+    if (gateQubits.size() > maxFusedQubits) {
+      flushFusedGate();
+      return false;
+    }
+
+    // Build the full matrix of the controlled gate, the targets are the low
+    // bits and the controls the high bits of its index.
+    const std::size_t targetDim = 1ULL << targets.size();
+    const std::size_t gateDim = 1ULL << gateQubits.size();
+    const std::size_t activeBlock = gateDim - targetDim;
+    std::vector<std::complex<double>> gate(gateDim * gateDim, 0.0);
+    for (std::size_t i = 0; i < activeBlock; i++)
+      gate[i * gateDim + i] = 1.0;
+    for (std::size_t r = 0; r < targetDim; r++)
+      for (std::size_t c = 0; c < targetDim; c++)
+        gate[(activeBlock + r) * gateDim + activeBlock + c] =
+            matrix[r * targetDim + c];
+
+    std::vector<std::size_t> merged(fusedQubits);
+    for (auto q : gateQubits)
+      if (std::find(merged.begin(), merged.end(), q) == merged.end())
+        merged.push_back(q);
+
+    if (merged.size() > maxFusedQubits) {
+      flushFusedGate();
+      merged = gateQubits;
+    }
+
+    auto expandedGate = embedMatrix(gate, gateQubits, merged);
+    if (fusedQubits.empty()) {
+      fusedMatrix = std::move(expandedGate);
+    } else {
+      auto expandedFused = embedMatrix(fusedMatrix, fusedQubits, merged);
+      const std::size_t dim = 1ULL << merged.size();
+      fusedMatrix.assign(dim * dim, 0.0);
+      for (std::size_t r = 0; r < dim; r++)
+        for (std::size_t k = 0; k < dim; k++) {
+          const auto g = expandedGate[r * dim + k];
+          if (g == 0.0)
+            continue;
+          for (std::size_t c = 0; c < dim; c++)
+            fusedMatrix[r * dim + c] += g * expandedFused[k * dim + c];
+        }
+    }
+    fusedQubits = std::move(merged);
+    nFusedGates++;
+    // The gate is applied in the pass of the fused gate.
+    if (executionContext && executionContext->counters.state_sweeps)
+      executionContext->counters.state_sweeps--;
+    return true;
+  }
+
+  /// @brief Return true if this CircuitSimulator can snapshot its state, see
+  /// saveStateSnapshot(). Such subtypes route their gates through
+  /// skipPrefixGate().
+  virtual bool canSnapshotState() { return false; }
+
+  /// @brief Keep a copy of the current state, replacing any previous one.
+  /// Return false if the copy cannot be made (e.g. out of memory).
+  virtual bool saveStateSnapshot() { return false; }
+
+  /// @brief Replace the current state with the snapshot. Return false, leaving
+  /// the state untouched, if the snapshot does not fit the current state.
+  virtual bool restoreStateSnapshot() { return false; }
+
+  /// @brief Release the snapshot.
+  virtual void clearStateSnapshot() {}
+
+  /// @brief Return true if this CircuitSimulator can compute adjoint
+  /// gradients, see computeAdjointGradient(). Such subtypes capture their
+  /// gates and implement the auxiliary state methods below.
+  virtual bool canComputeAdjointGradient() { return false; }
+
+  /// @brief Set the auxiliary state `slot` to `coefficient` times the state.
+  virtual void copyStateToAuxiliary(std::size_t slot,
+                                    std::complex<double> coefficient = 1.0) {
+    throw std::runtime_error(
+        "The current backend does not support auxiliary states.");
+  }
+
+  /// @brief Add `coefficient` times the state to the auxiliary state `slot`.
+  virtual void addStateToAuxiliary(std::size_t slot,
+                                   std::complex<double> coefficient) {
+    throw std::runtime_error(
+        "The current backend does not support auxiliary states.");
+  }
+
+  /// @brief Replace the state with a copy of the auxiliary state `slot`.
+  virtual void copyAuxiliaryToState(std::size_t slot) {
+    throw std::runtime_error(
+        "The current backend does not support auxiliary states.");
+  }
+
+  /// @brief Exchange the state and the auxiliary state `slot`, so that gates
+  /// apply to the latter.
+  virtual void swapStateWithAuxiliary(std::size_t slot) {
+    throw std::runtime_error(
+        "The current backend does not support auxiliary states.");
+  }
+
+  /// @brief Return <a|psi> for the auxiliary state a in `slot`.
+  virtual std::complex<double> overlapWithAuxiliary(std::size_t slot) {
+    throw std::runtime_error(
+        "The current backend does not support auxiliary states.");
+  }
+
+  /// @brief Release the auxiliary states.
+  virtual void clearAuxiliaryStates() {}
+
+  /// @brief Return true if this CircuitSimulator implements
+  /// copyStateToAuxiliary() and overlapWithAuxiliary(), for density matrices
+  /// as well if it simulates them. The "overlap" context then keeps the
+  /// first state where the simulator holds it, e.g. on the GPU, rather than
+  /// copying it to the host.
+  virtual bool canComputeOverlap() { return canComputeAdjointGradient(); }
+
+  /// @brief The auxiliary state of the first state under the "overlap"
+  /// context, or the host copy of it if the subtype cannot compute overlaps,
+  /// and its dimension.
+  static constexpr std::size_t overlapSlot = 0;
+  std::vector<std::complex<double>> overlapHostState;
+  std::size_t overlapDimension = 0;
+
+  /// @brief Under the "overlap" context, keep the state of the first kernel
+  /// and set the overlap of the state of the second kernel with it in the
+  /// context. The overlap is left unset if the states differ in size.
+  void computeOverlap() {
+    auto &context = *executionContext;
+    const bool onSimulator = canComputeOverlap();
+    if (!context.overlapPrepared) {
+      if (onSimulator)
+        copyStateToAuxiliary(overlapSlot);
+      else
+        overlapHostState = std::get<1>(getSimulationState()->toState());
+      overlapDimension = stateDimension;
+      context.overlapPrepared = true;
+      return;
+    }
+
+    if (stateDimension == overlapDimension) {
+      if (onSimulator) {
+        context.overlap = overlapWithAuxiliary(overlapSlot);
+      } else {
+        auto [shape, data] = getSimulationState()->toState();
+        if (data.size() == overlapHostState.size()) {
+          std::complex<double> sum = 0.0;
+          for (std::size_t i = 0; i < data.size(); i++)
+            sum += std::conj(overlapHostState[i]) * data[i];
+          context.overlap = sum;
+        }
+      }
+    }
+    clearAuxiliaryStates();
+    overlapHostState = {};
+    context.overlapPrepared = false;
+  }
+
+  /// @brief Drop the recorded prefix and its snapshot.
+  void clearPrefixCache() {
+    if (hasPrefixSnapshot)
+      clearStateSnapshot();
+    hasPrefixSnapshot = false;
+    prefixGates.clear();
+    prefixContext = nullptr;
+    prefixCacheMode = PrefixCacheMode::Off;
+  }
+
+  /// @brief Start a new shot of a kernel with conditionals on measure results.
+  /// Every shot re-executes the kernel from |0>, but the gates up to the
+  /// first mid-circuit measurement are typically the same in every shot. The
+  /// first shot records them and snapshots the state before its first
+  /// measurement, later shots skip the matching gates and restore the
+  /// snapshot.
+  void beginPrefixCache() {
+    const bool cacheable = executionContext->name == "sample" &&
+                           executionContext->hasConditionalsOnMeasureResults &&
+                           !executionContext->hasNoiseTrajectories &&
+                           canSnapshotState();
+    if (!cacheable || executionContext != prefixContext)
+      clearPrefixCache();
+    if (!cacheable)
+      return;
+
+    prefixContext = executionContext;
+    prefixPosition = 0;
+    if (hasPrefixSnapshot) {
+      prefixCacheMode = PrefixCacheMode::Matching;
+    } else {
+      prefixGates.clear();
+      prefixCacheMode = PrefixCacheMode::Recording;
+    }
+  }
+
+  /// @brief Hand a gate to the prefix cache, subtypes that can snapshot their
+  /// state call this on entry of every gate. Return true if the gate is part
+  /// of the cached prefix, in which case the caller must not apply it.
+  bool skipPrefixGate(const std::string_view gateName,
+                      const std::vector<double> &parameters,
+                      const std::vector<std::size_t> &controls,
+                      const std::vector<std::size_t> &targets) {
+    if (capturing) {
+      captureGate(gateName, parameters, controls, targets);
+      if (captureOnly)
+        return true;
+    }
+    if (recordingBatch) {
+      batchElements.back().gates.push_back(
+          {std::string(gateName), parameters, controls, targets});
+      return true;
+    }
+    if (prefixCacheMode == PrefixCacheMode::Off) {
+      countAppliedGate();
+      return false;
+    }
+
+    PrefixGate gate{std::string(gateName), parameters, controls, targets};
+    if (prefixCacheMode == PrefixCacheMode::Recording) {
+      prefixGates.push_back(std::move(gate));
+      countAppliedGate();
+      return false;
+    }
+
+    if (prefixPosition < prefixGates.size() &&
+        prefixGates[prefixPosition] == gate) {
+      prefixPosition++;
+      return true;
+    }
+
+    // This shot left the cached prefix, catch up before applying the gate.
+    endPrefix();
+    countAppliedGate();
+    return false;
+  }
+
+  /// @brief End the prefix of the current shot. When recording, snapshot the
+  /// state. When matching, restore the snapshot if the whole prefix was
+  /// matched, and otherwise replay the matched gates.
+  void endPrefix() {
+    const auto mode = prefixCacheMode;
+    prefixCacheMode = PrefixCacheMode::Off;
+    if (mode == PrefixCacheMode::Recording) {
+      flushFusedGate();
+      hasPrefixSnapshot = saveStateSnapshot();
+      if (hasPrefixSnapshot)
+        cudaq::info("Cached the state after a prefix of {} gates.",
+                    prefixGates.size());
+      else
+        prefixGates.clear();
+      return;
+    }
+
+    if (mode != PrefixCacheMode::Matching)
+      return;
+    if (prefixPosition == prefixGates.size() && restoreStateSnapshot()) {
+      cudaq::info("Restored the cached state after a prefix of {} gates.",
+                  prefixGates.size());
+      return;
+    }
+    cudaq::info("Replaying {} of {} cached prefix gates.", prefixPosition,
+                prefixGates.size());
+    // These gates were captured when they were first seen.
+    const bool wasCapturing = capturing;
+    capturing = false;
+    for (std::size_t i = 0; i < prefixPosition; i++)
+      applyPrefixGate(prefixGates[i]);
+    capturing = wasCapturing;
+  }
+
+  /// @brief Apply the recorded gate through the gate methods.
+  void applyPrefixGate(const PrefixGate &gate) {
+    auto captured = getCapturedGate(gate.name);
+    if (!captured)
+      throw std::runtime_error("Cannot replay unknown gate " + gate.name +
+                               ".");
+    applyCapturedGate(*captured, gate.parameters.data(), gate.controls,
+                      gate.targets.data());
+  }
+
+  /// @brief Apply the gate through the gate methods.
+  void applyCapturedGate(CapturedGate gate, const double *params,
+                         const std::vector<std::size_t> &controls,
+                         const std::size_t *targets) {
+    const auto target = targets[0];
+    switch (gate) {
+    case CapturedGate::x:
+      return x(controls, target);
+    case CapturedGate::y:
+      return y(controls, target);
+    case CapturedGate::z:
+      return z(controls, target);
+    case CapturedGate::h:
+      return h(controls, target);
+    case CapturedGate::s:
+      return s(controls, target);
+    case CapturedGate::t:
+      return t(controls, target);
+    case CapturedGate::sdg:
+      return sdg(controls, target);
+    case CapturedGate::tdg:
+      return tdg(controls, target);
+    case CapturedGate::rx:
+      return rx(params[0], controls, target);
+    case CapturedGate::ry:
+      return ry(params[0], controls, target);
+    case CapturedGate::rz:
+      return rz(params[0], controls, target);
+    case CapturedGate::r1:
+      return r1(params[0], controls, target);
+    case CapturedGate::u1:
+      return u1(params[0], controls, target);
+    case CapturedGate::u2:
+      return u2(params[0], params[1], controls, target);
+    case CapturedGate::u3:
+      return u3(params[0], params[1], params[2], controls, target);
+    case CapturedGate::swap:
+      return swap(controls, target, targets[1]);
+    }
+  }
+
+  /// @brief Append the gate to the captured circuit.
+  void captureGate(const std::string_view gateName,
+                   const std::vector<double> &parameters,
+                   const std::vector<std::size_t> &controls,
+                   const std::vector<std::size_t> &targets) {
+    auto gate = getCapturedGate(gateName);
+    if (!gate || controls.size() > UINT16_MAX) {
+      capturedCircuit.replayable = false;
+      return;
+    }
+    auto &circuit = capturedCircuit;
+    circuit.instructions.push_back(
+        {*gate, static_cast<std::uint8_t>(parameters.size()),
+         static_cast<std::uint16_t>(controls.size()),
+         static_cast<std::uint32_t>(circuit.qubits.size()),
+         static_cast<std::uint32_t>(circuit.parameters.size())});
+    circuit.qubits.insert(circuit.qubits.end(), controls.begin(),
+                          controls.end());
+    circuit.qubits.insert(circuit.qubits.end(), targets.begin(),
+                          targets.end());
+    circuit.parameters.insert(circuit.parameters.end(), parameters.begin(),
+                              parameters.end());
+  }
+
+  /// @brief Return true if this CircuitSimulator applies Pauli rotations in
+  /// one step, see applyPauliRotationImpl().
+  virtual bool canApplyPauliRotation() { return false; }
+
+  /// @brief Apply exp(-i angle / 2 P) for the Pauli word P with paulis[j] on
+  /// qubits[j]. Subtypes that can apply a Pauli rotation must implement this.
+  virtual void applyPauliRotationImpl(double angle,
+                                      const std::vector<std::size_t> &qubits,
+                                      const std::vector<cudaq::pauli> &paulis) {
+    throw std::runtime_error(
+        "The current backend does not support Pauli rotations.");
+  }
+
+  /// @brief Return true if this CircuitSimulator applies a layer of Z-only
+  /// rotations in one step, see applyDiagonalPhasesImpl().
+  virtual bool canApplyDiagonalPhases() { return false; }
+
+  /// @brief Apply the product of the commuting, diagonal `rotations`, i.e.
+  /// multiply each basis state by the phase given by the parities of its bits
+  /// on the qubits of each rotation. Subtypes that can apply diagonal phases
+  /// must implement this.
+  virtual void
+  applyDiagonalPhasesImpl(const std::vector<ZRotation> &rotations) {
+    throw std::runtime_error(
+        "The current backend does not support diagonal phase layers.");
+  }
+
+  /// @brief Return true if this CircuitSimulator can observe all kernel
+  /// executions of a batch at once, see observeBatch(). Such subtypes route
+  /// their gates through skipPrefixGate() and hand observe() calls to
+  /// observeRecordedBatch() while recordingBatch is set.
+  virtual bool canObserveBatch() { return false; }
+
+  /// @brief Return the result of observing `H` after each of the recorded
+  /// kernel executions, all starting from |0>.
+  virtual std::vector<cudaq::ExecutionResult>
+  observeBatch(const std::vector<BatchElement> &batch,
+               const cudaq::spin_op &H) {
+    throw std::runtime_error(
+        "The current backend does not support batched observation.");
+  }
+
+  /// @brief Start recording the next kernel execution of a batched
+  /// observation, that is an observe context with a batchSize. Only exact
+  /// expectation values of noiseless executions are batched.
+  void beginObserveBatch() {
+    recordingBatch = executionContext->name == "observe" &&
+                     executionContext->batchSize > 1 &&
+                     !executionContext->noiseModel && canObserveBatch();
+    if (!recordingBatch) {
+      batchElements.clear();
+      return;
+    }
+    if (executionContext->batchIndex == 0) {
+      batchElements.clear();
+      executionContext->batchResults.clear();
+    }
+    batchElements.emplace_back();
+  }
+
+  /// @brief End the recorded kernel execution. Until the last one of the
+  /// batch this returns a placeholder, the last one observes the whole batch
+  /// and stores the results of all executions in the execution context.
+  cudaq::ExecutionResult observeRecordedBatch(const cudaq::spin_op &H) {
+    recordingBatch = false;
+    batchElements.back().nQubits = nQubitsAllocated;
+    if (executionContext->batchIndex + 1 < executionContext->batchSize)
+      return cudaq::ExecutionResult{0.0};
+
+    cudaq::info("Observing a batch of {} kernel executions.",
+                batchElements.size());
+    auto batch = std::move(batchElements);
+    batchElements.clear();
+    executionContext->batchResults = observeBatch(batch, H);
+    return executionContext->batchResults.back();
+  }
+
+  /// @brief Bring the state up to date with all the gates seen so far, ending
+  /// a cached prefix and applying the pending fused gate. Subtypes must call
+  /// this before they read or collapse the state (measureQubit(),
+  /// resetQubit(), sample(), getStateData()).
+  void synchronizeState() {
+    if (recordingBatch)
+      throw std::runtime_error("Batched observation does not support kernels "
+                               "that measure or reset qubits.");
+    if (capturing)
+      capturedCircuit.replayable = false;
+    if (prefixCacheMode != PrefixCacheMode::Off)
+      endPrefix();
+    flushFusedGate();
+  }
+
+  /// @brief Apply the pending fused gate, if any, to the state. Subtypes call
+  /// synchronizeState() rather than this before they read the state.
+  void flushFusedGate() {
+    if (fusedQubits.empty())
+      return;
+    cudaq::info("Applying fused gate of {} gates on qubits {}", nFusedGates,
+                fusedQubits);
+    // Clear first, so a subtype calling back into the gate methods from
+    // applyDenseMatrix does not re-enter.
+    auto qubits = std::move(fusedQubits);
+    auto matrix = std::move(fusedMatrix);
+    fusedQubits.clear();
+    fusedMatrix.clear();
+    nFusedGates = 0;
+    if (executionContext)
+      executionContext->counters.state_sweeps++;
+    applyDenseMatrix(matrix, qubits);
+  }
+
   /// Add a new qubit to the state representation.
   /// This is subclass specific.
   virtual void addQubitToState() = 0;
 
+  /// @brief Remove the deallocated qubit, which was reset to |0>, from the
+  /// state representation, halving it. Subtypes only support this for some
+  /// qubits (e.g. the last one of the state) and return false otherwise.
+  virtual bool removeQubitFromState(const std::size_t qubitIdx) {
+    return false;
+  }
+
   /// Reset the qubit state back to dim = 0.
   void resetQubitState() {
     this->resetQubitStateImpl();
@@ -94,15 +1039,136 @@ protected:
   /// left as a task for concrete subtypes.
   virtual bool measureQubit(const std::size_t qubitIdx) = 0;
 
+  /// @brief Measure the qubits, collapsing the state, and return their bits
+  /// in order. Subtypes that measure several qubits at once override this,
+  /// the default measures them one after the other.
+  virtual std::vector<bool>
+  measureQubits(const std::vector<std::size_t> &qubitIdxs) {
+    std::vector<bool> bits;
+    bits.reserve(qubitIdxs.size());
+    for (auto qubitIdx : qubitIdxs)
+      bits.push_back(measureQubit(qubitIdx));
+    return bits;
+  }
+
+  /// @brief The largest number of qubits measured jointly from their
+  /// marginal probabilities, larger registers are measured qubit by qubit.
+  static constexpr std::size_t maxJointMeasureQubits = 12;
+
+  /// @brief Draw an outcome from the (unnormalized) `probabilities`, given a
+  /// uniform random number in [0, 1).
+  static std::size_t drawOutcome(const std::vector<double> &probabilities,
+                                 double random) {
+    double total = 0.0;
+    for (auto p : probabilities)
+      total += p;
+    double threshold = random * total;
+    std::size_t outcome = 0;
+    for (std::size_t i = 0; i < probabilities.size(); i++) {
+      if (probabilities[i] <= 0.0)
+        continue;
+      // Keep the last possible outcome in case of rounding.
+      outcome = i;
+      if (threshold < probabilities[i])
+        break;
+      threshold -= probabilities[i];
+    }
+    return outcome;
+  }
+
   /// @brief Return true if this CircuitSimulator can
   /// handle <psi | H | psi> instead of NVQIR applying measure
   /// basis quantum gates to change to the Z basis and sample.
   virtual bool canHandleObserve() { return false; }
 
+  /// @brief Return true if the current execution observes a spin_op with
+  /// exact expectation values rather than sampling each of its terms.
+  bool isExactObservation() const {
+    return executionContext && executionContext->name == "observe" &&
+           static_cast<int>(executionContext->shots) < 1;
+  }
+
+  /// @brief Return the amplitudes of the basis states of the given indices,
+  /// valid indices into the state vector, or nothing for density matrices.
+  /// Subtypes override this if the state handle of getSimulationState()
+  /// copies the state.
+  virtual std::vector<std::complex<double>>
+  getAmplitudes(const std::vector<std::size_t> &indices) {
+    auto handle = getSimulationState();
+    if (handle->getShape().size() != 1)
+      return {};
+    std::vector<std::complex<double>> amplitudes;
+    amplitudes.reserve(indices.size());
+    for (auto index : indices)
+      amplitudes.push_back(handle->getElement(index));
+    return amplitudes;
+  }
+
+  /// @brief Return the marginal probabilities of the 2^n outcomes of the n
+  /// given qubits, allocated and distinct, with bit j of an outcome the
+  /// value of qubits[j]. Return nothing if the subtype cannot compute them.
+  virtual std::vector<double>
+  getMarginalProbabilities(const std::vector<std::size_t> &qubits) {
+    return {};
+  }
+
+  /// @brief Answer the amplitude or probability query of the "amplitudes"
+  /// or "probabilities" context. Invalid queries are left unanswered.
+  void answerStateQuery() {
+    auto &context = *executionContext;
+    if (context.name == "amplitudes") {
+      if (std::all_of(context.amplitudeIndices.begin(),
+                      context.amplitudeIndices.end(),
+                      [&](std::size_t i) { return i < stateDimension; }))
+        context.amplitudes = getAmplitudes(context.amplitudeIndices);
+      return;
+    }
+
+    auto qubits = context.probabilityQubits;
+    std::sort(qubits.begin(), qubits.end());
+    if (!qubits.empty() && qubits.size() < 64 &&
+        std::adjacent_find(qubits.begin(), qubits.end()) == qubits.end() &&
+        std::all_of(qubits.begin(), qubits.end(), [&](std::size_t q) {
+          return q < nQubitsAllocated && !tracker.isAvailable(q);
+        }))
+      context.probabilities =
+          getMarginalProbabilities(context.probabilityQubits);
+  }
+
   /// @brief Return the internal state representation. This
   /// is meant for subtypes to override
   virtual cudaq::State getStateData() { return {}; }
 
+  /// @brief Return a handle referencing the internal state representation
+  /// without copying it. The handle is only valid until the next operation
+  /// on this simulator. Subtypes without a handle of their own return a copy
+  /// of getStateData().
+  virtual std::unique_ptr<cudaq::SimulationState> getSimulationState() {
+    return takeSimulationState();
+  }
+
+  /// @brief Move the internal state representation into the returned handle,
+  /// which then owns it. The state of this simulator is left unspecified, so
+  /// this must only be called before the state is reset. Subtypes without a
+  /// handle of their own return a copy of getStateData().
+  virtual std::unique_ptr<cudaq::SimulationState> takeSimulationState() {
+    auto [shape, data] = getStateData();
+    return std::make_unique<
+        cudaq::HostSimulationState<std::vector<std::complex<double>>>>(
+        std::move(shape), std::move(data));
+  }
+
+  /// @brief Return true if this CircuitSimulator implements setStateData(),
+  /// so that its state can be restored from a checkpoint.
+  virtual bool canRestoreState() { return false; }
+
+  /// @brief Replace the amplitudes of the state with the elements of `data`,
+  /// as many as the state has, in the flat order of cudaq::SimulationState.
+  virtual void setStateData(const std::complex<double> *data) {
+    throw std::runtime_error(
+        "The current backend does not support restoring states.");
+  }
+
   /// @brief Handle basic sampling tasks by storing the qubit index for
   /// processing in resetExecutionContext. Return true to indicate this is
   /// sampling and to exit early. False otherwise.
@@ -117,6 +1183,33 @@ protected:
     return false;
   }
 
+  /// @brief Append the sampled shots to the stream. A kernel executed once
+  /// per shot gives one record, its mid-circuit measurement results in order
+  /// followed by the sampled bits. Otherwise each sampled count becomes a
+  /// record, in random order.
+  void streamShots(cudaq::ShotStream &stream, cudaq::ExecutionResult &result) {
+    result.packCounts();
+    auto &counts = result.packedCounts;
+    if (midCircuitBits.empty()) {
+      stream.appendCounts(counts);
+      return;
+    }
+    for (std::size_t i = 0; i < counts.size(); i++) {
+      const auto nBits = midCircuitBits.size() + counts.n_bits();
+      std::vector<std::uint64_t> record(
+          std::max<std::size_t>((nBits + 63) / 64, 1), 0);
+      auto setBit = [&](std::size_t j) { record[j / 64] |= 1ULL << (j % 64); };
+      for (std::size_t j = 0; j < midCircuitBits.size(); j++)
+        if (midCircuitBits[j])
+          setBit(j);
+      for (std::size_t j = 0; j < counts.n_bits(); j++)
+        if (counts.bit(i, j))
+          setBit(midCircuitBits.size() + j);
+      for (std::size_t c = 0; c < counts.count(i); c++)
+        stream.append(record.data(), nBits);
+    }
+  }
+
   /// @brief This function handles sampling in the presence of conditional
   /// statements on qubit measurement results. Specifically, it will keep
   /// track of a classical register for all measures encountered in the program
@@ -137,20 +1230,20 @@ protected:
         return;
       }
 
-      // See if we've observed this register before, if not
-      // start a vector of bit results, if we have, add the
-      // bit result to the existing vector
-      auto iter = midCircuitSampleResults.find(registerName);
-      if (iter == midCircuitSampleResults.end())
-        midCircuitSampleResults.emplace(registerName,
-                                        std::vector<std::string>{bitResult});
-      else
-        iter->second.push_back(bitResult);
+      // Only log the bit, the register results are built from the log
+      // when they are read.
+      midCircuitBits.push_back(bitResult == "1");
+      auto [iter, inserted] = midCircuitRegisterIndex.try_emplace(
+          registerName, midCircuitRegisters.size());
+      if (inserted)
+        midCircuitRegisters.push_back({registerName, {}, false});
+      auto &reg = midCircuitRegisters[iter->second];
+      reg.bits.push_back(midCircuitBits.size() - 1);
 
       // If this register is the same as last time, then we are
       // writing to a bit vector register (auto var = mz(qreg))
       if (lastMidCircuitRegisterName == registerName)
-        vectorRegisters.push_back(registerName);
+        reg.isVector = true;
 
       // Store the last register name
       lastMidCircuitRegisterName = registerName;
@@ -193,10 +1286,146 @@ protected:
     return ret.str();
   }
 
+  /// @brief The widest fused gate supported, 2^10 x 2^10 matrices are
+  /// already far more expensive to build than the state sweeps they save.
+  static constexpr std::size_t maxSupportedFusedQubits = 10;
+
+  /// @brief Embed the row major `matrix` acting on the qubits `from` into the
+  /// larger space of qubits `into` (a superset of `from`), acting as the
+  /// identity on the additional qubits.
+  static std::vector<std::complex<double>>
+  embedMatrix(const std::vector<std::complex<double>> &matrix,
+              const std::vector<std::size_t> &from,
+              const std::vector<std::size_t> &into) {
+    if (from == into)
+      return matrix;
+
+    std::vector<std::size_t> positions;
+    std::size_t fromMask = 0;
+    for (auto q : from) {
+      auto pos = std::distance(into.begin(),
+                               std::find(into.begin(), into.end(), q));
+      positions.push_back(pos);
+      fromMask |= 1ULL << pos;
+    }
+    const auto gather = [&](std::size_t index) {
+      std::size_t local = 0;
+      for (std::size_t j = 0; j < positions.size(); j++)
+        local |= ((index >> positions[j]) & 1ULL) << j;
+      return local;
+    };
+
+    const std::size_t fromDim = 1ULL << from.size();
+    const std::size_t intoDim = 1ULL << into.size();
+    std::vector<std::complex<double>> result(intoDim * intoDim, 0.0);
+    for (std::size_t r = 0; r < intoDim; r++)
+      for (std::size_t c = 0; c < intoDim; c++)
+        if ((r & ~fromMask) == (c & ~fromMask))
+          result[r * intoDim + c] = matrix[gather(r) * fromDim + gather(c)];
+    return result;
+  }
+
 public:
   CircuitSimulator() = default;
   virtual ~CircuitSimulator() = default;
 
+  /// @brief Return the memory in bytes the state of `numQubits` qubits needs
+  /// on this backend, or 0 if it is not known from the number of qubits
+  /// alone. The default is that of a state vector of double precision
+  /// amplitudes, 16 * 2^n bytes.
+  virtual std::size_t getRequiredStateBytes(std::size_t numQubits) {
+    return stateVectorBytes(numQubits, sizeof(std::complex<double>));
+  }
+
+  /// @brief Return the memory in bytes available to the state: the value of
+  /// the CUDAQ_MEMORY_LIMIT environment variable if it is set, else the free
+  /// memory of the backend.
+  std::size_t getAvailableMemory() {
+    if (auto *limit = std::getenv("CUDAQ_MEMORY_LIMIT"))
+      return std::strtoull(limit, nullptr, 10);
+    return getFreeMemory();
+  }
+
+  /// @brief Return true if simulators of this type may run on several
+  /// threads at once, each with a simulator of its own, as the shots of a
+  /// per-shot sampling do. Backends sharing a device or a communicator
+  /// across their instances return false.
+  virtual bool canRunConcurrently() { return true; }
+
+  /// @brief Return the number of qubits currently allocated.
+  std::size_t getNumQubitsAllocated() const { return nQubitsAllocated; }
+
+  /// @brief Throw if the state of `numQubits` qubits does not fit into the
+  /// memory available to this backend. Called before qubits are allocated,
+  /// so that a kernel too large for the backend fails before any gate is
+  /// applied rather than deep inside the allocation of its state.
+  void checkStateFits(std::size_t numQubits) {
+    const auto required = getRequiredStateBytes(numQubits);
+    // Small states are not checked, so that their allocation does not query
+    // the free memory. The memory of the current state is reused as it grows.
+    if (required < minCheckedStateBytes || required <= getStateBytes())
+      return;
+    const auto available = getAvailableMemory();
+    if (required <= available)
+      return;
+    constexpr double GiB = 1024.0 * 1024.0 * 1024.0;
+    throw std::runtime_error(fmt::format(
+        "The {} backend needs {:.3g} GiB to simulate {} qubits, but only "
+        "{:.3g} GiB are available. Use a backend with a smaller footprint: "
+        "mps (memory linear in the number of qubits), custatevec-mgpu or "
+        "mpi (the state distributed over GPUs or nodes), or qpp-f32 (half "
+        "the memory).",
+        name(), required / GiB, numQubits, available / GiB));
+  }
+
+  /// @brief Write the state and the qubits in use to the checkpoint file at
+  /// `path`, compressing sparse states if `compress` is set. See
+  /// cudaq::writeStateCheckpoint().
+  void checkpoint(const std::string &path, bool compress = false) {
+    synchronizeState();
+    if (stateDimension == 0)
+      throw std::runtime_error("There is no state to checkpoint.");
+    auto state = getSimulationState();
+    const std::size_t numStateQubits = std::countr_zero(state->getShape()[0]);
+    std::vector<std::size_t> qubits;
+    for (std::size_t q = 0; q < numStateQubits; q++)
+      if (!tracker.isAvailable(q))
+        qubits.push_back(q);
+    cudaq::writeStateCheckpoint(path, *state, qubits, compress);
+  }
+
+  /// @brief Replace the state with the one of the checkpoint file at `path`.
+  /// If no qubits are allocated, the qubits in use at the checkpoint are
+  /// allocated, else the state must have the shape of the checkpoint.
+  void restore(const std::string &path) {
+    if (!canRestoreState())
+      throw std::runtime_error(
+          "The current backend does not support restoring states.");
+    cudaq::StateCheckpoint checkpoint(path);
+    synchronizeState();
+    clearPrefixCache();
+    const bool empty = tracker.numAvailable() == tracker.totalNumQudits();
+    const std::size_t numStateQubits = checkpoint.getNumQubits();
+    if (empty)
+      allocateQubits(numStateQubits);
+    if (getSimulationState()->getShape() != checkpoint.getShape()) {
+      if (empty)
+        for (std::size_t q = numStateQubits; q-- > 0;)
+          deallocate(q);
+      throw std::runtime_error("The state checkpoint " + path +
+                               " does not have the shape of the state.");
+    }
+    setStateData(checkpoint.data());
+    if (!empty)
+      return;
+    // Free the qubits of the state that were not in use, as deallocate()
+    // did before the checkpoint.
+    const auto &inUse = checkpoint.getQubits();
+    for (std::size_t q = numStateQubits; q-- > 0;)
+      if (std::find(inUse.begin(), inUse.end(), q) == inUse.end())
+        deallocate(q);
+  }
+
   virtual void setNoiseModel(cudaq::noise_model &noise) {
     // Fixme consider this as a warning instead of a hard error
     throw std::runtime_error(
@@ -210,6 +1439,59 @@ public:
                              "observe(const cudaq::spin_op &).");
   }
 
+  /// @brief Apply exp(-i angle / 2 P) for the Pauli word P with paulis[j] on
+  /// qubits[j] in one step, as Rz(angle) does for P = Z. Return false if the
+  /// caller has to decompose it into gates instead: if the subtype cannot
+  /// apply it, or if gates are recorded (prefix cache, capture or batched
+  /// observation) or subject to noise.
+  bool applyPauliRotation(double angle, const std::vector<std::size_t> &qubits,
+                          const std::vector<cudaq::pauli> &paulis) {
+    if (!canApplyPauliRotation() || capturing || recordingBatch ||
+        prefixCacheMode != PrefixCacheMode::Off ||
+        (executionContext && executionContext->noiseModel))
+      return false;
+    flushFusedGate();
+    countAppliedGate();
+    applyPauliRotationImpl(angle, qubits, paulis);
+    return true;
+  }
+
+  /// @brief Apply the product of the Z-only `rotations` in one step, instead
+  /// of one Pauli rotation (or CNOT ladder) each. Return false under the
+  /// same conditions as applyPauliRotation().
+  bool applyDiagonalPhases(const std::vector<ZRotation> &rotations) {
+    if (!canApplyDiagonalPhases() || capturing || recordingBatch ||
+        prefixCacheMode != PrefixCacheMode::Off ||
+        (executionContext && executionContext->noiseModel))
+      return false;
+    flushFusedGate();
+    countAppliedGate();
+    applyDiagonalPhasesImpl(rotations);
+    return true;
+  }
+
+  /// @brief Apply the dense, row major unitary `matrix` to the `targets`, with
+  /// the ordering of applyDenseMatrix(). This applies the gates fused at
+  /// compile time. Such a unitary is not a gate: it ends a cached prefix, the
+  /// kernel cannot be replayed or observed in a batch, and no noise is
+  /// applied with it.
+  void applyCustomUnitary(const std::vector<std::complex<double>> &matrix,
+                          const std::vector<std::size_t> &targets) {
+    if (recordingBatch)
+      throw std::runtime_error("Batched observation does not support kernels "
+                               "with custom unitaries.");
+    if (capturing) {
+      capturedCircuit.replayable = false;
+      if (captureOnly)
+        return;
+    }
+    if (prefixCacheMode != PrefixCacheMode::Off)
+      endPrefix();
+    flushFusedGate();
+    countAppliedGate();
+    applyDenseMatrix(matrix, targets);
+  }
+
   /// @brief Allocate a single qubit, return the qubit as a logical index
   /// @return qubit idx
   virtual std::size_t allocateQubit() {
@@ -226,6 +1508,7 @@ public:
 
     // Tell the subtype to grow the state representation
     addQubitToState();
+    countStateBytes();
 
     // return the new qubit index
     return newIdx;
@@ -253,6 +1536,8 @@ public:
 
     cudaq::info("Deallocating qubit {}", qubitIdx);
 
+    flushFusedGate();
+
     // Reset the qubit
     resetQubit(qubitIdx);
 
@@ -261,11 +1546,39 @@ public:
     --nQubitsAllocated;
 
     // Reset the state if we've deallocated all qubits.
-    if (tracker.numAvailable() == tracker.totalNumQubits()) {
+    if (tracker.numAvailable() == tracker.totalNumQudits()) {
       cudaq::info("Deallocated all qubits, reseting state vector.");
       // all qubits deallocated,
       resetQubitState();
+      return;
     }
+
+    // Otherwise shrink the state by this qubit and the deallocated qubits
+    // below it, as far as the subtype can remove them.
+    for (std::size_t q = qubitIdx + 1; q-- > 0 && tracker.isAvailable(q);) {
+      if (!removeQubitFromState(q))
+        break;
+      cudaq::info("Removed deallocated qubit {} from the state", q);
+    }
+  }
+
+  /// @brief The most sampled qubits whose distribution is kept for the
+  /// "sample" context, see ExecutionContext::keepDistribution.
+  static constexpr std::size_t maxDistributionQubits = 20;
+
+  /// @brief Set the distribution of the sampled outcomes if the context asks
+  /// for it and the final state alone determines it.
+  void setSampleDistribution() {
+    auto &context = *executionContext;
+    if (!context.keepDistribution || context.hasConditionalsOnMeasureResults ||
+        context.hasNoiseTrajectories || context.noiseModel ||
+        !midCircuitRegisters.empty() ||
+        sampleQubits.size() > maxDistributionQubits)
+      return;
+    auto qubits = sampleQubits;
+    std::sort(qubits.begin(), qubits.end());
+    if (std::adjacent_find(qubits.begin(), qubits.end()) == qubits.end())
+      context.distribution = getMarginalProbabilities(sampleQubits);
   }
 
   /// @brief Reset the current execution context.
@@ -274,6 +1587,11 @@ public:
     if (!executionContext)
       return;
 
+    recordingBatch = false;
+    endGateRecording();
+    synchronizeState();
+    countStateBytes();
+
     // Get the ExecutionContext name
     auto execContextName = executionContext->name;
 
@@ -290,57 +1608,85 @@ public:
 
       cudaq::info("Sampling the current state, with measure qubits = {}",
                   sampleQubits);
-
-      // Sample and give the results to the ExecutionContext
-      auto sampleResult =
-          sample(sampleQubits, executionContext->hasConditionalsOnMeasureResults
-                                   ? 1
-                                   : executionContext->shots);
-      executionContext->result.append(sampleResult);
-
-      for (auto &m : midCircuitSampleResults) {
-        // Get the register name and the vector of bit results
-        auto regName = m.first;
-        auto bitResults = m.second;
-        cudaq::ExecutionResult counts(regName);
-
-        if (std::find(vectorRegisters.begin(), vectorRegisters.end(),
-                      regName) != vectorRegisters.end()) {
-          // this is a vector register
-          std::string bitStr = "";
-          for (std::size_t j = 0; j < bitResults.size(); j++)
-            bitStr += bitResults[j];
-
-          counts.appendResult(bitStr, 1);
-
-        } else {
-          // Not a vector, collate all bits into a 1 qubit counts dict
-          for (std::size_t j = 0; j < bitResults.size(); j++) {
-            counts.appendResult(bitResults[j], 1);
-          }
+      SimulatorTimer timer(executionContext);
+
+      // Sample and give the results to the ExecutionContext, kernels with
+      // conditionals or noise trajectories are executed once per shot.
+      const int shots = executionContext->hasConditionalsOnMeasureResults ||
+                                executionContext->hasNoiseTrajectories
+                            ? 1
+                            : executionContext->shots;
+      if (executionContext->shotStream) {
+        // Sample in chunks, so that the counts of one chunk bound the memory
+        // however many shots are streamed. The streamed records hold the
+        // mid-circuit results as well.
+        for (int done = 0; done < shots; done += streamChunkShots) {
+          cudaq::profiler::ScopedEvent event(
+              "sample", cudaq::profiler::Category::sampling);
+          auto sampleResult =
+              sample(sampleQubits, std::min(shots - done, streamChunkShots));
+          applyReadoutErrors(sampleResult, sampleQubits);
+          streamShots(*executionContext->shotStream, sampleResult);
+        }
+      } else {
+        cudaq::profiler::ScopedEvent event(
+            "sample", cudaq::profiler::Category::sampling);
+        setSampleDistribution();
+        auto sampleResult = sample(sampleQubits, shots);
+        applyReadoutErrors(sampleResult, sampleQubits);
+        executionContext->result.append(std::move(sampleResult));
+        if (!midCircuitRegisters.empty()) {
+          // Hand over the packed record of this shot, the register results
+          // are built from the log only when read.
+          std::vector<std::uint64_t> record((midCircuitBits.size() + 63) / 64,
+                                            0);
+          for (std::size_t j = 0; j < midCircuitBits.size(); j++)
+            if (midCircuitBits[j])
+              record[j / 64] |= 1ULL << (j % 64);
+          cudaq::MeasurementLog log;
+          log.append(std::move(midCircuitRegisters), record.data(),
+                     midCircuitBits.size());
+          executionContext->result.append(std::move(log));
         }
-        executionContext->result.append(counts);
       }
 
       // Clear the sample bits for the next run
       sampleQubits.clear();
-      midCircuitSampleResults.clear();
+      midCircuitRegisters.clear();
+      midCircuitRegisterIndex.clear();
+      midCircuitBits.clear();
       lastMidCircuitRegisterName = "";
     }
 
-    // Set the state data if requested.
-    if (executionContext->name == "extract-state")
-      executionContext->simulationData = getStateData();
-
-    executionContext = nullptr;
+    if (execContextName == "overlap")
+      computeOverlap();
+    else if (execContextName == "amplitudes" ||
+             execContextName == "probabilities")
+      answerStateQuery();
 
     // Deallocate the deferred qubits, but do so
     // without explicit qubit reset.
     for (auto &deferred : deferredDeallocation)
       tracker.returnIndex(deferred);
 
+    // Set the state data if requested. The state is reset below once all
+    // qubits are deallocated, hand it over to the context in that case
+    // rather than copying it.
+    if (executionContext->name == "extract-state") {
+      if (tracker.numAvailable() == tracker.totalNumQudits())
+        executionContext->simulationState = takeSimulationState();
+      else {
+        auto [shape, data] = getSimulationState()->toState();
+        executionContext->simulationState = std::make_shared<
+            cudaq::HostSimulationState<std::vector<std::complex<double>>>>(
+            std::move(shape), std::move(data));
+      }
+    }
+
+    executionContext = nullptr;
+
     // Reset the state if we've deallocated all qubits.
-    if (tracker.numAvailable() == tracker.totalNumQubits()) {
+    if (tracker.numAvailable() == tracker.totalNumQudits()) {
       cudaq::info("Deallocated all qubits, reseting state vector.");
       // all qubits deallocated,
       resetQubitState();
@@ -352,29 +1698,277 @@ public:
   /// @brief Set the execution context
   /// @param context The execution context (sampling, observe)
   virtual void setExecutionContext(cudaq::ExecutionContext *context) {
+    flushFusedGate();
     executionContext = context;
-    executionContext->canHandleObserve = canHandleObserve();
+#ifdef _OPENMP
+    // Keep the OpenMP threads of this simulator, and of the Eigen and Q++
+    // routines it calls, within the thread budget of the calling thread.
+    if (auto budget = cudaq::getSimulatorThreadBudget())
+      omp_set_num_threads(budget);
+#endif
+    beginObserveBatch();
+    executionContext->canHandleObserve = canHandleObserve() || recordingBatch;
+    executionContext->hasNoiseTrajectories =
+        canHandleTrajectoryNoise() && executionContext->noiseModel &&
+        executionContext->noiseModel->has_channels();
+    executionContext->concurrentShots = canRunConcurrently();
+    beginPrefixCache();
+    beginGateRecording();
+    if (executionContext->seed)
+      seedRandomEngines(*executionContext->seed);
+  }
+
+  /// @brief Seed the random number generators of the measurement and noise
+  /// outcomes. Subtypes with generators of their own seed them as well.
+  virtual void seedRandomEngines(std::uint64_t seed) {
+    trajectoryRandomEngine.seed(seed);
   }
 
   /// @brief Return the current execution context
   /// @return context
   cudaq::ExecutionContext *getExecutionContext() { return executionContext; }
 
-  /// The following pragmas define the virtual and pure virtual
-  /// quantum instruction methods for the CircuitSimulator.
+  /// @brief Start capturing the gates applied from now on, until
+  /// endCapture(). Gates are still applied as usual. Capture the execution
+  /// of a whole kernel within an execution context, so that deallocating its
+  /// qubits does not reset them. Only subtypes that route their gates
+  /// through skipPrefixGate() can capture circuits.
+  void beginCapture() {
+    capturedCircuit = CapturedCircuit{};
+    capturedCircuit.replayable = canSnapshotState();
+    capturing = true;
+  }
+
+  /// @brief Stop capturing and return the captured circuit.
+  CapturedCircuit endCapture() {
+    capturing = false;
+    capturedCircuit.nQubits = nQubitsAllocated;
+    return std::move(capturedCircuit);
+  }
+
+  /// @brief Execute the captured circuit again: allocate the missing qubits,
+  /// apply its gates with the given `parameters` (laid out like
+  /// `circuit.parameters`), measure its measured qubits and deallocate the
+  /// allocated qubits. This has the effect of executing the kernel again,
+  /// without its host code. Gates go through the gate methods, so they are
+  /// fused, recorded for batched observation etc. as usual.
+  void replay(const CapturedCircuit &circuit,
+              const std::vector<double> &parameters) {
+    if (!circuit.replayable)
+      throw std::runtime_error("Cannot replay a captured circuit with "
+                               "measurements, resets or noise.");
+    if (parameters.size() != circuit.parameters.size())
+      throw std::runtime_error("Invalid number of parameters to replay the "
+                               "captured circuit.");
+
+    cudaq::info("Replaying captured circuit of {} gates.",
+                circuit.instructions.size());
+    std::vector<std::size_t> allocated;
+    if (nQubitsAllocated < circuit.nQubits)
+      allocated = allocateQubits(circuit.nQubits - nQubitsAllocated);
+    for (auto &instruction : circuit.instructions) {
+      const auto *qubits = circuit.qubits.data() + instruction.qubitOffset;
+      replayControls.assign(qubits, qubits + instruction.nControls);
+      applyCapturedGate(instruction.gate,
+                        parameters.data() + instruction.parameterOffset,
+                        replayControls, qubits + instruction.nControls);
+    }
+    for (auto q : circuit.measuredQubits)
+      mz(q);
+    for (auto q : allocated)
+      deallocate(q);
+  }
+
+  /// @brief Execute the captured circuit again with its own parameters.
+  void replay(const CapturedCircuit &circuit) {
+    replay(circuit, circuit.parameters);
+  }
+
+  /// @brief Apply the inverse of the gate through the gate methods. The
+  /// inverses of u2 and u3 are not gates of the simulator.
+  void applyInverseCapturedGate(CapturedGate gate, const double *params,
+                                const std::vector<std::size_t> &controls,
+                                const std::size_t *targets) {
+    switch (gate) {
+    case CapturedGate::s:
+      return applyCapturedGate(CapturedGate::sdg, params, controls, targets);
+    case CapturedGate::sdg:
+      return applyCapturedGate(CapturedGate::s, params, controls, targets);
+    case CapturedGate::t:
+      return applyCapturedGate(CapturedGate::tdg, params, controls, targets);
+    case CapturedGate::tdg:
+      return applyCapturedGate(CapturedGate::t, params, controls, targets);
+    case CapturedGate::rx:
+    case CapturedGate::ry:
+    case CapturedGate::rz:
+    case CapturedGate::r1:
+    case CapturedGate::u1: {
+      const double angle = -params[0];
+      return applyCapturedGate(gate, &angle, controls, targets);
+    }
+    case CapturedGate::u2:
+    case CapturedGate::u3:
+      throw std::runtime_error("Cannot invert u2 or u3 gates.");
+    default:
+      // x, y, z, h and swap are their own inverses.
+      return applyCapturedGate(gate, params, controls, targets);
+    }
+  }
+
+  /// @brief The auxiliary states of computeAdjointGradient().
+  enum AdjointSlot : std::size_t { adjointLambda = 0, adjointScratch = 1 };
+
+  /// @brief Return the derivative of <psi| H |psi> with respect to each
+  /// parameter slot of the captured circuit, whose gates took the initial
+  /// state to the current state psi, and set `expectation` to <psi| H |psi>.
+  ///
+  /// This is adjoint differentiation: with psi_k the state after gate k and
+  /// lambda_k = U_{k+1}^dag ... U_N^dag H psi, the derivative for the angle
+  /// of gate U_k is 2 Re <lambda_k| dU_k psi_{k-1}>. One backward sweep
+  /// undoes the gates on both psi and lambda, and dU_k psi_{k-1} is a
+  /// difference of U_k applied at two shifted angles. This takes two
+  /// auxiliary states besides the state, which ends up as the initial state.
+  /// Return nothing if the circuit has u2 or u3 gates, whose parameters are
+  /// not differentiated, or if H acts on more qubits than are allocated.
+  std::optional<std::vector<double>> computeAdjointGradient(const CapturedCircuit &circuit,
+                                             const cudaq::spin_op &H,
+                                             double &expectation) {
+    for (auto &instruction : circuit.instructions)
+      if (instruction.gate == CapturedGate::u2 ||
+          instruction.gate == CapturedGate::u3)
+        return std::nullopt;
+    if (H.n_qubits() > nQubitsAllocated)
+      return std::nullopt;
+
+    cudaq::info("Computing the adjoint gradient of {} gates.",
+                circuit.instructions.size());
+    // The sweep reads the state between gates, so none may be fused.
+    flushFusedGate();
+    const auto fusedWidth = maxFusedQubits;
+    maxFusedQubits = 0;
+
+    // lambda = H psi, term by term from a copy of psi.
+    copyStateToAuxiliary(adjointScratch);
+    copyStateToAuxiliary(adjointLambda, 0.0);
+    const auto nWords = H.n_words();
+    for (std::size_t t = 0; t < H.n_terms(); t++) {
+      const auto *term = H.get_term_data(t);
+      for (std::size_t w = 0; w < nWords; w++)
+        for (auto acts = term[w] | term[w + nWords]; acts; acts &= acts - 1) {
+          const auto bit = std::countr_zero(acts);
+          const auto q = 64 * w + bit;
+          const bool hasX = term[w] >> bit & 1;
+          const bool hasZ = term[w + nWords] >> bit & 1;
+          if (hasX && hasZ)
+            y(q);
+          else if (hasX)
+            x(q);
+          else
+            z(q);
+        }
+      addStateToAuxiliary(adjointLambda, H.get_term_coefficient(t));
+      copyAuxiliaryToState(adjointScratch);
+    }
+    // <psi| H |psi> = <lambda|psi>, real for a Hermitian H.
+    expectation = overlapWithAuxiliary(adjointLambda).real();
+
+    std::vector<double> gradient(circuit.parameters.size(), 0.0);
+    for (auto k = circuit.instructions.size(); k-- > 0;) {
+      auto &instruction = circuit.instructions[k];
+      const auto *qubits = circuit.qubits.data() + instruction.qubitOffset;
+      replayControls.assign(qubits, qubits + instruction.nControls);
+      const auto *targets = qubits + instruction.nControls;
+      const auto *params =
+          circuit.parameters.data() + instruction.parameterOffset;
+      applyInverseCapturedGate(instruction.gate, params, replayControls,
+                               targets);
+
+      if (instruction.nParameters) {
+        // rx, ry and rz are exp(-i angle G / 2) with G^2 = 1, so that
+        // dU = (U(angle + pi) - U(angle - pi)) / 4. r1 and u1 are
+        // diag(1, e^(i angle)), so that dU = (U(angle + pi/2) -
+        // U(angle - pi/2)) / 2. Both hold for the controlled gates too.
+        const bool isPhase = instruction.gate == CapturedGate::r1 ||
+                             instruction.gate == CapturedGate::u1;
+        const double shift = isPhase ? M_PI_2 : M_PI;
+        const double divisor = isPhase ? 2.0 : 4.0;
+        copyStateToAuxiliary(adjointScratch);
+        std::complex<double> difference = 0.0;
+        for (double sign : {1.0, -1.0}) {
+          const double angle = params[0] + sign * shift;
+          applyCapturedGate(instruction.gate, &angle, replayControls, targets);
+          difference += sign * overlapWithAuxiliary(adjointLambda);
+          copyAuxiliaryToState(adjointScratch);
+        }
+        gradient[instruction.parameterOffset] =
+            2.0 * difference.real() / divisor;
+      }
+
+      swapStateWithAuxiliary(adjointLambda);
+      applyInverseCapturedGate(instruction.gate, params, replayControls,
+                               targets);
+      swapStateWithAuxiliary(adjointLambda);
+    }
+
+    clearAuxiliaryStates();
+    maxFusedQubits = fusedWidth;
+    return gradient;
+  }
+
+  /// @brief Capture the gates of the kernel under the "adjoint-gradient" and
+  /// "record-gates" contexts. Under the latter the gates are only recorded,
+  /// not applied, so recording costs no simulation.
+  void beginGateRecording() {
+    const auto &name = executionContext->name;
+    if (name != "adjoint-gradient" && name != "record-gates")
+      return;
+    beginCapture();
+    captureOnly = name == "record-gates";
+  }
+
+  /// @brief Hand the parameters of the captured gates to the execution
+  /// context and, under "adjoint-gradient", the expectation value of its
+  /// spin_op and the derivatives with respect to them. These are left unset
+  /// if the kernel cannot be differentiated: it measured or reset qubits, is
+  /// noisy, or the simulator cannot compute adjoint gradients.
+  void endGateRecording() {
+    if (!capturing || (executionContext->name != "adjoint-gradient" &&
+                       executionContext->name != "record-gates"))
+      return;
+    captureOnly = false;
+    auto circuit = endCapture();
+    auto &context = *executionContext;
+    context.gateParameters = circuit.parameters;
+    context.gateParameterGradient.clear();
+    if (context.name != "adjoint-gradient" || !circuit.replayable ||
+        !context.spin || !canComputeAdjointGradient() ||
+        (context.noiseModel && !context.noiseModel->empty()))
+      return;
+
+    double expectation = 0.0;
+    if (auto gradient = computeAdjointGradient(circuit, *context.spin.value(),
+                                               expectation)) {
+      context.gateParameterGradient = std::move(*gradient);
+      context.expectationValue = expectation;
+    }
+  }
+
+  /// @brief The controls of uncontrolled gates.
+  static inline const std::vector<std::size_t> noControls;
+
+  /// The following pragmas define the quantum instruction methods for the
+  /// CircuitSimulator. Subtypes implement the pure virtual, controlled
+  /// versions. The uncontrolled versions are not virtual, they forward
+  /// directly so that every gate costs a single virtual call.
 
 #define CIRCUIT_SIMULATOR_ONE_QUBIT(NAME)                                      \
-  virtual void NAME(const std::size_t qubitIdx) {                              \
-    std::vector<std::size_t> tmp;                                              \
-    NAME(tmp, qubitIdx);                                                       \
-  }                                                                            \
+  void NAME(const std::size_t qubitIdx) { NAME(noControls, qubitIdx); }        \
   virtual void NAME(const std::vector<std::size_t> &controls,                  \
                     const std::size_t qubitIdx) = 0;
 
 #define CIRCUIT_SIMULATOR_ONE_QUBIT_ONE_PARAM(NAME)                            \
-  virtual void NAME(const double angle, const std::size_t qubitIdx) {          \
-    std::vector<std::size_t> tmp;                                              \
-    NAME(angle, tmp, qubitIdx);                                                \
+  void NAME(const double angle, const std::size_t qubitIdx) {                  \
+    NAME(angle, noControls, qubitIdx);                                         \
   }                                                                            \
   virtual void NAME(const double angle,                                        \
                     const std::vector<std::size_t> &controls,                  \
@@ -411,20 +2005,17 @@ public:
 #undef CIRCUIT_SIMULATOR_ONE_QUBIT
 #undef CIRCUIT_SIMULATOR_ONE_QUBIT_ONE_PARAM
 
-  virtual void u2(const double phi, const double lambda,
-                  const std::size_t qubitIdx) {
-    std::vector<std::size_t> controls;
-    u2(phi, lambda, controls, qubitIdx);
+  void u2(const double phi, const double lambda, const std::size_t qubitIdx) {
+    u2(phi, lambda, noControls, qubitIdx);
   }
 
   virtual void u2(const double phi, const double lambda,
                   const std::vector<std::size_t> &controls,
                   const std::size_t qubitIdx) = 0;
 
-  virtual void u3(const double theta, const double phi, const double lambda,
-                  const std::size_t qubitIdx) {
-    std::vector<std::size_t> controls;
-    u3(theta, phi, lambda, controls, qubitIdx);
+  void u3(const double theta, const double phi, const double lambda,
+          const std::size_t qubitIdx) {
+    u3(theta, phi, lambda, noControls, qubitIdx);
   }
 
   virtual void u3(const double theta, const double phi, const double lambda,
@@ -432,9 +2023,8 @@ public:
                   const std::size_t qubitIdx) = 0;
 
   /// @brief  Invoke the SWAP gate
-  virtual void swap(const std::size_t srcIdx, const std::size_t tgtIdx) {
-    std::vector<std::size_t> tmp;
-    swap(tmp, srcIdx, tgtIdx);
+  void swap(const std::size_t srcIdx, const std::size_t tgtIdx) {
+    swap(noControls, srcIdx, tgtIdx);
   }
 
   /// @brief Invoke a general multi-control swap gate
@@ -443,6 +2033,141 @@ public:
   /// @param tgtIdx
   virtual void swap(const std::vector<std::size_t> &ctrlBits,
                     const std::size_t srcIdx, const std::size_t tgtIdx) = 0;
+
+  /// @brief Decompose the permutation that moves the state of `qubits[i]` to
+  /// `qubits[permutation[i]]` into at most two layers of disjoint swaps,
+  /// applied first to last. Each cycle is the product of two reflections.
+  static std::vector<std::vector<std::pair<std::size_t, std::size_t>>>
+  getSwapLayers(const std::vector<std::size_t> &qubits,
+                const std::vector<std::size_t> &permutation) {
+    const std::size_t n = qubits.size();
+    if (permutation.size() != n)
+      throw std::runtime_error("Qubit permutation of the wrong size.");
+    std::vector<bool> seen(n, false);
+    for (auto p : permutation) {
+      if (p >= n || seen[p])
+        throw std::runtime_error("Invalid qubit permutation.");
+      seen[p] = true;
+    }
+
+    std::vector<std::vector<std::pair<std::size_t, std::size_t>>> layers(2);
+    std::vector<bool> visited(n, false);
+    std::vector<std::size_t> cycle;
+    for (std::size_t start = 0; start < n; start++) {
+      cycle.clear();
+      for (auto i = start; !visited[i]; i = permutation[i]) {
+        visited[i] = true;
+        cycle.push_back(qubits[i]);
+      }
+      // With p(c_i) = c_{i+1}, swap c_i with c_{-i}, then c_i with c_{1-i}.
+      const std::size_t k = cycle.size();
+      for (std::size_t i = 0; i < k; i++) {
+        if (i < (k - i) % k)
+          layers[0].emplace_back(cycle[i], cycle[(k - i) % k]);
+        if (i < (k + 1 - i) % k)
+          layers[1].emplace_back(cycle[i], cycle[(k + 1 - i) % k]);
+      }
+    }
+    auto isEmpty = [](const auto &layer) { return layer.empty(); };
+    layers.erase(std::remove_if(layers.begin(), layers.end(), isEmpty),
+                 layers.end());
+    return layers;
+  }
+
+  /// @brief Move the state of `qubits[i]` to `qubits[permutation[i]]`, for
+  /// every i. Subtypes that can permute qubits apply it at once, the others
+  /// as swaps. So do all subtypes while gates are individually recorded or
+  /// noisy.
+  void permuteQubits(const std::vector<std::size_t> &qubits,
+                     const std::vector<std::size_t> &permutation) {
+    auto layers = getSwapLayers(qubits, permutation);
+    const bool recorded = prefixCacheMode != PrefixCacheMode::Off ||
+                          capturing || recordingBatch ||
+                          (executionContext && executionContext->noiseModel);
+    if (recorded || !canPermuteQubits()) {
+      for (auto &layer : layers)
+        for (auto [a, b] : layer)
+          swap(a, b);
+      return;
+    }
+    if (layers.empty())
+      return;
+    flushFusedGate();
+    countAppliedGate();
+    applyQubitPermutation(qubits, permutation);
+  }
+
+  /// @brief Return the angles (theta, phi) such that r1(phi) ry(theta) takes
+  /// |0> to `state`, up to a global phase.
+  static std::pair<double, double>
+  getProductStateAngles(const std::array<std::complex<double>, 2> &state) {
+    const double theta =
+        2.0 * std::atan2(std::abs(state[1]), std::abs(state[0]));
+    const double phi = std::arg(state[1]) - std::arg(state[0]);
+    return {theta, phi};
+  }
+
+  /// @brief Put each of the `qubits`, fresh qubits in |0>, in the state
+  /// `state[0] |0> + state[1] |1>`, as prepared by the `quake-product-state`
+  /// pass. Subtypes that can prepare product states write them at once, the
+  /// others apply an ry and an r1 gate to each qubit. So do all subtypes while
+  /// gates are individually recorded or noisy.
+  void prepareProductState(const std::array<std::complex<double>, 2> &state,
+                           const std::vector<std::size_t> &qubits) {
+    const bool recorded = prefixCacheMode != PrefixCacheMode::Off ||
+                          capturing || recordingBatch ||
+                          (executionContext && executionContext->noiseModel);
+    if (recorded || !canPrepareProductState()) {
+      auto [theta, phi] = getProductStateAngles(state);
+      for (auto q : qubits) {
+        ry(theta, q);
+        if (phi != 0.0)
+          r1(phi, q);
+      }
+      return;
+    }
+    if (qubits.empty())
+      return;
+    flushFusedGate();
+    countAppliedGate();
+    applyProductState(state, qubits);
+  }
+
+  /// @brief Put the `qubits`, fresh qubits in |0>, in the state with the 2^n
+  /// normalized `amplitudes`, bit j of the amplitude index being the value
+  /// of `qubits[j]`. Subtypes that can write the amplitudes do so at once,
+  /// the others apply the circuit of cudaq::synthesizeStatePreparation(). So
+  /// do all subtypes while gates are individually recorded or noisy.
+  void initializeState(const std::vector<std::size_t> &qubits,
+                       const std::complex<double> *amplitudes) {
+    const std::size_t n = qubits.size();
+    cudaq::checkStateAmplitudes(n, amplitudes, n < 64 ? 1ULL << n : 0);
+    const bool recorded = prefixCacheMode != PrefixCacheMode::Off ||
+                          capturing || recordingBatch ||
+                          (executionContext && executionContext->noiseModel);
+    if (recorded || !canInitializeState(qubits)) {
+      std::vector<std::size_t> controls;
+      cudaq::synthesizeStatePreparation(
+          n, amplitudes,
+          [&](std::string_view name, double angle,
+              const std::vector<std::size_t> &positions, std::size_t target) {
+            controls.clear();
+            for (auto p : positions)
+              controls.push_back(qubits[p]);
+            if (name == "x")
+              x(controls, qubits[target]);
+            else if (name == "ry")
+              ry(angle, controls, qubits[target]);
+            else
+              r1(angle, controls, qubits[target]);
+          });
+      return;
+    }
+    flushFusedGate();
+    countAppliedGate();
+    applyStateInitialization(qubits, amplitudes);
+  }
+
   /// @brief Measure the qubit with given index
   /// @param qubitIdx The unique id for the qubit
   /// @return the measurement result
@@ -458,11 +2183,15 @@ public:
   /// measure, collapse, and return the bit.
   virtual bool mz(const std::size_t qubitIdx, const std::string &registerName) {
     // If sampling, just store the bit, do nothing else.
-    if (handleBasicSampling(qubitIdx))
+    if (handleBasicSampling(qubitIdx)) {
+      if (capturing)
+        capturedCircuit.measuredQubits.push_back(qubitIdx);
       return true;
+    }
 
-    // Get the actual measurement from the subtype measureQubit implementation
-    auto measureResult = measureQubit(qubitIdx);
+    // Get the actual measurement from the subtype measureQubit
+    // implementation, as read out by the noisy measurement device if any.
+    auto measureResult = readOut(qubitIdx, measureQubit(qubitIdx));
     auto bitResult = measureResult == true ? "1" : "0";
 
     // If this kernel has conditional statements on measure results
@@ -473,6 +2202,28 @@ public:
     return measureResult;
   }
 
+  /// @brief Measure the qubits of a register, as mz(qubitIdx, registerName)
+  /// does for each of them, but collapsing the state with one
+  /// measureQubits() call.
+  std::vector<bool> mz(const std::vector<std::size_t> &qubitIdxs,
+                       const std::string &registerName) {
+    std::vector<bool> results;
+    if (executionContext && executionContext->name == "sample" &&
+        !executionContext->hasConditionalsOnMeasureResults) {
+      for (auto qubitIdx : qubitIdxs)
+        results.push_back(mz(qubitIdx, registerName));
+      return results;
+    }
+
+    results = measureQubits(qubitIdxs);
+    for (std::size_t i = 0; i < qubitIdxs.size(); i++) {
+      results[i] = readOut(qubitIdxs[i], results[i]);
+      handleSamplingWithConditionals(qubitIdxs[i], results[i] ? "1" : "0",
+                                     registerName);
+    }
+    return results;
+  }
+
   /// @brief Reset the qubit to the |0> state
   /// @param qubitIdx the qubit idx
   virtual void resetQubit(const std::size_t qubitIdx) = 0;
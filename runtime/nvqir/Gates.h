@@ -8,7 +8,11 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <complex>
+#include <initializer_list>
+#include <stdexcept>
 #include <vector>
 
 namespace nvqir {
@@ -24,79 +28,116 @@ using ComplexT = std::complex<ScalarType>;
 /// @brief Enumeration of supported CUDA Quantum operations
 enum class GateName { X, Y, Z, H, S, Sdg, Tdg, T, Rx, Ry, Rz, R1, U1, U2, U3 };
 
-/// @brief Given the gate name (an element of the GateName enum),
-/// return the matrix data, optionally parameterized by a rotation angle.
-template <typename Scalar>
-std::vector<std::complex<Scalar>>
-getGateByName(GateName name, const std::vector<Scalar> angles = {}) {
-  Scalar two = 2.;
+/// @brief The row major matrix of a one-qubit gate.
+template <typename Scalar = double>
+using GateMatrix = std::array<std::complex<Scalar>, 4>;
+
+/// @brief Return the matrix of a gate without parameters (X, Y, Z, H, S, Sdg,
+/// T or Tdg). The matrices are literal tables, so a call with a constant gate
+/// name folds to a constant.
+template <typename Scalar = double>
+constexpr GateMatrix<Scalar> getFixedGateMatrix(GateName name) {
+  using C = std::complex<Scalar>;
+  constexpr Scalar oneOverSqrt2 = 0.70710678118654752440;
   switch (name) {
   case (GateName::X):
-    return {{0., 0.}, {1.0, 0.}, {1.0, 0.0}, {0., 0.}};
+    return {C(0., 0.), C(1., 0.), C(1., 0.), C(0., 0.)};
   case (GateName::Y):
-    return {{0., 0.}, {0.0, -1.0}, {0.0, 1.0}, {0., 0.}};
+    return {C(0., 0.), C(0., -1.), C(0., 1.), C(0., 0.)};
   case (GateName::Z):
-    return {{1., 0.}, {0.0, 0.}, {0.0, 0.0}, {-1., 0.}};
-  case (GateName::H): {
-    Scalar oneOverSqrt2 = 1 / std::sqrt(2.);
-    return {oneOverSqrt2, oneOverSqrt2, oneOverSqrt2, -oneOverSqrt2};
-  }
+    return {C(1., 0.), C(0., 0.), C(0., 0.), C(-1., 0.)};
+  case (GateName::H):
+    return {C(oneOverSqrt2, 0.), C(oneOverSqrt2, 0.), C(oneOverSqrt2, 0.),
+            C(-oneOverSqrt2, 0.)};
   case (GateName::S):
-    return {{1., 0.}, {0.0, 0.}, {0.0, 0.0}, {0., 1.}};
+    return {C(1., 0.), C(0., 0.), C(0., 0.), C(0., 1.)};
   case (GateName::Sdg):
-    return {{1., 0.}, {0.0, 0.}, {0.0, 0.0}, {0., -1.}};
+    return {C(1., 0.), C(0., 0.), C(0., 0.), C(0., -1.)};
   case (GateName::T):
-    return {{1., 0.},
-            {0.0, 0.},
-            {0.0, 0.0},
-            std::exp(im<Scalar> * static_cast<Scalar>(M_PI_4))};
+    return {C(1., 0.), C(0., 0.), C(0., 0.), C(oneOverSqrt2, oneOverSqrt2)};
   case (GateName::Tdg):
-    return {{1., 0.},
-            {0.0, 0.},
-            {0.0, 0.0},
-            std::exp(-im<Scalar> * static_cast<Scalar>(M_PI_4))};
+    return {C(1., 0.), C(0., 0.), C(0., 0.), C(oneOverSqrt2, -oneOverSqrt2)};
+  default:
+    break;
+  }
+  throw std::runtime_error("Gate provided to getFixedGateMatrix has "
+                           "parameters.");
+}
+
+/// @brief Write the matrix of the given gate, parameterized by `angles` (one
+/// for the rotations, two for U2, three for U3), to the 4 elements of
+/// `matrix`. Nothing is allocated.
+template <typename Scalar>
+void writeGateMatrix(GateName name, const Scalar *angles,
+                     std::complex<Scalar> *matrix) {
+  using C = std::complex<Scalar>;
+  auto write = [&](C m00, C m01, C m10, C m11) {
+    matrix[0] = m00;
+    matrix[1] = m01;
+    matrix[2] = m10;
+    matrix[3] = m11;
+  };
+  // e^{i x}
+  auto phase = [](Scalar x) { return C(std::cos(x), std::sin(x)); };
+  constexpr Scalar oneOverSqrt2 = 0.70710678118654752440;
+  switch (name) {
   case (GateName::Rx): {
-    auto angle = angles[0];
-    return {{std::cos(angle / two), 0.},
-            {0., -1 * std::sin(angle / two)},
-            {0, -1 * std::sin(angle / two)},
-            {std::cos(angle / two), 0.}};
+    const Scalar c = std::cos(angles[0] / 2), s = std::sin(angles[0] / 2);
+    write(C(c, 0.), C(0., -s), C(0., -s), C(c, 0.));
+    return;
   }
   case (GateName::Ry): {
-    auto angle = angles[0];
-    return {std::cos(angle / two), -std::sin(angle / two),
-            std::sin(angle / two), std::cos(angle / two)};
+    const Scalar c = std::cos(angles[0] / 2), s = std::sin(angles[0] / 2);
+    write(C(c, 0.), C(-s, 0.), C(s, 0.), C(c, 0.));
+    return;
   }
   case (GateName::Rz): {
-    auto angle = angles[0];
-    return {std::exp(-im<Scalar> * angle / two), 0, 0,
-            std::exp(im<Scalar> * angle / two)};
+    const C e = phase(angles[0] / 2);
+    write(std::conj(e), C(0., 0.), C(0., 0.), e);
+    return;
   }
   case (GateName::R1):
-    return {{1., 0.}, {0.0, 0.}, {0.0, 0.0}, std::exp(im<Scalar> * angles[0])};
   case (GateName::U1):
-    return {{1., 0.}, {0.0, 0.}, {0.0, 0.0}, std::exp(im<Scalar> * angles[0])};
+    write(C(1., 0.), C(0., 0.), C(0., 0.), phase(angles[0]));
+    return;
   case (GateName::U2): {
-    Scalar oneOverSqrt2 = 1 / std::sqrt(2.);
-    auto phi = angles[0];
-    auto lambda = angles[1];
-    return {{oneOverSqrt2, 0.},
-            -oneOverSqrt2 * std::exp(lambda * nvqir::im<Scalar>),
-            oneOverSqrt2 * std::exp(nvqir::im<Scalar> * phi),
-            oneOverSqrt2 * std::exp(nvqir::im<Scalar> * (phi + lambda))};
+    const Scalar phi = angles[0], lambda = angles[1];
+    write(C(oneOverSqrt2, 0.), -oneOverSqrt2 * phase(lambda),
+          oneOverSqrt2 * phase(phi), oneOverSqrt2 * phase(phi + lambda));
+    return;
   }
   case (GateName::U3): {
-    auto theta = angles[0];
-    auto phi = angles[1];
-    auto lambda = angles[2];
-    return {{std::cos(theta / 2), 0.},
-            std::exp(nvqir::im<Scalar> * phi) * std::sin(theta / 2),
-            -std::exp(nvqir::im<Scalar> * lambda) * std::sin(theta / 2),
-            std::exp(nvqir::im<Scalar> * (phi + lambda)) * std::cos(theta / 2)};
+    const Scalar theta = angles[0], phi = angles[1], lambda = angles[2];
+    const Scalar c = std::cos(theta / 2), s = std::sin(theta / 2);
+    write(C(c, 0.), s * phase(phi), -s * phase(lambda),
+          c * phase(phi + lambda));
+    return;
+  }
+  default: {
+    const auto fixed = getFixedGateMatrix<Scalar>(name);
+    std::copy(fixed.begin(), fixed.end(), matrix);
   }
   }
+}
 
-  throw std::runtime_error("Invalid gate provided to getGateByName.");
+/// @brief Return the matrix of the given gate by value, optionally
+/// parameterized by rotation angles.
+template <typename Scalar>
+GateMatrix<Scalar> getGateMatrix(GateName name,
+                                 std::initializer_list<Scalar> angles = {}) {
+  GateMatrix<Scalar> matrix;
+  writeGateMatrix(name, angles.begin(), matrix.data());
+  return matrix;
+}
+
+/// @brief Given the gate name (an element of the GateName enum),
+/// return the matrix data, optionally parameterized by a rotation angle.
+template <typename Scalar>
+std::vector<std::complex<Scalar>>
+getGateByName(GateName name, const std::vector<Scalar> angles = {}) {
+  std::vector<std::complex<Scalar>> matrix(4);
+  writeGateMatrix(name, angles.data(), matrix.data());
+  return matrix;
 }
 
 /// @brief The X operation as a type. Can instantiate and request
@@ -104,6 +145,9 @@ getGateByName(GateName name, const std::vector<Scalar> angles = {}) {
 template <typename ScalarType = double>
 struct x {
   auto getGate() { return getGateByName<ScalarType>(GateName::X); }
+  static constexpr GateMatrix<ScalarType> getMatrix() {
+    return getFixedGateMatrix<ScalarType>(GateName::X);
+  }
   const std::string name() const { return "x"; }
 };
 
@@ -113,6 +157,9 @@ struct y {
   std::vector<ComplexT<ScalarType>> getGate() {
     return getGateByName<ScalarType>(GateName::Y);
   }
+  static constexpr GateMatrix<ScalarType> getMatrix() {
+    return getFixedGateMatrix<ScalarType>(GateName::Y);
+  }
   const std::string name() const { return "y"; }
 };
 
@@ -122,6 +169,9 @@ struct z {
   std::vector<ComplexT<ScalarType>> getGate() {
     return getGateByName<ScalarType>(GateName::Z);
   }
+  static constexpr GateMatrix<ScalarType> getMatrix() {
+    return getFixedGateMatrix<ScalarType>(GateName::Z);
+  }
   const std::string name() const { return "z"; }
 };
 
@@ -131,6 +181,9 @@ struct h {
   std::vector<ComplexT<ScalarType>> getGate() {
     return getGateByName<ScalarType>(GateName::H);
   }
+  static constexpr GateMatrix<ScalarType> getMatrix() {
+    return getFixedGateMatrix<ScalarType>(GateName::H);
+  }
   const std::string name() const { return "h"; }
 };
 
@@ -140,6 +193,9 @@ struct s {
   std::vector<ComplexT<ScalarType>> getGate() {
     return getGateByName<ScalarType>(GateName::S);
   }
+  static constexpr GateMatrix<ScalarType> getMatrix() {
+    return getFixedGateMatrix<ScalarType>(GateName::S);
+  }
   const std::string name() const { return "s"; }
 };
 
@@ -149,6 +205,9 @@ struct t {
   std::vector<ComplexT<ScalarType>> getGate() {
     return getGateByName<ScalarType>(GateName::T);
   }
+  static constexpr GateMatrix<ScalarType> getMatrix() {
+    return getFixedGateMatrix<ScalarType>(GateName::T);
+  }
   const std::string name() const { return "t"; }
 };
 
@@ -158,6 +217,9 @@ struct sdg {
   std::vector<ComplexT<ScalarType>> getGate() {
     return getGateByName<ScalarType>(GateName::Sdg);
   }
+  static constexpr GateMatrix<ScalarType> getMatrix() {
+    return getFixedGateMatrix<ScalarType>(GateName::Sdg);
+  }
   const std::string name() const { return "sdg"; }
 };
 
@@ -167,6 +229,9 @@ struct tdg {
   std::vector<ComplexT<ScalarType>> getGate() {
     return getGateByName<ScalarType>(GateName::Tdg);
   }
+  static constexpr GateMatrix<ScalarType> getMatrix() {
+    return getFixedGateMatrix<ScalarType>(GateName::Tdg);
+  }
   const std::string name() const { return "tdg"; }
 };
 
@@ -176,6 +241,9 @@ struct rx {
   std::vector<ComplexT<ScalarType>> getGate(ScalarType angle) {
     return getGateByName<ScalarType>(GateName::Rx, {angle});
   }
+  static GateMatrix<ScalarType> getMatrix(ScalarType angle) {
+    return getGateMatrix<ScalarType>(GateName::Rx, {angle});
+  }
   const std::string name() const { return "rx"; }
 };
 
@@ -185,6 +253,9 @@ struct ry {
   std::vector<ComplexT<ScalarType>> getGate(ScalarType angle) {
     return getGateByName<ScalarType>(GateName::Ry, {angle});
   }
+  static GateMatrix<ScalarType> getMatrix(ScalarType angle) {
+    return getGateMatrix<ScalarType>(GateName::Ry, {angle});
+  }
   const std::string name() const { return "ry"; }
 };
 
@@ -194,6 +265,9 @@ struct rz {
   std::vector<ComplexT<ScalarType>> getGate(ScalarType angle) {
     return getGateByName<ScalarType>(GateName::Rz, {angle});
   }
+  static GateMatrix<ScalarType> getMatrix(ScalarType angle) {
+    return getGateMatrix<ScalarType>(GateName::Rz, {angle});
+  }
   const std::string name() const { return "rz"; }
 };
 
@@ -203,6 +277,9 @@ struct r1 {
   std::vector<ComplexT<ScalarType>> getGate(ScalarType angle) {
     return getGateByName<ScalarType>(GateName::R1, {angle});
   }
+  static GateMatrix<ScalarType> getMatrix(ScalarType angle) {
+    return getGateMatrix<ScalarType>(GateName::R1, {angle});
+  }
   const std::string name() const { return "r1"; }
 };
 
@@ -213,6 +290,9 @@ struct u1 {
   std::vector<ComplexT<ScalarType>> getGate(ScalarType angle) {
     return getGateByName<ScalarType>(GateName::U1, {angle});
   }
+  static GateMatrix<ScalarType> getMatrix(ScalarType angle) {
+    return getGateMatrix<ScalarType>(GateName::U1, {angle});
+  }
   const std::string name() const { return "u1"; }
 };
 
@@ -221,6 +301,9 @@ struct u2 {
   std::vector<ComplexT<ScalarType>> getGate(ScalarType phi, ScalarType lambda) {
     return getGateByName<ScalarType>(GateName::U2, {phi, lambda});
   }
+  static GateMatrix<ScalarType> getMatrix(ScalarType phi, ScalarType lambda) {
+    return getGateMatrix<ScalarType>(GateName::U2, {phi, lambda});
+  }
   const std::string name() const { return "u2"; }
 };
 
@@ -230,6 +313,10 @@ struct u3 {
                                             ScalarType lambda) {
     return getGateByName<ScalarType>(GateName::U3, {theta, phi, lambda});
   }
+  static GateMatrix<ScalarType> getMatrix(ScalarType theta, ScalarType phi,
+                                          ScalarType lambda) {
+    return getGateMatrix<ScalarType>(GateName::U3, {theta, phi, lambda});
+  }
   const std::string name() const { return "u3"; }
 };
 } // namespace nvqir
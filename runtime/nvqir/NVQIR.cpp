@@ -9,10 +9,19 @@
 #include "CircuitSimulator.h"
 #include "Logger.h"
 #include "PluginUtils.h"
+#include "Profiler.h"
+#include "ObserveResult.h"
+#include "PauliEvolution.h"
 #include "QIRTypes.h"
 #include "cudaq/spin_op.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdarg>
 #include <cmath>
 #include <complex>
+#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -63,13 +72,9 @@ void __nvqir__setCircuitSimulator(nvqir::CircuitSimulator *sim) {
 
 namespace nvqir {
 
-/// @brief Return the single simulation backend pointer, create if not created
-/// already.
+/// @brief Create the simulation backend of this thread.
 /// @return
-CircuitSimulator *getCircuitSimulatorInternal() {
-  if (simulator)
-    return simulator;
-
+static CircuitSimulator *createCircuitSimulator() {
   if (externSimGenerator) {
     simulator = (*externSimGenerator)();
     return simulator;
@@ -81,43 +86,159 @@ CircuitSimulator *getCircuitSimulatorInternal() {
   return simulator;
 }
 
-/// @brief Store allocated Array pointers
-thread_local static std::vector<std::unique_ptr<Array>> allocatedArrays;
+/// @brief Return the single simulation backend pointer, create if not created
+/// already. Every gate calls this, the creation is kept out of line.
+/// @return
+inline CircuitSimulator *getCircuitSimulatorInternal() {
+  if (simulator) [[likely]]
+    return simulator;
+  return createCircuitSimulator();
+}
+
+/// @brief A pool of QIR runtime objects. Released objects are kept on a free
+/// list and handed out again, so kernels allocating and releasing registers
+/// in a loop reuse the same objects instead of hitting the heap. The objects
+/// live in a std::deque, their addresses stay valid as the pool grows.
+template <typename T>
+class QIRObjectPool {
+  std::deque<T> objects;
+  std::vector<T *> released;
+
+public:
+  /// @brief Return a released object, or a new one constructed from `args`.
+  /// Reused objects keep their state, callers reinitialize them.
+  template <typename... Args>
+  T *acquire(Args &&...args) {
+    if (released.empty())
+      return &objects.emplace_back(std::forward<Args>(args)...);
+    T *object = released.back();
+    released.pop_back();
+    return object;
+  }
 
-/// @brief Store allocated Qubit pointers
-thread_local static std::vector<std::unique_ptr<Qubit>> allocatedSingleQubits;
+  /// @brief Return the object to the pool, it must have been acquired from
+  /// this pool.
+  void release(T *object) { released.push_back(object); }
+};
+
+/// @brief Pool of the Arrays of Qubit pointers handed out to kernels
+thread_local static QIRObjectPool<Array> arrayPool;
+
+/// @brief Pool of the Qubits handed out to kernels
+thread_local static QIRObjectPool<Qubit> qubitPool;
+
+/// @brief Return an Array of `size` null Qubit pointers from the pool
+static Array *acquireQubitArray(std::size_t size) {
+  auto *array = arrayPool.acquire(size, sizeof(Qubit *));
+  array->resize(size);
+  return array;
+}
+
+/// @brief Return a Qubit with the given id from the pool
+static Qubit *acquireQubit(std::size_t idx) {
+  auto *qubit = qubitPool.acquire(idx);
+  qubit->idx = idx;
+  return qubit;
+}
+
+/// @brief The number of G† G pairs every gate G is followed by, to scale the
+/// noise of the kernel for zero-noise extrapolation (see
+/// ExecutionContext::foldScale).
+thread_local static std::size_t foldPairs = 0;
+
+/// @brief Apply a gate with `apply`, followed `foldPairs` times by its
+/// adjoint, applied with `applyAdjoint`, and the gate again. The time is
+/// counted as simulator time of the execution.
+template <typename Apply, typename ApplyAdjoint>
+inline void applyFolded(Apply &&apply, ApplyAdjoint &&applyAdjoint) {
+  SimulatorTimer timer(getCircuitSimulatorInternal()->getExecutionContext());
+  apply();
+  for (std::size_t i = 0; i < foldPairs; i++) {
+    applyAdjoint();
+    apply();
+  }
+}
 
 /// @brief Utility function mapping qubit ids to a QIR Array pointer
 /// @param idxs
 /// @return
 Array *vectorSizetToArray(std::vector<std::size_t> &idxs) {
-  auto newArray = std::make_unique<Array>(idxs.size(), sizeof(std::size_t));
+  auto *newArray = acquireQubitArray(idxs.size());
   for (std::size_t i = 0; i < idxs.size(); i++) {
-    auto qbit = new Qubit{idxs[i]};
     auto arrayPtr = (*newArray)[i];
-    *reinterpret_cast<Qubit **>(arrayPtr) = qbit;
+    *reinterpret_cast<Qubit **>(arrayPtr) = acquireQubit(idxs[i]);
   }
-  nvqir::allocatedArrays.emplace_back(std::move(newArray));
-  return nvqir::allocatedArrays.back().get();
+  return newArray;
 }
 
-/// @brief Utility function mapping a QIR Array pointer to a vector of ids
+/// @brief Storage for the control qubit ids of the current controlled gate.
+/// It is reused for every gate and keeps its capacity, so passing controls
+/// to the simulator does not allocate.
+thread_local static std::vector<std::size_t> controlIdxs;
+
+std::size_t qubitToSizeT(Qubit *q);
+
+/// @brief Utility function mapping a QIR Array of control qubits to their
+/// ids. The returned vector is overwritten by the next controlled gate.
 /// @param arr
 /// @return
-std::vector<std::size_t> arrayToVectorSizeT(Array *arr) {
-  std::vector<std::size_t> ret;
+const std::vector<std::size_t> &arrayToControls(Array *arr) {
+  controlIdxs.clear();
   for (std::size_t i = 0; i < arr->size(); i++) {
     auto arrayPtr = (*arr)[i];
     Qubit *idxVal = *reinterpret_cast<Qubit **>(arrayPtr);
-    ret.push_back(idxVal->idx);
+    controlIdxs.push_back(qubitToSizeT(idxVal));
   }
-  return ret;
+  return controlIdxs;
+}
+
+/// @brief Utility function mapping a single control qubit id to the
+/// controls of a gate. The returned vector is overwritten by the next
+/// controlled gate.
+/// @param idx
+/// @return
+const std::vector<std::size_t> &qubitToControls(std::size_t idx) {
+  controlIdxs.assign(1, idx);
+  return controlIdxs;
 }
 
-/// @brief Utility function mapping a QIR Qubit pointer to its id
+/// @brief The simulator qubit ids of a base profile kernel run by
+/// `__nvqir__runBaseProfileKernel`, indexed by the static qubit ids of the
+/// kernel. Empty when no such kernel runs.
+thread_local static std::vector<std::size_t> staticQubitIdxs;
+
+/// @brief The measurement results of a base profile kernel, indexed by its
+/// static result ids.
+thread_local static std::vector<Result> staticResults;
+
+/// @brief The results recorded by the base profile kernel last run.
+thread_local static std::vector<bool> recordedResults;
+
+/// @brief Utility function mapping a QIR Qubit pointer to its id. In a base
+/// profile kernel the pointer is the static id of the qubit itself.
 /// @param q
 /// @return
-std::size_t qubitToSizeT(Qubit *q) { return q->idx; }
+std::size_t qubitToSizeT(Qubit *q) {
+  if (staticQubitIdxs.empty())
+    return q->idx;
+  auto staticIdx = reinterpret_cast<std::uintptr_t>(q);
+  if (staticIdx >= staticQubitIdxs.size())
+    throw std::runtime_error("Static qubit id " + std::to_string(staticIdx) +
+                             " exceeds the qubits required by the kernel.");
+  return staticQubitIdxs[staticIdx];
+}
+
+/// @brief Utility function mapping a base profile QIR Result pointer to its
+/// static id.
+/// @param r
+/// @return
+static std::size_t resultToSizeT(Result *r) {
+  auto staticIdx = reinterpret_cast<std::uintptr_t>(r);
+  if (staticIdx >= staticResults.size())
+    throw std::runtime_error("Static result id " + std::to_string(staticIdx) +
+                             " exceeds the results required by the kernel.");
+  return staticIdx;
+}
 
 } // namespace nvqir
 
@@ -151,6 +272,7 @@ void __quantum__rt__setExecutionContext(cudaq::ExecutionContext *ctx) {
                 ctx->hasConditionalsOnMeasureResults ? " with conditionals"
                                                      : "");
     nvqir::getCircuitSimulatorInternal()->setExecutionContext(ctx);
+    nvqir::foldPairs = ctx->foldScale > 1 ? (ctx->foldScale - 1) / 2 : 0;
   }
 }
 
@@ -159,6 +281,7 @@ void __quantum__rt__resetExecutionContext() {
   cudaq::ScopedTrace trace("NVQIR::resetExecutionContext");
   cudaq::info("Resetting execution context.");
   nvqir::getCircuitSimulatorInternal()->resetExecutionContext();
+  nvqir::foldPairs = 0;
 }
 
 /// @brief QIR function for allocated a qubit array
@@ -167,7 +290,10 @@ void __quantum__rt__resetExecutionContext() {
 Array *__quantum__rt__qubit_allocate_array(uint64_t size) {
   cudaq::ScopedTrace trace("NVQIR::qubit_allocate_array", size);
   __quantum__rt__initialize(0, nullptr);
-  auto qubitIdxs = nvqir::getCircuitSimulatorInternal()->allocateQubits(size);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  sim->checkStateFits(sim->getNumQubitsAllocated() + size);
+  nvqir::SimulatorTimer timer(sim->getExecutionContext());
+  auto qubitIdxs = sim->allocateQubits(size);
   return vectorSizetToArray(qubitIdxs);
 }
 
@@ -179,15 +305,9 @@ void __quantum__rt__qubit_release_array(Array *arr) {
     auto arrayPtr = (*arr)[i];
     Qubit *idxVal = *reinterpret_cast<Qubit **>(arrayPtr);
     nvqir::getCircuitSimulatorInternal()->deallocate(idxVal->idx);
-    delete idxVal;
+    nvqir::qubitPool.release(idxVal);
   }
-  auto begin = nvqir::allocatedArrays.begin();
-  auto end = nvqir::allocatedArrays.end();
-  nvqir::allocatedArrays.erase(
-      std::remove_if(
-          begin, end,
-          [&](std::unique_ptr<Array> &array) { return arr == array.get(); }),
-      end);
+  nvqir::arrayPool.release(arr);
   return;
 }
 
@@ -196,10 +316,11 @@ void __quantum__rt__qubit_release_array(Array *arr) {
 Qubit *__quantum__rt__qubit_allocate() {
   cudaq::ScopedTrace trace("NVQIR::allocate_qubit");
   __quantum__rt__initialize(0, nullptr);
-  auto qubitIdx = nvqir::getCircuitSimulatorInternal()->allocateQubit();
-  auto qubit = std::make_unique<Qubit>(qubitIdx);
-  nvqir::allocatedSingleQubits.emplace_back(std::move(qubit));
-  return nvqir::allocatedSingleQubits.back().get();
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  sim->checkStateFits(sim->getNumQubitsAllocated() + 1);
+  nvqir::SimulatorTimer timer(sim->getExecutionContext());
+  auto qubitIdx = sim->allocateQubit();
+  return nvqir::acquireQubit(qubitIdx);
 }
 
 /// @brief Once done, release that qubit
@@ -207,58 +328,65 @@ Qubit *__quantum__rt__qubit_allocate() {
 void __quantum__rt__qubit_release(Qubit *q) {
   cudaq::ScopedTrace trace("NVQIR::release_qubit");
   nvqir::getCircuitSimulatorInternal()->deallocate(q->idx);
-  auto begin = nvqir::allocatedSingleQubits.begin();
-  auto end = nvqir::allocatedSingleQubits.end();
-  nvqir::allocatedSingleQubits.erase(
-      std::remove_if(begin, end,
-                     [&](std::unique_ptr<Qubit> &qq) { return q == qq.get(); }),
-      end);
+  nvqir::qubitPool.release(q);
 }
 
-#define ONE_QUBIT_QIS_FUNCTION(GATENAME)                                       \
+#define ONE_QUBIT_QIS_FUNCTION(GATENAME, ADJOINT)                              \
   void QIS_FUNCTION_NAME(GATENAME)(Qubit * qubit) {                            \
     auto targetIdx = qubitToSizeT(qubit);                                      \
-    cudaq::ScopedTrace trace("NVQIR::" + std::string(#GATENAME), targetIdx);   \
-    nvqir::getCircuitSimulatorInternal()->GATENAME(targetIdx);                 \
+    cudaq::ScopedTrace trace("NVQIR::" #GATENAME, targetIdx);                  \
+    cudaq::profiler::ScopedEvent event("NVQIR::" #GATENAME,                    \
+                                       cudaq::profiler::Category::gate);       \
+    auto *sim = nvqir::getCircuitSimulatorInternal();                          \
+    nvqir::applyFolded([&] { sim->GATENAME(targetIdx); },                      \
+                       [&] { sim->ADJOINT(targetIdx); });                      \
   }                                                                            \
   void QIS_FUNCTION_CTRL_NAME(GATENAME)(Array * ctrlQubits, Qubit * qubit) {   \
-    auto ctrlIdxs = arrayToVectorSizeT(ctrlQubits);                            \
+    auto &ctrlIdxs = arrayToControls(ctrlQubits);                              \
     auto targetIdx = qubitToSizeT(qubit);                                      \
-    cudaq::ScopedTrace trace("NVQIR::ctrl-" + std::string(#GATENAME),          \
-                             ctrlIdxs, targetIdx);                             \
-    nvqir::getCircuitSimulatorInternal()->GATENAME(ctrlIdxs, targetIdx);       \
+    cudaq::ScopedTrace trace("NVQIR::ctrl-" #GATENAME, ctrlIdxs, targetIdx);   \
+    cudaq::profiler::ScopedEvent event("NVQIR::ctrl-" #GATENAME,               \
+                                       cudaq::profiler::Category::gate);       \
+    auto *sim = nvqir::getCircuitSimulatorInternal();                          \
+    nvqir::applyFolded([&] { sim->GATENAME(ctrlIdxs, targetIdx); },            \
+                       [&] { sim->ADJOINT(ctrlIdxs, targetIdx); });            \
   }                                                                            \
   void QIS_FUNCTION_BODY_NAME(GATENAME)(Qubit * qubit) {                       \
     QIS_FUNCTION_NAME(GATENAME)(qubit);                                        \
   }
 
-ONE_QUBIT_QIS_FUNCTION(h);
-ONE_QUBIT_QIS_FUNCTION(x);
-ONE_QUBIT_QIS_FUNCTION(y);
-ONE_QUBIT_QIS_FUNCTION(z);
-ONE_QUBIT_QIS_FUNCTION(t);
-ONE_QUBIT_QIS_FUNCTION(s);
-ONE_QUBIT_QIS_FUNCTION(tdg);
-ONE_QUBIT_QIS_FUNCTION(sdg);
+ONE_QUBIT_QIS_FUNCTION(h, h);
+ONE_QUBIT_QIS_FUNCTION(x, x);
+ONE_QUBIT_QIS_FUNCTION(y, y);
+ONE_QUBIT_QIS_FUNCTION(z, z);
+ONE_QUBIT_QIS_FUNCTION(t, tdg);
+ONE_QUBIT_QIS_FUNCTION(s, sdg);
+ONE_QUBIT_QIS_FUNCTION(tdg, t);
+ONE_QUBIT_QIS_FUNCTION(sdg, s);
 
 #define ONE_QUBIT_PARAM_QIS_FUNCTION(GATENAME)                                 \
   void QIS_FUNCTION_NAME(GATENAME)(double param, Qubit *qubit) {               \
     auto targetIdx = qubitToSizeT(qubit);                                      \
-    cudaq::ScopedTrace trace("NVQIR::" + std::string(#GATENAME), param,        \
-                             targetIdx);                                       \
-    nvqir::getCircuitSimulatorInternal()->GATENAME(param, targetIdx);          \
+    cudaq::ScopedTrace trace("NVQIR::" #GATENAME, param, targetIdx);           \
+    cudaq::profiler::ScopedEvent event("NVQIR::" #GATENAME,                    \
+                                       cudaq::profiler::Category::gate);       \
+    auto *sim = nvqir::getCircuitSimulatorInternal();                          \
+    nvqir::applyFolded([&] { sim->GATENAME(param, targetIdx); },               \
+                       [&] { sim->GATENAME(-param, targetIdx); });             \
   }                                                                            \
   void QIS_FUNCTION_BODY_NAME(GATENAME)(double param, Qubit *qubit) {          \
     QIS_FUNCTION_NAME(GATENAME)(param, qubit);                                 \
   }                                                                            \
   void QIS_FUNCTION_CTRL_NAME(GATENAME)(double param, Array *ctrlQubits,       \
                                         Qubit *qubit) {                        \
-    auto ctrlIdxs = arrayToVectorSizeT(ctrlQubits);                            \
+    auto &ctrlIdxs = arrayToControls(ctrlQubits);                              \
     auto targetIdx = qubitToSizeT(qubit);                                      \
-    cudaq::ScopedTrace trace("NVQIR::" + std::string(#GATENAME), param,        \
-                             ctrlIdxs, targetIdx);                             \
-    nvqir::getCircuitSimulatorInternal()->GATENAME(param, ctrlIdxs,            \
-                                                   targetIdx);                 \
+    cudaq::ScopedTrace trace("NVQIR::" #GATENAME, param, ctrlIdxs, targetIdx); \
+    cudaq::profiler::ScopedEvent event("NVQIR::" #GATENAME,                    \
+                                       cudaq::profiler::Category::gate);       \
+    auto *sim = nvqir::getCircuitSimulatorInternal();                          \
+    nvqir::applyFolded([&] { sim->GATENAME(param, ctrlIdxs, targetIdx); },     \
+                       [&] { sim->GATENAME(-param, ctrlIdxs, targetIdx); });   \
   }
 
 ONE_QUBIT_PARAM_QIS_FUNCTION(rx);
@@ -266,41 +394,220 @@ ONE_QUBIT_PARAM_QIS_FUNCTION(ry);
 ONE_QUBIT_PARAM_QIS_FUNCTION(rz);
 ONE_QUBIT_PARAM_QIS_FUNCTION(r1);
 
+void __quantum__qis__u2(double phi, double lambda, Qubit *qubit) {
+  auto targetIdx = qubitToSizeT(qubit);
+  cudaq::ScopedTrace trace("NVQIR::u2", phi, lambda, targetIdx);
+  cudaq::profiler::ScopedEvent event("NVQIR::u2",
+                                     cudaq::profiler::Category::gate);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  // u2(φ, λ) is u3(π/2, φ, λ), whose adjoint is u3(-π/2, -λ, -φ).
+  nvqir::applyFolded([&] { sim->u2(phi, lambda, targetIdx); },
+                     [&] { sim->u3(-M_PI_2, -lambda, -phi, targetIdx); });
+}
+
+void __quantum__qis__u3(double theta, double phi, double lambda,
+                        Qubit *qubit) {
+  auto targetIdx = qubitToSizeT(qubit);
+  cudaq::ScopedTrace trace("NVQIR::u3", theta, phi, lambda, targetIdx);
+  cudaq::profiler::ScopedEvent event("NVQIR::u3",
+                                     cudaq::profiler::Category::gate);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  nvqir::applyFolded([&] { sim->u3(theta, phi, lambda, targetIdx); },
+                     [&] { sim->u3(-theta, -lambda, -phi, targetIdx); });
+}
+
 void __quantum__qis__swap(Qubit *q, Qubit *r) {
   auto qI = qubitToSizeT(q);
   auto rI = qubitToSizeT(r);
   cudaq::ScopedTrace trace("NVQIR::swap", qI, rI);
-  nvqir::getCircuitSimulatorInternal()->swap(qI, rI);
+  cudaq::profiler::ScopedEvent event("NVQIR::swap",
+                                     cudaq::profiler::Category::gate);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  nvqir::applyFolded([&] { sim->swap(qI, rI); }, [&] { sim->swap(qI, rI); });
 }
 void __quantum__qis__swap__body(Qubit *q, Qubit *r) {
   __quantum__qis__swap(q, r);
 }
 
+/// @brief Move the state of `qubits[i]` to `qubits[permutation[i]]`, for each
+/// of the `count` qubits. Simulators that can permute qubits do so at once
+/// rather than swap by swap.
+void __nvqir__permuteQubits(Qubit **qubits, const std::size_t *permutation,
+                            std::size_t count) {
+  std::vector<std::size_t> qubitIdxs(count);
+  for (std::size_t i = 0; i < count; i++)
+    qubitIdxs[i] = qubitToSizeT(qubits[i]);
+  std::vector<std::size_t> forward(permutation, permutation + count);
+  std::vector<std::size_t> inverse(count);
+  for (std::size_t i = 0; i < count; i++)
+    if (forward[i] < count)
+      inverse[forward[i]] = i;
+  cudaq::ScopedTrace trace("NVQIR::permute", qubitIdxs, forward);
+  cudaq::profiler::ScopedEvent event("NVQIR::permute",
+                                     cudaq::profiler::Category::gate);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  nvqir::applyFolded([&] { sim->permuteQubits(qubitIdxs, forward); },
+                     [&] { sim->permuteQubits(qubitIdxs, inverse); });
+}
+
+/// @brief Put the `count` qubits, fresh qubits in |0>, in the state with the
+/// 2^count normalized `amplitudes`, bit j of the amplitude index being the
+/// value of `qubits[j]`. Simulators that can write the amplitudes do so,
+/// instead of applying a state preparation circuit.
+void __nvqir__initializeState(Qubit **qubits, std::size_t count,
+                              const std::complex<double> *amplitudes) {
+  std::vector<std::size_t> qubitIdxs(count);
+  for (std::size_t i = 0; i < count; i++)
+    qubitIdxs[i] = qubitToSizeT(qubits[i]);
+  cudaq::ScopedTrace trace("NVQIR::initialize_state", qubitIdxs);
+  cudaq::profiler::ScopedEvent event("NVQIR::initialize_state",
+                                     cudaq::profiler::Category::gate);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  nvqir::SimulatorTimer timer(sim->getExecutionContext());
+  sim->initializeState(qubitIdxs, amplitudes);
+}
+
+/// @brief Put each of the `nTargets` variadic target Qubit pointers, fresh
+/// qubits in |0>, in the state `(re0 + i im0) |0> + (re1 + i im1) |1>`, as
+/// found at the start of a kernel by the `quake-product-state` pass.
+void __quantum__qis__product_state(double re0, double im0, double re1,
+                                   double im1, const std::size_t nTargets,
+                                   ...) {
+  std::vector<std::size_t> targetIdxs(nTargets);
+  va_list args;
+  va_start(args, nTargets);
+  for (auto &idx : targetIdxs)
+    idx = qubitToSizeT(va_arg(args, Qubit *));
+  va_end(args);
+
+  const std::array<std::complex<double>, 2> state = {
+      std::complex<double>(re0, im0), std::complex<double>(re1, im1)};
+  cudaq::ScopedTrace trace("NVQIR::product_state", targetIdxs);
+  cudaq::profiler::ScopedEvent event("NVQIR::product_state",
+                                     cudaq::profiler::Category::gate);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  if (nvqir::foldPairs == 0) {
+    sim->prepareProductState(state, targetIdxs);
+    return;
+  }
+  // Folded, each qubit is prepared by its gates.
+  auto [theta, phi] = nvqir::CircuitSimulator::getProductStateAngles(state);
+  for (auto idx : targetIdxs) {
+    nvqir::applyFolded([&] { sim->ry(theta, idx); },
+                       [&] { sim->ry(-theta, idx); });
+    nvqir::applyFolded([&] { sim->r1(phi, idx); },
+                       [&] { sim->r1(-phi, idx); });
+  }
+}
+
+/// @brief Apply the unitary of a block of gates fused at compile time to the
+/// variadic list of `nTargets` target Qubit pointers. The row major matrix
+/// holds interleaved real and imaginary parts, bit `j` of its row (or column)
+/// index corresponds to the `j`-th target.
+void __quantum__qis__custom_unitary(const double *unitary,
+                                    const std::size_t nTargets, ...) {
+  std::vector<std::size_t> targetIdxs(nTargets);
+  va_list args;
+  va_start(args, nTargets);
+  for (auto &idx : targetIdxs)
+    idx = qubitToSizeT(va_arg(args, Qubit *));
+  va_end(args);
+
+  const std::size_t dim = 1ULL << nTargets;
+  const auto *elements =
+      reinterpret_cast<const std::complex<double> *>(unitary);
+  std::vector<std::complex<double>> matrix(elements, elements + dim * dim);
+  cudaq::ScopedTrace trace("NVQIR::custom_unitary", targetIdxs);
+  cudaq::profiler::ScopedEvent event("NVQIR::custom_unitary",
+                                     cudaq::profiler::Category::gate);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  if (nvqir::foldPairs == 0) {
+    sim->applyCustomUnitary(matrix, targetIdxs);
+    return;
+  }
+  std::vector<std::complex<double>> adjoint(dim * dim);
+  for (std::size_t i = 0; i < dim; i++)
+    for (std::size_t j = 0; j < dim; j++)
+      adjoint[i * dim + j] = std::conj(matrix[j * dim + i]);
+  nvqir::applyFolded([&] { sim->applyCustomUnitary(matrix, targetIdxs); },
+                     [&] { sim->applyCustomUnitary(adjoint, targetIdxs); });
+}
+
 void __quantum__qis__cphase(double d, Qubit *q, Qubit *r) {
   auto qI = qubitToSizeT(q);
   auto rI = qubitToSizeT(r);
-  std::vector<std::size_t> ctrls{qI};
-  nvqir::getCircuitSimulatorInternal()->r1(d, ctrls, rI);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  nvqir::applyFolded([&] { sim->r1(d, qubitToControls(qI), rI); },
+                     [&] { sim->r1(-d, qubitToControls(qI), rI); });
 }
 
 void __quantum__qis__cnot(Qubit *q, Qubit *r) {
   auto qI = qubitToSizeT(q);
   auto rI = qubitToSizeT(r);
   cudaq::ScopedTrace trace("NVQIR::cnot", qI, rI);
-  std::vector<std::size_t> controls{qI};
-  nvqir::getCircuitSimulatorInternal()->x(controls, rI);
+  cudaq::profiler::ScopedEvent event("NVQIR::cnot",
+                                     cudaq::profiler::Category::gate);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  nvqir::applyFolded([&] { sim->x(qubitToControls(qI), rI); },
+                     [&] { sim->x(qubitToControls(qI), rI); });
 }
 
 void __quantum__qis__reset(Qubit *q) {
   auto qI = qubitToSizeT(q);
   cudaq::ScopedTrace trace("NVQIR::reset", qI);
+  cudaq::profiler::ScopedEvent event("NVQIR::reset",
+                                     cudaq::profiler::Category::gate);
   nvqir::getCircuitSimulatorInternal()->resetQubit(qI);
 }
 
+void __quantum__qis__u2__body(double phi, double lambda, Qubit *qubit) {
+  __quantum__qis__u2(phi, lambda, qubit);
+}
+void __quantum__qis__u3__body(double theta, double phi, double lambda,
+                              Qubit *qubit) {
+  __quantum__qis__u3(theta, phi, lambda, qubit);
+}
+void __quantum__qis__cphase__body(double d, Qubit *q, Qubit *r) {
+  __quantum__qis__cphase(d, q, r);
+}
+void __quantum__qis__cnot__body(Qubit *q, Qubit *r) {
+  __quantum__qis__cnot(q, r);
+}
+void __quantum__qis__reset__body(Qubit *q) { __quantum__qis__reset(q); }
+
+/// @brief Base profile measurement, storing the bit in the static result.
+/// @param q
+/// @param r
+void __quantum__qis__mz__body(Qubit *q, Result *r) {
+  auto qI = qubitToSizeT(q);
+  auto rI = resultToSizeT(r);
+  cudaq::ScopedTrace trace("NVQIR::mz", qI);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  nvqir::SimulatorTimer timer(sim->getExecutionContext());
+  staticResults[rI] = sim->mz(qI, "");
+}
+
+/// @brief Return the bit stored in a base profile static result.
+/// @param r
+/// @return
+bool __quantum__qis__read_result__body(Result *r) {
+  return staticResults[resultToSizeT(r)];
+}
+
+/// @brief Base profile output recording. The recorded bits of the kernel
+/// last run are returned by `__nvqir__runBaseProfileKernel`.
+void __quantum__rt__array_start_record_output() { recordedResults.clear(); }
+void __quantum__rt__result_record_output(Result *r, int8_t *) {
+  recordedResults.push_back(staticResults[resultToSizeT(r)]);
+}
+void __quantum__rt__array_end_record_output() {}
+
 Result *__quantum__qis__mz(Qubit *q) {
   auto qI = qubitToSizeT(q);
   cudaq::ScopedTrace trace("NVQIR::mz", qI);
-  auto b = nvqir::getCircuitSimulatorInternal()->mz(qI, "");
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  nvqir::SimulatorTimer timer(sim->getExecutionContext());
+  auto b = sim->mz(qI, "");
   return b ? ResultOne : ResultZero;
 }
 
@@ -308,26 +615,180 @@ Result *__quantum__qis__mz__to__register(Qubit *q, const char *name) {
   std::string regName(name);
   auto qI = qubitToSizeT(q);
   cudaq::ScopedTrace trace("NVQIR::mz", qI, regName);
-  auto b = nvqir::getCircuitSimulatorInternal()->mz(qI, regName);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  nvqir::SimulatorTimer timer(sim->getExecutionContext());
+  auto b = sim->mz(qI, regName);
   return b ? ResultOne : ResultZero;
 }
 
-/// @brief Map an Array pointer containing Paulis to a vector of Paulis.
+/// @brief Measure the `count` qubits of a register at once, writing their bits
+/// to `results`.
+void __nvqir__mzQubits(Qubit **qubits, std::size_t count, bool *results) {
+  std::vector<std::size_t> qubitIdxs(count);
+  for (std::size_t i = 0; i < count; i++)
+    qubitIdxs[i] = qubitToSizeT(qubits[i]);
+  cudaq::ScopedTrace trace("NVQIR::mz", qubitIdxs);
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  nvqir::SimulatorTimer timer(sim->getExecutionContext());
+  auto bits = sim->mz(qubitIdxs, "");
+  std::copy(bits.begin(), bits.end(), results);
+}
+
+/// @brief Measure all the qubits of the array at once, writing their bits
+/// to `results`. Emitted by the compiler for the measurement of a whole
+/// register.
+void __quantum__qis__mz__array(Array *qubits, bool *results) {
+  std::vector<Qubit *> qubitPtrs(qubits->size());
+  for (std::size_t i = 0; i < qubitPtrs.size(); i++)
+    qubitPtrs[i] = *reinterpret_cast<Qubit **>((*qubits)[i]);
+  __nvqir__mzQubits(qubitPtrs.data(), qubitPtrs.size(), results);
+}
+
+/// @brief Map an Array pointer containing the data representation of a
+/// spin_op (see spin_op::getDataRepresentation()) back to the spin_op.
 /// @param paulis
 /// @return
-static std::vector<Pauli> extractPauliTermIds(Array *paulis) {
-  std::vector<Pauli> pauliIds;
-  // size - 3 bc we don't want coeff.real coeff.imag or nterms
-  for (std::size_t i = 0; i < paulis->size() - 3; ++i) {
-    auto ptr = (*paulis)[i];
-    double *casted_and_deref = reinterpret_cast<double *>(ptr);
-    Pauli tmp = static_cast<Pauli>(*casted_and_deref);
-    pauliIds.emplace_back(tmp);
+static cudaq::spin_op extractSpinOp(Array *paulis) {
+  std::vector<double> data(paulis->size());
+  for (std::size_t i = 0; i < data.size(); ++i)
+    data[i] = *reinterpret_cast<double *>((*paulis)[i]);
+  auto nTerms = static_cast<std::size_t>(data.back());
+  return cudaq::spin_op(data, (data.size() - 1 - 2 * nTerms) / nTerms);
+}
+
+/// @brief Measure every term of the spin_op on the current state of the
+/// simulator. The qubit-wise commuting terms of a group are measured
+/// together, with a single basis change and, if sampling, a single set of
+/// shots whose marginal counts give the counts and expectation value of each
+/// term. The same pass gives the covariances of the terms of a group, which
+/// are appended to `covariances`. The result of each term is returned at its
+/// index in `op`.
+/// @param simulator
+/// @param op
+/// @param shots
+/// @param covariances
+/// @return
+static std::vector<cudaq::ExecutionResult>
+measureSpinOpTerms(nvqir::CircuitSimulator &simulator, cudaq::spin_op &op,
+                   int shots, std::vector<cudaq::shot_covariance> &covariances) {
+  const auto nQubits = op.n_qubits();
+  std::vector<cudaq::ExecutionResult> results(op.n_terms());
+  for (std::size_t t = 0; t < results.size(); ++t) {
+    results[t].registerName = op.get_term(t).to_string(false);
+    // Identity terms are not part of any group.
+    results[t].expectationValue = 1.0;
   }
-  return pauliIds;
+
+  auto measures = [&](std::size_t t, std::size_t q) {
+    return op.get_term(t).get_pauli(q) != cudaq::pauli::I;
+  };
+
+  // The scratch buffers are reused by every group, so their memory is only
+  // allocated for the largest group.
+  std::vector<std::size_t> groupQubits, termQubits;
+  std::vector<std::vector<std::size_t>> bitPositions;
+  std::vector<std::uint64_t> masks, termBits;
+  std::vector<double> sums, parities, pairSums;
+
+  for (auto &group : op.get_qubit_wise_commuting_groups()) {
+    auto groupBasis = cudaq::details::getMeasurementBasis(op, group);
+    groupQubits.clear();
+    for (std::size_t q = 0; q < nQubits; ++q) {
+      if (!groupBasis[q] && !groupBasis[q + nQubits])
+        continue;
+      groupQubits.push_back(q);
+      if (groupBasis[q] && groupBasis[q + nQubits])
+        simulator.rx(M_PI_2, q);
+      else if (groupBasis[q])
+        simulator.h(q);
+    }
+
+    auto groupResult = shots > 0 ? simulator.sample(groupQubits, shots)
+                                 : cudaq::ExecutionResult();
+    groupResult.packCounts();
+    const std::size_t nTerms = group.size();
+    if (bitPositions.size() < nTerms)
+      bitPositions.resize(nTerms);
+    for (std::size_t g = 0; g < nTerms; ++g) {
+      bitPositions[g].clear();
+      termQubits.clear();
+      for (std::size_t i = 0; i < groupQubits.size(); ++i)
+        if (measures(group[g], groupQubits[i])) {
+          termQubits.push_back(groupQubits[i]);
+          bitPositions[g].push_back(i);
+        }
+      if (shots < 1)
+        results[group[g]].expectationValue =
+            simulator.sample(termQubits, 0).expectationValue;
+    }
+
+    if (shots > 0) {
+      // Marginalize the packed group outcomes onto the bits of each term,
+      // summing the parities of the terms and of their pairs.
+      auto &groupCounts = groupResult.packedCounts;
+      const auto nWords = groupCounts.n_words();
+      masks.assign(nTerms * nWords, 0);
+      std::vector<cudaq::PackedCounts> termCounts;
+      for (std::size_t g = 0; g < nTerms; ++g) {
+        for (auto i : bitPositions[g])
+          masks[g * nWords + i / 64] |= 1ULL << (i % 64);
+        termCounts.emplace_back(bitPositions[g].size());
+      }
+      sums.assign(nTerms, 0.0);
+      parities.resize(nTerms);
+      pairSums.assign(nTerms * (nTerms - 1) / 2, 0.0);
+      for (std::size_t k = 0; k < groupCounts.size(); ++k) {
+        const auto *key = groupCounts.key(k);
+        const double count = groupCounts.count(k);
+        for (std::size_t g = 0; g < nTerms; ++g) {
+          std::size_t ones = 0;
+          for (std::size_t w = 0; w < nWords; ++w)
+            ones += std::popcount(key[w] & masks[g * nWords + w]);
+          parities[g] = ones % 2 ? -1.0 : 1.0;
+          sums[g] += parities[g] * count;
+
+          termBits.assign(termCounts[g].n_words(), 0);
+          for (std::size_t j = 0; j < bitPositions[g].size(); ++j)
+            if (groupCounts.bit(k, bitPositions[g][j]))
+              termBits[j / 64] |= 1ULL << (j % 64);
+          termCounts[g].add(termBits.data(), groupCounts.count(k));
+        }
+        for (std::size_t a = 0, pair = 0; a < nTerms; ++a)
+          for (std::size_t b = a + 1; b < nTerms; ++b)
+            pairSums[pair++] += parities[a] * parities[b] * count;
+      }
+
+      for (std::size_t g = 0; g < nTerms; ++g) {
+        results[group[g]].packedCounts = std::move(termCounts[g]);
+        results[group[g]].expectationValue = sums[g] / shots;
+      }
+      for (std::size_t a = 0, pair = 0; a < nTerms; ++a)
+        for (std::size_t b = a + 1; b < nTerms; ++b) {
+          const double covariance =
+              pairSums[pair++] / shots - sums[a] / shots * sums[b] / shots;
+          if (covariance != 0.0)
+            covariances.push_back({results[group[a]].registerName,
+                                   results[group[b]].registerName,
+                                   covariance});
+        }
+    }
+
+    // Reverse the measurements bases change.
+    for (auto it = groupQubits.rbegin(); it != groupQubits.rend(); ++it) {
+      if (groupBasis[*it] && groupBasis[*it + nQubits])
+        simulator.rx(-M_PI_2, *it);
+      else if (groupBasis[*it])
+        simulator.h(*it);
+    }
+  }
+
+  return results;
 }
 
-/// @brief QIR function measuring the qubit state in the given Pauli basis.
+/// @brief QIR function measuring the qubit state in the Pauli basis of each
+/// term of the given spin_op. The state prepared by the kernel is reused for
+/// all terms, the context receives the result of every term and the total
+/// expectation value.
 /// @param pauli_arr
 /// @param qubits
 /// @return
@@ -337,9 +798,37 @@ Result *__quantum__qis__measure__body(Array *pauli_arr, Array *qubits) {
 
   auto *circuitSimulator = nvqir::getCircuitSimulatorInternal();
   auto currentContext = circuitSimulator->getExecutionContext();
+  nvqir::SimulatorTimer timer(currentContext);
 
   // Some backends may better handle the observe task.
   // Let's give them that opportunity.
+  if (currentContext->canHandleObserve && currentContext->termExpectations) {
+    // Each term on its own, with a result named like the measured terms.
+    auto &op = *currentContext->spin.value();
+    double sum = 0.0;
+    std::vector<cudaq::ExecutionResult> results;
+    for (std::size_t t = 0; t < op.n_terms(); ++t) {
+      auto term = op.get_term(t);
+      const double coefficient = term.get_coefficient().real();
+      if (term.is_identity()) {
+        sum += coefficient;
+        continue;
+      }
+      std::vector<cudaq::spin_op_builder::factor> factors;
+      for (std::size_t q = 0; q < op.n_qubits(); ++q)
+        if (auto p = term.get_pauli(q); p != cudaq::pauli::I)
+          factors.emplace_back(p, q);
+      auto unit = cudaq::spin_op_builder().add(1.0, factors).build();
+      auto &result = results.emplace_back(circuitSimulator->observe(unit));
+      result.registerName = term.to_string(false);
+      sum += coefficient * result.expectationValue.value_or(0.0);
+    }
+    if (results.empty())
+      results.emplace_back(sum);
+    currentContext->expectationValue = sum;
+    currentContext->result = cudaq::sample_result(sum, results);
+    return ResultZero;
+  }
   if (currentContext->canHandleObserve) {
     auto result = circuitSimulator->observe(*currentContext->spin.value());
     currentContext->expectationValue = result.expectationValue;
@@ -347,208 +836,85 @@ Result *__quantum__qis__measure__body(Array *pauli_arr, Array *qubits) {
     return ResultZero;
   }
 
-  const auto paulis = extractPauliTermIds(pauli_arr);
-  std::vector<std::size_t> qubits_to_measure;
-  std::vector<std::pair<std::string, std::size_t>> reverser;
-  for (size_t i = 0; i < paulis.size(); ++i) {
-    const auto pauli = paulis[i];
-    switch (pauli) {
-    case Pauli::Pauli_I:
-      break;
-    case Pauli::Pauli_X: {
-
-      circuitSimulator->h(i);
-      qubits_to_measure.push_back(i);
-      reverser.push_back({"X", i});
-      break;
-    }
-    case Pauli::Pauli_Y: {
-      double angle = M_PI_2;
-      circuitSimulator->rx(angle, i);
-      qubits_to_measure.push_back(i);
-      reverser.push_back({"Y", i});
-
-      break;
-    }
-    case Pauli::Pauli_Z: {
-      qubits_to_measure.push_back(i);
-      break;
-    }
-    }
-  }
-
   int shots = 0;
   if (currentContext->shots > 0) {
     shots = currentContext->shots;
   }
 
-  // Sample and give the data to the context
-  cudaq::ExecutionResult result =
-      circuitSimulator->sample(qubits_to_measure, shots);
-  currentContext->expectationValue = result.expectationValue;
-  currentContext->result = cudaq::sample_result(result);
-
-  // Reverse the measurements bases change.
-  if (!reverser.empty()) {
-    cudaq::info("NVQIR reverse pauli bases change for measurement.");
-    for (auto it = reverser.rbegin(); it != reverser.rend(); ++it) {
-      if (it->first == "X") {
-        circuitSimulator->h(it->second);
-      } else if (it->first == "Y") {
-        double angle = -M_PI_2;
-        circuitSimulator->rx(angle, it->second);
-      }
-    }
+  auto op = extractSpinOp(pauli_arr);
+  currentContext->shotCovariances.clear();
+  auto results = measureSpinOpTerms(*circuitSimulator, op, shots,
+                                    currentContext->shotCovariances);
+  double sum = 0.0;
+  std::vector<cudaq::ExecutionResult> measured;
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    sum += op.get_term_coefficient(i).real() *
+           results[i].expectationValue.value_or(0.0);
+    if (!op[i].is_identity())
+      measured.push_back(results[i]);
   }
 
+  // Identity terms have no counts, keep them out of the sample_result.
+  if (measured.empty())
+    measured.emplace_back(sum);
+  currentContext->expectationValue = sum;
+  currentContext->result = cudaq::sample_result(sum, measured);
   return ResultZero;
 }
 
-/// @brief Implementation of first order trotterization
-/// enables exp( i * angle * H), where H = Sum (PauliTensorProduct)
+/// @brief Apply the Suzuki product formula of the given order and number of
+/// steps approximating exp(-i angle / 2 H), where H = Sum (PauliTensorProduct)
+/// (see nvqir::trotterize()).
 /// @param paulis
 /// @param angle
 /// @param qubits
-void __quantum__qis__exp__body(Array *paulis, double angle, Array *qubits) {
-  auto n_qubits = qubits->size();
-  cudaq::ScopedTrace trace("NVQIR::exp_body");
-
-  // if identity, do nothing
-  std::vector<int> test;
-  for (std::size_t i = 0; i < paulis->size() - 1; i += n_qubits + 2) {
-    for (std::size_t j = 0; j < n_qubits; j++) {
-      auto ptr = (*paulis)[i + j];
-      double *casted_and_deref = reinterpret_cast<double *>(ptr);
-      int val = (int)*casted_and_deref;
-      test.push_back(val);
-    }
-  }
-
-  if (std::all_of(test.begin(), test.end(), [](int i) { return i == 0; })) {
-    // do nothing since this is the ID term
-    std::string msg = "Applying exp (i theta H), where H is the identity";
-    msg += "(warning, no non-identity terms in H. Not applying exp())";
-    cudaq::info(msg.c_str());
+/// @param order
+/// @param steps
+void __quantum__qis__exp__suzuki__body(Array *paulis, double angle,
+                                       Array *qubits, int64_t order,
+                                       int64_t steps) {
+  cudaq::ScopedTrace trace("NVQIR::exp_suzuki_body", order, steps);
+  if (order < 1 || steps < 1)
+    throw std::runtime_error("Invalid product formula order " +
+                             std::to_string(order) + " or steps " +
+                             std::to_string(steps) + " for exp().");
+
+  std::vector<std::size_t> qubitIdxs(qubits->size());
+  for (std::size_t i = 0; i < qubitIdxs.size(); i++)
+    qubitIdxs[i] = (*reinterpret_cast<Qubit **>((*qubits)[i]))->idx;
+
+  auto rotations = nvqir::trotterize(extractSpinOp(paulis), angle, order, steps);
+  if (rotations.empty()) {
+    cudaq::info("Applying exp (i theta H), where H is the identity (warning, "
+                "no non-identity terms in H. Not applying exp())");
     return;
   }
+  nvqir::applyPauliRotations(*nvqir::getCircuitSimulatorInternal(), rotations,
+                             qubitIdxs);
+}
 
-  enum QISInstructionType { H, Rx, CX, Rz };
-  using QISInstruction =
-      std::tuple<QISInstructionType, std::vector<Qubit *>, double>;
-  // Want to map logical qubit idxs to those in the qubits Array
-  std::map<std::size_t, std::size_t> qubit_map;
-  std::map<std::size_t, Qubit *> idx_to_qptr;
-  for (std::size_t i = 0; i < n_qubits; i++) {
-    Qubit *q = *reinterpret_cast<Qubit **>((*qubits)[i]);
-    qubit_map.insert({i, q->idx});
-    idx_to_qptr.insert({q->idx, q});
-  }
-
-  // size -1 bc last element is NTERMS
-  for (std::size_t i = 0; i < paulis->size() - 1; i += n_qubits + 2) {
-    std::vector<QISInstruction> basis_back;
-    std::vector<std::size_t> qIdxs;
-
-    for (std::size_t j = 0; j < n_qubits; j++) {
-      // Get what type of pauli this is
-      auto ptr = (*paulis)[i + j];
-      double *casted_and_deref = reinterpret_cast<double *>(ptr);
-      int val = (int)*casted_and_deref;
-      qIdxs.push_back(qubit_map[j]);
-
-      // Get the Qubit pointer
-      Qubit *q = idx_to_qptr[qubit_map[j]];
-      if (val == 1) {
-
-        nvqir::getCircuitSimulatorInternal()->h(q->idx);
-        basis_back.emplace_back(std::make_tuple(QISInstructionType::H,
-                                                std::vector<Qubit *>{q}, 0.0));
-      } else if (val == 3) {
-        double param = M_PI / 2.;
-        nvqir::getCircuitSimulatorInternal()->rx(param, q->idx);
-        basis_back.emplace_back(std::make_tuple(
-            QISInstructionType::Rx, std::vector<Qubit *>{q}, -M_PI / 2.));
-      }
-    }
-
-    std::vector<std::vector<int>> cnot_pairs(
-        2, std::vector<int>(qIdxs.size() - 1));
-    for (std::size_t i = 0; i < qIdxs.size() - 1; i++) {
-      cnot_pairs[0][i] = qIdxs[i];
-    }
-    for (std::size_t i = 0; i < qIdxs.size() - 1; i++) {
-      cnot_pairs[1][i] = qIdxs[i + 1];
-    }
-
-    std::vector<QISInstruction> cnot_back;
-    for (std::size_t i = 0; i < qIdxs.size() - 1; i++) {
-      auto c = cnot_pairs[0][i];
-      auto t = cnot_pairs[1][i];
-      auto q1 = idx_to_qptr[c];
-      auto q2 = idx_to_qptr[t];
-      std::vector<std::size_t> controls{(q1->idx)};
-      nvqir::getCircuitSimulatorInternal()->x(controls, q2->idx);
-    }
-
-    for (int i = qIdxs.size() - 2; i >= 0; i--) {
-      auto c = cnot_pairs[0][i];
-      auto t = cnot_pairs[1][i];
-      auto q1 = idx_to_qptr[c];
-      auto q2 = idx_to_qptr[t];
-
-      cnot_back.emplace_back(std::make_tuple(
-          QISInstructionType::CX, std::vector<Qubit *>{q1, q2}, 0.0));
-    }
-
-    auto ptr = (*paulis)[i + n_qubits];
-    double *casted_and_deref_real = reinterpret_cast<double *>(ptr);
-    ptr = (*paulis)[i + n_qubits + 1];
-    double *casted_and_deref_imag = reinterpret_cast<double *>(ptr);
-
-    std::complex<double> coeff(*casted_and_deref_real, *casted_and_deref_imag);
-    double param = coeff.real() * angle;
-    nvqir::getCircuitSimulatorInternal()->rz(param,
-                                             idx_to_qptr[qIdxs.back()]->idx);
-
-    for (auto cxb : cnot_back) {
-      auto qs = std::get<1>(cxb);
-      std::vector<std::size_t> controls{(qs[0]->idx)};
-      nvqir::getCircuitSimulatorInternal()->x(controls, qs[1]->idx);
-    }
-
-    for (auto bb : basis_back) {
-      auto type = std::get<0>(bb);
-      auto qs = std::get<1>(bb);
-      auto ps = std::get<2>(bb);
-      if (type == QISInstructionType::H) {
-        nvqir::getCircuitSimulatorInternal()->h(qs[0]->idx);
-      } else {
-        nvqir::getCircuitSimulatorInternal()->rx(ps, qs[0]->idx);
-      }
-    }
-  }
+/// @brief Implementation of first order trotterization
+/// enables exp( i * angle * H), where H = Sum (PauliTensorProduct)
+/// @param paulis
+/// @param angle
+/// @param qubits
+void __quantum__qis__exp__body(Array *paulis, double angle, Array *qubits) {
+  __quantum__qis__exp__suzuki__body(paulis, angle, qubits, 1, 1);
 }
 
 /// @brief Utility function used by Quake->QIR to pack a single Qubit pointer
 /// into an Array pointer.
 Array *packSingleQubitInArray(Qubit *q) {
-  auto newArray = std::make_unique<Array>(1, sizeof(std::size_t));
+  auto newArray = nvqir::acquireQubitArray(1);
   auto arrayPtr = (*newArray)[0];
   *reinterpret_cast<Qubit **>(arrayPtr) = q;
-  nvqir::allocatedArrays.emplace_back(std::move(newArray));
-  return nvqir::allocatedArrays.back().get();
+  return newArray;
 }
 
 /// @brief Utility function used by Quake->QIR to release any created Array from
 /// Qubit packing after its been used
 void releasePackedQubitArray(Array *a) {
-  auto begin = nvqir::allocatedArrays.begin();
-  auto end = nvqir::allocatedArrays.end();
-  nvqir::allocatedArrays.erase(
-      std::remove_if(
-          begin, end,
-          [&](std::unique_ptr<Array> &array) { return a == array.get(); }),
-      end);
+  nvqir::arrayPool.release(a);
   return;
 }
 
@@ -560,8 +926,8 @@ void releasePackedQubitArray(Array *a) {
 void invokeWithControlQubits(const std::size_t nControls,
                              void (*QISFunction)(Array *, Qubit *), ...) {
   // Create the Control Array *, This should
-  // be deallocated upon function exit.
-  auto ctrlArray = std::make_unique<Array>(nControls, sizeof(std::size_t));
+  // be released upon function exit.
+  auto ctrlArray = nvqir::acquireQubitArray(nControls);
 
   // Start up the variadic arg processing
   va_list args;
@@ -573,7 +939,7 @@ void invokeWithControlQubits(const std::size_t nControls,
     // and set it on the array.
     Qubit *ctrli = va_arg(args, Qubit *);
     auto ctrliRawPtr =
-        __quantum__rt__array_get_element_ptr_1d(ctrlArray.get(), nSetPointers);
+        __quantum__rt__array_get_element_ptr_1d(ctrlArray, nSetPointers);
     *reinterpret_cast<Qubit **>(ctrliRawPtr) = ctrli;
     nSetPointers++;
   }
@@ -581,9 +947,63 @@ void invokeWithControlQubits(const std::size_t nControls,
   // The last one will be the target
   Qubit *target = va_arg(args, Qubit *);
   // Invoke the function
-  QISFunction(ctrlArray.get(), target);
+  QISFunction(ctrlArray, target);
 
   // End the var args processing and release the array.
   va_end(args);
+  nvqir::arrayPool.release(ctrlArray);
+}
+}
+
+namespace nvqir {
+
+/// @brief Run a base profile kernel, whose qubits and results are the static
+/// ids `0` to `requiredQubits - 1` and `0` to `requiredResults - 1` given by
+/// its `requiredQubits` and `requiredResults` attributes. The qubits are
+/// allocated at once before the kernel runs, so the gates only map the static
+/// ids to the simulator qubits, and released after it. Return the bits
+/// recorded by the kernel.
+/// @param kernel
+/// @param requiredQubits
+/// @param requiredResults
+/// @return
+std::vector<bool> runBaseProfileKernel(void (*kernel)(),
+                                       std::uint64_t requiredQubits,
+                                       std::uint64_t requiredResults) {
+  cudaq::ScopedTrace trace("NVQIR::runBaseProfileKernel", requiredQubits,
+                           requiredResults);
+  __quantum__rt__initialize(0, nullptr);
+  if (!staticQubitIdxs.empty())
+    throw std::runtime_error("Base profile kernels cannot be nested.");
+  staticResults.assign(requiredResults, false);
+  recordedResults.clear();
+  if (requiredQubits == 0) {
+    kernel();
+    return recordedResults;
+  }
+
+  auto *sim = nvqir::getCircuitSimulatorInternal();
+  sim->checkStateFits(sim->getNumQubitsAllocated() + requiredQubits);
+  staticQubitIdxs = sim->allocateQubits(requiredQubits);
+  auto release = [&]() {
+    for (auto idx : staticQubitIdxs)
+      sim->deallocate(idx);
+    staticQubitIdxs.clear();
+  };
+  try {
+    kernel();
+  } catch (...) {
+    release();
+    throw;
+  }
+  release();
+  return recordedResults;
 }
+
+/// @brief Throw if the simulation backend cannot hold the state of
+/// `numQubits` qubits, see CircuitSimulator::checkStateFits().
+/// @param numQubits
+void checkStateFits(std::size_t numQubits) {
+  getCircuitSimulatorInternal()->checkStateFits(numQubits);
 }
+} // namespace nvqir
@@ -0,0 +1,240 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "PauliEvolution.h"
+#include "CircuitSimulator.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace nvqir {
+
+namespace {
+/// @brief Append the factor to the formula, merging it into the last factor
+/// if that is of the same Pauli word.
+void appendRotation(std::vector<PauliRotation> &rotations,
+                    const std::vector<cudaq::pauli> &paulis, double angle) {
+  if (!rotations.empty() && rotations.back().paulis == paulis) {
+    rotations.back().angle += angle;
+    return;
+  }
+  rotations.push_back({paulis, angle});
+}
+
+/// @brief Append the factors of the Suzuki formula S_order(t) of the terms,
+/// whose angles are their unit time angles.
+void appendSuzuki(const std::vector<PauliRotation> &terms, double t,
+                  std::size_t order, std::vector<PauliRotation> &rotations) {
+  if (order == 1) {
+    for (auto &term : terms)
+      appendRotation(rotations, term.paulis, term.angle * t);
+    return;
+  }
+  if (order == 2) {
+    for (auto &term : terms)
+      appendRotation(rotations, term.paulis, term.angle * t / 2);
+    for (auto it = terms.rbegin(); it != terms.rend(); ++it)
+      appendRotation(rotations, it->paulis, it->angle * t / 2);
+    return;
+  }
+
+  // S_2k(t) = S_2k-2(p t)^2 S_2k-2((1 - 4 p) t) S_2k-2(p t)^2, with
+  // p = 1 / (4 - 4^(1 / (2k - 1))).
+  const double p = 1.0 / (4.0 - std::pow(4.0, 1.0 / (order - 1)));
+  appendSuzuki(terms, p * t, order - 2, rotations);
+  appendSuzuki(terms, p * t, order - 2, rotations);
+  appendSuzuki(terms, (1 - 4 * p) * t, order - 2, rotations);
+  appendSuzuki(terms, p * t, order - 2, rotations);
+  appendSuzuki(terms, p * t, order - 2, rotations);
+}
+
+/// @brief Return true if the Pauli word is diagonal, i.e. Z-only.
+bool isDiagonal(const std::vector<cudaq::pauli> &paulis) {
+  return std::all_of(paulis.begin(), paulis.end(), [](cudaq::pauli p) {
+    return p == cudaq::pauli::I || p == cudaq::pauli::Z;
+  });
+}
+
+/// @brief A gate of the decomposed Pauli rotations.
+struct Gate {
+  enum Kind { H, Rx, Rz, CX } kind;
+  std::size_t qubit;
+  /// The target of a CX, whose control is `qubit`.
+  std::size_t target = 0;
+  double angle = 0.0;
+
+  bool actsOn(std::size_t q) const {
+    return qubit == q || (kind == CX && target == q);
+  }
+  bool overlaps(const Gate &other) const {
+    return actsOn(other.qubit) || (other.kind == CX && actsOn(other.target));
+  }
+};
+
+/// @brief A circuit that cancels each appended gate against the last gate
+/// acting on one of its qubits, if that is its inverse (or merges it, for
+/// rotations). The gates in between act on other qubits, so they commute.
+class CancellingCircuit {
+  std::vector<Gate> gates;
+
+public:
+  void append(const Gate &gate) {
+    for (auto it = gates.rbegin(); it != gates.rend(); ++it) {
+      if (!it->overlaps(gate))
+        continue;
+      if (it->kind != gate.kind || it->qubit != gate.qubit ||
+          (gate.kind == Gate::CX && it->target != gate.target))
+        break;
+      // H and CX are their own inverse, rotations add up.
+      if (gate.kind == Gate::Rx || gate.kind == Gate::Rz) {
+        it->angle += gate.angle;
+        if (std::abs(it->angle) > 1e-14)
+          return;
+      }
+      gates.erase(std::next(it).base());
+      return;
+    }
+    gates.push_back(gate);
+  }
+
+  std::size_t size() const { return gates.size(); }
+
+  void apply(CircuitSimulator &simulator) const {
+    for (auto &gate : gates) {
+      switch (gate.kind) {
+      case Gate::H:
+        simulator.h(gate.qubit);
+        break;
+      case Gate::Rx:
+        simulator.rx(gate.angle, gate.qubit);
+        break;
+      case Gate::Rz:
+        simulator.rz(gate.angle, gate.qubit);
+        break;
+      case Gate::CX:
+        simulator.x({gate.qubit}, gate.target);
+        break;
+      }
+    }
+  }
+};
+} // namespace
+
+std::vector<PauliRotation> trotterize(const cudaq::spin_op &H, double angle,
+                                      std::size_t order, std::size_t steps) {
+  if (order == 0 || (order > 1 && order % 2))
+    throw std::runtime_error("Suzuki product formulas are of order 1 or of "
+                             "even order, not " +
+                             std::to_string(order) + ".");
+  if (steps == 0)
+    throw std::runtime_error("A product formula needs at least one step.");
+
+  cudaq::spin_op merged = H;
+  merged.simplify();
+  std::vector<PauliRotation> terms;
+  for (auto term : merged.terms()) {
+    if (term.is_identity())
+      continue;
+    PauliRotation rotation;
+    for (std::size_t q = 0; q < merged.n_qubits(); q++)
+      rotation.paulis.push_back(term.get_pauli(q));
+    rotation.angle = term.get_coefficient().real();
+    terms.push_back(std::move(rotation));
+  }
+  std::stable_sort(terms.begin(), terms.end(),
+                   [](const PauliRotation &a, const PauliRotation &b) {
+                     const bool aDiagonal = isDiagonal(a.paulis);
+                     const bool bDiagonal = isDiagonal(b.paulis);
+                     if (aDiagonal != bDiagonal)
+                       return aDiagonal;
+                     return a.paulis < b.paulis;
+                   });
+
+  std::vector<PauliRotation> rotations;
+  for (std::size_t s = 0; s < steps; s++)
+    appendSuzuki(terms, angle / steps, order, rotations);
+  return rotations;
+}
+
+void applyPauliRotations(CircuitSimulator &simulator,
+                         const std::vector<PauliRotation> &rotations,
+                         const std::vector<std::size_t> &qubits) {
+  CancellingCircuit circuit;
+  bool native = true;
+  std::size_t nGates = 0;
+  // The end of the last run of Z-only factors tried as one layer.
+  std::size_t layerEnd = 0;
+  for (std::size_t r = 0; r < rotations.size(); r++) {
+    // A run of Z-only factors commutes and is diagonal, it is one layer of
+    // phases for the simulators that apply those in one sweep.
+    if (native && r >= layerEnd && isDiagonal(rotations[r].paulis)) {
+      std::vector<ZRotation> layer;
+      for (layerEnd = r; layerEnd < rotations.size() &&
+                         isDiagonal(rotations[layerEnd].paulis);
+           layerEnd++) {
+        auto &paulis = rotations[layerEnd].paulis;
+        ZRotation rotation{{}, rotations[layerEnd].angle};
+        for (std::size_t j = 0; j < paulis.size(); j++)
+          if (paulis[j] == cudaq::pauli::Z)
+            rotation.qubits.push_back(qubits[j]);
+        if (!rotation.qubits.empty())
+          layer.push_back(std::move(rotation));
+      }
+      if (layer.size() > 1 && simulator.applyDiagonalPhases(layer)) {
+        cudaq::info("Applied {} Z-only Pauli rotations as one diagonal layer.",
+                    layer.size());
+        r = layerEnd - 1;
+        continue;
+      }
+    }
+
+    auto &rotation = rotations[r];
+    std::vector<std::size_t> support;
+    std::vector<cudaq::pauli> paulis;
+    for (std::size_t j = 0; j < rotation.paulis.size(); j++)
+      if (rotation.paulis[j] != cudaq::pauli::I) {
+        support.push_back(qubits[j]);
+        paulis.push_back(rotation.paulis[j]);
+      }
+    if (support.empty())
+      continue;
+    if (native &&
+        simulator.applyPauliRotation(rotation.angle, support, paulis))
+      continue;
+    native = false;
+
+    for (std::size_t i = 0; i < support.size(); i++)
+      if (paulis[i] == cudaq::pauli::X)
+        circuit.append({Gate::H, support[i]});
+      else if (paulis[i] == cudaq::pauli::Y)
+        circuit.append({Gate::Rx, support[i], 0, M_PI_2});
+    for (std::size_t i = 0; i + 1 < support.size(); i++)
+      circuit.append({Gate::CX, support[i], support[i + 1]});
+    circuit.append({Gate::Rz, support.back(), 0, rotation.angle});
+    for (std::size_t i = support.size() - 1; i > 0; i--)
+      circuit.append({Gate::CX, support[i - 1], support[i]});
+    for (std::size_t i = 0; i < support.size(); i++)
+      if (paulis[i] == cudaq::pauli::X)
+        circuit.append({Gate::H, support[i]});
+      else if (paulis[i] == cudaq::pauli::Y)
+        circuit.append({Gate::Rx, support[i], 0, -M_PI_2});
+    const auto nBasisChanges = std::count_if(
+        paulis.begin(), paulis.end(),
+        [](cudaq::pauli p) { return p != cudaq::pauli::Z; });
+    nGates += 2 * nBasisChanges + 2 * support.size() - 1;
+  }
+
+  if (native)
+    return;
+  cudaq::info("Applying {} Pauli rotations as {} gates ({} cancelled).",
+              rotations.size(), circuit.size(), nGates - circuit.size());
+  circuit.apply(simulator);
+}
+} // namespace nvqir
@@ -0,0 +1,47 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "cudaq/spin_op.h"
+#include <cstddef>
+#include <vector>
+
+namespace nvqir {
+class CircuitSimulator;
+
+/// @brief One factor exp(-i angle / 2 P) of a product formula, where P is the
+/// Pauli word with paulis[j] on the j-th qubit the formula is applied to.
+struct PauliRotation {
+  std::vector<cudaq::pauli> paulis;
+  double angle = 0.0;
+};
+
+/// @brief Return the factors of the Suzuki product formula of the given
+/// order (1 or even) over `steps` steps, approximating exp(-i angle / 2 H),
+/// i.e. term P with coefficient c contributes exp(-i c angle / 2 P). Equal
+/// terms are merged and identity terms, a global phase, are dropped. The
+/// Z-only terms come first, so that they form one diagonal layer, and the
+/// terms are ordered by their Pauli words, so that adjacent terms share the
+/// basis changes and CNOTs of their leading qubits. Adjacent factors of the
+/// same word, like the ends of consecutive second order steps, are merged.
+std::vector<PauliRotation> trotterize(const cudaq::spin_op &H, double angle,
+                                      std::size_t order, std::size_t steps);
+
+/// @brief Apply the factors on the given qubits. Simulators that can apply
+/// diagonal phases (see CircuitSimulator::applyDiagonalPhases()) apply each
+/// run of Z-only factors, like a QAOA cost layer, in one sweep. Simulators
+/// that can apply a Pauli rotation directly (see
+/// CircuitSimulator::applyPauliRotation()) do so in one sweep per factor.
+/// Otherwise each factor is a basis change, a CNOT ladder over the qubits it
+/// acts on, an Rz and their inverses, and the inverse gates that meet across
+/// adjacent factors cancel out.
+void applyPauliRotations(CircuitSimulator &simulator,
+                         const std::vector<PauliRotation> &rotations,
+                         const std::vector<std::size_t> &qubits);
+} // namespace nvqir
@@ -0,0 +1,120 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "cudaq/spin_op.h"
+#include <complex>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// This header is included by the CUDA backends, which are compiled as C++17.
+
+namespace nvqir {
+
+/// @brief The terms of a spin_op that flip the same qubits. Their sum maps
+/// |k> to f(k) |k ^ xMask>, with f(k) = sum_t coefficients[t] (-1)^|k &
+/// zMasks[t]|, where the coefficients include the i^nY of the Y factors. So
+/// <psi| sum_t P_t |psi> = sum_k conj(psi[k ^ xMask]) f(k) psi[k] is a single
+/// sweep over the state for the whole group.
+struct XMaskGroup {
+  std::uint64_t xMask = 0;
+  std::vector<std::uint64_t> zMasks;
+  std::vector<std::complex<double>> coefficients;
+
+  /// @brief The most bits of zUnion() a phase table is built for.
+  static constexpr std::size_t maxTableBits = 20;
+
+  /// @brief Return the bits of the state index that f(k) depends on.
+  std::uint64_t zUnion() const {
+    std::uint64_t mask = 0;
+    for (auto z : zMasks)
+      mask |= z;
+    return mask;
+  }
+
+  /// @brief Return true if looking f(k) up in phaseTable() is cheaper than
+  /// summing the terms for each of the `dim` amplitudes.
+  bool useTable(std::size_t dim) const {
+    const std::size_t nBits = __builtin_popcountll(zUnion());
+    return nBits <= maxTableBits && (1ULL << nBits) <= dim &&
+           zMasks.size() > nBits;
+  }
+
+  /// @brief Return f(k) for every value of the bits of k in zUnion(), packed
+  /// into an index by gatherBits(). The coefficients are summed into the
+  /// entries of their packed Z masks, and a Walsh-Hadamard transform turns
+  /// them into the sums of the signed coefficients.
+  std::vector<std::complex<double>> phaseTable() const {
+    const auto mask = zUnion();
+    const std::size_t size = 1ULL << __builtin_popcountll(mask);
+    std::vector<std::complex<double>> table(size);
+    for (std::size_t t = 0; t < zMasks.size(); t++)
+      table[gatherBits(zMasks[t], mask)] += coefficients[t];
+    for (std::size_t h = 1; h < table.size(); h *= 2)
+      for (std::size_t i = 0; i < table.size(); i += 2 * h)
+        for (std::size_t j = i; j < i + h; j++) {
+          const auto a = table[j], b = table[j + h];
+          table[j] = a + b;
+          table[j + h] = a - b;
+        }
+    return table;
+  }
+
+  /// @brief Return the bits of `k` in `mask`, packed into the low bits.
+  static std::size_t gatherBits(std::uint64_t k, std::uint64_t mask) {
+    std::size_t packed = 0;
+    for (std::size_t j = 0; mask; mask &= mask - 1, j++)
+      packed |= static_cast<std::size_t>(k >> __builtin_ctzll(mask) & 1) << j;
+    return packed;
+  }
+};
+
+/// @brief Group the terms of `H` by the qubits they flip, in order of first
+/// appearance, where `qubitMask(q)` is the bit of qubit q in the state index
+/// of the simulator. Identity terms are summed into `constant`.
+template <typename QubitMask>
+std::vector<XMaskGroup> groupByXMask(const cudaq::spin_op &H,
+                                     QubitMask &&qubitMask, double &constant) {
+  const std::complex<double> phases[] = {1.0, {0, 1}, -1.0, {0, -1}};
+  const auto nWords = H.n_words();
+  std::vector<XMaskGroup> groups;
+  std::unordered_map<std::uint64_t, std::size_t> groupOf;
+  constant = 0.0;
+  for (std::size_t t = 0; t < H.n_terms(); t++) {
+    // Visit only the qubits the term acts on, word by word.
+    const auto *term = H.get_term_data(t);
+    std::uint64_t xMask = 0, zMask = 0;
+    std::size_t nY = 0;
+    for (std::size_t w = 0; w < nWords; w++) {
+      nY += __builtin_popcountll(term[w] & term[w + nWords]);
+      for (auto acts = term[w] | term[w + nWords]; acts; acts &= acts - 1) {
+        const auto bit = __builtin_ctzll(acts);
+        const auto q = 64 * w + bit;
+        if (term[w] >> bit & 1)
+          xMask |= qubitMask(q);
+        if (term[w + nWords] >> bit & 1)
+          zMask |= qubitMask(q);
+      }
+    }
+    const double coefficient = H.get_term_coefficient(t).real();
+    if (!xMask && !zMask) {
+      constant += coefficient;
+      continue;
+    }
+    auto [iter, inserted] = groupOf.try_emplace(xMask, groups.size());
+    if (inserted)
+      groups.push_back({xMask, {}, {}});
+    auto &group = groups[iter->second];
+    group.zMasks.push_back(zMask);
+    group.coefficients.push_back(coefficient * phases[nY % 4]);
+  }
+  return groups;
+}
+} // namespace nvqir
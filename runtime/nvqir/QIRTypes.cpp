@@ -45,6 +45,10 @@ void Array::append(const Array &other) {
 
 void Array::add_element() { storage.resize((1 + size()) * element_size_bytes); }
 
+void Array::resize(std::size_t nItems) {
+  storage.assign(nItems * element_size_bytes, 0);
+}
+
 std::size_t Array::size() const { return storage.size() / element_size_bytes; }
 void Array::clear() { storage.clear(); }
 int Array::element_size() const { return element_size_bytes; }
@@ -11,12 +11,28 @@
 
 #include "CircuitSimulator.h"
 #include "Gates.h"
+#include "PauliGroups.h"
 #include "cuComplex.h"
+#include "cublas_v2.h"
+#include "cudaq/spin_op.h"
+#include "curand.h"
 #include "custatevec.h"
+#include <thrust/complex.h>
+#include <thrust/device_ptr.h>
+#include <thrust/functional.h>
+#include <thrust/inner_product.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/sort.h>
+#include <thrust/transform.h>
+#include <thrust/transform_reduce.h>
+#include <thrust/system/cuda/execution_policy.h>
+#include <array>
 #include <bitset>
 #include <complex>
+#include <cstring>
 #include <iostream>
 #include <random>
+#include <unordered_map>
 
 namespace {
 
@@ -40,22 +56,34 @@ namespace {
     }                                                                          \
   };
 
-/// @brief Generate a vector of random values
-/// @param num_samples
-/// @param max_value
-/// @return
-static std::vector<double> randomValues(uint64_t num_samples,
-                                        double max_value) {
-  std::vector<double> rs;
-  rs.reserve(num_samples);
-  std::random_device rd;
-  std::mt19937 rgen(rd());
-  std::uniform_real_distribution<double> distr(0.0, max_value);
-  for (uint64_t i = 0; i < num_samples; ++i) {
-    rs.emplace_back(distr(rgen));
-  }
-  std::sort(rs.begin(), rs.end());
-  return rs;
+#define HANDLE_CURAND_ERROR(x)                                                 \
+  {                                                                            \
+    const auto err = x;                                                        \
+    if (err != CURAND_STATUS_SUCCESS) {                                        \
+      throw std::runtime_error(fmt::format("[custatevec] curand error {} in "  \
+                                           "{} (line {})",                     \
+                                           static_cast<int>(err),              \
+                                           __FUNCTION__, __LINE__));           \
+    }                                                                          \
+  };
+
+#define HANDLE_CUBLAS_ERROR(x)                                                 \
+  {                                                                            \
+    const auto err = x;                                                        \
+    if (err != CUBLAS_STATUS_SUCCESS) {                                        \
+      throw std::runtime_error(fmt::format("[custatevec] cublas error {} in "  \
+                                           "{} (line {})",                     \
+                                           static_cast<int>(err),              \
+                                           __FUNCTION__, __LINE__));           \
+    }                                                                          \
+  };
+
+/// @brief Map the uniform values of cuRAND, in (0, 1], to [0, 1) as
+/// cuStateVec expects them.
+__global__ void flipUniformValues(double *values, int64_t n) {
+  int64_t i = static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (i < n)
+    values[i] = 1.0 - values[i];
 }
 
 /// @brief Initialize the device state vector to the |0...0> state
@@ -74,26 +102,128 @@ __global__ void initializeDeviceStateVector(CudaDataType *sv, int64_t dim) {
   }
 }
 
-/// @brief Kernel to set the first N elements of the state vector sv equal to
-/// the
-// elements provided by the vector sv2. N is the number of elements to set.
-// Size of sv must be greater than size of sv2.
-/// @param sv
-/// @param sv2
-/// @param N
-/// @return
-template <typename T>
-__global__ void setFirstNElements(T *sv, const T *__restrict__ sv2, int64_t N) {
+/// @brief Set the first amplitude of each of the nSVs zeroed state vectors,
+/// stride amplitudes apart, so that they are all in the |0...0> state
+template <typename CudaDataType>
+__global__ void initializeBatchedStateVectors(CudaDataType *sv, int64_t nSVs,
+                                              int64_t stride) {
   int64_t i = static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x;
-  if (i < N) {
-    sv[i].x = sv2[i].x;
-    sv[i].y = sv2[i].y;
-  } else {
-    sv[i].x = 0.0;
-    sv[i].y = 0.0;
+  if (i < nSVs) {
+    sv[i * stride].x = 1.0;
+    sv[i * stride].y = 0.0;
   }
 }
 
+/// @brief Scale an amplitude by a coefficient.
+template <typename ScalarType>
+struct ScaleAmplitude {
+  thrust::complex<ScalarType> coefficient;
+  __host__ __device__ thrust::complex<ScalarType>
+  operator()(const thrust::complex<ScalarType> &a) const {
+    return coefficient * a;
+  }
+};
+
+/// @brief The product conj(a) b of two amplitudes, in double precision.
+template <typename ScalarType>
+struct ConjugateProduct {
+  __host__ __device__ thrust::complex<double>
+  operator()(const thrust::complex<ScalarType> &a,
+             const thrust::complex<ScalarType> &b) const {
+    return thrust::complex<double>(thrust::conj(a) * b);
+  }
+};
+
+/// @brief The contribution Re(f(k) conj(psi[k ^ xMask]) psi[k]) of the
+/// amplitude k to the expectation value of an nvqir::XMaskGroup. f(k) is
+/// looked up in the phase table `coefficients` by the bits of k in zUnion if
+/// nTerms is 0, else it is the sum of the nTerms signed coefficients.
+template <typename ScalarType>
+struct GroupContribution {
+  const thrust::complex<ScalarType> *sv;
+  const thrust::complex<double> *coefficients;
+  const std::uint64_t *zMasks;
+  std::uint64_t xMask;
+  std::uint64_t zUnion;
+  std::size_t nTerms;
+
+  __host__ __device__ double operator()(std::uint64_t k) const {
+    thrust::complex<double> phase = 0.0;
+    if (nTerms == 0) {
+      std::uint64_t packed = 0;
+      for (int b = 0, j = 0; b < 64; b++)
+        if (zUnion >> b & 1)
+          packed |= (k >> b & 1) << j++;
+      phase = coefficients[packed];
+    } else {
+      for (std::size_t t = 0; t < nTerms; t++) {
+#ifdef __CUDA_ARCH__
+        const bool odd = __popcll(k & zMasks[t]) & 1;
+#else
+        const bool odd = __builtin_popcountll(k & zMasks[t]) & 1;
+#endif
+        phase += odd ? -coefficients[t] : coefficients[t];
+      }
+    }
+    const auto element =
+        thrust::complex<double>(thrust::conj(sv[k ^ xMask]) * sv[k]);
+    return (phase * element).real();
+  }
+};
+
+/// @brief A SimulationState referencing or owning a device state vector. The
+/// state stays on the device, single elements are copied to the host when
+/// they are accessed.
+template <typename CudaDataType>
+class DeviceSimulationState : public cudaq::SimulationState {
+protected:
+  void *deviceData;
+  std::size_t dimension;
+  bool ownsData;
+
+public:
+  DeviceSimulationState(void *deviceData, std::size_t dimension, bool ownsData)
+      : deviceData(deviceData), dimension(dimension), ownsData(ownsData) {}
+  DeviceSimulationState(const DeviceSimulationState &) = delete;
+  DeviceSimulationState &operator=(const DeviceSimulationState &) = delete;
+
+  virtual ~DeviceSimulationState() {
+    if (ownsData)
+      cudaFree(deviceData);
+  }
+
+  std::vector<std::size_t> getShape() const override { return {dimension}; }
+
+  std::complex<double> getElement(std::size_t idx) const override {
+    CudaDataType element;
+    HANDLE_CUDA_ERROR(
+        cudaMemcpy(&element, reinterpret_cast<CudaDataType *>(deviceData) + idx,
+                   sizeof(CudaDataType), cudaMemcpyDeviceToHost));
+    return {element.x, element.y};
+  }
+
+  void copyElements(std::size_t first, std::size_t count,
+                    std::complex<double> *out) const override {
+    std::vector<CudaDataType> hostData(count);
+    HANDLE_CUDA_ERROR(cudaMemcpy(
+        hostData.data(), reinterpret_cast<CudaDataType *>(deviceData) + first,
+        count * sizeof(CudaDataType), cudaMemcpyDeviceToHost));
+    for (std::size_t i = 0; i < count; i++)
+      out[i] = {hostData[i].x, hostData[i].y};
+  }
+
+  cudaq::State toState() const override {
+    std::vector<CudaDataType> hostData(dimension);
+    HANDLE_CUDA_ERROR(cudaMemcpy(hostData.data(), deviceData,
+                                 dimension * sizeof(CudaDataType),
+                                 cudaMemcpyDeviceToHost));
+    std::vector<std::complex<double>> data(dimension);
+    for (std::size_t i = 0; i < dimension; i++)
+      data[i] = {hostData[i].x, hostData[i].y};
+    return cudaq::State{{dimension}, std::move(data)};
+  }
+};
+
 /// @brief The CuStateVecCircuitSimulator implements the CircuitSimulator
 /// base class to provide a simulator that delegates to the NVIDIA CuStateVec
 /// GPU-accelerated library.
@@ -110,27 +240,536 @@ protected:
   /// @brief The statevector that cuStateVec manipulates on the GPU
   void *deviceStateVector = nullptr;
 
+  /// @brief The number of amplitudes the device state vector has room for,
+  /// and the number of them currently in use. The buffer is kept at its
+  /// high-water mark across resets, so repeated kernel executions reuse it.
+  std::size_t deviceStateCapacity = 0;
+  std::size_t deviceStateDimension = 0;
+
   /// @brief The cuStateVec handle
   custatevecHandle_t handle;
+  bool hasHandle = false;
 
   /// @brief Pointer to potentially needed extra memory
   void *extraWorkspace = nullptr;
-  /// @brief The size of the extra workspace
+  /// @brief The size of the extra workspace requested by the last call, and
+  /// the size actually allocated.
   size_t extraWorkspaceSizeInBytes = 0;
-
+  size_t extraWorkspaceCapacity = 0;
 
   /// @brief Count the number of resets.
   int nResets = 0;
 
+  /// @brief Device copy of the state at the end of a cached conditional
+  /// prefix, and its number of amplitudes.
+  void *deviceSnapshot = nullptr;
+  std::size_t snapshotDimension = 0;
+
+  /// @brief The auxiliary state vectors on the device, see
+  /// copyStateToAuxiliary(), and their number of amplitudes.
+  std::vector<std::pair<void *, std::size_t>> deviceAuxiliaryStates;
+
+  /// @brief The state vectors of a batched observation, packed one after the
+  /// other, and the number of amplitudes the buffer has room for.
+  void *deviceBatchedStateVector = nullptr;
+  std::size_t deviceBatchedCapacity = 0;
+
   custatevecComputeType_t cuStateVecComputeType = CUSTATEVEC_COMPUTE_64F;
   cudaDataType_t cuStateVecCudaDataType = CUDA_C_64F;
 
-  /// @brief Return true if the bit string has even parity
-  /// @param x
-  /// @return
-  bool hasEvenParity(const std::string &x) {
-    int c = std::count(x.begin(), x.end(), '1');
-    return c % 2 == 0;
+  /// @brief The stream all device work of this simulator is issued on. Gates
+  /// are applied asynchronously, the host only waits for the stream when it
+  /// reads a result back (measurements, samples, expectation values, the
+  /// state).
+  cudaStream_t stream = nullptr;
+
+  /// @brief Gate matrices are uploaded through a pinned host buffer into a
+  /// device buffer of the same size. Both are used as a ring of two halves:
+  /// before the host writes a half again, it waits on the event recorded when
+  /// it last left that half, i.e. for the uploads of its previous contents.
+  static constexpr std::size_t matrixRingBytes = 1ULL << 22;
+  void *hostMatrixRing = nullptr;
+  void *deviceMatrixRing = nullptr;
+  std::size_t matrixRingOffset = 0;
+  cudaEvent_t matrixRingEvents[2];
+
+  /// @brief Fused gates on at least minGemmQubits contiguous qubits can be
+  /// applied as batched GEMMs with cuBLAS, which runs them on tensor cores
+  /// (see applyDenseMatrixGemm()). Selected with CUDAQ_FUSION_GEMM.
+  static constexpr std::size_t minGemmQubits = 4;
+  bool useGemmFusion = false;
+  cublasComputeType_t gemmComputeType = CUBLAS_COMPUTE_64F;
+  cublasHandle_t blasHandle = nullptr;
+
+  /// @brief The GEMMs write into a scratch buffer of at most
+  /// gemmScratchAmplitudes amplitudes, copied back into the state.
+  static constexpr std::size_t gemmScratchAmplitudes = 1ULL << 22;
+  void *deviceGemmScratch = nullptr;
+  std::size_t gemmScratchCapacity = 0;
+
+  /// @brief Sampling draws its sorted random values on the device, with a
+  /// Philox generator created at the first sample, into a device buffer and
+  /// the pinned host buffer cuStateVec reads them from. Both are kept at
+  /// their high-water mark.
+  curandGenerator_t randomGenerator = nullptr;
+  std::uint64_t randomGeneratorSeed = std::random_device{}();
+  double *deviceRandomBuffer = nullptr;
+  double *hostRandomBuffer = nullptr;
+  std::size_t randomBufferCapacity = 0;
+
+  /// @brief The generator of the single random values of measurements and
+  /// resets.
+  std::mt19937_64 measureRandomEngine{std::random_device{}()};
+
+  /// @brief Return `n` random values in [0, 1), in ascending order, drawn
+  /// and sorted on the device. The pointer is to pinned host memory valid
+  /// until the next call.
+  const double *sortedRandomValues(std::size_t n) {
+    if (!randomGenerator) {
+      HANDLE_CURAND_ERROR(curandCreateGenerator(
+          &randomGenerator, CURAND_RNG_PSEUDO_PHILOX4_32_10));
+      HANDLE_CURAND_ERROR(
+          curandSetPseudoRandomGeneratorSeed(randomGenerator,
+                                             randomGeneratorSeed));
+      HANDLE_CURAND_ERROR(curandSetStream(randomGenerator, stream));
+    }
+    if (n > randomBufferCapacity) {
+      if (deviceRandomBuffer)
+        HANDLE_CUDA_ERROR(cudaFreeAsync(deviceRandomBuffer, stream));
+      if (hostRandomBuffer) {
+        HANDLE_CUDA_ERROR(cudaStreamSynchronize(stream));
+        HANDLE_CUDA_ERROR(cudaFreeHost(hostRandomBuffer));
+      }
+      HANDLE_CUDA_ERROR(cudaMallocAsync(
+          reinterpret_cast<void **>(&deviceRandomBuffer),
+          n * sizeof(double), stream));
+      HANDLE_CUDA_ERROR(cudaMallocHost(
+          reinterpret_cast<void **>(&hostRandomBuffer), n * sizeof(double)));
+      randomBufferCapacity = n;
+    }
+
+    HANDLE_CURAND_ERROR(
+        curandGenerateUniformDouble(randomGenerator, deviceRandomBuffer, n));
+    constexpr int32_t threads_per_block = 256;
+    const int64_t n_blocks = (n + threads_per_block - 1) / threads_per_block;
+    flipUniformValues<<<n_blocks, threads_per_block, 0, stream>>>(
+        deviceRandomBuffer, n);
+    HANDLE_CUDA_ERROR(cudaGetLastError());
+    auto values = thrust::device_pointer_cast(deviceRandomBuffer);
+    thrust::sort(thrust::cuda::par.on(stream), values, values + n);
+    HANDLE_CUDA_ERROR(cudaMemcpyAsync(hostRandomBuffer, deviceRandomBuffer,
+                                      n * sizeof(double),
+                                      cudaMemcpyDeviceToHost, stream));
+    HANDLE_CUDA_ERROR(cudaStreamSynchronize(stream));
+    return hostRandomBuffer;
+  }
+
+  /// @brief Return one random value in [0, 1) for a measurement.
+  double measureRandomValue() {
+    return std::uniform_real_distribution<double>(0.0,
+                                                  1.0)(measureRandomEngine);
+  }
+
+  /// @brief Device copies of the matrices of the parameter free gates,
+  /// uploaded at their first use.
+  std::unordered_map<std::string, void *> namedGateMatrices;
+
+  /// @brief Return a device copy of the matrix, uploaded asynchronously
+  /// through the matrix ring. Matrices larger than half of the ring (wide
+  /// fused gates) are returned as is, cuStateVec then copies them from the
+  /// host itself. `MatrixT` is a contiguous container of DataType.
+  template <typename MatrixT>
+  const void *uploadMatrix(const MatrixT &matrix) {
+    constexpr std::size_t halfBytes = matrixRingBytes / 2;
+    const std::size_t bytes = matrix.size() * sizeof(CudaDataType);
+    if (bytes > halfBytes)
+      return matrix.data();
+
+    const std::size_t half = matrixRingOffset / halfBytes;
+    if (matrixRingOffset + bytes > (half + 1) * halfBytes) {
+      const std::size_t next = 1 - half;
+      HANDLE_CUDA_ERROR(cudaEventRecord(matrixRingEvents[half], stream));
+      HANDLE_CUDA_ERROR(cudaEventSynchronize(matrixRingEvents[next]));
+      matrixRingOffset = next * halfBytes;
+    }
+    auto *host = static_cast<char *>(hostMatrixRing) + matrixRingOffset;
+    auto *device = static_cast<char *>(deviceMatrixRing) + matrixRingOffset;
+    std::memcpy(host, matrix.data(), bytes);
+    HANDLE_CUDA_ERROR(cudaMemcpyAsync(device, host, bytes,
+                                      cudaMemcpyHostToDevice, stream));
+    // Keep every matrix aligned for complex double.
+    matrixRingOffset += (bytes + 15) & ~std::size_t(15);
+    return device;
+  }
+
+  /// @brief Return the device copy of the matrix of the parameter free gate
+  /// with the given name.
+  template <typename MatrixT>
+  const void *namedGateMatrix(const std::string &name, const MatrixT &matrix) {
+    auto &deviceMatrix = namedGateMatrices[name];
+    if (!deviceMatrix) {
+      const std::size_t bytes = matrix.size() * sizeof(CudaDataType);
+      HANDLE_CUDA_ERROR(cudaMalloc(&deviceMatrix, bytes));
+      HANDLE_CUDA_ERROR(cudaMemcpy(deviceMatrix, matrix.data(), bytes,
+                                   cudaMemcpyHostToDevice));
+    }
+    return deviceMatrix;
+  }
+
+  /// @brief Grow the extra workspace to extraWorkspaceSizeInBytes. It is only
+  /// reallocated when a larger one is requested.
+  void reserveExtraWorkspace() {
+    if (extraWorkspaceSizeInBytes <= extraWorkspaceCapacity)
+      return;
+    if (extraWorkspace)
+      HANDLE_CUDA_ERROR(cudaFreeAsync(extraWorkspace, stream));
+    HANDLE_CUDA_ERROR(
+        cudaMallocAsync(&extraWorkspace, extraWorkspaceSizeInBytes, stream));
+    extraWorkspaceCapacity = extraWorkspaceSizeInBytes;
+  }
+
+  /// @brief Grow the device state vector to stateDimension amplitudes. The
+  /// existing amplitudes stay in place and the new ones are zeroed, a new
+  /// buffer is only taken from the stream ordered pool when the state
+  /// outgrows the current one.
+  void growDeviceStateVector() {
+    if (!hasHandle) {
+      HANDLE_ERROR(custatevecCreate(&handle));
+      HANDLE_ERROR(custatevecSetStream(handle, stream));
+      hasHandle = true;
+    }
+    const std::size_t oldDimension = deviceStateDimension;
+    if (stateDimension <= oldDimension)
+      return;
+
+    if (stateDimension > deviceStateCapacity) {
+      void *grown;
+      HANDLE_CUDA_ERROR(cudaMallocAsync(
+          &grown, stateDimension * sizeof(CudaDataType), stream));
+      if (oldDimension)
+        HANDLE_CUDA_ERROR(cudaMemcpyAsync(grown, deviceStateVector,
+                                          oldDimension * sizeof(CudaDataType),
+                                          cudaMemcpyDeviceToDevice, stream));
+      if (deviceStateVector)
+        HANDLE_CUDA_ERROR(cudaFreeAsync(deviceStateVector, stream));
+      deviceStateVector = grown;
+      deviceStateCapacity = stateDimension;
+    }
+
+    if (oldDimension == 0) {
+      constexpr int32_t threads_per_block = 256;
+      uint32_t n_blocks =
+          (stateDimension + threads_per_block - 1) / threads_per_block;
+      initializeDeviceStateVector<<<n_blocks, threads_per_block, 0, stream>>>(
+          reinterpret_cast<CudaDataType *>(deviceStateVector), stateDimension);
+    } else {
+      HANDLE_CUDA_ERROR(cudaMemsetAsync(
+          reinterpret_cast<CudaDataType *>(deviceStateVector) + oldDimension,
+          0, (stateDimension - oldDimension) * sizeof(CudaDataType), stream));
+    }
+    deviceStateDimension = stateDimension;
+  }
+
+  /// @brief The matrix of the swap gate.
+  static constexpr std::array<DataType, 16> swapMatrix() {
+    return {DataType(1.0, 0.0), DataType(0.0, 0.0), DataType(0.0, 0.0),
+            DataType(0.0, 0.0), DataType(0.0, 0.0), DataType(0.0, 0.0),
+            DataType(1.0, 0.0), DataType(0.0, 0.0), DataType(0.0, 0.0),
+            DataType(1.0, 0.0), DataType(0.0, 0.0), DataType(0.0, 0.0),
+            DataType(0.0, 0.0), DataType(0.0, 0.0), DataType(0.0, 0.0),
+            DataType(1.0, 0.0)};
+  }
+
+  /// @brief Return the (uncontrolled) matrix of the recorded gate.
+  DataVector recordedGateMatrix(const PrefixGate &gate) {
+    using nvqir::GateName;
+    static const std::unordered_map<std::string, GateName> gateNames{
+        {"x", GateName::X},    {"y", GateName::Y},     {"z", GateName::Z},
+        {"h", GateName::H},    {"s", GateName::S},     {"t", GateName::T},
+        {"sdg", GateName::Sdg}, {"tdg", GateName::Tdg}, {"rx", GateName::Rx},
+        {"ry", GateName::Ry},  {"rz", GateName::Rz},   {"r1", GateName::R1},
+        {"u1", GateName::U1},  {"u2", GateName::U2},   {"u3", GateName::U3}};
+    if (gate.name == "swap") {
+      const auto matrix = swapMatrix();
+      return DataVector(matrix.begin(), matrix.end());
+    }
+    auto iter = gateNames.find(gate.name);
+    if (iter == gateNames.end())
+      throw std::runtime_error("Cannot batch unknown gate " + gate.name + ".");
+    std::vector<ScalarType> angles(gate.parameters.begin(),
+                                   gate.parameters.end());
+    return nvqir::getGateByName<ScalarType>(iter->second, angles);
+  }
+
+  /// @brief Return true if the two recorded kernel executions apply the same
+  /// gates, up to their parameters, so they can share batched launches.
+  static bool isSameCircuit(const BatchElement &a, const BatchElement &b) {
+    if (a.nQubits != b.nQubits || a.gates.size() != b.gates.size())
+      return false;
+    for (std::size_t i = 0; i < a.gates.size(); i++)
+      if (a.gates[i].name != b.gates[i].name ||
+          a.gates[i].controls != b.gates[i].controls ||
+          a.gates[i].targets != b.gates[i].targets)
+        return false;
+    return true;
+  }
+
+  /// @brief The fewest terms of a spin_op whose expectation value is
+  /// computed in one sweep per X mask, see computeGroupedExpectation().
+  static constexpr std::size_t minGroupedTerms = 64;
+
+  /// @brief Return <psi| H |psi> for the state vector `sv` of nQubits qubits
+  /// with one device reduction per distinct X mask of the terms of `H`,
+  /// rather than per term. The phase tables and Z masks of all the groups
+  /// are copied to the device at once.
+  double computeGroupedExpectation(void *sv, std::size_t nQubits,
+                                   const cudaq::spin_op &H) {
+    const std::size_t dim = 1ULL << nQubits;
+    double expectation = 0.0;
+    const auto groups = nvqir::groupByXMask(
+        H, [](std::size_t q) { return 1ULL << q; }, expectation);
+
+    // Each group takes either its phase table or its coefficients.
+    std::vector<std::complex<double>> coefficients;
+    std::vector<std::uint64_t> zMasks;
+    std::vector<std::pair<std::size_t, std::size_t>> offsets;
+    std::vector<bool> useTable;
+    for (auto &group : groups) {
+      offsets.emplace_back(coefficients.size(), zMasks.size());
+      useTable.push_back(group.useTable(dim));
+      if (useTable.back()) {
+        const auto table = group.phaseTable();
+        coefficients.insert(coefficients.end(), table.begin(), table.end());
+        continue;
+      }
+      coefficients.insert(coefficients.end(), group.coefficients.begin(),
+                          group.coefficients.end());
+      zMasks.insert(zMasks.end(), group.zMasks.begin(), group.zMasks.end());
+    }
+
+    thrust::complex<double> *deviceCoefficients = nullptr;
+    std::uint64_t *deviceZMasks = nullptr;
+    HANDLE_CUDA_ERROR(cudaMallocAsync(
+        reinterpret_cast<void **>(&deviceCoefficients),
+        coefficients.size() * sizeof(thrust::complex<double>), stream));
+    HANDLE_CUDA_ERROR(cudaMallocAsync(
+        reinterpret_cast<void **>(&deviceZMasks),
+        std::max<std::size_t>(zMasks.size(), 1) * sizeof(std::uint64_t),
+        stream));
+    HANDLE_CUDA_ERROR(cudaMemcpyAsync(
+        deviceCoefficients, coefficients.data(),
+        coefficients.size() * sizeof(thrust::complex<double>),
+        cudaMemcpyHostToDevice, stream));
+    HANDLE_CUDA_ERROR(cudaMemcpyAsync(deviceZMasks, zMasks.data(),
+                                      zMasks.size() * sizeof(std::uint64_t),
+                                      cudaMemcpyHostToDevice, stream));
+
+    const auto *amplitudes =
+        reinterpret_cast<const thrust::complex<ScalarType> *>(sv);
+    for (std::size_t g = 0; g < groups.size(); g++) {
+      const GroupContribution<ScalarType> contribution{
+          amplitudes,
+          deviceCoefficients + offsets[g].first,
+          deviceZMasks + offsets[g].second,
+          groups[g].xMask,
+          groups[g].zUnion(),
+          useTable[g] ? 0 : groups[g].zMasks.size()};
+      expectation += thrust::transform_reduce(
+          thrust::cuda::par.on(stream),
+          thrust::counting_iterator<std::uint64_t>(0),
+          thrust::counting_iterator<std::uint64_t>(dim), contribution, 0.0,
+          thrust::plus<double>());
+    }
+    HANDLE_CUDA_ERROR(cudaFreeAsync(deviceCoefficients, stream));
+    HANDLE_CUDA_ERROR(cudaFreeAsync(deviceZMasks, stream));
+    cudaq::info("Computed the expectation value of {} terms in {} sweeps.",
+                H.n_terms(), groups.size());
+    return expectation;
+  }
+
+  /// @brief Return <psi| H |psi> for the state vector `sv` of nQubits qubits.
+  double computeSpinOpExpectation(void *sv, std::size_t nQubits,
+                                  const cudaq::spin_op &H) {
+    const auto nSpinQubits = H.n_qubits();
+    if (nSpinQubits > nQubits)
+      throw std::runtime_error("Cannot observe a spin_op on " +
+                               std::to_string(nSpinQubits) + " qubits with " +
+                               std::to_string(nQubits) + " qubits allocated.");
+    if (H.n_terms() >= minGroupedTerms)
+      return computeGroupedExpectation(sv, nQubits, H);
+    const auto bsf = H.get_bsf();
+    double expectation = 0.0;
+    std::vector<std::vector<custatevecPauli_t>> paulis;
+    std::vector<std::vector<int>> basisBits;
+    std::vector<double> coefficients;
+    for (std::size_t t = 0; t < H.n_terms(); t++) {
+      std::vector<custatevecPauli_t> termPaulis;
+      std::vector<int> termBits;
+      for (std::size_t q = 0; q < nSpinQubits; q++) {
+        const bool x = bsf[t][q], z = bsf[t][q + nSpinQubits];
+        if (!x && !z)
+          continue;
+        termPaulis.push_back(x && z ? CUSTATEVEC_PAULI_Y
+                             : x    ? CUSTATEVEC_PAULI_X
+                                    : CUSTATEVEC_PAULI_Z);
+        termBits.push_back(q);
+      }
+      const double coefficient = H.get_term_coefficient(t).real();
+      if (termPaulis.empty()) {
+        expectation += coefficient;
+        continue;
+      }
+      paulis.push_back(std::move(termPaulis));
+      basisBits.push_back(std::move(termBits));
+      coefficients.push_back(coefficient);
+    }
+    if (paulis.empty())
+      return expectation;
+
+    std::vector<const custatevecPauli_t *> pauliArray;
+    std::vector<const int *> basisBitsArray;
+    std::vector<uint32_t> nBasisBitsArray;
+    for (std::size_t i = 0; i < paulis.size(); i++) {
+      pauliArray.push_back(paulis[i].data());
+      basisBitsArray.push_back(basisBits[i].data());
+      nBasisBitsArray.push_back(basisBits[i].size());
+    }
+    std::vector<double> values(paulis.size());
+    HANDLE_ERROR(custatevecComputeExpectationsOnPauliBasis(
+        handle, sv, cuStateVecCudaDataType, nQubits, values.data(),
+        pauliArray.data(), paulis.size(), basisBitsArray.data(),
+        nBasisBitsArray.data()));
+    for (std::size_t i = 0; i < values.size(); i++)
+      expectation += coefficients[i] * values[i];
+    return expectation;
+  }
+
+  /// @brief Simulate the recorded kernel executions `elements` of the batch,
+  /// which all apply the same circuit, as state vectors packed into one
+  /// buffer. Every gate is a single batched launch with the matrix of each
+  /// execution. Store the expectation values of `H` in `results`.
+  void observeSameCircuits(const std::vector<BatchElement> &batch,
+                           const std::vector<std::size_t> &elements,
+                           const cudaq::spin_op &H,
+                           std::vector<cudaq::ExecutionResult> &results) {
+    const auto &circuit = batch[elements.front()];
+    const uint32_t nQubits = circuit.nQubits;
+    const uint32_t nSVs = elements.size();
+    const custatevecIndex_t svStride = 1ULL << nQubits;
+    const std::size_t nAmplitudes = nSVs * svStride;
+    if (nAmplitudes > deviceBatchedCapacity) {
+      if (deviceBatchedStateVector)
+        HANDLE_CUDA_ERROR(cudaFreeAsync(deviceBatchedStateVector, stream));
+      HANDLE_CUDA_ERROR(cudaMallocAsync(&deviceBatchedStateVector,
+                                        nAmplitudes * sizeof(CudaDataType),
+                                        stream));
+      deviceBatchedCapacity = nAmplitudes;
+    }
+    auto *batchedSv =
+        reinterpret_cast<CudaDataType *>(deviceBatchedStateVector);
+    HANDLE_CUDA_ERROR(cudaMemsetAsync(
+        batchedSv, 0, nAmplitudes * sizeof(CudaDataType), stream));
+    constexpr int32_t threads_per_block = 256;
+    uint32_t n_blocks = (nSVs + threads_per_block - 1) / threads_per_block;
+    initializeBatchedStateVectors<<<n_blocks, threads_per_block, 0, stream>>>(
+        batchedSv, nSVs, svStride);
+
+    std::vector<int32_t> matrixIndices(nSVs);
+    for (uint32_t i = 0; i < nSVs; i++)
+      matrixIndices[i] = i;
+    for (std::size_t g = 0; g < circuit.gates.size(); g++) {
+      const auto &gate = circuit.gates[g];
+      // Parameter free gates, or identical parameters, share one matrix.
+      bool broadcast = true;
+      for (auto e : elements)
+        broadcast &= batch[e].gates[g].parameters == gate.parameters;
+      DataVector matrices;
+      for (auto e : elements) {
+        auto matrix = recordedGateMatrix(batch[e].gates[g]);
+        matrices.insert(matrices.end(), matrix.begin(), matrix.end());
+        if (broadcast)
+          break;
+      }
+      const auto mapType =
+          broadcast ? CUSTATEVEC_MATRIX_MAP_TYPE_BROADCAST
+                    : CUSTATEVEC_MATRIX_MAP_TYPE_MATRIX_INDEXED;
+      const uint32_t nMatrices = broadcast ? 1 : nSVs;
+      std::vector<int32_t> targets(gate.targets.begin(), gate.targets.end());
+      std::vector<int32_t> controls(gate.controls.begin(), gate.controls.end());
+
+      HANDLE_ERROR(custatevecApplyMatrixBatchedGetWorkspaceSize(
+          handle, cuStateVecCudaDataType, nQubits, nSVs, svStride, mapType,
+          broadcast ? nullptr : matrixIndices.data(), matrices.data(),
+          cuStateVecCudaDataType, CUSTATEVEC_MATRIX_LAYOUT_ROW, 0, nMatrices,
+          targets.size(), controls.size(), cuStateVecComputeType,
+          &extraWorkspaceSizeInBytes));
+      reserveExtraWorkspace();
+      HANDLE_ERROR(custatevecApplyMatrixBatched(
+          handle, batchedSv, cuStateVecCudaDataType, nQubits, nSVs, svStride,
+          mapType, broadcast ? nullptr : matrixIndices.data(), matrices.data(),
+          cuStateVecCudaDataType, CUSTATEVEC_MATRIX_LAYOUT_ROW, 0, nMatrices,
+          targets.data(), targets.size(),
+          controls.empty() ? nullptr : controls.data(), nullptr,
+          controls.size(), cuStateVecComputeType, extraWorkspace,
+          extraWorkspaceSizeInBytes));
+    }
+
+    for (uint32_t i = 0; i < nSVs; i++)
+      results[elements[i]].expectationValue =
+          computeSpinOpExpectation(batchedSv + i * svStride, nQubits, H);
+  }
+
+  /// @brief Exact expectation values are computed by observe() with
+  /// custatevecComputeExpectationsOnPauliBasis, sampled observations still
+  /// measure every term.
+  bool canHandleObserve() override { return isExactObservation(); }
+
+  /// @brief Batched observation packs the state vectors of the kernel
+  /// executions into one buffer.
+  bool canObserveBatch() override { return true; }
+
+  /// @brief Group the recorded kernel executions by circuit and simulate each
+  /// group as one batch of state vectors, split so that it fits in the free
+  /// device memory.
+  std::vector<cudaq::ExecutionResult>
+  observeBatch(const std::vector<BatchElement> &batch,
+               const cudaq::spin_op &H) override {
+    std::vector<std::vector<std::size_t>> groups;
+    for (std::size_t i = 0; i < batch.size(); i++) {
+      auto iter = std::find_if(groups.begin(), groups.end(), [&](auto &group) {
+        return isSameCircuit(batch[group.front()], batch[i]);
+      });
+      if (iter == groups.end())
+        groups.push_back({i});
+      else
+        iter->push_back(i);
+    }
+    cudaq::info("Batch of {} kernel executions applies {} distinct circuits.",
+                batch.size(), groups.size());
+
+    std::size_t freeBytes, totalBytes;
+    HANDLE_CUDA_ERROR(cudaMemGetInfo(&freeBytes, &totalBytes));
+    freeBytes += deviceBatchedCapacity * sizeof(CudaDataType);
+    std::vector<cudaq::ExecutionResult> results(batch.size());
+    for (auto &group : groups) {
+      const std::size_t svBytes =
+          (1ULL << batch[group.front()].nQubits) * sizeof(CudaDataType);
+      // Leave half of the free memory for the cuStateVec workspace.
+      const std::size_t maxSVs =
+          std::max<std::size_t>(1, freeBytes / 2 / svBytes);
+      for (std::size_t first = 0; first < group.size(); first += maxSVs) {
+        std::vector<std::size_t> chunk(
+            group.begin() + first,
+            group.begin() + std::min(group.size(), first + maxSVs));
+        observeSameCircuits(batch, chunk, H, results);
+      }
+    }
+    return results;
+  }
+
+  /// @brief Return true if the packed bit string has even parity
+  bool hasEvenParity(std::uint64_t bits) {
+    return std::bitset<64>(bits).count() % 2 == 0;
   }
 
   /// @brief Convert the pauli rotation gate name to a CUSTATEVEC_PAULI Type
@@ -152,16 +791,22 @@ protected:
   /// @param matrix The matrix data as a 1-d array, row-major
   /// @param controls Possible control qubits, can be empty
   /// @param targets Target qubits
-  void applyGateMatrix(const DataVector &matrix,
-                       const std::vector<int> &controls,
+  template <typename MatrixT>
+  void applyGateMatrix(const MatrixT &matrix, const std::vector<int> &controls,
                        const std::vector<int> &targets) {
+    applyDeviceMatrix(uploadMatrix(matrix), controls, targets);
+  }
+
+  /// @brief Apply the matrix, in device memory or (for wide matrices) host
+  /// memory, to the state vector on the GPU.
+  void applyDeviceMatrix(const void *matrix, const std::vector<int> &controls,
+                         const std::vector<int> &targets) {
     HANDLE_ERROR(custatevecApplyMatrixGetWorkspaceSize(
-        handle, cuStateVecCudaDataType, nQubitsAllocated, matrix.data(),
+        handle, cuStateVecCudaDataType, nQubitsAllocated, matrix,
         cuStateVecCudaDataType, CUSTATEVEC_MATRIX_LAYOUT_ROW, 0, targets.size(),
         controls.size(), cuStateVecComputeType, &extraWorkspaceSizeInBytes));
 
-    if (extraWorkspaceSizeInBytes > 0)
-      HANDLE_CUDA_ERROR(cudaMalloc(&extraWorkspace, extraWorkspaceSizeInBytes));
+    reserveExtraWorkspace();
 
     // When we perform a deallocation we apply a 
     // qubit reset, and the state does not shrink (trying to minimize device
@@ -171,12 +816,137 @@ protected:
     // apply gate
     HANDLE_ERROR(custatevecApplyMatrix(
         handle, deviceStateVector, cuStateVecCudaDataType, localNQubitsAllocated,
-        matrix.data(), cuStateVecCudaDataType, CUSTATEVEC_MATRIX_LAYOUT_ROW, 0,
+        matrix, cuStateVecCudaDataType, CUSTATEVEC_MATRIX_LAYOUT_ROW, 0,
         targets.data(), targets.size(),
         controls.empty() ? nullptr : controls.data(), nullptr, controls.size(),
         cuStateVecComputeType, extraWorkspace, extraWorkspaceSizeInBytes));
   }
 
+  /// @brief Hand the gate to the fusion buffer if gate fusion is enabled,
+  /// return true if it was absorbed and must not be applied here.
+  template <typename MatrixT>
+  bool fuseGateMatrix(const MatrixT &matrix,
+                      const std::vector<std::size_t> &controls,
+                      const std::vector<std::size_t> &targets) {
+    if (!isGateFusionEnabled())
+      return false;
+    return fuseGate(
+        std::vector<std::complex<double>>(matrix.begin(), matrix.end()),
+        controls, targets);
+  }
+
+  /// @brief Apply the dense matrix, cuStateVec takes targets[0] as the least
+  /// significant bit of the matrix index, matching the base class.
+  void applyDenseMatrix(const std::vector<std::complex<double>> &matrix,
+                        const std::vector<std::size_t> &targets) override {
+    if (useGemmFusion && applyDenseMatrixGemm(matrix, targets))
+      return;
+    std::vector<int> targets32(targets.begin(), targets.end());
+    applyGateMatrix(DataVector(matrix.begin(), matrix.end()), {}, targets32);
+  }
+
+  /// @brief Apply the dense matrix as batched GEMMs if its targets are the
+  /// contiguous qubits p to p + k - 1, return false otherwise. With the
+  /// amplitude index split as (hi, mid, lo) around these bits, each hi is a
+  /// column major 2^p x 2^k matrix A[lo, mid], and the gate maps it to
+  /// A M^T. The row major M, read column major, is M^T already. The GEMMs
+  /// are done in chunks of rows into the scratch buffer, which is copied
+  /// back into the state.
+  bool applyDenseMatrixGemm(const std::vector<std::complex<double>> &matrix,
+                            const std::vector<std::size_t> &targets) {
+    const std::size_t k = targets.size();
+    if (k < minGemmQubits ||
+        (1ULL << (2 * k)) * sizeof(CudaDataType) > matrixRingBytes / 2)
+      return false;
+    std::vector<std::size_t> sorted(targets);
+    std::sort(sorted.begin(), sorted.end());
+    if (sorted.back() - sorted.front() != k - 1)
+      return false;
+    auto local = embedMatrix(matrix, targets, sorted);
+    const auto *deviceMatrix =
+        static_cast<const CudaDataType *>(uploadMatrix(
+            DataVector(local.begin(), local.end())));
+
+    const int64_t dim = 1LL << (nQubitsAllocated + nResets);
+    const int64_t rows = 1LL << sorted.front();
+    const int64_t cols = 1LL << k;
+    const int64_t batchStride = rows * cols;
+    const int64_t nBatches = dim / batchStride;
+    const int64_t scratch = std::min<int64_t>(dim, gemmScratchAmplitudes);
+    const int64_t chunkRows = std::min(rows, scratch / cols);
+    const int64_t batchesPerChunk =
+        chunkRows == rows ? std::max<int64_t>(1, scratch / batchStride) : 1;
+    if (static_cast<std::size_t>(scratch) > gemmScratchCapacity) {
+      if (deviceGemmScratch)
+        HANDLE_CUDA_ERROR(cudaFreeAsync(deviceGemmScratch, stream));
+      HANDLE_CUDA_ERROR(cudaMallocAsync(
+          &deviceGemmScratch, scratch * sizeof(CudaDataType), stream));
+      gemmScratchCapacity = scratch;
+    }
+    if (!blasHandle) {
+      HANDLE_CUBLAS_ERROR(cublasCreate(&blasHandle));
+      HANDLE_CUBLAS_ERROR(cublasSetStream(blasHandle, stream));
+    }
+
+    const CudaDataType one{1, 0}, zero{0, 0};
+    auto *state = static_cast<CudaDataType *>(deviceStateVector);
+    auto *out = static_cast<CudaDataType *>(deviceGemmScratch);
+    for (int64_t b = 0; b < nBatches; b += batchesPerChunk) {
+      const int64_t nb = std::min(batchesPerChunk, nBatches - b);
+      for (int64_t r = 0; r < rows; r += chunkRows) {
+        auto *in = state + b * batchStride + r;
+        HANDLE_CUBLAS_ERROR(cublasGemmStridedBatchedEx(
+            blasHandle, CUBLAS_OP_N, CUBLAS_OP_N, chunkRows, cols, cols, &one,
+            in, cuStateVecCudaDataType, rows, batchStride, deviceMatrix,
+            cuStateVecCudaDataType, cols, 0, &zero, out,
+            cuStateVecCudaDataType, chunkRows, chunkRows * cols, nb,
+            gemmComputeType, CUBLAS_GEMM_DEFAULT));
+        HANDLE_CUDA_ERROR(cudaMemcpy2DAsync(
+            in, rows * sizeof(CudaDataType), out,
+            chunkRows * sizeof(CudaDataType), chunkRows * sizeof(CudaDataType),
+            cols * nb, cudaMemcpyDeviceToDevice, stream));
+      }
+    }
+    return true;
+  }
+
+  /// @brief Compute <psi| M |psi> on the GPU.
+  double
+  expectationOfDenseMatrix(const std::vector<std::complex<double>> &matrix,
+                           const std::vector<std::size_t> &targets) override {
+    DataVector localMatrix(matrix.begin(), matrix.end());
+    std::vector<int> targets32(targets.begin(), targets.end());
+    HANDLE_ERROR(custatevecComputeExpectationGetWorkspaceSize(
+        handle, cuStateVecCudaDataType, nQubitsAllocated, localMatrix.data(),
+        cuStateVecCudaDataType, CUSTATEVEC_MATRIX_LAYOUT_ROW, targets32.size(),
+        cuStateVecComputeType, &extraWorkspaceSizeInBytes));
+    reserveExtraWorkspace();
+
+    std::complex<double> expectation;
+    double residualNorm;
+    HANDLE_ERROR(custatevecComputeExpectation(
+        handle, deviceStateVector, cuStateVecCudaDataType, nQubitsAllocated,
+        &expectation, CUDA_C_64F, &residualNorm, localMatrix.data(),
+        cuStateVecCudaDataType, CUSTATEVEC_MATRIX_LAYOUT_ROW, targets32.data(),
+        targets32.size(), cuStateVecComputeType, extraWorkspace,
+        extraWorkspaceSizeInBytes));
+    return expectation.real();
+  }
+
+  /// @brief The state vector simulates noise with quantum trajectories.
+  bool canHandleTrajectoryNoise() override { return true; }
+
+  /// @brief Apply the noise channels for the gate, if any.
+  void applyNoise(const std::string_view gateName,
+                  const std::vector<std::size_t> &controls,
+                  const std::vector<std::size_t> &targets) {
+    if (!executionContext || !executionContext->noiseModel)
+      return;
+    std::vector<std::size_t> noiseQubits{controls.begin(), controls.end()};
+    noiseQubits.insert(noiseQubits.end(), targets.begin(), targets.end());
+    applyNoiseTrajectory(gateName, noiseQubits);
+  }
+
   /// @brief Utility function for applying one-target-qubit operations with
   /// optional control qubits
   /// @tparam GateT The instruction type, must be QppInstruction derived
@@ -186,12 +956,17 @@ protected:
   void oneQubitApply(const std::vector<std::size_t> &controls,
                      const std::size_t qubitIdx) {
     GateT gate;
-    cudaq::info(gateToString(gate.name(), controls, {}, {qubitIdx}));
-    DataVector matrix = gate.getGate();
+    CUDAQ_INFO(gateToString(gate.name(), controls, {}, {qubitIdx}));
+    if (skipPrefixGate(gate.name(), {}, controls, {qubitIdx}))
+      return;
+    constexpr auto matrix = GateT::getMatrix();
+    if (fuseGateMatrix(matrix, controls, {qubitIdx}))
+      return;
     std::vector<int> targets{(int)qubitIdx}, ctrls32;
     for (auto &c : controls)
       ctrls32.push_back(c);
-    applyGateMatrix(matrix, ctrls32, targets);
+    applyDeviceMatrix(namedGateMatrix(gate.name(), matrix), ctrls32, targets);
+    applyNoise(gate.name(), controls, {qubitIdx});
   }
 
   /// @brief Utility function for applying one-target-qubit rotation operations
@@ -204,7 +979,13 @@ protected:
                              const std::vector<std::size_t> &controls,
                              const std::size_t qubitIdx) {
     RotationGateT gate;
-    cudaq::info(gateToString(gate.name(), controls, {angle}, {qubitIdx}));
+    CUDAQ_INFO(gateToString(gate.name(), controls, {angle}, {qubitIdx}));
+    if (skipPrefixGate(gate.name(), {angle}, controls, {qubitIdx}))
+      return;
+    if (isGateFusionEnabled() &&
+        fuseGateMatrix(gate.getMatrix(static_cast<ScalarType>(angle)), controls,
+                       {qubitIdx}))
+      return;
     std::vector<int> controls32;
     for (auto c : controls)
       controls32.push_back((int)c);
@@ -214,6 +995,7 @@ protected:
                                  cuStateVecCudaDataType, nQubitsAllocated,
                                  -0.5 * angle, pauli, targets, 1,
                                  controls32.data(), nullptr, controls32.size());
+    applyNoise(gate.name(), controls, {qubitIdx});
   }
 
   /// @brief It's more efficient for us to allocate the whole state vector
@@ -232,75 +1014,186 @@ protected:
     // Increment the number of qubits and set
     // the new state dimension
     nQubitsAllocated += count;
-    auto oldStateDimension = stateDimension;
     stateDimension = calculateStateDim(nQubitsAllocated);
+    growDeviceStateVector();
+    return qubits;
+  }
 
-    if (!deviceStateVector) {
-      HANDLE_CUDA_ERROR(cudaMalloc((void **)&deviceStateVector,
-                                   stateDimension * sizeof(CudaDataType)));
-      constexpr int32_t threads_per_block = 256;
-      uint32_t n_blocks =
-          (stateDimension + threads_per_block - 1) / threads_per_block;
-      initializeDeviceStateVector<<<n_blocks, threads_per_block>>>(
-          reinterpret_cast<CudaDataType *>(deviceStateVector), stateDimension);
-      HANDLE_ERROR(custatevecCreate(&handle));
-    } else {
-      // Allocate new state..
-      void *newDeviceStateVector;
-      HANDLE_CUDA_ERROR(cudaMalloc((void **)&newDeviceStateVector,
-                                   stateDimension * sizeof(CudaDataType)));
-      constexpr int32_t threads_per_block = 256;
-      uint32_t n_blocks =
-          (stateDimension + threads_per_block - 1) / threads_per_block;
-      setFirstNElements<<<n_blocks, threads_per_block>>>(
-          reinterpret_cast<CudaDataType *>(newDeviceStateVector),
-          reinterpret_cast<CudaDataType *>(deviceStateVector),
-          oldStateDimension);
-      cudaFree(deviceStateVector);
-      deviceStateVector = newDeviceStateVector;
+  /// @brief Grow the state vector by one qubit.
+  void addQubitToState() override { growDeviceStateVector(); }
+
+  /// @brief Reset the qubit state. The device buffers and the handle are kept
+  /// for the next execution.
+  void resetQubitStateImpl() override {
+    deviceStateDimension = 0;
+    nResets = 0;
+  }
+
+  bool canSnapshotState() override { return true; }
+
+  /// @brief Copy the state on the device, if there is enough free device
+  /// memory left for the copy.
+  bool saveStateSnapshot() override {
+    if (snapshotDimension != stateDimension) {
+      clearStateSnapshot();
+      std::size_t freeBytes, totalBytes;
+      HANDLE_CUDA_ERROR(cudaMemGetInfo(&freeBytes, &totalBytes));
+      if (freeBytes < 2 * stateDimension * sizeof(CudaDataType))
+        return false;
+      HANDLE_CUDA_ERROR(
+          cudaMalloc(&deviceSnapshot, stateDimension * sizeof(CudaDataType)));
+      snapshotDimension = stateDimension;
     }
+    HANDLE_CUDA_ERROR(cudaMemcpyAsync(deviceSnapshot, deviceStateVector,
+                                      stateDimension * sizeof(CudaDataType),
+                                      cudaMemcpyDeviceToDevice, stream));
+    return true;
+  }
 
-    return qubits;
+  bool restoreStateSnapshot() override {
+    if (!deviceSnapshot || snapshotDimension != stateDimension)
+      return false;
+    HANDLE_CUDA_ERROR(cudaMemcpyAsync(deviceStateVector, deviceSnapshot,
+                                      stateDimension * sizeof(CudaDataType),
+                                      cudaMemcpyDeviceToDevice, stream));
+    return true;
   }
 
-  /// @brief Grow the state vector by one qubit.
-  void addQubitToState() override {
-    // Update the state vector
-    if (!deviceStateVector) {
-      HANDLE_CUDA_ERROR(cudaMalloc((void **)&deviceStateVector,
-                                   stateDimension * sizeof(CudaDataType)));
-      constexpr int32_t threads_per_block = 256;
-      uint32_t n_blocks =
-          (stateDimension + threads_per_block - 1) / threads_per_block;
-      initializeDeviceStateVector<<<n_blocks, threads_per_block>>>(
-          reinterpret_cast<CudaDataType *>(deviceStateVector), stateDimension);
-      HANDLE_ERROR(custatevecCreate(&handle));
+  void clearStateSnapshot() override {
+    if (deviceSnapshot)
+      HANDLE_CUDA_ERROR(cudaFree(deviceSnapshot));
+    deviceSnapshot = nullptr;
+    snapshotDimension = 0;
+  }
+
+  bool canRestoreState() override { return true; }
+
+  void setStateData(const std::complex<double> *data) override {
+    if constexpr (std::is_same_v<ScalarType, double>) {
+      HANDLE_CUDA_ERROR(cudaMemcpyAsync(deviceStateVector, data,
+                                        stateDimension * sizeof(CudaDataType),
+                                        cudaMemcpyHostToDevice, stream));
     } else {
-      int64_t oldDimension = calculateStateDim(std::log2(stateDimension) - 1);
-      // Allocate new state..
-      void *newDeviceStateVector;
-      HANDLE_CUDA_ERROR(cudaMalloc((void **)&newDeviceStateVector,
-                                   stateDimension * sizeof(CudaDataType)));
-      constexpr int32_t threads_per_block = 256;
-      uint32_t n_blocks =
-          (stateDimension + threads_per_block - 1) / threads_per_block;
-      setFirstNElements<<<n_blocks, threads_per_block>>>(
-          reinterpret_cast<CudaDataType *>(newDeviceStateVector),
-          reinterpret_cast<CudaDataType *>(deviceStateVector), oldDimension);
-      cudaFree(deviceStateVector);
-      deviceStateVector = newDeviceStateVector;
+      std::vector<CudaDataType> hostData(stateDimension);
+      for (std::size_t i = 0; i < stateDimension; i++)
+        hostData[i] = make_cuFloatComplex(data[i].real(), data[i].imag());
+      HANDLE_CUDA_ERROR(cudaMemcpyAsync(deviceStateVector, hostData.data(),
+                                        stateDimension * sizeof(CudaDataType),
+                                        cudaMemcpyHostToDevice, stream));
     }
+    HANDLE_CUDA_ERROR(cudaStreamSynchronize(stream));
   }
 
-  /// @brief Reset the qubit state.
-  void resetQubitStateImpl() override {
-    HANDLE_ERROR(custatevecDestroy(handle));
-    HANDLE_CUDA_ERROR(cudaFree(deviceStateVector));
-    if (extraWorkspaceSizeInBytes)
-      HANDLE_CUDA_ERROR(cudaFree(extraWorkspace));
-    deviceStateVector = nullptr;
-    extraWorkspaceSizeInBytes = 0;
-    nResets = 0;
+  /// @brief The amplitudes are copied to the device as the whole state, so
+  /// the targets must be all the qubits of the state, in index bit order.
+  /// Other initializations apply a state preparation circuit.
+  bool canInitializeState(const std::vector<std::size_t> &qubits) override {
+    if (qubits.size() >= 64 || 1ULL << qubits.size() != stateDimension)
+      return false;
+    for (std::size_t j = 0; j < qubits.size(); j++)
+      if (qubits[j] != j)
+        return false;
+    return true;
+  }
+
+  /// @brief Copy the amplitudes to the device, as setStateData() does.
+  void
+  applyStateInitialization(const std::vector<std::size_t> &qubits,
+                           const std::complex<double> *amplitudes) override {
+    setStateData(amplitudes);
+  }
+
+  /// @brief Return the amplitudes of the state as thrust complex numbers.
+  thrust::device_ptr<thrust::complex<ScalarType>>
+  devicePointer(void *data) const {
+    return thrust::device_pointer_cast(
+        reinterpret_cast<thrust::complex<ScalarType> *>(data));
+  }
+
+  bool canComputeOverlap() override { return true; }
+
+  /// @brief Copy the state into the auxiliary state `slot` on the device.
+  void copyStateToAuxiliary(std::size_t slot,
+                            std::complex<double> coefficient) override {
+    if (slot >= deviceAuxiliaryStates.size())
+      deviceAuxiliaryStates.resize(slot + 1, {nullptr, 0});
+    auto &[data, dimension] = deviceAuxiliaryStates[slot];
+    if (dimension != stateDimension) {
+      if (data)
+        HANDLE_CUDA_ERROR(cudaFree(data));
+      data = nullptr;
+      HANDLE_CUDA_ERROR(
+          cudaMalloc(&data, stateDimension * sizeof(CudaDataType)));
+      dimension = stateDimension;
+    }
+    auto state = devicePointer(deviceStateVector);
+    thrust::transform(
+        thrust::cuda::par.on(stream), state, state + stateDimension,
+        devicePointer(data),
+        ScaleAmplitude<ScalarType>{thrust::complex<ScalarType>(coefficient)});
+  }
+
+  /// @brief Return <a|psi> for the auxiliary state a in `slot`, reduced on
+  /// the device.
+  std::complex<double> overlapWithAuxiliary(std::size_t slot) override {
+    if (slot >= deviceAuxiliaryStates.size() ||
+        deviceAuxiliaryStates[slot].second != stateDimension)
+      throw std::runtime_error("The auxiliary state does not match the state.");
+    auto auxiliary = devicePointer(deviceAuxiliaryStates[slot].first);
+    const auto overlap = thrust::inner_product(
+        thrust::cuda::par.on(stream), auxiliary, auxiliary + stateDimension,
+        devicePointer(deviceStateVector), thrust::complex<double>(0.0),
+        thrust::plus<thrust::complex<double>>(),
+        ConjugateProduct<ScalarType>());
+    return {overlap.real(), overlap.imag()};
+  }
+
+  /// @brief Copy the requested amplitudes to the host, waiting for the
+  /// stream once.
+  std::vector<std::complex<double>>
+  getAmplitudes(const std::vector<std::size_t> &indices) override {
+    std::vector<DataType> amplitudes(indices.size());
+    const auto *data = static_cast<const CudaDataType *>(deviceStateVector);
+    for (std::size_t i = 0; i < indices.size(); i++)
+      HANDLE_CUDA_ERROR(cudaMemcpyAsync(&amplitudes[i], data + indices[i],
+                                        sizeof(CudaDataType),
+                                        cudaMemcpyDeviceToHost, stream));
+    HANDLE_CUDA_ERROR(cudaStreamSynchronize(stream));
+    return {amplitudes.begin(), amplitudes.end()};
+  }
+
+  /// @brief Reduce the probabilities of the outcomes of the qubits on the
+  /// device, only they are copied to the host.
+  std::vector<double>
+  getMarginalProbabilities(const std::vector<std::size_t> &qubits) override {
+    std::vector<int> bitOrdering(qubits.begin(), qubits.end());
+    std::vector<double> probabilities(1ULL << qubits.size());
+    HANDLE_ERROR(custatevecAbs2SumArray(
+        handle, deviceStateVector, cuStateVecCudaDataType, nQubitsAllocated,
+        probabilities.data(), bitOrdering.data(), bitOrdering.size(),
+        /*maskBitString*/ nullptr, /*maskOrdering*/ nullptr, /*maskLen*/ 0));
+    HANDLE_CUDA_ERROR(cudaStreamSynchronize(stream));
+    return probabilities;
+  }
+
+  void clearAuxiliaryStates() override {
+    for (auto &[data, dimension] : deviceAuxiliaryStates)
+      if (data)
+        HANDLE_CUDA_ERROR(cudaFree(data));
+    deviceAuxiliaryStates.clear();
+  }
+
+  /// @brief The device memory of the state vector, including the capacity
+  /// it keeps to grow.
+  std::size_t getStateBytes() override {
+    return deviceStateCapacity * sizeof(CudaDataType);
+  }
+
+  /// @brief The free memory of the current device.
+  std::size_t getFreeMemory() override {
+    std::size_t freeBytes, totalBytes;
+    HANDLE_CUDA_ERROR(cudaMemGetInfo(&freeBytes, &totalBytes));
+    return freeBytes;
   }
 
 public:
@@ -311,11 +1204,84 @@ public:
       cuStateVecCudaDataType = CUDA_C_32F;
     }
 
+    enableGateFusion();
+    // CUDAQ_FUSION_GEMM=1 applies wide fused gates with cuBLAS, on FP64
+    // tensor cores where available. For single precision, =tf32 allows
+    // TF32 tensor cores.
+    if (auto *gemm = std::getenv("CUDAQ_FUSION_GEMM")) {
+      const std::string mode(gemm);
+      useGemmFusion = !mode.empty() && mode != "0";
+      if constexpr (std::is_same_v<ScalarType, float>)
+        gemmComputeType = mode == "tf32" ? CUBLAS_COMPUTE_32F_FAST_TF32
+                                         : CUBLAS_COMPUTE_32F;
+      if (useGemmFusion)
+        cudaq::info("Fused gates applied as GEMMs ({}).", mode);
+    }
     cudaFree(0);
+
+    HANDLE_CUDA_ERROR(cudaStreamCreate(&stream));
+    HANDLE_CUDA_ERROR(cudaMallocHost(&hostMatrixRing, matrixRingBytes));
+    HANDLE_CUDA_ERROR(cudaMalloc(&deviceMatrixRing, matrixRingBytes));
+    for (auto &event : matrixRingEvents)
+      HANDLE_CUDA_ERROR(
+          cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+
+    // Keep the memory freed to the stream ordered pool reserved for reuse,
+    // rather than releasing it at every synchronization.
+    int device;
+    cudaMemPool_t pool;
+    uint64_t threshold = UINT64_MAX;
+    HANDLE_CUDA_ERROR(cudaGetDevice(&device));
+    HANDLE_CUDA_ERROR(cudaDeviceGetDefaultMemPool(&pool, device));
+    HANDLE_CUDA_ERROR(cudaMemPoolSetAttribute(
+        pool, cudaMemPoolAttrReleaseThreshold, &threshold));
   }
 
   /// The destructor
-  virtual ~CuStateVecCircuitSimulator() = default;
+  virtual ~CuStateVecCircuitSimulator() {
+    if (deviceStateVector)
+      cudaFree(deviceStateVector);
+    if (extraWorkspace)
+      cudaFree(extraWorkspace);
+    if (deviceBatchedStateVector)
+      cudaFree(deviceBatchedStateVector);
+    for (auto &[data, dimension] : deviceAuxiliaryStates)
+      if (data)
+        cudaFree(data);
+    for (auto &[name, deviceMatrix] : namedGateMatrices)
+      cudaFree(deviceMatrix);
+    if (deviceRandomBuffer)
+      cudaFree(deviceRandomBuffer);
+    if (hostRandomBuffer)
+      cudaFreeHost(hostRandomBuffer);
+    if (randomGenerator)
+      curandDestroyGenerator(randomGenerator);
+    if (deviceGemmScratch)
+      cudaFree(deviceGemmScratch);
+    if (blasHandle)
+      cublasDestroy(blasHandle);
+    cudaFree(deviceMatrixRing);
+    cudaFreeHost(hostMatrixRing);
+    for (auto &event : matrixRingEvents)
+      cudaEventDestroy(event);
+    if (hasHandle)
+      custatevecDestroy(handle);
+    cudaStreamDestroy(stream);
+  }
+
+  /// @brief Simulators on the same GPU would only contend for it.
+  bool canRunConcurrently() override { return false; }
+
+  void seedRandomEngines(std::uint64_t seed) override {
+    CircuitSimulator::seedRandomEngines(seed);
+    measureRandomEngine.seed(seed);
+    randomGeneratorSeed = seed;
+    if (randomGenerator) {
+      HANDLE_CURAND_ERROR(
+          curandSetPseudoRandomGeneratorSeed(randomGenerator, seed));
+      HANDLE_CURAND_ERROR(curandSetGeneratorOffset(randomGenerator, 0));
+    }
+  }
 
 /// The one-qubit overrides
 #define QPP_ONE_QUBIT_METHOD_OVERRIDE(NAME)                                    \
@@ -353,17 +1319,19 @@ public:
   /// @param qubitIdx
   void r1(const double angle, const std::vector<std::size_t> &controls,
           const std::size_t qubitIdx) override {
-    cudaq::info(gateToString("r1", controls, {}, {qubitIdx}));
-    DataVector matrix{
-        {1.0, 0.0},
-        {0.0, 0.0},
-        {0.0, 0.0},
-        std::exp(nvqir::im<ScalarType> * static_cast<ScalarType>(angle))};
+    CUDAQ_INFO(gateToString("r1", controls, {}, {qubitIdx}));
+    if (skipPrefixGate("r1", {angle}, controls, {qubitIdx}))
+      return;
+    const auto matrix =
+        nvqir::r1<ScalarType>::getMatrix(static_cast<ScalarType>(angle));
+    if (fuseGateMatrix(matrix, controls, {qubitIdx}))
+      return;
     std::vector<int> targets{(int)qubitIdx}, ctrls32;
     for (auto &c : controls)
       ctrls32.push_back(c);
 
     applyGateMatrix(matrix, ctrls32, targets);
+    applyNoise("r1", controls, {qubitIdx});
   }
 
   using CircuitSimulator::u2;
@@ -377,13 +1345,18 @@ public:
           const std::size_t qubitIdx) override {
     ScalarType castedPhi = static_cast<ScalarType>(phi);
     ScalarType castedLambda = static_cast<ScalarType>(lambda);
-    cudaq::info(gateToString("u2", controls, {phi, lambda}, {qubitIdx}));
-    auto matrix = nvqir::getGateByName<ScalarType>(nvqir::GateName::U2,
-                                                   {castedPhi, castedLambda});
+    CUDAQ_INFO(gateToString("u2", controls, {phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u2", {phi, lambda}, controls, {qubitIdx}))
+      return;
+    const auto matrix =
+        nvqir::u2<ScalarType>::getMatrix(castedPhi, castedLambda);
+    if (fuseGateMatrix(matrix, controls, {qubitIdx}))
+      return;
     std::vector<int> targets{(int)qubitIdx}, ctrls32;
     for (auto &c : controls)
       ctrls32.push_back(c);
     applyGateMatrix(matrix, ctrls32, targets);
+    applyNoise("u2", controls, {qubitIdx});
   }
 
   using CircuitSimulator::u3;
@@ -399,13 +1372,18 @@ public:
     auto castedTheta = static_cast<ScalarType>(theta);
     auto castedPhi = static_cast<ScalarType>(phi);
     auto castedLambda = static_cast<ScalarType>(lambda);
-    cudaq::info(gateToString("u3", controls, {theta, phi, lambda}, {qubitIdx}));
-    auto matrix = nvqir::getGateByName<ScalarType>(
-        nvqir::GateName::U3, {castedTheta, castedPhi, castedLambda});
+    CUDAQ_INFO(gateToString("u3", controls, {theta, phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u3", {theta, phi, lambda}, controls, {qubitIdx}))
+      return;
+    const auto matrix = nvqir::u3<ScalarType>::getMatrix(
+        castedTheta, castedPhi, castedLambda);
+    if (fuseGateMatrix(matrix, controls, {qubitIdx}))
+      return;
     std::vector<int> targets{(int)qubitIdx}, ctrls32;
     for (auto &c : controls)
       ctrls32.push_back(c);
     applyGateMatrix(matrix, ctrls32, targets);
+    applyNoise("u3", controls, {qubitIdx});
   }
 
   using CircuitSimulator::u1;
@@ -422,24 +1400,57 @@ public:
   using CircuitSimulator::swap;
   void swap(const std::vector<std::size_t> &ctrlBits, const std::size_t srcIdx,
             const std::size_t tgtIdx) override {
-    cudaq::info(gateToString("swap", ctrlBits, {}, {srcIdx, tgtIdx}));
-    DataVector matrix{{1.0, 0.0}, {0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0},
-                      {0.0, 0.0}, {0.0, 0.0}, {1.0, 0.0}, {0.0, 0.0},
-                      {0.0, 0.0}, {1.0, 0.0}, {0.0, 0.0}, {0.0, 0.0},
-                      {0.0, 0.0}, {0.0, 0.0}, {0.0, 0.0}, {1.0, 0.0}};
-    std::vector<int> targets{(int)srcIdx, (int)tgtIdx}, ctrls32;
-    for (auto &c : ctrlBits)
-      ctrls32.push_back(c);
-    applyGateMatrix(matrix, ctrls32, targets);
+    CUDAQ_INFO(gateToString("swap", ctrlBits, {}, {srcIdx, tgtIdx}));
+    if (skipPrefixGate("swap", {}, ctrlBits, {srcIdx, tgtIdx}))
+      return;
+    constexpr auto matrix = swapMatrix();
+    if (fuseGateMatrix(matrix, ctrlBits, {srcIdx, tgtIdx}))
+      return;
+    // A swap only permutes the amplitudes, the controls select the
+    // amplitudes whose control bits are all set.
+    const int2 bitSwap{(int)srcIdx, (int)tgtIdx};
+    std::vector<int32_t> maskBitString(ctrlBits.size(), 1);
+    std::vector<int32_t> maskOrdering(ctrlBits.begin(), ctrlBits.end());
+    swapIndexBits(&bitSwap, 1, maskBitString, maskOrdering);
+    applyNoise("swap", ctrlBits, {srcIdx, tgtIdx});
+  }
+
+  bool canPermuteQubits() override { return true; }
+
+  /// @brief Permute the qubits with one index bit swap call for each of the
+  /// (at most two) layers of disjoint swaps.
+  void applyQubitPermutation(
+      const std::vector<std::size_t> &qubits,
+      const std::vector<std::size_t> &permutation) override {
+    for (auto &layer : getSwapLayers(qubits, permutation)) {
+      std::vector<int2> bitSwaps;
+      for (auto [a, b] : layer)
+        bitSwaps.push_back({(int)a, (int)b});
+      swapIndexBits(bitSwaps.data(), bitSwaps.size(), {}, {});
+    }
+  }
+
+  /// @brief Swap the pairs of index bits of the amplitudes whose
+  /// `maskOrdering` bits equal `maskBitString`.
+  void swapIndexBits(const int2 *bitSwaps, const std::size_t nBitSwaps,
+                     const std::vector<int32_t> &maskBitString,
+                     const std::vector<int32_t> &maskOrdering) {
+    HANDLE_ERROR(custatevecSwapIndexBits(
+        handle, deviceStateVector, cuStateVecCudaDataType,
+        nQubitsAllocated + nResets, bitSwaps, nBitSwaps,
+        maskBitString.empty() ? nullptr : maskBitString.data(),
+        maskOrdering.empty() ? nullptr : maskOrdering.data(),
+        maskOrdering.size()));
   }
 
   /// @brief Measure operation
   /// @param qubitIdx
   /// @return
   bool measureQubit(const std::size_t qubitIdx) override {
+    synchronizeState();
     const int basisBits[] = {(int)qubitIdx};
     int parity;
-    double rand = randomValues(1, 1.0)[0];
+    double rand = measureRandomValue();
     HANDLE_ERROR(custatevecMeasureOnZBasis(
         handle, deviceStateVector, cuStateVecCudaDataType, nQubitsAllocated,
         &parity, basisBits, /*N Bits*/ 1, rand,
@@ -448,13 +1459,31 @@ public:
     return parity == 1 ? true : false;
   }
 
+  /// @brief Measure the qubits with one custatevecBatchMeasure call, which
+  /// collapses the state in a single pass.
+  std::vector<bool>
+  measureQubits(const std::vector<std::size_t> &qubitIdxs) override {
+    if (qubitIdxs.size() < 2)
+      return CircuitSimulator::measureQubits(qubitIdxs);
+    synchronizeState();
+    std::vector<int> bitOrdering(qubitIdxs.begin(), qubitIdxs.end());
+    std::vector<int> bitString(qubitIdxs.size());
+    HANDLE_ERROR(custatevecBatchMeasure(
+        handle, deviceStateVector, cuStateVecCudaDataType, nQubitsAllocated,
+        bitString.data(), bitOrdering.data(), bitOrdering.size(),
+        measureRandomValue(), CUSTATEVEC_COLLAPSE_NORMALIZE_AND_ZERO));
+    cudaq::info("Measured qubits {} -> {}", qubitIdxs, bitString);
+    return std::vector<bool>(bitString.begin(), bitString.end());
+  }
+
   /// @brief Reset the qubit
   /// @param qubitIdx
   void resetQubit(const std::size_t qubitIdx) override {
+    synchronizeState();
     nResets++;
     const int basisBits[] = {(int)qubitIdx};
     int parity;
-    double rand = randomValues(1, 1.0)[0];
+    double rand = measureRandomValue();
     HANDLE_ERROR(custatevecMeasureOnZBasis(
         handle, deviceStateVector, cuStateVecCudaDataType, nQubitsAllocated,
         &parity, basisBits, /*N Bits*/ 1, rand,
@@ -470,6 +1499,7 @@ public:
   /// @return
   cudaq::ExecutionResult sample(const std::vector<std::size_t> &measuredBits,
                             const int shots) override {
+    synchronizeState();
     double expVal = 0.0;
     // cudaq::CountsDictionary counts;
     std::vector<custatevecPauli_t> z_pauli;
@@ -493,68 +1523,99 @@ public:
       return cudaq::ExecutionResult{expVal};
     }
 
-    // Grab some random seed values and create the sampler
-    auto randomValues_ = randomValues(shots, 1.0);
+    // Draw the sorted random values on the device and create the sampler
+    const double *randomValues_ = sortedRandomValues(shots);
     custatevecSamplerDescriptor_t sampler;
     HANDLE_ERROR(custatevecSamplerCreate(
         handle, deviceStateVector, cuStateVecCudaDataType, nQubitsAllocated,
         &sampler, shots, &extraWorkspaceSizeInBytes));
     // allocate external workspace if necessary
-    if (extraWorkspaceSizeInBytes > 0) {
-      HANDLE_CUDA_ERROR(cudaMalloc(&extraWorkspace, extraWorkspaceSizeInBytes));
-    }
+    reserveExtraWorkspace();
 
     // Run the sampling preprocess step.
     HANDLE_ERROR(custatevecSamplerPreprocess(handle, sampler, extraWorkspace,
                                              extraWorkspaceSizeInBytes));
 
     // Sample!
-    custatevecIndex_t bitstrings0[shots];
+    std::vector<custatevecIndex_t> bitstrings0(shots);
     HANDLE_ERROR(custatevecSamplerSample(
-        handle, sampler, bitstrings0, measuredBits32.data(),
-        measuredBits32.size(), randomValues_.data(), shots,
+        handle, sampler, bitstrings0.data(), measuredBits32.data(),
+        measuredBits32.size(), randomValues_, shots,
         CUSTATEVEC_SAMPLER_OUTPUT_ASCENDING_ORDER));
+    HANDLE_ERROR(custatevecSamplerDestroy(sampler));
 
-    std::vector<std::string> sequentialData;
-
+    // The outcomes come out in ascending order, so equal ones are adjacent
+    // and are counted in one pass, appending each distinct outcome once as
+    // a packed bit string (bit j holding measuredBits[j]). Every shot is
+    // appended on its own only if the sequential data is requested.
+    static const bool sequentialShots = []() {
+      auto *env = std::getenv("CUDAQ_SEQUENTIAL_SHOTS");
+      return env && std::strtoul(env, nullptr, 10) != 0;
+    }();
     cudaq::ExecutionResult counts;
-
-    // We've sampled, convert the results to our ExecutionResult counts
-    for (int i = 0; i < shots; ++i) {
-      auto bitstring = std::bitset<64>(bitstrings0[i])
-                           .to_string()
-                           .erase(0, 64 - measuredBits.size());
-      std::reverse(bitstring.begin(), bitstring.end());
-      sequentialData.push_back(bitstring);
-      counts.appendResult(bitstring, 1);
-    }
-
-    // Compute the expectation value from the counts
-    for (auto &kv : counts.counts) {
-      auto par = hasEvenParity(kv.first);
-      auto p = kv.second / (double)shots;
-      if (!par) {
-        p = -p;
-      }
-      expVal += p;
+    for (int i = 0; i < shots;) {
+      const std::uint64_t outcome = bitstrings0[i];
+      int next = i + 1;
+      if (!sequentialShots)
+        while (next < shots &&
+               static_cast<std::uint64_t>(bitstrings0[next]) == outcome)
+          next++;
+      counts.appendResult(&outcome, measuredBits.size(), next - i);
+      expVal += (hasEvenParity(outcome) ? 1.0 : -1.0) * (next - i);
+      i = next;
     }
+    expVal /= shots;
 
     counts.expectationValue = expVal;
     return counts;
   }
 
+  /// @brief Compute <psi| H |psi> for all terms in one call, without
+  /// changing the state.
+  cudaq::ExecutionResult observe(const cudaq::spin_op &H) override {
+    if (recordingBatch)
+      return observeRecordedBatch(H);
+    synchronizeState();
+    return cudaq::ExecutionResult{
+        computeSpinOpExpectation(deviceStateVector, nQubitsAllocated, H)};
+  }
+
   cudaq::State getStateData() override {
+    synchronizeState();
     if constexpr (std::is_same_v<ScalarType, float>) {
       throw std::runtime_error(
           "CustateVec F32 does not support getStateData().");
     } else {
       std::vector<std::complex<ScalarType>> data(stateDimension);
-      cudaMemcpy(data.data(), deviceStateVector,
-                 stateDimension * sizeof(CudaDataType), cudaMemcpyDeviceToHost);
+      HANDLE_CUDA_ERROR(cudaMemcpyAsync(data.data(), deviceStateVector,
+                                        stateDimension * sizeof(CudaDataType),
+                                        cudaMemcpyDeviceToHost, stream));
+      HANDLE_CUDA_ERROR(cudaStreamSynchronize(stream));
       return cudaq::State{{stateDimension}, data};
     }
   }
 
+  /// @brief Reference the device state vector, it is not copied.
+  std::unique_ptr<cudaq::SimulationState> getSimulationState() override {
+    synchronizeState();
+    HANDLE_CUDA_ERROR(cudaStreamSynchronize(stream));
+    return std::make_unique<DeviceSimulationState<CudaDataType>>(
+        deviceStateVector, stateDimension, /*ownsData=*/false);
+  }
+
+  /// @brief Hand the device state vector over to the returned state, the
+  /// next execution allocates a new one.
+  std::unique_ptr<cudaq::SimulationState> takeSimulationState() override {
+    synchronizeState();
+    HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+    auto taken = std::make_unique<DeviceSimulationState<CudaDataType>>(
+        deviceStateVector, stateDimension, /*ownsData=*/true);
+    deviceStateVector = nullptr;
+    deviceStateCapacity = 0;
+    deviceStateDimension = 0;
+    return taken;
+  }
+
   std::string name() const override;
   NVQIR_SIMULATOR_CLONE_IMPL(CuStateVecCircuitSimulator<ScalarType>)
 };
@@ -0,0 +1,563 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#define __NVQIR_CUSTATEVEC_TOGGLE_CREATE
+#include "CuStateVecCircuitSimulator.cu"
+#include <map>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/transform_reduce.h>
+
+namespace {
+
+/// @brief Return the index with bit j of `k` moved to bit 2j.
+__host__ __device__ inline std::uint64_t spreadBits(std::uint64_t k) {
+  std::uint64_t spread = 0;
+  for (int j = 0; k; j++, k >>= 1)
+    spread |= (k & 1) << (2 * j);
+  return spread;
+}
+
+/// @brief Copy the real diagonal rho(k, k) of the vectorized density matrix.
+__global__ void densityMatrixDiagonal(const cuDoubleComplex *rho,
+                                      double *diagonal, int64_t dim) {
+  int64_t k = static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (k < dim)
+    diagonal[k] = rho[spreadBits(k) * 3].x;
+}
+
+/// @brief Copy the vectorized density matrix into the row major matrix,
+/// rho(k, b) at k * dim + b.
+__global__ void unvectorizeDensityMatrix(const cuDoubleComplex *rho,
+                                         cuDoubleComplex *matrix,
+                                         int64_t dim) {
+  int64_t i = static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (i < dim * dim)
+    matrix[i] = rho[spreadBits(i / dim) | spreadBits(i % dim) << 1];
+}
+
+/// @brief The contribution rho(k, k ^ xMask) (-1)^|k & zMask| of the basis
+/// state k to Tr(rho P), up to the phase i^nY of the Pauli string P.
+struct PauliTraceTerm {
+  const thrust::complex<double> *rho;
+  std::uint64_t xMask, zMask;
+  __host__ __device__ thrust::complex<double>
+  operator()(std::uint64_t k) const {
+    const auto element = rho[spreadBits(k) | spreadBits(k ^ xMask) << 1];
+    bool odd = false;
+    for (auto z = k & zMask; z; z &= z - 1)
+      odd = !odd;
+    return odd ? -element : element;
+  }
+};
+
+/// @brief The CuStateVecDMCircuitSimulator simulates the density matrix rho
+/// of n qubits on the GPU as the state vector vec(rho) of 2n qubits, which
+/// cuStateVec manipulates like any other state vector. Qubit q of the circuit
+/// is held by the index bits 2q (the row, or ket, of rho) and 2q + 1 (the
+/// column, or bra), so that the state grows qubit by qubit like a state
+/// vector. A gate U is applied as U on the ket bits and conj(U) on the bra
+/// bits, i.e. U rho U^dag, and the kraus_channels of the noise model as
+/// their superoperators, so noisy circuits are simulated exactly, without
+/// trajectories. The state takes 16 * 4^n bytes of device memory.
+class CuStateVecDMCircuitSimulator : public nvqir::CircuitSimulator {
+protected:
+  using DataVector = std::vector<std::complex<double>>;
+
+  /// @brief The vectorized density matrix on the device, and its number of
+  /// elements.
+  void *deviceState = nullptr;
+  std::size_t deviceStateCapacity = 0;
+  std::size_t deviceStateDimension = 0;
+
+  /// @brief The number of qubits held by the device state. Deallocated
+  /// qubits are reset but stay in the state until it is reset, this may
+  /// exceed nQubitsAllocated.
+  std::size_t nStateQubits = 0;
+
+  custatevecHandle_t handle;
+  bool hasHandle = false;
+  cudaStream_t stream = nullptr;
+
+  void *extraWorkspace = nullptr;
+  std::size_t extraWorkspaceSizeInBytes = 0;
+  std::size_t extraWorkspaceCapacity = 0;
+
+  /// @brief Device buffer of the diagonal of the density matrix.
+  double *deviceDiagonal = nullptr;
+  std::size_t diagonalCapacity = 0;
+
+  /// @brief The superoperators of the noise model of the execution context,
+  /// frozen when the context is set, see cudaq::get_superoperator().
+  cudaq::noise_table<DataVector> superOperators;
+
+  std::mt19937_64 randomEngine{std::random_device{}()};
+
+  /// @brief Grow the extra workspace to extraWorkspaceSizeInBytes.
+  void reserveExtraWorkspace() {
+    if (extraWorkspaceSizeInBytes <= extraWorkspaceCapacity)
+      return;
+    if (extraWorkspace)
+      HANDLE_CUDA_ERROR(cudaFreeAsync(extraWorkspace, stream));
+    HANDLE_CUDA_ERROR(
+        cudaMallocAsync(&extraWorkspace, extraWorkspaceSizeInBytes, stream));
+    extraWorkspaceCapacity = extraWorkspaceSizeInBytes;
+  }
+
+  /// @brief Grow the device state to nStateQubits qubits. The new qubits
+  /// are in |0><0|, i.e. the new elements are zero.
+  void growDeviceState() {
+    if (!hasHandle) {
+      HANDLE_ERROR(custatevecCreate(&handle));
+      HANDLE_ERROR(custatevecSetStream(handle, stream));
+      hasHandle = true;
+    }
+    const std::size_t oldDimension = deviceStateDimension;
+    const std::size_t dimension = 1ULL << (2 * nStateQubits);
+    if (dimension <= oldDimension)
+      return;
+
+    if (dimension > deviceStateCapacity) {
+      void *grown;
+      HANDLE_CUDA_ERROR(cudaMallocAsync(
+          &grown, dimension * sizeof(cuDoubleComplex), stream));
+      if (oldDimension)
+        HANDLE_CUDA_ERROR(cudaMemcpyAsync(
+            grown, deviceState, oldDimension * sizeof(cuDoubleComplex),
+            cudaMemcpyDeviceToDevice, stream));
+      if (deviceState)
+        HANDLE_CUDA_ERROR(cudaFreeAsync(deviceState, stream));
+      deviceState = grown;
+      deviceStateCapacity = dimension;
+    }
+
+    if (oldDimension == 0) {
+      constexpr int32_t threads_per_block = 256;
+      uint32_t n_blocks = (dimension + threads_per_block - 1) /
+                          threads_per_block;
+      initializeDeviceStateVector<<<n_blocks, threads_per_block, 0, stream>>>(
+          reinterpret_cast<cuDoubleComplex *>(deviceState), dimension);
+    } else {
+      HANDLE_CUDA_ERROR(cudaMemsetAsync(
+          reinterpret_cast<cuDoubleComplex *>(deviceState) + oldDimension, 0,
+          (dimension - oldDimension) * sizeof(cuDoubleComplex), stream));
+    }
+    deviceStateDimension = dimension;
+  }
+
+  /// @brief Apply the row major matrix to the index bits `targets` of the
+  /// vectorized density matrix, targets[0] the least significant bit of the
+  /// matrix index, if all of the `controls` bits are set.
+  void applyStateMatrix(const DataVector &matrix,
+                        const std::vector<int> &controls,
+                        const std::vector<int> &targets) {
+    const auto nIndexBits = 2 * nStateQubits;
+    HANDLE_ERROR(custatevecApplyMatrixGetWorkspaceSize(
+        handle, CUDA_C_64F, nIndexBits, matrix.data(), CUDA_C_64F,
+        CUSTATEVEC_MATRIX_LAYOUT_ROW, 0, targets.size(), controls.size(),
+        CUSTATEVEC_COMPUTE_64F, &extraWorkspaceSizeInBytes));
+    reserveExtraWorkspace();
+    HANDLE_ERROR(custatevecApplyMatrix(
+        handle, deviceState, CUDA_C_64F, nIndexBits, matrix.data(),
+        CUDA_C_64F, CUSTATEVEC_MATRIX_LAYOUT_ROW, 0, targets.data(),
+        targets.size(), controls.empty() ? nullptr : controls.data(), nullptr,
+        controls.size(), CUSTATEVEC_COMPUTE_64F, extraWorkspace,
+        extraWorkspaceSizeInBytes));
+  }
+
+  /// @brief Apply U rho U^dag for the row major unitary U on the `targets`,
+  /// targets[0] the least significant bit of the matrix index, controlled
+  /// by the `controls`.
+  void applyUnitary(const DataVector &matrix,
+                    const std::vector<std::size_t> &controls,
+                    const std::vector<std::size_t> &targets) {
+    std::vector<int> ketControls, braControls, ketTargets, braTargets;
+    for (auto c : controls) {
+      ketControls.push_back(2 * c);
+      braControls.push_back(2 * c + 1);
+    }
+    for (auto t : targets) {
+      ketTargets.push_back(2 * t);
+      braTargets.push_back(2 * t + 1);
+    }
+    DataVector conjugate(matrix.size());
+    for (std::size_t i = 0; i < matrix.size(); i++)
+      conjugate[i] = std::conj(matrix[i]);
+    applyStateMatrix(matrix, ketControls, ketTargets);
+    applyStateMatrix(conjugate, braControls, braTargets);
+  }
+
+  /// @brief Apply the gate and the kraus_channels of the noise model for it.
+  template <typename MatrixT>
+  void applyGate(const std::string_view gateName,
+                 const std::vector<double> &parameters, const MatrixT &matrix,
+                 const std::vector<std::size_t> &controls,
+                 const std::vector<std::size_t> &targets) {
+    CUDAQ_INFO(gateToString(gateName, controls, parameters, targets));
+    if (skipPrefixGate(gateName, parameters, controls, targets))
+      return;
+    applyUnitary(DataVector(matrix.begin(), matrix.end()), controls, targets);
+    std::vector<std::size_t> noiseQubits(controls);
+    noiseQubits.insert(noiseQubits.end(), targets.begin(), targets.end());
+    applyNoiseChannel(gateName, noiseQubits);
+  }
+
+  /// @brief Apply the superoperator of the noise model for the gate on the
+  /// qubits, if any. Its index is (a, b) with the ket index a in the high
+  /// bits and qubits[0] the most significant bit of a and b.
+  void applyNoiseChannel(const std::string_view gateName,
+                         const std::vector<std::size_t> &qubits) {
+    if (!executionContext || !executionContext->noiseModel)
+      return;
+    const auto *superOp = superOperators.find(gateName, qubits);
+    if (!superOp || superOp->empty())
+      return;
+    cudaq::info("Applying noise channel for {} to qubits {}", gateName,
+                qubits);
+    const std::size_t k = qubits.size();
+    std::vector<int> targets(2 * k);
+    for (std::size_t i = 0; i < k; i++) {
+      targets[i] = 2 * qubits[k - 1 - i] + 1;
+      targets[k + i] = 2 * qubits[k - 1 - i];
+    }
+    applyStateMatrix(*superOp, {}, targets);
+  }
+
+  /// @brief Return the diagonal of the density matrix, the probabilities of
+  /// the basis states, copied to the host.
+  std::vector<double> getDiagonal() {
+    const std::size_t dim = 1ULL << nStateQubits;
+    if (dim > diagonalCapacity) {
+      if (deviceDiagonal)
+        HANDLE_CUDA_ERROR(cudaFreeAsync(deviceDiagonal, stream));
+      HANDLE_CUDA_ERROR(cudaMallocAsync(
+          reinterpret_cast<void **>(&deviceDiagonal), dim * sizeof(double),
+          stream));
+      diagonalCapacity = dim;
+    }
+    constexpr int32_t threads_per_block = 256;
+    const int64_t n_blocks = (dim + threads_per_block - 1) / threads_per_block;
+    densityMatrixDiagonal<<<n_blocks, threads_per_block, 0, stream>>>(
+        static_cast<const cuDoubleComplex *>(deviceState), deviceDiagonal,
+        dim);
+    HANDLE_CUDA_ERROR(cudaGetLastError());
+    std::vector<double> diagonal(dim);
+    HANDLE_CUDA_ERROR(cudaMemcpyAsync(diagonal.data(), deviceDiagonal,
+                                      dim * sizeof(double),
+                                      cudaMemcpyDeviceToHost, stream));
+    HANDLE_CUDA_ERROR(cudaStreamSynchronize(stream));
+    return diagonal;
+  }
+
+  /// @brief Reduce the probabilities of the outcomes of the qubits from the
+  /// diagonal, with bit j of an outcome the value of qubits[j].
+  std::vector<double>
+  getMarginalProbabilities(const std::vector<std::size_t> &qubits) override {
+    const auto diagonal = getDiagonal();
+    std::vector<double> probabilities(1ULL << qubits.size(), 0.0);
+    for (std::size_t k = 0; k < diagonal.size(); k++) {
+      std::size_t outcome = 0;
+      for (std::size_t j = 0; j < qubits.size(); j++)
+        outcome |= ((k >> qubits[j]) & 1) << j;
+      probabilities[outcome] += diagonal[k];
+    }
+    return probabilities;
+  }
+
+  /// @brief Return Tr(rho P) for the Pauli string P with X or Y on the
+  /// qubits in `xMask`, Z or Y on those in `zMask`, and nY Y factors,
+  /// reduced on the device.
+  double pauliTrace(std::uint64_t xMask, std::uint64_t zMask,
+                    std::size_t nY) {
+    const std::uint64_t dim = 1ULL << nStateQubits;
+    const auto trace = thrust::transform_reduce(
+        thrust::cuda::par.on(stream), thrust::counting_iterator<uint64_t>(0),
+        thrust::counting_iterator<uint64_t>(dim),
+        PauliTraceTerm{
+            reinterpret_cast<const thrust::complex<double> *>(deviceState),
+            xMask, zMask},
+        thrust::complex<double>(0.0), thrust::plus<thrust::complex<double>>());
+    // Multiply by i^nY, only the real part is kept.
+    switch (nY % 4) {
+    case 0:
+      return trace.real();
+    case 1:
+      return -trace.imag();
+    case 2:
+      return -trace.real();
+    default:
+      return trace.imag();
+    }
+  }
+
+  std::size_t getRequiredStateBytes(std::size_t numQubits) override {
+    return stateVectorBytes(2 * numQubits, sizeof(cuDoubleComplex));
+  }
+
+  std::size_t getStateBytes() override {
+    return deviceStateCapacity * sizeof(cuDoubleComplex);
+  }
+
+  std::size_t getFreeMemory() override {
+    std::size_t freeBytes, totalBytes;
+    HANDLE_CUDA_ERROR(cudaMemGetInfo(&freeBytes, &totalBytes));
+    return freeBytes;
+  }
+
+  /// @brief Deallocated qubits are reset to |0><0| and stay in the state, a
+  /// reallocated index reuses them.
+  void addQubitToState() override {
+    nStateQubits = std::max<std::size_t>(nStateQubits, nQubitsAllocated);
+    growDeviceState();
+  }
+
+  void resetQubitStateImpl() override {
+    deviceStateDimension = 0;
+    nStateQubits = 0;
+  }
+
+  /// @brief Dense matrices, e.g. custom unitaries, are applied to the ket
+  /// and bra bits of their targets.
+  void applyDenseMatrix(const std::vector<std::complex<double>> &matrix,
+                        const std::vector<std::size_t> &targets) override {
+    applyUnitary(matrix, {}, targets);
+  }
+
+  bool canHandleObserve() override { return isExactObservation(); }
+
+public:
+  CuStateVecDMCircuitSimulator() {
+    cudaFree(0);
+    HANDLE_CUDA_ERROR(cudaStreamCreate(&stream));
+  }
+
+  virtual ~CuStateVecDMCircuitSimulator() {
+    if (deviceState)
+      cudaFree(deviceState);
+    if (extraWorkspace)
+      cudaFree(extraWorkspace);
+    if (deviceDiagonal)
+      cudaFree(deviceDiagonal);
+    if (hasHandle)
+      custatevecDestroy(handle);
+    cudaStreamDestroy(stream);
+  }
+
+  /// @brief Simulators on the same GPU would only contend for it.
+  bool canRunConcurrently() override { return false; }
+
+  void seedRandomEngines(std::uint64_t seed) override {
+    CircuitSimulator::seedRandomEngines(seed);
+    randomEngine.seed(seed);
+  }
+
+  /// @brief Set the execution context, freezing the superoperators of its
+  /// noise model, which may have changed since the last execution.
+  void setExecutionContext(cudaq::ExecutionContext *context) override {
+    superOperators = cudaq::noise_table<DataVector>();
+    if (context && context->noiseModel)
+      superOperators = cudaq::noise_table<DataVector>(
+          *context->noiseModel,
+          [](const std::string &gateName,
+             const std::vector<std::size_t> &qubits,
+             const std::vector<cudaq::kraus_channel> &krausChannels) {
+            cudaq::info("Freezing {} kraus channels for {} on qubits {}",
+                        krausChannels.size(), gateName, qubits);
+            return cudaq::get_superoperator(krausChannels, qubits.size());
+          });
+    CircuitSimulator::setExecutionContext(context);
+  }
+
+/// The one-qubit overrides
+#define CUSTATEVEC_DM_ONE_QUBIT_METHOD_OVERRIDE(NAME)                          \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const std::vector<std::size_t> &controls,                          \
+            const std::size_t qubitIdx) override {                             \
+    nvqir::NAME<double> gate;                                                  \
+    applyGate(gate.name(), {}, gate.getMatrix(), controls, {qubitIdx});        \
+  }
+
+  CUSTATEVEC_DM_ONE_QUBIT_METHOD_OVERRIDE(x)
+  CUSTATEVEC_DM_ONE_QUBIT_METHOD_OVERRIDE(y)
+  CUSTATEVEC_DM_ONE_QUBIT_METHOD_OVERRIDE(z)
+  CUSTATEVEC_DM_ONE_QUBIT_METHOD_OVERRIDE(h)
+  CUSTATEVEC_DM_ONE_QUBIT_METHOD_OVERRIDE(s)
+  CUSTATEVEC_DM_ONE_QUBIT_METHOD_OVERRIDE(t)
+  CUSTATEVEC_DM_ONE_QUBIT_METHOD_OVERRIDE(sdg)
+  CUSTATEVEC_DM_ONE_QUBIT_METHOD_OVERRIDE(tdg)
+
+/// The one-qubit parameterized overrides
+#define CUSTATEVEC_DM_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(NAME)                \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const double angle, const std::vector<std::size_t> &controls,      \
+            const std::size_t qubitIdx) override {                             \
+    nvqir::NAME<double> gate;                                                  \
+    applyGate(gate.name(), {angle}, gate.getMatrix(angle), controls,           \
+              {qubitIdx});                                                     \
+  }
+
+  CUSTATEVEC_DM_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rx)
+  CUSTATEVEC_DM_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(ry)
+  CUSTATEVEC_DM_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rz)
+  CUSTATEVEC_DM_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(r1)
+
+#undef CUSTATEVEC_DM_ONE_QUBIT_METHOD_OVERRIDE
+#undef CUSTATEVEC_DM_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE
+
+  using CircuitSimulator::u1;
+  void u1(const double angle, const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    r1(angle, controls, qubitIdx);
+  }
+
+  using CircuitSimulator::u2;
+  void u2(const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    applyGate("u2", {phi, lambda}, nvqir::u2<double>::getMatrix(phi, lambda),
+              controls, {qubitIdx});
+  }
+
+  using CircuitSimulator::u3;
+  void u3(const double theta, const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    applyGate("u3", {theta, phi, lambda},
+              nvqir::u3<double>::getMatrix(theta, phi, lambda), controls,
+              {qubitIdx});
+  }
+
+  using CircuitSimulator::swap;
+  void swap(const std::vector<std::size_t> &ctrlBits, const std::size_t srcIdx,
+            const std::size_t tgtIdx) override {
+    const DataVector matrix{1., 0., 0., 0., 0., 0., 1., 0.,
+                            0., 1., 0., 0., 0., 0., 0., 1.};
+    applyGate("swap", {}, matrix, ctrlBits, {srcIdx, tgtIdx});
+  }
+
+  /// @brief Measure the qubit: draw the outcome from the diagonal, then
+  /// project rho onto it and renormalize.
+  bool measureQubit(const std::size_t qubitIdx) override {
+    synchronizeState();
+    const auto probabilities = getMarginalProbabilities({qubitIdx});
+    const bool result = drawOutcome(
+        probabilities,
+        std::uniform_real_distribution<double>(0.0, 1.0)(randomEngine));
+    // The index of the 4x4 matrix is ket + 2 bra, keep |m><m| only.
+    DataVector projector(16, 0.0);
+    projector[result ? 15 : 0] = 1.0 / probabilities[result];
+    applyStateMatrix(projector, {},
+                     {2 * static_cast<int>(qubitIdx),
+                      2 * static_cast<int>(qubitIdx) + 1});
+    cudaq::info("Measured qubit {} -> {}", qubitIdx, result);
+    return result;
+  }
+
+  /// @brief Reset the qubit without measuring it: the |1><1| block moves to
+  /// |0><0| and the coherences of the qubit vanish.
+  void resetQubit(const std::size_t qubitIdx) override {
+    synchronizeState();
+    DataVector reset(16, 0.0);
+    reset[0] = 1.0;
+    reset[3] = 1.0;
+    applyStateMatrix(reset, {},
+                     {2 * static_cast<int>(qubitIdx),
+                      2 * static_cast<int>(qubitIdx) + 1});
+  }
+
+  /// @brief Sample the measured qubits from the marginal probabilities of
+  /// the diagonal.
+  cudaq::ExecutionResult sample(const std::vector<std::size_t> &measuredBits,
+                                const int shots) override {
+    synchronizeState();
+    const auto probabilities = getMarginalProbabilities(measuredBits);
+    if (shots < 1) {
+      double expectationValue = 0.0;
+      for (std::size_t i = 0; i < probabilities.size(); i++)
+        expectationValue +=
+            (std::bitset<64>(i).count() % 2 ? -1.0 : 1.0) * probabilities[i];
+      cudaq::info("Computed expectation value = {}", expectationValue);
+      return cudaq::ExecutionResult{expectationValue};
+    }
+
+    std::discrete_distribution<std::uint64_t> distribution(
+        probabilities.begin(), probabilities.end());
+    std::map<std::uint64_t, std::size_t> counts;
+    for (int shot = 0; shot < shots; shot++)
+      counts[distribution(randomEngine)]++;
+    cudaq::ExecutionResult result;
+    double expectationValue = 0.0;
+    for (auto [outcome, count] : counts) {
+      result.appendResult(&outcome, measuredBits.size(), count);
+      expectationValue +=
+          (std::bitset<64>(outcome).count() % 2 ? -1.0 : 1.0) * count;
+    }
+    result.expectationValue = expectationValue / shots;
+    return result;
+  }
+
+  /// @brief Compute Tr(rho H) term by term without changing the state.
+  cudaq::ExecutionResult observe(const cudaq::spin_op &H) override {
+    synchronizeState();
+    const auto nSpinQubits = H.n_qubits();
+    if (nSpinQubits > nQubitsAllocated)
+      throw std::runtime_error("Cannot observe a spin_op on " +
+                               std::to_string(nSpinQubits) + " qubits with " +
+                               std::to_string(nQubitsAllocated) +
+                               " qubits allocated.");
+    const auto bsf = H.get_bsf();
+    double expectation = 0.0;
+    for (std::size_t t = 0; t < H.n_terms(); t++) {
+      std::uint64_t xMask = 0, zMask = 0;
+      std::size_t nY = 0;
+      for (std::size_t q = 0; q < nSpinQubits; q++) {
+        const bool x = bsf[t][q], z = bsf[t][q + nSpinQubits];
+        xMask |= std::uint64_t(x) << q;
+        zMask |= std::uint64_t(z) << q;
+        nY += x && z;
+      }
+      const double coefficient = H.get_term_coefficient(t).real();
+      expectation += xMask || zMask
+                         ? coefficient * pauliTrace(xMask, zMask, nY)
+                         : coefficient;
+    }
+    cudaq::info("Computed expectation value = {}", expectation);
+    return cudaq::ExecutionResult{expectation};
+  }
+
+  /// @brief Return the row major density matrix, rho(i, j) with qubit q the
+  /// bit q of i and j as in the state vector of the custatevec backend.
+  cudaq::State getStateData() override {
+    synchronizeState();
+    const std::size_t dim = 1ULL << nStateQubits;
+    void *matrix;
+    HANDLE_CUDA_ERROR(cudaMallocAsync(
+        &matrix, dim * dim * sizeof(cuDoubleComplex), stream));
+    constexpr int32_t threads_per_block = 256;
+    const int64_t n_blocks =
+        (dim * dim + threads_per_block - 1) / threads_per_block;
+    unvectorizeDensityMatrix<<<n_blocks, threads_per_block, 0, stream>>>(
+        static_cast<const cuDoubleComplex *>(deviceState),
+        static_cast<cuDoubleComplex *>(matrix), dim);
+    HANDLE_CUDA_ERROR(cudaGetLastError());
+    std::vector<std::complex<double>> data(dim * dim);
+    HANDLE_CUDA_ERROR(cudaMemcpyAsync(data.data(), matrix,
+                                      dim * dim * sizeof(cuDoubleComplex),
+                                      cudaMemcpyDeviceToHost, stream));
+    HANDLE_CUDA_ERROR(cudaFreeAsync(matrix, stream));
+    HANDLE_CUDA_ERROR(cudaStreamSynchronize(stream));
+    return cudaq::State{{dim, dim}, std::move(data)};
+  }
+
+  std::string name() const override { return "custatevec-dm"; }
+  NVQIR_SIMULATOR_CLONE_IMPL(CuStateVecDMCircuitSimulator)
+};
+} // namespace
+
+/// Register this Simulator with NVQIR.
+NVQIR_REGISTER_SIMULATOR(CuStateVecDMCircuitSimulator, custatevec_dm)
+#undef __NVQIR_CUSTATEVEC_TOGGLE_CREATE
@@ -0,0 +1,828 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#define __NVQIR_CUSTATEVEC_TOGGLE_CREATE
+#include "CuStateVecCircuitSimulator.cu"
+
+namespace {
+
+/// @brief The CuStateVecMultiGPUSimulator shards a single state vector over
+/// all the GPUs of a node. With 2^g devices the top g qubit positions of the
+/// state are global, device `d` holds the sub state vector whose global
+/// position bits equal `d`. Gates on local positions are applied by
+/// cuStateVec on every device independently. A gate on a global qubit first
+/// swaps that qubit with the top local position, exchanging half of the sub
+/// state vector with the partner device over NVLink (cudaMemcpyPeer), and a
+/// qubit to position map keeps track of the permuted index bits.
+class CuStateVecMultiGPUSimulator : public nvqir::CircuitSimulator {
+protected:
+  using DataType = std::complex<double>;
+  using DataVector = std::vector<DataType>;
+
+  static constexpr cudaDataType_t cuStateVecCudaDataType = CUDA_C_64F;
+  static constexpr custatevecComputeType_t cuStateVecComputeType =
+      CUSTATEVEC_COMPUTE_64F;
+
+  /// @brief The state owned by one GPU.
+  struct Device {
+    int id = 0;
+    custatevecHandle_t handle;
+    cudaStream_t stream;
+    /// @brief The sub state vector, 2^nLocal amplitudes.
+    void *subStateVector = nullptr;
+    /// @brief Staging buffer for the peer exchanges.
+    void *exchangeBuffer = nullptr;
+    void *extraWorkspace = nullptr;
+    std::size_t extraWorkspaceSizeInBytes = 0;
+  };
+
+  /// @brief The devices the state is sharded over, a power of two.
+  std::vector<Device> devices;
+
+  /// @brief log2 of the number of devices.
+  std::size_t nGlobalBits = 0;
+
+  /// @brief The physical index bit of each qubit id.
+  std::vector<std::size_t> positionOf;
+
+  /// @brief The number of qubits in the physical state. This can be larger
+  /// than nQubitsAllocated, since deallocated qubits are reset but not
+  /// removed.
+  std::size_t nPhysical = 0;
+
+  /// @brief The number of index bits of each sub state vector.
+  std::size_t nLocal = 0;
+
+  /// @brief Whether the state is sharded, otherwise it lives on the first
+  /// device only.
+  bool distributed = false;
+
+  /// @brief States are only sharded once every device holds at least
+  /// 2^minLocalQubits amplitudes, smaller ones stay on a single GPU.
+  std::size_t minLocalQubits = 26;
+
+  /// @brief The number of amplitudes moved in one peer copy.
+  static constexpr std::size_t maxExchangeLength = 1ULL << 24;
+
+  /// @brief Find the visible GPUs and enable peer access between them.
+  void initializeDevices() {
+    int count = 0;
+    HANDLE_CUDA_ERROR(cudaGetDeviceCount(&count));
+    int nDevices = 1;
+    while (nDevices * 2 <= count)
+      nDevices *= 2;
+    for (nGlobalBits = 0; (1 << nGlobalBits) < nDevices; nGlobalBits++)
+      ;
+
+    if (auto *minLocal = std::getenv("CUDAQ_MGPU_MIN_LOCAL_QUBITS"))
+      minLocalQubits = std::strtoul(minLocal, nullptr, 10);
+    // Every gate, fused ones included, needs a spare local position to swap
+    // its global targets into.
+    minLocalQubits = std::max({minLocalQubits, std::size_t{3},
+                               maxFusedQubits + 1});
+
+    devices.resize(nDevices);
+    for (int d = 0; d < nDevices; d++) {
+      devices[d].id = d;
+      HANDLE_CUDA_ERROR(cudaSetDevice(d));
+      HANDLE_ERROR(custatevecCreate(&devices[d].handle));
+      HANDLE_CUDA_ERROR(cudaStreamCreate(&devices[d].stream));
+      for (int peer = 0; peer < nDevices; peer++) {
+        int canAccess = 0;
+        if (peer != d)
+          HANDLE_CUDA_ERROR(cudaDeviceCanAccessPeer(&canAccess, d, peer));
+        if (canAccess) {
+          HANDLE_CUDA_ERROR(cudaDeviceEnablePeerAccess(peer, 0));
+        } else if (peer != d) {
+          cudaq::info("GPU {} has no peer access to GPU {}, exchanges will "
+                      "be staged through the host.",
+                      d, peer);
+        }
+      }
+    }
+    HANDLE_CUDA_ERROR(cudaSetDevice(0));
+    cudaq::info("Multi-GPU state vector simulator on {} of {} GPUs.", nDevices,
+                count);
+  }
+
+  /// @brief The devices currently holding part of the state.
+  std::size_t numActiveDevices() const {
+    return distributed ? devices.size() : 1;
+  }
+
+  /// @brief Invoke `deviceFn(device)` on each active device, with that
+  /// device made current.
+  template <typename DeviceFnT>
+  void forEachDevice(DeviceFnT &&deviceFn) {
+    for (std::size_t d = 0; d < numActiveDevices(); d++) {
+      HANDLE_CUDA_ERROR(cudaSetDevice(devices[d].id));
+      deviceFn(devices[d]);
+    }
+    HANDLE_CUDA_ERROR(cudaSetDevice(devices[0].id));
+  }
+
+  void synchronizeDevices() {
+    forEachDevice([](Device &device) {
+      HANDLE_CUDA_ERROR(cudaDeviceSynchronize());
+    });
+  }
+
+  bool isGlobal(const std::size_t position) const {
+    return position >= nLocal;
+  }
+
+  /// @brief Return the device's value of the global position bit.
+  bool deviceBit(const Device &device, const std::size_t position) const {
+    return (device.id >> (position - nLocal)) & 1;
+  }
+
+  /// @brief Return a device workspace of at least the given size.
+  void *workspace(Device &device, const std::size_t sizeInBytes) {
+    if (sizeInBytes > device.extraWorkspaceSizeInBytes) {
+      if (device.extraWorkspace)
+        HANDLE_CUDA_ERROR(cudaFree(device.extraWorkspace));
+      HANDLE_CUDA_ERROR(cudaMalloc(&device.extraWorkspace, sizeInBytes));
+      device.extraWorkspaceSizeInBytes = sizeInBytes;
+    }
+    return device.extraWorkspace;
+  }
+
+  /// @brief Swap two local index bits on every device.
+  void swapLocalPositions(const std::size_t a, const std::size_t b) {
+    const int2 bitSwaps[] = {{(int)a, (int)b}};
+    forEachDevice([&](Device &device) {
+      HANDLE_ERROR(custatevecSwapIndexBits(
+          device.handle, device.subStateVector, cuStateVecCudaDataType, nLocal,
+          bitSwaps, 1, nullptr, nullptr, 0));
+    });
+    for (auto &p : positionOf)
+      if (p == a)
+        p = b;
+      else if (p == b)
+        p = a;
+  }
+
+  /// @brief Swap the top local index bit with the global one. Devices with
+  /// the global bit clear send their upper half to the partner device and
+  /// receive its lower half in return.
+  void swapWithGlobal(const std::size_t globalPosition) {
+    const std::size_t bit = globalPosition - nLocal;
+    const std::size_t half = 1ULL << (nLocal - 1);
+    const std::size_t chunk = std::min(half, maxExchangeLength);
+    synchronizeDevices();
+    for (std::size_t d = 0; d < devices.size(); d++) {
+      if (d & (1ULL << bit))
+        continue;
+      auto &lower = devices[d];
+      auto &upper = devices[d | (1ULL << bit)];
+      auto *lowerData =
+          reinterpret_cast<cuDoubleComplex *>(lower.subStateVector);
+      auto *upperData =
+          reinterpret_cast<cuDoubleComplex *>(upper.subStateVector);
+      HANDLE_CUDA_ERROR(cudaSetDevice(upper.id));
+      for (std::size_t start = 0; start < half; start += chunk) {
+        const std::size_t bytes = chunk * sizeof(cuDoubleComplex);
+        HANDLE_CUDA_ERROR(cudaMemcpyPeerAsync(
+            upper.exchangeBuffer, upper.id, lowerData + half + start, lower.id,
+            bytes, upper.stream));
+        HANDLE_CUDA_ERROR(cudaMemcpyPeerAsync(lowerData + half + start,
+                                              lower.id, upperData + start,
+                                              upper.id, bytes, upper.stream));
+        HANDLE_CUDA_ERROR(cudaMemcpyAsync(upperData + start,
+                                          upper.exchangeBuffer, bytes,
+                                          cudaMemcpyDeviceToDevice,
+                                          upper.stream));
+      }
+    }
+    for (auto &device : devices) {
+      HANDLE_CUDA_ERROR(cudaSetDevice(device.id));
+      HANDLE_CUDA_ERROR(cudaStreamSynchronize(device.stream));
+    }
+    HANDLE_CUDA_ERROR(cudaSetDevice(devices[0].id));
+
+    for (auto &p : positionOf)
+      if (p == nLocal - 1)
+        p = globalPosition;
+      else if (p == globalPosition)
+        p = nLocal - 1;
+  }
+
+  /// @brief Move all target qubits to local positions. A global target is
+  /// swapped with the highest local position that holds no target, and
+  /// preferably no control either.
+  void localizeTargets(const std::vector<std::size_t> &controls,
+                       const std::vector<std::size_t> &targets) {
+    for (auto t : targets) {
+      if (!isGlobal(positionOf[t]))
+        continue;
+      std::size_t targetMask = 0, controlMask = 0;
+      for (auto q : targets)
+        if (!isGlobal(positionOf[q]))
+          targetMask |= 1ULL << positionOf[q];
+      for (auto q : controls)
+        if (!isGlobal(positionOf[q]))
+          controlMask |= 1ULL << positionOf[q];
+
+      std::size_t position = nLocal;
+      for (std::size_t p = nLocal; p-- > 0;) {
+        const std::size_t mask = 1ULL << p;
+        if (targetMask & mask)
+          continue;
+        if (!(controlMask & mask)) {
+          position = p;
+          break;
+        }
+        if (position == nLocal)
+          position = p;
+      }
+      if (position == nLocal)
+        throw std::runtime_error(
+            "[custatevec-mgpu] Too many gate targets for the local qubits.");
+
+      cudaq::info("Swapping global qubit {} into local position {}.", t,
+                  position);
+      if (position != nLocal - 1)
+        swapLocalPositions(position, nLocal - 1);
+      swapWithGlobal(positionOf[t]);
+    }
+  }
+
+  /// @brief Apply the matrix on every device whose global position bits
+  /// satisfy the global controls. `MatrixT` is a contiguous container of
+  /// DataType.
+  template <typename MatrixT>
+  void applyGateMatrix(const MatrixT &matrix,
+                       const std::vector<std::size_t> &controls,
+                       const std::vector<std::size_t> &targets) {
+    if (distributed)
+      localizeTargets(controls, targets);
+
+    std::vector<int> targets32, controls32;
+    std::vector<std::size_t> globalControls;
+    for (auto t : targets)
+      targets32.push_back(positionOf[t]);
+    for (auto c : controls)
+      if (isGlobal(positionOf[c]))
+        globalControls.push_back(positionOf[c]);
+      else
+        controls32.push_back(positionOf[c]);
+
+    forEachDevice([&](Device &device) {
+      for (auto p : globalControls)
+        if (!deviceBit(device, p))
+          return;
+      std::size_t sizeInBytes = 0;
+      HANDLE_ERROR(custatevecApplyMatrixGetWorkspaceSize(
+          device.handle, cuStateVecCudaDataType, nLocal, matrix.data(),
+          cuStateVecCudaDataType, CUSTATEVEC_MATRIX_LAYOUT_ROW, 0,
+          targets32.size(), controls32.size(), cuStateVecComputeType,
+          &sizeInBytes));
+      HANDLE_ERROR(custatevecApplyMatrix(
+          device.handle, device.subStateVector, cuStateVecCudaDataType, nLocal,
+          matrix.data(), cuStateVecCudaDataType, CUSTATEVEC_MATRIX_LAYOUT_ROW,
+          0, targets32.data(), targets32.size(),
+          controls32.empty() ? nullptr : controls32.data(), nullptr,
+          controls32.size(), cuStateVecComputeType,
+          workspace(device, sizeInBytes), sizeInBytes));
+    });
+  }
+
+  /// @brief The matrix of the swap gate.
+  static constexpr std::array<DataType, 16> swapMatrix() {
+    return {DataType(1.0, 0.0), DataType(0.0, 0.0), DataType(0.0, 0.0),
+            DataType(0.0, 0.0), DataType(0.0, 0.0), DataType(0.0, 0.0),
+            DataType(1.0, 0.0), DataType(0.0, 0.0), DataType(0.0, 0.0),
+            DataType(1.0, 0.0), DataType(0.0, 0.0), DataType(0.0, 0.0),
+            DataType(0.0, 0.0), DataType(0.0, 0.0), DataType(0.0, 0.0),
+            DataType(1.0, 0.0)};
+  }
+
+  /// @brief Fuse the gate if gate fusion is enabled, otherwise apply it.
+  template <typename MatrixT>
+  void applyGate(const MatrixT &matrix,
+                 const std::vector<std::size_t> &controls,
+                 const std::vector<std::size_t> &targets) {
+    if (isGateFusionEnabled() &&
+        fuseGate(DataVector(matrix.begin(), matrix.end()), controls, targets))
+      return;
+    applyGateMatrix(matrix, controls, targets);
+  }
+
+  void applyDenseMatrix(const std::vector<std::complex<double>> &matrix,
+                        const std::vector<std::size_t> &targets) override {
+    applyGateMatrix(matrix, {}, targets);
+  }
+
+  template <typename GateT>
+  void oneQubitApply(const std::vector<std::size_t> &controls,
+                     const std::size_t qubitIdx) {
+    GateT gate;
+    CUDAQ_INFO(gateToString(gate.name(), controls, {}, {qubitIdx}));
+    if (skipPrefixGate(gate.name(), {}, controls, {qubitIdx}))
+      return;
+    applyGate(GateT::getMatrix(), controls, {qubitIdx});
+  }
+
+  template <typename RotationGateT>
+  void oneQubitOneParamApply(const double angle,
+                             const std::vector<std::size_t> &controls,
+                             const std::size_t qubitIdx) {
+    RotationGateT gate;
+    CUDAQ_INFO(gateToString(gate.name(), controls, {angle}, {qubitIdx}));
+    if (skipPrefixGate(gate.name(), {angle}, controls, {qubitIdx}))
+      return;
+    applyGate(gate.getMatrix(angle), controls, {qubitIdx});
+  }
+
+  /// @brief Replace the device's sub state vector with a zeroed one of
+  /// 2^nIndexBits amplitudes, and return the old one.
+  void *allocateSubStateVector(Device &device, const std::size_t nIndexBits) {
+    auto *old = device.subStateVector;
+    const std::size_t bytes = (1ULL << nIndexBits) * sizeof(cuDoubleComplex);
+    HANDLE_CUDA_ERROR(cudaMalloc(&device.subStateVector, bytes));
+    HANDLE_CUDA_ERROR(cudaMemset(device.subStateVector, 0, bytes));
+    return old;
+  }
+
+  /// @brief Grow the state to the allocated qubits. New qubits take the
+  /// local positions just above the existing ones, so every sub state vector
+  /// keeps its amplitudes at the start of the grown one. When the state
+  /// becomes large enough it is sharded, device `d` then takes the slice
+  /// starting at amplitude d * 2^nLocal.
+  void addQubitToState() override {
+    if (nQubitsAllocated <= nPhysical)
+      return;
+    if (devices.empty())
+      initializeDevices();
+
+    const std::size_t k = nQubitsAllocated - nPhysical;
+    const std::size_t newPhysical = nQubitsAllocated;
+    const bool newDistributed =
+        distributed ||
+        (devices.size() > 1 && newPhysical >= nGlobalBits + minLocalQubits);
+    const std::size_t newLocal =
+        newDistributed ? newPhysical - nGlobalBits : newPhysical;
+
+    if (nPhysical == 0) {
+      forEachDevice(
+          [&](Device &device) { allocateSubStateVector(device, newLocal); });
+      const cuDoubleComplex one = {1.0, 0.0};
+      HANDLE_CUDA_ERROR(cudaMemcpy(devices[0].subStateVector, &one,
+                                   sizeof(one), cudaMemcpyHostToDevice));
+      if (newDistributed)
+        for (std::size_t d = 1; d < devices.size(); d++) {
+          HANDLE_CUDA_ERROR(cudaSetDevice(devices[d].id));
+          allocateSubStateVector(devices[d], newLocal);
+        }
+    } else if (newDistributed && !distributed) {
+      // Shard the state held by the first device.
+      const std::size_t oldDimension = 1ULL << nPhysical;
+      auto *old = allocateSubStateVector(devices[0], newLocal);
+      for (std::size_t d = 0; d < devices.size(); d++) {
+        HANDLE_CUDA_ERROR(cudaSetDevice(devices[d].id));
+        if (d > 0)
+          allocateSubStateVector(devices[d], newLocal);
+        const std::size_t begin = d << newLocal;
+        if (begin >= oldDimension)
+          continue;
+        const std::size_t count =
+            std::min(oldDimension - begin, std::size_t{1} << newLocal);
+        HANDLE_CUDA_ERROR(cudaMemcpyPeer(
+            devices[d].subStateVector, devices[d].id,
+            reinterpret_cast<cuDoubleComplex *>(old) + begin, devices[0].id,
+            count * sizeof(cuDoubleComplex)));
+      }
+      HANDLE_CUDA_ERROR(cudaSetDevice(devices[0].id));
+      HANDLE_CUDA_ERROR(cudaFree(old));
+      cudaq::info("Sharding the {} qubit state over {} GPUs.", newPhysical,
+                  devices.size());
+    } else {
+      forEachDevice([&](Device &device) {
+        auto *old = allocateSubStateVector(device, newLocal);
+        HANDLE_CUDA_ERROR(cudaMemcpy(device.subStateVector, old,
+                                     (1ULL << nLocal) * sizeof(cuDoubleComplex),
+                                     cudaMemcpyDeviceToDevice));
+        HANDLE_CUDA_ERROR(cudaFree(old));
+      });
+    }
+
+    // The exchange buffers hold one chunk of half a sub state vector.
+    if (newDistributed)
+      for (auto &device : devices) {
+        HANDLE_CUDA_ERROR(cudaSetDevice(device.id));
+        if (device.exchangeBuffer)
+          HANDLE_CUDA_ERROR(cudaFree(device.exchangeBuffer));
+        HANDLE_CUDA_ERROR(cudaMalloc(
+            &device.exchangeBuffer,
+            std::min(std::size_t{1} << (newLocal - 1), maxExchangeLength) *
+                sizeof(cuDoubleComplex)));
+      }
+    HANDLE_CUDA_ERROR(cudaSetDevice(devices[0].id));
+
+    for (auto &p : positionOf)
+      if (p >= nLocal)
+        p += k;
+    for (std::size_t q = 0; q < k; q++)
+      positionOf.push_back(nLocal + q);
+    nPhysical = newPhysical;
+    nLocal = newLocal;
+    distributed = newDistributed;
+  }
+
+  void resetQubitStateImpl() override {
+    for (auto &device : devices) {
+      HANDLE_CUDA_ERROR(cudaSetDevice(device.id));
+      if (device.subStateVector)
+        HANDLE_CUDA_ERROR(cudaFree(device.subStateVector));
+      if (device.exchangeBuffer)
+        HANDLE_CUDA_ERROR(cudaFree(device.exchangeBuffer));
+      device.subStateVector = nullptr;
+      device.exchangeBuffer = nullptr;
+    }
+    if (!devices.empty())
+      HANDLE_CUDA_ERROR(cudaSetDevice(devices[0].id));
+    positionOf.clear();
+    nPhysical = 0;
+    nLocal = 0;
+    distributed = false;
+  }
+
+  /// @brief Return the squared norm of the device's sub state vector.
+  double squaredNorm(Device &device) {
+    double norm = 0.0;
+    HANDLE_ERROR(custatevecAbs2SumArray(
+        device.handle, device.subStateVector, cuStateVecCudaDataType, nLocal,
+        &norm, nullptr, 0, nullptr, nullptr, 0));
+    return norm;
+  }
+
+  /// @brief Return the probability of measuring the qubit in the |1> state.
+  double probabilityOfOne(const std::size_t qubitIdx) {
+    const auto position = positionOf[qubitIdx];
+    const int basisBits[] = {(int)position};
+    double prob = 0.0;
+    forEachDevice([&](Device &device) {
+      if (isGlobal(position)) {
+        if (deviceBit(device, position))
+          prob += squaredNorm(device);
+        return;
+      }
+      double abs2sum0, abs2sum1;
+      HANDLE_ERROR(custatevecAbs2SumOnZBasis(
+          device.handle, device.subStateVector, cuStateVecCudaDataType, nLocal,
+          &abs2sum0, &abs2sum1, basisBits, 1));
+      prob += abs2sum1;
+    });
+    return prob;
+  }
+
+  /// @brief Project the qubit onto the given result and renormalize.
+  void collapse(const std::size_t qubitIdx, const bool result,
+                const double probability) {
+    const auto position = positionOf[qubitIdx];
+    const int basisBits[] = {(int)position};
+    const double scale = 1.0 / std::sqrt(probability);
+    const nvqir::GateMatrix<double> scaleMatrix{scale, 0.0, 0.0, scale};
+    const int scaleTarget[] = {0};
+    forEachDevice([&](Device &device) {
+      if (!isGlobal(position)) {
+        HANDLE_ERROR(custatevecCollapseOnZBasis(
+            device.handle, device.subStateVector, cuStateVecCudaDataType,
+            nLocal, result, basisBits, 1, probability));
+        return;
+      }
+      if (deviceBit(device, position) != result) {
+        HANDLE_CUDA_ERROR(cudaMemset(device.subStateVector, 0,
+                                     (1ULL << nLocal) *
+                                         sizeof(cuDoubleComplex)));
+        return;
+      }
+      std::size_t sizeInBytes = 0;
+      HANDLE_ERROR(custatevecApplyMatrixGetWorkspaceSize(
+          device.handle, cuStateVecCudaDataType, nLocal, scaleMatrix.data(),
+          cuStateVecCudaDataType, CUSTATEVEC_MATRIX_LAYOUT_ROW, 0, 1, 0,
+          cuStateVecComputeType, &sizeInBytes));
+      HANDLE_ERROR(custatevecApplyMatrix(
+          device.handle, device.subStateVector, cuStateVecCudaDataType, nLocal,
+          scaleMatrix.data(), cuStateVecCudaDataType,
+          CUSTATEVEC_MATRIX_LAYOUT_ROW, 0, scaleTarget, 1, nullptr, nullptr, 0,
+          cuStateVecComputeType, workspace(device, sizeInBytes), sizeInBytes));
+    });
+  }
+
+  bool measureQubit(const std::size_t qubitIdx) override {
+    synchronizeState();
+    const double probOne = probabilityOfOne(qubitIdx);
+    const bool result = randomValues(1, 1.0)[0] < probOne;
+    collapse(qubitIdx, result, result ? probOne : 1.0 - probOne);
+    cudaq::info("Measured qubit {} -> {}", qubitIdx, result);
+    return result;
+  }
+
+  /// @brief Compute <Z...Z> over the given qubits, the global qubits
+  /// contribute the sign of their device.
+  double calculateExpectationValue(const std::vector<std::size_t> &qubits) {
+    std::vector<int> localBits;
+    std::vector<std::size_t> globalPositions;
+    for (auto q : qubits)
+      if (isGlobal(positionOf[q]))
+        globalPositions.push_back(positionOf[q]);
+      else
+        localBits.push_back(positionOf[q]);
+    std::vector<custatevecPauli_t> zPauli(localBits.size(),
+                                          CUSTATEVEC_PAULI_Z);
+
+    double result = 0.0;
+    forEachDevice([&](Device &device) {
+      double value = 0.0;
+      if (localBits.empty()) {
+        value = squaredNorm(device);
+      } else {
+        const uint32_t nBasisBitsArray[] = {(uint32_t)localBits.size()};
+        const int *basisBitsArray[] = {localBits.data()};
+        const custatevecPauli_t *pauliArray[] = {zPauli.data()};
+        HANDLE_ERROR(custatevecComputeExpectationsOnPauliBasis(
+            device.handle, device.subStateVector, cuStateVecCudaDataType,
+            nLocal, &value, pauliArray, 1, basisBitsArray, nBasisBitsArray));
+      }
+      bool odd = false;
+      for (auto p : globalPositions)
+        odd ^= deviceBit(device, p);
+      result += odd ? -value : value;
+    });
+    return result;
+  }
+
+  /// @brief The free memory of all devices the state is sharded over.
+  std::size_t getFreeMemory() override {
+    if (devices.empty())
+      initializeDevices();
+    std::size_t total = 0;
+    for (auto &device : devices) {
+      std::size_t freeBytes, totalBytes;
+      HANDLE_CUDA_ERROR(cudaSetDevice(device.id));
+      HANDLE_CUDA_ERROR(cudaMemGetInfo(&freeBytes, &totalBytes));
+      total += freeBytes;
+    }
+    HANDLE_CUDA_ERROR(cudaSetDevice(devices[0].id));
+    return total;
+  }
+
+public:
+  CuStateVecMultiGPUSimulator() {
+    enableGateFusion();
+    cudaFree(0);
+  }
+
+  virtual ~CuStateVecMultiGPUSimulator() {
+    for (auto &device : devices) {
+      cudaSetDevice(device.id);
+      if (device.subStateVector)
+        cudaFree(device.subStateVector);
+      if (device.exchangeBuffer)
+        cudaFree(device.exchangeBuffer);
+      if (device.extraWorkspace)
+        cudaFree(device.extraWorkspace);
+      cudaStreamDestroy(device.stream);
+      custatevecDestroy(device.handle);
+    }
+  }
+
+  /// @brief Every instance shards its state over all the GPUs.
+  bool canRunConcurrently() override { return false; }
+
+  /// @brief Allocate all the qubits at once, so the state is grown and
+  /// sharded a single time.
+  std::vector<std::size_t> allocateQubits(const std::size_t count) override {
+    std::vector<std::size_t> qubits;
+    for (std::size_t i = 0; i < count; i++)
+      qubits.emplace_back(tracker.getNextIndex());
+    cudaq::info("Allocating {} new qubits (nQ={}, dim={})", count,
+                nQubitsAllocated, stateDimension);
+    nQubitsAllocated += count;
+    stateDimension = calculateStateDim(nQubitsAllocated);
+    addQubitToState();
+    return qubits;
+  }
+
+/// The one-qubit overrides
+#define MGPU_ONE_QUBIT_METHOD_OVERRIDE(NAME)                                   \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const std::vector<std::size_t> &controls,                          \
+            const std::size_t qubitIdx) override {                             \
+    oneQubitApply<nvqir::NAME<double>>(controls, qubitIdx);                    \
+  }
+
+  MGPU_ONE_QUBIT_METHOD_OVERRIDE(x)
+  MGPU_ONE_QUBIT_METHOD_OVERRIDE(y)
+  MGPU_ONE_QUBIT_METHOD_OVERRIDE(z)
+  MGPU_ONE_QUBIT_METHOD_OVERRIDE(h)
+  MGPU_ONE_QUBIT_METHOD_OVERRIDE(s)
+  MGPU_ONE_QUBIT_METHOD_OVERRIDE(t)
+  MGPU_ONE_QUBIT_METHOD_OVERRIDE(sdg)
+  MGPU_ONE_QUBIT_METHOD_OVERRIDE(tdg)
+
+/// The one-qubit parameterized overrides
+#define MGPU_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(NAME)                         \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const double angle, const std::vector<std::size_t> &controls,      \
+            const std::size_t qubitIdx) override {                             \
+    oneQubitOneParamApply<nvqir::NAME<double>>(angle, controls, qubitIdx);     \
+  }
+
+  MGPU_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rx)
+  MGPU_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(ry)
+  MGPU_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rz)
+  MGPU_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(r1)
+  MGPU_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(u1)
+
+#undef MGPU_ONE_QUBIT_METHOD_OVERRIDE
+#undef MGPU_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE
+
+  using CircuitSimulator::u2;
+  void u2(const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u2", controls, {phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u2", {phi, lambda}, controls, {qubitIdx}))
+      return;
+    applyGate(nvqir::u2<double>::getMatrix(phi, lambda), controls, {qubitIdx});
+  }
+
+  using CircuitSimulator::u3;
+  void u3(const double theta, const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u3", controls, {theta, phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u3", {theta, phi, lambda}, controls, {qubitIdx}))
+      return;
+    applyGate(nvqir::u3<double>::getMatrix(theta, phi, lambda), controls,
+              {qubitIdx});
+  }
+
+  bool canPermuteQubits() override { return true; }
+
+  /// @brief A qubit permutation only relabels the qubit positions.
+  void applyQubitPermutation(
+      const std::vector<std::size_t> &qubits,
+      const std::vector<std::size_t> &permutation) override {
+    std::vector<std::size_t> positions;
+    for (auto q : qubits)
+      positions.push_back(positionOf[q]);
+    for (std::size_t i = 0; i < qubits.size(); i++)
+      positionOf[qubits[permutation[i]]] = positions[i];
+  }
+
+  /// @brief An uncontrolled swap only relabels the index bits of the two
+  /// qubits.
+  using CircuitSimulator::swap;
+  void swap(const std::vector<std::size_t> &ctrlBits, const std::size_t srcIdx,
+            const std::size_t tgtIdx) override {
+    CUDAQ_INFO(gateToString("swap", ctrlBits, {}, {srcIdx, tgtIdx}));
+    if (skipPrefixGate("swap", {}, ctrlBits, {srcIdx, tgtIdx}))
+      return;
+    if (ctrlBits.empty()) {
+      flushFusedGate();
+      std::swap(positionOf[srcIdx], positionOf[tgtIdx]);
+      return;
+    }
+    applyGate(swapMatrix(), ctrlBits, {srcIdx, tgtIdx});
+  }
+
+  void resetQubit(const std::size_t qubitIdx) override {
+    if (measureQubit(qubitIdx))
+      applyGateMatrix(nvqir::x<double>::getMatrix(), {}, {qubitIdx});
+  }
+
+  /// @brief Sample the state on the given qubits. The sorted random numbers
+  /// are split by the cumulative norm of the sub state vectors, and each
+  /// device samples its share of the shots over the local measured bits.
+  cudaq::ExecutionResult sample(const std::vector<std::size_t> &measuredBits,
+                                const int shots) override {
+    synchronizeState();
+    double expectationValue = calculateExpectationValue(measuredBits);
+    if (shots < 1) {
+      cudaq::info("Computed expectation value = {}", expectationValue);
+      return cudaq::ExecutionResult{{}, expectationValue};
+    }
+
+    std::vector<double> norms, offsets;
+    double totalNorm = 0.0;
+    forEachDevice([&](Device &device) {
+      norms.push_back(squaredNorm(device));
+      offsets.push_back(totalNorm);
+      totalNorm += norms.back();
+    });
+    auto randoms = randomValues(shots, totalNorm);
+
+    // The local measured bits are sampled by cuStateVec, the global ones are
+    // fixed by the device.
+    std::vector<int> localBits;
+    std::vector<std::size_t> localSlots;
+    for (std::size_t j = 0; j < measuredBits.size(); j++)
+      if (!isGlobal(positionOf[measuredBits[j]])) {
+        localBits.push_back(positionOf[measuredBits[j]]);
+        localSlots.push_back(j);
+      }
+
+    cudaq::ExecutionResult counts;
+    std::size_t next = 0;
+    forEachDevice([&](Device &device) {
+      const std::size_t d = device.id;
+      if (norms[d] == 0.0)
+        return;
+      // A random number belongs to the last device with non-zero norm whose
+      // slice starts at or below it.
+      std::size_t nextOwner = d + 1;
+      while (nextOwner < norms.size() && norms[nextOwner] == 0.0)
+        nextOwner++;
+      std::size_t end = next;
+      while (end < randoms.size() &&
+             (nextOwner == norms.size() || randoms[end] < offsets[nextOwner]))
+        end++;
+      const std::size_t nShots = end - next;
+      if (nShots == 0)
+        return;
+
+      std::string bitstring(measuredBits.size(), '0');
+      for (std::size_t j = 0; j < measuredBits.size(); j++)
+        if (isGlobal(positionOf[measuredBits[j]]) &&
+            deviceBit(device, positionOf[measuredBits[j]]))
+          bitstring[j] = '1';
+      if (localBits.empty()) {
+        counts.appendResult(bitstring, nShots);
+        next = end;
+        return;
+      }
+
+      std::vector<double> localRandoms(nShots);
+      for (std::size_t i = 0; i < nShots; i++)
+        localRandoms[i] =
+            std::clamp((randoms[next + i] - offsets[d]) / norms[d], 0.0,
+                       std::nextafter(1.0, 0.0));
+      custatevecSamplerDescriptor_t sampler;
+      std::size_t sizeInBytes = 0;
+      HANDLE_ERROR(custatevecSamplerCreate(
+          device.handle, device.subStateVector, cuStateVecCudaDataType, nLocal,
+          &sampler, nShots, &sizeInBytes));
+      HANDLE_ERROR(custatevecSamplerPreprocess(
+          device.handle, sampler, workspace(device, sizeInBytes), sizeInBytes));
+      std::vector<custatevecIndex_t> bitstrings(nShots);
+      HANDLE_ERROR(custatevecSamplerSample(
+          device.handle, sampler, bitstrings.data(), localBits.data(),
+          localBits.size(), localRandoms.data(), nShots,
+          CUSTATEVEC_SAMPLER_OUTPUT_ASCENDING_ORDER));
+      HANDLE_ERROR(custatevecSamplerDestroy(sampler));
+
+      for (auto sampled : bitstrings) {
+        for (std::size_t j = 0; j < localSlots.size(); j++)
+          bitstring[localSlots[j]] = (sampled >> j) & 1ULL ? '1' : '0';
+        counts.appendResult(bitstring, 1);
+      }
+      next = end;
+    });
+
+    counts.expectationValue = expectationValue;
+    return counts;
+  }
+
+  /// @brief Copy the sub state vectors to the host, with qubit `q` as bit
+  /// `q` of the index.
+  cudaq::State getStateData() override {
+    synchronizeState();
+    if (nPhysical == 0)
+      return {};
+    const std::size_t localDimension = 1ULL << nLocal;
+    std::vector<std::complex<double>> physical(localDimension *
+                                               numActiveDevices());
+    forEachDevice([&](Device &device) {
+      HANDLE_CUDA_ERROR(cudaMemcpy(physical.data() + device.id * localDimension,
+                                   device.subStateVector,
+                                   localDimension * sizeof(cuDoubleComplex),
+                                   cudaMemcpyDeviceToHost));
+    });
+
+    std::vector<std::complex<double>> data(stateDimension);
+    for (std::size_t i = 0; i < stateDimension; i++) {
+      std::size_t index = 0;
+      for (std::size_t q = 0; q < nQubitsAllocated; q++)
+        index |= ((i >> q) & 1ULL) << positionOf[q];
+      data[i] = physical[index];
+    }
+    return cudaq::State{{stateDimension}, std::move(data)};
+  }
+
+  std::string name() const override { return "custatevec-mgpu"; }
+  NVQIR_SIMULATOR_CLONE_IMPL(CuStateVecMultiGPUSimulator)
+};
+} // namespace
+
+/// Register this Simulator with NVQIR.
+NVQIR_REGISTER_SIMULATOR(CuStateVecMultiGPUSimulator, custatevec_mgpu)
+
+#undef __NVQIR_CUSTATEVEC_TOGGLE_CREATE
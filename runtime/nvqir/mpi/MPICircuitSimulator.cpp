@@ -0,0 +1,740 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CircuitSimulator.h"
+#include "Gates.h"
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <mpi.h>
+#include <random>
+#include <unordered_map>
+
+#define HANDLE_MPI_ERROR(x)                                                    \
+  {                                                                            \
+    const auto err = x;                                                        \
+    if (err != MPI_SUCCESS) {                                                  \
+      throw std::runtime_error(fmt::format("[mpi] error {} in {} (line {})",   \
+                                           err, __FUNCTION__, __LINE__));      \
+    }                                                                          \
+  };
+
+namespace nvqir {
+namespace mpi {
+
+/// @brief Initialize MPI on first use and finalize it at exit, unless the
+/// application manages MPI itself.
+class Session {
+  bool ownsMPI = false;
+
+public:
+  Session() {
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (!initialized) {
+      HANDLE_MPI_ERROR(MPI_Init(nullptr, nullptr));
+      ownsMPI = true;
+    }
+  }
+  ~Session() {
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (ownsMPI && !finalized)
+      MPI_Finalize();
+  }
+  static Session &get() {
+    static Session session;
+    return session;
+  }
+};
+
+/// @brief Insert a zero bit into `k` at position `bit`.
+inline std::size_t insertZeroBit(const std::size_t k, const std::size_t bit) {
+  const std::size_t low = (1ULL << bit) - 1;
+  return ((k & ~low) << 1) | (k & low);
+}
+} // namespace mpi
+
+/// @brief The MPICircuitSimulator distributes a state vector over the ranks
+/// of MPI_COMM_WORLD. With 2^g ranks the top g qubit positions of the state
+/// are global, each rank stores the 2^(n-g) amplitudes whose global position
+/// bits equal its rank. Gates on local qubits need no communication. A gate
+/// targeting a global qubit first swaps it with a local position, exchanging
+/// half of the local slice with the partner rank, and the logical qubit to
+/// physical position map is updated so the qubit stays local afterwards.
+/// Small states are replicated on every rank, which then all perform the
+/// same work without communicating.
+class MPICircuitSimulator : public nvqir::CircuitSimulator {
+protected:
+  /// @brief The amplitudes held by this rank, physical position `p < nLocal`
+  /// is bit `p` of the local index.
+  std::vector<std::complex<double>> localState;
+
+  /// @brief Copy of the local amplitudes at the end of a cached conditional
+  /// prefix, along with the qubit positions at that point.
+  std::vector<std::complex<double>> snapshotState;
+  std::vector<std::size_t> snapshotPositions;
+
+  /// @brief The physical position of each qubit id in the state. This is
+  /// only a permutation, so qubit swaps never move amplitudes.
+  std::vector<std::size_t> positionOf;
+
+  /// @brief The number of qubits in the physical state. This can be larger
+  /// than nQubitsAllocated, since deallocated qubits are reset but not
+  /// removed.
+  std::size_t nPhysical = 0;
+
+  /// @brief The number of local positions, the rest are global.
+  std::size_t nLocal = 0;
+
+  /// @brief Whether the state is currently split across the ranks.
+  bool distributed = false;
+
+  int rank = 0;
+  int nRanks = 1;
+
+  /// @brief log2 of the number of ranks.
+  std::size_t nGlobalBits = 0;
+
+  /// @brief States are only distributed once every rank holds at least
+  /// 2^minLocalQubits amplitudes, smaller ones are replicated.
+  std::size_t minLocalQubits = 12;
+
+  /// @brief Random number generator, seeded identically on all ranks so that
+  /// measurement results agree.
+  std::mt19937 randomEngine;
+
+  /// @brief Local states with fewer amplitudes than this are updated on a
+  /// single thread.
+  static constexpr std::size_t minParallelDimension = 1ULL << 14;
+
+  /// @brief The number of amplitudes exchanged in one MPI message.
+  static constexpr std::size_t maxMessageLength = 1ULL << 20;
+
+  /// @brief Set up the communicator on the first allocation. Doing this
+  /// lazily avoids initializing MPI when the library is only loaded.
+  void initializeMPI() {
+    static_cast<void>(mpi::Session::get());
+    HANDLE_MPI_ERROR(MPI_Comm_rank(MPI_COMM_WORLD, &rank));
+    HANDLE_MPI_ERROR(MPI_Comm_size(MPI_COMM_WORLD, &nRanks));
+    if (!std::has_single_bit(static_cast<unsigned>(nRanks)))
+      throw std::runtime_error(fmt::format(
+          "[mpi] The number of ranks must be a power of two, got {}.",
+          nRanks));
+    nGlobalBits = std::countr_zero(static_cast<unsigned>(nRanks));
+
+    if (auto *minLocal = std::getenv("CUDAQ_MPI_MIN_LOCAL_QUBITS"))
+      minLocalQubits = std::max(1UL, std::strtoul(minLocal, nullptr, 10));
+
+    unsigned seed = 0;
+    if (rank == 0)
+      seed = std::random_device{}();
+    HANDLE_MPI_ERROR(MPI_Bcast(&seed, 1, MPI_UNSIGNED, 0, MPI_COMM_WORLD));
+    randomEngine.seed(seed);
+    cudaq::info("MPI state vector simulator on rank {} of {}.", rank, nRanks);
+  }
+
+  bool isGlobal(const std::size_t position) const {
+    return position >= nLocal;
+  }
+
+  /// @brief Return this rank's value of the global position bit.
+  bool rankBit(const std::size_t position) const {
+    return (rank >> (position - nLocal)) & 1;
+  }
+
+  /// @brief The global index of the first local amplitude.
+  std::size_t rankOffset() const {
+    return distributed ? static_cast<std::size_t>(rank) << nLocal : 0;
+  }
+
+  /// @brief Sum a value over the ranks holding distinct parts of the state.
+  double reduceSum(double value) const {
+    if (distributed)
+      HANDLE_MPI_ERROR(MPI_Allreduce(MPI_IN_PLACE, &value, 1, MPI_DOUBLE,
+                                     MPI_SUM, MPI_COMM_WORLD));
+    return value;
+  }
+
+  /// @brief Swap the qubit at the local position with the one at the global
+  /// position. The amplitudes whose local bit differs from this rank's
+  /// global bit are exchanged with the partner rank.
+  void swapWithGlobal(const std::size_t localPosition,
+                      const std::size_t globalPosition) {
+    const int bit = globalPosition - nLocal;
+    const int partner = rank ^ (1 << bit);
+    const std::size_t sendMask =
+        ((rank >> bit) & 1) ? 0 : 1ULL << localPosition;
+    const std::size_t half = localState.size() / 2;
+    std::vector<std::complex<double>> buffer(std::min(half, maxMessageLength));
+    for (std::size_t start = 0; start < half; start += buffer.size()) {
+      const std::size_t count = std::min(buffer.size(), half - start);
+      for (std::size_t k = 0; k < count; k++)
+        buffer[k] =
+            localState[mpi::insertZeroBit(start + k, localPosition) | sendMask];
+      HANDLE_MPI_ERROR(MPI_Sendrecv_replace(
+          buffer.data(), count, MPI_C_DOUBLE_COMPLEX, partner, 0, partner, 0,
+          MPI_COMM_WORLD, MPI_STATUS_IGNORE));
+      for (std::size_t k = 0; k < count; k++)
+        localState[mpi::insertZeroBit(start + k, localPosition) | sendMask] =
+            buffer[k];
+    }
+
+    for (auto &p : positionOf)
+      if (p == localPosition)
+        p = globalPosition;
+      else if (p == globalPosition)
+        p = localPosition;
+  }
+
+  /// @brief Move the target qubit to a local position, preferring one that
+  /// does not hold a control. Every rank makes the same choice.
+  void localizeTarget(const std::size_t target,
+                      const std::vector<std::size_t> &controls) {
+    std::size_t controlMask = 0;
+    for (auto c : controls)
+      if (!isGlobal(positionOf[c]))
+        controlMask |= 1ULL << positionOf[c];
+    std::size_t localPosition = nLocal - 1;
+    for (std::size_t p = nLocal; p-- > 0;)
+      if (!(controlMask & (1ULL << p))) {
+        localPosition = p;
+        break;
+      }
+    cudaq::info("Swapping global qubit {} into local position {}.", target,
+                localPosition);
+    swapWithGlobal(localPosition, positionOf[target]);
+  }
+
+  /// @brief Apply the general 2x2 matrix to the target qubit.
+  void applyMatrix(const nvqir::GateMatrix<double> &matrix,
+                   const std::vector<std::size_t> &controls,
+                   const std::size_t target) {
+    if (isGlobal(positionOf[target]))
+      localizeTarget(target, controls);
+
+    // Controls on global positions select whole ranks.
+    std::vector<std::size_t> fixed{positionOf[target]};
+    std::size_t controlMask = 0;
+    for (auto c : controls) {
+      const auto p = positionOf[c];
+      if (!isGlobal(p)) {
+        fixed.push_back(p);
+        controlMask |= 1ULL << p;
+      } else if (!rankBit(p)) {
+        return;
+      }
+    }
+    std::sort(fixed.begin(), fixed.end());
+
+    const std::size_t targetMask = 1ULL << positionOf[target];
+    const std::size_t nFree = localState.size() >> fixed.size();
+    auto *state = localState.data();
+#pragma omp parallel for if (nFree >= minParallelDimension)
+    for (std::size_t k = 0; k < nFree; k++) {
+      std::size_t i = k;
+      for (auto p : fixed)
+        i = mpi::insertZeroBit(i, p);
+      i |= controlMask;
+      const auto a = state[i], b = state[i | targetMask];
+      state[i] = matrix[0] * a + matrix[1] * b;
+      state[i | targetMask] = matrix[2] * a + matrix[3] * b;
+    }
+  }
+
+  template <typename GateT>
+  void oneQubitApply(const std::vector<std::size_t> &controls,
+                     const std::size_t qubitIdx) {
+    GateT gate;
+    CUDAQ_INFO(gateToString(gate.name(), controls, {}, {qubitIdx}));
+    if (skipPrefixGate(gate.name(), {}, controls, {qubitIdx}))
+      return;
+    applyMatrix(GateT::getMatrix(), controls, qubitIdx);
+  }
+
+  template <typename RotationGateT>
+  void oneQubitOneParamApply(const double angle,
+                             const std::vector<std::size_t> &controls,
+                             const std::size_t qubitIdx) {
+    RotationGateT gate;
+    CUDAQ_INFO(gateToString(gate.name(), controls, {angle}, {qubitIdx}));
+    if (skipPrefixGate(gate.name(), {angle}, controls, {qubitIdx}))
+      return;
+    applyMatrix(gate.getMatrix(angle), controls, qubitIdx);
+  }
+
+  /// @brief Grow the state to the allocated qubits. New qubits take the
+  /// lowest physical positions, so amplitude `I` moves to `I << k`. Once the
+  /// state is large enough it is split across the ranks, each rank keeping
+  /// the amplitudes it owns.
+  void addQubitToState() override {
+    if (nQubitsAllocated <= nPhysical)
+      return;
+
+    if (nPhysical == 0) {
+      initializeMPI();
+      localState.assign(1, 1.0);
+      nLocal = 0;
+      distributed = false;
+    }
+
+    const std::size_t k = nQubitsAllocated - nPhysical;
+    const std::size_t newPhysical = nQubitsAllocated;
+    const bool newDistributed =
+        distributed || (nGlobalBits > 0 &&
+                        newPhysical >= nGlobalBits + minLocalQubits);
+    const std::size_t newLocal =
+        newDistributed ? newPhysical - nGlobalBits : newPhysical;
+    const std::size_t newLocalMask = (1ULL << newLocal) - 1;
+
+    std::vector<std::complex<double>> grown(1ULL << newLocal);
+    const std::size_t offset = rankOffset();
+    for (std::size_t i = 0; i < localState.size(); i++) {
+      const std::size_t index = (offset | i) << k;
+      if (!newDistributed ||
+          (index >> newLocal) == static_cast<std::size_t>(rank))
+        grown[index & newLocalMask] = localState[i];
+    }
+    localState = std::move(grown);
+
+    for (auto &p : positionOf)
+      p += k;
+    for (std::size_t q = 0; q < k; q++)
+      positionOf.push_back(q);
+
+    if (newDistributed && !distributed)
+      cudaq::info("Distributing the {} qubit state over {} ranks.",
+                  newPhysical, nRanks);
+    nPhysical = newPhysical;
+    nLocal = newLocal;
+    distributed = newDistributed;
+  }
+
+  void resetQubitStateImpl() override {
+    localState.clear();
+    positionOf.clear();
+    nPhysical = 0;
+    nLocal = 0;
+    distributed = false;
+  }
+
+  bool canSnapshotState() override { return true; }
+
+  bool saveStateSnapshot() override {
+    snapshotState = localState;
+    snapshotPositions = positionOf;
+    return true;
+  }
+
+  bool restoreStateSnapshot() override {
+    if (snapshotState.size() != localState.size() ||
+        snapshotPositions.size() != positionOf.size())
+      return false;
+    localState = snapshotState;
+    positionOf = snapshotPositions;
+    return true;
+  }
+
+  void clearStateSnapshot() override {
+    snapshotState.clear();
+    snapshotPositions.clear();
+  }
+
+  /// @brief The memory of the amplitudes held by this rank.
+  std::size_t getStateBytes() override {
+    return localState.size() * sizeof(std::complex<double>);
+  }
+
+  /// @brief Return the probability of measuring the qubit in the |1> state.
+  double probabilityOfOne(const std::size_t qubitIdx) {
+    const auto position = positionOf[qubitIdx];
+    const bool global = isGlobal(position);
+    if (global && !rankBit(position))
+      return reduceSum(0.0);
+    const std::size_t mask = global ? 0 : 1ULL << position;
+    const auto *state = localState.data();
+    const std::size_t dim = localState.size();
+    double prob = 0.0;
+#pragma omp parallel for reduction(+ : prob) if (dim >= minParallelDimension)
+    for (std::size_t i = 0; i < dim; i++)
+      if ((i & mask) == mask)
+        prob += std::norm(state[i]);
+    return reduceSum(prob);
+  }
+
+  /// @brief Project the qubit onto the given result and renormalize.
+  void collapse(const std::size_t qubitIdx, const bool result,
+                const double probability) {
+    const auto position = positionOf[qubitIdx];
+    const double scale = 1.0 / std::sqrt(probability);
+    if (isGlobal(position)) {
+      const double factor = rankBit(position) == result ? scale : 0.0;
+      for (auto &a : localState)
+        a *= factor;
+      return;
+    }
+    const std::size_t mask = 1ULL << position;
+    auto *state = localState.data();
+    const std::size_t dim = localState.size();
+#pragma omp parallel for if (dim >= minParallelDimension)
+    for (std::size_t i = 0; i < dim; i++)
+      state[i] *= (static_cast<bool>(i & mask) == result) ? scale : 0.0;
+  }
+
+  bool measureQubit(const std::size_t qubitIdx) override {
+    synchronizeState();
+    const double probOne = probabilityOfOne(qubitIdx);
+    std::uniform_real_distribution<double> distr(0.0, 1.0);
+    const bool result = distr(randomEngine) < probOne;
+    collapse(qubitIdx, result, result ? probOne : 1.0 - probOne);
+    cudaq::info("Measured qubit {} -> {}", qubitIdx, result);
+    return result;
+  }
+
+  /// @brief Return the physical index mask of the given qubits.
+  std::size_t physicalMask(const std::vector<std::size_t> &qubits) const {
+    std::size_t mask = 0;
+    for (auto q : qubits)
+      mask |= 1ULL << positionOf[q];
+    return mask;
+  }
+
+  /// @brief Sum the probabilities of the local amplitudes into those of the
+  /// outcomes of the qubits, and the sums over the ranks. Qubits at global
+  /// positions take this rank's bit.
+  std::vector<double>
+  getMarginalProbabilities(const std::vector<std::size_t> &qubits) override {
+    synchronizeState();
+    std::vector<std::size_t> masks(qubits.size(), 0);
+    std::size_t rankOutcome = 0;
+    for (std::size_t j = 0; j < qubits.size(); j++) {
+      const auto position = positionOf[qubits[j]];
+      if (!isGlobal(position))
+        masks[j] = 1ULL << position;
+      else if (rankBit(position))
+        rankOutcome |= 1ULL << j;
+    }
+    const auto *state = localState.data();
+    const std::size_t dim = localState.size();
+    std::vector<double> probabilities(1ULL << qubits.size(), 0.0);
+    auto *sums = probabilities.data();
+    const auto nOutcomes = probabilities.size();
+#pragma omp parallel for reduction(+ : sums[:nOutcomes]) if (dim >= minParallelDimension)
+    for (std::size_t i = 0; i < dim; i++) {
+      std::size_t outcome = rankOutcome;
+      for (std::size_t j = 0; j < masks.size(); j++)
+        if (i & masks[j])
+          outcome |= 1ULL << j;
+      sums[outcome] += std::norm(state[i]);
+    }
+    if (distributed)
+      HANDLE_MPI_ERROR(MPI_Allreduce(MPI_IN_PLACE, sums, nOutcomes,
+                                     MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD));
+    return probabilities;
+  }
+
+  /// @brief Compute <Z...Z> over the given qubits.
+  double calculateExpectationValue(const std::vector<std::size_t> &qubits) {
+    const std::size_t mask = physicalMask(qubits);
+    const std::size_t offset = rankOffset();
+    const auto *state = localState.data();
+    const std::size_t dim = localState.size();
+    double result = 0.0;
+#pragma omp parallel for reduction(+ : result) if (dim >= minParallelDimension)
+    for (std::size_t i = 0; i < dim; i++) {
+      const double p = std::norm(state[i]);
+      result += (std::popcount((offset | i) & mask) & 1) ? -p : p;
+    }
+    return reduceSum(result);
+  }
+
+public:
+  MPICircuitSimulator() = default;
+  virtual ~MPICircuitSimulator() = default;
+
+  /// @brief The ranks exchange amplitudes over MPI_COMM_WORLD, the instances
+  /// of a rank would interleave their messages.
+  bool canRunConcurrently() override { return false; }
+
+  /// @brief Each rank holds an equal slice of the state vector.
+  std::size_t getRequiredStateBytes(std::size_t numQubits) override {
+    static_cast<void>(mpi::Session::get());
+    int size = 1;
+    HANDLE_MPI_ERROR(MPI_Comm_size(MPI_COMM_WORLD, &size));
+    return stateVectorBytes(numQubits, sizeof(std::complex<double>)) / size;
+  }
+
+  /// @brief Allocate all the qubits at once, so the state is grown and
+  /// redistributed a single time.
+  std::vector<std::size_t> allocateQubits(const std::size_t count) override {
+    std::vector<std::size_t> qubits;
+    for (std::size_t i = 0; i < count; i++)
+      qubits.emplace_back(tracker.getNextIndex());
+    cudaq::info("Allocating {} new qubits (nQ={}, dim={})", count,
+                nQubitsAllocated, stateDimension);
+    nQubitsAllocated += count;
+    stateDimension = calculateStateDim(nQubitsAllocated);
+    addQubitToState();
+    return qubits;
+  }
+
+/// The one-qubit overrides
+#define MPI_ONE_QUBIT_METHOD_OVERRIDE(NAME)                                    \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const std::vector<std::size_t> &controls,                          \
+            const std::size_t qubitIdx) override {                             \
+    oneQubitApply<nvqir::NAME<double>>(controls, qubitIdx);                    \
+  }
+
+  MPI_ONE_QUBIT_METHOD_OVERRIDE(x)
+  MPI_ONE_QUBIT_METHOD_OVERRIDE(y)
+  MPI_ONE_QUBIT_METHOD_OVERRIDE(z)
+  MPI_ONE_QUBIT_METHOD_OVERRIDE(h)
+  MPI_ONE_QUBIT_METHOD_OVERRIDE(s)
+  MPI_ONE_QUBIT_METHOD_OVERRIDE(t)
+  MPI_ONE_QUBIT_METHOD_OVERRIDE(sdg)
+  MPI_ONE_QUBIT_METHOD_OVERRIDE(tdg)
+
+/// The one-qubit parameterized overrides
+#define MPI_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(NAME)                          \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const double angle, const std::vector<std::size_t> &controls,      \
+            const std::size_t qubitIdx) override {                             \
+    oneQubitOneParamApply<nvqir::NAME<double>>(angle, controls, qubitIdx);     \
+  }
+
+  MPI_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rx)
+  MPI_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(ry)
+  MPI_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rz)
+  MPI_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(r1)
+  MPI_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(u1)
+
+#undef MPI_ONE_QUBIT_METHOD_OVERRIDE
+#undef MPI_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE
+
+  using CircuitSimulator::u2;
+  void u2(const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u2", controls, {phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u2", {phi, lambda}, controls, {qubitIdx}))
+      return;
+    applyMatrix(nvqir::u2<double>::getMatrix(phi, lambda), controls, qubitIdx);
+  }
+
+  using CircuitSimulator::u3;
+  void u3(const double theta, const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u3", controls, {theta, phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u3", {theta, phi, lambda}, controls, {qubitIdx}))
+      return;
+    applyMatrix(nvqir::u3<double>::getMatrix(theta, phi, lambda), controls,
+                qubitIdx);
+  }
+
+  bool canPermuteQubits() override { return true; }
+
+  /// @brief A qubit permutation only relabels the qubit positions.
+  void applyQubitPermutation(
+      const std::vector<std::size_t> &qubits,
+      const std::vector<std::size_t> &permutation) override {
+    std::vector<std::size_t> positions;
+    for (auto q : qubits)
+      positions.push_back(positionOf[q]);
+    for (std::size_t i = 0; i < qubits.size(); i++)
+      positionOf[qubits[permutation[i]]] = positions[i];
+  }
+
+  /// @brief An uncontrolled swap only relabels the qubit positions. The
+  /// controlled swap is applied as three CNOTs with the middle one carrying
+  /// the controls.
+  using CircuitSimulator::swap;
+  void swap(const std::vector<std::size_t> &ctrlBits, const std::size_t srcIdx,
+            const std::size_t tgtIdx) override {
+    CUDAQ_INFO(gateToString("swap", ctrlBits, {}, {srcIdx, tgtIdx}));
+    if (skipPrefixGate("swap", {}, ctrlBits, {srcIdx, tgtIdx}))
+      return;
+    if (ctrlBits.empty()) {
+      std::swap(positionOf[srcIdx], positionOf[tgtIdx]);
+      return;
+    }
+    constexpr auto x = nvqir::x<double>::getMatrix();
+    std::vector<std::size_t> controls(ctrlBits);
+    controls.push_back(srcIdx);
+    applyMatrix(x, {tgtIdx}, srcIdx);
+    applyMatrix(x, controls, tgtIdx);
+    applyMatrix(x, {tgtIdx}, srcIdx);
+  }
+
+  void resetQubit(const std::size_t qubitIdx) override {
+    if (measureQubit(qubitIdx))
+      applyMatrix(nvqir::x<double>::getMatrix(), {}, qubitIdx);
+  }
+
+  /// @brief Sample the state on the given qubits. The ranks draw the same
+  /// sorted random numbers, each one walks its slice for the numbers falling
+  /// into it, and the per-rank counts are then gathered on every rank.
+  cudaq::ExecutionResult sample(const std::vector<std::size_t> &measuredBits,
+                                const int shots) override {
+    synchronizeState();
+    double expectationValue = calculateExpectationValue(measuredBits);
+    if (shots < 1) {
+      cudaq::info("Computed expectation value = {}", expectationValue);
+      return cudaq::ExecutionResult{{}, expectationValue};
+    }
+    if (measuredBits.size() > 64)
+      throw std::runtime_error("[mpi] Cannot sample more than 64 qubits.");
+
+    const auto *state = localState.data();
+    const std::size_t dim = localState.size();
+    double localNorm = 0.0;
+    for (std::size_t i = 0; i < dim; i++)
+      localNorm += std::norm(state[i]);
+
+    // Cumulative probability in front of each rank's slice.
+    std::vector<double> norms(distributed ? nRanks : 1, localNorm);
+    if (distributed)
+      HANDLE_MPI_ERROR(MPI_Allgather(&localNorm, 1, MPI_DOUBLE, norms.data(),
+                                     1, MPI_DOUBLE, MPI_COMM_WORLD));
+    std::vector<double> offsets(norms.size(), 0.0);
+    for (std::size_t r = 1; r < norms.size(); r++)
+      offsets[r] = offsets[r - 1] + norms[r - 1];
+    const double totalNorm = offsets.back() + norms.back();
+    const std::size_t me = distributed ? rank : 0;
+
+    std::uniform_real_distribution<double> distr(0.0, totalNorm);
+    std::vector<double> randoms(shots);
+    for (auto &r : randoms)
+      r = distr(randomEngine);
+    std::sort(randoms.begin(), randoms.end());
+
+    // A random number belongs to the last rank with non-zero probability
+    // whose slice starts at or below it.
+    auto owner = [&](double r) {
+      std::size_t result = 0;
+      for (std::size_t k = 0; k < norms.size(); k++)
+        if (norms[k] > 0.0 && offsets[k] <= r)
+          result = k;
+      return result;
+    };
+
+    // Map each sampled amplitude index to the measured bits, packed so that
+    // measuredBits[j] ends up as bit j.
+    std::vector<std::size_t> positions;
+    for (auto q : measuredBits)
+      positions.push_back(positionOf[q]);
+    const std::size_t offset = rankOffset();
+    auto pack = [&](std::size_t i) {
+      const std::size_t index = offset | i;
+      std::uint64_t packed = 0;
+      for (std::size_t j = 0; j < positions.size(); j++)
+        packed |= static_cast<std::uint64_t>((index >> positions[j]) & 1ULL)
+                  << j;
+      return packed;
+    };
+
+    std::unordered_map<std::uint64_t, std::uint64_t> packedCounts;
+    double cumulative = offsets[me];
+    std::size_t i = 0;
+    for (auto r : randoms) {
+      if (owner(r) != me)
+        continue;
+      while (i < dim && cumulative + std::norm(state[i]) <= r) {
+        cumulative += std::norm(state[i]);
+        i++;
+      }
+      // Rounding can run us past the end, fall back to the last index with
+      // non-zero probability.
+      std::size_t sampled = i;
+      if (sampled == dim) {
+        sampled = dim - 1;
+        while (sampled > 0 && state[sampled] == 0.0)
+          sampled--;
+      }
+      packedCounts[pack(sampled)]++;
+    }
+
+    std::vector<std::uint64_t> flat;
+    for (auto &[packed, count] : packedCounts) {
+      flat.push_back(packed);
+      flat.push_back(count);
+    }
+    if (distributed) {
+      int localSize = flat.size();
+      std::vector<int> sizes(nRanks), displacements(nRanks, 0);
+      HANDLE_MPI_ERROR(MPI_Allgather(&localSize, 1, MPI_INT, sizes.data(), 1,
+                                     MPI_INT, MPI_COMM_WORLD));
+      for (int r = 1; r < nRanks; r++)
+        displacements[r] = displacements[r - 1] + sizes[r - 1];
+      std::vector<std::uint64_t> all(displacements.back() + sizes.back());
+      HANDLE_MPI_ERROR(MPI_Allgatherv(flat.data(), localSize, MPI_UINT64_T,
+                                      all.data(), sizes.data(),
+                                      displacements.data(), MPI_UINT64_T,
+                                      MPI_COMM_WORLD));
+      flat = std::move(all);
+    }
+
+    std::unordered_map<std::uint64_t, std::uint64_t> merged;
+    for (std::size_t k = 0; k < flat.size(); k += 2)
+      merged[flat[k]] += flat[k + 1];
+
+    cudaq::ExecutionResult counts(expectationValue);
+    std::string bitstring(measuredBits.size(), '0');
+    for (auto &[packed, count] : merged) {
+      for (std::size_t j = 0; j < measuredBits.size(); j++)
+        bitstring[j] = (packed >> j) & 1ULL ? '1' : '0';
+      counts.appendResult(bitstring, count);
+    }
+    return counts;
+  }
+
+  /// @brief Gather the full state on every rank, with qubit `q` as bit `q`
+  /// of the index.
+  cudaq::State getStateData() override {
+    synchronizeState();
+    std::vector<std::complex<double>> physical;
+    if (distributed) {
+      if (localState.size() > static_cast<std::size_t>(INT_MAX))
+        throw std::runtime_error("[mpi] State is too large to gather.");
+      physical.resize(localState.size() * nRanks);
+      HANDLE_MPI_ERROR(MPI_Allgather(
+          localState.data(), localState.size(), MPI_C_DOUBLE_COMPLEX,
+          physical.data(), localState.size(), MPI_C_DOUBLE_COMPLEX,
+          MPI_COMM_WORLD));
+    } else {
+      physical = localState;
+    }
+
+    std::vector<std::complex<double>> data(stateDimension);
+    for (std::size_t i = 0; i < stateDimension; i++) {
+      std::size_t index = 0;
+      for (std::size_t q = 0; q < nQubitsAllocated; q++)
+        index |= ((i >> q) & 1ULL) << positionOf[q];
+      data[i] = physical[index];
+    }
+    return cudaq::State{{stateDimension}, std::move(data)};
+  }
+
+  /// @brief Return true if the state is split across the ranks, primarily
+  /// used for testing.
+  bool isDistributed() const { return distributed; }
+
+  std::string name() const override { return "mpi"; }
+  NVQIR_SIMULATOR_CLONE_IMPL(MPICircuitSimulator)
+};
+
+} // namespace nvqir
+
+#ifndef __NVQIR_MPI_TOGGLE_CREATE
+/// Register this Simulator with NVQIR.
+NVQIR_REGISTER_SIMULATOR(nvqir::MPICircuitSimulator, mpi)
+#endif
@@ -0,0 +1,600 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CircuitSimulator.h"
+#include "Gates.h"
+#include <Eigen/Dense>
+#include <Eigen/SVD>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <unordered_map>
+
+namespace nvqir {
+
+/// @brief The MPSCircuitSimulator stores the state as a matrix product state,
+/// one tensor A[l, s, r] per qubit (qubit 0 first), with the bond dimensions
+/// l and r capped. Memory and gate cost grow with the bond dimension instead
+/// of 2^n, so circuits with little entanglement (shallow or 1D circuits) run
+/// on many more qubits than a state vector allows.
+///
+/// The state is kept in mixed canonical form around the `center` site, so
+/// that truncations after a gate discard the smallest Schmidt values of the
+/// whole state. Gates on several qubits swap them next to each other first.
+class MPSCircuitSimulator : public nvqir::CircuitSimulator {
+protected:
+  using Complex = std::complex<double>;
+  using Matrix = Eigen::Matrix<Complex, Eigen::Dynamic, Eigen::Dynamic,
+                               Eigen::RowMajor>;
+
+  /// @brief The tensor of each site, as a (2 * left) x right matrix, row
+  /// 2 * l + s and column r.
+  std::vector<Matrix> sites;
+
+  /// @brief All sites left of the center are left canonical, all sites right
+  /// of it right canonical.
+  std::size_t center = 0;
+
+  std::vector<Matrix> snapshotSites;
+  std::size_t snapshotCenter = 0;
+
+  /// @brief The maximum bond dimension, read from CUDAQ_MPS_MAX_BOND_DIM.
+  std::size_t maxBondDimension = 64;
+
+  /// @brief Singular values below this fraction of the largest one are
+  /// discarded, read from CUDAQ_MPS_TRUNCATION_THRESHOLD.
+  double truncationThreshold = 1e-12;
+
+  /// @brief The total weight of the discarded singular values.
+  double discardedWeight = 0.0;
+
+  std::mt19937 randomEngine;
+
+  static Matrix reshaped(const Matrix &m, std::size_t rows, std::size_t cols) {
+    return Eigen::Map<const Matrix>(m.data(), rows, cols);
+  }
+
+  /// @brief Return the l x r matrix A[:, s, :] of a site.
+  static Matrix slice(const Matrix &site, std::size_t s) {
+    const auto left = site.rows() / 2;
+    Matrix result(left, site.cols());
+    for (Eigen::Index l = 0; l < left; l++)
+      result.row(l) = site.row(2 * l + s);
+    return result;
+  }
+
+  /// @brief Move the center of the canonical form to the given site with QR
+  /// decompositions.
+  void moveCenterTo(std::size_t target) {
+    while (center < target) {
+      auto &site = sites[center];
+      const auto rows = site.rows(), cols = site.cols();
+      const auto k = std::min(rows, cols);
+      Eigen::HouseholderQR<Matrix> qr(site);
+      Matrix q = qr.householderQ() * Matrix::Identity(rows, k);
+      Matrix r = qr.matrixQR().topRows(k).triangularView<Eigen::Upper>();
+      site = q;
+      auto &next = sites[center + 1];
+      Matrix merged = r * reshaped(next, cols, 2 * next.cols());
+      next = reshaped(merged, 2 * k, next.cols());
+      center++;
+    }
+
+    while (center > target) {
+      auto &site = sites[center];
+      const auto left = site.rows() / 2, right = site.cols();
+      Matrix adjoint = reshaped(site, left, 2 * right).adjoint();
+      const auto k = std::min(left, 2 * right);
+      Eigen::HouseholderQR<Matrix> qr(adjoint);
+      Matrix q = qr.householderQ() * Matrix::Identity(2 * right, k);
+      Matrix r = qr.matrixQR().topRows(k).triangularView<Eigen::Upper>();
+      site = reshaped(q.adjoint(), 2 * k, right);
+      auto &previous = sites[center - 1];
+      previous = previous * r.adjoint();
+      center--;
+    }
+  }
+
+  /// @brief Split m into u * sv with u left canonical, keeping at most
+  /// maxBondDimension singular values above the truncation threshold. The
+  /// kept singular values are rescaled to preserve the norm.
+  void truncatedSplit(const Matrix &m, Matrix &u, Matrix &sv) {
+    Eigen::BDCSVD<Matrix> svd(m, Eigen::ComputeThinU | Eigen::ComputeThinV);
+    const auto &values = svd.singularValues();
+    Eigen::Index keep = 1;
+    while (keep < values.size() &&
+           keep < static_cast<Eigen::Index>(maxBondDimension) &&
+           values(keep) > truncationThreshold * values(0))
+      keep++;
+
+    const double total = values.squaredNorm();
+    const double kept = values.head(keep).squaredNorm();
+    discardedWeight += total - kept;
+    const double scale = kept > 0. ? std::sqrt(total / kept) : 1.;
+    u = svd.matrixU().leftCols(keep);
+    sv = (values.head(keep) * scale).cast<Complex>().asDiagonal() *
+         svd.matrixV().leftCols(keep).adjoint();
+  }
+
+  /// @brief Apply the dense (row major, first site most significant) matrix
+  /// to the `count` consecutive sites starting at `first`.
+  void applyToSites(const Matrix &gate, std::size_t first, std::size_t count) {
+    moveCenterTo(first);
+    const std::size_t left = sites[first].rows() / 2;
+    Matrix theta = sites[first];
+    for (std::size_t j = 1; j < count; j++) {
+      const auto &site = sites[first + j];
+      Matrix merged = theta * reshaped(site, theta.cols(), 2 * site.cols());
+      theta = reshaped(merged, 2 * theta.rows(), site.cols());
+    }
+
+    const std::size_t dim = 1ULL << count;
+    for (std::size_t l = 0; l < left; l++)
+      theta.middleRows(l * dim, dim) = gate * theta.middleRows(l * dim, dim);
+
+    // Split theta into sites from left to right.
+    const std::size_t right = theta.cols();
+    std::size_t bond = left;
+    std::size_t rest = dim;
+    Matrix current = reshaped(theta, 2 * bond, (rest / 2) * right);
+    for (std::size_t j = 0; j + 1 < count; j++) {
+      Matrix u, sv;
+      truncatedSplit(current, u, sv);
+      sites[first + j] = u;
+      bond = u.cols();
+      rest /= 2;
+      current = reshaped(sv, 2 * bond, (rest / 2) * right);
+    }
+    sites[first + count - 1] = current;
+    center = first + count - 1;
+  }
+
+  /// @brief Swap the qubits of sites first and first + 1.
+  void swapSites(std::size_t first) {
+    Matrix swapGate = Matrix::Zero(4, 4);
+    swapGate(0, 0) = swapGate(1, 2) = swapGate(2, 1) = swapGate(3, 3) = 1.;
+    applyToSites(swapGate, first, 2);
+  }
+
+  /// @brief Apply the row major 2^t x 2^t matrix on the target qubits (the
+  /// first target most significant), conditioned on the control qubits.
+  void applyGate(std::span<const Complex> matrix,
+                 const std::vector<std::size_t> &controls,
+                 const std::vector<std::size_t> &targets) {
+    if (controls.empty() && targets.size() == 1) {
+      auto &site = sites[targets[0]];
+      Matrix gate = Eigen::Map<const Matrix>(matrix.data(), 2, 2);
+      for (Eigen::Index l = 0; l < site.rows() / 2; l++)
+        site.middleRows(2 * l, 2) = gate * site.middleRows(2 * l, 2);
+      return;
+    }
+
+    // Bring the qubits next to the first one, keeping their order.
+    std::vector<std::size_t> qubits(controls.begin(), controls.end());
+    qubits.insert(qubits.end(), targets.begin(), targets.end());
+    std::sort(qubits.begin(), qubits.end());
+    std::vector<std::size_t> swaps;
+    for (std::size_t j = 1; j < qubits.size(); j++)
+      for (std::size_t s = qubits[j]; s > qubits[0] + j; s--) {
+        swapSites(s - 1);
+        swaps.push_back(s - 1);
+      }
+
+    // Embed the gate into the block of sites, the qubit at position j is
+    // bit (count - 1 - j) of the block index.
+    const std::size_t count = qubits.size();
+    const std::size_t dim = 1ULL << count;
+    auto bitOf = [&](std::size_t qubit) {
+      auto position =
+          std::find(qubits.begin(), qubits.end(), qubit) - qubits.begin();
+      return 1ULL << (count - 1 - position);
+    };
+    std::size_t controlMask = 0;
+    for (auto c : controls)
+      controlMask |= bitOf(c);
+    std::vector<std::size_t> targetBits;
+    for (auto t : targets)
+      targetBits.push_back(bitOf(t));
+    const std::size_t targetDim = 1ULL << targets.size();
+    auto gatherTargets = [&](std::size_t index) {
+      std::size_t local = 0;
+      for (auto bit : targetBits)
+        local = (local << 1) | ((index & bit) ? 1 : 0);
+      return local;
+    };
+    auto scatterTargets = [&](std::size_t index, std::size_t local) {
+      for (std::size_t j = 0; j < targetBits.size(); j++) {
+        const bool set = (local >> (targetBits.size() - 1 - j)) & 1;
+        index = set ? index | targetBits[j] : index & ~targetBits[j];
+      }
+      return index;
+    };
+
+    Matrix gate = Matrix::Zero(dim, dim);
+    for (std::size_t col = 0; col < dim; col++) {
+      if ((col & controlMask) != controlMask) {
+        gate(col, col) = 1.;
+        continue;
+      }
+      const auto in = gatherTargets(col);
+      for (std::size_t out = 0; out < targetDim; out++)
+        gate(scatterTargets(col, out), col) = matrix[out * targetDim + in];
+    }
+    applyToSites(gate, qubits[0], count);
+
+    for (auto iter = swaps.rbegin(); iter != swaps.rend(); ++iter)
+      swapSites(*iter);
+  }
+
+  /// @brief Return <psi| P |psi> for the Pauli string with the given
+  /// operator ('I', 'X', 'Y' or 'Z') on each qubit, contracting the
+  /// transfer matrices from the left.
+  double pauliExpectation(const std::vector<char> &paulis) {
+    auto last = paulis.size();
+    while (last > 0 && paulis[last - 1] == 'I')
+      last--;
+    if (last == 0)
+      return 1.0;
+
+    moveCenterTo(0);
+    Matrix env = Matrix::Identity(1, 1);
+    for (std::size_t i = 0; i < last; i++) {
+      const Matrix a0 = slice(sites[i], 0), a1 = slice(sites[i], 1);
+      switch (paulis[i]) {
+      case 'X':
+        env = a0.adjoint() * env * a1 + a1.adjoint() * env * a0;
+        break;
+      case 'Y':
+        env = Complex(0, -1) * (a0.adjoint() * env * a1) +
+              Complex(0, 1) * (a1.adjoint() * env * a0);
+        break;
+      case 'Z':
+        env = a0.adjoint() * env * a0 - a1.adjoint() * env * a1;
+        break;
+      default:
+        env = a0.adjoint() * env * a0 + a1.adjoint() * env * a1;
+        break;
+      }
+    }
+    return env.trace().real();
+  }
+
+  /// @brief Add |0> sites for the new qubits, which keeps the canonical form.
+  void addQubitToState() override {
+    while (sites.size() < nQubitsAllocated) {
+      Matrix zero = Matrix::Zero(2, 1);
+      zero(0, 0) = 1.;
+      sites.push_back(zero);
+    }
+  }
+
+  void resetQubitStateImpl() override {
+    sites.clear();
+    center = 0;
+    discardedWeight = 0.0;
+  }
+
+  bool canSnapshotState() override { return true; }
+
+  bool saveStateSnapshot() override {
+    snapshotSites = sites;
+    snapshotCenter = center;
+    return true;
+  }
+
+  bool restoreStateSnapshot() override {
+    if (snapshotSites.size() != sites.size())
+      return false;
+    sites = snapshotSites;
+    center = snapshotCenter;
+    return true;
+  }
+
+  void clearStateSnapshot() override { snapshotSites.clear(); }
+
+  std::size_t getStateBytes() override {
+    std::size_t bytes = 0;
+    for (auto &site : sites)
+      bytes += site.size() * sizeof(Complex);
+    return bytes;
+  }
+
+  bool canHandleObserve() override { return isExactObservation(); }
+
+  bool measureQubit(const std::size_t qubitIdx) override {
+    synchronizeState();
+    moveCenterTo(qubitIdx);
+    auto &site = sites[qubitIdx];
+    double probabilities[2] = {0., 0.};
+    for (Eigen::Index row = 0; row < site.rows(); row++)
+      probabilities[row % 2] += site.row(row).squaredNorm();
+    const double total = probabilities[0] + probabilities[1];
+    std::uniform_real_distribution<double> distr(0.0, total);
+    const bool result = distr(randomEngine) < probabilities[1];
+
+    // Project onto the outcome, the center carries the norm.
+    const double scale = std::sqrt(total / probabilities[result]);
+    for (Eigen::Index row = 0; row < site.rows(); row++)
+      if (row % 2 == result)
+        site.row(row) *= scale;
+      else
+        site.row(row).setZero();
+    cudaq::info("Measured qubit {} -> {}", qubitIdx, result);
+    return result;
+  }
+
+  /// @brief Contract <psi| P |psi> from the left for the projector P onto
+  /// each outcome of the qubits, without forming the state vector.
+  std::vector<double>
+  getMarginalProbabilities(const std::vector<std::size_t> &qubits) override {
+    synchronizeState();
+    std::vector<int> fixed(sites.size(), -1);
+    std::vector<double> probabilities(1ULL << qubits.size());
+    double total = 0.0;
+    for (std::size_t outcome = 0; outcome < probabilities.size(); outcome++) {
+      for (std::size_t j = 0; j < qubits.size(); j++)
+        fixed[qubits[j]] = (outcome >> j) & 1;
+      Matrix environment = Matrix::Ones(1, 1);
+      for (std::size_t s = 0; s < sites.size(); s++) {
+        const auto &site = sites[s];
+        const Eigen::Index left = site.rows() / 2;
+        Matrix next = Matrix::Zero(site.cols(), site.cols());
+        for (int bit = 0; bit < 2; bit++) {
+          if (fixed[s] >= 0 && fixed[s] != bit)
+            continue;
+          Matrix slice(left, site.cols());
+          for (Eigen::Index l = 0; l < left; l++)
+            slice.row(l) = site.row(2 * l + bit);
+          next += slice.adjoint() * environment * slice;
+        }
+        environment = std::move(next);
+      }
+      probabilities[outcome] = environment(0, 0).real();
+      total += probabilities[outcome];
+    }
+    // The center of the MPS carries its norm.
+    for (auto &p : probabilities)
+      p /= total;
+    return probabilities;
+  }
+
+public:
+  MPSCircuitSimulator() : randomEngine(std::random_device{}()) {
+    if (auto *maxBond = std::getenv("CUDAQ_MPS_MAX_BOND_DIM"))
+      maxBondDimension = std::max(1UL, std::strtoul(maxBond, nullptr, 10));
+    if (auto *threshold = std::getenv("CUDAQ_MPS_TRUNCATION_THRESHOLD"))
+      truncationThreshold = std::strtod(threshold, nullptr);
+    cudaq::info("MPS simulator with maximum bond dimension {} and truncation "
+                "threshold {}.",
+                maxBondDimension, truncationThreshold);
+  }
+  virtual ~MPSCircuitSimulator() = default;
+
+  /// @brief A site holds at most 2 x maxBondDimension^2 amplitudes.
+  std::size_t getRequiredStateBytes(std::size_t numQubits) override {
+    return numQubits * 2 * maxBondDimension * maxBondDimension *
+           sizeof(Complex);
+  }
+
+  void seedRandomEngines(std::uint64_t seed) override {
+    CircuitSimulator::seedRandomEngines(seed);
+    randomEngine.seed(seed);
+  }
+
+  /// @brief Allocate the qubits without tracking the state dimension, which
+  /// overflows beyond 63 qubits.
+  std::vector<std::size_t> allocateQubits(const std::size_t count) override {
+    std::vector<std::size_t> qubits;
+    for (std::size_t i = 0; i < count; i++)
+      qubits.emplace_back(tracker.getNextIndex());
+    cudaq::info("Allocating {} new qubits (nQ={})", count, nQubitsAllocated);
+    nQubitsAllocated += count;
+    addQubitToState();
+    return qubits;
+  }
+
+  std::size_t allocateQubit() override { return allocateQubits(1)[0]; }
+
+/// The one-qubit overrides
+#define MPS_ONE_QUBIT_METHOD_OVERRIDE(NAME)                                    \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const std::vector<std::size_t> &controls,                          \
+            const std::size_t qubitIdx) override {                             \
+    nvqir::NAME<double> gate;                                                  \
+    CUDAQ_INFO(gateToString(gate.name(), controls, {}, {qubitIdx}));           \
+    if (skipPrefixGate(gate.name(), {}, controls, {qubitIdx}))                 \
+      return;                                                                  \
+    applyGate(gate.getMatrix(), controls, {qubitIdx});                         \
+  }
+
+  MPS_ONE_QUBIT_METHOD_OVERRIDE(x)
+  MPS_ONE_QUBIT_METHOD_OVERRIDE(y)
+  MPS_ONE_QUBIT_METHOD_OVERRIDE(z)
+  MPS_ONE_QUBIT_METHOD_OVERRIDE(h)
+  MPS_ONE_QUBIT_METHOD_OVERRIDE(s)
+  MPS_ONE_QUBIT_METHOD_OVERRIDE(t)
+  MPS_ONE_QUBIT_METHOD_OVERRIDE(sdg)
+  MPS_ONE_QUBIT_METHOD_OVERRIDE(tdg)
+
+#undef MPS_ONE_QUBIT_METHOD_OVERRIDE
+
+/// The one-qubit parameterized overrides
+#define MPS_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(NAME)                          \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const double angle, const std::vector<std::size_t> &controls,      \
+            const std::size_t qubitIdx) override {                             \
+    nvqir::NAME<double> gate;                                                  \
+    CUDAQ_INFO(gateToString(gate.name(), controls, {angle}, {qubitIdx}));      \
+    if (skipPrefixGate(gate.name(), {angle}, controls, {qubitIdx}))            \
+      return;                                                                  \
+    applyGate(gate.getMatrix(angle), controls, {qubitIdx});                    \
+  }
+
+  MPS_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rx)
+  MPS_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(ry)
+  MPS_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rz)
+  MPS_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(r1)
+  MPS_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(u1)
+
+#undef MPS_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE
+
+  using CircuitSimulator::u2;
+  void u2(const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u2", controls, {phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u2", {phi, lambda}, controls, {qubitIdx}))
+      return;
+    applyGate(nvqir::u2<double>::getMatrix(phi, lambda), controls, {qubitIdx});
+  }
+
+  using CircuitSimulator::u3;
+  void u3(const double theta, const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u3", controls, {theta, phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u3", {theta, phi, lambda}, controls, {qubitIdx}))
+      return;
+    applyGate(nvqir::u3<double>::getMatrix(theta, phi, lambda), controls,
+              {qubitIdx});
+  }
+
+  using CircuitSimulator::swap;
+  void swap(const std::vector<std::size_t> &ctrlBits, const std::size_t srcIdx,
+            const std::size_t tgtIdx) override {
+    CUDAQ_INFO(gateToString("swap", ctrlBits, {}, {srcIdx, tgtIdx}));
+    if (skipPrefixGate("swap", {}, ctrlBits, {srcIdx, tgtIdx}))
+      return;
+    static constexpr std::array<Complex, 16> swapGate{
+        1., 0., 0., 0., 0., 0., 1., 0., 0., 1., 0., 0., 0., 0., 0., 1.};
+    applyGate(swapGate, ctrlBits, {srcIdx, tgtIdx});
+  }
+
+  void resetQubit(const std::size_t qubitIdx) override {
+    if (measureQubit(qubitIdx))
+      applyGate(nvqir::x<double>::getMatrix(), {}, {qubitIdx});
+  }
+
+  /// @brief Sample the given qubits directly from the MPS. With the center
+  /// at the first site, each shot draws the qubits from left to right, up to
+  /// the last measured one, from their conditional probabilities.
+  cudaq::ExecutionResult sample(const std::vector<std::size_t> &measuredBits,
+                                const int shots) override {
+    synchronizeState();
+    if (shots < 1) {
+      std::vector<char> paulis(sites.size(), 'I');
+      for (auto q : measuredBits)
+        paulis[q] = 'Z';
+      double expectationValue = pauliExpectation(paulis);
+      cudaq::info("Computed expectation value = {}", expectationValue);
+      return cudaq::ExecutionResult{{}, expectationValue};
+    }
+
+    cudaq::info("Sampling the MPS, discarded weight so far {}.",
+                discardedWeight);
+    moveCenterTo(0);
+    const std::size_t last =
+        measuredBits.empty()
+            ? 0
+            : *std::max_element(measuredBits.begin(), measuredBits.end()) + 1;
+    std::vector<std::array<Matrix, 2>> slices;
+    for (std::size_t i = 0; i < last; i++)
+      slices.push_back({slice(sites[i], 0), slice(sites[i], 1)});
+
+    std::unordered_map<std::string, std::size_t> counts;
+    std::vector<bool> outcome(last);
+    std::string bitstring(measuredBits.size(), '0');
+    std::uniform_real_distribution<double> distr(0.0, 1.0);
+    Eigen::Matrix<Complex, 1, Eigen::Dynamic> prefix, branch0, branch1;
+    for (int shot = 0; shot < shots; shot++) {
+      prefix = Eigen::Matrix<Complex, 1, Eigen::Dynamic>::Ones(1);
+      for (std::size_t i = 0; i < last; i++) {
+        branch0 = prefix * slices[i][0];
+        branch1 = prefix * slices[i][1];
+        const double p0 = branch0.squaredNorm(), p1 = branch1.squaredNorm();
+        outcome[i] = distr(randomEngine) * (p0 + p1) < p1;
+        prefix = outcome[i] ? branch1 / std::sqrt(p1) : branch0 / std::sqrt(p0);
+      }
+      for (std::size_t j = 0; j < measuredBits.size(); j++)
+        bitstring[j] = outcome[measuredBits[j]] ? '1' : '0';
+      counts[bitstring]++;
+    }
+
+    std::vector<char> paulis(sites.size(), 'I');
+    for (auto q : measuredBits)
+      paulis[q] = 'Z';
+    cudaq::ExecutionResult result(pauliExpectation(paulis));
+    for (auto &[bits, count] : counts)
+      result.appendResult(bits, count);
+    return result;
+  }
+
+  /// @brief Compute <psi| H |psi> term by term from the MPS.
+  cudaq::ExecutionResult observe(const cudaq::spin_op &H) override {
+    synchronizeState();
+    const auto nSpinQubits = H.n_qubits();
+    if (nSpinQubits > nQubitsAllocated)
+      throw std::runtime_error("Cannot observe a spin_op on " +
+                               std::to_string(nSpinQubits) + " qubits with " +
+                               std::to_string(nQubitsAllocated) +
+                               " qubits allocated.");
+    double expectation = 0.0;
+    for (auto term : H.terms()) {
+      std::vector<char> paulis(sites.size(), 'I');
+      for (std::size_t q = 0; q < nSpinQubits; q++) {
+        const auto p = term.get_pauli(q);
+        paulis[q] = p == cudaq::pauli::Y   ? 'Y'
+                    : p == cudaq::pauli::X ? 'X'
+                    : p == cudaq::pauli::Z ? 'Z'
+                                           : 'I';
+      }
+      expectation += term.get_coefficient().real() * pauliExpectation(paulis);
+    }
+    cudaq::info("Computed expectation value = {}", expectation);
+    return cudaq::ExecutionResult{{}, expectation};
+  }
+
+  /// @brief Contract the MPS into a state vector, qubit 0 is the most
+  /// significant bit of the index (as for qpp).
+  cudaq::State getStateData() override {
+    synchronizeState();
+    if (sites.size() > 30)
+      throw std::runtime_error(
+          "The mps backend only provides the state vector of up to 30 "
+          "qubits, the state has " +
+          std::to_string(sites.size()) + ".");
+    Matrix state = Matrix::Ones(1, 1);
+    for (auto &site : sites) {
+      Matrix merged = state * reshaped(site, state.cols(), 2 * site.cols());
+      state = reshaped(merged, 2 * state.rows(), site.cols());
+    }
+    return cudaq::State{{static_cast<std::size_t>(state.size())},
+                        {state.data(), state.data() + state.size()}};
+  }
+
+  /// @brief Return the largest bond dimension of the MPS, primarily used
+  /// for testing.
+  std::size_t getMaxBondDimension() const {
+    std::size_t result = 1;
+    for (auto &site : sites)
+      result = std::max<std::size_t>(result, site.cols());
+    return result;
+  }
+
+  std::string name() const override { return "mps"; }
+  NVQIR_SIMULATOR_CLONE_IMPL(MPSCircuitSimulator)
+};
+
+} // namespace nvqir
+
+#ifndef __NVQIR_MPS_TOGGLE_CREATE
+/// Register this Simulator with NVQIR.
+NVQIR_REGISTER_SIMULATOR(nvqir::MPSCircuitSimulator, mps)
+#endif
@@ -8,80 +8,410 @@
 
 #include "CircuitSimulator.h"
 #include "Gates.h"
+#include "PauliGroups.h"
+#include "cudaq/spin_op.h"
 #include "qpp.h"
+#include <algorithm>
+#include <bit>
 #include <iostream>
+#include <numeric>
+#include <unordered_map>
 
 namespace nvqir {
 
+/// @brief Single precision state vector, used by the qpp-f32 backend. Gates
+/// go through the in-place kernels below, which do not need Q++ support for
+/// the amplitude type.
+using ket32 = Eigen::Matrix<std::complex<float>, Eigen::Dynamic, 1>;
+
 /// @brief The QppCircuitSimulator implements the CircuitSimulator
 /// base class to provide a simulator delegating to the Q++ library from
 /// https://github.com/softwareqinc/qpp.
 template <typename StateType>
 class QppCircuitSimulator : public nvqir::CircuitSimulator {
 protected:
-  /// The QPP state representation (qpp::ket or qpp::cmat)
+  /// The QPP state representation (qpp::ket, nvqir::ket32 or qpp::cmat)
   StateType state;
 
+  /// @brief True for state vectors of either precision.
+  static constexpr bool isStateVector = !std::is_same_v<StateType, qpp::cmat>;
+
+  /// @brief The amplitude type of the state.
+  using Amplitude = typename StateType::Scalar;
+
+  /// @brief Copy of the state at the end of a cached conditional prefix.
+  StateType prefixSnapshot;
+
+  /// @brief The auxiliary states of adjoint differentiation.
+  std::vector<StateType> auxiliaryStates;
+
   /// @brief Provide a base-class method that can be invoked
   /// after every gate application and will apply any noise
   /// channels after the gate invocation based on a user-provided noise
-  /// model. Unimplemented on the base class, sub-types can implement noise
-  /// modeling.
+  /// model. State vectors sample the channels as quantum trajectories,
+  /// sub-types can implement other noise modeling.
   virtual void applyNoiseChannel(const std::string_view gateName,
-                                 const std::vector<std::size_t> &qubits) {}
+                                 const std::vector<std::size_t> &qubits) {
+    if constexpr (isStateVector)
+      applyNoiseTrajectory(gateName, qubits);
+  }
 
-  /// @brief Compute the expectation value <Z...Z> over the given qubit indices.
-  /// @param qubit_indices
-  /// @return expectation
-  double
-  calculateExpectationValue(const std::vector<std::size_t> &qubit_indices) {
-    const auto hasEvenParity =
-        [](std::size_t x,
-           const std::vector<std::size_t> &in_qubitIndices) -> bool {
-      size_t count = 0;
-      for (const auto &bitIdx : in_qubitIndices) {
-        if (x & (1ULL << bitIdx)) {
-          count++;
+  /// @brief Whether applyNoisyGate() may apply gates, set by sub-types whose
+  /// noise model has channels.
+  bool hasNoisyGates = false;
+
+  /// @brief Apply the gate, given as a row major 2x2 matrix controlled by
+  /// all but the last of the qubits, followed by its noise channels in a
+  /// single pass, and return true. Return false if the gate is noiseless or
+  /// the sub-type does not fuse gates with their channels. `angle` tells the
+  /// parameterized gates apart, it is 0 for the others.
+  virtual bool applyNoisyGate(const std::string_view gateName,
+                              const double angle,
+                              const std::vector<std::complex<double>> &gate,
+                              const std::vector<std::size_t> &qubits) {
+    return false;
+  }
+
+  /// @brief State vectors simulate noise with quantum trajectories.
+  bool canHandleTrajectoryNoise() override {
+    return isStateVector;
+  }
+
+  /// @brief Exact expectation values are computed by observe(), sampled
+  /// observations still measure every term.
+  bool canHandleObserve() override { return isExactObservation(); }
+
+  /// @brief Return <psi| sum_t P_t |psi> (or Tr(rho sum_t P_t)) for the
+  /// terms of the group, see XMaskGroup, in one read-only sweep over the
+  /// state. f(k) is looked up in the phase table of the group if that is
+  /// cheaper than summing the terms for each amplitude.
+  double groupExpectation(const XMaskGroup &group) const {
+    const std::size_t dim = state.rows();
+    const auto *data = state.data();
+    const std::size_t xMask = group.xMask;
+    const bool useTable = group.useTable(dim);
+    const auto table = useTable ? group.phaseTable()
+                                : std::vector<std::complex<double>>();
+    const auto zUnion = group.zUnion();
+    auto phaseOf = [&](std::size_t k) {
+      if (useTable)
+        return table[XMaskGroup::gatherBits(k, zUnion)];
+      std::complex<double> phase = 0.0;
+      for (std::size_t t = 0; t < group.zMasks.size(); t++)
+        phase += paritySign(k, group.zMasks[t]) * group.coefficients[t];
+      return phase;
+    };
+    double sum = 0.0;
+#pragma omp parallel for reduction(+ : sum) if (dim >= minParallelDimension)
+    for (std::size_t k = 0; k < dim; ++k) {
+      std::complex<double> element;
+      if constexpr (isStateVector)
+        element = std::conj(std::complex<double>(data[k ^ xMask])) *
+                  std::complex<double>(data[k]);
+      else
+        element = data[(k ^ xMask) * dim + k];
+      // The sum is real for a Hermitian operator.
+      sum += (phaseOf(k) * element).real();
+    }
+    return sum;
+  }
+
+  /// @brief State vectors apply Pauli rotations in one sweep.
+  bool canApplyPauliRotation() override { return isStateVector; }
+
+  /// @brief Apply exp(-i angle / 2 P) = cos(angle / 2) - i sin(angle / 2) P,
+  /// where P maps |k> to i^nY (-1)^|k & zMask| |k ^ xMask>. Each amplitude
+  /// pair (k, k ^ xMask) is updated once.
+  void applyPauliRotationImpl(double angle,
+                              const std::vector<std::size_t> &qubits,
+                              const std::vector<cudaq::pauli> &paulis) override {
+    if constexpr (isStateVector) {
+      CUDAQ_INFO("Applying Pauli rotation({}) on {} qubits", angle,
+                 qubits.size());
+      std::size_t xMask = 0, zMask = 0, nY = 0;
+      for (std::size_t j = 0; j < qubits.size(); j++) {
+        if (paulis[j] == cudaq::pauli::X || paulis[j] == cudaq::pauli::Y)
+          xMask |= qubitMask(qubits[j]);
+        if (paulis[j] == cudaq::pauli::Z || paulis[j] == cudaq::pauli::Y)
+          zMask |= qubitMask(qubits[j]);
+        nY += paulis[j] == cudaq::pauli::Y;
+      }
+      const std::complex<double> phases[] = {1.0, {0, 1}, -1.0, {0, -1}};
+      // -i sin(angle / 2) i^nY, times the sign of the source amplitude.
+      const std::complex<double> offDiagonal =
+          std::complex<double>(0, -std::sin(angle / 2)) * phases[nY % 4];
+      const double c = std::cos(angle / 2);
+      auto *data = state.data();
+      const std::size_t dim = state.rows();
+
+      if (xMask == 0) {
+#pragma omp parallel for if (dim >= minParallelDimension)
+        for (std::size_t k = 0; k < dim; ++k) {
+          const double sign = std::popcount(k & zMask) & 1 ? -1.0 : 1.0;
+          data[k] *= Amplitude(c + sign * offDiagonal);
         }
+        return;
       }
-      return (count % 2) == 0;
-    };
 
-    // First, convert all of the qubit indices to big endian.
-    std::vector<std::size_t> casted_qubit_indices;
-    for (auto index : qubit_indices) {
-      casted_qubit_indices.push_back(bigEndian(nQubitsAllocated, index));
+      // Pair k with k ^ xMask, with k the one without the top bit of xMask.
+      const std::size_t topBit = 1ULL << (63 - std::countl_zero(xMask));
+      const std::size_t nPairs = dim >> 1;
+#pragma omp parallel for if (nPairs >= minParallelDimension)
+      for (std::size_t p = 0; p < nPairs; ++p) {
+        const std::size_t k0 = insertZeroBit(p, topBit);
+        const std::size_t k1 = k0 ^ xMask;
+        const std::complex<double> a0(data[k0]), a1(data[k1]);
+        const double sign0 = std::popcount(k0 & zMask) & 1 ? -1.0 : 1.0;
+        const double sign1 = std::popcount(k1 & zMask) & 1 ? -1.0 : 1.0;
+        data[k0] = Amplitude(c * a0 + sign1 * offDiagonal * a1);
+        data[k1] = Amplitude(c * a1 + sign0 * offDiagonal * a0);
+      }
+    }
+  }
+
+  /// @brief State vectors and density matrices apply a layer of diagonal
+  /// phases in one sweep.
+  bool canApplyDiagonalPhases() override { return true; }
+
+  /// @brief Multiply |k> by exp(-i sum_r angle_r / 2 (-1)^|k & mask_r|),
+  /// with mask_r the qubits of rotation r, and rho_kl by the phase of k times
+  /// the conjugate phase of l.
+  void
+  applyDiagonalPhasesImpl(const std::vector<ZRotation> &rotations) override {
+    CUDAQ_INFO("Applying {} diagonal phases", rotations.size());
+    std::vector<std::size_t> masks;
+    std::vector<double> halfAngles;
+    for (auto &rotation : rotations) {
+      masks.push_back(qubitsMask(rotation.qubits));
+      halfAngles.push_back(rotation.angle / 2);
     }
+    auto phaseOf = [&](std::size_t k) {
+      double phase = 0.0;
+      for (std::size_t r = 0; r < masks.size(); r++)
+        phase -= paritySign(k, masks[r]) * halfAngles[r];
+      return std::polar(1.0, phase);
+    };
+    auto *data = state.data();
+    const std::size_t dim = state.rows();
+    if constexpr (isStateVector) {
+#pragma omp parallel for if (dim >= minParallelDimension)
+      for (std::size_t k = 0; k < dim; ++k)
+        data[k] *= Amplitude(phaseOf(k));
+    } else {
+      std::vector<std::complex<double>> phases(dim);
+#pragma omp parallel for if (dim >= minParallelDimension)
+      for (std::size_t k = 0; k < dim; ++k)
+        phases[k] = phaseOf(k);
+      // Column major, element (k, l) at l * dim + k.
+#pragma omp parallel for if (dim >= minParallelDimension)
+      for (std::size_t l = 0; l < dim; ++l)
+        for (std::size_t k = 0; k < dim; ++k)
+          data[l * dim + k] *= Amplitude(phases[k] * std::conj(phases[l]));
+    }
+  }
 
+  /// @brief Return -1 if `i` has an odd number of the bits of `mask` set,
+  /// else 1, without branching.
+  static double paritySign(std::size_t i, std::size_t mask) {
+    return 1.0 - 2.0 * static_cast<double>(std::popcount(i & mask) & 1);
+  }
+
+  /// @brief Compute the expectation value <Z...Z> over the given qubit indices
+  /// in a single read of the probabilities.
+  /// @param qubit_indices
+  /// @return expectation
+  double
+  calculateExpectationValue(const std::vector<std::size_t> &qubit_indices) {
+    const auto mask = qubitsMask(qubit_indices);
+    const auto dim = static_cast<std::size_t>(state.rows());
+    const auto *data = state.data();
+    const bool parallel = dim >= minParallelDimension;
     double result = 0.0;
-    if constexpr (std::is_same_v<StateType, qpp::ket>) {
-#pragma omp parallel for reduction(+ : result)
-      for (std::size_t i = 0; i < stateDimension; ++i) {
-        result += (hasEvenParity(i, casted_qubit_indices) ? 1.0 : -1.0) *
-                  std::norm(state[i]);
-      }
-    } else if constexpr (std::is_same_v<StateType, qpp::cmat>) {
-      Eigen::VectorXcd diag = state.diagonal();
-#pragma omp parallel for reduction(+ : result)
-      for (Eigen::Index i = 0; i < state.rows(); i++) {
-        auto element = diag(i).real();
-        if (!hasEvenParity(i, casted_qubit_indices))
-          element *= -1.;
-        result += element;
-      }
+    if constexpr (isStateVector) {
+#pragma omp parallel for simd reduction(+ : result) if (parallel)
+      for (std::size_t i = 0; i < dim; ++i)
+        result += paritySign(i, mask) * std::norm(data[i]);
+    } else {
+#pragma omp parallel for simd reduction(+ : result) if (parallel)
+      for (std::size_t i = 0; i < dim; i++)
+        result += paritySign(i, mask) * data[i * dim + i].real();
     }
 
     return result;
   }
 
-  qpp::cmat toQppMatrix(std::vector<std::complex<double>> &&data) {
-    assert(data.size() == 4 &&
-           "Invalid number of gate matrix elements passed to toQppMatrix");
-
+  qpp::cmat toQppMatrix(const nvqir::GateMatrix<double> &data) {
     // we represent row major, they represent column major
-    return Eigen::Map<Eigen::Matrix<std::complex<double>, Eigen::Dynamic,
-                                    Eigen::Dynamic, Eigen::RowMajor>>(
-        data.data(), 2, 2);
+    return Eigen::Map<const Eigen::Matrix<std::complex<double>, 2, 2,
+                                          Eigen::RowMajor>>(data.data());
+  }
+
+  /// @brief States with fewer amplitudes than this are updated on a single
+  /// thread, the OpenMP fork / join overhead dominates below this size.
+  static constexpr std::size_t minParallelDimension = 1ULL << 14;
+
+  /// @brief Return the number of qubits of the state. It can be larger than
+  /// the number of allocated qubits, deallocated qubits stay in the state
+  /// unless they are its last qubits.
+  std::size_t nStateQubits() const {
+    if (state.size() == 0)
+      return 0;
+    return std::countr_zero(static_cast<std::size_t>(state.rows()));
+  }
+
+  /// @brief Return the bit in the Q++ (big endian) amplitude index that
+  /// corresponds to the given qubit.
+  std::size_t qubitMask(const std::size_t qubitIdx) const {
+    return 1ULL << (nStateQubits() - qubitIdx - 1);
+  }
+
+  /// @brief Return the combined bit mask for all the given qubits.
+  std::size_t qubitsMask(const std::vector<std::size_t> &qubits) const {
+    std::size_t mask = 0;
+    for (auto q : qubits)
+      mask |= qubitMask(q);
+    return mask;
+  }
+
+  /// @brief Insert a zero bit into `k` at the position of the single set bit
+  /// in `mask`, moving the higher bits of `k` up by one.
+  static std::size_t insertZeroBit(const std::size_t k,
+                                   const std::size_t mask) {
+    const std::size_t low = mask - 1;
+    return ((k & ~low) << 1) | (k & low);
+  }
+
+  /// @brief Apply the single-qubit `kernel` in place to every amplitude pair
+  /// (|..0..>, |..1..>) of the target qubit for which all control qubits are
+  /// in the |1> state. The kernel is invoked as `kernel(alpha0, alpha1)`. This
+  /// is one sweep over the state vector and performs no allocation.
+  template <typename KernelT>
+  void applyOneQubitKernel(const std::vector<std::size_t> &controls,
+                           const std::size_t qubitIdx, KernelT &&kernel) {
+    const std::size_t targetMask = qubitMask(qubitIdx);
+    const std::size_t controlMask = qubitsMask(controls);
+    const std::size_t nPairs = static_cast<std::size_t>(state.rows()) >> 1;
+    auto *data = state.data();
+#pragma omp parallel for if (nPairs >= minParallelDimension)
+    for (std::size_t k = 0; k < nPairs; ++k) {
+      const std::size_t i0 = insertZeroBit(k, targetMask);
+      if ((i0 & controlMask) != controlMask)
+        continue;
+      kernel(data[i0], data[i0 | targetMask]);
+    }
+  }
+
+  /// @brief Apply the general 2x2 (row major) `matrix` to the target qubit,
+  /// in place for state vectors, via Q++ for density matrices.
+  void applyOneQubitMatrix(const nvqir::GateMatrix<double> &matrix,
+                           const std::vector<std::size_t> &controls,
+                           const std::size_t qubitIdx) {
+    if constexpr (isStateVector) {
+      const Amplitude m00(matrix[0]), m01(matrix[1]), m10(matrix[2]),
+          m11(matrix[3]);
+      applyOneQubitKernel(controls, qubitIdx,
+                          [=](Amplitude &a0, Amplitude &a1) {
+                            const auto tmp = a0;
+                            a0 = m00 * tmp + m01 * a1;
+                            a1 = m10 * tmp + m11 * a1;
+                          });
+    } else {
+      state = qpp::applyCTRL(state, toQppMatrix(matrix), controls, {qubitIdx});
+    }
+  }
+
+  /// @brief Apply the diagonal gate diag(`d0`, `d1`) to the target qubit.
+  void applyOneQubitDiagonal(const std::complex<double> d0,
+                             const std::complex<double> d1,
+                             const std::vector<std::size_t> &controls,
+                             const std::size_t qubitIdx) {
+    if constexpr (isStateVector) {
+      const Amplitude e0(d0), e1(d1);
+      if (d0 == 1.0)
+        applyOneQubitKernel(controls, qubitIdx,
+                            [=](Amplitude &, Amplitude &a1) { a1 *= e1; });
+      else
+        applyOneQubitKernel(controls, qubitIdx,
+                            [=](Amplitude &a0, Amplitude &a1) {
+                              a0 *= e0;
+                              a1 *= e1;
+                            });
+    } else {
+      applyOneQubitMatrix({d0, 0.0, 0.0, d1}, controls, qubitIdx);
+    }
+  }
+
+  /// @brief Apply the given fixed gate to the state. State vectors use a
+  /// specialized in-place kernel for the common gates and the general 2x2
+  /// kernel otherwise.
+  template <typename GateT>
+  void applyFixedGate(GateT &gate, const std::vector<std::size_t> &controls,
+                      const std::size_t qubitIdx) {
+    using complex = Amplitude;
+    if constexpr (isStateVector) {
+      if constexpr (std::is_same_v<GateT, nvqir::x<double>>) {
+        applyOneQubitKernel(controls, qubitIdx, [](complex &a0, complex &a1) {
+          std::swap(a0, a1);
+        });
+        return;
+      } else if constexpr (std::is_same_v<GateT, nvqir::y<double>>) {
+        // Y |0> = i|1>, Y |1> = -i|0>
+        applyOneQubitKernel(controls, qubitIdx, [](complex &a0, complex &a1) {
+          const complex tmp = a0;
+          a0 = complex(a1.imag(), -a1.real());
+          a1 = complex(-tmp.imag(), tmp.real());
+        });
+        return;
+      } else if constexpr (std::is_same_v<GateT, nvqir::z<double>>) {
+        applyOneQubitKernel(controls, qubitIdx,
+                            [](complex &, complex &a1) { a1 = -a1; });
+        return;
+      } else if constexpr (std::is_same_v<GateT, nvqir::h<double>>) {
+        const typename complex::value_type oneOverSqrt2 = 1. / std::sqrt(2.);
+        applyOneQubitKernel(controls, qubitIdx, [=](complex &a0, complex &a1) {
+          const complex tmp = a0;
+          a0 = oneOverSqrt2 * (tmp + a1);
+          a1 = oneOverSqrt2 * (tmp - a1);
+        });
+        return;
+      } else if constexpr (std::is_same_v<GateT, nvqir::s<double>>) {
+        applyOneQubitKernel(controls, qubitIdx, [](complex &, complex &a1) {
+          a1 = complex(-a1.imag(), a1.real());
+        });
+        return;
+      } else if constexpr (std::is_same_v<GateT, nvqir::sdg<double>>) {
+        applyOneQubitKernel(controls, qubitIdx, [](complex &, complex &a1) {
+          a1 = complex(a1.imag(), -a1.real());
+        });
+        return;
+      }
+    }
+
+    constexpr auto matrix = GateT::getMatrix();
+    if constexpr (std::is_same_v<GateT, nvqir::t<double>> ||
+                  std::is_same_v<GateT, nvqir::tdg<double>>)
+      applyOneQubitDiagonal(matrix[0], matrix[3], controls, qubitIdx);
+    else
+      applyOneQubitMatrix(matrix, controls, qubitIdx);
+  }
+
+  /// @brief Apply the given rotation gate to the state. Diagonal rotations
+  /// only rescale amplitudes, so they take the diagonal kernel.
+  template <typename RotationGateT>
+  void applyRotationGate(RotationGateT &gate, const double angle,
+                         const std::vector<std::size_t> &controls,
+                         const std::size_t qubitIdx) {
+    if constexpr (std::is_same_v<RotationGateT, nvqir::rz<double>>) {
+      applyOneQubitDiagonal(std::exp(-nvqir::im<> * angle / 2.),
+                            std::exp(nvqir::im<> * angle / 2.), controls,
+                            qubitIdx);
+    } else if constexpr (std::is_same_v<RotationGateT, nvqir::r1<double>> ||
+                         std::is_same_v<RotationGateT, nvqir::u1<double>>) {
+      applyOneQubitDiagonal(1.0, std::exp(nvqir::im<> * angle), controls,
+                            qubitIdx);
+    } else {
+      applyOneQubitMatrix(gate.getMatrix(angle), controls, qubitIdx);
+    }
   }
 
   /// @brief Utility function for applying one-target-qubit operations with
@@ -93,11 +423,17 @@ protected:
   void oneQubitApply(const std::vector<std::size_t> &controls,
                      const std::size_t qubitIdx) {
     GateT gate;
-    cudaq::info(gateToString(gate.name(), controls, {}, {qubitIdx}));
-    auto matrix = toQppMatrix(gate.getGate());
-    state = qpp::applyCTRL(state, matrix, controls, {qubitIdx});
+    CUDAQ_INFO(gateToString(gate.name(), controls, {}, {qubitIdx}));
+    if (skipPrefixGate(gate.name(), {}, controls, {qubitIdx}))
+      return;
+    if (isGateFusionEnabled() && fuseGate(gate.getGate(), controls, {qubitIdx}))
+      return;
     std::vector<std::size_t> noiseQubits{controls.begin(), controls.end()};
     noiseQubits.push_back(qubitIdx);
+    if (hasNoisyGates &&
+        applyNoisyGate(gate.name(), 0.0, gate.getGate(), noiseQubits))
+      return;
+    applyFixedGate(gate, controls, qubitIdx);
     applyNoiseChannel(gate.name(), noiseQubits);
   }
 
@@ -111,29 +447,88 @@ protected:
                              const std::vector<std::size_t> &controls,
                              const std::size_t qubitIdx) {
     RotationGateT gate;
-    cudaq::info(gateToString(gate.name(), controls, {angle}, {qubitIdx}));
-    auto matrix = toQppMatrix(gate.getGate(angle));
-    state = qpp::applyCTRL(state, matrix, controls, {qubitIdx});
+    CUDAQ_INFO(gateToString(gate.name(), controls, {angle}, {qubitIdx}));
+    if (skipPrefixGate(gate.name(), {angle}, controls, {qubitIdx}))
+      return;
+    if (isGateFusionEnabled() &&
+        fuseGate(gate.getGate(angle), controls, {qubitIdx}))
+      return;
     std::vector<std::size_t> noiseQubits{controls.begin(), controls.end()};
     noiseQubits.push_back(qubitIdx);
+    if (hasNoisyGates &&
+        applyNoisyGate(gate.name(), angle, gate.getGate(angle), noiseQubits))
+      return;
+    applyRotationGate(gate, angle, controls, qubitIdx);
     applyNoiseChannel(gate.name(), noiseQubits);
   }
 
-  /// @brief Grow the state vector by one qubit.
-  void addQubitToState() override {
-    // Update the state vector
-    if (state.size() == 0) {
-      // If this is the first time, allocate the state
-      state = qpp::ket::Zero(stateDimension);
-      state(0) = 1.0;
+  /// @brief Grow the state by `count` qubits in the |0> state with a single
+  /// allocation. The new qubits become the least significant bits of the Q++
+  /// (big endian) amplitude index, equivalent to `count` repeated
+  /// qpp::kron(state, |0>) products. Every amplitude is first written by the
+  /// OpenMP threads, in the static schedule of the gate loops, so that its
+  /// memory page is allocated on the NUMA node of the thread using it, unless
+  /// cudaq::adviseLargeBuffer places the pages otherwise.
+  void growState(const std::size_t count) {
+    if (count == 0)
+      return;
+    const Eigen::Index oldDim = state.size() == 0 ? 1 : state.rows();
+    const Eigen::Index newDim = oldDim << count;
+    const Eigen::Index lowMask = (Eigen::Index(1) << count) - 1;
+    // The state before the first allocation is the scalar 1.
+    const bool empty = state.size() == 0;
+    auto old = [&](Eigen::Index i, Eigen::Index j) -> Amplitude {
+      return empty ? Amplitude(1.0) : state(i, j);
+    };
+    StateType grown;
+    if constexpr (isStateVector) {
+      grown = StateType(newDim);
+      cudaq::adviseLargeBuffer(grown.data(), newDim * sizeof(Amplitude));
+#pragma omp parallel for schedule(static)                                     \
+    if (std::size_t(newDim) >= minParallelDimension)
+      for (Eigen::Index i = 0; i < newDim; i++)
+        grown(i) = (i & lowMask) ? Amplitude(0.0) : old(i >> count, 0);
+    } else {
+      grown = qpp::cmat(newDim, newDim);
+      cudaq::adviseLargeBuffer(grown.data(),
+                               newDim * newDim * sizeof(Amplitude));
+#pragma omp parallel for schedule(static)                                     \
+    if (std::size_t(newDim * newDim) >= minParallelDimension)
+      for (Eigen::Index j = 0; j < newDim; j++)
+        for (Eigen::Index i = 0; i < newDim; i++)
+          grown(i, j) = ((i | j) & lowMask) ? Amplitude(0.0)
+                                            : old(i >> count, j >> count);
+    }
+    state = std::move(grown);
+  }
+
+  /// @brief Grow the state by one qubit.
+  void addQubitToState() override { growState(1); }
+
+  /// @brief Trace out the last qubit of the state, which is in |0>, by
+  /// keeping the amplitudes with its (least significant) bit clear.
+  bool removeQubitFromState(const std::size_t qubitIdx) override {
+    if (nStateQubits() < 2 || qubitIdx + 1 != nStateQubits())
+      return false;
+
+    const Eigen::Index newDim = state.rows() / 2;
+    StateType shrunk;
+    if constexpr (isStateVector) {
+      shrunk = StateType(newDim);
+#pragma omp parallel for if (std::size_t(newDim) >= minParallelDimension)
+      for (Eigen::Index i = 0; i < newDim; i++)
+        shrunk(i) = state(2 * i);
     } else {
-      // If we are resizing an existing, allocate
-      // a zero state on a single qubit, and Kron-prod
-      // that with the existing state.
-      qpp::ket zero_state = qpp::ket::Zero(2);
-      zero_state(0) = 1.0;
-      state = qpp::kron(state, zero_state);
+      shrunk = qpp::cmat(newDim, newDim);
+#pragma omp parallel for if (std::size_t(newDim * newDim) >=                  \
+                                 minParallelDimension)
+      for (Eigen::Index j = 0; j < newDim; j++)
+        for (Eigen::Index i = 0; i < newDim; i++)
+          shrunk(i, j) = state(2 * i, 2 * j);
     }
+    state = std::move(shrunk);
+    stateDimension = newDim;
+    return true;
   }
 
   /// @brief Reset the qubit state.
@@ -142,10 +537,383 @@ protected:
     state = tmp;
   }
 
+  bool canSnapshotState() override { return true; }
+
+  bool saveStateSnapshot() override {
+    prefixSnapshot = state;
+    return true;
+  }
+
+  bool restoreStateSnapshot() override {
+    if (prefixSnapshot.rows() != state.rows() ||
+        prefixSnapshot.cols() != state.cols())
+      return false;
+    state = prefixSnapshot;
+    return true;
+  }
+
+  void clearStateSnapshot() override { prefixSnapshot = StateType(); }
+
+  bool canRestoreState() override { return true; }
+
+  void setStateData(const std::complex<double> *data) override {
+    using HostType = Eigen::Matrix<std::complex<double>,
+                                   StateType::RowsAtCompileTime,
+                                   StateType::ColsAtCompileTime>;
+    state = Eigen::Map<const HostType>(data, state.rows(), state.cols())
+                .template cast<Amplitude>();
+  }
+
+  std::size_t getStateBytes() override {
+    return state.size() * sizeof(Amplitude);
+  }
+
+  /// @brief State vectors compute adjoint gradients, with auxiliary state
+  /// vectors of the same precision.
+  bool canComputeAdjointGradient() override { return isStateVector; }
+
+  StateType &auxiliaryState(std::size_t slot) {
+    if (slot >= auxiliaryStates.size())
+      auxiliaryStates.resize(slot + 1);
+    return auxiliaryStates[slot];
+  }
+
+  void copyStateToAuxiliary(std::size_t slot,
+                            std::complex<double> coefficient) override {
+    auxiliaryState(slot) = Amplitude(coefficient) * state;
+  }
+
+  void addStateToAuxiliary(std::size_t slot,
+                           std::complex<double> coefficient) override {
+    auxiliaryState(slot) += Amplitude(coefficient) * state;
+  }
+
+  void copyAuxiliaryToState(std::size_t slot) override {
+    state = auxiliaryState(slot);
+  }
+
+  void swapStateWithAuxiliary(std::size_t slot) override {
+    state.swap(auxiliaryState(slot));
+  }
+
+  /// @brief Return <a|psi>, or Tr(a^dag rho) for density matrices.
+  std::complex<double> overlapWithAuxiliary(std::size_t slot) override {
+    if constexpr (isStateVector)
+      return std::complex<double>(auxiliaryState(slot).dot(state));
+    else
+      return auxiliaryState(slot).conjugate().cwiseProduct(state).sum();
+  }
+
+  void clearAuxiliaryStates() override { auxiliaryStates.clear(); }
+
+  bool canComputeOverlap() override { return true; }
+
+  /// @brief Sum the probabilities of the basis states into those of the
+  /// outcomes of the qubits, in one parallel pass over the state.
+  std::vector<double>
+  getMarginalProbabilities(const std::vector<std::size_t> &qubits) override {
+    synchronizeState();
+    const auto dim = static_cast<std::size_t>(state.rows());
+    const auto *data = state.data();
+    std::vector<std::size_t> masks;
+    for (auto q : qubits)
+      masks.push_back(qubitMask(q));
+    std::vector<double> probabilities(1ULL << qubits.size(), 0.0);
+    auto *sums = probabilities.data();
+    const auto nOutcomes = probabilities.size();
+    const bool parallel = dim >= minParallelDimension;
+#pragma omp parallel for reduction(+ : sums[:nOutcomes]) if (parallel)
+    for (std::size_t i = 0; i < dim; i++) {
+      std::size_t outcome = 0;
+      for (std::size_t j = 0; j < masks.size(); j++)
+        if (i & masks[j])
+          outcome |= 1ULL << j;
+      if constexpr (isStateVector)
+        sums[outcome] += std::norm(data[i]);
+      else
+        sums[outcome] += data[i * dim + i].real();
+    }
+    return probabilities;
+  }
+
+  /// @brief Compute the amplitude offsets of the 2^k local basis states of
+  /// the `targets` (bit `j` of the local index is `targets[j]`) and the
+  /// sorted target masks used to enumerate the target subspaces.
+  void localSubspace(const std::vector<std::size_t> &targets,
+                     std::vector<std::size_t> &offsets,
+                     std::vector<std::size_t> &sortedMasks) const {
+    const std::size_t dim = 1ULL << targets.size();
+    offsets.assign(dim, 0);
+    sortedMasks.clear();
+    for (std::size_t j = 0; j < targets.size(); j++) {
+      sortedMasks.push_back(qubitMask(targets[j]));
+      for (std::size_t l = 0; l < dim; l++)
+        if (l & (1ULL << j))
+          offsets[l] |= sortedMasks.back();
+    }
+    std::sort(sortedMasks.begin(), sortedMasks.end());
+  }
+
+  /// @brief Compute <psi| M |psi> in one sweep over the state vector.
+  double
+  expectationOfDenseMatrix(const std::vector<std::complex<double>> &matrix,
+                           const std::vector<std::size_t> &targets) override {
+    if constexpr (isStateVector) {
+      const std::size_t dim = 1ULL << targets.size();
+      std::vector<std::size_t> offsets, sortedMasks;
+      localSubspace(targets, offsets, sortedMasks);
+      const std::size_t nGroups =
+          static_cast<std::size_t>(state.rows()) >> targets.size();
+      const auto *data = state.data();
+      double result = 0.0;
+      const bool parallel = nGroups * dim >= minParallelDimension;
+#pragma omp parallel for reduction(+ : result) if (parallel)
+      for (std::size_t g = 0; g < nGroups; ++g) {
+        std::size_t base = g;
+        for (auto mask : sortedMasks)
+          base = insertZeroBit(base, mask);
+        for (std::size_t r = 0; r < dim; r++) {
+          std::complex<double> sum = 0.0;
+          for (std::size_t c = 0; c < dim; c++)
+            sum += matrix[r * dim + c] *
+                   std::complex<double>(data[base | offsets[c]]);
+          result +=
+              (std::conj(std::complex<double>(data[base | offsets[r]])) * sum)
+                  .real();
+        }
+      }
+      return result;
+    } else {
+      return CircuitSimulator::expectationOfDenseMatrix(matrix, targets);
+    }
+  }
+
+  /// @brief Apply the dense matrix. State vectors are updated in place in one
+  /// sweep, gathering the 2^k amplitudes of each target subspace (in double
+  /// precision), density matrices go through Q++.
+  void applyDenseMatrix(const std::vector<std::complex<double>> &matrix,
+                        const std::vector<std::size_t> &targets) override {
+    if constexpr (isStateVector) {
+      const std::size_t dim = 1ULL << targets.size();
+      std::vector<std::size_t> offsets, sortedMasks;
+      localSubspace(targets, offsets, sortedMasks);
+
+      const std::size_t nGroups =
+          static_cast<std::size_t>(state.rows()) >> targets.size();
+      auto *data = state.data();
+#pragma omp parallel if (nGroups * dim >= minParallelDimension)
+      {
+        std::vector<std::complex<double>> local(dim);
+#pragma omp for
+        for (std::size_t g = 0; g < nGroups; ++g) {
+          std::size_t base = g;
+          for (auto mask : sortedMasks)
+            base = insertZeroBit(base, mask);
+          for (std::size_t l = 0; l < dim; l++)
+            local[l] = data[base | offsets[l]];
+          for (std::size_t r = 0; r < dim; r++) {
+            std::complex<double> sum = 0.0;
+            for (std::size_t c = 0; c < dim; c++)
+              sum += matrix[r * dim + c] * local[c];
+            data[base | offsets[r]] = sum;
+          }
+        }
+      }
+    } else {
+      // Q++ takes the first target as the most significant bit.
+      const auto dim = static_cast<Eigen::Index>(1ULL << targets.size());
+      qpp::cmat qppMatrix =
+          Eigen::Map<const Eigen::Matrix<std::complex<double>, Eigen::Dynamic,
+                                         Eigen::Dynamic, Eigen::RowMajor>>(
+              matrix.data(), dim, dim);
+      state = qpp::apply(state, qppMatrix,
+                         std::vector<std::size_t>(targets.rbegin(),
+                                                  targets.rend()));
+    }
+  }
+
+  /// @brief Measure the qubit and collapse the state in place, in one pass
+  /// for the probability and one for the projection. Unlike qpp::measure, no
+  /// post-measurement state is allocated. A density matrix keeps the rows and
+  /// columns of the measured outcome.
+  bool measureQubitInPlace(const std::size_t qubitIdx) {
+    const std::size_t mask = qubitMask(qubitIdx);
+    const auto dim = static_cast<std::size_t>(state.rows());
+    auto *data = state.data();
+    double probOne = 0.0;
+    const bool parallel = dim >= minParallelDimension;
+#pragma omp parallel for reduction(+ : probOne) if (parallel)
+    for (std::size_t i = 0; i < dim; i++)
+      if (i & mask) {
+        if constexpr (isStateVector)
+          probOne += std::norm(data[i]);
+        else
+          probOne += data[i * dim + i].real();
+      }
+
+    std::uniform_real_distribution<double> distr(0.0, 1.0);
+    const bool result =
+        distr(qpp::RandomDevices::get_instance().get_prng()) < probOne;
+    const double probResult = result ? probOne : 1.0 - probOne;
+    if constexpr (isStateVector) {
+      const auto scale = static_cast<typename Amplitude::value_type>(
+          1.0 / std::sqrt(probResult));
+#pragma omp parallel for if (parallel)
+      for (std::size_t i = 0; i < dim; i++)
+        data[i] = static_cast<bool>(i & mask) == result ? data[i] * scale
+                                                        : Amplitude(0);
+    } else {
+      const auto scale = 1.0 / probResult;
+#pragma omp parallel for if (parallel)
+      for (std::size_t j = 0; j < dim; j++) {
+        const bool keepColumn = static_cast<bool>(j & mask) == result;
+        for (std::size_t i = 0; i < dim; i++)
+          data[j * dim + i] =
+              keepColumn && static_cast<bool>(i & mask) == result
+                  ? data[j * dim + i] * scale
+                  : Amplitude(0);
+      }
+    }
+    cudaq::info("Measured qubit {} -> {}", qubitIdx, result);
+    return result;
+  }
+
+  /// @brief Sample the given qubits from the probabilities of the state
+  /// without Q++. A first pass sums the probability of each chunk of basis
+  /// states, along with the <Z...Z> expectation value. A second one walks
+  /// each chunk once against its share of the sorted uniform random numbers.
+  /// Both passes run in parallel over the chunks. Outcomes are counted as
+  /// packed integers, bit j holding measuredBits[j], and only converted to
+  /// bit strings once per distinct outcome.
+  cudaq::ExecutionResult
+  sampleState(const std::vector<std::size_t> &measuredBits, const int shots) {
+    const auto dim = static_cast<std::size_t>(state.rows());
+    const auto *data = state.data();
+    auto probability = [&](std::size_t i) -> double {
+      if constexpr (isStateVector)
+        return std::norm(data[i]);
+      else
+        return data[i * dim + i].real();
+    };
+
+    const std::size_t nChunks =
+        std::clamp<std::size_t>(dim / minParallelDimension, 1, 1024);
+    const std::size_t chunkSize = (dim + nChunks - 1) / nChunks;
+    const auto parityMask = qubitsMask(measuredBits);
+    std::vector<double> cumulativeMass(nChunks + 1, 0.0);
+    double expectationValue = 0.0;
+#pragma omp parallel for reduction(+ : expectationValue) if (nChunks > 1)
+    for (std::size_t c = 0; c < nChunks; c++) {
+      double mass = 0.0;
+      const auto end = std::min(dim, (c + 1) * chunkSize);
+      for (std::size_t i = c * chunkSize; i < end; i++) {
+        const auto p = probability(i);
+        mass += p;
+        expectationValue += paritySign(i, parityMask) * p;
+      }
+      cumulativeMass[c + 1] = mass;
+    }
+    std::partial_sum(cumulativeMass.begin(), cumulativeMass.end(),
+                     cumulativeMass.begin());
+
+    std::uniform_real_distribution<double> distr(0.0, cumulativeMass.back());
+    auto &gen = qpp::RandomDevices::get_instance().get_prng();
+    std::vector<double> randoms(shots);
+    for (auto &r : randoms)
+      r = distr(gen);
+    std::sort(randoms.begin(), randoms.end());
+
+    std::vector<std::size_t> masks;
+    for (auto q : measuredBits)
+      masks.push_back(qubitMask(q));
+    std::vector<std::unordered_map<std::size_t, std::size_t>> chunkCounts(
+        nChunks);
+#pragma omp parallel for schedule(dynamic) if (nChunks > 1)
+    for (std::size_t c = 0; c < nChunks; c++) {
+      auto first = std::lower_bound(randoms.begin(), randoms.end(),
+                                    cumulativeMass[c]);
+      auto last = c + 1 == nChunks
+                      ? randoms.end()
+                      : std::lower_bound(first, randoms.end(),
+                                         cumulativeMass[c + 1]);
+      const auto begin = c * chunkSize;
+      const auto end = std::min(dim, begin + chunkSize);
+      double cumulative = cumulativeMass[c];
+      std::size_t i = begin;
+      for (auto r = first; r != last; ++r) {
+        while (i + 1 < end && cumulative + probability(i) <= *r)
+          cumulative += probability(i++);
+        // Rounding can leave us on a zero probability at the end.
+        std::size_t index = i;
+        while (index > begin && probability(index) == 0.0)
+          index--;
+        std::size_t outcome = 0;
+        for (std::size_t j = 0; j < masks.size(); j++)
+          if (index & masks[j])
+            outcome |= 1ULL << j;
+        chunkCounts[c][outcome]++;
+      }
+    }
+
+    std::unordered_map<std::size_t, std::size_t> counts;
+    for (auto &chunk : chunkCounts)
+      for (auto [outcome, count] : chunk)
+        counts[outcome] += count;
+
+    // Bit j of an outcome is measured qubit j, as in the packed counts.
+    cudaq::ExecutionResult result(expectationValue);
+    for (auto [outcome, count] : counts) {
+      const std::uint64_t key = outcome;
+      result.appendResult(&key, measuredBits.size(), count);
+    }
+    return result;
+  }
+
 public:
-  QppCircuitSimulator() = default;
+  QppCircuitSimulator() {
+    // Gate fusion composes gates ahead of time, which is only valid without
+    // noise channels between them, so only the state vector simulator opts in.
+    if constexpr (isStateVector)
+      enableGateFusion();
+  }
   virtual ~QppCircuitSimulator() = default;
 
+  /// @brief A state vector holds 2^n amplitudes, a density matrix 4^n.
+  std::size_t getRequiredStateBytes(std::size_t numQubits) override {
+    return stateVectorBytes(isStateVector ? numQubits : 2 * numQubits,
+                            sizeof(Amplitude));
+  }
+
+  void seedRandomEngines(std::uint64_t seed) override {
+    CircuitSimulator::seedRandomEngines(seed);
+    qpp::RandomDevices::get_instance().get_prng().seed(seed);
+  }
+
+  /// @brief Allocate `count` qubits, sizing the state once rather than
+  /// growing it one qubit at a time. Reused qubit ids of deallocated qubits
+  /// still in the state (in |0>) do not grow it.
+  std::vector<std::size_t> allocateQubits(const std::size_t count) override {
+    if (count == 0)
+      return {};
+
+    std::vector<std::size_t> qubits;
+    for (std::size_t i = 0; i < count; i++)
+      qubits.emplace_back(tracker.getNextIndex());
+
+    cudaq::info("Allocating {} new qubits (nQ={}, dim={})", count,
+                nQubitsAllocated, stateDimension);
+
+    nQubitsAllocated += count;
+    const auto required =
+        *std::max_element(qubits.begin(), qubits.end()) + 1;
+    const auto current = nStateQubits();
+    growState(required > current ? required - current : 0);
+    stateDimension = state.rows();
+    return qubits;
+  }
+
+  std::size_t allocateQubit() override { return allocateQubits(1)[0]; }
+
 /// The one-qubit overrides
 #define QPP_ONE_QUBIT_METHOD_OVERRIDE(NAME)                                    \
   using CircuitSimulator::NAME;                                                \
@@ -183,13 +951,16 @@ public:
   void u2(const double phi, const double lambda,
           const std::vector<std::size_t> &controls,
           const std::size_t qubitIdx) override {
-    cudaq::info(gateToString("u3", controls, {phi, lambda}, {qubitIdx}));
-    qpp::cmat matrix = qpp::cmat::Zero(2, 2);
-    matrix(0, 0) = 1.0;
-    matrix(0, 1) = -1.0 * std::exp(nvqir::im<> * lambda);
-    matrix(1, 0) = std::exp(nvqir::im<> * phi);
-    matrix(1, 1) = std::exp(nvqir::im<> * (phi + lambda));
-    state = qpp::applyCTRL(state, matrix, controls, {qubitIdx});
+    CUDAQ_INFO(gateToString("u3", controls, {phi, lambda}, {qubitIdx}));
+    const nvqir::GateMatrix<double> matrix{
+        1.0, -1.0 * std::exp(nvqir::im<> * lambda), std::exp(nvqir::im<> * phi),
+        std::exp(nvqir::im<> * (phi + lambda))};
+    if (skipPrefixGate("u2", {phi, lambda}, controls, {qubitIdx}))
+      return;
+    if (isGateFusionEnabled() &&
+        fuseGate({matrix.begin(), matrix.end()}, controls, {qubitIdx}))
+      return;
+    applyOneQubitMatrix(matrix, controls, qubitIdx);
     std::vector<std::size_t> noiseQubits{controls.begin(), controls.end()};
     noiseQubits.push_back(qubitIdx);
     applyNoiseChannel("u2", noiseQubits);
@@ -200,13 +971,14 @@ public:
   void u3(const double theta, const double phi, const double lambda,
           const std::vector<std::size_t> &controls,
           const std::size_t qubitIdx) override {
-    cudaq::info(gateToString("u3", controls, {theta, phi, lambda}, {qubitIdx}));
-    qpp::cmat matrix = qpp::cmat::Zero(2, 2);
-    matrix(0, 0) = std::cos(theta / 2);
-    matrix(0, 1) = std::exp(nvqir::im<> * phi) * std::sin(theta / 2);
-    matrix(1, 0) = -1. * std::exp(nvqir::im<> * lambda) * std::sin(theta / 2);
-    matrix(1, 1) = std::exp(nvqir::im<> * (phi + lambda)) * std::cos(theta / 2);
-    state = qpp::applyCTRL(state, matrix, controls, {qubitIdx});
+    CUDAQ_INFO(gateToString("u3", controls, {theta, phi, lambda}, {qubitIdx}));
+    const auto matrix = nvqir::u3<double>::getMatrix(theta, phi, lambda);
+    if (skipPrefixGate("u3", {theta, phi, lambda}, controls, {qubitIdx}))
+      return;
+    if (isGateFusionEnabled() &&
+        fuseGate({matrix.begin(), matrix.end()}, controls, {qubitIdx}))
+      return;
+    applyOneQubitMatrix(matrix, controls, qubitIdx);
     std::vector<std::size_t> noiseQubits{controls.begin(), controls.end()};
     noiseQubits.push_back(qubitIdx);
     applyNoiseChannel("u3", noiseQubits);
@@ -216,83 +988,339 @@ public:
   using CircuitSimulator::swap;
   void swap(const std::vector<std::size_t> &ctrlBits, const std::size_t srcIdx,
             const std::size_t tgtIdx) override {
-    cudaq::info(gateToString("swap", ctrlBits, {}, {srcIdx, tgtIdx}));
-    state = qpp::applyCTRL(state, qpp::Gates::get_instance().SWAP, ctrlBits,
-                           {srcIdx, tgtIdx});
+    CUDAQ_INFO(gateToString("swap", ctrlBits, {}, {srcIdx, tgtIdx}));
+    if (skipPrefixGate("swap", {}, ctrlBits, {srcIdx, tgtIdx}))
+      return;
+    if (isGateFusionEnabled() &&
+        fuseGate({1., 0., 0., 0., 0., 0., 1., 0., 0., 1., 0., 0., 0., 0., 0.,
+                  1.},
+                 ctrlBits, {srcIdx, tgtIdx}))
+      return;
+    if constexpr (isStateVector) {
+      // Exchange the |..1..0..> and |..0..1..> amplitudes in place.
+      const std::size_t srcMask = qubitMask(srcIdx);
+      const std::size_t tgtMask = qubitMask(tgtIdx);
+      const std::size_t controlMask = qubitsMask(ctrlBits);
+      const std::size_t lowMask = std::min(srcMask, tgtMask);
+      const std::size_t highMask = std::max(srcMask, tgtMask);
+      const std::size_t nQuads = static_cast<std::size_t>(state.rows()) >> 2;
+      auto *data = state.data();
+#pragma omp parallel for if (nQuads >= minParallelDimension)
+      for (std::size_t k = 0; k < nQuads; ++k) {
+        const std::size_t i00 =
+            insertZeroBit(insertZeroBit(k, lowMask), highMask);
+        if ((i00 & controlMask) != controlMask)
+          continue;
+        std::swap(data[i00 | srcMask], data[i00 | tgtMask]);
+      }
+    } else {
+      // rho -> P rho P, with P the exchange of the |..1..0..> and |..0..1..>
+      // basis states: swap their rows, then their columns.
+      const std::size_t srcMask = qubitMask(srcIdx);
+      const std::size_t tgtMask = qubitMask(tgtIdx);
+      const std::size_t controlMask = qubitsMask(ctrlBits) | srcMask;
+      const std::size_t dim = state.rows();
+      for (std::size_t i = 0; i < dim; i++)
+        if ((i & (controlMask | tgtMask)) == controlMask)
+          state.row(i).swap(state.row(i ^ srcMask ^ tgtMask));
+      for (std::size_t i = 0; i < dim; i++)
+        if ((i & (controlMask | tgtMask)) == controlMask)
+          state.col(i).swap(state.col(i ^ srcMask ^ tgtMask));
+    }
     std::vector<std::size_t> noiseQubits{ctrlBits.begin(), ctrlBits.end()};
     noiseQubits.push_back(srcIdx);
     noiseQubits.push_back(tgtIdx);
     applyNoiseChannel("swap", noiseQubits);
   }
 
+  bool canPermuteQubits() override { return true; }
+
+  /// @brief Permute the qubits in one out of place pass. Every run of
+  /// amplitudes that only differ in the bits of unmoved qubits below the
+  /// lowest moved one is copied as one block.
+  void applyQubitPermutation(
+      const std::vector<std::size_t> &qubits,
+      const std::vector<std::size_t> &permutation) override {
+    std::vector<std::pair<std::size_t, std::size_t>> moves;
+    std::size_t movedMask = 0;
+    for (std::size_t i = 0; i < qubits.size(); i++)
+      if (permutation[i] != i) {
+        moves.emplace_back(qubitMask(qubits[i]),
+                           qubitMask(qubits[permutation[i]]));
+        movedMask |= moves.back().first;
+      }
+    if (!movedMask)
+      return;
+    auto permuteIndex = [&](std::size_t index) {
+      std::size_t permuted = index & ~movedMask;
+      for (auto [from, to] : moves)
+        if (index & from)
+          permuted |= to;
+      return permuted;
+    };
+
+    // A density matrix has its rows and columns permuted.
+    const std::size_t dim = state.rows();
+    const std::size_t nColumns = state.cols();
+    const std::size_t blockSize = movedMask & -movedMask;
+    StateType permuted(state.rows(), state.cols());
+    const auto *in = state.data();
+    auto *out = permuted.data();
+#pragma omp parallel for collapse(2) if (dim * nColumns >= minParallelDimension)
+    for (std::size_t c = 0; c < nColumns; c++)
+      for (std::size_t r = 0; r < dim; r += blockSize) {
+        const std::size_t column = isStateVector ? 0 : permuteIndex(c);
+        std::copy_n(in + c * dim + r, blockSize,
+                    out + column * dim + permuteIndex(r));
+      }
+    state.swap(permuted);
+  }
+
+  bool canPrepareProductState() override { return isStateVector; }
+
+  /// @brief Write the product state in one pass. The targets are in |0>, so
+  /// in each group of amplitudes that only differ in the target bits, only
+  /// the base, with these bits clear, may be nonzero. Every other amplitude
+  /// of the group is the base times the product of the target amplitudes,
+  /// the bases (a 2^-k fraction of the state) are scaled last.
+  void applyProductState(const std::array<std::complex<double>, 2> &target,
+                         const std::vector<std::size_t> &qubits) override {
+    if constexpr (isStateVector) {
+      const std::size_t k = qubits.size();
+      std::vector<std::complex<double>> powers0(k + 1, 1.0);
+      std::vector<std::complex<double>> powers1(k + 1, 1.0);
+      for (std::size_t j = 1; j <= k; j++) {
+        powers0[j] = powers0[j - 1] * target[0];
+        powers1[j] = powers1[j - 1] * target[1];
+      }
+      // The factor of an amplitude with m of the targets in |1>.
+      std::vector<Amplitude> factors(k + 1);
+      for (std::size_t m = 0; m <= k; m++)
+        factors[m] = Amplitude(powers0[k - m] * powers1[m]);
+
+      const std::size_t targetMask = qubitsMask(qubits);
+      const std::size_t dim = state.rows();
+      auto *data = state.data();
+#pragma omp parallel for if (dim >= minParallelDimension)
+      for (std::size_t i = 0; i < dim; i++)
+        if (const std::size_t bits = i & targetMask)
+          data[i] = data[i & ~targetMask] * factors[std::popcount(bits)];
+
+      const std::size_t freeMask = (dim - 1) & ~targetMask;
+      auto baseIndex = [&](std::size_t r) {
+        std::size_t index = 0;
+        for (std::size_t m = freeMask; m; m &= m - 1, r >>= 1)
+          if (r & 1)
+            index |= m & -m;
+        return index;
+      };
+      const std::size_t nBases = dim >> k;
+#pragma omp parallel for if (nBases >= minParallelDimension)
+      for (std::size_t r = 0; r < nBases; r++)
+        data[baseIndex(r)] *= factors[0];
+    }
+  }
+
+  bool canInitializeState(const std::vector<std::size_t> &) override {
+    return isStateVector;
+  }
+
+  /// @brief Write the amplitudes in one pass. As for applyProductState(),
+  /// only the base of each group of amplitudes that differ in the target bits
+  /// may be nonzero, the group becomes the base times the given amplitudes.
+  /// When the targets are all the qubits of the state, this is a copy.
+  void
+  applyStateInitialization(const std::vector<std::size_t> &qubits,
+                           const std::complex<double> *amplitudes) override {
+    if constexpr (isStateVector) {
+      // The offset of each amplitude index in the state index.
+      const std::size_t k = qubits.size();
+      std::vector<std::size_t> offsets(1ULL << k, 0);
+      for (std::size_t j = 0; j < k; j++)
+        for (std::size_t m = 0; m < 1ULL << j; m++)
+          offsets[m | 1ULL << j] = offsets[m] | qubitMask(qubits[j]);
+
+      const std::size_t targetMask = qubitsMask(qubits);
+      const std::size_t dim = state.rows();
+      const std::size_t freeMask = (dim - 1) & ~targetMask;
+      auto baseIndex = [&](std::size_t r) {
+        std::size_t index = 0;
+        for (std::size_t m = freeMask; m; m &= m - 1, r >>= 1)
+          if (r & 1)
+            index |= m & -m;
+        return index;
+      };
+      auto *data = state.data();
+      const std::size_t nBases = dim >> k;
+#pragma omp parallel for if (nBases >= minParallelDimension)
+      for (std::size_t r = 0; r < nBases; r++) {
+        const std::size_t base = baseIndex(r);
+        const std::complex<double> scale = data[base];
+        if (scale == 0.0)
+          continue;
+        // Few large groups, e.g. a single one when the targets are all the
+        // qubits, are written in parallel themselves.
+#pragma omp parallel for if (nBases < minParallelDimension &&                 \
+                                 offsets.size() >= minParallelDimension)
+        for (std::size_t m = 0; m < offsets.size(); m++)
+          data[base | offsets[m]] = Amplitude(scale * amplitudes[m]);
+      }
+    }
+  }
+
   /// @brief Measure the qubit and return the result. Collapse the
   /// state vector.
   bool measureQubit(const std::size_t qubitIdx) override {
-    // If here, then we care about the result bit, so compute it.
-    const auto measurement_tuple =
-        qpp::measure(state, qpp::cmat::Identity(2, 2), {qubitIdx},
-                     /*qudit dimension=*/2, /*destructive measmt=*/false);
-    const auto measurement_result = std::get<qpp::RES>(measurement_tuple);
-    const auto &post_meas_states = std::get<qpp::ST>(measurement_tuple);
-    const auto &collapsed_state = post_meas_states[measurement_result];
-    if constexpr (std::is_same_v<StateType, qpp::ket>) {
-      state = Eigen::Map<const StateType>(collapsed_state.data(),
-                                          collapsed_state.size());
+    synchronizeState();
+    return measureQubitInPlace(qubitIdx);
+  }
+
+  /// @brief Measure the qubits jointly: draw one outcome from their marginal
+  /// probabilities, then project the state onto it in a single pass.
+  std::vector<bool>
+  measureQubits(const std::vector<std::size_t> &qubitIdxs) override {
+    if (qubitIdxs.size() < 2 || qubitIdxs.size() > maxJointMeasureQubits)
+      return CircuitSimulator::measureQubits(qubitIdxs);
+    const auto probabilities = getMarginalProbabilities(qubitIdxs);
+    std::uniform_real_distribution<double> distr(0.0, 1.0);
+    const std::size_t outcome = drawOutcome(
+        probabilities, distr(qpp::RandomDevices::get_instance().get_prng()));
+
+    std::vector<bool> bits(qubitIdxs.size());
+    std::string bitString(qubitIdxs.size(), '0');
+    std::size_t kept = 0;
+    for (std::size_t j = 0; j < qubitIdxs.size(); j++) {
+      bits[j] = (outcome >> j) & 1;
+      if (bits[j]) {
+        bitString[j] = '1';
+        kept |= qubitMask(qubitIdxs[j]);
+      }
+    }
+    const std::size_t mask = qubitsMask(qubitIdxs);
+    const auto dim = static_cast<std::size_t>(state.rows());
+    auto *data = state.data();
+    const double probResult = probabilities[outcome];
+    const bool parallel = dim >= minParallelDimension;
+    if constexpr (isStateVector) {
+      const auto scale = static_cast<typename Amplitude::value_type>(
+          1.0 / std::sqrt(probResult));
+#pragma omp parallel for if (parallel)
+      for (std::size_t i = 0; i < dim; i++)
+        data[i] = (i & mask) == kept ? data[i] * scale : Amplitude(0);
     } else {
-      state = Eigen::Map<const StateType>(collapsed_state.data(),
-                                          collapsed_state.rows(),
-                                          collapsed_state.cols());
+      const auto scale = 1.0 / probResult;
+#pragma omp parallel for if (parallel)
+      for (std::size_t j = 0; j < dim; j++) {
+        const bool keepColumn = (j & mask) == kept;
+        for (std::size_t i = 0; i < dim; i++)
+          data[j * dim + i] = keepColumn && (i & mask) == kept
+                                  ? data[j * dim + i] * scale
+                                  : Amplitude(0);
+      }
     }
-    cudaq::info("Measured qubit {} -> {}", qubitIdx, measurement_result);
-    return measurement_result == 1 ? true : false;
+    cudaq::info("Measured qubits {} -> {}", qubitIdxs, bitString);
+    return bits;
   }
 
   /// @brief Reset the qubit
   /// @param qubitIdx
   void resetQubit(const std::size_t qubitIdx) override {
-    state = qpp::reset(state, {qubitIdx});
+    synchronizeState();
+    if constexpr (isStateVector) {
+      // Collapse in place and flip |1> back to |0>, without the copies of
+      // qpp::reset.
+      if (measureQubitInPlace(qubitIdx))
+        applyOneQubitKernel({}, qubitIdx,
+                            [](Amplitude &a0, Amplitude &a1) {
+                              std::swap(a0, a1);
+                            });
+    } else if (measureQubitInPlace(qubitIdx)) {
+      // Only the |1><1| block of the qubit is left, move it to |0><0|.
+      const std::size_t mask = qubitMask(qubitIdx);
+      const auto dim = static_cast<std::size_t>(state.rows());
+      auto *data = state.data();
+#pragma omp parallel for if (dim >= minParallelDimension)
+      for (std::size_t j = 0; j < dim; j++) {
+        if (j & mask)
+          continue;
+        for (std::size_t i = 0; i < dim; i++) {
+          if (i & mask)
+            continue;
+          std::swap(data[j * dim + i], data[(j | mask) * dim + (i | mask)]);
+        }
+      }
+    }
   }
 
   /// @brief Sample the multi-qubit state.
   cudaq::ExecutionResult sample(const std::vector<std::size_t> &measuredBits,
                                 const int shots) override {
-    double expectationValue = calculateExpectationValue(measuredBits);
+    synchronizeState();
     if (shots < 1) {
+      double expectationValue = calculateExpectationValue(measuredBits);
       cudaq::info("Computed expectation value = {}", expectationValue);
       return cudaq::ExecutionResult{{}, expectationValue};
     }
 
-    auto sampleResult = qpp::sample(shots, state, measuredBits, 2);
-    // Convert to what we expect
-    std::stringstream bitstring;
-    cudaq::ExecutionResult counts(expectationValue);
-
-    for (auto [result, count] : sampleResult) {
-      // Push back each term in the vector of bits to the bitstring.
-      for (const auto &bit : result) {
-        bitstring << bit;
-      }
-
-      // Add to the sample result
-      // in mid-circ sampling mode this will append 1 bitstring
-      counts.appendResult(bitstring.str(), count);
-
-      // Reset the state.
-      bitstring.str("");
-      bitstring.clear();
-    }
+    return sampleState(measuredBits, shots);
+  }
 
-    return counts;
+  /// @brief Compute <psi| H |psi> without changing the state, see
+  /// groupExpectation().
+  cudaq::ExecutionResult observe(const cudaq::spin_op &H) override {
+    synchronizeState();
+    const auto nSpinQubits = H.n_qubits();
+    if (nSpinQubits > nQubitsAllocated)
+      throw std::runtime_error("Cannot observe a spin_op on " +
+                               std::to_string(nSpinQubits) + " qubits with " +
+                               std::to_string(nQubitsAllocated) +
+                               " qubits allocated.");
+    // One sweep per distinct X mask rather than per term, which for
+    // chemistry Hamiltonians is far fewer.
+    double expectation = 0.0;
+    const auto groups = groupByXMask(
+        H, [&](std::size_t q) { return qubitMask(q); }, expectation);
+    for (auto &group : groups)
+      expectation += groupExpectation(group);
+    cudaq::info("Computed expectation value = {} ({} terms in {} sweeps)",
+                expectation, H.n_terms(), groups.size());
+    return cudaq::ExecutionResult{{}, expectation};
   }
 
   cudaq::State getStateData() override {
+    synchronizeState();
     // There has to be at least one copy
     return cudaq::State{{stateDimension},
                         {state.data(), state.data() + state.size()}};
   }
 
+  /// @brief Return the shape of the state, (n) or (n, n).
+  std::vector<std::size_t> stateShape() const {
+    const std::size_t dim = state.rows();
+    if constexpr (isStateVector)
+      return {dim};
+    else
+      return {dim, dim};
+  }
+
+  std::unique_ptr<cudaq::SimulationState> getSimulationState() override {
+    synchronizeState();
+    return std::make_unique<cudaq::HostSimulationStateView<Amplitude>>(
+        stateShape(), state.data());
+  }
+
+  std::unique_ptr<cudaq::SimulationState> takeSimulationState() override {
+    synchronizeState();
+    auto shape = stateShape();
+    return std::make_unique<cudaq::HostSimulationState<StateType>>(
+        std::move(shape), std::move(state));
+  }
+
   /// @brief Primarily used for testing.
-  auto getStateVector() { return state; }
+  auto getStateVector() {
+    synchronizeState();
+    return state;
+  }
   std::string name() const override { return "qpp"; }
   NVQIR_SIMULATOR_CLONE_IMPL(QppCircuitSimulator<StateType>)
 };
@@ -0,0 +1,18 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#define __NVQIR_QPP_TOGGLE_CREATE
+#include "QppCircuitSimulator.cpp"
+/// Register this Simulator with NVQIR.
+template <>
+std::string nvqir::QppCircuitSimulator<nvqir::ket32>::name() const {
+  return "qpp-f32";
+}
+NVQIR_REGISTER_SIMULATOR(nvqir::QppCircuitSimulator<nvqir::ket32>, qpp_f32)
+
+#undef __NVQIR_QPP_TOGGLE_CREATE
@@ -18,6 +18,152 @@ namespace {
 class QppNoiseCircuitSimulator : public nvqir::QppCircuitSimulator<qpp::cmat> {
 
 protected:
+  /// @brief The noise of a gate on given qubits as superoperators.
+  struct NoiseSuperOperator {
+    /// @brief All the Kraus channels registered for the gate, composed into
+    /// a single superoperator.
+    std::vector<std::complex<double>> channels;
+
+    /// @brief The superoperators of the gate followed by its channels, keyed
+    /// by the gate angle, 0 for fixed gates. Built on first use.
+    mutable std::unordered_map<double, std::vector<std::complex<double>>>
+        withGate;
+  };
+
+  /// @brief The most angles a parameterized gate keeps fused superoperators
+  /// for. The cache is dropped once full, e.g. when an optimizer sweeps the
+  /// angle.
+  static constexpr std::size_t maxFusedAngles = 64;
+
+  /// @brief The superoperators of the noise model of the execution context,
+  /// one per gate and qubits, frozen when the context is set so that the
+  /// noise of a gate is looked up without allocating.
+  using SuperOperatorTable = cudaq::noise_table<NoiseSuperOperator>;
+  SuperOperatorTable superOperators;
+
+  /// @brief Return the superoperator of the channels of the gate on the
+  /// qubits, see cudaq::get_superoperator().
+  static std::vector<std::complex<double>>
+  buildSuperOperator(const std::string &gateName,
+                     const std::vector<std::size_t> &qubits,
+                     const std::vector<cudaq::kraus_channel> &krausChannels) {
+    cudaq::info("Freezing {} kraus channels for {} on qubits {}",
+                krausChannels.size(), gateName, qubits);
+    return cudaq::get_superoperator(krausChannels, qubits.size());
+  }
+
+  /// @brief Return the superoperator of the row major 2x2 gate, controlled by
+  /// all but the last of the `nQubits` qubits, followed by the channels of
+  /// the superoperator `channels`. The controlled gate U acts on the last
+  /// two basis states only, and S[(a,b),(c,e)] = sum_(k,l)
+  /// C[(a,b),(k,l)] U[k][c] conj(U[l][e]).
+  static std::vector<std::complex<double>>
+  composeWithGate(const std::vector<std::complex<double>> &channels,
+                  const std::vector<std::complex<double>> &gate,
+                  const std::size_t nQubits) {
+    const std::size_t dim = 1ULL << nQubits;
+    const std::size_t superDim = dim * dim;
+    std::vector<std::complex<double>> U(superDim, 0.0);
+    for (std::size_t i = 0; i < dim - 2; i++)
+      U[i * dim + i] = 1.0;
+    for (std::size_t i = 0; i < 2; i++)
+      for (std::size_t j = 0; j < 2; j++)
+        U[(dim - 2 + i) * dim + dim - 2 + j] = gate[i * 2 + j];
+
+    std::vector<std::complex<double>> superOp(superDim * superDim, 0.0);
+    for (std::size_t r = 0; r < superDim; r++)
+      for (std::size_t k = 0; k < dim; k++)
+        for (std::size_t l = 0; l < dim; l++) {
+          const auto coefficient = channels[r * superDim + k * dim + l];
+          if (coefficient == 0.0)
+            continue;
+          for (std::size_t c = 0; c < dim; c++)
+            for (std::size_t e = 0; e < dim; e++)
+              superOp[r * superDim + c * dim + e] +=
+                  coefficient * U[k * dim + c] * std::conj(U[l * dim + e]);
+        }
+    return superOp;
+  }
+
+  /// @brief Apply the gate and its channels as one superoperator, in a
+  /// single pass over the density matrix instead of one for the gate and
+  /// one for the channels.
+  bool applyNoisyGate(const std::string_view gateName, const double angle,
+                      const std::vector<std::complex<double>> &gate,
+                      const std::vector<std::size_t> &qubits) override {
+    const auto *noise = superOperators.find(gateName, qubits);
+    if (!noise || noise->channels.empty())
+      return false;
+
+    auto iter = noise->withGate.find(angle);
+    if (iter == noise->withGate.end()) {
+      if (noise->withGate.size() >= maxFusedAngles)
+        noise->withGate.clear();
+      iter = noise->withGate
+                 .emplace(angle, composeWithGate(noise->channels, gate,
+                                                 qubits.size()))
+                 .first;
+    }
+    cudaq::info("Applying {} and its noise channel to qubits {}", gateName,
+                qubits);
+    applySuperOperator(iter->second, qubits);
+    return true;
+  }
+
+  /// @brief Apply the superoperator to the density matrix in place. Each
+  /// (d x d) block of rho indexed by the channel qubits is gathered, mapped
+  /// through the superoperator and written back, so no 4^n temporaries are
+  /// allocated.
+  void applySuperOperator(const std::vector<std::complex<double>> &superOp,
+                          const std::vector<std::size_t> &qubits) {
+    // Q++ ordering, qubits[0] is the most significant bit of the local index.
+    const std::size_t nLocal = qubits.size();
+    const std::size_t dim = 1ULL << nLocal;
+    std::vector<std::size_t> offsets(dim, 0), sortedMasks;
+    for (std::size_t j = 0; j < nLocal; j++) {
+      sortedMasks.push_back(qubitMask(qubits[j]));
+      for (std::size_t l = 0; l < dim; l++)
+        if (l & (1ULL << (nLocal - 1 - j)))
+          offsets[l] |= sortedMasks.back();
+    }
+    std::sort(sortedMasks.begin(), sortedMasks.end());
+    const auto expand = [&](std::size_t k) {
+      for (auto mask : sortedMasks)
+        k = insertZeroBit(k, mask);
+      return k;
+    };
+
+    const std::size_t rows = static_cast<std::size_t>(state.rows());
+    const std::size_t nGroups = rows >> nLocal;
+    const std::size_t superDim = dim * dim;
+    auto *data = state.data();
+#pragma omp parallel if (rows * rows >= minParallelDimension)
+    {
+      std::vector<std::complex<double>> block(superDim);
+#pragma omp for
+      for (std::size_t gc = 0; gc < nGroups; gc++) {
+        const std::size_t colBase = expand(gc);
+        for (std::size_t gr = 0; gr < nGroups; gr++) {
+          const std::size_t rowBase = expand(gr);
+          // Column major storage, rho(i, j) = data[i + j * rows].
+          for (std::size_t a = 0; a < dim; a++)
+            for (std::size_t b = 0; b < dim; b++)
+              block[a * dim + b] =
+                  data[(rowBase | offsets[a]) + (colBase | offsets[b]) * rows];
+          for (std::size_t a = 0; a < dim; a++)
+            for (std::size_t b = 0; b < dim; b++) {
+              const auto *row = &superOp[(a * dim + b) * superDim];
+              std::complex<double> sum = 0.0;
+              for (std::size_t l = 0; l < superDim; l++)
+                sum += row[l] * block[l];
+              data[(rowBase | offsets[a]) + (colBase | offsets[b]) * rows] =
+                  sum;
+            }
+        }
+      }
+    }
+  }
+
   /// @brief If we have a noise model, apply any user-specified
   /// kraus_channels for the given gate name on the provided qubits.
   /// @param gateName
@@ -32,54 +178,38 @@ protected:
     if (!executionContext->noiseModel)
       return;
 
-    // Get the name as a string
-    std::string gName(gateName);
-
-    // Get the Kraus channels specified for this gate and qubits
-    auto krausChannels =
-        executionContext->noiseModel->get_channels(gName, qubits);
+    const auto *noise = superOperators.find(gateName, qubits);
 
     // If none, do nothing
-    if (krausChannels.empty())
+    if (!noise || noise->channels.empty())
       return;
 
-    cudaq::info("Applying {} kraus channels to qubits {}", krausChannels.size(),
+    cudaq::info("Applying noise channel for {} to qubits {}", gateName,
                 qubits);
-
-    for (auto &channel : krausChannels) {
-      // Map our kraus ops to the qpp::cmat
-      std::vector<qpp::cmat> K;
-      auto ops = channel.get_ops();
-      std::transform(
-          ops.begin(), ops.end(), std::back_inserter(K), [&](auto &el) {
-            return Eigen::Map<qpp::cmat>(el.data.data(), el.nRows, el.nCols);
-          });
-
-      // Apply K rho Kdag
-      state = qpp::apply(state, K, qubits);
-    }
-  }
-
-  /// @brief Grow the density matrix by one qubit.
-  void addQubitToState() override {
-    // Update the state vector
-    if (state.size() == 0) {
-      state = qpp::cmat::Zero(stateDimension, stateDimension);
-      state(0, 0) = 1.0;
-      return;
-    }
-
-    auto prevDim = 1UL << (nQubitsAllocated - 1);
-    state.conservativeResize(stateDimension, stateDimension);
-    for (std::size_t i = prevDim; i < stateDimension; i++) {
-      state.col(i).setZero();
-      state.row(i).setZero();
-    }
+    applySuperOperator(noise->channels, qubits);
   }
 
 public:
   QppNoiseCircuitSimulator() = default;
   virtual ~QppNoiseCircuitSimulator() = default;
+
+  /// @brief Set the execution context, freezing the superoperators of its
+  /// noise model, which may have changed since the last execution.
+  void setExecutionContext(cudaq::ExecutionContext *context) override {
+    superOperators = SuperOperatorTable();
+    if (context && context->noiseModel)
+      superOperators = SuperOperatorTable(
+          *context->noiseModel,
+          [](const std::string &gateName,
+             const std::vector<std::size_t> &qubits,
+             const std::vector<cudaq::kraus_channel> &krausChannels) {
+            return NoiseSuperOperator{
+                buildSuperOperator(gateName, qubits, krausChannels), {}};
+          });
+    hasNoisyGates = context && context->noiseModel &&
+                    context->noiseModel->has_channels();
+    QppCircuitSimulator<qpp::cmat>::setExecutionContext(context);
+  }
   std::string name() const override { return "dm"; }
 
   cudaq::State getStateData() override {
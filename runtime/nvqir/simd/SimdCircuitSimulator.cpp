@@ -0,0 +1,881 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CircuitSimulator.h"
+#include "Gates.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define NVQIR_SIMD_X86
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NVQIR_SIMD_NEON
+#endif
+
+namespace nvqir {
+namespace simd {
+
+/// @brief The state is stored as two 64 byte aligned arrays, one holding the
+/// real parts and one holding the imaginary parts of the amplitudes (SoA).
+/// This lets every gate kernel load full vector registers of real and
+/// imaginary components without any shuffling.
+class AlignedBuffer {
+  double *ptr = nullptr;
+  std::size_t count = 0;
+
+public:
+  static constexpr std::size_t alignment = 64;
+
+  AlignedBuffer() = default;
+  AlignedBuffer(const AlignedBuffer &) = delete;
+  AlignedBuffer &operator=(const AlignedBuffer &) = delete;
+  ~AlignedBuffer() { std::free(ptr); }
+
+  /// @brief Resize to `newCount` elements, keeping the existing elements and
+  /// zero filling the new ones. Buffers of huge pages are aligned to them.
+  void resize(std::size_t newCount) {
+    auto bytes = std::max(newCount * sizeof(double), alignment);
+    std::size_t align = alignment;
+    if (bytes >= cudaq::hugePageSize && cudaq::useHugePages()) {
+      align = cudaq::hugePageSize;
+      bytes = (bytes + align - 1) / align * align;
+    }
+    auto *newPtr = static_cast<double *>(std::aligned_alloc(align, bytes));
+    if (!newPtr)
+      throw std::bad_alloc();
+    cudaq::adviseLargeBuffer(newPtr, bytes);
+    const std::size_t kept = std::min(count, newCount);
+    if (kept)
+      std::memcpy(newPtr, ptr, kept * sizeof(double));
+    std::memset(newPtr + kept, 0, (newCount - kept) * sizeof(double));
+    std::free(ptr);
+    ptr = newPtr;
+    count = newCount;
+  }
+
+  void clear() {
+    std::free(ptr);
+    ptr = nullptr;
+    count = 0;
+  }
+
+  double *data() { return ptr; }
+  const double *data() const { return ptr; }
+  std::size_t size() const { return count; }
+};
+
+/// @brief A SimulationState referencing the real and imaginary parts of the
+/// state, valid until the next operation on the simulator.
+class SplitStateView : public cudaq::SimulationState {
+  std::size_t dimension;
+  const double *re;
+  const double *im;
+
+public:
+  SplitStateView(std::size_t dimension, const double *re, const double *im)
+      : dimension(dimension), re(re), im(im) {}
+
+  std::vector<std::size_t> getShape() const override { return {dimension}; }
+
+  std::complex<double> getElement(std::size_t idx) const override {
+    return {re[idx], im[idx]};
+  }
+
+  void copyElements(std::size_t first, std::size_t count,
+                    std::complex<double> *out) const override {
+    for (std::size_t i = 0; i < count; i++)
+      out[i] = {re[first + i], im[first + i]};
+  }
+};
+
+/// @brief A 2x2 row major gate matrix split into real and imaginary parts.
+struct SplitMatrix {
+  double re[4];
+  double im[4];
+  SplitMatrix(const nvqir::GateMatrix<double> &matrix) {
+    for (std::size_t i = 0; i < 4; i++) {
+      re[i] = matrix[i].real();
+      im[i] = matrix[i].imag();
+    }
+  }
+};
+
+/// @brief Apply the matrix to `len` contiguous amplitude pairs, where the
+/// first element of each pair lives at (re0, im0) and the second at
+/// (re1, im1).
+using MatrixKernel = void (*)(double *re0, double *im0, double *re1,
+                              double *im1, std::size_t len,
+                              const SplitMatrix &m);
+
+/// @brief Multiply `len` contiguous amplitudes by the phase dr + i di.
+using PhaseKernel = void (*)(double *re, double *im, std::size_t len,
+                             double dr, double di);
+
+static void applyMatrixScalar(double *__restrict re0, double *__restrict im0,
+                              double *__restrict re1, double *__restrict im1,
+                              std::size_t len, const SplitMatrix &m) {
+  for (std::size_t j = 0; j < len; j++) {
+    const double ar = re0[j], ai = im0[j], br = re1[j], bi = im1[j];
+    re0[j] = m.re[0] * ar - m.im[0] * ai + m.re[1] * br - m.im[1] * bi;
+    im0[j] = m.re[0] * ai + m.im[0] * ar + m.re[1] * bi + m.im[1] * br;
+    re1[j] = m.re[2] * ar - m.im[2] * ai + m.re[3] * br - m.im[3] * bi;
+    im1[j] = m.re[2] * ai + m.im[2] * ar + m.re[3] * bi + m.im[3] * br;
+  }
+}
+
+static void applyPhaseScalar(double *__restrict re, double *__restrict im,
+                             std::size_t len, double dr, double di) {
+  for (std::size_t j = 0; j < len; j++) {
+    const double ar = re[j], ai = im[j];
+    re[j] = dr * ar - di * ai;
+    im[j] = dr * ai + di * ar;
+  }
+}
+
+#ifdef NVQIR_SIMD_X86
+__attribute__((target("avx2,fma"))) static void
+applyMatrixAVX2(double *re0, double *im0, double *re1, double *im1,
+                std::size_t len, const SplitMatrix &m) {
+  const __m256d m0r = _mm256_set1_pd(m.re[0]), m0i = _mm256_set1_pd(m.im[0]);
+  const __m256d m1r = _mm256_set1_pd(m.re[1]), m1i = _mm256_set1_pd(m.im[1]);
+  const __m256d m2r = _mm256_set1_pd(m.re[2]), m2i = _mm256_set1_pd(m.im[2]);
+  const __m256d m3r = _mm256_set1_pd(m.re[3]), m3i = _mm256_set1_pd(m.im[3]);
+  std::size_t j = 0;
+  for (; j + 4 <= len; j += 4) {
+    const __m256d ar = _mm256_loadu_pd(re0 + j), ai = _mm256_loadu_pd(im0 + j);
+    const __m256d br = _mm256_loadu_pd(re1 + j), bi = _mm256_loadu_pd(im1 + j);
+    __m256d r = _mm256_mul_pd(m0r, ar);
+    r = _mm256_fnmadd_pd(m0i, ai, r);
+    r = _mm256_fmadd_pd(m1r, br, r);
+    r = _mm256_fnmadd_pd(m1i, bi, r);
+    __m256d i = _mm256_mul_pd(m0r, ai);
+    i = _mm256_fmadd_pd(m0i, ar, i);
+    i = _mm256_fmadd_pd(m1r, bi, i);
+    i = _mm256_fmadd_pd(m1i, br, i);
+    _mm256_storeu_pd(re0 + j, r);
+    _mm256_storeu_pd(im0 + j, i);
+    r = _mm256_mul_pd(m2r, ar);
+    r = _mm256_fnmadd_pd(m2i, ai, r);
+    r = _mm256_fmadd_pd(m3r, br, r);
+    r = _mm256_fnmadd_pd(m3i, bi, r);
+    i = _mm256_mul_pd(m2r, ai);
+    i = _mm256_fmadd_pd(m2i, ar, i);
+    i = _mm256_fmadd_pd(m3r, bi, i);
+    i = _mm256_fmadd_pd(m3i, br, i);
+    _mm256_storeu_pd(re1 + j, r);
+    _mm256_storeu_pd(im1 + j, i);
+  }
+  applyMatrixScalar(re0 + j, im0 + j, re1 + j, im1 + j, len - j, m);
+}
+
+__attribute__((target("avx2,fma"))) static void
+applyPhaseAVX2(double *re, double *im, std::size_t len, double dr, double di) {
+  const __m256d vr = _mm256_set1_pd(dr), vi = _mm256_set1_pd(di);
+  std::size_t j = 0;
+  for (; j + 4 <= len; j += 4) {
+    const __m256d ar = _mm256_loadu_pd(re + j), ai = _mm256_loadu_pd(im + j);
+    _mm256_storeu_pd(re + j, _mm256_fnmadd_pd(vi, ai, _mm256_mul_pd(vr, ar)));
+    _mm256_storeu_pd(im + j, _mm256_fmadd_pd(vi, ar, _mm256_mul_pd(vr, ai)));
+  }
+  applyPhaseScalar(re + j, im + j, len - j, dr, di);
+}
+
+__attribute__((target("avx512f"))) static void
+applyMatrixAVX512(double *re0, double *im0, double *re1, double *im1,
+                  std::size_t len, const SplitMatrix &m) {
+  const __m512d m0r = _mm512_set1_pd(m.re[0]), m0i = _mm512_set1_pd(m.im[0]);
+  const __m512d m1r = _mm512_set1_pd(m.re[1]), m1i = _mm512_set1_pd(m.im[1]);
+  const __m512d m2r = _mm512_set1_pd(m.re[2]), m2i = _mm512_set1_pd(m.im[2]);
+  const __m512d m3r = _mm512_set1_pd(m.re[3]), m3i = _mm512_set1_pd(m.im[3]);
+  std::size_t j = 0;
+  for (; j + 8 <= len; j += 8) {
+    const __m512d ar = _mm512_loadu_pd(re0 + j), ai = _mm512_loadu_pd(im0 + j);
+    const __m512d br = _mm512_loadu_pd(re1 + j), bi = _mm512_loadu_pd(im1 + j);
+    __m512d r = _mm512_mul_pd(m0r, ar);
+    r = _mm512_fnmadd_pd(m0i, ai, r);
+    r = _mm512_fmadd_pd(m1r, br, r);
+    r = _mm512_fnmadd_pd(m1i, bi, r);
+    __m512d i = _mm512_mul_pd(m0r, ai);
+    i = _mm512_fmadd_pd(m0i, ar, i);
+    i = _mm512_fmadd_pd(m1r, bi, i);
+    i = _mm512_fmadd_pd(m1i, br, i);
+    _mm512_storeu_pd(re0 + j, r);
+    _mm512_storeu_pd(im0 + j, i);
+    r = _mm512_mul_pd(m2r, ar);
+    r = _mm512_fnmadd_pd(m2i, ai, r);
+    r = _mm512_fmadd_pd(m3r, br, r);
+    r = _mm512_fnmadd_pd(m3i, bi, r);
+    i = _mm512_mul_pd(m2r, ai);
+    i = _mm512_fmadd_pd(m2i, ar, i);
+    i = _mm512_fmadd_pd(m3r, bi, i);
+    i = _mm512_fmadd_pd(m3i, br, i);
+    _mm512_storeu_pd(re1 + j, r);
+    _mm512_storeu_pd(im1 + j, i);
+  }
+  applyMatrixScalar(re0 + j, im0 + j, re1 + j, im1 + j, len - j, m);
+}
+
+__attribute__((target("avx512f"))) static void
+applyPhaseAVX512(double *re, double *im, std::size_t len, double dr,
+                 double di) {
+  const __m512d vr = _mm512_set1_pd(dr), vi = _mm512_set1_pd(di);
+  std::size_t j = 0;
+  for (; j + 8 <= len; j += 8) {
+    const __m512d ar = _mm512_loadu_pd(re + j), ai = _mm512_loadu_pd(im + j);
+    _mm512_storeu_pd(re + j, _mm512_fnmadd_pd(vi, ai, _mm512_mul_pd(vr, ar)));
+    _mm512_storeu_pd(im + j, _mm512_fmadd_pd(vi, ar, _mm512_mul_pd(vr, ai)));
+  }
+  applyPhaseScalar(re + j, im + j, len - j, dr, di);
+}
+#endif
+
+#ifdef NVQIR_SIMD_NEON
+static void applyMatrixNEON(double *re0, double *im0, double *re1, double *im1,
+                            std::size_t len, const SplitMatrix &m) {
+  const float64x2_t m0r = vdupq_n_f64(m.re[0]), m0i = vdupq_n_f64(m.im[0]);
+  const float64x2_t m1r = vdupq_n_f64(m.re[1]), m1i = vdupq_n_f64(m.im[1]);
+  const float64x2_t m2r = vdupq_n_f64(m.re[2]), m2i = vdupq_n_f64(m.im[2]);
+  const float64x2_t m3r = vdupq_n_f64(m.re[3]), m3i = vdupq_n_f64(m.im[3]);
+  std::size_t j = 0;
+  for (; j + 2 <= len; j += 2) {
+    const float64x2_t ar = vld1q_f64(re0 + j), ai = vld1q_f64(im0 + j);
+    const float64x2_t br = vld1q_f64(re1 + j), bi = vld1q_f64(im1 + j);
+    float64x2_t r = vmulq_f64(m0r, ar);
+    r = vfmsq_f64(r, m0i, ai);
+    r = vfmaq_f64(r, m1r, br);
+    r = vfmsq_f64(r, m1i, bi);
+    float64x2_t i = vmulq_f64(m0r, ai);
+    i = vfmaq_f64(i, m0i, ar);
+    i = vfmaq_f64(i, m1r, bi);
+    i = vfmaq_f64(i, m1i, br);
+    vst1q_f64(re0 + j, r);
+    vst1q_f64(im0 + j, i);
+    r = vmulq_f64(m2r, ar);
+    r = vfmsq_f64(r, m2i, ai);
+    r = vfmaq_f64(r, m3r, br);
+    r = vfmsq_f64(r, m3i, bi);
+    i = vmulq_f64(m2r, ai);
+    i = vfmaq_f64(i, m2i, ar);
+    i = vfmaq_f64(i, m3r, bi);
+    i = vfmaq_f64(i, m3i, br);
+    vst1q_f64(re1 + j, r);
+    vst1q_f64(im1 + j, i);
+  }
+  applyMatrixScalar(re0 + j, im0 + j, re1 + j, im1 + j, len - j, m);
+}
+
+static void applyPhaseNEON(double *re, double *im, std::size_t len, double dr,
+                           double di) {
+  const float64x2_t vr = vdupq_n_f64(dr), vi = vdupq_n_f64(di);
+  std::size_t j = 0;
+  for (; j + 2 <= len; j += 2) {
+    const float64x2_t ar = vld1q_f64(re + j), ai = vld1q_f64(im + j);
+    vst1q_f64(re + j, vfmsq_f64(vmulq_f64(vr, ar), vi, ai));
+    vst1q_f64(im + j, vfmaq_f64(vmulq_f64(vr, ai), vi, ar));
+  }
+  applyPhaseScalar(re + j, im + j, len - j, dr, di);
+}
+#endif
+
+/// @brief The set of gate kernels for one instruction set.
+struct KernelTable {
+  std::string isa;
+  /// Number of doubles per vector register, spans shorter than this are
+  /// processed by the scalar kernels.
+  std::size_t width;
+  MatrixKernel applyMatrix;
+  PhaseKernel applyPhase;
+};
+
+/// @brief Return the kernels for the widest instruction set supported by the
+/// host CPU. The CUDAQ_SIMD_ISA environment variable (scalar, avx2, avx512 or
+/// neon) can request a narrower instruction set.
+static KernelTable selectKernels() {
+  std::vector<KernelTable> available{
+      {"scalar", 1, applyMatrixScalar, applyPhaseScalar}};
+#ifdef NVQIR_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    available.push_back({"avx2", 4, applyMatrixAVX2, applyPhaseAVX2});
+  if (__builtin_cpu_supports("avx512f"))
+    available.push_back({"avx512", 8, applyMatrixAVX512, applyPhaseAVX512});
+#endif
+#ifdef NVQIR_SIMD_NEON
+  available.push_back({"neon", 2, applyMatrixNEON, applyPhaseNEON});
+#endif
+
+  if (auto *requested = std::getenv("CUDAQ_SIMD_ISA")) {
+    for (auto &table : available)
+      if (table.isa == requested)
+        return table;
+    cudaq::info("Requested SIMD instruction set {} is not available on this "
+                "CPU, using {}.",
+                requested, available.back().isa);
+  }
+  return available.back();
+}
+
+} // namespace simd
+
+/// @brief The SimdCircuitSimulator is a CPU state vector simulator that
+/// stores the amplitudes as split real / imaginary arrays and applies gates
+/// with explicitly vectorized kernels (AVX2, AVX-512 or NEON), selected at
+/// runtime for the host CPU. Qubit `i` is bit `i` of the amplitude index.
+class SimdCircuitSimulator : public nvqir::CircuitSimulator {
+protected:
+  /// @brief Real parts of the amplitudes.
+  simd::AlignedBuffer real;
+
+  /// @brief Imaginary parts of the amplitudes.
+  simd::AlignedBuffer imag;
+
+  /// @brief The number of amplitudes in the buffers. This can be larger than
+  /// stateDimension, since deallocated qubits are reset but not removed.
+  std::size_t bufferDimension = 0;
+
+  /// @brief Copy of the amplitudes at the end of a cached conditional prefix.
+  simd::AlignedBuffer snapshotReal, snapshotImag;
+
+  /// @brief The gate kernels for the host instruction set.
+  simd::KernelTable kernels;
+
+  /// @brief Random number generator for measurement and sampling.
+  std::mt19937 randomEngine;
+
+  /// @brief States with fewer amplitudes than this are updated on a single
+  /// thread, the OpenMP fork / join overhead dominates below this size.
+  static constexpr std::size_t minParallelDimension = 1ULL << 14;
+
+  /// @brief The largest span handed to a kernel in one call, this bounds the
+  /// work of a single OpenMP iteration.
+  static constexpr std::size_t maxSpanLength = 1ULL << 12;
+
+  /// @brief The qubits a gate acts on (controls and targets), stored as their
+  /// single-bit masks in ascending order.
+  struct FixedQubits {
+    std::array<std::size_t, 64> masks;
+    std::size_t count = 0;
+    std::size_t controlMask = 0;
+
+    void add(std::size_t mask) {
+      auto *pos = std::lower_bound(masks.begin(), masks.begin() + count, mask);
+      std::move_backward(pos, masks.begin() + count,
+                         masks.begin() + count + 1);
+      *pos = mask;
+      count++;
+    }
+
+    /// @brief Insert a zero bit into `k` at each fixed qubit position.
+    std::size_t expand(std::size_t k) const {
+      for (std::size_t i = 0; i < count; i++) {
+        const std::size_t low = masks[i] - 1;
+        k = ((k & ~low) << 1) | (k & low);
+      }
+      return k;
+    }
+  };
+
+  FixedQubits fixedQubits(const std::vector<std::size_t> &controls,
+                          std::initializer_list<std::size_t> targets) const {
+    FixedQubits fixed;
+    for (auto c : controls) {
+      fixed.add(1ULL << c);
+      fixed.controlMask |= 1ULL << c;
+    }
+    for (auto t : targets)
+      fixed.add(1ULL << t);
+    return fixed;
+  }
+
+  /// @brief Invoke `spanFn(base, len)` for all contiguous spans of amplitude
+  /// indices whose control bits are set and whose target bits are zero.
+  /// Every span is `len` consecutive indices starting at `base`.
+  template <typename SpanFnT>
+  void forEachSpan(const FixedQubits &fixed, SpanFnT &&spanFn) {
+    const std::size_t nFree = bufferDimension >> fixed.count;
+    const std::size_t len =
+        std::min({fixed.masks[0], nFree, maxSpanLength});
+    const std::size_t nSpans = nFree / len;
+#pragma omp parallel for if (nFree >= minParallelDimension)
+    for (std::size_t s = 0; s < nSpans; s++)
+      spanFn(fixed.expand(s * len) | fixed.controlMask, len);
+  }
+
+  /// @brief Apply the general 2x2 matrix to the target qubit.
+  void applyMatrix(const nvqir::GateMatrix<double> &matrix,
+                   const std::vector<std::size_t> &controls,
+                   const std::size_t qubitIdx) {
+    const simd::SplitMatrix m(matrix);
+    const std::size_t targetMask = 1ULL << qubitIdx;
+    auto *re = real.data();
+    auto *im = imag.data();
+    forEachSpan(fixedQubits(controls, {qubitIdx}),
+                [&](std::size_t base, std::size_t len) {
+                  auto kernel = len >= kernels.width
+                                    ? kernels.applyMatrix
+                                    : simd::applyMatrixScalar;
+                  kernel(re + base, im + base, re + (base | targetMask),
+                         im + (base | targetMask), len, m);
+                });
+  }
+
+  /// @brief Apply the diagonal gate diag(d0, d1) to the target qubit.
+  void applyDiagonal(const std::complex<double> d0,
+                     const std::complex<double> d1,
+                     const std::vector<std::size_t> &controls,
+                     const std::size_t qubitIdx) {
+    const std::size_t targetMask = 1ULL << qubitIdx;
+    auto *re = real.data();
+    auto *im = imag.data();
+    const bool scaleZero = d0 != 1.0;
+    forEachSpan(fixedQubits(controls, {qubitIdx}),
+                [&](std::size_t base, std::size_t len) {
+                  auto kernel = len >= kernels.width ? kernels.applyPhase
+                                                     : simd::applyPhaseScalar;
+                  if (scaleZero)
+                    kernel(re + base, im + base, len, d0.real(), d0.imag());
+                  const std::size_t one = base | targetMask;
+                  kernel(re + one, im + one, len, d1.real(), d1.imag());
+                });
+  }
+
+  /// @brief Exchange the amplitudes with `maskA` set (and `maskB` clear)
+  /// with those that have `maskB` set (and `maskA` clear).
+  void exchange(const FixedQubits &fixed, const std::size_t maskA,
+                const std::size_t maskB) {
+    auto *re = real.data();
+    auto *im = imag.data();
+    forEachSpan(fixed, [&](std::size_t base, std::size_t len) {
+      std::swap_ranges(re + (base | maskA), re + (base | maskA) + len,
+                       re + (base | maskB));
+      std::swap_ranges(im + (base | maskA), im + (base | maskA) + len,
+                       im + (base | maskB));
+    });
+  }
+
+  template <typename GateT>
+  void oneQubitApply(const std::vector<std::size_t> &controls,
+                     const std::size_t qubitIdx) {
+    GateT gate;
+    CUDAQ_INFO(gateToString(gate.name(), controls, {}, {qubitIdx}));
+    if (skipPrefixGate(gate.name(), {}, controls, {qubitIdx}))
+      return;
+    if constexpr (std::is_same_v<GateT, nvqir::x<double>>) {
+      exchange(fixedQubits(controls, {qubitIdx}), 0, 1ULL << qubitIdx);
+    } else if constexpr (std::is_same_v<GateT, nvqir::z<double>> ||
+                         std::is_same_v<GateT, nvqir::s<double>> ||
+                         std::is_same_v<GateT, nvqir::sdg<double>> ||
+                         std::is_same_v<GateT, nvqir::t<double>> ||
+                         std::is_same_v<GateT, nvqir::tdg<double>>) {
+      constexpr auto matrix = GateT::getMatrix();
+      applyDiagonal(matrix[0], matrix[3], controls, qubitIdx);
+    } else {
+      applyMatrix(GateT::getMatrix(), controls, qubitIdx);
+    }
+  }
+
+  template <typename RotationGateT>
+  void oneQubitOneParamApply(const double angle,
+                             const std::vector<std::size_t> &controls,
+                             const std::size_t qubitIdx) {
+    RotationGateT gate;
+    CUDAQ_INFO(gateToString(gate.name(), controls, {angle}, {qubitIdx}));
+    if (skipPrefixGate(gate.name(), {angle}, controls, {qubitIdx}))
+      return;
+    const auto matrix = gate.getMatrix(angle);
+    if constexpr (std::is_same_v<RotationGateT, nvqir::rz<double>> ||
+                  std::is_same_v<RotationGateT, nvqir::r1<double>> ||
+                  std::is_same_v<RotationGateT, nvqir::u1<double>>)
+      applyDiagonal(matrix[0], matrix[3], controls, qubitIdx);
+    else
+      applyMatrix(matrix, controls, qubitIdx);
+  }
+
+  /// @brief Grow the buffers to the current state dimension.
+  void addQubitToState() override {
+    if (bufferDimension >= stateDimension)
+      return;
+
+    const bool isNew = bufferDimension == 0;
+    real.resize(stateDimension);
+    imag.resize(stateDimension);
+    if (isNew)
+      real.data()[0] = 1.0;
+    bufferDimension = stateDimension;
+  }
+
+  void resetQubitStateImpl() override {
+    real.clear();
+    imag.clear();
+    bufferDimension = 0;
+  }
+
+  bool canSnapshotState() override { return true; }
+
+  bool saveStateSnapshot() override {
+    snapshotReal.resize(bufferDimension);
+    snapshotImag.resize(bufferDimension);
+    std::memcpy(snapshotReal.data(), real.data(),
+                bufferDimension * sizeof(double));
+    std::memcpy(snapshotImag.data(), imag.data(),
+                bufferDimension * sizeof(double));
+    return true;
+  }
+
+  bool restoreStateSnapshot() override {
+    if (snapshotReal.size() != bufferDimension)
+      return false;
+    std::memcpy(real.data(), snapshotReal.data(),
+                bufferDimension * sizeof(double));
+    std::memcpy(imag.data(), snapshotImag.data(),
+                bufferDimension * sizeof(double));
+    return true;
+  }
+
+  void clearStateSnapshot() override {
+    snapshotReal.clear();
+    snapshotImag.clear();
+  }
+
+  bool canRestoreState() override { return true; }
+
+  void setStateData(const std::complex<double> *data) override {
+    auto *re = real.data();
+    auto *im = imag.data();
+    for (std::size_t i = 0; i < bufferDimension; i++) {
+      re[i] = data[i].real();
+      im[i] = data[i].imag();
+    }
+  }
+
+  /// @brief Return the probability of measuring the qubit in the |1> state.
+  double probabilityOfOne(const std::size_t qubitIdx) {
+    const std::size_t mask = 1ULL << qubitIdx;
+    const auto *re = real.data();
+    const auto *im = imag.data();
+    double prob = 0.0;
+#pragma omp parallel for reduction(+ : prob) if (bufferDimension >= minParallelDimension)
+    for (std::size_t i = 0; i < bufferDimension; i++)
+      if (i & mask)
+        prob += re[i] * re[i] + im[i] * im[i];
+    return prob;
+  }
+
+  /// @brief Project the qubit onto the given result and renormalize.
+  void collapse(const std::size_t qubitIdx, const bool result,
+                const double probability) {
+    const std::size_t mask = 1ULL << qubitIdx;
+    const double scale = 1.0 / std::sqrt(probability);
+    auto *re = real.data();
+    auto *im = imag.data();
+#pragma omp parallel for if (bufferDimension >= minParallelDimension)
+    for (std::size_t i = 0; i < bufferDimension; i++) {
+      const double factor = (static_cast<bool>(i & mask) == result) ? scale : 0.0;
+      re[i] *= factor;
+      im[i] *= factor;
+    }
+  }
+
+  bool measureQubit(const std::size_t qubitIdx) override {
+    synchronizeState();
+    const double probOne = probabilityOfOne(qubitIdx);
+    std::uniform_real_distribution<double> distr(0.0, 1.0);
+    const bool result = distr(randomEngine) < probOne;
+    collapse(qubitIdx, result, result ? probOne : 1.0 - probOne);
+    cudaq::info("Measured qubit {} -> {}", qubitIdx, result);
+    return result;
+  }
+
+  /// @brief Measure the qubits jointly: draw one outcome from their marginal
+  /// probabilities, then project the state onto it in a single pass.
+  std::vector<bool>
+  measureQubits(const std::vector<std::size_t> &qubitIdxs) override {
+    if (qubitIdxs.size() < 2 || qubitIdxs.size() > maxJointMeasureQubits)
+      return CircuitSimulator::measureQubits(qubitIdxs);
+    const auto probabilities = getMarginalProbabilities(qubitIdxs);
+    std::uniform_real_distribution<double> distr(0.0, 1.0);
+    const std::size_t outcome = drawOutcome(probabilities, distr(randomEngine));
+
+    std::vector<bool> bits(qubitIdxs.size());
+    std::string bitString(qubitIdxs.size(), '0');
+    std::size_t mask = 0, kept = 0;
+    for (std::size_t j = 0; j < qubitIdxs.size(); j++) {
+      mask |= 1ULL << qubitIdxs[j];
+      bits[j] = (outcome >> j) & 1;
+      if (bits[j]) {
+        bitString[j] = '1';
+        kept |= 1ULL << qubitIdxs[j];
+      }
+    }
+    const double scale = 1.0 / std::sqrt(probabilities[outcome]);
+    auto *re = real.data();
+    auto *im = imag.data();
+#pragma omp parallel for if (bufferDimension >= minParallelDimension)
+    for (std::size_t i = 0; i < bufferDimension; i++) {
+      const double factor = (i & mask) == kept ? scale : 0.0;
+      re[i] *= factor;
+      im[i] *= factor;
+    }
+    cudaq::info("Measured qubits {} -> {}", qubitIdxs, bitString);
+    return bits;
+  }
+
+  /// @brief Sum the probabilities of the basis states into those of the
+  /// outcomes of the qubits, in one parallel pass over the state.
+  std::vector<double>
+  getMarginalProbabilities(const std::vector<std::size_t> &qubits) override {
+    synchronizeState();
+    const auto *re = real.data();
+    const auto *im = imag.data();
+    std::vector<double> probabilities(1ULL << qubits.size(), 0.0);
+    auto *sums = probabilities.data();
+    const auto nOutcomes = probabilities.size();
+#pragma omp parallel for reduction(+ : sums[:nOutcomes]) if (bufferDimension >= minParallelDimension)
+    for (std::size_t i = 0; i < bufferDimension; i++) {
+      std::size_t outcome = 0;
+      for (std::size_t j = 0; j < qubits.size(); j++)
+        outcome |= ((i >> qubits[j]) & 1) << j;
+      sums[outcome] += re[i] * re[i] + im[i] * im[i];
+    }
+    return probabilities;
+  }
+
+  /// @brief Compute <Z...Z> over the given qubits.
+  double calculateExpectationValue(const std::vector<std::size_t> &qubits) {
+    std::size_t mask = 0;
+    for (auto q : qubits)
+      mask |= 1ULL << q;
+    const auto *re = real.data();
+    const auto *im = imag.data();
+    double result = 0.0;
+#pragma omp parallel for reduction(+ : result) if (bufferDimension >= minParallelDimension)
+    for (std::size_t i = 0; i < bufferDimension; i++) {
+      const double p = re[i] * re[i] + im[i] * im[i];
+      result += (std::popcount(i & mask) & 1) ? -p : p;
+    }
+    return result;
+  }
+
+public:
+  SimdCircuitSimulator()
+      : kernels(simd::selectKernels()), randomEngine(std::random_device{}()) {
+    cudaq::info("SIMD state vector simulator using {} kernels.", kernels.isa);
+  }
+  virtual ~SimdCircuitSimulator() = default;
+
+  void seedRandomEngines(std::uint64_t seed) override {
+    CircuitSimulator::seedRandomEngines(seed);
+    randomEngine.seed(seed);
+  }
+
+  /// @brief Allocate all the qubits at once, growing the buffers a single
+  /// time.
+  std::vector<std::size_t> allocateQubits(const std::size_t count) override {
+    std::vector<std::size_t> qubits;
+    for (std::size_t i = 0; i < count; i++)
+      qubits.emplace_back(tracker.getNextIndex());
+    cudaq::info("Allocating {} new qubits (nQ={}, dim={})", count,
+                nQubitsAllocated, stateDimension);
+    nQubitsAllocated += count;
+    stateDimension = calculateStateDim(nQubitsAllocated);
+    addQubitToState();
+    return qubits;
+  }
+
+/// The one-qubit overrides
+#define SIMD_ONE_QUBIT_METHOD_OVERRIDE(NAME)                                   \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const std::vector<std::size_t> &controls,                          \
+            const std::size_t qubitIdx) override {                             \
+    oneQubitApply<nvqir::NAME<double>>(controls, qubitIdx);                    \
+  }
+
+  SIMD_ONE_QUBIT_METHOD_OVERRIDE(x)
+  SIMD_ONE_QUBIT_METHOD_OVERRIDE(y)
+  SIMD_ONE_QUBIT_METHOD_OVERRIDE(z)
+  SIMD_ONE_QUBIT_METHOD_OVERRIDE(h)
+  SIMD_ONE_QUBIT_METHOD_OVERRIDE(s)
+  SIMD_ONE_QUBIT_METHOD_OVERRIDE(t)
+  SIMD_ONE_QUBIT_METHOD_OVERRIDE(sdg)
+  SIMD_ONE_QUBIT_METHOD_OVERRIDE(tdg)
+
+/// The one-qubit parameterized overrides
+#define SIMD_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(NAME)                         \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const double angle, const std::vector<std::size_t> &controls,      \
+            const std::size_t qubitIdx) override {                             \
+    oneQubitOneParamApply<nvqir::NAME<double>>(angle, controls, qubitIdx);     \
+  }
+
+  SIMD_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rx)
+  SIMD_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(ry)
+  SIMD_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rz)
+  SIMD_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(r1)
+  SIMD_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(u1)
+
+#undef SIMD_ONE_QUBIT_METHOD_OVERRIDE
+#undef SIMD_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE
+
+  using CircuitSimulator::u2;
+  void u2(const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u2", controls, {phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u2", {phi, lambda}, controls, {qubitIdx}))
+      return;
+    applyMatrix(nvqir::u2<double>::getMatrix(phi, lambda), controls, qubitIdx);
+  }
+
+  using CircuitSimulator::u3;
+  void u3(const double theta, const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u3", controls, {theta, phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u3", {theta, phi, lambda}, controls, {qubitIdx}))
+      return;
+    applyMatrix(nvqir::u3<double>::getMatrix(theta, phi, lambda), controls,
+                qubitIdx);
+  }
+
+  using CircuitSimulator::swap;
+  void swap(const std::vector<std::size_t> &ctrlBits, const std::size_t srcIdx,
+            const std::size_t tgtIdx) override {
+    CUDAQ_INFO(gateToString("swap", ctrlBits, {}, {srcIdx, tgtIdx}));
+    if (skipPrefixGate("swap", {}, ctrlBits, {srcIdx, tgtIdx}))
+      return;
+    exchange(fixedQubits(ctrlBits, {srcIdx, tgtIdx}), 1ULL << srcIdx,
+             1ULL << tgtIdx);
+  }
+
+  void resetQubit(const std::size_t qubitIdx) override {
+    if (measureQubit(qubitIdx))
+      exchange(fixedQubits({}, {qubitIdx}), 0, 1ULL << qubitIdx);
+  }
+
+  /// @brief Sample the state on the given qubits. One pass over the state
+  /// is made, walking the cumulative probability against sorted uniform
+  /// random numbers.
+  cudaq::ExecutionResult sample(const std::vector<std::size_t> &measuredBits,
+                                const int shots) override {
+    synchronizeState();
+    double expectationValue = calculateExpectationValue(measuredBits);
+    if (shots < 1) {
+      cudaq::info("Computed expectation value = {}", expectationValue);
+      return cudaq::ExecutionResult{{}, expectationValue};
+    }
+
+    const auto *re = real.data();
+    const auto *im = imag.data();
+    double norm = 0.0;
+    for (std::size_t i = 0; i < bufferDimension; i++)
+      norm += re[i] * re[i] + im[i] * im[i];
+
+    std::uniform_real_distribution<double> distr(0.0, norm);
+    std::vector<double> randoms(shots);
+    for (auto &r : randoms)
+      r = distr(randomEngine);
+    std::sort(randoms.begin(), randoms.end());
+
+    // Map each sampled amplitude index to the measured bits, packed so that
+    // measuredBits[j] ends up as bit j.
+    std::unordered_map<std::size_t, std::size_t> packedCounts;
+    auto pack = [&](std::size_t index) {
+      std::size_t packed = 0;
+      for (std::size_t j = 0; j < measuredBits.size(); j++)
+        packed |= ((index >> measuredBits[j]) & 1ULL) << j;
+      return packed;
+    };
+
+    double cumulative = 0.0;
+    std::size_t i = 0, lastNonZero = 0;
+    for (auto r : randoms) {
+      while (i < bufferDimension &&
+             cumulative + re[i] * re[i] + im[i] * im[i] <= r) {
+        cumulative += re[i] * re[i] + im[i] * im[i];
+        i++;
+      }
+      // Rounding can run us past the end, fall back to the last index with
+      // non-zero probability.
+      if (i == bufferDimension) {
+        while (lastNonZero + 1 < bufferDimension &&
+               re[bufferDimension - 1 - lastNonZero] == 0.0 &&
+               im[bufferDimension - 1 - lastNonZero] == 0.0)
+          lastNonZero++;
+        packedCounts[pack(bufferDimension - 1 - lastNonZero)]++;
+        continue;
+      }
+      packedCounts[pack(i)]++;
+    }
+
+    cudaq::ExecutionResult counts(expectationValue);
+    std::string bitstring(measuredBits.size(), '0');
+    for (auto &[packed, count] : packedCounts) {
+      for (std::size_t j = 0; j < measuredBits.size(); j++)
+        bitstring[j] = (packed >> j) & 1ULL ? '1' : '0';
+      counts.appendResult(bitstring, count);
+    }
+    return counts;
+  }
+
+  /// @brief Return the positions of the buffer whose qubits were
+  /// deallocated, and so reset to |0>. The qubits of a pending deferred
+  /// deallocation were not reset and stay in the state.
+  FixedQubits freedQubits() const {
+    FixedQubits freed;
+    for (std::size_t q = 0; (1ULL << q) < bufferDimension; q++)
+      if (tracker.isAvailable(q) &&
+          std::find(deferredDeallocation.begin(), deferredDeallocation.end(),
+                    q) == deferredDeallocation.end())
+        freed.add(1ULL << q);
+    return freed;
+  }
+
+  /// @brief Return the state of the qubits in use, gathering the amplitudes
+  /// with the bits of the deallocated qubits clear.
+  cudaq::State getStateData() override {
+    synchronizeState();
+    const auto freed = freedQubits();
+    const std::size_t dimension = bufferDimension >> freed.count;
+    std::vector<std::complex<double>> data(dimension);
+    for (std::size_t i = 0; i < dimension; i++) {
+      const std::size_t k = freed.expand(i);
+      data[i] = {real.data()[k], imag.data()[k]};
+    }
+    return cudaq::State{{dimension}, std::move(data)};
+  }
+
+  /// @brief Reference the whole buffer, it is not copied. The deallocated
+  /// qubits are part of it, as the checkpoints record the qubits in use.
+  std::unique_ptr<cudaq::SimulationState> getSimulationState() override {
+    synchronizeState();
+    return std::make_unique<simd::SplitStateView>(bufferDimension, real.data(),
+                                                  imag.data());
+  }
+
+  /// @brief Return the name of the selected instruction set, primarily
+  /// used for testing.
+  const std::string &isa() const { return kernels.isa; }
+
+  std::string name() const override { return "simd"; }
+  NVQIR_SIMULATOR_CLONE_IMPL(SimdCircuitSimulator)
+};
+
+} // namespace nvqir
+
+#ifndef __NVQIR_SIMD_TOGGLE_CREATE
+/// Register this Simulator with NVQIR.
+NVQIR_REGISTER_SIMULATOR(nvqir::SimdCircuitSimulator, simd)
+#endif
@@ -0,0 +1,648 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CircuitSimulator.h"
+#include "Gates.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <unordered_map>
+
+namespace nvqir {
+
+/// @brief The SparseCircuitSimulator stores only the nonzero amplitudes of
+/// the state, in a hash map keyed by the basis state, qubit q being bit q of
+/// the key. Memory and gate cost grow with the number of nonzero amplitudes
+/// instead of 2^n, so circuits that keep a small support (oracles, classical
+/// arithmetic, the ancillas of phase estimation) run on up to 64 qubits.
+///
+/// A gate maps every entry to the entries it pairs with on the target
+/// qubits, skipping the zero elements of the gate matrix, so permutations
+/// like x, cx or swap keep the number of entries and diagonal gates are
+/// applied in place. Once the entries fill more than the density threshold
+/// of the 2^n basis states, the state switches to a dense vector indexed the
+/// same way, which is smaller and faster at that density. It switches back
+/// if the state grows past the qubits a dense vector can hold.
+class SparseCircuitSimulator : public nvqir::CircuitSimulator {
+protected:
+  using Complex = std::complex<double>;
+  using SparseState = std::unordered_map<std::uint64_t, Complex>;
+
+  /// @brief The nonzero amplitudes, while the state is sparse.
+  SparseState entries;
+
+  /// @brief The map the next state is built into by a gate, kept to reuse
+  /// its buckets.
+  SparseState scratch;
+
+  /// @brief The amplitudes of the 2^n basis states, while the state is dense.
+  std::vector<Complex> dense;
+  bool isDense = false;
+
+  /// @brief The number of qubits of the state. The base class dimension
+  /// overflows beyond 63 qubits, the state is tracked by this count.
+  std::size_t nStateQubits = 0;
+
+  SparseState snapshotEntries;
+  std::vector<Complex> snapshotDense;
+  bool snapshotIsDense = false;
+  std::size_t snapshotQubits = 0;
+  bool hasSnapshot = false;
+
+  /// @brief The fraction of the basis states above which the state turns
+  /// dense, read from CUDAQ_SPARSE_DENSITY_THRESHOLD. A map entry takes
+  /// several times the memory of a dense amplitude.
+  double densityThreshold = 0.25;
+
+  /// @brief The most qubits of a dense state.
+  static constexpr std::size_t maxDenseQubits = 30;
+
+  /// @brief The most qubits of the state, the width of the keys.
+  static constexpr std::size_t maxQubits = 64;
+
+  /// @brief Entries of a smaller norm are dropped after a gate, they are
+  /// left over by amplitudes that cancel up to rounding.
+  static constexpr double minAmplitudeNorm = 1e-26;
+
+  /// @brief The approximate memory of a map entry: key, amplitude, the
+  /// bucket and node pointers.
+  static constexpr std::size_t entryBytes =
+      sizeof(std::uint64_t) + sizeof(Complex) + 3 * sizeof(void *);
+
+  std::mt19937_64 randomEngine;
+
+  /// @brief The number of nonzero (or stored) amplitudes.
+  std::size_t supportSize() const {
+    return isDense ? dense.size() : entries.size();
+  }
+
+  /// @brief Move the entries into a dense vector.
+  void densify() {
+    cudaq::info("Sparse state of {} entries on {} qubits turns dense.",
+                entries.size(), nStateQubits);
+    dense.assign(1ULL << nStateQubits, 0.0);
+    for (auto &[key, amplitude] : entries)
+      dense[key] = amplitude;
+    entries = SparseState();
+    scratch = SparseState();
+    isDense = true;
+  }
+
+  /// @brief Move the nonzero amplitudes of the dense vector into the map.
+  void sparsify() {
+    cudaq::info("Dense state on {} qubits turns sparse.", nStateQubits);
+    entries.clear();
+    for (std::size_t i = 0; i < dense.size(); i++)
+      if (std::norm(dense[i]) >= minAmplitudeNorm)
+        entries.emplace(i, dense[i]);
+    dense = std::vector<Complex>();
+    isDense = false;
+  }
+
+  /// @brief Turn the state dense if its entries exceed the density
+  /// threshold.
+  void checkDensity() {
+    if (!isDense && nStateQubits <= maxDenseQubits &&
+        entries.size() > densityThreshold * std::ldexp(1.0, nStateQubits))
+      densify();
+  }
+
+  /// @brief Return true if the row major matrix has no nonzero off-diagonal
+  /// element.
+  static bool isDiagonal(std::span<const Complex> matrix, std::size_t dim) {
+    for (std::size_t r = 0; r < dim; r++)
+      for (std::size_t c = 0; c < dim; c++)
+        if (r != c && matrix[r * dim + c] != 0.0)
+          return false;
+    return true;
+  }
+
+  /// @brief The basis state k of the targets in the row major 2^t x 2^t
+  /// matrix, bit j of its index being targets[j], see applyMatrix().
+  struct TargetBits {
+    std::vector<std::uint64_t> masks;
+    std::uint64_t all = 0;
+
+    TargetBits(const std::vector<std::size_t> &targets) {
+      for (auto t : targets) {
+        masks.push_back(1ULL << t);
+        all |= masks.back();
+      }
+    }
+    std::size_t gather(std::uint64_t key) const {
+      std::size_t local = 0;
+      for (std::size_t j = 0; j < masks.size(); j++)
+        if (key & masks[j])
+          local |= 1ULL << j;
+      return local;
+    }
+    std::uint64_t scatter(std::uint64_t base, std::size_t local) const {
+      for (std::size_t j = 0; j < masks.size(); j++)
+        if (local >> j & 1)
+          base |= masks[j];
+      return base;
+    }
+  };
+
+  /// @brief Apply the row major 2^t x 2^t matrix to the targets, bit j of
+  /// its index being targets[j], if all the controls are set.
+  void applyMatrix(std::span<const Complex> matrix,
+                   const std::vector<std::size_t> &controls,
+                   const std::vector<std::size_t> &targets) {
+    std::uint64_t controlMask = 0;
+    for (auto c : controls)
+      controlMask |= 1ULL << c;
+    const TargetBits bits(targets);
+    const std::size_t dim = 1ULL << targets.size();
+
+    if (isDiagonal(matrix, dim)) {
+      auto scale = [&](std::uint64_t key, Complex &amplitude) {
+        if ((key & controlMask) == controlMask) {
+          const auto local = bits.gather(key);
+          amplitude *= matrix[local * dim + local];
+        }
+      };
+      if (isDense)
+        for (std::size_t i = 0; i < dense.size(); i++)
+          scale(i, dense[i]);
+      else
+        for (auto iter = entries.begin(); iter != entries.end();) {
+          scale(iter->first, iter->second);
+          iter = std::norm(iter->second) < minAmplitudeNorm
+                     ? entries.erase(iter)
+                     : std::next(iter);
+        }
+      return;
+    }
+
+    if (isDense) {
+      std::vector<Complex> in(dim), out(dim);
+      for (std::size_t base = 0; base < dense.size(); base++) {
+        if ((base & bits.all) || (base & controlMask) != controlMask)
+          continue;
+        for (std::size_t l = 0; l < dim; l++)
+          in[l] = dense[bits.scatter(base, l)];
+        for (std::size_t r = 0; r < dim; r++) {
+          out[r] = 0.0;
+          for (std::size_t l = 0; l < dim; l++)
+            out[r] += matrix[r * dim + l] * in[l];
+        }
+        for (std::size_t l = 0; l < dim; l++)
+          dense[bits.scatter(base, l)] = out[l];
+      }
+      return;
+    }
+
+    // Every entry adds its column of the matrix to the entries it pairs with.
+    scratch.clear();
+    scratch.reserve(entries.size());
+    for (auto &[key, amplitude] : entries) {
+      if ((key & controlMask) != controlMask) {
+        scratch[key] += amplitude;
+        continue;
+      }
+      const auto in = bits.gather(key);
+      const auto base = key & ~bits.all;
+      for (std::size_t r = 0; r < dim; r++)
+        if (const auto element = matrix[r * dim + in]; element != 0.0)
+          scratch[bits.scatter(base, r)] += element * amplitude;
+    }
+    std::erase_if(scratch, [](auto &entry) {
+      return std::norm(entry.second) < minAmplitudeNorm;
+    });
+    std::swap(entries, scratch);
+    checkDensity();
+  }
+
+  /// @brief Apply the gate and its noise trajectory.
+  void applyGate(std::span<const Complex> matrix,
+                 const std::vector<std::size_t> &controls,
+                 const std::vector<std::size_t> &targets,
+                 const std::string_view gateName) {
+    applyMatrix(matrix, controls, targets);
+    if (executionContext && executionContext->noiseModel) {
+      std::vector<std::size_t> noiseQubits(controls);
+      noiseQubits.insert(noiseQubits.end(), targets.begin(), targets.end());
+      applyNoiseTrajectory(gateName, noiseQubits);
+    }
+  }
+
+  /// @brief Call f(key, amplitude) for every stored amplitude.
+  template <typename Function>
+  void forEachAmplitude(Function &&f) const {
+    if (isDense) {
+      for (std::size_t i = 0; i < dense.size(); i++)
+        f(static_cast<std::uint64_t>(i), dense[i]);
+      return;
+    }
+    for (auto &[key, amplitude] : entries)
+      f(key, amplitude);
+  }
+
+  /// @brief Return the amplitude of the basis state.
+  Complex amplitudeOf(std::uint64_t key) const {
+    if (isDense)
+      return dense[key];
+    auto iter = entries.find(key);
+    return iter == entries.end() ? Complex(0.0) : iter->second;
+  }
+
+  /// @brief Return <psi| P |psi> for the Pauli string P with X or Y on the
+  /// qubits in `xMask`, Z or Y on those in `zMask`, and nY Y factors. P maps
+  /// |k> to i^nY (-1)^|k & zMask| |k ^ xMask>.
+  double pauliExpectation(std::uint64_t xMask, std::uint64_t zMask,
+                          std::size_t nY) const {
+    Complex sum = 0.0;
+    forEachAmplitude([&](std::uint64_t key, const Complex &amplitude) {
+      const auto term =
+          std::conj(xMask ? amplitudeOf(key ^ xMask) : amplitude) * amplitude;
+      sum += std::popcount(key & zMask) % 2 ? -term : term;
+    });
+    static constexpr Complex phases[] = {
+        {1.0, 0.0}, {0.0, 1.0}, {-1.0, 0.0}, {0.0, -1.0}};
+    return (phases[nY % 4] * sum).real();
+  }
+
+  void addQubitToState() override {
+    if (nQubitsAllocated > maxQubits)
+      throw std::runtime_error("The sparse backend simulates at most " +
+                               std::to_string(maxQubits) + " qubits.");
+    if (nStateQubits == 0 && !isDense && entries.empty())
+      entries.emplace(0, 1.0);
+    nStateQubits = std::max(nStateQubits, nQubitsAllocated);
+    if (isDense) {
+      if (nStateQubits > maxDenseQubits)
+        sparsify();
+      else
+        dense.resize(1ULL << nStateQubits, 0.0);
+    }
+  }
+
+  void resetQubitStateImpl() override {
+    entries.clear();
+    scratch.clear();
+    dense = std::vector<Complex>();
+    isDense = false;
+    nStateQubits = 0;
+  }
+
+  bool canSnapshotState() override { return true; }
+
+  bool saveStateSnapshot() override {
+    snapshotEntries = entries;
+    snapshotDense = dense;
+    snapshotIsDense = isDense;
+    snapshotQubits = nStateQubits;
+    hasSnapshot = true;
+    return true;
+  }
+
+  bool restoreStateSnapshot() override {
+    if (!hasSnapshot || snapshotQubits != nStateQubits)
+      return false;
+    entries = snapshotEntries;
+    dense = snapshotDense;
+    isDense = snapshotIsDense;
+    return true;
+  }
+
+  void clearStateSnapshot() override {
+    snapshotEntries = SparseState();
+    snapshotDense = std::vector<Complex>();
+    hasSnapshot = false;
+  }
+
+  std::size_t getStateBytes() override {
+    return isDense ? dense.size() * sizeof(Complex)
+                   : entries.size() * entryBytes;
+  }
+
+  /// @brief Noise is simulated with quantum trajectories.
+  bool canHandleTrajectoryNoise() override { return true; }
+
+  bool canHandleObserve() override { return isExactObservation(); }
+
+  /// @brief Diagonal phases keep the support, they scale each stored
+  /// amplitude once.
+  bool canApplyDiagonalPhases() override { return true; }
+
+  void
+  applyDiagonalPhasesImpl(const std::vector<ZRotation> &rotations) override {
+    std::vector<std::uint64_t> masks;
+    for (auto &rotation : rotations) {
+      masks.push_back(0);
+      for (auto q : rotation.qubits)
+        masks.back() |= 1ULL << q;
+    }
+    auto scale = [&](std::uint64_t key, Complex &amplitude) {
+      double phase = 0.0;
+      for (std::size_t r = 0; r < rotations.size(); r++)
+        phase += std::popcount(key & masks[r]) & 1 ? rotations[r].angle / 2
+                                                   : -rotations[r].angle / 2;
+      amplitude *= std::polar(1.0, phase);
+    };
+    if (isDense)
+      for (std::size_t i = 0; i < dense.size(); i++)
+        scale(i, dense[i]);
+    else
+      for (auto &[key, amplitude] : entries)
+        scale(key, amplitude);
+  }
+
+  /// @brief Apply the dense matrix, targets[0] the least significant bit of
+  /// its index.
+  void applyDenseMatrix(const std::vector<std::complex<double>> &matrix,
+                        const std::vector<std::size_t> &targets) override {
+    applyMatrix(matrix, {}, targets);
+  }
+
+  double
+  expectationOfDenseMatrix(const std::vector<std::complex<double>> &matrix,
+                           const std::vector<std::size_t> &targets) override {
+    const TargetBits bits(targets);
+    const std::size_t dim = 1ULL << targets.size();
+    Complex sum = 0.0;
+    forEachAmplitude([&](std::uint64_t key, const Complex &amplitude) {
+      const auto in = bits.gather(key);
+      const auto base = key & ~bits.all;
+      for (std::size_t r = 0; r < dim; r++)
+        if (const auto element = matrix[r * dim + in]; element != 0.0)
+          sum += std::conj(amplitudeOf(bits.scatter(base, r))) * element *
+                 amplitude;
+    });
+    return sum.real();
+  }
+
+  bool measureQubit(const std::size_t qubitIdx) override {
+    synchronizeState();
+    const std::uint64_t mask = 1ULL << qubitIdx;
+    double probabilities[2] = {0.0, 0.0};
+    forEachAmplitude([&](std::uint64_t key, const Complex &amplitude) {
+      probabilities[(key & mask) != 0] += std::norm(amplitude);
+    });
+    const double total = probabilities[0] + probabilities[1];
+    std::uniform_real_distribution<double> distr(0.0, total);
+    const bool result = distr(randomEngine) < probabilities[1];
+
+    const double scale = std::sqrt(total / probabilities[result]);
+    if (isDense) {
+      for (std::size_t i = 0; i < dense.size(); i++)
+        dense[i] = ((i & mask) != 0) == result ? dense[i] * scale : 0.0;
+    } else {
+      for (auto iter = entries.begin(); iter != entries.end();) {
+        iter->second *= scale;
+        iter = ((iter->first & mask) != 0) != result ? entries.erase(iter)
+                                                     : std::next(iter);
+      }
+    }
+    cudaq::info("Measured qubit {} -> {}", qubitIdx, result);
+    return result;
+  }
+
+  /// @brief Sum the probabilities of the stored amplitudes into the
+  /// outcomes of the qubits.
+  std::vector<double>
+  getMarginalProbabilities(const std::vector<std::size_t> &qubits) override {
+    synchronizeState();
+    std::vector<double> probabilities(1ULL << qubits.size(), 0.0);
+    forEachAmplitude([&](std::uint64_t key, const Complex &amplitude) {
+      std::size_t outcome = 0;
+      for (std::size_t j = 0; j < qubits.size(); j++)
+        outcome |= (key >> qubits[j] & 1) << j;
+      probabilities[outcome] += std::norm(amplitude);
+    });
+    return probabilities;
+  }
+
+public:
+  SparseCircuitSimulator() : randomEngine(std::random_device{}()) {
+    if (auto *threshold = std::getenv("CUDAQ_SPARSE_DENSITY_THRESHOLD"))
+      densityThreshold = std::strtod(threshold, nullptr);
+    cudaq::info("Sparse simulator with density threshold {}.",
+                densityThreshold);
+  }
+  virtual ~SparseCircuitSimulator() = default;
+
+  /// @brief The state starts with a single entry, its size depends on the
+  /// circuit and not on the number of qubits.
+  std::size_t getRequiredStateBytes(std::size_t numQubits) override {
+    return entryBytes;
+  }
+
+  void seedRandomEngines(std::uint64_t seed) override {
+    CircuitSimulator::seedRandomEngines(seed);
+    randomEngine.seed(seed);
+  }
+
+  /// @brief Allocate the qubits without tracking the state dimension, which
+  /// overflows beyond 63 qubits.
+  std::vector<std::size_t> allocateQubits(const std::size_t count) override {
+    std::vector<std::size_t> qubits;
+    for (std::size_t i = 0; i < count; i++)
+      qubits.emplace_back(tracker.getNextIndex());
+    cudaq::info("Allocating {} new qubits (nQ={})", count, nQubitsAllocated);
+    nQubitsAllocated += count;
+    addQubitToState();
+    return qubits;
+  }
+
+  std::size_t allocateQubit() override { return allocateQubits(1)[0]; }
+
+/// The one-qubit overrides
+#define SPARSE_ONE_QUBIT_METHOD_OVERRIDE(NAME)                                 \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const std::vector<std::size_t> &controls,                          \
+            const std::size_t qubitIdx) override {                             \
+    nvqir::NAME<double> gate;                                                  \
+    CUDAQ_INFO(gateToString(gate.name(), controls, {}, {qubitIdx}));           \
+    if (skipPrefixGate(gate.name(), {}, controls, {qubitIdx}))                 \
+      return;                                                                  \
+    applyGate(gate.getMatrix(), controls, {qubitIdx}, gate.name());            \
+  }
+
+  SPARSE_ONE_QUBIT_METHOD_OVERRIDE(x)
+  SPARSE_ONE_QUBIT_METHOD_OVERRIDE(y)
+  SPARSE_ONE_QUBIT_METHOD_OVERRIDE(z)
+  SPARSE_ONE_QUBIT_METHOD_OVERRIDE(h)
+  SPARSE_ONE_QUBIT_METHOD_OVERRIDE(s)
+  SPARSE_ONE_QUBIT_METHOD_OVERRIDE(t)
+  SPARSE_ONE_QUBIT_METHOD_OVERRIDE(sdg)
+  SPARSE_ONE_QUBIT_METHOD_OVERRIDE(tdg)
+
+#undef SPARSE_ONE_QUBIT_METHOD_OVERRIDE
+
+/// The one-qubit parameterized overrides
+#define SPARSE_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(NAME)                       \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const double angle, const std::vector<std::size_t> &controls,      \
+            const std::size_t qubitIdx) override {                             \
+    nvqir::NAME<double> gate;                                                  \
+    CUDAQ_INFO(gateToString(gate.name(), controls, {angle}, {qubitIdx}));      \
+    if (skipPrefixGate(gate.name(), {angle}, controls, {qubitIdx}))            \
+      return;                                                                  \
+    applyGate(gate.getMatrix(angle), controls, {qubitIdx}, gate.name());       \
+  }
+
+  SPARSE_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rx)
+  SPARSE_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(ry)
+  SPARSE_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(rz)
+  SPARSE_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(r1)
+  SPARSE_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE(u1)
+
+#undef SPARSE_ONE_QUBIT_ONE_PARAM_METHOD_OVERRIDE
+
+  using CircuitSimulator::u2;
+  void u2(const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u2", controls, {phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u2", {phi, lambda}, controls, {qubitIdx}))
+      return;
+    applyGate(nvqir::u2<double>::getMatrix(phi, lambda), controls, {qubitIdx},
+              "u2");
+  }
+
+  using CircuitSimulator::u3;
+  void u3(const double theta, const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u3", controls, {theta, phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u3", {theta, phi, lambda}, controls, {qubitIdx}))
+      return;
+    applyGate(nvqir::u3<double>::getMatrix(theta, phi, lambda), controls,
+              {qubitIdx}, "u3");
+  }
+
+  using CircuitSimulator::swap;
+  void swap(const std::vector<std::size_t> &ctrlBits, const std::size_t srcIdx,
+            const std::size_t tgtIdx) override {
+    CUDAQ_INFO(gateToString("swap", ctrlBits, {}, {srcIdx, tgtIdx}));
+    if (skipPrefixGate("swap", {}, ctrlBits, {srcIdx, tgtIdx}))
+      return;
+    static constexpr std::array<Complex, 16> swapGate{
+        1., 0., 0., 0., 0., 0., 1., 0., 0., 1., 0., 0., 0., 0., 0., 1.};
+    applyGate(swapGate, ctrlBits, {srcIdx, tgtIdx}, "swap");
+  }
+
+  void resetQubit(const std::size_t qubitIdx) override {
+    if (measureQubit(qubitIdx))
+      applyMatrix(nvqir::x<double>::getMatrix(), {}, {qubitIdx});
+  }
+
+  /// @brief Sample the measured qubits from the probabilities of the stored
+  /// amplitudes.
+  cudaq::ExecutionResult sample(const std::vector<std::size_t> &measuredBits,
+                                const int shots) override {
+    synchronizeState();
+    std::uint64_t zMask = 0;
+    for (auto q : measuredBits)
+      zMask |= 1ULL << q;
+    const double expectationValue = pauliExpectation(0, zMask, 0);
+    if (shots < 1) {
+      cudaq::info("Computed expectation value = {}", expectationValue);
+      return cudaq::ExecutionResult{{}, expectationValue};
+    }
+
+    std::vector<std::uint64_t> keys;
+    std::vector<double> probabilities;
+    keys.reserve(supportSize());
+    probabilities.reserve(supportSize());
+    forEachAmplitude([&](std::uint64_t key, const Complex &amplitude) {
+      if (const double p = std::norm(amplitude); p > 0.0) {
+        keys.push_back(key);
+        probabilities.push_back(p);
+      }
+    });
+    std::discrete_distribution<std::size_t> distribution(
+        probabilities.begin(), probabilities.end());
+    std::unordered_map<std::uint64_t, std::size_t> counts;
+    for (int shot = 0; shot < shots; shot++) {
+      const auto key = keys[distribution(randomEngine)];
+      std::uint64_t outcome = 0;
+      for (std::size_t j = 0; j < measuredBits.size(); j++)
+        outcome |= (key >> measuredBits[j] & 1) << j;
+      counts[outcome]++;
+    }
+
+    cudaq::ExecutionResult result(expectationValue);
+    for (auto [outcome, count] : counts)
+      result.appendResult(&outcome, measuredBits.size(), count);
+    return result;
+  }
+
+  /// @brief Compute <psi| H |psi> term by term from the stored amplitudes.
+  cudaq::ExecutionResult observe(const cudaq::spin_op &H) override {
+    synchronizeState();
+    const auto nSpinQubits = H.n_qubits();
+    if (nSpinQubits > nQubitsAllocated)
+      throw std::runtime_error("Cannot observe a spin_op on " +
+                               std::to_string(nSpinQubits) + " qubits with " +
+                               std::to_string(nQubitsAllocated) +
+                               " qubits allocated.");
+    double expectation = 0.0;
+    for (auto term : H.terms()) {
+      std::uint64_t xMask = 0, zMask = 0;
+      std::size_t nY = 0;
+      for (std::size_t q = 0; q < nSpinQubits; q++) {
+        const auto p = term.get_pauli(q);
+        if (p == cudaq::pauli::X || p == cudaq::pauli::Y)
+          xMask |= 1ULL << q;
+        if (p == cudaq::pauli::Z || p == cudaq::pauli::Y)
+          zMask |= 1ULL << q;
+        nY += p == cudaq::pauli::Y;
+      }
+      expectation += term.get_coefficient().real() *
+                     (xMask || zMask ? pauliExpectation(xMask, zMask, nY)
+                                     : 1.0);
+    }
+    cudaq::info("Computed expectation value = {}", expectation);
+    return cudaq::ExecutionResult{{}, expectation};
+  }
+
+  /// @brief Return the dense state vector, qubit 0 is the most significant
+  /// bit of the index (as for qpp).
+  cudaq::State getStateData() override {
+    synchronizeState();
+    if (nStateQubits > maxDenseQubits)
+      throw std::runtime_error(
+          "The sparse backend only provides the state vector of up to " +
+          std::to_string(maxDenseQubits) + " qubits, the state has " +
+          std::to_string(nStateQubits) + ".");
+    const std::size_t dimension = 1ULL << nStateQubits;
+    std::vector<Complex> data(dimension, 0.0);
+    forEachAmplitude([&](std::uint64_t key, const Complex &amplitude) {
+      std::size_t index = 0;
+      for (std::size_t q = 0; q < nStateQubits; q++)
+        index |= (key >> q & 1) << (nStateQubits - 1 - q);
+      data[index] = amplitude;
+    });
+    return cudaq::State{{dimension}, std::move(data)};
+  }
+
+  /// @brief Return the number of stored amplitudes, primarily used for
+  /// testing.
+  std::size_t getSupportSize() const { return supportSize(); }
+
+  /// @brief Return true if the state is stored densely, primarily used for
+  /// testing.
+  bool isDenseState() const { return isDense; }
+
+  std::string name() const override { return "sparse"; }
+  NVQIR_SIMULATOR_CLONE_IMPL(SparseCircuitSimulator)
+};
+
+} // namespace nvqir
+
+#ifndef __NVQIR_SPARSE_TOGGLE_CREATE
+/// Register this Simulator with NVQIR.
+NVQIR_REGISTER_SIMULATOR(nvqir::SparseCircuitSimulator, sparse)
+#endif
@@ -0,0 +1,601 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#define __NVQIR_STABILIZER_TOGGLE_CREATE
+#include "StabilizerCircuitSimulator.cpp"
+
+namespace nvqir {
+
+/// @brief The ExtendedStabilizerCircuitSimulator simulates Clifford circuits
+/// with a few non-Clifford gates (t, tdg, rotations by arbitrary angles,
+/// ccx, ccz and single-controlled rotations) by keeping the state as a
+/// superposition of stabilizer states that share one tableau. With the
+/// tableau's stabilizer state |phi> and destabilizers d_i, the state is
+/// sum_s a_s |phi_s>, with |phi_s> the product of d_i over the bits i of s
+/// applied to |phi>. These are orthonormal. Clifford gates only update the
+/// tableau, each non-Clifford rotation (ccx takes 7) at most doubles the
+/// number of terms, so the cost grows exponentially in the number of
+/// non-Clifford gates rather than in the number of qubits.
+class ExtendedStabilizerCircuitSimulator : public StabilizerCircuitSimulator {
+protected:
+  /// @brief Hash the bits s of a term.
+  struct TermHash {
+    std::size_t operator()(const std::vector<Word> &key) const {
+      std::uint64_t h = 0x9e3779b97f4a7c15ULL;
+      for (auto w : key)
+        h = (h ^ w) * 0xff51afd7ed558ccdULL;
+      return h ^ (h >> 32);
+    }
+  };
+
+  using Terms =
+      std::unordered_map<std::vector<Word>, std::complex<double>, TermHash>;
+
+  /// @brief The amplitudes a_s, keyed by the tableau.stride words of s.
+  Terms terms;
+  Terms termsSnapshot;
+
+  /// @brief Amplitudes below this magnitude are dropped.
+  static constexpr double pruneTolerance = 1e-12;
+
+  /// @brief The Pauli string i^phase times the product over qubits of
+  /// X_q^x Z_q^z (Y for x = z = 1).
+  struct PauliString {
+    std::vector<Word> x;
+    std::vector<Word> z;
+    unsigned phase = 0;
+  };
+
+  /// @brief The action of a Pauli string P on the terms,
+  /// P |phi_s> = i^phase (-1)^|u & s| |phi_{s ^ r}>. Bit i of r is set if P
+  /// anti-commutes with stabilizer i, bit i of u if it anti-commutes with
+  /// destabilizer i.
+  struct PauliAction {
+    std::vector<Word> r;
+    std::vector<Word> u;
+    unsigned phase = 0;
+  };
+
+  static std::complex<double> iPower(unsigned k) {
+    static const std::complex<double> powers[] = {
+        {1., 0.}, {0., 1.}, {-1., 0.}, {0., -1.}};
+    return powers[k & 3];
+  }
+
+  static bool antiCommutes(const Word *ax, const Word *az, const Word *bx,
+                           const Word *bz, std::size_t stride) {
+    int parity = 0;
+    for (std::size_t w = 0; w < stride; w++)
+      parity ^= std::popcount((ax[w] & bz[w]) ^ (az[w] & bx[w])) & 1;
+    return parity;
+  }
+
+  static bool oddOverlap(const std::vector<Word> &a,
+                         const std::vector<Word> &b) {
+    int parity = 0;
+    for (std::size_t w = 0; w < a.size(); w++)
+      parity ^= std::popcount(a[w] & b[w]) & 1;
+    return parity;
+  }
+
+  static void xorInto(std::vector<Word> &dst, const std::vector<Word> &src) {
+    for (std::size_t w = 0; w < dst.size(); w++)
+      dst[w] ^= src[w];
+  }
+
+  static bool isZero(const std::vector<Word> &bits) {
+    return std::all_of(bits.begin(), bits.end(), [](Word w) { return !w; });
+  }
+
+  PauliString singleQubitPauli(char axis, std::size_t q) const {
+    PauliString pauli{std::vector<Word>(tableau.stride),
+                      std::vector<Word>(tableau.stride)};
+    if (axis != 'z')
+      flipBit(pauli.x.data(), q);
+    if (axis != 'x')
+      flipBit(pauli.z.data(), q);
+    return pauli;
+  }
+
+  /// @brief Write the Pauli string as i^phase d^r g^u in the current
+  /// tableau, where g^u |phi> = |phi>.
+  PauliAction decompose(const PauliString &pauli) {
+    const auto n = tableau.nQubits;
+    const auto stride = tableau.stride;
+    PauliAction action{std::vector<Word>(stride), std::vector<Word>(stride)};
+    for (std::size_t i = 0; i < n; i++) {
+      if (antiCommutes(pauli.x.data(), pauli.z.data(), xRow(n + i),
+                       zRow(n + i), stride))
+        flipBit(action.r.data(), i);
+      if (antiCommutes(pauli.x.data(), pauli.z.data(), xRow(i), zRow(i),
+                       stride))
+        flipBit(action.u.data(), i);
+    }
+
+    // The phase of the product d^r g^u relative to its bare string, which
+    // is the one of the Pauli string.
+    std::vector<Word> x(stride), z(stride);
+    unsigned phase = 0;
+    auto multiply = [&](std::size_t row) {
+      phase += multiplyPauliBits(xRow(row), zRow(row), x.data(), z.data(),
+                                 stride) +
+               2 * tableau.signs[row];
+    };
+    for (std::size_t i = 0; i < n; i++)
+      if (getBit(action.u.data(), i))
+        multiply(n + i);
+    for (std::size_t i = 0; i < n; i++)
+      if (getBit(action.r.data(), i))
+        multiply(i);
+    action.phase = (pauli.phase + 4 - (phase & 3)) & 3;
+    return action;
+  }
+
+  /// @brief Return <psi|P|psi> for the Pauli string of the action.
+  std::complex<double> expectation(const PauliAction &action) const {
+    std::complex<double> sum = 0.;
+    std::vector<Word> partner;
+    for (auto &[s, amplitude] : terms) {
+      partner = s;
+      xorInto(partner, action.r);
+      auto iter = terms.find(partner);
+      if (iter == terms.end())
+        continue;
+      const auto value = std::conj(iter->second) * amplitude;
+      sum += oddOverlap(action.u, s) ? -value : value;
+    }
+    return iPower(action.phase) * sum;
+  }
+
+  void normalize() {
+    double norm = 0.;
+    for (auto &[s, amplitude] : terms)
+      norm += std::norm(amplitude);
+    const double scale = 1. / std::sqrt(norm);
+    for (auto &[s, amplitude] : terms)
+      amplitude *= scale;
+  }
+
+  /// @brief Apply exp(-i angle / 2 P) = cos(angle / 2) - i sin(angle / 2) P
+  /// for the Hermitian Pauli string P.
+  void rotateTerms(double angle, const PauliString &pauli) {
+    const auto action = decompose(pauli);
+    const std::complex<double> identity = std::cos(angle / 2.);
+    const auto flipped =
+        std::complex<double>(0., -std::sin(angle / 2.)) * iPower(action.phase);
+    Terms rotated;
+    rotated.reserve(2 * terms.size());
+    for (auto &[s, amplitude] : terms) {
+      rotated[s] += identity * amplitude;
+      auto partner = s;
+      xorInto(partner, action.r);
+      rotated[partner] +=
+          (oddOverlap(action.u, s) ? -flipped : flipped) * amplitude;
+    }
+    std::erase_if(rotated, [](const auto &term) {
+      return std::abs(term.second) < pruneTolerance;
+    });
+    terms = std::move(rotated);
+  }
+
+  /// @brief Apply rz, rx or ry (axis 'z', 'x', 'y') by any angle, up to a
+  /// global phase.
+  void applyAxisRotation(char axis, double angle, std::size_t q) {
+    if (auto turns = quarterTurns(angle))
+      applyRotation(axis, *turns, q);
+    else
+      rotateTerms(angle, singleQubitPauli(axis, q));
+  }
+
+  /// @brief Apply a rotation controlled on one qubit, as rz(angle / 2) and
+  /// rz(-angle / 2) on the target around two CNOTs, in the basis of the
+  /// axis. r1 also rotates the control.
+  void applyControlledRotation(char axis, bool phase, double angle,
+                               std::size_t control, std::size_t target) {
+    if (axis == 'x')
+      applyH(target);
+    else if (axis == 'y') {
+      applySdg(target);
+      applyH(target);
+    }
+    applyAxisRotation('z', angle / 2., target);
+    applyCNOT(control, target);
+    applyAxisRotation('z', -angle / 2., target);
+    applyCNOT(control, target);
+    if (axis == 'x')
+      applyH(target);
+    else if (axis == 'y') {
+      applyH(target);
+      applyS(target);
+    }
+    if (phase)
+      applyAxisRotation('z', angle / 2., control);
+  }
+
+  /// @brief Apply the Toffoli gate with the Clifford + T circuit of Nielsen
+  /// and Chuang, T being rz(pi / 4) up to a global phase.
+  void applyToffoli(std::size_t a, std::size_t b, std::size_t c) {
+    constexpr double t = M_PI_4;
+    applyH(c);
+    applyCNOT(b, c);
+    applyAxisRotation('z', -t, c);
+    applyCNOT(a, c);
+    applyAxisRotation('z', t, c);
+    applyCNOT(b, c);
+    applyAxisRotation('z', -t, c);
+    applyCNOT(a, c);
+    applyAxisRotation('z', t, b);
+    applyAxisRotation('z', t, c);
+    applyH(c);
+    applyCNOT(a, b);
+    applyAxisRotation('z', t, a);
+    applyAxisRotation('z', -t, b);
+    applyCNOT(a, b);
+  }
+
+  /// @brief If the state is a single stabilizer state, make it |phi> by
+  /// flipping the signs of the stabilizers that anti-commute with its
+  /// destabilizers, and return true. The base class then measures and
+  /// samples the tableau.
+  bool absorbSingleTerm() {
+    if (terms.size() != 1)
+      return false;
+    auto node = terms.extract(terms.begin());
+    const auto n = tableau.nQubits;
+    for (std::size_t i = 0; i < n; i++)
+      if (getBit(node.key().data(), i))
+        tableau.signs[n + i] ^= 1;
+    std::fill(node.key().begin(), node.key().end(), 0);
+    terms.insert(std::move(node));
+    return true;
+  }
+
+  /// @brief Return the probability to measure qubit q as 1.
+  double probabilityOfOne(std::size_t q) {
+    const double z = expectation(decompose(singleQubitPauli('z', q))).real();
+    return std::clamp((1. - z) / 2., 0., 1.);
+  }
+
+  /// @brief Project the state on the given result of measuring qubit q. If
+  /// a stabilizer anti-commutes with Z_q, the tableau collapses as for a
+  /// single stabilizer state and the terms are re-expanded in the new one.
+  void projectQubit(std::size_t q, bool result) {
+    const auto n = tableau.nQubits;
+    const auto stride = tableau.stride;
+    const auto action = decompose(singleQubitPauli('z', q));
+    if (isZero(action.r)) {
+      // Each term is an eigenstate of Z_q.
+      const bool flipped = action.phase == 2;
+      std::erase_if(terms, [&](const auto &term) {
+        return (oddOverlap(action.u, term.first) != flipped) != result;
+      });
+      normalize();
+      return;
+    }
+
+    std::size_t p = n;
+    while (!getBit(action.r.data(), p - n))
+      p++;
+
+    // Write each term as a Pauli string on |phi>, those that anti-commute
+    // with Z_q times g_p, so that they commute with the projector onto the
+    // result and map the projected |phi>, the new one, to the new terms.
+    std::vector<std::pair<PauliString, std::complex<double>>> strings;
+    strings.reserve(terms.size());
+    for (auto &[s, amplitude] : terms) {
+      PauliString pauli{std::vector<Word>(stride), std::vector<Word>(stride)};
+      for (std::size_t i = 0; i < n; i++)
+        if (getBit(s.data(), i))
+          pauli.phase += multiplyPauliBits(xRow(i), zRow(i), pauli.x.data(),
+                                           pauli.z.data(), stride) +
+                         2 * tableau.signs[i];
+      if (getBit(pauli.x.data(), q)) {
+        PauliString product{std::vector<Word>(xRow(p), xRow(p) + stride),
+                            std::vector<Word>(zRow(p), zRow(p) + stride),
+                            pauli.phase + 2 * tableau.signs[p]};
+        product.phase += multiplyPauliBits(pauli.x.data(), pauli.z.data(),
+                                           product.x.data(),
+                                           product.z.data(), stride);
+        pauli = std::move(product);
+      }
+      pauli.phase &= 3;
+      strings.emplace_back(std::move(pauli), amplitude);
+    }
+
+    collapseQubit(p, q, result);
+    terms.clear();
+    for (auto &[pauli, amplitude] : strings) {
+      const auto projected = decompose(pauli);
+      terms[projected.r] += iPower(projected.phase) * amplitude;
+    }
+    std::erase_if(terms, [](const auto &term) {
+      return std::abs(term.second) < pruneTolerance;
+    });
+    normalize();
+  }
+
+  /// @brief Sample the qubits after the bits of the prefix, one at a time:
+  /// the shots split binomially between the two results of the next qubit,
+  /// each branch continues on the projected state. Once a branch is a
+  /// single stabilizer state, the base class samples the rest.
+  void sampleBranch(const std::vector<std::size_t> &qubits, std::size_t shots,
+                    std::string &prefix,
+                    std::unordered_map<std::string, std::size_t> &counts) {
+    if (prefix.size() == qubits.size()) {
+      counts[prefix] += shots;
+      return;
+    }
+    if (absorbSingleTerm()) {
+      std::vector<std::size_t> rest(qubits.begin() + prefix.size(),
+                                    qubits.end());
+      auto result = StabilizerCircuitSimulator::sample(rest, shots);
+      for (auto &[bits, count] : result.counts)
+        counts[prefix + bits] += count;
+      return;
+    }
+
+    const auto q = qubits[prefix.size()];
+    const auto ones = std::binomial_distribution<std::size_t>(
+        shots, probabilityOfOne(q))(randomEngine);
+    for (bool result : {false, true}) {
+      const auto branchShots = result ? ones : shots - ones;
+      if (branchShots == 0)
+        continue;
+      auto savedTableau = tableau;
+      auto savedTerms = terms;
+      projectQubit(q, result);
+      prefix.push_back(result ? '1' : '0');
+      sampleBranch(qubits, branchShots, prefix, counts);
+      prefix.pop_back();
+      tableau = std::move(savedTableau);
+      terms = std::move(savedTerms);
+    }
+  }
+
+  [[noreturn]] void
+  throwNonClifford(const std::string &gateName,
+                   const std::vector<std::size_t> &controls,
+                   const std::vector<double> &params = {}) override {
+    std::string gate = std::string(controls.size(), 'c') + gateName;
+    if (!params.empty()) {
+      gate += "(";
+      for (std::size_t i = 0; i < params.size(); i++)
+        gate += (i ? ", " : "") + std::to_string(params[i]);
+      gate += ")";
+    }
+    throw std::runtime_error(
+        "The extended stabilizer backend does not support " + gate + ".");
+  }
+
+  /// @brief Apply a rotation by any angle, with at most one control.
+  void extendedRotation(const std::string &gateName, char axis, double angle,
+                        const std::vector<std::size_t> &controls,
+                        std::size_t q) {
+    CUDAQ_INFO(gateToString(gateName, controls, {angle}, {q}));
+    if (skipPrefixGate(gateName, {angle}, controls, {q}))
+      return;
+    if (controls.size() > 1)
+      throwNonClifford(gateName, controls, {angle});
+    if (controls.empty())
+      applyAxisRotation(axis, angle, q);
+    else
+      applyControlledRotation(axis, gateName == "r1" || gateName == "u1",
+                              angle, controls[0], q);
+  }
+
+  /// @brief The terms are keyed by as many words as the tableau rows.
+  void addQubitToState() override {
+    StabilizerCircuitSimulator::addQubitToState();
+    if (terms.empty() || terms.begin()->first.size() == tableau.stride)
+      return;
+    Terms grown;
+    grown.reserve(terms.size());
+    for (auto &[s, amplitude] : terms) {
+      auto key = s;
+      key.resize(tableau.stride);
+      grown.emplace(std::move(key), amplitude);
+    }
+    terms = std::move(grown);
+  }
+
+  void resetQubitStateImpl() override {
+    StabilizerCircuitSimulator::resetQubitStateImpl();
+    terms = {{std::vector<Word>(), 1.}};
+  }
+
+  bool saveStateSnapshot() override {
+    termsSnapshot = terms;
+    return StabilizerCircuitSimulator::saveStateSnapshot();
+  }
+
+  bool restoreStateSnapshot() override {
+    if (!StabilizerCircuitSimulator::restoreStateSnapshot())
+      return false;
+    terms = termsSnapshot;
+    return true;
+  }
+
+  void clearStateSnapshot() override {
+    StabilizerCircuitSimulator::clearStateSnapshot();
+    termsSnapshot.clear();
+  }
+
+  std::size_t getStateBytes() override {
+    return StabilizerCircuitSimulator::getStateBytes() +
+           terms.size() * (tableau.stride * sizeof(Word) +
+                           sizeof(std::complex<double>));
+  }
+
+  bool measureQubit(const std::size_t qubitIdx) override {
+    synchronizeState();
+    if (absorbSingleTerm())
+      return StabilizerCircuitSimulator::measureQubit(qubitIdx);
+    const bool result =
+        std::uniform_real_distribution<double>()(randomEngine) <
+        probabilityOfOne(qubitIdx);
+    projectQubit(qubitIdx, result);
+    cudaq::info("Measured qubit {} -> {} ({} terms)", qubitIdx, result,
+                terms.size());
+    return result;
+  }
+
+public:
+  ExtendedStabilizerCircuitSimulator() { resetQubitStateImpl(); }
+  virtual ~ExtendedStabilizerCircuitSimulator() = default;
+
+  /// @brief Return the number of stabilizer states in the superposition.
+  std::size_t getNumTerms() const { return terms.size(); }
+
+  using CircuitSimulator::x;
+  void x(const std::vector<std::size_t> &controls,
+         const std::size_t qubitIdx) override {
+    if (controls.size() != 2)
+      return StabilizerCircuitSimulator::x(controls, qubitIdx);
+    CUDAQ_INFO(gateToString("x", controls, {}, {qubitIdx}));
+    if (skipPrefixGate("x", {}, controls, {qubitIdx}))
+      return;
+    applyToffoli(controls[0], controls[1], qubitIdx);
+  }
+
+  using CircuitSimulator::z;
+  void z(const std::vector<std::size_t> &controls,
+         const std::size_t qubitIdx) override {
+    if (controls.size() != 2)
+      return StabilizerCircuitSimulator::z(controls, qubitIdx);
+    CUDAQ_INFO(gateToString("z", controls, {}, {qubitIdx}));
+    if (skipPrefixGate("z", {}, controls, {qubitIdx}))
+      return;
+    applyH(qubitIdx);
+    applyToffoli(controls[0], controls[1], qubitIdx);
+    applyH(qubitIdx);
+  }
+
+/// The phase gates, controlled versions are cr1 rotations
+#define EXTENDED_STABILIZER_PHASE_METHOD_OVERRIDE(NAME, ANGLE)                 \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const std::vector<std::size_t> &controls,                          \
+            const std::size_t qubitIdx) override {                             \
+    if (controls.empty() && quarterTurns(ANGLE))                               \
+      return StabilizerCircuitSimulator::NAME(controls, qubitIdx);             \
+    CUDAQ_INFO(gateToString(#NAME, controls, {}, {qubitIdx}));                 \
+    if (skipPrefixGate(#NAME, {}, controls, {qubitIdx}))                       \
+      return;                                                                  \
+    if (controls.size() > 1)                                                   \
+      throwNonClifford(#NAME, controls);                                       \
+    if (controls.empty())                                                      \
+      applyAxisRotation('z', ANGLE, qubitIdx);                                 \
+    else                                                                       \
+      applyControlledRotation('z', true, ANGLE, controls[0], qubitIdx);        \
+  }
+
+  EXTENDED_STABILIZER_PHASE_METHOD_OVERRIDE(s, M_PI_2)
+  EXTENDED_STABILIZER_PHASE_METHOD_OVERRIDE(sdg, -M_PI_2)
+  EXTENDED_STABILIZER_PHASE_METHOD_OVERRIDE(t, M_PI_4)
+  EXTENDED_STABILIZER_PHASE_METHOD_OVERRIDE(tdg, -M_PI_4)
+
+#undef EXTENDED_STABILIZER_PHASE_METHOD_OVERRIDE
+
+/// The rotations by any angle
+#define EXTENDED_STABILIZER_ROTATION_METHOD_OVERRIDE(NAME, AXIS)               \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const double angle, const std::vector<std::size_t> &controls,      \
+            const std::size_t qubitIdx) override {                             \
+    extendedRotation(#NAME, AXIS, angle, controls, qubitIdx);                  \
+  }
+
+  EXTENDED_STABILIZER_ROTATION_METHOD_OVERRIDE(rx, 'x')
+  EXTENDED_STABILIZER_ROTATION_METHOD_OVERRIDE(ry, 'y')
+  EXTENDED_STABILIZER_ROTATION_METHOD_OVERRIDE(rz, 'z')
+  EXTENDED_STABILIZER_ROTATION_METHOD_OVERRIDE(r1, 'z')
+  EXTENDED_STABILIZER_ROTATION_METHOD_OVERRIDE(u1, 'z')
+
+#undef EXTENDED_STABILIZER_ROTATION_METHOD_OVERRIDE
+
+  /// @brief u3(theta, phi, lambda) is rz(lambda) ry(-theta) rz(phi) up to a
+  /// global phase, as in the base class.
+  using CircuitSimulator::u3;
+  void u3(const double theta, const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u3", controls, {theta, phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u3", {theta, phi, lambda}, controls, {qubitIdx}))
+      return;
+    if (!controls.empty())
+      throwNonClifford("u3", controls, {theta, phi, lambda});
+    applyAxisRotation('z', phi, qubitIdx);
+    applyAxisRotation('y', -theta, qubitIdx);
+    applyAxisRotation('z', lambda, qubitIdx);
+  }
+
+  using CircuitSimulator::u2;
+  void u2(const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u2", controls, {phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u2", {phi, lambda}, controls, {qubitIdx}))
+      return;
+    if (!controls.empty())
+      throwNonClifford("u2", controls, {phi, lambda});
+    applyAxisRotation('z', lambda, qubitIdx);
+    applyRotation('y', 1, qubitIdx);
+    applyAxisRotation('z', phi, qubitIdx);
+  }
+
+  /// @brief The Fredkin gate is a Toffoli between two CNOTs.
+  using CircuitSimulator::swap;
+  void swap(const std::vector<std::size_t> &ctrlBits, const std::size_t srcIdx,
+            const std::size_t tgtIdx) override {
+    if (ctrlBits.size() != 1)
+      return StabilizerCircuitSimulator::swap(ctrlBits, srcIdx, tgtIdx);
+    CUDAQ_INFO(gateToString("swap", ctrlBits, {}, {srcIdx, tgtIdx}));
+    if (skipPrefixGate("swap", {}, ctrlBits, {srcIdx, tgtIdx}))
+      return;
+    applyCNOT(tgtIdx, srcIdx);
+    applyToffoli(ctrlBits[0], srcIdx, tgtIdx);
+    applyCNOT(tgtIdx, srcIdx);
+  }
+
+  /// @brief Sample the given qubits. A single stabilizer state is sampled
+  /// by the base class, otherwise the shots are split qubit by qubit, see
+  /// sampleBranch(). The state is left unchanged.
+  cudaq::ExecutionResult sample(const std::vector<std::size_t> &measuredBits,
+                                const int shots) override {
+    synchronizeState();
+    if (absorbSingleTerm())
+      return StabilizerCircuitSimulator::sample(measuredBits, shots);
+
+    PauliString parity{std::vector<Word>(tableau.stride),
+                       std::vector<Word>(tableau.stride)};
+    for (auto q : measuredBits)
+      flipBit(parity.z.data(), q);
+    const double expectationValue = expectation(decompose(parity)).real();
+    if (shots < 1) {
+      cudaq::info("Computed expectation value = {}", expectationValue);
+      return cudaq::ExecutionResult{{}, expectationValue};
+    }
+
+    std::unordered_map<std::string, std::size_t> counts;
+    std::string prefix;
+    sampleBranch(measuredBits, shots, prefix, counts);
+    cudaq::ExecutionResult result(expectationValue);
+    for (auto &[bits, count] : counts)
+      result.appendResult(bits, count);
+    return result;
+  }
+
+  std::string name() const override { return "extended-stabilizer"; }
+  NVQIR_SIMULATOR_CLONE_IMPL(ExtendedStabilizerCircuitSimulator)
+};
+
+} // namespace nvqir
+
+#ifndef __NVQIR_EXTENDED_STABILIZER_TOGGLE_CREATE
+/// Register this Simulator with NVQIR.
+NVQIR_REGISTER_SIMULATOR(nvqir::ExtendedStabilizerCircuitSimulator,
+                         extended_stabilizer)
+#endif
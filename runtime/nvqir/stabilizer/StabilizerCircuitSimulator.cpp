@@ -0,0 +1,679 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CircuitSimulator.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <unordered_map>
+
+namespace nvqir {
+
+/// @brief The StabilizerCircuitSimulator simulates Clifford circuits (h, s,
+/// sdg, x, y, z, cnot, cz, cy, swap, rotations by multiples of pi / 2,
+/// measurement and reset) with the stabilizer tableau of Aaronson and
+/// Gottesman (CHP), at polynomial instead of exponential cost. Gates that are
+/// not Clifford, like t or rx by an arbitrary angle, throw.
+class StabilizerCircuitSimulator : public nvqir::CircuitSimulator {
+protected:
+  using Word = std::uint64_t;
+  static constexpr std::size_t wordBits = 64;
+
+  /// @brief The tableau holds nTableauQubits destabilizer rows followed by as
+  /// many stabilizer rows. Row r is the Pauli string (-1)^signs[r] times the
+  /// product over qubits q of X_q^x Z_q^z (Y for x = z = 1), where x and z
+  /// are bit q of the stride words of the row in xs and zs.
+  struct Tableau {
+    std::size_t nQubits = 0;
+    std::size_t stride = 0;
+    std::vector<Word> xs;
+    std::vector<Word> zs;
+    std::vector<std::uint8_t> signs;
+  };
+
+  Tableau tableau;
+  Tableau snapshot;
+
+  std::mt19937_64 randomEngine;
+
+  static bool getBit(const Word *row, std::size_t q) {
+    return (row[q / wordBits] >> (q % wordBits)) & 1;
+  }
+
+  static void flipBit(Word *row, std::size_t q) {
+    row[q / wordBits] ^= Word(1) << (q % wordBits);
+  }
+
+  Word *xRow(std::size_t r) { return tableau.xs.data() + r * tableau.stride; }
+  Word *zRow(std::size_t r) { return tableau.zs.data() + r * tableau.stride; }
+
+  /// @brief Set the Pauli string (dstX, dstZ) to the product of (srcX, srcZ)
+  /// and itself, ignoring signs. The product is i^k times the new string, k
+  /// (modulo 4) is returned. It is counted for all bit positions of a word in
+  /// parallel.
+  static unsigned multiplyPauliBits(const Word *srcX, const Word *srcZ,
+                                    Word *dstX, Word *dstZ,
+                                    std::size_t stride) {
+    Word count1 = 0, count2 = 0;
+    for (std::size_t w = 0; w < stride; w++) {
+      const Word x1 = srcX[w], z1 = srcZ[w], x2 = dstX[w], z2 = dstZ[w];
+      const Word newX = x1 ^ x2, newZ = z1 ^ z2;
+      const Word x1z2 = x1 & z2;
+      const Word antiCommutes = (x2 & z1) ^ x1z2;
+      count2 ^= (count1 ^ newX ^ newZ ^ x1z2) & antiCommutes;
+      count1 ^= antiCommutes;
+      dstX[w] = newX;
+      dstZ[w] = newZ;
+    }
+    return (std::popcount(count1) + 2 * std::popcount(count2)) & 3;
+  }
+
+  /// @brief Set the Pauli string (dstX, dstZ, dstSign) to the product of
+  /// (srcX, srcZ, srcSign) and itself. Both strings must commute, the sign
+  /// of the product is returned.
+  static bool multiplyInto(const Word *srcX, const Word *srcZ, bool srcSign,
+                           Word *dstX, Word *dstZ, bool dstSign,
+                           std::size_t stride) {
+    const auto phase = multiplyPauliBits(srcX, srcZ, dstX, dstZ, stride) +
+                       2 * (srcSign + dstSign);
+    return (phase & 3) == 2;
+  }
+
+  /// @brief Set row `dst` of the tableau to the product of row `src` and
+  /// row `dst`.
+  void multiplyRows(std::size_t dst, std::size_t src) {
+    tableau.signs[dst] =
+        multiplyInto(xRow(src), zRow(src), tableau.signs[src], xRow(dst),
+                     zRow(dst), tableau.signs[dst], tableau.stride);
+  }
+
+  /// @brief Call `fn(x, z, sign)` with the x and z bits of qubit q in every
+  /// row of the tableau, the bits are written back afterwards.
+  template <typename RowFn>
+  void forEachRow(std::size_t q, RowFn &&fn) {
+    const auto word = q / wordBits;
+    const auto shift = q % wordBits;
+    for (std::size_t r = 0; r < 2 * tableau.nQubits; r++) {
+      auto &xw = tableau.xs[r * tableau.stride + word];
+      auto &zw = tableau.zs[r * tableau.stride + word];
+      bool x = (xw >> shift) & 1, z = (zw >> shift) & 1;
+      bool sign = tableau.signs[r];
+      fn(x, z, sign);
+      xw = (xw & ~(Word(1) << shift)) | (Word(x) << shift);
+      zw = (zw & ~(Word(1) << shift)) | (Word(z) << shift);
+      tableau.signs[r] = sign;
+    }
+  }
+
+  void applyH(std::size_t q) {
+    forEachRow(q, [](bool &x, bool &z, bool &sign) {
+      sign ^= x && z;
+      std::swap(x, z);
+    });
+  }
+
+  void applyS(std::size_t q) {
+    forEachRow(q, [](bool &x, bool &z, bool &sign) {
+      sign ^= x && z;
+      z ^= x;
+    });
+  }
+
+  void applySdg(std::size_t q) {
+    forEachRow(q, [](bool &x, bool &z, bool &sign) {
+      sign ^= x && !z;
+      z ^= x;
+    });
+  }
+
+  void applyX(std::size_t q) {
+    forEachRow(q, [](bool &, bool &z, bool &sign) { sign ^= z; });
+  }
+
+  void applyY(std::size_t q) {
+    forEachRow(q, [](bool &x, bool &z, bool &sign) { sign ^= x != z; });
+  }
+
+  void applyZ(std::size_t q) {
+    forEachRow(q, [](bool &x, bool &, bool &sign) { sign ^= x; });
+  }
+
+  void applyCNOT(std::size_t control, std::size_t target) {
+    for (std::size_t r = 0; r < 2 * tableau.nQubits; r++) {
+      auto *x = xRow(r), *z = zRow(r);
+      const bool xc = getBit(x, control), zc = getBit(z, control);
+      const bool xt = getBit(x, target), zt = getBit(z, target);
+      tableau.signs[r] ^= xc && zt && (xt == zc);
+      if (xc)
+        flipBit(x, target);
+      if (zt)
+        flipBit(z, control);
+    }
+  }
+
+  void applySwap(std::size_t a, std::size_t b) {
+    for (std::size_t r = 0; r < 2 * tableau.nQubits; r++)
+      for (auto *row : {xRow(r), zRow(r)})
+        if (getBit(row, a) != getBit(row, b)) {
+          flipBit(row, a);
+          flipBit(row, b);
+        }
+  }
+
+  /// @brief Apply S^k, which is rz(k pi / 2) up to a global phase.
+  void applySPower(std::size_t k, std::size_t q) {
+    if (k == 1)
+      applyS(q);
+    else if (k == 2)
+      applyZ(q);
+    else if (k == 3)
+      applySdg(q);
+  }
+
+  /// @brief Return the number of quarter turns (modulo 4) of the given
+  /// angle, or std::nullopt if it is not a multiple of pi / 2.
+  static std::optional<std::size_t> quarterTurns(double angle) {
+    const double turns = angle / M_PI_2;
+    const double rounded = std::round(turns);
+    if (std::abs(turns - rounded) > 1e-9)
+      return std::nullopt;
+    return static_cast<std::size_t>(
+        ((static_cast<long long>(rounded) % 4) + 4) % 4);
+  }
+
+  /// @brief Throw for a gate that this backend cannot simulate.
+  [[noreturn]] virtual void
+  throwNonClifford(const std::string &gateName,
+                                     const std::vector<std::size_t> &controls,
+                                     const std::vector<double> &params = {}) {
+    std::string gate = std::string(controls.size(), 'c') + gateName;
+    if (!params.empty()) {
+      gate += "(";
+      for (std::size_t i = 0; i < params.size(); i++)
+        gate += (i ? ", " : "") + std::to_string(params[i]);
+      gate += ")";
+    }
+    throw std::runtime_error(
+        "The stabilizer backend only simulates Clifford circuits, " + gate +
+        " is not a Clifford gate.");
+  }
+
+  /// @brief Apply rz, rx or ry (axis 'z', 'x', 'y') by the given number of
+  /// quarter turns.
+  void applyRotation(char axis, std::size_t turns, std::size_t q) {
+    if (turns == 0)
+      return;
+    if (axis == 'z') {
+      applySPower(turns, q);
+    } else if (axis == 'x') {
+      applyH(q);
+      applySPower(turns, q);
+      applyH(q);
+    } else {
+      // ry(theta) = s rx(theta) sdg
+      applySdg(q);
+      applyRotation('x', turns, q);
+      applyS(q);
+    }
+  }
+
+  /// @brief Apply a rotation gate, which is Clifford if the angle is a
+  /// multiple of pi / 2 and it has no controls (or does nothing).
+  void rotation(const std::string &gateName, char axis, double angle,
+                const std::vector<std::size_t> &controls, std::size_t q) {
+    CUDAQ_INFO(gateToString(gateName, controls, {angle}, {q}));
+    if (skipPrefixGate(gateName, {angle}, controls, {q}))
+      return;
+    auto turns = quarterTurns(angle);
+    if (!turns || (*turns != 0 && !controls.empty()))
+      throwNonClifford(gateName, controls, {angle});
+    applyRotation(axis, *turns, q);
+  }
+
+  /// @brief Grow the tableau to nQubitsAllocated qubits. New qubits start in
+  /// |0>, with destabilizer X_q and stabilizer Z_q.
+  void addQubitToState() override {
+    const std::size_t newQubits = nQubitsAllocated;
+    if (newQubits <= tableau.nQubits)
+      return;
+
+    Tableau grown;
+    grown.nQubits = newQubits;
+    grown.stride = (newQubits + wordBits - 1) / wordBits;
+    grown.xs.resize(2 * newQubits * grown.stride);
+    grown.zs.resize(2 * newQubits * grown.stride);
+    grown.signs.resize(2 * newQubits);
+    const auto oldQubits = tableau.nQubits;
+    for (std::size_t r = 0; r < 2 * oldQubits; r++) {
+      // Stabilizer rows move behind the new destabilizer rows.
+      const auto newRow = r < oldQubits ? r : r - oldQubits + newQubits;
+      std::copy_n(xRow(r), tableau.stride,
+                  grown.xs.data() + newRow * grown.stride);
+      std::copy_n(zRow(r), tableau.stride,
+                  grown.zs.data() + newRow * grown.stride);
+      grown.signs[newRow] = tableau.signs[r];
+    }
+    for (std::size_t q = oldQubits; q < newQubits; q++) {
+      flipBit(grown.xs.data() + q * grown.stride, q);
+      flipBit(grown.zs.data() + (q + newQubits) * grown.stride, q);
+    }
+    tableau = std::move(grown);
+  }
+
+  void resetQubitStateImpl() override { tableau = Tableau(); }
+
+  bool canSnapshotState() override { return true; }
+
+  bool saveStateSnapshot() override {
+    snapshot = tableau;
+    return true;
+  }
+
+  bool restoreStateSnapshot() override {
+    if (snapshot.nQubits != tableau.nQubits)
+      return false;
+    tableau = snapshot;
+    return true;
+  }
+
+  void clearStateSnapshot() override { snapshot = Tableau(); }
+
+  std::size_t getStateBytes() override {
+    return (tableau.xs.size() + tableau.zs.size()) * sizeof(Word) +
+           tableau.signs.size();
+  }
+
+  /// @brief Update the tableau for measuring qubit q with the given result,
+  /// where stabilizer row p is the first that anti-commutes with Z_q. Row p
+  /// becomes the destabilizer of the new stabilizer +-Z_q.
+  void collapseQubit(std::size_t p, std::size_t q, bool result) {
+    const auto n = tableau.nQubits;
+    const auto stride = tableau.stride;
+    for (std::size_t r = 0; r < 2 * n; r++)
+      if (r != p && getBit(xRow(r), q))
+        multiplyRows(r, p);
+    std::copy_n(xRow(p), stride, xRow(p - n));
+    std::copy_n(zRow(p), stride, zRow(p - n));
+    tableau.signs[p - n] = tableau.signs[p];
+    std::fill_n(xRow(p), stride, 0);
+    std::fill_n(zRow(p), stride, 0);
+    flipBit(zRow(p), q);
+    tableau.signs[p] = result;
+  }
+
+  bool measureQubit(const std::size_t qubitIdx) override {
+    synchronizeState();
+    const auto n = tableau.nQubits;
+    const auto stride = tableau.stride;
+
+    // The outcome is random if a stabilizer anti-commutes with Z_q.
+    for (std::size_t p = n; p < 2 * n; p++) {
+      if (!getBit(xRow(p), qubitIdx))
+        continue;
+      const bool result = randomEngine() & 1;
+      collapseQubit(p, qubitIdx, result);
+      cudaq::info("Measured qubit {} -> {}", qubitIdx, result);
+      return result;
+    }
+
+    // Otherwise +-Z_q is the product of the stabilizers whose destabilizers
+    // anti-commute with Z_q.
+    std::vector<Word> x(stride), z(stride);
+    bool sign = false;
+    for (std::size_t i = 0; i < n; i++)
+      if (getBit(xRow(i), qubitIdx))
+        sign = multiplyInto(xRow(i + n), zRow(i + n), tableau.signs[i + n],
+                            x.data(), z.data(), sign, stride);
+    cudaq::info("Measured qubit {} -> {}", qubitIdx, sign);
+    return sign;
+  }
+
+  /// @brief The outcomes of measuring a set of m qubits are distributed
+  /// uniformly over the solutions of a linear system over GF(2), one
+  /// equation per independent stabilizer that is a product of Z on measured
+  /// qubits only. The system is kept in reduced row echelon form.
+  struct OutcomeSpace {
+    std::size_t mWords = 0;
+    std::vector<std::vector<Word>> rows;
+    std::vector<bool> rhs;
+    std::vector<std::size_t> pivots;
+    std::vector<Word> freeMask;
+  };
+
+  /// @brief Compute the OutcomeSpace of measuring the given qubits.
+  OutcomeSpace computeOutcomeSpace(const std::vector<std::size_t> &qubits) {
+    const auto n = tableau.nQubits;
+    const auto stride = tableau.stride;
+    std::vector<Word> xs(xRow(n), xRow(n) + n * stride);
+    std::vector<Word> zs(zRow(n), zRow(n) + n * stride);
+    std::vector<bool> signs(tableau.signs.begin() + n, tableau.signs.end());
+    std::vector<bool> measured(n);
+    for (auto q : qubits)
+      measured[q] = true;
+
+    // Eliminate the X part of all qubits and the Z part of the unmeasured
+    // qubits from the stabilizers, the rows that are left over (never
+    // pivots) are products of Z on measured qubits.
+    std::vector<bool> isPivot(n);
+    auto eliminate = [&](std::vector<Word> &bits, std::size_t q) {
+      std::size_t pivot = n;
+      for (std::size_t r = 0; r < n; r++) {
+        if (isPivot[r] || !getBit(bits.data() + r * stride, q))
+          continue;
+        if (pivot == n) {
+          pivot = r;
+          isPivot[r] = true;
+          continue;
+        }
+        signs[r] = multiplyInto(xs.data() + pivot * stride,
+                                zs.data() + pivot * stride, signs[pivot],
+                                xs.data() + r * stride, zs.data() + r * stride,
+                                signs[r], stride);
+      }
+    };
+    for (std::size_t q = 0; q < n; q++)
+      eliminate(xs, q);
+    for (std::size_t q = 0; q < n; q++)
+      if (!measured[q])
+        eliminate(zs, q);
+
+    OutcomeSpace space;
+    const auto m = qubits.size();
+    space.mWords = (m + wordBits - 1) / wordBits;
+    for (std::size_t r = 0; r < n; r++) {
+      if (isPivot[r])
+        continue;
+      std::vector<Word> row(space.mWords);
+      for (std::size_t j = 0; j < m; j++)
+        if (getBit(zs.data() + r * stride, qubits[j]))
+          flipBit(row.data(), j);
+      space.rows.push_back(std::move(row));
+      space.rhs.push_back(signs[r]);
+    }
+
+    // Bring the system to reduced row echelon form.
+    std::size_t rank = 0;
+    space.freeMask.assign(space.mWords, 0);
+    for (std::size_t j = 0; j < m; j++) {
+      auto iter = std::find_if(
+          space.rows.begin() + rank, space.rows.end(),
+          [&](const std::vector<Word> &row) { return getBit(row.data(), j); });
+      if (iter == space.rows.end()) {
+        flipBit(space.freeMask.data(), j);
+        continue;
+      }
+
+      const auto r = std::distance(space.rows.begin(), iter);
+      std::swap(space.rows[rank], space.rows[r]);
+      std::vector<bool>::swap(space.rhs[rank], space.rhs[r]);
+      for (std::size_t i = 0; i < space.rows.size(); i++) {
+        if (i == rank || !getBit(space.rows[i].data(), j))
+          continue;
+        for (std::size_t w = 0; w < space.mWords; w++)
+          space.rows[i][w] ^= space.rows[rank][w];
+        space.rhs[i] = space.rhs[i] != space.rhs[rank];
+      }
+      space.pivots.push_back(j);
+      rank++;
+    }
+    space.rows.resize(rank);
+    space.rhs.resize(rank);
+    return space;
+  }
+
+  /// @brief Return <Z...Z> over all qubits of the OutcomeSpace, +-1 if the
+  /// parity of the outcomes is fixed and 0 otherwise.
+  static double parityExpectation(const OutcomeSpace &space, std::size_t m) {
+    std::vector<Word> target(space.mWords);
+    for (std::size_t j = 0; j < m; j++)
+      flipBit(target.data(), j);
+    bool parity = false;
+    for (std::size_t i = 0; i < space.pivots.size(); i++) {
+      if (!getBit(target.data(), space.pivots[i]))
+        continue;
+      for (std::size_t w = 0; w < space.mWords; w++)
+        target[w] ^= space.rows[i][w];
+      parity = parity != space.rhs[i];
+    }
+    if (std::any_of(target.begin(), target.end(), [](Word w) { return w; }))
+      return 0.0;
+    return parity ? -1.0 : 1.0;
+  }
+
+public:
+  StabilizerCircuitSimulator() : randomEngine(std::random_device{}()) {}
+  virtual ~StabilizerCircuitSimulator() = default;
+
+  /// @brief The tableau grows quadratically: 2n rows of n x and n z bits.
+  std::size_t getRequiredStateBytes(std::size_t numQubits) override {
+    const std::size_t stride = (numQubits + wordBits - 1) / wordBits;
+    return 2 * numQubits * (2 * stride * sizeof(Word) + 1);
+  }
+
+  void seedRandomEngines(std::uint64_t seed) override {
+    CircuitSimulator::seedRandomEngines(seed);
+    randomEngine.seed(seed);
+  }
+
+  /// @brief Allocate the qubits and grow the tableau once. The state
+  /// dimension is not tracked, it overflows beyond 63 qubits.
+  std::vector<std::size_t> allocateQubits(const std::size_t count) override {
+    std::vector<std::size_t> qubits;
+    for (std::size_t i = 0; i < count; i++)
+      qubits.emplace_back(tracker.getNextIndex());
+    cudaq::info("Allocating {} new qubits (nQ={})", count, nQubitsAllocated);
+    nQubitsAllocated += count;
+    addQubitToState();
+    countStateBytes();
+    return qubits;
+  }
+
+  std::size_t allocateQubit() override { return allocateQubits(1)[0]; }
+
+  using CircuitSimulator::x;
+  void x(const std::vector<std::size_t> &controls,
+         const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("x", controls, {}, {qubitIdx}));
+    if (skipPrefixGate("x", {}, controls, {qubitIdx}))
+      return;
+    if (controls.size() > 1)
+      throwNonClifford("x", controls);
+    if (controls.empty())
+      applyX(qubitIdx);
+    else
+      applyCNOT(controls[0], qubitIdx);
+  }
+
+  using CircuitSimulator::y;
+  void y(const std::vector<std::size_t> &controls,
+         const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("y", controls, {}, {qubitIdx}));
+    if (skipPrefixGate("y", {}, controls, {qubitIdx}))
+      return;
+    if (controls.size() > 1)
+      throwNonClifford("y", controls);
+    if (controls.empty()) {
+      applyY(qubitIdx);
+      return;
+    }
+    applySdg(qubitIdx);
+    applyCNOT(controls[0], qubitIdx);
+    applyS(qubitIdx);
+  }
+
+  using CircuitSimulator::z;
+  void z(const std::vector<std::size_t> &controls,
+         const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("z", controls, {}, {qubitIdx}));
+    if (skipPrefixGate("z", {}, controls, {qubitIdx}))
+      return;
+    if (controls.size() > 1)
+      throwNonClifford("z", controls);
+    if (controls.empty()) {
+      applyZ(qubitIdx);
+      return;
+    }
+    applyH(qubitIdx);
+    applyCNOT(controls[0], qubitIdx);
+    applyH(qubitIdx);
+  }
+
+/// The uncontrolled one-qubit Clifford gates
+#define STABILIZER_ONE_QUBIT_METHOD_OVERRIDE(NAME, APPLY)                      \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const std::vector<std::size_t> &controls,                          \
+            const std::size_t qubitIdx) override {                             \
+    CUDAQ_INFO(gateToString(#NAME, controls, {}, {qubitIdx}));                 \
+    if (skipPrefixGate(#NAME, {}, controls, {qubitIdx}))                       \
+      return;                                                                  \
+    if (!controls.empty())                                                     \
+      throwNonClifford(#NAME, controls);                                       \
+    APPLY(qubitIdx);                                                           \
+  }
+
+  STABILIZER_ONE_QUBIT_METHOD_OVERRIDE(h, applyH)
+  STABILIZER_ONE_QUBIT_METHOD_OVERRIDE(s, applyS)
+  STABILIZER_ONE_QUBIT_METHOD_OVERRIDE(sdg, applySdg)
+
+#undef STABILIZER_ONE_QUBIT_METHOD_OVERRIDE
+
+  using CircuitSimulator::t;
+  void t(const std::vector<std::size_t> &controls,
+         const std::size_t qubitIdx) override {
+    throwNonClifford("t", controls);
+  }
+
+  using CircuitSimulator::tdg;
+  void tdg(const std::vector<std::size_t> &controls,
+           const std::size_t qubitIdx) override {
+    throwNonClifford("tdg", controls);
+  }
+
+/// The rotations, Clifford for multiples of pi / 2
+#define STABILIZER_ROTATION_METHOD_OVERRIDE(NAME, AXIS)                        \
+  using CircuitSimulator::NAME;                                                \
+  void NAME(const double angle, const std::vector<std::size_t> &controls,      \
+            const std::size_t qubitIdx) override {                             \
+    rotation(#NAME, AXIS, angle, controls, qubitIdx);                          \
+  }
+
+  STABILIZER_ROTATION_METHOD_OVERRIDE(rx, 'x')
+  STABILIZER_ROTATION_METHOD_OVERRIDE(ry, 'y')
+  STABILIZER_ROTATION_METHOD_OVERRIDE(rz, 'z')
+  STABILIZER_ROTATION_METHOD_OVERRIDE(r1, 'z')
+  STABILIZER_ROTATION_METHOD_OVERRIDE(u1, 'z')
+
+#undef STABILIZER_ROTATION_METHOD_OVERRIDE
+
+  /// @brief The u3(theta, phi, lambda) matrix of getGateByName is
+  /// rz(lambda) ry(-theta) rz(phi) up to a global phase.
+  using CircuitSimulator::u3;
+  void u3(const double theta, const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u3", controls, {theta, phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u3", {theta, phi, lambda}, controls, {qubitIdx}))
+      return;
+    auto thetaTurns = quarterTurns(theta), phiTurns = quarterTurns(phi),
+         lambdaTurns = quarterTurns(lambda);
+    if (!thetaTurns || !phiTurns || !lambdaTurns || !controls.empty())
+      throwNonClifford("u3", controls, {theta, phi, lambda});
+    applyRotation('z', *phiTurns, qubitIdx);
+    applyRotation('y', (4 - *thetaTurns) % 4, qubitIdx);
+    applyRotation('z', *lambdaTurns, qubitIdx);
+  }
+
+  /// @brief u2(phi, lambda) is rz(phi) ry(pi / 2) rz(lambda) up to a global
+  /// phase.
+  using CircuitSimulator::u2;
+  void u2(const double phi, const double lambda,
+          const std::vector<std::size_t> &controls,
+          const std::size_t qubitIdx) override {
+    CUDAQ_INFO(gateToString("u2", controls, {phi, lambda}, {qubitIdx}));
+    if (skipPrefixGate("u2", {phi, lambda}, controls, {qubitIdx}))
+      return;
+    auto phiTurns = quarterTurns(phi), lambdaTurns = quarterTurns(lambda);
+    if (!phiTurns || !lambdaTurns || !controls.empty())
+      throwNonClifford("u2", controls, {phi, lambda});
+    applyRotation('z', *lambdaTurns, qubitIdx);
+    applyRotation('y', 1, qubitIdx);
+    applyRotation('z', *phiTurns, qubitIdx);
+  }
+
+  using CircuitSimulator::swap;
+  void swap(const std::vector<std::size_t> &ctrlBits, const std::size_t srcIdx,
+            const std::size_t tgtIdx) override {
+    CUDAQ_INFO(gateToString("swap", ctrlBits, {}, {srcIdx, tgtIdx}));
+    if (skipPrefixGate("swap", {}, ctrlBits, {srcIdx, tgtIdx}))
+      return;
+    if (!ctrlBits.empty())
+      throwNonClifford("swap", ctrlBits);
+    applySwap(srcIdx, tgtIdx);
+  }
+
+  void resetQubit(const std::size_t qubitIdx) override {
+    if (measureQubit(qubitIdx))
+      applyX(qubitIdx);
+  }
+
+  /// @brief Sample the given qubits. The outcome space is computed once,
+  /// each shot then only draws the free outcome bits and solves for the
+  /// others.
+  cudaq::ExecutionResult sample(const std::vector<std::size_t> &measuredBits,
+                                const int shots) override {
+    synchronizeState();
+    const auto m = measuredBits.size();
+    auto space = computeOutcomeSpace(measuredBits);
+    const double expectationValue = parityExpectation(space, m);
+    if (shots < 1) {
+      cudaq::info("Computed expectation value = {}", expectationValue);
+      return cudaq::ExecutionResult{{}, expectationValue};
+    }
+
+    std::unordered_map<std::string, std::size_t> counts;
+    std::vector<Word> outcome(space.mWords);
+    std::string bitstring(m, '0');
+    for (int shot = 0; shot < shots; shot++) {
+      for (std::size_t w = 0; w < space.mWords; w++)
+        outcome[w] = randomEngine() & space.freeMask[w];
+      for (std::size_t i = 0; i < space.pivots.size(); i++) {
+        std::size_t parity = space.rhs[i];
+        for (std::size_t w = 0; w < space.mWords; w++)
+          parity += std::popcount(space.rows[i][w] & outcome[w]);
+        if (parity & 1)
+          flipBit(outcome.data(), space.pivots[i]);
+      }
+      for (std::size_t j = 0; j < m; j++)
+        bitstring[j] = getBit(outcome.data(), j) ? '1' : '0';
+      counts[bitstring]++;
+    }
+
+    cudaq::ExecutionResult result(expectationValue);
+    for (auto &[bits, count] : counts)
+      result.appendResult(bits, count);
+    return result;
+  }
+
+  cudaq::State getStateData() override {
+    throw std::runtime_error(
+        "The stabilizer backend does not provide the state vector.");
+  }
+
+  std::string name() const override { return "stabilizer"; }
+  NVQIR_SIMULATOR_CLONE_IMPL(StabilizerCircuitSimulator)
+};
+
+} // namespace nvqir
+
+#ifndef __NVQIR_STABILIZER_TOGGLE_CREATE
+/// Register this Simulator with NVQIR.
+NVQIR_REGISTER_SIMULATOR(nvqir::StabilizerCircuitSimulator, stabilizer)
+#endif
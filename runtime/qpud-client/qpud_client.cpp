@@ -10,15 +10,22 @@
 #pragma GCC diagnostic ignored "-Wsuggest-override"
 #endif
 #include "qpud_client.h"
+#include "common/Logger.h"
+#include "common/SharedBuffer.h"
+#include "cudaq/algorithms/observe.h"
 #include "nlohmann/json.hpp"
 #include "rpc/client.h"
 #include "rpc/rpc_error.h"
 #include "llvm/Support/Program.h"
 
 #include <fmt/core.h>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <random>
+#include <unordered_map>
 
 #if defined(__APPLE__) && defined(__MACH__)
 #include <mach-o/dyld.h>
@@ -96,7 +103,7 @@ void captureHostCommandLineArgs(int argc, char **argv, char **) {
 /// error
 template <typename... Args>
 auto invokeCall(rpc::client *client, const std::string &functionName,
-                Args &...args) {
+                const Args &...args) {
   try {
     // Load the quake code to the QPU
     return client->call(functionName, args...);
@@ -108,7 +115,9 @@ auto invokeCall(rpc::client *client, const std::string &functionName,
   }
 }
 
-llvm::sys::ProcessInfo qpud_client::startDaemon() {
+/// @brief Return the path of the NVQIR backend library this executable is
+/// linked to, the qpud JIT engine needs it.
+static std::string getLinkedNVQIRLibrary() {
   // We need to know what NVQIR backend we were compiled
   // with. Here we loop over all linked libraries to get the nvqir backend
   // library
@@ -118,6 +127,11 @@ llvm::sys::ProcessInfo qpud_client::startDaemon() {
 #else
   dl_iterate_phdr(getNVQIRLibraryPath, &data);
 #endif
+  return data.path;
+}
+
+llvm::sys::ProcessInfo qpud_client::startDaemon() {
+  NVQIRLibraryData data{getLinkedNVQIRLibrary()};
   qpudJITExtraLibraries.push_back(data.path);
 
   std::random_device rd;
@@ -154,6 +168,27 @@ llvm::sys::ProcessInfo qpud_client::startDaemon() {
   return qpudProcInfo;
 }
 
+bool qpud_client::connect(int attempts) {
+  rpc::client::connection_state state =
+      rpc::client::connection_state::disconnected;
+  for (auto i = 0; i < attempts; ++i) {
+    rpcClient = std::make_unique<rpc::client>(url, port);
+    state = rpcClient->get_connection_state();
+    // Upon construction, the client is at state `initial` and tries to
+    // connect to the server using an asynchronous call.  This is basically
+    // a spin lock to wait for the return of this call, which should be
+    // either a `connected` or `disconnected` state.
+    while (state == rpc::client::connection_state::initial) {
+      state = rpcClient->get_connection_state();
+    };
+    if (state == rpc::client::connection_state::connected)
+      return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  }
+  rpcClient.reset();
+  return false;
+}
+
 rpc::client *qpud_client::getClient(bool startServer) {
   if (!rpcClient && startServer) {
     auto qpudProcInfo = startDaemon();
@@ -161,22 +196,7 @@ rpc::client *qpud_client::getClient(bool startServer) {
     // run into the problem that when we try to connect to it, the server didn't
     // had enough time to initialize. So here, we try to connect 10 times with
     // a waiting time between each try.
-    rpc::client::connection_state state;
-    for (auto i = 0; i < 10; ++i) {
-      rpcClient = std::make_unique<rpc::client>(url, port);
-      state = rpcClient->get_connection_state();
-      // Upon construction, the client is at state `initial` and tries to
-      // connect to the server using an asynchronous call.  This is basically
-      // a spin lock to wait for the return of this call, which should be
-      // either a `connected` or `disconnected` state.
-      while (state == rpc::client::connection_state::initial) {
-        state = rpcClient->get_connection_state();
-      };
-      if (state == rpc::client::connection_state::connected)
-        break;
-      std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    }
-    if (state == rpc::client::connection_state::disconnected) {
+    if (!connect(10)) {
       if (qpudProcInfo.Pid) {
         // If the QPU daemon stated, but we were not able to connect to it, we
         // kill it. (This call needs a SecondsToWait > 0 to kill the process)
@@ -206,6 +226,60 @@ void qpud_client::jitQuakeIfUnseen(const std::string &kernelName) {
 /// This will also allocate a random port
 qpud_client::qpud_client() {}
 
+qpud_client::qpud_client(const std::string &qpudUrl, const int qpudPort)
+    : url(qpudUrl), port(qpudPort), ownsDaemon(false) {
+  qpudJITExtraLibraries.push_back(getLinkedNVQIRLibrary());
+  if (!connect(3))
+    throw std::runtime_error(fmt::format(
+        "Could not connect to remote qpud process at {}:{}", url, port));
+}
+
+bool qpud_client::is_healthy(std::chrono::milliseconds timeout) {
+  if (!rpcClient || rpcClient->get_connection_state() !=
+                        rpc::client::connection_state::connected)
+    return false;
+  rpcClient->set_timeout(timeout.count());
+  bool healthy = true;
+  try {
+    rpcClient->call("getIsSimulator");
+  } catch (std::exception &e) {
+    cudaq::info("qpud at {}:{} failed its health check ({}).", url, port,
+                e.what());
+    healthy = false;
+  }
+  rpcClient->clear_timeout();
+  return healthy;
+}
+
+SharedBuffer *qpud_client::getSharedBuffer(void *runtimeArgs,
+                                           std::size_t argsSize) {
+  rpc::client *client = getClient();
+  if (!sharedBufferSetUp) {
+    sharedBufferSetUp = true;
+    if (auto *env = std::getenv("CUDAQ_QPUD_SHARED_BUFFER");
+        env && std::string(env) == "0")
+      return nullptr;
+    try {
+      // qpud runs on this host, it maps the buffer by name.
+      sharedBuffer = SharedBuffer::create(1 << 20);
+      if (!client->call("attachSharedBuffer", sharedBuffer->getName())
+               .as<bool>())
+        sharedBuffer.reset();
+    } catch (std::exception &e) {
+      cudaq::info("Kernel data goes through RPC, no shared buffer ({}).",
+                  e.what());
+      sharedBuffer.reset();
+    }
+  }
+  if (!sharedBuffer)
+    return nullptr;
+
+  sharedBuffer->reserve(argsSize);
+  if (argsSize)
+    std::memcpy(sharedBuffer->data(), runtimeArgs, argsSize);
+  return sharedBuffer.get();
+}
+
 void qpud_client::set_backend(const std::string &backend) {
   // Get the client, if not set, create it
   rpc::client *client = getClient();
@@ -232,13 +306,22 @@ void qpud_client::execute(const std::string &kernelName, void *runtimeArgs,
   // Tell the QPUD to JIT compile the code
   jitQuakeIfUnseen(kernelName);
 
-  // Map the runtime args to a vector<uint8_t>
-  uint8_t *buf = (uint8_t *)runtimeArgs;
-  std::vector<uint8_t> vec_buf(buf, buf + argsSize);
-
-  // No context has been set, just calling base execute
-  auto updatedArgs = invokeCall(client, "executeKernel", kernelName, vec_buf)
-                         .as<std::vector<uint8_t>>();
+  // No context has been set, just calling base execute, on the arguments in
+  // the shared buffer if there is one.
+  std::vector<uint8_t> updatedArgs;
+  if (auto *shared = getSharedBuffer(runtimeArgs, argsSize)) {
+    auto size = invokeCall(client, "executeKernelShared", kernelName,
+                           static_cast<std::uint64_t>(argsSize))
+                    .as<std::uint64_t>();
+    auto *data = reinterpret_cast<uint8_t *>(shared->data());
+    updatedArgs.assign(data, data + size);
+  } else {
+    // Map the runtime args to a vector<uint8_t>
+    uint8_t *buf = (uint8_t *)runtimeArgs;
+    std::vector<uint8_t> vec_buf(buf, buf + argsSize);
+    updatedArgs = invokeCall(client, "executeKernel", kernelName, vec_buf)
+                      .as<std::vector<uint8_t>>();
+  }
 
   if (updatedArgs.size() > argsSize) {
     assert(resultOff != NoResultOffset && "result offset must be given");
@@ -269,14 +352,22 @@ sample_result qpud_client::sample(const std::string &kernelName,
   // Tell the QPUD to JIT compile the code
   jitQuakeIfUnseen(kernelName);
 
-  // Map the runtime args to a vector<uint8_t>
-  uint8_t *buf = (uint8_t *)runtimeArgs;
-  std::vector<uint8_t> vec_buf(buf, buf + argsSize);
-
-  // Tell teh QPUD to sample
-  auto countsData =
-      invokeCall(client, "sampleKernel", kernelName, shots, vec_buf)
-          .as<ResultType>();
+  // Tell the QPUD to sample, the arguments and counts go through the shared
+  // buffer if there is one.
+  ResultType countsData;
+  if (auto *shared = getSharedBuffer(runtimeArgs, argsSize)) {
+    auto words = invokeCall(client, "sampleKernelShared", kernelName, shots,
+                            static_cast<std::uint64_t>(argsSize))
+                     .as<std::uint64_t>();
+    auto *data = reinterpret_cast<std::size_t *>(shared->data());
+    countsData.assign(data, data + words);
+  } else {
+    // Map the runtime args to a vector<uint8_t>
+    uint8_t *buf = (uint8_t *)runtimeArgs;
+    std::vector<uint8_t> vec_buf(buf, buf + argsSize);
+    countsData = invokeCall(client, "sampleKernel", kernelName, shots, vec_buf)
+                     .as<ResultType>();
+  }
 
   // Deserialize the result and return
   sample_result counts;
@@ -332,22 +423,186 @@ observe_result qpud_client::observe(const std::string &kernelName,
   jitQuakeIfUnseen(kernelName);
 
   // Serialize the spin op
-  std::vector<double> H_data = spinOp.getDataRepresentation();
-
-  // Map the runtime args to a vector<uint8_t>
-  uint8_t *buf = (uint8_t *)runtimeArgs;
-  std::vector<uint8_t> vec_buf(buf, buf + argsSize);
-
-  // Invoke the observation function
-  auto result =
-      invokeCall(client, "observeKernel", kernelName, H_data, shots, vec_buf)
-          .as<ResultType>();
+  std::vector<std::uint64_t> H_data = spinOp.getPackedRepresentation();
+
+  // Invoke the observation function, the arguments and counts go through
+  // the shared buffer if there is one.
+  ResultType result;
+  if (auto *shared = getSharedBuffer(runtimeArgs, argsSize)) {
+    auto [exp, words] =
+        invokeCall(client, "observeKernelShared", kernelName, H_data, shots,
+                   static_cast<std::uint64_t>(argsSize))
+            .as<std::tuple<double, std::uint64_t>>();
+    auto *data = reinterpret_cast<std::size_t *>(shared->data());
+    result = {exp, std::vector<std::size_t>(data, data + words)};
+  } else {
+    // Map the runtime args to a vector<uint8_t>
+    uint8_t *buf = (uint8_t *)runtimeArgs;
+    std::vector<uint8_t> vec_buf(buf, buf + argsSize);
+    result =
+        invokeCall(client, "observeKernel", kernelName, H_data, shots, vec_buf)
+            .as<ResultType>();
+  }
   // Handle counts
   sample_result data;
   data.deserialize(std::get<1>(result));
   return observe_result(std::get<0>(result), spinOp, data);
 }
 
+/// @brief Return the result of an asynchronous call, with the error of
+/// qpud rethrown as by invokeCall().
+template <typename ResultType>
+ResultType getAsyncResult(std::future<clmdep_msgpack::object_handle> &future) {
+  try {
+    return future.get().as<ResultType>();
+  } catch (rpc::rpc_error &e) {
+    throw std::runtime_error("[qpud::" + e.get_function_name() + "] " +
+                             e.get_error().as<std::string>());
+  }
+}
+
+std::future<sample_result>
+qpud_client::sample_async(const std::string &kernelName,
+                          const std::size_t shots, void *runtimeArgs,
+                          std::size_t argsSize) {
+  rpc::client *client = getClient();
+  jitQuakeIfUnseen(kernelName);
+
+  // The shared buffer holds one request at a time, the arguments of
+  // requests in flight go through RPC.
+  uint8_t *buf = (uint8_t *)runtimeArgs;
+  std::vector<uint8_t> vec_buf(buf, buf + argsSize);
+  auto pending = client->async_call("sampleKernel", kernelName, shots, vec_buf);
+  return std::async(std::launch::deferred,
+                    [pending = std::move(pending)]() mutable {
+                      auto countsData =
+                          getAsyncResult<std::vector<std::size_t>>(pending);
+                      sample_result counts;
+                      counts.deserialize(countsData);
+                      return counts;
+                    });
+}
+
+std::future<observe_result>
+qpud_client::observe_async(const std::string &kernelName,
+                           cudaq::spin_op &spinOp, void *runtimeArgs,
+                           std::size_t argsSize, std::size_t shots) {
+  using ResultType = std::tuple<double, std::vector<std::size_t>>;
+  rpc::client *client = getClient();
+  jitQuakeIfUnseen(kernelName);
+
+  std::vector<std::uint64_t> H_data = spinOp.getPackedRepresentation();
+  uint8_t *buf = (uint8_t *)runtimeArgs;
+  std::vector<uint8_t> vec_buf(buf, buf + argsSize);
+  auto pending =
+      client->async_call("observeKernel", kernelName, H_data, shots, vec_buf);
+  return std::async(std::launch::deferred,
+                    [pending = std::move(pending), spinOp]() mutable {
+                      auto result = getAsyncResult<ResultType>(pending);
+                      sample_result data;
+                      data.deserialize(std::get<1>(result));
+                      return observe_result(std::get<0>(result), spinOp, data);
+                    });
+}
+
+/// @brief The results of a batch submitted to qpud. Waiting on the future
+/// of any of its executions fetches the results finished so far, and keeps
+/// those of the other executions for their futures.
+class BatchResults {
+  using Result = std::tuple<double, std::vector<std::size_t>>;
+  rpc::client *client;
+  std::uint64_t batchId;
+  std::unordered_map<std::uint64_t, Result> finished;
+  std::string error;
+  std::mutex lock;
+
+public:
+  BatchResults(rpc::client *c, std::uint64_t id) : client(c), batchId(id) {}
+
+  /// @brief Return the result of the execution of the given index, waiting
+  /// for it.
+  Result get(std::uint64_t index) {
+    std::lock_guard<std::mutex> l(lock);
+    while (true) {
+      if (auto iter = finished.find(index); iter != finished.end()) {
+        auto result = std::move(iter->second);
+        finished.erase(iter);
+        return result;
+      }
+      if (!error.empty())
+        throw std::runtime_error(error);
+      try {
+        using FetchType = std::vector<
+            std::tuple<std::uint64_t, double, std::vector<std::size_t>>>;
+        auto results =
+            client->call("fetchBatchResults", batchId).as<FetchType>();
+        for (auto &[i, exp, counts] : results)
+          finished.emplace(i, Result{exp, std::move(counts)});
+      } catch (rpc::rpc_error &e) {
+        error = "[qpud::" + e.get_function_name() + "] " +
+                e.get_error().as<std::string>();
+      }
+    }
+  }
+};
+
+/// @brief Submit the batch of the kernel on the argument sets, and return
+/// the results of the batch.
+static std::shared_ptr<BatchResults>
+submitBatch(rpc::client *client, const std::string &kernelName,
+            const std::vector<std::uint64_t> &H_data, std::size_t shots,
+            const std::vector<std::pair<void *, std::size_t>> &argSets) {
+  std::vector<std::vector<uint8_t>> vec_bufs;
+  vec_bufs.reserve(argSets.size());
+  for (auto &[args, size] : argSets) {
+    auto *buf = static_cast<uint8_t *>(args);
+    vec_bufs.emplace_back(buf, buf + size);
+  }
+  auto batchId = invokeCall(client, "submitKernelBatch", kernelName, H_data,
+                            shots, vec_bufs)
+                     .as<std::uint64_t>();
+  return std::make_shared<BatchResults>(client, batchId);
+}
+
+std::vector<std::future<sample_result>> qpud_client::sample_batch(
+    const std::string &kernelName, const std::size_t shots,
+    const std::vector<std::pair<void *, std::size_t>> &argSets) {
+  rpc::client *client = getClient();
+  jitQuakeIfUnseen(kernelName);
+
+  auto batch = submitBatch(client, kernelName, {}, shots, argSets);
+  std::vector<std::future<sample_result>> results;
+  for (std::uint64_t i = 0; i < argSets.size(); i++)
+    results.push_back(std::async(std::launch::deferred, [batch, i]() {
+      auto countsData = std::get<1>(batch->get(i));
+      sample_result counts;
+      counts.deserialize(countsData);
+      return counts;
+    }));
+  return results;
+}
+
+std::vector<std::future<observe_result>> qpud_client::observe_batch(
+    const std::string &kernelName, cudaq::spin_op &spinOp,
+    const std::vector<std::pair<void *, std::size_t>> &argSets,
+    std::size_t shots) {
+  rpc::client *client = getClient();
+  jitQuakeIfUnseen(kernelName);
+
+  auto batch = submitBatch(client, kernelName,
+                           spinOp.getPackedRepresentation(), shots, argSets);
+  std::vector<std::future<observe_result>> results;
+  for (std::uint64_t i = 0; i < argSets.size(); i++)
+    results.push_back(
+        std::async(std::launch::deferred, [batch, i, spinOp]() mutable {
+          auto [exp, countsData] = batch->get(i);
+          sample_result counts;
+          counts.deserialize(countsData);
+          return observe_result(exp, spinOp, counts);
+        }));
+  return results;
+}
+
 detached_job qpud_client::observe_detach(const std::string &kernelName,
                                          cudaq::spin_op &spinOp,
                                          void *runtimeArgs,
@@ -362,7 +617,7 @@ detached_job qpud_client::observe_detach(const std::string &kernelName,
   jitQuakeIfUnseen(kernelName);
 
   // Serialize the spin op
-  std::vector<double> H_data = spinOp.getDataRepresentation();
+  std::vector<std::uint64_t> H_data = spinOp.getPackedRepresentation();
 
   // Map the runtime args to a vector<uint8_t>
   uint8_t *buf = (uint8_t *)runtimeArgs;
@@ -388,9 +643,8 @@ observe_result qpud_client::observe(cudaq::spin_op &spinOp, detached_job &job) {
   double sum = 0.0;
   sample_result global;
   std::vector<ExecutionResult> sampleResults;
-  for (std::size_t i = 0; i < spinOp.n_terms(); i++) {
-    auto term = spinOp[i];
-    auto realCoeff = term.get_term_coefficient(0).real();
+  for (auto term : spinOp.terms()) {
+    auto realCoeff = term.get_coefficient().real();
     if (term.is_identity())
       sum += realCoeff;
     else {
@@ -401,18 +655,247 @@ observe_result qpud_client::observe(cudaq::spin_op &spinOp, detached_job &job) {
       sample_result m;
       m.deserialize(std::get<1>(result));
 
-      sampleResults.emplace_back(m.to_map(), term.to_string(false));
+      auto &termResult = sampleResults.emplace_back(m.extract_register());
+      termResult.registerName = term.to_string(false);
 
       sum += realCoeff * std::get<0>(result);
       counter++;
     }
   }
-  sample_result m(sampleResults);
-  return observe_result(sum, spinOp, m);
+  return observe_result(sum, spinOp, sample_result(std::move(sampleResults)));
+}
+
+qpud_cluster::qpud_cluster(const std::vector<endpoint> &endpoints,
+                           std::size_t maxInFlightPerEndpoint)
+    : maxInFlight(std::max<std::size_t>(maxInFlightPerEndpoint, 1)) {
+  for (auto &address : endpoints)
+    nodes.push_back({address, nullptr});
+  if (!check_health())
+    throw std::runtime_error("None of the " + std::to_string(nodes.size()) +
+                             " qpud endpoints of the cluster is healthy.");
+}
+
+qpud_cluster::~qpud_cluster() = default;
+
+std::size_t qpud_cluster::check_health(std::chrono::milliseconds timeout) {
+  std::vector<std::size_t> nowHealthy;
+  for (std::size_t i = 0; i < nodes.size(); i++) {
+    auto &node = nodes[i];
+    if (!node.client) {
+      try {
+        node.client = std::make_unique<qpud_client>(node.address.first,
+                                                    node.address.second);
+      } catch (std::exception &e) {
+        cudaq::info("qpud cluster endpoint {}:{} is unreachable ({}).",
+                    node.address.first, node.address.second, e.what());
+      }
+    }
+    const bool isHealthy = node.client && node.client->is_healthy(timeout);
+    if (isHealthy)
+      nowHealthy.push_back(i);
+  }
+
+  std::lock_guard<std::mutex> l(lock);
+  for (std::size_t i = 0; i < nodes.size(); i++)
+    nodes[i].healthy =
+        std::find(nowHealthy.begin(), nowHealthy.end(), i) != nowHealthy.end();
+  // The measured speeds are those of the healthy nodes, in order.
+  if (nowHealthy != healthy || !history)
+    history = std::make_shared<details::qpu_throughput_history>();
+  healthy = std::move(nowHealthy);
+  released.notify_all();
+  return healthy.size();
+}
+
+std::size_t qpud_cluster::num_healthy() {
+  std::lock_guard<std::mutex> l(lock);
+  return healthy.size();
+}
+
+void qpud_cluster::set_backend(const std::string &backend) {
+  for (auto &node : nodes)
+    if (node.client)
+      node.client->set_backend(backend);
+}
+
+void qpud_cluster::acquire(std::size_t node) {
+  std::unique_lock<std::mutex> l(lock);
+  released.wait(l, [&]() { return nodes[node].inFlight < maxInFlight; });
+  nodes[node].inFlight++;
+}
+
+std::size_t qpud_cluster::acquireAny() {
+  std::unique_lock<std::mutex> l(lock);
+  std::size_t chosen = nodes.size();
+  released.wait(l, [&]() {
+    if (healthy.empty())
+      throw std::runtime_error("No healthy qpud endpoint left in the cluster.");
+    chosen = healthy.front();
+    for (auto i : healthy)
+      if (nodes[i].inFlight < nodes[chosen].inFlight)
+        chosen = i;
+    return nodes[chosen].inFlight < maxInFlight;
+  });
+  nodes[chosen].inFlight++;
+  return chosen;
+}
+
+void qpud_cluster::release(std::size_t node, bool failed) {
+  {
+    std::lock_guard<std::mutex> l(lock);
+    nodes[node].inFlight--;
+    if (failed && nodes[node].healthy) {
+      nodes[node].healthy = false;
+      std::erase(healthy, node);
+      history = std::make_shared<details::qpu_throughput_history>();
+    }
+  }
+  released.notify_all();
+}
+
+template <typename T>
+T qpud_cluster::finish(std::size_t node, std::future<T> &pending) {
+  try {
+    auto result = pending.get();
+    release(node, false);
+    return result;
+  } catch (...) {
+    release(node, true);
+    throw;
+  }
+}
+
+/// @brief Return the counts of the observe result, carrying its expectation
+/// value for async_observe_result::get().
+static sample_result withExpectation(observe_result &result) {
+  auto data = result.raw_data();
+  std::vector<ExecutionResult> registers;
+  for (auto &name : data.register_names())
+    registers.push_back(data.extract_register(name));
+  return sample_result(result.exp_val_z(), registers);
+}
+
+observe_result qpud_cluster::observe(const std::string &kernelName,
+                                     cudaq::spin_op &spinOp,
+                                     void *runtimeArgs, std::size_t argsSize,
+                                     std::size_t shots) {
+  std::vector<std::size_t> targets;
+  std::shared_ptr<details::qpu_throughput_history> speeds;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    if (healthy.empty())
+      throw std::runtime_error("No healthy qpud endpoint left in the cluster.");
+    targets = healthy;
+    speeds = history;
+  }
+
+  // Each partition of the terms is requested on its endpoint, and waited
+  // for on its own thread so that the reduction sees it complete.
+  return details::distributeComputations(
+      [&](std::size_t i, spin_op &op) {
+        const auto node = targets[i];
+        acquire(node);
+        std::future<observe_result> pending;
+        try {
+          pending = nodes[node].client->observe_async(kernelName, op,
+                                                      runtimeArgs, argsSize,
+                                                      shots);
+        } catch (...) {
+          release(node, true);
+          throw;
+        }
+        return async_observe_result(
+            details::future(std::async(
+                std::launch::async,
+                [this, node, pending = std::move(pending)]() mutable {
+                  auto result = finish(node, pending);
+                  return withExpectation(result);
+                })),
+            &op);
+      },
+      spinOp, targets.size(), *speeds);
+}
+
+sample_result qpud_cluster::sample(const std::string &kernelName,
+                                   const std::size_t shots, void *runtimeArgs,
+                                   std::size_t argsSize) {
+  std::vector<std::size_t> targets;
+  {
+    std::lock_guard<std::mutex> l(lock);
+    if (healthy.empty())
+      throw std::runtime_error("No healthy qpud endpoint left in the cluster.");
+    targets = healthy;
+  }
+
+  const auto nShards = std::min<std::size_t>(targets.size(), shots);
+  std::vector<std::future<sample_result>> pending;
+  for (std::size_t i = 0; i < nShards; i++) {
+    const auto node = targets[i];
+    const auto shardShots = shots / nShards + (i < shots % nShards);
+    acquire(node);
+    try {
+      pending.push_back(nodes[node].client->sample_async(
+          kernelName, shardShots, runtimeArgs, argsSize));
+    } catch (...) {
+      release(node, true);
+      throw;
+    }
+  }
+  std::vector<sample_result> results;
+  for (std::size_t i = 0; i < pending.size(); i++)
+    results.push_back(finish(targets[i], pending[i]));
+  return sample_result::merge(results);
+}
+
+std::vector<std::future<sample_result>> qpud_cluster::sample_batch(
+    const std::string &kernelName, const std::size_t shots,
+    const std::vector<std::pair<void *, std::size_t>> &argSets) {
+  std::vector<std::future<sample_result>> results;
+  for (auto &[args, size] : argSets) {
+    const auto node = acquireAny();
+    std::future<sample_result> pending;
+    try {
+      pending =
+          nodes[node].client->sample_async(kernelName, shots, args, size);
+    } catch (...) {
+      release(node, true);
+      throw;
+    }
+    results.push_back(std::async(
+        std::launch::async,
+        [this, node, pending = std::move(pending)]() mutable {
+          return finish(node, pending);
+        }));
+  }
+  return results;
+}
+
+std::vector<std::future<observe_result>> qpud_cluster::observe_batch(
+    const std::string &kernelName, cudaq::spin_op &spinOp,
+    const std::vector<std::pair<void *, std::size_t>> &argSets,
+    std::size_t shots) {
+  std::vector<std::future<observe_result>> results;
+  for (auto &[args, size] : argSets) {
+    const auto node = acquireAny();
+    std::future<observe_result> pending;
+    try {
+      pending = nodes[node].client->observe_async(kernelName, spinOp, args,
+                                                  size, shots);
+    } catch (...) {
+      release(node, true);
+      throw;
+    }
+    results.push_back(std::async(
+        std::launch::async,
+        [this, node, pending = std::move(pending)]() mutable {
+          return finish(node, pending);
+        }));
+  }
+  return results;
 }
 
 void qpud_client::stop_qpud() {
-  if (!stopRequested &&
+  if (!stopRequested && ownsDaemon &&
       (rpcClient && rpcClient->get_connection_state() ==
                         rpc::client::connection_state::connected)) {
     stopRequested = true;
@@ -11,7 +11,11 @@
 #include "common/ObserveResult.h"
 #include "cudaq/spin_op.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <stack>
 
 // Forward declare the RPC client type
@@ -24,6 +28,10 @@ struct ProcessInfo;
 }
 
 namespace cudaq {
+class SharedBuffer;
+namespace details {
+class qpu_throughput_history;
+}
 
 static constexpr std::size_t NoResultOffset = ~0u >> 1;
 
@@ -127,6 +135,21 @@ protected:
   /// @brief Bool indicating if a stop of qpud has been requested
   bool stopRequested = false;
 
+  /// @brief True if this client started the qpud proc, and stops it. A qpud
+  /// proc connected to by url is shared, it is left running.
+  bool ownsDaemon = true;
+
+  /// @brief The buffer shared with the qpud proc, which carries the kernel
+  /// arguments and results without serializing them, and whether it was
+  /// set up (it stays null if qpud could not attach it).
+  std::unique_ptr<SharedBuffer> sharedBuffer;
+  bool sharedBufferSetUp = false;
+
+  /// @brief Return the buffer shared with the qpud proc holding the given
+  /// kernel arguments, or nullptr if the data goes through RPC. Disabled by
+  /// CUDAQ_QPUD_SHARED_BUFFER=0.
+  SharedBuffer *getSharedBuffer(void *runtimeArgs, std::size_t argsSize);
+
   /// @brief Return a raw pointer to the rpc client.
   /// @param connectClient
   /// @return
@@ -135,6 +158,10 @@ protected:
   /// @brief Utility function for starting the qpud proc
   llvm::sys::ProcessInfo startDaemon();
 
+  /// @brief Connect to the qpud proc at url:port, trying the given number of
+  /// times. Return false if it could not be reached.
+  bool connect(int attempts);
+
   /// @brief Utility function for JIT compiling the quakeCode once
   /// @param kernelName
   void jitQuakeIfUnseen(const std::string &kernelName);
@@ -144,9 +171,13 @@ public:
   qpud_client();
 
   /// @brief The constructor, does not create the qpud proc but
-  /// instead connects to an existing one
+  /// instead connects to an existing one. Throws if it cannot be reached.
   qpud_client(const std::string &qpudUrl, const int qpudPort);
 
+  /// @brief Return true if the qpud proc is connected and answers a request
+  /// within the timeout.
+  bool is_healthy(std::chrono::milliseconds timeout);
+
   /// @brief Set the qpud proc target backend
   void set_backend(const std::string &backend);
 
@@ -267,6 +298,37 @@ public:
   /// @brief Return the observe result based on a detached job
   observe_result observe(cudaq::spin_op &spinOp, detached_job &job);
 
+  /// @brief Sample the kernel without waiting for the result, so that
+  /// several requests can be in flight. The arguments are copied.
+  std::future<sample_result> sample_async(const std::string &kernelName,
+                                          const std::size_t shots,
+                                          void *runtimeArgs,
+                                          std::size_t argsSize);
+
+  /// @brief Observe the kernel without waiting for the result, so that
+  /// several requests can be in flight. The arguments are copied.
+  std::future<observe_result> observe_async(const std::string &kernelName,
+                                            cudaq::spin_op &spinOp,
+                                            void *runtimeArgs,
+                                            std::size_t argsSize,
+                                            std::size_t shots = 0);
+
+  /// @brief Sample the kernel on each of the given (args, size) argument
+  /// sets in one request. qpud runs them concurrently, the future of each
+  /// one is ready once its result has been streamed back.
+  std::vector<std::future<sample_result>>
+  sample_batch(const std::string &kernelName, const std::size_t shots,
+               const std::vector<std::pair<void *, std::size_t>> &argSets);
+
+  /// @brief Observe the kernel on each of the given (args, size) argument
+  /// sets in one request, e.g. the points of a parameter sweep. qpud runs
+  /// them concurrently, the future of each one is ready once its result has
+  /// been streamed back.
+  std::vector<std::future<observe_result>>
+  observe_batch(const std::string &kernelName, cudaq::spin_op &spinOp,
+                const std::vector<std::pair<void *, std::size_t>> &argSets,
+                std::size_t shots = 0);
+
   /// @brief Convert a user specified kernel argument struct to a raw void
   /// pointer and its associated size.
   template <typename ArgsType>
@@ -284,6 +346,96 @@ public:
   ~qpud_client();
 };
 
+/// @brief A cluster of running qpud procs, typically one per GPU node, that
+/// observe and sample calls are sharded across. The procs that fail their
+/// health check are left out until the next check. Every proc has a limit
+/// on the requests in flight on it, further requests wait for a free slot.
+class qpud_cluster {
+public:
+  /// @brief The url and port of a qpud proc.
+  using endpoint = std::pair<std::string, int>;
+
+private:
+  struct Node {
+    endpoint address;
+    std::unique_ptr<qpud_client> client;
+    std::size_t inFlight = 0;
+    bool healthy = false;
+  };
+  std::vector<Node> nodes;
+
+  /// @brief The indices of the healthy nodes, as of the last health check.
+  std::vector<std::size_t> healthy;
+
+  /// @brief The observed speed of each healthy node, see
+  /// details::distributeComputations(). Reset when the healthy nodes change.
+  std::shared_ptr<details::qpu_throughput_history> history;
+
+  std::size_t maxInFlight;
+  std::mutex lock;
+  std::condition_variable released;
+
+  /// @brief Take a request slot on the given node, waiting for one.
+  void acquire(std::size_t node);
+
+  /// @brief Take a request slot on the least loaded healthy node, waiting
+  /// for one, and return the node.
+  std::size_t acquireAny();
+
+  /// @brief Give back the request slot. A failed request marks the node
+  /// unhealthy until the next health check.
+  void release(std::size_t node, bool failed);
+
+  /// @brief Wait for the result of a request in flight on the node, then
+  /// release its slot.
+  template <typename T>
+  T finish(std::size_t node, std::future<T> &pending);
+
+public:
+  /// @brief Connect to the qpud procs at the given endpoints, allowing up
+  /// to maxInFlightPerEndpoint requests in flight on each one. Throws if
+  /// none of them is healthy.
+  qpud_cluster(const std::vector<endpoint> &endpoints,
+               std::size_t maxInFlightPerEndpoint = 4);
+  ~qpud_cluster();
+
+  /// @brief Health check every endpoint, reconnecting the ones that were
+  /// unreachable. Return the number of healthy endpoints.
+  std::size_t check_health(
+      std::chrono::milliseconds timeout = std::chrono::milliseconds(2000));
+
+  /// @brief Return the number of healthy endpoints.
+  std::size_t num_healthy();
+
+  /// @brief Set the target backend of every qpud proc.
+  void set_backend(const std::string &backend);
+
+  /// @brief Observe the kernel with respect to the spin op, its terms
+  /// partitioned amongst the healthy endpoints by their cost and the speed
+  /// of the endpoints, and the results reduced as they complete.
+  observe_result observe(const std::string &kernelName, cudaq::spin_op &spinOp,
+                         void *runtimeArgs, std::size_t argsSize,
+                         std::size_t shots = 0);
+
+  /// @brief Sample the kernel, its shots split evenly amongst the healthy
+  /// endpoints and their counts merged.
+  sample_result sample(const std::string &kernelName, const std::size_t shots,
+                       void *runtimeArgs, std::size_t argsSize);
+
+  /// @brief Sample the kernel on each of the given (args, size) argument
+  /// sets, each one on the least loaded healthy endpoint.
+  std::vector<std::future<sample_result>>
+  sample_batch(const std::string &kernelName, const std::size_t shots,
+               const std::vector<std::pair<void *, std::size_t>> &argSets);
+
+  /// @brief Observe the kernel on each of the given (args, size) argument
+  /// sets, each one on the least loaded healthy endpoint.
+  std::vector<std::future<observe_result>>
+  observe_batch(const std::string &kernelName, cudaq::spin_op &spinOp,
+                const std::vector<std::pair<void *, std::size_t>> &argSets,
+                std::size_t shots = 0);
+};
+
 qpud_client &get_qpud_client();
 
 /// @brief Launch a sampling job and detach, returning the job id. Takes the
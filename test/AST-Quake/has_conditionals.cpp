@@ -31,7 +31,7 @@ struct kernel {
 };
 
 // CHECK-LABEL:   func.func @__nvqpp__mlirgen__kernelNoConditional
-// CHECK-SAME: () attributes {{{.*}}"cudaq-entrypoint"{{.*}}} {
+// CHECK-SAME: () attributes {{{.*}}"cudaq-entrypoint"{{.*}}requiredQubits = 1 : i64{{.*}}} {
 struct kernelNoConditional {
     void operator()() __qpu__ {
         cudaq::qreg<1> q;
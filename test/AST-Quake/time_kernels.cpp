@@ -0,0 +1,35 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+// RUN: cudaq-quake --time-kernels %s -o /dev/null 2>&1 | FileCheck %s
+
+// Every kernel is timed once, even if its template is instantiated twice.
+// CHECK: Kernel lowering time report
+// CHECK-DAG: __nvqpp__mlirgen__ghzILm3EE
+// CHECK-DAG: __nvqpp__mlirgen__ghzILm5EE
+// CHECK-NOT: __nvqpp__mlirgen__ghz
+
+#include <cudaq.h>
+
+template <std::size_t N>
+struct ghz {
+  void operator()() __qpu__ {
+    cudaq::qreg<N> q;
+    h(q[0]);
+    for (int i = 0; i < N - 1; i++)
+      x<cudaq::ctrl>(q[i], q[i + 1]);
+    mz(q);
+  }
+};
+
+int main() {
+  ghz<3>{}();
+  ghz<5>{}();
+  ghz<5>{}();
+  return 0;
+}
@@ -0,0 +1,32 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+// RUN: rm -rf %t.cache
+// RUN: nvq++ --cache-dir %t.cache %s -o %t.first && %t.first | FileCheck %s
+// RUN: nvq++ -v --cache-dir %t.cache %s -o %t.second | FileCheck --check-prefix=HIT %s
+// RUN: %t.second | FileCheck %s
+
+#include "cudaq.h"
+
+struct test {
+  void operator()() __qpu__ {
+    cudaq::qubit q;
+    x(q);
+    mz(q);
+  }
+};
+
+int main() { cudaq::sample(test{}).dump(); }
+
+// CHECK: { 1:1000 }
+
+// The second compilation takes the object file from the cache, without
+// running the kernel compilation again.
+// HIT-NOT: cudaq-quake
+// HIT: cp {{.*}}.cache/{{[0-9a-f]+}}.o
+// HIT-NOT: cudaq-quake
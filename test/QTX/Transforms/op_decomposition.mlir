@@ -8,6 +8,7 @@
 
 // RUN: cudaq-opt --qtx-op-decomposition %s | FileCheck %s
 // RUN: cudaq-opt --qtx-op-decomposition %s | CircuitCheck %s
+// RUN: cudaq-opt --qtx-op-decomposition %s | CircuitCheck %s --probes=4
 
 module {
 
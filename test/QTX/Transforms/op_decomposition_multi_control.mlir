@@ -0,0 +1,44 @@
+// ========================================================================== //
+// Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                 //
+// All rights reserved.                                                       //
+//                                                                            //
+// This source code and the accompanying materials are made available under   //
+// the terms of the Apache License 2.0 which accompanies this distribution.   //
+// ========================================================================== //
+
+// RUN: cudaq-opt --qtx-op-decomposition %s | FileCheck %s
+// RUN: cudaq-opt --qtx-op-decomposition %s | CircuitCheck %s
+// RUN: cudaq-opt --qtx-op-decomposition=max-ancillas=2 %s | FileCheck --check-prefix=CLEAN %s
+
+module {
+
+  // The idle wire %d is borrowed as a dirty ancilla.
+
+  // CHECK-LABEL: qtx.circuit @cccx_dirty(
+  // CHECK-NOT:     alloca
+  // CHECK-NOT:     x [%{{.*}}, %{{.*}}, %{{.*}}]
+  // CHECK:         return
+
+  // CLEAN-LABEL: qtx.circuit @cccx_dirty(
+  // CLEAN:         %[[VAL_0:.*]] = alloca : !qtx.wire
+  // CLEAN-NOT:     x [%{{.*}}, %{{.*}}, %{{.*}}]
+  // CLEAN:         dealloc %{{.*}} : !qtx.wire
+  // CLEAN:         return
+  qtx.circuit @cccx_dirty(%a: !qtx.wire, %b: !qtx.wire, %c: !qtx.wire, %d: !qtx.wire, %t: !qtx.wire) -> (!qtx.wire, !qtx.wire, !qtx.wire, !qtx.wire, !qtx.wire) {
+    %t_1 = x [%a, %b, %c] %t : [!qtx.wire, !qtx.wire, !qtx.wire] !qtx.wire
+    return %a, %b, %c, %d, %t_1 : !qtx.wire, !qtx.wire, !qtx.wire, !qtx.wire, !qtx.wire
+  }
+
+  // With a single idle wire, the four controls are split in two halves.
+
+  // CHECK-LABEL: qtx.circuit @ccccz_split(
+  // CHECK-NOT:     alloca
+  // CHECK-NOT:     z [%{{.*}}, %{{.*}}, %{{.*}}]
+  // CHECK-NOT:     x [%{{.*}}, %{{.*}}, %{{.*}}]
+  // CHECK:         return
+  qtx.circuit @ccccz_split(%a: !qtx.wire, %b: !qtx.wire, %c: !qtx.wire, %d: !qtx.wire, %e: !qtx.wire, %t: !qtx.wire) -> (!qtx.wire, !qtx.wire, !qtx.wire, !qtx.wire, !qtx.wire, !qtx.wire) {
+    %t_1 = z [%a, %b, %c, %d] %t : [!qtx.wire, !qtx.wire, !qtx.wire, !qtx.wire] !qtx.wire
+    return %a, %b, %c, %d, %e, %t_1 : !qtx.wire, !qtx.wire, !qtx.wire, !qtx.wire, !qtx.wire, !qtx.wire
+  }
+
+}
@@ -0,0 +1,32 @@
+// ========================================================================== //
+// Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                 //
+// All rights reserved.                                                       //
+//                                                                            //
+// This source code and the accompanying materials are made available under   //
+// the terms of the Apache License 2.0 which accompanies this distribution.   //
+// ========================================================================== //
+
+// RUN: cudaq-translate --convert-to=openqasm3 %s | FileCheck %s
+
+module {
+  qtx.circuit @ansatz<%theta: f64>() attributes {"cudaq-entrypoint"} {
+    %q0 = alloca : !qtx.wire
+    %cst = arith.constant 2.000000e+00 : f64
+    %0 = arith.mulf %theta, %cst : f64
+    %q1 = rx<%0> %q0 : <f64> !qtx.wire
+    %1 = arith.negf %theta : f64
+    %q2 = ry<%1> %q1 : <f64> !qtx.wire
+    %b, %q3 = mz %q2 : !qtx.wire -> <i1> !qtx.wire
+    return
+  }
+}
+
+// CHECK: OPENQASM 3;
+
+// CHECK: include "stdgates.inc";
+
+// CHECK: input float[64] [[THETA:.*]];
+// CHECK: qreg [[Q:.*]][1];
+// CHECK: rx (([[THETA]] * {{.*}})) [[Q]][0];
+// CHECK: ry (-([[THETA]])) [[Q]][0];
+// CHECK: measure [[Q]][0] -> {{.*}};
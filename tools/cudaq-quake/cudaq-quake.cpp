@@ -28,6 +28,7 @@
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include "mlir/IR/BuiltinOps.h"
@@ -90,6 +91,12 @@ static cl::opt<std::string>
     resourceDir("resource-dir", cl::desc("Specify output filename"),
                 cl::init(LLVM_ROOT "/lib/clang/" CUDAQ_LLVM_VERSION));
 
+static cl::opt<unsigned> numThreads(
+    "num-threads",
+    cl::desc("Number of threads verifying the kernels (0 uses all the "
+             "hardware threads)."),
+    cl::init(0));
+
 static cl::list<std::string>
     macroDefines("D", cl::desc("Define preprocessor macro."));
 
@@ -297,7 +304,16 @@ int main(int argc, char **argv) {
   mlir::DialectRegistry registry;
   mlir::registerAllDialects(registry);
   registry.insert<cudaq::cc::CCDialect, quake::QuakeDialect>();
+  std::unique_ptr<llvm::ThreadPool> threadPool;
   mlir::MLIRContext context(registry);
+  if (numThreads == 1) {
+    context.disableMultithreading();
+  } else if (numThreads > 1) {
+    threadPool = std::make_unique<llvm::ThreadPool>(
+        llvm::hardware_concurrency(numThreads));
+    context.disableMultithreading();
+    context.setThreadPool(*threadPool);
+  }
   // TODO: Consider only loading the dialects we know we'll use.
   context.loadAllAvailableDialects();
   mlir::OpBuilder builder(&context);
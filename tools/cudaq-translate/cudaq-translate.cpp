@@ -19,6 +19,7 @@
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
@@ -68,7 +69,7 @@ static llvm::cl::opt<std::string> convertTo(
     llvm::cl::desc(
         "Specify the translation output to be created. [Default: \"qir\"]"),
     llvm::cl::value_desc("target dialect [\"qir\", \"qir-base\", "
-                         "\"openqasm\", \"iqm\"]"),
+                         "\"openqasm\", \"openqasm3\", \"iqm\"]"),
     llvm::cl::init("qir"));
 
 static llvm::cl::opt<bool> emitLLVM(
@@ -77,6 +78,12 @@ static llvm::cl::opt<bool> emitLLVM(
                    "translation will terminate with the selected dialect."),
     llvm::cl::init(true));
 
+static llvm::cl::opt<unsigned> numThreads(
+    "num-threads",
+    llvm::cl::desc("Number of threads running the passes over the kernels (0 "
+                   "uses all the hardware threads)."),
+    llvm::cl::init(0));
+
 constexpr static char BOLD[] = "\033[1m";
 constexpr static char RED[] = "\033[91m";
 constexpr static char CLEAR[] = "\033[0m";
@@ -133,7 +140,18 @@ int main(int argc, char **argv) {
   DialectRegistry registry;
   registry.insert<cudaq::cc::CCDialect, quake::QuakeDialect, qtx::QTXDialect>();
   registerAllDialects(registry);
+  std::unique_ptr<llvm::ThreadPool> threadPool;
   MLIRContext context(registry);
+  // The passes nested on functions run in parallel, unless disabled by
+  // --mlir-disable-threading.
+  if (numThreads == 1) {
+    context.disableMultithreading();
+  } else if (numThreads > 1 && context.isMultithreadingEnabled()) {
+    threadPool = std::make_unique<llvm::ThreadPool>(
+        llvm::hardware_concurrency(numThreads));
+    context.disableMultithreading();
+    context.setThreadPool(*threadPool);
+  }
   context.loadAllAvailableDialects();
 
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> fileOrErr =
@@ -178,6 +196,10 @@ int main(int argc, char **argv) {
       .Case("qir-base", [&]() { addPipelineToQIR</*baseProfile=*/true>(pm); })
       .Case("openqasm",
             [&]() { directTranslation = cudaq::translateToOpenQASM; })
+      .Case("openqasm3",
+            [&]() {
+              directTranslation = cudaq::translateToParameterizedOpenQASM;
+            })
       .Case("iqm", [&]() { directTranslation = cudaq::translateToIQMJson; })
       .Default([]() {})();
 
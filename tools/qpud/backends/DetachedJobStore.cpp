@@ -0,0 +1,143 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "DetachedJobStore.h"
+#include "common/ColumnarResult.h"
+#include "common/Logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace cudaq {
+
+namespace {
+/// @brief The register of the result files holding the expectation value of
+/// the job, with no counts.
+constexpr char expectationRegisterName[] = "__job_expectation__";
+} // namespace
+
+DetachedJobStore::DetachedJobStore() {
+  std::string dir;
+  if (auto *env = std::getenv("CUDAQ_QPUD_JOB_STORE_DIR"))
+    dir = env;
+  std::size_t budget = maxBytes;
+  if (auto *env = std::getenv("CUDAQ_QPUD_JOB_STORE_BYTES"))
+    budget = std::strtoull(env, nullptr, 10);
+  configure(dir, budget);
+}
+
+DetachedJobStore &DetachedJobStore::get() {
+  static DetachedJobStore store;
+  return store;
+}
+
+void DetachedJobStore::configure(const std::string &dir, std::size_t budget) {
+  std::lock_guard<std::mutex> l(lock);
+  if (!dir.empty())
+    std::filesystem::create_directories(dir);
+  directory = dir;
+  maxBytes = budget;
+}
+
+std::string DetachedJobStore::path(const std::string &jobId) const {
+  if (directory.empty() || jobId.empty() ||
+      !std::all_of(jobId.begin(), jobId.end(), [](unsigned char c) {
+        return std::isalnum(c) || c == '-' || c == '_';
+      }))
+    return "";
+  return (std::filesystem::path(directory) / (jobId + ".cqsr")).string();
+}
+
+void DetachedJobStore::insert(const std::string &jobId, Result result) {
+  if (auto iter = index.find(jobId); iter != index.end()) {
+    bytes -= iter->second->bytes;
+    entries.erase(iter->second);
+    index.erase(iter);
+  }
+  const std::size_t size = sizeof(Entry) + jobId.size() +
+                           std::get<1>(result).size() * sizeof(std::size_t);
+  entries.push_front({jobId, std::move(result), size});
+  index[jobId] = entries.begin();
+  bytes += size;
+
+  while (bytes > maxBytes && entries.size() > 1) {
+    auto &last = entries.back();
+    bytes -= last.bytes;
+    index.erase(last.jobId);
+    entries.pop_back();
+  }
+}
+
+void DetachedJobStore::put(const std::string &jobId, Result result) {
+  std::lock_guard<std::mutex> l(lock);
+
+  // Write the result through, so that it outlives the daemon.
+  if (auto file = path(jobId); !file.empty()) {
+    auto counts = std::get<1>(result);
+    sample_result data;
+    data.deserialize(counts);
+    ExecutionResult expectation(std::get<0>(result));
+    expectation.registerName = expectationRegisterName;
+    data.append(expectation);
+    try {
+      std::ofstream os(file, std::ios::binary | std::ios::trunc);
+      columnar::write(data, os);
+    } catch (std::exception &e) {
+      cudaq::info("Could not write the result of job {} to {}: {}", jobId,
+                  file, e.what());
+    }
+  }
+
+  insert(jobId, std::move(result));
+}
+
+std::optional<DetachedJobStore::Result>
+DetachedJobStore::find(const std::string &jobId) {
+  std::lock_guard<std::mutex> l(lock);
+  if (auto iter = index.find(jobId); iter != index.end()) {
+    entries.splice(entries.begin(), entries, iter->second);
+    return iter->second->result;
+  }
+
+  auto file = path(jobId);
+  if (file.empty())
+    return std::nullopt;
+  std::ifstream is(file, std::ios::binary);
+  if (!is)
+    return std::nullopt;
+  std::vector<std::uint8_t> buffer((std::istreambuf_iterator<char>(is)),
+                                   std::istreambuf_iterator<char>());
+  try {
+    auto data = sample_result_view(buffer).to_sample_result();
+    auto expectation = data.extract_register(expectationRegisterName);
+    Result result{expectation.expectationValue.value_or(0.0),
+                  data.serialize()};
+    insert(jobId, result);
+    return result;
+  } catch (std::exception &e) {
+    cudaq::info("Could not read the result of job {} from {}: {}", jobId, file,
+                e.what());
+    return std::nullopt;
+  }
+}
+
+std::size_t DetachedJobStore::memoryBytes() {
+  std::lock_guard<std::mutex> l(lock);
+  return bytes;
+}
+
+std::size_t DetachedJobStore::maxMemoryBytes() {
+  std::lock_guard<std::mutex> l(lock);
+  return maxBytes;
+}
+
+} // namespace cudaq
@@ -0,0 +1,84 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace cudaq {
+
+/// @brief The store of the results of detached jobs, shared by the backends
+/// of all qpud clients. The most recently used results are kept in memory up
+/// to a byte budget, the least recently used ones are evicted first. If a
+/// directory is set, every result is also written to it as a columnar sample
+/// result file (see ColumnarResult.h) named after its job id, so results
+/// evicted from memory, or stored by a previous daemon, are read back from
+/// disk. Lookups are O(1) in memory and open a single file otherwise.
+class DetachedJobStore {
+public:
+  /// @brief A job result: the expectation value (zero for sampling jobs) and
+  /// the serialized counts (see sample_result::serialize()).
+  using Result = std::tuple<double, std::vector<std::size_t>>;
+
+  /// @brief Return the store of this process. Its directory and memory
+  /// budget are taken from CUDAQ_QPUD_JOB_STORE_DIR and
+  /// CUDAQ_QPUD_JOB_STORE_BYTES, unless set with configure().
+  static DetachedJobStore &get();
+
+  /// @brief Set the directory of the result files, created if needed (empty
+  /// to keep results in memory only), and the memory budget in bytes.
+  void configure(const std::string &directory, std::size_t maxBytes);
+
+  /// @brief Store the result of the job.
+  void put(const std::string &jobId, Result result);
+
+  /// @brief Return the result of the job, or nullopt if it is unknown or was
+  /// evicted without a directory to read it back from.
+  std::optional<Result> find(const std::string &jobId);
+
+  /// @brief Return the bytes of the results held in memory.
+  std::size_t memoryBytes();
+
+  /// @brief Return the memory budget in bytes.
+  std::size_t maxMemoryBytes();
+
+private:
+  DetachedJobStore();
+
+  struct Entry {
+    std::string jobId;
+    Result result;
+    std::size_t bytes = 0;
+  };
+
+  /// @brief The results in memory from most to least recently used, and
+  /// their position by job id.
+  std::list<Entry> entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index;
+  std::size_t bytes = 0;
+  std::size_t maxBytes = 256 << 20;
+  std::string directory;
+  std::mutex lock;
+
+  /// @brief Insert the result as most recently used and evict the least
+  /// recently used ones over the budget, the new one excepted.
+  void insert(const std::string &jobId, Result result);
+
+  /// @brief Return the path of the result file of the job, or an empty
+  /// string if there is no directory or the id is not a valid file name.
+  std::string path(const std::string &jobId) const;
+};
+
+} // namespace cudaq
@@ -119,15 +119,8 @@ TargetBackend::compile(MLIRContext &context, const std::string_view quakeCode) {
     return nullptr;
   }
 
-  // Initialize LLVM targets.
-  /// Optionally run an optimization pipeline over the llvm module.
-  bool enableOpt = true;
-  auto optPipeline = makeOptimizingTransformer(
-      /*optLevel=*/enableOpt ? 3 : 0, /*sizeLevel=*/0,
-      /*targetMachine=*/nullptr);
-  if (auto err = optPipeline(llvmModule.get()))
-    llvm::errs() << "Failed to optimize LLVM IR " << err << "\n";
-
+  // The module is optimized by the JIT, at its optimization level and for
+  // the host CPU.
   if (!setupTargetTriple(llvmModule.get())) {
     llvm::errs() << "Failed to setup the llvm module target triple.\n";
     return nullptr;
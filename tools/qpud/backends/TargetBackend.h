@@ -98,18 +98,16 @@ public:
                                           void *kernelArgs) = 0;
 
   /// Execute the ThunkFunction with the given args, return the expected value
-  /// of the provided spin_op (represented as a vector<double>, with format
-  /// [OP0 OP1 OP2 ... COEFF_REAL COEFF_IMAG | OP0 OP1 OP2 ... COEFF_REAL
-  /// COEFF_IMAG | ... | NTERMS]).
+  /// of the provided spin_op and the serialized counts of its terms.
   virtual std::tuple<double, std::vector<std::size_t>>
-  observe(Kernel &thunk, std::vector<double> &spin_op_data,
-          const std::size_t shots, void *kernelArgs) = 0;
+  observe(Kernel &thunk, cudaq::spin_op &H, const std::size_t shots,
+          void *kernelArgs) = 0;
 
-  /// Execute an Observe task with the given ansatz and spin op data, but
+  /// Execute an Observe task with the given ansatz and spin op, but
   /// detach and return the job ids and job names for the given task.
   virtual std::tuple<std::vector<std::string>, std::vector<std::string>>
-  observeDetach(Kernel &thunk, std::vector<double> &spin_op_data,
-                const std::size_t shots, void *kernelArgs) {
+  observeDetach(Kernel &thunk, cudaq::spin_op &H, const std::size_t shots,
+                void *kernelArgs) {
     throw std::runtime_error("observeDetach not supported for this backend.");
   }
 
@@ -6,10 +6,12 @@
  * the terms of the Apache License 2.0 which accompanies this distribution.    *
  *******************************************************************************/
 
+#include "DetachedJobStore.h"
 #include "TargetBackend.h"
 #include "common/ExecutionContext.h"
 #include "cudaq/utils/registry.h"
 #include <cudaq/spin_op.h>
+#include <random>
 
 // Instantiate the registry for all backends
 LLVM_INSTANTIATE_REGISTRY(cudaq::TargetBackend::RegistryType);
@@ -142,36 +144,20 @@ public:
     return ctx.result.serialize();
   }
   std::tuple<double, std::vector<std::size_t>>
-  observe(Kernel &thunk, std::vector<double> &spin_op_data,
-          const std::size_t shots, void *kernelArgs) override {
-
+  observe(Kernel &thunk, cudaq::spin_op &H, const std::size_t shots,
+          void *kernelArgs) override {
+    // As in-process observe: the kernel prepares the state once, then the
+    // simulator computes <psi | H | psi> itself if it can, otherwise NVQIR
+    // measures the qubit-wise commuting groups of terms on that state.
     ExecutionContext ctx("observe");
     ctx.shots = shots == 0 ? -1 : shots;
+    ctx.spin = &H;
 
     __quantum__rt__setExecutionContext(&ctx);
-    // default to never using CircuitSimulator::observe()
-    ctx.canHandleObserve = false;
-
-    auto n_terms = (int)spin_op_data.back();
-    auto nQubits = (spin_op_data.size() - 2 * n_terms) / n_terms;
-    cudaq::spin_op H(spin_op_data, nQubits);
-    double sum = 0.0;
     thunk(kernelArgs, /*isClientServer=*/false);
-
-    std::vector<ExecutionResult> results;
-    for (std::size_t i = 0; i < H.n_terms(); i++) {
-      auto term = H[i];
-      if (!term.is_identity()) {
-        auto exp = measure(term, &ctx);
-        results.emplace_back(ctx.result.to_map(), term.to_string(false));
-        sum += term.get_term_coefficient(0).real() * exp;
-      } else {
-        sum += term.get_term_coefficient(0).real();
-      }
-    }
+    auto sum = measure(H, &ctx);
     __quantum__rt__resetExecutionContext();
-    sample_result counts(results);
-    return std::make_tuple(sum, counts.serialize());
+    return std::make_tuple(sum, ctx.result.serialize());
   }
 
   std::string genRandomString() {
@@ -179,11 +165,15 @@ public:
     static const char alphanum[] = "0123456789"
                                    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
                                    "abcdefghijklmnopqrstuvwxyz";
+    // Seeded per thread, job ids must not repeat across daemons sharing the
+    // job store.
+    thread_local std::mt19937_64 generator{std::random_device{}()};
+    std::uniform_int_distribution<std::size_t> dist(0, sizeof(alphanum) - 2);
     std::string tmp_s;
     tmp_s.reserve(len);
 
     for (int i = 0; i < len; ++i) {
-      tmp_s += alphanum[rand() % (sizeof(alphanum) - 1)];
+      tmp_s += alphanum[dist(generator)];
     }
 
     return tmp_s;
@@ -196,23 +186,19 @@ public:
     thunk(kernelArgs, /*isClientServer=*/false);
     __quantum__rt__resetExecutionContext();
     auto jobId = genRandomString();
-    detachedSampleResults.insert({jobId, ctx.result});
+    DetachedJobStore::get().put(jobId, {0.0, ctx.result.serialize()});
     return std::make_tuple(jobId,
                            std::string(thunk.name()) + std::string(".sample"));
   }
 
   std::tuple<std::vector<std::string>, std::vector<std::string>>
-  observeDetach(Kernel &thunk, std::vector<double> &spin_op_data,
-                const std::size_t shots, void *kernelArgs) override {
+  observeDetach(Kernel &thunk, cudaq::spin_op &H, const std::size_t shots,
+                void *kernelArgs) override {
     // Local declarations
     ExecutionContext ctx("observe");
     ctx.shots = shots == 0 ? -1 : shots;
 
     __quantum__rt__setExecutionContext(&ctx);
-    auto n_terms = (int)spin_op_data.back();
-    auto nQubits = (spin_op_data.size() - 2 * n_terms) / n_terms;
-
-    cudaq::spin_op H(spin_op_data, nQubits);
     thunk(kernelArgs, /*isClientServer=*/false);
 
     std::vector<std::string> jobIds, jobNames;
@@ -220,9 +206,9 @@ public:
       auto term = H[i];
       if (!term.is_identity()) {
         auto jobId = genRandomString();
+        ctx.spin = &term;
         auto exp = measure(term, &ctx);
-        detachedObserveResults.insert(
-            {jobId, std::make_pair(exp, ctx.result.serialize())});
+        DetachedJobStore::get().put(jobId, {exp, ctx.result.serialize()});
         jobIds.push_back(jobId);
         jobNames.push_back(term.to_string(false));
       }
@@ -234,23 +220,25 @@ public:
 
   std::tuple<double, std::vector<std::size_t>>
   observeFromJobId(const std::string &jobId) override {
-    return detachedObserveResults[jobId];
+    return findResult(jobId);
   }
 
   std::vector<std::size_t> sampleFromJobId(const std::string &jobId) override {
-    return detachedSampleResults[jobId].serialize();
+    return std::get<1>(findResult(jobId));
   }
 
   virtual ~DefaultBackend() = default;
 
 protected:
-  /// @brief For each detached sample task, store jobId -> results
-  std::map<std::string, sample_result> detachedSampleResults;
-
-  /// @brief For each detached observe task, store jobId -> tuple(ExpVal,
-  /// Serialized Counts)
-  std::map<std::string, std::tuple<double, std::vector<std::size_t>>>
-      detachedObserveResults;
+  /// @brief Return the result of the detached job, kept in the job store of
+  /// the daemon.
+  DetachedJobStore::Result findResult(const std::string &jobId) {
+    auto result = DetachedJobStore::get().find(jobId);
+    if (!result)
+      throw std::runtime_error("Unknown or expired detached job id " + jobId +
+                               ".");
+    return std::move(*result);
+  }
 };
 
 } // namespace
@@ -7,29 +7,78 @@
  *******************************************************************************/
 
 #include "KernelJIT.h"
+#include "mlir/ExecutionEngine/OptUtils.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/SHA256.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
 using namespace llvm::orc;
 
 namespace cudaq {
+std::string KernelObjectCache::getPath(StringRef Key) const {
+  SmallString<256> Path(Dir);
+  sys::path::append(Path, Key + ".o");
+  return std::string(Path);
+}
+
+void KernelObjectCache::notifyObjectCompiled(const Module *M,
+                                             MemoryBufferRef Obj) {
+  // Write to a unique temporary file and rename it, so that concurrent
+  // writers and readers never see a partial object.
+  if (sys::fs::create_directories(Dir))
+    return;
+  auto Path = getPath(M->getModuleIdentifier());
+  int FD;
+  SmallString<256> TmpPath;
+  if (sys::fs::createUniqueFile(Path + ".%%%%%%.tmp", FD, TmpPath))
+    return;
+  {
+    raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Obj.getBuffer();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TmpPath);
+      return;
+    }
+  }
+  if (sys::fs::rename(TmpPath, Path))
+    sys::fs::remove(TmpPath);
+}
+
+std::unique_ptr<MemoryBuffer> KernelObjectCache::getObject(const Module *M) {
+  return load(M->getModuleIdentifier());
+}
+
+std::unique_ptr<MemoryBuffer> KernelObjectCache::load(StringRef Key) {
+  auto Buffer = MemoryBuffer::getFile(getPath(Key), /*IsText=*/false,
+                                      /*RequiresNullTerminator=*/false);
+  if (!Buffer)
+    return nullptr;
+  return std::move(*Buffer);
+}
+
 KernelJIT::KernelJIT(std::unique_ptr<ExecutionSession> ES,
                      JITTargetMachineBuilder JTMB, DataLayout DL,
-                     const std::vector<std::string> &extraLibraries,
-                     std::unique_ptr<LLVMContext> ctx)
-    : ES(std::move(ES)),
+                     std::unique_ptr<KernelObjectCache> Cache,
+                     int OptLevel, std::unique_ptr<LLVMContext> ctx)
+    : ES(std::move(ES)), Cache(std::move(Cache)), JTMB(std::move(JTMB)),
       ObjectLayer(*this->ES,
                   []() { return std::make_unique<SectionMemoryManager>(); }),
-      CompileLayer(*this->ES, ObjectLayer,
-                   std::make_unique<ConcurrentIRCompiler>(std::move(JTMB))),
-      DL(std::move(DL)), Ctx(std::move(ctx)),
-      MainJD(this->ES->createBareJITDylib("<main>")) {
-  MainJD.addGenerator(
-      cantFail(DynamicLibrarySearchGenerator::GetForCurrentProcess(
-          DL.getGlobalPrefix())));
-  for (auto &library : extraLibraries) {
-    MainJD.addGenerator(cantFail(DynamicLibrarySearchGenerator::Load(
-        library.data(), DL.getGlobalPrefix())));
+      DL(std::move(DL)), Ctx(std::move(ctx)), OptLevel(OptLevel) {
+  for (int Level = 0; Level < 4; Level++) {
+    auto LevelJTMB = this->JTMB;
+    LevelJTMB.setCodeGenOptLevel(static_cast<CodeGenOpt::Level>(Level));
+    CompileLayers[Level] = std::make_unique<IRCompileLayer>(
+        *this->ES, ObjectLayer,
+        std::make_unique<ConcurrentIRCompiler>(std::move(LevelJTMB),
+                                               this->Cache.get()));
   }
+  raw_string_ostream OS(CacheTag);
+  OS << this->JTMB.getTargetTriple().str() << ";" << this->JTMB.getCPU()
+     << ";" << this->JTMB.getFeatures().getString();
 }
 
 KernelJIT::~KernelJIT() {
@@ -39,31 +88,107 @@ KernelJIT::~KernelJIT() {
   }
 }
 
-Expected<std::unique_ptr<KernelJIT>>
-KernelJIT::Create(const std::vector<std::string> &extraLibraries) {
+Expected<std::unique_ptr<KernelJIT>> KernelJIT::Create(StringRef cacheDir,
+                                                       int optLevel) {
+  if (optLevel < 0 || optLevel > 3)
+    return make_error<StringError>("Invalid optimization level " +
+                                       std::to_string(optLevel) +
+                                       ", use 0 to 3.",
+                                   inconvertibleErrorCode());
+
   auto EPC = SelfExecutorProcessControl::Create();
   if (!EPC)
     return EPC.takeError();
 
   auto ES = std::make_unique<ExecutionSession>(std::move(*EPC));
-  JITTargetMachineBuilder JTMB(
-      ES->getExecutorProcessControl().getTargetTriple());
 
-  auto DL = JTMB.getDefaultDataLayoutForTarget();
+  // Generate code for the CPU of the host and its features, e.g. its vector
+  // extensions, rather than for the generic CPU of its triple.
+  auto JTMB = JITTargetMachineBuilder::detectHost();
+  if (!JTMB)
+    return JTMB.takeError();
+
+  auto DL = JTMB->getDefaultDataLayoutForTarget();
   if (!DL)
     return DL.takeError();
 
-  return std::make_unique<KernelJIT>(std::move(ES), std::move(JTMB),
-                                     std::move(*DL), extraLibraries);
+  std::unique_ptr<KernelObjectCache> Cache;
+  if (!cacheDir.empty())
+    Cache = std::make_unique<KernelObjectCache>(cacheDir);
+  return std::make_unique<KernelJIT>(std::move(ES), std::move(*JTMB),
+                                     std::move(*DL), std::move(Cache),
+                                     optLevel);
+}
+
+std::string KernelJIT::getCacheKey(StringRef quakeCode, StringRef backendName,
+                                   int optLevel) const {
+  SHA256 Hash;
+  Hash.update(CacheTag);
+  Hash.update(";O" + std::to_string(optLevel));
+  Hash.update(StringRef("\0", 1));
+  Hash.update(backendName);
+  Hash.update(StringRef("\0", 1));
+  Hash.update(quakeCode);
+  return toHex(Hash.final(), /*LowerCase=*/true);
+}
+
+Expected<JITDylib &>
+KernelJIT::createDylib(const std::vector<std::string> &extraLibraries) {
+  auto &JD = ES->createBareJITDylib("<kernel " + std::to_string(NumDylibs++) +
+                                    ">");
+  auto Process =
+      DynamicLibrarySearchGenerator::GetForCurrentProcess(DL.getGlobalPrefix());
+  if (!Process)
+    return Process.takeError();
+  JD.addGenerator(std::move(*Process));
+  for (auto &library : extraLibraries) {
+    auto Library = DynamicLibrarySearchGenerator::Load(library.data(),
+                                                       DL.getGlobalPrefix());
+    if (!Library)
+      return Library.takeError();
+    JD.addGenerator(std::move(*Library));
+  }
+  return JD;
+}
+
+Expected<bool> KernelJIT::addCachedObject(JITDylib &JD, StringRef cacheKey) {
+  if (!Cache)
+    return false;
+  auto Object = Cache->load(cacheKey);
+  if (!Object)
+    return false;
+  if (auto Err = ObjectLayer.add(JD, std::move(Object)))
+    return std::move(Err);
+  return true;
+}
+
+Error KernelJIT::optimizeModule(llvm::Module &M, int optLevel) {
+  auto LevelJTMB = JTMB;
+  LevelJTMB.setCodeGenOptLevel(static_cast<CodeGenOpt::Level>(optLevel));
+  auto TM = LevelJTMB.createTargetMachine();
+  if (!TM)
+    return TM.takeError();
+  M.setDataLayout(DL);
+  M.setTargetTriple(JTMB.getTargetTriple().str());
+  return mlir::makeOptimizingTransformer(optLevel, /*sizeLevel=*/0,
+                                         TM->get())(&M);
+}
+
+Error KernelJIT::addModule(JITDylib &JD, std::unique_ptr<llvm::Module> M,
+                           StringRef cacheKey, int optLevel) {
+  return addModule(JD, ThreadSafeModule(std::move(M), Ctx), cacheKey,
+                   optLevel);
 }
 
-Error KernelJIT::addModule(std::unique_ptr<llvm::Module> M,
-                           std::vector<std::string> extra_paths) {
-  auto rt = MainJD.getDefaultResourceTracker();
-  return CompileLayer.add(rt, ThreadSafeModule(std::move(M), Ctx));
+Error KernelJIT::addModule(JITDylib &JD, ThreadSafeModule TSM,
+                           StringRef cacheKey, int optLevel) {
+  // The object cache finds the object of the module by its identifier.
+  TSM.withModuleDo([&](llvm::Module &M) { M.setModuleIdentifier(cacheKey); });
+  return CompileLayers[optLevel]->add(JD.getDefaultResourceTracker(),
+                                      std::move(TSM));
 }
 
-Expected<JITEvaluatedSymbol> KernelJIT::lookup(StringRef Name) {
-  return ES->lookup({&MainJD}, Name.str());
+Expected<JITEvaluatedSymbol> KernelJIT::lookup(JITDylib &JD, StringRef Name) {
+  return ES->lookup({&JD}, Name.str());
 }
 } // namespace cudaq
@@ -10,6 +10,7 @@
 
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ExecutionEngine/JITSymbol.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
 #include "llvm/ExecutionEngine/Orc/Core.h"
 #include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
@@ -20,6 +21,8 @@
 #include "llvm/ExecutionEngine/SectionMemoryManager.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/LLVMContext.h"
+#include <array>
+#include <atomic>
 #include <memory>
 
 using namespace llvm;
@@ -27,19 +30,48 @@ using namespace llvm::orc;
 
 namespace cudaq {
 
+// The KernelObjectCache stores the objects compiled by the KernelJIT on
+// disk, one file per module named by its module identifier, so that the
+// modules of the same key are not compiled again, even by another process.
+class KernelObjectCache : public ObjectCache {
+  // The directory of the objects
+  std::string Dir;
+
+  // Return the path of the object of the key
+  std::string getPath(StringRef Key) const;
+
+public:
+  KernelObjectCache(StringRef Dir) : Dir(Dir.str()) {}
+
+  void notifyObjectCompiled(const Module *M, MemoryBufferRef Obj) override;
+  std::unique_ptr<MemoryBuffer> getObject(const Module *M) override;
+
+  // Return the object of the key, nullptr if it is not cached
+  std::unique_ptr<MemoryBuffer> load(StringRef Key);
+};
+
 // The KernelJIT class wraps the LLVM JIT utility types to
 // take as input a llvm::Module and enable one to extract
 // a function pointer for the contained llvm::Functions.
+// One KernelJIT serves all kernels, each module is added to
+// its own JITDylib. Code is generated for the host CPU and its
+// features, at an optimization level from 0 to 3 chosen per module.
 class KernelJIT {
 private:
   // The LLVM ExecutionSession representing the JIT program
   std::unique_ptr<ExecutionSession> ES;
 
+  // The optional on-disk cache of the compiled objects
+  std::unique_ptr<KernelObjectCache> Cache;
+
+  // The host target, without a code generation level
+  JITTargetMachineBuilder JTMB;
+
   // LLVM helper for object linking
   RTDyldObjectLinkingLayer ObjectLayer;
 
-  // LLVM helper for compiling Modules
-  IRCompileLayer CompileLayer;
+  // LLVM helpers for compiling Modules, one per optimization level
+  std::array<std::unique_ptr<IRCompileLayer>, 4> CompileLayers;
 
   // Representation of the target triple
   DataLayout DL;
@@ -47,31 +79,65 @@ private:
   // Thread-safe LLVM Context
   ThreadSafeContext Ctx;
 
-  // LLVM Helper representing JIT dynamic library
-  JITDylib &MainJD;
+  // The target options the objects are compiled for, part of their cache
+  // keys with the optimization level
+  std::string CacheTag;
+
+  // The optimization level of the modules by default
+  int OptLevel;
+
+  // The number of JITDylibs created, to name them
+  std::atomic<std::size_t> NumDylibs = 0;
 
 public:
   // The constructor, not meant to be used publicly, see KernelJIT::Create()
   KernelJIT(std::unique_ptr<ExecutionSession> ES, JITTargetMachineBuilder JTMB,
-            DataLayout DL, const std::vector<std::string> &extraLibraries,
+            DataLayout DL, std::unique_ptr<KernelObjectCache> Cache,
+            int OptLevel,
             std::unique_ptr<LLVMContext> ctx = std::make_unique<LLVMContext>());
 
   // The destructor
   ~KernelJIT();
 
-  // Static creation method for the KernelJIT
+  // Static creation method for the KernelJIT, compiled objects are cached
+  // in the given directory unless it is empty. Modules are optimized at the
+  // given level (0 to 3) by default.
   static Expected<std::unique_ptr<KernelJIT>>
-  Create(const std::vector<std::string> &extraLibraries);
+  Create(StringRef cacheDir = "", int optLevel = 2);
+
+  // Return the default optimization level.
+  int getOptLevel() const { return OptLevel; }
+
+  // Return the key of the object compiled from the Quake code by the named
+  // backend, for this target and the given optimization level.
+  std::string getCacheKey(StringRef quakeCode, StringRef backendName,
+                          int optLevel) const;
+
+  // Optimize the LLVM Module at the given level, tuned for the host CPU.
+  Error optimizeModule(llvm::Module &M, int optLevel);
+
+  // Create the JITDylib of a module, resolving its external symbols in the
+  // current process and the extra libraries.
+  Expected<JITDylib &>
+  createDylib(const std::vector<std::string> &extraLibraries);
+
+  // Add the cached object of the key to the JITDylib, return false if it is
+  // not cached.
+  Expected<bool> addCachedObject(JITDylib &JD, StringRef cacheKey);
+
+  // Add an LLVM Module to be JIT compiled to the JITDylib with code
+  // generated at the given level, its object is cached under the key.
+  Error addModule(JITDylib &JD, std::unique_ptr<llvm::Module> M,
+                  StringRef cacheKey, int optLevel);
 
-  // Add an LLVM Module to be JIT compiled, optionally
-  // provide extra linker paths to search.
-  Error addModule(std::unique_ptr<llvm::Module> M,
-                  std::vector<std::string> extra_paths = {});
+  // Add an LLVM Module with its own context, as above.
+  Error addModule(JITDylib &JD, ThreadSafeModule TSM, StringRef cacheKey,
+                  int optLevel);
 
   // Lookup and return a symbol JIT compiled from the Module
   // i.e. get a handle to a specific compiled function
   // and cast to a function pointer to invoke.
-  Expected<JITEvaluatedSymbol> lookup(StringRef Name);
+  Expected<JITEvaluatedSymbol> lookup(JITDylib &JD, StringRef Name);
 };
 
 } // namespace cudaq
@@ -6,16 +6,23 @@
  * the terms of the Apache License 2.0 which accompanies this distribution.    *
  *******************************************************************************/
 
+#include "DetachedJobStore.h"
 #include "KernelJIT.h"
 #include "NvidiaPlatformHelper.h"
 #include "TargetBackend.h"
 #include "common/Logger.h"
+#include "common/RuntimeMLIR.h"
+#include "common/SharedBuffer.h"
 #include "cudaq/Optimizer/Dialect/CC/CCDialect.h"
 #include "cudaq/Optimizer/Dialect/Quake/QuakeDialect.h"
+#include "cudaq/platform/QuantumExecutionQueue.h"
 #include "cudaq/utils/cudaq_utils.h"
 #include "nvqpp_config.h"
 #include "rpc/server.h"
 #include "rpc/this_handler.h"
+#include "rpc/this_session.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
 #include "mlir/Dialect/Affine/IR/AffineOps.h"
 #include "mlir/Dialect/Arith/IR/Arith.h"
@@ -28,9 +35,15 @@
 #include "mlir/InitAllPasses.h"
 #include "mlir/Target/LLVMIR/Dialect/LLVMIR/LLVMToLLVMIRTranslation.h"
 #include <charconv>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
 #include <dlfcn.h>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <sstream>
 #include <thread>
 #include <unordered_map>
@@ -39,18 +52,240 @@ namespace cudaq {
 /// Flag that stops the server and exits the qpud process
 static std::atomic<bool> _stopServer = false;
 
+/// @brief The key of a JIT compiled kernel, its name and the hash of its
+/// Quake code and backend, so that clients loading different code under the
+/// same kernel name do not collide, while identical kernels are compiled
+/// once.
+using KernelKey = std::pair<std::string, std::size_t>;
+struct KernelKeyHash {
+  std::size_t operator()(const KernelKey &key) const {
+    return std::hash<std::string>()(key.first) ^ (key.second << 1);
+  }
+};
+
 /// Storage for loaded Kernels
-static std::unordered_map<std::string, Kernel> loadedThunkSymbols;
+static std::unordered_map<KernelKey, Kernel, KernelKeyHash> loadedThunkSymbols;
 
-/// Storage for the JIT engine used for each kernel
-std::unordered_map<std::string, std::unique_ptr<KernelJIT>> jitStorage;
+/// The JIT shared by all kernels, each one in its own JITDylib
+std::unique_ptr<KernelJIT> kernelJIT;
 
-/// Pointer to the targeted QPUD backend
-std::unique_ptr<TargetBackend> backend = nullptr;
+/// Storage for the JITDylib of each kernel
+std::unordered_map<KernelKey, JITDylib *, KernelKeyHash> jitStorage;
+
+/// @brief Guards the JIT tables and the MLIR context that compiles into
+/// them. Kernel lookups share it, compilations hold it exclusively.
+static std::shared_mutex jitLock;
 
 /// Pointer to the global MLIR context
 std::unique_ptr<mlir::MLIRContext> mlirContext;
 
+/// @brief The number of calls of a kernel after which it is recompiled at the
+/// optimization level of the JIT. Kernels are first compiled unoptimized, so
+/// that they load fast, and only the hot ones pay for the optimization. Zero
+/// compiles every kernel optimized at once.
+static std::size_t tierUpCalls = 0;
+
+/// @brief The state of a kernel running unoptimized until it is called
+/// tierUpCalls times, then recompiled in the background.
+struct TierUp {
+  /// The unoptimized LLVM IR of the kernel, and the cache key of its
+  /// optimized object
+  std::string llvmIR;
+  std::string cacheKey;
+  std::vector<std::string> extraLibraries;
+
+  std::atomic<std::size_t> calls = 0;
+  std::atomic<bool> started = false;
+};
+
+/// @brief The kernels that may be recompiled optimized, guarded by jitLock.
+static std::unordered_map<KernelKey, std::shared_ptr<TierUp>, KernelKeyHash>
+    tierUps;
+
+/// @brief The queue whose single worker recompiles the hot kernels.
+static std::unique_ptr<QuantumExecutionQueue> tierUpQueue;
+
+/// @brief Return the name of the thunk symbol of the kernel in the JIT.
+std::string getThunkSymbolName(const std::string &kernelName) {
+  // Apple for some reason prepends a "_"
+#if defined(__APPLE__) && defined(__MACH__)
+  return "_" + kernelName + ".thunk";
+#else
+  return kernelName + ".thunk";
+#endif
+}
+
+/// @brief Recompile the kernel at the optimization level of the JIT, into a
+/// new JITDylib, and replace its thunk. Executions already running keep the
+/// unoptimized one, which is never removed. On failure the kernel keeps
+/// running unoptimized.
+void tierUp(const KernelKey &key, std::shared_ptr<TierUp> state) {
+  cudaq::ScopedTrace trace("qpud::tierUp", key.first);
+  const int optLevel = kernelJIT->getOptLevel();
+  auto fail = [&](const std::string &msg) {
+    cudaq::info("Could not optimize kernel {}: {}", key.first, msg);
+  };
+
+  auto dylib = kernelJIT->createDylib(state->extraLibraries);
+  if (!dylib)
+    return fail(toString(dylib.takeError()));
+  auto cached = kernelJIT->addCachedObject(*dylib, state->cacheKey);
+  if (!cached)
+    return fail(toString(cached.takeError()));
+
+  if (!*cached) {
+    // Parse the IR in a context of its own, the JIT compiles concurrently.
+    auto context = std::make_unique<llvm::LLVMContext>();
+    llvm::SMDiagnostic diagnostic;
+    auto llvmModule = llvm::parseIR(
+        llvm::MemoryBufferRef(state->llvmIR, key.first), diagnostic, *context);
+    if (!llvmModule)
+      return fail(diagnostic.getMessage().str());
+    if (auto err = kernelJIT->optimizeModule(*llvmModule, optLevel))
+      return fail(toString(std::move(err)));
+    if (auto err = kernelJIT->addModule(
+            *dylib, ThreadSafeModule(std::move(llvmModule), std::move(context)),
+            state->cacheKey, optLevel))
+      return fail(toString(std::move(err)));
+  }
+
+  // The lookup compiles the module, outside of the lock.
+  auto symbol = kernelJIT->lookup(*dylib, getThunkSymbolName(key.first));
+  if (!symbol)
+    return fail(toString(symbol.takeError()));
+  auto *thunkFunctor =
+      reinterpret_cast<DynamicResult (*)(void *, bool)>(symbol->getAddress());
+
+  std::unique_lock<std::shared_mutex> l(jitLock);
+  tierUps.erase(key);
+  auto iter = loadedThunkSymbols.find(key);
+  if (iter == loadedThunkSymbols.end())
+    return;
+  auto &kernel = iter->second;
+  kernel = Kernel(thunkFunctor, key.first, std::string(kernel.getQIRCode()),
+                  std::string(kernel.getQuakeCode()));
+  jitStorage[key] = &*dylib;
+  cudaq::info("Kernel {} optimized at level {}", key.first, optLevel);
+}
+
+/// @brief The result of one argument set of a batch: its index, the
+/// expectation value (zero when sampling) and the serialized counts.
+using BatchResult = std::tuple<std::uint64_t, double, std::vector<std::size_t>>;
+
+/// @brief A batch of executions of one kernel, whose results are fetched by
+/// the client as they finish.
+struct Batch {
+  /// The finished results not fetched yet, and the number of results not
+  /// fetched yet, finished or not
+  std::vector<BatchResult> finished;
+  std::size_t unfetched = 0;
+
+  /// The error of the first failed execution, which fails the batch
+  std::string error;
+
+  /// Idle backends of the batch, each execution takes one, so that
+  /// backends keeping state between calls are not shared across threads
+  std::vector<std::unique_ptr<TargetBackend>> backends;
+
+  std::mutex lock;
+  std::condition_variable cv;
+};
+
+/// @brief The queue whose workers run the executions of all batches. Its
+/// workers are long-lived, so that each keeps its simulator.
+static std::unique_ptr<QuantumExecutionQueue> batchQueue;
+
+/// @brief The state of a client connection. The requests of different
+/// sessions run concurrently on the server workers, each on the simulator
+/// of its worker thread, the requests of one session run one at a time.
+struct Session {
+  /// The targeted backend of this client, and its name
+  std::unique_ptr<TargetBackend> backend;
+  std::string backendName = "default";
+
+  /// The kernels loaded by this client, by name
+  std::unordered_map<std::string, KernelKey> kernelKeys;
+
+  /// The buffer shared with a client on the same host, which carries the
+  /// arguments and results of the *Shared requests
+  std::unique_ptr<SharedBuffer> sharedBuffer;
+
+  /// The batches of this client not fully fetched, by id
+  std::unordered_map<std::uint64_t, std::shared_ptr<Batch>> batches;
+  std::uint64_t nextBatchId = 0;
+
+  /// Serializes the requests of this client
+  std::mutex lock;
+};
+
+using SessionId = std::decay_t<decltype(rpc::this_session().id())>;
+
+/// @brief The sessions by client connection, and their guard.
+static std::unordered_map<SessionId, std::unique_ptr<Session>> sessions;
+static std::shared_mutex sessionsLock;
+
+/// @brief Return the session of the client of the current request, created
+/// with the default backend on its first request.
+Session &getSession() {
+  const auto id = rpc::this_session().id();
+  {
+    std::shared_lock<std::shared_mutex> l(sessionsLock);
+    if (auto iter = sessions.find(id); iter != sessions.end())
+      return *iter->second;
+  }
+  std::unique_lock<std::shared_mutex> l(sessionsLock);
+  auto &session = sessions[id];
+  if (!session) {
+    session = std::make_unique<Session>();
+    session->backend = cudaq::registry::get<cudaq::TargetBackend>("default");
+  }
+  return *session;
+}
+
+/// @brief Create the target backend of the given name, with an optional
+/// sub backend after a ':'. Return nullptr if there is no such backend.
+std::unique_ptr<TargetBackend> createBackend(const std::string &backend) {
+  std::string mutableName = backend, subBackend = "";
+  auto split = cudaq::split(backend, ':');
+  if (split.size() > 1) {
+    mutableName = split[0];
+    subBackend = split[1];
+  }
+
+  auto newBackend = cudaq::registry::get<cudaq::TargetBackend>(mutableName);
+  if (newBackend && !subBackend.empty())
+    newBackend->setSpecificBackend(subBackend);
+  return newBackend;
+}
+
+/// @brief Return the initialized backend of the session.
+TargetBackend &getBackend(Session &session) {
+  if (!session.backend->isInitialized())
+    session.backend->initialize();
+  return *session.backend;
+}
+
+/// @brief Return the kernel of the given name loaded by the session, if any.
+std::optional<Kernel> findKernel(Session &session,
+                                 const std::string &kernelName) {
+  auto key = session.kernelKeys.find(kernelName);
+  if (key == session.kernelKeys.end())
+    return std::nullopt;
+  std::shared_lock<std::shared_mutex> l(jitLock);
+  auto f_iter = loadedThunkSymbols.find(key->second);
+  if (f_iter == loadedThunkSymbols.end())
+    return std::nullopt;
+
+  // Recompile the kernel optimized once it is hot.
+  if (auto t_iter = tierUps.find(key->second); t_iter != tierUps.end()) {
+    auto state = t_iter->second;
+    if (++state->calls >= tierUpCalls && !state->started.exchange(true))
+      tierUpQueue->enqueue(
+          [key = key->second, state]() { tierUp(key, state); });
+  }
+  return f_iter->second;
+}
+
 /// @brief Respond to the client with an error and
 /// return from the calling function.
 template <typename RetType>
@@ -77,32 +312,31 @@ auto backendInvokeHandleErrors(Functor &&functor, const std::string &errorMsg) {
 /// @brief Stop the server.
 void stopServer() { _stopServer = true; }
 
-/// @brief Reset the backend to the given target backend
+/// @brief Reset the backend of the client to the given target backend
 /// @param backend
 void setTargetBackend(const std::string &backend) {
   cudaq::info("Setting qpud backend to {}", backend);
-  std::string mutableName = backend, subBackend = "";
-  auto split = cudaq::split(backend, ':');
-  if (split.size() > 1) {
-    mutableName = split[0];
-    subBackend = split[1];
-  }
 
   // Set the backend, check that it is valid
-  cudaq::backend = cudaq::registry::get<cudaq::TargetBackend>(mutableName);
-  if (!cudaq::backend)
-    returnWithError<void>("Invalid target backend. (" + backend + ")");
-
-  // Set the sub backend if we have one
-  if (!subBackend.empty())
-    cudaq::backend->setSpecificBackend(subBackend);
+  auto newBackend = createBackend(backend);
+  if (!newBackend)
+    return returnWithError<void>("Invalid target backend. (" + backend + ")");
 
-  return;
+  auto &session = getSession();
+  std::lock_guard<std::mutex> l(session.lock);
+  session.backend = std::move(newBackend);
+  session.backendName = backend;
 }
 
-bool getIsSimulator() { return cudaq::backend->isSimulator(); }
+bool getIsSimulator() {
+  auto &session = getSession();
+  std::lock_guard<std::mutex> l(session.lock);
+  return session.backend->isSimulator();
+}
 bool getSupportsConditionalFeedback() {
-  return cudaq::backend->supportsConditionalFeedback();
+  auto &session = getSession();
+  std::lock_guard<std::mutex> l(session.lock);
+  return session.backend->supportsConditionalFeedback();
 }
 
 /// @brief If it has not been loaded, JIT the provided quakeCode to LLVM.
@@ -112,59 +346,108 @@ void loadQuakeCode(const std::string &kernelName, const std::string &quakeCode,
                    const std::vector<std::string> &extraLibraries) {
   cudaq::ScopedTrace trace("qpud::loadQuakeCode", kernelName, extraLibraries);
 
-  if (!cudaq::backend->isInitialized())
-    cudaq::backend->initialize();
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  auto &backend = getBackend(session);
+
+  // Ensure we have the thunk symbol
+  if (quakeCode.find(kernelName + ".thunk") == std::string::npos) {
+    return returnWithError<void>(kernelName +
+                                 ".thunk symbol not available. Please "
+                                 "compile with --enable-mlir.");
+  }
+
+  KernelKey key{kernelName, std::hash<std::string>()(session.backendName +
+                                                     '\0' + quakeCode)};
+  {
+    std::shared_lock<std::shared_mutex> l(jitLock);
+    if (loadedThunkSymbols.count(key)) {
+      session.kernelKeys[kernelName] = key;
+      return;
+    }
+  }
 
   // Will need to JIT the quakeCode to LLVM only
   // Load as MLIR Module, run the PassManager to lower to LLVM Dialect
   // Translate to LLVM Module and use MLIR ExecutionEngine
   // add to loadedThunkSymbols
-  if (!loadedThunkSymbols.count(kernelName)) {
-    // Get the LLVM Module from the backend compile phase
-    // Default will lower quake to QIR llvm, others may
-    // lower to the QIR base profile.
-    auto llvmModule = cudaq::backend->compile(*mlirContext.get(), quakeCode);
-    if (!llvmModule)
-      returnWithError<void>(
-          "[qpud::loadQuake] Failed to lower quake code to LLVM IR: " +
-          kernelName);
+  std::unique_lock<std::shared_mutex> l(jitLock);
+  if (!loadedThunkSymbols.count(key)) {
+    // Create the JITDylib of the kernel
+    auto dylib = kernelJIT->createDylib(extraLibraries);
+    if (!dylib)
+      return returnWithError<void>(
+          "[qpud::loadQuake] Could not create the JIT library of " +
+          kernelName + ": " + toString(dylib.takeError()));
 
-    std::string qirCode;
-    llvm::raw_string_ostream os(qirCode);
-    llvmModule->print(os, nullptr);
-    os.flush();
-    // Create and store the KernelJIT instance, get pointer to it
-    auto result = jitStorage.insert(
-        {kernelName, cantFail(KernelJIT::Create(extraLibraries))});
-    auto kernelJIT = result.first->second.get();
-
-    // Add the LLVM Module, Get the KERNEL.thunk function pointer
-    cantFail(kernelJIT->addModule(std::move(llvmModule)),
-             "Could not load the llvm::Module for thunk JIT.");
-
-    // Ensure we have the thunk symbol
-    std::string symbolName = kernelName + ".thunk";
-    if (quakeCode.find(symbolName) == std::string::npos) {
+    // Load the object compiled for the same code before, by this or a
+    // previous daemon, if the object cache has it. The optimized object is
+    // preferred, the unoptimized one of a tiered kernel is the fallback.
+    const int optLevel = kernelJIT->getOptLevel();
+    const bool tiered = tierUpCalls > 0 && optLevel > 0;
+    const auto optimizedKey =
+        kernelJIT->getCacheKey(quakeCode, session.backendName, optLevel);
+    const auto cacheKey =
+        tiered ? kernelJIT->getCacheKey(quakeCode, session.backendName, 0)
+               : optimizedKey;
+    auto cached = kernelJIT->addCachedObject(*dylib, optimizedKey);
+    if (cached && !*cached && tiered)
+      cached = kernelJIT->addCachedObject(*dylib, cacheKey);
+    if (!cached)
       return returnWithError<void>(
-          symbolName +
-          " symbol not available. Please compile with --enable-mlir.");
-    }
+          "[qpud::loadQuake] Could not load the cached object of " +
+          kernelName + ": " + toString(cached.takeError()));
 
-    // Apple for some reason prepends a "_"
-#if defined(__APPLE__) && defined(__MACH__)
-    symbolName = "_" + symbolName;
-#endif
+    std::string qirCode;
+    if (!*cached) {
+      // Get the LLVM Module from the backend compile phase
+      // Default will lower quake to QIR llvm, others may
+      // lower to the QIR base profile.
+      auto llvmModule = backend.compile(*mlirContext.get(), quakeCode);
+      if (!llvmModule)
+        return returnWithError<void>(
+            "[qpud::loadQuake] Failed to lower quake code to LLVM IR: " +
+            kernelName);
+
+      // Run unoptimized until the kernel is hot, else optimize it now.
+      if (tiered) {
+        llvm::raw_string_ostream os(qirCode);
+        llvmModule->print(os, nullptr);
+        os.flush();
+        auto state = std::make_shared<TierUp>();
+        state->llvmIR = qirCode;
+        state->cacheKey = optimizedKey;
+        state->extraLibraries = extraLibraries;
+        tierUps[key] = std::move(state);
+      } else if (auto err = kernelJIT->optimizeModule(*llvmModule, optLevel)) {
+        return returnWithError<void>(
+            "[qpud::loadQuake] Failed to optimize the LLVM IR of " +
+            kernelName + ": " + toString(std::move(err)));
+      } else {
+        llvm::raw_string_ostream os(qirCode);
+        llvmModule->print(os, nullptr);
+        os.flush();
+      }
+
+      // Add the LLVM Module, Get the KERNEL.thunk function pointer
+      cantFail(kernelJIT->addModule(*dylib, std::move(llvmModule), cacheKey,
+                                    tiered ? 0 : optLevel),
+               "Could not load the llvm::Module for thunk JIT.");
+    }
 
     // Get the thunk symbol
     auto symbol =
-        cantFail(kernelJIT->lookup(symbolName), "Could not find the symbol");
+        cantFail(kernelJIT->lookup(*dylib, getThunkSymbolName(kernelName)),
+                 "Could not find the symbol");
     auto *thunkFunctor =
         reinterpret_cast<DynamicResult (*)(void *, bool)>(symbol.getAddress());
 
-    // Store the thunk pointer.
+    // Store the JITDylib and the thunk pointer.
+    jitStorage.insert({key, &*dylib});
     loadedThunkSymbols.insert(
-        {kernelName, Kernel(thunkFunctor, kernelName, qirCode, quakeCode)});
+        {key, Kernel(thunkFunctor, kernelName, qirCode, quakeCode)});
   }
+  session.kernelKeys[kernelName] = key;
 }
 
 /// @brief Direct the server to execute the kernel with given name and provided
@@ -176,21 +459,21 @@ std::vector<uint8_t> executeKernel(const std::string &kernelName,
                                    std::vector<uint8_t> args) {
   cudaq::ScopedTrace trace("qpud::executeKernel", kernelName);
 
-  if (!cudaq::backend->isInitialized())
-    cudaq::backend->initialize();
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  auto &backend = getBackend(session);
 
-  auto f_iter = loadedThunkSymbols.find(kernelName);
-  if (f_iter == loadedThunkSymbols.end())
-    returnWithError<std::vector<uint8_t>>(
+  auto function = findKernel(session, kernelName);
+  if (!function)
+    return returnWithError<std::vector<uint8_t>>(
         "[qpud::base_exec] Invalid CUDA Quantum kernel name: " + kernelName);
 
-  auto function = f_iter->second;
   auto raw_args = static_cast<void *>(args.data());
 
   return backendInvokeHandleErrors(
       [&]() -> std::vector<uint8_t> {
-        auto res = cudaq::backend->baseExecute(function, raw_args,
-                                               /*isClientServer=*/true);
+        auto res = backend.baseExecute(*function, raw_args,
+                                       /*isClientServer=*/true);
         if (!res.ptr)
           return args;
         return {&res.ptr[0], &res.ptr[res.len]};
@@ -208,44 +491,174 @@ std::vector<std::size_t> sampleKernel(const std::string &kernelName,
                                       std::vector<uint8_t> args) {
   cudaq::ScopedTrace trace("qpud::sampleKernel", kernelName, shots);
 
-  if (!cudaq::backend->isInitialized())
-    cudaq::backend->initialize();
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  auto &backend = getBackend(session);
 
-  auto f_iter = loadedThunkSymbols.find(kernelName);
-  if (f_iter == loadedThunkSymbols.end())
-    returnWithError<std::vector<std::size_t>>(
+  auto function = findKernel(session, kernelName);
+  if (!function)
+    return returnWithError<std::vector<std::size_t>>(
         "[qpud::sample] Invalid CUDA Quantum kernel name: " + kernelName);
 
-  auto function = f_iter->second;
   auto raw_args = static_cast<void *>(args.data());
   return backendInvokeHandleErrors(
-      [&]() { return backend->sample(function, shots, raw_args); },
+      [&]() { return backend.sample(*function, shots, raw_args); },
       "Error in sample.");
 }
 
 /// @brief Observe the state generated by the kernel with the given spin
 /// operator
 /// @param kernelName name of the kernel to execute
-/// @param spin_op_data The operator representation <kernel|H|kernel, H.
+/// @param spin_op_data The packed spin_op H of <kernel|H|kernel>, see
+/// spin_op::getPackedRepresentation().
 /// @param args vector<uint8_t> representation of the void* kernelArgs.
 /// @return
 std::tuple<double, std::vector<std::size_t>>
-observeKernel(const std::string &kernelName, std::vector<double> spin_op_data,
+observeKernel(const std::string &kernelName,
+              const std::vector<std::uint64_t> &spin_op_data,
               const std::size_t shots, std::vector<uint8_t> &args) {
   cudaq::ScopedTrace trace("qpud::observeKernel", kernelName, shots);
-  if (!cudaq::backend->isInitialized())
-    cudaq::backend->initialize();
 
-  auto f_iter = loadedThunkSymbols.find(kernelName);
-  if (f_iter == loadedThunkSymbols.end())
-    returnWithError<double>("[qpud::observe] Invalid CUDA Quantum kernel name: " +
-                            kernelName);
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  auto &backend = getBackend(session);
+
+  auto function = findKernel(session, kernelName);
+  if (!function)
+    return returnWithError<std::tuple<double, std::vector<std::size_t>>>(
+        "[qpud::observe] Invalid CUDA Quantum kernel name: " + kernelName);
 
-  auto function = f_iter->second;
   auto raw_args = static_cast<void *>(args.data());
   return backendInvokeHandleErrors(
       [&]() {
-        return backend->observe(function, spin_op_data, shots, raw_args);
+        auto H = spin_op::fromPackedRepresentation(spin_op_data);
+        return backend.observe(*function, H, shots, raw_args);
+      },
+      "Error in observe.");
+}
+
+/// @brief Map the shared buffer of the given name, created by a client on
+/// the same host, for the arguments and results of its *Shared requests.
+/// @return False if the buffer could not be opened, the client then sends
+/// its data through RPC.
+bool attachSharedBuffer(const std::string &name) {
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  try {
+    session.sharedBuffer = SharedBuffer::open(name);
+  } catch (std::exception &e) {
+    cudaq::info("Could not attach the shared buffer {}: {}", name, e.what());
+    session.sharedBuffer.reset();
+  }
+  return session.sharedBuffer != nullptr;
+}
+
+/// @brief Return the shared buffer of the session, holding the kernel
+/// arguments, or respond with an error.
+SharedBuffer *getSharedBuffer(Session &session, std::size_t argsSize) {
+  auto *buffer = session.sharedBuffer.get();
+  if (!buffer || buffer->data() == nullptr || buffer->size() < argsSize) {
+    returnWithError<void>("[qpud] No shared buffer attached, or it is "
+                          "smaller than the kernel arguments.");
+    return nullptr;
+  }
+  return buffer;
+}
+
+/// @brief Execute the kernel on the arguments in the shared buffer, as
+/// executeKernel(). The kernel runs on the arguments in place.
+/// @return The size of the updated arguments in the shared buffer.
+std::uint64_t executeKernelShared(const std::string &kernelName,
+                                  std::uint64_t argsSize) {
+  cudaq::ScopedTrace trace("qpud::executeKernelShared", kernelName);
+
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  auto &backend = getBackend(session);
+
+  auto function = findKernel(session, kernelName);
+  if (!function)
+    return returnWithError<std::uint64_t>(
+        "[qpud::base_exec] Invalid CUDA Quantum kernel name: " + kernelName);
+  auto *buffer = getSharedBuffer(session, argsSize);
+  if (!buffer)
+    return 0;
+
+  return backendInvokeHandleErrors(
+      [&]() -> std::uint64_t {
+        auto res = backend.baseExecute(*function, buffer->data(),
+                                       /*isClientServer=*/true);
+        if (!res.ptr)
+          return argsSize;
+        buffer->reserve(res.len);
+        std::memmove(buffer->data(), res.ptr, res.len);
+        return res.len;
+      },
+      "Error in base execute.");
+}
+
+/// @brief Sample the kernel on the arguments in the shared buffer, as
+/// sampleKernel().
+/// @return The number of words of the serialized counts, written to the
+/// shared buffer.
+std::uint64_t sampleKernelShared(const std::string &kernelName,
+                                 std::size_t shots, std::uint64_t argsSize) {
+  cudaq::ScopedTrace trace("qpud::sampleKernelShared", kernelName, shots);
+
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  auto &backend = getBackend(session);
+
+  auto function = findKernel(session, kernelName);
+  if (!function)
+    return returnWithError<std::uint64_t>(
+        "[qpud::sample] Invalid CUDA Quantum kernel name: " + kernelName);
+  auto *buffer = getSharedBuffer(session, argsSize);
+  if (!buffer)
+    return 0;
+
+  return backendInvokeHandleErrors(
+      [&]() -> std::uint64_t {
+        auto counts = backend.sample(*function, shots, buffer->data());
+        const auto bytes = counts.size() * sizeof(std::size_t);
+        buffer->reserve(bytes);
+        std::memcpy(buffer->data(), counts.data(), bytes);
+        return counts.size();
+      },
+      "Error in sample.");
+}
+
+/// @brief Observe the kernel on the arguments in the shared buffer, as
+/// observeKernel().
+/// @return The expectation value and the number of words of the serialized
+/// counts, written to the shared buffer.
+std::tuple<double, std::uint64_t>
+observeKernelShared(const std::string &kernelName,
+                    const std::vector<std::uint64_t> &spin_op_data,
+                    const std::size_t shots, std::uint64_t argsSize) {
+  cudaq::ScopedTrace trace("qpud::observeKernelShared", kernelName, shots);
+
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  auto &backend = getBackend(session);
+
+  auto function = findKernel(session, kernelName);
+  if (!function)
+    return returnWithError<std::tuple<double, std::uint64_t>>(
+        "[qpud::observe] Invalid CUDA Quantum kernel name: " + kernelName);
+  auto *buffer = getSharedBuffer(session, argsSize);
+  if (!buffer)
+    return {};
+
+  return backendInvokeHandleErrors(
+      [&]() -> std::tuple<double, std::uint64_t> {
+        auto H = spin_op::fromPackedRepresentation(spin_op_data);
+        auto [exp, counts] =
+            backend.observe(*function, H, shots, buffer->data());
+        const auto bytes = counts.size() * sizeof(std::size_t);
+        buffer->reserve(bytes);
+        std::memcpy(buffer->data(), counts.data(), bytes);
+        return {exp, counts.size()};
       },
       "Error in observe.");
 }
@@ -253,28 +666,31 @@ observeKernel(const std::string &kernelName, std::vector<double> spin_op_data,
 /// @brief Observe the state generated by the kernel with the given spin
 /// operator, but immediately return with the Job ID information.
 /// @param kernelName name of the kernel to execute
-/// @param spin_op_data The operator representation <kernel|H|kernel, H.
+/// @param spin_op_data The packed spin_op H of <kernel|H|kernel>, see
+/// spin_op::getPackedRepresentation().
 /// @param args vector<uint8_t> representation of the void* kernelArgs.
 /// @return
 std::tuple<std::vector<std::string>, std::vector<std::string>>
 observeKernelDetach(const std::string &kernelName,
-                    std::vector<double> spin_op_data, const std::size_t shots,
-                    std::vector<uint8_t> &args) {
+                    const std::vector<std::uint64_t> &spin_op_data,
+                    const std::size_t shots, std::vector<uint8_t> &args) {
   cudaq::ScopedTrace trace("qpud::observeKernelDetach", kernelName, shots);
 
-  if (!cudaq::backend->isInitialized())
-    backend->initialize();
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  auto &backend = getBackend(session);
 
-  auto f_iter = loadedThunkSymbols.find(kernelName);
-  if (f_iter == loadedThunkSymbols.end())
-    returnWithError<double>("[qpud::observe] Invalid CUDA Quantum kernel name: " +
-                            kernelName);
+  auto function = findKernel(session, kernelName);
+  if (!function)
+    return returnWithError<
+        std::tuple<std::vector<std::string>, std::vector<std::string>>>(
+        "[qpud::observe] Invalid CUDA Quantum kernel name: " + kernelName);
 
-  auto function = f_iter->second;
   auto raw_args = static_cast<void *>(args.data());
   return backendInvokeHandleErrors(
       [&]() {
-        return backend->observeDetach(function, spin_op_data, shots, raw_args);
+        auto H = spin_op::fromPackedRepresentation(spin_op_data);
+        return backend.observeDetach(*function, H, shots, raw_args);
       },
       "Error in detached observe.");
 }
@@ -286,10 +702,11 @@ std::tuple<double, std::vector<std::size_t>>
 observeKernelFromJobId(const std::string &jobId) {
   cudaq::ScopedTrace trace("qpud::observeKernelFromJobId", jobId);
 
-  if (!cudaq::backend->isInitialized())
-    backend->initialize();
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  auto &backend = getBackend(session);
   return backendInvokeHandleErrors(
-      [&]() { return backend->observeFromJobId(jobId); },
+      [&]() { return backend.observeFromJobId(jobId); },
       "Error in observe from Job ID.");
 }
 
@@ -299,31 +716,166 @@ std::tuple<std::string, std::string>
 sampleKernelDetach(const std::string &kernelName, const std::size_t shots,
                    std::vector<uint8_t> &args) {
   cudaq::ScopedTrace trace("qpud::sampleKernelDetach", kernelName, shots);
-  if (!cudaq::backend->isInitialized())
-    backend->initialize();
 
-  auto f_iter = loadedThunkSymbols.find(kernelName);
-  if (f_iter == loadedThunkSymbols.end())
-    returnWithError<double>("[qpud::sampleDetach] Invalid CUDA Quantum kernel name: " +
-                            kernelName);
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  auto &backend = getBackend(session);
+
+  auto function = findKernel(session, kernelName);
+  if (!function)
+    return returnWithError<std::tuple<std::string, std::string>>(
+        "[qpud::sampleDetach] Invalid CUDA Quantum kernel name: " +
+        kernelName);
 
-  auto function = f_iter->second;
   auto raw_args = static_cast<void *>(args.data());
   return backendInvokeHandleErrors(
-      [&]() { return backend->sampleDetach(function, shots, raw_args); },
+      [&]() { return backend.sampleDetach(*function, shots, raw_args); },
       "Error in detached sample.");
 }
 
+/// @brief Submit the executions of the kernel on each of the argument sets,
+/// which run concurrently on the batch workers, each on its own backend. The
+/// kernel is sampled if spin_op_data is empty, observed otherwise (see
+/// observeKernel()).
+/// @return The id of the batch, whose results are returned by
+/// fetchBatchResults() as they finish.
+std::uint64_t submitKernelBatch(const std::string &kernelName,
+                                const std::vector<std::uint64_t> &spin_op_data,
+                                const std::size_t shots,
+                                std::vector<std::vector<uint8_t>> argSets) {
+  cudaq::ScopedTrace trace("qpud::submitKernelBatch", kernelName, shots,
+                           argSets.size());
+
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+
+  auto function = findKernel(session, kernelName);
+  if (!function)
+    return returnWithError<std::uint64_t>(
+        "[qpud::batch] Invalid CUDA Quantum kernel name: " + kernelName);
+
+  // Each execution observes its own copy of the spin_op.
+  std::shared_ptr<const spin_op> spinOp;
+  if (!spin_op_data.empty()) {
+    try {
+      spinOp = std::make_shared<const spin_op>(
+          spin_op::fromPackedRepresentation(spin_op_data));
+    } catch (std::exception &e) {
+      return returnWithError<std::uint64_t>("[qpud::batch] " +
+                                            std::string(e.what()));
+    }
+  }
+
+  auto batch = std::make_shared<Batch>();
+  batch->unfetched = argSets.size();
+  const auto backendName = session.backendName;
+  for (std::size_t i = 0; i < argSets.size(); i++) {
+    QuantumTask task = [batch, spinOp, backendName, shots, i,
+                        function = *function,
+                        args = std::move(argSets[i])]() mutable {
+      std::unique_ptr<TargetBackend> backend;
+      {
+        std::lock_guard<std::mutex> l(batch->lock);
+        if (!batch->error.empty())
+          return;
+        if (!batch->backends.empty()) {
+          backend = std::move(batch->backends.back());
+          batch->backends.pop_back();
+        }
+      }
+
+      BatchResult result{i, 0.0, {}};
+      std::string error;
+      try {
+        if (!backend)
+          backend = createBackend(backendName);
+        if (!backend->isInitialized())
+          backend->initialize();
+        if (!spinOp)
+          std::get<2>(result) = backend->sample(function, shots, args.data());
+        else {
+          auto H = *spinOp;
+          std::tie(std::get<1>(result), std::get<2>(result)) =
+              backend->observe(function, H, shots, args.data());
+        }
+      } catch (std::exception &e) {
+        error = "Error in batch execution " + std::to_string(i) + ": " +
+                e.what();
+      }
+
+      std::lock_guard<std::mutex> l(batch->lock);
+      if (!error.empty()) {
+        if (batch->error.empty())
+          batch->error = error;
+      } else
+        batch->finished.push_back(std::move(result));
+      if (backend)
+        batch->backends.push_back(std::move(backend));
+      batch->cv.notify_all();
+    };
+    batchQueue->enqueue(task);
+  }
+
+  const auto id = session.nextBatchId++;
+  session.batches.insert({id, std::move(batch)});
+  return id;
+}
+
+/// @brief Wait for results of the given batch, and return those finished
+/// since the last call. The batch is released when all its results have
+/// been returned, or when one of its executions failed.
+std::vector<BatchResult> fetchBatchResults(std::uint64_t batchId) {
+  cudaq::ScopedTrace trace("qpud::fetchBatchResults", batchId);
+
+  auto &session = getSession();
+  std::shared_ptr<Batch> batch;
+  {
+    std::lock_guard<std::mutex> sessionGuard(session.lock);
+    auto iter = session.batches.find(batchId);
+    if (iter == session.batches.end())
+      return returnWithError<std::vector<BatchResult>>(
+          "[qpud::batch] Invalid batch id: " + std::to_string(batchId));
+    batch = iter->second;
+  }
+
+  // Wait without holding the session, so that the client can keep other
+  // requests in flight.
+  std::vector<BatchResult> results;
+  std::string error;
+  bool done = false;
+  {
+    std::unique_lock<std::mutex> l(batch->lock);
+    batch->cv.wait(l, [&]() {
+      return !batch->finished.empty() || !batch->error.empty() ||
+             batch->unfetched == 0;
+    });
+    error = batch->error;
+    results = std::move(batch->finished);
+    batch->finished.clear();
+    batch->unfetched -= results.size();
+    done = !error.empty() || batch->unfetched == 0;
+  }
+
+  if (done) {
+    std::lock_guard<std::mutex> sessionGuard(session.lock);
+    session.batches.erase(batchId);
+  }
+  if (!error.empty())
+    return returnWithError<std::vector<BatchResult>>("[qpud::batch] " + error);
+  return results;
+}
+
 /// @brief Produce the result from a detached observe job
 /// @param jobId
 /// @return
 std::vector<std::size_t> sampleKernelFromJobId(const std::string &jobId) {
   cudaq::ScopedTrace trace("qpud::sampleKernelFromJobId", jobId);
 
-  if (!cudaq::backend->isInitialized())
-    backend->initialize();
+  auto &session = getSession();
+  std::lock_guard<std::mutex> sessionGuard(session.lock);
+  auto &backend = getBackend(session);
   return backendInvokeHandleErrors(
-      [&]() { return backend->sampleFromJobId(jobId); },
+      [&]() { return backend.sampleFromJobId(jobId); },
       "Error in sample from Job ID.");
 }
 
@@ -331,6 +883,23 @@ std::vector<std::size_t> sampleKernelFromJobId(const std::string &jobId) {
 
 int main(int argc, char **argv) {
   int qpu_id = 0, port = 8888;
+  // The requests of different clients are served concurrently by the
+  // workers.
+  int workers = std::max(1u, std::thread::hardware_concurrency());
+  // The executions of batches run on their own workers.
+  int batchWorkers = workers;
+  // The directory of the compiled kernel objects, kept across restarts.
+  std::string objectCacheDir;
+  if (auto *dir = std::getenv("CUDAQ_QPUD_OBJECT_CACHE_DIR"))
+    objectCacheDir = dir;
+  // The optimization level of the kernels, CUDAQ_JIT_OPT_LEVEL by default.
+  int optLevel = 2;
+  try {
+    optLevel = cudaq::getJITOptLevel();
+  } catch (std::exception &e) {
+    llvm::errs() << "[qpud] " << e.what() << "\n";
+    return -1;
+  }
   std::vector<std::string> args(&argv[0], &argv[0] + argc);
   for (std::size_t i = 0; i < args.size(); i++) {
     if (args[i] == "--qpu") {
@@ -361,6 +930,93 @@ int main(int argc, char **argv) {
         return -1;
       }
     }
+
+    if (args[i] == "--object-cache") {
+      if (i == args.size() - 1) {
+        llvm::errs()
+            << "--object-cache specified but no directory provided.\n";
+        return -1;
+      }
+      objectCacheDir = args[i + 1];
+    }
+
+    if (args[i] == "--job-store") {
+      if (i == args.size() - 1) {
+        llvm::errs() << "--job-store specified but no directory provided.\n";
+        return -1;
+      }
+      // Keep the results of detached jobs in this directory, across
+      // restarts, with the default memory budget unless set by
+      // CUDAQ_QPUD_JOB_STORE_BYTES.
+      try {
+        auto &store = cudaq::DetachedJobStore::get();
+        store.configure(args[i + 1], store.maxMemoryBytes());
+      } catch (std::exception &e) {
+        llvm::errs() << "[qpud] Invalid job store directory (" << args[i + 1]
+                     << "): " << e.what() << "\n";
+        return -1;
+      }
+    }
+
+    if (args[i] == "--batch-workers") {
+      if (i == args.size() - 1) {
+        llvm::errs() << "--batch-workers specified but no count provided.\n";
+        return -1;
+      }
+      std::string arg = args[i + 1];
+      auto [ptr, ec] =
+          std::from_chars(arg.data(), arg.data() + arg.size(), batchWorkers);
+      if (ec == std::errc::invalid_argument || batchWorkers < 1) {
+        llvm::errs() << "[qpud] Invalid batch worker count (" << arg
+                     << "). Provide a positive integer.\n";
+        return -1;
+      }
+    }
+
+    if (args[i] == "--opt-level") {
+      if (i == args.size() - 1) {
+        llvm::errs() << "--opt-level specified but no level provided.\n";
+        return -1;
+      }
+      std::string arg = args[i + 1];
+      auto [ptr, ec] =
+          std::from_chars(arg.data(), arg.data() + arg.size(), optLevel);
+      if (ec == std::errc::invalid_argument || optLevel < 0 || optLevel > 3) {
+        llvm::errs() << "[qpud] Invalid optimization level (" << arg
+                     << "). Provide an integer [0,3].\n";
+        return -1;
+      }
+    }
+
+    if (args[i] == "--tier-up-calls") {
+      if (i == args.size() - 1) {
+        llvm::errs() << "--tier-up-calls specified but no count provided.\n";
+        return -1;
+      }
+      std::string arg = args[i + 1];
+      auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.size(),
+                                       cudaq::tierUpCalls);
+      if (ec == std::errc::invalid_argument) {
+        llvm::errs() << "[qpud] Invalid tier up call count (" << arg
+                     << "). Provide a non-negative integer.\n";
+        return -1;
+      }
+    }
+
+    if (args[i] == "--workers") {
+      if (i == args.size() - 1) {
+        llvm::errs() << "--workers specified but no count provided.\n";
+        return -1;
+      }
+      std::string arg = args[i + 1];
+      auto [ptr, ec] =
+          std::from_chars(arg.data(), arg.data() + arg.size(), workers);
+      if (ec == std::errc::invalid_argument || workers < 1) {
+        llvm::errs() << "[qpud] Invalid worker count (" << arg
+                     << "). Provide a positive integer.\n";
+        return -1;
+      }
+    }
   }
 
   // One time initialization of LLVM
@@ -380,8 +1036,15 @@ int main(int argc, char **argv) {
   // Register the translation to LLVM IR with the MLIR context.
   mlir::registerLLVMDialectTranslation(*cudaq::mlirContext.get());
 
-  // Create the Default Target Backend.
-  cudaq::backend = cudaq::registry::get<cudaq::TargetBackend>("default");
+  // Create the JIT of all kernels.
+  cudaq::kernelJIT =
+      cantFail(cudaq::KernelJIT::Create(objectCacheDir, optLevel),
+               "Could not create the kernel JIT.");
+  cudaq::tierUpQueue = std::make_unique<cudaq::QuantumExecutionQueue>(1);
+
+  // Create the workers of the batches.
+  cudaq::batchQueue =
+      std::make_unique<cudaq::QuantumExecutionQueue>(batchWorkers);
 
   // Create the server and bind the functions
   std::unique_ptr<rpc::server> server;
@@ -393,6 +1056,12 @@ int main(int argc, char **argv) {
     server->bind("sampleKernelDetach", &cudaq::sampleKernelDetach);
     server->bind("sampleKernelFromJobId", &cudaq::sampleKernelFromJobId);
     server->bind("observeKernel", &cudaq::observeKernel);
+    server->bind("attachSharedBuffer", &cudaq::attachSharedBuffer);
+    server->bind("executeKernelShared", &cudaq::executeKernelShared);
+    server->bind("sampleKernelShared", &cudaq::sampleKernelShared);
+    server->bind("observeKernelShared", &cudaq::observeKernelShared);
+    server->bind("submitKernelBatch", &cudaq::submitKernelBatch);
+    server->bind("fetchBatchResults", &cudaq::fetchBatchResults);
     server->bind("observeKernelFromJobId", &cudaq::observeKernelFromJobId);
     server->bind("observeKernelDetach", &::cudaq::observeKernelDetach);
     server->bind("setTargetBackend", &cudaq::setTargetBackend);
@@ -404,7 +1073,7 @@ int main(int argc, char **argv) {
     cudaq::NvidiaPlatformHelper helper;
     helper.setQPU(qpu_id);
 
-    server->async_run();
+    server->async_run(workers);
   } catch (std::exception &e) {
     printf("%s\n", e.what());
     return -1;
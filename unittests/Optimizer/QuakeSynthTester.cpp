@@ -13,6 +13,7 @@
 #include "cudaq/Optimizer/Transforms/Passes.h"
 #include "cudaq/algorithm.h"
 #include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/ExecutionEngine/ExecutionEngine.h"
 #include "mlir/IR/BuiltinOps.h"
 #include "mlir/Parser/Parser.h"
@@ -265,6 +266,58 @@ TEST(QuakeSynthTester, checkVector) {
   EXPECT_NEAR(energy, -2.045375, 1e-3);
 }
 
+TEST(QuakeSynthTester, checkLargeVector) {
+  // The same circuit as checkVector, with 30 parameters of which all but the
+  // first two are zero rotations.
+  auto [kernel, thetas] = cudaq::make_kernel<std::vector<double>>();
+  auto theta = thetas[0];
+  auto phi = thetas[1];
+  auto q = kernel.qalloc(3);
+  kernel.x(q[0]);
+  kernel.ry(theta, q[1]);
+  kernel.ry(phi, q[2]);
+  for (std::size_t i = 2; i < 30; i++)
+    kernel.ry(thetas[i], q[i % 3]);
+  kernel.x<cudaq::ctrl>(q[2], q[0]);
+  kernel.x<cudaq::ctrl>(q[0], q[1]);
+  kernel.ry(-theta, q[1]);
+  kernel.x<cudaq::ctrl>(q[0], q[1]);
+  kernel.x<cudaq::ctrl>(q[1], q[0]);
+
+  auto properName = cudaq::runtime::cudaqGenPrefixName + kernel.name();
+
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+  cudaq::spin_op h3 = h + 9.625 - 9.625 * z(2) - 3.913119 * x(1) * x(2) -
+                      3.913119 * y(1) * y(2);
+
+  std::vector<double> parameters(30, 0.);
+  parameters[0] = .3591;
+  parameters[1] = .2569;
+  double energy = cudaq::observe(kernel, h3, parameters);
+  EXPECT_NEAR(energy, -2.045375, 1e-3);
+
+  auto context = cudaq::initializeMLIR();
+  auto module = parseSourceString<ModuleOp>(kernel.to_quake(), context.get());
+  auto [args, offset] = cudaq::mapToRawArgs(kernel.name(), parameters);
+  EXPECT_TRUE(succeeded(runQuakeSynth(kernel.name(), args, module)));
+
+  // The parameters are a single global array, not a constant per element.
+  auto func = module->lookupSymbol<func::FuncOp>(properName);
+  EXPECT_TRUE(func);
+  EXPECT_TRUE(func.getArguments().empty());
+  auto global = module->lookupSymbol<LLVM::GlobalOp>(properName + ".arg0");
+  EXPECT_TRUE(global);
+
+  EXPECT_TRUE(succeeded(lowerToLLVMDialect(*module)));
+  auto jitOrError = ExecutionEngine::create(*module);
+  EXPECT_TRUE(!!jitOrError);
+  std::unique_ptr<ExecutionEngine> jit = std::move(jitOrError.get());
+  energy = observeJitCode(jit.get(), h3, kernel.name());
+  EXPECT_NEAR(energy, -2.045375, 1e-3);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
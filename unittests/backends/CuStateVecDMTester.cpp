@@ -0,0 +1,125 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include <complex>
+#include <gtest/gtest.h>
+
+#include "CUDAQTestUtils.h"
+#include "CircuitSimulator.h"
+#include "ReferenceState.h"
+#include "common/ExecutionContext.h"
+#include "common/NoiseModel.h"
+
+using nvqir::GateName;
+using nvqir::getGateByName;
+
+// The backend is a CUDA source, so its simulator is taken from the linked
+// plugin rather than compiled into this tester.
+extern "C" nvqir::CircuitSimulator *getCircuitSimulator_custatevec_dm();
+
+namespace {
+/// Check that the density matrix extracted in the context is the mixture of
+/// the weighted reference states.
+void expectDensityMatrix(const cudaq::ExecutionContext &context,
+                         const std::vector<ReferenceState> &refs,
+                         const std::vector<double> &weights) {
+  ASSERT_TRUE(context.simulationState);
+  auto [dims, data] = context.simulationState->toState();
+  const std::size_t dim = refs.front().data.size();
+  ASSERT_EQ(dims, std::vector<std::size_t>({dim, dim}));
+  for (std::size_t i = 0; i < dim; i++)
+    for (std::size_t j = 0; j < dim; j++) {
+      std::complex<double> expected = 0.;
+      for (std::size_t k = 0; k < refs.size(); k++)
+        expected += weights[k] * refs[k].data[i] * std::conj(refs[k].data[j]);
+      EXPECT_NEAR(data[i * dim + j].real(), expected.real(), 1e-10);
+      EXPECT_NEAR(data[i * dim + j].imag(), expected.imag(), 1e-10);
+    }
+}
+} // namespace
+
+CUDAQ_TEST(CuStateVecDMTester, checkGatesMatchReference) {
+  auto &sim = *getCircuitSimulator_custatevec_dm();
+  cudaq::ExecutionContext context("extract-state");
+  sim.setExecutionContext(&context);
+  const std::size_t nQubits = 5;
+  ReferenceState ref(nQubits);
+  auto qubits = sim.allocateQubits(nQubits);
+  applyReferenceCircuit(sim, ref, {{}, {0}, {nQubits - 1}, {1, 3}});
+  sim.swap({2}, 0, 4);
+  ref.swap({2}, 0, 4);
+  sim.resetExecutionContext();
+  expectDensityMatrix(context, {ref}, {1.});
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(CuStateVecDMTester, checkDepolarizingChannel) {
+  // Depolarizing the Hadamard mixes the state with its three Pauli images,
+  // which the later gates then carry along.
+  const double p = .15;
+  cudaq::noise_model noise;
+  noise.add_channel<cudaq::types::h>({0}, cudaq::depolarization_channel(p));
+  cudaq::ExecutionContext context("extract-state");
+  context.noiseModel = &noise;
+
+  auto &sim = *getCircuitSimulator_custatevec_dm();
+  sim.setExecutionContext(&context);
+  auto qubits = sim.allocateQubits(3);
+  std::vector<ReferenceState> refs(4, ReferenceState(3));
+  sim.h(0);
+  for (auto &ref : refs)
+    ref.apply(getGateByName<double>(GateName::H), {}, 0);
+  refs[1].apply(getGateByName<double>(GateName::X), {}, 0);
+  refs[2].apply(getGateByName<double>(GateName::Y), {}, 0);
+  refs[3].apply(getGateByName<double>(GateName::Z), {}, 0);
+  sim.x({0}, 1);
+  sim.ry(.4, 2);
+  sim.t({1}, 2);
+  for (auto &ref : refs) {
+    ref.apply(getGateByName<double>(GateName::X), {0}, 1);
+    ref.apply(getGateByName<double>(GateName::Ry, {.4}), {}, 2);
+    ref.apply(getGateByName<double>(GateName::T), {1}, 2);
+  }
+
+  // The exact <Z...Z> of the sample matches the mixture.
+  double parity = (1. - p) * refs[0].parity({0, 2});
+  for (std::size_t k = 1; k < refs.size(); k++)
+    parity += p / 3. * refs[k].parity({0, 2});
+  EXPECT_NEAR(sim.sample({0, 2}, 0).expectationValue.value(), parity, 1e-10);
+  sim.resetExecutionContext();
+  expectDensityMatrix(context, refs, {1. - p, p / 3., p / 3., p / 3.});
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(CuStateVecDMTester, checkMeasureAndReset) {
+  auto &sim = *getCircuitSimulator_custatevec_dm();
+  cudaq::ExecutionContext context("extract-state");
+  sim.setExecutionContext(&context);
+  auto qubits = sim.allocateQubits(3);
+  sim.x(1);
+  sim.swap({}, 1, 2);
+  EXPECT_FALSE(sim.mz(1));
+  EXPECT_TRUE(sim.mz(2));
+
+  // The outcome of a Bell pair is random, but fixes its partner.
+  sim.h(0);
+  sim.x({0}, 1);
+  EXPECT_EQ(sim.mz(0), sim.mz(1));
+
+  // Reset is a channel, the superposition does not survive it.
+  sim.h(2);
+  sim.resetQubit(0);
+  sim.resetQubit(1);
+  sim.resetQubit(2);
+  sim.resetExecutionContext();
+  expectDensityMatrix(context, {ReferenceState(3)}, {1.});
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
@@ -0,0 +1,223 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include <complex>
+#include <gtest/gtest.h>
+#include <random>
+
+#include "CUDAQTestUtils.h"
+#include "Gates.h"
+#include "ReferenceState.h"
+#include <cudaq/algorithm.h>
+
+#define __NVQIR_EXTENDED_STABILIZER_TOGGLE_CREATE
+#include "ExtendedStabilizerCircuitSimulator.cpp"
+
+using nvqir::GateName;
+using nvqir::getGateByName;
+
+namespace {
+const std::vector<std::vector<std::size_t>> measuredSets{
+    {0}, {3}, {1, 2}, {0, 2, 3}, {0, 1, 2, 3}};
+
+/// Apply the same random Clifford + non-Clifford circuit to both states.
+void applyRandomCircuit(std::mt19937 &gen, std::size_t nQubits,
+                        nvqir::ExtendedStabilizerCircuitSimulator &sim,
+                        ReferenceState &ref) {
+  auto pick = [&]() { return std::size_t(gen() % nQubits); };
+  for (int gate = 0; gate < 30; gate++) {
+    const auto t = pick();
+    auto c = pick();
+    if (c == t)
+      c = (t + 1) % nQubits;
+    auto b = pick();
+    while (b == t || b == c)
+      b = (b + 1) % nQubits;
+    const double angle = 0.1 + 0.37 * (gen() % 17);
+    switch (gen() % 14) {
+    case 0:
+      sim.h(t);
+      ref.apply(getGateByName<double>(GateName::H), {}, t);
+      break;
+    case 1:
+      sim.s(t);
+      ref.apply(getGateByName<double>(GateName::S), {}, t);
+      break;
+    case 2:
+      sim.x({c}, t);
+      ref.apply(getGateByName<double>(GateName::X), {c}, t);
+      break;
+    case 3:
+      sim.z({c}, t);
+      ref.apply(getGateByName<double>(GateName::Z), {c}, t);
+      break;
+    case 4:
+      sim.t(t);
+      ref.apply(getGateByName<double>(GateName::T), {}, t);
+      break;
+    case 5:
+      sim.tdg(t);
+      ref.apply(getGateByName<double>(GateName::Tdg), {}, t);
+      break;
+    case 6:
+      sim.rx(angle, t);
+      ref.apply(getGateByName<double>(GateName::Rx, {angle}), {}, t);
+      break;
+    case 7:
+      sim.ry(angle, t);
+      ref.apply(getGateByName<double>(GateName::Ry, {angle}), {}, t);
+      break;
+    case 8:
+      sim.r1(angle, {c}, t);
+      ref.apply(getGateByName<double>(GateName::R1, {angle}), {c}, t);
+      break;
+    case 9:
+      sim.rx(angle, {c}, t);
+      ref.apply(getGateByName<double>(GateName::Rx, {angle}), {c}, t);
+      break;
+    case 10:
+      sim.ry(angle, {c}, t);
+      ref.apply(getGateByName<double>(GateName::Ry, {angle}), {c}, t);
+      break;
+    case 11:
+      sim.x({c, b}, t);
+      ref.apply(getGateByName<double>(GateName::X), {c, b}, t);
+      break;
+    case 12:
+      sim.u3(angle, 0.3, -angle, {}, t);
+      ref.apply(getGateByName<double>(GateName::U3, {angle, 0.3, -angle}),
+                {}, t);
+      break;
+    default:
+      sim.t({c}, t);
+      ref.apply(getGateByName<double>(GateName::T), {c}, t);
+      break;
+    }
+  }
+}
+} // namespace
+
+CUDAQ_TEST(ExtendedStabilizerTester, checkRandomCircuits) {
+  std::mt19937 gen(17);
+  const std::size_t nQubits = 4;
+  for (int circuit = 0; circuit < 20; circuit++) {
+    nvqir::ExtendedStabilizerCircuitSimulator sim;
+    ReferenceState ref(nQubits);
+    auto qubits = sim.allocateQubits(nQubits);
+    applyRandomCircuit(gen, nQubits, sim, ref);
+
+    for (const auto &measured : measuredSets) {
+      EXPECT_NEAR(sim.sample(measured, 0).expectationValue.value(),
+                  ref.parity(measured), 1e-9);
+
+      // Every sampled outcome must have a nonzero probability.
+      auto result = sim.sample(measured, 100);
+      std::size_t total = 0;
+      for (auto &[bits, count] : result.counts) {
+        total += count;
+        EXPECT_GT(ref.probability(measured, bits), 1e-9) << bits;
+      }
+      EXPECT_EQ(total, 100);
+    }
+
+    // Measuring collapses both states the same way.
+    for (std::size_t q : {2, 0}) {
+      const bool result = sim.mz(q);
+      EXPECT_GT(ref.probability({q}, result ? "1" : "0"), 1e-9);
+      ref.project(q, result);
+      for (const auto &measured : measuredSets)
+        EXPECT_NEAR(sim.sample(measured, 0).expectationValue.value(),
+                    ref.parity(measured), 1e-9);
+    }
+
+    for (auto q : qubits)
+      sim.deallocate(q);
+  }
+}
+
+CUDAQ_TEST(ExtendedStabilizerTester, checkSampleStatistics) {
+  nvqir::ExtendedStabilizerCircuitSimulator sim;
+  ReferenceState ref(3);
+  auto qubits = sim.allocateQubits(3);
+  // A GHZ state with a T rotated in the middle.
+  sim.h(0);
+  sim.x({0}, 1);
+  sim.x({1}, 2);
+  sim.h(1);
+  sim.t(1);
+  sim.h(1);
+  for (auto [gate, controls, target] :
+       std::vector<std::tuple<GateName, std::vector<std::size_t>,
+                              std::size_t>>{{GateName::H, {}, 0},
+                                            {GateName::X, {0}, 1},
+                                            {GateName::X, {1}, 2},
+                                            {GateName::H, {}, 1},
+                                            {GateName::T, {}, 1},
+                                            {GateName::H, {}, 1}})
+    ref.apply(getGateByName<double>(gate), controls, target);
+
+  const int shots = 20000;
+  auto result = sim.sample({0, 1, 2}, shots);
+  for (auto &[bits, count] : result.counts)
+    EXPECT_NEAR(double(count) / shots, ref.probability({0, 1, 2}, bits), 0.02)
+        << bits;
+  EXPECT_GT(sim.getNumTerms(), 1);
+
+  // Sampling leaves the state unchanged.
+  EXPECT_NEAR(sim.sample({1}, 0).expectationValue.value(), ref.parity({1}),
+              1e-9);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(ExtendedStabilizerTester, checkToffoliAndFredkin) {
+  nvqir::ExtendedStabilizerCircuitSimulator sim;
+  auto qubits = sim.allocateQubits(3);
+  sim.x(0);
+  sim.x({0, 1}, 2);
+  EXPECT_FALSE(sim.mz(2));
+  sim.x(1);
+  sim.x({0, 1}, 2);
+  EXPECT_TRUE(sim.mz(2));
+
+  sim.x(2);
+  sim.swap({0}, 1, 2);
+  sim.x(0);
+  sim.swap({0}, 1, 2);
+  EXPECT_FALSE(sim.mz(1));
+  EXPECT_TRUE(sim.mz(2));
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(ExtendedStabilizerTester, checkUnsupportedGatesThrow) {
+  nvqir::ExtendedStabilizerCircuitSimulator sim;
+  auto qubits = sim.allocateQubits(4);
+  EXPECT_NO_THROW(sim.t(0));
+  EXPECT_NO_THROW(sim.rz(0.3, {0}, 1));
+  EXPECT_THROW(sim.h({0}, 1), std::runtime_error);
+  EXPECT_THROW(sim.x({0, 1, 2}, 3), std::runtime_error);
+  EXPECT_THROW(sim.rx(0.3, {0, 1}, 2), std::runtime_error);
+  EXPECT_THROW(sim.getStateData(), std::runtime_error);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(ExtendedStabilizerTester, checkObserve) {
+  auto kernel = []() __qpu__ {
+    cudaq::qreg q(2);
+    h(q[0]);
+    t(q[0]);
+    x<cudaq::ctrl>(q[0], q[1]);
+  };
+
+  // <X0 X1> = cos(pi / 4), <Y0 Y1> = -cos(pi / 4).
+  using namespace cudaq::spin;
+  cudaq::spin_op h = x(0) * x(1) - y(0) * y(1) + z(0) * z(1);
+  EXPECT_NEAR(cudaq::observe(kernel, h), 1. + std::sqrt(2.), 1e-9);
+}
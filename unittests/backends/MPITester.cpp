@@ -0,0 +1,92 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include <complex>
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+#include "CUDAQTestUtils.h"
+#include "ReferenceState.h"
+
+#define __NVQIR_MPI_TOGGLE_CREATE
+#include "MPICircuitSimulator.cpp"
+
+using namespace nvqir;
+
+// These tests also run under mpiexec, distributing even the smallest states
+// so that global qubits and the rank exchange are exercised.
+
+namespace {
+int numRanks() {
+  int size = 1;
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  return size;
+}
+} // namespace
+
+CUDAQ_TEST(MPITester, checkCircuitMatchesReference) {
+  setenv("CUDAQ_MPI_MIN_LOCAL_QUBITS", "1", 1);
+  MPICircuitSimulator sim;
+  const std::size_t nQubits = 6;
+  ReferenceState ref(nQubits);
+  auto qubits = sim.allocateQubits(nQubits);
+  unsetenv("CUDAQ_MPI_MIN_LOCAL_QUBITS");
+  EXPECT_EQ(sim.isDistributed(), numRanks() > 1);
+
+  // Controls on the top qubits start out global.
+  const std::vector<std::vector<std::size_t>> controlSets{
+      {}, {0}, {nQubits - 1}, {nQubits - 2, nQubits - 1}, {1, 3}};
+  applyReferenceCircuit(sim, ref, controlSets);
+  expectReferenceState(sim, ref);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(MPITester, checkSwapMeasureAndSample) {
+  setenv("CUDAQ_MPI_MIN_LOCAL_QUBITS", "1", 1);
+  MPICircuitSimulator sim;
+  auto qubits = sim.allocateQubits(6);
+  unsetenv("CUDAQ_MPI_MIN_LOCAL_QUBITS");
+  sim.x(0);
+  sim.swap({}, 0, 5);
+  EXPECT_FALSE(sim.mz(0));
+  EXPECT_TRUE(sim.mz(5));
+
+  // Controlled swap only fires with the control set.
+  sim.swap({4}, 5, 1);
+  EXPECT_TRUE(sim.mz(5));
+  sim.x(4);
+  sim.swap({4}, 5, 1);
+  EXPECT_FALSE(sim.mz(5));
+  EXPECT_TRUE(sim.mz(1));
+
+  sim.resetQubit(1);
+  sim.resetQubit(4);
+  EXPECT_FALSE(sim.mz(1));
+  EXPECT_FALSE(sim.mz(4));
+
+  // All ranks return the same GHZ counts.
+  sim.h(5);
+  for (std::size_t q = 0; q < 5; q++)
+    sim.x({5}, q);
+  auto result = sim.sample({0, 1, 2, 3, 4, 5}, 1000);
+  std::size_t total = 0;
+  for (auto &[bits, count] : result.counts) {
+    EXPECT_TRUE(bits == "000000" || bits == "111111");
+    total += count;
+  }
+  EXPECT_EQ(total, 1000);
+  EXPECT_NEAR(result.expectationValue.value(), 1.0, 1e-12);
+
+  std::size_t zeros = result.counts["000000"], minZeros = 0, maxZeros = 0;
+  MPI_Allreduce(&zeros, &minZeros, 1, MPI_UINT64_T, MPI_MIN, MPI_COMM_WORLD);
+  MPI_Allreduce(&zeros, &maxZeros, 1, MPI_UINT64_T, MPI_MAX, MPI_COMM_WORLD);
+  EXPECT_EQ(minZeros, maxZeros);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
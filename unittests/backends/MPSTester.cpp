@@ -0,0 +1,92 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include <complex>
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+#include "CUDAQTestUtils.h"
+#include "ReferenceState.h"
+#include <cudaq/algorithm.h>
+
+#define __NVQIR_MPS_TOGGLE_CREATE
+#include "MPSCircuitSimulator.cpp"
+
+namespace {
+struct ghz {
+  void operator()(const int N) __qpu__ {
+    cudaq::qreg q(N);
+    h(q[0]);
+    for (int i = 0; i < N - 1; i++)
+      x<cudaq::ctrl>(q[i], q[i + 1]);
+    mz(q);
+  }
+};
+} // namespace
+
+CUDAQ_TEST(MPSTester, checkGatesMatchReference) {
+  const std::size_t nQubits = 7;
+  nvqir::MPSCircuitSimulator sim;
+  ReferenceState ref(nQubits, /*reversedOrder=*/true);
+  auto qubits = sim.allocateQubits(nQubits);
+  applyReferenceCircuit(sim, ref, {{}, {0}, {nQubits - 1}, {2, 5}});
+
+  // A swap of distant qubits, controlled on a qubit in between.
+  sim.swap({3}, 0, 6);
+  ref.swap({3}, 0, 6);
+  expectReferenceState(sim, ref);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(MPSTester, checkBondDimensionCap) {
+  setenv("CUDAQ_MPS_MAX_BOND_DIM", "4", 1);
+  nvqir::MPSCircuitSimulator sim;
+  unsetenv("CUDAQ_MPS_MAX_BOND_DIM");
+
+  // A brickwork circuit on 60 qubits, far beyond a state vector.
+  const std::size_t nQubits = 60;
+  auto qubits = sim.allocateQubits(nQubits);
+  for (std::size_t layer = 0; layer < 6; layer++) {
+    for (std::size_t q = 0; q < nQubits; q++)
+      sim.ry(0.4 + 0.1 * layer, q);
+    for (std::size_t q = layer % 2; q + 1 < nQubits; q += 2)
+      sim.x({q}, q + 1);
+  }
+  EXPECT_LE(sim.getMaxBondDimension(), 4);
+
+  auto result = sim.sample({0, 30, 59}, 200);
+  std::size_t total = 0;
+  for (auto &[bits, count] : result.counts) {
+    EXPECT_EQ(bits.size(), 3);
+    total += count;
+  }
+  EXPECT_EQ(total, 200);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(MPSTester, checkLargeGHZ) {
+  auto counts = cudaq::sample(100, ghz{}, 80);
+  std::size_t total = 0;
+  for (auto &[bits, count] : counts) {
+    total += count;
+    EXPECT_TRUE(bits == std::string(80, '0') || bits == std::string(80, '1'));
+  }
+  EXPECT_EQ(total, 100);
+
+  auto kernel = []() __qpu__ {
+    cudaq::qreg q(80);
+    h(q[0]);
+    for (int i = 0; i < 79; i++)
+      x<cudaq::ctrl>(q[i], q[i + 1]);
+  };
+  using namespace cudaq::spin;
+  cudaq::spin_op h = z(0) * z(79) + 0.5 * z(40) + 2. * x(0) * x(79);
+  EXPECT_NEAR(cudaq::observe(kernel, h), 1., 1e-9);
+}
@@ -7,11 +7,13 @@
  *******************************************************************************/
 
 #include <complex>
+#include <filesystem>
 #include <gtest/gtest.h>
 #include <iostream>
 #include <math.h>
 
 #include "CUDAQTestUtils.h"
+#include "PauliEvolution.h"
 #include "QppCircuitSimulator.cpp"
 
 #define _USE_MATH_DEFINES
@@ -1241,3 +1243,1091 @@ CUDAQ_TEST(QPPTester, checkReset) {
     EXPECT_EQ(1, qppBackend.mz(q1));
   }
 }
+
+// Checks the in-place gate kernels against the Q++ reference `applyCTRL`
+// on a non-trivial 4 qubit state, with and without control qubits.
+CUDAQ_TEST(QPPTester, checkInPlaceGateKernels) {
+  const std::size_t num_qubits = 4;
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  auto qubits = qppBackend.allocateQubits(num_qubits);
+
+  // Prepare an entangled state with non-trivial phases.
+  for (std::size_t i = 0; i < num_qubits; i++) {
+    qppBackend.ry(0.3 + 0.4 * i, qubits[i]);
+    qppBackend.rx(1.1 - 0.2 * i, qubits[i]);
+  }
+  qppBackend.x({qubits[0]}, qubits[2]);
+  qppBackend.x({qubits[3]}, qubits[1]);
+
+  auto toMatrix = [](std::vector<std::complex<double>> &&data) -> qpp::cmat {
+    return Eigen::Map<Eigen::Matrix<std::complex<double>, Eigen::Dynamic,
+                                    Eigen::Dynamic, Eigen::RowMajor>>(
+        data.data(), 2, 2);
+  };
+
+  std::vector<std::vector<std::size_t>> controlSets{{}, {1}, {3, 0}};
+  for (auto &controls : controlSets) {
+    const std::size_t target = 2;
+    auto check = [&](auto applyGate, const qpp::cmat &matrix) {
+      qpp::ket before = qppBackend.getStateVector();
+      applyGate();
+      qpp::ket want_state = qpp::applyCTRL(before, matrix, controls, {target});
+      EXPECT_EQ_KETS(want_state, qppBackend.getStateVector(), 1e-12);
+    };
+
+    check([&]() { qppBackend.x(controls, target); }, toMatrix(x<>{}.getGate()));
+    check([&]() { qppBackend.y(controls, target); }, toMatrix(y<>{}.getGate()));
+    check([&]() { qppBackend.z(controls, target); }, toMatrix(z<>{}.getGate()));
+    check([&]() { qppBackend.h(controls, target); }, toMatrix(h<>{}.getGate()));
+    check([&]() { qppBackend.s(controls, target); }, toMatrix(s<>{}.getGate()));
+    check([&]() { qppBackend.t(controls, target); }, toMatrix(t<>{}.getGate()));
+    check([&]() { qppBackend.sdg(controls, target); },
+          toMatrix(sdg<>{}.getGate()));
+    check([&]() { qppBackend.tdg(controls, target); },
+          toMatrix(tdg<>{}.getGate()));
+    check([&]() { qppBackend.rx(0.7, controls, target); },
+          toMatrix(rx<>{}.getGate(0.7)));
+    check([&]() { qppBackend.ry(-1.3, controls, target); },
+          toMatrix(ry<>{}.getGate(-1.3)));
+    check([&]() { qppBackend.rz(2.1, controls, target); },
+          toMatrix(rz<>{}.getGate(2.1)));
+    check([&]() { qppBackend.r1(0.4, controls, target); },
+          toMatrix(r1<>{}.getGate(0.4)));
+
+    const std::size_t partner = controls.size() == 2 ? 1 : 0;
+    qpp::ket before = qppBackend.getStateVector();
+    qppBackend.swap(controls, target, partner);
+    qpp::ket want_state = qpp::applyCTRL(
+        before, qpp::Gates::get_instance().SWAP, controls, {target, partner});
+    EXPECT_EQ_KETS(want_state, qppBackend.getStateVector(), 1e-12);
+  }
+
+  for (auto q : qubits)
+    qppBackend.deallocate(q);
+}
+
+CUDAQ_TEST(QPPTester, checkGateFusion) {
+  const std::size_t num_qubits = 6;
+  auto runCircuit = [&](QppCircuitSimulator<qpp::ket> &backend) {
+    auto qubits = backend.allocateQubits(num_qubits);
+    for (std::size_t layer = 0; layer < 3; layer++) {
+      for (std::size_t i = 0; i < num_qubits; i++) {
+        backend.ry(0.3 + 0.4 * i + layer, qubits[i]);
+        backend.rz(1.1 - 0.2 * i, qubits[i]);
+      }
+      for (std::size_t i = 0; i + 1 < num_qubits; i++)
+        backend.x({qubits[i]}, qubits[i + 1]);
+      backend.h(qubits[layer]);
+      backend.u3(0.5, 0.2, -0.7, {qubits[5]}, qubits[0]);
+      backend.swap({qubits[1]}, qubits[2], qubits[4]);
+      backend.t({qubits[0], qubits[3], qubits[4]}, qubits[1]);
+    }
+    auto state = backend.getStateVector();
+    for (auto q : qubits)
+      backend.deallocate(q);
+    return state;
+  };
+
+  QppCircuitSimulator<qpp::ket> unfused;
+  auto want_state = runCircuit(unfused);
+
+  // Fusion windows both narrower and wider than the individual gates.
+  for (auto width : {"1", "2", "3", "5"}) {
+    setenv("CUDAQ_FUSION_MAX_QUBITS", width, 1);
+    QppCircuitSimulator<qpp::ket> fused;
+    unsetenv("CUDAQ_FUSION_MAX_QUBITS");
+    EXPECT_EQ_KETS(want_state, runCircuit(fused), 1e-12);
+  }
+}
+
+CUDAQ_TEST(QPPTester, checkBulkAllocation) {
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  auto first = qppBackend.allocateQubits(2);
+  EXPECT_EQ_KETS(getZeroState(2), qppBackend.getStateVector());
+
+  qppBackend.ry(0.7, first[0]);
+  qppBackend.x({first[0]}, first[1]);
+  qppBackend.rz(0.3, first[1]);
+  qpp::ket before = qppBackend.getStateVector();
+
+  // Growing an existing state by several qubits at once must match
+  // appending |0> qubits one at a time.
+  auto second = qppBackend.allocateQubits(3);
+  EXPECT_EQ(second.size(), 3);
+  EXPECT_EQ_KETS(qpp::kron(before, getZeroState(3)),
+                 qppBackend.getStateVector(), 1e-12);
+
+  // Gates on the new qubits see them as the trailing subsystems.
+  qppBackend.x(second[2]);
+  EXPECT_EQ_KETS(qpp::kron(before, getZeroState(2), getOneState(1)),
+                 qppBackend.getStateVector(), 1e-12);
+
+  for (auto q : first)
+    qppBackend.deallocate(q);
+  for (auto q : second)
+    qppBackend.deallocate(q);
+}
+
+CUDAQ_TEST(QPPTester, checkConditionalPrefixCache) {
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  cudaq::ExecutionContext ctx("sample", 1);
+  ctx.hasConditionalsOnMeasureResults = true;
+
+  // Every shot prepares a Bell pair before measuring, later shots start from
+  // the cached state. Every fifth shot leaves the prefix early.
+  const std::size_t shots = 400;
+  std::size_t ones = 0;
+  for (std::size_t shot = 0; shot < shots; shot++) {
+    qppBackend.setExecutionContext(&ctx);
+    auto qubits = qppBackend.allocateQubits(3);
+    qppBackend.h(qubits[0]);
+    const bool diverge = shot % 5 == 4;
+    if (diverge)
+      qppBackend.x(qubits[2]);
+    qppBackend.x({qubits[0]}, qubits[1]);
+    qppBackend.ry(M_PI, qubits[2]);
+    auto first = qppBackend.mz(qubits[0]);
+    ones += first;
+    EXPECT_EQ(first, qppBackend.mz(qubits[1]));
+
+    // The conditional gate after the prefix acts on the restored state.
+    if (first)
+      qppBackend.x(qubits[2]);
+    EXPECT_EQ(first == diverge, qppBackend.mz(qubits[2])) << "shot " << shot;
+    for (auto q : qubits)
+      qppBackend.deallocate(q);
+    qppBackend.resetExecutionContext();
+  }
+  EXPECT_NEAR(.5, ones / static_cast<double>(shots), .1);
+}
+
+CUDAQ_TEST(QPPTester, checkSeededSampling) {
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  auto sampleWithSeed = [&](std::optional<std::uint64_t> seed) {
+    cudaq::ExecutionContext ctx("sample", 200);
+    ctx.seed = seed;
+    qppBackend.setExecutionContext(&ctx);
+    auto qubits = qppBackend.allocateQubits(4);
+    for (auto q : qubits)
+      qppBackend.h(q);
+    for (auto q : qubits)
+      qppBackend.deallocate(q);
+    qppBackend.resetExecutionContext();
+    return ctx.result.to_map();
+  };
+  auto first = sampleWithSeed(42);
+  EXPECT_EQ(first, sampleWithSeed(42));
+  EXPECT_NE(first, sampleWithSeed(43));
+}
+
+CUDAQ_TEST(QPPTester, checkKeptDistribution) {
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  cudaq::ExecutionContext ctx("sample", 100);
+  ctx.keepDistribution = true;
+  qppBackend.setExecutionContext(&ctx);
+  auto q0 = qppBackend.allocateQubit();
+  auto q1 = qppBackend.allocateQubit();
+  qppBackend.h(q0);
+  qppBackend.x(q1);
+  qppBackend.mz(q1);
+  qppBackend.mz(q0);
+  qppBackend.deallocate(q0);
+  qppBackend.deallocate(q1);
+  qppBackend.resetExecutionContext();
+
+  // Bit 0 of an outcome is q1, sampled first, bit 1 is q0.
+  std::vector<double> expected{0., .5, 0., .5};
+  ASSERT_EQ(ctx.distribution.size(), expected.size());
+  for (std::size_t i = 0; i < expected.size(); i++)
+    EXPECT_NEAR(ctx.distribution[i], expected[i], 1e-12);
+  for (auto &[bits, count] : ctx.result)
+    EXPECT_EQ(bits[0], '1');
+}
+
+CUDAQ_TEST(QPPTester, checkSinglePrecision) {
+  auto runCircuit = [](auto &sim) {
+    auto qubits = sim.allocateQubits(4);
+    sim.h(qubits[0]);
+    sim.ry(0.3, qubits[1]);
+    sim.x({qubits[0]}, qubits[2]);
+    sim.rz(0.7, {qubits[1]}, qubits[3]);
+    sim.u3(0.2, 0.4, -0.1, {}, qubits[2]);
+    sim.t(qubits[3]);
+    sim.swap(qubits[0], qubits[3]);
+    sim.s({qubits[2]}, qubits[1]);
+    sim.y(qubits[0]);
+    auto [dims, data] = sim.getStateData();
+    for (auto q : qubits)
+      sim.deallocate(q);
+    return data;
+  };
+
+  QppCircuitSimulator<qpp::ket> doublePrecision;
+  QppCircuitSimulator<nvqir::ket32> singlePrecision;
+  auto want = runCircuit(doublePrecision);
+  auto got = runCircuit(singlePrecision);
+  ASSERT_EQ(want.size(), got.size());
+  for (std::size_t i = 0; i < want.size(); i++)
+    EXPECT_NEAR(0., std::abs(want[i] - got[i]), 1e-6);
+
+  // Measurement and sampling of the single precision state.
+  auto qubits = singlePrecision.allocateQubits(2);
+  singlePrecision.h(qubits[0]);
+  singlePrecision.x({qubits[0]}, qubits[1]);
+  auto result = singlePrecision.sample(qubits, 1000);
+  cudaq::sample_result counts(result);
+  EXPECT_EQ(2, counts.size());
+  EXPECT_NEAR(500, counts.count("00"), 100);
+  EXPECT_NEAR(500, counts.count("11"), 100);
+  EXPECT_EQ(singlePrecision.mz(qubits[0]), singlePrecision.mz(qubits[1]));
+  singlePrecision.resetQubit(qubits[0]);
+  EXPECT_FALSE(singlePrecision.mz(qubits[0]));
+  for (auto q : qubits)
+    singlePrecision.deallocate(q);
+}
+
+CUDAQ_TEST(QPPTester, checkNativeObserve) {
+  using cudaq::spin::x, cudaq::spin::y, cudaq::spin::z;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1) + 0.7 * y(2) * x(1) -
+                     1.3 * z(0) * y(1) * y(2) + 0.4 * x(2) * z(1) * x(0);
+
+  auto prepare = [](auto &sim) {
+    auto qubits = sim.allocateQubits(3);
+    sim.x(qubits[0]);
+    sim.ry(.59, qubits[1]);
+    sim.x({qubits[1]}, qubits[0]);
+    sim.h(qubits[2]);
+    sim.rz(0.3, {qubits[0]}, qubits[2]);
+    sim.u3(0.2, 0.4, -0.1, {}, qubits[1]);
+    return qubits;
+  };
+
+  // Reference <psi| H |psi> from the Pauli matrices applied to a copy.
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  auto qubits = prepare(qppBackend);
+  qpp::ket psi = qppBackend.getStateVector();
+  auto &gates = ::qpp::Gates::get_instance();
+  double want = 0.0;
+  for (std::size_t i = 0; i < h.n_terms(); i++) {
+    auto term = h[i];
+    qpp::ket applied = psi;
+    term.for_each_pauli([&](cudaq::pauli p, std::size_t q) {
+      if (p == cudaq::pauli::X)
+        applied = ::qpp::apply(applied, gates.X, {q});
+      else if (p == cudaq::pauli::Y)
+        applied = ::qpp::apply(applied, gates.Y, {q});
+      else if (p == cudaq::pauli::Z)
+        applied = ::qpp::apply(applied, gates.Z, {q});
+    });
+    want += term.get_term_coefficient(0).real() *
+            psi.dot(applied).real();
+  }
+
+  cudaq::ExecutionContext ctx("observe", -1);
+  qppBackend.setExecutionContext(&ctx);
+  EXPECT_TRUE(ctx.canHandleObserve);
+  EXPECT_NEAR(want, qppBackend.observe(h).expectationValue.value(), 1e-12);
+  qppBackend.resetExecutionContext();
+  // Observing does not change the state.
+  EXPECT_EQ_KETS(psi, qppBackend.getStateVector(), 1e-12);
+  for (auto q : qubits)
+    qppBackend.deallocate(q);
+
+  // Sampled observations measure every term.
+  cudaq::ExecutionContext sampledCtx("observe", 100);
+  qppBackend.setExecutionContext(&sampledCtx);
+  EXPECT_FALSE(sampledCtx.canHandleObserve);
+  qppBackend.resetExecutionContext();
+
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  qubits = prepare(densityMatrix);
+  EXPECT_NEAR(want, densityMatrix.observe(h).expectationValue.value(), 1e-12);
+  for (auto q : qubits)
+    densityMatrix.deallocate(q);
+}
+
+CUDAQ_TEST(QPPTester, checkGroupedObserve) {
+  // Every Z pattern under a few X patterns, i.e. few X masks with many terms
+  // each, which take the phase tables, and a lone term with a wide Z mask.
+  const std::size_t n = 6;
+  cudaq::spin_op h = 0.25 * cudaq::spin::i(0);
+  std::size_t t = 0;
+  for (std::size_t xBits : {0b000000, 0b000011, 0b101000})
+    for (std::size_t zBits = 0; zBits < 1ULL << n; zBits++, t++) {
+      if (!xBits && !zBits)
+        continue;
+      cudaq::spin_op term = cudaq::spin::i(0);
+      for (std::size_t q = 0; q < n; q++) {
+        const bool x = xBits >> q & 1, z = zBits >> q & 1;
+        if (x || z)
+          term *= x && z ? cudaq::spin::y(q)
+                  : x    ? cudaq::spin::x(q)
+                         : cudaq::spin::z(q);
+      }
+      h += (0.01 * (t % 13) - 0.05) * term;
+    }
+  h += 0.3 * cudaq::spin::x(1) * cudaq::spin::z(2) * cudaq::spin::y(4) *
+       cudaq::spin::z(5);
+
+  auto prepare = [&](auto &sim) {
+    auto qubits = sim.allocateQubits(n);
+    for (std::size_t q = 0; q < n; q++) {
+      sim.ry(0.3 + 0.2 * q, qubits[q]);
+      sim.rz(0.1 * q, qubits[q]);
+    }
+    for (std::size_t q = 0; q + 1 < n; q++)
+      sim.x({qubits[q]}, qubits[q + 1]);
+    return qubits;
+  };
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  auto qubits = prepare(qppBackend);
+  qpp::ket psi = qppBackend.getStateVector();
+  auto &gates = ::qpp::Gates::get_instance();
+  double want = 0.0;
+  for (std::size_t i = 0; i < h.n_terms(); i++) {
+    auto term = h[i];
+    qpp::ket applied = psi;
+    term.for_each_pauli([&](cudaq::pauli p, std::size_t q) {
+      if (p == cudaq::pauli::X)
+        applied = ::qpp::apply(applied, gates.X, {q});
+      else if (p == cudaq::pauli::Y)
+        applied = ::qpp::apply(applied, gates.Y, {q});
+      else if (p == cudaq::pauli::Z)
+        applied = ::qpp::apply(applied, gates.Z, {q});
+    });
+    want += term.get_term_coefficient(0).real() * psi.dot(applied).real();
+  }
+  EXPECT_NEAR(want, qppBackend.observe(h).expectationValue.value(), 1e-12);
+  for (auto q : qubits)
+    qppBackend.deallocate(q);
+
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  qubits = prepare(densityMatrix);
+  EXPECT_NEAR(want, densityMatrix.observe(h).expectationValue.value(), 1e-12);
+  for (auto q : qubits)
+    densityMatrix.deallocate(q);
+}
+
+CUDAQ_TEST(QPPTester, checkDeallocateShrinksState) {
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  auto qubits = qppBackend.allocateQubits(2);
+  qppBackend.ry(0.7, qubits[0]);
+  qppBackend.x({qubits[0]}, qubits[1]);
+  qpp::ket before = qppBackend.getStateVector();
+
+  // Ancillas allocated in a loop are traced out again at deallocation.
+  qpp::ket expected = before;
+  for (int i = 0; i < 3; i++) {
+    auto ancilla = qppBackend.allocateQubit();
+    EXPECT_EQ(qppBackend.getStateVector().size(), 8);
+    qppBackend.x({qubits[1]}, ancilla);
+    qppBackend.z(ancilla);
+    qppBackend.x({qubits[1]}, ancilla);
+    qppBackend.deallocate(ancilla);
+    expected = ::qpp::apply(expected, ::qpp::Gates::get_instance().Z, {1});
+    EXPECT_EQ_KETS(expected, qppBackend.getStateVector(), 1e-12);
+  }
+
+  // Deallocated qubits in the middle stay until the ones above them are
+  // deallocated, and reusing them does not grow the state.
+  auto more = qppBackend.allocateQubits(2);
+  qppBackend.deallocate(more[0]);
+  EXPECT_EQ(qppBackend.getStateVector().size(), 16);
+  auto reused = qppBackend.allocateQubit();
+  EXPECT_EQ(reused, more[0]);
+  EXPECT_EQ(qppBackend.getStateVector().size(), 16);
+  qppBackend.deallocate(reused);
+  qppBackend.deallocate(more[1]);
+  EXPECT_EQ_KETS(expected, qppBackend.getStateVector(), 1e-12);
+
+  for (auto q : qubits)
+    qppBackend.deallocate(q);
+}
+
+CUDAQ_TEST(QPPTester, checkExtractStateWithoutCopy) {
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  cudaq::ExecutionContext context("extract-state");
+  qppBackend.setExecutionContext(&context);
+  auto qubits = qppBackend.allocateQubits(2);
+  qppBackend.h(qubits[0]);
+  qppBackend.x({qubits[0]}, qubits[1]);
+
+  // A view references the state of the simulator.
+  const std::complex<double> *data =
+      qppBackend.getSimulationState()->getHostData();
+  ASSERT_NE(data, nullptr);
+  EXPECT_NEAR(data[3].real(), M_SQRT1_2, 1e-12);
+
+  // At the end of the execution the context takes over the same memory.
+  for (auto q : qubits)
+    qppBackend.deallocate(q);
+  qppBackend.resetExecutionContext();
+  ASSERT_TRUE(context.simulationState);
+  EXPECT_EQ(context.simulationState->getHostData(), data);
+  EXPECT_EQ(context.simulationState->getShape(), std::vector<std::size_t>{4});
+  EXPECT_NEAR(context.simulationState->getElement(0).real(), M_SQRT1_2, 1e-12);
+  EXPECT_NEAR(std::abs(context.simulationState->getElement(1)), 0., 1e-12);
+
+  // The simulator starts over from a new state.
+  auto qubit = qppBackend.allocateQubit();
+  EXPECT_EQ_KETS(getZeroState(1), qppBackend.getStateVector(), 1e-12);
+  qppBackend.deallocate(qubit);
+}
+
+CUDAQ_TEST(QPPTester, checkReplayCapturedCircuit) {
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  auto execute = [&](const std::vector<double> &angles) {
+    auto qubits = qppBackend.allocateQubits(3);
+    qppBackend.h(qubits[0]);
+    qppBackend.rx(angles[0], {qubits[0]}, qubits[1]);
+    qppBackend.ry(angles[1], qubits[2]);
+    qppBackend.u3(angles[2], angles[3], angles[4], {qubits[1]}, qubits[2]);
+    qppBackend.swap(qubits[0], qubits[2]);
+    for (auto q : qubits)
+      qppBackend.deallocate(q);
+  };
+  auto getState = [&](auto &&kernel) {
+    cudaq::ExecutionContext context("extract-state");
+    qppBackend.setExecutionContext(&context);
+    kernel();
+    qppBackend.resetExecutionContext();
+    return std::get<1>(context.simulationState->toState());
+  };
+
+  nvqir::CapturedCircuit circuit;
+  const std::vector<double> angles{0.1, 0.2, 0.3, 0.4, 0.5};
+  auto captured = getState([&]() {
+    qppBackend.beginCapture();
+    execute(angles);
+    circuit = qppBackend.endCapture();
+  });
+  ASSERT_TRUE(circuit.replayable);
+  EXPECT_EQ(circuit.instructions.size(), 5);
+  EXPECT_EQ(circuit.parameters, angles);
+  EXPECT_EQ(circuit.nQubits, 3);
+
+  // Replaying with the captured or new angles matches executing the gates.
+  auto replayed = getState([&]() { qppBackend.replay(circuit); });
+  const std::vector<double> newAngles{0.7, -0.3, 1.1, 0.2, -0.9};
+  auto replayedNew = getState([&]() { qppBackend.replay(circuit, newAngles); });
+  auto expectedNew = getState([&]() { execute(newAngles); });
+  ASSERT_EQ(replayed.size(), captured.size());
+  ASSERT_EQ(replayedNew.size(), expectedNew.size());
+  for (std::size_t i = 0; i < captured.size(); i++) {
+    EXPECT_NEAR(std::abs(replayed[i] - captured[i]), 0., 1e-12);
+    EXPECT_NEAR(std::abs(replayedNew[i] - expectedNew[i]), 0., 1e-12);
+  }
+  EXPECT_ANY_THROW(qppBackend.replay(circuit, {0.1}));
+
+  // A mid-circuit measurement makes the captured circuit not replayable.
+  getState([&]() {
+    qppBackend.beginCapture();
+    auto q = qppBackend.allocateQubit();
+    qppBackend.h(q);
+    qppBackend.mz(q);
+    qppBackend.deallocate(q);
+    circuit = qppBackend.endCapture();
+  });
+  EXPECT_FALSE(circuit.replayable);
+  EXPECT_ANY_THROW(qppBackend.replay(circuit));
+}
+
+CUDAQ_TEST(QPPTester, checkAdjointGradient) {
+  using cudaq::spin::x, cudaq::spin::y, cudaq::spin::z;
+  cudaq::spin_op h = 0.5 * z(0) * z(1) - 1.2 * x(1) + 0.8 * y(0) * x(2) +
+                     0.3 * z(2) + 0.1;
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  auto execute = [&](const std::vector<double> &angles) {
+    auto qubits = qppBackend.allocateQubits(3);
+    qppBackend.h(qubits[0]);
+    qppBackend.rx(angles[0], qubits[1]);
+    qppBackend.ry(angles[1], {qubits[0]}, qubits[2]);
+    qppBackend.s(qubits[1]);
+    qppBackend.rz(angles[2], qubits[0]);
+    qppBackend.r1(angles[3], {qubits[2]}, qubits[1]);
+    qppBackend.swap(qubits[0], qubits[1]);
+    qppBackend.ry(angles[4], qubits[2]);
+    qppBackend.t(qubits[2]);
+    qppBackend.x({qubits[2]}, qubits[0]);
+    for (auto q : qubits)
+      qppBackend.deallocate(q);
+  };
+  auto observe = [&](const std::vector<double> &angles) {
+    cudaq::ExecutionContext context("observe");
+    context.spin = &h;
+    qppBackend.setExecutionContext(&context);
+    execute(angles);
+    auto result = qppBackend.observe(h);
+    qppBackend.resetExecutionContext();
+    return result.expectationValue.value();
+  };
+
+  const std::vector<double> angles{0.3, -1.1, 0.7, 0.4, 2.1};
+  cudaq::ExecutionContext context("adjoint-gradient");
+  context.spin = &h;
+  qppBackend.setExecutionContext(&context);
+  execute(angles);
+  qppBackend.resetExecutionContext();
+  EXPECT_EQ(context.gateParameters, angles);
+  ASSERT_TRUE(context.expectationValue.has_value());
+  EXPECT_NEAR(*context.expectationValue, observe(angles), 1e-12);
+
+  // Every derivative matches central differences of the expectation value.
+  ASSERT_EQ(context.gateParameterGradient.size(), angles.size());
+  const double step = 1e-5;
+  for (std::size_t i = 0; i < angles.size(); i++) {
+    auto plus = angles, minus = angles;
+    plus[i] += step;
+    minus[i] -= step;
+    EXPECT_NEAR(context.gateParameterGradient[i],
+                (observe(plus) - observe(minus)) / (2 * step), 1e-7);
+  }
+
+  // Recording the gates does not simulate them.
+  cudaq::ExecutionContext record("record-gates");
+  qppBackend.setExecutionContext(&record);
+  execute(angles);
+  qppBackend.resetExecutionContext();
+  EXPECT_EQ(record.gateParameters, angles);
+
+  // A measurement leaves the gradient unset.
+  cudaq::ExecutionContext measured("adjoint-gradient");
+  measured.spin = &h;
+  qppBackend.setExecutionContext(&measured);
+  auto q = qppBackend.allocateQubit();
+  qppBackend.rx(0.5, q);
+  qppBackend.mz(q);
+  qppBackend.deallocate(q);
+  qppBackend.resetExecutionContext();
+  EXPECT_FALSE(measured.expectationValue.has_value());
+}
+
+CUDAQ_TEST(QPPTester, checkPauliRotations) {
+  using cudaq::spin::x, cudaq::spin::y, cudaq::spin::z;
+  cudaq::spin_op h = 1.5 - 0.7 * x(0) * x(1) + 0.3 * y(0) * z(2) +
+                     1.1 * z(1) - 0.4 * x(0) * x(1) + 0.9 * y(1) * y(2);
+
+  // Merged, identity-free factors, the Z-only one first and the others
+  // ordered by Pauli word.
+  auto rotations = trotterize(h, 0.8, 1, 1);
+  ASSERT_EQ(rotations.size(), 4);
+  EXPECT_NEAR(rotations[0].angle, 1.1 * 0.8, 1e-12);
+  EXPECT_NEAR(rotations[2].angle, -1.1 * 0.8, 1e-12);
+  for (std::size_t i = 2; i < rotations.size(); i++)
+    EXPECT_TRUE(rotations[i - 1].paulis < rotations[i].paulis);
+  // Consecutive second order steps share their end factors.
+  EXPECT_EQ(trotterize(h, 0.8, 2, 3).size(), 3 * (2 * 4 - 2) + 1);
+  EXPECT_ANY_THROW(trotterize(h, 0.8, 3, 1));
+  EXPECT_ANY_THROW(trotterize(h, 0.8, 1, 0));
+
+  // The state vector rotates natively, the density matrix through the
+  // decomposed (and cancelled) gates, and both agree.
+  rotations = trotterize(h, 0.8, 4, 2);
+  auto prepare = [](auto &sim) {
+    auto qubits = sim.allocateQubits(3);
+    sim.ry(.59, qubits[0]);
+    sim.h(qubits[2]);
+    sim.x({qubits[0]}, qubits[1]);
+    return qubits;
+  };
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  auto qubits = prepare(qppBackend);
+  applyPauliRotations(qppBackend, rotations, qubits);
+  qpp::ket psi = qppBackend.getStateVector();
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  prepare(densityMatrix);
+  applyPauliRotations(densityMatrix, rotations, qubits);
+  qpp::cmat rho = densityMatrix.getStateVector();
+  EXPECT_NEAR((rho - psi * psi.adjoint()).norm(), 0., 1e-12);
+
+  // A single factor is exactly exp(-i angle / 2 P), here on |00> with
+  // P = Y0 Y1, i.e. cos(angle / 2) |00> + i sin(angle / 2) |11>.
+  QppCircuitSimulator<qpp::ket> single;
+  auto pair = single.allocateQubits(2);
+  applyPauliRotations(single, trotterize(y(0) * y(1), 0.6, 1, 1), pair);
+  qpp::ket want = qpp::ket::Zero(4);
+  want(0) = std::cos(0.3);
+  want(3) = std::complex<double>(0, std::sin(0.3));
+  EXPECT_EQ_KETS(want, single.getStateVector(), 1e-12);
+}
+
+CUDAQ_TEST(QPPTester, checkDiagonalPhases) {
+  using cudaq::spin::x, cudaq::spin::z;
+  // A QAOA step on a weighted ring: the cost layer is one diagonal sweep.
+  const std::size_t n = 5;
+  cudaq::spin_op cost = 0.5 * z(0) * z(1);
+  for (std::size_t i = 1; i < n; i++)
+    cost += (0.3 + 0.2 * i) * z(i) * z((i + 1) % n);
+  cost += 0.7 * z(2);
+  cudaq::spin_op mixer = x(0);
+  for (std::size_t i = 1; i < n; i++)
+    mixer += x(i);
+  auto rotations = trotterize(cost, 0.9, 1, 1);
+  auto mixing = trotterize(mixer, 0.4, 1, 1);
+  rotations.insert(rotations.end(), mixing.begin(), mixing.end());
+
+  // Both the state vector and the density matrix apply the cost terms as one
+  // layer, the reference applies them one rotation at a time.
+  auto prepare = [&](auto &sim) {
+    auto qubits = sim.allocateQubits(n);
+    for (auto q : qubits)
+      sim.h(q);
+    sim.ry(0.3, qubits[1]);
+    return qubits;
+  };
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  auto qubits = prepare(qppBackend);
+  applyPauliRotations(qppBackend, rotations, qubits);
+  qpp::ket psi = qppBackend.getStateVector();
+
+  QppCircuitSimulator<qpp::ket> reference;
+  prepare(reference);
+  for (auto &rotation : rotations) {
+    std::vector<std::size_t> support;
+    std::vector<cudaq::pauli> paulis;
+    for (std::size_t j = 0; j < rotation.paulis.size(); j++)
+      if (rotation.paulis[j] != cudaq::pauli::I) {
+        support.push_back(qubits[j]);
+        paulis.push_back(rotation.paulis[j]);
+      }
+    reference.applyPauliRotation(rotation.angle, support, paulis);
+  }
+  EXPECT_EQ_KETS(reference.getStateVector(), psi, 1e-12);
+
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  prepare(densityMatrix);
+  applyPauliRotations(densityMatrix, rotations, qubits);
+  qpp::cmat rho = densityMatrix.getStateVector();
+  EXPECT_NEAR((rho - psi * psi.adjoint()).norm(), 0., 1e-12);
+}
+
+CUDAQ_TEST(QPPTester, checkStateMemoryPreflight) {
+  QppCircuitSimulator<qpp::ket> stateVector;
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  EXPECT_EQ(stateVector.getRequiredStateBytes(34), 16ULL << 34);
+  EXPECT_EQ(densityMatrix.getRequiredStateBytes(17), 16ULL << 34);
+  EXPECT_EQ(stateVector.getRequiredStateBytes(64),
+            std::numeric_limits<std::size_t>::max());
+
+  // A state larger than the available memory is refused before allocation,
+  // small states are not checked.
+  setenv("CUDAQ_MEMORY_LIMIT", "1048576", 1);
+  EXPECT_THROW(stateVector.checkStateFits(34), std::runtime_error);
+  EXPECT_NO_THROW(stateVector.checkStateFits(10));
+  unsetenv("CUDAQ_MEMORY_LIMIT");
+  EXPECT_GT(stateVector.getAvailableMemory(), 0);
+}
+
+CUDAQ_TEST(QPPTester, checkInPlaceMeasureAndReset) {
+  auto prepare = [](auto &sim) {
+    auto qubits = sim.allocateQubits(3);
+    sim.ry(.73, qubits[0]);
+    sim.h(qubits[2]);
+    sim.x({qubits[0]}, qubits[1]);
+    sim.rx(.41, qubits[1]);
+    return qubits;
+  };
+
+  // The in-place collapse agrees with qpp::measure.
+  for (std::size_t qubit = 0; qubit < 3; qubit++) {
+    QppCircuitSimulator<qpp::ket> qppBackend;
+    prepare(qppBackend);
+    qpp::ket psi = qppBackend.getStateVector();
+    const auto result = qppBackend.measureQubit(qubit);
+    auto [_, probabilities, states] =
+        qpp::measure(psi, qpp::cmat::Identity(2, 2), {qubit}, 2, false);
+    EXPECT_GT(probabilities[result], 0.);
+    EXPECT_EQ_KETS(states[result], qppBackend.getStateVector(), 1e-12);
+
+    QppCircuitSimulator<qpp::cmat> densityMatrix;
+    prepare(densityMatrix);
+    qpp::cmat rho = densityMatrix.getStateVector();
+    const auto rhoResult = densityMatrix.measureQubit(qubit);
+    auto [__, rhoProbabilities, rhoStates] =
+        qpp::measure(rho, qpp::cmat::Identity(2, 2), {qubit}, 2, false);
+    EXPECT_GT(rhoProbabilities[rhoResult], 0.);
+    EXPECT_NEAR((rhoStates[rhoResult] - densityMatrix.getStateVector()).norm(),
+                0., 1e-12);
+
+    // A reset collapses the qubit, then flips it back to |0> if needed.
+    QppCircuitSimulator<qpp::cmat> reset;
+    prepare(reset);
+    reset.resetQubit(qubit);
+    qpp::cmat flipped =
+        qpp::apply(rhoStates[1], qpp::Gates::get_instance().X, {qubit});
+    qpp::cmat rhoReset = reset.getStateVector();
+    EXPECT_NEAR(std::min((rhoStates[0] - rhoReset).norm(),
+                         (flipped - rhoReset).norm()),
+                0., 1e-12);
+  }
+}
+
+CUDAQ_TEST(QPPTester, checkParityExpectation) {
+  auto prepare = [](auto &sim) {
+    auto qubits = sim.allocateQubits(3);
+    sim.ry(.52, qubits[0]);
+    sim.x(qubits[2]);
+    return qubits;
+  };
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  prepare(qppBackend);
+  prepare(densityMatrix);
+  for (auto *sim : std::vector<nvqir::CircuitSimulator *>{&qppBackend,
+                                                           &densityMatrix}) {
+    EXPECT_NEAR(sim->sample({0}, 0).expectationValue.value(), std::cos(.52),
+                1e-12);
+    EXPECT_NEAR(sim->sample({0, 2}, 0).expectationValue.value(),
+                -std::cos(.52), 1e-12);
+    EXPECT_NEAR(sim->sample({1, 2}, 0).expectationValue.value(), -1., 1e-12);
+  }
+}
+
+CUDAQ_TEST(QPPTester, checkOverlap) {
+  auto prepare = [](nvqir::CircuitSimulator &sim, double angle,
+                    std::size_t nQubits) {
+    auto qubits = sim.allocateQubits(nQubits);
+    sim.ry(angle, qubits[0]);
+    sim.x({qubits[0]}, qubits[1]);
+    for (auto q : qubits)
+      sim.deallocate(q);
+  };
+  auto overlap = [&](nvqir::CircuitSimulator &sim, double angleA,
+                     double angleB, std::size_t nQubitsB = 2) {
+    cudaq::ExecutionContext context("overlap");
+    sim.setExecutionContext(&context);
+    prepare(sim, angleA, 2);
+    sim.resetExecutionContext();
+    sim.setExecutionContext(&context);
+    prepare(sim, angleB, nQubitsB);
+    sim.resetExecutionContext();
+    return context.overlap;
+  };
+
+  // <a|b> = cos((a - b) / 2), and |<a|b>|^2 for density matrices.
+  struct HostOverlap : QppCircuitSimulator<qpp::ket> {
+    bool canComputeOverlap() override { return false; }
+  };
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  HostOverlap hostBackend;
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  const double expected = std::cos((.9 - .3) / 2);
+  for (auto *sim : std::vector<nvqir::CircuitSimulator *>{&qppBackend,
+                                                           &hostBackend}) {
+    auto result = overlap(*sim, .9, .3);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_NEAR(std::abs(*result - expected), 0., 1e-12);
+    EXPECT_FALSE(overlap(*sim, .9, .3, 3).has_value());
+  }
+  auto result = overlap(densityMatrix, .9, .3);
+  ASSERT_TRUE(result.has_value());
+  EXPECT_NEAR(std::abs(*result - expected * expected), 0., 1e-12);
+}
+
+CUDAQ_TEST(QPPTester, checkStateQueries) {
+  // ry(a) |0> on qubit 0, then a CNOT onto qubit 2: cos(a / 2) |000> +
+  // sin(a / 2) |101>.
+  auto query = [](nvqir::CircuitSimulator &sim,
+                  cudaq::ExecutionContext &context) {
+    sim.setExecutionContext(&context);
+    auto qubits = sim.allocateQubits(3);
+    sim.ry(.8, qubits[0]);
+    sim.x({qubits[0]}, qubits[2]);
+    for (auto q : qubits)
+      sim.deallocate(q);
+    sim.resetExecutionContext();
+  };
+
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  cudaq::ExecutionContext amplitudes("amplitudes");
+  amplitudes.amplitudeIndices = {0, 5, 3};
+  query(qppBackend, amplitudes);
+  ASSERT_EQ(amplitudes.amplitudes.size(), 3);
+  EXPECT_NEAR(std::abs(amplitudes.amplitudes[0] - std::cos(.4)), 0., 1e-12);
+  EXPECT_NEAR(std::abs(amplitudes.amplitudes[1] - std::sin(.4)), 0., 1e-12);
+  EXPECT_NEAR(std::abs(amplitudes.amplitudes[2]), 0., 1e-12);
+  amplitudes.amplitudeIndices = {8};
+  amplitudes.amplitudes.clear();
+  query(qppBackend, amplitudes);
+  EXPECT_TRUE(amplitudes.amplitudes.empty());
+
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  for (auto *sim : std::vector<nvqir::CircuitSimulator *>{&qppBackend,
+                                                           &densityMatrix}) {
+    cudaq::ExecutionContext probabilities("probabilities");
+    probabilities.probabilityQubits = {2, 1};
+    query(*sim, probabilities);
+    const double p = std::pow(std::sin(.4), 2);
+    ASSERT_EQ(probabilities.probabilities.size(), 4);
+    EXPECT_NEAR(probabilities.probabilities[0], 1. - p, 1e-12);
+    EXPECT_NEAR(probabilities.probabilities[1], p, 1e-12);
+    EXPECT_NEAR(probabilities.probabilities[2], 0., 1e-12);
+    EXPECT_NEAR(probabilities.probabilities[3], 0., 1e-12);
+
+    // Repeated qubits are not answered.
+    probabilities.probabilityQubits = {0, 0};
+    probabilities.probabilities.clear();
+    query(*sim, probabilities);
+    EXPECT_TRUE(probabilities.probabilities.empty());
+  }
+}
+
+CUDAQ_TEST(QPPTester, checkStateCheckpoint) {
+  const auto dir = std::filesystem::temp_directory_path();
+  const std::string dense = dir / "cudaq_checkpoint_dense.bin";
+  const std::string sparse = dir / "cudaq_checkpoint_sparse.bin";
+
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  auto qubits = qppBackend.allocateQubits(3);
+  qppBackend.ry(.8, qubits[0]);
+  qppBackend.x({qubits[0]}, qubits[2]);
+  const qpp::ket expected = qppBackend.getStateVector();
+  qppBackend.checkpoint(dense);
+  qppBackend.checkpoint(sparse, /*compress=*/true);
+  EXPECT_LT(std::filesystem::file_size(sparse),
+            std::filesystem::file_size(dense));
+
+  // Restore in place, after the state changed.
+  qppBackend.h(qubits[1]);
+  qppBackend.restore(dense);
+  EXPECT_EQ_KETS(expected, qppBackend.getStateVector(), 1e-12);
+  for (auto q : qubits)
+    qppBackend.deallocate(q);
+
+  // Restore into simulators without qubits, which allocate them.
+  for (auto &path : {dense, sparse}) {
+    QppCircuitSimulator<qpp::ket> restored;
+    restored.restore(path);
+    EXPECT_EQ_KETS(expected, restored.getStateVector(), 1e-12);
+    restored.x({0}, 2);
+    EXPECT_NEAR(std::abs(restored.getStateVector()(0) - std::cos(.4)), 0.,
+                1e-12);
+    for (std::size_t q = 0; q < 3; q++)
+      restored.deallocate(q);
+  }
+
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  auto dmQubits = densityMatrix.allocateQubits(2);
+  densityMatrix.h(dmQubits[0]);
+  const qpp::cmat expectedDensity = densityMatrix.getStateVector();
+  densityMatrix.checkpoint(dense);
+  QppCircuitSimulator<qpp::cmat> restoredDensity;
+  restoredDensity.restore(dense);
+  EXPECT_TRUE(expectedDensity.isApprox(restoredDensity.getStateVector()));
+
+  // A density matrix does not restore into a state vector simulator.
+  QppCircuitSimulator<qpp::ket> mismatch;
+  EXPECT_THROW(mismatch.restore(dense), std::runtime_error);
+  EXPECT_EQ(mismatch.allocateQubit(), 0);
+  EXPECT_THROW(mismatch.restore(dir / "cudaq_no_checkpoint.bin"),
+               std::runtime_error);
+  std::filesystem::remove(dense);
+  std::filesystem::remove(sparse);
+}
+
+CUDAQ_TEST(QPPTester, checkRegisterMeasurement) {
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  qppBackend.seedRandomEngines(13);
+  auto qubits = qppBackend.allocateQubits(3);
+  qppBackend.h(qubits[0]);
+  qppBackend.x({qubits[0]}, qubits[1]);
+  qppBackend.x({qubits[0]}, qubits[2]);
+
+  // The GHZ state collapses to |000> or |111>.
+  auto bits = qppBackend.mz(qubits, "");
+  ASSERT_EQ(bits.size(), 3);
+  EXPECT_EQ(bits[0], bits[1]);
+  EXPECT_EQ(bits[0], bits[2]);
+  EXPECT_EQ(qppBackend.mz(std::vector<std::size_t>{qubits[2], qubits[0]}, ""),
+            (std::vector<bool>{bits[2], bits[0]}));
+  for (auto q : qubits)
+    qppBackend.deallocate(q);
+}
+
+CUDAQ_TEST(QPPTester, checkJointMeasurement) {
+  QppCircuitSimulator<qpp::ket> qppBackend;
+  qppBackend.seedRandomEngines(7);
+  int ones = 0;
+  for (int shot = 0; shot < 200; shot++) {
+    auto qubits = qppBackend.allocateQubits(3);
+    qppBackend.h(qubits[0]);
+    qppBackend.x({qubits[0]}, qubits[1]);
+    qppBackend.h(qubits[2]);
+
+    // The Bell pair collapses to |00> or |11>, the third qubit is left in
+    // |+> and the state normalized.
+    auto bits = qppBackend.mz({qubits[0], qubits[1]}, "");
+    ASSERT_EQ(bits.size(), 2);
+    EXPECT_EQ(bits[0], bits[1]);
+    ones += bits[0];
+    qpp::ket expected = qpp::ket::Zero(8);
+    expected(bits[0] ? 6 : 0) = expected(bits[0] ? 7 : 1) = M_SQRT1_2;
+    EXPECT_EQ_KETS(expected, qppBackend.getStateVector(), 1e-12);
+    for (auto q : qubits)
+      qppBackend.deallocate(q);
+  }
+  EXPECT_NEAR(ones / 200., .5, .15);
+
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  auto dmQubits = densityMatrix.allocateQubits(3);
+  densityMatrix.x(dmQubits[1]);
+  EXPECT_EQ(densityMatrix.mz(dmQubits, ""),
+            (std::vector<bool>{false, true, false}));
+  const qpp::cmat state = densityMatrix.getStateVector();
+  EXPECT_NEAR(std::abs(state(2, 2) - 1.), 0., 1e-12);
+  for (auto q : dmQubits)
+    densityMatrix.deallocate(q);
+}
+
+CUDAQ_TEST(QPPTester, checkQubitPermutation) {
+  // An entangled state without symmetries, with qubit i of the circuit on
+  // qubit label[i].
+  auto prepare = [](nvqir::CircuitSimulator &sim,
+                    const std::vector<std::size_t> &label) {
+    for (std::size_t i = 0; i < label.size(); i++)
+      sim.ry(.3 + .4 * i, label[i]);
+    sim.x({label[0]}, label[1]);
+    sim.rx(.7, label[2]);
+    sim.x({label[3]}, label[0]);
+    sim.x({label[1], label[2]}, label[3]);
+    sim.t(label[1]);
+  };
+  const std::vector<std::size_t> identity{0, 1, 2, 3};
+  const std::vector<std::size_t> permutation{2, 0, 3, 1};
+
+  QppCircuitSimulator<qpp::ket> permuted, expected, swapped;
+  permuted.allocateQubits(4);
+  expected.allocateQubits(4);
+  swapped.allocateQubits(4);
+  prepare(permuted, identity);
+  permuted.permuteQubits(identity, permutation);
+  prepare(expected, permutation);
+  EXPECT_EQ_KETS(expected.getStateVector(), permuted.getStateVector(), 1e-12);
+
+  // The swap layers realize the same permutation.
+  prepare(swapped, identity);
+  auto layers = nvqir::CircuitSimulator::getSwapLayers(identity, permutation);
+  EXPECT_LE(layers.size(), 2);
+  for (auto &layer : layers)
+    for (auto [a, b] : layer)
+      swapped.swap(a, b);
+  EXPECT_EQ_KETS(expected.getStateVector(), swapped.getStateVector(), 1e-12);
+
+  // Permuting a subset of the qubits, which leaves the others in place.
+  permuted.permuteQubits({3, 1}, {1, 0});
+  expected.swap(1, 3);
+  EXPECT_EQ_KETS(expected.getStateVector(), permuted.getStateVector(), 1e-12);
+  EXPECT_ANY_THROW(permuted.permuteQubits({0, 1}, {1, 1}));
+
+  // The density matrix is permuted on its rows and columns, and a controlled
+  // swap acts on it as on the state vector.
+  expected.swap({0}, 2, 3);
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  densityMatrix.allocateQubits(4);
+  prepare(densityMatrix, identity);
+  densityMatrix.permuteQubits(identity, permutation);
+  densityMatrix.permuteQubits({3, 1}, {1, 0});
+  densityMatrix.swap({0}, 2, 3);
+  const qpp::ket psi = expected.getStateVector();
+  const qpp::cmat rho = densityMatrix.getStateVector();
+  EXPECT_NEAR((rho - psi * psi.adjoint()).norm(), 0., 1e-12);
+}
+
+CUDAQ_TEST(QPPTester, checkProductStatePreparation) {
+  // All the qubits in |+>, as a layer of Hadamards.
+  const double s = M_SQRT1_2;
+  QppCircuitSimulator<qpp::ket> prepared, expected;
+  prepared.allocateQubits(5);
+  expected.allocateQubits(5);
+  prepared.prepareProductState({s, s}, {0, 1, 2, 3, 4});
+  for (std::size_t q = 0; q < 5; q++)
+    expected.h(q);
+  EXPECT_EQ_KETS(expected.getStateVector(), prepared.getStateVector(), 1e-12);
+
+  // Fresh qubits of an entangled state, in |1> and in a state with a phase.
+  auto entangle = [](nvqir::CircuitSimulator &sim) {
+    sim.ry(.3, 0);
+    sim.rx(.8, 2);
+    sim.x({0}, 2);
+    sim.t(0);
+  };
+  const std::complex<double> zero = .6, one(0., .8);
+  auto [theta, phi] = nvqir::CircuitSimulator::getProductStateAngles(
+      {zero, one});
+  QppCircuitSimulator<qpp::ket> partial, partialExpected;
+  partial.allocateQubits(5);
+  partialExpected.allocateQubits(5);
+  entangle(partial);
+  entangle(partialExpected);
+  partial.prepareProductState({0., 1.}, {4});
+  partial.prepareProductState({zero, one}, {1, 3});
+  partialExpected.x(4);
+  for (std::size_t q : {1, 3}) {
+    partialExpected.ry(theta, q);
+    partialExpected.r1(phi, q);
+  }
+  EXPECT_EQ_KETS(partialExpected.getStateVector(), partial.getStateVector(),
+                 1e-12);
+
+  // The density matrix applies the gates.
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  densityMatrix.allocateQubits(5);
+  entangle(densityMatrix);
+  densityMatrix.prepareProductState({0., 1.}, {4});
+  densityMatrix.prepareProductState({zero, one}, {1, 3});
+  const qpp::ket psi = partialExpected.getStateVector();
+  const qpp::cmat rho = densityMatrix.getStateVector();
+  EXPECT_NEAR((rho - psi * psi.adjoint()).norm(), 0., 1e-12);
+}
+
+CUDAQ_TEST(QPPTester, checkStateInitialization) {
+  // Bit j of the amplitude index is the value of the j-th target, Q++
+  // indexes the amplitudes big endian.
+  const std::vector<std::complex<double>> amplitudes = {
+      {.1, .2}, {-.3, 0.}, {0., 0.}, {.4, -.1},
+      {.2, .2}, {0., .5},  {-.1, .3}, {.5, .1}};
+  double norm = 0.;
+  for (auto a : amplitudes)
+    norm += std::norm(a);
+  std::vector<std::complex<double>> normalized;
+  for (auto a : amplitudes)
+    normalized.push_back(a / std::sqrt(norm));
+
+  QppCircuitSimulator<qpp::ket> initialized;
+  initialized.allocateQubits(3);
+  initialized.initializeState({0, 1, 2}, normalized.data());
+  qpp::ket expected = qpp::ket::Zero(8);
+  for (std::size_t k = 0; k < 8; k++)
+    expected((k & 1) << 2 | (k & 2) | (k & 4) >> 2) = normalized[k];
+  EXPECT_EQ_KETS(expected, initialized.getStateVector(), 1e-12);
+
+  // Fresh qubits of an entangled state, written directly by the state vector
+  // and prepared by the synthesized circuit on the density matrix.
+  auto entangle = [](nvqir::CircuitSimulator &sim) {
+    sim.ry(.3, 0);
+    sim.rx(.8, 2);
+    sim.x({0}, 2);
+    sim.t(0);
+  };
+  QppCircuitSimulator<qpp::ket> partial;
+  QppCircuitSimulator<qpp::cmat> densityMatrix;
+  partial.allocateQubits(6);
+  densityMatrix.allocateQubits(6);
+  entangle(partial);
+  entangle(densityMatrix);
+  partial.initializeState({4, 1, 3}, normalized.data());
+  densityMatrix.initializeState({4, 1, 3}, normalized.data());
+  const qpp::ket psi = partial.getStateVector();
+  const qpp::cmat rho = densityMatrix.getStateVector();
+  EXPECT_NEAR((rho - psi * psi.adjoint()).norm(), 0., 1e-12);
+  QppCircuitSimulator<qpp::cmat> synthesized;
+  synthesized.allocateQubits(3);
+  synthesized.initializeState({0, 1, 2}, normalized.data());
+  const qpp::cmat expectedRho = expected * expected.adjoint();
+  EXPECT_NEAR((synthesized.getStateVector() - expectedRho).norm(), 0., 1e-12);
+
+  std::vector<std::complex<double>> unnormalized(8, 1.);
+  EXPECT_ANY_THROW(
+      initialized.initializeState({0, 1, 2}, unnormalized.data()));
+}
@@ -0,0 +1,165 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#pragma once
+
+#include "Gates.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+/// Reference dense state vector the backend testers check the simulators
+/// against. Qubit i is bit i of the index, or bit (n - 1 - i) for the
+/// backends ordering their state the other way.
+struct ReferenceState {
+  std::size_t nQubits;
+  bool reversed;
+  std::vector<std::complex<double>> data;
+  ReferenceState(std::size_t n, bool reversedOrder = false)
+      : nQubits(n), reversed(reversedOrder), data(1ULL << n) {
+    data[0] = 1.;
+  }
+
+  /// Return the bit of the qubit in the index.
+  std::size_t mask(std::size_t qubit) const {
+    return 1ULL << (reversed ? nQubits - 1 - qubit : qubit);
+  }
+
+  /// Return the bits of the qubits in the index.
+  std::size_t mask(const std::vector<std::size_t> &qubits) const {
+    std::size_t result = 0;
+    for (auto q : qubits)
+      result |= mask(q);
+    return result;
+  }
+
+  /// Apply the 2x2 matrix, in row major order, to the target qubit under the
+  /// controls.
+  void apply(const std::vector<std::complex<double>> &m,
+             const std::vector<std::size_t> &controls, std::size_t target) {
+    const std::size_t controlMask = mask(controls);
+    const std::size_t targetMask = mask(target);
+    for (std::size_t i = 0; i < data.size(); i++) {
+      if ((i & targetMask) || (i & controlMask) != controlMask)
+        continue;
+      auto a = data[i], b = data[i | targetMask];
+      data[i] = m[0] * a + m[1] * b;
+      data[i | targetMask] = m[2] * a + m[3] * b;
+    }
+  }
+
+  /// Swap the qubits a and b under the controls.
+  void swap(const std::vector<std::size_t> &controls, std::size_t a,
+            std::size_t b) {
+    const std::size_t controlMask = mask(controls);
+    const std::size_t aMask = mask(a), bMask = mask(b);
+    for (std::size_t i = 0; i < data.size(); i++)
+      if ((i & controlMask) == controlMask && (i & aMask) && !(i & bMask))
+        std::swap(data[i], data[i ^ aMask ^ bMask]);
+  }
+
+  /// Project qubit q on the given result and renormalize.
+  void project(std::size_t q, bool result) {
+    double norm = 0.;
+    for (std::size_t i = 0; i < data.size(); i++) {
+      if (bool(i & mask(q)) != result)
+        data[i] = 0.;
+      norm += std::norm(data[i]);
+    }
+    for (auto &amplitude : data)
+      amplitude /= std::sqrt(norm);
+  }
+
+  /// Return the probability that the given qubits have the given bits.
+  double probability(const std::vector<std::size_t> &qubits,
+                     const std::string &bits) const {
+    double result = 0.;
+    for (std::size_t i = 0; i < data.size(); i++) {
+      bool matches = true;
+      for (std::size_t j = 0; j < qubits.size(); j++)
+        matches &= bool(i & mask(qubits[j])) == (bits[j] == '1');
+      if (matches)
+        result += std::norm(data[i]);
+    }
+    return result;
+  }
+
+  /// Return <Z...Z> over the given qubits.
+  double parity(const std::vector<std::size_t> &qubits) const {
+    const std::size_t qubitMask = mask(qubits);
+    double result = 0.;
+    for (std::size_t i = 0; i < data.size(); i++)
+      result +=
+          std::norm(data[i]) * (std::popcount(i & qubitMask) % 2 ? -1. : 1.);
+    return result;
+  }
+};
+
+/// Apply the same gates to the simulator and the reference. On every target,
+/// H and Ry, then X, Rx, T, Rz, U3 and Y under each of the control sets not
+/// holding the target.
+template <typename Simulator>
+void applyReferenceCircuit(
+    Simulator &sim, ReferenceState &ref,
+    const std::vector<std::vector<std::size_t>> &controlSets) {
+  using nvqir::GateName;
+  using nvqir::getGateByName;
+  for (std::size_t t = 0; t < ref.nQubits; t++) {
+    double angle = 0.3 + 0.17 * t;
+    sim.h(t);
+    ref.apply(getGateByName<double>(GateName::H), {}, t);
+    sim.ry(angle, t);
+    ref.apply(getGateByName<double>(GateName::Ry, {angle}), {}, t);
+    for (auto &controls : controlSets) {
+      if (std::find(controls.begin(), controls.end(), t) != controls.end())
+        continue;
+      sim.x(controls, t);
+      ref.apply(getGateByName<double>(GateName::X), controls, t);
+      sim.rx(angle, controls, t);
+      ref.apply(getGateByName<double>(GateName::Rx, {angle}), controls, t);
+      sim.t(controls, t);
+      ref.apply(getGateByName<double>(GateName::T), controls, t);
+      sim.rz(angle, controls, t);
+      ref.apply(getGateByName<double>(GateName::Rz, {angle}), controls, t);
+      sim.u3(angle, 0.2, -0.4, controls, t);
+      ref.apply(getGateByName<double>(GateName::U3, {angle, 0.2, -0.4}),
+                controls, t);
+      sim.y(controls, t);
+      ref.apply(getGateByName<double>(GateName::Y), controls, t);
+    }
+  }
+}
+
+/// Check that the state of the simulator is the reference state.
+template <typename Simulator>
+void expectReferenceState(Simulator &sim, const ReferenceState &ref) {
+  auto [dims, data] = sim.getStateData();
+  ASSERT_EQ(data.size(), ref.data.size());
+  for (std::size_t i = 0; i < data.size(); i++) {
+    EXPECT_NEAR(data[i].real(), ref.data[i].real(), 1e-12);
+    EXPECT_NEAR(data[i].imag(), ref.data[i].imag(), 1e-12);
+  }
+}
+
+/// Run the reference circuit on new qubits of the simulator, check its
+/// state, and deallocate the qubits.
+template <typename Simulator>
+void checkCircuit(Simulator &sim, std::size_t nQubits,
+                  const std::vector<std::vector<std::size_t>> &controlSets,
+                  bool reversedOrder = false) {
+  ReferenceState ref(nQubits, reversedOrder);
+  auto qubits = sim.allocateQubits(nQubits);
+  applyReferenceCircuit(sim, ref, controlSets);
+  expectReferenceState(sim, ref);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
@@ -0,0 +1,85 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include <complex>
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+#include "CUDAQTestUtils.h"
+#include "ReferenceState.h"
+
+#define __NVQIR_SIMD_TOGGLE_CREATE
+#include "SimdCircuitSimulator.cpp"
+
+using namespace nvqir;
+
+// Exercise every target position, so that spans shorter and longer than the
+// vector width are both covered.
+CUDAQ_TEST(SimdTester, checkKernelsMatchReference) {
+  const std::vector<std::vector<std::size_t>> controlSets{
+      {}, {0}, {9}, {1, 3}};
+  {
+    SimdCircuitSimulator sim;
+    checkCircuit(sim, 10, controlSets);
+  }
+
+  // Force the portable kernels and check they agree as well.
+  setenv("CUDAQ_SIMD_ISA", "scalar", 1);
+  SimdCircuitSimulator scalarSim;
+  unsetenv("CUDAQ_SIMD_ISA");
+  EXPECT_EQ(scalarSim.isa(), "scalar");
+  checkCircuit(scalarSim, 10, controlSets);
+}
+
+CUDAQ_TEST(SimdTester, checkSwapAndMeasure) {
+  SimdCircuitSimulator sim;
+  auto qubits = sim.allocateQubits(6);
+  sim.x(0);
+  sim.swap({}, 0, 5);
+  EXPECT_FALSE(sim.mz(0));
+  EXPECT_TRUE(sim.mz(5));
+
+  // Controlled swap only fires with the control set.
+  sim.swap({2}, 5, 1);
+  EXPECT_TRUE(sim.mz(5));
+  sim.x(2);
+  sim.swap({2}, 5, 1);
+  EXPECT_FALSE(sim.mz(5));
+  EXPECT_TRUE(sim.mz(1));
+
+  sim.resetQubit(1);
+  EXPECT_FALSE(sim.mz(1));
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+// Deallocated qubits stay in the buffer, reset to |0>, the state only holds
+// the qubits in use.
+CUDAQ_TEST(SimdTester, checkStateAfterDeallocation) {
+  SimdCircuitSimulator sim;
+  auto qubits = sim.allocateQubits(3);
+  sim.h(0);
+  sim.x(1);
+  sim.x({0}, 2);
+  sim.deallocate(1);
+
+  // Qubits 0 and 2 are bits 0 and 1 of the state, in a Bell pair.
+  ReferenceState ref(2);
+  ref.data[0] = ref.data[3] = M_SQRT1_2;
+  expectReferenceState(sim, ref);
+
+  // The qubit allocated next takes the freed position back.
+  EXPECT_EQ(sim.allocateQubit(), 1);
+  sim.x(1);
+  ReferenceState grown(3);
+  grown.data[0] = 0.;
+  grown.data[2] = grown.data[7] = M_SQRT1_2;
+  expectReferenceState(sim, grown);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
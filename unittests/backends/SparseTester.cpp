@@ -0,0 +1,155 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include <complex>
+#include <cstdlib>
+#include <gtest/gtest.h>
+
+#include "CUDAQTestUtils.h"
+#include "ReferenceState.h"
+#include <cudaq/algorithm.h>
+
+#define __NVQIR_SPARSE_TOGGLE_CREATE
+#include "SparseCircuitSimulator.cpp"
+
+namespace {
+/// Run the same gates on the simulator and the reference state.
+void checkGates(nvqir::SparseCircuitSimulator &sim) {
+  const std::size_t nQubits = 7;
+  ReferenceState ref(nQubits, /*reversedOrder=*/true);
+  auto qubits = sim.allocateQubits(nQubits);
+  applyReferenceCircuit(sim, ref, {{}, {0}, {nQubits - 1}, {2, 5}});
+  sim.swap({3}, 0, 6);
+  ref.swap({3}, 0, 6);
+  expectReferenceState(sim, ref);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+struct ghz {
+  void operator()(const int N) __qpu__ {
+    cudaq::qreg q(N);
+    h(q[0]);
+    for (int i = 0; i < N - 1; i++)
+      x<cudaq::ctrl>(q[i], q[i + 1]);
+    mz(q);
+  }
+};
+} // namespace
+
+CUDAQ_TEST(SparseTester, checkGatesMatchReference) {
+  // Kept sparse for the whole circuit.
+  setenv("CUDAQ_SPARSE_DENSITY_THRESHOLD", "2", 1);
+  nvqir::SparseCircuitSimulator sparseSim;
+  unsetenv("CUDAQ_SPARSE_DENSITY_THRESHOLD");
+  checkGates(sparseSim);
+
+  // Turns dense once the hadamards spread the state.
+  nvqir::SparseCircuitSimulator denseSim;
+  checkGates(denseSim);
+}
+
+CUDAQ_TEST(SparseTester, checkLowSupportOnManyQubits) {
+  nvqir::SparseCircuitSimulator sim;
+  const std::size_t nQubits = 64;
+  auto qubits = sim.allocateQubits(nQubits);
+
+  // A ripple of controlled gates and swaps on a basis state keeps a single
+  // entry, a GHZ state two.
+  sim.x(0);
+  for (std::size_t q = 0; q + 1 < nQubits; q++)
+    sim.x({q}, q + 1);
+  sim.swap(0, 63);
+  sim.x({1, 2}, 0);
+  EXPECT_EQ(sim.getSupportSize(), 1);
+  EXPECT_FALSE(sim.isDenseState());
+
+  for (auto q : qubits)
+    sim.x(q);
+  sim.h(0);
+  for (std::size_t q = 0; q + 1 < nQubits; q++)
+    sim.x({q}, q + 1);
+  sim.s(10);
+  sim.rz(0.3, 40);
+  EXPECT_EQ(sim.getSupportSize(), 2);
+
+  auto result = sim.sample({0, 30, 63}, 400);
+  result.materializeCounts();
+  std::size_t total = 0;
+  for (auto &[bits, count] : result.counts) {
+    EXPECT_TRUE(bits == "000" || bits == "111");
+    total += count;
+  }
+  EXPECT_EQ(total, 400);
+
+  using namespace cudaq::spin;
+  cudaq::spin_op zz = z(0) * z(63);
+  cudaq::spin_op xx = x(0) * x(63);
+  EXPECT_NEAR(sim.observe(zz).expectationValue.value(), 1., 1e-12);
+  EXPECT_NEAR(sim.observe(xx).expectationValue.value(), 0., 1e-12);
+
+  // The amplitudes that cancel are dropped.
+  sim.h(50);
+  EXPECT_EQ(sim.getSupportSize(), 4);
+  sim.h(50);
+  EXPECT_EQ(sim.getSupportSize(), 2);
+
+  const bool first = sim.mz(0);
+  EXPECT_EQ(sim.getSupportSize(), 1);
+  EXPECT_EQ(sim.mz(63), first);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(SparseTester, checkDenseSwitch) {
+  setenv("CUDAQ_SPARSE_DENSITY_THRESHOLD", "0.5", 1);
+  nvqir::SparseCircuitSimulator sim;
+  unsetenv("CUDAQ_SPARSE_DENSITY_THRESHOLD");
+  auto qubits = sim.allocateQubits(4);
+  sim.h(0);
+  sim.h(1);
+  sim.h(2);
+  EXPECT_FALSE(sim.isDenseState());
+  sim.h(3);
+  EXPECT_TRUE(sim.isDenseState());
+
+  // Undo the hadamards, the state stays dense and gives |0000>.
+  for (auto q : qubits)
+    sim.h(q);
+  auto [dims, data] = sim.getStateData();
+  EXPECT_NEAR(std::abs(data[0]), 1., 1e-12);
+
+  // Growing past the dense limit turns the state sparse again.
+  auto more = sim.allocateQubits(40);
+  EXPECT_FALSE(sim.isDenseState());
+  EXPECT_EQ(sim.getSupportSize(), 1);
+  for (auto q : more)
+    sim.deallocate(q);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(SparseTester, checkLargeGHZ) {
+  auto counts = cudaq::sample(100, ghz{}, 60);
+  std::size_t total = 0;
+  for (auto &[bits, count] : counts) {
+    total += count;
+    EXPECT_TRUE(bits == std::string(60, '0') || bits == std::string(60, '1'));
+  }
+  EXPECT_EQ(total, 100);
+
+  auto kernel = []() __qpu__ {
+    cudaq::qreg q(60);
+    h(q[0]);
+    for (int i = 0; i < 59; i++)
+      x<cudaq::ctrl>(q[i], q[i + 1]);
+  };
+  using namespace cudaq::spin;
+  cudaq::spin_op h = z(0) * z(59) + 0.5 * z(30) + 2. * x(0) * x(59);
+  EXPECT_NEAR(cudaq::observe(kernel, h), 1., 1e-9);
+}
@@ -0,0 +1,191 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include <complex>
+#include <gtest/gtest.h>
+#include <random>
+
+#include "CUDAQTestUtils.h"
+#include "Gates.h"
+#include "ReferenceState.h"
+#include <cudaq/algorithm.h>
+
+#define __NVQIR_STABILIZER_TOGGLE_CREATE
+#include "StabilizerCircuitSimulator.cpp"
+
+using nvqir::GateName;
+using nvqir::getGateByName;
+
+namespace {
+struct ghz {
+  void operator()(const int N) __qpu__ {
+    cudaq::qreg q(N);
+    h(q[0]);
+    for (int i = 0; i < N - 1; i++)
+      x<cudaq::ctrl>(q[i], q[i + 1]);
+    mz(q);
+  }
+};
+} // namespace
+
+CUDAQ_TEST(StabilizerTester, checkRandomCliffordCircuits) {
+  std::mt19937 gen(13);
+  const std::size_t nQubits = 5;
+  const double quarter = M_PI_2;
+  for (int circuit = 0; circuit < 20; circuit++) {
+    nvqir::StabilizerCircuitSimulator sim;
+    ReferenceState ref(nQubits);
+    auto qubits = sim.allocateQubits(nQubits);
+    auto pick = [&]() { return std::size_t(gen() % nQubits); };
+    for (int gate = 0; gate < 40; gate++) {
+      const auto t = pick();
+      auto c = pick();
+      if (c == t)
+        c = (t + 1) % nQubits;
+      const double angle = quarter * (int(gen() % 7) - 3);
+      switch (gen() % 13) {
+      case 0:
+        sim.h(t);
+        ref.apply(getGateByName<double>(GateName::H), {}, t);
+        break;
+      case 1:
+        sim.s(t);
+        ref.apply(getGateByName<double>(GateName::S), {}, t);
+        break;
+      case 2:
+        sim.sdg(t);
+        ref.apply(getGateByName<double>(GateName::Sdg), {}, t);
+        break;
+      case 3:
+        sim.y(t);
+        ref.apply(getGateByName<double>(GateName::Y), {}, t);
+        break;
+      case 4:
+        sim.x({c}, t);
+        ref.apply(getGateByName<double>(GateName::X), {c}, t);
+        break;
+      case 5:
+        sim.y({c}, t);
+        ref.apply(getGateByName<double>(GateName::Y), {c}, t);
+        break;
+      case 6:
+        sim.z({c}, t);
+        ref.apply(getGateByName<double>(GateName::Z), {c}, t);
+        break;
+      case 7:
+        sim.rx(angle, t);
+        ref.apply(getGateByName<double>(GateName::Rx, {angle}), {}, t);
+        break;
+      case 8:
+        sim.ry(angle, t);
+        ref.apply(getGateByName<double>(GateName::Ry, {angle}), {}, t);
+        break;
+      case 9:
+        sim.r1(angle, t);
+        ref.apply(getGateByName<double>(GateName::R1, {angle}), {}, t);
+        break;
+      case 10:
+        sim.u3(angle, quarter, -angle, {}, t);
+        ref.apply(getGateByName<double>(GateName::U3, {angle, quarter, -angle}),
+                  {}, t);
+        break;
+      case 11:
+        sim.u2(angle, -quarter, {}, t);
+        ref.apply(getGateByName<double>(GateName::U2, {angle, -quarter}), {},
+                  t);
+        break;
+      default:
+        sim.swap({}, c, t);
+        ref.swap({}, c, t);
+        break;
+      }
+    }
+
+    for (const std::vector<std::size_t> &measured :
+         std::vector<std::vector<std::size_t>>{
+             {0}, {4}, {1, 3}, {0, 2, 4}, {0, 1, 2, 3, 4}}) {
+      EXPECT_NEAR(sim.sample(measured, 0).expectationValue.value(),
+                  ref.parity(measured), 1e-9);
+
+      // Every sampled outcome must have a nonzero probability.
+      auto result = sim.sample(measured, 100);
+      std::size_t total = 0;
+      for (auto &[bits, count] : result.counts) {
+        total += count;
+        EXPECT_GT(ref.probability(measured, bits), 1e-9) << bits;
+      }
+      EXPECT_EQ(total, 100);
+    }
+
+    for (auto q : qubits)
+      sim.deallocate(q);
+  }
+}
+
+CUDAQ_TEST(StabilizerTester, checkMeasureAndReset) {
+  nvqir::StabilizerCircuitSimulator sim;
+  auto qubits = sim.allocateQubits(3);
+  sim.x(1);
+  sim.swap({}, 1, 2);
+  EXPECT_FALSE(sim.mz(1));
+  EXPECT_TRUE(sim.mz(2));
+
+  // The outcome of a Bell pair is random, but fixes its partner.
+  sim.h(0);
+  sim.x({0}, 1);
+  EXPECT_EQ(sim.mz(0), sim.mz(1));
+
+  sim.resetQubit(0);
+  sim.resetQubit(2);
+  EXPECT_FALSE(sim.mz(0));
+  EXPECT_FALSE(sim.mz(2));
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(StabilizerTester, checkNonCliffordGatesThrow) {
+  nvqir::StabilizerCircuitSimulator sim;
+  auto qubits = sim.allocateQubits(3);
+  EXPECT_THROW(sim.t(0), std::runtime_error);
+  EXPECT_THROW(sim.rx(0.3, 0), std::runtime_error);
+  EXPECT_THROW(sim.x({0, 1}, 2), std::runtime_error);
+  EXPECT_THROW(sim.h({0}, 1), std::runtime_error);
+  EXPECT_THROW(sim.rz(M_PI_2, {0}, 1), std::runtime_error);
+  EXPECT_NO_THROW(sim.rx(-M_PI_2, 0));
+  EXPECT_NO_THROW(sim.rz(0., {0}, 1));
+  EXPECT_THROW(sim.getStateData(), std::runtime_error);
+  for (auto q : qubits)
+    sim.deallocate(q);
+}
+
+CUDAQ_TEST(StabilizerTester, checkLargeGHZ) {
+  auto counts = cudaq::sample(100, ghz{}, 1000);
+  std::size_t total = 0;
+  for (auto &[bits, count] : counts) {
+    total += count;
+    EXPECT_EQ(bits.size(), 1000);
+    EXPECT_TRUE(bits == std::string(1000, '0') ||
+                bits == std::string(1000, '1'));
+  }
+  EXPECT_EQ(total, 100);
+  EXPECT_EQ(counts.size(), 2);
+}
+
+CUDAQ_TEST(StabilizerTester, checkObserve) {
+  auto bell = []() __qpu__ {
+    cudaq::qreg q(2);
+    h(q[0]);
+    x<cudaq::ctrl>(q[0], q[1]);
+  };
+
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 2. + x(0) * x(1) - y(0) * y(1) + z(0) * z(1) + z(0);
+  EXPECT_NEAR(cudaq::observe(bell, h), 5., 1e-9);
+  // Only <Z0> is random with shots.
+  EXPECT_NEAR(cudaq::observe(1000, bell, h), 5., 0.2);
+}
@@ -0,0 +1,64 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "common/ObserveResult.h"
+#include "common/RuntimeMLIR.h"
+#include "cudaq/Optimizer/Builder/Runtime.h"
+#include "cudaq/builder.h"
+#include "cudaq/platform/default/rest/ObserveCodegen.h"
+#include "cudaq/spin_op.h"
+#include "mlir/Dialect/Func/IR/FuncOps.h"
+#include "mlir/IR/BuiltinOps.h"
+#include "mlir/Parser/Parser.h"
+
+#include <gtest/gtest.h>
+
+using namespace mlir;
+
+TEST(ObserveCodegenTester, checkOpenQASMAnsatzMatchesTranslation) {
+  auto kernel = cudaq::make_kernel();
+  auto q = kernel.qalloc(4);
+  kernel.x(q[0]);
+  kernel.ry(.59, q[1]);
+  kernel.x<cudaq::ctrl>(q[1], q[0]);
+  kernel.h(q[2]);
+  kernel.x<cudaq::ctrl>(q[2], q[3]);
+
+  // Groups measuring all qubits, and some of them in every basis.
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1) + x(2) * z(3) + y(3) +
+                     z(0) * y(2) * x(3);
+  auto groups = h.get_qubit_wise_commuting_groups();
+  ASSERT_GT(groups.size(), 2u);
+
+  auto context = cudaq::initializeMLIR();
+  auto module = parseSourceString<ModuleOp>(kernel.to_quake(), context.get());
+  ASSERT_TRUE(module);
+  ASSERT_TRUE(succeeded(cudaq::runPassPipeline("canonicalize", *module)));
+  auto ansatz = module->lookupSymbol<func::FuncOp>(
+      cudaq::runtime::cudaqGenPrefixName + kernel.name());
+  ASSERT_TRUE(ansatz);
+
+  auto &translation = cudaq::getTranslation("qasm2");
+  auto qasmAnsatz = cudaq::translateOpenQASMAnsatz(translation, "qasm2",
+                                                   ansatz, h.num_qubits());
+  ASSERT_TRUE(qasmAnsatz);
+
+  // The code assembled for each group is the translation of the ansatz
+  // measured in the basis of the group.
+  for (auto &group : groups) {
+    auto basis = cudaq::details::getMeasurementBasis(h, group);
+    OwningOpRef<ModuleOp> groupModule(ModuleOp::create(ansatz.getLoc()));
+    groupModule->push_back(ansatz.clone());
+    auto expected = cudaq::translateObserveModule(translation, "qasm2",
+                                                  *groupModule, basis);
+    EXPECT_EQ(cudaq::measureOpenQASMAnsatz(*qasmAnsatz, basis), expected)
+        << cudaq::details::getMeasurementBasisName(h, group);
+  }
+}
@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CUDAQTestUtils.h"
+#include "common/DistributionCache.h"
+
+using namespace cudaq;
+
+CUDAQ_TEST(DistributionCacheTester, checkAliasTable) {
+  // Bit j of an outcome is character j of its bit string.
+  AliasTable table({0.1, 0.2, 0.0, 0.7}, 2);
+  const std::size_t shots = 100000;
+  sample_result counts(table.sample(shots, 42));
+  EXPECT_EQ(counts.size(), 3);
+  EXPECT_EQ(counts.count("01"), 0);
+  EXPECT_NEAR(counts.count("00") / double(shots), 0.1, 0.01);
+  EXPECT_NEAR(counts.count("10") / double(shots), 0.2, 0.01);
+  EXPECT_NEAR(counts.count("11") / double(shots), 0.7, 0.01);
+  EXPECT_NEAR(counts.exp_val_z(), 0.1 - 0.2 + 0.7, 1e-12);
+
+  // The draws are reproducible from a seed, and the probabilities need not
+  // be normalized.
+  sample_result again(table.sample(shots, 42));
+  EXPECT_EQ(again.count("11"), counts.count("11"));
+  sample_result single(AliasTable({0.0, 0.0, 3.0, 0.0}, 2).sample(10, 1));
+  EXPECT_EQ(single.count("01"), 10);
+
+  EXPECT_ANY_THROW(AliasTable({0.0, 0.0}, 1));
+}
+
+CUDAQ_TEST(DistributionCacheTester, checkLeastRecentlyUsed) {
+  DistributionCache cache;
+  auto table = std::make_shared<const AliasTable>(
+      std::vector<double>{0.5, 0.5}, 1);
+  EXPECT_FALSE(cache.enabled());
+  cache.insert("a", table);
+  EXPECT_EQ(cache.find("a"), nullptr);
+
+  cache.setCapacity(2);
+  cache.insert("a", table);
+  cache.insert("b", table);
+  EXPECT_EQ(cache.find("a"), table);
+  cache.insert("c", table);
+  EXPECT_EQ(cache.find("b"), nullptr);
+  EXPECT_EQ(cache.find("a"), table);
+  EXPECT_EQ(cache.find("c"), table);
+  EXPECT_EQ(cache.hits(), 3);
+
+  cache.setCapacity(1);
+  EXPECT_EQ(cache.find("a"), nullptr);
+  EXPECT_EQ(cache.find("c"), table);
+  cache.clear();
+  EXPECT_EQ(cache.find("c"), nullptr);
+  EXPECT_EQ(cache.hits(), 0);
+}
@@ -0,0 +1,278 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "common/Future.h"
+#include "common/ServerHelper.h"
+#include "cudaq/spin_op.h"
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+/// A minimal HTTP server on localhost standing in for the remote service of
+/// the jobs. A job is polled with GET /job/<id> and is done once it was
+/// polled the given number of times, or never. POST /cancel/<id> records the
+/// cancellation of the job.
+class MockJobServer {
+  int listener = -1;
+  int port = 0;
+  std::atomic<bool> stopping = false;
+  std::mutex mutex;
+  std::map<std::string, int> pollsUntilDone;
+  std::map<std::string, std::string> counts;
+  std::vector<std::string> cancelled;
+  std::thread worker;
+
+  /// Return the response body to the request.
+  std::string respond(const std::string &method, const std::string &path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (method == "POST" && path.starts_with("/cancel/")) {
+      cancelled.push_back(path.substr(8));
+      return "{}";
+    }
+    if (method != "GET" || !path.starts_with("/job/"))
+      return R"({"error": "unknown request"})";
+    auto id = path.substr(5);
+    auto &polls = pollsUntilDone.at(id);
+    if (polls != 0) {
+      if (polls > 0)
+        polls--;
+      return R"({"status": "running"})";
+    }
+    return R"({"status": "done", "counts": )" + counts.at(id) + "}";
+  }
+
+  /// Read a request, answer it and close the connection.
+  void serve(int connection) {
+    std::string request;
+    char buffer[4096];
+    std::size_t headerEnd = std::string::npos, contentLength = 0;
+    while (true) {
+      auto n = ::read(connection, buffer, sizeof(buffer));
+      if (n <= 0)
+        break;
+      request.append(buffer, n);
+      if (headerEnd == std::string::npos) {
+        headerEnd = request.find("\r\n\r\n");
+        if (headerEnd == std::string::npos)
+          continue;
+        auto lengthPos = request.find("Content-Length: ");
+        if (lengthPos != std::string::npos && lengthPos < headerEnd)
+          contentLength = std::stoul(request.substr(lengthPos + 16));
+      }
+      if (request.size() >= headerEnd + 4 + contentLength)
+        break;
+    }
+    auto methodEnd = request.find(' ');
+    auto pathEnd = request.find(' ', methodEnd + 1);
+    std::string body = methodEnd == std::string::npos
+                           ? std::string("{}")
+                           : respond(request.substr(0, methodEnd),
+                                     request.substr(methodEnd + 1,
+                                                    pathEnd - methodEnd - 1));
+    std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json"
+                           "\r\nConnection: close\r\nContent-Length: " +
+                           std::to_string(body.size()) + "\r\n\r\n" + body;
+    for (std::size_t sent = 0; sent < response.size();) {
+      auto n = ::write(connection, response.data() + sent,
+                       response.size() - sent);
+      if (n <= 0)
+        break;
+      sent += n;
+    }
+    ::close(connection);
+  }
+
+public:
+  MockJobServer() {
+    listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    if (::bind(listener, reinterpret_cast<sockaddr *>(&address),
+               sizeof(address)) != 0 ||
+        ::listen(listener, 16) != 0)
+      throw std::runtime_error("Could not start the mock job server.");
+    socklen_t length = sizeof(address);
+    ::getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length);
+    port = ntohs(address.sin_port);
+    worker = std::thread([this]() {
+      while (!stopping) {
+        pollfd ready{listener, POLLIN, 0};
+        if (::poll(&ready, 1, 20) > 0)
+          if (int connection = ::accept(listener, nullptr, nullptr);
+              connection >= 0)
+            serve(connection);
+      }
+    });
+  }
+
+  ~MockJobServer() {
+    stopping = true;
+    worker.join();
+    ::close(listener);
+  }
+
+  std::string url() const { return "http://127.0.0.1:" + std::to_string(port); }
+
+  /// Add a job that is done, with the given counts, once it was polled
+  /// `polls` times, or never if `polls` is negative.
+  void addJob(const std::string &id, int polls,
+              const std::string &jobCounts = "{}") {
+    std::lock_guard<std::mutex> lock(mutex);
+    pollsUntilDone[id] = polls;
+    counts[id] = jobCounts;
+  }
+
+  /// Return the ids of the jobs cancelled so far, sorted.
+  std::vector<std::string> getCancelled() {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto result = cancelled;
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+};
+
+/// The server helper of the mock job server, its URL is the `url` of the
+/// server configuration.
+class MockServerHelper : public cudaq::ServerHelper {
+  std::string url;
+
+public:
+  const std::string name() const override { return "mock_jobs"; }
+  void initialize(cudaq::BackendConfig config) override {
+    backendConfig = config;
+    url = backendConfig["url"];
+  }
+  cudaq::RestHeaders getHeaders() override {
+    return {{"Content-Type", "application/json"}};
+  }
+  cudaq::ServerJobPayload
+  createJob(std::vector<cudaq::KernelExecution> &) override {
+    throw std::runtime_error("The mock job server does not take jobs.");
+  }
+  std::string extractJobId(cudaq::ServerMessage &) override { return {}; }
+  std::string constructGetJobPath(std::string &jobId) override {
+    return url + "/job/" + jobId;
+  }
+  std::string constructGetJobPath(cudaq::ServerMessage &) override {
+    return {};
+  }
+  std::optional<std::string>
+  constructCancelJobPath(std::string &jobId) override {
+    return url + "/cancel/" + jobId;
+  }
+  bool jobIsDone(cudaq::ServerMessage &response) override {
+    return response["status"] == "done";
+  }
+  std::chrono::milliseconds
+  nextPollingInterval(cudaq::ServerMessage &,
+                      std::chrono::milliseconds) override {
+    return std::chrono::milliseconds(5);
+  }
+  cudaq::sample_result processResults(cudaq::ServerMessage &response) override {
+    cudaq::CountsDictionary jobCounts;
+    for (auto &[bits, count] : response["counts"].items())
+      jobCounts[bits] = count.get<std::size_t>();
+    return cudaq::sample_result(cudaq::ExecutionResult(jobCounts));
+  }
+};
+} // namespace
+
+CUDAQ_REGISTER_TYPE(cudaq::ServerHelper, MockServerHelper, mock_jobs)
+
+namespace {
+/// Return the future of the jobs on the mock server.
+cudaq::details::future
+makeFuture(MockJobServer &server,
+           std::vector<cudaq::details::future::Job> jobs) {
+  std::string qpuName = "mock_jobs";
+  std::map<std::string, std::string> config{{"url", server.url()}};
+  return cudaq::details::future(jobs, qpuName, config);
+}
+} // namespace
+
+TEST(FutureTester, checkCancelPostsToUnfinishedJobs) {
+  MockJobServer server;
+  server.addJob("a", -1);
+  server.addJob("b", -1);
+  auto future = makeFuture(server, {{"a", "A"}, {"b", "B"}});
+  future.cancel();
+  EXPECT_EQ(server.getCancelled(), std::vector<std::string>({"a", "b"}));
+  EXPECT_THROW(future.get(), std::runtime_error);
+  EXPECT_TRUE(future.wait_for(std::chrono::microseconds(0)));
+
+  // Cancelling again posts nothing more.
+  future.cancel();
+  EXPECT_EQ(server.getCancelled().size(), 2);
+}
+
+TEST(FutureTester, checkGetReturnsOnceDoneAccepts) {
+  MockJobServer server;
+  server.addJob("a", 1, R"({"00": 60, "11": 40})");
+  server.addJob("b", -1);
+  auto future = makeFuture(server, {{"a", "A"}, {"b", "B"}});
+  std::size_t calls = 0;
+  auto result = future.get([&](cudaq::sample_result &partial) {
+    calls++;
+    auto names = partial.register_names();
+    return std::find(names.begin(), names.end(), "A") != names.end();
+  });
+  EXPECT_GT(calls, 0);
+  EXPECT_EQ(result.register_names(), std::vector<std::string>({"A"}));
+  EXPECT_EQ(result.count("00", "A"), 60);
+  EXPECT_EQ(result.count("11", "A"), 40);
+  // Only the job still running is cancelled.
+  EXPECT_EQ(server.getCancelled(), std::vector<std::string>({"b"}));
+}
+
+TEST(FutureTester, checkGetWithinTolerance) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 1.5 * z(0) * z(1) + .1 * x(0) * x(1);
+  auto groups = h.get_qubit_wise_commuting_groups();
+  ASSERT_EQ(groups.size(), 2);
+  std::vector<cudaq::details::future::Job> jobs;
+  for (auto &group : groups) {
+    auto name = cudaq::details::getMeasurementBasisName(h, group);
+    jobs.emplace_back(name.starts_with("Z") ? "z" : "x", name);
+  }
+
+  // The XX group can change the energy by at most .1, so a tolerance of .2
+  // returns without it, counting it as 0 and cancelling its job.
+  {
+    MockJobServer server;
+    server.addJob("z", 0, R"({"00": 75, "01": 25})");
+    server.addJob("x", -1);
+    cudaq::async_result<cudaq::observe_result> result(
+        makeFuture(server, jobs), &h);
+    EXPECT_NEAR(result.get_within(.2).exp_val_z(), 1.5 * .5, 1e-12);
+    EXPECT_EQ(server.getCancelled(), std::vector<std::string>({"x"}));
+  }
+
+  // A tolerance of .05 waits for the XX group as well.
+  {
+    MockJobServer server;
+    server.addJob("z", 0, R"({"00": 75, "01": 25})");
+    server.addJob("x", 3, R"({"00": 90, "10": 10})");
+    cudaq::async_result<cudaq::observe_result> result(
+        makeFuture(server, jobs), &h);
+    EXPECT_NEAR(result.get_within(.05).exp_val_z(), 1.5 * .5 + .1 * .8,
+                1e-12);
+    EXPECT_TRUE(server.getCancelled().empty());
+  }
+}
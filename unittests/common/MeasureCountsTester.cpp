@@ -7,7 +7,15 @@
  *******************************************************************************/
 
 #include "CUDAQTestUtils.h"
+#include "common/ApproximateCounts.h"
+#include "common/ColumnarResult.h"
 #include "common/MeasureCounts.h"
+#include "common/ObserveResult.h"
+#include "common/ResultCache.h"
+#include "common/ShotStream.h"
+#include <map>
+#include <random>
+#include <sstream>
 
 using namespace cudaq;
 
@@ -38,6 +46,31 @@ CUDAQ_TEST(MeasureCountsTester, checkExpValZ) {
   EXPECT_NEAR(-1. / 5., mc.exp_val_z(), 1e-9);
 }
 
+CUDAQ_TEST(MeasureCountsTester, checkMarginalizeGroupCounts) {
+  using namespace cudaq::spin;
+  spin_op H = 2. + z(0) + z(1) + .5 * z(0) * z(1) + x(0) * x(1);
+  auto groups = H.get_qubit_wise_commuting_groups();
+  ASSERT_EQ(2, groups.size());
+
+  // Counts of the z and x measurement settings, as returned by a QPU.
+  std::vector<ExecutionResult> groupResults{
+      {CountsDictionary{{"00", 300}, {"01", 100}, {"11", 600}},
+       details::getMeasurementBasisName(H, groups[0])},
+      {CountsDictionary{{"00", 500}, {"11", 500}},
+       details::getMeasurementBasisName(H, groups[1])}};
+  sample_result data(groupResults);
+  details::marginalizeGroupCounts(data, H);
+
+  auto z0 = data.to_map(H[1].to_string(false));
+  EXPECT_EQ(400, z0["0"]);
+  EXPECT_EQ(600, z0["1"]);
+  auto z1 = data.to_map(H[2].to_string(false));
+  EXPECT_EQ(300, z1["0"]);
+  EXPECT_EQ(700, z1["1"]);
+  EXPECT_NEAR(.8, data.exp_val_z(H[3].to_string(false)), 1e-9);
+  EXPECT_NEAR(1., data.exp_val_z(H[4].to_string(false)), 1e-9);
+}
+
 // TEST Sample Result / sample_result serialize / deserialize
 
 CUDAQ_TEST(MeasureCountsTester, checkSampleResultSerialize) {
@@ -64,3 +97,417 @@ CUDAQ_TEST(MeasureCountsTester, checkMeasureCountsSerialize) {
 
   EXPECT_TRUE(mm == mc);
 }
+
+CUDAQ_TEST(MeasureCountsTester, checkPackedCounts) {
+  // Bit j of a packed bit string is the j-th character, first bit first.
+  ExecutionResult packed;
+  const std::uint64_t a = 0b001, b = 0b110;
+  packed.appendResult(&a, 3, 400);
+  packed.appendResult(&b, 3, 500);
+  packed.appendResult("100", 100);
+  EXPECT_TRUE(packed.isPacked());
+  EXPECT_TRUE(packed.counts.empty());
+  EXPECT_EQ(1000, packed.totalCount());
+
+  ExecutionResult strings{CountsDictionary{{"100", 500}, {"011", 500}}};
+  EXPECT_TRUE(strings == packed);
+
+  cudaq::sample_result mc(packed);
+  EXPECT_EQ(2, mc.size());
+  EXPECT_EQ(500, mc.count("100"));
+  EXPECT_EQ(0, mc.count("111"));
+  EXPECT_EQ(0, mc.count("1"));
+  EXPECT_NEAR(.5, mc.probability("011"), 1e-9);
+  EXPECT_NEAR(0., mc.exp_val_z(), 1e-9);
+  auto marginal = mc.get_marginal({1, 2});
+  EXPECT_EQ(500, marginal.count("00"));
+  EXPECT_EQ(500, marginal.count("11"));
+  EXPECT_EQ(std::vector<std::string>({"100", "011", "100"}),
+            mc.sequential_data());
+
+  // Iterating materializes the strings once.
+  std::size_t total = 0;
+  for (auto &[bits, count] : mc) {
+    EXPECT_TRUE(bits == "100" || bits == "011");
+    total += count;
+  }
+  EXPECT_EQ(1000, total);
+  EXPECT_EQ(2, mc.to_map().size());
+
+  // Serialized like string counts.
+  ExecutionResult deserialized;
+  auto data = ExecutionResult(packed).serialize();
+  deserialized.deserialize(data);
+  EXPECT_TRUE(deserialized == strings);
+
+  // Merging packed results adds the counts.
+  ExecutionResult more;
+  more.appendResult(&b, 3, 10);
+  cudaq::sample_result other(more);
+  cudaq::sample_result merged(packed);
+  merged += other;
+  EXPECT_EQ(510, merged.count("011"));
+
+  // More than 64 bits.
+  std::vector<std::uint64_t> wide{1, 1ULL << 3};
+  ExecutionResult wideResult;
+  wideResult.appendResult(wide.data(), 70, 7);
+  std::string want(70, '0');
+  want[0] = want[67] = '1';
+  EXPECT_EQ(7, cudaq::sample_result(wideResult).count(want));
+  EXPECT_EQ(want, wideResult.toCountsDictionary().begin()->first);
+}
+
+CUDAQ_TEST(MeasureCountsTester, checkRegisterShots) {
+  // Registers are normalized by their own shots.
+  std::vector<ExecutionResult> results{
+      {CountsDictionary{{"00", 300}, {"11", 100}}},
+      {CountsDictionary{{"0", 30}, {"1", 70}}, "reg"}};
+  sample_result mc(results);
+  EXPECT_NEAR(1., mc.exp_val_z(), 1e-9);
+  EXPECT_NEAR(.75, mc.probability("00"), 1e-9);
+  EXPECT_NEAR(-.4, mc.exp_val_z("reg"), 1e-9);
+  EXPECT_NEAR(.7, mc.probability("1", "reg"), 1e-9);
+
+  // Looking up a missing bit string does not add it.
+  EXPECT_EQ(0, mc.count("01"));
+  EXPECT_EQ(2, mc.size());
+
+  // Merging more counts updates the shots.
+  std::vector<ExecutionResult> more{{CountsDictionary{{"01", 400}}}};
+  sample_result other(more);
+  mc += other;
+  EXPECT_NEAR(.375, mc.probability("00"), 1e-9);
+  EXPECT_NEAR(0., mc.exp_val_z(), 1e-9);
+}
+
+CUDAQ_TEST(MeasureCountsTester, checkShotStream) {
+  PackedCounts counts(3);
+  counts.add("101", 250);
+  counts.add("010", 500);
+  counts.add("111", 250);
+
+  std::size_t nBatches = 0, nextShot = 0;
+  std::map<std::string, std::size_t> seen;
+  ShotStream stream({[&](const shot_batch &batch) {
+                       EXPECT_LE(batch.size(), 64);
+                       EXPECT_EQ(3, batch.n_bits());
+                       EXPECT_EQ(nextShot, batch.first_shot());
+                       nextShot += batch.size();
+                       nBatches++;
+                       for (std::size_t s = 0; s < batch.size(); s++)
+                         seen[batch.bit_string(s)]++;
+                     },
+                     64});
+  stream.appendCounts(counts);
+  stream.append("000");
+  stream.flush();
+
+  // Every count is streamed once, in batches of at most 64 shots.
+  EXPECT_EQ(1001, stream.size());
+  EXPECT_EQ(1001, nextShot);
+  EXPECT_EQ(16, nBatches);
+  EXPECT_EQ(250, seen["101"]);
+  EXPECT_EQ(500, seen["010"]);
+  EXPECT_EQ(250, seen["111"]);
+  EXPECT_EQ(1, seen["000"]);
+
+  // The records of a stream have the same length.
+  EXPECT_THROW(stream.append("01"), std::runtime_error);
+  EXPECT_THROW(ShotStream({nullptr, 64}), std::runtime_error);
+}
+
+CUDAQ_TEST(MeasureCountsTester, checkColumnarFormat) {
+  // A 70 bit global register and a named register with an expectation.
+  std::vector<std::uint64_t> wide{1, 1ULL << 3};
+  ExecutionResult global;
+  global.appendResult(wide.data(), 70, 700);
+  wide[0] = 2;
+  global.appendResult(wide.data(), 70, 300);
+  std::vector<ExecutionResult> results{
+      global, {CountsDictionary{{"0", 3}, {"1", 70000}}, "reg", -.5}};
+  sample_result mc(results);
+
+  for (bool compress : {false, true}) {
+    std::ostringstream os;
+    columnar::write(mc, os, compress);
+    auto bytes = os.str();
+    EXPECT_EQ(bytes.size(), columnar::serialize(mc, compress).size());
+    EXPECT_EQ(0, bytes.size() % 8);
+
+    sample_result_view view(bytes.data(), bytes.size());
+    EXPECT_EQ(compress, view.is_compressed());
+    EXPECT_EQ(1000, view.total_shots());
+    EXPECT_EQ(2, view.n_registers());
+    EXPECT_EQ(GlobalRegisterName, view.get_register(0).name());
+
+    auto *reg = view.find_register("reg");
+    ASSERT_NE(nullptr, reg);
+    EXPECT_EQ(1, reg->n_bits());
+    EXPECT_NEAR(-.5, reg->expectation_value().value(), 1e-12);
+    EXPECT_FALSE(view.get_register(0).expectation_value().has_value());
+
+    auto copy = view.to_sample_result();
+    std::string want(70, '0');
+    want[0] = want[67] = '1';
+    EXPECT_EQ(700, copy.count(want));
+    want[0] = '0';
+    want[1] = '1';
+    EXPECT_EQ(300, copy.count(want));
+    EXPECT_EQ(70000, copy.count("1", "reg"));
+    EXPECT_EQ(3, copy.count("0", "reg"));
+    EXPECT_NEAR(.3, copy.probability(want), 1e-12);
+  }
+
+  // Truncated or foreign buffers are rejected.
+  auto bytes = columnar::serialize(mc);
+  EXPECT_THROW(sample_result_view(bytes.data(), bytes.size() - 8),
+               std::runtime_error);
+  bytes[0] = 'X';
+  EXPECT_THROW(sample_result_view{bytes}, std::runtime_error);
+}
+
+CUDAQ_TEST(MeasureCountsTester, checkMarginalAndMerge) {
+  // Packed and string marginals agree, also across word boundaries and for
+  // enough bit strings to use several threads.
+  std::mt19937_64 gen(13);
+  CountsDictionary strings;
+  ExecutionResult packed;
+  std::vector<std::uint64_t> key(2);
+  for (std::size_t i = 0; i < 100000; i++) {
+    key = {gen(), gen() & 0x3f};
+    std::string bits(70, '0');
+    for (std::size_t j = 0; j < 70; j++)
+      if ((key[j / 64] >> (j % 64)) & 1)
+        bits[j] = '1';
+    strings[bits] += i % 7 + 1;
+    packed.appendResult(key.data(), 70, i % 7 + 1);
+  }
+  ExecutionResult unpacked{strings};
+  sample_result fromPacked(packed), fromStrings(unpacked);
+  for (std::vector<std::size_t> indices :
+       {std::vector<std::size_t>{3, 1, 63, 64, 69},
+        std::vector<std::size_t>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9},
+        std::vector<std::size_t>{5, 5, 66}}) {
+    auto want = fromStrings.get_marginal(indices).to_map();
+    auto got = fromPacked.get_marginal(indices).to_map();
+    EXPECT_EQ(want, got);
+  }
+
+  // Merging many results at once matches merging them one by one.
+  std::vector<sample_result> parts;
+  sample_result serial;
+  for (std::size_t q = 0; q < 4; q++) {
+    std::vector<ExecutionResult> results{
+        {CountsDictionary{{"00", q + 1}, {"11", 2 * q + 1}}},
+        {CountsDictionary{{"0", q}, {"1", 5}}, "reg" + std::to_string(q % 2)}};
+    parts.emplace_back(results);
+    serial += parts.back();
+  }
+  auto merged = sample_result::merge(parts);
+  EXPECT_EQ(serial.to_map(), merged.to_map());
+  EXPECT_EQ(serial.to_map("reg1"), merged.to_map("reg1"));
+  EXPECT_EQ(serial.register_names().size(), merged.register_names().size());
+  EXPECT_NEAR(serial.probability("11"), merged.probability("11"), 1e-12);
+}
+
+CUDAQ_TEST(MeasureCountsTester, checkApproximateCounts) {
+  counting_policy policy;
+  policy.top_k = 16;
+  policy.marginals = {{0, 1}, {39}};
+  approximate_counts counts(policy);
+
+  // Two frequent bit strings in a sea of unique ones.
+  std::mt19937_64 gen(7);
+  std::uint64_t frequent[] = {0b1011, 1ULL << 39};
+  std::size_t nOnes0 = 0, nOnes01 = 0, nOnes39 = 0;
+  for (std::size_t i = 0; i < 200000; i++) {
+    std::uint64_t key =
+        i % 4 == 0 ? frequent[0]
+                   : (i % 4 == 1 ? frequent[1] : gen() & ((1ULL << 40) - 1));
+    nOnes0 += key & 1;
+    nOnes01 += (key & 3) == 3;
+    nOnes39 += key >> 39;
+    counts.add(&key, 40);
+  }
+  EXPECT_EQ(200000, counts.total_shots());
+  EXPECT_FALSE(counts.is_exact());
+
+  // The frequent ones are tracked with a bounded error.
+  auto top = counts.top_k();
+  ASSERT_EQ(16, top.size());
+  std::string first(40, '0'), second(40, '0');
+  first[0] = first[1] = first[3] = '1';
+  second[39] = '1';
+  for (std::size_t i = 0; i < 2; i++) {
+    EXPECT_TRUE(top[i].bit_string == first || top[i].bit_string == second);
+    EXPECT_GE(top[i].count, 50000);
+    EXPECT_LE(top[i].count - top[i].max_error, 50000);
+  }
+  EXPECT_GE(counts.estimate(first), 50000);
+
+  // About 100000 distinct bit strings.
+  EXPECT_NEAR(100000, counts.distinct(), 5000);
+
+  // The requested marginals are exact.
+  auto m01 = counts.marginal({1, 0});
+  EXPECT_EQ(nOnes01, m01.count("11"));
+  EXPECT_EQ(nOnes0 - nOnes01, m01.count("10"));
+  EXPECT_EQ(nOnes39, counts.marginal({39}).count("1"));
+  EXPECT_THROW(counts.marginal({2}), std::runtime_error);
+
+  // Few distinct bit strings are counted exactly.
+  approximate_counts small(policy);
+  small.add(std::string(40, '0'), 3);
+  small.add(first, 2);
+  EXPECT_TRUE(small.is_exact());
+  EXPECT_EQ(2, small.estimate(first));
+  EXPECT_EQ(0, small.estimate(second));
+  EXPECT_EQ(2, small.distinct());
+  EXPECT_THROW(small.add("01"), std::runtime_error);
+}
+
+CUDAQ_TEST(MeasureCountsTester, checkMoveResults) {
+  // Moving hands over the counts, copying leaves the source intact.
+  ExecutionResult r{CountsDictionary{{"01", 10}, {"10", 30}}, "reg"};
+  sample_result copied(r);
+  EXPECT_EQ(2, r.counts.size());
+  sample_result moved(std::move(r));
+  EXPECT_EQ(30, moved.count("10", "reg"));
+  EXPECT_EQ(copied.to_map("reg"), moved.to_map("reg"));
+
+  // Extracting a register takes it out of the sample_result.
+  auto extracted = moved.extract_register("reg");
+  EXPECT_EQ("reg", extracted.registerName);
+  EXPECT_EQ(40, extracted.totalCount());
+  EXPECT_TRUE(moved.to_map("reg").empty());
+  EXPECT_EQ("missing", moved.extract_register("missing").registerName);
+
+  sample_result assigned;
+  assigned = std::move(copied);
+  EXPECT_EQ(10, assigned.count("01", "reg"));
+}
+
+CUDAQ_TEST(MeasureCountsTester, checkShotNoise) {
+  // H = 2 Z0 + 3 Z1 + 1, measured on the same 100 shots.
+  spin_op H = 2. * spin::z(0) + 3. * spin::z(1) + 1.;
+  // Terms are named by their Paulis on all qubits of H, e.g. "ZI".
+  spin_op Z0 = spin::z(0) * spin::i(1), Z1 = spin::i(0) * spin::z(1);
+  const auto z0 = Z0.to_string(false), z1 = Z1.to_string(false);
+
+  std::vector<ExecutionResult> results{
+      {CountsDictionary{{"0", 75}, {"1", 25}}, z0},
+      {CountsDictionary{{"0", 50}, {"1", 50}}, z1}};
+  observe_result r(1.0, H, sample_result(std::move(results)),
+                   {{z0, z1, .2}});
+
+  EXPECT_NEAR(.0075, r.variance(Z0), 1e-12);
+  EXPECT_NEAR(.01, r.variance(Z1), 1e-12);
+  EXPECT_NEAR(.002, r.covariance(Z1, Z0), 1e-12);
+  EXPECT_NEAR(4 * .0075 + 9 * .01 + 2 * 2 * 3 * .002, r.variance(), 1e-12);
+
+  // The shots go to the terms by |c| sqrt(1 - <P>^2).
+  auto shots = r.optimal_shots(1000);
+  std::size_t total = 0, zero = 0, one = 0;
+  for (std::size_t t = 0; auto term : H.terms()) {
+    total += shots[t];
+    if (term.is_identity())
+      EXPECT_EQ(0, shots[t]);
+    else
+      (term.to_string(false) == z0 ? zero : one) = shots[t];
+    t++;
+  }
+  EXPECT_EQ(1000, total);
+  EXPECT_NEAR(3. / (2. * std::sqrt(.75)), double(one) / zero, .01);
+
+  // Exact results have no shot noise.
+  double e = 1.0;
+  observe_result exact(e, H);
+  EXPECT_EQ(0., exact.variance());
+}
+
+CUDAQ_TEST(MeasureCountsTester, checkMidCircuitLog) {
+  // Each shot measures b0 into "a", b1 b2 into the vector register "v" and
+  // b3 into "a" again, as logged by a simulator executing once per shot.
+  auto shot = [](std::uint64_t record) {
+    sample_result result(ExecutionResult{CountsDictionary{{"0", 1}}});
+    MeasurementLog log;
+    log.append({{"a", {0, 3}, false}, {"v", {1, 2}, true}}, &record, 4);
+    result.append(std::move(log));
+    return result;
+  };
+  sample_result counts;
+  for (std::uint64_t record : {0b0110, 0b1011, 0b0110})
+    counts += shot(record);
+
+  auto names = counts.register_names();
+  std::sort(names.begin(), names.end());
+  EXPECT_EQ((std::vector<std::string>{"__global__", "a", "v"}), names);
+  EXPECT_EQ(3, counts.count("0"));
+
+  // Copies keep the unread registers.
+  sample_result copied = counts;
+  EXPECT_EQ(2, copied.count("11", "v"));
+  EXPECT_EQ(1, copied.count("10", "v"));
+
+  EXPECT_EQ((std::vector<std::string>{"11", "10", "11"}),
+            counts.sequential_data("v"));
+  EXPECT_EQ((std::vector<std::string>{"0", "0", "1", "1", "0", "0"}),
+            counts.sequential_data("a"));
+  EXPECT_EQ(4, counts.count("0", "a"));
+  EXPECT_TRUE(counts == copied);
+
+  // A register read on one side is merged with the log of the other.
+  auto more = shot(0b1111);
+  counts += more;
+  EXPECT_EQ(3, counts.count("11", "v"));
+  EXPECT_EQ(4, counts.count("1", "a"));
+}
+
+CUDAQ_TEST(MeasureCountsTester, checkPackedCountsOfStrings) {
+  sample_result result(
+      ExecutionResult{CountsDictionary{{"001", 3}, {"101", 5}}});
+  auto &packed = result.packed_counts();
+  EXPECT_EQ(3, packed.n_bits());
+  ASSERT_EQ(2, packed.size());
+  std::map<std::uint64_t, std::size_t> counts;
+  for (std::size_t i = 0; i < packed.size(); i++)
+    counts[packed.keys_data()[i]] = packed.counts_data()[i];
+  EXPECT_EQ(3, counts[0b100]);
+  EXPECT_EQ(5, counts[0b101]);
+  // Reading the counts as strings again still works.
+  EXPECT_EQ(5, result.to_map()["101"]);
+
+  sample_result mixed(ExecutionResult{CountsDictionary{{"0", 1}, {"11", 1}}});
+  EXPECT_ANY_THROW(mixed.packed_counts());
+  EXPECT_ANY_THROW(mixed.packed_counts("missing"));
+}
+
+CUDAQ_TEST(ResultCacheTester, checkStoreLoadExpire) {
+  auto dir = std::filesystem::temp_directory_path() /
+             ("cudaq_result_cache_" + std::to_string(std::random_device{}()));
+  ResultCache cache(dir, std::chrono::hours(1));
+
+  auto key = ResultCache::hashKey({"OPENQASM 2.0;", "1000", "quantinuum"});
+  EXPECT_EQ(32, key.size());
+  // Part boundaries are part of the key.
+  EXPECT_NE(key, ResultCache::hashKey({"OPENQASM 2.0;1000", "quantinuum"}));
+  EXPECT_FALSE(cache.load(key).has_value());
+
+  sample_result result(
+      ExecutionResult{CountsDictionary{{"00", 480}, {"11", 520}}});
+  cache.store(key, result);
+  auto loaded = cache.load(key);
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(480, loaded->count("00"));
+  EXPECT_EQ(520, loaded->count("11"));
+
+  // An expired entry is a miss, and is removed.
+  ResultCache expired(dir, std::chrono::seconds(0));
+  std::filesystem::last_write_time(
+      dir / (key + ".result"),
+      std::filesystem::file_time_type::clock::now() - std::chrono::seconds(5));
+  EXPECT_FALSE(expired.load(key).has_value());
+  EXPECT_FALSE(cache.load(key).has_value());
+  std::filesystem::remove_all(dir);
+}
@@ -8,6 +8,8 @@
 
 #include "CUDAQTestUtils.h"
 #include "common/MeasureCounts.h"
+#include "common/ReadoutMitigation.h"
+#include "common/ZeroNoiseExtrapolation.h"
 #include <fmt/core.h>
 
 using namespace cudaq;
@@ -73,3 +75,81 @@ CUDAQ_TEST(NoiseModelTester, checkConstruction) {
   // Can only add channels for ops we know about.
   EXPECT_ANY_THROW({ noise.add_channel("invalid_op", {0}, simpleChannel); });
 }
+
+CUDAQ_TEST(NoiseModelTester, checkNoiseTable) {
+  cudaq::noise_model noise;
+  noise.add_channel("x", {3}, cudaq::bit_flip_channel(0.1));
+  noise.add_channel("x", {3}, cudaq::phase_flip_channel(0.1));
+  noise.add_channel("h", {0}, cudaq::depolarization_channel(0.1));
+  noise.add_channel("x", {0, 1},
+                    cudaq::kraus_channel(std::vector<cudaq::kraus_op>{
+                        cudaq::kraus_op({1., 0., 0., 0., 0., 1., 0., 0., 0.,
+                                         0., 1., 0., 0., 0., 0., 1.})}));
+
+  // The table holds one value per entry, built from all its channels.
+  cudaq::noise_table<std::size_t> table(
+      noise, [](const std::string &, const std::vector<std::size_t> &qubits,
+                const std::vector<cudaq::kraus_channel> &channels) {
+        return 10 * qubits.size() + channels.size();
+      });
+  ASSERT_NE(table.find("x", {3}), nullptr);
+  EXPECT_EQ(*table.find("x", {3}), 12);
+  EXPECT_EQ(*table.find("h", {0}), 11);
+  EXPECT_EQ(*table.find("x", {0, 1}), 21);
+
+  EXPECT_EQ(table.find("x", {2}), nullptr);
+  EXPECT_EQ(table.find("x", {7}), nullptr);
+  EXPECT_EQ(table.find("y", {3}), nullptr);
+  EXPECT_EQ(table.find("x", {1, 0}), nullptr);
+  EXPECT_EQ(table.find("swap", {0, 1}), nullptr);
+  EXPECT_FALSE(cudaq::noise_model::op_index("swap").has_value());
+}
+
+CUDAQ_TEST(NoiseModelTester, checkReadoutMitigation) {
+  // The exact outcome is 11, read with these errors on both qubits.
+  cudaq::CountsDictionary counts{
+      {"11", 8100}, {"01", 900}, {"10", 900}, {"00", 100}};
+  cudaq::ExecutionResult execution(counts);
+  cudaq::sample_result result(execution);
+  EXPECT_NEAR(result.exp_val_z(), .64, 1e-12);
+
+  cudaq::noise_model noise;
+  noise.add_readout_error(0, .05, .1);
+  noise.add_readout_error(1, .05, .1);
+  auto mitigator = cudaq::readout_mitigator::from_noise_model(noise, 2);
+  auto quasi = mitigator.quasi_probabilities(result, {0, 1});
+  EXPECT_NEAR(quasi["11"], 1., 1e-8);
+  EXPECT_NEAR(quasi["00"], 0., 1e-8);
+  EXPECT_NEAR(mitigator.exp_val_z(result, {0, 1}), 1., 1e-8);
+
+  // Qubits without a confusion matrix read exactly.
+  EXPECT_NEAR(mitigator.exp_val_z(result, {5, 6}), .64, 1e-8);
+  EXPECT_ANY_THROW(cudaq::readout_mitigator({{.5, .6, 0., 1.}}));
+}
+
+CUDAQ_TEST(NoiseModelTester, checkZeroNoiseExtrapolation) {
+  using cudaq::zne_extrapolation;
+  // Richardson extrapolation is exact for polynomials of lower degree.
+  std::vector<double> scales{1., 3., 5.};
+  std::vector<double> quadratic;
+  for (auto s : scales)
+    quadratic.push_back(.9 - .1 * s + .01 * s * s);
+  EXPECT_NEAR(cudaq::extrapolate_to_zero_noise(scales, quadratic,
+                                               zne_extrapolation::richardson),
+              .9, 1e-12);
+
+  // Exponential extrapolation is exact for a decay to the asymptote.
+  std::vector<double> decay;
+  for (auto s : scales)
+    decay.push_back(-1. - .7 * std::exp(-.2 * s));
+  EXPECT_NEAR(cudaq::extrapolate_to_zero_noise(
+                  scales, decay, zne_extrapolation::exponential, -1.),
+              -1.7, 1e-12);
+
+  EXPECT_ANY_THROW(cudaq::extrapolate_to_zero_noise(
+      {1.}, {.5}, zne_extrapolation::richardson));
+  EXPECT_ANY_THROW(cudaq::extrapolate_to_zero_noise(
+      {1., 1.}, {.5, .4}, zne_extrapolation::richardson));
+  EXPECT_ANY_THROW(cudaq::extrapolate_to_zero_noise(
+      {1., 3.}, {.5, -.1}, zne_extrapolation::exponential));
+}
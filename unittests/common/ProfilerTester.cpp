@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CUDAQTestUtils.h"
+#include "common/Profiler.h"
+#include <cudaq/algorithm.h>
+#include <cudaq/builder.h>
+#include <set>
+#include <sstream>
+#include <thread>
+
+using namespace cudaq;
+
+#ifndef CUDAQ_NO_TRACE
+CUDAQ_TEST(ProfilerTester, checkRingBuffer) {
+  profiler::enable(4);
+  for (int i = 0; i < 10; i++)
+    profiler::ScopedEvent event("event", profiler::Category::gate);
+  profiler::disable();
+  { profiler::ScopedEvent event("disabled", profiler::Category::gate); }
+
+  // Only the last 4 events of the thread are kept.
+  auto events = profiler::getEvents();
+  EXPECT_EQ(events.size(), 4);
+  for (std::size_t i = 1; i < events.size(); i++)
+    EXPECT_LE(events[i - 1].end, events[i].start);
+
+  profiler::clear();
+  EXPECT_TRUE(profiler::getEvents().empty());
+}
+
+CUDAQ_TEST(ProfilerTester, checkTracks) {
+  profiler::enable();
+  {
+    profiler::ScopedEvent outer("outer", profiler::Category::launch);
+    profiler::ScopedEvent inner("inner", profiler::Category::gate);
+  }
+  std::thread([]() {
+    profiler::ScopedQPU qpu(1);
+    profiler::ScopedEvent event("qpu", profiler::Category::sampling);
+  }).join();
+  profiler::disable();
+
+  auto events = profiler::getEvents();
+  ASSERT_EQ(events.size(), 3);
+  EXPECT_EQ(std::string(events[0].name), "outer");
+  EXPECT_EQ(std::string(events[1].name), "inner");
+  EXPECT_EQ(events[0].qpu, -1);
+  EXPECT_EQ(events[2].qpu, 1);
+  EXPECT_NE(events[0].thread, events[2].thread);
+
+  std::stringstream chrome;
+  profiler::writeChromeTrace(chrome);
+  EXPECT_NE(chrome.str().find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(chrome.str().find("\"QPU 1\""), std::string::npos);
+
+  // The inner event is a child span of the outer one, the first span.
+  std::stringstream otlp;
+  profiler::writeOpenTelemetry(otlp);
+  EXPECT_NE(otlp.str().find("\"parentSpanId\":\"0000000000000001\""),
+            std::string::npos);
+  profiler::clear();
+}
+
+CUDAQ_TEST(ProfilerTester, checkKernelLaunch) {
+  auto kernel = cudaq::make_kernel();
+  auto q = kernel.qalloc(2);
+  kernel.h(q[0]);
+  kernel.x<cudaq::ctrl>(q[0], q[1]);
+  kernel.mz(q);
+
+  profiler::enable();
+  cudaq::sample(kernel);
+  profiler::disable();
+
+  std::set<profiler::Category> categories;
+  for (auto &event : profiler::getEvents())
+    categories.insert(event.category);
+  EXPECT_TRUE(categories.count(profiler::Category::jit));
+  EXPECT_TRUE(categories.count(profiler::Category::launch));
+  EXPECT_TRUE(categories.count(profiler::Category::gate));
+  EXPECT_TRUE(categories.count(profiler::Category::sampling));
+  profiler::clear();
+}
+#endif
@@ -0,0 +1,98 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CUDAQTestUtils.h"
+#include "cudaq/platform/QuantumExecutionQueue.h"
+
+CUDAQ_TEST(QuantumExecutionQueueTester, checkPriorityThenFifo) {
+  cudaq::QuantumExecutionQueue queue;
+  std::promise<void> started, release;
+  auto released = release.get_future().share();
+  std::vector<int> order;
+  std::mutex orderLock;
+
+  // Block the single worker so that the next tasks are queued together.
+  cudaq::QuantumTask blocker = [&, released]() {
+    started.set_value();
+    released.wait();
+  };
+  queue.enqueue(blocker);
+  started.get_future().wait();
+
+  std::promise<void> done;
+  auto finished = done.get_future();
+  for (auto [id, priority] : std::vector<std::pair<int, int>>{
+           {0, 0}, {1, 5}, {2, 0}, {3, 5}, {4, -1}}) {
+    cudaq::QuantumTask task = [&, id = id]() {
+      std::lock_guard<std::mutex> l(orderLock);
+      order.push_back(id);
+      if (order.size() == 5)
+        done.set_value();
+    };
+    queue.enqueue(task, {priority, ""});
+  }
+  release.set_value();
+  finished.wait();
+  EXPECT_EQ(order, (std::vector<int>{1, 3, 0, 2, 4}));
+}
+
+CUDAQ_TEST(QuantumExecutionQueueTester, checkWorkersAndBatches) {
+  cudaq::QuantumExecutionQueue queue(4);
+  EXPECT_EQ(queue.getNumWorkers(), 4);
+
+  // Four tasks that wait for each other only finish on four workers.
+  std::atomic<int> arrived = 0;
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < 4; i++) {
+    auto promise = std::make_shared<std::promise<void>>();
+    futures.push_back(promise->get_future());
+    cudaq::QuantumTask task = [&arrived, promise]() {
+      arrived++;
+      while (arrived < 4)
+        std::this_thread::yield();
+      promise->set_value();
+    };
+    queue.enqueue(task);
+  }
+  for (auto &f : futures)
+    f.wait();
+
+  queue.setNumWorkers(1);
+  EXPECT_EQ(queue.getNumWorkers(), 1);
+  std::promise<void> started, release;
+  auto released = release.get_future().share();
+  cudaq::QuantumTask blocker = [&, released]() {
+    started.set_value();
+    released.wait();
+  };
+  queue.enqueue(blocker);
+  started.get_future().wait();
+
+  // The queued tasks of a batch key run in batches of at most two.
+  std::vector<std::size_t> batchSizes;
+  std::promise<void> done;
+  queue.setBatchHandler(
+      "key",
+      [&](std::vector<cudaq::QuantumTask> &batch) {
+        batchSizes.push_back(batch.size());
+        for (auto &task : batch)
+          task();
+      },
+      2);
+  int ran = 0;
+  for (int i = 0; i < 3; i++) {
+    cudaq::QuantumTask task = [&]() {
+      if (++ran == 3)
+        done.set_value();
+    };
+    queue.enqueue(task, {0, "key"});
+  }
+  release.set_value();
+  done.get_future().wait();
+  EXPECT_EQ(batchSizes, (std::vector<std::size_t>{2, 1}));
+}
@@ -0,0 +1,53 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CUDAQTestUtils.h"
+#include "common/QuditIdTracker.h"
+
+CUDAQ_TEST(QuditIdTrackerTester, checkSmallestIndexFirst) {
+  cudaq::QuditIdTracker tracker;
+  EXPECT_EQ(tracker.totalNumQudits(), 30);
+  EXPECT_EQ(tracker.numAvailable(), 30);
+
+  std::vector<std::size_t> indices;
+  for (std::size_t i = 0; i < 5; i++)
+    indices.push_back(tracker.getNextIndex());
+  EXPECT_EQ(indices, (std::vector<std::size_t>{0, 1, 2, 3, 4}));
+  EXPECT_FALSE(tracker.isAvailable(3));
+  EXPECT_TRUE(tracker.isAvailable(5));
+
+  // Returned indices are handed out again smallest first.
+  tracker.returnIndex(3);
+  tracker.returnIndex(1);
+  EXPECT_TRUE(tracker.isAvailable(3));
+  EXPECT_EQ(tracker.numAvailable(), 27);
+  EXPECT_EQ(tracker.getNextIndex(), 1);
+  EXPECT_EQ(tracker.getNextIndex(), 3);
+  EXPECT_EQ(tracker.getNextIndex(), 5);
+
+  // Returning an index twice does not hand it out twice.
+  tracker.returnIndex(0);
+  tracker.returnIndex(0);
+  EXPECT_EQ(tracker.getNextIndex(), 0);
+  EXPECT_EQ(tracker.getNextIndex(), 6);
+}
+
+CUDAQ_TEST(QuditIdTrackerTester, checkGrowth) {
+  cudaq::QuditIdTracker tracker;
+  for (std::size_t i = 0; i < 40; i++)
+    EXPECT_EQ(tracker.getNextIndex(), i);
+  EXPECT_EQ(tracker.totalNumQudits(), 40);
+  EXPECT_EQ(tracker.numAvailable(), 0);
+
+  tracker.returnIndex(35);
+  tracker.returnIndex(10);
+  EXPECT_EQ(tracker.numAvailable(), 2);
+  EXPECT_EQ(tracker.getNextIndex(), 10);
+  EXPECT_EQ(tracker.getNextIndex(), 35);
+  EXPECT_EQ(tracker.getNextIndex(), 40);
+}
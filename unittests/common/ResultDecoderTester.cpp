@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CUDAQTestUtils.h"
+#include "common/ResultDecoder.h"
+
+using namespace cudaq;
+
+CUDAQ_TEST(ResultDecoderTester, checkStreamedCounts) {
+  const std::string text = R"({
+    "status": "completed", "shots": [1, 2.5, null, true],
+    "results": [{"counts": {"00": 40, "11": "60"}, "name": "a"},
+                {"counts": {"01": 3}, "meta": {"counts": 2}}]
+  })";
+  std::vector<CountsDictionary> counts;
+  auto response = decodeJobResponse(text, "counts", counts);
+
+  ASSERT_EQ(counts.size(), 2);
+  EXPECT_EQ(counts[0], (CountsDictionary{{"00", 40}, {"11", 60}}));
+  EXPECT_EQ(counts[1], (CountsDictionary{{"01", 3}}));
+
+  // The rest of the response is parsed as usual, the counts are left out.
+  EXPECT_EQ(response["status"], "completed");
+  EXPECT_EQ(response["shots"], nlohmann::json::parse("[1, 2.5, null, true]"));
+  EXPECT_EQ(response["results"][0]["name"], "a");
+  EXPECT_TRUE(response["results"][0]["counts"].empty());
+  EXPECT_EQ(response["results"][1]["meta"]["counts"], 2);
+
+  // Without counts objects, the DOM is the parsed response.
+  auto plain = decodeJobResponse(text, "histogram", counts);
+  EXPECT_EQ(plain, nlohmann::json::parse(text));
+  EXPECT_EQ(counts.size(), 2);
+}
+
+CUDAQ_TEST(ResultDecoderTester, checkInvalidCounts) {
+  std::vector<CountsDictionary> counts;
+  EXPECT_ANY_THROW(decodeJobResponse(R"({"counts": {"0": -1}})", "counts",
+                                     counts));
+  EXPECT_ANY_THROW(decodeJobResponse(R"({"counts": {"0": 1.5}})", "counts",
+                                     counts));
+  EXPECT_ANY_THROW(decodeJobResponse(R"({"counts": {"0": "x"}})", "counts",
+                                     counts));
+  EXPECT_ANY_THROW(decodeJobResponse(R"({"counts": {"0": 1})", "counts",
+                                     counts));
+}
+
+CUDAQ_TEST(ResultDecoderTester, checkGzipCompression) {
+  if (!isGzipAvailable()) {
+    EXPECT_ANY_THROW(gzipCompress("{}"));
+    return;
+  }
+  std::string text;
+  for (int i = 0; i < 1000; i++)
+    text += R"({"gate": "h", "qubits": [0]},)";
+  auto compressed = gzipCompress(text);
+  ASSERT_GT(compressed.size(), 2);
+  EXPECT_EQ(static_cast<unsigned char>(compressed[0]), 0x1f);
+  EXPECT_EQ(static_cast<unsigned char>(compressed[1]), 0x8b);
+  EXPECT_LT(compressed.size(), text.size() / 10);
+}
@@ -0,0 +1,63 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CUDAQTestUtils.h"
+#include "common/SharedBuffer.h"
+#include <cstring>
+
+using namespace cudaq;
+
+CUDAQ_TEST(SharedBufferTester, checkOpenByName) {
+  auto created = SharedBuffer::create(64);
+  EXPECT_GE(created->size(), 64);
+  std::strcpy(created->data(), "arguments");
+
+  // Another mapping of the same name sees the data, and writes to it are
+  // seen by the creator.
+  auto opened = SharedBuffer::open(created->getName());
+  EXPECT_EQ(opened->size(), created->size());
+  EXPECT_STREQ(opened->data(), "arguments");
+  std::strcpy(opened->data(), "results");
+  EXPECT_STREQ(created->data(), "results");
+}
+
+CUDAQ_TEST(SharedBufferTester, checkGrowth) {
+  auto created = SharedBuffer::create(16);
+  auto opened = SharedBuffer::open(created->getName());
+  std::strcpy(created->data(), "kept");
+
+  // The buffer grows geometrically, and only when needed.
+  const auto initialSize = created->size();
+  created->reserve(initialSize);
+  EXPECT_EQ(created->size(), initialSize);
+  created->reserve(initialSize + 1);
+  EXPECT_EQ(created->size(), 2 * initialSize);
+
+  // Growing it from the other side remaps it here on the next access, with
+  // the data kept.
+  opened->reserve(1 << 16);
+  EXPECT_GE(opened->size(), 1 << 16);
+  opened->data()[(1 << 16) - 1] = 'x';
+  EXPECT_STREQ(created->data(), "kept");
+  EXPECT_EQ(created->size(), opened->size());
+  EXPECT_EQ(created->data()[(1 << 16) - 1], 'x');
+}
+
+CUDAQ_TEST(SharedBufferTester, checkUnavailable) {
+  // The creator removes the name, it can no longer be opened, as when qpud
+  // cannot attach the buffer of a client.
+  std::string name;
+  {
+    auto created = SharedBuffer::create(16);
+    name = created->getName();
+    auto opened = SharedBuffer::open(name);
+  }
+  EXPECT_THROW(SharedBuffer::open(name), std::runtime_error);
+  EXPECT_THROW(SharedBuffer::open("/cudaq-no-such-buffer"),
+               std::runtime_error);
+}
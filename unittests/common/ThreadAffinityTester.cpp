@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CUDAQTestUtils.h"
+#include "common/ThreadAffinity.h"
+#include <cstdlib>
+#include <set>
+#include <thread>
+
+using namespace cudaq;
+
+CUDAQ_TEST(ThreadAffinityTester, checkCorePartitions) {
+  auto &cores = getCoresByNumaNode();
+  ASSERT_FALSE(cores.empty());
+  EXPECT_EQ(std::set<int>(cores.begin(), cores.end()).size(), cores.size());
+
+  // Contiguous partitions covering every core once.
+  for (std::size_t numParts = 1; numParts <= cores.size(); numParts *= 2) {
+    std::vector<int> all;
+    for (std::size_t part = 0; part < numParts; part++) {
+      auto partition = getCorePartition(part, numParts);
+      EXPECT_FALSE(partition.empty());
+      all.insert(all.end(), partition.begin(), partition.end());
+    }
+    EXPECT_EQ(all, cores);
+  }
+
+  // More partitions than cores share them, one core each.
+  EXPECT_EQ(getCorePartition(cores.size(), cores.size() + 1),
+            std::vector<int>{cores[0]});
+}
+
+CUDAQ_TEST(ThreadAffinityTester, checkThreadBudget) {
+  setSimulatorThreadBudget(3);
+  EXPECT_EQ(getSimulatorThreadBudget(), 3);
+  // The budget belongs to the calling thread.
+  std::thread([]() { EXPECT_NE(getSimulatorThreadBudget(), 3); }).join();
+  setSimulatorThreadBudget(0);
+
+#ifdef __linux__
+  std::thread([]() {
+    EXPECT_TRUE(pinCallingThread({getCoresByNumaNode().back()}));
+  }).join();
+#endif
+}
+
+CUDAQ_TEST(ThreadAffinityTester, checkLargeBufferAdvice) {
+  // The advice only applies to pages not written yet, and keeps the data.
+  const std::size_t count = 2 * hugePageSize / sizeof(double);
+  auto *data = static_cast<double *>(
+      std::aligned_alloc(hugePageSize, count * sizeof(double)));
+  ASSERT_NE(data, nullptr);
+  adviseLargeBuffer(data, count * sizeof(double));
+  for (std::size_t i = 0; i < count; i++)
+    data[i] = i;
+  adviseLargeBuffer(data + 1, count * sizeof(double) - 16);
+  for (std::size_t i = 0; i < count; i++)
+    ASSERT_EQ(data[i], i);
+  std::free(data);
+}
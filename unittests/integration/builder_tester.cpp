@@ -11,6 +11,7 @@
 #include <cudaq/algorithms/gradients/central_difference.h>
 #include <cudaq/builder.h>
 #include <cudaq/optimizers.h>
+#include <thread>
 
 CUDAQ_TEST(BuilderTester, checkSimple) {
   {
@@ -324,3 +325,218 @@ CUDAQ_TEST(BuilderTester, checkKernelAdjoint) {
   EXPECT_EQ(counts.size(), 1);
   EXPECT_EQ(counts.begin()->first, "1");
 }
+
+CUDAQ_TEST(BuilderTester, checkIdenticalKernelsShareJit) {
+  // Builders of the same code share one JIT compiled kernel, while it is in
+  // use by the first one and after it is gone.
+  for (int i = 0; i < 3; i++) {
+    auto kernel = cudaq::make_kernel();
+    auto q = kernel.qalloc(2);
+    kernel.h(q[0]);
+    kernel.x<cudaq::ctrl>(q[0], q[1]);
+    kernel.mz(q);
+
+    auto copy = cudaq::make_kernel();
+    auto r = copy.qalloc(2);
+    copy.h(r[0]);
+    copy.x<cudaq::ctrl>(r[0], r[1]);
+    copy.mz(r);
+
+    for (auto *builder : {&kernel, &copy}) {
+      auto counts = cudaq::sample(*builder);
+      EXPECT_EQ(counts.size(), 2);
+      for (auto &[bits, count] : counts)
+        EXPECT_TRUE(bits == "00" || bits == "11");
+    }
+  }
+}
+
+CUDAQ_TEST(BuilderTester, checkInvokeDoubles) {
+  auto [kernel, theta, phi] = cudaq::make_kernel<double, double>();
+  auto q = kernel.qalloc(2);
+  kernel.rx(theta, q[0]);
+  kernel.rx(phi, q[1]);
+  kernel.mz(q);
+  EXPECT_TRUE(kernel.allArgsAreDouble());
+
+  auto &platform = cudaq::get_platform();
+  for (auto [angles, expected] :
+       {std::pair{std::vector<double>{M_PI, 0.}, "10"},
+        std::pair{std::vector<double>{0., M_PI}, "01"}}) {
+    cudaq::ExecutionContext context("sample", 100);
+    platform.set_exec_ctx(&context);
+    kernel.invoke(angles);
+    platform.reset_exec_ctx();
+    EXPECT_EQ(context.result.size(), 1);
+    EXPECT_EQ(context.result.begin()->first, expected);
+  }
+
+  std::vector<double> tooFew{M_PI};
+  EXPECT_THROW(kernel.invoke(tooFew), std::runtime_error);
+
+  auto [vecKernel, params] = cudaq::make_kernel<std::vector<double>>();
+  EXPECT_FALSE(vecKernel.allArgsAreDouble());
+}
+
+CUDAQ_TEST(BuilderTester, checkPrecompile) {
+  std::vector<cudaq::kernel_builder<>> kernels;
+  kernels.reserve(4);
+  for (std::size_t n = 1; n <= 4; n++) {
+    auto &kernel = kernels.emplace_back(cudaq::make_kernel());
+    auto q = kernel.qalloc(n);
+    for (std::size_t i = 0; i < n; i++)
+      kernel.x(q[i]);
+    kernel.mz(q);
+  }
+  std::vector<cudaq::details::kernel_builder_base *> builders;
+  for (auto &kernel : kernels)
+    builders.push_back(&kernel);
+  cudaq::precompile(builders);
+  cudaq::precompile(kernels[0], kernels[1]);
+
+  for (std::size_t n = 1; n <= 4; n++) {
+    auto counts = cudaq::sample(kernels[n - 1]);
+    EXPECT_EQ(counts.size(), 1);
+    EXPECT_EQ(counts.begin()->first, std::string(n, '1'));
+  }
+}
+
+CUDAQ_TEST(BuilderTester, checkApplyGates) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+
+  // The ansatz of checkSimple, with the angle of ry scaled by thetas[0].
+  auto [ansatz, thetas] = cudaq::make_kernel<std::vector<double>>();
+  auto q = ansatz.qalloc(2);
+  using gate = cudaq::gate_instruction;
+  std::vector<gate> gates{{gate::x, 0},
+                          {gate::ry, 1, -1, 0.5, 0},
+                          {gate::x, 0, /*control=*/1}};
+  ansatz.apply_gates(q, gates, thetas);
+
+  double exp = cudaq::observe(ansatz, h, std::vector<double>{2 * .59});
+  EXPECT_NEAR(exp, -1.748795, 1e-2);
+
+  std::vector<gate> outOfRange{{gate::h, 2}};
+  EXPECT_THROW(ansatz.apply_gates(q, outOfRange), std::runtime_error);
+  std::vector<gate> noParameters{{gate::rx, 0, -1, 0.5, 0}};
+  EXPECT_THROW(ansatz.apply_gates(q, noParameters), std::runtime_error);
+}
+
+CUDAQ_TEST(BuilderTester, checkForLoop) {
+  // A GHZ state on more qubits than the loop unrolling threshold, so that
+  // the CNOT chain stays a loop.
+  const std::size_t n = 60;
+  auto kernel = cudaq::make_kernel();
+  auto q = kernel.qalloc(n);
+  kernel.h(q[0]);
+  kernel.for_loop(0, n - 1, [&](cudaq::QuakeValue &i) {
+    kernel.x<cudaq::ctrl>(q[i], q[i + 1]);
+  });
+  kernel.mz(q);
+  EXPECT_NE(kernel.to_quake().find("cc.loop"), std::string::npos);
+
+  auto counts = cudaq::sample(kernel);
+  EXPECT_EQ(counts.size(), 2);
+  EXPECT_EQ(counts.count(std::string(n, '0')) +
+                counts.count(std::string(n, '1')),
+            1000);
+
+  // A loop bounded by an argument.
+  auto [flips, count] = cudaq::make_kernel<int>();
+  auto r = flips.qalloc(3);
+  flips.for_loop(0, count, [&](cudaq::QuakeValue &i) { flips.x(r[i]); });
+  flips.mz(r);
+  auto flipped = cudaq::sample(flips, 2);
+  EXPECT_EQ(flipped.size(), 1);
+  EXPECT_EQ(flipped.begin()->first, "110");
+}
+
+CUDAQ_TEST(BuilderTester, checkQpuStatistics) {
+  auto &platform = cudaq::get_platform();
+  platform.reset_qpu_statistics();
+  EXPECT_EQ(platform.get_qpu_statistics().launches, 0);
+
+  auto kernel = cudaq::make_kernel();
+  auto q = kernel.qalloc(2);
+  kernel.h(q[0]);
+  kernel.x<cudaq::ctrl>(q[0], q[1]);
+  kernel.mz(q);
+  kernel();
+  kernel();
+
+  auto statistics = platform.get_qpu_statistics();
+  EXPECT_EQ(statistics.launches, 2);
+  EXPECT_GT(statistics.busy_seconds, 0.0);
+
+  platform.reset_qpu_statistics();
+  EXPECT_EQ(platform.get_qpu_statistics().launches, 0);
+  EXPECT_EQ(platform.get_qpu_statistics().busy_seconds, 0.0);
+}
+
+CUDAQ_TEST(BuilderTester, checkConcurrentShots) {
+  auto kernel = cudaq::make_kernel();
+  auto q = kernel.qalloc(2);
+  kernel.h(q[0]);
+  auto mres = kernel.mz(q[0], "res0");
+  kernel.c_if(mres, [&]() { kernel.x(q[1]); });
+  kernel.mz(q);
+
+  auto &platform = cudaq::get_platform();
+  for (std::size_t threads : {1, 4}) {
+    platform.set_num_shot_threads(threads);
+    auto counts = cudaq::sample(1000, kernel);
+    EXPECT_EQ(counts.count("00") + counts.count("11"), 1000);
+    EXPECT_GT(counts.count("00"), 0);
+    EXPECT_GT(counts.count("11"), 0);
+    EXPECT_EQ(counts.get_counters().kernel_executions, 1000);
+
+    // Seeded shots differ from each other, and the seeded result does not
+    // depend on the scheduling of the threads.
+    platform.set_random_seed(13);
+    auto first = cudaq::sample(1000, kernel);
+    platform.set_random_seed(13);
+    auto second = cudaq::sample(1000, kernel);
+    EXPECT_GT(first.count("00"), 0);
+    EXPECT_GT(first.count("11"), 0);
+    EXPECT_EQ(first.count("00"), second.count("00"));
+  }
+  platform.set_num_shot_threads(std::thread::hardware_concurrency());
+}
+
+CUDAQ_TEST(BuilderTester, checkObserveCacheAfterMutation) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = z(0);
+  auto [kernel, theta] = cudaq::make_kernel<double>();
+  auto q = kernel.qalloc();
+  kernel.ry(theta, q);
+
+  auto &cache = cudaq::details::getObserveCache();
+  cudaq::set_observe_cache_capacity(4);
+  EXPECT_NEAR(cudaq::observe(kernel, h, .5), std::cos(.5), 1e-9);
+  EXPECT_NEAR(cudaq::observe(kernel, h, .5), std::cos(.5), 1e-9);
+  EXPECT_EQ(cache.hits(), 1);
+
+  // Extending the builder changes its Quake code, so the earlier result of
+  // the same builder object and arguments is not reused.
+  kernel.x(q);
+  EXPECT_NEAR(cudaq::observe(kernel, h, .5), -std::cos(.5), 1e-9);
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_NEAR(cudaq::observe(kernel, h, .5), -std::cos(.5), 1e-9);
+  EXPECT_EQ(cache.hits(), 2);
+
+  // Kernels with other state, like a lambda capturing by reference, are
+  // never memoized.
+  double angle = .5;
+  auto lambda = [&]() __qpu__ {
+    cudaq::qubit r;
+    ry(angle, r);
+  };
+  EXPECT_NEAR(cudaq::observe(lambda, h), std::cos(.5), 1e-9);
+  angle = 1.;
+  EXPECT_NEAR(cudaq::observe(lambda, h), std::cos(1.), 1e-9);
+  EXPECT_EQ(cache.hits(), 2);
+  cudaq::set_observe_cache_capacity(0);
+  cudaq::clear_observe_cache();
+}
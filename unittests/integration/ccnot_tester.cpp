@@ -79,3 +79,30 @@ CUDAQ_TEST(CCNOTTester, checkSimple) {
   EXPECT_EQ(1, counts3.size());
   EXPECT_TRUE(counts3.begin()->first == "101");
 }
+
+// Only the action of a controlled compute_action is controlled.
+struct controlled_compute_action {
+  void operator()(bool control) __qpu__ {
+    cudaq::qreg q(3);
+    if (control)
+      x(q[0]);
+
+    auto flip = [&](cudaq::qubit &r) {
+      cudaq::compute_action([&]() { x(q[1]); },
+                            [&]() { x<cudaq::ctrl>(q[1], r); });
+    };
+    cudaq::control(flip, q[0], q[2]);
+
+    mz(q);
+  }
+};
+
+CUDAQ_TEST(CCNOTTester, checkControlledComputeAction) {
+  auto counts = cudaq::sample(controlled_compute_action{}, true);
+  EXPECT_EQ(1, counts.size());
+  EXPECT_TRUE(counts.begin()->first == "101");
+
+  auto counts2 = cudaq::sample(controlled_compute_action{}, false);
+  EXPECT_EQ(1, counts2.size());
+  EXPECT_TRUE(counts2.begin()->first == "000");
+}
@@ -0,0 +1,42 @@
+/*******************************************************************************
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "CUDAQTestUtils.h"
+#include <cudaq/algorithm.h>
+#include <cudaq/algorithms/cutting.h>
+
+CUDAQ_TEST(CuttingTester, checkWireCuts) {
+  // Two blocks of four qubits, entangled by a single gate.
+  cudaq::cut_circuit circuit{8, {}};
+  for (std::size_t q = 0; q < 8; q++)
+    circuit.gates.push_back({"ry", {0.3 + 0.2 * q}, {}, {q}});
+  for (std::size_t q = 0; q + 1 < 8; q++)
+    if (q != 3)
+      circuit.gates.push_back({"x", {}, {q}, {q + 1}});
+  circuit.gates.push_back({"z", {}, {3}, {4}});
+  for (std::size_t q = 0; q < 8; q++)
+    circuit.gates.push_back({"rx", {0.1 * q}, {}, {q}});
+
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 0.5 * z(0) * z(7) + 1.3 * x(3) * x(4) - 0.7 * z(2) +
+                     0.25 * y(5) * x(1) + 0.1 * i(7);
+
+  // Without cuts, the circuit is simulated at once.
+  auto exact = cudaq::observe_cut(circuit, h, {.max_fragment_qubits = 8});
+  auto plan = cudaq::details::planWireCuts(circuit, 4);
+  // The entangling gate moves into a fragment of its own.
+  EXPECT_EQ(plan.num_cuts, 2);
+  EXPECT_EQ(plan.fragments.size(), 3);
+  for (auto &fragment : plan.fragments)
+    EXPECT_LE(fragment.num_qubits, 4);
+  EXPECT_NEAR(cudaq::observe_cut(circuit, h, {.max_fragment_qubits = 4}),
+              exact, 1e-8);
+
+  EXPECT_ANY_THROW(cudaq::observe_cut(
+      circuit, h, {.max_fragment_qubits = 2, .max_cuts = 1}));
+}
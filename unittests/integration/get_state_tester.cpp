@@ -68,3 +68,51 @@ CUDAQ_TEST(GetStateTester, checkSimple) {
 
   EXPECT_NEAR(opt_val, 0.0, 1e-3);
 }
+
+CUDAQ_TEST(GetStateTester, checkOverlap) {
+  auto kernel = [](double angle) __qpu__ {
+    cudaq::qubit q, r;
+    ry(angle, q);
+    cx(q, r);
+  };
+  auto bell = []() __qpu__ {
+    cudaq::qubit q, r;
+    h(q);
+    cx(q, r);
+  };
+
+  // <a|b> = cos((a - b) / 2), the overlap of density matrices is its square.
+  auto overlap = cudaq::overlap(kernel, std::make_tuple(0.9), kernel,
+                                std::make_tuple(0.3));
+#ifdef CUDAQ_BACKEND_DM
+  EXPECT_NEAR(std::pow(std::cos(0.3), 2), overlap.real(), 1e-6);
+#else
+  EXPECT_NEAR(std::cos(0.3), overlap.real(), 1e-6);
+#endif
+  EXPECT_NEAR(0., overlap.imag(), 1e-6);
+  EXPECT_NEAR(1., std::abs(cudaq::overlap(bell, bell)), 1e-6);
+}
+
+CUDAQ_TEST(GetStateTester, checkAmplitudesAndProbabilities) {
+  // cos(a / 2) |000> + sin(a / 2) |101>
+  auto kernel = [](double angle) __qpu__ {
+    cudaq::qreg q(3);
+    ry(angle, q[0]);
+    x<cudaq::ctrl>(q[0], q[2]);
+  };
+
+  auto probabilities = cudaq::get_probabilities(kernel, {2, 1}, 0.8);
+  ASSERT_EQ(probabilities.size(), 4);
+  EXPECT_NEAR(std::pow(std::cos(0.4), 2), probabilities[0], 1e-6);
+  EXPECT_NEAR(std::pow(std::sin(0.4), 2), probabilities[1], 1e-6);
+  EXPECT_NEAR(0., probabilities[2] + probabilities[3], 1e-6);
+  EXPECT_ANY_THROW(cudaq::get_probabilities(kernel, {0, 3}, 0.8));
+
+#ifndef CUDAQ_BACKEND_DM
+  auto amplitudes = cudaq::get_amplitudes(kernel, {0, 5, 2}, 0.8);
+  ASSERT_EQ(amplitudes.size(), 3);
+  EXPECT_NEAR(std::cos(0.4), amplitudes[0].real(), 1e-6);
+  EXPECT_NEAR(std::sin(0.4), amplitudes[1].real(), 1e-6);
+  EXPECT_NEAR(0., std::abs(amplitudes[2]), 1e-6);
+#endif
+}
@@ -40,3 +40,21 @@ CUDAQ_TEST(GHZSampleTester, checkSimple) {
   EXPECT_EQ(counter, 1000);
   printf("Exp: %lf\n", counts.exp_val_z());
 }
+
+CUDAQ_TEST(GHZSampleTester, checkExecutionCounters) {
+  auto counts = cudaq::sample(ghz{}, 5);
+  auto &counters = counts.get_counters();
+  EXPECT_EQ(counters.kernel_executions, 1);
+  EXPECT_EQ(counters.gates, 5);
+  EXPECT_GE(counters.state_sweeps, 1);
+  EXPECT_LE(counters.state_sweeps, counters.gates);
+  EXPECT_GT(counters.peak_state_bytes, 0);
+  EXPECT_GT(counters.simulator_seconds, 0.0);
+  EXPECT_GE(counters.host_seconds, 0.0);
+
+  // Merged results sum the counters of their executions.
+  auto more = cudaq::sample(ghz{}, 5);
+  counts += more;
+  EXPECT_EQ(counts.get_counters().kernel_executions, 2);
+  EXPECT_EQ(counts.get_counters().gates, 10);
+}
@@ -8,7 +8,9 @@
 
 #include "CUDAQTestUtils.h"
 #include <cudaq/algorithm.h>
+#include <cudaq/algorithms/gradients/adjoint.h>
 #include <cudaq/algorithms/gradients/central_difference.h>
+#include <cudaq/algorithms/gradients/parameter_shift.h>
 #include <cudaq/optimizers.h>
 
 #ifndef CUDAQ_BACKEND_DM
@@ -78,4 +80,28 @@ CUDAQ_TEST(GradientTester, checkSimple) {
   EXPECT_NEAR(-2.0453, opt_val, 1e-2);
 }
 
+#ifdef CUDAQ_BACKEND_ADJOINT
+CUDAQ_TEST(GradientTester, checkAdjoint) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1) + 9.625 - 9.625 * z(2) -
+                     3.913119 * x(1) * x(2) - 3.913119 * y(1) * y(2);
+  auto argsMapper = [](std::vector<double> x) {
+    return std::make_tuple(x[0], x[1]);
+  };
+  deuteron_n3_ansatz ansatz;
+  cudaq::gradients::adjoint adjoint(ansatz, argsMapper);
+  cudaq::gradients::parameter_shift shift(ansatz, argsMapper);
+
+  // x0 enters two gates, with opposite signs.
+  const std::vector<double> x{0.4, -0.9};
+  std::vector<double> adjointDx(2), shiftDx(2);
+  double e = cudaq::observe(ansatz, h, x[0], x[1]);
+  adjoint.compute(x, adjointDx, h, e);
+  shift.compute(x, shiftDx, h, e);
+  for (std::size_t i = 0; i < x.size(); i++)
+    EXPECT_NEAR(adjointDx[i], shiftDx[i], 1e-6);
+}
+#endif
+
 #endif
@@ -10,7 +10,7 @@
 #include <cudaq/algorithm.h>
 #include <stdio.h>
 
-#ifdef CUDAQ_BACKEND_DM
+#if defined(CUDAQ_BACKEND_DM) || defined(CUDAQ_BACKEND_TRAJECTORY)
 struct xOp {
   void operator()() __qpu__ {
     cudaq::qubit q;
@@ -18,6 +18,13 @@ struct xOp {
   }
 };
 
+struct ryOp {
+  void operator()(double theta) __qpu__ {
+    cudaq::qubit q;
+    ry(theta, q);
+  }
+};
+
 struct bell {
   void operator()() __qpu__ {
     cudaq::qubit q, r;
@@ -156,6 +163,19 @@ CUDAQ_TEST(NoiseTest, checkCNOT) {
   EXPECT_TRUE(counts.size() > 2);
 }
 
+CUDAQ_TEST(NoiseTest, checkReadoutError) {
+  // The state is exactly |1>, only its readout is noisy.
+  cudaq::noise_model noise;
+  noise.add_readout_error(0, .05, .25);
+  cudaq::set_noise(noise);
+  auto counts = cudaq::sample(2000, xOp{});
+  EXPECT_NEAR(counts.probability("0"), .25, .05);
+  EXPECT_NEAR(counts.probability("1"), .75, .05);
+  cudaq::unset_noise();
+
+  EXPECT_ANY_THROW(noise.add_readout_error(0, {.5, .6, 0., 1.}));
+}
+
 CUDAQ_TEST(NoiseTest, checkExceptions) {
   cudaq::kraus_channel amplitudeDamping{{1., 0., 0., .8660254037844386},
                                         {0., 0.0, 0.5, 0.}};
@@ -199,3 +219,120 @@ CUDAQ_TEST(NoiseTest, checkBitFlipType) {
   EXPECT_NEAR(counts.probability("1"), .9, .1);
 }
 #endif
+
+#ifdef CUDAQ_BACKEND_TRAJECTORY
+CUDAQ_TEST(NoiseTest, checkTrajectoryState) {
+  // Each trajectory applies one renormalized Kraus operator, so the state
+  // is a single pure basis state here.
+  cudaq::noise_model damping;
+  damping.add_channel<cudaq::types::x>({0},
+                                       cudaq::amplitude_damping_channel(.25));
+  cudaq::set_noise(damping);
+  std::size_t nDamped = 0;
+  for (std::size_t i = 0; i < 200; i++) {
+    auto state = cudaq::get_state(xOp{});
+    EXPECT_NEAR(1., std::norm(state[0]) + std::norm(state[1]), 1e-9);
+    EXPECT_NEAR(0., std::norm(state[0]) * std::norm(state[1]), 1e-9);
+    nDamped += std::norm(state[0]) > .5;
+  }
+  EXPECT_NEAR(.25, nDamped / 200., .1);
+  cudaq::unset_noise();
+}
+#endif
+
+#ifdef CUDAQ_BACKEND_DM
+CUDAQ_TEST(NoiseTest, checkDensityMatrixChannels) {
+  // Phase flip on the Hadamard shrinks the Bell state coherences, and two
+  // channels on the same gate compose.
+  cudaq::noise_model noise;
+  noise.add_channel<cudaq::types::h>({0}, cudaq::phase_flip_channel(.1));
+  noise.add_channel<cudaq::types::h>({0}, cudaq::phase_flip_channel(.2));
+  cudaq::set_noise(noise);
+
+  auto state = cudaq::get_state(bell{});
+  const double coherence = .5 * (1. - 2. * .1) * (1. - 2. * .2);
+  EXPECT_NEAR(.5, state(0, 0).real(), 1e-9);
+  EXPECT_NEAR(.5, state(3, 3).real(), 1e-9);
+  EXPECT_NEAR(coherence, state(0, 3).real(), 1e-9);
+  EXPECT_NEAR(coherence, state(3, 0).real(), 1e-9);
+  EXPECT_NEAR(0., std::abs(state(1, 1)), 1e-9);
+
+  // Amplitude damping is exact on the density matrix.
+  cudaq::noise_model damping;
+  damping.add_channel<cudaq::types::x>({0},
+                                       cudaq::amplitude_damping_channel(.25));
+  cudaq::set_noise(damping);
+  auto damped = cudaq::get_state(xOp{});
+  EXPECT_NEAR(.25, damped(0, 0).real(), 1e-9);
+  EXPECT_NEAR(.75, damped(1, 1).real(), 1e-9);
+  cudaq::unset_noise();
+}
+
+CUDAQ_TEST(NoiseTest, checkDensityMatrixParameterizedChannels) {
+  // The rotation and its channel are applied as one superoperator per angle.
+  cudaq::noise_model noise;
+  noise.add_channel<cudaq::types::ry>({0}, cudaq::bit_flip_channel(.1));
+  cudaq::set_noise(noise);
+  for (double theta : {.3, 1.2, .3, 2.5}) {
+    auto state = cudaq::get_state(ryOp{}, theta);
+    const double p1 = std::pow(std::sin(theta / 2.), 2);
+    EXPECT_NEAR(.9 * p1 + .1 * (1. - p1), state(1, 1).real(), 1e-9);
+    // A bit flip leaves the real coherences of ry unchanged.
+    EXPECT_NEAR(.5 * std::sin(theta), state(0, 1).real(), 1e-9);
+  }
+  cudaq::unset_noise();
+}
+
+CUDAQ_TEST(NoiseTest, checkZeroNoiseExtrapolation) {
+  // Every depolarizing ry shrinks the Bloch vector by 1 - 4p/3, so <Z>
+  // decays exponentially with the noise scale.
+  const double theta = .5, shrink = 1. - 4. * .05 / 3.;
+  cudaq::noise_model noise;
+  noise.add_channel<cudaq::types::ry>({0}, cudaq::depolarization_channel(.05));
+  cudaq::set_noise(noise);
+  cudaq::spin_op h = cudaq::spin::z(0);
+
+  cudaq::zne_options options;
+  auto richardson = cudaq::observe(options, ryOp{}, h, theta);
+  ASSERT_EQ(richardson.results.size(), 3);
+  for (std::size_t i = 0; i < 3; i++)
+    EXPECT_NEAR(richardson.results[i].exp_val_z(),
+                std::cos(theta) * std::pow(shrink, options.scales[i]), 1e-9);
+  EXPECT_NEAR(richardson.expectation, std::cos(theta), 1e-3);
+
+  options.extrapolation = cudaq::zne_extrapolation::exponential;
+  double exponential = cudaq::observe(options, ryOp{}, h, theta);
+  EXPECT_NEAR(exponential, std::cos(theta), 1e-9);
+
+  EXPECT_ANY_THROW(
+      cudaq::observe(cudaq::zne_options{{1, 2}}, ryOp{}, h, theta));
+  cudaq::unset_noise();
+}
+
+CUDAQ_TEST(NoiseTest, checkObserveCacheIgnoresNoisyResults) {
+  // A noise model changes the exact expectation value, so neither is
+  // memoized for the other.
+  const double theta = .5;
+  cudaq::spin_op h = cudaq::spin::z(0);
+  auto &cache = cudaq::details::getObserveCache();
+  cudaq::clear_observe_cache();
+  cudaq::set_observe_cache_capacity(4);
+  double noiseless = cudaq::observe(ryOp{}, h, theta);
+  EXPECT_NEAR(noiseless, std::cos(theta), 1e-9);
+
+  cudaq::noise_model noise;
+  noise.add_channel<cudaq::types::ry>({0}, cudaq::depolarization_channel(.3));
+  cudaq::set_noise(noise);
+  double noisy = cudaq::observe(ryOp{}, h, theta);
+  EXPECT_NEAR(noisy, std::cos(theta) * (1. - 4. * .3 / 3.), 1e-9);
+  EXPECT_GT(std::abs(noiseless - noisy), .1);
+  EXPECT_EQ(cache.hits(), 0);
+
+  // Without the noise, the noiseless value is memoized again.
+  cudaq::unset_noise();
+  EXPECT_EQ(cudaq::observe(ryOp{}, h, theta).exp_val_z(), noiseless);
+  EXPECT_EQ(cache.hits(), 1);
+  cudaq::set_observe_cache_capacity(0);
+  cudaq::clear_observe_cache();
+}
+#endif
@@ -43,6 +43,8 @@ CUDAQ_TEST(ObserveResult, checkSimple) {
   auto obs_res = cudaq::observe(ansatz, h, 0.59);
   EXPECT_NEAR(obs_res.exp_val_z(), -1.7487, 1e-3);
   printf("Energy from observe_result %lf\n", obs_res.exp_val_z());
+  EXPECT_EQ(obs_res.get_counters().kernel_executions, 1);
+  EXPECT_GE(obs_res.get_counters().gates, 3);
 
   auto &platform = cudaq::get_platform();
 
@@ -62,3 +64,189 @@ CUDAQ_TEST(ObserveResult, checkSimple) {
   EXPECT_TRUE(x0x1Counts.size() == 4);
   platform.clear_shots();
 }
+
+CUDAQ_TEST(ObserveResult, checkSharedBasisTerms) {
+  using namespace cudaq::spin;
+  // z(0), z(1) and z(0) * z(1) are measured from the same shots.
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1) + .5 * z(0) * z(1);
+
+  auto ansatz = [](double theta) __qpu__ {
+    cudaq::qubit q, r;
+    x(q);
+    ry(theta, r);
+    x<cudaq::ctrl>(r, q);
+  };
+
+  auto exact = cudaq::observe(ansatz, h, 0.59);
+  auto res = cudaq::observe(100000, ansatz, h, 0.59);
+  EXPECT_NEAR(res.exp_val_z(), exact.exp_val_z(), 1e-1);
+
+  // Every term gets the counts of all shots on its own qubits.
+  for (std::size_t i = 0; i < h.n_terms(); i++) {
+    if (h[i].is_identity())
+      continue;
+    auto bsf = h[i].get_bsf()[0];
+    std::size_t nMeasured = 0;
+    for (std::size_t q = 0; q < h.n_qubits(); q++)
+      nMeasured += bsf[q] || bsf[q + h.n_qubits()];
+    std::size_t shots = 0;
+    for (auto &[bits, count] : res.counts(h[i])) {
+      EXPECT_EQ(bits.size(), nMeasured);
+      shots += count;
+    }
+    EXPECT_EQ(shots, 100000);
+  }
+  cudaq::get_platform().clear_shots();
+}
+
+CUDAQ_TEST(ObserveResult, checkBatch) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+
+  auto ansatz = [](double theta) __qpu__ {
+    cudaq::qubit q, r;
+    x(q);
+    ry(theta, r);
+    x<cudaq::ctrl>(r, q);
+  };
+
+  std::vector<std::tuple<double>> thetas{{0.}, {.59}, {1.2}, {.59}};
+  auto results = cudaq::observe_batch(ansatz, h, thetas);
+  ASSERT_EQ(results.size(), thetas.size());
+  for (std::size_t i = 0; i < thetas.size(); i++) {
+    double expected = cudaq::observe(ansatz, h, std::get<0>(thetas[i]));
+    EXPECT_NEAR(results[i].exp_val_z(), expected, 1e-6);
+  }
+  EXPECT_NEAR(results[1].exp_val_z(), -1.7487, 1e-3);
+}
+
+CUDAQ_TEST(ObserveResult, checkBatchWithShots) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+
+  auto ansatz = [](double theta) __qpu__ {
+    cudaq::qubit q, r;
+    x(q);
+    ry(theta, r);
+    x<cudaq::ctrl>(r, q);
+  };
+
+  // Sampled evaluations are not batched, each one is sampled on its own.
+  std::vector<std::tuple<double>> thetas{{0.}, {.59}, {1.2}};
+  auto results = cudaq::observe(10000, ansatz, h, thetas);
+  ASSERT_EQ(results.size(), thetas.size());
+  for (std::size_t k = 0; k < thetas.size(); k++) {
+    double expected = cudaq::observe(ansatz, h, std::get<0>(thetas[k]));
+    EXPECT_NEAR(results[k].exp_val_z(), expected, .4);
+    std::size_t shots = 0;
+    for (auto &[bits, count] : results[k].counts(i(0) * z(1)))
+      shots += count;
+    EXPECT_EQ(shots, 10000);
+  }
+}
+
+CUDAQ_TEST(ObserveResult, checkShotBudget) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+
+  auto ansatz = [](double theta) __qpu__ {
+    cudaq::qubit q, r;
+    x(q);
+    ry(theta, r);
+    x<cudaq::ctrl>(r, q);
+  };
+
+  auto exact = cudaq::observe(ansatz, h, 0.59);
+  auto res = cudaq::observe(cudaq::shot_budget{30000, 3}, ansatz, h, 0.59);
+  EXPECT_NEAR(res.exp_val_z(), exact.exp_val_z(), 1e-1);
+  EXPECT_GT(res.variance(), 0.);
+
+  // The three groups share the budget, z(1) of the largest coefficient gets
+  // more shots than x(0) * x(1).
+  auto shotsOf = [&](cudaq::spin_op term) {
+    std::size_t shots = 0;
+    for (auto &[bits, count] : res.counts(term))
+      shots += count;
+    return shots;
+  };
+  std::size_t total = 0;
+  for (auto term : {x(0) * x(1), y(0) * y(1), z(0) * i(1)})
+    total += shotsOf(term);
+  EXPECT_EQ(total, 30000);
+  EXPECT_EQ(shotsOf(z(0) * i(1)), shotsOf(i(0) * z(1)));
+  EXPECT_GT(shotsOf(i(0) * z(1)), shotsOf(x(0) * x(1)));
+
+  EXPECT_ANY_THROW(cudaq::observe(cudaq::shot_budget{4, 2}, ansatz, h, 0.59));
+}
+
+CUDAQ_TEST(ObserveResult, checkMultipleObservables) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+
+  auto ansatz = [](double theta) __qpu__ {
+    cudaq::qubit q, r;
+    x(q);
+    ry(theta, r);
+    x<cudaq::ctrl>(r, q);
+  };
+
+  // x(0) * x(1) and z(1) are shared with h, the kernel is executed once.
+  std::vector<cudaq::spin_op> ops{h, 2. * x(0) * x(1), z(1) - 1.};
+  auto results = cudaq::observe(ansatz, ops, 0.59);
+  ASSERT_EQ(results.size(), ops.size());
+  for (std::size_t i = 0; i < ops.size(); i++) {
+    double expected = cudaq::observe(ansatz, ops[i], 0.59);
+    EXPECT_NEAR(results[i].exp_val_z(), expected, 1e-6);
+    EXPECT_EQ(results[i].get_counters().kernel_executions, 1);
+  }
+  EXPECT_NEAR(results[0].exp_val_z(), -1.7487, 1e-3);
+  EXPECT_NEAR(results[0].exp_val_z(x(0) * x(1)),
+              results[1].exp_val_z() / 2., 1e-6);
+}
+
+CUDAQ_TEST(ObserveResult, checkCache) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+
+  auto ansatz = [](std::vector<double> theta) __qpu__ {
+    cudaq::qubit q, r;
+    x(q);
+    ry(theta[0], r);
+    x<cudaq::ctrl>(r, q);
+  };
+
+  auto &cache = cudaq::details::getObserveCache();
+  cudaq::set_observe_cache_capacity(2);
+  double first = cudaq::observe(ansatz, h, std::vector<double>{.59});
+  EXPECT_EQ(cache.hits(), 0);
+  double second = cudaq::observe(ansatz, h, std::vector<double>{.59});
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(first, second);
+  EXPECT_NEAR(first, -1.7487, 1e-3);
+
+  // Another spin_op or parameter is a miss, and evicts the oldest entry.
+  cudaq::observe(ansatz, 2. * h, std::vector<double>{.59});
+  cudaq::observe(ansatz, h, std::vector<double>{.6});
+  EXPECT_EQ(cache.hits(), 1);
+  cudaq::observe(ansatz, h, std::vector<double>{.59});
+  EXPECT_EQ(cache.hits(), 1);
+
+  // The batched evaluations share the memoized ones.
+  std::vector<std::tuple<std::vector<double>>> thetas{{{.6}}, {{.7}}};
+  auto results = cudaq::observe_batch(ansatz, h, thetas);
+  EXPECT_EQ(cache.hits(), 2);
+  EXPECT_NEAR(results[0].exp_val_z(),
+              cudaq::observe(ansatz, h, std::vector<double>{.6}), 1e-12);
+
+  // Shot-based observations are never memoized.
+  cudaq::observe(1000, ansatz, h, std::vector<double>{.7});
+  EXPECT_EQ(cache.hits(), 3);
+  cudaq::set_observe_cache_capacity(0);
+  cudaq::clear_observe_cache();
+}
@@ -121,6 +121,94 @@ CUDAQ_TEST_F(VQETester, checkSpsa) {
   EXPECT_NEAR(opt_val, -1.1371, 1e-3);
 }
 
+CUDAQ_TEST_F(VQETester, checkBatchSpsa) {
+  cudaq::optimizers::spsa opt;
+  opt.perturbations = 2;
+  opt.max_eval = 200;
+  std::size_t checkpoints = 0;
+  cudaq::vqe_batch_report report;
+  auto [opt_val, opt_params] = cudaq::vqe_batch(
+      ansatz_compute_action{}, *H, opt, 1,
+      {.checkpoint = [&](double, const std::vector<double> &) {
+         checkpoints++;
+       },
+       .report = &report});
+  EXPECT_NEAR(opt_val, -1.1371, 1e-2);
+  EXPECT_EQ(checkpoints, report.batches);
+  EXPECT_EQ(report.evaluations, 5 * report.batches);
+  EXPECT_LE(report.best_energy, opt_val);
+  EXPECT_LE(report.utilization(), 1.0);
+
+  // Resume from the checkpoint, and fall back to one energy per batch.
+  cudaq::optimizers::cobyla c_opt;
+  c_opt.initial_parameters = report.best_parameters;
+  auto [opt_val2, opt_params2] =
+      cudaq::vqe_batch(ansatz_compute_action{}, *H, c_opt, 1,
+                       {.report = &report});
+  EXPECT_NEAR(opt_val2, -1.1371, 1e-3);
+  EXPECT_EQ(report.evaluations, report.batches);
+}
+
+CUDAQ_TEST_F(VQETester, checkBatchAdamWithShots) {
+  cudaq::optimizers::adam opt;
+  opt.perturbations = 2;
+  opt.shots = 1000;
+  opt.shot_budget = 1000 * 5 * 100;
+  opt.learning_rate = [](std::size_t k) { return 0.1 / std::sqrt(k + 1.); };
+  cudaq::vqe_batch_report report;
+  auto [opt_val, opt_params] = cudaq::vqe_batch(
+      ansatz_compute_action{}, *H, opt, 1, {.report = &report});
+  EXPECT_NEAR(opt_val, -1.1371, 5e-2);
+  EXPECT_LE(report.evaluations * *opt.shots, *opt.shot_budget);
+}
+
+CUDAQ_TEST_F(VQETester, checkMultistart) {
+  auto cobylaFrom = [](const std::vector<double> &x0) {
+    auto optimizer = std::make_unique<cudaq::optimizers::cobyla>();
+    optimizer->initial_parameters = x0;
+    return optimizer;
+  };
+  std::vector<double> checkpoints;
+  auto result = cudaq::vqe_multistart(
+      ansatz_compute_action{}, *H, cobylaFrom, 1, 4,
+      {.seed = 13,
+       .max_concurrent = 2,
+       .stall_evaluations = 20,
+       .checkpoint = [&](double energy, const std::vector<double> &) {
+         checkpoints.push_back(energy);
+       }});
+  EXPECT_NEAR(result.optimal_value, -1.1371, 1e-3);
+  ASSERT_EQ(result.trajectories.size(), 4);
+  EXPECT_EQ(result.trajectories[result.best_start].optimal_value,
+            result.optimal_value);
+  for (auto &trajectory : result.trajectories) {
+    EXPECT_EQ(trajectory.initial_parameters.size(), 1);
+    EXPECT_FALSE(trajectory.energies.empty());
+    EXPECT_GE(trajectory.optimal_value, result.optimal_value);
+  }
+  ASSERT_FALSE(checkpoints.empty());
+  EXPECT_TRUE(std::is_sorted(checkpoints.rbegin(), checkpoints.rend()));
+
+  // Every trajectory is stopped after its first evaluation.
+  auto stopped = cudaq::vqe_multistart(
+      ansatz_compute_action{}, *H, cobylaFrom, 1, 3,
+      {.seed = 13,
+       .stop = [](const cudaq::vqe_trajectory &, double) { return true; }});
+  for (auto &trajectory : stopped.trajectories) {
+    EXPECT_TRUE(trajectory.stopped);
+    EXPECT_EQ(trajectory.energies.size(), 1);
+    EXPECT_EQ(trajectory.optimal_value, trajectory.energies.front());
+  }
+
+  EXPECT_ANY_THROW({
+    cudaq::vqe_multistart(ansatz_compute_action{}, *H,
+                          [](const std::vector<double> &) {
+                            return std::make_unique<cudaq::optimizers::lbfgs>();
+                          },
+                          1, 2);
+  });
+}
+
 CUDAQ_TEST_F(VQETester, checkDifferentArgStructure) {
   cudaq::optimizers::cobyla c_opt;
   auto argMapper = [](std::vector<double> x) { return std::make_tuple(x[0]); };
@@ -0,0 +1,65 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+
+#include "cudaq/platform/mqpu/MultiQPUConfig.h"
+#include <gtest/gtest.h>
+
+using namespace cudaq::mqpu;
+
+TEST(MultiQPUConfigTester, checkRemoteQPUs) {
+  EXPECT_TRUE(parseRemoteQPUs("").empty());
+  EXPECT_TRUE(parseRemoteQPUs("  ").empty());
+
+  EXPECT_EQ(parseRemoteQPUs("quantinuum"),
+            std::vector<std::string>{"quantinuum"});
+  EXPECT_EQ(parseRemoteQPUs("quantinuum;url;http://localhost:62440"),
+            std::vector<std::string>{"quantinuum;url;http://localhost:62440"});
+
+  // Several endpoints and several accounts of one provider, with any number
+  // of spaces between them.
+  std::vector<std::string> backends{
+      "quantinuum;machine;H1-1E",
+      "quantinuum;machine;H1-2E;credentials;/tmp/other",
+      "ionq;url;https://[::1]:8443/v0.3", "ionq;url;https://[::1]/v0.3"};
+  EXPECT_EQ(parseRemoteQPUs(" " + backends[0] + "  " + backends[1] + " " +
+                            backends[2] + " " + backends[3] + " "),
+            backends);
+
+  // The port of a url must be a number in [1, 65535].
+  for (auto url : {"http://localhost:", "http://localhost:0",
+                   "http://localhost:65536", "http://localhost:80a/job",
+                   "https://[::1]:-1"})
+    EXPECT_THROW(parseRemoteQPUs(std::string("quantinuum;url;") + url),
+                 std::runtime_error);
+  EXPECT_THROW(parseRemoteQPUs("quantinuum;machine"), std::runtime_error);
+  EXPECT_THROW(parseRemoteQPUs(";machine;H1-1E"), std::runtime_error);
+}
+
+TEST(MultiQPUConfigTester, checkDevices) {
+  EXPECT_EQ(parseDevices("3", 8), std::vector<int>{3});
+  EXPECT_EQ(parseDevices("5,0,2", 8), std::vector<int>({5, 0, 2}));
+
+  // Ranges are inclusive, and keep the listed order.
+  EXPECT_EQ(parseDevices("0-3", 8), std::vector<int>({0, 1, 2, 3}));
+  EXPECT_EQ(parseDevices("6,1-2,4-4", 8), std::vector<int>({6, 1, 2, 4}));
+
+  // Duplicates, also within ranges, are an error.
+  EXPECT_THROW(parseDevices("1,1", 8), std::runtime_error);
+  EXPECT_THROW(parseDevices("0-3,2", 8), std::runtime_error);
+  EXPECT_THROW(parseDevices("0-2,1-4", 8), std::runtime_error);
+
+  // So are the ids of missing devices.
+  EXPECT_THROW(parseDevices("8", 8), std::runtime_error);
+  EXPECT_THROW(parseDevices("6-9", 8), std::runtime_error);
+  EXPECT_THROW(parseDevices("0", 0), std::runtime_error);
+
+  // And malformed entries.
+  for (auto value : {",", "0,", "a", "1.5", "-1", "3-1", "1-", "1-2-3",
+                     " 1", "99999999999"})
+    EXPECT_THROW(parseDevices(value, 8), std::runtime_error) << value;
+}
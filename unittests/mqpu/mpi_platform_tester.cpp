@@ -0,0 +1,81 @@
+/*************************************************************** -*- C++ -*- ***
+ * Copyright (c) 2022 - 2023 NVIDIA Corporation & Affiliates.                  *
+ * All rights reserved.                                                        *
+ *                                                                             *
+ * This source code and the accompanying materials are made available under    *
+ * the terms of the Apache License 2.0 which accompanies this distribution.    *
+ *******************************************************************************/
+#include <cudaq.h>
+#include <cudaq/algorithm.h>
+#include <cudaq/algorithms/gradients/parameter_shift.h>
+#include <gtest/gtest.h>
+
+namespace {
+cudaq::spin_op makeHamiltonian() {
+  using namespace cudaq::spin;
+  return 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) + .21829 * z(0) -
+         6.125 * z(1);
+}
+
+struct ansatz {
+  void operator()(double theta) __qpu__ {
+    cudaq::qubit q, r;
+    x(q);
+    ry(theta, r);
+    x<cudaq::ctrl>(r, q);
+  }
+};
+} // namespace
+
+TEST(MPIPlatformTester, checkObserve) {
+  // Every rank observes its share of the terms and returns the sum.
+  auto h = makeHamiltonian();
+  double result = cudaq::observe(ansatz{}, h, 0.59);
+  EXPECT_NEAR(result, -1.7487, 1e-3);
+
+  // More ranks than groups of terms leaves some ranks without terms.
+  using namespace cudaq::spin;
+  cudaq::spin_op zz = z(0) * z(1);
+  EXPECT_NEAR(cudaq::observe(ansatz{}, zz, 0.0).exp_val_z(), -1., 1e-9);
+}
+
+TEST(MPIPlatformTester, checkBroadcasts) {
+  auto h = makeHamiltonian();
+  std::vector<std::tuple<double>> thetas;
+  for (int i = 0; i < 7; i++)
+    thetas.emplace_back(-1.0 + 0.3 * i);
+
+  // Each rank observes a share of the argument sets, all ranks get all.
+  auto results = cudaq::observe(ansatz{}, h, thetas);
+  ASSERT_EQ(results.size(), thetas.size());
+  for (std::size_t i = 0; i < thetas.size(); i++)
+    EXPECT_NEAR(results[i].exp_val_z(),
+                cudaq::observe(ansatz{}, h, std::get<0>(thetas[i])),
+                1e-6);
+
+  auto kernel = [](double theta) __qpu__ {
+    cudaq::qubit q;
+    rx(theta, q);
+    mz(q);
+  };
+  std::vector<std::tuple<double>> angles;
+  for (int i = 0; i < 5; i++)
+    angles.emplace_back(i % 2 ? M_PI : 0.0);
+  auto counts = cudaq::sample(100, kernel, angles);
+  ASSERT_EQ(counts.size(), angles.size());
+  for (std::size_t i = 0; i < angles.size(); i++)
+    EXPECT_EQ(counts[i].count(i % 2 ? "1" : "0"), 100);
+
+  // The shifted evaluations of a gradient are a broadcast too.
+  auto argsMapper = [](std::vector<double> x) { return std::make_tuple(x[0]); };
+  ansatz kernelObject;
+  cudaq::gradients::parameter_shift shift(kernelObject, argsMapper);
+  std::vector<double> x{0.2}, dx(1);
+  shift.compute(x, dx, h, 0.);
+  const double step = 1e-4;
+  EXPECT_NEAR(dx[0],
+              (cudaq::observe(ansatz{}, h, 0.2 + step).exp_val_z() -
+               cudaq::observe(ansatz{}, h, 0.2 - step).exp_val_z()) /
+                  (2 * step),
+              1e-4);
+}
@@ -7,6 +7,8 @@
  *******************************************************************************/
 #include <cudaq.h>
 #include <cudaq/algorithm.h>
+#include <cudaq/algorithms/gradients/central_difference.h>
+#include <cudaq/algorithms/gradients/parameter_shift.h>
 #include <gtest/gtest.h>
 
 TEST(MQPUTester, checkSimple) {
@@ -86,3 +88,164 @@ TEST(MQPUTester, checkLarge) {
   std::chrono::duration<double, std::milli> ms_double = t2 - t1;
   printf("Time %lf s\n", ms_double.count() * 1e-3);
 }
+
+TEST(MQPUTester, checkCostPartition) {
+  using namespace cudaq::spin;
+  // Two commuting groups of very different cost and an identity term.
+  cudaq::spin_op h = 2.0 + x(0) * x(1) * x(2) * x(3) + x(0) * x(1) +
+                     x(2) * x(3) + x(0) + z(0) + z(1);
+  auto [partition, costs] =
+      cudaq::details::partitionTermsByCost(h, {1.0, 1.0, 1.0});
+  ASSERT_EQ(partition.size(), 3);
+  std::size_t nTerms = 0;
+  for (auto &terms : partition)
+    nTerms += terms.size();
+  EXPECT_EQ(nTerms, h.n_terms());
+  // The X group and the Z group each go to their own QPU.
+  EXPECT_EQ(std::count(costs.begin(), costs.end(), 0.0), 1);
+
+  // A QPU twice as fast takes the costlier group.
+  auto [weighted, weightedCosts] =
+      cudaq::details::partitionTermsByCost(h, {1.0, 2.0});
+  EXPECT_GT(weightedCosts[1], weightedCosts[0]);
+
+  auto ansatz = [](double theta) __qpu__ {
+    cudaq::qreg q(4);
+    ry(theta, q[0]);
+    x<cudaq::ctrl>(q[0], q[1]);
+  };
+  // cos(.15)|0000> + sin(.15)|1100>
+  EXPECT_NEAR(cudaq::observe(ansatz, h, 0.3),
+              2.0 + std::sin(0.3) + 2 * std::cos(0.3), 1e-6);
+}
+
+TEST(MQPUTester, checkGradient) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+
+  auto ansatz = [](double theta) __qpu__ {
+    cudaq::qubit q, r;
+    x(q);
+    ry(theta, r);
+    x<cudaq::ctrl>(r, q);
+  };
+  auto argsMapper = [](std::vector<double> x) { return std::make_tuple(x[0]); };
+
+  // The shifted evaluations are spread across the QPUs.
+  cudaq::gradients::parameter_shift shift(ansatz, argsMapper);
+  cudaq::gradients::central_difference difference(ansatz, argsMapper);
+  std::vector<double> x{0.2}, shiftDx(1), differenceDx(1);
+  shift.compute(x, shiftDx, h, 0.);
+  difference.compute(x, differenceDx, h, 0.);
+  EXPECT_NEAR(shiftDx[0], differenceDx[0], 1e-4);
+  EXPECT_LT(shiftDx[0], 0.);
+}
+
+TEST(MQPUTester, checkObserveBroadcast) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+
+  auto ansatz = [](double theta) __qpu__ {
+    cudaq::qubit q, r;
+    x(q);
+    ry(theta, r);
+    x<cudaq::ctrl>(r, q);
+  };
+
+  // The argument sets are split amongst the QPUs, the results come back in
+  // input order.
+  std::vector<std::tuple<double>> thetas;
+  for (int i = 0; i < 11; i++)
+    thetas.emplace_back(-1.0 + 0.2 * i);
+  auto results = cudaq::observe(ansatz, h, thetas);
+  ASSERT_EQ(results.size(), thetas.size());
+  for (std::size_t i = 0; i < thetas.size(); i++)
+    EXPECT_NEAR(results[i].exp_val_z(),
+                cudaq::observe(ansatz, h, std::get<0>(thetas[i])).exp_val_z(),
+                1e-6);
+}
+
+TEST(MQPUTester, checkSampleBroadcast) {
+  auto kernel = [](double theta) __qpu__ {
+    cudaq::qubit q;
+    rx(theta, q);
+    mz(q);
+  };
+
+  // rx(0) gives all zeros, rx(pi) all ones, whichever QPU samples them.
+  std::vector<std::tuple<double>> thetas;
+  for (int i = 0; i < 8; i++)
+    thetas.emplace_back(i % 2 ? M_PI : 0.0);
+  auto results = cudaq::sample(100, kernel, thetas);
+  ASSERT_EQ(results.size(), thetas.size());
+  for (std::size_t i = 0; i < thetas.size(); i++)
+    EXPECT_EQ(results[i].count(i % 2 ? "1" : "0"), 100);
+
+  // The callback sees every set of arguments once.
+  std::vector<int> seen(thetas.size(), 0);
+  cudaq::sample(10, kernel, thetas,
+                [&](std::size_t i, cudaq::sample_result &&result) {
+                  seen[i]++;
+                  EXPECT_EQ(result.count(i % 2 ? "1" : "0"), 10);
+                });
+  for (auto count : seen)
+    EXPECT_EQ(count, 1);
+}
+
+TEST(MQPUTester, checkUnplacedTasks) {
+  auto &platform = cudaq::get_platform();
+  auto ghz = [](int n) __qpu__ {
+    cudaq::qreg q(n);
+    h(q[0]);
+    for (int i = 0; i < n - 1; i++)
+      x<cudaq::ctrl>(q[i], q[i + 1]);
+    mz(q);
+  };
+
+  // Tasks of uneven cost, taken by whichever QPU is free.
+  const std::size_t nTasks = 4 * platform.num_qpus() + 1;
+  std::vector<cudaq::UnplacedTask> tasks;
+  for (std::size_t i = 0; i < nTasks; i++)
+    tasks.emplace_back([&, i](std::size_t qpu) {
+      EXPECT_EQ(platform.get_current_qpu(), qpu);
+      return cudaq::details::runSampling(
+                 [&]() { ghz(2 + i % 5); }, platform, "ghz", 100, qpu)
+          .value();
+    });
+  auto stream = platform.enqueueUnplacedTasks(std::move(tasks));
+  std::vector<bool> seen(nTasks, false);
+  while (auto completed = stream.next()) {
+    auto &[i, counts] = *completed;
+    EXPECT_FALSE(seen[i]);
+    seen[i] = true;
+    EXPECT_EQ(counts.size(), 2);
+    EXPECT_EQ(counts.begin()->first.size(), 2 + i % 5);
+  }
+  EXPECT_EQ(stream.remaining(), 0);
+  EXPECT_EQ(std::count(seen.begin(), seen.end(), true), nTasks);
+}
+
+TEST(MQPUTester, checkSplitSampling) {
+  auto bell = []() __qpu__ {
+    cudaq::qreg q(2);
+    h(q[0]);
+    x<cudaq::ctrl>(q[0], q[1]);
+    mz(q);
+  };
+
+  // The shots are split across the QPUs, seeded per chunk.
+  const std::size_t shots = 100001;
+  cudaq::set_random_seed(13);
+  auto counts = cudaq::sample(shots, bell);
+  std::size_t total = 0;
+  for (auto &[bits, count] : counts)
+    total += count;
+  EXPECT_EQ(total, shots);
+  EXPECT_EQ(counts.size(), 2);
+  EXPECT_NEAR(counts.probability("00"), .5, .01);
+
+  cudaq::set_random_seed(13);
+  EXPECT_EQ(counts.to_map(), cudaq::sample(shots, bell).to_map());
+}
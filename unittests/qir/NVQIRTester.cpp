@@ -92,6 +92,22 @@ Array *__quantum__rt__array_slice(Array *array, int32_t dim,
                                   int64_t range_end);
 Array *__quantum__rt__array_slice_1d(Array *array, int64_t range_start,
                                      int64_t range_step, int64_t range_end);
+
+// Base profile functions
+void __quantum__qis__h__body(Qubit *q);
+void __quantum__qis__x__body(Qubit *q);
+void __quantum__qis__cnot__body(Qubit *src, Qubit *tgt);
+void __quantum__qis__mz__body(Qubit *q, Result *r);
+bool __quantum__qis__read_result__body(Result *r);
+void __quantum__rt__array_start_record_output();
+void __quantum__rt__result_record_output(Result *r, int8_t *label);
+void __quantum__rt__array_end_record_output();
+}
+
+namespace nvqir {
+std::vector<bool> runBaseProfileKernel(void (*kernel)(),
+                                       std::uint64_t requiredQubits,
+                                       std::uint64_t requiredResults);
 }
 
 CUDAQ_TEST(NVQIRTester, checkSimple) {
@@ -287,6 +303,97 @@ CUDAQ_TEST(NVQIRTester, checkNisqMechanics) {
   __quantum__rt__finalize();
 }
 
+CUDAQ_TEST(NVQIRTester, checkReleasedArraysAreReused) {
+  __quantum__rt__initialize(0, nullptr);
+  auto qubits = __quantum__rt__qubit_allocate_array(3);
+  __quantum__rt__qubit_release_array(qubits);
+
+  // Registers allocated in a loop get the released Array and Qubits back.
+  for (int i = 0; i < 10; i++) {
+    auto qreg = __quantum__rt__qubit_allocate_array(2);
+    EXPECT_EQ(qreg, qubits);
+    EXPECT_EQ(__quantum__rt__array_get_size_1d(qreg), 2);
+    Qubit *q1 = extract_qubit(qreg, 0);
+    Qubit *q2 = extract_qubit(qreg, 1);
+    EXPECT_NE(q1, q2);
+    __quantum__qis__x(q1);
+    invokeWithControlQubits(1, __quantum__qis__x__ctl, q1, q2);
+    EXPECT_TRUE(*__quantum__qis__mz(q1));
+    EXPECT_TRUE(*__quantum__qis__mz(q2));
+    __quantum__rt__qubit_release_array(qreg);
+  }
+
+  auto qubit = __quantum__rt__qubit_allocate();
+  EXPECT_FALSE(*__quantum__qis__mz(qubit));
+  __quantum__rt__qubit_release(qubit);
+  EXPECT_EQ(__quantum__rt__qubit_allocate(), qubit);
+  __quantum__rt__qubit_release(qubit);
+  __quantum__rt__finalize();
+}
+
+CUDAQ_TEST(NVQIRTester, checkControlsOfConsecutiveGates) {
+  __quantum__rt__initialize(0, nullptr);
+  auto qubits = __quantum__rt__qubit_allocate_array(4);
+  Qubit *q0 = extract_qubit(qubits, 0);
+  Qubit *q1 = extract_qubit(qubits, 1);
+  Qubit *q2 = extract_qubit(qubits, 2);
+  Qubit *q3 = extract_qubit(qubits, 3);
+  __quantum__qis__x(q0);
+  __quantum__qis__x(q1);
+  __quantum__qis__x(q2);
+
+  // Gates with different numbers of controls must not see each other's.
+  invokeWithControlQubits(3, __quantum__qis__x__ctl, q0, q1, q2, q3);
+  __quantum__qis__cnot(q3, q0);
+  invokeWithControlQubits(2, __quantum__qis__x__ctl, q0, q1, q2);
+  auto ctls = __quantum__rt__array_slice_1d(qubits, 1, 1, 1);
+  __quantum__qis__x__ctl(ctls, q0);
+  EXPECT_TRUE(*__quantum__qis__mz(q0));
+  EXPECT_TRUE(*__quantum__qis__mz(q1));
+  EXPECT_TRUE(*__quantum__qis__mz(q2));
+  EXPECT_TRUE(*__quantum__qis__mz(q3));
+  __quantum__rt__qubit_release_array(qubits);
+  __quantum__rt__finalize();
+}
+
+// A base profile Bell kernel, its qubits and results are static ids.
+static void baseProfileBell() {
+  auto *q0 = reinterpret_cast<Qubit *>(0);
+  auto *q1 = reinterpret_cast<Qubit *>(1);
+  auto *q2 = reinterpret_cast<Qubit *>(2);
+  auto *r0 = reinterpret_cast<Result *>(0);
+  auto *r1 = reinterpret_cast<Result *>(1);
+  auto *r2 = reinterpret_cast<Result *>(2);
+  __quantum__qis__h__body(q0);
+  __quantum__qis__cnot__body(q0, q1);
+  __quantum__qis__x__body(q2);
+  __quantum__qis__mz__body(q0, r0);
+  __quantum__qis__mz__body(q1, r1);
+  __quantum__qis__mz__body(q2, r2);
+  EXPECT_TRUE(__quantum__qis__read_result__body(r2));
+  __quantum__rt__array_start_record_output();
+  __quantum__rt__result_record_output(r0, nullptr);
+  __quantum__rt__result_record_output(r1, nullptr);
+  __quantum__rt__result_record_output(r2, nullptr);
+  __quantum__rt__array_end_record_output();
+}
+
+CUDAQ_TEST(NVQIRTester, checkBaseProfileKernel) {
+  __quantum__rt__initialize(0, nullptr);
+  for (int i = 0; i < 10; i++) {
+    auto bits = nvqir::runBaseProfileKernel(baseProfileBell, 3, 3);
+    ASSERT_EQ(bits.size(), 3);
+    EXPECT_EQ(bits[0], bits[1]);
+    EXPECT_TRUE(bits[2]);
+  }
+
+  // The static qubits are released, dynamic qubits work as before.
+  auto qubit = __quantum__rt__qubit_allocate();
+  EXPECT_FALSE(*__quantum__qis__mz(qubit));
+  __quantum__rt__qubit_release(qubit);
+  __quantum__rt__finalize();
+}
+
 CUDAQ_TEST(NVQIRTester, checkGates) {
 
   double oneOverSqrt2 = 1. / std::sqrt(2.0);
@@ -309,3 +416,59 @@ CUDAQ_TEST(NVQIRTester, checkGates) {
     std::cout << m.real() << ", " << m.imag() << "\n";
   }
 }
+
+CUDAQ_TEST(NVQIRTester, checkGateMatrices) {
+  // The fixed gate matrices are compile time constants.
+  static_assert(nvqir::x<double>::getMatrix()[1] == std::complex<double>(1.));
+  constexpr auto t = nvqir::t<double>::getMatrix();
+  const auto s = nvqir::s<double>::getMatrix();
+  EXPECT_NEAR(0.0, std::abs(t[3] * t[3] - s[3]), 1e-12);
+
+  // Every gate is unitary.
+  const double angles[] = {0.3, -1.1, 2.5};
+  for (int g = 0; g <= static_cast<int>(nvqir::GateName::U3); g++) {
+    nvqir::GateMatrix<double> m;
+    nvqir::writeGateMatrix(static_cast<nvqir::GateName>(g), angles, m.data());
+    for (std::size_t r = 0; r < 2; r++)
+      for (std::size_t c = 0; c < 2; c++) {
+        const auto dot = m[2 * r] * std::conj(m[2 * c]) +
+                         m[2 * r + 1] * std::conj(m[2 * c + 1]);
+        EXPECT_NEAR(r == c ? 1.0 : 0.0, std::abs(dot), 1e-12);
+      }
+  }
+}
+
+CUDAQ_TEST(NVQIRTester, checkObserveManyGroups) {
+  __quantum__rt__initialize(0, nullptr);
+  // All the 3^7 X/Y/Z words on 7 qubits, no two of which commute qubit-wise,
+  // so each is measured as a group of its own.
+  const std::size_t nQubits = 7;
+  cudaq::spin_op_builder builder;
+  for (std::size_t word = 0; word < 2187; word++) {
+    std::string pauliWord;
+    for (std::size_t q = 0, w = word; q < nQubits; q++, w /= 3)
+      pauliWord += "XYZ"[w % 3];
+    builder.add(1.0, pauliWord);
+  }
+  auto op = builder.build();
+  auto data = op.getDataRepresentation();
+  auto paulis = __quantum__rt__array_create_1d(sizeof(double), data.size());
+  for (std::size_t i = 0; i < data.size(); i++)
+    *reinterpret_cast<double *>(
+        __quantum__rt__array_get_element_ptr_1d(paulis, i)) = data[i];
+
+  cudaq::ExecutionContext ctx("observe", 100);
+  __quantum__rt__setExecutionContext(&ctx);
+  auto qubits = __quantum__rt__qubit_allocate_array(nQubits);
+  __quantum__qis__measure__body(paulis, qubits);
+  __quantum__rt__qubit_release_array(qubits);
+  __quantum__rt__resetExecutionContext();
+  EXPECT_EQ(op.n_terms(), 2187);
+  EXPECT_TRUE(ctx.expectationValue.has_value());
+  // Every group reuses the scratch buffers, each term still gets its counts.
+  auto registers = ctx.result.register_names();
+  EXPECT_EQ(registers.size(), 2187 + 1);
+
+  __quantum__rt__array_release(paulis);
+  __quantum__rt__finalize();
+}
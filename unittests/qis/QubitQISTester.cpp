@@ -335,4 +335,73 @@ CUDAQ_TEST(QubitQISTester, checkAdjointRegions) {
   EXPECT_TRUE(counts5.begin()->first == "101");
 }
 
+CUDAQ_TEST(QubitQISTester, checkDeepQueuesAndWideControls) {
+  struct wide_ctrl_test {
+    void operator()() __qpu__ {
+      auto apply_x = [](cudaq::qubit &q) { x(q); };
+
+      cudaq::qreg q(7);
+      x(q.front(6));
+      cudaq::control(apply_x, q.front(6), q[6]);
+      mz(q);
+    }
+  };
+
+  struct deep_adjoint_test {
+    void operator()() __qpu__ {
+      auto layers = [](cudaq::qspan<> q) {
+        for (int i = 0; i < 20; i++) {
+          rx(0.1 * i, q[0]);
+          h(q[1]);
+          t<cudaq::ctrl>(q[0], q[1]);
+        }
+      };
+
+      cudaq::qreg q(2);
+      x(q[0]);
+      layers(q);
+      cudaq::adjoint(layers, q);
+      mz(q);
+    }
+  };
+
+  auto counts = cudaq::sample(wide_ctrl_test{});
+  EXPECT_EQ(1, counts.size());
+  EXPECT_TRUE(counts.begin()->first == "1111111");
+
+  auto counts2 = cudaq::sample(deep_adjoint_test{});
+  EXPECT_EQ(1, counts2.size());
+  EXPECT_TRUE(counts2.begin()->first == "10");
+}
+
+CUDAQ_TEST(QubitQISTester, checkNestedAdjointRegions) {
+  struct rotations {
+    void operator()(cudaq::qspan<> q) __qpu__ {
+      ry(0.7, q[0]);
+      t<cudaq::adj>(q[0]);
+      ry(0.3, q[0]);
+      s<cudaq::adj>(q[0]);
+      rx(1.1, q[0]);
+    }
+  };
+
+  // The adjoint of the adjoint applies the gates themselves.
+  struct double_adjoint_test {
+    void operator()() __qpu__ {
+      auto adjoint_rotations = [](cudaq::qspan<> q) {
+        cudaq::adjoint(rotations{}, q);
+      };
+
+      cudaq::qreg q(1);
+      cudaq::adjoint(adjoint_rotations, q);
+      cudaq::adjoint(rotations{}, q);
+      mz(q);
+    }
+  };
+
+  auto counts = cudaq::sample(double_adjoint_test{});
+  EXPECT_EQ(1, counts.size());
+  EXPECT_TRUE(counts.begin()->first == "0");
+}
+
 #endif
@@ -13,6 +13,13 @@
 #include <cudaq.h>
 
 #include "qpud_client.h"
+#include "rpc/client.h"
+#include "llvm/Support/Program.h"
+
+#include <filesystem>
+#include <random>
+#include <thread>
+#include <unistd.h>
 
 TEST(QPUDClientTester, checkSample) {
 
@@ -592,3 +599,549 @@ TEST(QPUDClientTester, checkObserveDetachedWithVector) {
     EXPECT_EQ(2, z1Counts.size());
   }
 }
+
+namespace {
+/// The Quake code of a GHZ kernel, ghz(int N) on N qubits.
+const std::string_view ghzQuakeCode =
+    R"#(module attributes {qtx.mangled_name_map = {__nvqpp__mlirgen__ghz = "_ZN3ghzclEi"}} {
+  func.func @__nvqpp__mlirgen__ghz(%arg0: i32) {
+    %c0_i64 = arith.constant 0 : i64
+    %c1_i32 = arith.constant 1 : i32
+    %c0_i32 = arith.constant 0 : i32
+    %0 = memref.alloca() : memref<i32>
+    memref.store %arg0, %0[] : memref<i32>
+    %1 = memref.load %0[] : memref<i32>
+    %2 = arith.extsi %1 : i32 to i64
+    %3 = quake.alloca(%2 : i64) : !quake.qvec<?>
+    %4 = quake.qextract %3[%c0_i64] : !quake.qvec<?>[i64]  -> !quake.qref
+    quake.h (%4)
+    cc.scope {
+      %9 = memref.alloca() : memref<i32>
+      memref.store %c0_i32, %9[] : memref<i32>
+      cc.loop while {
+        %10 = memref.load %9[] : memref<i32>
+        %11 = memref.load %0[] : memref<i32>
+        %12 = arith.subi %11, %c1_i32 : i32
+        %13 = arith.cmpi slt, %10, %12 : i32
+        cc.condition %13
+      } do {
+        cc.scope {
+          %10 = memref.load %9[] : memref<i32>
+          %11 = arith.extsi %10 : i32 to i64
+          %12 = quake.qextract %3[%11] : !quake.qvec<?>[i64] -> !quake.qref
+          %13 = memref.load %9[] : memref<i32>
+          %14 = arith.addi %13, %c1_i32 : i32
+          %15 = arith.extsi %14 : i32 to i64
+          %16 = quake.qextract %3[%15] : !quake.qvec<?>[i64] -> !quake.qref
+          quake.x [%12 : !quake.qref] (%16)
+        }
+        cc.continue
+      } step {
+        %10 = memref.load %9[] : memref<i32>
+        %11 = arith.addi %10, %c1_i32 : i32
+        memref.store %11, %9[] : memref<i32>
+      }
+    }
+    %5 = quake.qvec_size %3 : (!quake.qvec<?>) -> i64
+    %6 = arith.index_cast %5 : i64 to index
+    %7 = llvm.alloca %5 x i1 : (i64) -> !llvm.ptr<i1>
+    affine.for %arg1 = 0 to %6 {
+      %9 = quake.qextract %3[%arg1] : !quake.qvec<?>[index] -> !quake.qref
+      %10 = quake.mz(%9 : !quake.qref) : i1
+      %11 = arith.index_cast %arg1 : index to i64
+      %12 = llvm.getelementptr %7[%11] : (!llvm.ptr<i1>, i64) -> !llvm.ptr<i1>
+      llvm.store %10, %12 : !llvm.ptr<i1>
+    }
+    %8 = cc.stdvec_init %7, %5 : (!llvm.ptr<i1>, i64) -> !cc.stdvec<i1>
+    return
+  }
+  func.func private @__nvqpp_zeroDynamicResult() -> !llvm.struct<(ptr<i8>, i64)> {
+    %c0_i64 = arith.constant 0 : i64
+    %0 = llvm.inttoptr %c0_i64 : i64 to !llvm.ptr<i8>
+    %1 = llvm.mlir.undef : !llvm.struct<(ptr<i8>, i64)>
+    %2 = llvm.insertvalue %0, %1[0] : !llvm.struct<(ptr<i8>, i64)> 
+    %3 = llvm.insertvalue %c0_i64, %2[1] : !llvm.struct<(ptr<i8>, i64)> 
+    return %3 : !llvm.struct<(ptr<i8>, i64)>
+  }
+  func.func @ghz.thunk(%arg0: !llvm.ptr<i8>, %arg1: i1) -> !llvm.struct<(ptr<i8>, i64)> {
+    %0 = llvm.bitcast %arg0 : !llvm.ptr<i8> to !llvm.ptr<struct<(i32)>>
+    %1 = llvm.load %0 : !llvm.ptr<struct<(i32)>>
+    %2 = llvm.mlir.constant(0 : i64) : i64
+    %3 = llvm.inttoptr %2 : i64 to !llvm.ptr<struct<(i32)>>
+    %4 = llvm.getelementptr %3[1] : (!llvm.ptr<struct<(i32)>>) -> !llvm.ptr<struct<(i32)>>
+    %5 = llvm.ptrtoint %4 : !llvm.ptr<struct<(i32)>> to i64
+    %6 = llvm.getelementptr %arg0[%5] : (!llvm.ptr<i8>, i64) -> !llvm.ptr<i8>
+    %7 = llvm.extractvalue %1[0] : !llvm.struct<(i32)> 
+    call @__nvqpp__mlirgen__ghz(%7) : (i32) -> ()
+    %nil = call @__nvqpp_zeroDynamicResult() : () -> !llvm.struct<(ptr<i8>, i64)>
+    return %nil : !llvm.struct<(ptr<i8>, i64)>
+  }
+})#";
+
+/// The Quake code of the deuteron ansatz, ansatz(double theta).
+const std::string_view ansatzQuakeCode =
+    R"#(module attributes {qtx.mangled_name_map = {__nvqpp__mlirgen__ansatz = "_ZN6ansatzclEd"}} {
+  func.func @__nvqpp__mlirgen__ansatz(%arg0: f64) {
+    %c0_i64 = arith.constant 0 : i64
+    %c1_i64 = arith.constant 1 : i64
+    %0 = memref.alloca() : memref<f64>
+    memref.store %arg0, %0[] : memref<f64>
+    %1 = quake.alloca : !quake.qvec<2>
+    %2 = quake.qextract %1[%c0_i64] : !quake.qvec<2>[i64] -> !quake.qref
+    quake.x (%2)
+    %3 = memref.load %0[] : memref<f64>
+    %4 = quake.qextract %1[%c1_i64] : !quake.qvec<2>[i64] -> !quake.qref
+    quake.ry |%3 : f64|(%4)
+    %5 = quake.qextract %1[%c1_i64] : !quake.qvec<2>[i64] -> !quake.qref
+    %6 = quake.qextract %1[%c0_i64] : !quake.qvec<2>[i64] -> !quake.qref
+    quake.x [%5 : !quake.qref] (%6)
+    return
+  }
+  func.func private @__nvqpp_zeroDynamicResult() -> !llvm.struct<(ptr<i8>, i64)> {
+    %c0_i64 = arith.constant 0 : i64
+    %0 = llvm.inttoptr %c0_i64 : i64 to !llvm.ptr<i8>
+    %1 = llvm.mlir.undef : !llvm.struct<(ptr<i8>, i64)>
+    %2 = llvm.insertvalue %0, %1[0] : !llvm.struct<(ptr<i8>, i64)> 
+    %3 = llvm.insertvalue %c0_i64, %2[1] : !llvm.struct<(ptr<i8>, i64)> 
+    return %3 : !llvm.struct<(ptr<i8>, i64)>
+  }
+  func.func @ansatz.thunk(%arg0: !llvm.ptr<i8>, %arg1: i1) -> !llvm.struct<(ptr<i8>, i64)> {
+    %0 = llvm.bitcast %arg0 : !llvm.ptr<i8> to !llvm.ptr<struct<(f64)>>
+    %1 = llvm.load %0 : !llvm.ptr<struct<(f64)>>
+    %2 = llvm.mlir.constant(0 : i64) : i64
+    %3 = llvm.inttoptr %2 : i64 to !llvm.ptr<struct<(f64)>>
+    %4 = llvm.getelementptr %3[1] : (!llvm.ptr<struct<(f64)>>) -> !llvm.ptr<struct<(f64)>>
+    %5 = llvm.ptrtoint %4 : !llvm.ptr<struct<(f64)>> to i64
+    %6 = llvm.getelementptr %arg0[%5] : (!llvm.ptr<i8>, i64) -> !llvm.ptr<i8>
+    %7 = llvm.extractvalue %1[0] : !llvm.struct<(f64)> 
+    call @__nvqpp__mlirgen__ansatz(%7) : (f64) -> ()
+    %nil = call @__nvqpp_zeroDynamicResult() : () -> !llvm.struct<(ptr<i8>, i64)>
+    return %nil : !llvm.struct<(ptr<i8>, i64)>
+  }
+})#";
+
+/// Check that the counts are those of a GHZ state on n qubits.
+void checkGhzCounts(cudaq::sample_result &counts, int n, std::size_t shots) {
+  std::size_t total = 0;
+  for (auto &[bits, count] : counts) {
+    total += count;
+    EXPECT_TRUE(bits == std::string(n, '0') || bits == std::string(n, '1'))
+        << bits;
+  }
+  EXPECT_EQ(total, shots);
+}
+} // namespace
+
+TEST(QPUDClientTester, checkSampleAndObserveAsync) {
+  cudaq::registry::deviceCodeHolderAdd("ghz", ghzQuakeCode.data());
+  cudaq::registry::deviceCodeHolderAdd("ansatz", ansatzQuakeCode.data());
+  cudaq::qpud_client client;
+
+  // Several requests in flight at once, each one on its own arguments.
+  struct KernelArgs {
+    int N;
+  };
+  const std::size_t shots = 200;
+  std::vector<std::future<cudaq::sample_result>> pendingCounts;
+  for (int n = 2; n <= 5; n++) {
+    KernelArgs args{n};
+    pendingCounts.push_back(
+        client.sample_async("ghz", shots, &args, sizeof(KernelArgs)));
+  }
+  for (int n = 2; n <= 5; n++) {
+    auto counts = pendingCounts[n - 2].get();
+    checkGhzCounts(counts, n, shots);
+  }
+
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+  std::vector<double> thetas{0., 0.3, 0.59, 1.2};
+  std::vector<std::future<cudaq::observe_result>> pendingResults;
+  for (auto &theta : thetas)
+    pendingResults.push_back(
+        client.observe_async("ansatz", h, &theta, sizeof(double)));
+  std::vector<double> energies;
+  for (auto &pending : pendingResults)
+    energies.push_back(pending.get().exp_val_z());
+
+  // The same values as one request at a time.
+  for (std::size_t i = 0; i < thetas.size(); i++)
+    EXPECT_NEAR(energies[i],
+                client.observe("ansatz", h, &thetas[i], sizeof(double)),
+                1e-9);
+  EXPECT_NEAR(energies[2], -1.74, 1e-2);
+}
+
+TEST(QPUDClientTester, checkSampleAndObserveBatch) {
+  cudaq::registry::deviceCodeHolderAdd("ghz", ghzQuakeCode.data());
+  cudaq::registry::deviceCodeHolderAdd("ansatz", ansatzQuakeCode.data());
+  cudaq::qpud_client client;
+
+  struct KernelArgs {
+    int N;
+  };
+  std::vector<KernelArgs> ghzArgs{{2}, {3}, {4}, {5}, {3}};
+  std::vector<std::pair<void *, std::size_t>> argSets;
+  for (auto &args : ghzArgs)
+    argSets.emplace_back(&args, sizeof(KernelArgs));
+  const std::size_t shots = 200;
+  auto pendingCounts = client.sample_batch("ghz", shots, argSets);
+  ASSERT_EQ(pendingCounts.size(), ghzArgs.size());
+
+  // Each future holds the result of its own argument set, whichever order
+  // they are waited on.
+  for (std::size_t i = pendingCounts.size(); i-- > 0;) {
+    auto counts = pendingCounts[i].get();
+    checkGhzCounts(counts, ghzArgs[i].N, shots);
+  }
+
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+  std::vector<double> thetas{0., 0.3, 0.59, 1.2, 2.5};
+  argSets.clear();
+  for (auto &theta : thetas)
+    argSets.emplace_back(&theta, sizeof(double));
+  auto pendingResults = client.observe_batch("ansatz", h, argSets);
+  ASSERT_EQ(pendingResults.size(), thetas.size());
+  for (std::size_t i = 0; i < thetas.size(); i++)
+    EXPECT_NEAR(pendingResults[i].get().exp_val_z(),
+                client.observe("ansatz", h, &thetas[i], sizeof(double)),
+                1e-9);
+
+  // With shots, the counts of every term come back as well.
+  auto sampledResults = client.observe_batch("ansatz", h, argSets, 1000);
+  auto result = sampledResults[2].get();
+  EXPECT_NEAR(result.exp_val_z(), -1.74, 0.2);
+  EXPECT_EQ(result.counts(x(0) * x(1)).size(), 4);
+  EXPECT_EQ(result.counts(z(1)).size(), 2);
+}
+
+namespace {
+/// A client that tells whether its kernel data goes through the buffer it
+/// shares with qpud.
+class SharedBufferClient : public cudaq::qpud_client {
+public:
+  bool usesSharedBuffer() const { return sharedBuffer != nullptr; }
+};
+
+/// Sample and observe through the client, and return the energy.
+double sampleAndObserve(SharedBufferClient &client) {
+  struct KernelArgs {
+    int N = 5;
+  } args;
+  auto counts = client.sample("ghz", 500, args);
+  checkGhzCounts(counts, 5, 500);
+
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+  double theta = 0.59;
+  auto result = client.observe("ansatz", h, &theta, sizeof(double), 1000);
+  EXPECT_EQ(result.counts(z(1)).size(), 2);
+  return client.observe("ansatz", h, &theta, sizeof(double));
+}
+} // namespace
+
+TEST(QPUDClientTester, checkSharedBuffer) {
+  cudaq::registry::deviceCodeHolderAdd("ghz", ghzQuakeCode.data());
+  cudaq::registry::deviceCodeHolderAdd("ansatz", ansatzQuakeCode.data());
+
+  // qpud runs on this host, it attaches the buffer of the client.
+  SharedBufferClient client;
+  const double energy = sampleAndObserve(client);
+  EXPECT_TRUE(client.usesSharedBuffer());
+  EXPECT_NEAR(energy, -1.74, 1e-2);
+}
+
+TEST(QPUDClientTester, checkSharedBufferFallback) {
+  cudaq::registry::deviceCodeHolderAdd("ghz", ghzQuakeCode.data());
+  cudaq::registry::deviceCodeHolderAdd("ansatz", ansatzQuakeCode.data());
+
+  // Without shared memory, the same data goes through RPC.
+  setenv("CUDAQ_QPUD_SHARED_BUFFER", "0", 1);
+  SharedBufferClient client;
+  const double energy = sampleAndObserve(client);
+  unsetenv("CUDAQ_QPUD_SHARED_BUFFER");
+  EXPECT_FALSE(client.usesSharedBuffer());
+  EXPECT_NEAR(energy, -1.74, 1e-2);
+}
+
+namespace {
+/// A qpud proc started by the test with the given arguments, that clients
+/// connect to by url. It is stopped on destruction.
+class QpudProcess {
+  int port;
+  llvm::sys::ProcessInfo info;
+
+public:
+  QpudProcess(const std::vector<std::string> &extraArgs = {}) {
+    std::random_device rd;
+    port = std::uniform_int_distribution<int>(10000, 65534)(rd);
+    std::vector<std::string> args{QPUD_EXECUTABLE, "--port",
+                                  std::to_string(port)};
+    args.insert(args.end(), extraArgs.begin(), extraArgs.end());
+    std::vector<llvm::StringRef> argRefs(args.begin(), args.end());
+    std::string error;
+    bool failed = false;
+    info = llvm::sys::ExecuteNoWait(QPUD_EXECUTABLE, argRefs, std::nullopt,
+                                    {}, 0, &error, &failed);
+    if (failed)
+      throw std::runtime_error("Could not start qpud: " + error);
+
+    // Wait for the server to listen.
+    for (int attempt = 0; attempt < 50; attempt++) {
+      rpc::client probe("127.0.0.1", port);
+      auto state = probe.get_connection_state();
+      while (state == rpc::client::connection_state::initial)
+        state = probe.get_connection_state();
+      if (state == rpc::client::connection_state::connected)
+        return;
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    throw std::runtime_error("qpud did not start listening.");
+  }
+
+  /// Return the url and port of the proc.
+  cudaq::qpud_cluster::endpoint getEndpoint() const {
+    return {"127.0.0.1", port};
+  }
+
+  /// Return a new client of the proc, which leaves it running.
+  std::unique_ptr<cudaq::qpud_client> connect() {
+    return std::make_unique<cudaq::qpud_client>("127.0.0.1", port);
+  }
+
+  ~QpudProcess() {
+    try {
+      rpc::client client("127.0.0.1", port);
+      client.set_timeout(2000);
+      client.call("stopServer");
+    } catch (std::exception &) {
+      // Already stopped, e.g. by a client after an error.
+    }
+    llvm::sys::Wait(info, /*SecondsToWait=*/10, nullptr, nullptr);
+  }
+};
+} // namespace
+
+TEST(QPUDClientTester, checkDetachedResultsOutliveDaemon) {
+  cudaq::registry::deviceCodeHolderAdd("ghz", ghzQuakeCode.data());
+  cudaq::registry::deviceCodeHolderAdd("ansatz", ansatzQuakeCode.data());
+  auto store = std::filesystem::temp_directory_path() /
+               ("qpud-job-store-" + std::to_string(getpid()));
+  std::filesystem::remove_all(store);
+
+  struct KernelArgs {
+    int N = 4;
+  } args;
+  double theta = 0.59;
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+
+  cudaq::detached_job sampleJob, observeJob;
+  cudaq::sample_result counts;
+  double energy = 0.;
+  {
+    QpudProcess qpud({"--job-store", store.string()});
+    auto client = qpud.connect();
+    sampleJob = client->sample_detach("ghz", 500, args);
+    observeJob = client->observe_detach("ansatz", h, &theta, sizeof(double));
+
+    // The results are kept by the daemon, for any of its clients.
+    auto other = qpud.connect();
+    counts = other->sample(sampleJob);
+    checkGhzCounts(counts, 4, 500);
+    energy = other->observe(h, observeJob);
+    EXPECT_NEAR(energy, -1.74, 1e-2);
+  }
+
+  // A later daemon on the same store reads them back from disk.
+  QpudProcess qpud({"--job-store", store.string()});
+  auto client = qpud.connect();
+  EXPECT_EQ(client->sample(sampleJob).to_map(), counts.to_map());
+  EXPECT_NEAR(client->observe(h, observeJob), energy, 1e-12);
+
+  cudaq::detached_job unknownJob;
+  unknownJob.emplace_back("ghz.sample", "NoSuchJob");
+  EXPECT_THROW(client->sample(unknownJob), std::runtime_error);
+  std::filesystem::remove_all(store);
+}
+
+TEST(QPUDClientTester, checkConcurrentClients) {
+  cudaq::registry::deviceCodeHolderAdd("ghz", ghzQuakeCode.data());
+  cudaq::registry::deviceCodeHolderAdd("ansatz", ansatzQuakeCode.data());
+  QpudProcess qpud({"--workers", "4"});
+
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+  const int numClients = 4;
+  std::vector<double> thetas, energies;
+  for (int i = 0; i < numClients; i++) {
+    thetas.push_back(0.3 * i);
+    energies.push_back(
+        qpud.connect()->observe("ansatz", h, &thetas[i], sizeof(double)));
+  }
+
+  // Each client has its own session, in which both kernels are loaded
+  // concurrently, and then run on the arguments of that client only.
+  std::vector<std::unique_ptr<cudaq::qpud_client>> clients;
+  for (int i = 0; i < numClients; i++)
+    clients.push_back(qpud.connect());
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numClients; i++)
+    threads.emplace_back([&, i]() {
+      auto &client = *clients[i];
+      struct KernelArgs {
+        int N;
+      } args{2 + i};
+      auto spinOp = h;
+      double theta = thetas[i];
+      for (int round = 0; round < 10; round++) {
+        auto counts = client.sample("ghz", 100, args);
+        checkGhzCounts(counts, 2 + i, 100);
+        EXPECT_NEAR(client.observe("ansatz", spinOp, &theta, sizeof(double)),
+                    energies[i], 1e-9);
+      }
+    });
+  for (auto &thread : threads)
+    thread.join();
+}
+
+namespace {
+/// Return the number of kernel objects in the object cache directory.
+std::size_t countCachedObjects(const std::filesystem::path &dir) {
+  std::size_t count = 0;
+  if (std::filesystem::exists(dir))
+    for (auto &entry : std::filesystem::directory_iterator(dir))
+      count += entry.path().extension() == ".o";
+  return count;
+}
+} // namespace
+
+TEST(QPUDClientTester, checkTieredCompilation) {
+  cudaq::registry::deviceCodeHolderAdd("ghz", ghzQuakeCode.data());
+  auto cache = std::filesystem::temp_directory_path() /
+               ("qpud-object-cache-" + std::to_string(getpid()));
+  std::filesystem::remove_all(cache);
+  const std::vector<std::string> tieredArgs{"--object-cache", cache.string(),
+                                            "--opt-level",    "2",
+                                            "--tier-up-calls", "3"};
+  struct KernelArgs {
+    int N = 3;
+  } args;
+  auto sampleGhz = [&](cudaq::qpud_client &client) {
+    auto counts = client.sample("ghz", 100, args);
+    checkGhzCounts(counts, 3, 100);
+  };
+
+  {
+    // The kernel is first compiled unoptimized.
+    QpudProcess qpud(tieredArgs);
+    auto client = qpud.connect();
+    sampleGhz(*client);
+    EXPECT_EQ(countCachedObjects(cache), 1);
+
+    // Its third call has it recompiled optimized in the background, while
+    // it keeps running.
+    sampleGhz(*client);
+    sampleGhz(*client);
+    for (int wait = 0; wait < 300 && countCachedObjects(cache) < 2; wait++) {
+      sampleGhz(*client);
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    EXPECT_EQ(countCachedObjects(cache), 2);
+    sampleGhz(*client);
+  }
+
+  {
+    // A later daemon loads the cached optimized object, and compiles
+    // nothing.
+    QpudProcess qpud(tieredArgs);
+    auto client = qpud.connect();
+    for (int call = 0; call < 5; call++)
+      sampleGhz(*client);
+    EXPECT_EQ(countCachedObjects(cache), 2);
+  }
+  std::filesystem::remove_all(cache);
+
+  {
+    // Without tiering, the kernel is compiled optimized once.
+    QpudProcess qpud({"--object-cache", cache.string(), "--opt-level", "2",
+                      "--tier-up-calls", "0"});
+    auto client = qpud.connect();
+    for (int call = 0; call < 5; call++)
+      sampleGhz(*client);
+    EXPECT_EQ(countCachedObjects(cache), 1);
+  }
+  std::filesystem::remove_all(cache);
+}
+
+TEST(QPUDClientTester, checkCluster) {
+  cudaq::registry::deviceCodeHolderAdd("ghz", ghzQuakeCode.data());
+  cudaq::registry::deviceCodeHolderAdd("ansatz", ansatzQuakeCode.data());
+
+  // Each daemon compiles every kernel it runs once into its own object
+  // cache, which tells which daemons got a share of the work.
+  std::vector<std::filesystem::path> caches;
+  std::vector<std::unique_ptr<QpudProcess>> daemons;
+  for (int i = 0; i < 2; i++) {
+    caches.push_back(std::filesystem::temp_directory_path() /
+                     ("qpud-cluster-cache-" + std::to_string(getpid()) + "-" +
+                      std::to_string(i)));
+    std::filesystem::remove_all(caches[i]);
+    daemons.push_back(std::make_unique<QpudProcess>(std::vector<std::string>{
+        "--object-cache", caches[i].string(), "--opt-level", "2",
+        "--tier-up-calls", "0"}));
+  }
+  cudaq::qpud_cluster cluster(
+      {daemons[0]->getEndpoint(), daemons[1]->getEndpoint()});
+  EXPECT_EQ(cluster.num_healthy(), 2);
+
+  // The qubit-wise commuting groups of the terms are spread over both
+  // daemons, and their energies reduced.
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) +
+                     .21829 * z(0) - 6.125 * z(1);
+  double theta = 0.59;
+  const double energy =
+      daemons[0]->connect()->observe("ansatz", h, &theta, sizeof(double));
+  EXPECT_NEAR(cluster.observe("ansatz", h, &theta, sizeof(double)).exp_val_z(),
+              energy, 1e-9);
+  for (auto &cache : caches)
+    EXPECT_EQ(countCachedObjects(cache), 1);
+
+  // The shots are split over both daemons, and their counts merged.
+  struct KernelArgs {
+    int N = 4;
+  } args;
+  auto counts = cluster.sample("ghz", 1001, &args, sizeof(KernelArgs));
+  checkGhzCounts(counts, 4, 1001);
+  for (auto &cache : caches)
+    EXPECT_EQ(countCachedObjects(cache), 2);
+
+  // Once a daemon is down, the next health check leaves the other one all
+  // the work.
+  const auto downEndpoint = daemons[1]->getEndpoint();
+  daemons[1].reset();
+  EXPECT_EQ(cluster.check_health(std::chrono::milliseconds(500)), 1);
+  EXPECT_EQ(cluster.num_healthy(), 1);
+  counts = cluster.sample("ghz", 1001, &args, sizeof(KernelArgs));
+  checkGhzCounts(counts, 4, 1001);
+  EXPECT_NEAR(cluster.observe("ansatz", h, &theta, sizeof(double)).exp_val_z(),
+              energy, 1e-9);
+
+  // A cluster skips the unreachable endpoints, and needs a healthy one.
+  cudaq::qpud_cluster partial({daemons[0]->getEndpoint(), downEndpoint});
+  EXPECT_EQ(partial.num_healthy(), 1);
+  EXPECT_NEAR(partial.observe("ansatz", h, &theta, sizeof(double)).exp_val_z(),
+              energy, 1e-9);
+  EXPECT_THROW(cudaq::qpud_cluster({downEndpoint}), std::runtime_error);
+
+  daemons.clear();
+  for (auto &cache : caches)
+    std::filesystem::remove_all(cache);
+}
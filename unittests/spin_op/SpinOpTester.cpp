@@ -7,8 +7,11 @@
  *******************************************************************************/
 
 #include <gtest/gtest.h>
+#include <map>
+#include <random>
 
 #include "cudaq/spin_op.h"
+#include <filesystem>
 
 using namespace cudaq::spin;
 
@@ -120,3 +123,435 @@ TEST(SpinOpTester, canBuildDeuteron) {
     H[i].dump();
   }
 }
+
+TEST(SpinOpTester, checkQubitWiseCommutingGroups) {
+  auto H = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) + .21829 * z(0) -
+           6.125 * z(1) + z(0) * z(1) + x(0);
+
+  // {x0 x1, x0}, {y0 y1}, {z0, z1, z0 z1}, the identity is in no group.
+  auto groups = H.get_qubit_wise_commuting_groups();
+  EXPECT_EQ(3, groups.size());
+
+  std::size_t nGrouped = 0;
+  auto bsf = H.get_bsf();
+  for (auto &group : groups) {
+    nGrouped += group.size();
+    for (auto t : group)
+      for (auto u : group)
+        for (std::size_t q = 0; q < H.n_qubits(); q++) {
+          bool tActs = bsf[t][q] || bsf[t][q + 2];
+          bool uActs = bsf[u][q] || bsf[u][q + 2];
+          if (tActs && uActs) {
+            EXPECT_EQ(bsf[t][q], bsf[u][q]);
+            EXPECT_EQ(bsf[t][q + 2], bsf[u][q + 2]);
+          }
+        }
+  }
+  EXPECT_EQ(H.n_terms() - 1, nGrouped);
+}
+
+TEST(SpinOpTester, checkMultiTermMultiplication) {
+  std::cout << "Z * X: iY\n";
+  EXPECT_EQ(y(0), z(0) * x(0));
+  EXPECT_EQ((z(0) * x(0)).get_term_coefficient(0), std::complex<double>(0, 1));
+
+  // (X0 + Z0) * (X0 - Z0) = I - X0 Z0 + Z0 X0 - I = 2i Y0
+  auto product = (x(0) + z(0)) * (x(0) - z(0));
+  product.dump();
+  EXPECT_EQ(1, product.n_terms());
+  EXPECT_EQ(y(0), product);
+  EXPECT_EQ(product.get_term_coefficient(0), std::complex<double>(0, 2));
+
+  // (X0 + Y1) * (X0 + Y1) = 2 I + 2 X0 Y1
+  auto square = (x(0) + y(1)) * (x(0) + y(1));
+  square.dump();
+  EXPECT_EQ(2, square.n_terms());
+  EXPECT_EQ(2.0 + 2.0 * x(0) * y(1), square);
+}
+
+TEST(SpinOpTester, checkManyQubits) {
+  // Terms spanning several words of the packed representation.
+  auto op = x(3) * y(70) * z(130);
+  EXPECT_EQ(131, op.n_qubits());
+  EXPECT_EQ(3, op.n_words());
+
+  auto *term = op.get_term_data(0);
+  EXPECT_EQ(1ULL << 3, term[0]);
+  EXPECT_EQ(1ULL << 6, term[1]);
+  EXPECT_EQ(0, term[2]);
+  EXPECT_EQ(0, term[3]);
+  EXPECT_EQ(1ULL << 6, term[4]);
+  EXPECT_EQ(1ULL << 2, term[5]);
+
+  std::size_t nPaulis = 0;
+  op.for_each_pauli([&](cudaq::pauli p, std::size_t q) {
+    if (p == cudaq::pauli::I)
+      return;
+    nPaulis++;
+    EXPECT_EQ(q == 3    ? cudaq::pauli::X
+              : q == 70 ? cudaq::pauli::Y
+                        : cudaq::pauli::Z,
+              p);
+  });
+  EXPECT_EQ(3, nPaulis);
+
+  // Y70 * Y70 = I, Z130 * X130 = i Y130
+  auto product = op * (y(70) * x(130));
+  EXPECT_EQ(x(3) * y(130), product);
+  EXPECT_EQ(product.get_term_coefficient(0), std::complex<double>(0, 1));
+
+  auto bsf = (x(100) + z(1)).get_bsf();
+  EXPECT_EQ(2, bsf.size());
+  EXPECT_EQ(202, bsf[0].size());
+  EXPECT_TRUE(bsf[0][100]);
+  EXPECT_TRUE(bsf[1][101 + 1]);
+}
+
+TEST(SpinOpTester, checkTermAccumulation) {
+  // Z_i Z_{i+1} for i < 100 and X_i for i < 100, each added twice.
+  cudaq::spin_op H = 0.0 * cudaq::spin_op();
+  for (int repeat = 0; repeat < 2; repeat++)
+    for (std::size_t i = 0; i < 100; i++) {
+      H += 0.5 * z(i) * z(i + 1);
+      H += x(i);
+    }
+  EXPECT_EQ(200, H.n_terms());
+  EXPECT_EQ(101, H.n_qubits());
+  for (auto c : H.get_coefficients())
+    EXPECT_TRUE(c == 1.0 || c == 2.0);
+
+  // Cancel every other term, later additions still find the remaining ones.
+  for (std::size_t i = 0; i < 100; i += 2)
+    H -= 2.0 * x(i);
+  EXPECT_EQ(150, H.n_terms());
+  H += z(1) * z(2);
+  EXPECT_EQ(150, H.n_terms());
+  H += x(0);
+  EXPECT_EQ(151, H.n_terms());
+  EXPECT_EQ(x(0) * i(100), H[150]);
+  std::size_t nFound = 0;
+  for (std::size_t t = 0; t < H.n_terms(); t++)
+    if (H[t] == z(1) * z(2) * i(100)) {
+      EXPECT_EQ(2.0, H.get_term_coefficient(t));
+      nFound++;
+    }
+  EXPECT_EQ(1, nFound);
+}
+
+TEST(SpinOpTester, checkBuilder) {
+  using cudaq::pauli;
+  auto expectEqual = [](const cudaq::spin_op &a, const cudaq::spin_op &b) {
+    EXPECT_EQ(a.n_qubits(), b.n_qubits());
+    for (auto c : (a - b).get_coefficients())
+      EXPECT_NEAR(std::abs(c), 0., 1e-12);
+  };
+
+  // A transverse field Ising chain across the 64 qubit word boundary.
+  cudaq::spin_op_builder builder;
+  cudaq::spin_op H = 0.0 * cudaq::spin_op();
+  for (std::size_t i = 0; i < 70; i++) {
+    builder.add(-1.0, {{pauli::Z, i}, {pauli::Z, i + 1}});
+    builder.add(0.5, {{pauli::X, i}});
+    H -= z(i) * z(i + 1);
+    H += 0.5 * x(i);
+  }
+  builder.add(0.25, {});
+  builder.add(0.25, "");
+  H += 0.5 * cudaq::spin_op();
+  EXPECT_EQ(141, builder.n_terms());
+  expectEqual(H, builder.build());
+  EXPECT_EQ(0, builder.n_terms());
+
+  // Factors on the same qubit are multiplied, equal terms merged.
+  builder.add(2.0, {{pauli::X, 0}, {pauli::Y, 0}, {pauli::Z, 1}});
+  builder.add({0, 1}, "ZY");
+  builder.add(x(2) * y(1));
+  builder += -1.0 * x(2) * y(1);
+  EXPECT_EQ(3, builder.n_terms());
+  expectEqual(2.0 * x(0) * y(0) * z(1) + std::complex<double>{0, 1} * z(0) *
+                                             y(1) * i(2),
+              builder.build());
+
+  // Everything cancels out.
+  builder.add(1.0, "XX");
+  builder.add(-1.0, {{pauli::X, 1}, {pauli::X, 0}});
+  auto empty = builder.build();
+  EXPECT_EQ(1, empty.n_terms());
+  EXPECT_EQ(0.0, empty.get_term_coefficient(0));
+  EXPECT_ANY_THROW(builder.add(1.0, "XA"));
+}
+
+TEST(SpinOpTester, checkLargeProduct) {
+  // 300 x 300 term pairs are split over threads, the result has to match
+  // the sum of the products of each lhs term. The operators come from a
+  // seeded generator so that a failure can be reproduced.
+  std::mt19937 gen(1234);
+  auto randomOp = [&](std::size_t nQubits, std::size_t nTerms) {
+    std::vector<std::vector<bool>> bsf;
+    for (std::size_t i = 0; i < nTerms; i++) {
+      std::vector<bool> termData(2 * nQubits);
+      std::fill_n(termData.begin(), nQubits, true);
+      std::shuffle(termData.begin(), termData.end(), gen);
+      bsf.push_back(termData);
+    }
+    std::vector<std::complex<double>> coeffs(nTerms, 1.0);
+    return cudaq::spin_op::from_binary_symplectic(bsf, coeffs);
+  };
+  auto A = randomOp(12, 300);
+  auto B = randomOp(12, 300);
+  auto product = A * B;
+
+  cudaq::spin_op expected = A[0] * B;
+  for (std::size_t t = 1; t < A.n_terms(); t++)
+    expected += A[t] * B;
+  // Terms that cancel in between are appended again by +=, so compare
+  // regardless of the term order.
+  EXPECT_EQ(expected.n_terms(), product.n_terms());
+  std::map<std::string, std::complex<double>> expectedCoeffs;
+  for (std::size_t t = 0; t < expected.n_terms(); t++)
+    expectedCoeffs[expected[t].to_string(false)] =
+        expected.get_term_coefficient(t);
+  for (std::size_t t = 0; t < product.n_terms(); t++) {
+    auto iter = expectedCoeffs.find(product[t].to_string(false));
+    ASSERT_TRUE(iter != expectedCoeffs.end());
+    EXPECT_NEAR(std::abs(iter->second - product.get_term_coefficient(t)), 0.0,
+                1e-9);
+  }
+}
+
+TEST(SpinOpTester, checkCommutator) {
+  // [X, Y] = 2iZ
+  auto xy = cudaq::commutator(x(0), y(0));
+  EXPECT_EQ(1, xy.n_terms());
+  EXPECT_EQ(z(0), xy);
+  EXPECT_EQ(std::complex<double>(0, 2), xy.get_term_coefficient(0));
+
+  // Terms on different qubits commute.
+  EXPECT_EQ(0, cudaq::commutator(x(0), z(1)).n_terms());
+  EXPECT_EQ(0, cudaq::commutator(x(0) * x(1), z(0) * z(1)).n_terms());
+
+  // The commutator matches A * B - B * A, without the commuting terms.
+  auto A = 0.5 * x(0) * z(1) + y(1) - 2.0 * z(0) * z(2);
+  auto B = z(0) + 0.25 * x(1) * y(2) + x(0) * x(1);
+  auto AB = cudaq::commutator(A, B);
+  auto expected = A * B - B * A;
+  EXPECT_EQ(expected.n_terms(), AB.n_terms());
+  for (std::size_t t = 0; t < AB.n_terms(); t++) {
+    std::size_t nFound = 0;
+    for (std::size_t u = 0; u < expected.n_terms(); u++)
+      if (expected[u] == AB[t]) {
+        EXPECT_NEAR(std::abs(expected.get_term_coefficient(u) -
+                             AB.get_term_coefficient(t)),
+                    0.0, 1e-12);
+        nFound++;
+      }
+    EXPECT_EQ(1, nFound);
+  }
+}
+
+TEST(SpinOpTester, checkTermViews) {
+  auto H = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) + .21829 * z(0) -
+           6.125 * z(1);
+
+  std::size_t t = 0;
+  for (auto term : H.terms()) {
+    auto copy = H[t];
+    EXPECT_EQ(copy.to_string(false), term.to_string(false));
+    EXPECT_EQ(copy.to_string(), term.to_string());
+    EXPECT_EQ(copy.get_term_coefficient(0), term.get_coefficient());
+    EXPECT_EQ(copy.is_identity(), term.is_identity());
+    EXPECT_EQ(H.get_term_data(t), term.data());
+    t++;
+  }
+  EXPECT_EQ(H.n_terms(), t);
+  EXPECT_EQ(H.n_terms(), std::distance(H.terms().begin(), H.terms().end()));
+
+  auto term = H.terms()[2];
+  EXPECT_EQ("Y0Y1", term.to_string(false));
+  EXPECT_EQ(cudaq::pauli::Y, term.get_pauli(1));
+  EXPECT_TRUE(H.get_term(0).is_identity());
+}
+
+TEST(SpinOpTester, checkMappedSpinOp) {
+  auto H = cudaq::spin_op::random(70, 100);
+  auto fileName =
+      (std::filesystem::temp_directory_path() / "mapped_spin_op_test.bin")
+          .string();
+  cudaq::mapped_spin_op::write(fileName, H);
+  EXPECT_TRUE(cudaq::mapped_spin_op::is_mapped_format(fileName));
+
+  {
+    cudaq::mapped_spin_op mapped(fileName);
+    EXPECT_EQ(H.n_qubits(), mapped.n_qubits());
+    EXPECT_EQ(H.n_terms(), mapped.n_terms());
+    std::size_t t = 0;
+    for (auto term : mapped.terms()) {
+      EXPECT_EQ(H.get_term(t).to_string(), term.to_string());
+      t++;
+    }
+    EXPECT_EQ(H.n_terms(), t);
+
+    // The chunks hold all terms in order.
+    std::size_t nChunks = 0;
+    t = 0;
+    mapped.for_each_chunk(30, [&](cudaq::spin_op &chunk) {
+      EXPECT_EQ(nChunks < 3 ? 30 : 10, chunk.n_terms());
+      for (auto term : chunk.terms())
+        EXPECT_EQ(H.get_term(t++).to_string(), term.to_string());
+      nChunks++;
+    });
+    EXPECT_EQ(4, nChunks);
+    EXPECT_EQ(H.to_string(), mapped.to_spin_op().to_string());
+  }
+
+  cudaq::binary_spin_op_reader reader;
+  EXPECT_EQ(H.to_string(), reader.read(fileName).to_string());
+  std::filesystem::remove(fileName);
+}
+
+TEST(SpinOpTester, checkSparseMatrix) {
+  // Qubit 0 is the most significant bit of the index.
+  auto zMatrix = (z(0) * i(1)).to_sparse_matrix();
+  EXPECT_EQ(4, zMatrix.n_rows);
+  EXPECT_EQ(4, zMatrix.nnz());
+  std::vector<std::complex<double>> expectedDiagonal{1., 1., -1., -1.};
+  for (std::size_t r = 0; r < 4; r++) {
+    EXPECT_EQ(r, zMatrix.column_indices[zMatrix.row_offsets[r]]);
+    EXPECT_EQ(expectedDiagonal[r], zMatrix.values[zMatrix.row_offsets[r]]);
+  }
+
+  // Y on qubit 1 maps |00> to i|01>.
+  auto xyMatrix = (x(0) * y(1)).to_sparse_matrix();
+  EXPECT_EQ(4, xyMatrix.nnz());
+  EXPECT_EQ(3, xyMatrix.column_indices[xyMatrix.row_offsets[0]]);
+  EXPECT_EQ(std::complex<double>(0, -1),
+            xyMatrix.values[xyMatrix.row_offsets[0]]);
+  EXPECT_EQ(std::complex<double>(0, 1),
+            xyMatrix.values[xyMatrix.row_offsets[3]]);
+
+  // The cancelling entries of XX + YY are not stored.
+  auto hopping = (x(0) * x(1) + y(0) * y(1)).to_sparse_matrix();
+  EXPECT_EQ(2, hopping.nnz());
+  EXPECT_EQ(2., hopping.values[0]);
+
+  auto product = hopping * std::vector<std::complex<double>>{0., 1., 0., 0.};
+  EXPECT_EQ(2., product[2]);
+}
+
+TEST(SpinOpTester, checkExactGroundState) {
+  auto H = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(1) + .21829 * z(0) -
+           6.125 * z(1);
+  EXPECT_NEAR(-1.7488, cudaq::exact_ground_state(H), 1e-3);
+
+  // The ground state of the periodic Heisenberg ring of 4 qubits is -8.
+  cudaq::spin_op ring = x(0) * x(1) + y(0) * y(1) + z(0) * z(1);
+  for (std::size_t q = 1; q < 4; q++)
+    ring += x(q) * x((q + 1) % 4) + y(q) * y((q + 1) % 4) +
+            z(q) * z((q + 1) % 4);
+  EXPECT_NEAR(-8.0, cudaq::exact_ground_state(ring), 1e-8);
+
+  // Above the parallel thresholds, the open XX chain of 14 qubits. It maps to
+  // free fermions of energies 4 cos(pi k / 15), the negative ones are filled.
+  cudaq::spin_op chain = x(0) * x(1) + y(0) * y(1);
+  for (std::size_t q = 1; q + 1 < 14; q++)
+    chain += x(q) * x(q + 1) + y(q) * y(q + 1);
+  double expected = 0.0;
+  for (std::size_t k = 1; k <= 14; k++)
+    expected += std::min(4. * std::cos(M_PI * k / 15), 0.0);
+  EXPECT_NEAR(expected, cudaq::exact_ground_state(chain), 1e-8);
+}
+
+TEST(SpinOpTester, checkStaticSpinOp) {
+  constexpr cudaq::static_spin_op<3, 3> H({"XXI", "IYY", "ZIZ"},
+                                          {1., 2., -.5});
+  static_assert(H.get_term_data(0)[0] == 0b011 && H.get_term_data(0)[1] == 0);
+  static_assert(H.get_term_data(1)[0] == 0b110 &&
+                H.get_term_data(1)[1] == 0b110);
+  static_assert(H.get_term_data(2)[0] == 0 && H.get_term_data(2)[1] == 0b101);
+
+  auto expected = x(0) * x(1) + 2. * y(1) * y(2) - .5 * z(0) * z(2);
+  auto op = H.to_spin_op();
+  EXPECT_EQ(expected.to_string(false), op.to_string(false));
+  EXPECT_EQ(expected.get_coefficients(), op.get_coefficients());
+  std::size_t t = 0;
+  for (auto term : H.terms()) {
+    EXPECT_EQ(expected.get_term(t).to_string(false), term.to_string(false));
+    EXPECT_EQ(expected.get_term_coefficient(t++), term.get_coefficient());
+  }
+
+  auto product = op * op;
+  EXPECT_EQ((expected * expected).to_string(false), product.to_string(false));
+}
+
+TEST(SpinOpTester, checkPackedRepresentation) {
+  using namespace cudaq::spin;
+  auto H = 5.907 - 2.1433 * x(0) * x(1) - 2.1433 * y(0) * y(70) +
+           std::complex<double>{.21829, -1.} * z(0) - 6.125 * z(70);
+  auto packed = H.getPackedRepresentation();
+  EXPECT_EQ(3 + H.n_terms() * (2 * H.n_words() + 2), packed.size());
+
+  auto unpacked = cudaq::spin_op::fromPackedRepresentation(packed);
+  EXPECT_EQ(H.n_qubits(), unpacked.n_qubits());
+  EXPECT_EQ(H.to_string(false), unpacked.to_string(false));
+  EXPECT_EQ(H.get_coefficients(), unpacked.get_coefficients());
+  EXPECT_TRUE(H == unpacked);
+
+  packed.pop_back();
+  EXPECT_ANY_THROW(cudaq::spin_op::fromPackedRepresentation(packed));
+}
+
+TEST(SpinOpTester, checkSelect) {
+  using namespace cudaq::spin;
+  cudaq::spin_op h = 2.0 * x(0) + 3.0 * z(1) * y(2) - i(0) + 0.5 * y(3);
+  auto selected = h.select({3, 1});
+  EXPECT_EQ(selected.n_terms(), 2);
+  EXPECT_EQ(selected.get_term(0).to_string(), h.get_term(3).to_string());
+  EXPECT_EQ(selected.get_term(1).to_string(), h.get_term(1).to_string());
+  EXPECT_EQ(selected.n_qubits(), h.n_qubits());
+  EXPECT_ANY_THROW(h.select({4}));
+}
+
+TEST(SpinOpTester, checkSimplify) {
+  constexpr cudaq::static_spin_op<2, 4> H({"XX", "ZI", "XX", "YY"},
+                                          {1., 1e-9, 2., 1e-5});
+  auto op = H.to_spin_op();
+  EXPECT_EQ(4, op.n_terms());
+  op.simplify();
+  EXPECT_EQ(3, op.n_terms());
+  EXPECT_EQ(3., op.get_term_coefficient(0));
+  op.simplify(1e-4);
+  EXPECT_EQ(1, op.n_terms());
+  EXPECT_EQ("X0X1", op.to_string(false));
+}
+
+TEST(SpinOpTester, checkTaperQubits) {
+  // The H2 molecule in the STO-3G basis, Jordan-Wigner encoded.
+  auto H = -0.09886397 + 0.17119775 * z(0) + 0.17119775 * z(1) -
+           0.22278593 * z(2) - 0.22278593 * z(3) + 0.16862219 * z(0) * z(1) +
+           0.12054482 * z(0) * z(2) + 0.16586702 * z(0) * z(3) +
+           0.16586702 * z(1) * z(2) + 0.12054482 * z(1) * z(3) +
+           0.17434844 * z(2) * z(3) - 0.0453222 * x(0) * x(1) * y(2) * y(3) +
+           0.0453222 * x(0) * y(1) * y(2) * x(3) +
+           0.0453222 * y(0) * x(1) * x(2) * y(3) -
+           0.0453222 * y(0) * y(1) * x(2) * x(3);
+
+  // The symmetries are the even products of Z.
+  auto symmetries = cudaq::find_z2_symmetries(H);
+  EXPECT_EQ(3, symmetries.size());
+  for (auto &symmetry : symmetries)
+    EXPECT_EQ(0, cudaq::commutator(H, symmetry).n_terms());
+
+  // The ground state is in one of the sectors.
+  double groundState = cudaq::exact_ground_state(H);
+  double lowest = 0.0;
+  for (int s = 0; s < 8; s++) {
+    std::vector<int> sector{s & 1 ? -1 : 1, s & 2 ? -1 : 1, s & 4 ? -1 : 1};
+    auto tapered = cudaq::taper_qubits(H, sector);
+    EXPECT_EQ(1, tapered.op.n_qubits());
+    EXPECT_EQ(3, tapered.tapered_qubits.size());
+    auto energy = cudaq::exact_ground_state(tapered.op);
+    EXPECT_GE(energy, groundState - 1e-8);
+    lowest = std::min(lowest, energy);
+  }
+  EXPECT_NEAR(groundState, lowest, 1e-8);
+}
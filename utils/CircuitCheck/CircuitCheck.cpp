@@ -36,9 +36,16 @@ static cl::opt<bool> printUnitary("print-unitary",
                                   cl::desc("Print the unitary of each circuit"),
                                   cl::init(false));
 
+static cl::opt<unsigned> numProbes(
+    "probes",
+    cl::desc("Compare the circuits applied to this many random product states "
+             "instead of their unitaries, for circuits too large for the "
+             "unitary to fit in memory (0: compare the unitaries)"),
+    cl::init(0));
+
 static LogicalResult computeUnitary(mlir::Operation *op,
                                     cudaq::UnitaryBuilder::UMatrix &unitary) {
-  cudaq::UnitaryBuilder builder(unitary);
+  cudaq::UnitaryBuilder builder(unitary, numProbes);
   if (auto func = dyn_cast_if_present<func::FuncOp>(op)) {
     auto a = builder.build(func);
     return a;
@@ -8,7 +8,9 @@
 
 #include "UnitaryBuilder.h"
 #include "cudaq/Optimizer/Dialect/Quake/QuakeInterfaces.h"
+#include <array>
 #include <numeric>
+#include <random>
 
 using namespace cudaq;
 using namespace mlir;
@@ -159,19 +161,43 @@ Optional<int64_t> UnitaryBuilder::getValueAsInt(Value value) {
 
 void UnitaryBuilder::applyOperator(ArrayRef<Complex> m, OperandRange controls,
                                    OperandRange targets) {
-  auto qubits = getQubits(controls, targets);
-  if (qubits.size() == 1u) {
-    applyMatrix(m, qubits);
-    return;
-  }
-  if (targets.size() == 1) {
-    applyControlledMatrix(m, qubits);
-    return;
-  }
-  applyMatrix(m, targets.size(), qubits);
+  applyMatrix(m, getQubits(controls), getQubits(targets));
+}
+
+/// Returns a random single-qubit state of the probe `probe`, drawn from
+/// `seed` and the qubit index only.
+static std::array<std::complex<double>, 2>
+randomQubitState(std::uint64_t seed, unsigned probe, unsigned qubit) {
+  std::seed_seq seq{static_cast<std::uint32_t>(seed),
+                    static_cast<std::uint32_t>(seed >> 32), probe, qubit};
+  std::mt19937_64 gen(seq);
+  std::uniform_real_distribution<double> uniform(0., 1.);
+  // Uniform on the Bloch sphere.
+  const double theta = std::acos(1. - 2. * uniform(gen));
+  const double phi = 2. * M_PI * uniform(gen);
+  return {std::cos(theta / 2.), std::polar(std::sin(theta / 2.), phi)};
 }
 
 void UnitaryBuilder::growMatrix(unsigned numQubits) {
+  if (numProbes) {
+    // The new qubits are the most significant ones, every probe is extended
+    // by the tensor product with their random states.
+    if (matrix.size() == 0)
+      matrix = UMatrix::Ones(1, numProbes);
+    const Qubit first = getNextQubit();
+    UMatrix m(matrix.rows() << numQubits, numProbes);
+    for (unsigned p = 0; p < numProbes; ++p) {
+      m.col(p).head(matrix.rows()) = matrix.col(p);
+      for (unsigned i = 0; i < numQubits; ++i) {
+        const auto state = randomQubitState(seed, p, first + i);
+        const Eigen::Index size = m.rows() >> (numQubits - i);
+        m.col(p).segment(size, size) = state[1] * m.col(p).head(size);
+        m.col(p).head(size) *= state[0];
+      }
+    }
+    matrix.swap(m);
+    return;
+  }
   if (matrix.size() == 0) {
     matrix = UMatrix::Identity((1 << numQubits), (1 << numQubits));
     return;
@@ -239,81 +265,61 @@ void UnitaryBuilder::growMatrix(unsigned numQubits) {
 //         | i j k l |                         c, g, k, o,
 //         | m n o p |                         d, h, l, p ]
 
-static unsigned first_idx(const std::vector<UnitaryBuilder::Qubit> &qubits,
-                          unsigned k) {
-  unsigned lowBits;
-  unsigned result = k;
-  for (unsigned j = 0u, end = qubits.size(); j < end; ++j) {
-    lowBits = result & ((1 << qubits.at(j)) - 1);
-    result >>= qubits.at(j);
-    result <<= qubits.at(j) + 1;
-    result |= lowBits;
+/// Inserts a zero bit into `k` at the position of each of the `sortedQubits`,
+/// in increasing order.
+static std::size_t insertZeroBits(ArrayRef<UnitaryBuilder::Qubit> sortedQubits,
+                                  std::size_t k) {
+  for (auto qubit : sortedQubits) {
+    const std::size_t lowBits = k & ((std::size_t(1) << qubit) - 1);
+    k = ((k >> qubit) << (qubit + 1)) | lowBits;
   }
-  return result;
+  return k;
 }
 
-static std::vector<unsigned>
-indicies(const std::vector<UnitaryBuilder::Qubit> &qubits,
-         const std::vector<UnitaryBuilder::Qubit> &qubitsSorted, unsigned k) {
-  std::vector<unsigned> result((1 << qubits.size()), 0u);
-  result.at(0) = first_idx(qubitsSorted, k);
-  for (unsigned i = 0u, end = qubits.size(); i < end; ++i) {
-    const unsigned n = (1u << i);
-    const unsigned bit = (1u << qubits.at(i));
-    for (size_t j = 0; j < n; j++) {
-      result.at(n + j) = result.at(j) | bit;
-    }
-  }
-  return result;
-}
+/// The number of matrix elements from which operators are applied in
+/// parallel.
+static constexpr std::size_t minParallelSize = 1 << 14;
 
 // TODO:  Optimize!  There are ways to specialize for diagonal and anti-diagonal
 // matrices.
 void UnitaryBuilder::applyMatrix(ArrayRef<Complex> u,
-                                 const std::vector<Qubit> &qubits) {
-  auto *m = matrix.data();
-  for (unsigned k = 0u, end = (matrix.size() >> 1u); k < end; ++k) {
-    const auto idx = indicies(qubits, qubits, k);
-    const auto cache = m[idx.at(0)];
-    m[idx.at(0)] = u[0] * cache + u[2] * m[idx.at(1)];
-    m[idx.at(1)] = u[1] * cache + u[3] * m[idx.at(1)];
-  }
-}
-
-void UnitaryBuilder::applyMatrix(ArrayRef<Complex> u, unsigned numTargets,
-                                 const std::vector<Qubit> &qubits) {
-  auto qubitsSorted = qubits;
+                                 const std::vector<Qubit> &controls,
+                                 const std::vector<Qubit> &targets) {
+  std::vector<Qubit> qubitsSorted(controls);
+  qubitsSorted.insert(qubitsSorted.end(), targets.begin(), targets.end());
   std::sort(qubitsSorted.begin(), qubitsSorted.end());
 
+  // The controls are set in every index the operator acts on, the targets
+  // select the amplitudes of the block the operator is applied to.
+  std::size_t controlMask = 0;
+  for (auto qubit : controls)
+    controlMask |= std::size_t(1) << qubit;
+  const std::size_t dim = std::size_t(1) << targets.size();
+  SmallVector<std::size_t, 8> offsets(dim, 0);
+  for (std::size_t i = 0; i < dim; ++i)
+    for (unsigned t = 0, end = targets.size(); t < end; ++t)
+      if (i & (std::size_t(1) << t))
+        offsets[i] |= std::size_t(1) << targets[t];
+
+  // Every column of the matrix is the image of a basis state (or a probe), the
+  // operator is applied to each of them independently.
   auto *m = matrix.data();
-  const size_t dim = (1u << numTargets);
-  for (size_t k = 0u, end = (matrix.size() >> qubits.size()); k < end; ++k) {
-    const auto idx = indicies(qubits, qubitsSorted, k);
-    SmallVector<Complex, 8> cache(dim, 0);
-    for (size_t i = 0; i < dim; i++) {
-      cache[i] = m[idx.at(i)];
-      m[idx.at(i)] = 0.;
-    }
-    for (size_t i = 0; i < dim; i++) {
-      for (size_t j = 0; j < dim; j++) {
-        m[idx.at(i)] += u[i + dim * j] * cache[j];
+  const std::int64_t rows = matrix.rows(), cols = matrix.cols();
+  const std::int64_t numBlocks = rows >> qubitsSorted.size();
+#pragma omp parallel for collapse(2) if (matrix.size() >= minParallelSize)
+  for (std::int64_t col = 0; col < cols; ++col) {
+    for (std::int64_t k = 0; k < numBlocks; ++k) {
+      Complex *column = m + col * rows;
+      const std::size_t base = insertZeroBits(qubitsSorted, k) | controlMask;
+      SmallVector<Complex, 8> cache(dim);
+      for (std::size_t i = 0; i < dim; ++i)
+        cache[i] = column[base | offsets[i]];
+      for (std::size_t i = 0; i < dim; ++i) {
+        Complex sum = 0.;
+        for (std::size_t j = 0; j < dim; ++j)
+          sum += u[i + dim * j] * cache[j];
+        column[base | offsets[i]] = sum;
       }
     }
   }
 }
-
-void UnitaryBuilder::applyControlledMatrix(ArrayRef<Complex> u,
-                                           const std::vector<Qubit> &qubits) {
-  auto qubitsSorted = qubits;
-  std::sort(qubitsSorted.begin(), qubitsSorted.end());
-  const unsigned p0 = (1 << (qubits.size() - 1)) - 1;
-  const unsigned p1 = (1 << qubits.size()) - 1;
-
-  auto *m = matrix.data();
-  for (unsigned k = 0u, end = (matrix.size() >> qubits.size()); k < end; ++k) {
-    const auto idx = indicies(qubits, qubitsSorted, k);
-    const auto cache = m[idx.at(p0)];
-    m[idx.at(p0)] = u[0] * cache + u[2] * m[idx.at(p1)];
-    m[idx.at(p1)] = u[1] * cache + u[3] * m[idx.at(p1)];
-  }
-}
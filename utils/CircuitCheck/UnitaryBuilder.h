@@ -12,6 +12,7 @@
 #include "mlir/Dialect/Func/IR/FuncOps.h"
 #include <Eigen/Dense>
 #include <complex>
+#include <cstdint>
 #include <vector>
 
 namespace cudaq {
@@ -24,7 +25,14 @@ public:
   using Qubit = unsigned;
   using UMatrix = Eigen::Matrix<Complex, Eigen::Dynamic, Eigen::Dynamic>;
 
-  UnitaryBuilder(UMatrix &matrix) : matrix(matrix) {}
+  /// If `numProbes` is zero, `matrix` is built as the unitary of the
+  /// circuit. Otherwise it is built as the circuit applied to `numProbes`
+  /// random product states, one per column, which only takes memory linear in
+  /// the dimension. The states are drawn from `seed` and the index of each
+  /// qubit, so two circuits on the same qubits are applied to the same states.
+  UnitaryBuilder(UMatrix &matrix, unsigned numProbes = 0,
+                 std::uint64_t seed = 0)
+      : matrix(matrix), numProbes(numProbes), seed(seed) {}
 
   mlir::LogicalResult build(mlir::func::FuncOp func);
 
@@ -73,22 +81,24 @@ private:
   void applyOperator(mlir::ArrayRef<Complex> m, mlir::OperandRange controls,
                      mlir::OperandRange targets);
 
-  /// Applies a general single-qubit unitary matrix
-  void applyMatrix(mlir::ArrayRef<Complex> m, const std::vector<Qubit> &qubits);
-
-  /// Applies a general multiple-control, multiple-target unitary matrix
-  void applyMatrix(mlir::ArrayRef<Complex> m, unsigned numTargets,
-                   const std::vector<Qubit> &qubits);
-
-  /// Applies a general multiple-control, single-target unitary matrix
-  void applyControlledMatrix(mlir::ArrayRef<Complex> m,
-                             const std::vector<Qubit> &qubits);
+  /// Applies a general multiple-control, multiple-target unitary matrix, in
+  /// place and in parallel over the columns of the matrix
+  void applyMatrix(mlir::ArrayRef<Complex> m,
+                   const std::vector<Qubit> &controls,
+                   const std::vector<Qubit> &targets);
 
   //===--------------------------------------------------------------------===//
 
   /// The unitary we are building
   UMatrix &matrix;
 
+  /// The number of random states the circuit is applied to, zero to build the
+  /// unitary
+  unsigned numProbes;
+
+  /// The seed of the random states
+  std::uint64_t seed;
+
   /// Map values to qubits identifiers
   ///
   /// NOTE: To simplify the API and avoid the need to keep different maps for
@@ -113,7 +123,7 @@ getGlobalPhaseConjugate(const UnitaryBuilder::UMatrix &matrix, double atol) {
   // Since the matrix uses a column-major storage scheme, it is faster to search
   // for the first nonzero element in the first column.
   for (auto &elt : matrix.col(0)) {
-    if (std::abs(elt) > atol)
+    if (std::abs(elt) <= atol)
       continue;
     // Speed up the case for 1 + 0i
     return elt == 1. ? 1. : std::exp(std::complex<double>(0., -std::arg(elt)));